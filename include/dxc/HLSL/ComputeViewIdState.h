@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <bitset>
+#include <functional>
 #include <unordered_set>
 #include <unordered_map>
 #include <set>
@@ -62,7 +63,13 @@ public:
   const InputsContributingToOutputType &getInputsContributingToPCOutputs() const;
   const InputsContributingToOutputType &getPCInputsContributingToOutputs() const;
 
+  // Returns the control dependence of a function, e.g. as kept by a pass
+  // manager for passes that preserve it.
+  using ControlDependenceGetter =
+      std::function<const ControlDependence &(llvm::Function &)>;
+
   void Compute();
+  void Compute(const ControlDependenceGetter &GetCtrlDep);
   void Serialize();
   const std::vector<unsigned> &GetSerialized();
   const std::vector<unsigned> &GetSerialized() const;   // returns previously serialized data
@@ -136,18 +143,17 @@ private:
   void Clear();
   void DetermineMaxPackedLocation(DxilSignature &DxilSig, unsigned *pMaxSigLoc, unsigned NumStreams);
   void ComputeReachableFunctionsRec(llvm::CallGraph &CG, llvm::CallGraphNode *pNode, FunctionSetType &FuncSet);
-  void AnalyzeFunctions(EntryInfo &Entry);
+  void AnalyzeFunctions(EntryInfo &Entry,
+                        const ControlDependenceGetter &GetCtrlDep);
   void CollectValuesContributingToOutputs(EntryInfo &Entry);
-  void CollectValuesContributingToOutputRec(EntryInfo &Entry,
-                                            llvm::Value *pContributingValue,
-                                            InstructionSetType &ContributingInstructions);
-  void CollectPhiCFValuesContributingToOutputRec(llvm::PHINode *pPhi,
-                                                 EntryInfo &Entry,
-                                                 InstructionSetType &ContributingInstructions);
+  void CollectValuesContributingToOutput(EntryInfo &Entry,
+                                         llvm::Value *pContributingValue,
+                                         InstructionSetType &ContributingInstructions);
+  void CollectPhiCFValuesContributingToOutput(llvm::PHINode *pPhi,
+                                              EntryInfo &Entry,
+                                              std::vector<llvm::Value *> &Worklist);
   const ValueSetType &CollectReachingDecls(llvm::Value *pValue);
-  void CollectReachingDeclsRec(llvm::Value *pValue, ValueSetType &ReachingDecls, ValueSetType &Visited);
   const ValueSetType &CollectStores(llvm::Value *pValue);
-  void CollectStoresRec(llvm::Value *pValue, ValueSetType &Stores, ValueSetType &Visited);
   void UpdateDynamicIndexUsageState() const;
   void CreateViewIdSets(const std::unordered_map<unsigned, InstructionSetType> &ContributingInstructions,
                         OutputsDependentOnViewIdType &OutputsDependentOnViewId,
@@ -12,12 +12,14 @@
 #pragma once
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Dominators.h"
+#include "llvm/Pass.h"
 
 #include <unordered_set>
 #include <unordered_map>
 
 namespace llvm {
   class Function;
+  class Module;
   class raw_ostream;
 }
 
@@ -32,14 +34,14 @@ public:
   void Compute(llvm::Function *F, PostDomRelationType &PostDomRel);
   void Clear();
   const BasicBlockSet &GetCDBlocks(llvm::BasicBlock *pBB) const;
-  void print(llvm::raw_ostream &OS);
+  void print(llvm::raw_ostream &OS) const;
   void dump();
 
 private:
   using BasicBlockVector = std::vector<llvm::BasicBlock *>;
   using ControlDependenceType = std::unordered_map<llvm::BasicBlock *, BasicBlockSet>;
 
-  llvm::Function *m_pFunc;
+  llvm::Function *m_pFunc = nullptr;
   ControlDependenceType m_ControlDependence;
   BasicBlockSet m_EmptyBBSet;
 
@@ -49,3 +51,31 @@ private:
 };
 
 } // end of hlsl namespace
+
+
+namespace llvm {
+
+// Keeps the control dependence of a function as an analysis, so passes that
+// preserve it share one computation with the post-dominator tree it is built
+// from.
+class ControlDependenceWrapperPass : public FunctionPass {
+  hlsl::ControlDependence CtrlDep;
+
+public:
+  static char ID; // Pass ID, replacement for typeid
+
+  ControlDependenceWrapperPass();
+
+  const hlsl::ControlDependence &getControlDependence() const {
+    return CtrlDep;
+  }
+
+  bool runOnFunction(Function &F) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+  void releaseMemory() override;
+  void print(raw_ostream &OS, const Module *M = nullptr) const override;
+};
+
+void initializeControlDependenceWrapperPassPass(llvm::PassRegistry &);
+
+} // end of llvm namespace
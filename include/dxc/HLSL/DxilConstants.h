@@ -892,6 +892,12 @@ namespace DXIL {
     LastEntry,
   };
 
+  // First argument of the markers of a [profile] region.
+  enum class ProfileRegionMarker : unsigned {
+    Begin = 0,
+    End = 1,
+  };
+
   // XYZW component mask.
   const uint8_t kCompMask_X     = 0x1;
   const uint8_t kCompMask_Y     = 0x2;
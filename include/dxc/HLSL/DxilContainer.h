@@ -20,7 +20,10 @@
 #include "dxc/HLSL/DxilConstants.h"
 
 struct IDxcContainerReflection;
-namespace llvm { class Module; }
+namespace llvm {
+class Module;
+template <typename T> class SmallVectorImpl;
+}
 
 namespace hlsl {
 
@@ -76,6 +79,7 @@ enum DxilFourCC {
   DFCC_PatchConstantSignature   = DXIL_FOURCC('P', 'S', 'G', '1'),
   DFCC_ShaderStatistics         = DXIL_FOURCC('S', 'T', 'A', 'T'),
   DFCC_ShaderDebugInfoDXIL      = DXIL_FOURCC('I', 'L', 'D', 'B'),
+  DFCC_ShaderDebugInfoDXILCompressed = DXIL_FOURCC('I', 'L', 'D', 'Z'), // DFCC_ShaderDebugInfoDXIL content, compressed
   DFCC_ShaderDebugName          = DXIL_FOURCC('I', 'L', 'D', 'N'),
   DFCC_FeatureInfo              = DXIL_FOURCC('S', 'F', 'I', '0'),
   DFCC_PrivateData              = DXIL_FOURCC('P', 'R', 'I', 'V'),
@@ -222,6 +226,21 @@ struct DxilShaderDebugName {
 };
 static const size_t MinDxilShaderDebugNameSize = sizeof(DxilShaderDebugName) + 4;
 
+enum class DxilPartCompression : uint32_t {
+  Zlib = 1,
+};
+
+/// Use this type to describe a part whose content is another part's content,
+/// compressed. DFCC_ShaderDebugInfoDXILCompressed uses it to hold the content
+/// of a DFCC_ShaderDebugInfoDXIL part; a container has at most one of the two.
+struct DxilCompressedPartHeader {
+  uint32_t CompressionType;  // A DxilPartCompression value.
+  uint32_t UncompressedSize; // Byte count of the original part content.
+  uint32_t CompressedSize;   // Byte count of the compressed data.
+  // Followed by uint8_t CompressedData[CompressedSize].
+  // Followed by [0-3] zero bytes to align to a 4-byte boundary.
+};
+
 #pragma pack(pop)
 
 /// Gets a part header by index.
@@ -265,6 +284,18 @@ DxilProgramHeader *GetDxilProgramHeader(DxilContainerHeader *pHeader, DxilFourCC
 const DxilProgramHeader *
 GetDxilProgramHeader(const DxilContainerHeader *pHeader, DxilFourCC fourCC);
 
+/// Decompresses the content of a part described by DxilCompressedPartHeader.
+/// Returns false if the part is malformed or its compression is unsupported.
+bool DecompressDxilPartData(const DxilPartHeader *pPart,
+                            llvm::SmallVectorImpl<char> &Data);
+
+/// Returns the valid debug DxilProgramHeader, from either debug info part;
+/// a compressed part is decompressed into Storage, which must outlive the
+/// result. nullptr if neither exists.
+const DxilProgramHeader *
+GetDxilDebugProgramHeader(const DxilContainerHeader *pHeader,
+                          llvm::SmallVectorImpl<char> &Storage);
+
 /// Initializes container with the specified values.
 void InitDxilContainer(_Out_ DxilContainerHeader *pHeader, uint32_t partCount,
                        uint32_t containerSizeInBytes);
@@ -422,16 +453,39 @@ public:
   virtual void write(AbstractMemoryStream *pStream) = 0;
 };
 
-DxilPartWriter *NewProgramSignatureWriter(const DxilModule &M, DXIL::SignatureKind Kind);
+// With bDedupStrings, the signature and PSV writers store each distinct
+// semantic name once per part, and in the same sorted order in every part.
+DxilPartWriter *NewProgramSignatureWriter(const DxilModule &M, DXIL::SignatureKind Kind,
+                                          bool bDedupStrings = false);
 DxilPartWriter *NewRootSignatureWriter(const RootSignatureHandle &S);
 DxilPartWriter *NewFeatureInfoWriter(const DxilModule &M);
-DxilPartWriter *NewPSVWriter(const DxilModule &M, uint32_t PSVVersion = 0);
+DxilPartWriter *NewPSVWriter(const DxilModule &M, uint32_t PSVVersion = 0,
+                             bool bDedupStrings = false);
+
+// Digests of a container's content: every byte after the header's Hash
+// field, so signing a container does not change them.
+enum class DxilContainerDigestKind {
+  None,
+  MD5,  // 128-bit MD5; stable across processes.
+  Fast, // 64-bit non-cryptographic hash in the first 8 bytes, rest zero;
+        // stable only within a process, for in-memory deduplication.
+};
 
 class DxilContainerWriter : public DxilPartWriter  {
 public:
   typedef std::function<void(AbstractMemoryStream*)> WriteFn;
   virtual ~DxilContainerWriter() {}
   virtual void AddPart(uint32_t FourCC, uint32_t Size, WriteFn Write) = 0;
+  // Adds the last part, for content whose size is only known once it has been
+  // written, such as bitcode serialized straight into the container. Write
+  // must leave the content padded to 4 bytes; write() then patches the part
+  // and container sizes. SizeHint is only used to reserve the stream, and
+  // size() does not include the part's content.
+  virtual void AddTrailingPart(uint32_t FourCC, uint32_t SizeHint, WriteFn Write) = 0;
+  // Selects the digest write() computes as it goes; none by default.
+  virtual void SetDigestKind(DxilContainerDigestKind Kind) = 0;
+  // Retrieves the digest computed by the last write().
+  virtual void GetDigest(DxilContainerHash *pDigest) const = 0;
 };
 
 DxilContainerWriter *NewDxilContainerWriter();
@@ -440,7 +494,11 @@ enum class SerializeDxilFlags : uint32_t {
   None = 0,                     // No flags defined.
   IncludeDebugInfoPart = 1,     // Include the debug info part in the container.
   IncludeDebugNamePart = 2,     // Include the debug name part in the container.
-  DebugNameDependOnSource = 4   // Make the debug name depend on source (and not just final module).
+  DebugNameDependOnSource = 4,  // Make the debug name depend on source (and not just final module).
+  CompressDebugInfoPart = 8,    // Compress the debug info part when that makes it smaller.
+  IncludePSVIndexes = 16,       // Write PSV version 2, with binding and signature indexes.
+  DebugNameFastHash = 32,       // Base the debug name on a 64-bit xxHash rather than MD5.
+  DeduplicateStrings = 64       // Share equal semantic names in the signature and PSV parts.
 };
 inline SerializeDxilFlags& operator |=(SerializeDxilFlags& l, const SerializeDxilFlags& r) {
   l = static_cast<SerializeDxilFlags>(static_cast<int>(l) | static_cast<int>(r));
@@ -457,10 +515,19 @@ inline SerializeDxilFlags operator~(SerializeDxilFlags l) {
   return static_cast<SerializeDxilFlags>(~static_cast<uint32_t>(l));
 }
 
+// When pDigest is provided, it receives the DigestKind digest of the
+// container, computed while the parts are written.
 void SerializeDxilContainerForModule(hlsl::DxilModule *pModule,
                                      AbstractMemoryStream *pModuleBitcode,
                                      AbstractMemoryStream *pStream,
-                                     SerializeDxilFlags Flags);
+                                     SerializeDxilFlags Flags,
+                                     DxilContainerDigestKind DigestKind = DxilContainerDigestKind::None,
+                                     DxilContainerHash *pDigest = nullptr);
+// Computes the digest of an existing container; it matches the digest the
+// container writer computed when it wrote the same bytes.
+void ComputeDxilContainerDigest(const DxilContainerHeader *pHeader,
+                                DxilContainerDigestKind Kind,
+                                DxilContainerHash *pDigest);
 void SerializeDxilContainerForRootSignature(hlsl::RootSignatureHandle *pRootSigHandle,
                                      AbstractMemoryStream *pStream);
 
@@ -18,6 +18,8 @@ class Function;
 class FunctionPass;
 class Instruction;
 class PassRegistry;
+class StringRef;
+class Value;
 }
 
 namespace hlsl {
@@ -30,6 +32,25 @@ public:
   virtual bool IsWaveSensitive(llvm::Instruction *op) = 0;
 };
 
+// Divergence analysis: a value is uniform when every active lane of a wave
+// computes the same value for it.
+class DxilUniformityAnalysis {
+public:
+  static DxilUniformityAnalysis* create();
+  virtual ~DxilUniformityAnalysis() { }
+  virtual void Analyze(llvm::Function *F) = 0;
+  virtual bool IsUniform(llvm::Value *V) = 0;
+  // True for conditional branches and switches on a uniform condition, which
+  // can be taken as scalar branches.
+  virtual bool IsUniformBranch(llvm::Instruction *TI) = 0;
+  virtual unsigned GetConditionalBranchCount() = 0;
+  virtual unsigned GetDivergentBranchCount() = 0;
+};
+
+// The largest number of scalar values live at any point of F, the register
+// pressure estimate of the shader statistics.
+unsigned ComputePeakLiveValues(llvm::Function &F);
+
 class HLSLExtensionsCodegenHelper;
 }
 
@@ -37,33 +58,71 @@ namespace llvm {
 
 /// \brief Create and return a pass that tranform the module into a DXIL module
 /// Note that this pass is designed for use with the legacy pass manager.
+ModulePass *createDxilApplyBlockProfilePass(llvm::StringRef Profile);
+FunctionPass *createDxilCoalesceCBufferLoadsPass();
+FunctionPass *createDxilCombineBufferAccessesPass();
 ModulePass *createDxilCondenseResourcesPass();
+ModulePass *createDxilConstantTablesPass(unsigned MaxElements = 8);
+FunctionPass *createDxilDynamicIndexToSelectPass();
 ModulePass *createDxilEliminateOutputDynamicIndexingPass();
 ModulePass *createDxilGenerationPass(bool NotOptimized, hlsl::HLSLExtensionsCodegenHelper *extensionsHelper);
 ModulePass *createHLEmitMetadataPass();
 ModulePass *createHLEnsureMetadataPass();
-ModulePass *createDxilEmitMetadataPass();
+ModulePass *createDxilEmitMetadataPass(bool EmitRootSignature = true);
 FunctionPass *createDxilExpandTrigIntrinsicsPass();
+FunctionPass *createDxilHoistSamplesPass();
+ModulePass *createDxilInsertBlockCountersPass();
+ModulePass *createDxilInsertProfileRegionsPass();
 ModulePass *createDxilLoadMetadataPass();
+FunctionPass *createDxilLoadToGatherPass();
+ModulePass *createDxilMapCountersToLinesPass();
+FunctionPass *createDxilNonUniformHandlesPass();
 ModulePass *createDxilPrecisePropagatePass();
 FunctionPass *createDxilPreserveAllOutputsPass();
+ModulePass *createDxilPruneUnreadOutputsPass(unsigned RenderTargetMask = 0xFF,
+                                             bool bDepthWriteDisabled = false,
+                                             const char *pConsumerInputs = nullptr);
+ModulePass *createDxilShaderStatsPass();
+FunctionPass *createDxilSimplifyBeforeInlinePass();
+FunctionPass *createDxilSimplifyWaveOpsPass();
+ModulePass *createDxilTGSMBankConflictsPass();
 FunctionPass *createDxilLegalizeResourceUsePass();
 ModulePass *createDxilLegalizeStaticResourceUsePass();
 ModulePass *createDxilLegalizeEvalOperationsPass();
 FunctionPass *createDxilLegalizeSampleOffsetPass();
 FunctionPass *createSimplifyInstPass();
+FunctionPass *createDxilUniformityStatsPass();
 ModulePass *createDxilOutputColorBecomesConstantPass();
+FunctionPass *createDxilPairHalfOpsPass();
 
+void initializeDxilApplyBlockProfilePass(llvm::PassRegistry&);
+void initializeDxilCoalesceCBufferLoadsPass(llvm::PassRegistry&);
+void initializeDxilCombineBufferAccessesPass(llvm::PassRegistry&);
 void initializeDxilCondenseResourcesPass(llvm::PassRegistry&);
+void initializeDxilConstantTablesPass(llvm::PassRegistry&);
+void initializeDxilDynamicIndexToSelectPass(llvm::PassRegistry&);
 void initializeDxilEliminateOutputDynamicIndexingPass(llvm::PassRegistry&);
 void initializeDxilGenerationPassPass(llvm::PassRegistry&);
 void initializeHLEnsureMetadataPass(llvm::PassRegistry&);
 void initializeHLEmitMetadataPass(llvm::PassRegistry&);
 void initializeDxilEmitMetadataPass(llvm::PassRegistry&);
 void initializeDxilExpandTrigIntrinsicsPass(llvm::PassRegistry&);
+void initializeDxilHoistSamplesPass(llvm::PassRegistry&);
+void initializeDxilInsertBlockCountersPass(llvm::PassRegistry&);
+void initializeDxilInsertProfileRegionsPass(llvm::PassRegistry&);
 void initializeDxilLoadMetadataPass(llvm::PassRegistry&);
+void initializeDxilLoadToGatherPass(llvm::PassRegistry&);
+void initializeDxilMapCountersToLinesPass(llvm::PassRegistry&);
+void initializeDxilNonUniformHandlesPass(llvm::PassRegistry&);
 void initializeDxilPrecisePropagatePassPass(llvm::PassRegistry&);
+void initializeDxilPairHalfOpsPass(llvm::PassRegistry&);
 void initializeDxilPreserveAllOutputsPass(llvm::PassRegistry&);
+void initializeDxilPruneUnreadOutputsPass(llvm::PassRegistry&);
+void initializeDxilShaderStatsPass(llvm::PassRegistry&);
+void initializeDxilSimplifyBeforeInlinePass(llvm::PassRegistry&);
+void initializeDxilSimplifyWaveOpsPass(llvm::PassRegistry&);
+void initializeDxilTGSMBankConflictsPass(llvm::PassRegistry&);
+void initializeDxilUniformityStatsPass(llvm::PassRegistry&);
 void initializeDxilLegalizeResourceUsePassPass(llvm::PassRegistry&);
 void initializeDxilLegalizeStaticResourceUsePassPass(llvm::PassRegistry&);
 void initializeDxilLegalizeEvalOperationsPass(llvm::PassRegistry&);
@@ -13,7 +13,9 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include <memory>
 #include "llvm/Support/ErrorOr.h"
 
@@ -42,9 +44,30 @@ public:
   virtual bool AttachLib(llvm::StringRef name) = 0;
   virtual bool DetachLib(llvm::StringRef name) = 0;
   virtual void DetachAll() = 0;
+  // Replaces the registered library name, which must not be attached, with
+  // a new build of it. changedFunctions receives the names of the functions
+  // defined differently, including entries whose properties or signatures
+  // changed. bAllChanged is set when the libraries also differ in their
+  // globals, initializers or resources, which may affect any link.
+  virtual bool ReplaceLib(llvm::StringRef name,
+                          std::unique_ptr<llvm::Module> pModule,
+                          std::unique_ptr<llvm::Module> pDebugModule,
+                          llvm::StringSet<> &changedFunctions,
+                          bool &bAllChanged) = 0;
 
-  virtual std::unique_ptr<llvm::Module> Link(llvm::StringRef entry,
-                                             llvm::StringRef profile) = 0;
+  // linkConstants maps the names of link-time constants to the text of
+  // their values; constants not in the map keep their defaults. An optLevel
+  // above zero runs the compiler's optimization pipeline on the result. If
+  // pLinkedFunctions is not null, it receives the names of the library
+  // functions the link used, including those inlined into prepared copies.
+  virtual std::unique_ptr<llvm::Module>
+  Link(llvm::StringRef entry, llvm::StringRef profile,
+       const llvm::StringMap<std::string> &linkConstants, unsigned optLevel,
+       llvm::StringSet<> *pLinkedFunctions) = 0;
+
+  // Prefix of the functions that stand for link-time constants in a
+  // library. Each call passes the default value of the constant.
+  static const char kLinkConstantPrefix[];
 
 protected:
   DxilLinker(llvm::LLVMContext &Ctx) : m_ctx(Ctx) {}
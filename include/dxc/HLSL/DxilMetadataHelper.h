@@ -171,6 +171,21 @@ public:
   static const char kDxilTypeSystemHelperVariablePrefix[];
   static const unsigned kDxilTypeSystemStructTag                  = 0;
   static const unsigned kDxilTypeSystemFunctionTag                = 1;
+  // Compact struct annotations, emitted for validator version 1.2 and up:
+  // !{i32 2, !{!"string", ...}, %struct undef, [N x i32] [...], ...}, with
+  // one packed array per struct holding the cbuffer size, the field count
+  // and, per field, the kDxilCompactField* flags followed by the values of
+  // the flags set, in flag order. Strings are indices into the table.
+  static const unsigned kDxilTypeSystemCompactStructTag           = 2;
+  static const unsigned kDxilTypeSystemCompactMinValMajor         = 1;
+  static const unsigned kDxilTypeSystemCompactMinValMinor         = 2;
+  static const unsigned kDxilCompactFieldName                     = 1 << 0;
+  static const unsigned kDxilCompactFieldPrecise                  = 1 << 1;
+  static const unsigned kDxilCompactFieldMatrix                   = 1 << 2;
+  static const unsigned kDxilCompactFieldCBufferOffset            = 1 << 3;
+  static const unsigned kDxilCompactFieldSemanticString           = 1 << 4;
+  static const unsigned kDxilCompactFieldInterpolationMode        = 1 << 5;
+  static const unsigned kDxilCompactFieldCompType                 = 1 << 6;
   static const unsigned kDxilFieldAnnotationSNormTag              = 0;
   static const unsigned kDxilFieldAnnotationUNormTag              = 1;
   static const unsigned kDxilFieldAnnotationMatrixTag             = 2;
@@ -193,6 +208,11 @@ public:
   // Precise attribute.
   static const char kDxilPreciseAttributeMDName[];
 
+  // Profile regions, named in index order, and the function marking where
+  // each one begins and ends.
+  static const char kDxilProfileRegionsMDName[];
+  static const char kDxilProfileRegionMarkerName[];
+
   // Validator version.
   static const char kDxilValidatorVersionMDName[];
   // Validator version uses the same constants for fields as kDxilVersion*
@@ -321,7 +341,8 @@ public:
   void LoadDxilSamplerFromMDNode(llvm::MDNode *MD, DxilSampler &S);
 
   // Type system.
-  void EmitDxilTypeSystem(DxilTypeSystem &TypeSystem, std::vector<llvm::GlobalVariable *> &LLVMUsed);
+  void EmitDxilTypeSystem(DxilTypeSystem &TypeSystem, std::vector<llvm::GlobalVariable *> &LLVMUsed,
+                          bool bCompact = false);
   void LoadDxilTypeSystemNode(const llvm::MDTuple &MDT, DxilTypeSystem &TypeSystem);
   void LoadDxilTypeSystem(DxilTypeSystem &TypeSystem);
   llvm::Metadata *EmitDxilStructAnnotation(const DxilStructAnnotation &SA);
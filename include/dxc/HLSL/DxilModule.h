@@ -22,7 +22,9 @@
 
 
 
+#include <bitset>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -150,8 +152,10 @@ public:
   const DxilViewIdState &GetViewIdState() const;
 
   // DXIL metadata manipulation.
-  /// Serialize DXIL in-memory form to metadata form.
-  void EmitDxilMetadata();
+  /// Serialize DXIL in-memory form to metadata form. The root signature is
+  /// left out when bEmitRootSignature is false, for modules whose container
+  /// writes it from the in-memory form to its own part.
+  void EmitDxilMetadata(bool bEmitRootSignature = true);
   /// Deserialize DXIL metadata form into in-memory form.
   void LoadDxilMetadata();
   /// Check if a Named meta data node is known by dxil module.
@@ -312,8 +316,49 @@ public:
     uint32_t m_align1;            // align to 64 bit.
   };
 
+  // What the instructions of the module use, as far as shader flags are
+  // concerned. Callers that visit every instruction anyway, like the
+  // validator, add instructions as they go and derive the flags from the
+  // census instead of walking the module again. Censuses of disjoint sets of
+  // functions can be gathered separately and merged.
+  class InstructionCensus {
+  public:
+    void AddInstruction(llvm::Instruction &I);
+    void AddFunction(llvm::Function &F);
+    void Merge(const InstructionCensus &Other);
+
+    bool UsesOpCode(DXIL::OpCode Op) const {
+      return m_OpCodes.test(static_cast<unsigned>(Op));
+    }
+    bool UsesWaveOps() const { return m_bWaveOps; }
+    bool UsesDouble() const { return m_bDouble; }
+    bool UsesDoubleExtensions() const { return m_bDoubleExtensions; }
+    bool UsesInt64() const { return m_bInt64; }
+    bool Uses16BitTypes() const { return m_b16BitTypes; }
+    bool LoadsUAV() const { return m_bUAVLoad; }
+    // Range IDs of the UAVs loaded through a handle with a constant range ID.
+    const std::set<unsigned> &GetLoadedUAVRangeIDs() const {
+      return m_LoadedUAVRangeIDs;
+    }
+
+  private:
+    std::bitset<static_cast<unsigned>(DXIL::OpCode::NumOpCodes)> m_OpCodes;
+    std::set<unsigned> m_LoadedUAVRangeIDs;
+    bool m_bWaveOps = false;
+    bool m_bDouble = false;
+    // ddiv dfma drcp d2i d2u i2d u2d.
+    bool m_bDoubleExtensions = false;
+    bool m_bInt64 = false;
+    bool m_b16BitTypes = false;
+    bool m_bUAVLoad = false;
+  };
+
   ShaderFlags m_ShaderFlags;
   void CollectShaderFlags(ShaderFlags &Flags);
+  // Collects the flags of the instructions in the census rather than of the
+  // instructions in the module; the signatures and resources come from the
+  // module either way.
+  void CollectShaderFlags(ShaderFlags &Flags, const InstructionCensus &Census);
 
   // Check if DxilModule contains multi component UAV Loads.
   // This funciton must be called after unused resources are removed from DxilModule
@@ -59,7 +59,9 @@ public:
   // Try to get the opcode class for a function.
   // Return true and set `opClass` if the given function is a dxil function.
   // Return false if the given function is not a dxil function.
-  bool GetOpCodeClass(const llvm::Function *F, OpCodeClass &opClass);
+  // This does not hash for functions that are used by a call; it reads the
+  // opcode from the call and checks the overload cache.
+  bool GetOpCodeClass(const llvm::Function *F, OpCodeClass &opClass) const;
 
   // LLVM helpers. Perhaps, move to a separate utility class.
   llvm::Constant *GetI1Const(bool v);
@@ -81,6 +83,9 @@ public:
   static bool IsOverloadLegal(OpCode OpCode, llvm::Type *pType);
   static bool CheckOpCodeTable();
   static bool IsDxilOpFuncName(llvm::StringRef name);
+  // Whether name is that of a struct type OP creates, whose body is the same
+  // in every module.
+  static bool IsDxilOpTypeName(llvm::StringRef name);
   static bool IsDxilOpFunc(const llvm::Function *F);
   static bool IsDxilOpFuncCallInst(const llvm::Instruction *I);
   static bool IsDxilOpFuncCallInst(const llvm::Instruction *I, OpCode opcode);
@@ -110,7 +115,11 @@ private:
   };
   OpCodeCacheItem m_OpCodeClassCache[(unsigned)OpCodeClass::NumOpClasses];
   std::unordered_map<const llvm::Function *, OpCodeClass> m_FunctionToOpClass;
+  // The caches are only written by GetOpFunc on a miss, by RefreshCache and
+  // by RemoveFunction. Cache hits in GetOpFunc, GetOpFuncList and
+  // GetOpCodeClass only read them.
   void UpdateCache(OpCodeClass opClass, unsigned typeSlot, llvm::Function *F);
+  bool IsCachedOpFunc(OpCodeClass opClass, const llvm::Function *F) const;
 private:
   // Static properties.
   struct OpCodeProperty {
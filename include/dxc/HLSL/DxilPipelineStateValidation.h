@@ -86,6 +86,16 @@ struct PSVRuntimeInfo1 : public PSVRuntimeInfo0
   uint8_t SigOutputVectors[4];      // Array for GS Stream Out Index
 };
 
+struct PSVRuntimeInfo2 : public PSVRuntimeInfo1
+{
+  // Combined hash of the input, output and patch constant signatures, so
+  // stages can be matched without comparing elements.
+  uint32_t SignatureHash;
+  // Bucket count of the resource binding hash table: a power of two larger
+  // than twice ResourceCount, or 0 when there are no resources.
+  uint32_t ResourceBindBuckets;
+};
+
 enum class PSVResourceType
 {
   Invalid = 0,
@@ -113,6 +123,55 @@ struct PSVResourceBindInfo0
 };
 // PSVResourceBindInfo1 would derive and extend
 
+// Resource classes bindings are indexed by; matches hlsl::DXIL::ResourceClass
+enum class PSVResourceClass
+{
+  SRV = 0,
+  UAV,
+  CBV,
+  Sampler,
+  Invalid,
+};
+
+inline PSVResourceClass PSVGetResourceClass(uint32_t ResType) {
+  switch ((PSVResourceType)ResType) {
+  case PSVResourceType::Sampler: return PSVResourceClass::Sampler;
+  case PSVResourceType::CBV: return PSVResourceClass::CBV;
+  case PSVResourceType::SRVTyped:
+  case PSVResourceType::SRVRaw:
+  case PSVResourceType::SRVStructured: return PSVResourceClass::SRV;
+  case PSVResourceType::UAVTyped:
+  case PSVResourceType::UAVRaw:
+  case PSVResourceType::UAVStructured:
+  case PSVResourceType::UAVStructuredWithCounter: return PSVResourceClass::UAV;
+  default: return PSVResourceClass::Invalid;
+  }
+}
+
+// 32-bit FNV-1a, used for the PSVRuntimeInfo2 binding and signature hashes
+#define PSV_HASH_SEED 2166136261u
+inline uint32_t PSVHashBytes(uint32_t Hash, const void *pData, uint32_t Size) {
+  const uint8_t *pBytes = (const uint8_t*)pData;
+  for (uint32_t i = 0; i < Size; ++i) {
+    Hash ^= pBytes[i];
+    Hash *= 16777619u;
+  }
+  return Hash;
+}
+inline uint32_t PSVHashBindKey(PSVResourceClass Class, uint32_t Space, uint32_t LowerBound) {
+  uint32_t Key[3] = { (uint32_t)Class, Space, LowerBound };
+  return PSVHashBytes(PSV_HASH_SEED, Key, sizeof(Key));
+}
+inline uint32_t PSVComputeBindBuckets(uint32_t ResourceCount) {
+  if (!ResourceCount)
+    return 0;
+  uint32_t Buckets = 1;
+  while (Buckets <= ResourceCount * 2)
+    Buckets <<= 1;
+  return Buckets;
+}
+#define PSV_EMPTY_BIND_BUCKET 0xFFFFFFFFu
+
 // Helpers for output dependencies (ViewID and Input-Output tables)
 struct PSVComponentMask {
   uint32_t *Mask;
@@ -307,6 +366,7 @@ class DxilPipelineStateValidation
   uint32_t m_uPSVRuntimeInfoSize;
   PSVRuntimeInfo0* m_pPSVRuntimeInfo0;
   PSVRuntimeInfo1* m_pPSVRuntimeInfo1;
+  PSVRuntimeInfo2* m_pPSVRuntimeInfo2;
   uint32_t m_uResourceCount;
   uint32_t m_uPSVResourceBindInfoSize;
   void* m_pPSVResourceBindInfo;
@@ -321,12 +381,43 @@ class DxilPipelineStateValidation
   uint32_t* m_pInputToOutputTable;
   uint32_t* m_pInputToPCOutputTable;
   uint32_t* m_pPCInputToOutputTable;
+  uint32_t* m_pResourceBindOrder;
+  uint32_t* m_pResourceBindBuckets;
+
+  // (class, space, lower bound) of a resource binding
+  bool BindKeyLess(uint32_t Left, uint32_t Right) const {
+    const PSVResourceBindInfo0 *pLeft = GetPSVResourceBindInfo0(Left);
+    const PSVResourceBindInfo0 *pRight = GetPSVResourceBindInfo0(Right);
+    PSVResourceClass LeftClass = PSVGetResourceClass(pLeft->ResType);
+    PSVResourceClass RightClass = PSVGetResourceClass(pRight->ResType);
+    if (LeftClass != RightClass)
+      return LeftClass < RightClass;
+    if (pLeft->Space != pRight->Space)
+      return pLeft->Space < pRight->Space;
+    return pLeft->LowerBound < pRight->LowerBound;
+  }
+
+  uint32_t HashSignatureElements(uint32_t Hash, uint32_t Count, PSVSignatureElement0 *(DxilPipelineStateValidation::*GetElement)(uint32_t) const) const {
+    Hash = PSVHashBytes(Hash, &Count, sizeof(Count));
+    for (uint32_t i = 0; i < Count; ++i) {
+      // Hash names and semantic indexes rather than their table offsets.
+      PSVSignatureElement0 Element = *(this->*GetElement)(i);
+      const char *Name = m_StringTable.Get(Element.SemanticName);
+      Hash = PSVHashBytes(Hash, Name, (uint32_t)strlen(Name) + 1);
+      Hash = PSVHashBytes(Hash, m_SemanticIndexTable.Get(Element.SemanticIndexes), sizeof(uint32_t) * Element.Rows);
+      Element.SemanticName = 0;
+      Element.SemanticIndexes = 0;
+      Hash = PSVHashBytes(Hash, &Element, sizeof(Element));
+    }
+    return Hash;
+  }
 
 public:
   DxilPipelineStateValidation() : 
     m_uPSVRuntimeInfoSize(0),
     m_pPSVRuntimeInfo0(nullptr),
     m_pPSVRuntimeInfo1(nullptr),
+    m_pPSVRuntimeInfo2(nullptr),
     m_uResourceCount(0),
     m_uPSVResourceBindInfoSize(0),
     m_pPSVResourceBindInfo(nullptr),
@@ -340,7 +431,9 @@ public:
     m_pViewIDPCOutputMask(nullptr),
     m_pInputToOutputTable(nullptr),
     m_pInputToPCOutputTable(nullptr),
-    m_pPCInputToOutputTable(nullptr)
+    m_pPCInputToOutputTable(nullptr),
+    m_pResourceBindOrder(nullptr),
+    m_pResourceBindBuckets(nullptr)
   {
   }
 
@@ -381,6 +474,11 @@ public:
   //    If (DS and SigOutputVectors[0] and SigPatchConstantVectors non-zero):
   //      { PSVComputeInputOutputTableSize(SigPatchConstantVectors, SigOutputVectors[0]) }
   //        - Outputs affected by patch constant inputs as a table of bitmasks
+  // If PSVRuntimeInfo2:
+  //    { uint32_t resource index } * ResourceCount
+  //      - Bindings sorted by (PSVResourceClass, Space, LowerBound)
+  //    { uint32_t resource index or PSV_EMPTY_BIND_BUCKET } * ResourceBindBuckets
+  //      - Open addressing hash table keyed by PSVHashBindKey
   // returns true if no errors occurred.
   bool InitFromPSV0(const void* pBits, uint32_t size) {
     if(!(pBits != nullptr)) return false;
@@ -395,6 +493,8 @@ public:
     m_pPSVRuntimeInfo0 = const_cast<PSVRuntimeInfo0*>((const PSVRuntimeInfo0*)pCurBits);
     if(m_uPSVRuntimeInfoSize >= sizeof(PSVRuntimeInfo1))
       m_pPSVRuntimeInfo1 = const_cast<PSVRuntimeInfo1*>((const PSVRuntimeInfo1*)pCurBits);
+    if(m_uPSVRuntimeInfoSize >= sizeof(PSVRuntimeInfo2))
+      m_pPSVRuntimeInfo2 = const_cast<PSVRuntimeInfo2*>((const PSVRuntimeInfo2*)pCurBits);
     pCurBits += m_uPSVRuntimeInfoSize;
     m_uResourceCount = *(const uint32_t*)pCurBits;
     pCurBits += sizeof(uint32_t);
@@ -497,6 +597,29 @@ public:
         pCurBits += PSVComputeInputOutputTableSize(m_pPSVRuntimeInfo1->SigPatchConstantVectors, m_pPSVRuntimeInfo1->SigOutputVectors[0]);
       }
     }
+
+    if (m_pPSVRuntimeInfo2) {
+      // Resource binding indexes
+      if (m_pPSVRuntimeInfo2->ResourceBindBuckets != PSVComputeBindBuckets(m_uResourceCount))
+        return false;   // Illegal: Hash table not sized for the resources
+      minsize += sizeof(uint32_t) * (m_uResourceCount + m_pPSVRuntimeInfo2->ResourceBindBuckets);
+      if (!(size >= minsize)) return false;
+      if (m_uResourceCount) {
+        m_pResourceBindOrder = (uint32_t*)pCurBits;
+        pCurBits += sizeof(uint32_t) * m_uResourceCount;
+        m_pResourceBindBuckets = (uint32_t*)pCurBits;
+        pCurBits += sizeof(uint32_t) * m_pPSVRuntimeInfo2->ResourceBindBuckets;
+        for (uint32_t i = 0; i < m_uResourceCount; ++i) {
+          if (m_pResourceBindOrder[i] >= m_uResourceCount)
+            return false;
+        }
+        for (uint32_t i = 0; i < m_pPSVRuntimeInfo2->ResourceBindBuckets; ++i) {
+          if (m_pResourceBindBuckets[i] != PSV_EMPTY_BIND_BUCKET &&
+              m_pResourceBindBuckets[i] >= m_uResourceCount)
+            return false;
+        }
+      }
+    }
     return true;
   }
 
@@ -511,7 +634,7 @@ public:
 
   bool InitNew(const PSVInitInfo &initInfo, void *pBuffer, uint32_t *pSize) {
     if(!(pSize)) return false;
-    if (initInfo.PSVVersion > 1) return false;
+    if (initInfo.PSVVersion > 2) return false;
 
     // Versioned structure sizes
     m_uPSVRuntimeInfoSize = sizeof(PSVRuntimeInfo0);
@@ -520,6 +643,9 @@ public:
     if (initInfo.PSVVersion > 0) {
       m_uPSVRuntimeInfoSize = sizeof(PSVRuntimeInfo1);
     }
+    if (initInfo.PSVVersion > 1) {
+      m_uPSVRuntimeInfoSize = sizeof(PSVRuntimeInfo2);
+    }
 
     // PSVVersion 0
     uint32_t size = m_uPSVRuntimeInfoSize + sizeof(uint32_t) * 2;
@@ -562,6 +688,11 @@ public:
       }
     }
 
+    // PSVVersion 2
+    if (initInfo.PSVVersion > 1) {
+      size += sizeof(uint32_t) * (initInfo.ResourceCount + PSVComputeBindBuckets(initInfo.ResourceCount));
+    }
+
     // Validate or return required size
     if (pBuffer) {
       if(!(*pSize >= size)) return false;
@@ -673,9 +804,53 @@ public:
       }
     }
 
+    // PSVVersion 2
+    if (initInfo.PSVVersion > 1) {
+      m_pPSVRuntimeInfo2 = (PSVRuntimeInfo2*)m_pPSVRuntimeInfo0;
+      m_pPSVRuntimeInfo2->ResourceBindBuckets = PSVComputeBindBuckets(m_uResourceCount);
+      if (m_uResourceCount) {
+        m_pResourceBindOrder = (uint32_t*)pCurBits;
+        pCurBits += sizeof(uint32_t) * m_uResourceCount;
+        m_pResourceBindBuckets = (uint32_t*)pCurBits;
+        pCurBits += sizeof(uint32_t) * m_pPSVRuntimeInfo2->ResourceBindBuckets;
+      }
+    }
+
     return true;
   }
 
+  // For PSVVersion 2, computes the binding indexes and the signature hash
+  // once the resource bindings and signature elements have been filled in.
+  void BuildIndexes() {
+    if (!m_pPSVRuntimeInfo2)
+      return;
+    uint32_t Hash = PSV_HASH_SEED;
+    Hash = HashSignatureElements(Hash, GetSigInputElements(), &DxilPipelineStateValidation::GetInputElement0);
+    Hash = HashSignatureElements(Hash, GetSigOutputElements(), &DxilPipelineStateValidation::GetOutputElement0);
+    Hash = HashSignatureElements(Hash, GetSigPatchConstantElements(), &DxilPipelineStateValidation::GetPatchConstantElement0);
+    m_pPSVRuntimeInfo2->SignatureHash = Hash;
+
+    if (!m_uResourceCount)
+      return;
+    // Insertion sort keeps this header free of dependencies; it runs once
+    // per shader at compile time.
+    for (uint32_t i = 0; i < m_uResourceCount; ++i) {
+      uint32_t j = i;
+      for (; j > 0 && BindKeyLess(i, m_pResourceBindOrder[j - 1]); --j)
+        m_pResourceBindOrder[j] = m_pResourceBindOrder[j - 1];
+      m_pResourceBindOrder[j] = i;
+    }
+    uint32_t Mask = m_pPSVRuntimeInfo2->ResourceBindBuckets - 1;
+    memset(m_pResourceBindBuckets, 0xFF, sizeof(uint32_t) * m_pPSVRuntimeInfo2->ResourceBindBuckets);
+    for (uint32_t i = 0; i < m_uResourceCount; ++i) {
+      const PSVResourceBindInfo0 *pBindInfo = GetPSVResourceBindInfo0(i);
+      uint32_t Bucket = PSVHashBindKey(PSVGetResourceClass(pBindInfo->ResType), pBindInfo->Space, pBindInfo->LowerBound) & Mask;
+      while (m_pResourceBindBuckets[Bucket] != PSV_EMPTY_BIND_BUCKET)
+        Bucket = (Bucket + 1) & Mask;
+      m_pResourceBindBuckets[Bucket] = i;
+    }
+  }
+
   PSVRuntimeInfo0* GetPSVRuntimeInfo0() const {
     return m_pPSVRuntimeInfo0;
   }
@@ -684,6 +859,10 @@ public:
     return m_pPSVRuntimeInfo1;
   }
 
+  PSVRuntimeInfo2* GetPSVRuntimeInfo2() const {
+    return m_pPSVRuntimeInfo2;
+  }
+
   uint32_t GetBindCount() const {
     return m_uResourceCount;
   }
@@ -697,6 +876,58 @@ public:
     return nullptr;
   }
 
+  // Binding indexes (PSVVersion 2)
+  bool HasResourceBindIndexes() const {
+    return m_pPSVRuntimeInfo2 != nullptr;
+  }
+  // Index of the binding in sorted (class, space, lower bound) order
+  const uint32_t *GetSortedResourceBindIndexes() const {
+    return m_pResourceBindOrder;
+  }
+  // Finds the binding of the given class and space whose range holds
+  // Register, in constant time when Register is its lower bound.
+  // Returns false if there is none or the part has no binding indexes.
+  bool FindResourceBind(PSVResourceClass Class, uint32_t Space, uint32_t Register, uint32_t *pIndex) const {
+    if (!m_pResourceBindBuckets || !pIndex)
+      return false;
+    uint32_t Mask = m_pPSVRuntimeInfo2->ResourceBindBuckets - 1;
+    uint32_t Bucket = PSVHashBindKey(Class, Space, Register) & Mask;
+    for (; m_pResourceBindBuckets[Bucket] != PSV_EMPTY_BIND_BUCKET; Bucket = (Bucket + 1) & Mask) {
+      const PSVResourceBindInfo0 *pBindInfo = GetPSVResourceBindInfo0(m_pResourceBindBuckets[Bucket]);
+      if (PSVGetResourceClass(pBindInfo->ResType) == Class &&
+          pBindInfo->Space == Space && pBindInfo->LowerBound == Register) {
+        *pIndex = m_pResourceBindBuckets[Bucket];
+        return true;
+      }
+    }
+    // Otherwise take the last binding starting at or below Register.
+    uint32_t First = 0, Count = m_uResourceCount;
+    while (Count > 0) {
+      uint32_t Step = Count / 2;
+      const PSVResourceBindInfo0 *pBindInfo = GetPSVResourceBindInfo0(m_pResourceBindOrder[First + Step]);
+      PSVResourceClass BindClass = PSVGetResourceClass(pBindInfo->ResType);
+      if (BindClass < Class || (BindClass == Class && (pBindInfo->Space < Space ||
+          (pBindInfo->Space == Space && pBindInfo->LowerBound <= Register)))) {
+        First += Step + 1;
+        Count -= Step + 1;
+      } else {
+        Count = Step;
+      }
+    }
+    if (First == 0)
+      return false;
+    const PSVResourceBindInfo0 *pBindInfo = GetPSVResourceBindInfo0(m_pResourceBindOrder[First - 1]);
+    if (PSVGetResourceClass(pBindInfo->ResType) != Class || pBindInfo->Space != Space ||
+        pBindInfo->UpperBound < Register)
+      return false;
+    *pIndex = m_pResourceBindOrder[First - 1];
+    return true;
+  }
+  // Combined signature hash (PSVVersion 2), 0 if not present
+  uint32_t GetSignatureHash() const {
+    return m_pPSVRuntimeInfo2 ? m_pPSVRuntimeInfo2->SignatureHash : 0;
+  }
+
   const PSVStringTable &GetStringTable() const { return m_StringTable; }
   const PSVSemanticIndexTable &GetSemanticIndexTable() const { return m_SemanticIndexTable; }
 
@@ -26,6 +26,7 @@ namespace llvm {
 namespace hlsl {
 
 // Forward declarations.
+struct DxilContainerHash;
 struct DxilDescriptorRange;
 struct DxilDescriptorRange1;
 struct DxilRootConstants;
@@ -335,6 +336,25 @@ public:
   const DxilVersionedRootSignatureDesc *GetDesc() const { return m_pDesc; }
 };
 
+// Process-wide cache of root signatures compiled from source text, keyed on
+// the version and the text, so that shaders sharing a root signature parse,
+// verify and serialize it once. Entries hold the serialized form only; a
+// handle assigned from the cache deserializes it if the description is
+// needed. Thread-safe.
+bool LookupCachedRootSignature(DxilRootSignatureVersion Version,
+                               const char *pText, size_t TextLength,
+                               _Outptr_result_maybenull_ IDxcBlob **ppSerialized);
+void StoreCachedRootSignature(DxilRootSignatureVersion Version,
+                              const char *pText, size_t TextLength,
+                              _In_ IDxcBlob *pSerialized);
+void ClearRootSignatureCache();
+
+// Computes the digest of a serialized root signature (the RTS0 part), which
+// is the same for every container carrying that root signature, so that
+// archives can key one copy on it.
+void ComputeRootSignatureHash(_In_reads_bytes_(Size) const void *pData,
+                              uint32_t Size, _Out_ DxilContainerHash *pHash);
+
 void DeleteRootSignature(const DxilVersionedRootSignatureDesc *pRootSignature);  
 
 // Careful to delete: returns the original root signature, if conversion is not required.  
@@ -357,6 +377,33 @@ bool VerifyRootSignatureWithShaderPSV(_In_ const DxilVersionedRootSignatureDesc
                                       _In_ uint32_t PSVSize,
                                       _In_ llvm::raw_ostream &DiagStream);
 
+// Why a shader does not fit a root signature; the values are those of the
+// DxcRootSignatureCompatibility_* constants in dxcapi.h.
+enum class DxilRootSignatureCompatibility : uint32_t {
+  Compatible = 0,
+  InvalidRootSignature = 1,       // The root signature fails verification.
+  InvalidShader = 2,              // The shader has no readable PSV part.
+  UnboundResource = 3,            // A resource is not fully bound.
+  RootDescriptorResourceType = 4, // A root descriptor binds a typed or
+                                  // counter resource.
+  DeniedShaderStage = 5,          // A DENY flag blocks a stage with bindings.
+};
+
+struct DxilShaderPSV {
+  DXIL::ShaderKind ShaderKind;
+  const void *pPSVData; // Null if the shader has no PSV part.
+  uint32_t PSVSize;
+};
+
+// Checks every shader against every root signature, verifying each root
+// signature and reading each PSV part once. pResults receives
+// NumRootSignatures rows of NumShaders reasons each.
+void VerifyRootSignaturesWithShaderPSVs(
+    unsigned NumRootSignatures,
+    _In_count_(NumRootSignatures) const DxilVersionedRootSignatureDesc *const *ppDescs,
+    unsigned NumShaders, _In_count_(NumShaders) const DxilShaderPSV *pShaders,
+    _Out_writes_(NumRootSignatures * NumShaders) DxilRootSignatureCompatibility *pResults);
+
 } // namespace hlsl
 
 #endif // __DXC_ROOTSIGNATURE__
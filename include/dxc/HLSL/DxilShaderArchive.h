@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilShaderArchive.h                                                       //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides declarations for archives of DXIL containers that store each     //
+// unique part once.                                                         //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifndef __DXC_SHADER_ARCHIVE__
+#define __DXC_SHADER_ARCHIVE__
+
+#include "dxc/HLSL/DxilContainer.h"
+
+namespace hlsl {
+
+#pragma pack(push, 1)
+
+static const uint16_t DxilShaderArchiveVersionMajor = 1;
+static const uint16_t DxilShaderArchiveVersionMinor = 0;
+static const uint32_t DxilShaderArchiveFourCC = DXIL_FOURCC('D', 'X', 'S', 'A');
+
+// An archive is laid out as follows, with every table and every part's data
+// starting on a 4-byte boundary, so it can be used straight from a mapping:
+//   DxilShaderArchiveHeader
+//   DxilShaderArchiveContainer[ContainerCount]
+//   uint32_t Buckets[BucketCount]      - container indices, open addressing
+//   DxilShaderArchivePart[PartCount]   - unique parts
+//   uint32_t PartRefs[PartRefCount]    - part indices, in container order
+//   part data
+struct DxilShaderArchiveHeader {
+  uint32_t HeaderFourCC;
+  uint16_t MajorVersion;
+  uint16_t MinorVersion;
+  uint32_t ArchiveSizeInBytes;
+  uint32_t ContainerCount;
+  uint32_t BucketCount;         // Power of two, larger than ContainerCount.
+  uint32_t PartCount;
+  uint32_t PartRefCount;
+  uint32_t ContainerTableOffset;
+  uint32_t BucketTableOffset;
+  uint32_t PartTableOffset;
+  uint32_t PartRefTableOffset;
+};
+
+struct DxilShaderArchiveContainer {
+  DxilContainerHash Key;        // MD5 content digest of the container.
+  DxilContainerHash Hash;       // Hash field of the container header.
+  DxilContainerVersion Version;
+  uint32_t ContainerSizeInBytes;
+  uint32_t FirstPartRef;
+  uint32_t PartCount;
+};
+
+struct DxilShaderArchivePart {
+  uint32_t PartFourCC;
+  uint32_t PartSize;
+  uint32_t DataOffset;          // From the start of the archive.
+};
+
+#pragma pack(pop)
+
+static const uint32_t DxilShaderArchiveEmptyBucket = UINT32_MAX;
+
+/// Computes the key an archive indexes the container by.
+void GetDxilShaderArchiveKey(const DxilContainerHeader *pHeader,
+                             DxilContainerHash *pKey);
+
+/// Collects containers and writes them as an archive. Parts are copied as
+/// containers are added, so the containers need not outlive the writer.
+class DxilShaderArchiveWriter : public DxilPartWriter {
+public:
+  virtual ~DxilShaderArchiveWriter() {}
+  // Adds a valid container whose parts follow its offset table in order
+  // without gaps, as the container writer and builder lay them out. Adding
+  // a container that is already in the archive only retrieves its key.
+  // Returns false if the container cannot be archived.
+  virtual bool AddContainer(const DxilContainerHeader *pHeader, size_t length,
+                            DxilContainerHash *pKey) = 0;
+  virtual uint32_t GetContainerCount() const = 0;
+  virtual uint32_t GetUniquePartCount() const = 0;
+};
+
+DxilShaderArchiveWriter *NewDxilShaderArchiveWriter();
+
+/// Reads containers out of an archive in place. The archive is validated
+/// once on Load, and must outlive the reader.
+class DxilShaderArchiveReader {
+private:
+  const char *m_pArchive;
+  const DxilShaderArchiveHeader *m_pHeader;
+  const DxilShaderArchiveContainer *m_pContainers;
+  const uint32_t *m_pBuckets;
+  const DxilShaderArchivePart *m_pParts;
+  const uint32_t *m_pPartRefs;
+
+public:
+  DxilShaderArchiveReader()
+      : m_pArchive(nullptr), m_pHeader(nullptr), m_pContainers(nullptr),
+        m_pBuckets(nullptr), m_pParts(nullptr), m_pPartRefs(nullptr) {}
+
+  // Returns false if the archive is malformed.
+  bool Load(const void *pArchive, size_t length);
+  bool IsLoaded() const { return m_pHeader != nullptr; }
+
+  uint32_t GetContainerCount() const {
+    return m_pHeader ? m_pHeader->ContainerCount : 0;
+  }
+  const DxilShaderArchiveContainer &GetContainer(uint32_t index) const {
+    return m_pContainers[index];
+  }
+  const DxilShaderArchivePart &GetContainerPart(uint32_t index,
+                                                uint32_t partIndex) const {
+    return m_pParts[m_pPartRefs[m_pContainers[index].FirstPartRef + partIndex]];
+  }
+  const char *GetPartData(const DxilShaderArchivePart &part) const {
+    return m_pArchive + part.DataOffset;
+  }
+
+  // Looks a container up by the key from GetDxilShaderArchiveKey.
+  bool FindContainer(const DxilContainerHash &Key, uint32_t *pIndex) const;
+  // Writes the container's ContainerSizeInBytes bytes to pDest, copying each
+  // part's data once.
+  void ReadContainer(uint32_t index, void *pDest) const;
+};
+
+} // namespace hlsl
+
+#endif // __DXC_SHADER_ARCHIVE__
@@ -82,12 +82,26 @@ private:
   unsigned m_NumUAVRegs;
 
   ShaderModel() = delete;
-  ShaderModel(Kind Kind, unsigned Major, unsigned Minor, const char *pszName,
-              unsigned m_NumInputRegs, unsigned m_NumOutputRegs,
-              bool m_bUAVs, bool m_bTypedUavs, unsigned m_UAVRegsLim);
+  // constexpr so that ms_ShaderModels is initialized at compile time, with
+  // nothing to run at load and nothing to race on between threads.
+  constexpr ShaderModel(Kind Kind, unsigned Major, unsigned Minor,
+                        const char *pszName, unsigned NumInputRegs,
+                        unsigned NumOutputRegs, bool bUAVs, bool bTypedUavs,
+                        unsigned NumUAVRegs)
+      : m_Kind(Kind), m_Major(Major), m_Minor(Minor), m_pszName(pszName),
+        m_NumInputRegs(NumInputRegs), m_NumOutputRegs(NumOutputRegs),
+        m_bUAVs(bUAVs), m_bTypedUavs(bTypedUavs), m_NumUAVRegs(NumUAVRegs) {}
 
   static const unsigned kNumShaderModels = 34;
   static const ShaderModel ms_ShaderModels[kNumShaderModels];
+  // Index into ms_ShaderModels by kind, major version 4 to 6 and minor
+  // version 0 to 1.
+  static const unsigned kMinIndexedMajor = 4;
+  static const unsigned kNumIndexedMajors = 3;
+  static const unsigned kNumIndexedMinors = 2;
+  static const unsigned char
+      ms_ShaderModelIndex[(unsigned)Kind::Invalid][kNumIndexedMajors]
+                         [kNumIndexedMinors];
 
   static const ShaderModel *GetInvalid();
 };
@@ -16,7 +16,7 @@
 namespace hlsl {
 
 struct VersionedSemanticInterpretation {
-  VersionedSemanticInterpretation(DXIL::SemanticInterpretationKind k, unsigned MajorVersion=0, unsigned MinorVersion=0) :
+  constexpr VersionedSemanticInterpretation(DXIL::SemanticInterpretationKind k, unsigned MajorVersion=0, unsigned MinorVersion=0) :
     Kind(k), Major((unsigned short)MajorVersion), Minor((unsigned short)MinorVersion)
   {}
   DXIL::SemanticInterpretationKind Kind;
@@ -30,7 +30,10 @@ class SigPoint {
 public:
   using Kind = DXIL::SigPointKind;
 
-  SigPoint(DXIL::SigPointKind spk, const char *name, DXIL::SigPointKind rspk, DXIL::ShaderKind shk, DXIL::SignatureKind sigk, DXIL::PackingKind pk);
+  // constexpr so that the tables are initialized at compile time.
+  constexpr SigPoint(DXIL::SigPointKind spk, const char *name, DXIL::SigPointKind rspk, DXIL::ShaderKind shk, DXIL::SignatureKind sigk, DXIL::PackingKind pk) :
+    m_Kind(spk), m_RelatedKind(rspk), m_ShaderKind(shk), m_SignatureKind(sigk), m_pszName(name), m_PackingKind(pk)
+  {}
 
   bool IsInput() const { return m_SignatureKind == DXIL::SignatureKind::Input; }
   bool IsOutput() const { return m_SignatureKind == DXIL::SignatureKind::Output; }
@@ -40,6 +40,10 @@ public:
   const DxilSignatureElement &GetElement(unsigned idx) const;
   const std::vector<std::unique_ptr<DxilSignatureElement> > &GetElements() const;
 
+  // Removes the elements whose flag in bDelete is set and renumbers the IDs of
+  // the remaining elements to match their new positions.
+  void DeleteElements(const std::vector<bool> &bDelete);
+
   // Packs the signature elements per DXIL constraints and returns the number of rows used for the signature
   unsigned PackElements(DXIL::PackingStrategy packing);
 
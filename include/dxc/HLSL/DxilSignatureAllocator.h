@@ -129,6 +129,9 @@ public:
   // Simple greedy in-order packer used by PackOptimized
   unsigned PackGreedy(std::vector<PackElement*> elements, unsigned startRow, unsigned numRows, unsigned startCol = 0);
 
+  // Greedy packer that tries several element orders and keeps the tightest
+  unsigned PackBestOrder(std::vector<PackElement*> elements, unsigned startRow, unsigned numRows);
+
   // Optimized packing algorithm - appended elements may affect positions of prior elements.
   unsigned PackOptimized(std::vector<PackElement*> elements, unsigned startRow, unsigned numRows);
 
@@ -211,6 +211,28 @@ struct {
   }
 } CmpElementsLess;
 
+// Alternative orderings tried by PackBestOrder: largest elements first
+// regardless of interpolation mode, and widest elements first.
+int CmpElementsBySize(const DxilSignatureAllocator::PackElement* left, const DxilSignatureAllocator::PackElement* right) {
+  unsigned result;
+  result = -cmp(left->GetRows() * left->GetCols(), right->GetRows() * right->GetCols());
+  if (result) return result;
+  return CmpElements(left, right);
+}
+int CmpElementsByWidth(const DxilSignatureAllocator::PackElement* left, const DxilSignatureAllocator::PackElement* right) {
+  unsigned result;
+  result = -cmp(left->GetCols(), right->GetCols());
+  if (result) return result;
+  return CmpElements(left, right);
+}
+
+typedef int (*PackElementCmpFn)(const DxilSignatureAllocator::PackElement*, const DxilSignatureAllocator::PackElement*);
+static const PackElementCmpFn PackElementOrders[] = {
+  CmpElements,        // Must be first; preferred unless another is strictly better.
+  CmpElementsBySize,
+  CmpElementsByWidth,
+};
+
 } // anonymous namespace
 
 unsigned DxilSignatureAllocator::PackNext(PackElement* SE, unsigned startRow, unsigned numRows, unsigned startCol) {
@@ -249,6 +271,53 @@ unsigned DxilSignatureAllocator::PackGreedy(std::vector<PackElement*> elements,
   return rowsUsed;
 }
 
+unsigned DxilSignatureAllocator::PackBestOrder(std::vector<PackElement*> elements, unsigned startRow, unsigned numRows) {
+  // Greedy packing is sensitive to element order, so try a few orders from
+  // the same starting state and keep the one that allocates the most
+  // elements in the fewest rows.
+  const std::vector<PackedRegister> savedRegisters = m_Registers;
+  const unsigned numOrders = sizeof(PackElementOrders) / sizeof(PackElementOrders[0]);
+  unsigned bestOrder = 0;
+  unsigned bestAllocated = 0;
+  unsigned bestRowsUsed = 0;
+  for (unsigned order = 0; order < numOrders; ++order) {
+    PackElementCmpFn cmpFn = PackElementOrders[order];
+    std::sort(elements.begin(), elements.end(),
+              [cmpFn](const PackElement *left, const PackElement *right) {
+                return cmpFn(left, right) < 0;
+              });
+    m_Registers = savedRegisters;
+    for (auto &SE : elements)
+      SE->ClearLocation();
+    unsigned rowsUsed = PackGreedy(elements, startRow, numRows);
+    unsigned allocated = 0;
+    for (auto &SE : elements) {
+      if (SE->IsAllocated())
+        ++allocated;
+    }
+    if (order == 0 || allocated > bestAllocated ||
+        (allocated == bestAllocated && rowsUsed < bestRowsUsed)) {
+      bestOrder = order;
+      bestAllocated = allocated;
+      bestRowsUsed = rowsUsed;
+    }
+  }
+
+  // Repack with the winning order, unless it was the last one tried.
+  if (bestOrder != numOrders - 1) {
+    PackElementCmpFn cmpFn = PackElementOrders[bestOrder];
+    std::sort(elements.begin(), elements.end(),
+              [cmpFn](const PackElement *left, const PackElement *right) {
+                return cmpFn(left, right) < 0;
+              });
+    m_Registers = savedRegisters;
+    for (auto &SE : elements)
+      SE->ClearLocation();
+    PackGreedy(elements, startRow, numRows);
+  }
+  return bestRowsUsed;
+}
+
 unsigned DxilSignatureAllocator::PackOptimized(std::vector<PackElement*> elements, unsigned startRow, unsigned numRows) {
   unsigned rowsUsed = startRow;
 
@@ -376,8 +445,7 @@ unsigned DxilSignatureAllocator::PackOptimized(std::vector<PackElement*> element
   // ==========
   // Allocate arbitrary
   if (!arbElements.empty()) {
-    std::sort(arbElements.begin(), arbElements.end(), CmpElementsLess);
-    unsigned used = PackGreedy(arbElements, startRow, numRows);
+    unsigned used = PackBestOrder(arbElements, startRow, numRows);
     if (rowsUsed < used)
       rowsUsed = used;
   }
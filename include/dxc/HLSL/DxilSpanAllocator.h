@@ -52,13 +52,15 @@ public:
       return false;
     if (pos < m_FirstFree)
       pos = m_FirstFree;
+    if (align == 1 && pos < GetSearchStart(size))
+      pos = GetSearchStart(size);
     if (!UpdatePos(pos, size, align))
       return false;
     T_index end = pos + (size - 1);
     auto next = m_Spans.lower_bound(Span(nullptr, pos, end));
     if (next == m_Spans.end() || end < next->start)
       return true;  // it fits here
-    return Find(size, result.first, pos, align);
+    return Find(size, next, pos, align);
   }
 
   // allocate element size in first available space, returns false on failure
@@ -69,18 +71,24 @@ public:
     if (m_AllocationFull)
       return false;
     pos = m_FirstFree;
+    if (align == 1 && pos < GetSearchStart(size))
+      pos = GetSearchStart(size);
     if (!UpdatePos(pos, size, align))
       return false;
     auto result = m_Spans.emplace(element, pos, pos + (size - 1));
     if (result.second) {
       AdvanceFirstFree(result.first);
-      return true;
+    } else {
+      // Collision, find a gap from iterator
+      if (!Find(size, result.first, pos, align))
+        return false;
+      result = m_Spans.emplace(element, pos, pos + (size - 1));
+      if (!result.second)
+        return false;
     }
-    // Collision, find a gap from iterator
-    if (!Find(size, result.first, pos, align))
-      return false;
-    result = m_Spans.emplace(element, pos, pos + (size - 1));
-    return result.second;
+    if (align == 1)
+      SetSearchStart(size, pos);
+    return true;
   }
 
   bool AllocateUnbounded(const T_element *element, T_index &pos, T_index align = 1) {
@@ -145,6 +153,26 @@ private:
     }
   }
 
+  // Spans are never removed, so gaps only shrink: once the first gap of some
+  // size has been found, later searches for that size or larger can start
+  // past it. This keeps repeated allocations of array sizes that don't fit
+  // the first free gap from rescanning every span before it.
+  T_index GetSearchStart(T_index size) const {
+    auto it = m_SearchStart.upper_bound(size);
+    if (it == m_SearchStart.begin())
+      return m_Min;
+    return (--it)->second;
+  }
+  // Records that no gap of size fits before the span allocated at pos.
+  void SetSearchStart(T_index size, T_index pos) {
+    T_index next = pos + size;
+    if (next < pos)
+      next = m_Max; // overflow; the allocation ends at m_Max
+    T_index &start = m_SearchStart[size];
+    if (start < next)
+      start = next;
+  }
+
   T_index Align(T_index pos, T_index align) {
     T_index rem = (1 < align) ? pos % align : 0;
     return rem ? pos + (align - rem) : pos;
@@ -169,6 +197,8 @@ private:
 
 private:
   SpanSet m_Spans;
+  // Lowest position at which a gap of at least the key size may start.
+  std::map<T_index, T_index> m_SearchStart;
   T_index m_Min, m_Max, m_FirstFree;
   const T_element *m_Unbounded;
   bool m_AllocationFull;
@@ -50,6 +50,12 @@ public:
   bool IsPrecise() const;
   void SetPrecise(bool b = true);
 
+  /// Whether the field is a 4x4 matrix, or array of them, declared [affine],
+  /// so that its last row is 0, 0, 0, 1. This is used by matrix lowering
+  /// and is not written to metadata.
+  bool IsAffine() const;
+  void SetAffine(bool b = true);
+
   bool HasMatrixAnnotation() const;
   const DxilMatrixAnnotation &GetMatrixAnnotation() const;
   void SetMatrixAnnotation(const DxilMatrixAnnotation &MA);
@@ -81,6 +87,7 @@ public:
 
 private:
   bool m_bPrecise;
+  bool m_bAffine;
   CompType m_CompType;
   DxilMatrixAnnotation m_Matrix;
   llvm::MDNode *m_ResourceAttribute;
@@ -12,12 +12,18 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include "dxc/Support/Global.h"
 #include "dxc/HLSL/DxilConstants.h"
 
 namespace llvm {
 class Module;
+class Function;
 class LLVMContext;
+class CallGraph;
+class DominatorTree;
+class LoopInfo;
+struct PostDominatorTree;
 class raw_ostream;
 class DiagnosticPrinter;
 class DiagnosticInfo;
@@ -238,8 +244,44 @@ enum class ValidationRule : unsigned {
 
 const char *GetValidationRuleText(ValidationRule value);
 void GetValidationVersion(_Out_ unsigned *pMajor, _Out_ unsigned *pMinor);
+
+// Control flow analyses used by module validation, computed on first use and
+// kept until the module's CFG changes. A caller that already holds the final
+// module can pass one instance to several validation calls so dominator
+// trees, loop info and the call graph are built once. Not thread-safe.
+class DxilValidationAnalyses {
+public:
+  explicit DxilValidationAnalyses(llvm::Module &M);
+  ~DxilValidationAnalyses();
+
+  llvm::Module &GetModule() const { return m_Module; }
+  bool IsReducible();
+  llvm::CallGraph &GetCallGraph();
+  llvm::DominatorTree &GetDominatorTree(llvm::Function &F);
+  llvm::LoopInfo &GetLoopInfo(llvm::Function &F);
+  llvm::PostDominatorTree &GetPostDominatorTree(llvm::Function &F);
+
+private:
+  struct FunctionAnalyses;
+  FunctionAnalyses &GetFunctionAnalyses(llvm::Function &F);
+
+  llvm::Module &m_Module;
+  int m_Reducible; // -1 until computed.
+  std::unique_ptr<llvm::CallGraph> m_CallGraph;
+  std::unordered_map<llvm::Function *, std::unique_ptr<FunctionAnalyses>>
+      m_FunctionAnalyses;
+};
+
+// Validates the module. pAnalyses, when provided, must have been created for
+// pModule and is updated with whatever analyses validation computes.
+// Diagnostics are written to pDiagStream as they are produced when one is
+// given, and reported through the module's context otherwise. At most
+// MaxErrors errors are printed; 0 prints all of them.
 HRESULT ValidateDxilModule(_In_ llvm::Module *pModule,
-                           _In_opt_ llvm::Module *pDebugModule);
+                           _In_opt_ llvm::Module *pDebugModule,
+                           _In_opt_ DxilValidationAnalyses *pAnalyses = nullptr,
+                           _In_opt_ llvm::raw_ostream *pDiagStream = nullptr,
+                           _In_ unsigned MaxErrors = 0);
 
 // DXIL Container Verification Functions (return false on failure)
 
@@ -265,11 +307,14 @@ HRESULT ValidateDxilContainerParts(_In_ llvm::Module *pModule,
                                    _In_ uint32_t ContainerSize);
 
 // Loads module, validating load, but not module.
+// With bLazy, function bodies are decoded on demand and pIL must outlive the
+// module; ValidateDxilModule materializes them before body-level checks.
 HRESULT ValidateLoadModule(_In_reads_bytes_(ILLength) const char *pIL,
                            _In_ uint32_t ILLength,
                            _In_ std::unique_ptr<llvm::Module> &pModule,
                            _In_ llvm::LLVMContext &Ctx,
-                           _In_ llvm::raw_ostream &DiagStream);
+                           _In_ llvm::raw_ostream &DiagStream,
+                           _In_ bool bLazy = false);
 
 // Loads module from container, validating load, but not module.
 HRESULT ValidateLoadModuleFromContainer(
@@ -277,7 +322,7 @@ HRESULT ValidateLoadModuleFromContainer(
     _In_ uint32_t ContainerSize, _In_ std::unique_ptr<llvm::Module> &pModule,
     _In_ std::unique_ptr<llvm::Module> &pDebugModule,
     _In_ llvm::LLVMContext &Ctx, llvm::LLVMContext &DbgCtx,
-    _In_ llvm::raw_ostream &DiagStream);
+    _In_ llvm::raw_ostream &DiagStream, _In_ bool bLazy = false);
 
 // Load and validate Dxil module from bitcode.
 HRESULT ValidateDxilBitcode(_In_reads_bytes_(ILLength) const char *pIL,
@@ -20,6 +20,8 @@
 #include "dxc/HLSL/DxilShaderModel.h"
 #include "dxc/HLSL/DxilSignature.h"
 #include "dxc/HLSL/DxilFunctionProps.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -129,6 +131,12 @@ public:
   DxilFunctionAnnotation *GetFunctionAnnotation(llvm::Function *F);
   DxilFunctionAnnotation *AddFunctionAnnotation(llvm::Function *F);
 
+  // HL operation groups, recorded as HL functions are created so calls are
+  // classified without parsing the callee name. Functions without a group
+  // recorded are not HL operations.
+  void SetHLFunctionGroup(llvm::Function *F, HLOpcodeGroup group);
+  HLOpcodeGroup GetHLFunctionGroup(const llvm::Function *F) const;
+
   void AddResourceTypeAnnotation(llvm::Type *Ty, DXIL::ResourceClass resClass,
                                  DXIL::ResourceKind kind);
   DXIL::ResourceClass GetResourceClass(llvm::Type *Ty);
@@ -208,6 +216,10 @@ public:
   RootSignatureHandle *ReleaseRootSignature();
   std::unordered_map<llvm::Function *, std::unique_ptr<DxilFunctionProps>> &&
   ReleaseFunctionPropsMap();
+  std::vector<std::unique_ptr<DxilCBuffer> > &&ReleaseCBuffers();
+  std::vector<std::unique_ptr<DxilSampler> > &&ReleaseSamplers();
+  std::vector<std::unique_ptr<HLResource> > &&ReleaseSRVs();
+  std::vector<std::unique_ptr<HLResource> > &&ReleaseUAVs();
 
   llvm::DebugInfoFinder &GetOrCreateDebugInfoFinder();
   static llvm::DIGlobalVariable *
@@ -241,8 +253,12 @@ private:
   // High level function info.
   std::unordered_map<llvm::Function *, std::unique_ptr<DxilFunctionProps>>  m_DxilFunctionPropsMap;
 
+  // Groups of the HL operation functions.
+  llvm::DenseMap<const llvm::Function *, HLOpcodeGroup> m_HLFunctionGroups;
+
   // Resource type annotation.
-  std::unordered_map<llvm::Type *, std::pair<DXIL::ResourceClass, DXIL::ResourceKind>> m_ResTypeAnnotation;
+  // In the order added, as the annotations are emitted in this order.
+  llvm::MapVector<llvm::Type *, std::pair<DXIL::ResourceClass, DXIL::ResourceKind>> m_ResTypeAnnotation;
 
 private:
   llvm::LLVMContext &m_Ctx;
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// PassStatistics.h                                                          //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides hooks to observe the passes run on this thread, and the IR size  //
+// and statistics recorder used by -print-stats.                             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "llvm/ADT/StringMap.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class Function;
+class Module;
+class Statistic;
+class raw_ostream;
+}
+
+namespace hlsl {
+
+/// Receives each pass run by the legacy pass manager on the thread it is
+/// installed on. F is the function of a function pass and nullptr for a
+/// module pass. Passes nest, as pass managers are passes themselves.
+class PassObserver {
+public:
+  virtual ~PassObserver() {}
+  virtual void BeginPass(const char *pName, llvm::Module &M,
+                         llvm::Function *F) = 0;
+  virtual void EndPass(const char *pName, llvm::Module &M, llvm::Function *F,
+                       bool changed) = 0;
+};
+
+inline PassObserver *&CurrentPassObserver() {
+  static thread_local PassObserver *pCurrent = nullptr;
+  return pCurrent;
+}
+
+/// Installs an observer for the current thread for the lifetime of the scope.
+class PassObserverScope {
+public:
+  explicit PassObserverScope(PassObserver *pObserver)
+      : m_pPrevious(CurrentPassObserver()) {
+    CurrentPassObserver() = pObserver;
+  }
+  ~PassObserverScope() { CurrentPassObserver() = m_pPrevious; }
+  PassObserverScope(const PassObserverScope &) = delete;
+  PassObserverScope &operator=(const PassObserverScope &) = delete;
+
+private:
+  PassObserver *m_pPrevious;
+};
+
+/// Records, per pass name, how often the pass ran and changed the IR, how
+/// it changed the function, block and instruction counts of the module,
+/// and how it moved the llvm::Statistic counters. A function pass recounts
+/// its function and a module pass the module, so that the cost stays linear
+/// in the size of the module for each pass.
+///
+/// Statistic counters are process-wide, so the work of compilations running
+/// concurrently on other threads shows in them; they only count in builds
+/// with assertions or LLVM_ENABLE_STATS.
+class PassStatisticsRecorder : public PassObserver {
+public:
+  PassStatisticsRecorder();
+
+  void BeginPass(const char *pName, llvm::Module &M,
+                 llvm::Function *F) override;
+  void EndPass(const char *pName, llvm::Module &M, llvm::Function *F,
+               bool changed) override;
+
+  /// Writes the report as a JSON object with the IR counts before the first
+  /// and after the last pass, one entry per pass in the order the passes
+  /// first ran, and the statistics that moved since construction.
+  void WriteJson(llvm::raw_ostream &OS) const;
+
+private:
+  struct IRCounts {
+    int64_t Functions = 0;
+    int64_t Blocks = 0;
+    int64_t Instructions = 0;
+  };
+  typedef std::vector<std::pair<const llvm::Statistic *, int64_t>> StatDeltas;
+  struct OpenPass {
+    const char *Name;
+    IRCounts Before;
+    std::vector<unsigned> StatsBefore;
+  };
+  struct PassTotals {
+    unsigned Index = 0;
+    unsigned Runs = 0;
+    unsigned Changed = 0;
+    IRCounts Delta;
+    int64_t PeakInstructions = 0;
+    StatDeltas Stats;
+  };
+
+  static IRCounts Count(llvm::Module &M);
+  static IRCounts Count(llvm::Function &F);
+
+  const llvm::Module *m_pModule;
+  IRCounts m_current;
+  IRCounts m_initial;
+  std::vector<OpenPass> m_open;
+  llvm::StringMap<PassTotals> m_totals;
+  std::vector<unsigned> m_statsAtStart;
+  std::vector<const llvm::Statistic *> m_stats;
+};
+
+} // namespace hlsl
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// Cancellation.h                                                            //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides cooperative cancellation for the compilation on this thread.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/Support/exception.h"
+#include <chrono>
+
+namespace hlsl {
+
+/// Cancellation request for the compilation running on the current thread.
+/// Long-running loops call ThrowIfCancellationRequested, which unwinds to the
+/// API entry point with DXC_E_COMPILATION_CANCELLED.
+struct CancellationState {
+  typedef std::chrono::steady_clock Clock;
+
+  bool (*IsCancelled)(void *pContext); // Optional callback polled for requests.
+  void *pContext;
+  bool HasDeadline;
+  Clock::time_point Deadline;
+
+  CancellationState()
+      : IsCancelled(nullptr), pContext(nullptr), HasDeadline(false) {}
+};
+
+inline CancellationState *&CurrentCancellationState() {
+  static thread_local CancellationState *pCurrent = nullptr;
+  return pCurrent;
+}
+
+/// Makes a state current for the lifetime of the scope on this thread.
+class CancellationScope {
+public:
+  explicit CancellationScope(CancellationState &state)
+      : m_pPrevious(CurrentCancellationState()) {
+    CurrentCancellationState() = &state;
+  }
+  ~CancellationScope() { CurrentCancellationState() = m_pPrevious; }
+  CancellationScope(const CancellationScope &) = delete;
+  CancellationScope &operator=(const CancellationScope &) = delete;
+
+private:
+  CancellationState *m_pPrevious;
+};
+
+inline bool IsCancellationRequested() {
+  CancellationState *pState = CurrentCancellationState();
+  if (pState == nullptr)
+    return false;
+  if (pState->HasDeadline &&
+      CancellationState::Clock::now() >= pState->Deadline)
+    return true;
+  return pState->IsCancelled != nullptr && pState->IsCancelled(pState->pContext);
+}
+
+inline void ThrowIfCancellationRequested() {
+  if (IsCancellationRequested())
+    throw hlsl::Exception(DXC_E_COMPILATION_CANCELLED, "compilation cancelled");
+}
+
+} // namespace hlsl
@@ -14,6 +14,8 @@
 
 #include "dxc/Support/Unicode.h"
 #include "dxc/Support/FileIOHelper.h"
+#include "llvm/ADT/StringMap.h"
+#include <mutex>
 #include <vector>
 
 namespace llvm {
@@ -27,6 +29,17 @@ class CompilerInstance;
 
 namespace hlsl {
 
+// A parsed semantic define is a semantic define that has actually been
+// parsed by the compiler. It has a name (required), a value (could be
+// the empty string), and a location. We use an encoded clang::SourceLocation
+// for the location to avoid a clang include dependency.
+struct ParsedSemanticDefine{
+  std::string Name;
+  std::string Value;
+  unsigned Location;
+};
+typedef std::vector<ParsedSemanticDefine> ParsedSemanticDefineList;
+
 class DxcLangExtensionsHelper : public DxcLangExtensionsHelperApply {
 private:
   llvm::SmallVector<std::string, 2> m_semanticDefines;
@@ -34,6 +47,8 @@ private:
   llvm::SmallVector<std::string, 2> m_defines;
   llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> m_intrinsicTables;
   CComPtr<IDxcSemanticDefineValidator> m_semanticDefineValidator;
+  // Null unless the validator takes every define of a compilation at once.
+  CComPtr<IDxcSemanticDefineValidator2> m_semanticDefineValidator2;
   std::string m_semanticDefineMetaDataName;
 
   HRESULT STDMETHODCALLTYPE RegisterIntoVector(LPCWSTR name, llvm::SmallVector<std::string, 2>& here)
@@ -99,6 +114,18 @@ public:
       return E_POINTER;
 
     m_semanticDefineValidator = pValidator;
+    m_semanticDefineValidator2.Release();
+    pValidator->QueryInterface(&m_semanticDefineValidator2);
+    std::lock_guard<std::mutex> lock(m_validationCacheMutex);
+    m_validationCache.clear();
+    return S_OK;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetSemanticDefineValidationCaching(BOOL enabled) {
+    std::lock_guard<std::mutex> lock(m_validationCacheMutex);
+    m_validationCaching = enabled != FALSE;
+    if (!m_validationCaching)
+      m_validationCache.clear();
     return S_OK;
   }
 
@@ -148,21 +175,21 @@ public:
     }
   };
 
-  // Use the contained semantice define validator to validate the given semantic define.
-  SemanticDefineValidationResult ValidateSemanticDefine(const std::string &name, const std::string &value) {
-    if (!m_semanticDefineValidator)
-      return SemanticDefineValidationResult::Success();
-
-    // Blobs for getting restul from validator. Strings for returning results to caller.
-    CComPtr<IDxcBlobEncoding> pError;
-    CComPtr<IDxcBlobEncoding> pWarning;
+private:
+  // Guards the validation cache; compilations of any thread validate
+  // against it.
+  std::mutex m_validationCacheMutex;
+  bool m_validationCaching = false;
+  llvm::StringMap<SemanticDefineValidationResult> m_validationCache;
+
+  // Converts what the validator produced for one define into a result.
+  static SemanticDefineValidationResult GetValidationResult(
+      HRESULT result, const std::string &name, const std::string &value,
+      IDxcBlobEncoding *pWarning, IDxcBlobEncoding *pError) {
+    // Strings for returning results to caller.
     std::string error;
     std::string warning;
 
-    // Run semantic define validator.
-    HRESULT result = m_semanticDefineValidator->GetSemanticDefineWarningsAndErrors(name.c_str(), value.c_str(), &pWarning, &pError);
-
-
     if (FAILED(result)) {
       // Failure indicates it was not able to even run validation so
       // we cannot say whether the define is invalid or not. Return a
@@ -173,7 +200,7 @@ public:
     }
 
     // Define a  little function to convert encoded blob into a string.
-    auto GetErrorAsString = [&name](const CComPtr<IDxcBlobEncoding> &pBlobString) -> std::string {
+    auto GetErrorAsString = [&name](IDxcBlobEncoding *pBlobString) -> std::string {
       CComPtr<IDxcBlobEncoding> pUTF8BlobStr;
       if (SUCCEEDED(hlsl::DxcGetBlobAsUtf8(pBlobString, &pUTF8BlobStr)))
         return std::string(static_cast<char*>(pUTF8BlobStr->GetBufferPointer()), pUTF8BlobStr->GetBufferSize());
@@ -192,6 +219,91 @@ public:
     return SemanticDefineValidationResult{ warning, error };
   }
 
+public:
+
+  // Use the contained semantice define validator to validate the given semantic define.
+  SemanticDefineValidationResult ValidateSemanticDefine(const std::string &name, const std::string &value) {
+    if (!m_semanticDefineValidator)
+      return SemanticDefineValidationResult::Success();
+
+    // Blobs for getting restul from validator.
+    CComPtr<IDxcBlobEncoding> pError;
+    CComPtr<IDxcBlobEncoding> pWarning;
+
+    // Run semantic define validator.
+    HRESULT result = m_semanticDefineValidator->GetSemanticDefineWarningsAndErrors(name.c_str(), value.c_str(), &pWarning, &pError);
+    return GetValidationResult(result, name, value, pWarning, pError);
+  }
+
+  // Validates every semantic define of a compilation, returning one result
+  // per define in order. With caching enabled, only the (name, value) pairs
+  // no earlier compilation validated reach the validator, and a validator
+  // implementing IDxcSemanticDefineValidator2 gets them in a single call.
+  std::vector<SemanticDefineValidationResult> ValidateSemanticDefines(const ParsedSemanticDefineList &defines) {
+    std::vector<SemanticDefineValidationResult> results(defines.size());
+    if (!m_semanticDefineValidator)
+      return results;
+
+    // Keys are name and value with their terminators, so pairs can't alias.
+    std::vector<std::string> keys;
+    std::vector<size_t> pending;
+    bool caching;
+    {
+      std::lock_guard<std::mutex> lock(m_validationCacheMutex);
+      caching = m_validationCaching;
+      for (size_t i = 0; i < defines.size(); ++i) {
+        if (caching) {
+          std::string key = defines[i].Name;
+          key.push_back('\0');
+          key += defines[i].Value;
+          auto it = m_validationCache.find(key);
+          if (it != m_validationCache.end()) {
+            results[i] = it->second;
+            continue;
+          }
+          keys.push_back(std::move(key));
+        }
+        pending.push_back(i);
+      }
+    }
+    if (pending.empty())
+      return results;
+
+    if (m_semanticDefineValidator2) {
+      std::vector<LPCSTR> names, values;
+      for (size_t i : pending) {
+        names.push_back(defines[i].Name.c_str());
+        values.push_back(defines[i].Value.c_str());
+      }
+      std::vector<IDxcBlobEncoding *> warnings(pending.size(), nullptr);
+      std::vector<IDxcBlobEncoding *> errors(pending.size(), nullptr);
+      HRESULT result = m_semanticDefineValidator2->GetSemanticDefinesWarningsAndErrors(
+          (UINT32)pending.size(), names.data(), values.data(), warnings.data(),
+          errors.data());
+      for (size_t p = 0; p < pending.size(); ++p) {
+        CComPtr<IDxcBlobEncoding> pWarning, pError;
+        pWarning.Attach(warnings[p]);
+        pError.Attach(errors[p]);
+        const ParsedSemanticDefine &define = defines[pending[p]];
+        results[pending[p]] = GetValidationResult(result, define.Name, define.Value, pWarning, pError);
+      }
+    }
+    else {
+      for (size_t i : pending)
+        results[i] = ValidateSemanticDefine(defines[i].Name, defines[i].Value);
+    }
+
+    if (caching) {
+      std::lock_guard<std::mutex> lock(m_validationCacheMutex);
+      // Caching may have been turned off, and the cache cleared, meanwhile.
+      if (m_validationCaching) {
+        for (size_t p = 0; p < pending.size(); ++p)
+          m_validationCache[keys[p]] = results[pending[p]];
+      }
+    }
+    return results;
+  }
+
   __override void SetupSema(clang::Sema &S) {
     clang::ExternalASTSource *astSource = S.getASTContext().getExternalSource();
     if (clang::ExternalSemaSource *externalSema =
@@ -239,17 +351,6 @@ public:
     return (_helper_field_).SetSemanticDefineMetaDataName(name); \
   } \
 
-// A parsed semantic define is a semantic define that has actually been
-// parsed by the compiler. It has a name (required), a value (could be
-// the empty string), and a location. We use an encoded clang::SourceLocation
-// for the location to avoid a clang include dependency.
-struct ParsedSemanticDefine{
-  std::string Name;
-  std::string Value;
-  unsigned Location;
-};
-typedef std::vector<ParsedSemanticDefine> ParsedSemanticDefineList;
-
 // Return the collection of semantic defines parsed by the compiler instance.
 ParsedSemanticDefineList
   CollectSemanticDefinesParsedByCompiler(clang::CompilerInstance &compiler,
@@ -101,3 +101,6 @@
 
 // 0X80AA0018 - General internal error.
 #define DXC_E_GENERAL_INTERNAL_ERROR                  DXC_MAKE_HRESULT(DXC_SEVERITY_ERROR,FACILITY_DXC,(0x0018))
+
+// 0X80AA0019 - Compilation was cancelled or its deadline expired.
+#define DXC_E_COMPILATION_CANCELLED                   DXC_MAKE_HRESULT(DXC_SEVERITY_ERROR,FACILITY_DXC,(0x0019))
@@ -30,9 +30,15 @@ void WriteBinaryFile(_In_z_ LPCWSTR pFileName,
 UINT32 DxcCodePageFromBytes(_In_count_(byteLen) const char *bytes,
                             size_t byteLen) throw();
 
+// Large files are mapped read-only rather than read into the heap; the file
+// cannot be written while the blob or a blob created from it is alive.
 HRESULT DxcCreateBlobFromFile(LPCWSTR pFileName, _In_opt_ UINT32 *pCodePage,
                               _COM_Outptr_ IDxcBlobEncoding **pBlobEncoding) throw();
 
+// Like DxcCreateBlobFromFile, but maps any non-empty file.
+HRESULT DxcCreateBlobFromFileMapped(LPCWSTR pFileName, _In_opt_ UINT32 *pCodePage,
+                                    _COM_Outptr_ IDxcBlobEncoding **pBlobEncoding) throw();
+
 // Given a blob, creates a subrange view.
 HRESULT DxcCreateBlobFromBlob(_In_ IDxcBlob *pBlob, UINT32 offset,
                               UINT32 length,
@@ -98,6 +104,13 @@ public:
   virtual HRESULT Reserve(ULONG targetSize) throw() = 0;
 };
 HRESULT CreateMemoryStream(_In_ IMalloc *pMalloc, _COM_Outptr_ AbstractMemoryStream** ppResult) throw();
+// Creates a memory stream that never moves what has been written, for
+// intermediate outputs that are copied rather than used in place. GetPtr
+// still works, but copies the data together on first use.
+HRESULT CreateChunkedMemoryStream(_In_ IMalloc *pMalloc, _COM_Outptr_ AbstractMemoryStream** ppResult) throw();
+// Writes the contents of pSource to pTarget at its position, without
+// requiring them to be contiguous. The position of pSource is unchanged.
+HRESULT CopyMemoryStream(_In_ AbstractMemoryStream *pSource, _In_ IStream *pTarget) throw();
 HRESULT CreateReadOnlyBlobStream(_In_ IDxcBlob *pSource, _COM_Outptr_ IStream** ppResult) throw();
 
 template <typename T>
@@ -90,6 +90,10 @@ public:
 
   llvm::StringRef AssemblyCode; // OPT_Fc
   llvm::StringRef DebugFile;    // OPT_Fd
+  llvm::StringRef DependencyFile; // OPT_MF
+  llvm::StringRef BatchFile; // OPT_batch
+  llvm::StringRef BatchSummaryFile; // OPT_batch_summary
+  llvm::StringRef DependencyTarget; // OPT_MT
   llvm::StringRef EntryPoint;   // OPT_entrypoint
   llvm::StringRef ExternalFn;   // OPT_external_fn
   llvm::StringRef ExternalLib;  // OPT_external_lib
@@ -99,7 +103,10 @@ public:
   llvm::StringRef OutputHeader; // OPT_Fh
   llvm::StringRef OutputObject; // OPT_Fo
   llvm::StringRef OutputWarningsFile; // OPT_Fe
+  llvm::StringRef PackageFile; // OPT_Fpackage
   llvm::StringRef Preprocess; // OPT_P
+  llvm::StringRef ProfileUseFile; // OPT_profile_use
+  llvm::StringRef StatisticsFile; // OPT_Fstats
   llvm::StringRef TargetProfile; // OPT_target_profile
   llvm::StringRef VariableName; // OPT_Vn
   llvm::StringRef PrivateSource; // OPT_setprivate
@@ -110,21 +117,47 @@ public:
   bool AllResourcesBound; // OPT_all_resources_bound
   bool AstDump; // OPT_ast_dump
   bool GenSPIRV; // OPT_spirv // SPIRV change
+  bool SPIRVCompact; // OPT_spirv_compact // SPIRV change
+  bool SPIRVStats; // OPT_spirv_stats // SPIRV change
   bool ColorCodeAssembly; // OPT_Cc
   bool CodeGenHighLevel; // OPT_fcgl
-  bool DebugInfo; // OPT__SLASH_Zi
+  bool DebugInfo; // OPT__SLASH_Zi or OPT_gline_tables_only
+  bool DebugInfoLineTablesOnly = false; // OPT_gline_tables_only
   bool DebugNameForBinary; // OPT_Zsb
   bool DebugNameForSource; // OPT_Zss
+  bool DebugNameFastHash; // OPT_Zsx
+  bool DependenciesOnly; // OPT_M, OPT_MJ or OPT_MF without OPT_MD
+  bool DependenciesWithOutput; // OPT_MD
+  bool DependenciesJson; // OPT_MJ
   bool DumpBin;        // OPT_dumpbin
+  bool FromPackage = false; // OPT_from_package
+  bool Server = false; // OPT_server
+  bool VerifyDeterminism = false; // OPT_verify_determinism
   bool WarningAsError; // OPT__SLASH_WX
   bool IEEEStrict;     // OPT_Gis
   bool DefaultColMajor;  // OPT_Zpc
   bool DefaultRowMajor;  // OPT_Zpr
   bool DisableValidation; // OPT_VD
   unsigned OptLevel;      // OPT_O0/O1/O2/O3
+  unsigned BatchThreads = 0; // OPT_batch_threads
+  unsigned ServerMemoryLimit = 0; // OPT_server_memory_limit, in megabytes
+  bool OptFast = false;   // OPT_O1fast
   bool DisableOptimizations; // OPT_Od
   bool AvoidFlowControl;     // OPT_Gfa
   bool PreferFlowControl;    // OPT_Gfp
+  bool PairHalfOps = false;  // OPT_pair_half_ops
+  bool HoistSamples = false; // OPT_hoist_samples
+  bool LazyFunctionBodies = false; // OPT_lazy_function_bodies
+  bool DynamicIndexToSelect = false; // OPT_dynamic_index_to_select
+  unsigned ConstTableSelect = 0; // OPT_const_table_select
+  bool ReportConstTables = false; // OPT_report_const_tables
+  bool ReportNonUniformIndices = false; // OPT_report_non_uniform_indices
+  unsigned FunctionBudget = 0; // OPT_function_budget
+  bool ProfileInstrument = false; // OPT_profile_instrument
+  bool ProfileRegions = false; // OPT_profile_regions
+  unsigned RenderTargetMask = 0xFF; // OPT_rt_mask
+  bool NoDepthWrite = false; // OPT_no_depth_write
+  bool PackCBuffers = false; // OPT_pack_cbuffers
   bool EnableStrictMode;     // OPT_Ges
   bool HLSL2015;  // OPT_hlsl_version (=2015)
   bool HLSL2016;  // OPT_hlsl_version (=2016)
@@ -142,6 +175,9 @@ public:
   bool DisplayIncludeProcess; // OPT__vi
   bool RecompileFromBinary; // OPT _Recompile (Recompiling the DXBC binary file not .hlsl file)
   bool StripDebug; // OPT Qstrip_debug
+  bool CompressDebug; // OPT_Qcompress_debug
+  bool PSVIndexes; // OPT_Qpsv_indexes
+  bool DedupStrings; // OPT_Qdedup_strings
   bool StripRootSignature; // OPT_Qstrip_rootsignature
   bool StripPrivate; // OPT_Qstrip_priv
   bool StripReflection; // OPT_Qstrip_reflect
@@ -150,6 +186,8 @@ public:
   bool DisassembleInstNumbers; //OPT_Ni
   bool DisassembleByteOffset; //OPT_No
   bool DisaseembleHex; //OPT_Lx
+  bool TimeReport; // OPT_ftime_report
+  bool PrintStats; // OPT_print_stats
   bool IsRootSignatureProfile();
   bool IsLibraryProfile();
 };
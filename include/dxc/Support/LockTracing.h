@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// LockTracing.h                                                             //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Reports the waits for locks shared by concurrent compilations.            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/Support/PhaseTracing.h"
+
+#include <chrono>
+
+namespace hlsl {
+
+/// Names the counters of a lock: the number of acquisitions that found it
+/// held, and the microseconds waited in them. Both names are static.
+struct LockSite {
+  const char *pContendedName;
+  const char *pWaitUsName;
+};
+
+/// Holds a lock for the lifetime of the scope, like std::lock_guard. When
+/// the lock is found held, the wait is added to the counters of the site in
+/// the tracer installed on this thread; an uncontended acquisition only
+/// costs a try_lock.
+template <typename MutexT> class TracedLockGuard {
+public:
+  TracedLockGuard(MutexT &mutex, const LockSite &site) : m_mutex(mutex) {
+    if (m_mutex.try_lock())
+      return;
+    PhaseTracer *pTracer = CurrentPhaseTracer();
+    if (pTracer == nullptr) {
+      m_mutex.lock();
+      return;
+    }
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    m_mutex.lock();
+    std::chrono::microseconds waited =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+    pTracer->AddCount(site.pContendedName, 1);
+    pTracer->AddCount(site.pWaitUsName, (uint64_t)waited.count());
+  }
+  ~TracedLockGuard() { m_mutex.unlock(); }
+  TracedLockGuard(const TracedLockGuard &) = delete;
+  TracedLockGuard &operator=(const TracedLockGuard &) = delete;
+
+private:
+  MutexT &m_mutex;
+};
+
+} // namespace hlsl
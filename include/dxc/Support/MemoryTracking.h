@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// MemoryTracking.h                                                          //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides accounting of the memory an operation allocates on this thread.  //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/Support/WinIncludes.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace hlsl {
+
+/// Counts the bytes allocated and freed by one operation on the thread it is
+/// installed on, through global operator new and the operation's IMalloc.
+/// Once the limit is exceeded, further allocations fail and the tracker
+/// stays in the exceeded state. A limit of zero counts without limiting.
+class MemoryTracker {
+public:
+  explicit MemoryTracker(uint64_t limitBytes)
+      : m_pParent(nullptr), m_limitBytes(limitBytes), m_currentBytes(0),
+        m_peakBytes(0), m_totalBytes(0), m_limitExceeded(false) {}
+  MemoryTracker(const MemoryTracker &) = delete;
+  MemoryTracker &operator=(const MemoryTracker &) = delete;
+
+  /// Counts an allocation of size bytes against this tracker and the ones it
+  /// is nested in. Returns false, counting nothing, if that would exceed the
+  /// limit of any of them.
+  bool Allocate(size_t size);
+  /// Counts the release of size bytes. Blocks allocated before the
+  /// operation started are released as well, so the count stops at zero.
+  void Free(size_t size);
+
+  uint64_t GetLimitBytes() const { return m_limitBytes; }
+  uint64_t GetPeakBytes() const { return m_peakBytes; }
+  uint64_t GetTotalBytes() const { return m_totalBytes; }
+  bool IsLimitExceeded() const { return m_limitExceeded; }
+
+private:
+  friend class MemoryTrackerScope;
+  bool WouldExceed(size_t size) const;
+
+  MemoryTracker *m_pParent;
+  uint64_t m_limitBytes;
+  uint64_t m_currentBytes;
+  uint64_t m_peakBytes;
+  uint64_t m_totalBytes;
+  bool m_limitExceeded;
+};
+
+inline MemoryTracker *&CurrentMemoryTracker() {
+  static thread_local MemoryTracker *pCurrent = nullptr;
+  return pCurrent;
+}
+
+/// Installs a tracker for the current thread for the lifetime of the scope.
+/// A null tracker leaves the current one, if any, in place, so an operation
+/// without accounting run from one with it is still counted. A tracker
+/// installed over another also counts against the outer one.
+class MemoryTrackerScope {
+public:
+  explicit MemoryTrackerScope(MemoryTracker *pTracker)
+      : m_pPrevious(CurrentMemoryTracker()), m_installed(pTracker != nullptr) {
+    if (m_installed) {
+      pTracker->m_pParent = m_pPrevious;
+      CurrentMemoryTracker() = pTracker;
+    }
+  }
+  ~MemoryTrackerScope() {
+    if (m_installed)
+      CurrentMemoryTracker() = m_pPrevious;
+  }
+  MemoryTrackerScope(const MemoryTrackerScope &) = delete;
+  MemoryTrackerScope &operator=(const MemoryTrackerScope &) = delete;
+
+private:
+  MemoryTracker *m_pPrevious;
+  bool m_installed;
+};
+
+/// Returns the allocator of the current operation: the COM task allocator,
+/// counted against the tracker installed on this thread while one is.
+/// Blocks from it may be freed through CoGetMalloc and the other way around.
+HRESULT DxcGetOperationMalloc(IMalloc **ppMalloc);
+
+} // namespace hlsl
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// PhaseTracing.h                                                            //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides hooks to observe the phases of the compilation on this thread.   //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+namespace hlsl {
+
+/// Receives the begin and end of each compilation phase (parsing, codegen,
+/// each optimization pass, container serialization, validation) on the
+/// thread it is installed on. Phases nest; pName outlives the phase.
+class PhaseTracer {
+public:
+  virtual ~PhaseTracer() {}
+  virtual void BeginPhase(const char *pName) = 0;
+  virtual void EndPhase(const char *pName) = 0;
+  /// Adds value to the counter pName, such as the number of declarations a
+  /// phase created. pName outlives the tracer.
+  virtual void AddCount(const char *pName, uint64_t value) {}
+};
+
+inline PhaseTracer *&CurrentPhaseTracer() {
+  static thread_local PhaseTracer *pCurrent = nullptr;
+  return pCurrent;
+}
+
+/// Adds to a counter of the tracer installed on this thread, if any.
+inline void AddPhaseCount(const char *pName, uint64_t value) {
+  if (PhaseTracer *pTracer = CurrentPhaseTracer())
+    pTracer->AddCount(pName, value);
+}
+
+/// Installs a tracer for the current thread for the lifetime of the scope.
+class PhaseTracerScope {
+public:
+  explicit PhaseTracerScope(PhaseTracer *pTracer)
+      : m_pPrevious(CurrentPhaseTracer()) {
+    CurrentPhaseTracer() = pTracer;
+  }
+  ~PhaseTracerScope() { CurrentPhaseTracer() = m_pPrevious; }
+  PhaseTracerScope(const PhaseTracerScope &) = delete;
+  PhaseTracerScope &operator=(const PhaseTracerScope &) = delete;
+
+private:
+  PhaseTracer *m_pPrevious;
+};
+
+/// Reports a phase spanning the lifetime of the object, if a tracer is
+/// installed. The end is reported on unwinding as well.
+class PhaseSpan {
+public:
+  explicit PhaseSpan(const char *pName)
+      : m_pTracer(CurrentPhaseTracer()), m_pName(pName) {
+    if (m_pTracer != nullptr)
+      m_pTracer->BeginPhase(m_pName);
+  }
+  ~PhaseSpan() {
+    if (m_pTracer != nullptr)
+      m_pTracer->EndPhase(m_pName);
+  }
+  PhaseSpan(const PhaseSpan &) = delete;
+  PhaseSpan &operator=(const PhaseSpan &) = delete;
+
+private:
+  PhaseTracer *m_pTracer;
+  const char *m_pName;
+};
+
+} // namespace hlsl
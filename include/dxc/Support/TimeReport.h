@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TimeReport.h                                                              //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the phase timing recorder used by -ftime-report.                 //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/Support/PhaseTracing.h"
+#include "llvm/ADT/StringMap.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace hlsl {
+
+/// Accumulates wall-clock and thread CPU time per phase name while
+/// installed, forwarding every phase to the previously installed tracer.
+/// Times are inclusive of nested phases; passes that run once per function
+/// are aggregated under their name.
+class TimeReportTracer : public PhaseTracer {
+public:
+  explicit TimeReportTracer(PhaseTracer *pNext);
+
+  void BeginPhase(const char *pName) override;
+  void EndPhase(const char *pName) override;
+  void AddCount(const char *pName, uint64_t value) override;
+
+  /// Writes the report as a JSON object with the total wall time, the peak
+  /// working set of the process, one entry per phase in the order the
+  /// phases first started and one entry per counter in the order the
+  /// counters were first added to.
+  void WriteJson(llvm::raw_ostream &OS) const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  struct OpenPhase {
+    const char *Name;
+    Clock::time_point WallStart;
+    uint64_t CpuStart100ns;
+  };
+  struct PhaseTotals {
+    unsigned Index;
+    unsigned Count;
+    double WallMs;
+    double CpuMs;
+  };
+
+  PhaseTracer *m_pNext;
+  Clock::time_point m_start;
+  std::vector<OpenPhase> m_open;
+  llvm::StringMap<PhaseTotals> m_totals;
+  std::vector<std::pair<const char *, uint64_t>> m_counts;
+};
+
+} // namespace hlsl
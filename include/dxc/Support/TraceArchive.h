@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TraceArchive.h                                                            //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the formats of recorded and of packaged compile calls.           //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/Support/WinIncludes.h"
+#include <string>
+#include <vector>
+
+namespace hlsl {
+
+/// Names the directory compile calls are recorded into. Each call is one
+/// file in it, so that the processes of a build can record side by side.
+static const wchar_t TraceRecordEnvVar[] = L"DXC_TRACE_RECORD";
+/// Extension of the files of recorded calls.
+static const wchar_t TraceFileExtension[] = L".dxctrace";
+/// Extension of compile package files.
+static const wchar_t PackageFileExtension[] = L".dxcpkg";
+
+/// A compile call, with everything needed to run it again.
+struct TraceCall {
+  struct Define {
+    std::wstring Name;
+    std::wstring Value;
+    bool HasValue;
+  };
+  struct Include {
+    std::wstring Name;
+    std::string Contents;   // UTF-8, as the compiler read it.
+  };
+
+  UINT64 StartTime = 0;     // FILETIME of the start of the call.
+  UINT64 DurationUs = 0;    // Wall time of the call.
+  HRESULT Status = S_OK;    // Status of the result, or the call's failure.
+  bool HasSourceName = false;
+  std::wstring SourceName;
+  std::wstring EntryPoint;
+  std::wstring TargetProfile;
+  std::vector<std::wstring> Arguments;
+  std::vector<Define> Defines;
+  std::string Source;       // UTF-8, as the compiler read it.
+  std::vector<Include> Includes; // Files the include handler served.
+};
+
+/// Appends the call to out in the trace file format.
+void SerializeTraceCall(const TraceCall &call, std::string &out);
+/// Reads a call written by SerializeTraceCall. Returns false if the data is
+/// not a complete call of a known version.
+bool DeserializeTraceCall(const void *pData, size_t size, TraceCall &call);
+
+/// Appends the call to out as a compile package, which leaves out the start
+/// time, duration and status and stores included files with the same
+/// contents once.
+void SerializeCompilePackage(const TraceCall &call, std::string &out);
+/// Reads a package written by SerializeCompilePackage. Returns false if the
+/// data is not a complete package of a known version.
+bool DeserializeCompilePackage(const void *pData, size_t size,
+                               TraceCall &call);
+
+} // namespace hlsl
@@ -32,14 +32,39 @@ public:
   }
 };
 
-class DxcOperationResult : public IDxcOperationResult {
+// Writes through to a caller-provided stream.
+class raw_istream_ostream : public llvm::raw_ostream {
+private:
+  CComPtr<IStream> m_pStream;
+  uint64_t m_pos;
+  void write_impl(const char *Ptr, size_t Size) override {
+    ULONG cbWritten;
+    IFT(m_pStream->Write(Ptr, (ULONG)Size, &cbWritten));
+    m_pos += Size;
+  }
+  uint64_t current_pos() const override { return m_pos; }
+public:
+  raw_istream_ostream(IStream *pStream) : m_pStream(pStream), m_pos(0) { }
+  ~raw_istream_ostream() override {
+    flush();
+  }
+};
+
+class DxcOperationResult : public IDxcOperationResult, public IDxcTimeReportResult,
+                           public IDxcPassStatisticsResult,
+                           public IDxcMemoryUsageResult,
+                           public IDxcRootSignatureHashResult,
+                           public IDxcDependenciesResult {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
 
   DxcOperationResult(_In_opt_ IDxcBlob *pResultBlob,
     _In_opt_ IDxcBlobEncoding *pErrorBlob, HRESULT status)
     : m_dwRef(0), m_status(status), m_result(pResultBlob),
-    m_errors(pErrorBlob) {}
+    m_errors(pErrorBlob), m_memoryCounted(false), m_peakBytes(0),
+    m_totalBytes(0), m_hasRootSignatureHash(false) {
+    memset(m_rootSignatureHash, 0, sizeof(m_rootSignatureHash));
+  }
 
 public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
@@ -47,9 +72,21 @@ public:
   HRESULT m_status;
   CComPtr<IDxcBlob> m_result;
   CComPtr<IDxcBlobEncoding> m_errors;
+  CComPtr<IDxcBlobEncoding> m_timeReport;
+  CComPtr<IDxcBlobEncoding> m_passStatistics;
+  CComPtr<IDxcBlobEncoding> m_dependencies;
+  bool m_memoryCounted;
+  UINT64 m_peakBytes;
+  UINT64 m_totalBytes;
+  bool m_hasRootSignatureHash;
+  BYTE m_rootSignatureHash[16];
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcOperationResult>(this, iid, ppvObject);
+    return DoBasicQueryInterface<IDxcOperationResult, IDxcTimeReportResult,
+                                 IDxcPassStatisticsResult,
+                                 IDxcMemoryUsageResult,
+                                 IDxcRootSignatureHashResult,
+                                 IDxcDependenciesResult>(this, iid, ppvObject);
   }
 
   static HRESULT CreateFromResultErrorStatus(_In_opt_ IDxcBlob *pResultBlob,
@@ -110,6 +147,38 @@ public:
     GetErrorBuffer(_COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppErrors) {
     return m_errors.CopyTo(ppErrors);
   }
+
+  __override HRESULT STDMETHODCALLTYPE
+    GetTimeReport(_COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppReport) {
+    return m_timeReport.CopyTo(ppReport);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+    GetPassStatistics(_COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppStatistics) {
+    return m_passStatistics.CopyTo(ppStatistics);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+    GetDependencies(_COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppDependencies) {
+    return m_dependencies.CopyTo(ppDependencies);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+    GetMemoryUsage(_Out_ UINT64 *pPeakBytes, _Out_ UINT64 *pTotalBytes) {
+    if (pPeakBytes == nullptr || pTotalBytes == nullptr)
+      return E_INVALIDARG;
+    *pPeakBytes = m_peakBytes;
+    *pTotalBytes = m_totalBytes;
+    return m_memoryCounted ? S_OK : S_FALSE;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+    GetRootSignatureHash(_Out_writes_bytes_(16) BYTE *pDigest) {
+    if (pDigest == nullptr)
+      return E_INVALIDARG;
+    memcpy(pDigest, m_rootSignatureHash, sizeof(m_rootSignatureHash));
+    return m_hasRootSignatureHash ? S_OK : S_FALSE;
+  }
 };
 
 #endif
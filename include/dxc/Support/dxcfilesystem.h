@@ -11,8 +11,12 @@
 
 #pragma once
 
+#include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.h"
 #include "llvm/Support/MSFileSystem.h"
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace clang {
 class CompilerInstance;
@@ -38,8 +42,16 @@ public:
   virtual void GetStdOutpuHandleStream(IStream **ppResultStream) = 0;
   virtual void WriteStdErrToStream(llvm::raw_string_ostream &s) = 0;
   virtual void EnableDisplayIncludeProcess() = 0;
+  virtual void SetIncludeCache(_In_opt_ IDxcIncludeCache *pCache) = 0;
   virtual HRESULT CreateStdStreams(_In_ IMalloc *pMalloc) = 0;
   virtual HRESULT RegisterOutputStream(LPCWSTR pName, IStream *pStream) = 0;
+  // Appends the name of the source and of every file opened through the
+  // include handler or include cache so far, in the order first opened.
+  virtual void GetOpenedFileNames(std::vector<std::wstring> &names) = 0;
+  // Appends every file opened through the include handler or include cache
+  // so far, in the order first opened, with the contents as read.
+  virtual void GetIncludedFiles(
+      std::vector<std::pair<std::wstring, CComPtr<IDxcBlob>>> &files) = 0;
 };
 
 HRESULT
@@ -144,7 +144,8 @@ IDxcCompiler : public IUnknown {
     _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
   ) = 0;
 
-  // Preprocess source text
+  // Preprocess source text. With -M or -MJ, the result lists the files the
+  // source depends on instead, as a Makefile rule or as JSON.
   virtual HRESULT STDMETHODCALLTYPE Preprocess(
     _In_ IDxcBlob *pSource,                       // Source text to preprocess
     _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
@@ -182,6 +183,472 @@ IDxcCompiler2 : public IDxcCompiler {
   ) = 0;
 };
 
+// UTF-8 counterparts of IDxcIncludeHandler and DxcDefine.
+struct __declspec(uuid("d6652636-e978-4be9-9328-659d8678836c"))
+IDxcIncludeHandlerUtf8 : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE LoadSource(
+    _In_z_ LPCSTR pFilename,                                  // Candidate filename.
+    _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource  // Resultant source object for included file, nullptr if not found.
+    ) = 0;
+};
+
+struct DxcDefineUtf8 {
+  LPCSTR Name;
+  _Maybenull_ LPCSTR Value;
+};
+
+struct __declspec(uuid("ec93e294-1e8d-4653-beda-6dd76c8c2a5a"))
+IDxcCompilerUtf8 : public IUnknown {
+  // Compile a single entry point to the target shader model, taking every
+  // string in UTF-8. The names, arguments and defines reach the front end
+  // without conversion; only the source name and entry point are converted
+  // for ETW events and include file names for the file system, and the
+  // arguments and defines when a result store or trace recording needs them.
+  virtual HRESULT STDMETHODCALLTYPE CompileUtf8(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_z_ LPCSTR pSourceName,                // Optional file name for pSource. Used in errors and include handlers.
+    _In_z_ LPCSTR pEntryPoint,                    // Entry point name
+    _In_z_ LPCSTR pTargetProfile,                 // Shader profile to compile
+    _In_count_(argCount) LPCSTR *pArguments,      // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefineUtf8 *pDefines, // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandlerUtf8 *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) = 0;
+};
+
+// Compiler arguments parsed and validated once. The object is immutable, so
+// any number of compilations, on any thread, may share it.
+struct __declspec(uuid("b7a3d5e1-4c2f-4e8a-9d61-0f5c8e2a7b94"))
+IDxcCompilerArgs : public IUnknown {
+  // Retrieves the arguments the object was parsed from. The array is owned
+  // by the object.
+  virtual HRESULT STDMETHODCALLTYPE GetArguments(
+    _Outptr_result_buffer_(*pArgCount) LPCWSTR **ppArguments,
+    _Out_ UINT32 *pArgCount) = 0;
+};
+
+struct __declspec(uuid("2e6f0c84-9a1d-4b57-8c3e-d4a9b6f10e27"))
+IDxcCompilerArgsParsing : public IUnknown {
+  // Parses and validates arguments for CompileWithArgs. If the arguments
+  // are invalid, *ppArgs is nullptr and *ppResult holds the failed status
+  // and errors Compile would have produced; otherwise *ppResult is nullptr.
+  virtual HRESULT STDMETHODCALLTYPE ParseArguments(
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _COM_Outptr_result_maybenull_ IDxcCompilerArgs **ppArgs, // Parsed arguments
+    _COM_Outptr_result_maybenull_ IDxcOperationResult **ppResult // Errors if the arguments are invalid
+  ) = 0;
+
+  // Compile a single entry point to the target shader model, like Compile
+  // with the arguments pArgs was parsed from, without parsing them again.
+  virtual HRESULT STDMETHODCALLTYPE CompileWithArgs(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // Entry point name
+    _In_ LPCWSTR pTargetProfile,                  // Shader profile to compile
+    _In_ IDxcCompilerArgs *pArgs,                 // Arguments from ParseArguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) = 0;
+};
+
+struct DxcCompileTarget {
+  LPCWSTR EntryPoint;     // Entry point name
+  LPCWSTR TargetProfile;  // Shader profile to compile
+};
+
+struct __declspec(uuid("8f4f87df-f759-4bb6-ba42-1dca6565d474"))
+IDxcCompilerBatch : public IUnknown {
+  // Compile several entry points of the same source text. ppResults receives
+  // one operation result per target, in the order of pTargets.
+  virtual HRESULT STDMETHODCALLTYPE CompileBatch(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_count_(targetCount) const DxcCompileTarget *pTargets, // Array of (entry point, profile) pairs
+    _In_ UINT32 targetCount,                      // Number of targets
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _Out_writes_(targetCount) IDxcOperationResult **ppResults // Compiler output status, buffer, and errors per target
+  ) = 0;
+};
+
+struct DxcDefineSet {
+  const DxcDefine *pDefines;  // Array of defines
+  UINT32 DefineCount;         // Number of defines
+};
+
+struct __declspec(uuid("5c1e9a83-27d4-4f0b-b6e1-93a8d2c7f450"))
+IDxcCompilerPermutations : public IUnknown {
+  // Compile one entry point of the same source text under several define
+  // sets. Each set is preprocessed first; sets whose preprocessed text and
+  // arguments are identical are compiled once, and every member of the
+  // group receives the same operation result. ppResults receives one result
+  // per set and, if given, pRepresentatives the index of the set that was
+  // compiled for it.
+  virtual HRESULT STDMETHODCALLTYPE CompilePermutations(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // Entry point name
+    _In_ LPCWSTR pTargetProfile,                  // Shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(setCount) const DxcDefineSet *pDefineSets, // Array of define sets
+    _In_ UINT32 setCount,                         // Number of define sets
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _Out_writes_(setCount) IDxcOperationResult **ppResults, // Compiler output status, buffer, and errors per set
+    _Out_writes_opt_(setCount) UINT32 *pRepresentatives // Index of the set compiled for each set
+  ) = 0;
+};
+
+// One stage of a pipeline compiled by IDxcCompilerPipeline.
+struct DxcPipelineStage {
+  IDxcBlob *pSource;      // Source text of the stage
+  LPCWSTR pSourceName;    // Optional file name for pSource. Used in errors and include handlers.
+  LPCWSTR EntryPoint;     // Entry point name
+  LPCWSTR TargetProfile;  // vs_, hs_, ds_, gs_ or ps_ profile
+};
+
+struct __declspec(uuid("73ecd546-7e03-4952-8681-b475c5fb4e65"))
+IDxcCompilerPipeline : public IUnknown {
+  // Compile the stages of one graphics pipeline, given in pipeline order,
+  // and validate each into its own container. Stages with the same source
+  // blob and name share one token cache, so their text is lexed once. The
+  // stages are compiled in parallel, and a vertex or domain shader waits for
+  // the stage after it: its outputs that stage does not read are removed,
+  // with the computations feeding them, and the rest are repacked.
+  // Stages out of pipeline order fail with E_INVALIDARG. ppResults receives
+  // one operation result per stage.
+  virtual HRESULT STDMETHODCALLTYPE CompilePipeline(
+    _In_count_(stageCount) const DxcPipelineStage *pStages, // Stages in pipeline order
+    _In_ UINT32 stageCount,                       // Number of stages
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _Out_writes_(stageCount) IDxcOperationResult **ppResults // Compiler output status, buffer, and errors per stage
+  ) = 0;
+};
+
+// Caller-provided storage for compiled containers, keyed by an opaque hash of
+// the preprocessed source, arguments, entry point, profile and versions.
+struct __declspec(uuid("3503756d-ef56-49a3-a992-9d4f25caec33"))
+IDxcCompileResultStore : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE Lookup(
+    _In_ IDxcBlob *pKey,                                   // Key computed by the compiler
+    _COM_Outptr_result_maybenull_ IDxcBlob **ppContainer   // Stored container, nullptr if not found
+  ) = 0;
+  virtual HRESULT STDMETHODCALLTYPE Store(
+    _In_ IDxcBlob *pKey,                          // Key computed by the compiler
+    _In_ IDxcBlob *pContainer                     // Container produced for the key
+  ) = 0;
+};
+
+struct __declspec(uuid("742d3a10-41b8-4b69-806d-583b28000e13"))
+IDxcCompilerResultCaching : public IUnknown {
+  // Sets the store consulted by Compile before running codegen and
+  // validation, or clears it when pStore is nullptr. Only successful
+  // compilations are stored, and results served from the store carry no
+  // warnings.
+  virtual HRESULT STDMETHODCALLTYPE SetResultStore(
+    _In_opt_ IDxcCompileResultStore *pStore) = 0;
+};
+
+// Implemented by compile results. When compiling with -ftime-report, the
+// report is a UTF-8 JSON document with per-phase and per-pass wall and CPU
+// times, the peak working set and counters such as the number of built-in
+// declarations created; otherwise *ppReport is nullptr.
+struct __declspec(uuid("6a0c9e43-d1b7-4e25-8f96-c4b3a2e17d58"))
+IDxcTimeReportResult : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE GetTimeReport(
+    _COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppReport) = 0;
+};
+
+// Implemented by compile results. When compiling with -print-stats, the
+// report is a UTF-8 JSON document with, for each pass, its runs and how it
+// changed the function, block and instruction counts, and the LLVM
+// statistics the compilation moved; otherwise *ppStatistics is nullptr.
+struct __declspec(uuid("e8b3c6d5-2f19-4a7e-b04d-9c5a71f3e26b"))
+IDxcPassStatisticsResult : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE GetPassStatistics(
+    _COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppStatistics) = 0;
+};
+
+// Implemented by compile results. When compiling with -MD, the dependencies
+// are the files the compilation read, the source first, as a Makefile rule
+// or, with -MJ, as a UTF-8 JSON document; otherwise *ppDependencies is
+// nullptr.
+struct __declspec(uuid("3f1c8b27-6e4a-4d95-a2b7-8c0e51d9f6a3"))
+IDxcDependenciesResult : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE GetDependencies(
+    _COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppDependencies) = 0;
+};
+
+// Implemented by compile results. Returns the MD5 digest of the serialized
+// root signature in the result's RTS0 part, which is the same for every
+// shader compiled with that root signature, so that archives can store one
+// copy of it. Returns S_FALSE with a zero digest if there is none.
+struct __declspec(uuid("e7af4863-2da8-4811-a658-7d6d3d06ae11"))
+IDxcRootSignatureHashResult : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE GetRootSignatureHash(
+    _Out_writes_bytes_(16) BYTE *pDigest) = 0;
+};
+
+// Implemented by the compiler, linker and validator. While enabled, each
+// operation counts the memory it allocates on the calling thread, through
+// the global allocator and its IMalloc, and reports it on the result. An
+// operation that would exceed limitBytes (0 for no limit) stops and returns
+// a result failed with E_OUTOFMEMORY rather than exhausting the process.
+struct __declspec(uuid("b2e94d17-6c3a-4f08-9d51-e7a0c48f2b63"))
+IDxcMemoryAccounting : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE SetMemoryAccounting(
+    BOOL enabled, UINT64 limitBytes) = 0;
+};
+
+// Implemented by the results of operations run with memory accounting.
+// Returns S_FALSE with both values zero when the operation was not counted.
+struct __declspec(uuid("5d1f8a62-e93b-4c74-a0d6-12b7f59ce384"))
+IDxcMemoryUsageResult : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE GetMemoryUsage(
+    _Out_ UINT64 *pPeakBytes,  // Most memory allocated at once
+    _Out_ UINT64 *pTotalBytes  // Sum of all allocations
+  ) = 0;
+};
+
+// Implemented by the compiler. While maxContexts is non-zero, the LLVM
+// contexts of successful compilations are kept, up to maxContexts idle ones,
+// and reused by later compilations, which then find the types common to all
+// shaders already created. Contexts are reset between compilations so that
+// the output is the same as with pooling disabled, the default.
+struct __declspec(uuid("a40fc1d8-b6d3-441e-88f4-780e054a20d7"))
+IDxcCompilerContextPooling : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE SetContextPooling(UINT32 maxContexts) = 0;
+};
+
+// Implemented by the compiler. While enabled, the compiler keeps, for each
+// source name, entry point, target profile, argument and define list, the
+// container of the last successful compilation and a digest of the IR of
+// the functions its entry point reaches, the globals they use and the
+// declarations outside of function bodies. A later compilation still parses
+// the source and generates high-level IR, but when the digest is unchanged
+// it returns the kept container instead of optimizing, generating DXIL and
+// validating, so that editing a helper function only recompiles the entry
+// points that call it. Such results carry the front end's warnings only.
+// Compilations with debug information are never matched. Disabling
+// discards the kept containers.
+struct __declspec(uuid("757fe5c5-faba-4a7f-94b4-2d2584ee9847"))
+IDxcCompilerIncremental : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE SetIncremental(BOOL enabled) = 0;
+  // Counts the compilations that returned a kept container and those that
+  // ran the backend while enabled.
+  virtual HRESULT STDMETHODCALLTYPE GetIncrementalCounts(
+    _Out_ UINT32 *pReused, _Out_ UINT32 *pCompiled) = 0;
+};
+
+// Operation result of an asynchronous compilation. GetStatus, GetResult and
+// GetErrorBuffer block until the compilation has finished.
+struct __declspec(uuid("9d2c46e1-5a7b-4f38-b0c6-31e4d5f7a812"))
+IDxcAsyncOperationResult : public IDxcOperationResult {
+  virtual HRESULT STDMETHODCALLTYPE IsComplete(_Out_ BOOL *pComplete) = 0;
+  // Returns S_OK once the compilation has finished, or S_FALSE if it is
+  // still running after timeoutMs milliseconds (INFINITE waits forever).
+  virtual HRESULT STDMETHODCALLTYPE Wait(_In_ UINT32 timeoutMs) = 0;
+};
+
+struct __declspec(uuid("4b8e0f37-c2a6-4d91-8e55-b7a9c03d6f24"))
+IDxcCompilerAsync : public IUnknown {
+  // Queues a compilation on the compiler's thread pool and returns
+  // immediately. Arguments are copied; pSource and pIncludeHandler are
+  // referenced until the compilation finishes, and the include handler may
+  // be called from a pool thread.
+  virtual HRESULT STDMETHODCALLTYPE CompileAsync(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // entry point name
+    _In_ LPCWSTR pTargetProfile,                  // shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcAsyncOperationResult **ppResult // Pending compiler output status, buffer, and errors
+  ) = 0;
+};
+
+// Caller-implemented cancellation flag. It is polled from the compiling
+// thread between top-level declarations and between optimization passes, so
+// it must be cheap and thread-safe.
+struct __declspec(uuid("e7a3b5c1-2d84-4f6e-9a17-58c0b2d4e6f3"))
+IDxcCancellationToken : public IUnknown {
+  virtual BOOL STDMETHODCALLTYPE IsCancellationRequested() = 0;
+};
+
+struct __declspec(uuid("1f9d7c2b-83e4-4a5d-b6c8-0e2a4f6d8b17"))
+IDxcCompilerCancellation : public IUnknown {
+  // Compiles like IDxcCompiler::Compile, but stops early and returns
+  // DXC_E_COMPILATION_CANCELLED once pToken requests it or timeoutMs
+  // milliseconds have elapsed (INFINITE for no deadline).
+  virtual HRESULT STDMETHODCALLTYPE CompileWithCancellation(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // entry point name
+    _In_ LPCWSTR pTargetProfile,                  // shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _In_opt_ IDxcCancellationToken *pToken,       // Cancellation flag (optional)
+    _In_ UINT32 timeoutMs,                        // Deadline relative to the call, or INFINITE
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) = 0;
+};
+
+// Sections of a disassembly listing, for IDxcCompilerDisassembly.
+static const UINT32 DxcDisassembleSection_FeatureInfo = 0x1;
+static const UINT32 DxcDisassembleSection_Signatures = 0x2;
+static const UINT32 DxcDisassembleSection_DebugName = 0x4;
+static const UINT32 DxcDisassembleSection_PipelineStateValidation = 0x8;
+static const UINT32 DxcDisassembleSection_BufferDefinitions = 0x10;
+static const UINT32 DxcDisassembleSection_ResourceBindings = 0x20;
+static const UINT32 DxcDisassembleSection_ViewIdState = 0x40;
+static const UINT32 DxcDisassembleSection_Module = 0x80; // Annotated LLVM IR.
+static const UINT32 DxcDisassembleSection_All = 0xff;
+
+struct __declspec(uuid("3b2c1a11-c56d-4a24-9324-d7b3d07c9141"))
+IDxcCompilerDisassembly : public IUnknown {
+  // Disassembles like IDxcCompiler::Disassemble, but writes the listing to
+  // pOutput as it is produced rather than into a blob. When functions are
+  // named, the module section lists only their definitions.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleToStream(
+    _In_ IDxcBlob *pSource,                         // Program to disassemble.
+    _In_ UINT32 sections,                           // DxcDisassembleSection_* flags.
+    _In_count_(functionCount) LPCWSTR *pFunctions,  // Functions to list (optional).
+    _In_ UINT32 functionCount,                      // Number of functions; 0 for all.
+    _In_ IStream *pOutput                           // Receives disassembly text (UTF-8).
+    ) = 0;
+};
+
+// Process-wide storage for included files, shared across compilations so
+// that headers returned by an include handler are loaded and converted to
+// UTF-8 once. Entries are keyed by the full include path; callers that know
+// a file changed on disk should invalidate it before the next compilation.
+struct __declspec(uuid("0b6aa1ef-4ee5-4c4f-9552-6f2a35d3d9c0"))
+IDxcIncludeCache : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE Lookup(
+    _In_ LPCWSTR pFileName,                               // Full include path
+    _COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppSource // Cached UTF-8 text, nullptr if not found
+  ) = 0;
+  // Stores pSource for pFileName. If an entry with identical contents is
+  // already present it is kept, so concurrent compilations share one blob.
+  virtual HRESULT STDMETHODCALLTYPE Store(
+    _In_ LPCWSTR pFileName,                       // Full include path
+    _In_ IDxcBlobEncoding *pSource                // UTF-8 text of the file
+  ) = 0;
+  // Removes the entry for pFileName, or every entry when pFileName is nullptr.
+  virtual HRESULT STDMETHODCALLTYPE Invalidate(
+    _In_opt_ LPCWSTR pFileName
+  ) = 0;
+};
+
+struct __declspec(uuid("c3e6f8a5-13bd-4b4e-8d3c-7f0f5b1b8a41"))
+IDxcCompilerIncludeCaching : public IUnknown {
+  // Sets the cache consulted before calling the include handler, or clears
+  // it when pCache is nullptr. Files not produced by an include handler are
+  // never cached.
+  virtual HRESULT STDMETHODCALLTYPE SetIncludeCache(
+    _In_opt_ IDxcIncludeCache *pCache) = 0;
+};
+
+struct __declspec(uuid("0f6a2d7e-9b41-4c85-a3e2-5d8c17b0f964"))
+IDxcCompilerTokenCaching : public IUnknown {
+  // Lexes the source and the files it includes into a token cache, returned
+  // as the result blob. The cache keeps every token, including those of
+  // inactive conditional blocks, and the structure of the conditional
+  // directives, so it serves any set of defines. Files included only under
+  // other defines are lexed as usual when they are reached.
+  virtual HRESULT STDMETHODCALLTYPE CreateTokenCache(
+    _In_ IDxcBlob *pSource,                       // Source text to lex
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Token cache, status and errors
+  ) = 0;
+
+  // Sets the token cache that Compile and Preprocess replay tokens from, or
+  // clears it when pTokenCache is nullptr. Only directives and macro
+  // expansions are evaluated again. The cache is used when the source, its
+  // name and the arguments other than defines match those it was created
+  // with. The included files must not have changed since.
+  virtual HRESULT STDMETHODCALLTYPE SetTokenCache(
+    _In_opt_ IDxcBlob *pTokenCache) = 0;
+};
+
+static const UINT32 DxcPreprocessFlags_None = 0;
+static const UINT32 DxcPreprocessFlags_NoLineMarkers = 1;       // No #line directives.
+static const UINT32 DxcPreprocessFlags_NormalizeWhitespace = 2; // No indentation or blank lines.
+static const UINT32 DxcPreprocessFlags_ValidMask = 0x3;
+
+struct __declspec(uuid("6c4e2a9f-0b71-4d38-95e6-a2f3c81d07b5"))
+IDxcCompilerStreamingPreprocess : public IUnknown {
+  // Preprocesses like IDxcCompiler::Preprocess, but writes the text to
+  // pOutput as it is produced rather than keeping it for the result, whose
+  // blob is empty. The output of -M and its variants goes to pOutput too.
+  // The flags make the text stable across edits that only move lines, for
+  // callers that hash it.
+  virtual HRESULT STDMETHODCALLTYPE PreprocessToStream(
+    _In_ IDxcBlob *pSource,                       // Source text to preprocess
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _In_ UINT32 Flags,                            // DxcPreprocessFlags_*
+    _In_ IStream *pOutput,                        // Receives the preprocessed text
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Preprocessor status and errors
+  ) = 0;
+};
+
+struct __declspec(uuid("7da67cae-eba3-406b-9041-e7349c8c6deb"))
+IDxcCompilerPackaging : public IUnknown {
+  // Preprocesses the source to find the files it includes, through
+  // pIncludeHandler and the include cache, and returns as the result blob a
+  // package with the source, those files, the defines and the arguments.
+  // Files with the same contents are stored once. Compiling the package
+  // asks for no file, so it can run on any machine.
+  virtual HRESULT STDMETHODCALLTYPE CreatePackage(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // entry point name
+    _In_ LPCWSTR pTargetProfile,                  // shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Package, status and errors
+  ) = 0;
+
+  // Compiles as IDxcCompiler::Compile with the inputs stored in pPackage,
+  // serving includes from the package. Returns E_INVALIDARG if pPackage is
+  // not a package from CreatePackage.
+  virtual HRESULT STDMETHODCALLTYPE CompileFromPackage(
+    _In_ IDxcBlob *pPackage,                      // Package from CreatePackage
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) = 0;
+};
+
 struct __declspec(uuid("F1B5BE2A-62DD-4327-A1C2-42AC1E1E78E6"))
 IDxcLinker : public IUnknown {
 public:
@@ -192,7 +659,10 @@ public:
   ) = 0;
 
   // Links the shader and produces a shader blob that the Direct3D runtime can
-  // use.
+  // use. Arguments of the form "-D name=value" set the values of
+  // [linkconstant] globals in the libraries, and -O1 to -O3 optimize the
+  // linked shader as the compiler does at that level (the default, -Od,
+  // only inlines and removes dead code). Other arguments are ignored.
   virtual HRESULT STDMETHODCALLTYPE Link(
       _In_opt_ LPCWSTR pEntryName, // Entry point name
       _In_ LPCWSTR pTargetProfile, // shader profile to link
@@ -207,11 +677,67 @@ public:
   ) = 0;
 };
 
+struct __declspec(uuid("8e2d4b71-a05c-4f3e-9b68-c17d5e2f0a94"))
+IDxcLinkerBatch : public IUnknown {
+  // Links several entry points against the same registered libraries.
+  // Targets are linked and validated concurrently; each worker thread loads
+  // its own copy of the libraries into its own context, so libraries must
+  // not be registered while a batch runs. ppResults receives one operation
+  // result per target, in the order of pTargets. A registered container
+  // events handler may be called from the worker threads. pArguments are
+  // interpreted as for IDxcLinker::Link and apply to every target.
+  virtual HRESULT STDMETHODCALLTYPE LinkBatch(
+      _In_count_(targetCount)
+          const DxcCompileTarget *pTargets, // Array of (entry point, profile) pairs
+      _In_ UINT32 targetCount,              // Number of targets
+      _In_count_(libCount)
+          const LPCWSTR *pLibNames, // Array of library names to link
+      UINT32 libCount,              // Number of libraries to link
+      _In_count_(argCount)
+          const LPCWSTR *pArguments, // Array of pointers to arguments
+      _In_ UINT32 argCount,          // Number of arguments
+      _Out_writes_(targetCount) IDxcOperationResult *
+          *ppResults // Linker output status, buffer, and errors per target
+  ) = 0;
+};
+
+struct __declspec(uuid("3c7a9e15-6b2d-4f80-a4e3-5d91c08b7f26"))
+IDxcLinkerResultCache : public IUnknown {
+  // Keeps the results of up to capacity successful links, keyed on the entry
+  // point, profile, contents of the libraries and arguments, and returns them
+  // from later identical Link and LinkBatch calls without linking again. A
+  // container events handler is not called for a cached result. A capacity
+  // of zero, the default, disables the cache and drops its results.
+  virtual HRESULT STDMETHODCALLTYPE SetResultCacheCapacity(UINT32 capacity) = 0;
+};
+
+struct __declspec(uuid("b5e83f2a-7d46-4c19-8a0b-e2f6931dc457"))
+IDxcLinkerLibraryUpdate : public IUnknown {
+  // Replaces the contents of a registered library with a new build of it,
+  // such as after one of its functions was edited. Results kept by
+  // IDxcLinkerResultCache for links that used no changed function remain
+  // valid and are returned by later identical links, so only the affected
+  // entry points are linked and validated again. A change to the globals,
+  // static initializers or resources of the library drops every result
+  // linked from it. Libraries must not be updated while a batch runs.
+  virtual HRESULT STDMETHODCALLTYPE UpdateLibrary(
+      _In_ LPCWSTR pLibName, // Name of the registered library.
+      _In_ IDxcBlob *pLib    // New contents of the library.
+  ) = 0;
+};
+
 static const UINT32 DxcValidatorFlags_Default = 0;
 static const UINT32 DxcValidatorFlags_InPlaceEdit = 1;  // Validator is allowed to update shader blob in-place.
 static const UINT32 DxcValidatorFlags_RootSignatureOnly = 2;
 static const UINT32 DxcValidatorFlags_ModuleOnly = 4;
-static const UINT32 DxcValidatorFlags_ValidMask = 0x7;
+// Checks only that the container parts (signatures, PSV, feature info, root
+// signature) are consistent with the module, skipping module validation.
+// Intended for containers produced by a trusted build of this compiler: an
+// invalid module such as one with out-of-profile operations or resource and
+// signature errors is accepted, so full validation should still run
+// periodically.
+static const UINT32 DxcValidatorFlags_StructuralOnly = 8;
+static const UINT32 DxcValidatorFlags_ValidMask = 0xf;
 
 struct __declspec(uuid("A6E82BD2-1FD7-4826-9811-2857E797F49A"))
 IDxcValidator : public IUnknown {
@@ -223,6 +749,65 @@ IDxcValidator : public IUnknown {
     ) = 0;
 };
 
+// Implemented by validators. The cache is shared by every validator in the
+// process, including those used by the compiler, linker and container
+// builder. A program whose DXIL part already passed validation with the same
+// flags skips module validation; container parts are still checked against
+// the module. Disabling the cache discards its contents.
+struct __declspec(uuid("d8b3e2f4-6a91-4c57-b0e8-3f5a7c1d9e26"))
+IDxcValidatorCaching : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE SetValidationCacheEnabled(BOOL enabled) = 0;
+};
+
+// Implemented by validators, for inputs whose diagnostics may be very large.
+// The error limit applies to every later validation on this instance, through
+// either interface; errors past the limit still fail validation.
+struct __declspec(uuid("5e0a7c39-d14b-4f82-9c6e-b83f21a4d7c5"))
+IDxcValidatorDiagnostics : public IUnknown {
+  // Limits the number of errors reported; 0, the default, reports all.
+  virtual HRESULT STDMETHODCALLTYPE SetMaxErrors(UINT32 maxErrors) = 0;
+
+  // Validates as IDxcValidator::Validate does, but writes the diagnostics to
+  // pDiagStream while validating rather than into a result's error buffer.
+  virtual HRESULT STDMETHODCALLTYPE ValidateToStream(
+    _In_ IDxcBlob *pShader,                       // Shader to validate.
+    _In_ UINT32 Flags,                            // Validation flags.
+    _In_ IStream *pDiagStream,                    // Receives diagnostic text (UTF-8).
+    _Out_ HRESULT *pStatus                        // Validation status.
+    ) = 0;
+};
+
+// Reasons reported by IDxcRootSignatureCompatibility.
+static const UINT32 DxcRootSignatureCompatibility_Compatible = 0;
+// The root signature could not be read or fails verification.
+static const UINT32 DxcRootSignatureCompatibility_InvalidRootSignature = 1;
+// The shader is not a container with DXIL and pipeline state validation parts.
+static const UINT32 DxcRootSignatureCompatibility_InvalidShader = 2;
+// A resource of the shader is not fully bound by the root signature.
+static const UINT32 DxcRootSignatureCompatibility_UnboundResource = 3;
+// A typed resource, or a UAV with a counter, is bound by a root descriptor.
+static const UINT32 DxcRootSignatureCompatibility_RootDescriptorResourceType = 4;
+// The shader has root bindings, but a DENY flag excludes its stage.
+static const UINT32 DxcRootSignatureCompatibility_DeniedShaderStage = 5;
+
+// Implemented by validators. Checks a set of shaders against a set of root
+// signatures in one call, reading each root signature and each shader's
+// pipeline state validation part once, as VerifyRootSignature does for a
+// single pair. A root signature is either serialized or a container with a
+// root signature part; any root signature part of a shader is ignored.
+struct __declspec(uuid("2d55da27-d5d7-467b-b984-8e5654f3eb48"))
+IDxcRootSignatureCompatibility : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE CheckRootSignatureCompatibility(
+    _In_ UINT32 rootSignatureCount,                        // Number of root signatures
+    _In_count_(rootSignatureCount) IDxcBlob **ppRootSignatures,
+    _In_ UINT32 shaderCount,                               // Number of shader containers
+    _In_count_(shaderCount) IDxcBlob **ppShaders,
+    // One DxcRootSignatureCompatibility_* reason per pair, in rows of
+    // shaderCount for each root signature.
+    _Out_writes_(rootSignatureCount * shaderCount) UINT32 *pReasons
+  ) = 0;
+};
+
 struct __declspec(uuid("334b1f50-2292-4b35-99a1-25588d8c17fe"))
 IDxcContainerBuilder : public IUnknown {
   virtual HRESULT STDMETHODCALLTYPE Load(_In_ IDxcBlob *pDxilContainerHeader) = 0;                // Loads DxilContainer to the builder
@@ -231,6 +816,23 @@ IDxcContainerBuilder : public IUnknown {
   virtual HRESULT STDMETHODCALLTYPE SerializeContainer(_Out_ IDxcOperationResult **ppResult) = 0; // Builds a container of the given container builder state
 };
 
+// Implemented by the container builder. Stamps one root signature onto many
+// containers, replacing any root signature part they already have. The root
+// signature is deserialized once; each container is only checked against it
+// through its pipeline state validation part. Each result holds the new
+// container, or a failed status with errors if the root signature does not
+// fit that shader. Fails with DXC_E_INCORRECT_ROOT_SIGNATURE, and produces no
+// results, if the root signature itself is invalid.
+struct __declspec(uuid("7c4f91d2-35ab-4e6c-8b0a-e2d16f5c9a38"))
+IDxcContainerBuilderBatch : public IUnknown {
+  virtual HRESULT STDMETHODCALLTYPE AddRootSignatureToContainers(
+    _In_ IDxcBlob *pRootSignature,                           // Serialized root signature
+    _In_ UINT32 containerCount,                              // Number of containers
+    _In_count_(containerCount) IDxcBlob **ppContainers,      // Containers to stamp
+    _Out_writes_(containerCount) IDxcOperationResult **ppResults // One result per container
+  ) = 0;
+};
+
 struct __declspec(uuid("091f7a26-1c1f-4948-904b-e6e3a8a771d5"))
 IDxcAssembler : public IUnknown {
   // Assemble dxil in ll or llvm bitcode to DXIL container.
@@ -250,6 +852,28 @@ IDxcContainerReflection : public IUnknown {
   virtual HRESULT STDMETHODCALLTYPE GetPartReflection(UINT32 idx, REFIID iid, void **ppvObject) = 0;
 };
 
+// Uses of a compute shader that decide how it can be dispatched.
+static const UINT32 DxcComputeShaderUsage_WaveOps = 0x1;     // Wave or quad operations.
+static const UINT32 DxcComputeShaderUsage_Derivatives = 0x2; // Derivatives, explicit or implied by sampling.
+
+// The resource use of a compute shader, for choosing between variants of a
+// kernel and their dispatch sizes at runtime.
+struct DxcComputeShaderSummary {
+  UINT32 ThreadGroupSize[3]; // numthreads
+  UINT32 GroupSharedBytes;   // Bytes of groupshared memory
+  UINT32 PeakLiveValues;     // Register pressure estimate: the most scalar values live at once
+  UINT32 Usage;              // DxcComputeShaderUsage_* flags
+};
+
+// Implemented by the shader reflection objects of IDxcContainerReflection,
+// alongside ID3D12ShaderReflection.
+struct __declspec(uuid("a45a4382-c26b-4e9a-8f04-957eb3808a6e"))
+IDxcComputeShaderReflection : public IUnknown {
+  // Fails with E_NOTIMPL if the part is not a compute shader.
+  virtual HRESULT STDMETHODCALLTYPE GetComputeShaderSummary(
+    _Out_ DxcComputeShaderSummary *pSummary) = 0;
+};
+
 struct __declspec(uuid("AE2CD79F-CC22-453F-9B6B-B124E7A5204C"))
 IDxcOptimizerPass : public IUnknown {
   virtual HRESULT STDMETHODCALLTYPE GetOptionName(_COM_Outptr_ LPWSTR *ppResult) = 0;
@@ -269,6 +893,29 @@ IDxcOptimizer : public IUnknown {
     _COM_Outptr_opt_ IDxcBlobEncoding **ppOutputText) = 0;
 };
 
+// A module parsed once by IDxcOptimizer2::ParseModule, to run many pipelines
+// over. Calls on one module must not overlap.
+struct __declspec(uuid("5a1c9e7b-0f3d-4e58-b1a4-6c2d8e93f047"))
+IDxcOptimizerModule : public IUnknown {
+  // Runs a pipeline on a copy of the module; the parsed module is unchanged.
+  // The pipeline lists passes separated by ';' or whitespace, each written
+  // as for RunOptimizer with the leading '-' optional, for example
+  // "mem2reg;instcombine;gvn,enable-pre=0". The report is a JSON object with
+  // the wall time, the instruction count after each pass and its delta.
+  virtual HRESULT STDMETHODCALLTYPE RunPipeline(
+    _In_z_ LPCWSTR pPipeline,
+    _COM_Outptr_opt_ IDxcBlob **ppOutputModule,
+    _COM_Outptr_opt_ IDxcBlobEncoding **ppReport) = 0;
+};
+
+struct __declspec(uuid("3c5f8b0e-7d21-4a96-8e43-b9f0d17a6c25"))
+IDxcOptimizer2 : public IDxcOptimizer {
+  // Parses bitcode or assembly into a module that pipelines can be run on
+  // repeatedly without parsing it again.
+  virtual HRESULT STDMETHODCALLTYPE ParseModule(
+    _In_ IDxcBlob *pBlob, _COM_Outptr_ IDxcOptimizerModule **ppModule) = 0;
+};
+
 static const UINT32 DxcVersionInfoFlags_None = 0;
 static const UINT32 DxcVersionInfoFlags_Debug = 1; // Matches VS_FF_DEBUG
 static const UINT32 DxcVersionInfoFlags_Internal = 2; // Internal Validator (non-signing)
@@ -350,4 +997,12 @@ __declspec(selectany) extern const GUID CLSID_DxcContainerBuilder = {
   0x4574,  
   { 0xb4, 0xd0, 0x87, 0x41, 0xe2, 0x52, 0x40, 0xd2 }
 };
+
+// {5f1c8a2e-9b0d-4e3a-a6f4-2d7c81e9b053}
+__declspec(selectany) extern const GUID CLSID_DxcIncludeCache = {
+  0x5f1c8a2e,
+  0x9b0d,
+  0x4e3a,
+  { 0xa6, 0xf4, 0x2d, 0x7c, 0x81, 0xe9, 0xb0, 0x53 }
+};
 #endif
@@ -140,6 +140,19 @@ public:
   virtual HRESULT STDMETHODCALLTYPE GetDxilOpCode(UINT opcode, UINT *pDxilOpcode) = 0;
 };
 
+// Tables that also implement this interface are looked up with the UTF-8
+// names the compiler already has, avoiding a conversion on every probe.
+struct __declspec(uuid("6b7b54b2-79f4-4c2a-9c8e-1f3f1d9a2e07"))
+IDxcIntrinsicTable2 : public IDxcIntrinsicTable
+{
+public:
+  // Same as LookupIntrinsic, with null-terminated UTF-8 names.
+  virtual HRESULT STDMETHODCALLTYPE LookupIntrinsicUtf8(
+    LPCSTR typeName, LPCSTR functionName,
+    const HLSL_INTRINSIC** pIntrinsic,
+    _Inout_ UINT64* pLookupCookie) = 0;
+};
+
 struct __declspec(uuid("1d063e4f-515a-4d57-a12a-431f6a44cfb9"))
 IDxcSemanticDefineValidator : public IUnknown
 {
@@ -147,6 +160,21 @@ public:
   virtual HRESULT STDMETHODCALLTYPE GetSemanticDefineWarningsAndErrors(LPCSTR pName, LPCSTR pValue, IDxcBlobEncoding **ppWarningBlob, IDxcBlobEncoding **ppErrorBlob) = 0;
 };
 
+// Validators that also implement this interface are called once per
+// compilation with every semantic define, rather than once per define.
+struct __declspec(uuid("a3e6c1d9-57b2-4f08-b4d3-8e1f92c6a0b5"))
+IDxcSemanticDefineValidator2 : public IDxcSemanticDefineValidator
+{
+public:
+  // Same as GetSemanticDefineWarningsAndErrors for each of the count
+  // defines; ppWarningBlobs and ppErrorBlobs receive count blobs each.
+  virtual HRESULT STDMETHODCALLTYPE GetSemanticDefinesWarningsAndErrors(
+    UINT32 count, _In_count_(count) const LPCSTR *pNames,
+    _In_count_(count) const LPCSTR *pValues,
+    _Out_writes_(count) IDxcBlobEncoding **ppWarningBlobs,
+    _Out_writes_(count) IDxcBlobEncoding **ppErrorBlobs) = 0;
+};
+
 struct __declspec(uuid("282a56b4-3f56-4360-98c7-9ea04a752272"))
 IDxcLangExtensions : public IUnknown
 {
@@ -170,6 +198,18 @@ public:
   virtual HRESULT STDMETHODCALLTYPE SetSemanticDefineMetaDataName(LPCSTR name) = 0;
 };
 
+struct __declspec(uuid("f0b8d4a2-6c93-4e1d-a57f-2d9e8c3b61f4"))
+IDxcLangExtensions2 : public IDxcLangExtensions
+{
+public:
+  /// <summary>Enables reuse of semantic define validation results.</summary>
+  /// When enabled, the validator runs once for each distinct name and value
+  /// over the lifetime of the object, and later compilations reuse its
+  /// warnings and errors. Setting a validator or disabling caching discards
+  /// the results.
+  virtual HRESULT STDMETHODCALLTYPE SetSemanticDefineValidationCaching(BOOL enabled) = 0;
+};
+
 struct __declspec(uuid("454b764f-3549-475b-958c-a7a6fcd05fbc"))
 IDxcSystemAccess : public IUnknown
 {
@@ -148,8 +148,8 @@ typedef enum DxcTranslationUnitFlags
   // Used to indicate that the translation unit is incomplete.
   DxcTranslationUnitFlags_Incomplete = 0x02,
 
-  // Used to indicate that the translation unit should be built with an
-  // implicit precompiled header for the preamble.
+  // Used to indicate that the translation unit should keep the tokens of its
+  // included files, and replay them on reparse while the files are unchanged.
   DxcTranslationUnitFlags_PrecompiledPreamble = 0x04,
 
   // Used to indicate that the translation unit should cache some
@@ -561,16 +561,28 @@ enum DxcCursorKindFlags
   DxcCursorKind_Unexposed = 0x100,
 };
 
+// Describes the progress of an asynchronous IntelliSense request.
+enum DxcIntelliSenseRequestStatus
+{
+  DxcIntelliSenseRequest_Pending = 0,   // Queued behind earlier requests.
+  DxcIntelliSenseRequest_Running = 1,   // Results are being added.
+  DxcIntelliSenseRequest_Completed = 2,
+  DxcIntelliSenseRequest_Cancelled = 3, // Results added before cancellation remain.
+  DxcIntelliSenseRequest_Failed = 4,
+};
+
 struct IDxcCursor;
 struct IDxcDiagnostic;
 struct IDxcFile;
 struct IDxcInclusion;
 struct IDxcIntelliSense;
+struct IDxcIntelliSenseRequest;
 struct IDxcIndex;
 struct IDxcSourceLocation;
 struct IDxcSourceRange;
 struct IDxcToken;
 struct IDxcTranslationUnit;
+struct IDxcTranslationUnitAsync;
 struct IDxcType;
 struct IDxcUnsavedFile;
 
@@ -663,6 +675,29 @@ IDxcIntelliSense : public IUnknown
   virtual HRESULT STDMETHODCALLTYPE CreateUnsavedFile(_In_ LPCSTR fileName, _In_ LPCSTR contents, unsigned contentLength, _Outptr_result_nullonfailure_ IDxcUnsavedFile** pResult) = 0;
 };
 
+// Results of a request queued through IDxcTranslationUnitAsync. Results are
+// copies, so they outlive later parses, and can be read from any thread while
+// the request runs; the counts only grow, and entries never change.
+struct __declspec(uuid("fbba526c-3495-4d68-8e0f-f1c420828a18"))
+IDxcIntelliSenseRequest : public IUnknown
+{
+  virtual HRESULT STDMETHODCALLTYPE GetStatus(_Out_ DxcIntelliSenseRequestStatus* pStatus) = 0;
+  // Returns S_OK once the request has finished, or S_FALSE if it is still
+  // pending or running after timeoutMs milliseconds (INFINITE waits forever).
+  virtual HRESULT STDMETHODCALLTYPE Wait(UINT32 timeoutMs) = 0;
+  // Drops a pending request; a running request stops at its next top-level
+  // declaration or batch of results.
+  virtual HRESULT STDMETHODCALLTYPE Cancel() = 0;
+  virtual HRESULT STDMETHODCALLTYPE GetNumCompletions(_Out_ unsigned* pValue) = 0;
+  // Gets a completion in priority order, with the text the user would type.
+  virtual HRESULT STDMETHODCALLTYPE GetCompletionAt(unsigned index,
+    _Out_ DxcCursorKind* pKind, _Outptr_result_z_ LPSTR* pTypedText) = 0;
+  virtual HRESULT STDMETHODCALLTYPE GetNumDiagnostics(_Out_ unsigned* pValue) = 0;
+  // Gets a diagnostic formatted with the default display options.
+  virtual HRESULT STDMETHODCALLTYPE GetDiagnosticAt(unsigned index,
+    _Out_ DxcDiagnosticSeverity* pSeverity, _Outptr_result_z_ LPSTR* pText) = 0;
+};
+
 struct __declspec(uuid("937824a0-7f5a-4815-9ba7-7fc0424f4173"))
 IDxcIndex : public IUnknown
 {
@@ -741,6 +776,26 @@ IDxcTranslationUnit : public IUnknown
   virtual HRESULT STDMETHODCALLTYPE GetInclusionList(_Out_ unsigned* pResultCount, _Outptr_result_buffer_(*pResultCount) IDxcInclusion*** pResult) = 0;
 };
 
+// Implemented by translation units. Requests run in order on a worker thread
+// owned by the translation unit; other IDxcTranslationUnit methods must not
+// be called until the requests queued so far have finished.
+struct __declspec(uuid("8465ec78-990b-4652-90db-d2a01c9edc40"))
+IDxcTranslationUnitAsync : public IUnknown
+{
+  // Queues a reparse whose request holds the new diagnostics. The edit
+  // supersedes every unfinished request, which is cancelled.
+  virtual HRESULT STDMETHODCALLTYPE ReparseAsync(
+    _In_count_(num_unsaved_files) IDxcUnsavedFile** unsaved_files,
+    unsigned num_unsaved_files,
+    _COM_Outptr_ IDxcIntelliSenseRequest** pRequest) = 0;
+  // Queues code completion at a location, cancelling unfinished completions.
+  virtual HRESULT STDMETHODCALLTYPE CodeCompleteAsync(
+    _In_z_ const char* fileName, unsigned line, unsigned column,
+    _In_count_(num_unsaved_files) IDxcUnsavedFile** unsaved_files,
+    unsigned num_unsaved_files,
+    _COM_Outptr_ IDxcIntelliSenseRequest** pRequest) = 0;
+};
+
 struct __declspec(uuid("2ec912fd-b144-4a15-ad0d-1c5439c81e46"))
 IDxcType : public IUnknown
 {
@@ -47,6 +47,18 @@ IDxcRewriter : public IUnknown {
 
 };
 
+struct __declspec(uuid("8f2c4e61-3b7a-4d95-a0c8-5e1f9b27d4a3"))
+IDxcRewriter2 : public IDxcRewriter {
+  // Like RemoveUnusedGlobals for each of the entry points, but parses the
+  // source once. ppResults receives one result per entry point, in order.
+  virtual HRESULT STDMETHODCALLTYPE RemoveUnusedGlobalsForEntryPoints(_In_ IDxcBlobEncoding *pSource,
+                                                                      _In_count_(entryPointCount) LPCWSTR *pEntryPoints,
+                                                                      _In_ UINT32 entryPointCount,
+                                                                      _In_count_(defineCount) DxcDefine *pDefines,
+                                                                      _In_ UINT32 defineCount,
+                                                                      _Out_writes_(entryPointCount) IDxcOperationResult **ppResults) = 0;
+};
+
 __declspec(selectany)
 extern const CLSID CLSID_DxcRewriter = { /* b489b951-e07f-40b3-968d-93e124734da4 */
   0xb489b951,
@@ -28,6 +28,7 @@
 
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Valgrind.h"
+#include <vector> // HLSL Change
 
 namespace llvm {
 class raw_ostream;
@@ -176,6 +177,12 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+// HLSL Change Begin - let callers read statistics without -stats.
+/// \brief Get every statistic that has counted so far, whether or not -stats
+/// is set, in the order they first counted.
+void GetStatistics(std::vector<const Statistic *> &Stats);
+// HLSL Change End
+
 } // End llvm namespace
 
 #endif
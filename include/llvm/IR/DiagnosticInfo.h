@@ -473,6 +473,14 @@ void emitLoopVectorizeWarning(LLVMContext &Ctx, const Function &Fn,
 void emitLoopInterleaveWarning(LLVMContext &Ctx, const Function &Fn,
                                const DebugLoc &DLoc, const Twine &Msg);
 
+// HLSL Change Begin
+/// Emit a warning when loop unrolling is specified but fails. \p Fn is the
+/// function triggering the warning, \p DLoc is the debug location where the
+/// diagnostic is generated. \p Msg is the message string to use.
+void emitLoopUnrollWarning(LLVMContext &Ctx, const Function &Fn,
+                           const DebugLoc &DLoc, const Twine &Msg);
+// HLSL Change End
+
 } // End namespace llvm
 
 #endif
@@ -71,6 +71,16 @@ public:
   /// custom metadata IDs registered in this LLVMContext.
   void getMDKindNames(SmallVectorImpl<StringRef> &Result) const;
 
+  // HLSL Change Begin - Support reusing a context across modules.
+  /// resetForReuse - Restores the state that a module created in this
+  /// context can observe to that of a new context: metadata kinds past the
+  /// first NumMDKinds are unregistered, named struct types lose their names
+  /// unless KeepStructName accepts them, the renaming counter restarts and
+  /// the handlers are cleared. Returns false, changing nothing, while modules
+  /// are still alive in the context.
+  bool resetForReuse(unsigned NumMDKinds, bool (*KeepStructName)(StringRef));
+  // HLSL Change End
+
 
   typedef void (*InlineAsmDiagHandlerTy)(const SMDiagnostic&, void *Context,
                                          unsigned LocCookie);
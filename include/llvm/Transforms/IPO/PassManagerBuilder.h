@@ -16,6 +16,7 @@
 #define LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 
 #include <vector>
+#include <string> // HLSL Change
 
 namespace hlsl {
   class HLSLExtensionsCodegenHelper;
@@ -127,6 +128,22 @@ public:
   bool MergeFunctions;
   bool PrepareForLTO;
   bool HLSLHighLevel = false; // HLSL Change
+  bool HLSLFastOpt = false; // HLSL Change - fast-compile pass list, see populateModulePassManager
+  bool HLSLPairHalfOps = false; // HLSL Change - schedule half operations for packed math
+  bool HLSLHoistSamples = false; // HLSL Change - speculate samples above branches
+  bool HLSLDynamicIndexToSelect = false; // HLSL Change - select over small local arrays
+  unsigned HLSLConstTableSelect = 0; // HLSL Change - select over small constant tables
+  bool HLSLReportConstTables = false; // HLSL Change - remark on constant table storage
+  unsigned HLSLFunctionBudget = 0; // HLSL Change - instructions over which GVN and LICM degrade, 0 for none
+  bool HLSLLinked = false; // HLSL Change - module is linked DXIL, skip lowering
+  bool HLSLRootSignatureInMetadata = true; // HLSL Change - false when only the container part carries it
+  bool HLSLProfileInstrument = false; // HLSL Change - count block executions into a UAV
+  bool HLSLProfileRegions = false; // HLSL Change - time [profile] regions into a UAV
+  std::string HLSLBlockProfile; // HLSL Change - block counts for control flow hints
+  unsigned HLSLRenderTargetMask = 0xFF; // HLSL Change - render targets a pixel shader writes
+  bool HLSLDepthWriteDisabled = false; // HLSL Change - pixel shader depth output is dropped
+  bool HLSLHasConsumerInputs = false; // HLSL Change - HLSLConsumerInputs is set
+  std::string HLSLConsumerInputs; // HLSL Change - '+'-separated semantics the next stage reads
   hlsl::HLSLExtensionsCodegenHelper *HLSLExtensionsCodeGen = nullptr; // HLSL Change
 
 private:
@@ -21,11 +21,13 @@
 namespace llvm {
 
 class BasicBlockPass;
+class DebugLoc; // HLSL Change
 class Function;
 class FunctionPass;
 class ModulePass;
 class Pass;
 class GetElementPtrInst;
+class Loop; // HLSL Change
 class PassInfo;
 class TerminatorInst;
 class TargetLowering;
@@ -187,8 +189,9 @@ FunctionPass *createInstructionCombiningPass();
 //===----------------------------------------------------------------------===//
 //
 // LICM - This pass is a loop invariant code motion and memory promotion pass.
+// HLSL Change - functions over MaxInstructions are skipped, zero is unlimited.
 //
-Pass *createLICMPass();
+Pass *createLICMPass(unsigned MaxInstructions = 0);
 
 //===----------------------------------------------------------------------===//
 //
@@ -230,7 +233,22 @@ Pass *createLoopInstSimplifyPass();
 // LoopUnroll - This pass is a simple loop unrolling pass.
 //
 Pass *createLoopUnrollPass(int Threshold = -1, int Count = -1,
-                           int AllowPartial = -1, int Runtime = -1);
+                           int AllowPartial = -1, int Runtime = -1,
+                           bool ReportHintFailures = false); // HLSL Change
+// HLSL Change Begin
+// Lets the creator of an unrolling pass restrict it to some loops and learn
+// how they were unrolled.
+struct LoopUnrollCallbacks {
+  // Loops this returns false for are not unrolled.
+  std::function<bool(Loop *L)> ShouldUnroll;
+  // Called after the loop starting at Loc has been unrolled by Count; Count
+  // equals TripCount when the loop was completely unrolled.
+  std::function<void(const DebugLoc &Loc, unsigned Count, unsigned TripCount)>
+      Unrolled;
+};
+Pass *createLoopUnrollPass(int Threshold, int Count, int AllowPartial,
+                           int Runtime, LoopUnrollCallbacks Callbacks);
+// HLSL Change End
 // Create an unrolling pass for full unrolling only.
 Pass *createSimpleLoopUnrollPass();
 
@@ -393,8 +411,11 @@ FunctionPass *createMergedLoadStoreMotionPass();
 //
 // GVN - This pass performs global value numbering and redundant load
 // elimination cotemporaneously.
+// HLSL Change - functions over MaxInstructions are only value numbered,
+// without load elimination or PRE; zero is unlimited.
 //
-FunctionPass *createGVNPass(bool NoLoads = false);
+FunctionPass *createGVNPass(bool NoLoads = false,
+                            unsigned MaxInstructions = 0);
 
 //===----------------------------------------------------------------------===//
 //
@@ -291,6 +291,16 @@ void combineMetadata(Instruction *K, const Instruction *J, ArrayRef<unsigned> Kn
 /// the given edge.  Returns the number of replacements made.
 unsigned replaceDominatedUsesWith(Value *From, Value *To, DominatorTree &DT,
                                   const BasicBlockEdge &Edge);
+
+// HLSL Change Begins
+/// \brief Check F against a per-function instruction budget.
+///
+/// Returns true, and warns that pass \p PassName \p Degradation on F, if F
+/// has more than \p MaxInstructions instructions. A budget of zero is
+/// unlimited.
+bool isOverInstructionBudget(Function &F, unsigned MaxInstructions,
+                             StringRef PassName, StringRef Degradation);
+// HLSL Change Ends
 } // End llvm namespace
 
 #endif
@@ -469,6 +469,27 @@ static Constant *ConstantFoldFPIntrinsic(OP::OpCode opcode, Type *Ty, const Dxil
   return nullptr;
 }
 
+// Constant fold the special float tests, which take a float and return i1.
+// Unlike the arithmetic folds, NaN and infinite operands are folded here
+// since classifying them is the point of these operations.
+static Constant *ConstantFoldIsSpecialFloat(OP::OpCode opcode, Type *Ty, const DxilIntrinsicOperands &IntrinsicOperands) {
+  assert(IntrinsicOperands.Size() == 1);
+  ConstantFP *Op = IntrinsicOperands.GetConstantFloat(0);
+  if (!Op || !Ty->isIntegerTy(1))
+    return nullptr;
+
+  const APFloat &C = Op->getValueAPF();
+  switch (opcode) {
+  default: break;
+  case OP::OpCode::IsNaN:    return ConstantInt::get(Ty, C.isNaN());
+  case OP::OpCode::IsInf:    return ConstantInt::get(Ty, C.isInfinity());
+  case OP::OpCode::IsFinite: return ConstantInt::get(Ty, C.isFinite());
+  case OP::OpCode::IsNormal: return ConstantInt::get(Ty, C.isNormal());
+  }
+
+  return nullptr;
+}
+
 // Top level function to constant fold integer intrinsics.
 static Constant *ConstantFoldIntIntrinsic(OP::OpCode opcode, Type *Ty, const DxilIntrinsicOperands &IntrinsicOperands) {
   if (Ty->getScalarSizeInBits() > (sizeof(int64_t) * CHAR_BIT))
@@ -529,7 +550,10 @@ Constant *hlsl::ConstantFoldScalarCall(StringRef Name, Type *Ty, ArrayRef<Consta
   if (GetDxilOpcode(Name, RawOperands, opcode)) {
     DxilIntrinsicOperands IntrinsicOperands(RawOperands);
 
-    if (Ty->isFloatingPointTy()) {
+    if (OP::GetOpCodeClass(opcode) == OP::OpCodeClass::IsSpecialFloat) {
+      return ConstantFoldIsSpecialFloat(opcode, Ty, IntrinsicOperands);
+    }
+    else if (Ty->isFloatingPointTy()) {
       return ConstantFoldFPIntrinsic(opcode, Ty, IntrinsicOperands);
     }
     else if (Ty->isIntegerTy()) {
@@ -564,6 +588,7 @@ bool hlsl::CanConstantFoldCallTo(const Function *F) {
     case OP::OpCodeClass::Binary:
     case OP::OpCodeClass::Tertiary:
     case OP::OpCodeClass::Quaternary:
+    case OP::OpCodeClass::IsSpecialFloat:
     case OP::OpCodeClass::Dot2:
     case OP::OpCodeClass::Dot3:
     case OP::OpCodeClass::Dot4:
@@ -18,20 +18,26 @@
 
 #include <algorithm>
 #include <memory>
+#include <vector>
 #include <intsafe.h>
 
 #define CP_UTF16 1200
 
 namespace hlsl {
 
-_Use_decl_annotations_
-void ReadBinaryFile(LPCWSTR pFileName, void **ppData, DWORD *pDataSize) {
+// Files at least this large are mapped rather than read by
+// DxcCreateBlobFromFile; below it, a heap copy costs less than a mapping.
+static const DWORD DxcMappedFileMinSize = 64 * 1024;
+
+static HANDLE OpenFileForRead(LPCWSTR pFileName) {
   HANDLE hFile = CreateFileW(pFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
   if(hFile == INVALID_HANDLE_VALUE) {
     IFT(HRESULT_FROM_WIN32(GetLastError()));
   }
-  CHandle h(hFile);
+  return hFile;
+}
 
+static DWORD GetFileSizeForRead(HANDLE hFile) {
   LARGE_INTEGER FileSize;
   if(!GetFileSizeEx(hFile, &FileSize)) {
     IFT(HRESULT_FROM_WIN32(GetLastError()));
@@ -39,19 +45,46 @@ void ReadBinaryFile(LPCWSTR pFileName, void **ppData, DWORD *pDataSize) {
   if(FileSize.HighPart != 0) {
     throw(hlsl::Exception(DXC_E_INPUT_FILE_TOO_LARGE, "input file is too large"));
   }
+  return FileSize.LowPart;
+}
+
+static void ReadOpenedFile(HANDLE hFile, DWORD FileSize, void **ppData) {
   CComHeapPtr<char> pData;
-  if (!pData.AllocateBytes(FileSize.LowPart)) {
+  if (!pData.AllocateBytes(FileSize)) {
     throw std::bad_alloc();
   }
 
   DWORD BytesRead;
-  if(!ReadFile(hFile, pData.m_pData, FileSize.LowPart, &BytesRead, nullptr)) {
+  if(!ReadFile(hFile, pData.m_pData, FileSize, &BytesRead, nullptr)) {
     IFT(HRESULT_FROM_WIN32(GetLastError()));
   }
-  DXASSERT(FileSize.LowPart == BytesRead, "ReadFile operation failed");
+  DXASSERT(FileSize == BytesRead, "ReadFile operation failed");
 
   *ppData = pData.Detach();
-  *pDataSize = FileSize.LowPart;
+}
+
+// Maps the whole of a non-empty file read-only. The view stays valid after
+// the file and mapping handles are closed, until it is unmapped.
+static const void *MapBinaryFile(HANDLE hFile) {
+  HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (hMapping == NULL) {
+    IFT(HRESULT_FROM_WIN32(GetLastError()));
+  }
+  CHandle m(hMapping);
+
+  const void *pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+  if (pView == nullptr) {
+    IFT(HRESULT_FROM_WIN32(GetLastError()));
+  }
+  return pView;
+}
+
+_Use_decl_annotations_
+void ReadBinaryFile(LPCWSTR pFileName, void **ppData, DWORD *pDataSize) {
+  CHandle h(OpenFileForRead(pFileName));
+  DWORD FileSize = GetFileSizeForRead(h);
+  ReadOpenedFile(h, FileSize, ppData);
+  *pDataSize = FileSize;
 }
 
 _Use_decl_annotations_
@@ -110,6 +143,7 @@ private:
   unsigned m_HeapFree : 1;
   unsigned m_EncodingKnown : 1;
   unsigned m_MallocFree : 1;
+  unsigned m_UnmapView : 1;
   UINT32 m_CodePage;
 public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
@@ -129,6 +163,9 @@ public:
     if (m_HeapFree) {
       CoTaskMemFree((LPVOID)m_Buffer);
     }
+    if (m_UnmapView) {
+      UnmapViewOfFile(m_Buffer);
+    }
   }
 
   static HRESULT
@@ -144,6 +181,7 @@ public:
     (*pEncoding)->m_HeapFree = 1;
     (*pEncoding)->m_EncodingKnown = encodingKnown;
     (*pEncoding)->m_MallocFree = 0;
+    (*pEncoding)->m_UnmapView = 0;
     (*pEncoding)->m_CodePage = codePage;
     (*pEncoding)->AddRef();
     return S_OK;
@@ -163,6 +201,7 @@ public:
     (*pEncoding)->m_HeapFree = 0;
     (*pEncoding)->m_EncodingKnown = encodingKnown;
     (*pEncoding)->m_MallocFree = 0;
+    (*pEncoding)->m_UnmapView = 0;
     (*pEncoding)->m_CodePage = codePage;
     (*pEncoding)->AddRef();
     return S_OK;
@@ -181,12 +220,33 @@ public:
     (*pEncoding)->m_HeapFree = 0;
     (*pEncoding)->m_EncodingKnown = encodingKnown;
     (*pEncoding)->m_MallocFree = 1;
+    (*pEncoding)->m_UnmapView = 0;
+    (*pEncoding)->m_CodePage = codePage;
+    (*pEncoding)->AddRef();
+    return S_OK;
+  }
+
+  static HRESULT
+  CreateFromMappedView(LPCVOID view, SIZE_T viewSize, bool encodingKnown,
+                       UINT32 codePage,
+                       _COM_Outptr_ InternalDxcBlobEncoding **pEncoding) {
+    *pEncoding = new (std::nothrow) InternalDxcBlobEncoding();
+    if (*pEncoding == nullptr) {
+      return E_OUTOFMEMORY;
+    }
+    (*pEncoding)->m_Buffer = view;
+    (*pEncoding)->m_BufferSize = viewSize;
+    (*pEncoding)->m_HeapFree = 0;
+    (*pEncoding)->m_EncodingKnown = encodingKnown;
+    (*pEncoding)->m_MallocFree = 0;
+    (*pEncoding)->m_UnmapView = 1;
     (*pEncoding)->m_CodePage = codePage;
     (*pEncoding)->AddRef();
     return S_OK;
   }
 
   void AdjustPtrAndSize(unsigned offset, unsigned size) {
+    DXASSERT(!m_UnmapView, "else the view can no longer be unmapped");
     DXASSERT(offset < m_BufferSize, "else caller will overflow");
     DXASSERT(offset + size <= m_BufferSize, "else caller will overflow");
     m_Buffer = (const uint8_t*)m_Buffer + offset;
@@ -316,34 +376,65 @@ DxcCreateBlobOnHeapCopy(_In_bytecount_(size) LPCVOID pData, UINT32 size,
   return S_OK;
 }
 
-_Use_decl_annotations_
-HRESULT DxcCreateBlobFromFile(LPCWSTR pFileName, UINT32 *pCodePage,
-                              IDxcBlobEncoding **ppBlobEncoding) {
+static HRESULT CreateBlobFromFile(LPCWSTR pFileName, UINT32 *pCodePage,
+                                  DWORD minMappedSize,
+                                  IDxcBlobEncoding **ppBlobEncoding) {
   if (pFileName == nullptr || ppBlobEncoding == nullptr) {
     return E_POINTER;
   }
 
+  bool known = (pCodePage != nullptr);
+  UINT32 codePage = (pCodePage != nullptr) ? *pCodePage : 0;
+  *ppBlobEncoding = nullptr;
+
   CComHeapPtr<char> pData;
+  const void *pView = nullptr;
   DWORD dataSize;
-  *ppBlobEncoding = nullptr;
   try {
-    ReadBinaryFile(pFileName, (void **)(&pData), &dataSize);
+    CHandle h(OpenFileForRead(pFileName));
+    dataSize = GetFileSizeForRead(h);
+    // Empty files cannot be mapped.
+    if (dataSize != 0 && dataSize >= minMappedSize)
+      pView = MapBinaryFile(h);
+    else
+      ReadOpenedFile(h, dataSize, (void **)(&pData));
   }
   CATCH_CPP_RETURN_HRESULT();
 
-  bool known = (pCodePage != nullptr);
-  UINT32 codePage = (pCodePage != nullptr) ? *pCodePage : 0;
-
   InternalDxcBlobEncoding *internalEncoding;
-  HRESULT hr = InternalDxcBlobEncoding::CreateFromHeap(
-      pData, dataSize, known, codePage, &internalEncoding);
+  HRESULT hr;
+  if (pView != nullptr) {
+    hr = InternalDxcBlobEncoding::CreateFromMappedView(
+        pView, dataSize, known, codePage, &internalEncoding);
+    if (FAILED(hr)) {
+      UnmapViewOfFile(pView);
+    }
+  } else {
+    hr = InternalDxcBlobEncoding::CreateFromHeap(
+        pData, dataSize, known, codePage, &internalEncoding);
+    if (SUCCEEDED(hr)) {
+      pData.Detach();
+    }
+  }
   if (SUCCEEDED(hr)) {
     *ppBlobEncoding = internalEncoding;
-    pData.Detach();
   }
   return hr;
 }
 
+_Use_decl_annotations_
+HRESULT DxcCreateBlobFromFile(LPCWSTR pFileName, UINT32 *pCodePage,
+                              IDxcBlobEncoding **ppBlobEncoding) {
+  return CreateBlobFromFile(pFileName, pCodePage, DxcMappedFileMinSize,
+                            ppBlobEncoding);
+}
+
+_Use_decl_annotations_
+HRESULT DxcCreateBlobFromFileMapped(LPCWSTR pFileName, UINT32 *pCodePage,
+                                    IDxcBlobEncoding **ppBlobEncoding) {
+  return CreateBlobFromFile(pFileName, pCodePage, 0, ppBlobEncoding);
+}
+
 _Use_decl_annotations_
 HRESULT
 DxcCreateBlobWithEncodingSet(IDxcBlob *pBlob, UINT32 codePage,
@@ -796,12 +887,323 @@ public:
     return S_OK;
   }
 
-  __override HRESULT STDMETHODCALLTYPE CopyTo(IStream *, ULARGE_INTEGER,
-    ULARGE_INTEGER *,
-    ULARGE_INTEGER *) {
+  __override HRESULT STDMETHODCALLTYPE CopyTo(IStream *pstm, ULARGE_INTEGER cb,
+    ULARGE_INTEGER *pcbRead,
+    ULARGE_INTEGER *pcbWritten) {
+    if (pstm == nullptr) return E_POINTER;
+    if (pcbRead != nullptr) pcbRead->QuadPart = 0;
+    if (pcbWritten != nullptr) pcbWritten->QuadPart = 0;
+    if (m_offset >= m_size) return S_OK;
+    ULONG count = (ULONG)std::min<UINT64>(cb.QuadPart, m_size - m_offset);
+    ULONG cbWritten;
+    HRESULT hr = pstm->Write(m_pMemory + m_offset, count, &cbWritten);
+    if (FAILED(hr)) return hr;
+    m_offset += count;
+    if (pcbRead != nullptr) pcbRead->QuadPart = count;
+    if (pcbWritten != nullptr) pcbWritten->QuadPart = cbWritten;
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Commit(DWORD) { return E_NOTIMPL; }
+
+  __override HRESULT STDMETHODCALLTYPE Revert(void) { return E_NOTIMPL; }
+
+  __override HRESULT STDMETHODCALLTYPE LockRegion(ULARGE_INTEGER,
+    ULARGE_INTEGER, DWORD) {
+    return E_NOTIMPL;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE UnlockRegion(ULARGE_INTEGER,
+    ULARGE_INTEGER, DWORD) {
     return E_NOTIMPL;
   }
 
+  __override HRESULT STDMETHODCALLTYPE Clone(IStream **) { return E_NOTIMPL; }
+
+  __override HRESULT STDMETHODCALLTYPE Seek(LARGE_INTEGER liDistanceToMove,
+    DWORD dwOrigin,
+    ULARGE_INTEGER *lpNewFilePointer) {
+    if (lpNewFilePointer != nullptr) {
+      lpNewFilePointer->QuadPart = 0;
+    }
+
+    if (liDistanceToMove.HighPart != 0) {
+      return E_FAIL;
+    }
+
+    ULONG targetOffset;
+
+    switch (dwOrigin) {
+    case STREAM_SEEK_SET:
+      targetOffset = liDistanceToMove.LowPart;
+      break;
+    case STREAM_SEEK_CUR:
+      targetOffset = liDistanceToMove.LowPart + m_offset;
+      break;
+    case STREAM_SEEK_END:
+      targetOffset = liDistanceToMove.LowPart + m_size;
+      break;
+    default:
+      return STG_E_INVALIDFUNCTION;
+    }
+
+    m_offset = targetOffset;
+    if (lpNewFilePointer != nullptr) {
+      lpNewFilePointer->LowPart = targetOffset;
+    }
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Stat(STATSTG *pStatstg,
+    DWORD grfStatFlag) {
+    if (pStatstg == nullptr) {
+      return E_POINTER;
+    }
+    ZeroMemory(pStatstg, sizeof(*pStatstg));
+    pStatstg->type = STGTY_STREAM;
+    pStatstg->cbSize.LowPart = m_size;
+    return S_OK;
+  }
+};
+
+// A memory stream that grows by adding chunks, so that data once written is
+// never moved. A contiguous view is only built when one is requested through
+// GetPtr, Detach or the IDxcBlob interface; the chunks are then coalesced
+// into one block, and later writes add chunks after it again.
+class ChunkedMemoryStream : public AbstractMemoryStream, public IDxcBlob {
+private:
+  struct Chunk {
+    LPBYTE pData;
+    ULONG start;    // Offset of the chunk in the stream.
+    ULONG capacity;
+  };
+
+  // The first chunk added when writing; each later one is at least as large
+  // as all before it, so there are few chunks even for large streams.
+  static const ULONG MinChunkSize = 64 * 1024;
+
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  CComPtr<IMalloc> m_pMalloc;
+  std::vector<Chunk> m_chunks;
+  ULONG m_offset;
+  ULONG m_size;
+  ULONG m_allocSize;
+
+  // Adds a chunk of at least minCapacity bytes at the end of the stream.
+  HRESULT AddChunk(ULONG minCapacity) {
+    ULONG capacity = std::max(minCapacity, std::max(MinChunkSize, m_allocSize));
+    if (m_allocSize + capacity < m_allocSize)
+      capacity = minCapacity;
+    Chunk chunk;
+    chunk.pData = (LPBYTE)m_pMalloc->Alloc(capacity);
+    if (chunk.pData == nullptr)
+      return E_OUTOFMEMORY;
+    chunk.start = m_allocSize;
+    chunk.capacity = capacity;
+    try {
+      m_chunks.push_back(chunk);
+    } catch (std::bad_alloc &) {
+      m_pMalloc->Free(chunk.pData);
+      return E_OUTOFMEMORY;
+    }
+    m_allocSize += capacity;
+    return S_OK;
+  }
+
+  // Returns the index of the chunk holding offset, which is below
+  // m_allocSize.
+  size_t FindChunk(ULONG offset) const {
+    auto it = std::upper_bound(
+        m_chunks.begin(), m_chunks.end(), offset,
+        [](ULONG value, const Chunk &chunk) { return value < chunk.start; });
+    return (it - m_chunks.begin()) - 1;
+  }
+
+  // Copies cb bytes from pv, or zeroes if pv is null, to the given offset.
+  // The chunks must already extend past offset + cb.
+  void CopyIn(ULONG offset, const BYTE *pv, ULONG cb) {
+    for (size_t i = FindChunk(offset); cb > 0; ++i) {
+      const Chunk &chunk = m_chunks[i];
+      ULONG inChunk = offset - chunk.start;
+      ULONG count = std::min(cb, chunk.capacity - inChunk);
+      if (pv != nullptr) {
+        memcpy(chunk.pData + inChunk, pv, count);
+        pv += count;
+      } else {
+        memset(chunk.pData + inChunk, 0, count);
+      }
+      offset += count;
+      cb -= count;
+    }
+  }
+
+  // Makes the first chunk hold all the data.
+  HRESULT Coalesce() {
+    if (m_chunks.size() <= 1)
+      return S_OK;
+    LPBYTE pData = (LPBYTE)m_pMalloc->Alloc(std::max(m_size, 1UL));
+    if (pData == nullptr)
+      return E_OUTOFMEMORY;
+    ULONG copied = 0;
+    for (const Chunk &chunk : m_chunks) {
+      ULONG count = std::min(chunk.capacity, m_size - copied);
+      memcpy(pData + copied, chunk.pData, count);
+      copied += count;
+      m_pMalloc->Free(chunk.pData);
+    }
+    m_chunks.resize(1);
+    m_chunks[0].pData = pData;
+    m_chunks[0].start = 0;
+    m_chunks[0].capacity = std::max(m_size, 1UL);
+    m_allocSize = m_chunks[0].capacity;
+    return S_OK;
+  }
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IStream, ISequentialStream, IDxcBlob>(this, iid, ppvObject);
+  }
+
+  ChunkedMemoryStream(_In_ IMalloc *pMalloc)
+    : m_dwRef(0), m_pMalloc(pMalloc), m_offset(0), m_size(0),
+    m_allocSize(0) {}
+
+  ~ChunkedMemoryStream() {
+    Reset();
+  }
+
+  void Reset() {
+    for (const Chunk &chunk : m_chunks)
+      m_pMalloc->Free(chunk.pData);
+    m_chunks.clear();
+    m_offset = 0;
+    m_size = 0;
+    m_allocSize = 0;
+  }
+
+  // AbstractMemoryStream implementation.
+  __override LPBYTE GetPtr() {
+    if (m_chunks.empty() || FAILED(Coalesce()))
+      return nullptr;
+    return m_chunks[0].pData;
+  }
+
+  __override ULONG GetPtrSize() {
+    return m_size;
+  }
+
+  __override LPBYTE Detach() {
+    LPBYTE result = GetPtr();
+    if (result != nullptr)
+      m_chunks.clear();
+    Reset();
+    return result;
+  }
+
+  __override HRESULT Reserve(ULONG targetSize) {
+    if (targetSize <= m_allocSize)
+      return S_OK;
+    return AddChunk(targetSize - m_allocSize);
+  }
+
+  // IDxcBlob implementation. Requires no further writes.
+  __override LPVOID STDMETHODCALLTYPE GetBufferPointer(void) {
+    return GetPtr();
+  }
+  __override SIZE_T STDMETHODCALLTYPE GetBufferSize(void) {
+    return m_size;
+  }
+  __override UINT64 GetPosition() {
+    return m_offset;
+  }
+
+  // ISequentialStream implementation.
+  __override HRESULT STDMETHODCALLTYPE Read(void* pv, ULONG cb, ULONG* pcbRead) {
+    if (!pv || !pcbRead) return E_POINTER;
+    // If we seeked past the end, read nothing.
+    if (m_offset >= m_size) {
+      *pcbRead = 0;
+      return cb == 0 ? S_OK : S_FALSE;
+    }
+    ULONG cbLeft = m_size - m_offset;
+    *pcbRead = std::min(cb, cbLeft);
+    LPBYTE pOut = (LPBYTE)pv;
+    for (size_t i = FindChunk(m_offset), left = *pcbRead; left > 0; ++i) {
+      const Chunk &chunk = m_chunks[i];
+      ULONG inChunk = m_offset - chunk.start;
+      ULONG count = std::min((ULONG)left, chunk.capacity - inChunk);
+      memcpy(pOut, chunk.pData + inChunk, count);
+      pOut += count;
+      m_offset += count;
+      left -= count;
+    }
+    return (*pcbRead == cb) ? S_OK : S_FALSE;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Write(void const* pv, ULONG cb, ULONG* pcbWritten) {
+    if (!pv || !pcbWritten) return E_POINTER;
+    if (m_offset + cb < m_offset) return E_OUTOFMEMORY;
+    if (cb + m_offset > m_allocSize) {
+      HRESULT hr = AddChunk(cb + m_offset - m_allocSize);
+      if (FAILED(hr)) return hr;
+    }
+    // Implicitly extend as needed with zeroes.
+    if (m_offset > m_size) {
+      CopyIn(m_size, nullptr, m_offset - m_size);
+    }
+    *pcbWritten = cb;
+    CopyIn(m_offset, (const BYTE *)pv, cb);
+    m_offset += cb;
+    m_size = std::max(m_size, m_offset);
+    return S_OK;
+  }
+
+  // IStream implementation.
+  __override HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER val) {
+    if (val.HighPart != 0) {
+      return E_OUTOFMEMORY;
+    }
+    if (val.LowPart > m_allocSize) {
+      HRESULT hr = AddChunk(val.LowPart - m_allocSize);
+      if (FAILED(hr)) return hr;
+    }
+    if (val.LowPart < m_size) {
+      m_size = val.LowPart;
+      m_offset = std::min(m_offset, m_size);
+    }
+    else if (val.LowPart > m_size) {
+      CopyIn(m_size, nullptr, val.LowPart - m_size);
+      m_size = val.LowPart;
+    }
+    return S_OK;
+  }
+
+  // Writes the chunks to pstm one at a time, without coalescing them.
+  __override HRESULT STDMETHODCALLTYPE CopyTo(IStream *pstm, ULARGE_INTEGER cb,
+    ULARGE_INTEGER *pcbRead,
+    ULARGE_INTEGER *pcbWritten) {
+    if (pstm == nullptr) return E_POINTER;
+    if (pcbRead != nullptr) pcbRead->QuadPart = 0;
+    if (pcbWritten != nullptr) pcbWritten->QuadPart = 0;
+    if (m_offset >= m_size) return S_OK;
+    ULONG left = (ULONG)std::min<UINT64>(cb.QuadPart, m_size - m_offset);
+    for (size_t i = FindChunk(m_offset); left > 0; ++i) {
+      const Chunk &chunk = m_chunks[i];
+      ULONG inChunk = m_offset - chunk.start;
+      ULONG count = std::min(left, chunk.capacity - inChunk);
+      ULONG cbWritten;
+      HRESULT hr = pstm->Write(chunk.pData + inChunk, count, &cbWritten);
+      if (FAILED(hr)) return hr;
+      m_offset += count;
+      left -= count;
+      if (pcbRead != nullptr) pcbRead->QuadPart += count;
+      if (pcbWritten != nullptr) pcbWritten->QuadPart += cbWritten;
+    }
+    return S_OK;
+  }
+
   __override HRESULT STDMETHODCALLTYPE Commit(DWORD) { return E_NOTIMPL; }
 
   __override HRESULT STDMETHODCALLTYPE Revert(void) { return E_NOTIMPL; }
@@ -987,6 +1389,33 @@ HRESULT CreateMemoryStream(_In_ IMalloc *pMalloc, _COM_Outptr_ AbstractMemoryStr
   return (*ppResult == nullptr) ? E_OUTOFMEMORY : S_OK;
 }
 
+HRESULT CreateChunkedMemoryStream(_In_ IMalloc *pMalloc, _COM_Outptr_ AbstractMemoryStream** ppResult) {
+  if (pMalloc == nullptr || ppResult == nullptr) {
+    return E_POINTER;
+  }
+
+  CComPtr<ChunkedMemoryStream> stream = new (std::nothrow) ChunkedMemoryStream(pMalloc);
+  *ppResult = stream.Detach();
+  return (*ppResult == nullptr) ? E_OUTOFMEMORY : S_OK;
+}
+
+HRESULT CopyMemoryStream(_In_ AbstractMemoryStream *pSource, _In_ IStream *pTarget) {
+  if (pSource == nullptr || pTarget == nullptr) {
+    return E_POINTER;
+  }
+
+  LARGE_INTEGER position;
+  position.QuadPart = 0;
+  UINT64 savedPosition = pSource->GetPosition();
+  IFR(pSource->Seek(position, STREAM_SEEK_SET, nullptr));
+  ULARGE_INTEGER size;
+  size.QuadPart = pSource->GetPtrSize();
+  HRESULT hr = pSource->CopyTo(pTarget, size, nullptr, nullptr);
+  position.QuadPart = savedPosition;
+  IFR(pSource->Seek(position, STREAM_SEEK_SET, nullptr));
+  return hr;
+}
+
 HRESULT CreateReadOnlyBlobStream(_In_ IDxcBlob *pSource, _COM_Outptr_ IStream** ppResult) {
   if (pSource == nullptr || ppResult == nullptr) {
     return E_POINTER;
@@ -257,17 +257,73 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.OutputObject = Args.getLastArgValue(OPT_Fo);
   opts.OutputHeader = Args.getLastArgValue(OPT_Fh);
   opts.OutputWarningsFile = Args.getLastArgValue(OPT_Fe);
+  opts.StatisticsFile = Args.getLastArgValue(OPT_Fstats);
   opts.UseColor = Args.hasFlag(OPT_Cc, OPT_INVALID);
   opts.UseInstructionNumbers = Args.hasFlag(OPT_Ni, OPT_INVALID);
   opts.UseInstructionByteOffsets = Args.hasFlag(OPT_No, OPT_INVALID);
   opts.UseHexLiterals = Args.hasFlag(OPT_Lx, OPT_INVALID);
   opts.Preprocess = Args.getLastArgValue(OPT_P);
+  opts.DependencyFile = Args.getLastArgValue(OPT_MF);
+  opts.BatchFile = Args.getLastArgValue(OPT_batch);
+  opts.BatchSummaryFile = Args.getLastArgValue(OPT_batch_summary);
+  llvm::StringRef batchThreads = Args.getLastArgValue(OPT_batch_threads);
+  if (!batchThreads.empty() &&
+      batchThreads.getAsInteger(10, opts.BatchThreads)) {
+    errors << "Invalid worker count '" << batchThreads << "' for /batch-threads.";
+    return 1;
+  }
+  opts.Server = Args.hasFlag(OPT_server, OPT_INVALID, false);
+  llvm::StringRef serverMemoryLimit =
+      Args.getLastArgValue(OPT_server_memory_limit);
+  if (!serverMemoryLimit.empty() &&
+      serverMemoryLimit.getAsInteger(10, opts.ServerMemoryLimit)) {
+    errors << "Invalid size '" << serverMemoryLimit
+           << "' for /server-memory-limit.";
+    return 1;
+  }
+  if (opts.Server && !opts.BatchFile.empty()) {
+    errors << "/server and /batch cannot be used together.";
+    return 1;
+  }
+  if (opts.BatchFile.empty() && !opts.BatchSummaryFile.empty()) {
+    errors << "/batch-summary requires /batch.";
+    return 1;
+  }
+  if (opts.BatchFile.empty() && !opts.Server && opts.BatchThreads != 0) {
+    errors << "/batch-threads requires /batch or /server.";
+    return 1;
+  }
+  if (!opts.Server && opts.ServerMemoryLimit != 0) {
+    errors << "/server-memory-limit requires /server.";
+    return 1;
+  }
+  opts.DependencyTarget = Args.getLastArgValue(OPT_MT);
+  opts.PackageFile = Args.getLastArgValue(OPT_Fpackage);
+  opts.VerifyDeterminism =
+      Args.hasFlag(OPT_verify_determinism, OPT_INVALID, false);
+  opts.FromPackage = Args.hasFlag(OPT_from_package, OPT_INVALID, false);
+  opts.DependenciesJson = Args.hasFlag(OPT_MJ, OPT_INVALID, false);
+  opts.DependenciesWithOutput = Args.hasFlag(OPT_MD, OPT_INVALID, false);
+  opts.DependenciesOnly = Args.hasFlag(OPT_M, OPT_INVALID, false) ||
+                          (!opts.DependenciesWithOutput &&
+                           (opts.DependenciesJson ||
+                            !opts.DependencyFile.empty()));
+  if (opts.DependenciesOnly && opts.DependenciesWithOutput) {
+    errors << "/M and /MD cannot be used together.";
+    return 1;
+  }
   opts.AstDump = Args.hasFlag(OPT_ast_dump, OPT_INVALID, false);
   opts.GenSPIRV = Args.hasFlag(OPT_spirv, OPT_INVALID, false); // SPIRV change
+  opts.SPIRVCompact = Args.hasFlag(OPT_spirv_compact, OPT_INVALID, false); // SPIRV change
+  opts.SPIRVStats = Args.hasFlag(OPT_spirv_stats, OPT_INVALID, false); // SPIRV change
   opts.CodeGenHighLevel = Args.hasFlag(OPT_fcgl, OPT_INVALID, false);
-  opts.DebugInfo = Args.hasFlag(OPT__SLASH_Zi, OPT_INVALID, false);
+  opts.DebugInfoLineTablesOnly =
+      Args.hasFlag(OPT_gline_tables_only, OPT_INVALID, false);
+  opts.DebugInfo = Args.hasFlag(OPT__SLASH_Zi, OPT_INVALID, false) ||
+                   opts.DebugInfoLineTablesOnly;
   opts.DebugNameForBinary = Args.hasFlag(OPT_Zsb, OPT_INVALID, false);
   opts.DebugNameForSource = Args.hasFlag(OPT_Zsb, OPT_INVALID, false);
+  opts.DebugNameFastHash = Args.hasFlag(OPT_Zsx, OPT_INVALID, false);
   opts.VariableName = Args.getLastArgValue(OPT_Vn);
   opts.InputFile = Args.getLastArgValue(OPT_INPUT);
   opts.ForceRootSigVer = Args.getLastArgValue(OPT_force_rootsig_ver);
@@ -285,11 +341,15 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
 
   opts.IEEEStrict = Args.hasFlag(OPT_Gis, OPT_INVALID, false);
   
-  if (Arg *A = Args.getLastArg(OPT_O0, OPT_O1, OPT_O2, OPT_O3)) {
+  if (Arg *A = Args.getLastArg(OPT_O0, OPT_O1, OPT_O1fast, OPT_O2, OPT_O3)) {
     if (A->getOption().matches(OPT_O0))
       opts.OptLevel = 0;
     if (A->getOption().matches(OPT_O1))
       opts.OptLevel = 1;
+    if (A->getOption().matches(OPT_O1fast)) {
+      opts.OptLevel = 1;
+      opts.OptFast = true;
+    }
     if (A->getOption().matches(OPT_O2))
       opts.OptLevel = 2;
     if (A->getOption().matches(OPT_O3))
@@ -300,12 +360,47 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.OptDump = Args.hasFlag(OPT_Odump, OPT_INVALID, false);
 
   opts.DisableOptimizations = Args.hasFlag(OPT_Od, OPT_INVALID, false);
-  if (opts.DisableOptimizations)
+  if (opts.DisableOptimizations) {
     opts.OptLevel = 0;
+    opts.OptFast = false;
+  }
 
   opts.DisableValidation = Args.hasFlag(OPT_VD, OPT_INVALID, false);
 
   opts.AllResourcesBound = Args.hasFlag(OPT_all_resources_bound, OPT_INVALID, false);
+  opts.PairHalfOps = Args.hasFlag(OPT_pair_half_ops, OPT_INVALID, false);
+  opts.HoistSamples = Args.hasFlag(OPT_hoist_samples, OPT_INVALID, false);
+  opts.LazyFunctionBodies = Args.hasFlag(OPT_lazy_function_bodies, OPT_INVALID, false);
+  opts.DynamicIndexToSelect = Args.hasFlag(OPT_dynamic_index_to_select, OPT_INVALID, false);
+  llvm::StringRef constTableSelect = Args.getLastArgValue(OPT_const_table_select);
+  if (!constTableSelect.empty() &&
+      constTableSelect.getAsInteger(10, opts.ConstTableSelect)) {
+    errors << "Invalid element count '" << constTableSelect
+           << "' for /const_table_select.";
+    return 1;
+  }
+  opts.ReportConstTables = Args.hasFlag(OPT_report_const_tables, OPT_INVALID, false);
+  opts.ReportNonUniformIndices = Args.hasFlag(OPT_report_non_uniform_indices, OPT_INVALID, false);
+  llvm::StringRef functionBudget = Args.getLastArgValue(OPT_function_budget);
+  if (!functionBudget.empty() &&
+      functionBudget.getAsInteger(10, opts.FunctionBudget)) {
+    errors << "Invalid instruction count '" << functionBudget
+           << "' for /function_budget.";
+    return 1;
+  }
+  opts.ProfileInstrument = Args.hasFlag(OPT_profile_instrument, OPT_INVALID, false);
+  opts.ProfileRegions = Args.hasFlag(OPT_profile_regions, OPT_INVALID, false);
+  opts.ProfileUseFile = Args.getLastArgValue(OPT_profile_use);
+  llvm::StringRef renderTargetMask = Args.getLastArgValue(OPT_rt_mask);
+  if (!renderTargetMask.empty() &&
+      (renderTargetMask.getAsInteger(0, opts.RenderTargetMask) ||
+       opts.RenderTargetMask > 0xFF)) {
+    errors << "Invalid render target mask '" << renderTargetMask
+           << "' for /rt_mask.";
+    return 1;
+  }
+  opts.NoDepthWrite = Args.hasFlag(OPT_no_depth_write, OPT_INVALID, false);
+  opts.PackCBuffers = Args.hasFlag(OPT_pack_cbuffers, OPT_INVALID, false);
   opts.ColorCodeAssembly = Args.hasFlag(OPT_Cc, OPT_INVALID, false);
   opts.DefaultRowMajor = Args.hasFlag(OPT_Zpr, OPT_INVALID, false);
   opts.DefaultColMajor = Args.hasFlag(OPT_Zpc, OPT_INVALID, false);
@@ -319,6 +414,9 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.PreferFlowControl = Args.hasFlag(OPT_Gfp, OPT_INVALID, false);
   opts.RecompileFromBinary = Args.hasFlag(OPT_recompile, OPT_INVALID, false);
   opts.StripDebug = Args.hasFlag(OPT_Qstrip_debug, OPT_INVALID, false);
+  opts.CompressDebug = Args.hasFlag(OPT_Qcompress_debug, OPT_INVALID, false);
+  opts.PSVIndexes = Args.hasFlag(OPT_Qpsv_indexes, OPT_INVALID, false);
+  opts.DedupStrings = Args.hasFlag(OPT_Qdedup_strings, OPT_INVALID, false);
   opts.StripRootSignature = Args.hasFlag(OPT_Qstrip_rootsignature, OPT_INVALID, false);
   opts.StripPrivate = Args.hasFlag(OPT_Qstrip_priv, OPT_INVALID, false);
   opts.StripReflection = Args.hasFlag(OPT_Qstrip_reflect, OPT_INVALID, false);
@@ -327,6 +425,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.DisassembleInstNumbers = Args.hasFlag(OPT_Ni, OPT_INVALID, false);
   opts.DisassembleByteOffset = Args.hasFlag(OPT_No, OPT_INVALID, false);
   opts.DisaseembleHex = Args.hasFlag(OPT_Lx, OPT_INVALID, false);
+  opts.TimeReport = Args.hasFlag(OPT_ftime_report, OPT_INVALID, false);
+  opts.PrintStats = Args.hasFlag(OPT_print_stats, OPT_INVALID, false);
 
   if (opts.DefaultColMajor && opts.DefaultRowMajor) {
     errors << "Cannot specify /Zpr and /Zpc together, use /? to get usage information";
@@ -340,6 +440,10 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
     errors << "Cannot specify /pack_prefix_stable and /pack_optimized together, use /? to get usage information";
     return 1;
   }
+  if (opts.ProfileInstrument && !opts.ProfileUseFile.empty()) {
+    errors << "Cannot specify /profile_instrument and /profile_use together, use /? to get usage information";
+    return 1;
+  }
   // TODO: more fxc option check.
   // ERR_RES_MAY_ALIAS_ONLY_IN_CS_5
   // ERR_NOT_ABLE_TO_FLATTEN on if that contain side effects
@@ -350,8 +454,10 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   // ERR_TEMPLATE_VAR_CONFLICT
   // ERR_ATTRIBUTE_PARAM_SIDE_EFFECT
 
-  if ((flagsToInclude & hlsl::options::DriverOption) && opts.InputFile.empty()) {
+  if ((flagsToInclude & hlsl::options::DriverOption) && opts.InputFile.empty() &&
+      opts.BatchFile.empty() && !opts.Server) {
     // Input file is required in arguments only for drivers; APIs take this through an argument.
+    // Batch jobs and server requests name their own inputs.
     errors << "Required input file argument is missing. use -help to get more information.";
     return 1;
   }
@@ -367,6 +473,31 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
     return 1;
   }
 
+  if (opts.DependenciesOnly &&
+      (!opts.Preprocess.empty() || opts.DumpBin || opts.RecompileFromBinary ||
+       !opts.OutputHeader.empty() || !opts.AssemblyCode.empty() ||
+       !opts.DebugFile.empty())) {
+    errors << "Dependency output cannot be specified with other outputs.";
+    return 1;
+  }
+
+  if (!opts.PackageFile.empty() &&
+      (!opts.Preprocess.empty() || opts.DependenciesOnly || opts.DumpBin ||
+       opts.RecompileFromBinary || opts.FromPackage)) {
+    errors << "/Fpackage cannot be specified with other actions.";
+    return 1;
+  }
+
+  if (opts.FromPackage &&
+      (!opts.Preprocess.empty() || opts.DependenciesOnly || opts.DumpBin ||
+       opts.RecompileFromBinary || opts.Defines.size() != 0 ||
+       !opts.EntryPoint.empty() || !opts.TargetProfile.empty())) {
+    errors << "/from_package takes the entry point, target profile and "
+              "defines from the package and cannot be specified with other "
+              "actions.";
+    return 1;
+  }
+
   if (opts.DumpBin) {
     if (opts.DisplayIncludeProcess || opts.AstDump) {
       errors << "Cannot perform actions related to sources from a binary file.";
@@ -384,7 +515,9 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   }
 
   if ((flagsToInclude & hlsl::options::DriverOption) &&
-      opts.TargetProfile.empty() && !opts.DumpBin && opts.Preprocess.empty() && !opts.RecompileFromBinary) {
+      opts.TargetProfile.empty() && !opts.DumpBin && opts.Preprocess.empty() && !opts.RecompileFromBinary &&
+      !opts.DependenciesOnly && !opts.FromPackage && opts.BatchFile.empty() &&
+      !opts.Server) {
     // Target profile is required in arguments only for drivers when compiling;
     // APIs take this through an argument.
     errors << "Target profile argument is missing";
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// MemoryTracking.cpp                                                        //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements the per-operation memory tracker and its IMalloc.              //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/Global.h"
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/microcom.h"
+#include "dxc/Support/MemoryTracking.h"
+
+#include <new>
+
+using namespace hlsl;
+
+bool MemoryTracker::WouldExceed(size_t size) const {
+  for (const MemoryTracker *p = this; p != nullptr; p = p->m_pParent) {
+    if (p->m_limitBytes != 0 && p->m_currentBytes + size > p->m_limitBytes)
+      return true;
+  }
+  return false;
+}
+
+bool MemoryTracker::Allocate(size_t size) {
+  if (WouldExceed(size)) {
+    for (MemoryTracker *p = this; p != nullptr; p = p->m_pParent) {
+      if (p->m_limitBytes != 0 && p->m_currentBytes + size > p->m_limitBytes)
+        p->m_limitExceeded = true;
+    }
+    return false;
+  }
+  for (MemoryTracker *p = this; p != nullptr; p = p->m_pParent) {
+    p->m_currentBytes += size;
+    p->m_totalBytes += size;
+    if (p->m_currentBytes > p->m_peakBytes)
+      p->m_peakBytes = p->m_currentBytes;
+  }
+  return true;
+}
+
+void MemoryTracker::Free(size_t size) {
+  for (MemoryTracker *p = this; p != nullptr; p = p->m_pParent)
+    p->m_currentBytes = size < p->m_currentBytes ? p->m_currentBytes - size : 0;
+}
+
+namespace {
+
+// Forwards to the COM task allocator, counting against the tracker current
+// on the calling thread. Blocks are sized with GetSize so that frees match
+// the allocations whatever the allocator rounds up to.
+class TrackingMalloc : public IMalloc {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  CComPtr<IMalloc> m_pMalloc;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  TrackingMalloc(IMalloc *pMalloc) : m_dwRef(0), m_pMalloc(pMalloc) {}
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IMalloc>(this, iid, ppvObject);
+  }
+
+  void *STDMETHODCALLTYPE Alloc(SIZE_T cb) override {
+    void *p = m_pMalloc->Alloc(cb);
+    MemoryTracker *pTracker = CurrentMemoryTracker();
+    if (p != nullptr && pTracker != nullptr &&
+        !pTracker->Allocate(m_pMalloc->GetSize(p))) {
+      m_pMalloc->Free(p);
+      return nullptr;
+    }
+    return p;
+  }
+
+  void *STDMETHODCALLTYPE Realloc(void *pv, SIZE_T cb) override {
+    MemoryTracker *pTracker = CurrentMemoryTracker();
+    if (pTracker == nullptr)
+      return m_pMalloc->Realloc(pv, cb);
+    // Count the growth up front so that it can be refused, then settle on
+    // the size the block ends up with.
+    SIZE_T oldSize = pv != nullptr ? m_pMalloc->GetSize(pv) : 0;
+    SIZE_T growth = cb > oldSize ? cb - oldSize : 0;
+    if (growth != 0 && !pTracker->Allocate(growth))
+      return nullptr;
+    void *p = m_pMalloc->Realloc(pv, cb);
+    SIZE_T counted = oldSize + growth;
+    SIZE_T newSize;
+    if (p != nullptr)
+      newSize = m_pMalloc->GetSize(p);
+    else
+      newSize = cb == 0 ? 0 : oldSize; // Freed, or failed and unchanged.
+    if (newSize > counted)
+      pTracker->Allocate(newSize - counted);
+    else
+      pTracker->Free(counted - newSize);
+    return p;
+  }
+
+  void STDMETHODCALLTYPE Free(void *pv) override {
+    MemoryTracker *pTracker = CurrentMemoryTracker();
+    if (pv != nullptr && pTracker != nullptr)
+      pTracker->Free(m_pMalloc->GetSize(pv));
+    m_pMalloc->Free(pv);
+  }
+
+  SIZE_T STDMETHODCALLTYPE GetSize(void *pv) override {
+    return m_pMalloc->GetSize(pv);
+  }
+
+  int STDMETHODCALLTYPE DidAlloc(void *pv) override {
+    return m_pMalloc->DidAlloc(pv);
+  }
+
+  void STDMETHODCALLTYPE HeapMinimize() override { m_pMalloc->HeapMinimize(); }
+};
+
+} // namespace
+
+HRESULT hlsl::DxcGetOperationMalloc(IMalloc **ppMalloc) {
+  CComPtr<IMalloc> pMalloc;
+  IFR(CoGetMalloc(1, &pMalloc));
+  if (CurrentMemoryTracker() == nullptr) {
+    *ppMalloc = pMalloc.Detach();
+    return S_OK;
+  }
+  TrackingMalloc *pTracking = new (std::nothrow) TrackingMalloc(pMalloc);
+  if (pTracking == nullptr)
+    return E_OUTOFMEMORY;
+  pTracking->AddRef();
+  *ppMalloc = pTracking;
+  return S_OK;
+}
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TimeReport.cpp                                                            //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements the phase timing recorder used by -ftime-report.               //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/TimeReport.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <psapi.h>
+
+using namespace hlsl;
+
+static uint64_t GetThreadCpuTime100ns() {
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime,
+                      &kernelTime, &userTime))
+    return 0;
+  ULARGE_INTEGER kernel, user;
+  kernel.LowPart = kernelTime.dwLowDateTime;
+  kernel.HighPart = kernelTime.dwHighDateTime;
+  user.LowPart = userTime.dwLowDateTime;
+  user.HighPart = userTime.dwHighDateTime;
+  return kernel.QuadPart + user.QuadPart;
+}
+
+static uint64_t GetPeakWorkingSetBytes() {
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize;
+}
+
+static void WriteJsonString(llvm::raw_ostream &OS, llvm::StringRef value) {
+  OS << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      OS << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      OS << ' ';
+    else
+      OS << c;
+  }
+  OS << '"';
+}
+
+TimeReportTracer::TimeReportTracer(PhaseTracer *pNext)
+    : m_pNext(pNext), m_start(Clock::now()) {}
+
+void TimeReportTracer::BeginPhase(const char *pName) {
+  if (m_pNext != nullptr)
+    m_pNext->BeginPhase(pName);
+  OpenPhase phase = { pName, Clock::now(), GetThreadCpuTime100ns() };
+  m_open.push_back(phase);
+}
+
+void TimeReportTracer::EndPhase(const char *pName) {
+  if (!m_open.empty()) {
+    const OpenPhase &phase = m_open.back();
+    std::chrono::duration<double, std::milli> wall = Clock::now() - phase.WallStart;
+    double cpuMs = (GetThreadCpuTime100ns() - phase.CpuStart100ns) / 10000.0;
+    auto inserted = m_totals.insert(std::make_pair(
+        llvm::StringRef(phase.Name), PhaseTotals{(unsigned)m_totals.size(), 0, 0, 0}));
+    PhaseTotals &totals = inserted.first->second;
+    ++totals.Count;
+    totals.WallMs += wall.count();
+    totals.CpuMs += cpuMs;
+    m_open.pop_back();
+  }
+  if (m_pNext != nullptr)
+    m_pNext->EndPhase(pName);
+}
+
+void TimeReportTracer::AddCount(const char *pName, uint64_t value) {
+  if (m_pNext != nullptr)
+    m_pNext->AddCount(pName, value);
+  // Few distinct counters are expected, so a linear search suffices.
+  for (auto &count : m_counts) {
+    if (llvm::StringRef(count.first) == pName) {
+      count.second += value;
+      return;
+    }
+  }
+  m_counts.push_back(std::make_pair(pName, value));
+}
+
+void TimeReportTracer::WriteJson(llvm::raw_ostream &OS) const {
+  std::vector<const llvm::StringMapEntry<PhaseTotals> *> entries;
+  for (const auto &entry : m_totals)
+    entries.push_back(&entry);
+  std::sort(entries.begin(), entries.end(),
+            [](const llvm::StringMapEntry<PhaseTotals> *a,
+               const llvm::StringMapEntry<PhaseTotals> *b) {
+              return a->second.Index < b->second.Index;
+            });
+
+  std::chrono::duration<double, std::milli> total = Clock::now() - m_start;
+  OS << "{\n  \"totalWallMs\": " << total.count()
+     << ",\n  \"peakWorkingSetBytes\": " << GetPeakWorkingSetBytes()
+     << ",\n  \"phases\": [";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const PhaseTotals &totals = entries[i]->second;
+    OS << (i ? ",\n" : "\n") << "    { \"name\": ";
+    WriteJsonString(OS, entries[i]->getKey());
+    OS << ", \"count\": " << totals.Count << ", \"wallMs\": " << totals.WallMs
+       << ", \"cpuMs\": " << totals.CpuMs << " }";
+  }
+  OS << "\n  ],\n  \"counters\": [";
+  for (size_t i = 0; i < m_counts.size(); ++i) {
+    OS << (i ? ",\n" : "\n") << "    { \"name\": ";
+    WriteJsonString(OS, m_counts[i].first);
+    OS << ", \"value\": " << m_counts[i].second << " }";
+  }
+  OS << "\n  ]\n}\n";
+}
@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// TraceArchive.cpp                                                          //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements the formats of recorded and of packaged compile calls.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/Global.h"
+#include "dxc/Support/Unicode.h"
+#include "dxc/Support/TraceArchive.h"
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+using namespace hlsl;
+
+// A trace file is the magic and version followed by the fields of the call
+// in declaration order. Integers are little-endian; strings and byte arrays
+// are a 32-bit length followed by the bytes, with wide strings as UTF-8;
+// lists are a 32-bit count followed by the elements.
+static const char TraceMagic[8] = { 'D', 'X', 'C', 'T', 'R', 'A', 'C', 'E' };
+static const UINT32 TraceVersion = 1;
+
+// A package is the magic and version followed by the fields of the call
+// from the source name to the source, as in a trace. Then come the distinct
+// contents of the included files, as a list of byte arrays, and the list of
+// includes, each its name and the index of its contents.
+static const char PackageMagic[8] = { 'D', 'X', 'C', 'P', 'A', 'C', 'K', 'G' };
+static const UINT32 PackageVersion = 1;
+
+namespace {
+
+class TraceWriter {
+public:
+  explicit TraceWriter(std::string &out) : m_out(out) {}
+
+  void WriteU32(UINT32 value) { WriteRaw(&value, sizeof(value)); }
+  void WriteU64(UINT64 value) { WriteRaw(&value, sizeof(value)); }
+  void WriteBytes(const std::string &bytes) {
+    WriteU32((UINT32)bytes.size());
+    WriteRaw(bytes.data(), bytes.size());
+  }
+  void WriteWide(const std::wstring &text) {
+    std::string utf8;
+    IFTBOOL(Unicode::UTF16ToUTF8String(text.c_str(), &utf8),
+            DXC_E_STRING_ENCODING_FAILED);
+    WriteBytes(utf8);
+  }
+  void WriteRaw(const void *pData, size_t size) {
+    m_out.append((const char *)pData, size);
+  }
+
+private:
+  std::string &m_out;
+};
+
+class TraceReader {
+public:
+  TraceReader(const void *pData, size_t size)
+      : m_pCursor((const char *)pData), m_pEnd((const char *)pData + size) {}
+
+  bool ReadU32(UINT32 &value) { return ReadRaw(&value, sizeof(value)); }
+  bool ReadU64(UINT64 &value) { return ReadRaw(&value, sizeof(value)); }
+  // Reads the count of a list, each element of which takes at least four
+  // bytes, so that a corrupt count cannot allocate more than the data.
+  bool ReadCount(UINT32 &count) {
+    return ReadU32(count) && (size_t)(m_pEnd - m_pCursor) / 4 >= count;
+  }
+  bool ReadBytes(std::string &bytes) {
+    UINT32 size;
+    if (!ReadU32(size) || (size_t)(m_pEnd - m_pCursor) < size)
+      return false;
+    bytes.assign(m_pCursor, size);
+    m_pCursor += size;
+    return true;
+  }
+  bool ReadWide(std::wstring &text) {
+    std::string utf8;
+    return ReadBytes(utf8) &&
+           Unicode::UTF8ToUTF16String(utf8.data(), utf8.size(), &text);
+  }
+  bool ReadRaw(void *pData, size_t size) {
+    if ((size_t)(m_pEnd - m_pCursor) < size)
+      return false;
+    memcpy(pData, m_pCursor, size);
+    m_pCursor += size;
+    return true;
+  }
+  bool AtEnd() const { return m_pCursor == m_pEnd; }
+
+private:
+  const char *m_pCursor;
+  const char *m_pEnd;
+};
+
+// Writes the fields shared by traces and packages, from the source name to
+// the source.
+void WriteRequest(TraceWriter &W, const TraceCall &call) {
+  W.WriteU32(call.HasSourceName ? 1 : 0);
+  W.WriteWide(call.SourceName);
+  W.WriteWide(call.EntryPoint);
+  W.WriteWide(call.TargetProfile);
+  W.WriteU32((UINT32)call.Arguments.size());
+  for (const std::wstring &arg : call.Arguments)
+    W.WriteWide(arg);
+  W.WriteU32((UINT32)call.Defines.size());
+  for (const TraceCall::Define &define : call.Defines) {
+    W.WriteWide(define.Name);
+    W.WriteU32(define.HasValue ? 1 : 0);
+    W.WriteWide(define.Value);
+  }
+  W.WriteBytes(call.Source);
+}
+
+bool ReadRequest(TraceReader &R, TraceCall &call) {
+  UINT32 flag, count;
+  if (!R.ReadU32(flag) || !R.ReadWide(call.SourceName) ||
+      !R.ReadWide(call.EntryPoint) || !R.ReadWide(call.TargetProfile))
+    return false;
+  call.HasSourceName = flag != 0;
+
+  if (!R.ReadCount(count))
+    return false;
+  call.Arguments.resize(count);
+  for (std::wstring &arg : call.Arguments) {
+    if (!R.ReadWide(arg))
+      return false;
+  }
+  if (!R.ReadCount(count))
+    return false;
+  call.Defines.resize(count);
+  for (TraceCall::Define &define : call.Defines) {
+    if (!R.ReadWide(define.Name) || !R.ReadU32(flag) ||
+        !R.ReadWide(define.Value))
+      return false;
+    define.HasValue = flag != 0;
+  }
+  return R.ReadBytes(call.Source);
+}
+
+} // namespace
+
+void hlsl::SerializeTraceCall(const TraceCall &call, std::string &out) {
+  TraceWriter W(out);
+  W.WriteRaw(TraceMagic, sizeof(TraceMagic));
+  W.WriteU32(TraceVersion);
+  W.WriteU64(call.StartTime);
+  W.WriteU64(call.DurationUs);
+  W.WriteU32((UINT32)call.Status);
+  WriteRequest(W, call);
+  W.WriteU32((UINT32)call.Includes.size());
+  for (const TraceCall::Include &include : call.Includes) {
+    W.WriteWide(include.Name);
+    W.WriteBytes(include.Contents);
+  }
+}
+
+bool hlsl::DeserializeTraceCall(const void *pData, size_t size,
+                                TraceCall &call) {
+  TraceReader R(pData, size);
+  char magic[sizeof(TraceMagic)];
+  UINT32 version, status, count;
+  if (!R.ReadRaw(magic, sizeof(magic)) ||
+      memcmp(magic, TraceMagic, sizeof(magic)) != 0 || !R.ReadU32(version) ||
+      version != TraceVersion)
+    return false;
+  if (!R.ReadU64(call.StartTime) || !R.ReadU64(call.DurationUs) ||
+      !R.ReadU32(status) || !ReadRequest(R, call))
+    return false;
+  call.Status = (HRESULT)status;
+
+  if (!R.ReadCount(count))
+    return false;
+  call.Includes.resize(count);
+  for (TraceCall::Include &include : call.Includes) {
+    if (!R.ReadWide(include.Name) || !R.ReadBytes(include.Contents))
+      return false;
+  }
+  return R.AtEnd();
+}
+
+void hlsl::SerializeCompilePackage(const TraceCall &call, std::string &out) {
+  // Contents are looked up by their hash, then compared, so that a header
+  // reached under several names is stored once.
+  std::unordered_multimap<size_t, UINT32> indexByHash;
+  std::vector<const std::string *> contents;
+  std::vector<UINT32> indices;
+  indices.reserve(call.Includes.size());
+  for (const TraceCall::Include &include : call.Includes) {
+    size_t hash = std::hash<std::string>()(include.Contents);
+    UINT32 index = (UINT32)contents.size();
+    auto range = indexByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (*contents[it->second] == include.Contents) {
+        index = it->second;
+        break;
+      }
+    }
+    if (index == contents.size()) {
+      contents.push_back(&include.Contents);
+      indexByHash.emplace(hash, index);
+    }
+    indices.push_back(index);
+  }
+
+  TraceWriter W(out);
+  W.WriteRaw(PackageMagic, sizeof(PackageMagic));
+  W.WriteU32(PackageVersion);
+  WriteRequest(W, call);
+  W.WriteU32((UINT32)contents.size());
+  for (const std::string *pContents : contents)
+    W.WriteBytes(*pContents);
+  W.WriteU32((UINT32)call.Includes.size());
+  for (size_t i = 0; i < call.Includes.size(); ++i) {
+    W.WriteWide(call.Includes[i].Name);
+    W.WriteU32(indices[i]);
+  }
+}
+
+bool hlsl::DeserializeCompilePackage(const void *pData, size_t size,
+                                     TraceCall &call) {
+  TraceReader R(pData, size);
+  char magic[sizeof(PackageMagic)];
+  UINT32 version, count;
+  if (!R.ReadRaw(magic, sizeof(magic)) ||
+      memcmp(magic, PackageMagic, sizeof(magic)) != 0 ||
+      !R.ReadU32(version) || version != PackageVersion ||
+      !ReadRequest(R, call))
+    return false;
+
+  if (!R.ReadCount(count))
+    return false;
+  std::vector<std::string> contents(count);
+  for (std::string &bytes : contents) {
+    if (!R.ReadBytes(bytes))
+      return false;
+  }
+  if (!R.ReadCount(count))
+    return false;
+  call.Includes.resize(count);
+  for (TraceCall::Include &include : call.Includes) {
+    UINT32 index;
+    if (!R.ReadWide(include.Name) || !R.ReadU32(index) ||
+        index >= contents.size())
+      return false;
+    include.Contents = contents[index];
+  }
+  return R.AtEnd();
+}
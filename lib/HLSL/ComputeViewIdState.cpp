@@ -50,6 +50,10 @@ const DxilViewIdState::InputsContributingToOutputType &DxilViewIdState::getInput
 const DxilViewIdState::InputsContributingToOutputType &DxilViewIdState::getPCInputsContributingToOutputs() const                { return m_PCInputsContributingToOutputs; }
 
 void DxilViewIdState::Compute() {
+  Compute(nullptr);
+}
+
+void DxilViewIdState::Compute(const ControlDependenceGetter &GetCtrlDep) {
   Clear();
 
   const ShaderModel *pSM = m_pModule->GetShaderModel();
@@ -71,9 +75,9 @@ void DxilViewIdState::Compute() {
   }
 
   // 3. Determine shape components that are dynamically accesses and collect all sig outputs.
-  AnalyzeFunctions(m_Entry);
+  AnalyzeFunctions(m_Entry, GetCtrlDep);
   if (m_PCEntry.pEntryFunc) {
-    AnalyzeFunctions(m_PCEntry);
+    AnalyzeFunctions(m_PCEntry, GetCtrlDep);
   }
 
   // 4. Collect sets of values contributing to outputs.
@@ -263,13 +267,17 @@ static bool GetUnsignedVal(Value *V, uint32_t *pValue) {
   return true;
 }
 
-void DxilViewIdState::AnalyzeFunctions(EntryInfo &Entry) {
+void DxilViewIdState::AnalyzeFunctions(EntryInfo &Entry,
+                                       const ControlDependenceGetter &GetCtrlDep) {
   for (auto *F : Entry.Functions) {
     DXASSERT_NOMSG(!F->empty());
 
     auto itFI = m_FuncInfo.find(F);
     FuncInfo *pFuncInfo = nullptr;
-    if (itFI != m_FuncInfo.end()) {
+    // Functions reachable from both the main and the patch constant entry
+    // have their dominator relations already.
+    bool bNewFuncInfo = itFI == m_FuncInfo.end();
+    if (!bNewFuncInfo) {
       pFuncInfo = itFI->second.get();
     } else {
       m_FuncInfo[F] = make_unique<FuncInfo>();
@@ -340,6 +348,9 @@ void DxilViewIdState::AnalyzeFunctions(EntryInfo &Entry) {
       }
     }
 
+    if (!bNewFuncInfo)
+      continue;
+
     // Compute dominator relation.
     pFuncInfo->pDomTree = make_unique<DominatorTreeBase<BasicBlock> >(false);
     pFuncInfo->pDomTree->recalculate(*F);
@@ -347,14 +358,18 @@ void DxilViewIdState::AnalyzeFunctions(EntryInfo &Entry) {
     pFuncInfo->pDomTree->print(dbgs());
 #endif
 
-    // Compute postdominator relation.
-    DominatorTreeBase<BasicBlock> PDR(true);
-    PDR.recalculate(*F);
+    // Compute control dependence, from the postdominator relation unless the
+    // caller has it already.
+    if (GetCtrlDep) {
+      pFuncInfo->CtrlDep = GetCtrlDep(*F);
+    } else {
+      DominatorTreeBase<BasicBlock> PDR(true);
+      PDR.recalculate(*F);
 #if DXILVIEWID_DBG
-    PDR.print(dbgs());
+      PDR.print(dbgs());
 #endif
-    // Compute control dependence.
-    pFuncInfo->CtrlDep.Compute(F, PDR);
+      pFuncInfo->CtrlDep.Compute(F, PDR);
+    }
 #if DXILVIEWID_DBG
     pFuncInfo->CtrlDep.print(dbgs());
 #endif
@@ -403,11 +418,11 @@ void DxilViewIdState::CollectValuesContributingToOutputs(EntryInfo &Entry) {
       // Scalar or indexable with known index.
       unsigned index = GetLinearIndex(SigElem, startRow, col);
       InstructionSetType &ContributingInstructions = Entry.ContributingInstructions[StreamId][index];
-      CollectValuesContributingToOutputRec(Entry, pContributingValue, ContributingInstructions);
+      CollectValuesContributingToOutput(Entry, pContributingValue, ContributingInstructions);
     } else {
       // Dynamically indexed output.
       InstructionSetType ContributingInstructions;
-      CollectValuesContributingToOutputRec(Entry, pContributingValue, ContributingInstructions);
+      CollectValuesContributingToOutput(Entry, pContributingValue, ContributingInstructions);
 
       for (int row = startRow; row <= endRow; row++) {
         unsigned index = GetLinearIndex(SigElem, row, col);
@@ -417,72 +432,77 @@ void DxilViewIdState::CollectValuesContributingToOutputs(EntryInfo &Entry) {
   }
 }
 
-void DxilViewIdState::CollectValuesContributingToOutputRec(EntryInfo &Entry,
-                                                           Value *pContributingValue,
-                                                           InstructionSetType &ContributingInstructions) {
-  if (Argument *pArg = dyn_cast<Argument>(pContributingValue)) {
-    // This must be a leftover signature argument of an entry function.
-    DXASSERT_NOMSG(Entry.pEntryFunc == m_pModule->GetEntryFunction() ||
-                   Entry.pEntryFunc == m_pModule->GetPatchConstantFunction());
-    return;
-  }
-
-  Instruction *pContributingInst = dyn_cast<Instruction>(pContributingValue);
-  if (pContributingInst == nullptr) {
-    // Can be literal constant, global decl, branch target.
-    DXASSERT_NOMSG(isa<Constant>(pContributingValue) || isa<BasicBlock>(pContributingValue));
-    return;
-  }
+void DxilViewIdState::CollectValuesContributingToOutput(EntryInfo &Entry,
+                                                        Value *pContributingValue,
+                                                        InstructionSetType &ContributingInstructions) {
+  // Walk with an explicit worklist; contributing chains in large shaders are
+  // too deep to follow recursively.
+  std::vector<Value *> Worklist;
+  Worklist.emplace_back(pContributingValue);
+
+  while (!Worklist.empty()) {
+    Value *pValue = Worklist.back();
+    Worklist.pop_back();
+
+    if (Argument *pArg = dyn_cast<Argument>(pValue)) {
+      // This must be a leftover signature argument of an entry function.
+      DXASSERT_NOMSG(Entry.pEntryFunc == m_pModule->GetEntryFunction() ||
+                     Entry.pEntryFunc == m_pModule->GetPatchConstantFunction());
+      continue;
+    }
 
-  auto itInst = ContributingInstructions.emplace(pContributingInst);
-  // Already visited instruction.
-  if (!itInst.second) return;
+    Instruction *pContributingInst = dyn_cast<Instruction>(pValue);
+    if (pContributingInst == nullptr) {
+      // Can be literal constant, global decl, branch target.
+      DXASSERT_NOMSG(isa<Constant>(pValue) || isa<BasicBlock>(pValue));
+      continue;
+    }
 
-  // Handle special cases.
-  if (PHINode *phi = dyn_cast<PHINode>(pContributingInst)) {
-    CollectPhiCFValuesContributingToOutputRec(phi, Entry, ContributingInstructions);
-  } else if (isa<LoadInst>(pContributingInst) || 
-             isa<AtomicCmpXchgInst>(pContributingInst) ||
-             isa<AtomicRMWInst>(pContributingInst)) {
-    Value *pPtrValue = pContributingInst->getOperand(0);
-    DXASSERT_NOMSG(pPtrValue->getType()->isPointerTy());
-    const ValueSetType &ReachingDecls = CollectReachingDecls(pPtrValue);
-    DXASSERT_NOMSG(ReachingDecls.size() > 0);
-    for (Value *pDeclValue : ReachingDecls) {
-      const ValueSetType &Stores = CollectStores(pDeclValue);
-      for (Value *V : Stores) {
-        CollectValuesContributingToOutputRec(Entry, V, ContributingInstructions);
+    auto itInst = ContributingInstructions.emplace(pContributingInst);
+    // Already visited instruction.
+    if (!itInst.second) continue;
+
+    // Handle special cases.
+    if (PHINode *phi = dyn_cast<PHINode>(pContributingInst)) {
+      CollectPhiCFValuesContributingToOutput(phi, Entry, Worklist);
+    } else if (isa<LoadInst>(pContributingInst) || 
+               isa<AtomicCmpXchgInst>(pContributingInst) ||
+               isa<AtomicRMWInst>(pContributingInst)) {
+      Value *pPtrValue = pContributingInst->getOperand(0);
+      DXASSERT_NOMSG(pPtrValue->getType()->isPointerTy());
+      const ValueSetType &ReachingDecls = CollectReachingDecls(pPtrValue);
+      DXASSERT_NOMSG(ReachingDecls.size() > 0);
+      for (Value *pDeclValue : ReachingDecls) {
+        const ValueSetType &Stores = CollectStores(pDeclValue);
+        Worklist.insert(Worklist.end(), Stores.begin(), Stores.end());
       }
-    }
-  } else if (CallInst *CI = dyn_cast<CallInst>(pContributingInst)) {
-    if (!hlsl::OP::IsDxilOpFuncCallInst(CI)) {
-      Function *F = CI->getCalledFunction();
-      if (!F->empty()) {
-        // Return value of a user function.
-        if (Entry.Functions.find(F) != Entry.Functions.end()) {
-          const FuncInfo &FI = *m_FuncInfo[F];
-          for (ReturnInst *pRetInst : FI.Returns) {
-            CollectValuesContributingToOutputRec(Entry, pRetInst, ContributingInstructions);
+    } else if (CallInst *CI = dyn_cast<CallInst>(pContributingInst)) {
+      if (!hlsl::OP::IsDxilOpFuncCallInst(CI)) {
+        Function *F = CI->getCalledFunction();
+        if (!F->empty()) {
+          // Return value of a user function.
+          if (Entry.Functions.find(F) != Entry.Functions.end()) {
+            const FuncInfo &FI = *m_FuncInfo[F];
+            Worklist.insert(Worklist.end(), FI.Returns.begin(), FI.Returns.end());
           }
         }
       }
     }
-  }
 
-  // Handle instruction inputs.
-  unsigned NumOps = pContributingInst->getNumOperands();
-  for (unsigned i = 0; i < NumOps; i++) {
-    Value *O = pContributingInst->getOperand(i);
-    CollectValuesContributingToOutputRec(Entry, O, ContributingInstructions);
-  }
+    // Handle instruction inputs.
+    unsigned NumOps = pContributingInst->getNumOperands();
+    for (unsigned i = 0; i < NumOps; i++) {
+      Worklist.emplace_back(pContributingInst->getOperand(i));
+    }
 
-  // Handle control dependence of this instruction BB.
-  BasicBlock *pBB = pContributingInst->getParent();
-  Function *F = pBB->getParent();
-  FuncInfo *pFuncInfo = m_FuncInfo[F].get();
-  const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
-  for (BasicBlock *B : CtrlDepSet) {
-    CollectValuesContributingToOutputRec(Entry, B->getTerminator(), ContributingInstructions);
+    // Handle control dependence of this instruction BB.
+    BasicBlock *pBB = pContributingInst->getParent();
+    Function *F = pBB->getParent();
+    FuncInfo *pFuncInfo = m_FuncInfo[F].get();
+    const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
+    for (BasicBlock *B : CtrlDepSet) {
+      Worklist.emplace_back(B->getTerminator());
+    }
   }
 }
 
@@ -491,9 +511,9 @@ void DxilViewIdState::CollectValuesContributingToOutputRec(EntryInfo &Entry,
 // However, this may be too conservative and, as such, pick up extra control dependent BBs.
 // A better "definition" point is the highest dominator where it is still legal to "insert" constant assignment.
 // In this context, "legal" means that only one value "leaves" the dominator and reaches Phi.
-void DxilViewIdState::CollectPhiCFValuesContributingToOutputRec(PHINode *pPhi,
-                                                                EntryInfo &Entry,
-                                                                InstructionSetType &ContributingInstructions) {
+void DxilViewIdState::CollectPhiCFValuesContributingToOutput(PHINode *pPhi,
+                                                             EntryInfo &Entry,
+                                                             std::vector<Value *> &Worklist) {
   Function *F = pPhi->getParent()->getParent();
   FuncInfo *pFuncInfo = m_FuncInfo[F].get();
   unordered_map<DomTreeNodeBase<BasicBlock> *, Value *> DomTreeMarkers;
@@ -568,97 +588,98 @@ void DxilViewIdState::CollectPhiCFValuesContributingToOutputRec(PHINode *pPhi,
     pBB = pDefDomNode->getBlock();
     const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
     for (BasicBlock *B : CtrlDepSet) {
-      CollectValuesContributingToOutputRec(Entry, B->getTerminator(), ContributingInstructions);
+      Worklist.emplace_back(B->getTerminator());
     }
   }
 }
 
 const DxilViewIdState::ValueSetType &DxilViewIdState::CollectReachingDecls(Value *pValue) {
   auto it = m_ReachingDeclsCache.emplace(pValue, ValueSetType());
-  if (it.second) {
-    // We have not seen this value before.
-    ValueSetType Visited;
-    CollectReachingDeclsRec(pValue, it.first->second, Visited);
-  }
-  return it.first->second;
-}
-
-void DxilViewIdState::CollectReachingDeclsRec(Value *pValue, ValueSetType &ReachingDecls, ValueSetType &Visited) {
-  if (Visited.find(pValue) != Visited.end())
-    return;
-
-  bool bInitialValue = Visited.size() == 0;
+  if (!it.second)
+    return it.first->second;
+
+  // We have not seen this value before.
+  ValueSetType &ReachingDecls = it.first->second;
+  ValueSetType Visited;
+  std::vector<Value *> Worklist;
+  Worklist.emplace_back(pValue);
   Visited.emplace(pValue);
 
-  if (!bInitialValue) {
-    auto it = m_ReachingDeclsCache.find(pValue);
-    if (it != m_ReachingDeclsCache.end()) {
-      ReachingDecls.insert(it->second.begin(), it->second.end());
-      return;
-    }
-  }
+  while (!Worklist.empty()) {
+    Value *V = Worklist.back();
+    Worklist.pop_back();
 
-  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(pValue)) {
-    ReachingDecls.emplace(pValue);
-    return;
-  }
+    if (V != pValue) {
+      auto itCached = m_ReachingDeclsCache.find(V);
+      if (itCached != m_ReachingDeclsCache.end()) {
+        ReachingDecls.insert(itCached->second.begin(), itCached->second.end());
+        continue;
+      }
+    }
 
-  if (GetElementPtrInst *pGepInst = dyn_cast<GetElementPtrInst>(pValue)) {
-    Value *pPtrValue = pGepInst->getPointerOperand();
-    CollectReachingDeclsRec(pPtrValue, ReachingDecls, Visited);
-  } else if (GEPOperator *pGepOp = dyn_cast<GEPOperator>(pValue)) {
-    Value *pPtrValue = pGepOp->getPointerOperand();
-    CollectReachingDeclsRec(pPtrValue, ReachingDecls, Visited);
-  } else if (AllocaInst *AI = dyn_cast<AllocaInst>(pValue)) {
-    ReachingDecls.emplace(pValue);
-  } else if (PHINode *phi = dyn_cast<PHINode>(pValue)) {
-    for (Value *pPtrValue : phi->operands()) {
-      CollectReachingDeclsRec(pPtrValue, ReachingDecls, Visited);
+    auto AddPtr = [&](Value *pPtrValue) {
+      if (Visited.emplace(pPtrValue).second)
+        Worklist.emplace_back(pPtrValue);
+    };
+
+    if (isa<GlobalVariable>(V) || isa<AllocaInst>(V) || isa<Argument>(V)) {
+      ReachingDecls.emplace(V);
+    } else if (GetElementPtrInst *pGepInst = dyn_cast<GetElementPtrInst>(V)) {
+      AddPtr(pGepInst->getPointerOperand());
+    } else if (GEPOperator *pGepOp = dyn_cast<GEPOperator>(V)) {
+      AddPtr(pGepOp->getPointerOperand());
+    } else if (PHINode *phi = dyn_cast<PHINode>(V)) {
+      for (Value *pPtrValue : phi->operands()) {
+        AddPtr(pPtrValue);
+      }
+    } else {
+      IFT(DXC_E_GENERAL_INTERNAL_ERROR);
     }
-  } else if (Argument *pArg = dyn_cast<Argument>(pValue)) {
-    ReachingDecls.emplace(pValue);
-  } else {
-    IFT(DXC_E_GENERAL_INTERNAL_ERROR);
   }
+
+  return ReachingDecls;
 }
 
 const DxilViewIdState::ValueSetType &DxilViewIdState::CollectStores(llvm::Value *pValue) {
   auto it = m_StoresPerDeclCache.emplace(pValue, ValueSetType());
-  if (it.second) {
-    // We have not seen this value before.
-    ValueSetType Visited;
-    CollectStoresRec(pValue, it.first->second, Visited);
-  }
-  return it.first->second;
-}
+  if (!it.second)
+    return it.first->second;
+
+  // We have not seen this value before.
+  ValueSetType &Stores = it.first->second;
+  ValueSetType Visited;
+  std::vector<Value *> Worklist;
+  Worklist.emplace_back(pValue);
+  Visited.emplace(pValue);
 
-void DxilViewIdState::CollectStoresRec(llvm::Value *pValue, ValueSetType &Stores, ValueSetType &Visited) {
-  if (Visited.find(pValue) != Visited.end())
-    return;
+  while (!Worklist.empty()) {
+    Value *V = Worklist.back();
+    Worklist.pop_back();
 
-  bool bInitialValue = Visited.size() == 0;
-  Visited.emplace(pValue);
+    if (V != pValue) {
+      auto itCached = m_StoresPerDeclCache.find(V);
+      if (itCached != m_StoresPerDeclCache.end()) {
+        Stores.insert(itCached->second.begin(), itCached->second.end());
+        continue;
+      }
+    }
 
-  if (!bInitialValue) {
-    auto it = m_StoresPerDeclCache.find(pValue);
-    if (it != m_StoresPerDeclCache.end()) {
-      Stores.insert(it->second.begin(), it->second.end());
-      return;
+    if (isa<LoadInst>(V)) {
+      continue;
+    } else if (isa<StoreInst>(V) ||
+               isa<AtomicCmpXchgInst>(V) ||
+               isa<AtomicRMWInst>(V)) {
+      Stores.emplace(V);
+      continue;
     }
-  }
 
-  if (isa<LoadInst>(pValue)) {
-    return;
-  } else if (isa<StoreInst>(pValue) ||
-             isa<AtomicCmpXchgInst>(pValue) ||
-             isa<AtomicRMWInst>(pValue)) {
-    Stores.emplace(pValue);
-    return;
+    for (auto *U : V->users()) {
+      if (Visited.emplace(U).second)
+        Worklist.emplace_back(U);
+    }
   }
 
-  for (auto *U : pValue->users()) {
-    CollectStoresRec(U, Stores, Visited);
-  }
+  return Stores;
 }
 
 void DxilViewIdState::CreateViewIdSets(const std::unordered_map<unsigned, InstructionSetType> &ContributingInstructions, 
@@ -991,6 +1012,7 @@ char ComputeViewIdState::ID = 0;
 
 INITIALIZE_PASS_BEGIN(ComputeViewIdState, "viewid-state",
                 "Compute information related to ViewID", true, true)
+INITIALIZE_PASS_DEPENDENCY(ControlDependenceWrapperPass)
 INITIALIZE_PASS_END(ComputeViewIdState, "viewid-state",
                 "Compute information related to ViewID", true, true)
 
@@ -1002,13 +1024,16 @@ bool ComputeViewIdState::runOnModule(Module &M) {
   const ShaderModel *pSM = DxilModule.GetShaderModel();
   if (!pSM->IsCS() && !pSM->IsLib()) {
     DxilViewIdState &ViewIdState = DxilModule.GetViewIdState();
-    ViewIdState.Compute();
+    ViewIdState.Compute([this](Function &F) -> const ControlDependence & {
+      return getAnalysis<ControlDependenceWrapperPass>(F).getControlDependence();
+    });
     return true;
   }
   return false;
 }
 
 void ComputeViewIdState::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<ControlDependenceWrapperPass>();
   AU.setPreservesAll();
 }
 
@@ -9,6 +9,7 @@
 
 #include "dxc/HLSL/ControlDependence.h"
 #include "dxc/Support/Global.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/Support/Debug.h"
 
 using namespace llvm;
@@ -23,7 +24,9 @@ const BasicBlockSet &ControlDependence::GetCDBlocks(BasicBlock *pBB) const {
     return m_EmptyBBSet;
 }
 
-void ControlDependence::print(raw_ostream &OS) {
+void ControlDependence::print(raw_ostream &OS) const {
+  if (!m_pFunc)
+    return;
   OS << "Control dependence for function '" << m_pFunc->getName() << "'\n";
   for (auto &it : m_ControlDependence) {
     BasicBlock *pBB = it.first;
@@ -119,3 +122,34 @@ void ControlDependence::ComputeRevTopOrderRec(PostDomRelationType &PostDomRel,
 
   RevTopOrder.emplace_back(pBB);
 }
+
+char ControlDependenceWrapperPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(ControlDependenceWrapperPass, "hlsl-control-dependence",
+                      "HLSL Control Dependence Construction", true, true)
+INITIALIZE_PASS_DEPENDENCY(PostDominatorTree)
+INITIALIZE_PASS_END(ControlDependenceWrapperPass, "hlsl-control-dependence",
+                    "HLSL Control Dependence Construction", true, true)
+
+ControlDependenceWrapperPass::ControlDependenceWrapperPass()
+    : FunctionPass(ID) {}
+
+bool ControlDependenceWrapperPass::runOnFunction(Function &F) {
+  CtrlDep.Clear();
+  CtrlDep.Compute(&F, *getAnalysis<PostDominatorTree>().DT);
+  return false;
+}
+
+void ControlDependenceWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<PostDominatorTree>();
+  AU.setPreservesAll();
+}
+
+void ControlDependenceWrapperPass::releaseMemory() {
+  CtrlDep.Clear();
+}
+
+void ControlDependenceWrapperPass::print(raw_ostream &OS,
+                                         const Module *) const {
+  CtrlDep.print(OS);
+}
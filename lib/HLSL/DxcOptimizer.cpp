@@ -20,7 +20,10 @@
 #include "dxc/HLSL/HLMatrixLowerPass.h"
 #include "dxc/HLSL/DxilGenerationPass.h"
 #include "dxc/HLSL/ComputeViewIdState.h"
+#include "dxc/HLSL/ControlDependence.h"
 #include "dxc/Support/dxcapi.impl.h"
+#include "dxc/Support/TimeReport.h"
+#include "dxc/HLSL/PassStatistics.h"
 
 #include "llvm/Pass.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -34,8 +37,10 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/Analysis/CFGPrinter.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include <algorithm>
+#include <chrono>
 #include <list>   // should change this for string_table
 #include <vector>
 
@@ -76,25 +81,44 @@ HRESULT SetupRegistryPassForHLSL() {
     initializeCFLAliasAnalysisPass(Registry);
     initializeComputeViewIdStatePass(Registry);
     initializeConstantMergePass(Registry);
+    initializeControlDependenceWrapperPassPass(Registry);
     initializeCorrelatedValuePropagationPass(Registry);
     initializeDAEPass(Registry);
     initializeDAHPass(Registry);
     initializeDCEPass(Registry);
     initializeDSEPass(Registry);
     initializeDeadInstEliminationPass(Registry);
+    initializeDxilApplyBlockProfilePass(Registry);
+    initializeDxilCoalesceCBufferLoadsPass(Registry);
+    initializeDxilCombineBufferAccessesPass(Registry);
     initializeDxilCondenseResourcesPass(Registry);
+    initializeDxilConstantTablesPass(Registry);
+    initializeDxilDynamicIndexToSelectPass(Registry);
     initializeDxilEliminateOutputDynamicIndexingPass(Registry);
     initializeDxilEmitMetadataPass(Registry);
     initializeDxilExpandTrigIntrinsicsPass(Registry);
     initializeDxilGenerationPassPass(Registry);
+    initializeDxilHoistSamplesPass(Registry);
+    initializeDxilInsertBlockCountersPass(Registry);
+    initializeDxilInsertProfileRegionsPass(Registry);
     initializeDxilLegalizeEvalOperationsPass(Registry);
     initializeDxilLegalizeResourceUsePassPass(Registry);
     initializeDxilLegalizeSampleOffsetPassPass(Registry);
     initializeDxilLegalizeStaticResourceUsePassPass(Registry);
     initializeDxilLoadMetadataPass(Registry);
+    initializeDxilLoadToGatherPass(Registry);
+    initializeDxilMapCountersToLinesPass(Registry);
+    initializeDxilNonUniformHandlesPass(Registry);
     initializeDxilOutputColorBecomesConstantPass(Registry);
+    initializeDxilPairHalfOpsPass(Registry);
     initializeDxilPrecisePropagatePassPass(Registry);
     initializeDxilPreserveAllOutputsPass(Registry);
+    initializeDxilPruneUnreadOutputsPass(Registry);
+    initializeDxilShaderStatsPass(Registry);
+    initializeDxilSimplifyBeforeInlinePass(Registry);
+    initializeDxilSimplifyWaveOpsPass(Registry);
+    initializeDxilTGSMBankConflictsPass(Registry);
+    initializeDxilUniformityStatsPass(Registry);
     initializeDynamicIndexingVectorToArrayPass(Registry);
     initializeEarlyCSELegacyPassPass(Registry);
     initializeEliminateAvailableExternallyPass(Registry);
@@ -168,8 +192,17 @@ static ArrayRef<LPCSTR> GetPassArgNames(LPCSTR passName) {
   static const LPCSTR AlwaysInlinerArgs[] = { "InsertLifetime", "InlineThreshold" };
   static const LPCSTR ArgPromotionArgs[] = { "maxElements" };
   static const LPCSTR CFGSimplifyPassArgs[] = { "Threshold", "Ftor", "bonus-inst-threshold" };
+  static const LPCSTR DxilApplyBlockProfileArgs[] = { "profile", "cold-percent" };
+  static const LPCSTR DxilConstantTablesArgs[] = { "max-elements" };
+  static const LPCSTR DxilDynamicIndexToSelectArgs[] = { "max-elements" };
+  static const LPCSTR DxilExpandTrigIntrinsicsArgs[] = { "approximate" };
   static const LPCSTR DxilGenerationPassArgs[] = { "NotOptimized" };
+  static const LPCSTR DxilInsertBlockCountersArgs[] = { "uav-space", "uav-register", "per-line" };
+  static const LPCSTR DxilInsertProfileRegionsArgs[] = { "uav-space", "uav-register" };
+  static const LPCSTR DxilMapCountersToLinesArgs[] = { "counts" };
   static const LPCSTR DxilOutputColorBecomesConstantArgs[] = { "mod-mode", "constant-red", "constant-green", "constant-blue", "constant-alpha" };
+  static const LPCSTR DxilPruneUnreadOutputsArgs[] = { "consumer-inputs", "rt-mask", "depth-write-disabled" };
+  static const LPCSTR DxilTGSMBankConflictsArgs[] = { "banks", "lanes" };
   static const LPCSTR DynamicIndexingVectorToArrayArgs[] = { "ReplaceAllVectors" };
   static const LPCSTR Float2IntArgs[] = { "float2int-max-integer-bw" };
   static const LPCSTR GVNArgs[] = { "noloads", "enable-pre", "enable-load-pre", "max-recurse-depth" };
@@ -178,7 +211,7 @@ static ArrayRef<LPCSTR> GetPassArgNames(LPCSTR passName) {
   static const LPCSTR LoopDistributeArgs[] = { "loop-distribute-verify", "loop-distribute-non-if-convertible" };
   static const LPCSTR LoopRerollArgs[] = { "max-reroll-increment", "reroll-num-tolerated-failed-matches" };
   static const LPCSTR LoopRotateArgs[] = { "MaxHeaderSize", "rotation-max-header-size" };
-  static const LPCSTR LoopUnrollArgs[] = { "Threshold", "Count", "AllowPartial", "Runtime", "unroll-threshold", "unroll-percent-dynamic-cost-saved-threshold", "unroll-dynamic-cost-savings-discount", "unroll-max-iteration-count-to-analyze", "unroll-count", "unroll-allow-partial", "unroll-runtime", "pragma-unroll-threshold" };
+  static const LPCSTR LoopUnrollArgs[] = { "Threshold", "Count", "AllowPartial", "Runtime", "ReportHintFailures", "unroll-threshold", "unroll-percent-dynamic-cost-saved-threshold", "unroll-dynamic-cost-savings-discount", "unroll-max-iteration-count-to-analyze", "unroll-count", "unroll-allow-partial", "unroll-runtime", "pragma-unroll-threshold", "hlsl-unroll-fetch-bonus", "hlsl-unroll-constant-index-threshold" };
   static const LPCSTR LoopUnswitchArgs[] = { "Os", "loop-unswitch-threshold" };
   static const LPCSTR LowerBitSetsArgs[] = { "lowerbitsets-avoid-reuse" };
   static const LPCSTR LowerExpectIntrinsicArgs[] = { "likely-branch-weight", "unlikely-branch-weight" };
@@ -198,8 +231,17 @@ static ArrayRef<LPCSTR> GetPassArgNames(LPCSTR passName) {
   if (strcmp(passName, "always-inline") == 0) return ArrayRef<LPCSTR>(AlwaysInlinerArgs, _countof(AlwaysInlinerArgs));
   if (strcmp(passName, "argpromotion") == 0) return ArrayRef<LPCSTR>(ArgPromotionArgs, _countof(ArgPromotionArgs));
   if (strcmp(passName, "simplifycfg") == 0) return ArrayRef<LPCSTR>(CFGSimplifyPassArgs, _countof(CFGSimplifyPassArgs));
+  if (strcmp(passName, "hlsl-dxil-apply-block-profile") == 0) return ArrayRef<LPCSTR>(DxilApplyBlockProfileArgs, _countof(DxilApplyBlockProfileArgs));
+  if (strcmp(passName, "hlsl-dxil-constant-tables") == 0) return ArrayRef<LPCSTR>(DxilConstantTablesArgs, _countof(DxilConstantTablesArgs));
+  if (strcmp(passName, "hlsl-dxil-dynamic-index-to-select") == 0) return ArrayRef<LPCSTR>(DxilDynamicIndexToSelectArgs, _countof(DxilDynamicIndexToSelectArgs));
+  if (strcmp(passName, "hlsl-dxil-expand-trig-intrinsics") == 0) return ArrayRef<LPCSTR>(DxilExpandTrigIntrinsicsArgs, _countof(DxilExpandTrigIntrinsicsArgs));
   if (strcmp(passName, "dxilgen") == 0) return ArrayRef<LPCSTR>(DxilGenerationPassArgs, _countof(DxilGenerationPassArgs));
+  if (strcmp(passName, "hlsl-dxil-insert-block-counters") == 0) return ArrayRef<LPCSTR>(DxilInsertBlockCountersArgs, _countof(DxilInsertBlockCountersArgs));
+  if (strcmp(passName, "hlsl-dxil-insert-profile-regions") == 0) return ArrayRef<LPCSTR>(DxilInsertProfileRegionsArgs, _countof(DxilInsertProfileRegionsArgs));
+  if (strcmp(passName, "hlsl-dxil-map-counters-to-lines") == 0) return ArrayRef<LPCSTR>(DxilMapCountersToLinesArgs, _countof(DxilMapCountersToLinesArgs));
   if (strcmp(passName, "hlsl-dxil-constantColor") == 0) return ArrayRef<LPCSTR>(DxilOutputColorBecomesConstantArgs, _countof(DxilOutputColorBecomesConstantArgs));
+  if (strcmp(passName, "hlsl-dxil-prune-unread-outputs") == 0) return ArrayRef<LPCSTR>(DxilPruneUnreadOutputsArgs, _countof(DxilPruneUnreadOutputsArgs));
+  if (strcmp(passName, "hlsl-dxil-tgsm-bank-conflicts") == 0) return ArrayRef<LPCSTR>(DxilTGSMBankConflictsArgs, _countof(DxilTGSMBankConflictsArgs));
   if (strcmp(passName, "dynamic-vector-to-array") == 0) return ArrayRef<LPCSTR>(DynamicIndexingVectorToArrayArgs, _countof(DynamicIndexingVectorToArrayArgs));
   if (strcmp(passName, "float2int") == 0) return ArrayRef<LPCSTR>(Float2IntArgs, _countof(Float2IntArgs));
   if (strcmp(passName, "gvn") == 0) return ArrayRef<LPCSTR>(GVNArgs, _countof(GVNArgs));
@@ -235,8 +277,17 @@ static ArrayRef<LPCSTR> GetPassArgDescriptions(LPCSTR passName) {
   static const LPCSTR AlwaysInlinerArgs[] = { "Insert @llvm.lifetime intrinsics", "Insert @llvm.lifetime intrinsics" };
   static const LPCSTR ArgPromotionArgs[] = { "None" };
   static const LPCSTR CFGSimplifyPassArgs[] = { "None", "None", "Control the number of bonus instructions (default = 1)" };
+  static const LPCSTR DxilApplyBlockProfileArgs[] = { "Block counts, as function:block:count entries separated by ';'", "Branches whose rarer side runs less than this percentage of the time are marked [branch]" };
+  static const LPCSTR DxilConstantTablesArgs[] = { "Largest dynamically indexed constant table, in elements, to rewrite into selects" };
+  static const LPCSTR DxilDynamicIndexToSelectArgs[] = { "Largest array, in elements, to rewrite into selects" };
+  static const LPCSTR DxilExpandTrigIntrinsicsArgs[] = { "Use cheaper, less accurate expansions for non-precise calls" };
   static const LPCSTR DxilGenerationPassArgs[] = { "None" };
+  static const LPCSTR DxilInsertBlockCountersArgs[] = { "Register space of the counter buffer", "Register of the counter buffer", "Also count each run of instructions on a new source line" };
+  static const LPCSTR DxilInsertProfileRegionsArgs[] = { "Register space of the region timing buffer", "Register of the region timing buffer" };
+  static const LPCSTR DxilMapCountersToLinesArgs[] = { "Values of the counter buffer, in order, separated by ';'" };
   static const LPCSTR DxilOutputColorBecomesConstantArgs[] = { "None", "None", "None", "None", "None" };
+  static const LPCSTR DxilPruneUnreadOutputsArgs[] = { "Semantics read by the next stage, separated by '+'", "Render targets bound to a pixel shader, one bit per SV_Target index", "Remove the depth output of a pixel shader" };
+  static const LPCSTR DxilTGSMBankConflictsArgs[] = { "Number of groupshared memory banks", "Number of threads that access groupshared memory together" };
   static const LPCSTR DynamicIndexingVectorToArrayArgs[] = { "None" };
   static const LPCSTR Float2IntArgs[] = { "Max integer bitwidth to consider in float2int" };
   static const LPCSTR GVNArgs[] = { "None", "None", "None", "Max recurse depth" };
@@ -245,7 +296,7 @@ static ArrayRef<LPCSTR> GetPassArgDescriptions(LPCSTR passName) {
   static const LPCSTR LoopDistributeArgs[] = { "Turn on DominatorTree and LoopInfo verification after Loop Distribution", "Whether to distribute into a loop that may not be if-convertible by the loop vectorizer" };
   static const LPCSTR LoopRerollArgs[] = { "The maximum increment for loop rerolling", "The maximum number of failures to tolerate during fuzzy matching." };
   static const LPCSTR LoopRotateArgs[] = { "None", "The default maximum header size for automatic loop rotation" };
-  static const LPCSTR LoopUnrollArgs[] = { "None", "None", "None", "None", "The baseline cost threshold for loop unrolling", "The percentage of estimated dynamic cost which must be saved by unrolling to allow unrolling up to the max threshold.", "This is the amount discounted from the total unroll cost when the unrolled form has a high dynamic cost savings (triggered by the '-unroll-perecent-dynamic-cost-saved-threshold' flag).", "Don't allow loop unrolling to simulate more than this number of iterations when checking full unroll profitability", "Use this unroll count for all loops including those with unroll_count pragma values, for testing purposes", "Allows loops to be partially unrolled until -unroll-threshold loop size is reached.", "Unroll loops with run-time trip counts", "Unrolled size limit for loops with an unroll(full) or unroll_count pragma." };
+  static const LPCSTR LoopUnrollArgs[] = { "None", "None", "None", "None", "Warn when a loop with an unroll attribute cannot be unrolled as directed", "The baseline cost threshold for loop unrolling", "The percentage of estimated dynamic cost which must be saved by unrolling to allow unrolling up to the max threshold.", "This is the amount discounted from the total unroll cost when the unrolled form has a high dynamic cost savings (triggered by the '-unroll-perecent-dynamic-cost-saved-threshold' flag).", "Don't allow loop unrolling to simulate more than this number of iterations when checking full unroll profitability", "Use this unroll count for all loops including those with unroll_count pragma values, for testing purposes", "Allows loops to be partially unrolled until -unroll-threshold loop size is reached.", "Unroll loops with run-time trip counts", "Unrolled size limit for loops with an unroll(full) or unroll_count pragma.", "Amount the full unroll threshold grows by for each texture or buffer read executed by the loop.", "Full unroll threshold for loops whose resource and cbuffer indices become constant when unrolled; also caps the fetch bonus." };
   static const LPCSTR LoopUnswitchArgs[] = { "Optimize for size", "Max loop size to unswitch" };
   static const LPCSTR LowerBitSetsArgs[] = { "Try to avoid reuse of byte array addresses using aliases" };
   static const LPCSTR LowerExpectIntrinsicArgs[] = { "Weight of the branch likely to be taken (default = 64)", "Weight of the branch unlikely to be taken (default = 4)" };
@@ -265,8 +316,17 @@ static ArrayRef<LPCSTR> GetPassArgDescriptions(LPCSTR passName) {
   if (strcmp(passName, "always-inline") == 0) return ArrayRef<LPCSTR>(AlwaysInlinerArgs, _countof(AlwaysInlinerArgs));
   if (strcmp(passName, "argpromotion") == 0) return ArrayRef<LPCSTR>(ArgPromotionArgs, _countof(ArgPromotionArgs));
   if (strcmp(passName, "simplifycfg") == 0) return ArrayRef<LPCSTR>(CFGSimplifyPassArgs, _countof(CFGSimplifyPassArgs));
+  if (strcmp(passName, "hlsl-dxil-apply-block-profile") == 0) return ArrayRef<LPCSTR>(DxilApplyBlockProfileArgs, _countof(DxilApplyBlockProfileArgs));
+  if (strcmp(passName, "hlsl-dxil-constant-tables") == 0) return ArrayRef<LPCSTR>(DxilConstantTablesArgs, _countof(DxilConstantTablesArgs));
+  if (strcmp(passName, "hlsl-dxil-dynamic-index-to-select") == 0) return ArrayRef<LPCSTR>(DxilDynamicIndexToSelectArgs, _countof(DxilDynamicIndexToSelectArgs));
+  if (strcmp(passName, "hlsl-dxil-expand-trig-intrinsics") == 0) return ArrayRef<LPCSTR>(DxilExpandTrigIntrinsicsArgs, _countof(DxilExpandTrigIntrinsicsArgs));
   if (strcmp(passName, "dxilgen") == 0) return ArrayRef<LPCSTR>(DxilGenerationPassArgs, _countof(DxilGenerationPassArgs));
+  if (strcmp(passName, "hlsl-dxil-insert-block-counters") == 0) return ArrayRef<LPCSTR>(DxilInsertBlockCountersArgs, _countof(DxilInsertBlockCountersArgs));
+  if (strcmp(passName, "hlsl-dxil-insert-profile-regions") == 0) return ArrayRef<LPCSTR>(DxilInsertProfileRegionsArgs, _countof(DxilInsertProfileRegionsArgs));
+  if (strcmp(passName, "hlsl-dxil-map-counters-to-lines") == 0) return ArrayRef<LPCSTR>(DxilMapCountersToLinesArgs, _countof(DxilMapCountersToLinesArgs));
   if (strcmp(passName, "hlsl-dxil-constantColor") == 0) return ArrayRef<LPCSTR>(DxilOutputColorBecomesConstantArgs, _countof(DxilOutputColorBecomesConstantArgs));
+  if (strcmp(passName, "hlsl-dxil-prune-unread-outputs") == 0) return ArrayRef<LPCSTR>(DxilPruneUnreadOutputsArgs, _countof(DxilPruneUnreadOutputsArgs));
+  if (strcmp(passName, "hlsl-dxil-tgsm-bank-conflicts") == 0) return ArrayRef<LPCSTR>(DxilTGSMBankConflictsArgs, _countof(DxilTGSMBankConflictsArgs));
   if (strcmp(passName, "dynamic-vector-to-array") == 0) return ArrayRef<LPCSTR>(DynamicIndexingVectorToArrayArgs, _countof(DynamicIndexingVectorToArrayArgs));
   if (strcmp(passName, "float2int") == 0) return ArrayRef<LPCSTR>(Float2IntArgs, _countof(Float2IntArgs));
   if (strcmp(passName, "gvn") == 0) return ArrayRef<LPCSTR>(GVNArgs, _countof(GVNArgs));
@@ -310,6 +370,7 @@ static bool IsPassOptionName(StringRef S) {
     ||  S.equals("NotOptimized")
     ||  S.equals("Os")
     ||  S.equals("ReplaceAllVectors")
+    ||  S.equals("ReportHintFailures")
     ||  S.equals("RequiresDomTree")
     ||  S.equals("Runtime")
     ||  S.equals("ScalarLoadThreshold")
@@ -317,11 +378,16 @@ static bool IsPassOptionName(StringRef S) {
     ||  S.equals("TIRA")
     ||  S.equals("TLIImpl")
     ||  S.equals("Threshold")
+    ||  S.equals("approximate")
+    ||  S.equals("banks")
     ||  S.equals("bonus-inst-threshold")
+    ||  S.equals("cold-percent")
     ||  S.equals("constant-alpha")
     ||  S.equals("constant-blue")
     ||  S.equals("constant-green")
     ||  S.equals("constant-red")
+    ||  S.equals("consumer-inputs")
+    ||  S.equals("depth-write-disabled")
     ||  S.equals("disable-licm-promotion")
     ||  S.equals("enable-load-pre")
     ||  S.equals("enable-pre")
@@ -329,12 +395,16 @@ static bool IsPassOptionName(StringRef S) {
     ||  S.equals("enable-tbaa")
     ||  S.equals("float2int-max-integer-bw")
     ||  S.equals("force-ssa-updater")
+    ||  S.equals("hlsl-unroll-constant-index-threshold")
+    ||  S.equals("hlsl-unroll-fetch-bonus")
     ||  S.equals("jump-threading-threshold")
+    ||  S.equals("lanes")
     ||  S.equals("likely-branch-weight")
     ||  S.equals("loop-distribute-non-if-convertible")
     ||  S.equals("loop-distribute-verify")
     ||  S.equals("loop-unswitch-threshold")
     ||  S.equals("lowerbitsets-avoid-reuse")
+    ||  S.equals("max-elements")
     ||  S.equals("max-recurse-depth")
     ||  S.equals("max-reroll-increment")
     ||  S.equals("maxElements")
@@ -343,13 +413,17 @@ static bool IsPassOptionName(StringRef S) {
     ||  S.equals("no-discriminators")
     ||  S.equals("noloads")
     ||  S.equals("pragma-unroll-threshold")
+    ||  S.equals("profile")
     ||  S.equals("reroll-num-tolerated-failed-matches")
     ||  S.equals("rewrite-map-file")
     ||  S.equals("rotation-max-header-size")
+    ||  S.equals("rt-mask")
     ||  S.equals("sample-profile-file")
     ||  S.equals("sample-profile-max-propagate-iterations")
     ||  S.equals("sroa-random-shuffle-slices")
     ||  S.equals("sroa-strict-inbounds")
+    ||  S.equals("uav-register")
+    ||  S.equals("uav-space")
     ||  S.equals("unlikely-branch-weight")
     ||  S.equals("unroll-allow-partial")
     ||  S.equals("unroll-count")
@@ -380,6 +454,78 @@ static HRESULT Utf8ToUtf16CoTaskMalloc(LPCSTR pValue, LPWSTR *ppResult) {
   return S_OK;
 }
 
+// Creates the pass for an option with the syntax
+//   '-' OPTION_NAME (',' ARG_NAME ('=' ARG_VALUE)?)*
+// where the leading '-' (or '/') may be left out unless RequireDash is set.
+// pOption is split in place.
+static HRESULT CreatePassFromOption(PassRegistry *registry, char *pOption,
+                                    bool RequireDash, raw_ostream &outStream,
+                                    const PassInfo **ppPassInfo,
+                                    Pass **ppPass) {
+  *ppPassInfo = nullptr;
+  *ppPass = nullptr;
+
+  const char ArgDelim = ',';
+  SmallVector<PassOption, 2> options;
+  char *pCursor = pOption;
+  const char *pEnd = pOption + strlen(pOption);
+  if (*pCursor == '-' || *pCursor == '/') {
+    ++pCursor;
+  }
+  else if (RequireDash) {
+    return E_INVALIDARG;
+  }
+  const char *pOptionNameStart = pCursor;
+  while (*pCursor && *pCursor != ArgDelim) {
+    ++pCursor;
+  }
+  *pCursor = '\0';
+  const llvm::PassInfo *PassInf = registry->getPassInfo(StringRef(pOptionNameStart));
+  if (!PassInf) {
+    return E_INVALIDARG;
+  }
+  while (pCursor < pEnd) {
+    // *pCursor is '\0' when we overwrite ',' to get a null-terminated string
+    if (*pCursor && *pCursor != ArgDelim) {
+      return E_INVALIDARG;
+    }
+    ++pCursor;
+    const char *pArgStart = pCursor;
+    while (*pCursor && *pCursor != ArgDelim) {
+      ++pCursor;
+    }
+    StringRef argString = StringRef(pArgStart, pCursor - pArgStart);
+    std::pair<StringRef, StringRef> nameValue = argString.split('=');
+    if (!IsPassOptionName(nameValue.first)) {
+      return E_INVALIDARG;
+    }
+
+    PassOption *OptionPos = std::lower_bound(options.begin(), options.end(), nameValue, PassOptionsCompare());
+    // If empty, remove if available; otherwise upsert.
+    if (nameValue.second.empty()) {
+      if (OptionPos != options.end() && OptionPos->first == nameValue.first) {
+        options.erase(OptionPos);
+      }
+    }
+    else {
+      if (OptionPos != options.end() && OptionPos->first == nameValue.first) {
+        OptionPos->second = nameValue.second;
+      }
+      else {
+        options.insert(OptionPos, nameValue);
+      }
+    }
+  }
+
+  DXASSERT(PassInf->getNormalCtor(), "else pass with no default .ctor was added");
+  Pass *pass = PassInf->getNormalCtor()();
+  pass->setOSOverride(&outStream);
+  pass->applyOptions(options);
+  *ppPassInfo = PassInf;
+  *ppPass = pass;
+  return S_OK;
+}
+
 class DxcOptimizerPass : public IDxcOptimizerPass {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
@@ -438,30 +584,256 @@ public:
   }
 };
 
-class DxcOptimizer : public IDxcOptimizer {
+// Records the time and instruction count between the passes of a pipeline.
+class PipelineProbe : public ModulePass {
+public:
+  typedef std::chrono::steady_clock Clock;
+  struct Sample {
+    Clock::time_point Begin;
+    Clock::time_point End;
+    uint64_t InstructionCount;
+  };
+
+  static char ID;
+  explicit PipelineProbe(std::vector<Sample> *pSamples)
+      : ModulePass(ID), m_pSamples(pSamples) {}
+
+  __override const char *getPassName() const { return "DXC Pipeline Probe"; }
+  __override void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+  }
+  __override bool runOnModule(Module &M) {
+    Sample sample;
+    sample.Begin = Clock::now();
+    sample.InstructionCount = 0;
+    for (Function &F : M)
+      for (BasicBlock &BB : F)
+        sample.InstructionCount += BB.size();
+    sample.End = Clock::now();
+    m_pSamples->push_back(sample);
+    return false;
+  }
+
+private:
+  std::vector<Sample> *m_pSamples;
+};
+
+char PipelineProbe::ID = 0;
+
+static bool IsPipelineDelim(char c) {
+  return c == ';' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Parses optimizer input: a DXIL container, bitcode or IR text. Bitcode,
+// including the program of a container, is read in place; with bLazy,
+// function bodies and their metadata are loaded when first needed, so the
+// blob must outlive the module. Text is copied to be null terminated.
+static std::unique_ptr<Module> ParseOptimizerInput(IDxcBlob *pBlob,
+                                                   LLVMContext &Context,
+                                                   bool bLazy) {
+  const char *pData = reinterpret_cast<const char *>(pBlob->GetBufferPointer());
+  uint32_t size = pBlob->GetBufferSize();
+  if (const DxilContainerHeader *pContainer = IsDxilContainerLike(pData, size)) {
+    if (!IsValidDxilContainer(pContainer, size))
+      return nullptr;
+    const DxilPartHeader *pPart = GetDxilPartByType(pContainer, DFCC_DXIL);
+    if (pPart == nullptr)
+      return nullptr;
+    const DxilProgramHeader *pProgram =
+        reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart));
+    if (!IsValidDxilProgramHeader(pProgram, pPart->PartSize))
+      return nullptr;
+    GetDxilProgramBitcode(pProgram, &pData, &size);
+  }
+
+  StringRef bufStrRef(pData, size);
+  if (!isBitcode(bufStrRef.bytes_begin(), bufStrRef.bytes_end())) {
+    std::unique_ptr<MemoryBuffer> memBuf =
+        MemoryBuffer::getMemBufferCopy(bufStrRef);
+    SMDiagnostic Err;
+    return parseIR(memBuf->getMemBufferRef(), Err, Context);
+  }
+
+  std::unique_ptr<MemoryBuffer> memBuf = MemoryBuffer::getMemBuffer(
+      bufStrRef, "", /*RequiresNullTerminator*/ false);
+  ErrorOr<std::unique_ptr<Module>> M =
+      bLazy ? getLazyBitcodeModule(std::move(memBuf), Context, nullptr,
+                                   /*ShouldLazyLoadMetadata*/ true)
+            : parseBitcodeFile(memBuf->getMemBufferRef(), Context);
+  if (!M)
+    return nullptr;
+  return std::move(M.get());
+}
+
+class DxcOptimizerModule : public IDxcOptimizerModule {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  PassRegistry *m_registry;
+  LLVMContext m_context; // Declared before the module to outlive it.
+  std::unique_ptr<Module> m_pModule;
+  double m_parseMs;
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcOptimizerModule>(this, iid, ppvObject);
+  }
+
+  DxcOptimizerModule(PassRegistry *registry)
+      : m_dwRef(0), m_registry(registry), m_parseMs(0) {}
+  HRESULT Initialize(IDxcBlob *pBlob);
+
+  __override HRESULT STDMETHODCALLTYPE RunPipeline(
+    _In_z_ LPCWSTR pPipeline,
+    _COM_Outptr_opt_ IDxcBlob **ppOutputModule,
+    _COM_Outptr_opt_ IDxcBlobEncoding **ppReport);
+};
+
+HRESULT DxcOptimizerModule::Initialize(IDxcBlob *pBlob) {
+  PipelineProbe::Clock::time_point parseStart = PipelineProbe::Clock::now();
+
+  // The module outlives the blob, so it is loaded in full.
+  m_pModule = ParseOptimizerInput(pBlob, m_context, /*bLazy*/ false);
+  if (!m_pModule) {
+    return E_INVALIDARG;
+  }
+
+  std::chrono::duration<double, std::milli> parseMs =
+      PipelineProbe::Clock::now() - parseStart;
+  m_parseMs = parseMs.count();
+  return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE DxcOptimizerModule::RunPipeline(
+    _In_z_ LPCWSTR pPipeline, _COM_Outptr_opt_ IDxcBlob **ppOutputModule,
+    _COM_Outptr_opt_ IDxcBlobEncoding **ppReport) {
+  AssignToOutOpt(nullptr, ppOutputModule);
+  AssignToOutOpt(nullptr, ppReport);
+  if (pPipeline == nullptr)
+    return E_POINTER;
+
+  try {
+    CComPtr<IMalloc> pMalloc;
+    CComPtr<AbstractMemoryStream> pOutputStream;
+    CComPtr<IDxcBlob> pOutputBlob;
+
+    IFT(CoGetMalloc(1, &pMalloc));
+    IFT(CreateMemoryStream(pMalloc, &pOutputStream));
+    IFT(pOutputStream.QueryInterface(&pOutputBlob));
+
+    raw_stream_ostream outStream(pOutputStream.p);
+
+    PipelineProbe::Clock::time_point cloneStart = PipelineProbe::Clock::now();
+    std::unique_ptr<Module> M(CloneModule(m_pModule.get()));
+    std::chrono::duration<double, std::milli> cloneMs =
+        PipelineProbe::Clock::now() - cloneStart;
+
+    // A probe runs before the first pass and after each pass; the probes
+    // preserve all analyses, so they only split the timing.
+    std::vector<PipelineProbe::Sample> samples;
+    std::vector<const PassInfo *> passInfos;
+    legacy::PassManager passes;
+    passes.add(new PipelineProbe(&samples));
+
+    CW2A pipeline(pPipeline, CP_UTF8);
+    char *pCursor = pipeline.m_psz;
+    for (;;) {
+      while (*pCursor && IsPipelineDelim(*pCursor)) {
+        ++pCursor;
+      }
+      if (!*pCursor) {
+        break;
+      }
+      char *pEntry = pCursor;
+      while (*pCursor && !IsPipelineDelim(*pCursor)) {
+        ++pCursor;
+      }
+      if (*pCursor) {
+        *pCursor++ = '\0';
+      }
+
+      const PassInfo *PassInf;
+      Pass *pass;
+      IFT(CreatePassFromOption(m_registry, pEntry, /*RequireDash*/ false,
+                               outStream, &PassInf, &pass));
+      passes.add(pass);
+      passes.add(new PipelineProbe(&samples));
+      passInfos.push_back(PassInf);
+    }
+    passes.add(createVerifierPass());
+
+    {
+      raw_ostream *err_ostream = &outStream;
+      ScopedFatalErrorHandler errHandler(FatalErrorHandlerStreamWrite, err_ostream);
+      passes.run(*M.get());
+    }
+    DXASSERT(samples.size() == passInfos.size() + 1, "else a probe did not run");
+
+    std::chrono::duration<double, std::milli> pipelineMs =
+        samples.back().Begin - samples.front().End;
+    outStream << "{\n  \"parseMs\": " << m_parseMs
+              << ",\n  \"cloneMs\": " << cloneMs.count()
+              << ",\n  \"pipelineWallMs\": " << pipelineMs.count()
+              << ",\n  \"initialInstructions\": "
+              << samples.front().InstructionCount << ",\n  \"passes\": [";
+    for (size_t i = 0; i < passInfos.size(); ++i) {
+      std::chrono::duration<double, std::milli> wall =
+          samples[i + 1].Begin - samples[i].End;
+      int64_t delta = (int64_t)samples[i + 1].InstructionCount -
+                      (int64_t)samples[i].InstructionCount;
+      outStream << (i ? ",\n" : "\n") << "    { \"name\": \""
+                << passInfos[i]->getPassArgument()
+                << "\", \"wallMs\": " << wall.count()
+                << ", \"instructions\": " << samples[i + 1].InstructionCount
+                << ", \"delta\": " << delta << " }";
+    }
+    outStream << (passInfos.empty() ? "" : "\n  ") << "]\n}\n";
+
+    outStream.flush();
+    if (ppReport != nullptr) {
+      IFT(DxcCreateBlobWithEncodingSet(pOutputBlob, CP_UTF8, ppReport));
+    }
+    if (ppOutputModule != nullptr) {
+      CComPtr<AbstractMemoryStream> pProgramStream;
+      IFT(CreateMemoryStream(pMalloc, &pProgramStream));
+      {
+        raw_stream_ostream outStream(pProgramStream.p);
+        WriteBitcodeToFile(M.get(), outStream, true);
+      }
+      IFT(pProgramStream.QueryInterface(ppOutputModule));
+    }
+  }
+  CATCH_CPP_RETURN_HRESULT();
+
+  return S_OK;
+}
+
+class DxcOptimizer : public IDxcOptimizer2 {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
   PassRegistry *m_registry;
-  std::vector<const PassInfo *> m_passes;
+  const std::vector<const PassInfo *> *m_pPasses;
 public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcOptimizer>(this, iid, ppvObject);
+    return DoBasicQueryInterface<IDxcOptimizer, IDxcOptimizer2>(this, iid, ppvObject);
   }
 
-  DxcOptimizer() : m_dwRef(0) { }
+  DxcOptimizer() : m_dwRef(0), m_pPasses(nullptr) { }
   HRESULT Initialize();
   const PassInfo *getPassByID(llvm::AnalysisID PassID);
   const PassInfo *getPassByName(const char *pName);
   __override HRESULT STDMETHODCALLTYPE GetAvailablePassCount(_Out_ UINT32 *pCount) {
-    return AssignToOut<UINT32>(m_passes.size(), pCount);
+    return AssignToOut<UINT32>(m_pPasses->size(), pCount);
   }
   __override HRESULT STDMETHODCALLTYPE GetAvailablePass(UINT32 index, _COM_Outptr_ IDxcOptimizerPass** ppResult);
   __override HRESULT STDMETHODCALLTYPE RunOptimizer(IDxcBlob *pBlob,
     _In_count_(optionCount) LPCWSTR *ppOptions, UINT32 optionCount,
     _COM_Outptr_ IDxcBlob **ppOutputModule,
     _COM_Outptr_opt_ IDxcBlobEncoding **ppOutputText);
+  __override HRESULT STDMETHODCALLTYPE ParseModule(
+    _In_ IDxcBlob *pBlob, _COM_Outptr_ IDxcOptimizerModule **ppModule);
 };
 
 class CapturePassManager : public llvm::legacy::PassManagerBase {
@@ -485,20 +857,29 @@ public:
   }
 };
 
-HRESULT DxcOptimizer::Initialize() {
-  try {
-    m_registry = PassRegistry::getPassRegistry();
-
+// Every pass is registered when the library is loaded, so the list of
+// available passes is enumerated once and shared by all optimizers instead
+// of being built again for each compilation that creates one.
+static const std::vector<const PassInfo *> &GetAvailablePasses() {
+  static const std::vector<const PassInfo *> passes = [] {
     struct PRL : public PassRegistrationListener {
-      std::vector<const PassInfo *> *Passes;
+      std::vector<const PassInfo *> Passes;
       __override void passEnumerate(const PassInfo * PI) {
         DXASSERT(nullptr != PI->getNormalCtor(), "else cannot construct");
-        Passes->push_back(PI);
+        Passes.push_back(PI);
       }
     };
     PRL prl;
-    prl.Passes = &this->m_passes;
-    m_registry->enumerateWith(&prl);
+    PassRegistry::getPassRegistry()->enumerateWith(&prl);
+    return std::move(prl.Passes);
+  }();
+  return passes;
+}
+
+HRESULT DxcOptimizer::Initialize() {
+  try {
+    m_registry = PassRegistry::getPassRegistry();
+    m_pPasses = &GetAvailablePasses();
   }
   CATCH_CPP_RETURN_HRESULT();
   return S_OK;
@@ -515,12 +896,13 @@ const PassInfo *DxcOptimizer::getPassByName(const char *pName) {
 HRESULT STDMETHODCALLTYPE DxcOptimizer::GetAvailablePass(
     UINT32 index, _COM_Outptr_ IDxcOptimizerPass **ppResult) {
   IFR(AssignToOut(nullptr, ppResult));
-  if (index >= m_passes.size())
+  if (index >= m_pPasses->size())
     return E_INVALIDARG;
+  const PassInfo *PI = (*m_pPasses)[index];
   return DxcOptimizerPass::Create(
-      m_passes[index]->getPassArgument(), m_passes[index]->getPassName(),
-      GetPassArgNames(m_passes[index]->getPassArgument()),
-      GetPassArgDescriptions(m_passes[index]->getPassArgument()), ppResult);
+      PI->getPassArgument(), PI->getPassName(),
+      GetPassArgNames(PI->getPassArgument()),
+      GetPassArgDescriptions(PI->getPassArgument()), ppResult);
 }
 
 HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
@@ -534,20 +916,10 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
   if (optionCount > 0 && ppOptions == nullptr)
     return E_POINTER;
 
-  // Setup input buffer.
-  // The ir parsing requires the buffer to be null terminated. We deal with
-  // both source and bitcode input, so the input buffer may not be null
-  // terminated.
-  // Create a new membuf that copies the buffer and adds a null terminator.
-  StringRef bufStrRef(reinterpret_cast<const char *>(pBlob->GetBufferPointer()),
-                      pBlob->GetBufferSize());
-  std::unique_ptr<MemoryBuffer> memBuf =
-      MemoryBuffer::getMemBufferCopy(bufStrRef);
-
-  // Parse IR
+  // Parse IR; bitcode is read from pBlob in place and loaded lazily.
   LLVMContext Context;
-  SMDiagnostic Err;
-  std::unique_ptr<Module> M = parseIR(memBuf->getMemBufferRef(), Err, Context);
+  std::unique_ptr<Module> M =
+      ParseOptimizerInput(pBlob, Context, /*bLazy*/ true);
   if (!M) {
     //Err.print(argv[0], errs());
     return E_INVALIDARG;
@@ -584,6 +956,8 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
     //
     bool OutputAssembly = false;
     bool AnalyzeOnly = false;
+    bool TimeReport = false;
+    bool PrintStats = false;
 
     // First gather flags, wherever they may be.
     SmallVector<UINT32, 2> handled;
@@ -598,11 +972,20 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
         handled.push_back(i);
         continue;
       }
+      if (wcseq(L"-ftime-report", ppOptions[i])) {
+        TimeReport = true;
+        handled.push_back(i);
+        continue;
+      }
+      if (wcseq(L"-print-stats", ppOptions[i])) {
+        PrintStats = true;
+        handled.push_back(i);
+        continue;
+      }
     }
 
     // TODO: should really use string_table for this once that's available
     std::list<std::string> optionsAnsi;
-    SmallVector<PassOption, 2> options;
     for (UINT32 i = 0; i < optionCount; ++i) {
       if (std::find(handled.begin(), handled.end(), i) != handled.end()) {
         continue;
@@ -636,62 +1019,10 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
       }
 
       CW2A optName(ppOptions[i], CP_UTF8);
-      // The option syntax is
-      const char ArgDelim = ',';
-      // '-' OPTION_NAME (',' ARG_NAME ('=' ARG_VALUE)?)*
-      char *pCursor = optName.m_psz;
-      const char *pEnd = optName.m_psz + strlen(optName.m_psz);
-      if (*pCursor != '-' && *pCursor != '/') {
-        return E_INVALIDARG;
-      }
-      ++pCursor;
-      const char *pOptionNameStart = pCursor;
-      while (*pCursor && *pCursor != ArgDelim) {
-        ++pCursor;
-      }
-      *pCursor = '\0';
-      const llvm::PassInfo *PassInf = getPassByName(pOptionNameStart);
-      if (!PassInf) {
-        return E_INVALIDARG;
-      }
-      while (pCursor < pEnd) {
-        // *pCursor is '\0' when we overwrite ',' to get a null-terminated string
-        if (*pCursor && *pCursor != ArgDelim) {
-          return E_INVALIDARG;
-        }
-        ++pCursor;
-        const char *pArgStart = pCursor;
-        while (*pCursor && *pCursor != ArgDelim) {
-          ++pCursor;
-        }
-        StringRef argString = StringRef(pArgStart, pCursor - pArgStart);
-        std::pair<StringRef, StringRef> nameValue = argString.split('=');
-        if (!IsPassOptionName(nameValue.first)) {
-          return E_INVALIDARG;
-        }
-
-        PassOption *OptionPos = std::lower_bound(options.begin(), options.end(), nameValue, PassOptionsCompare());
-        // If empty, remove if available; otherwise upsert.
-        if (nameValue.second.empty()) {
-          if (OptionPos != options.end() && OptionPos->first == nameValue.first) {
-            options.erase(OptionPos);
-          }
-        }
-        else {
-          if (OptionPos != options.end() && OptionPos->first == nameValue.first) {
-            OptionPos->second = nameValue.second;
-          }
-          else {
-            options.insert(OptionPos, nameValue);
-          }
-        }
-      }
-
-      DXASSERT(PassInf->getNormalCtor(), "else pass with no default .ctor was added");
-      Pass *pass = PassInf->getNormalCtor()();
-      pass->setOSOverride(&outStream);
-      pass->applyOptions(options);
-      options.clear();
+      const llvm::PassInfo *PassInf;
+      Pass *pass;
+      IFR(CreatePassFromOption(m_registry, optName.m_psz, /*RequireDash*/ true,
+                               outStream, &PassInf, &pass));
       pPassManager->add(pass);
       if (AnalyzeOnly) {
         const bool Quiet = false;
@@ -729,13 +1060,38 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
     {
       raw_ostream *err_ostream = &outStream;
       ScopedFatalErrorHandler errHandler(FatalErrorHandlerStreamWrite, err_ostream);
+      hlsl::TimeReportTracer timeReport(hlsl::CurrentPhaseTracer());
+      std::unique_ptr<hlsl::PhaseTracerScope> timeReportScope;
+      if (TimeReport)
+        timeReportScope.reset(new hlsl::PhaseTracerScope(&timeReport));
+      std::unique_ptr<hlsl::PassStatisticsRecorder> passStats;
+      std::unique_ptr<hlsl::PassObserverScope> passStatsScope;
+      if (PrintStats) {
+        passStats.reset(new hlsl::PassStatisticsRecorder());
+        passStatsScope.reset(new hlsl::PassObserverScope(passStats.get()));
+      }
 
+      // Each function is loaded as the function passes reach it; the module
+      // passes, the verifier and the bitcode writer need them all.
       FunctionPasses.doInitialization();
       for (Function &F : *M.get())
         if (!F.isDeclaration())
           FunctionPasses.run(F);
       FunctionPasses.doFinalization();
+      if (std::error_code EC = M->materializeAllPermanently())
+        report_fatal_error("Error reading bitcode file: " + EC.message());
       ModulePasses.run(*M.get());
+
+      if (TimeReport) {
+        timeReportScope.reset();
+        outStream << "TIME-REPORT\n";
+        timeReport.WriteJson(outStream);
+      }
+      if (PrintStats) {
+        passStatsScope.reset();
+        outStream << "PASS-STATS\n";
+        passStats->WriteJson(outStream);
+      }
     }
 
     outStream.flush();
@@ -757,6 +1113,26 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
   return S_OK;
 }
 
+HRESULT STDMETHODCALLTYPE DxcOptimizer::ParseModule(
+    _In_ IDxcBlob *pBlob, _COM_Outptr_ IDxcOptimizerModule **ppModule) {
+  if (ppModule == nullptr)
+    return E_POINTER;
+  *ppModule = nullptr;
+  if (pBlob == nullptr)
+    return E_POINTER;
+
+  try {
+    CComPtr<DxcOptimizerModule> result =
+        new (std::nothrow) DxcOptimizerModule(m_registry);
+    IFROOM(result.p);
+    IFR(result->Initialize(pBlob));
+    *ppModule = result.Detach();
+  }
+  CATCH_CPP_RETURN_HRESULT();
+
+  return S_OK;
+}
+
 HRESULT CreateDxcOptimizer(_In_ REFIID riid, _Out_ LPVOID *ppv) {
   CComPtr<DxcOptimizer> result = new (std::nothrow) DxcOptimizer();
   if (result == nullptr) {
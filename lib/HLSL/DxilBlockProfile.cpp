@@ -0,0 +1,501 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilBlockProfile.cpp                                                      //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides passes to count basic block executions into a UAV, to map the    //
+// collected counts back to source lines, and to feed them back into control //
+// flow hints on a recompile.                                                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilResource.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+// Block profiles are collected and applied at the same point of the pipeline,
+// right after DXIL generation, so a block is identified by its function and
+// its position in that function.
+//
+// The counters are 32-bit values in a raw buffer, one per block, with the
+// blocks of each function numbered in order and functions following each
+// other in module order. A profile is a list of entries, one per line or
+// separated by ';', each giving a function, a block index and a count,
+// separated by spaces or ':'. Lines starting with '#' are comments:
+//
+//   # function block count
+//   main 0 1024
+//   main 1 12
+//
+// With per-line, a block also gets a counter before each instruction that
+// starts a new source line. Every counter carries the debug location of the
+// instructions it counts, so that the counts of a buffer can be mapped back
+// to source lines however later passes move the code around.
+
+namespace {
+
+// The space counters are bound in by default, away from application spaces.
+static const unsigned kDefaultCounterSpace = 1000;
+static const char kCounterBufferName[] = "dx.block.counters";
+
+static std::string GetLocationString(const DebugLoc &DL) {
+  if (!DL)
+    return std::string();
+  return (DL->getFilename() + ":" + Twine(DL.getLine())).str();
+}
+
+static bool IsSameLine(const DebugLoc &A, const DebugLoc &B) {
+  return A.getLine() == B.getLine() && A->getFilename() == B->getFilename();
+}
+
+class DxilInsertBlockCounters : public ModulePass {
+  struct CounterRange {
+    std::string Function;
+    unsigned First;
+    unsigned Count;
+  };
+
+  unsigned m_UAVSpace = kDefaultCounterSpace;
+  unsigned m_UAVRegister = 0;
+  bool m_PerLine = false;
+  std::vector<CounterRange> m_Ranges;
+  std::vector<std::string> m_Locations;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilInsertBlockCounters() : ModulePass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL insert block counters";
+  }
+
+  void applyOptions(PassOptions O) override {
+    GetPassOptionUnsigned(O, "uav-space", &m_UAVSpace, m_UAVSpace);
+    GetPassOptionUnsigned(O, "uav-register", &m_UAVRegister, m_UAVRegister);
+    GetPassOptionBool(O, "per-line", &m_PerLine, m_PerLine);
+  }
+
+  bool runOnModule(Module &M) override;
+
+  // Prints the counters of each function, to map a dump of the buffer back
+  // to blocks, and the source location of each counter that has one.
+  void print(raw_ostream &OS, const Module *) const override {
+    OS << "Block counters in u" << m_UAVRegister << ", space " << m_UAVSpace
+       << "\n";
+    for (const CounterRange &Range : m_Ranges) {
+      OS << Range.Function << ": " << Range.Count << " counters from "
+         << Range.First << "\n";
+    }
+    for (unsigned i = 0, e = m_Locations.size(); i < e; ++i) {
+      if (!m_Locations[i].empty())
+        OS << "counter " << i << ": " << m_Locations[i] << "\n";
+    }
+  }
+};
+
+bool DxilInsertBlockCounters::runOnModule(Module &M) {
+  DxilModule &DM = M.GetOrCreateDxilModule();
+  // Library functions get their handles from the linker's bindings.
+  if (DM.GetShaderModel()->IsLib())
+    return false;
+
+  LLVMContext &Ctx = M.getContext();
+  OP *hlslOP = DM.GetOP();
+
+  StructType *BufferTy = M.getTypeByName("struct.RWByteAddressBuffer");
+  if (!BufferTy)
+    BufferTy = StructType::create({Type::getInt32Ty(Ctx)},
+                                  "struct.RWByteAddressBuffer");
+
+  std::unique_ptr<DxilResource> pCounters = llvm::make_unique<DxilResource>();
+  pCounters->SetRW(true);
+  pCounters->SetKind(DxilResourceBase::Kind::RawBuffer);
+  pCounters->SetGlobalSymbol(UndefValue::get(BufferTy->getPointerTo()));
+  pCounters->SetGlobalName(kCounterBufferName);
+  pCounters->SetSpaceID(m_UAVSpace);
+  pCounters->SetLowerBound(m_UAVRegister);
+  pCounters->SetRangeSize(1);
+  unsigned CountersID = DM.AddUAV(std::move(pCounters));
+  DM.GetUAV(CountersID).SetID(CountersID);
+
+  Function *CreateHandle =
+      hlslOP->GetOpFunc(OP::OpCode::CreateHandle, Type::getVoidTy(Ctx));
+  Function *AtomicBinOp =
+      hlslOP->GetOpFunc(OP::OpCode::AtomicBinOp, Type::getInt32Ty(Ctx));
+  Value *CreateHandleOpArg =
+      hlslOP->GetU32Const((unsigned)OP::OpCode::CreateHandle);
+  Value *AtomicBinOpArg =
+      hlslOP->GetU32Const((unsigned)OP::OpCode::AtomicBinOp);
+  Value *AddArg = hlslOP->GetU32Const((unsigned)DXIL::AtomicBinOpCode::Add);
+  Value *UndefI = UndefValue::get(Type::getInt32Ty(Ctx));
+  Value *One = hlslOP->GetU32Const(1);
+
+  unsigned Counter = 0;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+
+    // The index is relative to the range; resource allocation adds the
+    // lower bound.
+    IRBuilder<> Builder(F.getEntryBlock().getFirstInsertionPt());
+    Value *HandleArgs[] = {
+        CreateHandleOpArg,
+        hlslOP->GetI8Const((char)DXIL::ResourceClass::UAV),
+        hlslOP->GetU32Const(CountersID), hlslOP->GetU32Const(0),
+        hlslOP->GetI1Const(false)};
+    Instruction *Handle =
+        Builder.CreateCall(CreateHandle, HandleArgs, "block.counters");
+
+    unsigned First = Counter;
+    for (BasicBlock &BB : F) {
+      Instruction *Start = &BB == &F.getEntryBlock()
+                               ? Handle->getNextNode()
+                               : &*BB.getFirstInsertionPt();
+      // Each counter counts the instructions up to the next one and takes
+      // the location of the first of them that has one.
+      SmallVector<std::pair<Instruction *, DebugLoc>, 4> Points;
+      Points.push_back(std::make_pair(Start, DebugLoc()));
+      for (Instruction *I = Start; I; I = I->getNextNode()) {
+        const DebugLoc &DL = I->getDebugLoc();
+        if (!DL || DL.getLine() == 0)
+          continue;
+        DebugLoc &Current = Points.back().second;
+        if (!Current)
+          Current = DL;
+        else if (m_PerLine && !IsSameLine(DL, Current))
+          Points.push_back(std::make_pair(I, DL));
+      }
+
+      for (const auto &Point : Points) {
+        Builder.SetInsertPoint(Point.first);
+        Builder.SetCurrentDebugLocation(Point.second);
+        Value *Args[] = {AtomicBinOpArg, Handle, AddArg,
+                         hlslOP->GetU32Const(Counter * 4), UndefI, UndefI, One};
+        Builder.CreateCall(AtomicBinOp, Args);
+        m_Locations.push_back(GetLocationString(Point.second));
+        ++Counter;
+      }
+    }
+    m_Ranges.push_back({F.getName(), First, Counter - First});
+  }
+  return true;
+}
+
+// Maps the values of a counter buffer to the source lines of the counters
+// that wrote them, through the debug locations of the increments. The module
+// is the instrumented one, at any point of the pipeline, with its debug
+// information; the counts are the 32-bit values of the buffer in order. The
+// lines are printed hottest first.
+class DxilMapCountersToLines : public ModulePass {
+  std::string m_Counts;
+  std::vector<std::pair<std::string, uint64_t>> m_Lines;
+  std::vector<std::string> m_Report;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilMapCountersToLines() : ModulePass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL map counters to lines";
+  }
+
+  void applyOptions(PassOptions O) override {
+    StringRef Counts;
+    if (GetPassOption(O, "counts", &Counts))
+      m_Counts = Counts;
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void print(raw_ostream &OS, const Module *) const override {
+    for (const std::string &Entry : m_Report)
+      OS << Entry << "\n";
+    for (const auto &Line : m_Lines)
+      OS << Line.first << " " << Line.second << "\n";
+  }
+};
+
+bool DxilMapCountersToLines::runOnModule(Module &M) {
+  SmallVector<StringRef, 64> Fields;
+  SplitString(m_Counts, Fields, " \t\r\n,;");
+  std::vector<uint64_t> Counts;
+  for (StringRef Field : Fields) {
+    uint64_t Count;
+    if (Field.getAsInteger(0, Count)) {
+      m_Report.push_back(("Ignored malformed count: " + Field).str());
+      Count = 0;
+    }
+    Counts.push_back(Count);
+  }
+
+  DxilModule &DM = M.GetOrCreateDxilModule();
+  const DxilResource *pCounters = nullptr;
+  for (const auto &UAV : DM.GetUAVs()) {
+    if (UAV->GetGlobalName() == kCounterBufferName)
+      pCounters = UAV.get();
+  }
+  if (!pCounters) {
+    m_Report.push_back("Module has no block counters");
+    return false;
+  }
+
+  StringMap<uint64_t> LineCounts;
+  unsigned NoLocation = 0;
+  for (Function &F : M) {
+    if (!OP::IsDxilOpFunc(&F))
+      continue;
+    for (User *U : F.users()) {
+      Instruction *I = dyn_cast<Instruction>(U);
+      if (!I || !DxilInst_AtomicBinOp(I))
+        continue;
+      DxilInst_AtomicBinOp Atomic(I);
+      Instruction *HandleI = dyn_cast<Instruction>(Atomic.get_handle());
+      if (!HandleI || !DxilInst_CreateHandle(HandleI))
+        continue;
+      DxilInst_CreateHandle Handle(HandleI);
+      ConstantInt *RangeID = dyn_cast<ConstantInt>(Handle.get_rangeId());
+      ConstantInt *Offset = dyn_cast<ConstantInt>(Atomic.get_offset0());
+      if (!RangeID || RangeID->getLimitedValue() != pCounters->GetID() ||
+          !Offset)
+        continue;
+      uint64_t Index = Offset->getLimitedValue() / 4;
+      if (Index >= Counts.size())
+        continue;
+      std::string Location = GetLocationString(I->getDebugLoc());
+      if (Location.empty()) {
+        ++NoLocation;
+        continue;
+      }
+      LineCounts[Location] += Counts[Index];
+    }
+  }
+  if (NoLocation)
+    m_Report.push_back((Twine(NoLocation) +
+                        " counters have no debug location; compile with /Zi")
+                           .str());
+
+  for (const auto &Entry : LineCounts)
+    m_Lines.push_back(std::make_pair(Entry.getKey().str(), Entry.getValue()));
+  std::sort(m_Lines.begin(), m_Lines.end(),
+            [](const std::pair<std::string, uint64_t> &a,
+               const std::pair<std::string, uint64_t> &b) {
+              return a.second != b.second ? a.second > b.second
+                                          : a.first < b.first;
+            });
+  return false;
+}
+
+class DxilApplyBlockProfile : public ModulePass {
+  std::string m_Profile;
+  unsigned m_ColdPercent = 5;
+  std::vector<std::string> m_Report;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilApplyBlockProfile() : ModulePass(ID) {}
+  explicit DxilApplyBlockProfile(StringRef Profile)
+      : ModulePass(ID), m_Profile(Profile) {}
+
+  const char *getPassName() const override {
+    return "DXIL apply block profile";
+  }
+
+  void applyOptions(PassOptions O) override {
+    StringRef Profile;
+    if (GetPassOption(O, "profile", &Profile))
+      m_Profile = Profile;
+    GetPassOptionUnsigned(O, "cold-percent", &m_ColdPercent, m_ColdPercent);
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void print(raw_ostream &OS, const Module *) const override {
+    for (const std::string &Entry : m_Report)
+      OS << Entry << "\n";
+  }
+
+private:
+  typedef StringMap<std::vector<uint64_t>> ProfileMap;
+  void ParseProfile(ProfileMap &Profile);
+  bool ApplyToFunction(Function &F, const std::vector<uint64_t> &Counts);
+};
+
+void DxilApplyBlockProfile::ParseProfile(ProfileMap &Profile) {
+  SmallVector<StringRef, 32> Lines;
+  SplitString(m_Profile, Lines, "\r\n;");
+  for (StringRef Line : Lines) {
+    Line = Line.trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    SmallVector<StringRef, 3> Fields;
+    SplitString(Line, Fields, " \t:");
+    unsigned Block;
+    uint64_t Count;
+    if (Fields.size() != 3 || Fields[1].getAsInteger(10, Block) ||
+        Fields[2].getAsInteger(10, Count)) {
+      m_Report.push_back(("Ignored malformed profile entry: " + Line).str());
+      continue;
+    }
+    std::vector<uint64_t> &Counts = Profile[Fields[0]];
+    if (Counts.size() <= Block)
+      Counts.resize(Block + 1);
+    Counts[Block] = Count;
+  }
+}
+
+// Returns how often control goes from the branch's block to each successor,
+// or false if the counts of the blocks do not tell. A successor with no
+// other predecessor runs exactly as often as the edge to it is taken.
+static bool GetEdgeCounts(BranchInst *BI,
+                          const DenseMap<BasicBlock *, uint64_t> &Counts,
+                          uint64_t EdgeCounts[2]) {
+  BasicBlock *BB = BI->getParent();
+  uint64_t BlockCount = Counts.lookup(BB);
+  bool Known[2];
+  for (unsigned i = 0; i < 2; ++i) {
+    BasicBlock *Succ = BI->getSuccessor(i);
+    Known[i] = Succ->getSinglePredecessor() == BB;
+    EdgeCounts[i] = Known[i] ? Counts.lookup(Succ) : 0;
+  }
+  if (!Known[0] && !Known[1])
+    return false;
+  for (unsigned i = 0; i < 2; ++i) {
+    if (!Known[i]) {
+      uint64_t Other = EdgeCounts[1 - i];
+      EdgeCounts[i] = BlockCount > Other ? BlockCount - Other : 0;
+    }
+  }
+  return true;
+}
+
+// Branches without a hint that almost always go one way are marked [branch],
+// so the rarely taken side is skipped rather than flattened into the common
+// path. Loop exits and back edges are left to the loop passes.
+bool DxilApplyBlockProfile::ApplyToFunction(
+    Function &F, const std::vector<uint64_t> &Counts) {
+  if (Counts.size() != F.size()) {
+    m_Report.push_back((F.getName() + ": profile has " + Twine(Counts.size()) +
+                        " blocks, function has " + Twine(F.size()) +
+                        "; profile ignored")
+                           .str());
+    return false;
+  }
+
+  DenseMap<BasicBlock *, uint64_t> BlockCounts;
+  std::vector<BasicBlock *> Blocks;
+  for (BasicBlock &BB : F) {
+    BlockCounts[&BB] = Counts[Blocks.size()];
+    Blocks.push_back(&BB);
+  }
+
+  DominatorTreeAnalysis DTA;
+  DominatorTree DT = DTA.run(F);
+  LoopInfo LI;
+  LI.Analyze(DT);
+
+  bool bChanged = false;
+  for (unsigned i = 0, e = Blocks.size(); i < e; ++i) {
+    BasicBlock *BB = Blocks[i];
+    BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator());
+    if (!BI || !BI->isConditional() ||
+        BI->getMetadata(DxilMDHelper::kDxilControlFlowHintMDName))
+      continue;
+    uint64_t BlockCount = BlockCounts[BB];
+    if (BlockCount == 0)
+      continue;
+    if (Loop *L = LI.getLoopFor(BB)) {
+      if (!L->contains(BI->getSuccessor(0)) ||
+          !L->contains(BI->getSuccessor(1)) ||
+          BI->getSuccessor(0) == L->getHeader() ||
+          BI->getSuccessor(1) == L->getHeader())
+        continue;
+    }
+
+    uint64_t EdgeCounts[2];
+    if (!GetEdgeCounts(BI, BlockCounts, EdgeCounts))
+      continue;
+    uint64_t Rare = std::min(EdgeCounts[0], EdgeCounts[1]);
+    if (Rare * 100 >= (uint64_t)m_ColdPercent * BlockCount)
+      continue;
+
+    std::vector<DXIL::ControlFlowHint> Hints = {DXIL::ControlFlowHint::Branch};
+    BI->setMetadata(DxilMDHelper::kDxilControlFlowHintMDName,
+                    DxilMDHelper::EmitControlFlowHints(F.getContext(), Hints));
+    m_Report.push_back((F.getName() + ": block " + Twine(i) +
+                        " marked [branch], rare side taken " + Twine(Rare) +
+                        " of " + Twine(BlockCount) + " times")
+                           .str());
+    bChanged = true;
+  }
+  return bChanged;
+}
+
+bool DxilApplyBlockProfile::runOnModule(Module &M) {
+  ProfileMap Profile;
+  ParseProfile(Profile);
+  if (Profile.empty())
+    return false;
+
+  bool bChanged = false;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto It = Profile.find(F.getName());
+    if (It == Profile.end())
+      continue;
+    bChanged |= ApplyToFunction(F, It->second);
+  }
+  return bChanged;
+}
+
+} // namespace
+
+char DxilInsertBlockCounters::ID = 0;
+char DxilMapCountersToLines::ID = 0;
+char DxilApplyBlockProfile::ID = 0;
+
+ModulePass *llvm::createDxilInsertBlockCountersPass() {
+  return new DxilInsertBlockCounters();
+}
+
+ModulePass *llvm::createDxilMapCountersToLinesPass() {
+  return new DxilMapCountersToLines();
+}
+
+ModulePass *llvm::createDxilApplyBlockProfilePass(StringRef Profile) {
+  return new DxilApplyBlockProfile(Profile);
+}
+
+INITIALIZE_PASS(DxilInsertBlockCounters, "hlsl-dxil-insert-block-counters",
+                "DXIL insert block counters", false, false)
+INITIALIZE_PASS(DxilMapCountersToLines, "hlsl-dxil-map-counters-to-lines",
+                "DXIL map counters to lines", false, false)
+INITIALIZE_PASS(DxilApplyBlockProfile, "hlsl-dxil-apply-block-profile",
+                "DXIL apply block profile", false, false)
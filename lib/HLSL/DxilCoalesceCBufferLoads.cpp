@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilCoalesceCBufferLoads.cpp                                              //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Hoists loop-invariant resource handles and dimension queries out of      //
+// loops and merges them, and legacy constant buffer row loads, with         //
+// identical operands across a function.                                     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilInstructions.h"
+
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Pass.h"
+
+#include <map>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+///////////////////////////////////////////////////////////////////////////////
+// Coalesce cbuffer loads.
+
+namespace {
+// A handle only names a resource, and constant buffers cannot be written
+// while a shader runs, so handles and cbuffer row loads with the same
+// operands produce the same value anywhere in the function. GVN cannot see
+// this when stores or barriers come between the calls, since the calls are
+// only marked readonly. The dimensions of a resource don't change either;
+// getDimensions is readnone, but LICM runs before handles leave loops here,
+// so it is hoisted and merged along with them. This pass first hoists
+// handles, then dimension queries, with loop-invariant operands into loop
+// preheaders. It then replaces a call with an equivalent one that dominates
+// it, or hoists the first of two equivalent calls into their nearest common
+// dominator when the operands are available there.
+// The non-uniform flag is an operand, so a handle marked non-uniform is
+// never merged with one that is not.
+class DxilCoalesceCBufferLoads : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilCoalesceCBufferLoads() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL coalesce cbuffer loads";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addPreserved<LoopInfoWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (!F.getParent()->HasDxilModule())
+      return false;
+
+    DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    // Hoisting first leaves handles of different iterations and loops in
+    // common blocks where they can be merged.
+    bool bChanged = HoistFromLoops(F, LI, DXIL::OpCode::CreateHandle);
+    bChanged |= HoistFromLoops(F, LI, DXIL::OpCode::GetDimensions);
+    // Handles first, so uses of equivalent handles get equal operands.
+    bChanged |= Coalesce(F, DT, DXIL::OpCode::CreateHandle);
+    bChanged |= Coalesce(F, DT, DXIL::OpCode::CBufferLoadLegacy);
+    bChanged |= Coalesce(F, DT, DXIL::OpCode::GetDimensions);
+    return bChanged;
+  }
+
+private:
+  typedef SmallVector<Value *, 5> CallKey;
+  bool HoistFromLoops(Function &F, LoopInfo &LI, DXIL::OpCode opcode);
+  bool Coalesce(Function &F, DominatorTree &DT, DXIL::OpCode opcode);
+  static bool IsCandidate(CallInst *CI, DXIL::OpCode opcode);
+  static bool OperandsAvailableAt(CallInst *CI, Instruction *InsertPt,
+                                  DominatorTree &DT);
+};
+
+char DxilCoalesceCBufferLoads::ID = 0;
+
+bool DxilCoalesceCBufferLoads::IsCandidate(CallInst *CI, DXIL::OpCode opcode) {
+  Function *Callee = CI->getCalledFunction();
+  if (!Callee || !OP::IsDxilOpFunc(Callee))
+    return false;
+  ConstantInt *opArg =
+      dyn_cast<ConstantInt>(CI->getArgOperand(DXIL::OperandIndex::kOpcodeIdx));
+  return opArg && opArg->getLimitedValue() == (uint64_t)opcode;
+}
+
+bool DxilCoalesceCBufferLoads::HoistFromLoops(Function &F, LoopInfo &LI,
+                                              DXIL::OpCode opcode) {
+  bool bChanged = false;
+  for (BasicBlock &BB : F) {
+    Loop *L = LI.getLoopFor(&BB);
+    if (!L)
+      continue;
+    for (auto It = BB.begin(), E = BB.end(); It != E;) {
+      CallInst *CI = dyn_cast<CallInst>(&*(It++));
+      if (!CI || !IsCandidate(CI, opcode))
+        continue;
+      // Out of as many loops as the operands allow.
+      Loop *Outermost = nullptr;
+      for (Loop *Cur = L; Cur && Cur->getLoopPreheader() &&
+                          Cur->hasLoopInvariantOperands(CI);
+           Cur = Cur->getParentLoop())
+        Outermost = Cur;
+      if (Outermost) {
+        CI->moveBefore(Outermost->getLoopPreheader()->getTerminator());
+        bChanged = true;
+      }
+    }
+  }
+  return bChanged;
+}
+
+bool DxilCoalesceCBufferLoads::OperandsAvailableAt(CallInst *CI,
+                                                   Instruction *InsertPt,
+                                                   DominatorTree &DT) {
+  for (Value *Arg : CI->arg_operands()) {
+    if (Instruction *I = dyn_cast<Instruction>(Arg)) {
+      if (!DT.dominates(I, InsertPt))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool DxilCoalesceCBufferLoads::Coalesce(Function &F, DominatorTree &DT,
+                                        DXIL::OpCode opcode) {
+  // Leaders are the calls kept for each set of operands. Visiting blocks in
+  // dominator tree preorder means an earlier leader either dominates a later
+  // call or sits in a sibling subtree, never below it.
+  std::map<CallKey, std::vector<CallInst *>> Leaders;
+  bool bChanged = false;
+
+  for (DomTreeNode *Node : depth_first(DT.getRootNode())) {
+    BasicBlock *BB = Node->getBlock();
+    for (auto It = BB->begin(), E = BB->end(); It != E;) {
+      CallInst *CI = dyn_cast<CallInst>(&*(It++));
+      if (!CI || !IsCandidate(CI, opcode))
+        continue;
+
+      CallKey Key(CI->arg_operands().begin(), CI->arg_operands().end());
+      std::vector<CallInst *> &Calls = Leaders[Key];
+      CallInst *Replacement = nullptr;
+      for (CallInst *Leader : Calls) {
+        if (Leader->getCalledFunction() != CI->getCalledFunction())
+          continue;
+        if (DT.dominates(Leader, CI)) {
+          Replacement = Leader;
+          break;
+        }
+        BasicBlock *Common = DT.findNearestCommonDominator(Leader->getParent(), BB);
+        if (!Common)
+          continue;
+        Instruction *InsertPt = Common->getTerminator();
+        if (OperandsAvailableAt(Leader, InsertPt, DT)) {
+          Leader->moveBefore(InsertPt);
+          Replacement = Leader;
+          break;
+        }
+      }
+
+      if (Replacement) {
+        CI->replaceAllUsesWith(Replacement);
+        CI->eraseFromParent();
+        bChanged = true;
+      } else {
+        Calls.emplace_back(CI);
+      }
+    }
+  }
+
+  return bChanged;
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilCoalesceCBufferLoadsPass() {
+  return new DxilCoalesceCBufferLoads();
+}
+
+INITIALIZE_PASS_BEGIN(DxilCoalesceCBufferLoads, "hlsl-dxil-coalesce-cbuffer-loads",
+                      "DXIL coalesce cbuffer loads", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(DxilCoalesceCBufferLoads, "hlsl-dxil-coalesce-cbuffer-loads",
+                    "DXIL coalesce cbuffer loads", false, false)
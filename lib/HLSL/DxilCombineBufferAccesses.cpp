@@ -0,0 +1,428 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilCombineBufferAccesses.cpp                                             //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Merges adjacent raw and structured buffer loads and stores into wider     //
+// accesses.                                                                 //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilResource.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+///////////////////////////////////////////////////////////////////////////////
+// Combine buffer accesses.
+
+namespace {
+// Structured buffer fields and raw buffer words are accessed one 32-bit
+// component at a time once the scalarizer has run. This pass finds accesses
+// in the same block to the same handle and element, at constant byte offsets
+// that fall in one 16-byte window, and issues a single access of up to four
+// components instead.
+class DxilCombineBufferAccesses : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilCombineBufferAccesses() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL combine buffer accesses";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override;
+
+private:
+  static const unsigned kCompBytes = 4;
+  static const unsigned kMaxComps = 4;
+
+  // Where an access reads or writes: accesses with the same key differ only
+  // by the constant byte offset.
+  struct AccessKey {
+    Function *Callee;
+    Value *Handle;
+    Value *Base; // Structured element index, or raw address without the constant.
+    bool operator<(const AccessKey &o) const {
+      if (Callee != o.Callee) return Callee < o.Callee;
+      if (Handle != o.Handle) return Handle < o.Handle;
+      return Base < o.Base;
+    }
+  };
+  struct Access {
+    CallInst *CI;
+    unsigned Offset;  // Constant byte offset from the base.
+    unsigned NumComps;
+    unsigned Order;   // Position in the block.
+  };
+  typedef std::map<AccessKey, std::vector<Access>> AccessGroups;
+
+  DxilModule *m_pDM;
+  OP *m_pOP;
+
+  bool IsCombinableBuffer(Value *Handle, bool &bRaw);
+  bool GetAccess(CallInst *CI, bool bStore, AccessKey &Key, Access &A);
+  bool CombineLoads(AccessGroups &Groups);
+  bool CombineLoadWindow(std::vector<Access> &Loads, bool bRaw);
+  bool CombineStores(const std::vector<Access> &Stores);
+  Value *GetAddress(IRBuilder<> &Builder, CallInst *CI, unsigned Offset,
+                    bool bRaw, Value *Base);
+};
+
+char DxilCombineBufferAccesses::ID = 0;
+
+bool DxilCombineBufferAccesses::IsCombinableBuffer(Value *Handle, bool &bRaw) {
+  CallInst *CI = dyn_cast<CallInst>(Handle);
+  if (!CI || !OP::IsDxilOpFuncCallInst(CI, DXIL::OpCode::CreateHandle))
+    return false;
+  DxilInst_CreateHandle createHandle(CI);
+  ConstantInt *resClass = dyn_cast<ConstantInt>(createHandle.get_resourceClass());
+  ConstantInt *rangeId = dyn_cast<ConstantInt>(createHandle.get_rangeId());
+  if (!resClass || !rangeId)
+    return false;
+
+  const std::vector<std::unique_ptr<DxilResource>> *pResources = nullptr;
+  switch ((DXIL::ResourceClass)resClass->getLimitedValue()) {
+  case DXIL::ResourceClass::SRV: pResources = &m_pDM->GetSRVs(); break;
+  case DXIL::ResourceClass::UAV: pResources = &m_pDM->GetUAVs(); break;
+  default: return false;
+  }
+  for (auto &Res : *pResources) {
+    if (Res->GetID() != rangeId->getLimitedValue())
+      continue;
+    if (Res->IsRawBuffer()) {
+      bRaw = true;
+      return true;
+    }
+    if (Res->IsStructuredBuffer()) {
+      bRaw = false;
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+bool DxilCombineBufferAccesses::GetAccess(CallInst *CI, bool bStore,
+                                          AccessKey &Key, Access &A) {
+  // bufferLoad(handle, index, offset) and bufferStore(handle, index, offset,
+  // v0, v1, v2, v3, mask) share the layout of their first three operands.
+  Value *Handle = CI->getArgOperand(1);
+  Value *Index = CI->getArgOperand(2);
+  Value *Offset = CI->getArgOperand(3);
+  bool bRaw = false;
+  if (!IsCombinableBuffer(Handle, bRaw))
+    return false;
+
+  Type *CompTy = bStore ? CI->getArgOperand(4)->getType()
+                        : CI->getType()->getStructElementType(0);
+  if (CompTy->getPrimitiveSizeInBits() != kCompBytes * 8)
+    return false;
+
+  uint64_t ByteOffset = 0;
+  Value *Base = nullptr;
+  if (bRaw) {
+    // Raw addresses are (base + constant) or a constant.
+    if (ConstantInt *C = dyn_cast<ConstantInt>(Index)) {
+      ByteOffset = C->getLimitedValue();
+    } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(Index)) {
+      ConstantInt *C = dyn_cast<ConstantInt>(BO->getOperand(1));
+      if (BO->getOpcode() == Instruction::Add && C) {
+        Base = BO->getOperand(0);
+        ByteOffset = C->getLimitedValue();
+      } else {
+        Base = Index;
+      }
+    } else {
+      Base = Index;
+    }
+  } else {
+    ConstantInt *C = dyn_cast<ConstantInt>(Offset);
+    if (!C)
+      return false;
+    Base = Index;
+    ByteOffset = C->getLimitedValue();
+  }
+  if (ByteOffset % kCompBytes || ByteOffset > UINT32_MAX - 16)
+    return false;
+
+  unsigned NumComps = 0;
+  if (bStore) {
+    ConstantInt *Mask = dyn_cast<ConstantInt>(CI->getArgOperand(8));
+    if (!Mask)
+      return false;
+    switch (Mask->getLimitedValue()) {
+    case 1: NumComps = 1; break;
+    case 3: NumComps = 2; break;
+    case 7: NumComps = 3; break;
+    case 15: NumComps = 4; break;
+    default: return false;
+    }
+  } else {
+    // Only components that are extracted count, and the status is not
+    // combined since it covers every component of a load.
+    for (User *U : CI->users()) {
+      ExtractValueInst *EV = dyn_cast<ExtractValueInst>(U);
+      if (!EV || EV->getNumIndices() != 1)
+        return false;
+      unsigned Idx = EV->getIndices()[0];
+      if (Idx >= kMaxComps)
+        return false;
+      NumComps = std::max(NumComps, Idx + 1);
+    }
+    if (NumComps == 0)
+      return false;
+  }
+
+  Key.Callee = CI->getCalledFunction();
+  Key.Handle = Handle;
+  Key.Base = Base;
+  A.CI = CI;
+  A.Offset = (unsigned)ByteOffset;
+  A.NumComps = NumComps;
+  return true;
+}
+
+Value *DxilCombineBufferAccesses::GetAddress(IRBuilder<> &Builder,
+                                             CallInst *CI, unsigned Offset,
+                                             bool bRaw, Value *Base) {
+  if (!bRaw)
+    return CI->getArgOperand(2);
+  if (!Base)
+    return m_pOP->GetU32Const(Offset);
+  if (Offset == 0)
+    return Base;
+  return Builder.CreateAdd(Base, m_pOP->GetU32Const(Offset));
+}
+
+bool DxilCombineBufferAccesses::CombineLoadWindow(std::vector<Access> &Loads,
+                                                  bool bRaw) {
+  if (Loads.size() < 2)
+    return false;
+
+  // Issue the combined load where the first of the loads in program order
+  // was; every operand it needs is available there.
+  const Access *pEarliest = &Loads[0];
+  for (const Access &A : Loads) {
+    if (A.Order < pEarliest->Order)
+      pEarliest = &A;
+  }
+  CallInst *InsertPt = pEarliest->CI;
+  unsigned BaseOffset = Loads[0].Offset;
+  CallInst *First = Loads[0].CI;
+  AccessKey Key;
+  Access Tmp;
+  GetAccess(First, /*bStore*/false, Key, Tmp);
+
+  IRBuilder<> Builder(InsertPt);
+  Value *Args[] = {
+    First->getArgOperand(0), First->getArgOperand(1),
+    GetAddress(Builder, First, BaseOffset, bRaw, Key.Base),
+    bRaw ? First->getArgOperand(3) : m_pOP->GetU32Const(BaseOffset)
+  };
+  CallInst *Combined = Builder.CreateCall(First->getCalledFunction(), Args);
+
+  for (Access &A : Loads) {
+    unsigned Shift = (A.Offset - BaseOffset) / kCompBytes;
+    for (auto U = A.CI->user_begin(), E = A.CI->user_end(); U != E;) {
+      ExtractValueInst *EV = cast<ExtractValueInst>(*(U++));
+      Builder.SetInsertPoint(EV);
+      Value *NewEV = Builder.CreateExtractValue(Combined, EV->getIndices()[0] + Shift);
+      EV->replaceAllUsesWith(NewEV);
+      EV->eraseFromParent();
+    }
+    A.CI->eraseFromParent();
+  }
+  return true;
+}
+
+bool DxilCombineBufferAccesses::CombineLoads(AccessGroups &Groups) {
+  bool bChanged = false;
+  for (auto &It : Groups) {
+    std::vector<Access> &Loads = It.second;
+    if (Loads.size() < 2)
+      continue;
+    bool bRaw = false;
+    IsCombinableBuffer(It.first.Handle, bRaw);
+    std::stable_sort(Loads.begin(), Loads.end(),
+                     [](const Access &a, const Access &b) { return a.Offset < b.Offset; });
+    // Greedily take windows of loads that fit in four components from the
+    // lowest offset.
+    unsigned i = 0;
+    while (i < Loads.size()) {
+      std::vector<Access> Window;
+      unsigned Begin = Loads[i].Offset;
+      unsigned j = i;
+      for (; j < Loads.size(); ++j) {
+        unsigned End = Loads[j].Offset + Loads[j].NumComps * kCompBytes;
+        if (End > Begin + kMaxComps * kCompBytes)
+          break;
+        Window.emplace_back(Loads[j]);
+      }
+      bChanged |= CombineLoadWindow(Window, bRaw);
+      i = std::max(j, i + 1);
+    }
+  }
+  return bChanged;
+}
+
+bool DxilCombineBufferAccesses::CombineStores(const std::vector<Access> &Stores) {
+  bool bChanged = false;
+  if (Stores.size() >= 2) {
+    bool bRaw = false;
+    IsCombinableBuffer(Stores[0].CI->getArgOperand(1), bRaw);
+    // Stores are in program order; the combined store goes where the last
+    // one was, after every value it writes is defined.
+    std::vector<Access> Sorted = Stores;
+    std::stable_sort(Sorted.begin(), Sorted.end(),
+                     [](const Access &a, const Access &b) { return a.Offset < b.Offset; });
+    unsigned i = 0;
+    while (i < Sorted.size()) {
+      // A window covers components [0, End) with no gaps or overlaps, so the
+      // combined mask is still a prefix.
+      unsigned Begin = Sorted[i].Offset;
+      unsigned End = Begin + Sorted[i].NumComps * kCompBytes;
+      unsigned j = i + 1;
+      while (j < Sorted.size() && Sorted[j].Offset == End &&
+             End + Sorted[j].NumComps * kCompBytes <= Begin + kMaxComps * kCompBytes) {
+        End += Sorted[j].NumComps * kCompBytes;
+        ++j;
+      }
+      if (j - i >= 2) {
+        const Access *pLast = &Sorted[i];
+        for (unsigned k = i; k < j; ++k) {
+          if (pLast->Order < Sorted[k].Order)
+            pLast = &Sorted[k];
+        }
+        CallInst *Last = pLast->CI;
+        CallInst *First = Sorted[i].CI;
+        AccessKey Key;
+        Access Tmp;
+        GetAccess(First, /*bStore*/true, Key, Tmp);
+
+        IRBuilder<> Builder(Last);
+        Value *Vals[kMaxComps];
+        Value *Undef = UndefValue::get(First->getArgOperand(4)->getType());
+        std::fill(Vals, Vals + kMaxComps, Undef);
+        for (unsigned k = i; k < j; ++k) {
+          unsigned Shift = (Sorted[k].Offset - Begin) / kCompBytes;
+          for (unsigned c = 0; c < Sorted[k].NumComps; ++c)
+            Vals[Shift + c] = Sorted[k].CI->getArgOperand(4 + c);
+        }
+        unsigned NumComps = (End - Begin) / kCompBytes;
+        Value *Args[] = {
+          First->getArgOperand(0), First->getArgOperand(1),
+          GetAddress(Builder, First, Begin, bRaw, Key.Base),
+          bRaw ? First->getArgOperand(3) : m_pOP->GetU32Const(Begin),
+          Vals[0], Vals[1], Vals[2], Vals[3],
+          m_pOP->GetI8Const((1 << NumComps) - 1)
+        };
+        Builder.CreateCall(First->getCalledFunction(), Args);
+        for (unsigned k = i; k < j; ++k)
+          Sorted[k].CI->eraseFromParent();
+        bChanged = true;
+      }
+      i = j;
+    }
+  }
+  return bChanged;
+}
+
+bool DxilCombineBufferAccesses::runOnFunction(Function &F) {
+  if (!F.getParent()->HasDxilModule())
+    return false;
+  m_pDM = &F.getParent()->GetDxilModule();
+  m_pOP = m_pDM->GetOP();
+
+  // Loads may be combined across other loads, but not across anything that
+  // writes memory. Stores are only combined within a run of stores to the
+  // same location with nothing else touching memory in between. The block
+  // is only rewritten once every segment is collected.
+  std::vector<AccessGroups> LoadSegments;
+  std::vector<std::vector<Access>> StoreRuns;
+  for (BasicBlock &BB : F) {
+    AccessGroups Loads;
+    std::vector<Access> Stores;
+    AccessKey StoreKey = { nullptr, nullptr, nullptr };
+    auto FlushLoads = [&]() {
+      if (!Loads.empty())
+        LoadSegments.emplace_back(std::move(Loads));
+      Loads.clear();
+    };
+    auto FlushStores = [&]() {
+      if (Stores.size() >= 2)
+        StoreRuns.emplace_back(std::move(Stores));
+      Stores.clear();
+    };
+
+    unsigned Order = 0;
+    for (Instruction &I : BB) {
+      ++Order;
+      CallInst *CI = dyn_cast<CallInst>(&I);
+      AccessKey Key;
+      Access A;
+      if (CI && OP::IsDxilOpFuncCallInst(CI, DXIL::OpCode::BufferLoad) &&
+          GetAccess(CI, /*bStore*/false, Key, A)) {
+        FlushStores();
+        A.Order = Order;
+        Loads[Key].emplace_back(A);
+        continue;
+      }
+      if (CI && OP::IsDxilOpFuncCallInst(CI, DXIL::OpCode::BufferStore) &&
+          GetAccess(CI, /*bStore*/true, Key, A)) {
+        FlushLoads();
+        if (!Stores.empty() && (Key < StoreKey || StoreKey < Key))
+          FlushStores();
+        StoreKey = Key;
+        A.Order = Order;
+        Stores.emplace_back(A);
+        continue;
+      }
+      if (I.mayWriteToMemory()) {
+        FlushLoads();
+        FlushStores();
+      } else if (I.mayReadFromMemory()) {
+        FlushStores();
+      }
+    }
+    FlushLoads();
+    FlushStores();
+  }
+
+  bool bChanged = false;
+  for (AccessGroups &Groups : LoadSegments)
+    bChanged |= CombineLoads(Groups);
+  for (const std::vector<Access> &Stores : StoreRuns)
+    bChanged |= CombineStores(Stores);
+  return bChanged;
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilCombineBufferAccessesPass() {
+  return new DxilCombineBufferAccesses();
+}
+
+INITIALIZE_PASS(DxilCombineBufferAccesses, "hlsl-dxil-combine-buffer-accesses",
+                "DXIL combine buffer accesses", false, false)
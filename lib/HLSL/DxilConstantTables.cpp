@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilConstantTables.cpp                                                    //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Chooses how dynamically indexed constant tables are stored: small tables  //
+// become selects over their elements, larger ones stay immediate constant   //
+// data.                                                                     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+#define DEBUG_TYPE "hlsl-dxil-constant-tables"
+
+namespace {
+// Static const arrays that are indexed dynamically are emitted as immediate
+// constant data, which drivers read through memory on every access. For
+// tables of at most max-elements scalars, this pass replaces each dynamic
+// load with a select over the constant elements, keeping the table in
+// registers:
+//
+//   load t[i]  ->  select(i == N-1, cN-1, ... select(i == 1, c1, c0))
+//
+// Loads at constant indices fold to the element. Each dynamically indexed
+// table gets an analysis remark naming the chosen storage, which the front
+// end prints for -report_const_tables.
+class DxilConstantTables : public ModulePass {
+  unsigned m_MaxElements = 8;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilConstantTables(unsigned MaxElements = 8)
+      : ModulePass(ID), m_MaxElements(MaxElements) {}
+
+  const char *getPassName() const override { return "DXIL constant tables"; }
+
+  void applyOptions(PassOptions O) override {
+    for (const auto &option : O) {
+      if (0 == option.first.compare("max-elements"))
+        m_MaxElements = atoi(option.second.data());
+    }
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  void RewriteAsSelects(GlobalVariable *GV);
+};
+
+// A table is an internal constant array of scalars with an initializer.
+static bool IsConstantTable(GlobalVariable &GV) {
+  if (!GV.isConstant() || !GV.hasInitializer() || !GV.hasLocalLinkage())
+    return false;
+  ArrayType *AT = dyn_cast<ArrayType>(GV.getType()->getElementType());
+  if (!AT)
+    return false;
+  Type *EltTy = AT->getElementType();
+  return EltTy->isIntegerTy() || EltTy->isFloatingPointTy();
+}
+
+// An access is a GEP with a zero first index and one element index, all of
+// whose users are simple loads through it.
+static bool IsSupportedAccess(User *U) {
+  GEPOperator *GEP = dyn_cast<GEPOperator>(U);
+  if (!GEP || GEP->getNumIndices() != 2)
+    return false;
+  ConstantInt *First = dyn_cast<ConstantInt>(GEP->getOperand(1));
+  if (!First || !First->isZero())
+    return false;
+  for (User *GEPUser : GEP->users()) {
+    LoadInst *LI = dyn_cast<LoadInst>(GEPUser);
+    if (!LI || !LI->isSimple())
+      return false;
+  }
+  return true;
+}
+
+// Returns the first load through a dynamic index of GV, or null if all
+// indices are constant.
+static LoadInst *FindDynamicLoad(GlobalVariable *GV) {
+  for (User *U : GV->users()) {
+    GEPOperator *GEP = dyn_cast<GEPOperator>(U);
+    if (!GEP || GEP->getNumIndices() != 2 || isa<Constant>(GEP->getOperand(2)))
+      continue;
+    for (User *GEPUser : GEP->users()) {
+      if (LoadInst *LI = dyn_cast<LoadInst>(GEPUser))
+        return LI;
+    }
+  }
+  return nullptr;
+}
+
+void DxilConstantTables::RewriteAsSelects(GlobalVariable *GV) {
+  Constant *Init = GV->getInitializer();
+  unsigned NumElements = GV->getType()->getElementType()->getArrayNumElements();
+  std::vector<Constant *> Elts(NumElements);
+  for (unsigned i = 0; i < NumElements; ++i)
+    Elts[i] = Init->getAggregateElement(i);
+
+  SmallVector<User *, 8> GEPs(GV->user_begin(), GV->user_end());
+  for (User *U : GEPs) {
+    Value *Idx = U->getOperand(2);
+    ConstantInt *CIdx = dyn_cast<ConstantInt>(Idx);
+    SmallVector<User *, 4> Loads(U->user_begin(), U->user_end());
+    for (User *GEPUser : Loads) {
+      LoadInst *LI = cast<LoadInst>(GEPUser);
+      Value *Result;
+      if (CIdx) {
+        uint64_t i = CIdx->getLimitedValue();
+        Result = i < NumElements ? Elts[i] : UndefValue::get(LI->getType());
+      } else {
+        IRBuilder<> Builder(LI);
+        Result = Elts[0];
+        for (unsigned i = 1; i < NumElements; ++i) {
+          Value *IsElt =
+              Builder.CreateICmpEQ(Idx, ConstantInt::get(Idx->getType(), i));
+          Result = Builder.CreateSelect(IsElt, Elts[i], Result);
+        }
+        Result->takeName(LI);
+      }
+      LI->replaceAllUsesWith(Result);
+      LI->eraseFromParent();
+    }
+    if (GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(U))
+      GEP->eraseFromParent();
+  }
+  GV->removeDeadConstantUsers();
+  if (GV->use_empty())
+    GV->eraseFromParent();
+}
+
+bool DxilConstantTables::runOnModule(Module &M) {
+  std::vector<GlobalVariable *> Tables;
+  for (GlobalVariable &GV : M.globals()) {
+    if (IsConstantTable(GV))
+      Tables.push_back(&GV);
+  }
+
+  bool Changed = false;
+  for (GlobalVariable *GV : Tables) {
+    LoadInst *DynamicLoad = FindDynamicLoad(GV);
+    if (!DynamicLoad)
+      continue;
+
+    ArrayType *AT = cast<ArrayType>(GV->getType()->getElementType());
+    unsigned NumElements = AT->getNumElements();
+    uint64_t Size = M.getDataLayout().getTypeAllocSize(AT);
+    std::string Msg;
+    raw_string_ostream OS(Msg);
+    OS << "constant table '" << GV->getName() << "' (" << NumElements
+       << " elements, " << Size << " bytes) is indexed dynamically; ";
+
+    const char *Reason = nullptr;
+    if (NumElements > m_MaxElements)
+      Reason = "more elements than the select threshold";
+    for (User *U : GV->users()) {
+      if (!Reason && !IsSupportedAccess(U))
+        Reason = "unsupported use";
+    }
+    if (Reason) {
+      OS << "kept as immediate constant data (" << Reason << ")";
+    } else {
+      OS << "rewritten as selects";
+    }
+
+    // The table may go away below, so report before rewriting it.
+    Function *F = DynamicLoad->getParent()->getParent();
+    emitOptimizationRemarkAnalysis(M.getContext(), DEBUG_TYPE, *F,
+                                   DynamicLoad->getDebugLoc(), OS.str());
+    if (!Reason) {
+      RewriteAsSelects(GV);
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+} // namespace
+
+char DxilConstantTables::ID = 0;
+
+ModulePass *llvm::createDxilConstantTablesPass(unsigned MaxElements) {
+  return new DxilConstantTables(MaxElements);
+}
+
+INITIALIZE_PASS(DxilConstantTables, "hlsl-dxil-constant-tables",
+                "DXIL constant tables", false, false)
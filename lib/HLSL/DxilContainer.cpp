@@ -10,6 +10,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "dxc/HLSL/DxilContainer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compression.h"
 #include <algorithm>
 
 namespace hlsl {
@@ -122,4 +125,47 @@ DxilProgramHeader *GetDxilProgramHeader(DxilContainerHeader *pHeader, DxilFourCC
       GetDxilProgramHeader(static_cast<const DxilContainerHeader *>(pHeader), fourCC));
 }
 
+bool DecompressDxilPartData(const DxilPartHeader *pPart,
+                            llvm::SmallVectorImpl<char> &Data) {
+  if (pPart->PartSize < sizeof(DxilCompressedPartHeader))
+    return false;
+  const DxilCompressedPartHeader *pCompressedHeader =
+      reinterpret_cast<const DxilCompressedPartHeader *>(GetDxilPartData(pPart));
+  if (pCompressedHeader->CompressedSize >
+      pPart->PartSize - sizeof(DxilCompressedPartHeader))
+    return false;
+  if (pCompressedHeader->CompressionType !=
+      (uint32_t)DxilPartCompression::Zlib)
+    return false;
+
+  llvm::StringRef CompressedData(
+      reinterpret_cast<const char *>(pCompressedHeader + 1),
+      pCompressedHeader->CompressedSize);
+  Data.clear();
+  if (llvm::zlib::uncompress(CompressedData, Data,
+                             pCompressedHeader->UncompressedSize) !=
+      llvm::zlib::StatusOK)
+    return false;
+  return Data.size() == pCompressedHeader->UncompressedSize;
+}
+
+const DxilProgramHeader *
+GetDxilDebugProgramHeader(const DxilContainerHeader *pHeader,
+                          llvm::SmallVectorImpl<char> &Storage) {
+  if (const DxilProgramHeader *ProgramHeader =
+          GetDxilProgramHeader(pHeader, DFCC_ShaderDebugInfoDXIL)) {
+    return ProgramHeader;
+  }
+  const DxilPartHeader *PartHeader =
+      GetDxilPartByType(pHeader, DFCC_ShaderDebugInfoDXILCompressed);
+  if (!PartHeader || !DecompressDxilPartData(PartHeader, Storage)) {
+    return nullptr;
+  }
+  const DxilProgramHeader *ProgramHeader =
+      reinterpret_cast<const DxilProgramHeader *>(Storage.data());
+  return IsValidDxilProgramHeader(ProgramHeader, Storage.size())
+             ? ProgramHeader
+             : nullptr;
+}
+
 } // namespace hlsl
@@ -9,19 +9,25 @@
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/MD5.h"
 #include "dxc/HLSL/DxilContainer.h"
 #include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
 #include "dxc/HLSL/DxilShaderModel.h"
 #include "dxc/HLSL/DxilRootSignature.h"
 #include "dxc/Support/Global.h"
 #include "dxc/Support/Unicode.h"
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/Support/FileIOHelper.h"
+#include "dxc/Support/MemoryTracking.h"
 #include "dxc/Support/dxcapi.impl.h"
 #include "dxc/HLSL/DxilPipelineStateValidation.h"
 #include <algorithm>
@@ -145,15 +151,21 @@ private:
   uint32_t m_lastOffset;
   NameOffsetMap m_semanticNameOffsets;
   unsigned m_paramCount;
+  // With m_dedupStrings, elements with equal names share the string of the
+  // first one, and the strings are sorted.
+  bool m_dedupStrings;
+  llvm::StringMap<const char *> m_sharedNames;
 
   const char *GetSemanticName(const hlsl::DxilSignatureElement *pElement) {
     DXASSERT_NOMSG(pElement != nullptr);
     DXASSERT(pElement->GetName() != nullptr, "else sig is malformed");
-    return pElement->GetName();
+    const char *pName = pElement->GetName();
+    if (m_dedupStrings)
+      pName = m_sharedNames.insert(std::make_pair(pName, pName)).first->second;
+    return pName;
   }
 
-  uint32_t GetSemanticOffset(const hlsl::DxilSignatureElement *pElement) {
-    const char *pName = GetSemanticName(pElement);
+  uint32_t GetSemanticOffset(const char *pName) {
     NameOffsetMap::iterator nameOffset = m_semanticNameOffsets.find(pName);
     uint32_t result;
     if (nameOffset == m_semanticNameOffsets.end()) {
@@ -179,7 +191,7 @@ private:
     DxilProgramSignatureElement sig;
     memset(&sig, 0, sizeof(DxilProgramSignatureElement));
     sig.Stream = pElement->GetOutputStream();
-    sig.SemanticName = GetSemanticOffset(pElement);
+    sig.SemanticName = GetSemanticOffset(GetSemanticName(pElement));
     sig.SystemValue = KindToSystemValue(pElement->GetKind(), m_domain);
     sig.CompType = CompTypeToSigCompType(pElement->GetCompType());
     sig.Register = pElement->GetStartRow();
@@ -221,15 +233,32 @@ private:
     m_lastOffset = m_fixedSize;
 
     // Calculate size for semantic strings.
+    if (m_dedupStrings) {
+      // Sorted, so that every part lists the names it shares in one order.
+      std::vector<const char *> names;
+      for (size_t i = 0; i < elements.size(); ++i) {
+        DXIL::SemanticInterpretationKind I = elements[i]->GetInterpretation();
+        if (I == DXIL::SemanticInterpretationKind::NA || I == DXIL::SemanticInterpretationKind::NotInSig)
+          continue;
+        names.push_back(GetSemanticName(elements[i].get()));
+      }
+      std::sort(names.begin(), names.end(),
+                [](const char *a, const char *b) { return strcmp(a, b) < 0; });
+      for (const char *pName : names)
+        GetSemanticOffset(pName);
+      return;
+    }
     for (size_t i = 0; i < elements.size(); ++i) {
-      GetSemanticOffset(elements[i].get());
+      GetSemanticOffset(GetSemanticName(elements[i].get()));
     }
   }
 
 public:
   DxilProgramSignatureWriter(const DxilSignature &signature,
-                             DXIL::TessellatorDomain domain, bool isInput)
-      : m_signature(signature), m_domain(domain), m_isInput(isInput) {
+                             DXIL::TessellatorDomain domain, bool isInput,
+                             bool dedupStrings = false)
+      : m_signature(signature), m_domain(domain), m_isInput(isInput),
+        m_dedupStrings(dedupStrings) {
     calcSizes();
   }
 
@@ -278,17 +307,19 @@ public:
   }
 };
 
-DxilPartWriter *hlsl::NewProgramSignatureWriter(const DxilModule &M, DXIL::SignatureKind Kind) {
+DxilPartWriter *hlsl::NewProgramSignatureWriter(const DxilModule &M, DXIL::SignatureKind Kind,
+                                                bool bDedupStrings) {
   switch (Kind) {
   case DXIL::SignatureKind::Input:
     return new DxilProgramSignatureWriter(M.GetInputSignature(),
-      M.GetTessellatorDomain(), true);
+      M.GetTessellatorDomain(), true, bDedupStrings);
   case DXIL::SignatureKind::Output:
     return new DxilProgramSignatureWriter(M.GetOutputSignature(),
-      M.GetTessellatorDomain(), false);
+      M.GetTessellatorDomain(), false, bDedupStrings);
   case DXIL::SignatureKind::PatchConstant:
     return new DxilProgramSignatureWriter(M.GetPatchConstantSignature(),
-      M.GetTessellatorDomain(), /*IsInput*/ M.GetShaderModel()->IsDS());
+      M.GetTessellatorDomain(), /*IsInput*/ M.GetShaderModel()->IsDS(),
+      bDedupStrings);
   }
   return nullptr;
 }
@@ -339,6 +370,9 @@ private:
   uint32_t m_PSVBufferSize;
   SmallVector<char, 512> m_PSVBuffer;
   SmallVector<char, 256> m_StringBuffer;
+  // Offsets of the shared names, when strings are deduplicated.
+  bool m_bDedupStrings;
+  llvm::StringMap<uint32_t> m_StringOffsets;
   SmallVector<uint32_t, 8> m_SemanticIndexBuffer;
   std::vector<PSVSignatureElement0> m_SigInputElements;
   std::vector<PSVSignatureElement0> m_SigOutputElements;
@@ -346,7 +380,9 @@ private:
 
   void SetPSVSigElement(PSVSignatureElement0 &E, const DxilSignatureElement &SE) {
     memset(&E, 0, sizeof(PSVSignatureElement0));
-    if (SE.GetKind() == DXIL::SemanticKind::Arbitrary && strlen(SE.GetName()) > 0) {
+    if (m_bDedupStrings && HasSemanticName(SE)) {
+      E.SemanticName = m_StringOffsets.lookup(SE.GetName());
+    } else if (HasSemanticName(SE)) {
       E.SemanticName = (uint32_t)m_StringBuffer.size();
       StringRef Name(SE.GetName());
       m_StringBuffer.append(Name.size()+1, '\0');
@@ -396,6 +432,31 @@ private:
     E.DynamicMaskAndStream |= (SE.GetDynIdxCompMask()) & 0xF;
   }
 
+  static bool HasSemanticName(const DxilSignatureElement &SE) {
+    return SE.GetKind() == DXIL::SemanticKind::Arbitrary && strlen(SE.GetName()) > 0;
+  }
+
+  // Writes each distinct name once, sorted as the signature parts do.
+  void AddSharedNames() {
+    std::vector<StringRef> Names;
+    const DxilSignature *Sigs[] = { &m_Module.GetInputSignature(),
+                                    &m_Module.GetOutputSignature(),
+                                    &m_Module.GetPatchConstantSignature() };
+    for (const DxilSignature *Sig : Sigs) {
+      for (auto &SE : Sig->GetElements()) {
+        if (HasSemanticName(*SE))
+          Names.push_back(SE->GetName());
+      }
+    }
+    std::sort(Names.begin(), Names.end());
+    Names.erase(std::unique(Names.begin(), Names.end()), Names.end());
+    for (StringRef Name : Names) {
+      m_StringOffsets[Name] = (uint32_t)m_StringBuffer.size();
+      m_StringBuffer.append(Name.begin(), Name.end());
+      m_StringBuffer.push_back('\0');
+    }
+  }
+
   const uint32_t *CopyViewIDState(const uint32_t *pSrc, uint32_t InputScalars, uint32_t OutputScalars, PSVComponentMask ViewIDMask, PSVDependencyTable IOTable) {
     unsigned MaskDwords = PSVComputeMaskDwordsFromVectors(PSVALIGN4(OutputScalars) / 4);
     if (ViewIDMask.IsValid()) {
@@ -413,9 +474,11 @@ private:
   }
 
 public:
-  DxilPSVWriter(const DxilModule &module, uint32_t PSVVersion = 0)
+  DxilPSVWriter(const DxilModule &module, uint32_t PSVVersion = 0,
+                bool bDedupStrings = false)
   : m_Module(module),
-    m_PSVInitInfo(PSVVersion)
+    m_PSVInitInfo(PSVVersion),
+    m_bDedupStrings(bDedupStrings)
   {
     unsigned ValMajor, ValMinor;
     m_Module.GetValidatorVersion(ValMajor, ValMinor);
@@ -433,6 +496,8 @@ public:
       m_PSVInitInfo.ShaderStage = (PSVShaderKind)SM->GetKind();
       // Copy Dxil Signatures
       m_StringBuffer.push_back('\0'); // For empty semantic name (system value)
+      if (m_bDedupStrings)
+        AddSharedNames();
       m_PSVInitInfo.SigInputElements = m_Module.GetInputSignature().GetElements().size();
       m_SigInputElements.resize(m_PSVInitInfo.SigInputElements);
       m_PSVInitInfo.SigOutputElements = m_Module.GetOutputSignature().GetElements().size();
@@ -682,14 +747,82 @@ public:
       }
     }
 
+    // Index the bindings and signatures written above
+    m_PSV.BuildIndexes();
+
     ULONG cbWritten;
     IFT(pStream->Write(m_PSVBuffer.data(), m_PSVBufferSize, &cbWritten));
     DXASSERT_NOMSG(cbWritten == m_PSVBufferSize);
   }
 };
 
-DxilPartWriter *hlsl::NewPSVWriter(const DxilModule &M, uint32_t PSVVersion) {
-  return new DxilPSVWriter(M, PSVVersion);
+DxilPartWriter *hlsl::NewPSVWriter(const DxilModule &M, uint32_t PSVVersion,
+                                   bool bDedupStrings) {
+  return new DxilPSVWriter(M, PSVVersion, bDedupStrings);
+}
+
+namespace {
+// Accumulates a container digest one region at a time. The regions are the
+// header after its hash field plus the offset table, then each part with its
+// header, so the fast hash depends on the container layout but not on how
+// the bytes were produced.
+class DxilContainerDigestBuilder {
+private:
+  DxilContainerDigestKind m_Kind;
+  llvm::MD5 m_MD5;
+  llvm::hash_code m_Fast;
+
+public:
+  DxilContainerDigestBuilder(DxilContainerDigestKind Kind)
+      : m_Kind(Kind), m_Fast(0) {}
+
+  void Update(const uint8_t *pData, size_t Size) {
+    switch (m_Kind) {
+    case DxilContainerDigestKind::MD5:
+      m_MD5.update(llvm::ArrayRef<uint8_t>(pData, Size));
+      break;
+    case DxilContainerDigestKind::Fast:
+      m_Fast = llvm::hash_combine(m_Fast,
+                                  llvm::hash_combine_range(pData, pData + Size));
+      break;
+    case DxilContainerDigestKind::None:
+      break;
+    }
+  }
+
+  void Final(DxilContainerHash *pDigest) {
+    memset(pDigest->Digest, 0, sizeof(pDigest->Digest));
+    if (m_Kind == DxilContainerDigestKind::MD5) {
+      llvm::MD5::MD5Result md5Result;
+      m_MD5.final(md5Result);
+      static_assert(sizeof(md5Result) == sizeof(pDigest->Digest),
+                    "MD5 result must fill the container hash");
+      memcpy(pDigest->Digest, md5Result, sizeof(md5Result));
+    } else if (m_Kind == DxilContainerDigestKind::Fast) {
+      uint64_t value = (size_t)m_Fast;
+      memcpy(pDigest->Digest, &value, sizeof(value));
+    }
+  }
+};
+
+const size_t kDigestStartOffset = offsetof(DxilContainerHeader, Version);
+}
+
+void hlsl::ComputeDxilContainerDigest(const DxilContainerHeader *pHeader,
+                                      DxilContainerDigestKind Kind,
+                                      DxilContainerHash *pDigest) {
+  DXASSERT_NOMSG(pHeader != nullptr && pDigest != nullptr);
+  DxilContainerDigestBuilder digest(Kind);
+  const uint8_t *pBase = (const uint8_t *)pHeader;
+  digest.Update(pBase + kDigestStartOffset,
+                sizeof(DxilContainerHeader) - kDigestStartOffset +
+                    GetOffsetTableSize(pHeader->PartCount));
+  for (uint32_t i = 0; i < pHeader->PartCount; ++i) {
+    const DxilPartHeader *pPart = GetDxilContainerPart(pHeader, i);
+    digest.Update((const uint8_t *)pPart,
+                  sizeof(DxilPartHeader) + pPart->PartSize);
+  }
+  digest.Final(pDigest);
 }
 
 class DxilContainerWriter_impl : public DxilContainerWriter  {
@@ -705,12 +838,39 @@ private:
   };
 
   llvm::SmallVector<DxilPart, 8> m_Parts;
+  DxilContainerDigestKind m_DigestKind;
+  DxilContainerHash m_Digest;
+  bool m_HasTrailingPart;
+  uint32_t m_TrailingSizeHint;
 
 public:
+  DxilContainerWriter_impl()
+      : m_DigestKind(DxilContainerDigestKind::None), m_HasTrailingPart(false),
+        m_TrailingSizeHint(0) {
+    memset(&m_Digest, 0, sizeof(m_Digest));
+  }
+
   __override void AddPart(uint32_t FourCC, uint32_t Size, WriteFn Write) {
+    DXASSERT(!m_HasTrailingPart, "else a part follows the trailing part");
     m_Parts.emplace_back(FourCC, Size, Write);
   }
 
+  __override void AddTrailingPart(uint32_t FourCC, uint32_t SizeHint,
+                                  WriteFn Write) {
+    DXASSERT(!m_HasTrailingPart, "else there are two trailing parts");
+    m_Parts.emplace_back(FourCC, 0, Write);
+    m_HasTrailingPart = true;
+    m_TrailingSizeHint = SizeHint;
+  }
+
+  __override void SetDigestKind(DxilContainerDigestKind Kind) {
+    m_DigestKind = Kind;
+  }
+
+  __override void GetDigest(DxilContainerHash *pDigest) const {
+    *pDigest = m_Digest;
+  }
+
   __override uint32_t size() const {
     uint32_t partSize = 0;
     for (auto &part : m_Parts) {
@@ -724,20 +884,54 @@ public:
     const uint32_t PartCount = (uint32_t)m_Parts.size();
     uint32_t containerSizeInBytes = size();
     InitDxilContainer(&header, PartCount, containerSizeInBytes);
-    IFT(pStream->Reserve(header.ContainerSizeInBytes));
+    IFT(pStream->Reserve(header.ContainerSizeInBytes + m_TrailingSizeHint));
+    // Each region is hashed right after it is written, while it is still hot
+    // in the cache; the stream is reserved, so its buffer does not move.
+    // A trailing part changes the sizes in the header after the fact, so the
+    // digest is then computed once the container is complete.
+    bool digestAsWritten =
+        m_DigestKind != DxilContainerDigestKind::None && !m_HasTrailingPart;
+    DxilContainerDigestBuilder digest(m_DigestKind);
+    size_t containerStart = (size_t)pStream->GetPosition();
     IFT(WriteStreamValue(pStream, header));
     uint32_t offset = sizeof(header) + (uint32_t)GetOffsetTableSize(PartCount);
     for (auto &&part : m_Parts) {
       IFT(WriteStreamValue(pStream, offset));
       offset += sizeof(DxilPartHeader) + part.Header.PartSize;
     }
+    if (digestAsWritten) {
+      digest.Update(pStream->GetPtr() + containerStart + kDigestStartOffset,
+                    (size_t)pStream->GetPosition() - containerStart - kDigestStartOffset);
+    }
+    size_t partStart = 0;
     for (auto &&part : m_Parts) {
+      partStart = (size_t)pStream->GetPosition();
       IFT(WriteStreamValue(pStream, part.Header));
       size_t start = pStream->GetPosition();
       part.Write(pStream);
-      DXASSERT_LOCALVAR(start, pStream->GetPosition() - start == (size_t)part.Header.PartSize, "out of bound");
+      DXASSERT_LOCALVAR(start, (m_HasTrailingPart && &part == &m_Parts.back()) ||
+                        pStream->GetPosition() - start == (size_t)part.Header.PartSize, "out of bound");
+      if (digestAsWritten) {
+        digest.Update(pStream->GetPtr() + partStart,
+                      (size_t)pStream->GetPosition() - partStart);
+      }
+    }
+
+    if (m_HasTrailingPart) {
+      // Patch the sizes now that the trailing part has been written in place.
+      uint32_t trailingSize = (uint32_t)(pStream->GetPosition() - partStart -
+                                         sizeof(DxilPartHeader));
+      DXASSERT(trailingSize % 4 == 0, "else trailing part is not padded");
+      containerSizeInBytes += trailingSize;
+      DxilContainerHeader *pHeader =
+          (DxilContainerHeader *)(pStream->GetPtr() + containerStart);
+      pHeader->ContainerSizeInBytes = containerSizeInBytes;
+      ((DxilPartHeader *)(pStream->GetPtr() + partStart))->PartSize = trailingSize;
+      ComputeDxilContainerDigest(pHeader, m_DigestKind, &m_Digest);
+    } else {
+      digest.Final(&m_Digest);
     }
-    DXASSERT(containerSizeInBytes == (uint32_t)pStream->GetPosition(), "else stream size is incorrect");
+    DXASSERT(containerStart + containerSizeInBytes == (size_t)pStream->GetPosition(), "else stream size is incorrect");
   }
 };
 
@@ -764,17 +958,156 @@ static void GetPaddedProgramPartSize(AbstractMemoryStream *pStream,
   bitcodeInUInt32 = (bitcodeInUInt32 / 4) + (bitcodePaddingBytes ? 1 : 0);
 }
 
-static void WriteProgramPart(const ShaderModel *pModel,
-                             AbstractMemoryStream *pModuleBitcode,
-                             AbstractMemoryStream *pStream) {
+static void InitProgramHeaderForModel(const ShaderModel *pModel,
+                                      DxilProgramHeader &programHeader,
+                                      uint32_t bitcodeSize) {
   DXASSERT(pModel != nullptr, "else generation should have failed");
-  DxilProgramHeader programHeader;
   uint32_t shaderVersion =
       EncodeVersion(pModel->GetKind(), pModel->GetMajor(), pModel->GetMinor());
   unsigned dxilMajor, dxilMinor;
   pModel->GetDxilVersion(dxilMajor, dxilMinor);
   uint32_t dxilVersion = DXIL::MakeDxilVersion(dxilMajor, dxilMinor);
-  InitProgramHeader(programHeader, shaderVersion, dxilVersion, pModuleBitcode->GetPtrSize());
+  InitProgramHeader(programHeader, shaderVersion, dxilVersion, bitcodeSize);
+}
+
+namespace {
+// Computes the hash in the debug name of a container: 32 hex digits of MD5
+// by default, or 16 hex digits of XXH64 with seed 0 for the fast scheme.
+// The bytes are fed in as the bitcode is written, so that hashing does not
+// read the whole bitcode again afterwards.
+class DebugNameHasher {
+private:
+  static const uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+  static const uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+  static const uint64_t Prime3 = 0x165667B19E3779F9ULL;
+  static const uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+  static const uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+  bool m_Fast;
+  llvm::MD5 m_MD5;
+  uint64_t m_Acc[4];
+  uint8_t m_Pending[32];
+  size_t m_PendingSize;
+  uint64_t m_TotalSize;
+
+  static uint64_t Rotl(uint64_t x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+  }
+  static uint64_t Round(uint64_t acc, uint64_t input) {
+    return Rotl(acc + input * Prime2, 31) * Prime1;
+  }
+  static uint64_t MergeRound(uint64_t acc, uint64_t value) {
+    return (acc ^ Round(0, value)) * Prime1 + Prime4;
+  }
+  void ConsumeStripe(const uint8_t *pData) {
+    for (unsigned i = 0; i < 4; ++i)
+      m_Acc[i] = Round(m_Acc[i], support::endian::read64le(pData + i * 8));
+  }
+
+public:
+  DebugNameHasher(bool Fast)
+      : m_Fast(Fast), m_PendingSize(0), m_TotalSize(0) {
+    m_Acc[0] = Prime1 + Prime2;
+    m_Acc[1] = Prime2;
+    m_Acc[2] = 0;
+    m_Acc[3] = 0 - Prime1;
+  }
+
+  static uint32_t GetHashLength(bool Fast) { return Fast ? 16 : 32; }
+
+  void Update(const uint8_t *pData, size_t Size) {
+    if (!m_Fast) {
+      m_MD5.update(ArrayRef<uint8_t>(pData, Size));
+      return;
+    }
+    m_TotalSize += Size;
+    if (m_PendingSize) {
+      size_t fill = std::min(Size, sizeof(m_Pending) - m_PendingSize);
+      memcpy(m_Pending + m_PendingSize, pData, fill);
+      m_PendingSize += fill;
+      pData += fill;
+      Size -= fill;
+      if (m_PendingSize < sizeof(m_Pending))
+        return;
+      ConsumeStripe(m_Pending);
+      m_PendingSize = 0;
+    }
+    for (; Size >= sizeof(m_Pending); pData += 32, Size -= 32)
+      ConsumeStripe(pData);
+    memcpy(m_Pending, pData, Size);
+    m_PendingSize = Size;
+  }
+
+  void Final(SmallString<32> &Hash) {
+    if (!m_Fast) {
+      llvm::MD5::MD5Result md5Result;
+      m_MD5.final(md5Result);
+      m_MD5.stringifyResult(md5Result, Hash);
+      return;
+    }
+    uint64_t h;
+    if (m_TotalSize >= 32) {
+      h = Rotl(m_Acc[0], 1) + Rotl(m_Acc[1], 7) + Rotl(m_Acc[2], 12) +
+          Rotl(m_Acc[3], 18);
+      for (unsigned i = 0; i < 4; ++i)
+        h = MergeRound(h, m_Acc[i]);
+    } else {
+      h = Prime5;
+    }
+    h += m_TotalSize;
+    const uint8_t *p = m_Pending;
+    const uint8_t *pEnd = m_Pending + m_PendingSize;
+    for (; p + 8 <= pEnd; p += 8)
+      h = Rotl(h ^ Round(0, support::endian::read64le(p)), 27) * Prime1 + Prime4;
+    if (p + 4 <= pEnd) {
+      h = Rotl(h ^ (support::endian::read32le(p) * Prime1), 23) * Prime2 + Prime3;
+      p += 4;
+    }
+    for (; p < pEnd; ++p)
+      h = Rotl(h ^ (*p * Prime5), 11) * Prime1;
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+
+    // Most significant digit first, as xxhsum prints it.
+    static const char Digits[] = "0123456789abcdef";
+    Hash.resize(16);
+    for (unsigned i = 0; i < 16; ++i)
+      Hash[i] = Digits[(h >> (60 - i * 4)) & 0xf];
+  }
+};
+
+// Writes through to a memory stream, hashing what is written.
+class raw_hashing_stream_ostream : public llvm::raw_ostream {
+private:
+  CComPtr<AbstractMemoryStream> m_pStream;
+  DebugNameHasher *m_pHasher;
+  void write_impl(const char *Ptr, size_t Size) override {
+    ULONG cbWritten;
+    IFT(m_pStream->Write(Ptr, Size, &cbWritten));
+    if (m_pHasher)
+      m_pHasher->Update((const uint8_t *)Ptr, Size);
+  }
+  uint64_t current_pos() const override { return m_pStream->GetPosition(); }
+
+public:
+  raw_hashing_stream_ostream(AbstractMemoryStream *pStream,
+                             DebugNameHasher *pHasher)
+      : m_pStream(pStream), m_pHasher(pHasher) {}
+  ~raw_hashing_stream_ostream() override { flush(); }
+};
+}
+
+// Writes the program part for existing bitcode. With pHasher, the bitcode
+// must be contiguous; it is fed to the hasher as it is copied.
+static void WriteProgramPart(const ShaderModel *pModel,
+                             AbstractMemoryStream *pModuleBitcode,
+                             AbstractMemoryStream *pStream,
+                             DebugNameHasher *pHasher = nullptr) {
+  DxilProgramHeader programHeader;
+  InitProgramHeaderForModel(pModel, programHeader, pModuleBitcode->GetPtrSize());
 
   uint32_t programInUInt32, programPaddingBytes;
   GetPaddedProgramPartSize(pModuleBitcode, programInUInt32,
@@ -782,18 +1115,65 @@ static void WriteProgramPart(const ShaderModel *pModel,
 
   ULONG cbWritten;
   IFT(WriteStreamValue(pStream, programHeader));
-  IFT(pStream->Write(pModuleBitcode->GetPtr(), pModuleBitcode->GetPtrSize(),
-                     &cbWritten));
+  if (pHasher) {
+    // Hash each chunk right before it is copied, while it is in the cache.
+    const size_t ChunkSize = 64 * 1024;
+    const uint8_t *pData = (const uint8_t *)pModuleBitcode->GetPtr();
+    size_t size = pModuleBitcode->GetPtrSize();
+    for (size_t offset = 0; offset < size; offset += ChunkSize) {
+      size_t chunk = std::min(ChunkSize, size - offset);
+      pHasher->Update(pData + offset, chunk);
+      IFT(pStream->Write(pData + offset, (ULONG)chunk, &cbWritten));
+    }
+  } else {
+    IFT(CopyMemoryStream(pModuleBitcode, pStream));
+  }
+  if (programPaddingBytes) {
+    uint32_t paddingValue = 0;
+    IFT(pStream->Write(&paddingValue, programPaddingBytes, &cbWritten));
+  }
+}
+
+// Writes the program part for the current state of M, serializing the
+// bitcode in place and then filling in the header with its size.
+//
+// Libraries are re-encoded whole even when few functions changed. A
+// function block refers to types, globals and metadata by their module-wide
+// numbers and picks abbreviation widths from the module's table sizes, so
+// any change elsewhere in the module can change its bytes. Telling whether
+// an old block is still valid means walking the same operands the writer
+// encodes, which costs about as much as encoding the block again.
+//
+// With pHasher, the bitcode is fed to the hasher as it is written.
+static void WriteProgramPart(const ShaderModel *pModel, Module *M,
+                             AbstractMemoryStream *pStream,
+                             DebugNameHasher *pHasher = nullptr) {
+  DxilProgramHeader programHeader;
+  InitProgramHeaderForModel(pModel, programHeader, 0);
+  size_t headerPosition = (size_t)pStream->GetPosition();
+  IFT(WriteStreamValue(pStream, programHeader));
+  size_t bitcodePosition = (size_t)pStream->GetPosition();
+  {
+    raw_hashing_stream_ostream outStream(pStream, pHasher);
+    WriteBitcodeToFile(M, outStream, true);
+  }
+  uint32_t bitcodeSize = (uint32_t)(pStream->GetPosition() - bitcodePosition);
+  uint32_t programPaddingBytes = (4 - (bitcodeSize % 4)) % 4;
   if (programPaddingBytes) {
+    ULONG cbWritten;
     uint32_t paddingValue = 0;
     IFT(pStream->Write(&paddingValue, programPaddingBytes, &cbWritten));
   }
+  InitProgramHeaderForModel(pModel, programHeader, bitcodeSize);
+  memcpy(pStream->GetPtr() + headerPosition, &programHeader, sizeof(programHeader));
 }
 
 void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
                                            AbstractMemoryStream *pModuleBitcode,
                                            AbstractMemoryStream *pFinalStream,
-                                           SerializeDxilFlags Flags) {
+                                           SerializeDxilFlags Flags,
+                                           DxilContainerDigestKind DigestKind,
+                                           DxilContainerHash *pDigest) {
   // TODO: add a flag to update the module and remove information that is not part
   // of DXIL proper and is used only to assemble the container.
 
@@ -806,13 +1186,16 @@ void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
   if (ValMajor == 1 && ValMinor == 0)
     Flags &= ~SerializeDxilFlags::IncludeDebugNamePart;
 
+  const bool bDedupStrings = (Flags & SerializeDxilFlags::DeduplicateStrings) != 0;
   DxilProgramSignatureWriter inputSigWriter(pModule->GetInputSignature(),
                                             pModule->GetTessellatorDomain(),
-                                            /*IsInput*/ true);
+                                            /*IsInput*/ true, bDedupStrings);
   DxilProgramSignatureWriter outputSigWriter(pModule->GetOutputSignature(),
                                              pModule->GetTessellatorDomain(),
-                                             /*IsInput*/ false);
-  DxilPSVWriter PSVWriter(*pModule);
+                                             /*IsInput*/ false, bDedupStrings);
+  DxilPSVWriter PSVWriter(*pModule,
+                          (Flags & SerializeDxilFlags::IncludePSVIndexes) ? 2 : 0,
+                          bDedupStrings);
   DxilContainerWriter_impl writer;
 
   // Write the feature part.
@@ -831,7 +1214,7 @@ void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
 
   DxilProgramSignatureWriter patchConstantSigWriter(
       pModule->GetPatchConstantSignature(), pModule->GetTessellatorDomain(),
-      /*IsInput*/ pModule->GetShaderModel()->IsDS());
+      /*IsInput*/ pModule->GetShaderModel()->IsDS(), bDedupStrings);
 
   if (pModule->GetPatchConstantSignature().GetElements().size()) {
     writer.AddPart(DFCC_PatchConstantSignature, patchConstantSigWriter.size(),
@@ -847,49 +1230,115 @@ void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
 
   // Write the root signature (RTS0) part.
   DxilProgramRootSignatureWriter rootSigWriter(pModule->GetRootSignature());
-  CComPtr<AbstractMemoryStream> pInputProgramStream = pModuleBitcode;
+  // pModuleBitcode is the program until the module is changed below; from
+  // then on the program is serialized straight into its part.
+  bool bModuleBitcodeCurrent = true;
   if (!pModule->GetRootSignature().IsEmpty()) {
     writer.AddPart(
         DFCC_RootSignature, rootSigWriter.size(),
         [&](AbstractMemoryStream *pStream) { rootSigWriter.write(pStream); });
-    pModule->StripRootSignatureFromMetadata();
-    pInputProgramStream.Release();
-    CComPtr<IMalloc> pMalloc;
-    IFT(CoGetMalloc(1, &pMalloc));
-    IFT(CreateMemoryStream(pMalloc, &pInputProgramStream));
-    raw_stream_ostream outStream(pInputProgramStream.p);
-    WriteBitcodeToFile(pModule->GetModule(), outStream, true);
+    // Compiles leave the root signature out of the metadata, so their
+    // bitcode needs no rewrite without it.
+    if (pModule->GetModule()->getNamedMetadata(
+            DxilMDHelper::kDxilRootSignatureMDName)) {
+      pModule->StripRootSignatureFromMetadata();
+      bModuleBitcodeCurrent = false;
+    }
   }
 
   // If we have debug information present, serialize it to a debug part, then use the stripped version as the canonical program version.
-  CComPtr<AbstractMemoryStream> pProgramStream = pInputProgramStream;
+  CComPtr<AbstractMemoryStream> pInputProgramStream = pModuleBitcode;
+  CComPtr<AbstractMemoryStream> pDebugPartStream;
+  SmallVector<char, 0> CompressedDebugPart;
+  bool bHashProgramForDebugName = false;
+  size_t debugNameHashPosition = 0;
+  const bool bFastDebugName = (Flags & SerializeDxilFlags::DebugNameFastHash) != 0;
+  DebugNameHasher debugNameHasher(bFastDebugName);
+  // The debug part copy that feeds the source-dependent name, if any, and
+  // whether it has been written.
+  DebugNameHasher *pSourceNameHasher = nullptr;
+  bool bDebugNameHashed = false;
   if (HasDebugInfo(*pModule->GetModule())) {
+    if ((Flags & SerializeDxilFlags::IncludeDebugInfoPart) &&
+        !bModuleBitcodeCurrent) {
+      // The debug part has everything but the root signature.
+      pInputProgramStream.Release();
+      CComPtr<IMalloc> pMalloc;
+      IFT(DxcGetOperationMalloc(&pMalloc));
+      // The debug bitcode is only copied into its part, so it need not be
+      // contiguous.
+      IFT(CreateChunkedMemoryStream(pMalloc, &pInputProgramStream));
+      raw_stream_ostream outStream(pInputProgramStream.p);
+      WriteBitcodeToFile(pModule->GetModule(), outStream, true);
+    }
+    // The source-dependent name hashes pModuleBitcode, so it is hashed on
+    // its way into the debug part when that part holds the same bytes.
+    pSourceNameHasher =
+        (Flags & SerializeDxilFlags::IncludeDebugNamePart) &&
+                (Flags & SerializeDxilFlags::DebugNameDependOnSource) &&
+                pInputProgramStream.p == pModuleBitcode
+            ? &debugNameHasher
+            : nullptr;
     uint32_t debugInUInt32, debugPaddingBytes;
     GetPaddedProgramPartSize(pInputProgramStream, debugInUInt32, debugPaddingBytes);
-    if (Flags & SerializeDxilFlags::IncludeDebugInfoPart) {
+    if ((Flags & SerializeDxilFlags::IncludeDebugInfoPart) &&
+        (Flags & SerializeDxilFlags::CompressDebugInfoPart) &&
+        llvm::zlib::isAvailable()) {
+      CComPtr<IMalloc> pMalloc;
+      IFT(DxcGetOperationMalloc(&pMalloc));
+      IFT(CreateMemoryStream(pMalloc, &pDebugPartStream));
+      WriteProgramPart(pModule->GetShaderModel(), pInputProgramStream,
+                       pDebugPartStream, pSourceNameHasher);
+      bDebugNameHashed = pSourceNameHasher != nullptr;
+      StringRef DebugPartData((const char *)pDebugPartStream->GetPtr(),
+                              pDebugPartStream->GetPtrSize());
+      // Keep the plain part if compression fails or does not pay for itself.
+      if (llvm::zlib::compress(DebugPartData, CompressedDebugPart,
+                               llvm::zlib::BestSizeCompression) != llvm::zlib::StatusOK ||
+          sizeof(DxilCompressedPartHeader) + CompressedDebugPart.size() >=
+              DebugPartData.size()) {
+        CompressedDebugPart.clear();
+      }
+    }
+    if (!CompressedDebugPart.empty()) {
+      uint32_t compressedSize = CompressedDebugPart.size();
+      uint32_t compressedPaddingBytes = (4 - (compressedSize % 4)) % 4;
+      writer.AddPart(DFCC_ShaderDebugInfoDXILCompressed,
+                     sizeof(DxilCompressedPartHeader) + compressedSize + compressedPaddingBytes,
+                     [&](AbstractMemoryStream *pStream) {
+        DxilCompressedPartHeader CompressedHeader;
+        CompressedHeader.CompressionType = (uint32_t)DxilPartCompression::Zlib;
+        CompressedHeader.UncompressedSize = pDebugPartStream->GetPtrSize();
+        CompressedHeader.CompressedSize = compressedSize;
+        IFT(WriteStreamValue(pStream, CompressedHeader));
+        ULONG cbWritten;
+        IFT(pStream->Write(CompressedDebugPart.data(), compressedSize, &cbWritten));
+        if (compressedPaddingBytes) {
+          uint32_t paddingValue = 0;
+          IFT(pStream->Write(&paddingValue, compressedPaddingBytes, &cbWritten));
+        }
+      });
+    } else if (Flags & SerializeDxilFlags::IncludeDebugInfoPart) {
       writer.AddPart(DFCC_ShaderDebugInfoDXIL, debugInUInt32 * sizeof(uint32_t) + sizeof(DxilProgramHeader), [&](AbstractMemoryStream *pStream) {
-        WriteProgramPart(pModule->GetShaderModel(), pInputProgramStream, pStream);
+        DebugNameHasher *pHasher = bDebugNameHashed ? nullptr : pSourceNameHasher;
+        WriteProgramPart(pModule->GetShaderModel(), pInputProgramStream, pStream,
+                         pHasher);
+        bDebugNameHashed |= pHasher != nullptr;
       });
     }
 
-    pProgramStream.Release();
-
     llvm::StripDebugInfo(*pModule->GetModule());
     pModule->StripDebugRelatedCode();
-
-    CComPtr<IMalloc> pMalloc;
-    IFT(CoGetMalloc(1, &pMalloc));
-    IFT(CreateMemoryStream(pMalloc, &pProgramStream));
-    raw_stream_ostream outStream(pProgramStream.p);
-    WriteBitcodeToFile(pModule->GetModule(), outStream, true);
+    bModuleBitcodeCurrent = false;
 
     if (Flags & SerializeDxilFlags::IncludeDebugNamePart) {
-      CComPtr<AbstractMemoryStream> pHashStream;
       // If the debug name should be specific to the sources, base the name on the debug
       // bitcode, which will include the source references, line numbers, etc. Otherwise,
-      // do it exclusively on the target shader bitcode.
-      pHashStream = (int)(Flags & SerializeDxilFlags::DebugNameDependOnSource) ? pModuleBitcode : pProgramStream;
-      const uint32_t DebugInfoNameHashLen = 32;   // 32 chars of MD5
+      // do it exclusively on the target shader bitcode, which only exists once the
+      // program part is written; the hash is filled in after the container is.
+      bHashProgramForDebugName = !(Flags & SerializeDxilFlags::DebugNameDependOnSource);
+      const uint32_t DebugInfoNameHashLen =       // hex chars of the hash
+          DebugNameHasher::GetHashLength(bFastDebugName);
       const uint32_t DebugInfoNameSuffix = 4;     // '.lld'
       const uint32_t DebugInfoNameNullAndPad = 4; // '\0\0\0\0'
       const uint32_t DebugInfoContentLen =
@@ -901,13 +1350,16 @@ void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
         NameContent.NameLength = DebugInfoNameHashLen + DebugInfoNameSuffix;
         IFT(WriteStreamValue(pStream, NameContent));
 
-        ArrayRef<uint8_t> Data((uint8_t *)pHashStream->GetPtr(), pHashStream->GetPtrSize());
-        llvm::MD5 md5;
-        llvm::MD5::MD5Result md5Result;
         SmallString<32> Hash;
-        md5.update(Data);
-        md5.final(md5Result);
-        md5.stringifyResult(md5Result, Hash);
+        if (bHashProgramForDebugName) {
+          debugNameHashPosition = (size_t)pStream->GetPosition();
+          Hash.assign(DebugInfoNameHashLen, '0');
+        } else {
+          if (!bDebugNameHashed)
+            debugNameHasher.Update((const uint8_t *)pModuleBitcode->GetPtr(),
+                                   pModuleBitcode->GetPtrSize());
+          debugNameHasher.Final(Hash);
+        }
 
         ULONG cbWritten;
         IFT(pStream->Write(Hash.data(), Hash.size(), &cbWritten));
@@ -917,16 +1369,35 @@ void hlsl::SerializeDxilContainerForModule(DxilModule *pModule,
     }
   }
 
-  // Compute padded bitcode size.
-  uint32_t programInUInt32, programPaddingBytes;
-  GetPaddedProgramPartSize(pProgramStream, programInUInt32, programPaddingBytes);
-
   // Write the program part.
-  writer.AddPart(DFCC_DXIL, programInUInt32 * sizeof(uint32_t) + sizeof(DxilProgramHeader), [&](AbstractMemoryStream *pStream) {
-    WriteProgramPart(pModule->GetShaderModel(), pProgramStream, pStream);
-  });
+  if (bModuleBitcodeCurrent) {
+    uint32_t programInUInt32, programPaddingBytes;
+    GetPaddedProgramPartSize(pModuleBitcode, programInUInt32, programPaddingBytes);
+    writer.AddPart(DFCC_DXIL, programInUInt32 * sizeof(uint32_t) + sizeof(DxilProgramHeader), [&](AbstractMemoryStream *pStream) {
+      WriteProgramPart(pModule->GetShaderModel(), pModuleBitcode, pStream);
+    });
+  } else {
+    // The stripped program is no larger than the bitcode it came from.
+    writer.AddTrailingPart(DFCC_DXIL, pModuleBitcode->GetPtrSize() + sizeof(DxilProgramHeader) + 4, [&](AbstractMemoryStream *pStream) {
+      WriteProgramPart(pModule->GetShaderModel(), pModule->GetModule(), pStream,
+                       bHashProgramForDebugName ? &debugNameHasher : nullptr);
+    });
+  }
 
+  size_t containerStart = (size_t)pFinalStream->GetPosition();
+  writer.SetDigestKind(pDigest && !bHashProgramForDebugName ? DigestKind : DxilContainerDigestKind::None);
   writer.write(pFinalStream);
+  if (bHashProgramForDebugName) {
+    const DxilContainerHeader *pContainer =
+        (const DxilContainerHeader *)(pFinalStream->GetPtr() + containerStart);
+    SmallString<32> Hash;
+    debugNameHasher.Final(Hash);
+    memcpy(pFinalStream->GetPtr() + debugNameHashPosition, Hash.data(), Hash.size());
+    if (pDigest)
+      ComputeDxilContainerDigest(pContainer, DigestKind, pDigest);
+  } else if (pDigest) {
+    writer.GetDigest(pDigest);
+  }
 }
 
 void hlsl::SerializeDxilContainerForRootSignature(hlsl::RootSignatureHandle *pRootSigHandle,
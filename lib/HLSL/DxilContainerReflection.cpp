@@ -10,9 +10,12 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "dxc/HLSL/DxilContainer.h"
+#include "dxc/HLSL/DxilGenerationPass.h"
 #include "dxc/HLSL/DxilModule.h"
 #include "dxc/HLSL/DxilShaderModel.h"
 #include "dxc/HLSL/DxilOperations.h"
@@ -24,6 +27,8 @@
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/dxcapi.impl.h"
 
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 
 #include "dxc/dxcapi.h"
@@ -44,13 +49,23 @@ const GUID IID_ID3D11ShaderReflection_47 = {
 using namespace llvm;
 using namespace hlsl;
 
+class DxilShaderReflectionState;
+
+// Load must not race with other calls; once a container is loaded, every
+// method may be called concurrently. The reflection state of each program
+// part is loaded on first request and shared by every reflection object
+// GetPartReflection returns for it afterwards.
 class DxilContainerReflection : public IDxcContainerReflection {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
   CComPtr<IDxcBlob> m_container;
   const DxilContainerHeader *m_pHeader;
   uint32_t m_headerLen;
+  std::mutex m_partStatesLock;
+  std::vector<std::shared_ptr<DxilShaderReflectionState>> m_partStates;
   bool IsLoaded() const { return m_pHeader != nullptr; }
+  HRESULT LoadPartState(const DxilPartHeader *pPart,
+                        std::shared_ptr<DxilShaderReflectionState> &pState);
 public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
@@ -68,9 +83,11 @@ public:
 
 class CShaderReflectionConstantBuffer;
 class CShaderReflectionType;
-class DxilShaderReflection : public ID3D12ShaderReflection {
-private:
-  DXC_MICROCOM_REF_FIELD(m_dwRef)
+// The reflection data of one program part. It is built by Load and never
+// modified afterwards, which lets any number of DxilShaderReflection objects
+// query it from any thread.
+class DxilShaderReflectionState {
+public:
   CComPtr<IDxcBlob> m_pContainer;
   LLVMContext Context;
   std::unique_ptr<Module> m_pModule; // Must come after LLVMContext, otherwise unique_ptr will over-delete.
@@ -82,7 +99,15 @@ private:
   std::vector<D3D12_SIGNATURE_PARAMETER_DESC>     m_PatchConstantSignature;
   std::vector<std::unique_ptr<char[]>>            m_UpperCaseNames;
   std::vector<std::unique_ptr<CShaderReflectionType>> m_Types;
+  DxcComputeShaderSummary m_ComputeSummary; // Only set for compute shaders.
+
+  HRESULT Load(IDxcBlob *pBlob, const DxilProgramHeader *pProgramHeader);
+
+  DxilShaderReflectionState() : m_pDxilModule(nullptr), m_ComputeSummary() { }
+
+private:
   void CreateReflectionObjects();
+  void CreateComputeShaderSummary();
   void SetCBufferUsage();
   void CreateReflectionObjectForResource(DxilResourceBase *R);
   void CreateReflectionObjectsForSignature(
@@ -90,10 +115,18 @@ private:
       std::vector<D3D12_SIGNATURE_PARAMETER_DESC> &Descs);
   LPCSTR CreateUpperCase(LPCSTR pValue);
   void MarkUsedSignatureElements();
+};
+
+// A lightweight view of a loaded reflection state, which adds the public API
+// version that sizes the out parameters of the queries.
+class DxilShaderReflection : public ID3D12ShaderReflection,
+                             public IDxcComputeShaderReflection {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  std::shared_ptr<DxilShaderReflectionState> m_pState;
 public:
   enum class PublicAPI { D3D12 = 0, D3D11_47 = 1, D3D11_43 = 2 };
-  PublicAPI m_PublicAPI;
-  void SetPublicAPI(PublicAPI value) { m_PublicAPI = value; }
+  const PublicAPI m_PublicAPI;
   static PublicAPI IIDToAPI(REFIID iid) {
     DxilShaderReflection::PublicAPI api =
         DxilShaderReflection::PublicAPI::D3D12;
@@ -105,7 +138,9 @@ public:
   }
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
-    HRESULT hr = DoBasicQueryInterface<ID3D12ShaderReflection>(this, iid, ppvObject);
+    HRESULT hr = DoBasicQueryInterface<ID3D12ShaderReflection,
+                                       IDxcComputeShaderReflection>(
+        this, iid, ppvObject);
     if (hr == E_NOINTERFACE) {
       // ID3D11ShaderReflection is identical to ID3D12ShaderReflection, except
       // for some shorter data structures in some out parameters.
@@ -119,8 +154,9 @@ public:
     return hr;
   }
 
-  DxilShaderReflection() : m_dwRef(0), m_pDxilModule(nullptr) { }
-  HRESULT Load(IDxcBlob *pBlob, const DxilPartHeader *pPart);
+  DxilShaderReflection(std::shared_ptr<DxilShaderReflectionState> pState,
+                       PublicAPI api)
+      : m_dwRef(0), m_pState(std::move(pState)), m_PublicAPI(api) { }
 
   // ID3D12ShaderReflection
   STDMETHODIMP GetDesc(THIS_ _Out_ D3D12_SHADER_DESC *pDesc);
@@ -160,6 +196,10 @@ public:
     _Out_opt_ UINT* pSizeZ);
 
   STDMETHODIMP_(UINT64) GetRequiresFlags(THIS);
+
+  // IDxcComputeShaderReflection
+  __override HRESULT STDMETHODCALLTYPE
+  GetComputeShaderSummary(_Out_ DxcComputeShaderSummary *pSummary);
 };
 
 _Use_decl_annotations_
@@ -168,6 +208,7 @@ HRESULT DxilContainerReflection::Load(IDxcBlob *pContainer) {
     m_container.Release();
     m_pHeader = nullptr;
     m_headerLen = 0;
+    m_partStates.clear();
     return S_OK;
   }
 
@@ -181,6 +222,10 @@ HRESULT DxilContainerReflection::Load(IDxcBlob *pContainer) {
     return E_INVALIDARG;
   }
 
+  try {
+    m_partStates.assign(pHeader->PartCount, nullptr);
+  }
+  CATCH_CPP_RETURN_HRESULT();
   m_container = pContainer;
   m_headerLen = bufLen;
   m_pHeader = pHeader;
@@ -230,6 +275,32 @@ HRESULT DxilContainerReflection::FindFirstPartKind(UINT32 kind, _Out_ UINT32 *pR
   return S_OK;
 }
 
+HRESULT DxilContainerReflection::LoadPartState(
+    const DxilPartHeader *pPart,
+    std::shared_ptr<DxilShaderReflectionState> &pState) {
+  // Reflect a compressed debug part through its decompressed content.
+  SmallVector<char, 0> DecompressedData;
+  const DxilProgramHeader *pProgramHeader =
+      reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart));
+  if (pPart->PartFourCC == DFCC_ShaderDebugInfoDXILCompressed) {
+    if (!DecompressDxilPartData(pPart, DecompressedData))
+      return DXC_E_CONTAINER_INVALID;
+    pProgramHeader =
+        reinterpret_cast<const DxilProgramHeader *>(DecompressedData.data());
+    if (!IsValidDxilProgramHeader(pProgramHeader, DecompressedData.size()))
+      return DXC_E_CONTAINER_INVALID;
+  }
+
+  std::shared_ptr<DxilShaderReflectionState> pNewState;
+  try {
+    pNewState = std::make_shared<DxilShaderReflectionState>();
+  }
+  CATCH_CPP_RETURN_HRESULT();
+  IFR(pNewState->Load(m_container, pProgramHeader));
+  pState = std::move(pNewState);
+  return S_OK;
+}
+
 _Use_decl_annotations_
 HRESULT DxilContainerReflection::GetPartReflection(UINT32 idx, REFIID iid, void **ppvObject) {
   if (ppvObject == nullptr) return E_POINTER;
@@ -237,20 +308,28 @@ HRESULT DxilContainerReflection::GetPartReflection(UINT32 idx, REFIID iid, void
   if (!IsLoaded()) return E_NOT_VALID_STATE;
   if (idx >= m_pHeader->PartCount) return E_BOUNDS;
   const DxilPartHeader *pPart = GetDxilContainerPart(m_pHeader, idx);
-  if (pPart->PartFourCC != DFCC_DXIL && pPart->PartFourCC != DFCC_ShaderDebugInfoDXIL) {
+  if (pPart->PartFourCC != DFCC_DXIL &&
+      pPart->PartFourCC != DFCC_ShaderDebugInfoDXIL &&
+      pPart->PartFourCC != DFCC_ShaderDebugInfoDXILCompressed) {
     return E_NOTIMPL;
   }
-  
-  HRESULT hr = S_OK;
-  CComPtr<DxilShaderReflection> pReflection = new (std::nothrow)DxilShaderReflection();
-  IFCOOM(pReflection.p);
-  DxilShaderReflection::PublicAPI api = DxilShaderReflection::IIDToAPI(iid);
-  pReflection->SetPublicAPI(api);
 
-  IFC(pReflection->Load(m_container, pPart));
-  IFC(pReflection.p->QueryInterface(iid, ppvObject));
-Cleanup:
-  return hr;
+  // Loading holds the lock, so concurrent first requests for a part load it
+  // once. A part that fails to load is not cached and fails again next time.
+  std::shared_ptr<DxilShaderReflectionState> pState;
+  {
+    std::lock_guard<std::mutex> lock(m_partStatesLock);
+    std::shared_ptr<DxilShaderReflectionState> &pCached = m_partStates[idx];
+    if (!pCached)
+      IFR(LoadPartState(pPart, pCached));
+    pState = pCached;
+  }
+
+  DxilShaderReflection::PublicAPI api = DxilShaderReflection::IIDToAPI(iid);
+  CComPtr<DxilShaderReflection> pReflection =
+      new (std::nothrow) DxilShaderReflection(std::move(pState), api);
+  IFROOM(pReflection.p);
+  return pReflection.p->QueryInterface(iid, ppvObject);
 }
 
 void hlsl::CreateDxcContainerReflection(IDxcContainerReflection **ppResult) {
@@ -1225,7 +1304,7 @@ static UINT ResourceToFlags(DxilResourceBase *RB) {
   return result;
 }
 
-void DxilShaderReflection::CreateReflectionObjectForResource(DxilResourceBase *RB) {
+void DxilShaderReflectionState::CreateReflectionObjectForResource(DxilResourceBase *RB) {
   DxilResourceBase::Class C = RB->GetClass();
   DxilResource *R =
       (C == DXIL::ResourceClass::UAV || C == DXIL::ResourceClass::SRV)
@@ -1343,30 +1422,28 @@ static void CollectCBufUsage(Value *cbHandle,
 }
 
 static void SetCBufVarUsage(CShaderReflectionConstantBuffer &cb,
-                            std::vector<unsigned> usage) {
+                            std::vector<unsigned> &usage) {
   D3D12_SHADER_BUFFER_DESC Desc;
   if (FAILED(cb.GetDesc(&Desc)))
     return;
 
   unsigned size = Desc.Variables;
 
+  // Sort the used offsets once so each variable's range is a binary search.
   std::sort(usage.begin(), usage.end());
   for (unsigned i = 0; i < size; i++) {
     ID3D12ShaderReflectionVariable *pVar = cb.GetVariableByIndex(i);
+    if (!pVar)
+      continue;
     D3D12_SHADER_VARIABLE_DESC VarDesc;
     if (FAILED(pVar->GetDesc(&VarDesc)))
       continue;
-    if (!pVar)
-      continue;
 
     unsigned begin = VarDesc.StartOffset;
     unsigned end = begin + VarDesc.Size;
-    auto beginIt = std::find_if(usage.begin(), usage.end(),
-                                [&](unsigned v) { return v >= begin; });
-    auto endIt = std::find_if(usage.begin(), usage.end(),
-                              [&](unsigned v) { return v >= end; });
+    auto beginIt = std::lower_bound(usage.begin(), usage.end(), begin);
 
-    bool used = beginIt != endIt;
+    bool used = beginIt != usage.end() && *beginIt < end;
     // Clear used.
     if (!used) {
       CShaderReflectionType *pVarType = (CShaderReflectionType *)pVar->GetType();
@@ -1379,7 +1456,7 @@ static void SetCBufVarUsage(CShaderReflectionConstantBuffer &cb,
   }
 }
 
-void DxilShaderReflection::SetCBufferUsage() {
+void DxilShaderReflectionState::SetCBufferUsage() {
   hlsl::OP *hlslOP = m_pDxilModule->GetOP();
   LLVMContext &Ctx = m_pDxilModule->GetCtx();
   unsigned cbSize = m_CBs.size();
@@ -1408,7 +1485,7 @@ void DxilShaderReflection::SetCBufferUsage() {
   }
 }
 
-void DxilShaderReflection::CreateReflectionObjects() {
+void DxilShaderReflectionState::CreateReflectionObjects() {
   DXASSERT_NOMSG(m_pDxilModule != nullptr);
 
   // Create constant buffers, resources and signatures.
@@ -1566,7 +1643,7 @@ static uint8_t NegMask(uint8_t V) {
   return V & 0xF;
 }
 
-void DxilShaderReflection::CreateReflectionObjectsForSignature(
+void DxilShaderReflectionState::CreateReflectionObjectsForSignature(
   const DxilSignature &Sig,
   std::vector<D3D12_SIGNATURE_PARAMETER_DESC> &Descs) {
   bool clipDistanceSeen = false;
@@ -1603,7 +1680,7 @@ void DxilShaderReflection::CreateReflectionObjectsForSignature(
   }
 }
 
-LPCSTR DxilShaderReflection::CreateUpperCase(LPCSTR pValue) {
+LPCSTR DxilShaderReflectionState::CreateUpperCase(LPCSTR pValue) {
   // Restricted only to [a-z] ASCII.
   LPCSTR pCursor = pValue;
   while (*pCursor != '\0') {
@@ -1631,51 +1708,104 @@ LPCSTR DxilShaderReflection::CreateUpperCase(LPCSTR pValue) {
   return m_UpperCaseNames.back().get();
 }
 
-HRESULT DxilShaderReflection::Load(IDxcBlob *pBlob,
-                                   const DxilPartHeader *pPart) {
+HRESULT DxilShaderReflectionState::Load(IDxcBlob *pBlob,
+                                        const DxilProgramHeader *pProgramHeader) {
   DXASSERT_NOMSG(pBlob != nullptr);
-  DXASSERT_NOMSG(pPart != nullptr);
+  DXASSERT_NOMSG(pProgramHeader != nullptr);
   m_pContainer = pBlob;
-  const char *pData = GetDxilPartData(pPart);
   try {
     const char *pBitcode;
     uint32_t bitcodeLength;
-    GetDxilProgramBitcode((DxilProgramHeader *)pData, &pBitcode, &bitcodeLength);
-    std::unique_ptr<MemoryBuffer> pMemBuffer =
-        MemoryBuffer::getMemBufferCopy(StringRef(pBitcode, bitcodeLength));
-#if 0 // We materialize eagerly, because we'll need to walk instructions to look for usage information.
-    ErrorOr<std::unique_ptr<Module>> module =
-        getLazyBitcodeModule(std::move(pMemBuffer), Context);
-#else
+    GetDxilProgramBitcode(pProgramHeader, &pBitcode, &bitcodeLength);
+    // Reflection only needs module-level metadata and the bodies of the entry
+    // points, which are walked for usage information, so the module is loaded
+    // lazily and any other function bodies are never deserialized. The lazy
+    // module keeps referring to the bitcode, which is read in place when it
+    // lives in the container (kept alive by m_pContainer) and copied when it
+    // is transient, as with a decompressed debug part.
+    const char *pContainerBegin = (const char *)pBlob->GetBufferPointer();
+    const char *pContainerEnd = pContainerBegin + pBlob->GetBufferSize();
+    StringRef BitcodeRef(pBitcode, bitcodeLength);
+    std::unique_ptr<MemoryBuffer> pBitcodeBuf;
+    if (pContainerBegin <= pBitcode &&
+        pBitcode + bitcodeLength <= pContainerEnd)
+      pBitcodeBuf = MemoryBuffer::getMemBuffer(BitcodeRef, "", false);
+    else
+      pBitcodeBuf = MemoryBuffer::getMemBufferCopy(BitcodeRef, "");
     ErrorOr<std::unique_ptr<Module>> module =
-      parseBitcodeFile(pMemBuffer->getMemBufferRef(), Context, nullptr);
-#endif
+        getLazyBitcodeModule(std::move(pBitcodeBuf), Context);
     if (!module) {
       return E_INVALIDARG;
     }
     std::swap(m_pModule, module.get());
     m_pDxilModule = &m_pModule->GetOrCreateDxilModule();
+    Function *pEntryFunc = m_pDxilModule->GetEntryFunction();
+    Function *pPatchConstantFunc = m_pDxilModule->GetPatchConstantFunction();
+    if (pEntryFunc == nullptr || pEntryFunc->materialize() ||
+        (pPatchConstantFunc && pPatchConstantFunc->materialize())) {
+      return E_INVALIDARG;
+    }
     CreateReflectionObjects();
+    if (m_pDxilModule->GetShaderModel()->IsCS())
+      CreateComputeShaderSummary();
     return S_OK;
   }
   CATCH_CPP_RETURN_HRESULT();
 };
 
+void DxilShaderReflectionState::CreateComputeShaderSummary() {
+  DxcComputeShaderSummary &summary = m_ComputeSummary;
+  for (unsigned i = 0; i < 3; ++i)
+    summary.ThreadGroupSize[i] = m_pDxilModule->m_NumThreads[i];
+
+  const DataLayout &DL = m_pModule->getDataLayout();
+  for (GlobalVariable &GV : m_pModule->globals()) {
+    if (GV.getType()->getPointerAddressSpace() == DXIL::kTGSMAddrSpace)
+      summary.GroupSharedBytes +=
+          (UINT32)DL.getTypeAllocSize(GV.getType()->getElementType());
+  }
+
+  // Shaders other than libraries are a single function once generated.
+  Function *pEntryFunc = m_pDxilModule->GetEntryFunction();
+  summary.PeakLiveValues = ComputePeakLiveValues(*pEntryFunc);
+  for (Instruction &I : inst_range(pEntryFunc)) {
+    if (!OP::IsDxilOpFuncCallInst(&I))
+      continue;
+    OP::OpCode opcode = OP::GetDxilOpFuncCallInst(&I);
+    if (OP::IsDxilOpWave(opcode))
+      summary.Usage |= DxcComputeShaderUsage_WaveOps;
+    switch (opcode) {
+    case OP::OpCode::DerivCoarseX:
+    case OP::OpCode::DerivCoarseY:
+    case OP::OpCode::DerivFineX:
+    case OP::OpCode::DerivFineY:
+    case OP::OpCode::Sample:
+    case OP::OpCode::SampleBias:
+    case OP::OpCode::SampleCmp:
+    case OP::OpCode::CalculateLOD:
+      summary.Usage |= DxcComputeShaderUsage_Derivatives;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
 _Use_decl_annotations_
 HRESULT DxilShaderReflection::GetDesc(D3D12_SHADER_DESC *pDesc) {
   IFR(ZeroMemoryToOut(pDesc));
-  const DxilModule &M = *m_pDxilModule;
+  const DxilModule &M = *m_pState->m_pDxilModule;
   const ShaderModel *pSM = M.GetShaderModel();
 
   pDesc->Version = EncodeVersion(pSM->GetKind(), pSM->GetMajor(), pSM->GetMinor());
   // Unset:  LPCSTR                  Creator;                     // Creator string
   // Unset:  UINT                    Flags;                       // Shader compilation/parse flags
 
-  pDesc->ConstantBuffers = m_CBs.size();
-  pDesc->BoundResources = m_Resources.size();
-  pDesc->InputParameters = m_InputSignature.size();
-  pDesc->OutputParameters = m_OutputSignature.size();
-  pDesc->PatchConstantParameters = m_PatchConstantSignature.size();
+  pDesc->ConstantBuffers = m_pState->m_CBs.size();
+  pDesc->BoundResources = m_pState->m_Resources.size();
+  pDesc->InputParameters = m_pState->m_InputSignature.size();
+  pDesc->OutputParameters = m_pState->m_OutputSignature.size();
+  pDesc->PatchConstantParameters = m_pState->m_PatchConstantSignature.size();
 
   // Unset:  UINT                    InstructionCount;            // Number of emitted instructions
   // Unset:  UINT                    TempRegisterCount;           // Number of temporary registers used 
@@ -1720,7 +1850,7 @@ static bool GetUnsignedVal(Value *V, uint32_t *pValue) {
   return true;
 }
 
-void DxilShaderReflection::MarkUsedSignatureElements() {
+void DxilShaderReflectionState::MarkUsedSignatureElements() {
   Function *F = m_pDxilModule->GetEntryFunction();
   DXASSERT(F != nullptr, "else module load should have failed");
   // For every loadInput/storeOutput, update the corresponding ReadWriteMask.
@@ -1785,10 +1915,10 @@ void DxilShaderReflection::MarkUsedSignatureElements() {
 
 _Use_decl_annotations_
 ID3D12ShaderReflectionConstantBuffer* DxilShaderReflection::GetConstantBufferByIndex(UINT Index) {
-  if (Index >= m_CBs.size()) {
+  if (Index >= m_pState->m_CBs.size()) {
     return &g_InvalidSRConstantBuffer;
   }
-  return &m_CBs[Index];
+  return &m_pState->m_CBs[Index];
 }
 
 _Use_decl_annotations_
@@ -1796,9 +1926,9 @@ ID3D12ShaderReflectionConstantBuffer* DxilShaderReflection::GetConstantBufferByN
   if (!Name) {
     return &g_InvalidSRConstantBuffer;
   }
-  for (UINT index = 0; index < m_CBs.size(); ++index) {
-    if (0 == strcmp(m_CBs[index].GetName(), Name)) {
-      return &m_CBs[index];
+  for (UINT index = 0; index < m_pState->m_CBs.size(); ++index) {
+    if (0 == strcmp(m_pState->m_CBs[index].GetName(), Name)) {
+      return &m_pState->m_CBs[index];
     }
   }
   return &g_InvalidSRConstantBuffer;
@@ -1808,12 +1938,12 @@ _Use_decl_annotations_
 HRESULT DxilShaderReflection::GetResourceBindingDesc(UINT ResourceIndex,
   _Out_ D3D12_SHADER_INPUT_BIND_DESC *pDesc) {
   IFRBOOL(pDesc != nullptr, E_INVALIDARG);
-  IFRBOOL(ResourceIndex < m_Resources.size(), E_INVALIDARG);
+  IFRBOOL(ResourceIndex < m_pState->m_Resources.size(), E_INVALIDARG);
   if (m_PublicAPI != PublicAPI::D3D12) {
-    memcpy(pDesc, &m_Resources[ResourceIndex], sizeof(D3D11_SHADER_INPUT_BIND_DESC));
+    memcpy(pDesc, &m_pState->m_Resources[ResourceIndex], sizeof(D3D11_SHADER_INPUT_BIND_DESC));
   }
   else {
-    *pDesc = m_Resources[ResourceIndex];
+    *pDesc = m_pState->m_Resources[ResourceIndex];
   }
   return S_OK;
 }
@@ -1822,11 +1952,11 @@ _Use_decl_annotations_
 HRESULT DxilShaderReflection::GetInputParameterDesc(UINT ParameterIndex,
   _Out_ D3D12_SIGNATURE_PARAMETER_DESC *pDesc) {
   IFRBOOL(pDesc != nullptr, E_INVALIDARG);
-  IFRBOOL(ParameterIndex < m_InputSignature.size(), E_INVALIDARG);
+  IFRBOOL(ParameterIndex < m_pState->m_InputSignature.size(), E_INVALIDARG);
   if (m_PublicAPI != PublicAPI::D3D11_43)
-    *pDesc = m_InputSignature[ParameterIndex];
+    *pDesc = m_pState->m_InputSignature[ParameterIndex];
   else
-    memcpy(pDesc, &m_InputSignature[ParameterIndex],
+    memcpy(pDesc, &m_pState->m_InputSignature[ParameterIndex],
            // D3D11_43 does not have MinPrecison.
            sizeof(D3D12_SIGNATURE_PARAMETER_DESC) - sizeof(D3D_MIN_PRECISION));
 
@@ -1837,11 +1967,11 @@ _Use_decl_annotations_
 HRESULT DxilShaderReflection::GetOutputParameterDesc(UINT ParameterIndex,
   D3D12_SIGNATURE_PARAMETER_DESC *pDesc) {
   IFRBOOL(pDesc != nullptr, E_INVALIDARG);
-  IFRBOOL(ParameterIndex < m_OutputSignature.size(), E_INVALIDARG);
+  IFRBOOL(ParameterIndex < m_pState->m_OutputSignature.size(), E_INVALIDARG);
   if (m_PublicAPI != PublicAPI::D3D11_43)
-    *pDesc = m_OutputSignature[ParameterIndex];
+    *pDesc = m_pState->m_OutputSignature[ParameterIndex];
   else
-    memcpy(pDesc, &m_OutputSignature[ParameterIndex],
+    memcpy(pDesc, &m_pState->m_OutputSignature[ParameterIndex],
            // D3D11_43 does not have MinPrecison.
            sizeof(D3D12_SIGNATURE_PARAMETER_DESC) - sizeof(D3D_MIN_PRECISION));
 
@@ -1852,11 +1982,11 @@ _Use_decl_annotations_
 HRESULT DxilShaderReflection::GetPatchConstantParameterDesc(UINT ParameterIndex,
   D3D12_SIGNATURE_PARAMETER_DESC *pDesc) {
   IFRBOOL(pDesc != nullptr, E_INVALIDARG);
-  IFRBOOL(ParameterIndex < m_PatchConstantSignature.size(), E_INVALIDARG);
+  IFRBOOL(ParameterIndex < m_pState->m_PatchConstantSignature.size(), E_INVALIDARG);
   if (m_PublicAPI != PublicAPI::D3D11_43)
-    *pDesc = m_PatchConstantSignature[ParameterIndex];
+    *pDesc = m_pState->m_PatchConstantSignature[ParameterIndex];
   else
-    memcpy(pDesc, &m_PatchConstantSignature[ParameterIndex],
+    memcpy(pDesc, &m_pState->m_PatchConstantSignature[ParameterIndex],
            // D3D11_43 does not have MinPrecison.
            sizeof(D3D12_SIGNATURE_PARAMETER_DESC) - sizeof(D3D_MIN_PRECISION));
 
@@ -1867,8 +1997,8 @@ _Use_decl_annotations_
 ID3D12ShaderReflectionVariable* DxilShaderReflection::GetVariableByName(LPCSTR Name) {
   if (Name != nullptr) {
     // Iterate through all cbuffers to find the variable.
-    for (UINT i = 0; i < m_CBs.size(); i++) {
-      ID3D12ShaderReflectionVariable *pVar = m_CBs[i].GetVariableByName(Name);
+    for (UINT i = 0; i < m_pState->m_CBs.size(); i++) {
+      ID3D12ShaderReflectionVariable *pVar = m_pState->m_CBs[i].GetVariableByName(Name);
       if (pVar != &g_InvalidSRVariable) {
         return pVar;
       }
@@ -1884,13 +2014,13 @@ HRESULT DxilShaderReflection::GetResourceBindingDescByName(LPCSTR Name,
   IFRBOOL(Name != nullptr, E_INVALIDARG);
   IFR(ZeroMemoryToOut(pDesc));
 
-  for (UINT i = 0; i < m_Resources.size(); i++) {
-    if (strcmp(m_Resources[i].Name, Name) == 0) {
+  for (UINT i = 0; i < m_pState->m_Resources.size(); i++) {
+    if (strcmp(m_pState->m_Resources[i].Name, Name) == 0) {
       if (m_PublicAPI != PublicAPI::D3D12) {
-        memcpy(pDesc, &m_Resources[i], sizeof(D3D11_SHADER_INPUT_BIND_DESC));
+        memcpy(pDesc, &m_pState->m_Resources[i], sizeof(D3D11_SHADER_INPUT_BIND_DESC));
       }
       else {
-        *pDesc = m_Resources[i];
+        *pDesc = m_pState->m_Resources[i];
       }
       return S_OK;
     }
@@ -1905,7 +2035,7 @@ UINT DxilShaderReflection::GetConversionInstructionCount() { return 0; }
 UINT DxilShaderReflection::GetBitwiseInstructionCount() { return 0; }
 
 D3D_PRIMITIVE DxilShaderReflection::GetGSInputPrimitive() {
-  return (D3D_PRIMITIVE)m_pDxilModule->GetInputPrimitive();
+  return (D3D_PRIMITIVE)m_pState->m_pDxilModule->GetInputPrimitive();
 }
 
 BOOL DxilShaderReflection::IsSampleFrequencyShader() {
@@ -1923,16 +2053,27 @@ HRESULT DxilShaderReflection::GetMinFeatureLevel(enum D3D_FEATURE_LEVEL* pLevel)
 
 _Use_decl_annotations_
 UINT DxilShaderReflection::GetThreadGroupSize(UINT *pSizeX, UINT *pSizeY, UINT *pSizeZ) {
-  UINT *pNumThreads = m_pDxilModule->m_NumThreads;
+  UINT *pNumThreads = m_pState->m_pDxilModule->m_NumThreads;
   AssignToOutOpt(pNumThreads[0], pSizeX);
   AssignToOutOpt(pNumThreads[1], pSizeY);
   AssignToOutOpt(pNumThreads[2], pSizeZ);
   return pNumThreads[0] * pNumThreads[1] * pNumThreads[2];
 }
 
+_Use_decl_annotations_
+HRESULT DxilShaderReflection::GetComputeShaderSummary(
+    DxcComputeShaderSummary *pSummary) {
+  if (pSummary == nullptr)
+    return E_POINTER;
+  if (!m_pState->m_pDxilModule->GetShaderModel()->IsCS())
+    return E_NOTIMPL;
+  *pSummary = m_pState->m_ComputeSummary;
+  return S_OK;
+}
+
 UINT64 DxilShaderReflection::GetRequiresFlags() {
   UINT64 result = 0;
-  uint64_t features = m_pDxilModule->m_ShaderFlags.GetFeatureInfo();
+  uint64_t features = m_pState->m_pDxilModule->m_ShaderFlags.GetFeatureInfo();
   if (features & ShaderFeatureInfo_Doubles) result |= D3D_SHADER_REQUIRES_DOUBLES;
   if (features & ShaderFeatureInfo_UAVsAtEveryStage) result |= D3D_SHADER_REQUIRES_UAVS_AT_EVERY_STAGE;
   if (features & ShaderFeatureInfo_64UAVs) result |= D3D_SHADER_REQUIRES_64_UAVS;
@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilDynamicIndexToSelect.cpp                                              //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Rewrites dynamic indexing of small local arrays into selects over SSA     //
+// values, so the arrays do not need indexable temporaries.                  //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+// Local arrays that are indexed dynamically stay as allocas through the
+// pipeline and become indexable temporaries, which drivers often keep in
+// scratch memory. For arrays of at most max-elements scalars, this pass
+// splits the array into one alloca per element and rewrites each dynamic
+// access as a select over all elements:
+//
+//   load a[i]      ->  select(i == N-1, a[N-1], ... select(i == 1, a[1], a[0]))
+//   store v, a[i]  ->  a[k] = select(i == k, v, a[k]) for every k
+//
+// The element allocas are then promoted to registers. Arrays that are too
+// large or used other than through loads and stores are left in memory, and
+// are listed by print, so -analyze reports them.
+class DxilDynamicIndexToSelect : public FunctionPass {
+  unsigned m_MaxElements = 8;
+  std::vector<std::string> m_ArraysLeftInMemory;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilDynamicIndexToSelect() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL dynamic index to select";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  void applyOptions(PassOptions O) override {
+    for (const auto &option : O) {
+      if (0 == option.first.compare("max-elements"))
+        m_MaxElements = atoi(option.second.data());
+    }
+  }
+
+  bool runOnFunction(Function &F) override;
+
+  void print(raw_ostream &OS, const Module *) const override {
+    for (const std::string &Entry : m_ArraysLeftInMemory)
+      OS << "Array left in memory: " << Entry << "\n";
+  }
+
+private:
+  // Returns null if the array can be rewritten, or the reason it cannot.
+  const char *GetUnsupportedReason(AllocaInst *AI);
+  void SplitArray(AllocaInst *AI, std::vector<AllocaInst *> &Elements);
+};
+
+static bool IsScalarArray(Type *Ty) {
+  ArrayType *AT = dyn_cast<ArrayType>(Ty);
+  if (!AT)
+    return false;
+  Type *EltTy = AT->getElementType();
+  return EltTy->isIntegerTy() || EltTy->isFloatingPointTy();
+}
+
+// An access is a GEP with a zero first index and one element index, all of
+// whose users are simple loads and stores through it.
+static bool IsSupportedAccess(User *U) {
+  GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(U);
+  if (!GEP || GEP->getNumIndices() != 2)
+    return false;
+  ConstantInt *First = dyn_cast<ConstantInt>(GEP->getOperand(1));
+  if (!First || !First->isZero())
+    return false;
+  for (User *GEPUser : GEP->users()) {
+    if (LoadInst *LI = dyn_cast<LoadInst>(GEPUser)) {
+      if (!LI->isSimple())
+        return false;
+    } else if (StoreInst *SI = dyn_cast<StoreInst>(GEPUser)) {
+      if (!SI->isSimple() || SI->getValueOperand() == GEP)
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char *DxilDynamicIndexToSelect::GetUnsupportedReason(AllocaInst *AI) {
+  if (AI->getAllocatedType()->getArrayNumElements() > m_MaxElements)
+    return "too many elements";
+  for (User *U : AI->users()) {
+    if (!IsSupportedAccess(U))
+      return "unsupported use";
+  }
+  return nullptr;
+}
+
+void DxilDynamicIndexToSelect::SplitArray(AllocaInst *AI,
+                                          std::vector<AllocaInst *> &Elements) {
+  ArrayType *AT = cast<ArrayType>(AI->getAllocatedType());
+  Type *EltTy = AT->getElementType();
+  unsigned NumElements = AT->getNumElements();
+
+  IRBuilder<> AllocaBuilder(AI);
+  std::vector<AllocaInst *> Elts(NumElements);
+  for (unsigned i = 0; i < NumElements; ++i) {
+    Elts[i] = AllocaBuilder.CreateAlloca(EltTy, nullptr,
+                                         AI->getName() + "." + Twine(i));
+    Elements.push_back(Elts[i]);
+  }
+
+  SmallVector<GetElementPtrInst *, 8> GEPs;
+  for (User *U : AI->users())
+    GEPs.push_back(cast<GetElementPtrInst>(U));
+
+  for (GetElementPtrInst *GEP : GEPs) {
+    Value *Idx = GEP->getOperand(2);
+    ConstantInt *CIdx = dyn_cast<ConstantInt>(Idx);
+    SmallVector<User *, 4> Users(GEP->user_begin(), GEP->user_end());
+
+    // Constant indices address a single element directly.
+    if (CIdx) {
+      uint64_t i = CIdx->getLimitedValue();
+      if (i < NumElements) {
+        GEP->replaceAllUsesWith(Elts[i]);
+        GEP->eraseFromParent();
+        continue;
+      }
+    }
+
+    for (User *GEPUser : Users) {
+      Instruction *I = cast<Instruction>(GEPUser);
+      IRBuilder<> Builder(I);
+      if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+        Value *Result = Builder.CreateLoad(Elts[0]);
+        for (unsigned i = 1; i < NumElements; ++i) {
+          Value *Elt = Builder.CreateLoad(Elts[i]);
+          Value *IsElt =
+              Builder.CreateICmpEQ(Idx, ConstantInt::get(Idx->getType(), i));
+          Result = Builder.CreateSelect(IsElt, Elt, Result);
+        }
+        Result->takeName(LI);
+        LI->replaceAllUsesWith(Result);
+      } else {
+        StoreInst *SI = cast<StoreInst>(I);
+        Value *V = SI->getValueOperand();
+        for (unsigned i = 0; i < NumElements; ++i) {
+          Value *Old = Builder.CreateLoad(Elts[i]);
+          Value *IsElt =
+              Builder.CreateICmpEQ(Idx, ConstantInt::get(Idx->getType(), i));
+          Builder.CreateStore(Builder.CreateSelect(IsElt, V, Old), Elts[i]);
+        }
+      }
+      I->eraseFromParent();
+    }
+    GEP->eraseFromParent();
+  }
+  AI->eraseFromParent();
+}
+
+bool DxilDynamicIndexToSelect::runOnFunction(Function &F) {
+  std::vector<AllocaInst *> Arrays;
+  for (Instruction &I : F.getEntryBlock()) {
+    AllocaInst *AI = dyn_cast<AllocaInst>(&I);
+    if (AI && !AI->isArrayAllocation() &&
+        IsScalarArray(AI->getAllocatedType()))
+      Arrays.push_back(AI);
+  }
+
+  std::vector<AllocaInst *> Elements;
+  for (AllocaInst *AI : Arrays) {
+    if (const char *Reason = GetUnsupportedReason(AI)) {
+      m_ArraysLeftInMemory.push_back(
+          (F.getName() + ": " + AI->getName() + " (" + Reason + ")").str());
+      continue;
+    }
+    SplitArray(AI, Elements);
+  }
+  if (Elements.empty())
+    return false;
+
+  DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  PromoteMemToReg(Elements, DT);
+  return true;
+}
+
+} // namespace
+
+char DxilDynamicIndexToSelect::ID = 0;
+
+FunctionPass *llvm::createDxilDynamicIndexToSelectPass() {
+  return new DxilDynamicIndexToSelect();
+}
+
+INITIALIZE_PASS_BEGIN(DxilDynamicIndexToSelect,
+                      "hlsl-dxil-dynamic-index-to-select",
+                      "DXIL dynamic index to select", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_END(DxilDynamicIndexToSelect,
+                    "hlsl-dxil-dynamic-index-to-select",
+                    "DXIL dynamic index to select", false, false)
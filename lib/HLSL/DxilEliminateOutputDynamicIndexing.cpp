@@ -16,14 +16,20 @@
 #include "dxc/Support/Global.h"
 #include "dxc/HLSL/DxilInstructions.h"
 
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 using namespace hlsl;
 
+#define DEBUG_TYPE "hlsl-dxil-eliminate-output-dynamic"
+
 namespace {
 class DxilEliminateOutputDynamicIndexing : public ModulePass {
 private:
@@ -61,8 +67,10 @@ public:
 
 private:
   bool EliminateDynamicOutput(hlsl::OP *hlslOP, DXIL::OpCode opcode, DxilSignature &outputSig, Function *Entry);
-  void ReplaceDynamicOutput(ArrayRef<Value *> tmpSigElts, Value * sigID, Value *zero, Function *F);
-  void StoreTmpSigToOutput(ArrayRef<Value *> tmpSigElts, unsigned row,
+  void ReplaceDynamicOutput(ArrayRef<Value *> tmpSigElts, Value * sigID, Value *zero, Function *F,
+                            MutableArrayRef<SmallBitVector> writtenRows);
+  void StoreTmpSigToOutput(ArrayRef<Value *> tmpSigElts,
+                           ArrayRef<SmallBitVector> writtenRows,
                            Value *opcode, Value *sigID, Function *StoreOutput,
                            Function *Entry);
 };
@@ -143,16 +151,59 @@ bool DxilEliminateOutputDynamicIndexing::EliminateDynamicOutput(
     }
 
     Function *F = hlslOP->GetOpFunc(opcode, EltTy);
-    // Change store output to store tmpSigElts.
-    ReplaceDynamicOutput(tmpSigElts, sigID, zero, F);
+    // Change store output to store tmpSigElts, noting which rows of each
+    // column may be written.
+    std::vector<SmallBitVector> writtenRows(col, SmallBitVector(row));
+    DebugLoc DL;
+    for (User *U : F->users()) {
+      DxilOutputStore store(cast<CallInst>(U));
+      if (store.get_outputSigId() == sigID &&
+          !isa<ConstantInt>(store.get_rowIndex())) {
+        DL = store.Instr->getDebugLoc();
+        break;
+      }
+    }
+    ReplaceDynamicOutput(tmpSigElts, sigID, zero, F, writtenRows);
     // Store tmpSigElts to Output before return.
-    StoreTmpSigToOutput(tmpSigElts, row, opcodeV, sigID, F, Entry);
+    StoreTmpSigToOutput(tmpSigElts, writtenRows, opcodeV, sigID, F, Entry);
+
+    unsigned stored = 0;
+    for (const SmallBitVector &rows : writtenRows)
+      stored += rows.count();
+    std::string Msg;
+    raw_string_ostream OS(Msg);
+    OS << "dynamically indexed output " << sigElt.GetName() << ": "
+       << stored << " of " << row * col
+       << " components stored at each return, " << row * col - stored
+       << " stores eliminated";
+    emitOptimizationRemarkAnalysis(Entry->getContext(), DEBUG_TYPE, *Entry,
+                                   DL, OS.str());
   }
   return true;
 }
 
+// Marks the rows a store with row index r may write: r itself if it is
+// constant, otherwise every row up to the largest value r's known zero bits
+// allow.
+static void MarkWrittenRows(Value *r, const DataLayout &DL,
+                            SmallBitVector &rows) {
+  if (ConstantInt *C = dyn_cast<ConstantInt>(r)) {
+    uint64_t idx = C->getLimitedValue();
+    if (idx < rows.size())
+      rows.set(idx);
+    return;
+  }
+  unsigned bitWidth = r->getType()->getScalarSizeInBits();
+  APInt knownZero(bitWidth, 0), knownOne(bitWidth, 0);
+  computeKnownBits(r, knownZero, knownOne, DL);
+  uint64_t maxIdx = (~knownZero).getLimitedValue();
+  rows.set(0, std::min<uint64_t>(maxIdx + 1, rows.size()));
+}
+
 void DxilEliminateOutputDynamicIndexing::ReplaceDynamicOutput(
-    ArrayRef<Value *> tmpSigElts, Value *sigID, Value *zero, Function *F) {
+    ArrayRef<Value *> tmpSigElts, Value *sigID, Value *zero, Function *F,
+    MutableArrayRef<SmallBitVector> writtenRows) {
+  const DataLayout &DL = F->getParent()->getDataLayout();
   for (auto it = F->user_begin(); it != F->user_end();) {
     CallInst *CI = cast<CallInst>(*(it++));
     DxilOutputStore store(CI);
@@ -161,6 +212,7 @@ void DxilEliminateOutputDynamicIndexing::ReplaceDynamicOutput(
       Value *tmpSigElt = tmpSigElts[col];
       IRBuilder<> Builder(CI);
       Value *r = store.get_rowIndex();
+      MarkWrittenRows(r, DL, writtenRows[col]);
       // Store to tmpSigElt.
       Value *GEP = Builder.CreateInBoundsGEP(tmpSigElt, {zero, r});
       Builder.CreateStore(store.get_value(), GEP);
@@ -171,11 +223,13 @@ void DxilEliminateOutputDynamicIndexing::ReplaceDynamicOutput(
 }
 
 void DxilEliminateOutputDynamicIndexing::StoreTmpSigToOutput(
-    ArrayRef<Value *> tmpSigElts, unsigned row, Value *opcode, Value *sigID,
-    Function *StoreOutput, Function *Entry) {
+    ArrayRef<Value *> tmpSigElts, ArrayRef<SmallBitVector> writtenRows,
+    Value *opcode, Value *sigID, Function *StoreOutput, Function *Entry) {
   Value *args[] = {opcode, sigID, /*row*/ nullptr, /*col*/ nullptr,
                    /*val*/ nullptr};
-  // Store the tmpSigElts to Output before every return.
+  // Store the tmpSigElts to Output before every return. Components no store
+  // may reach hold undef, the same as an output that is never written, so
+  // they are left unstored.
   for (auto &BB : Entry->getBasicBlockList()) {
     if (ReturnInst *RI = dyn_cast<ReturnInst>(BB.getTerminator())) {
       IRBuilder<> Builder(RI);
@@ -183,7 +237,8 @@ void DxilEliminateOutputDynamicIndexing::StoreTmpSigToOutput(
       for (unsigned c = 0; c<tmpSigElts.size(); c++) {
         Value *col = tmpSigElts[c];
         args[DXIL::OperandIndex::kStoreOutputColOpIdx] = Builder.getInt8(c);
-        for (unsigned r = 0; r < row; r++) {
+        for (int r = writtenRows[c].find_first(); r != -1;
+             r = writtenRows[c].find_next(r)) {
           Value *GEP =
               Builder.CreateInBoundsGEP(col, {zero, Builder.getInt32(r)});
           Value *V = Builder.CreateLoad(GEP);
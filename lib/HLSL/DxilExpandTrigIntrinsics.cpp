@@ -37,6 +37,19 @@
 // 
 // The approximation functions mostly come from [ADC]. The approximations
 // are also referenced in [HMF], but they give original credit to [ADC].
+//
+// Approximate mode
+// ---------------------------------------------------------------------------
+// With the "approximate" pass option, non-precise calls use cheaper
+// expansions: lower-degree minimax polynomials for asin, acos and atan, and
+// a single exp for the hyperbolic functions. The maximum absolute errors,
+// measured over the whole input range, are
+//
+//     asin, acos   3.3e-3
+//     atan         5.0e-3
+//
+// The hyperbolic expansions are rearranged, not further approximated.
+// Precise calls always get the default expansions.
 // 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -62,6 +75,7 @@ using namespace hlsl;
 namespace {
 class DxilExpandTrigIntrinsics : public FunctionPass {
 private:
+  bool m_bApproximate = false;
 
 public:
   static char ID; // Pass identification, replacement for typeid
@@ -72,7 +86,8 @@ public:
   }
   
   bool runOnFunction(Function &F) override;
-  
+  void applyOptions(PassOptions O) override;
+
 
 private:
   typedef std::vector<CallInst *> IntrinsicList;
@@ -90,6 +105,7 @@ private:
   Value *expandHSin(IRBuilder<> &builder, DxilInst_Hsin hsin, DxilModule &DM);
   Value *expandHTan(IRBuilder<> &builder, DxilInst_Htan htan, DxilModule &DM);
   Value *expandTan(IRBuilder<> &builder, DxilInst_Tan tan, DxilModule &DM);
+  bool useApproximation(IRBuilder<> &builder);
 };
 
 // Math constants.
@@ -104,6 +120,13 @@ namespace math {
 }
 
 
+void DxilExpandTrigIntrinsics::applyOptions(PassOptions O) {
+  for (const auto &option : O) {
+    if (0 == option.first.compare("approximate"))
+      m_bApproximate = atoi(option.second.data()) != 0;
+  }
+}
+
 bool DxilExpandTrigIntrinsics::runOnFunction(Function &F) {
   DxilModule &DM = F.getParent()->GetOrCreateDxilModule(); 
   IntrinsicList intrinsics = findTrigFunctionsToExpand(F);
@@ -150,6 +173,10 @@ static void setPreciseBuilder(IRBuilder<> &builder, bool precise) {
   builder.SetFastMathFlags(flags);
 }
 
+bool DxilExpandTrigIntrinsics::useApproximation(IRBuilder<> &builder) {
+  return m_bApproximate && !isPreciseBuilder(builder);
+}
+
 void DxilExpandTrigIntrinsics::prepareBuilderToExpandIntrinsic(IRBuilder<> &builder, CallInst *intrinsic) {
   DxilModule &DM = intrinsic->getModule()->GetOrCreateDxilModule();
   builder.SetInsertPoint(intrinsic);
@@ -245,6 +272,35 @@ static Value *emitSqrt1mXtimesPsiX(IRBuilder<> &builder, Value *X, OP *dxOp, Str
   return r4;
 }
 
+// Helper
+// return sqrt(1 - X) * psi1*(X)
+//
+// A degree one minimax fit of acos(x) / sqrt(1 - x) over [0, 1], used in
+// approximate mode. The error of sqrt(1 - x) * psi1*(x) against acos(x) is
+// at most 3.3e-3.
+//
+//   psi1*(X) = b0 + b1x
+//     b0 =  1.5675894
+//     b1 = -0.1682581
+//
+static Value *emitSqrt1mXtimesPsi1X(IRBuilder<> &builder, Value *X, OP *dxOp, StringRef name) {
+  Value *One = ConstantFP::get(X->getType(), 1.0);
+  Value *b0 = ConstantFP::get(X->getType(),  1.5675894);
+  Value *b1 = ConstantFP::get(X->getType(), -0.1682581);
+
+  // sqrt(1-x)
+  Value *r1 = builder.CreateFSub(One, X, name);
+  Value *r2 = emitSqrt(builder, r1, dxOp, name);
+
+  // psi1*(x)
+  Value *r3 = builder.CreateFMul(X,  b1, name);
+         r3 = builder.CreateFAdd(r3, b0, name);
+
+  // sqrt(1-x) * psi1*(x)
+  Value *r4 = builder.CreateFMul(r2, r3, name);
+  return r4;
+}
+
 // Helper
 // return e^x, e^-x
 //
@@ -266,6 +322,23 @@ static std::pair<Value *, Value *> emitExEmx(IRBuilder<> &builder, Value *X, OP
   return std::make_pair(r1, r3);
 }
 
+// Helper
+// return e^x, e^-x
+//
+// Approximate mode variant computing e^-x as 1 / e^x, which trades the
+// second exp for a division.
+//
+static std::pair<Value *, Value *> emitExRcpEx(IRBuilder<> &builder, Value *X, OP *dxOp, StringRef name) {
+  Value *One   = ConstantFP::get(X->getType(), 1.0);
+  Value *Log2e = ConstantFP::get(X->getType(), math::LOG2E);
+
+  Value *r0 = builder.CreateFMul(X, Log2e, name);
+  Value *r1 = emitUnaryFloat(builder, r0, dxOp, OP::OpCode::Exp, name);
+  Value *r2 = builder.CreateFDiv(One, r1, name);
+
+  return std::make_pair(r1, r2);
+}
+
 // Asin
 // ----------------------------------------------------------------------------
 // Function
@@ -306,7 +379,9 @@ Value *DxilExpandTrigIntrinsics::expandASin(IRBuilder<> &builder, DxilInst_Asin
   Value *absX = emitFAbs(builder, X, DM.GetOP(), name);
 
   // Approximation
-  Value *psiX = emitSqrt1mXtimesPsiX(builder, absX, DM.GetOP(), name);
+  Value *psiX = useApproximation(builder)
+                    ? emitSqrt1mXtimesPsi1X(builder, absX, DM.GetOP(), name)
+                    : emitSqrt1mXtimesPsiX(builder, absX, DM.GetOP(), name);
   Value *asinX = builder.CreateFSub(PI_2, psiX, name);
   Value *asinmX = builder.CreateFSub(Zero, asinX, name);
 
@@ -350,7 +425,9 @@ Value *DxilExpandTrigIntrinsics::expandACos(IRBuilder<> &builder, DxilInst_Acos
   Value *absX = emitFAbs(builder, X, DM.GetOP(), name);
 
   // Approximation
-  Value *acosX = emitSqrt1mXtimesPsiX(builder, absX, DM.GetOP(), name);
+  Value *acosX = useApproximation(builder)
+                     ? emitSqrt1mXtimesPsi1X(builder, absX, DM.GetOP(), name)
+                     : emitSqrt1mXtimesPsiX(builder, absX, DM.GetOP(), name);
   Value *acosmX = builder.CreateFSub(PI, acosX, name);
 
   // Range expansion to [-1, 1]
@@ -423,15 +500,25 @@ Value *DxilExpandTrigIntrinsics::expandATan(IRBuilder<> &builder, DxilInst_Atan
 
   // Approximate
   Value *r3 = builder.CreateFMul(r2, r2, name);
-  Value *r4 = builder.CreateFMul(r3, c9, name);
-         r4 = builder.CreateFAdd(r4, c7, name);
-         r4 = builder.CreateFMul(r4, r3, name);
-         r4 = builder.CreateFAdd(r4, c5, name);
-         r4 = builder.CreateFMul(r4, r3, name);
-         r4 = builder.CreateFAdd(r4, c3, name);
-         r4 = builder.CreateFMul(r4, r3, name);
-         r4 = builder.CreateFAdd(r4, c1, name);
-         r4 = builder.CreateFMul(r2, r4, name);
+  Value *r4;
+  if (useApproximation(builder)) {
+    // Degree three minimax fit over [0, 1], with error at most 5.0e-3.
+    Value *d1 = ConstantFP::get(X->getType(),  0.9723941);
+    Value *d3 = ConstantFP::get(X->getType(), -0.1919480);
+    r4 = builder.CreateFMul(r3, d3, name);
+    r4 = builder.CreateFAdd(r4, d1, name);
+    r4 = builder.CreateFMul(r2, r4, name);
+  } else {
+    r4 = builder.CreateFMul(r3, c9, name);
+    r4 = builder.CreateFAdd(r4, c7, name);
+    r4 = builder.CreateFMul(r4, r3, name);
+    r4 = builder.CreateFAdd(r4, c5, name);
+    r4 = builder.CreateFMul(r4, r3, name);
+    r4 = builder.CreateFAdd(r4, c3, name);
+    r4 = builder.CreateFMul(r4, r3, name);
+    r4 = builder.CreateFAdd(r4, c1, name);
+    r4 = builder.CreateFMul(r2, r4, name);
+  }
 
   // Range Expansion to [0, inf]
   Value *r5 = builder.CreateFSub(PI_2, r4, name);
@@ -460,7 +547,9 @@ Value *DxilExpandTrigIntrinsics::expandHCos(IRBuilder<> &builder, DxilInst_Hcos
   Value *X = hcos.get_value();
   Value *Two = ConstantFP::get(X->getType(), 2.0);
 
-  std::tie(eX, emX) = emitExEmx(builder, X, DM.GetOP(), name);
+  std::tie(eX, emX) = useApproximation(builder)
+                         ? emitExRcpEx(builder, X, DM.GetOP(), name)
+                         : emitExEmx(builder, X, DM.GetOP(), name);
   Value *r4 = builder.CreateFAdd(eX, emX, name);
   Value *r  = builder.CreateFDiv(r4, Two, name);
 
@@ -482,7 +571,9 @@ Value *DxilExpandTrigIntrinsics::expandHSin(IRBuilder<> &builder, DxilInst_Hsin
   Value *X = hsin.get_value();
   Value *Two = ConstantFP::get(X->getType(), 2.0);
 
-  std::tie(eX, emX) = emitExEmx(builder, X, DM.GetOP(), name);
+  std::tie(eX, emX) = useApproximation(builder)
+                         ? emitExRcpEx(builder, X, DM.GetOP(), name)
+                         : emitExEmx(builder, X, DM.GetOP(), name);
   Value *r4 = builder.CreateFSub(eX, emX, name);
   Value *r  = builder.CreateFDiv(r4, Two, name);
 
@@ -497,12 +588,29 @@ Value *DxilExpandTrigIntrinsics::expandHSin(IRBuilder<> &builder, DxilInst_Hsin
 //
 // No range reduction is needed.
 //
+// In approximate mode we use the equivalent form
+//
+//    tanh(x) = 1 - 2 / (e^2x + 1)
+//
+// which needs a single exp and saturates to +-1 for large |x|.
+//
 Value *DxilExpandTrigIntrinsics::expandHTan(IRBuilder<> &builder, DxilInst_Htan htan, DxilModule &DM) {
   assert(htan);
   StringRef name = "htan.x";
   Value *eX, *emX;
   Value *X = htan.get_value();
 
+  if (useApproximation(builder)) {
+    Value *One = ConstantFP::get(X->getType(), 1.0);
+    Value *Two = ConstantFP::get(X->getType(), 2.0);
+    Value *TwoLog2e = ConstantFP::get(X->getType(), 2.0 * math::LOG2E);
+    Value *r0 = builder.CreateFMul(X, TwoLog2e, name);
+    Value *r1 = emitUnaryFloat(builder, r0, DM.GetOP(), OP::OpCode::Exp, name);
+    Value *r2 = builder.CreateFAdd(r1, One, name);
+    Value *r3 = builder.CreateFDiv(Two, r2, name);
+    return builder.CreateFSub(One, r3, name);
+  }
+
   std::tie(eX, emX) = emitExEmx(builder, X, DM.GetOP(), name);
   Value *r4 = builder.CreateFSub(eX, emX, name);
   Value *r5 = builder.CreateFAdd(eX, emX, name);
@@ -30,6 +30,8 @@
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Pass.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Transforms/Utils/SSAUpdater.h"
@@ -79,29 +81,6 @@ public:
   }
 };
 
-void InitResourceBase(const DxilResourceBase *pSource, DxilResourceBase *pDest) {
-  DXASSERT_NOMSG(pSource->GetClass() == pDest->GetClass());
-  pDest->SetKind(pSource->GetKind());
-  pDest->SetID(pSource->GetID());
-  pDest->SetSpaceID(pSource->GetSpaceID());
-  pDest->SetLowerBound(pSource->GetLowerBound());
-  pDest->SetRangeSize(pSource->GetRangeSize());
-  pDest->SetGlobalSymbol(pSource->GetGlobalSymbol());
-  pDest->SetGlobalName(pSource->GetGlobalName());
-  pDest->SetHandle(pSource->GetHandle());
-}
-
-void InitResource(const DxilResource *pSource, DxilResource *pDest) {
-  pDest->SetCompType(pSource->GetCompType());
-  pDest->SetSampleCount(pSource->GetSampleCount());
-  pDest->SetElementStride(pSource->GetElementStride());
-  pDest->SetGloballyCoherent(pSource->IsGloballyCoherent());
-  pDest->SetHasCounter(pSource->HasCounter());
-  pDest->SetRW(pSource->IsRW());
-  pDest->SetROV(pSource->IsROV());
-  InitResourceBase(pSource, pDest);
-}
-
 void InitDxilModuleFromHLModule(HLModule &H, DxilModule &M, DxilEntrySignature *pSig, bool HasDebugInfo) {
   // Subsystems.
   unsigned ValMajor, ValMinor;
@@ -117,44 +96,33 @@ void InitDxilModuleFromHLModule(HLModule &H, DxilModule &M, DxilEntrySignature *
   
   std::vector<GlobalVariable* > &LLVMUsed = M.GetLLVMUsed();
 
-  // Resources
-  for (auto && C : H.GetCBuffers()) {
-    auto b = make_unique<DxilCBuffer>();
-    InitResourceBase(C.get(), b.get());
-    b->SetSize(C->GetSize());
-    if (HasDebugInfo)
-      LLVMUsed.emplace_back(cast<GlobalVariable>(b->GetGlobalSymbol()));
-
-    b->SetGlobalSymbol(UndefValue::get(b->GetGlobalSymbol()->getType()));
-    M.AddCBuffer(std::move(b));
-  }
-  for (auto && C : H.GetUAVs()) {
-    auto b = make_unique<DxilResource>();
-    InitResource(C.get(), b.get());
-    if (HasDebugInfo)
-      LLVMUsed.emplace_back(cast<GlobalVariable>(b->GetGlobalSymbol()));
-
-    b->SetGlobalSymbol(UndefValue::get(b->GetGlobalSymbol()->getType()));
-    M.AddUAV(std::move(b));
-  }
-  for (auto && C : H.GetSRVs()) {
-    auto b = make_unique<DxilResource>();
-    InitResource(C.get(), b.get());
-    if (HasDebugInfo)
-      LLVMUsed.emplace_back(cast<GlobalVariable>(b->GetGlobalSymbol()));
-
-    b->SetGlobalSymbol(UndefValue::get(b->GetGlobalSymbol()->getType()));
-    M.AddSRV(std::move(b));
-  }
-  for (auto && C : H.GetSamplers()) {
-    auto b = make_unique<DxilSampler>();
-    InitResourceBase(C.get(), b.get());
-    b->SetSamplerKind(C->GetSamplerKind());
+  // Resources. HLResource adds nothing to DxilResource, so the objects are
+  // moved over rather than copied; only their global symbols change, as the
+  // globals are removed from the DXIL module.
+  auto MoveResource = [&](DxilResourceBase &R) {
     if (HasDebugInfo)
-      LLVMUsed.emplace_back(cast<GlobalVariable>(b->GetGlobalSymbol()));
-
-    b->SetGlobalSymbol(UndefValue::get(b->GetGlobalSymbol()->getType()));
-    M.AddSampler(std::move(b));
+      LLVMUsed.emplace_back(cast<GlobalVariable>(R.GetGlobalSymbol()));
+    R.SetGlobalSymbol(UndefValue::get(R.GetGlobalSymbol()->getType()));
+  };
+  std::vector<std::unique_ptr<DxilCBuffer> > CBuffers = H.ReleaseCBuffers();
+  for (std::unique_ptr<DxilCBuffer> &C : CBuffers) {
+    MoveResource(*C);
+    M.AddCBuffer(std::move(C));
+  }
+  std::vector<std::unique_ptr<HLResource> > UAVs = H.ReleaseUAVs();
+  for (std::unique_ptr<HLResource> &C : UAVs) {
+    MoveResource(*C);
+    M.AddUAV(std::move(C));
+  }
+  std::vector<std::unique_ptr<HLResource> > SRVs = H.ReleaseSRVs();
+  for (std::unique_ptr<HLResource> &C : SRVs) {
+    MoveResource(*C);
+    M.AddSRV(std::move(C));
+  }
+  std::vector<std::unique_ptr<DxilSampler> > Samplers = H.ReleaseSamplers();
+  for (std::unique_ptr<DxilSampler> &C : Samplers) {
+    MoveResource(*C);
+    M.AddSampler(std::move(C));
   }
 
   // Signatures.
@@ -410,11 +378,11 @@ static bool IsResourceType(Type *Ty) {
 
 void DxilGenerationPass::RemoveLocalDxilResourceAllocas(Function *F) {
   BasicBlock &BB = F->getEntryBlock(); // Get the entry node for the function
-  std::unordered_set<AllocaInst *> localResources;
+  SmallVector<AllocaInst *, 4> localResources;
   for (BasicBlock::iterator I = BB.begin(), E = --BB.end(); I != E; ++I)
     if (AllocaInst *AI = dyn_cast<AllocaInst>(I)) { // Is it an alloca?
       if (IsResourceType(AI->getAllocatedType())) {
-        localResources.insert(AI);
+        localResources.push_back(AI);
       }
     }
 
@@ -683,7 +651,7 @@ void DxilGenerationPass::GenerateDxilResourceHandles(
 }
 
 static void
-AddResourceToSet(Instruction *Res, std::unordered_set<Instruction *> &resSet) {
+AddResourceToSet(Instruction *Res, SetVector<Instruction *> &resSet) {
   unsigned startOpIdx = 0;
   // Skip Cond for Select.
   if (isa<SelectInst>(Res))
@@ -799,7 +767,8 @@ void DxilGenerationPass::AddCreateHandleForPhiNodeAndSelect(OP *hlslOP) {
 
   std::unordered_set<PHINode *> objPhiList;
   std::unordered_set<SelectInst *> objSelectList;
-  std::unordered_set<Instruction *> resSelectSet;
+  // In the order found, as handles are created in this order.
+  SetVector<Instruction *> resSelectSet;
   for (User *U : createHandle->users()) {
     for (User *HandleU : U->users()) {
       Instruction *I = cast<Instruction>(HandleU);
@@ -1435,7 +1404,8 @@ void CheckInBoundForTGSM(GlobalVariable &GV, const DataLayout &DL) {
 class DxilEmitMetadata : public ModulePass {
 public:
   static char ID; // Pass identification, replacement for typeid
-  explicit DxilEmitMetadata() : ModulePass(ID) {}
+  explicit DxilEmitMetadata(bool EmitRootSignature = true)
+      : ModulePass(ID), m_EmitRootSignature(EmitRootSignature) {}
 
   const char *getPassName() const override { return "HLSL DXIL Metadata Emit"; }
 
@@ -1612,19 +1582,22 @@ public:
       DM.CollectShaderFlags(); // Update flags to reflect any changes.
                                // Update Validator Version
       DM.UpgradeToMinValidatorVersion();
-      DM.EmitDxilMetadata();
+      DM.EmitDxilMetadata(m_EmitRootSignature);
       return true;
     }
 
     return false;
   }
+
+private:
+  bool m_EmitRootSignature;
 };
 }
 
 char DxilEmitMetadata::ID = 0;
 
-ModulePass *llvm::createDxilEmitMetadataPass() {
-  return new DxilEmitMetadata();
+ModulePass *llvm::createDxilEmitMetadataPass(bool EmitRootSignature) {
+  return new DxilEmitMetadata(EmitRootSignature);
 }
 
 INITIALIZE_PASS(DxilEmitMetadata, "hlsl-dxilemit", "HLSL DXIL Metadata Emit", false, false)
@@ -1634,6 +1607,26 @@ INITIALIZE_PASS(DxilEmitMetadata, "hlsl-dxilemit", "HLSL DXIL Metadata Emit", fa
 // Precise propagate.
 
 namespace {
+// Propagates precise from values to everything they are computed from. Values
+// and memory locations are each processed once, so values reached through
+// many paths, like shared tessellation factors, don't make it exponential.
+class PrecisePropagator {
+public:
+  PrecisePropagator(DxilTypeSystem &typeSys) : m_typeSys(typeSys) {}
+  void Propagate(Value *V);
+
+private:
+  void AddValue(Value *V);
+  void AddPointer(Value *Ptr);
+  void ProcessValue(Instruction *I);
+  void ProcessPointer(Value *Ptr);
+
+  DxilTypeSystem &m_typeSys;
+  SmallPtrSet<Value *, 32> m_visited;
+  SmallVector<Instruction *, 32> m_valueWorklist;
+  SmallVector<Value *, 8> m_pointerWorklist;
+};
+
 class DxilPrecisePropagatePass : public ModulePass {
   HLModule *m_pHLModule;
 
@@ -1647,10 +1640,13 @@ public:
     DxilModule &dxilModule = M.GetOrCreateDxilModule();
     DxilTypeSystem &typeSys = dxilModule.GetTypeSystem();
 
+    // One propagator for the module, values marked by one precise function
+    // need no visit for the next.
+    PrecisePropagator propagator(typeSys);
     std::vector<Function*> deadList;
     for (Function &F : M.functions()) {
       if (HLModule::HasPreciseAttribute(&F)) {
-        PropagatePreciseOnFunctionUser(F, typeSys);
+        PropagatePreciseOnFunctionUser(F, propagator);
         deadList.emplace_back(&F);
       }
     }
@@ -1659,16 +1655,25 @@ public:
     return true;
   }
 private:
-  void PropagatePreciseOnFunctionUser(Function &F, DxilTypeSystem &typeSys);
+  void PropagatePreciseOnFunctionUser(Function &F,
+                                      PrecisePropagator &propagator);
 };
 
 char DxilPrecisePropagatePass::ID = 0;
 
 }
 
-static void PropagatePreciseAttribute(Instruction *I, DxilTypeSystem &typeSys);
+void PrecisePropagator::Propagate(Value *V) {
+  AddValue(V);
+  while (!m_valueWorklist.empty() || !m_pointerWorklist.empty()) {
+    if (!m_pointerWorklist.empty())
+      ProcessPointer(m_pointerWorklist.pop_back_val());
+    else
+      ProcessValue(m_valueWorklist.pop_back_val());
+  }
+}
 
-static void PropagatePreciseAttributeOnOperand(Value *V, DxilTypeSystem &typeSys, LLVMContext &Context) {
+void PrecisePropagator::AddValue(Value *V) {
   Instruction *I = dyn_cast<Instruction>(V);
   // Skip none inst.
   if (!I)
@@ -1679,7 +1684,9 @@ static void PropagatePreciseAttributeOnOperand(Value *V, DxilTypeSystem &typeSys
   if (!FPMath)
     return;
 
-  // Skip inst already marked.
+  // Skip inst already visited or marked.
+  if (!m_visited.insert(I).second)
+    return;
   if (DxilModule::HasPreciseFastMathFlags(I))
     return;
   // TODO: skip precise on integer type, sample instruction...
@@ -1691,23 +1698,44 @@ static void PropagatePreciseAttributeOnOperand(Value *V, DxilTypeSystem &typeSys
   // Fast math not work on call, use metadata.
   if (CallInst *CI = dyn_cast<CallInst>(I))
     HLModule::MarkPreciseAttributeWithMetadata(CI);
-  PropagatePreciseAttribute(I, typeSys);
+  m_valueWorklist.emplace_back(I);
+}
+
+void PrecisePropagator::AddPointer(Value *Ptr) {
+  if (m_visited.insert(Ptr).second)
+    m_pointerWorklist.emplace_back(Ptr);
+}
+
+void PrecisePropagator::ProcessValue(Instruction *I) {
+  if (LoadInst *ldInst = dyn_cast<LoadInst>(I)) {
+    // Loads are FPMath too, check them first to reach the stores.
+    AddPointer(ldInst->getPointerOperand());
+  } else if (isa<CallInst>(I) || isa<FPMathOperator>(I)) {
+    // Propagate every argument.
+    // TODO: only propagate precise argument.
+    for (Value *src : I->operands())
+      AddValue(src);
+  }
+  // TODO: support more case which need
 }
 
-static void PropagatePreciseAttributeOnPointer(Value *Ptr, DxilTypeSystem &typeSys, LLVMContext &Context) {
+void PrecisePropagator::ProcessPointer(Value *Ptr) {
   // Find all store and propagate on the val operand of store.
   // For CallInst, if Ptr is used as out parameter, mark it.
   for (User *U : Ptr->users()) {
-    Instruction *user = cast<Instruction>(U);
-    if (StoreInst *stInst = dyn_cast<StoreInst>(user)) {
-      Value *val = stInst->getValueOperand();
-      PropagatePreciseAttributeOnOperand(val, typeSys, Context);
-    }
-    else if (CallInst *CI = dyn_cast<CallInst>(user)) {
+    if (StoreInst *stInst = dyn_cast<StoreInst>(U)) {
+      if (stInst->getPointerOperand() == Ptr)
+        AddValue(stInst->getValueOperand());
+    } else if (CallInst *CI = dyn_cast<CallInst>(U)) {
       bool bReadOnly = true;
 
       Function *F = CI->getCalledFunction();
-      const DxilFunctionAnnotation *funcAnnotation = typeSys.GetFunctionAnnotation(F);
+      const DxilFunctionAnnotation *funcAnnotation =
+          F ? m_typeSys.GetFunctionAnnotation(F) : nullptr;
+      // Functions without annotation, like dxil operations, don't write
+      // through pointer arguments.
+      if (!funcAnnotation)
+        continue;
       for (unsigned i = 0; i < CI->getNumArgOperands(); ++i) {
         if (Ptr != CI->getArgOperand(i))
           continue;
@@ -1725,39 +1753,17 @@ static void PropagatePreciseAttributeOnPointer(Value *Ptr, DxilTypeSystem &typeS
       }
 
       if (!bReadOnly)
-        PropagatePreciseAttributeOnOperand(CI, typeSys, Context);
+        AddValue(CI);
     }
   }
 }
 
-static void PropagatePreciseAttribute(Instruction *I, DxilTypeSystem &typeSys) {
-  LLVMContext &Context = I->getContext();
-  if (AllocaInst *AI = dyn_cast<AllocaInst>(I)) {
-    PropagatePreciseAttributeOnPointer(AI, typeSys, Context);
-  } else if (CallInst *CI = dyn_cast<CallInst>(I)) {
-    // Propagate every argument.
-    // TODO: only propagate precise argument.
-    for (Value *src : I->operands())
-      PropagatePreciseAttributeOnOperand(src, typeSys, Context);
-  } else if (FPMathOperator *FPMath = dyn_cast<FPMathOperator>(I)) {
-    // TODO: only propagate precise argument.
-    for (Value *src : I->operands())
-      PropagatePreciseAttributeOnOperand(src, typeSys, Context);
-  }
-  else if (LoadInst *ldInst = dyn_cast<LoadInst>(I)) {
-    Value *Ptr = ldInst->getPointerOperand();
-    PropagatePreciseAttributeOnPointer(Ptr, typeSys, Context);
-  } else if (GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(I))
-    PropagatePreciseAttributeOnPointer(GEP, typeSys, Context);
-  // TODO: support more case which need 
-}
-
-void DxilPrecisePropagatePass::PropagatePreciseOnFunctionUser(Function &F, DxilTypeSystem &typeSys) {
-  LLVMContext &Context = F.getContext();
+void DxilPrecisePropagatePass::PropagatePreciseOnFunctionUser(
+    Function &F, PrecisePropagator &propagator) {
   for (auto U=F.user_begin(), E=F.user_end();U!=E;) {
     CallInst *CI = cast<CallInst>(*(U++));
     Value *V = CI->getArgOperand(0);
-    PropagatePreciseAttributeOnOperand(V, typeSys, Context);
+    propagator.Propagate(V);
     CI->eraseFromParent();
   }
 }
@@ -1915,11 +1921,12 @@ void DxilLegalizeStaticResourceUsePass::PromoteStaticGlobalResources(
   HLModule &HLM = M.GetOrCreateHLModule();
   Type *HandleTy = HLM.GetOP()->GetHandleType();
 
-  std::set<GlobalVariable *> staticResources;
+  // In module order, as each promotion inserts instructions.
+  std::vector<GlobalVariable *> staticResources;
   for (auto &GV : M.globals()) {
     if (GV.getLinkage() == GlobalValue::LinkageTypes::InternalLinkage &&
         HandleTy == HLModule::GetArrayEltTy(GV.getType())) {
-      staticResources.insert(&GV);
+      staticResources.push_back(&GV);
     }
   }
   SSAUpdater SSA;
@@ -1928,7 +1935,7 @@ void DxilLegalizeStaticResourceUsePass::PromoteStaticGlobalResources(
   while (!staticResources.empty()) {
     bool bUpdated = false;
     for (auto it = staticResources.begin(); it != staticResources.end();) {
-      GlobalVariable *GV = *(it++);
+      GlobalVariable *GV = *it;
       // Build list of instructions to promote.
       for (User *U : GV->users()) {
         Instruction *I = cast<Instruction>(U);
@@ -1938,7 +1945,9 @@ void DxilLegalizeStaticResourceUsePass::PromoteStaticGlobalResources(
       LoadAndStorePromoter(Insts, SSA).run(Insts);
       if (GV->user_empty()) {
         bUpdated = true;
-        staticResources.erase(GV);
+        it = staticResources.erase(it);
+      } else {
+        ++it;
       }
 
       Insts.clear();
@@ -2028,7 +2037,7 @@ public:
         }
         // Start from the call instruction, find all allocas that this call
         // uses.
-        std::unordered_set<AllocaInst *> allocas;
+        SetVector<AllocaInst *> allocas;
         for (CallInst *CI : EvalFunctionCalls) {
           FindAllocasForEvalOperations(CI, allocas);
         }
@@ -2050,14 +2059,14 @@ public:
 
 private:
   void FindAllocasForEvalOperations(Value *val,
-                                    std::unordered_set<AllocaInst *> &allocas);
+                                    SetVector<AllocaInst *> &allocas);
 };
 
 char DxilLegalizeEvalOperations::ID = 0;
 
 // Find allocas for EvaluateAttribute operations
 void DxilLegalizeEvalOperations::FindAllocasForEvalOperations(
-    Value *val, std::unordered_set<AllocaInst *> &allocas) {
+    Value *val, SetVector<AllocaInst *> &allocas) {
   Value *CurVal = val;
   while (!isa<AllocaInst>(CurVal)) {
     if (CallInst *CI = dyn_cast<CallInst>(CurVal)) {
@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilHoistSamples.cpp                                                      //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Speculatively hoists texture samples and loads above the branches that    //
+// guard them, so their latency overlaps the evaluation of the condition.    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <algorithm>
+#include <memory>
+
+using namespace llvm;
+using namespace hlsl;
+
+#define DEBUG_TYPE "hlsl-dxil-hoist-samples"
+
+namespace {
+// A sample in a block reached only through one side of a conditional branch
+// cannot be issued until the branch resolves. Moving it to the end of the
+// branching block lets its latency overlap the condition, at the cost of
+// a wasted sample on the other side. A sample or load is moved when:
+// - it reads an SRV, so no other thread's write can be guarded by the
+//   branch, and its descriptors are known valid: all resources are bound,
+//   or each handle is already used where the branch is;
+// - its operands are available at the branch, or computed in its block by
+//   at most kMaxOperandChain instructions that are moved with it, and
+//   nothing before it in its block writes memory or has side effects;
+// - if it computes implicit derivatives, the branch is uniform, so the same
+//   lanes of each quad run it before and after;
+// - the branch has no [branch] hint, which asks for only the taken side to
+//   run and so opts out;
+// - fewer than kMaxHoistedPerBranch were moved for the same side already.
+// The number moved is reported in an optimization remark.
+class DxilHoistSamples : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilHoistSamples()
+      : FunctionPass(ID), m_pAnalysis(DxilUniformityAnalysis::create()) {}
+
+  const char *getPassName() const override {
+    return "DXIL hoist samples";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override;
+
+private:
+  static const unsigned kMaxHoistedPerBranch = 4;
+  static const unsigned kMaxOperandChain = 8;
+  std::unique_ptr<DxilUniformityAnalysis> m_pAnalysis;
+  // Moved calls, which don't show that a descriptor is valid.
+  SmallPtrSet<Instruction *, 16> m_Hoisted;
+
+  static bool IsCandidate(CallInst *CI, bool &bHasSampler,
+                          bool &bImplicitDerivatives);
+  static bool HasBranchHint(BranchInst *BI);
+  bool IsHandleSafe(Value *Handle, DXIL::ResourceClass Class, BranchInst *BI,
+                    DominatorTree &DT, bool bAllResourcesBound);
+  static bool CollectOperands(Value *V, BranchInst *BI, DominatorTree &DT,
+                              SmallVectorImpl<Instruction *> &Chain);
+  unsigned HoistFrom(BasicBlock *BB, BranchInst *BI, DominatorTree &DT,
+                     bool bUniformBranch, bool bAllResourcesBound);
+};
+
+char DxilHoistSamples::ID = 0;
+
+bool DxilHoistSamples::IsCandidate(CallInst *CI, bool &bHasSampler,
+                                   bool &bImplicitDerivatives) {
+  if (!OP::IsDxilOpFuncCallInst(CI))
+    return false;
+  bHasSampler = true;
+  bImplicitDerivatives = false;
+  switch (OP::GetDxilOpFuncCallInst(CI)) {
+  case OP::OpCode::Sample:
+  case OP::OpCode::SampleBias:
+  case OP::OpCode::SampleCmp:
+    bImplicitDerivatives = true;
+    return true;
+  case OP::OpCode::SampleLevel:
+  case OP::OpCode::SampleGrad:
+  case OP::OpCode::SampleCmpLevelZero:
+  case OP::OpCode::TextureGather:
+  case OP::OpCode::TextureGatherCmp:
+    return true;
+  case OP::OpCode::TextureLoad:
+  case OP::OpCode::BufferLoad:
+    bHasSampler = false;
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool DxilHoistSamples::HasBranchHint(BranchInst *BI) {
+  MDNode *pNode = BI->getMetadata(DxilMDHelper::kDxilControlFlowHintMDName);
+  if (!pNode)
+    return false;
+  for (unsigned i = 2; i < pNode->getNumOperands(); ++i) {
+    ConstantAsMetadata *pHint =
+        dyn_cast<ConstantAsMetadata>(pNode->getOperand(i));
+    ConstantInt *pValue =
+        pHint ? dyn_cast<ConstantInt>(pHint->getValue()) : nullptr;
+    if (pValue &&
+        pValue->getLimitedValue() == (unsigned)DXIL::ControlFlowHint::Branch)
+      return true;
+  }
+  return false;
+}
+
+bool DxilHoistSamples::IsHandleSafe(Value *Handle, DXIL::ResourceClass Class,
+                                    BranchInst *BI, DominatorTree &DT,
+                                    bool bAllResourcesBound) {
+  CallInst *CI = dyn_cast<CallInst>(Handle);
+  if (!CI || !DxilInst_CreateHandle(CI))
+    return false;
+  DxilInst_CreateHandle CH(CI);
+  ConstantInt *HandleClass = dyn_cast<ConstantInt>(CH.get_resourceClass());
+  if (!HandleClass || HandleClass->getLimitedValue() != (unsigned)Class)
+    return false;
+  if (bAllResourcesBound)
+    return true;
+  // A resource access that runs whenever the branch does shows the
+  // descriptor is valid there.
+  for (User *U : CI->users()) {
+    Instruction *I = dyn_cast<Instruction>(U);
+    if (I && !m_Hoisted.count(I) && DT.dominates(I, BI))
+      return true;
+  }
+  return false;
+}
+
+// Adds to Chain, operands first, the instructions V needs that are not
+// available at BI. Returns false if one cannot be speculated.
+bool DxilHoistSamples::CollectOperands(Value *V, BranchInst *BI,
+                                       DominatorTree &DT,
+                                       SmallVectorImpl<Instruction *> &Chain) {
+  Instruction *I = dyn_cast<Instruction>(V);
+  if (!I || DT.dominates(I, BI) ||
+      std::find(Chain.begin(), Chain.end(), I) != Chain.end())
+    return true;
+  if (isa<PHINode>(I) || !isSafeToSpeculativelyExecute(I))
+    return false;
+  for (Value *Op : I->operands()) {
+    if (!CollectOperands(Op, BI, DT, Chain))
+      return false;
+  }
+  if (Chain.size() == kMaxOperandChain)
+    return false;
+  Chain.push_back(I);
+  return true;
+}
+
+unsigned DxilHoistSamples::HoistFrom(BasicBlock *BB, BranchInst *BI,
+                                     DominatorTree &DT, bool bUniformBranch,
+                                     bool bAllResourcesBound) {
+  unsigned Count = 0;
+  for (auto It = BB->begin(), E = BB->end();
+       It != E && Count < kMaxHoistedPerBranch;) {
+    Instruction *I = &*(It++);
+    if (isa<PHINode>(I))
+      break;
+    CallInst *CI = dyn_cast<CallInst>(I);
+    bool bHasSampler, bImplicitDerivatives;
+    if (!CI || !IsCandidate(CI, bHasSampler, bImplicitDerivatives)) {
+      // Anything later could depend on what this writes.
+      if (I->mayHaveSideEffects())
+        break;
+      continue;
+    }
+    if (bImplicitDerivatives && !bUniformBranch)
+      continue;
+    SmallVector<Instruction *, kMaxOperandChain> Chain;
+    bool bAvailable = true;
+    for (Value *Arg : CI->arg_operands()) {
+      if (!CollectOperands(Arg, BI, DT, Chain)) {
+        bAvailable = false;
+        break;
+      }
+    }
+    // Every candidate takes the resource handle first, then the sampler.
+    if (!bAvailable ||
+        !IsHandleSafe(CI->getArgOperand(1), DXIL::ResourceClass::SRV, BI, DT,
+                      bAllResourcesBound) ||
+        (bHasSampler &&
+         !IsHandleSafe(CI->getArgOperand(2), DXIL::ResourceClass::Sampler, BI,
+                       DT, bAllResourcesBound)))
+      continue;
+    // The chain comes before CI in BB, so the iterator is past it.
+    for (Instruction *Op : Chain)
+      Op->moveBefore(BI);
+    CI->moveBefore(BI);
+    m_Hoisted.insert(CI);
+    ++Count;
+  }
+  return Count;
+}
+
+bool DxilHoistSamples::runOnFunction(Function &F) {
+  Module *M = F.getParent();
+  if (!M->HasDxilModule() || F.isDeclaration())
+    return false;
+  bool bAllResourcesBound = M->GetDxilModule().GetAllResourcesBound();
+  DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  m_pAnalysis->Analyze(&F);
+  m_Hoisted.clear();
+
+  unsigned Hoisted = 0;
+  for (BasicBlock &BB : F) {
+    BranchInst *BI = dyn_cast<BranchInst>(BB.getTerminator());
+    if (!BI || !BI->isConditional() || HasBranchHint(BI))
+      continue;
+    bool bUniformBranch = m_pAnalysis->IsUniformBranch(BI);
+    for (BasicBlock *Succ : BI->successors()) {
+      // Only blocks the branch alone leads to, so that the moved calls
+      // still run whenever they did.
+      if (Succ == &BB || Succ->getSinglePredecessor() != &BB)
+        continue;
+      Hoisted += HoistFrom(Succ, BI, DT, bUniformBranch, bAllResourcesBound);
+    }
+  }
+
+  if (Hoisted)
+    emitOptimizationRemark(F.getContext(), DEBUG_TYPE, F, DebugLoc(),
+                           Twine("hoisted ") + Twine(Hoisted) +
+                               " samples and loads above branches");
+  return Hoisted != 0;
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilHoistSamplesPass() {
+  return new DxilHoistSamples();
+}
+
+INITIALIZE_PASS_BEGIN(DxilHoistSamples, "hlsl-dxil-hoist-samples",
+                      "DXIL hoist samples", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_END(DxilHoistSamples, "hlsl-dxil-hoist-samples",
+                    "DXIL hoist samples", false, false)
@@ -13,9 +13,13 @@
 #include "dxc/HLSL/DxilModule.h"
 #include "dxc/HLSL/DxilOperations.h"
 
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
@@ -23,6 +27,7 @@
 #include "llvm/IR/PassManager.h"
 #include "llvm/Pass.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
 
 #include <unordered_set>
 
@@ -31,10 +36,20 @@ using std::unique_ptr;
 using namespace llvm;
 using namespace hlsl;
 
+#define DEBUG_TYPE "dxil-legalize-sample-offset"
+
 ///////////////////////////////////////////////////////////////////////////////
 // Legalize Sample offset.
 
 namespace {
+bool HasPHINodes(Function &F) {
+  for (BasicBlock &BB : F) {
+    if (isa<PHINode>(BB.begin()))
+      return true;
+  }
+  return false;
+}
+
 // When optimizations are disabled, try to legalize sample offset.
 class DxilLegalizeSampleOffsetPass : public FunctionPass {
 
@@ -46,6 +61,12 @@ public:
     return "DXIL legalize sample offset";
   }
 
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AssumptionCacheTracker>();
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<LoopInfoWrapperPass>();
+  }
+
   bool runOnFunction(Function &F) override {
     DxilModule &DM = F.getParent()->GetOrCreateDxilModule();
     hlsl::OP *hlslOP = DM.GetOP();
@@ -58,9 +79,9 @@ public:
       return false;
 
     // Loop unroll if has offset inside loop.
-    TryUnrollLoop(illegalOffsets, F);
+    TryUnrollLoop(illegalOffsets, F, hlslOP);
 
-    // Collect offset again after mem2reg.
+    // Collect offset again after promotion.
     std::vector<Instruction *> ssaIllegalOffsets;
     CollectIllegalOffsets(ssaIllegalOffsets, F, hlslOP);
 
@@ -68,9 +89,11 @@ public:
     LegalizeOffsets(ssaIllegalOffsets);
 
     // Remove PHINodes to keep code shape.
-    legacy::FunctionPassManager PM(F.getParent());
-    PM.add(createDemoteRegisterToMemoryHlslPass());
-    PM.run(F);
+    if (HasPHINodes(F)) {
+      legacy::FunctionPassManager PM(F.getParent());
+      PM.add(createDemoteRegisterToMemoryHlslPass());
+      PM.run(F);
+    }
 
     FinalCheck(illegalOffsets, F, hlslOP);
 
@@ -78,7 +101,8 @@ public:
   }
 
 private:
-  void TryUnrollLoop(std::vector<Instruction *> &illegalOffsets, Function &F);
+  void TryUnrollLoop(std::vector<Instruction *> &illegalOffsets, Function &F,
+                     hlsl::OP *hlslOP);
   void CollectIllegalOffsets(std::vector<Instruction *> &illegalOffsets,
                              Function &F, hlsl::OP *hlslOP);
   void CollectIllegalOffsets(std::vector<Instruction *> &illegalOffsets,
@@ -92,12 +116,7 @@ private:
 char DxilLegalizeSampleOffsetPass::ID = 0;
 
 bool HasIllegalOffsetInLoop(std::vector<Instruction *> &illegalOffsets,
-                            Function &F) {
-  DominatorTreeAnalysis DTA;
-  DominatorTree DT = DTA.run(F);
-  LoopInfo LI;
-  LI.Analyze(DT);
-
+                            LoopInfo &LI) {
   bool findOffset = false;
 
   for (Instruction *I : illegalOffsets) {
@@ -125,6 +144,70 @@ void CollectIllegalOffset(CallInst *CI,
       illegalOffsets.emplace_back(I);
   }
 }
+
+// Collects the allocas the offsets are computed from, and those that the exit
+// conditions of the loops computing them read, which are the only ones that
+// need promoting for the offsets to simplify.
+void CollectOffsetAllocas(const std::vector<Instruction *> &illegalOffsets,
+                          LoopInfo &LI, std::vector<AllocaInst *> &allocas) {
+  SmallPtrSet<Value *, 32> visited;
+  SmallPtrSet<Loop *, 8> visitedLoops;
+  SmallVector<Value *, 32> worklist(illegalOffsets.begin(),
+                                    illegalOffsets.end());
+  while (!worklist.empty()) {
+    Value *V = worklist.pop_back_val();
+    if (!visited.insert(V).second)
+      continue;
+    if (AllocaInst *AI = dyn_cast<AllocaInst>(V)) {
+      BasicBlock *Entry = &AI->getParent()->getParent()->getEntryBlock();
+      if (AI->getParent() == Entry && isAllocaPromotable(AI)) {
+        allocas.emplace_back(AI);
+        for (User *U : AI->users()) {
+          if (StoreInst *SI = dyn_cast<StoreInst>(U))
+            worklist.push_back(SI->getValueOperand());
+        }
+      }
+      continue;
+    }
+    Instruction *I = dyn_cast<Instruction>(V);
+    if (!I)
+      continue;
+    for (Loop *L = LI.getLoopFor(I->getParent()); L; L = L->getParentLoop()) {
+      if (!visitedLoops.insert(L).second)
+        break;
+      SmallVector<BasicBlock *, 4> exitingBlocks;
+      L->getExitingBlocks(exitingBlocks);
+      for (BasicBlock *BB : exitingBlocks) {
+        BranchInst *BI = dyn_cast<BranchInst>(BB->getTerminator());
+        if (BI && BI->isConditional())
+          worklist.push_back(BI->getCondition());
+      }
+    }
+    for (Value *Op : I->operands())
+      worklist.push_back(Op);
+  }
+}
+
+// Unrolling a loop only helps the offsets computed from values the loop
+// defines; other loops are left as written.
+bool OffsetsDependOnLoop(const std::vector<Instruction *> &illegalOffsets,
+                         Loop *L) {
+  SmallPtrSet<Instruction *, 16> visited;
+  SmallVector<Instruction *, 16> worklist(illegalOffsets.begin(),
+                                          illegalOffsets.end());
+  while (!worklist.empty()) {
+    Instruction *I = worklist.pop_back_val();
+    if (!visited.insert(I).second)
+      continue;
+    if (L->contains(I))
+      return true;
+    for (Value *Op : I->operands()) {
+      if (Instruction *OpI = dyn_cast<Instruction>(Op))
+        worklist.push_back(OpI);
+    }
+  }
+  return false;
+}
 }
 
 void DxilLegalizeSampleOffsetPass::FinalCheck(
@@ -151,18 +234,56 @@ void DxilLegalizeSampleOffsetPass::FinalCheck(
 }
 
 void DxilLegalizeSampleOffsetPass::TryUnrollLoop(
-    std::vector<Instruction *> &illegalOffsets, Function &F) {
-  legacy::FunctionPassManager PM(F.getParent());
-  // Always need mem2reg for simplify illegal offsets.
-  PM.add(createPromoteMemoryToRegisterPass());
-
-  if (HasIllegalOffsetInLoop(illegalOffsets, F)) {
-    PM.add(createCFGSimplificationPass());
-    PM.add(createLCSSAPass());
-    PM.add(createLoopSimplifyPass());
-    PM.add(createLoopRotatePass());
-    PM.add(createLoopUnrollPass(-2, -1, 0, 0));
+    std::vector<Instruction *> &illegalOffsets, Function &F,
+    hlsl::OP *hlslOP) {
+  // The offsets are still loads from allocas, so this has to be answered
+  // before promotion removes them.
+  LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  bool hasOffsetInLoop = HasIllegalOffsetInLoop(illegalOffsets, LI);
+
+  // Promote only the variables the offsets depend on, so the rest of the
+  // function keeps its memory form and nothing needs demoting afterwards.
+  // Promotion does not change the CFG, so the dominator tree computed for
+  // this pass stays valid.
+  std::vector<AllocaInst *> allocas;
+  CollectOffsetAllocas(illegalOffsets, LI, allocas);
+  if (!allocas.empty()) {
+    DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    AssumptionCache &AC =
+        getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F);
+    PromoteMemToReg(allocas, DT, nullptr, &AC);
   }
+
+  if (!hasOffsetInLoop)
+    return;
+
+  LoopUnrollCallbacks callbacks;
+  callbacks.ShouldUnroll = [this, &F, hlslOP](Loop *L) {
+    std::vector<Instruction *> loopOffsets;
+    CollectIllegalOffsets(loopOffsets, F, hlslOP);
+    return OffsetsDependOnLoop(loopOffsets, L);
+  };
+  callbacks.Unrolled = [&F](const DebugLoc &Loc, unsigned Count,
+                            unsigned TripCount) {
+    if (Count == TripCount)
+      emitOptimizationRemark(F.getContext(), DEBUG_TYPE, F, Loc,
+                             Twine("completely unrolled loop with ") +
+                                 Twine(TripCount) +
+                                 " iterations to make sample offsets "
+                                 "immediate");
+    else
+      emitOptimizationRemark(F.getContext(), DEBUG_TYPE, F, Loc,
+                             Twine("unrolled loop by a factor of ") +
+                                 Twine(Count) +
+                                 " to make sample offsets immediate");
+  };
+
+  legacy::FunctionPassManager PM(F.getParent());
+  PM.add(createCFGSimplificationPass());
+  PM.add(createLCSSAPass());
+  PM.add(createLoopSimplifyPass());
+  PM.add(createLoopRotatePass());
+  PM.add(createLoopUnrollPass(-2, -1, 0, 0, std::move(callbacks)));
   PM.run(F);
 }
 
@@ -207,5 +328,12 @@ FunctionPass *llvm::createDxilLegalizeSampleOffsetPass() {
   return new DxilLegalizeSampleOffsetPass();
 }
 
-INITIALIZE_PASS(DxilLegalizeSampleOffsetPass, "dxil-legalize-sample-offset",
-                "DXIL legalize sample offset", false, false)
+INITIALIZE_PASS_BEGIN(DxilLegalizeSampleOffsetPass,
+                      "dxil-legalize-sample-offset",
+                      "DXIL legalize sample offset", false, false)
+INITIALIZE_PASS_DEPENDENCY(AssumptionCacheTracker)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_END(DxilLegalizeSampleOffsetPass,
+                    "dxil-legalize-sample-offset",
+                    "DXIL legalize sample offset", false, false)
@@ -14,7 +14,11 @@
 #include "dxc/HLSL/DxilOperations.h"
 #include "dxc/HLSL/DxilResource.h"
 #include "dxc/HLSL/DxilSampler.h"
+#include "dxc/HLSL/DxilSignature.h"
 #include "dxc/Support/Global.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/IRBuilder.h"
@@ -22,6 +26,9 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/ADT/StringMap.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -32,6 +39,7 @@
 #include "dxc/HLSL/DxilGenerationPass.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
 
 using namespace llvm;
@@ -39,15 +47,19 @@ using namespace hlsl;
 
 namespace {
 
-void CollectUsedFunctions(Constant *C,
-                          std::unordered_set<Function *> &funcSet) {
-  for (User *U : C->users()) {
-    if (Instruction *I = dyn_cast<Instruction>(U)) {
-      funcSet.insert(I->getParent()->getParent());
-    } else {
-      Constant *CU = cast<Constant>(U);
-      CollectUsedFunctions(CU, funcSet);
-    }
+// Collects the globals C refers to, including those referred to by the
+// initializers of the globals found.
+void CollectUsedGlobals(Constant *C, SetVector<GlobalVariable *> &GVSet) {
+  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(C)) {
+    if (GVSet.insert(GV) && GV->hasInitializer())
+      CollectUsedGlobals(GV->getInitializer(), GVSet);
+    return;
+  }
+  if (isa<GlobalValue>(C))
+    return;
+  for (Value *Op : C->operands()) {
+    if (Constant *OpC = dyn_cast<Constant>(Op))
+      CollectUsedGlobals(OpC, GVSet);
   }
 }
 
@@ -79,6 +91,295 @@ void CloneFunction(Function *F, Function *NewF, ValueToValueMapTy &vmap) {
   }
 }
 
+// Compares function definitions from different libraries. The libraries
+// share a context, so types and constants are uniqued, except for named
+// structs, which are renamed per module, and globals, which are matched by
+// name as the linker resolves them. Values local to the functions are
+// matched by position.
+class FunctionBodyComparator {
+public:
+  bool IsSame(Function *A, Function *B);
+  bool IsSameGlobal(GlobalVariable *A, GlobalVariable *B);
+  bool IsSameConstant(Constant *A, Constant *B) { return IsSameValue(A, B); }
+
+private:
+  DenseMap<const Value *, const Value *> m_valueMap;
+  DenseMap<Type *, Type *> m_typeMap;
+
+  bool IsSameType(Type *A, Type *B);
+  bool IsSameValue(Value *A, Value *B);
+  bool IsSameInstruction(Instruction *A, Instruction *B);
+  bool Map(const Value *A, const Value *B);
+};
+
+bool FunctionBodyComparator::IsSameType(Type *A, Type *B) {
+  if (A == B)
+    return true;
+  if (A->getTypeID() != B->getTypeID() ||
+      A->getNumContainedTypes() != B->getNumContainedTypes())
+    return false;
+  if (StructType *STA = dyn_cast<StructType>(A)) {
+    auto it = m_typeMap.find(A);
+    if (it != m_typeMap.end())
+      return it->second == B;
+    StructType *STB = cast<StructType>(B);
+    if (STA->isPacked() != STB->isPacked() ||
+        STA->isOpaque() != STB->isOpaque())
+      return false;
+    m_typeMap[A] = B;
+  } else if (PointerType *PTA = dyn_cast<PointerType>(A)) {
+    if (PTA->getAddressSpace() != B->getPointerAddressSpace())
+      return false;
+  } else if (isa<SequentialType>(A)) {
+    if ((A->isArrayTy() &&
+         A->getArrayNumElements() != B->getArrayNumElements()) ||
+        (A->isVectorTy() &&
+         A->getVectorNumElements() != B->getVectorNumElements()))
+      return false;
+  } else if (FunctionType *FTA = dyn_cast<FunctionType>(A)) {
+    if (FTA->isVarArg() != cast<FunctionType>(B)->isVarArg())
+      return false;
+  } else {
+    // Other types with the same ID are equal only when uniqued together.
+    return false;
+  }
+  for (unsigned i = 0; i < A->getNumContainedTypes(); ++i) {
+    if (!IsSameType(A->getContainedType(i), B->getContainedType(i)))
+      return false;
+  }
+  return true;
+}
+
+bool FunctionBodyComparator::Map(const Value *A, const Value *B) {
+  auto result = m_valueMap.insert(std::make_pair(A, B));
+  return result.first->second == B;
+}
+
+bool FunctionBodyComparator::IsSameValue(Value *A, Value *B) {
+  if (A == B)
+    return true;
+  if (!IsSameType(A->getType(), B->getType()))
+    return false;
+  if (GlobalValue *GA = dyn_cast<GlobalValue>(A)) {
+    GlobalValue *GB = dyn_cast<GlobalValue>(B);
+    return GB && GA->getName() == GB->getName();
+  }
+  if (ConstantExpr *CA = dyn_cast<ConstantExpr>(A)) {
+    ConstantExpr *CB = dyn_cast<ConstantExpr>(B);
+    if (!CB || CA->getOpcode() != CB->getOpcode() ||
+        CA->getNumOperands() != CB->getNumOperands() ||
+        CA->getRawSubclassOptionalData() != CB->getRawSubclassOptionalData())
+      return false;
+    if (CA->isCompare() && CA->getPredicate() != CB->getPredicate())
+      return false;
+    for (unsigned i = 0; i < CA->getNumOperands(); ++i) {
+      if (!IsSameValue(CA->getOperand(i), CB->getOperand(i)))
+        return false;
+    }
+    return true;
+  }
+  if (isa<Constant>(A) || isa<Constant>(B))
+    return false; // Uniqued, so only equal when identical.
+  auto it = m_valueMap.find(A);
+  return it != m_valueMap.end() && it->second == B;
+}
+
+bool FunctionBodyComparator::IsSameInstruction(Instruction *A,
+                                               Instruction *B) {
+  if (A->getOpcode() != B->getOpcode() ||
+      A->getNumOperands() != B->getNumOperands() ||
+      A->getRawSubclassOptionalData() != B->getRawSubclassOptionalData() ||
+      !IsSameType(A->getType(), B->getType()))
+    return false;
+
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDA, MDB;
+  A->getAllMetadataOtherThanDebugLoc(MDA);
+  B->getAllMetadataOtherThanDebugLoc(MDB);
+  if (MDA != MDB)
+    return false;
+
+  if (CmpInst *CI = dyn_cast<CmpInst>(A)) {
+    if (CI->getPredicate() != cast<CmpInst>(B)->getPredicate())
+      return false;
+  } else if (LoadInst *LI = dyn_cast<LoadInst>(A)) {
+    LoadInst *LB = cast<LoadInst>(B);
+    if (LI->isVolatile() != LB->isVolatile() ||
+        LI->getAlignment() != LB->getAlignment() ||
+        LI->getOrdering() != LB->getOrdering())
+      return false;
+  } else if (StoreInst *SI = dyn_cast<StoreInst>(A)) {
+    StoreInst *SB = cast<StoreInst>(B);
+    if (SI->isVolatile() != SB->isVolatile() ||
+        SI->getAlignment() != SB->getAlignment() ||
+        SI->getOrdering() != SB->getOrdering())
+      return false;
+  } else if (AllocaInst *AI = dyn_cast<AllocaInst>(A)) {
+    AllocaInst *AB = cast<AllocaInst>(B);
+    if (AI->getAlignment() != AB->getAlignment() ||
+        !IsSameType(AI->getAllocatedType(), AB->getAllocatedType()))
+      return false;
+  } else if (CallInst *CI = dyn_cast<CallInst>(A)) {
+    CallInst *CB = cast<CallInst>(B);
+    if (CI->getCallingConv() != CB->getCallingConv() ||
+        CI->getAttributes() != CB->getAttributes() ||
+        CI->isTailCall() != CB->isTailCall())
+      return false;
+  } else if (GetElementPtrInst *GI = dyn_cast<GetElementPtrInst>(A)) {
+    if (!IsSameType(GI->getSourceElementType(),
+                    cast<GetElementPtrInst>(B)->getSourceElementType()))
+      return false;
+  } else if (ExtractValueInst *EI = dyn_cast<ExtractValueInst>(A)) {
+    if (EI->getIndices() != cast<ExtractValueInst>(B)->getIndices())
+      return false;
+  } else if (InsertValueInst *II = dyn_cast<InsertValueInst>(A)) {
+    if (II->getIndices() != cast<InsertValueInst>(B)->getIndices())
+      return false;
+  } else if (PHINode *PA = dyn_cast<PHINode>(A)) {
+    PHINode *PB = cast<PHINode>(B);
+    for (unsigned i = 0; i < PA->getNumIncomingValues(); ++i) {
+      if (!Map(PA->getIncomingBlock(i), PB->getIncomingBlock(i)))
+        return false;
+    }
+  }
+
+  for (unsigned i = 0; i < A->getNumOperands(); ++i) {
+    Value *OpA = A->getOperand(i);
+    Value *OpB = B->getOperand(i);
+    // Blocks may be used before they are reached.
+    if (isa<BasicBlock>(OpA) && isa<BasicBlock>(OpB)) {
+      if (!Map(OpA, OpB))
+        return false;
+    } else if (!IsSameValue(OpA, OpB)) {
+      // Operands defined later in the function are compared once both are
+      // mapped, which happens when the instructions defining them are.
+      if (!isa<Instruction>(OpA) || !isa<Instruction>(OpB) ||
+          m_valueMap.count(OpA) || !Map(OpA, OpB))
+        return false;
+    }
+  }
+  return Map(A, B);
+}
+
+bool FunctionBodyComparator::IsSame(Function *A, Function *B) {
+  if (A->getAttributes() != B->getAttributes() ||
+      A->getCallingConv() != B->getCallingConv() ||
+      A->size() != B->size() ||
+      !IsSameType(A->getFunctionType(), B->getFunctionType()))
+    return false;
+
+  for (auto argA = A->arg_begin(), argB = B->arg_begin(); argA != A->arg_end();
+       ++argA, ++argB)
+    Map(argA, argB);
+
+  for (auto bbA = A->begin(), bbB = B->begin(); bbA != A->end();
+       ++bbA, ++bbB) {
+    if (bbA->size() != bbB->size() || !Map(bbA, bbB))
+      return false;
+    for (auto iA = bbA->begin(), iB = bbB->begin(); iA != bbA->end();
+         ++iA, ++iB) {
+      if (!IsSameInstruction(iA, iB))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool FunctionBodyComparator::IsSameGlobal(GlobalVariable *A,
+                                          GlobalVariable *B) {
+  if (A->isConstant() != B->isConstant() ||
+      A->getLinkage() != B->getLinkage() ||
+      A->hasInitializer() != B->hasInitializer() ||
+      !IsSameType(A->getType(), B->getType()))
+    return false;
+  return !A->hasInitializer() ||
+         IsSameValue(A->getInitializer(), B->getInitializer());
+}
+
+bool IsSameShaderProps(const DxilFunctionProps &A,
+                       const DxilFunctionProps &B) {
+  if (A.shaderKind != B.shaderKind)
+    return false;
+  const auto &PA = A.ShaderProps, &PB = B.ShaderProps;
+  switch (A.shaderKind) {
+  case DXIL::ShaderKind::Compute:
+    return std::equal(PA.CS.numThreads, PA.CS.numThreads + 3,
+                      PB.CS.numThreads);
+  case DXIL::ShaderKind::Geometry:
+    return PA.GS.inputPrimitive == PB.GS.inputPrimitive &&
+           PA.GS.maxVertexCount == PB.GS.maxVertexCount &&
+           PA.GS.instanceCount == PB.GS.instanceCount &&
+           std::equal(PA.GS.streamPrimitiveTopologies,
+                      PA.GS.streamPrimitiveTopologies + DXIL::kNumOutputStreams,
+                      PB.GS.streamPrimitiveTopologies);
+  case DXIL::ShaderKind::Hull:
+    return PA.HS.patchConstantFunc->getName() ==
+               PB.HS.patchConstantFunc->getName() &&
+           PA.HS.domain == PB.HS.domain && PA.HS.partition == PB.HS.partition &&
+           PA.HS.outputPrimitive == PB.HS.outputPrimitive &&
+           PA.HS.inputControlPoints == PB.HS.inputControlPoints &&
+           PA.HS.outputControlPoints == PB.HS.outputControlPoints &&
+           PA.HS.maxTessFactor == PB.HS.maxTessFactor;
+  case DXIL::ShaderKind::Domain:
+    return PA.DS.domain == PB.DS.domain &&
+           PA.DS.inputControlPoints == PB.DS.inputControlPoints;
+  case DXIL::ShaderKind::Vertex:
+    for (unsigned i = 0; i < DXIL::kNumClipPlanes; ++i) {
+      Constant *CA = PA.VS.clipPlanes[i], *CB = PB.VS.clipPlanes[i];
+      if (!CA || !CB) {
+        if (CA != CB)
+          return false;
+        continue;
+      }
+      FunctionBodyComparator comparator;
+      if (!comparator.IsSameConstant(CA, CB))
+        return false;
+    }
+    return true;
+  case DXIL::ShaderKind::Pixel:
+    return PA.PS.EarlyDepthStencil == PB.PS.EarlyDepthStencil;
+  default:
+    return true;
+  }
+}
+
+bool IsSameSignature(const DxilSignature &A, const DxilSignature &B) {
+  const auto &EA = A.GetElements(), &EB = B.GetElements();
+  if (EA.size() != EB.size())
+    return false;
+  for (size_t i = 0; i < EA.size(); ++i) {
+    const DxilSignatureElement &SA = *EA[i], &SB = *EB[i];
+    if (strcmp(SA.GetName(), SB.GetName()) != 0 ||
+        SA.GetKind() != SB.GetKind() ||
+        SA.GetSemanticIndexVec() != SB.GetSemanticIndexVec() ||
+        !(SA.GetCompType() == SB.GetCompType()) ||
+        !(*SA.GetInterpolationMode() == *SB.GetInterpolationMode()) ||
+        SA.GetRows() != SB.GetRows() || SA.GetCols() != SB.GetCols() ||
+        SA.GetStartRow() != SB.GetStartRow() ||
+        SA.GetStartCol() != SB.GetStartCol() ||
+        SA.GetOutputStream() != SB.GetOutputStream() ||
+        SA.GetDynIdxCompMask() != SB.GetDynIdxCompMask())
+      return false;
+  }
+  return true;
+}
+
+template <class T>
+bool IsSameResources(const std::vector<std::unique_ptr<T>> &A,
+                     const std::vector<std::unique_ptr<T>> &B) {
+  if (A.size() != B.size())
+    return false;
+  for (size_t i = 0; i < A.size(); ++i) {
+    const DxilResourceBase &RA = *A[i], &RB = *B[i];
+    if (RA.GetGlobalName() != RB.GetGlobalName() ||
+        RA.GetClass() != RB.GetClass() || RA.GetKind() != RB.GetKind() ||
+        RA.GetSpaceID() != RB.GetSpaceID() ||
+        RA.GetLowerBound() != RB.GetLowerBound() ||
+        RA.GetRangeSize() != RB.GetRangeSize())
+      return false;
+  }
+  return true;
+}
+
 } // namespace
 
 namespace {
@@ -86,8 +387,14 @@ namespace {
 struct DxilFunctionLinkInfo {
   DxilFunctionLinkInfo(llvm::Function *F);
   llvm::Function *func;
-  std::unordered_set<llvm::Function *> usedFunctions;
-  std::unordered_set<llvm::GlobalVariable *> usedGVs;
+  // Function whose body is cloned for func: func itself, or a prepared copy
+  // with its callees inlined.
+  llvm::Function *body;
+  // Whether the body is materialized and the sets below are collected.
+  bool loaded;
+  // In the order first used, so that links do not depend on addresses.
+  llvm::SetVector<llvm::Function *> usedFunctions;
+  llvm::SetVector<llvm::GlobalVariable *> usedGVs;
   std::unordered_set<DxilResourceBase *> usedResources;
 };
 
@@ -101,11 +408,25 @@ public:
   llvm::StringMap<std::unique_ptr<DxilFunctionLinkInfo>> &GetFunctionTable() {
     return m_functionNameMap;
   }
+  // Materializes the body of the function and collects what it uses.
+  // Returns false if the body cannot be read.
+  bool LoadFunctionLinkInfo(DxilFunctionLinkInfo *linkInfo);
+  // Returns the link info of a prepared copy of the function, or linkInfo
+  // if the function cannot be prepared. The info must be loaded.
+  DxilFunctionLinkInfo *GetPreparedLinkInfo(DxilFunctionLinkInfo *linkInfo);
   bool IsInitFunc(llvm::Function *F);
+  // Whether the definition may be shared with an identical one of another
+  // library, which holds for functions other than entries and initializers.
+  bool IsMergeable(DxilFunctionLinkInfo *linkInfo);
   bool IsResourceGlobal(const llvm::Constant *GV);
   DxilResourceBase *GetResource(const llvm::Constant *GV);
 
   DxilModule &GetDxilModule() { return m_DM; }
+  // Adds to changedFunctions the names of the functions newLib defines
+  // differently, or that only one of the libraries defines. Returns false if
+  // the libraries also differ outside the functions, in their globals,
+  // initializers or resources.
+  bool CollectChangedFunctions(DxilLib &newLib, StringSet<> &changedFunctions);
 
 private:
   std::unique_ptr<llvm::Module> m_pModule;
@@ -114,9 +435,15 @@ private:
   llvm::StringMap<std::unique_ptr<DxilFunctionLinkInfo>> m_functionNameMap;
   // Map from resource link global to resource.
   std::unordered_map<const llvm::Constant *, DxilResourceBase *> m_resourceMap;
-  // Set of initialize functions for global variable.
-  std::unordered_set<llvm::Function *> m_initFuncSet;
-};
+  // Set of initialize functions for global variable, in constructor order.
+  llvm::SetVector<llvm::Function *> m_initFuncSet;
+  // Prepared copies, or null for functions that cannot be prepared.
+  std::unordered_map<DxilFunctionLinkInfo *,
+                     std::unique_ptr<DxilFunctionLinkInfo>>
+      m_preparedMap;
+
+  bool CanPrepare(DxilFunctionLinkInfo *linkInfo,
+                  std::unordered_set<DxilFunctionLinkInfo *> &visited);
 
 class DxilLinkerImpl : public hlsl::DxilLinker {
 public:
@@ -130,13 +457,23 @@ public:
   bool AttachLib(StringRef name) override;
   bool DetachLib(StringRef name) override;
   void DetachAll() override;
+  bool ReplaceLib(StringRef name, std::unique_ptr<llvm::Module> pModule,
+                  std::unique_ptr<llvm::Module> pDebugModule,
+                  StringSet<> &changedFunctions, bool &bAllChanged) override;
 
-  std::unique_ptr<llvm::Module> Link(StringRef entry,
-                                     StringRef profile) override;
+  std::unique_ptr<llvm::Module>
+  Link(StringRef entry, StringRef profile,
+       const StringMap<std::string> &linkConstants, unsigned optLevel,
+       StringSet<> *pLinkedFunctions) override;
 
 private:
   bool AttachLib(DxilLib *lib);
   bool DetachLib(DxilLib *lib);
+  bool IsSameDefinition(std::pair<DxilFunctionLinkInfo *, DxilLib *> &A,
+                        std::pair<DxilFunctionLinkInfo *, DxilLib *> &B);
+  void CollectInlinedFunctions(
+      std::pair<DxilFunctionLinkInfo *, DxilLib *> &linkPair,
+      StringSet<> &inlinedFunctions);
   // Attached libs to link.
   std::unordered_set<DxilLib *> m_attachedLibs;
   // Owner of all DxilLib.
@@ -151,7 +488,8 @@ private:
 //
 // DxilFunctionLinkInfo methods.
 //
-DxilFunctionLinkInfo::DxilFunctionLinkInfo(Function *F) : func(F) {
+DxilFunctionLinkInfo::DxilFunctionLinkInfo(Function *F)
+    : func(F), body(F), loaded(false) {
   DXASSERT_NOMSG(F);
 }
 
@@ -176,21 +514,10 @@ DxilLib::DxilLib(std::unique_ptr<llvm::Module> pModule)
     m_functionNameMap[F.getName()] =
         llvm::make_unique<DxilFunctionLinkInfo>(&F);
   }
-  // Build LinkInfo for each define.
+  // The module may be loaded lazily, so only the function table is built
+  // here; the functions and globals each definition uses are collected by
+  // LoadFunctionLinkInfo when a link needs it.
   for (Function &F : M.functions()) {
-    for (User *U : F.users()) {
-      // Skip ConstantStruct user of Construct function for static globals.
-      if (isa<ConstantStruct>(U))
-        continue;
-      CallInst *CI = cast<CallInst>(U);
-      Function *UserF = CI->getParent()->getParent();
-
-      DXASSERT(m_functionNameMap.count(UserF->getName()),
-               "must exist in internal table");
-      DxilFunctionLinkInfo *linkInfo =
-          m_functionNameMap[UserF->getName()].get();
-      linkInfo->usedFunctions.insert(&F);
-    }
     if (m_DM.HasDxilFunctionProps(&F)) {
       DxilFunctionProps &props = m_DM.GetDxilFunctionProps(&F);
       if (props.IsHS()) {
@@ -209,13 +536,6 @@ DxilLib::DxilLib(std::unique_ptr<llvm::Module> pModule)
       // Add prefix to internal global.
       GV.setName(MID + GV.getName());
     }
-    std::unordered_set<Function *> funcSet;
-    CollectUsedFunctions(&GV, funcSet);
-    for (Function *F : funcSet) {
-      DXASSERT(m_functionNameMap.count(F->getName()), "must exist in table");
-      DxilFunctionLinkInfo *linkInfo = m_functionNameMap[F->getName()].get();
-      linkInfo->usedGVs.insert(&GV);
-    }
   }
 
   // Build resource map.
@@ -247,28 +567,216 @@ DxilLib::DxilLib(std::unique_ptr<llvm::Module> pModule)
         m_initFuncSet.insert(Ctor);
       }
     }
+  }
+}
+
+bool DxilLib::LoadFunctionLinkInfo(DxilFunctionLinkInfo *linkInfo) {
+  if (linkInfo->loaded)
+    return true;
 
+  Function *F = linkInfo->func;
+  if (linkInfo->body->materialize())
+    return false;
+
+  for (BasicBlock &BB : *linkInfo->body) {
+    for (Instruction &I : BB) {
+      if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+        if (Function *Callee = CI->getCalledFunction())
+          linkInfo->usedFunctions.insert(Callee);
+      }
+      for (Value *Op : I.operands()) {
+        if (Constant *C = dyn_cast<Constant>(Op))
+          CollectUsedGlobals(C, linkInfo->usedGVs);
+      }
+    }
+  }
+
+  // If a function other than a Ctor uses globals of the Ctor, add the Ctor
+  // to its usedFunctions.
+  if (!IsInitFunc(F)) {
     for (Function *Ctor : m_initFuncSet) {
       DXASSERT(m_functionNameMap.count(Ctor->getName()),
                "must exist in internal table");
-      DxilFunctionLinkInfo *linkInfo = m_functionNameMap[Ctor->getName()].get();
-      // If function other than Ctor used GV of Ctor.
-      // Add Ctor to usedFunctions for it.
+      DxilFunctionLinkInfo *ctorInfo = m_functionNameMap[Ctor->getName()].get();
+      if (!LoadFunctionLinkInfo(ctorInfo))
+        return false;
       for (GlobalVariable *GV : linkInfo->usedGVs) {
-        std::unordered_set<Function *> funcSet;
-        CollectUsedFunctions(GV, funcSet);
-        for (Function *F : funcSet) {
-          if (F == Ctor)
-            continue;
-          DXASSERT(m_functionNameMap.count(F->getName()),
-                   "must exist in table");
-          DxilFunctionLinkInfo *linkInfo =
-              m_functionNameMap[F->getName()].get();
+        if (ctorInfo->usedGVs.count(GV)) {
           linkInfo->usedFunctions.insert(Ctor);
+          break;
+        }
+      }
+    }
+  }
+
+  linkInfo->loaded = true;
+  return true;
+}
+
+// A function can be prepared when every function it calls, directly or not,
+// is defined in this library, since no other library can then provide them.
+bool DxilLib::CanPrepare(DxilFunctionLinkInfo *linkInfo,
+                         std::unordered_set<DxilFunctionLinkInfo *> &visited) {
+  if (!visited.insert(linkInfo).second)
+    return false; // Recursion.
+  if (!LoadFunctionLinkInfo(linkInfo))
+    return false;
+  for (BasicBlock &BB : *linkInfo->func) {
+    for (Instruction &I : BB) {
+      CallInst *CI = dyn_cast<CallInst>(&I);
+      if (!CI)
+        continue;
+      Function *Callee = CI->getCalledFunction();
+      if (!Callee)
+        return false;
+      if (hlsl::OP::IsDxilOpFunc(Callee))
+        continue;
+      auto it = m_functionNameMap.find(Callee->getName());
+      if (it == m_functionNameMap.end() || m_DM.HasDxilFunctionProps(Callee) ||
+          IsInitFunc(Callee))
+        return false;
+      if (!CanPrepare(it->second.get(), visited))
+        return false;
+    }
+  }
+  visited.erase(linkInfo);
+  return true;
+}
+
+DxilFunctionLinkInfo *
+DxilLib::GetPreparedLinkInfo(DxilFunctionLinkInfo *linkInfo) {
+  auto it = m_preparedMap.find(linkInfo);
+  if (it != m_preparedMap.end())
+    return it->second ? it->second.get() : linkInfo;
+  std::unique_ptr<DxilFunctionLinkInfo> &prepared = m_preparedMap[linkInfo];
+
+  // Entries are linked once each, so only helpers are worth preparing, and
+  // only those that call other functions.
+  Function *F = linkInfo->func;
+  if (m_DM.HasDxilFunctionProps(F) || IsInitFunc(F))
+    return linkInfo;
+  bool bHasCalls = false;
+  for (Function *UsedF : linkInfo->usedFunctions)
+    bHasCalls |= !hlsl::OP::IsDxilOpFunc(UsedF) && !IsInitFunc(UsedF);
+  std::unordered_set<DxilFunctionLinkInfo *> visited;
+  if (!bHasCalls || !CanPrepare(linkInfo, visited))
+    return linkInfo;
+
+  // Inline the callees into a copy of the function and simplify it, which
+  // every link pulling in the function would otherwise repeat.
+  ValueToValueMapTy vmap;
+  Function *Body = llvm::CloneFunction(F, vmap, /*ModuleLevelChanges*/ false);
+  Body->setLinkage(GlobalValue::LinkageTypes::InternalLinkage);
+  m_pModule->getFunctionList().push_back(Body);
+  Body->setName("dx.link.prepared." + F->getName());
+
+  bool bInlined = true;
+  while (bInlined) {
+    bInlined = false;
+    SmallVector<CallInst *, 8> calls;
+    for (BasicBlock &BB : *Body) {
+      for (Instruction &I : BB) {
+        if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+          Function *Callee = CI->getCalledFunction();
+          if (!hlsl::OP::IsDxilOpFunc(Callee))
+            calls.push_back(CI);
         }
       }
     }
+    for (CallInst *CI : calls) {
+      InlineFunctionInfo IFI;
+      if (!InlineFunction(CI, IFI, /*InsertLifetime*/ false)) {
+        Body->eraseFromParent();
+        return linkInfo;
+      }
+      bInlined = true;
+    }
   }
+
+  legacy::FunctionPassManager FPM(m_pModule.get());
+  FPM.add(createSimplifyInstPass());
+  FPM.add(createDeadCodeEliminationPass());
+  FPM.doInitialization();
+  FPM.run(*Body);
+  FPM.doFinalization();
+
+  prepared = llvm::make_unique<DxilFunctionLinkInfo>(F);
+  prepared->body = Body;
+  LoadFunctionLinkInfo(prepared.get());
+  return prepared.get();
+}
+
+bool DxilLib::CollectChangedFunctions(DxilLib &newLib,
+                                      StringSet<> &changedFunctions) {
+  DxilModule &newDM = newLib.m_DM;
+  for (auto &it : m_functionNameMap) {
+    StringRef name = it.getKey();
+    auto newIt = newLib.m_functionNameMap.find(name);
+    if (newIt == newLib.m_functionNameMap.end()) {
+      changedFunctions.insert(name);
+      continue;
+    }
+    Function *F = it.second->func;
+    Function *NewF = newIt->second->func;
+    FunctionBodyComparator comparator;
+    bool bSame = !F->materialize() && !NewF->materialize() &&
+                 comparator.IsSame(F, NewF) &&
+                 m_DM.HasDxilFunctionProps(F) ==
+                     newDM.HasDxilFunctionProps(NewF);
+    // An entry also needs its properties and signatures unchanged.
+    if (bSame && m_DM.HasDxilFunctionProps(F)) {
+      bSame = IsSameShaderProps(m_DM.GetDxilFunctionProps(F),
+                                newDM.GetDxilFunctionProps(NewF)) &&
+              m_DM.HasDxilEntrySignature(F) ==
+                  newDM.HasDxilEntrySignature(NewF);
+      if (bSame && m_DM.HasDxilEntrySignature(F)) {
+        DxilEntrySignature &Sig = m_DM.GetDxilEntrySignature(F);
+        DxilEntrySignature &NewSig = newDM.GetDxilEntrySignature(NewF);
+        bSame = IsSameSignature(Sig.InputSignature, NewSig.InputSignature) &&
+                IsSameSignature(Sig.OutputSignature,
+                                NewSig.OutputSignature) &&
+                IsSameSignature(Sig.PatchConstantSignature,
+                                NewSig.PatchConstantSignature);
+      }
+    }
+    if (!bSame)
+      changedFunctions.insert(name);
+  }
+  for (auto &it : newLib.m_functionNameMap) {
+    if (!m_functionNameMap.count(it.getKey()))
+      changedFunctions.insert(it.getKey());
+  }
+
+  // Initializers run in every entry using their globals, so a change to
+  // them, to the globals or to the resources may affect any link.
+  if (m_initFuncSet.size() != newLib.m_initFuncSet.size())
+    return false;
+  for (unsigned i = 0; i < m_initFuncSet.size(); ++i) {
+    if (m_initFuncSet[i]->getName() != newLib.m_initFuncSet[i]->getName())
+      return false;
+  }
+  Module &newM = *newLib.m_pModule;
+  unsigned globalCount = 0, newGlobalCount = 0;
+  for (GlobalVariable &GV : m_pModule->globals()) {
+    // The constructor list was compared above.
+    if (GV.getName().startswith("llvm."))
+      continue;
+    ++globalCount;
+    GlobalVariable *NewGV =
+        newM.getGlobalVariable(GV.getName(), /*AllowInternal*/ true);
+    FunctionBodyComparator comparator;
+    if (!NewGV || !comparator.IsSameGlobal(&GV, NewGV))
+      return false;
+  }
+  for (GlobalVariable &GV : newM.globals()) {
+    if (!GV.getName().startswith("llvm."))
+      ++newGlobalCount;
+  }
+  return globalCount == newGlobalCount &&
+         IsSameResources(m_DM.GetUAVs(), newDM.GetUAVs()) &&
+         IsSameResources(m_DM.GetSRVs(), newDM.GetSRVs()) &&
+         IsSameResources(m_DM.GetCBuffers(), newDM.GetCBuffers()) &&
+         IsSameResources(m_DM.GetSamplers(), newDM.GetSamplers());
 }
 
 bool DxilLib::HasFunction(std::string &name) {
@@ -276,6 +784,10 @@ bool DxilLib::HasFunction(std::string &name) {
 }
 
 bool DxilLib::IsInitFunc(llvm::Function *F) { return m_initFuncSet.count(F); }
+bool DxilLib::IsMergeable(DxilFunctionLinkInfo *linkInfo) {
+  return !m_DM.HasDxilFunctionProps(linkInfo->func) &&
+         !IsInitFunc(linkInfo->func);
+}
 bool DxilLib::IsResourceGlobal(const llvm::Constant *GV) {
   return m_resourceMap.count(GV);
 }
@@ -293,15 +805,21 @@ struct DxilLinkJob {
   DxilLinkJob(LLVMContext &Ctx) : m_ctx(Ctx) {}
   std::unique_ptr<llvm::Module>
   Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
-       StringRef profile);
-  void RunPreparePass(llvm::Module &M);
+       StringRef profile, const StringMap<std::string> &linkConstants,
+       unsigned optLevel);
+  void RunPreparePass(llvm::Module &M, bool bHasLinkConstants,
+                      unsigned optLevel);
   void AddFunction(std::pair<DxilFunctionLinkInfo *, DxilLib *> &linkPair);
   void AddFunction(llvm::Function *F);
 
 private:
   bool AddResource(DxilResourceBase *res, llvm::GlobalVariable *GV);
   void AddResourceToDM(DxilModule &DM);
-  std::unordered_map<DxilFunctionLinkInfo *, DxilLib *> m_functionDefs;
+  bool ReplaceLinkConstants(const StringMap<std::string> &linkConstants,
+                            bool &bHasLinkConstants);
+  // In the order added, which fixes the order of the linked functions,
+  // globals and constructor calls.
+  llvm::MapVector<DxilFunctionLinkInfo *, DxilLib *> m_functionDefs;
   llvm::StringMap<llvm::Function *> m_dxilFunctions;
   // New created functions.
   llvm::StringMap<llvm::Function *> m_newFunctions;
@@ -323,6 +841,8 @@ const char kShaderKindMismatch[] =
     "Profile mismatch between entry function and target profile:";
 const char kNoEntryProps[] =
     "Cannot find function property for entry function ";
+const char kLoadFunctionFailed[] = "Cannot load body of function ";
+const char kInvalidLinkConstant[] = "Invalid value for link-time constant ";
 const char kRefineResource[] =
     "Resource already exists as ";
 } // namespace
@@ -395,9 +915,75 @@ void DxilLinkJob::AddResourceToDM(DxilModule &DM) {
   }
 }
 
+// Parses the text of a link-time constant value for type Ty.
+static Constant *ParseLinkConstant(StringRef text, Type *Ty) {
+  if (Ty->isIntegerTy()) {
+    if (text == "true")
+      return ConstantInt::get(Ty, 1);
+    if (text == "false")
+      return ConstantInt::get(Ty, 0);
+    long long value;
+    if (!text.getAsInteger(0, value))
+      return ConstantInt::get(Ty, value, /*isSigned*/ true);
+    unsigned long long uvalue;
+    if (!text.getAsInteger(0, uvalue))
+      return ConstantInt::get(Ty, uvalue);
+    return nullptr;
+  }
+  if (Ty->isFloatingPointTy()) {
+    if (text.endswith("f") || text.endswith("F"))
+      text = text.drop_back();
+    std::string str = text.str();
+    char *end = nullptr;
+    double value = std::strtod(str.c_str(), &end);
+    if (str.empty() || *end != '\0')
+      return nullptr;
+    return ConstantFP::get(Ty, value);
+  }
+  return nullptr;
+}
+
+// Replaces the calls standing for link-time constants with the values in
+// linkConstants, or with the defaults they pass.
+bool DxilLinkJob::ReplaceLinkConstants(
+    const StringMap<std::string> &linkConstants, bool &bHasLinkConstants) {
+  bHasLinkConstants = false;
+  std::vector<Function *> constantFuncs;
+  for (auto &it : m_newFunctions) {
+    if (it.getKey().startswith(DxilLinker::kLinkConstantPrefix))
+      constantFuncs.emplace_back(it.second);
+  }
+
+  for (Function *F : constantFuncs) {
+    bHasLinkConstants = true;
+    StringRef name =
+        F->getName().substr(strlen(DxilLinker::kLinkConstantPrefix));
+    Constant *value = nullptr;
+    auto valueIt = linkConstants.find(name);
+    if (valueIt != linkConstants.end()) {
+      value = ParseLinkConstant(valueIt->second, F->getReturnType());
+      if (!value) {
+        m_ctx.emitError(Twine(kInvalidLinkConstant) + name + ": " +
+                        valueIt->second);
+        return false;
+      }
+    }
+    for (auto U = F->user_begin(); U != F->user_end();) {
+      CallInst *CI = cast<CallInst>(*(U++));
+      CI->replaceAllUsesWith(value ? value : CI->getArgOperand(0));
+      CI->eraseFromParent();
+    }
+    m_newFunctions.erase(F->getName());
+    F->eraseFromParent();
+  }
+  return true;
+}
+
 std::unique_ptr<Module>
 DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
-                  StringRef profile) {
+                  StringRef profile,
+                  const StringMap<std::string> &linkConstants,
+                  unsigned optLevel) {
 
   Function *entryFunc = entryLinkPair.first->func;
   DxilModule &entryDM = entryLinkPair.second->GetDxilModule();
@@ -569,7 +1155,7 @@ DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
       }
     }
 
-    CloneFunction(F, NewF, vmap);
+    CloneFunction(linkInfo->body, NewF, vmap);
   }
 
   // Call global constrctor.
@@ -586,6 +1172,10 @@ DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
     }
   }
 
+  bool bHasLinkConstants;
+  if (!ReplaceLinkConstants(linkConstants, bHasLinkConstants))
+    return nullptr;
+
   // Refresh intrinsic cache.
   DM.GetOP()->RefreshCache();
 
@@ -593,7 +1183,7 @@ DxilLinkJob::Link(std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair,
   // This should be after functions cloned.
   AddResourceToDM(DM);
 
-  RunPreparePass(*pM);
+  RunPreparePass(*pM, bHasLinkConstants, optLevel);
 
   return pM;
 }
@@ -607,10 +1197,29 @@ void DxilLinkJob::AddFunction(llvm::Function *F) {
   m_dxilFunctions[F->getName()] = F;
 }
 
-void DxilLinkJob::RunPreparePass(Module &M) {
+void DxilLinkJob::RunPreparePass(Module &M, bool bHasLinkConstants,
+                                 unsigned optLevel) {
   legacy::PassManager PM;
 
+  if (optLevel > 0) {
+    // Run the pipeline the compiler runs after DXIL generation, so code that
+    // was split across functions and libraries is optimized as a whole. It
+    // inlines, folds link-time constants and ends with the same resource and
+    // metadata passes as below.
+    PassManagerBuilder PMB;
+    PMB.OptLevel = optLevel;
+    PMB.HLSLLinked = true;
+    PMB.populateModulePassManager(PM);
+    PM.run(M);
+    return;
+  }
+
   PM.add(createAlwaysInlinerPass(/*InsertLifeTime*/ false));
+  if (bHasLinkConstants) {
+    // Fold the branches the substituted constants decide.
+    PM.add(createSCCPPass());
+    PM.add(createCFGSimplificationPass());
+  }
   // Remove unused functions.
   PM.add(createDeadCodeEliminationPass());
   PM.add(createGlobalDCEPass());
@@ -673,6 +1282,29 @@ void DxilLinkerImpl::DetachAll() {
   m_attachedLibs.clear();
 }
 
+bool DxilLinkerImpl::ReplaceLib(StringRef name,
+                                std::unique_ptr<llvm::Module> pModule,
+                                std::unique_ptr<llvm::Module> pDebugModule,
+                                StringSet<> &changedFunctions,
+                                bool &bAllChanged) {
+  auto iter = m_LibMap.find(name);
+  if (iter == m_LibMap.end() || m_attachedLibs.count(iter->second.get()))
+    return false;
+
+  std::unique_ptr<llvm::Module> pM =
+      pDebugModule ? std::move(pDebugModule) : std::move(pModule);
+  if (!pM)
+    return false;
+
+  // Give the new module the same name, so that its internal functions and
+  // globals get the same prefixed names as before.
+  pM->setModuleIdentifier(name);
+  std::unique_ptr<DxilLib> pLib = std::make_unique<DxilLib>(std::move(pM));
+  bAllChanged = !iter->second->CollectChangedFunctions(*pLib, changedFunctions);
+  iter->second = std::move(pLib);
+  return true;
+}
+
 bool DxilLinkerImpl::AttachLib(DxilLib *lib) {
   if (!lib) {
     // Invalid arg.
@@ -688,6 +1320,12 @@ bool DxilLinkerImpl::AttachLib(DxilLib *lib) {
   for (auto it = funcTable.begin(), e = funcTable.end(); it != e; it++) {
     StringRef name = it->getKey();
     if (m_functionNameMap.count(name)) {
+      // Libraries built from shared source define the same helpers; keep the
+      // definition already attached when they are identical.
+      std::pair<DxilFunctionLinkInfo *, DxilLib *> linkPair(it->second.get(),
+                                                            lib);
+      if (IsSameDefinition(m_functionNameMap[name], linkPair))
+        continue;
       // Redefine of function.
       m_ctx.emitError(Twine(kRedefineFunction) + name);
       bSuccess = false;
@@ -726,18 +1364,67 @@ bool DxilLinkerImpl::DetachLib(DxilLib *lib) {
 
   m_attachedLibs.erase(lib);
 
-  // Remove functions from lib.
+  // Remove functions from lib. A definition it shared with other attached
+  // libraries is taken from one of them instead.
   StringMap<std::unique_ptr<DxilFunctionLinkInfo>> &funcTable =
       lib->GetFunctionTable();
   for (auto it = funcTable.begin(), e = funcTable.end(); it != e; it++) {
     StringRef name = it->getKey();
-    m_functionNameMap.erase(name);
+    auto iter = m_functionNameMap.find(name);
+    if (iter == m_functionNameMap.end() || iter->second.second != lib)
+      continue;
+    m_functionNameMap.erase(iter);
+    for (DxilLib *otherLib : m_attachedLibs) {
+      auto &otherTable = otherLib->GetFunctionTable();
+      auto otherIt = otherTable.find(name);
+      if (otherIt != otherTable.end()) {
+        m_functionNameMap[name] =
+            std::make_pair(otherIt->second.get(), otherLib);
+        break;
+      }
+    }
   }
   return true;
 }
 
-std::unique_ptr<llvm::Module> DxilLinkerImpl::Link(StringRef entry,
-                                               StringRef profile) {
+// Bodies are only materialized here for names defined by more than one
+// library, so libraries without collisions stay lazily loaded.
+bool DxilLinkerImpl::IsSameDefinition(
+    std::pair<DxilFunctionLinkInfo *, DxilLib *> &A,
+    std::pair<DxilFunctionLinkInfo *, DxilLib *> &B) {
+  if (!A.second->IsMergeable(A.first) || !B.second->IsMergeable(B.first))
+    return false;
+  if (A.first->func->materialize() || B.first->func->materialize())
+    return false;
+  FunctionBodyComparator comparator;
+  return comparator.IsSame(A.first->func, B.first->func);
+}
+
+// Adds the names of the functions a prepared copy of linkPair has inlined,
+// which its link info no longer lists. Preparing loaded their link info.
+void DxilLinkerImpl::CollectInlinedFunctions(
+    std::pair<DxilFunctionLinkInfo *, DxilLib *> &linkPair,
+    StringSet<> &inlinedFunctions) {
+  DxilLib *pLib = linkPair.second;
+  for (Function *F : linkPair.first->usedFunctions) {
+    if (hlsl::OP::IsDxilOpFunc(F) ||
+        F->getName().startswith(kLinkConstantPrefix))
+      continue;
+    if (!inlinedFunctions.insert(F->getName()).second)
+      continue;
+    auto it = pLib->GetFunctionTable().find(F->getName());
+    if (it != pLib->GetFunctionTable().end()) {
+      std::pair<DxilFunctionLinkInfo *, DxilLib *> calleePair(it->second.get(),
+                                                              pLib);
+      CollectInlinedFunctions(calleePair, inlinedFunctions);
+    }
+  }
+}
+
+std::unique_ptr<llvm::Module>
+DxilLinkerImpl::Link(StringRef entry, StringRef profile,
+                     const StringMap<std::string> &linkConstants,
+                     unsigned optLevel, StringSet<> *pLinkedFunctions) {
   StringSet<> addedFunctionSet;
   SmallVector<StringRef, 4> workList;
   workList.emplace_back(entry);
@@ -757,11 +1444,23 @@ std::unique_ptr<llvm::Module> DxilLinkerImpl::Link(StringRef entry,
 
     std::pair<DxilFunctionLinkInfo *, DxilLib *> &linkPair =
         m_functionNameMap[name];
-    linkJob.AddFunction(linkPair);
-
-    for (Function *F : linkPair.first->usedFunctions) {
-      if (hlsl::OP::IsDxilOpFunc(F)) {
-        // Add dxil operations directly.
+    // Bodies are materialized only for the functions this entry reaches.
+    if (!linkPair.second->LoadFunctionLinkInfo(linkPair.first)) {
+      m_ctx.emitError(Twine(kLoadFunctionFailed) + name);
+      return nullptr;
+    }
+    // Helpers are linked from a copy with their callees already inlined,
+    // which is prepared once per library and reused by later links.
+    std::pair<DxilFunctionLinkInfo *, DxilLib *> preparedPair(
+        linkPair.second->GetPreparedLinkInfo(linkPair.first), linkPair.second);
+    linkJob.AddFunction(preparedPair);
+    if (pLinkedFunctions && preparedPair.first != linkPair.first)
+      CollectInlinedFunctions(linkPair, *pLinkedFunctions);
+
+    for (Function *F : preparedPair.first->usedFunctions) {
+      if (hlsl::OP::IsDxilOpFunc(F) ||
+          F->getName().startswith(kLinkConstantPrefix)) {
+        // Add dxil operations and link-time constants directly.
         linkJob.AddFunction(F);
       } else {
         // Push function name to work list.
@@ -772,14 +1471,21 @@ std::unique_ptr<llvm::Module> DxilLinkerImpl::Link(StringRef entry,
     addedFunctionSet.insert(name);
   }
 
+  if (pLinkedFunctions) {
+    for (auto &it : addedFunctionSet)
+      pLinkedFunctions->insert(it.getKey());
+  }
+
   std::pair<DxilFunctionLinkInfo *, DxilLib *> &entryLinkPair =
       m_functionNameMap[entry];
 
-  return linkJob.Link(entryLinkPair, profile);
+  return linkJob.Link(entryLinkPair, profile, linkConstants, optLevel);
 }
 
 namespace hlsl {
 
+const char DxilLinker::kLinkConstantPrefix[] = "dx.linkconst.";
+
 DxilLinker *DxilLinker::CreateLinker(LLVMContext &Ctx) {
   return new DxilLinkerImpl(Ctx);
 }
@@ -0,0 +1,392 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilLoadToGather.cpp                                                      //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Forms one gather from four texture loads of a 2x2 texel block.            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilRootSignature.h"
+#include "dxc/HLSL/DxilSampler.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <map>
+#include <tuple>
+
+using namespace llvm;
+using namespace hlsl;
+
+#define DEBUG_TYPE "hlsl-dxil-load-to-gather"
+
+namespace {
+// A texture load of one component, split into the coordinate bases and the
+// constant displacement from them.
+struct TexelLoad {
+  CallInst *Load;
+  ExtractValueInst *Value;
+  int64_t X, Y;
+  unsigned Order; // Position in the block.
+};
+
+// Four Texture2D loads of texels (x,y), (x+1,y), (x,y+1) and (x+1,y+1) of
+// mip 0 that only use the first component are one gather of channel 0 at
+// the center of the block: components w, z, x and y of the gather hold the
+// four texels in that order.
+//
+// The loads' semantics only survive when the sampler is known at compile
+// time. Out of range loads return zero, so the sampler must use border
+// addressing with a transparent black border; the gather must neither
+// compare nor reduce, and LOD 0 must be reachable. Only a static sampler of
+// the root signature that the shader also declares gives that guarantee.
+// Without one, loads that would otherwise be merged are reported in a
+// missed-optimization remark.
+class DxilLoadToGather : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilLoadToGather() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL load to gather";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override;
+
+private:
+  typedef std::tuple<Value *, Value *, Value *> BlockKey;
+
+  static bool GetTexelLoad(CallInst *CI, DxilModule &DM, TexelLoad &TL);
+  static bool SplitCoordinate(Value *Coord, Value *Offset, const DataLayout &DL,
+                              Value *&Base, int64_t &Disp);
+  static const DxilSampler *FindBorderSampler(DxilModule &DM,
+                                              unsigned &Index);
+  static void RewriteBlock(TexelLoad *Quad[4], Value *Handle, Value *BaseX,
+                           Value *BaseY, Value *SamplerHandle,
+                           hlsl::OP *hlslOP);
+};
+
+char DxilLoadToGather::ID = 0;
+
+bool DxilLoadToGather::SplitCoordinate(Value *Coord, Value *Offset,
+                                       const DataLayout &DL, Value *&Base,
+                                       int64_t &Disp) {
+  Disp = 0;
+  if (!isa<UndefValue>(Offset)) {
+    ConstantInt *C = dyn_cast<ConstantInt>(Offset);
+    if (!C)
+      return false;
+    Disp = C->getSExtValue();
+  }
+  // Strip additions of constants; instcombine turns some into disjoint ors.
+  while (BinaryOperator *BO = dyn_cast<BinaryOperator>(Coord)) {
+    ConstantInt *C = dyn_cast<ConstantInt>(BO->getOperand(1));
+    if (!C)
+      break;
+    if (BO->getOpcode() == Instruction::Or) {
+      unsigned Width = C->getBitWidth();
+      APInt KnownZero(Width, 0), KnownOne(Width, 0);
+      computeKnownBits(BO->getOperand(0), KnownZero, KnownOne, DL);
+      if ((C->getValue() & ~KnownZero) != 0)
+        break;
+    } else if (BO->getOpcode() != Instruction::Add) {
+      break;
+    }
+    Disp += C->getSExtValue();
+    Coord = BO->getOperand(0);
+  }
+  if (ConstantInt *C = dyn_cast<ConstantInt>(Coord)) {
+    Disp += C->getSExtValue();
+    Coord = nullptr;
+  }
+  Base = Coord;
+  return true;
+}
+
+bool DxilLoadToGather::GetTexelLoad(CallInst *CI, DxilModule &DM,
+                                    TexelLoad &TL) {
+  DxilInst_TextureLoad Load(CI);
+  ConstantInt *Mip = dyn_cast<ConstantInt>(Load.get_mipLevelOrSampleCount());
+  if (!Mip || !Mip->isZero())
+    return false;
+  Type *ETy = CI->getType()->getStructElementType(0);
+  if (!ETy->isFloatTy() && !ETy->isIntegerTy(32))
+    return false;
+
+  CallInst *Handle = dyn_cast<CallInst>(Load.get_srv());
+  if (!Handle || !DxilInst_CreateHandle(Handle))
+    return false;
+  DxilInst_CreateHandle CH(Handle);
+  ConstantInt *Class = dyn_cast<ConstantInt>(CH.get_resourceClass());
+  ConstantInt *RangeId = dyn_cast<ConstantInt>(CH.get_rangeId());
+  if (!Class || !RangeId ||
+      Class->getLimitedValue() != (unsigned)DXIL::ResourceClass::SRV)
+    return false;
+  if (RangeId->getLimitedValue() >= DM.GetSRVs().size() ||
+      DM.GetSRV(RangeId->getLimitedValue()).GetKind() !=
+          DXIL::ResourceKind::Texture2D)
+    return false;
+
+  // Only the first component may be used; the status is lost in a gather.
+  TL.Load = CI;
+  TL.Value = nullptr;
+  for (User *U : CI->users()) {
+    ExtractValueInst *EVI = dyn_cast<ExtractValueInst>(U);
+    if (!EVI || EVI->getIndices()[0] != 0 || TL.Value)
+      return false;
+    TL.Value = EVI;
+  }
+  return TL.Value != nullptr;
+}
+
+const DxilSampler *DxilLoadToGather::FindBorderSampler(DxilModule &DM,
+                                                       unsigned &Index) {
+  const RootSignatureHandle &RS = DM.GetRootSignature();
+  if (RS.IsEmpty())
+    return nullptr;
+  const DxilVersionedRootSignatureDesc *pDesc = RS.GetDesc();
+  RootSignatureHandle Deserialized;
+  if (!pDesc) {
+    try {
+      Deserialized.Assign(nullptr, RS.GetSerialized());
+      Deserialized.Deserialize();
+    } catch (...) {
+      return nullptr;
+    }
+    pDesc = Deserialized.GetDesc();
+    if (!pDesc)
+      return nullptr;
+  }
+
+  unsigned NumStaticSamplers;
+  const DxilStaticSamplerDesc *pStaticSamplers;
+  if (pDesc->Version == DxilRootSignatureVersion::Version_1_0) {
+    NumStaticSamplers = pDesc->Desc_1_0.NumStaticSamplers;
+    pStaticSamplers = pDesc->Desc_1_0.pStaticSamplers;
+  } else {
+    NumStaticSamplers = pDesc->Desc_1_1.NumStaticSamplers;
+    pStaticSamplers = pDesc->Desc_1_1.pStaticSamplers;
+  }
+
+  DxilShaderVisibility Stage;
+  switch (DM.GetShaderModel()->GetKind()) {
+  case DXIL::ShaderKind::Vertex:   Stage = DxilShaderVisibility::Vertex; break;
+  case DXIL::ShaderKind::Hull:     Stage = DxilShaderVisibility::Hull; break;
+  case DXIL::ShaderKind::Domain:   Stage = DxilShaderVisibility::Domain; break;
+  case DXIL::ShaderKind::Geometry: Stage = DxilShaderVisibility::Geometry; break;
+  case DXIL::ShaderKind::Pixel:    Stage = DxilShaderVisibility::Pixel; break;
+  default:                         Stage = DxilShaderVisibility::All; break;
+  }
+
+  for (unsigned i = 0; i < NumStaticSamplers; ++i) {
+    const DxilStaticSamplerDesc &SS = pStaticSamplers[i];
+    // Comparison, minimum and maximum filters don't return the texels.
+    if ((unsigned)SS.Filter & 0x180)
+      continue;
+    if (SS.AddressU != DxilTextureAddressMode::Border ||
+        SS.AddressV != DxilTextureAddressMode::Border ||
+        SS.BorderColor != DxilStaticBorderColor::TransparentBlack ||
+        SS.MinLOD > 0.0f)
+      continue;
+    if (SS.ShaderVisibility != DxilShaderVisibility::All &&
+        SS.ShaderVisibility != Stage)
+      continue;
+    for (const std::unique_ptr<DxilSampler> &S : DM.GetSamplers()) {
+      if (S->GetSamplerKind() != DXIL::SamplerKind::Default ||
+          !S->IsAllocated() || S->GetSpaceID() != SS.RegisterSpace)
+        continue;
+      uint64_t Lower = S->GetLowerBound();
+      if (SS.ShaderRegister < Lower ||
+          SS.ShaderRegister >= Lower + (uint64_t)S->GetRangeSize())
+        continue;
+      // Handle indices are relative to the range until resources are
+      // allocated.
+      Index = SS.ShaderRegister - S->GetLowerBound();
+      return S.get();
+    }
+  }
+  return nullptr;
+}
+
+void DxilLoadToGather::RewriteBlock(TexelLoad *Quad[4], Value *Handle,
+                                    Value *BaseX, Value *BaseY,
+                                    Value *SamplerHandle, hlsl::OP *hlslOP) {
+  TexelLoad *First = Quad[0];
+  for (unsigned i = 1; i < 4; ++i) {
+    if (Quad[i]->Order < First->Order)
+      First = Quad[i];
+  }
+  LLVMContext &Ctx = First->Load->getContext();
+  Type *I32Ty = Type::getInt32Ty(Ctx);
+  Type *F32Ty = Type::getFloatTy(Ctx);
+  IRBuilder<> B(First->Load);
+
+  Function *GetDimensions =
+      hlslOP->GetOpFunc(OP::OpCode::GetDimensions, Type::getVoidTy(Ctx));
+  Value *DimArgs[] = {hlslOP->GetU32Const((unsigned)OP::OpCode::GetDimensions),
+                      Handle, hlslOP->GetU32Const(0)};
+  Value *Dims = B.CreateCall(GetDimensions, DimArgs);
+  Value *Width = B.CreateUIToFP(B.CreateExtractValue(Dims, 0), F32Ty);
+  Value *Height = B.CreateUIToFP(B.CreateExtractValue(Dims, 1), F32Ty);
+
+  // The center of the block is the corner shared by its four texels.
+  auto Center = [&](Value *Base, int64_t Disp, Value *Size) -> Value * {
+    Value *C = ConstantInt::get(I32Ty, Disp + 1);
+    Value *Coord = Base ? B.CreateAdd(Base, C) : C;
+    return B.CreateFDiv(B.CreateSIToFP(Coord, F32Ty), Size);
+  };
+  Value *U = Center(BaseX, Quad[0]->X, Width);
+  Value *V = Center(BaseY, Quad[0]->Y, Height);
+
+  Type *ETy = First->Load->getType()->getStructElementType(0);
+  Function *Gather = hlslOP->GetOpFunc(OP::OpCode::TextureGather, ETy);
+  Value *Undef = UndefValue::get(F32Ty);
+  Value *Zero = hlslOP->GetU32Const(0);
+  Value *GatherArgs[] = {
+      hlslOP->GetU32Const((unsigned)OP::OpCode::TextureGather),
+      Handle, SamplerHandle, U, V, Undef, Undef, Zero, Zero,
+      hlslOP->GetU32Const(0)}; // Channel
+  Value *Result = B.CreateCall(Gather, GatherArgs);
+
+  // (x,y), (x+1,y), (x,y+1), (x+1,y+1) are w, z, x, y.
+  static const unsigned Components[4] = {3, 2, 0, 1};
+  for (unsigned i = 0; i < 4; ++i) {
+    Value *Texel = B.CreateExtractValue(Result, Components[i]);
+    Quad[i]->Value->replaceAllUsesWith(Texel);
+    Quad[i]->Value->eraseFromParent();
+    Quad[i]->Load->eraseFromParent();
+  }
+}
+
+bool DxilLoadToGather::runOnFunction(Function &F) {
+  Module *M = F.getParent();
+  if (!M->HasDxilModule() || F.isDeclaration())
+    return false;
+  DxilModule &DM = M->GetDxilModule();
+  if (DM.GetShaderModel()->IsLib())
+    return false;
+  hlsl::OP *hlslOP = DM.GetOP();
+  const DataLayout &DL = M->getDataLayout();
+
+  bool bSamplerChecked = false;
+  const DxilSampler *pSampler = nullptr;
+  unsigned SamplerIndex = 0;
+  Value *SamplerHandle = nullptr;
+  bool bChanged = false;
+
+  for (BasicBlock &BB : F) {
+    // Loads of the same texture, grouped by coordinate bases. Each block of
+    // four must be in one basic block, so that the gather runs exactly when
+    // the loads do.
+    std::map<BlockKey, SmallVector<TexelLoad, 4>> Groups;
+    unsigned Order = 0;
+    for (Instruction &I : BB) {
+      ++Order;
+      if (!OP::IsDxilOpFuncCallInst(&I, OP::OpCode::TextureLoad))
+        continue;
+      CallInst *CI = cast<CallInst>(&I);
+      TexelLoad TL;
+      if (!GetTexelLoad(CI, DM, TL))
+        continue;
+      DxilInst_TextureLoad Load(CI);
+      Value *BaseX, *BaseY;
+      if (!SplitCoordinate(Load.get_coord0(), Load.get_offset0(), DL, BaseX,
+                           TL.X) ||
+          !SplitCoordinate(Load.get_coord1(), Load.get_offset1(), DL, BaseY,
+                           TL.Y))
+        continue;
+      TL.Order = Order;
+      Groups[BlockKey(Load.get_srv(), BaseX, BaseY)].push_back(TL);
+    }
+
+    for (auto &It : Groups) {
+      SmallVector<TexelLoad, 4> &Loads = It.second;
+      if (Loads.size() < 4)
+        continue;
+      std::map<std::pair<int64_t, int64_t>, TexelLoad *> ByDisp;
+      for (TexelLoad &TL : Loads)
+        ByDisp.insert(std::make_pair(std::make_pair(TL.Y, TL.X), &TL));
+
+      // Visit blocks in row order, so that each starts at its top left.
+      for (auto &D : ByDisp) {
+        if (!D.second)
+          continue;
+        int64_t X = D.first.second, Y = D.first.first;
+        auto Right = ByDisp.find(std::make_pair(Y, X + 1));
+        auto Below = ByDisp.find(std::make_pair(Y + 1, X));
+        auto BelowRight = ByDisp.find(std::make_pair(Y + 1, X + 1));
+        if (Right == ByDisp.end() || !Right->second ||
+            Below == ByDisp.end() || !Below->second ||
+            BelowRight == ByDisp.end() || !BelowRight->second)
+          continue;
+        TexelLoad *Quad[4] = {D.second, Right->second, Below->second,
+                              BelowRight->second};
+
+        if (!bSamplerChecked) {
+          pSampler = FindBorderSampler(DM, SamplerIndex);
+          bSamplerChecked = true;
+        }
+        if (!pSampler) {
+          emitOptimizationRemarkMissed(
+              F.getContext(), DEBUG_TYPE, F, Quad[0]->Load->getDebugLoc(),
+              "four loads of a 2x2 texel block were not merged into a "
+              "gather: no declared sampler is a root signature static "
+              "sampler with border addressing and a transparent black "
+              "border");
+          break;
+        }
+        if (!SamplerHandle) {
+          IRBuilder<> B(F.getEntryBlock().getFirstInsertionPt());
+          Function *CreateHandle = hlslOP->GetOpFunc(
+              OP::OpCode::CreateHandle, Type::getVoidTy(F.getContext()));
+          Value *HandleArgs[] = {
+              hlslOP->GetU32Const((unsigned)OP::OpCode::CreateHandle),
+              hlslOP->GetI8Const((char)DXIL::ResourceClass::Sampler),
+              hlslOP->GetU32Const(pSampler->GetID()),
+              hlslOP->GetU32Const(SamplerIndex), hlslOP->GetI1Const(false)};
+          SamplerHandle = B.CreateCall(CreateHandle, HandleArgs);
+        }
+
+        emitOptimizationRemark(F.getContext(), DEBUG_TYPE, F,
+                               Quad[0]->Load->getDebugLoc(),
+                               "merged four loads of a 2x2 texel block "
+                               "into a gather");
+        RewriteBlock(Quad, std::get<0>(It.first), std::get<1>(It.first),
+                     std::get<2>(It.first), SamplerHandle, hlslOP);
+        D.second = nullptr;
+        Right->second = nullptr;
+        Below->second = nullptr;
+        BelowRight->second = nullptr;
+        bChanged = true;
+      }
+    }
+  }
+  return bChanged;
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilLoadToGatherPass() {
+  return new DxilLoadToGather();
+}
+
+INITIALIZE_PASS(DxilLoadToGather, "hlsl-dxil-load-to-gather",
+                "DXIL load to gather", false, false)
@@ -20,6 +20,7 @@
 #include "dxc/HLSL/ComputeViewIdState.h"
 #include "dxc/HLSL/DxilFunctionProps.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
@@ -48,6 +49,8 @@ const char DxilMDHelper::kDxilTypeSystemMDName[]                      = "dx.type
 const char DxilMDHelper::kDxilTypeSystemHelperVariablePrefix[]        = "dx.typevar.";
 const char DxilMDHelper::kDxilControlFlowHintMDName[]                 = "dx.controlflow.hints";
 const char DxilMDHelper::kDxilPreciseAttributeMDName[]                = "dx.precise";
+const char DxilMDHelper::kDxilProfileRegionsMDName[]                  = "dx.profile.regions";
+const char DxilMDHelper::kDxilProfileRegionMarkerName[]               = "dx.profile.region";
 const char DxilMDHelper::kHLDxilResourceAttributeMDName[]             = "dx.hl.resource.attribute";
 const char DxilMDHelper::kDxilValidatorVersionMDName[]                = "dx.valver";
 
@@ -645,21 +648,190 @@ void DxilMDHelper::LoadDxilCBuffer(const MDOperand &MDO, DxilCBuffer &CB) {
   m_ExtraPropertyHelper->LoadCBufferProperties(pTupleMD->getOperand(kDxilCBufferNameValueList), CB);
 }
 
-void DxilMDHelper::EmitDxilTypeSystem(DxilTypeSystem &TypeSystem, vector<GlobalVariable*> &LLVMUsed) {
+namespace {
+// Shared string table of the compact struct annotations.
+class CompactStringTable {
+public:
+  explicit CompactStringTable(LLVMContext &Ctx) : m_Ctx(Ctx) {}
+  unsigned GetIndex(StringRef Str) {
+    auto inserted = m_Indices.insert(std::make_pair(Str, (unsigned)m_Strings.size()));
+    if (inserted.second)
+      m_Strings.emplace_back(MDString::get(m_Ctx, Str));
+    return inserted.first->second;
+  }
+  MDTuple *Emit() { return MDNode::get(m_Ctx, m_Strings); }
+
+private:
+  LLVMContext &m_Ctx;
+  StringMap<unsigned> m_Indices;
+  vector<Metadata *> m_Strings;
+};
+
+Metadata *EmitCompactStructAnnotation(LLVMContext &Ctx,
+                                      const DxilStructAnnotation &SA,
+                                      CompactStringTable &Strings) {
+  vector<uint32_t> Vals;
+  Vals.emplace_back(SA.GetCBufferSize());
+  Vals.emplace_back(SA.GetNumFields());
+  for (unsigned i = 0; i < SA.GetNumFields(); i++) {
+    const DxilFieldAnnotation &FA = SA.GetFieldAnnotation(i);
+    size_t FlagsIdx = Vals.size();
+    unsigned Flags = 0;
+    Vals.emplace_back(0);
+    if (FA.HasFieldName()) {
+      Flags |= DxilMDHelper::kDxilCompactFieldName;
+      Vals.emplace_back(Strings.GetIndex(FA.GetFieldName()));
+    }
+    if (FA.IsPrecise())
+      Flags |= DxilMDHelper::kDxilCompactFieldPrecise;
+    if (FA.HasMatrixAnnotation()) {
+      const DxilMatrixAnnotation &MA = FA.GetMatrixAnnotation();
+      Flags |= DxilMDHelper::kDxilCompactFieldMatrix;
+      Vals.emplace_back(MA.Rows);
+      Vals.emplace_back(MA.Cols);
+      Vals.emplace_back((unsigned)MA.Orientation);
+    }
+    if (FA.HasCBufferOffset()) {
+      Flags |= DxilMDHelper::kDxilCompactFieldCBufferOffset;
+      Vals.emplace_back(FA.GetCBufferOffset());
+    }
+    if (FA.HasSemanticString()) {
+      Flags |= DxilMDHelper::kDxilCompactFieldSemanticString;
+      Vals.emplace_back(Strings.GetIndex(FA.GetSemanticString()));
+    }
+    if (FA.HasInterpolationMode()) {
+      Flags |= DxilMDHelper::kDxilCompactFieldInterpolationMode;
+      Vals.emplace_back((unsigned)FA.GetInterpolationMode().GetKind());
+    }
+    if (FA.HasCompType()) {
+      Flags |= DxilMDHelper::kDxilCompactFieldCompType;
+      Vals.emplace_back((unsigned)FA.GetCompType().GetKind());
+    }
+    Vals[FlagsIdx] = Flags;
+  }
+
+  return ConstantAsMetadata::get(ConstantDataArray::get(Ctx, Vals));
+}
+
+// Reads the packed values of a compact struct annotation. An array of all
+// zeros is uniqued as a ConstantAggregateZero rather than a data array.
+void LoadCompactValues(const MDOperand &MDO, vector<uint32_t> &Vals) {
+  const ConstantAsMetadata *pMD = dyn_cast_or_null<ConstantAsMetadata>(MDO.get());
+  IFTBOOL(pMD != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+  Constant *pValue = pMD->getValue();
+  ArrayType *pArrayTy = dyn_cast<ArrayType>(pValue->getType());
+  IFTBOOL(pArrayTy != nullptr && pArrayTy->getElementType()->isIntegerTy(32),
+          DXC_E_INCORRECT_DXIL_METADATA);
+  if (isa<ConstantAggregateZero>(pValue)) {
+    Vals.assign(pArrayTy->getNumElements(), 0);
+    return;
+  }
+  const ConstantDataArray *pArray = dyn_cast<ConstantDataArray>(pValue);
+  IFTBOOL(pArray != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+  Vals.resize(pArray->getNumElements());
+  for (unsigned i = 0; i < Vals.size(); i++)
+    Vals[i] = (uint32_t)pArray->getElementAsInteger(i);
+}
+
+class CompactValueReader {
+public:
+  CompactValueReader(const vector<uint32_t> &Vals, const MDTuple &Strings)
+      : m_Vals(Vals), m_Strings(Strings), m_Idx(0) {}
+  uint32_t Read() {
+    IFTBOOL(m_Idx < m_Vals.size(), DXC_E_INCORRECT_DXIL_METADATA);
+    return m_Vals[m_Idx++];
+  }
+  string ReadString() {
+    uint32_t StrIdx = Read();
+    IFTBOOL(StrIdx < m_Strings.getNumOperands(), DXC_E_INCORRECT_DXIL_METADATA);
+    const MDString *pStr = dyn_cast_or_null<MDString>(m_Strings.getOperand(StrIdx).get());
+    IFTBOOL(pStr != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+    return pStr->getString();
+  }
+  bool AtEnd() const { return m_Idx == m_Vals.size(); }
+
+private:
+  const vector<uint32_t> &m_Vals;
+  const MDTuple &m_Strings;
+  size_t m_Idx;
+};
+
+void LoadCompactStructAnnotation(const MDOperand &MDO, const MDTuple &Strings,
+                                 DxilStructAnnotation &SA) {
+  vector<uint32_t> Vals;
+  LoadCompactValues(MDO, Vals);
+  CompactValueReader R(Vals, Strings);
+  SA.SetCBufferSize(R.Read());
+  unsigned NumFields = R.Read();
+  if (NumFields == 0) {
+    const StructType *ST = SA.GetStructType();
+    if (ST->getNumElements() == 1 &&
+        ST->getElementType(0) == Type::getInt8Ty(ST->getContext()))
+      SA.MarkEmptyStruct();
+  }
+  IFTBOOL(NumFields == SA.GetNumFields(), DXC_E_INCORRECT_DXIL_METADATA);
+
+  const unsigned KnownFlags =
+      DxilMDHelper::kDxilCompactFieldName |
+      DxilMDHelper::kDxilCompactFieldPrecise |
+      DxilMDHelper::kDxilCompactFieldMatrix |
+      DxilMDHelper::kDxilCompactFieldCBufferOffset |
+      DxilMDHelper::kDxilCompactFieldSemanticString |
+      DxilMDHelper::kDxilCompactFieldInterpolationMode |
+      DxilMDHelper::kDxilCompactFieldCompType;
+  for (unsigned i = 0; i < NumFields; i++) {
+    DxilFieldAnnotation &FA = SA.GetFieldAnnotation(i);
+    unsigned Flags = R.Read();
+    IFTBOOL((Flags & ~KnownFlags) == 0, DXC_E_INCORRECT_DXIL_METADATA);
+    if (Flags & DxilMDHelper::kDxilCompactFieldName)
+      FA.SetFieldName(R.ReadString());
+    if (Flags & DxilMDHelper::kDxilCompactFieldPrecise)
+      FA.SetPrecise(true);
+    if (Flags & DxilMDHelper::kDxilCompactFieldMatrix) {
+      DxilMatrixAnnotation MA;
+      MA.Rows = R.Read();
+      MA.Cols = R.Read();
+      MA.Orientation = (MatrixOrientation)R.Read();
+      FA.SetMatrixAnnotation(MA);
+    }
+    if (Flags & DxilMDHelper::kDxilCompactFieldCBufferOffset)
+      FA.SetCBufferOffset(R.Read());
+    if (Flags & DxilMDHelper::kDxilCompactFieldSemanticString)
+      FA.SetSemanticString(R.ReadString());
+    if (Flags & DxilMDHelper::kDxilCompactFieldInterpolationMode)
+      FA.SetInterpolationMode(InterpolationMode((InterpolationMode::Kind)R.Read()));
+    if (Flags & DxilMDHelper::kDxilCompactFieldCompType)
+      FA.SetCompType((CompType::Kind)R.Read());
+  }
+  IFTBOOL(R.AtEnd(), DXC_E_INCORRECT_DXIL_METADATA);
+}
+} // namespace
+
+void DxilMDHelper::EmitDxilTypeSystem(DxilTypeSystem &TypeSystem, vector<GlobalVariable*> &LLVMUsed,
+                                      bool bCompact) {
   auto &TypeMap = TypeSystem.GetStructAnnotationMap();
   vector<Metadata *> MDVals;
-  MDVals.emplace_back(Uint32ToConstMD(kDxilTypeSystemStructTag)); // Tag
+  CompactStringTable Strings(m_Ctx);
+  if (bCompact) {
+    MDVals.emplace_back(Uint32ToConstMD(kDxilTypeSystemCompactStructTag)); // Tag
+    MDVals.emplace_back(nullptr); // String table, filled in below.
+  } else {
+    MDVals.emplace_back(Uint32ToConstMD(kDxilTypeSystemStructTag)); // Tag
+  }
   unsigned GVIdx = 0;
   for (auto it = TypeMap.begin(); it != TypeMap.end(); ++it, GVIdx++) {
     StructType *pStructType = const_cast<StructType *>(it->first);
     DxilStructAnnotation *pA = it->second.get();
 
     // Emit struct type field annotations.
-    Metadata *pMD = EmitDxilStructAnnotation(*pA);
+    Metadata *pMD = bCompact ? EmitCompactStructAnnotation(m_Ctx, *pA, Strings)
+                             : EmitDxilStructAnnotation(*pA);
 
     MDVals.push_back(ValueAsMetadata::get(UndefValue::get(pStructType)));
     MDVals.push_back(pMD);
   }
+  if (bCompact)
+    MDVals[1] = Strings.Emit();
 
   auto &FuncMap = TypeSystem.GetFunctionAnnotationMap();
   vector<Metadata *> MDFuncVals;
@@ -674,7 +846,7 @@ void DxilMDHelper::EmitDxilTypeSystem(DxilTypeSystem &TypeSystem, vector<GlobalV
     MDFuncVals.push_back(pMD);
   }
 
-  if (MDVals.size() > 1) {
+  if (MDVals.size() > (bCompact ? 2u : 1u)) {
     NamedMDNode *pDxilTypeAnnotationsMD = m_pModule->getNamedMetadata(kDxilTypeSystemMDName);
     IFTBOOL(pDxilTypeAnnotationsMD == nullptr, DXC_E_INCORRECT_DXIL_METADATA);
     pDxilTypeAnnotationsMD = m_pModule->getOrInsertNamedMetadata(kDxilTypeSystemMDName);
@@ -708,6 +880,22 @@ void DxilMDHelper::LoadDxilTypeSystemNode(const llvm::MDTuple &MDT,
       DxilStructAnnotation *pSA = TypeSystem.AddStructAnnotation(pGVType);
       LoadDxilStructAnnotation(MDT.getOperand(i + 1), *pSA);
     }
+  } else if (Tag == kDxilTypeSystemCompactStructTag) {
+    IFTBOOL((MDT.getNumOperands() & 0x1) == 0, DXC_E_INCORRECT_DXIL_METADATA);
+    const MDTuple *pStrings = dyn_cast_or_null<MDTuple>(MDT.getOperand(1).get());
+    IFTBOOL(pStrings != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+
+    for (unsigned i = 2; i < MDT.getNumOperands(); i += 2) {
+      Constant *pGV =
+          dyn_cast<Constant>(ValueMDToValue(MDT.getOperand(i)));
+      IFTBOOL(pGV != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+      StructType *pGVType =
+          dyn_cast<StructType>(pGV->getType());
+      IFTBOOL(pGVType != nullptr, DXC_E_INCORRECT_DXIL_METADATA);
+
+      DxilStructAnnotation *pSA = TypeSystem.AddStructAnnotation(pGVType);
+      LoadCompactStructAnnotation(MDT.getOperand(i + 1), *pStrings, *pSA);
+    }
   } else {
     IFTBOOL(Tag == kDxilTypeSystemFunctionTag, DXC_E_INCORRECT_DXIL_METADATA);
     IFTBOOL((MDT.getNumOperands() & 0x1) == 1, DXC_E_INCORRECT_DXIL_METADATA);
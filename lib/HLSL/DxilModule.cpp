@@ -333,152 +333,148 @@ static ConstantInt *GetArbitraryConstantRangeID(CallInst *handleCall) {
   return ConstantRangeID;
 }
 
-void DxilModule::CollectShaderFlags(ShaderFlags &Flags) {
-  bool hasDouble = false;
-  // ddiv dfma drcp d2i d2u i2d u2d.
-  // fma has dxil op. Others should check IR instruction div/cast.
-  bool hasDoubleExtension = false;
-  bool has64Int = false;
-  bool has16FloatInt = false;
-  bool hasWaveOps = false;
-  bool hasCheckAccessFully = false;
-  bool hasMSAD = false;
-  bool hasInnerCoverage = false;
-  bool hasViewID = false;
-  bool hasMulticomponentUAVLoads = false;
-  bool hasMulticomponentUAVLoadsBackCompat = false;
+void DxilModule::InstructionCensus::AddInstruction(Instruction &I) {
+  // Skip none dxil function call.
+  CallInst *CI = dyn_cast<CallInst>(&I);
+  if (CI && !OP::IsDxilOpFunc(CI->getCalledFunction()))
+    return;
+  if (isa<ExtractElementInst>(&I) || isa<InsertElementInst>(&I))
+    return;
 
-  // Try to maintain compatibility with a v1.0 validator if that's what we have.
-  {
-    unsigned valMajor, valMinor;
-    GetValidatorVersion(valMajor, valMinor);
-    hasMulticomponentUAVLoadsBackCompat = valMajor <= 1 && valMinor == 0;
+  Type *Ty = I.getType();
+  bool isDouble = Ty->isDoubleTy();
+  bool isHalf = Ty->isHalfTy();
+  bool isInt16 = Ty->isIntegerTy(16);
+  bool isInt64 = Ty->isIntegerTy(64);
+  for (Value *operand : I.operands()) {
+    Type *Ty = operand->getType();
+    isDouble |= Ty->isDoubleTy();
+    isHalf |= Ty->isHalfTy();
+    isInt16 |= Ty->isIntegerTy(16);
+    isInt64 |= Ty->isIntegerTy(64);
   }
 
-  Type *int16Ty = Type::getInt16Ty(GetCtx());
-  Type *int64Ty = Type::getInt64Ty(GetCtx());
+  if (isDouble) {
+    m_bDouble = true;
+    // fma has dxil op. Others should check IR instruction div/cast.
+    switch (I.getOpcode()) {
+    case Instruction::FDiv:
+    case Instruction::UIToFP:
+    case Instruction::SIToFP:
+    case Instruction::FPToUI:
+    case Instruction::FPToSI:
+      m_bDoubleExtensions = true;
+      break;
+    }
+  }
 
-  for (Function &F : GetModule()->functions()) {
-    for (BasicBlock &BB : F.getBasicBlockList()) {
-      for (Instruction &I : BB.getInstList()) {
-        // Skip none dxil function call.
-        if (CallInst *CI = dyn_cast<CallInst>(&I)) {
-          if (!OP::IsDxilOpFunc(CI->getCalledFunction()))
-            continue;
-        }
-        Type *Ty = I.getType();
-        bool isDouble = Ty->isDoubleTy();
-        bool isHalf = Ty->isHalfTy();
-        bool isInt16 = Ty == int16Ty;
-        bool isInt64 = Ty == int64Ty;
-        if (isa<ExtractElementInst>(&I) ||
-            isa<InsertElementInst>(&I))
-          continue;
-        for (Value *operand : I.operands()) {
-          Type *Ty = operand->getType();
-          isDouble |= Ty->isDoubleTy();
-          isHalf |= Ty->isHalfTy();
-          isInt16 |= Ty == int16Ty;
-          isInt64 |= Ty == int64Ty;
-        }
+  m_b16BitTypes |= isHalf;
+  m_b16BitTypes |= isInt16;
+  m_bInt64 |= isInt64;
 
-        if (isDouble) {
-          hasDouble = true;
-          switch (I.getOpcode()) {
-          case Instruction::FDiv:
-          case Instruction::UIToFP:
-          case Instruction::SIToFP:
-          case Instruction::FPToUI:
-          case Instruction::FPToSI:
-            hasDoubleExtension = true;
-            break;
-          }
-        }
-        
-        has16FloatInt |= isHalf;
-        has16FloatInt |= isInt16;
-        has64Int |= isInt64;
-
-        if (CallInst *CI = dyn_cast<CallInst>(&I)) {
-          if (!OP::IsDxilOpFunc(CI->getCalledFunction()))
-            continue;
-          Value *opcodeArg = CI->getArgOperand(DXIL::OperandIndex::kOpcodeIdx);
-          ConstantInt *opcodeConst = dyn_cast<ConstantInt>(opcodeArg);
-          DXASSERT(opcodeConst, "DXIL opcode arg must be immediate");
-          unsigned opcode = opcodeConst->getLimitedValue();
-          DXASSERT(opcode < static_cast<unsigned>(DXIL::OpCode::NumOpCodes),
-                   "invalid DXIL opcode");
-          DXIL::OpCode dxilOp = static_cast<DXIL::OpCode>(opcode);
-          if (hlsl::OP::IsDxilOpWave(dxilOp))
-            hasWaveOps = true;
-          switch (dxilOp) {
-          case DXIL::OpCode::CheckAccessFullyMapped:
-            hasCheckAccessFully = true;
-            break;
-          case DXIL::OpCode::Msad:
-            hasMSAD = true;
-            break;
-          case DXIL::OpCode::BufferLoad:
-          case DXIL::OpCode::TextureLoad: {
-            if (hasMulticomponentUAVLoads) continue;
-            // This is the old-style computation (overestimating requirements).
-            Value *resHandle = CI->getArgOperand(DXIL::OperandIndex::kBufferStoreHandleOpIdx);
-            CallInst *handleCall = cast<CallInst>(resHandle);
-
-            if (ConstantInt *resClassArg =
-              dyn_cast<ConstantInt>(handleCall->getArgOperand(
+  if (!CI)
+    return;
+  Value *opcodeArg = CI->getArgOperand(DXIL::OperandIndex::kOpcodeIdx);
+  ConstantInt *opcodeConst = dyn_cast<ConstantInt>(opcodeArg);
+  DXASSERT(opcodeConst, "DXIL opcode arg must be immediate");
+  unsigned opcode = opcodeConst->getLimitedValue();
+  DXASSERT(opcode < static_cast<unsigned>(DXIL::OpCode::NumOpCodes),
+           "invalid DXIL opcode");
+  // The validator reports invalid opcodes by itself.
+  if (opcode >= static_cast<unsigned>(DXIL::OpCode::NumOpCodes))
+    return;
+  DXIL::OpCode dxilOp = static_cast<DXIL::OpCode>(opcode);
+  m_OpCodes.set(opcode);
+  if (hlsl::OP::IsDxilOpWave(dxilOp))
+    m_bWaveOps = true;
+  switch (dxilOp) {
+  case DXIL::OpCode::BufferLoad:
+  case DXIL::OpCode::TextureLoad: {
+    Value *resHandle =
+        CI->getArgOperand(DXIL::OperandIndex::kBufferStoreHandleOpIdx);
+    CallInst *handleCall = cast<CallInst>(resHandle);
+
+    if (ConstantInt *resClassArg =
+            dyn_cast<ConstantInt>(handleCall->getArgOperand(
                 DXIL::OperandIndex::kCreateHandleResClassOpIdx))) {
-              DXIL::ResourceClass resClass = static_cast<DXIL::ResourceClass>(
-                resClassArg->getLimitedValue());
-              if (resClass == DXIL::ResourceClass::UAV) {
-                // Validator 1.0 assumes that all uav load is multi component load.
-                if (hasMulticomponentUAVLoadsBackCompat) {
-                  hasMulticomponentUAVLoads = true;
-                  continue;
-                }
-                else {
-                  ConstantInt *rangeID = GetArbitraryConstantRangeID(handleCall);
-                  if (rangeID) {
-                      DxilResource resource = GetUAV(rangeID->getLimitedValue());
-                      if (!IsResourceSingleComponent(resource.GetRetType())) {
-                          hasMulticomponentUAVLoads = true;
-                      }
-                  }
-                }
-              }
-            }
-            else {
-                DXASSERT(false, "Resource class must be constant.");
-            }
-          } break;
-          case DXIL::OpCode::Fma:
-            hasDoubleExtension |= isDouble;
-            break;
-          case DXIL::OpCode::InnerCoverage:
-            hasInnerCoverage = true;
-            break;
-          case DXIL::OpCode::ViewID:
-            hasViewID = true;
-            break;
-          default:
-            // Normal opcodes.
-            break;
-          }
-        }
+      DXIL::ResourceClass resClass = static_cast<DXIL::ResourceClass>(
+          resClassArg->getLimitedValue());
+      if (resClass == DXIL::ResourceClass::UAV) {
+        m_bUAVLoad = true;
+        if (ConstantInt *rangeID = GetArbitraryConstantRangeID(handleCall))
+          m_LoadedUAVRangeIDs.insert(rangeID->getLimitedValue());
       }
+    } else {
+      DXASSERT(false, "Resource class must be constant.");
     }
+  } break;
+  case DXIL::OpCode::Fma:
+    m_bDoubleExtensions |= isDouble;
+    break;
+  default:
+    // Normal opcodes.
+    break;
+  }
+}
 
+void DxilModule::InstructionCensus::AddFunction(Function &F) {
+  for (BasicBlock &BB : F.getBasicBlockList()) {
+    for (Instruction &I : BB.getInstList())
+      AddInstruction(I);
   }
+}
 
-  Flags.SetEnableDoublePrecision(hasDouble);
-  Flags.SetInt64Ops(has64Int);
-  Flags.SetEnableMinPrecision(has16FloatInt);
-  Flags.SetEnableDoubleExtensions(hasDoubleExtension);
-  Flags.SetWaveOps(hasWaveOps);
-  Flags.SetTiledResources(hasCheckAccessFully);
-  Flags.SetEnableMSAD(hasMSAD);
+void DxilModule::InstructionCensus::Merge(const InstructionCensus &Other) {
+  m_OpCodes |= Other.m_OpCodes;
+  m_LoadedUAVRangeIDs.insert(Other.m_LoadedUAVRangeIDs.begin(),
+                             Other.m_LoadedUAVRangeIDs.end());
+  m_bWaveOps |= Other.m_bWaveOps;
+  m_bDouble |= Other.m_bDouble;
+  m_bDoubleExtensions |= Other.m_bDoubleExtensions;
+  m_bInt64 |= Other.m_bInt64;
+  m_b16BitTypes |= Other.m_b16BitTypes;
+  m_bUAVLoad |= Other.m_bUAVLoad;
+}
+
+void DxilModule::CollectShaderFlags(ShaderFlags &Flags) {
+  InstructionCensus Census;
+  for (Function &F : GetModule()->functions())
+    Census.AddFunction(F);
+  CollectShaderFlags(Flags, Census);
+}
+
+void DxilModule::CollectShaderFlags(ShaderFlags &Flags,
+                                    const InstructionCensus &Census) {
+  bool hasMulticomponentUAVLoads = false;
+  if (Census.LoadsUAV()) {
+    // Try to maintain compatibility with a v1.0 validator if that's what we
+    // have: it assumes that all uav loads are multi component loads.
+    unsigned valMajor, valMinor;
+    GetValidatorVersion(valMajor, valMinor);
+    if (valMajor <= 1 && valMinor == 0) {
+      hasMulticomponentUAVLoads = true;
+    } else {
+      for (unsigned rangeID : Census.GetLoadedUAVRangeIDs()) {
+        const DxilResource &resource = GetUAV(rangeID);
+        if (!IsResourceSingleComponent(resource.GetRetType())) {
+          hasMulticomponentUAVLoads = true;
+          break;
+        }
+      }
+    }
+  }
+  bool hasInnerCoverage = Census.UsesOpCode(DXIL::OpCode::InnerCoverage);
+
+  Flags.SetEnableDoublePrecision(Census.UsesDouble());
+  Flags.SetInt64Ops(Census.UsesInt64());
+  Flags.SetEnableMinPrecision(Census.Uses16BitTypes());
+  Flags.SetEnableDoubleExtensions(Census.UsesDoubleExtensions());
+  Flags.SetWaveOps(Census.UsesWaveOps());
+  Flags.SetTiledResources(
+      Census.UsesOpCode(DXIL::OpCode::CheckAccessFullyMapped));
+  Flags.SetEnableMSAD(Census.UsesOpCode(DXIL::OpCode::Msad));
   Flags.SetUAVLoadAdditionalFormats(hasMulticomponentUAVLoads);
-  Flags.SetViewID(hasViewID);
+  Flags.SetViewID(Census.UsesOpCode(DXIL::OpCode::ViewID));
 
   const ShaderModel *SM = GetShaderModel();
   if (SM->IsPS()) {
@@ -1182,7 +1178,7 @@ vector<GlobalVariable* > &DxilModule::GetLLVMUsed() {
 }
 
 // DXIL metadata serialization/deserialization.
-void DxilModule::EmitDxilMetadata() {
+void DxilModule::EmitDxilMetadata(bool bEmitRootSignature) {
   m_pMDHelper->EmitDxilVersion(m_DxilMajor, m_DxilMinor);
   m_pMDHelper->EmitValidatorVersion(m_ValMajor, m_ValMinor);
   m_pMDHelper->EmitDxilShaderModel(m_pSM);
@@ -1191,7 +1187,11 @@ void DxilModule::EmitDxilMetadata() {
 
   MDTuple *pMDSignatures = m_pMDHelper->EmitDxilSignatures(*m_EntrySignature);
   MDTuple *pMDResources = EmitDxilResources();
-  m_pMDHelper->EmitDxilTypeSystem(GetTypeSystem(), m_LLVMUsed);
+  bool bCompactTypeSystem =
+      m_ValMajor > DxilMDHelper::kDxilTypeSystemCompactMinValMajor ||
+      (m_ValMajor == DxilMDHelper::kDxilTypeSystemCompactMinValMajor &&
+       m_ValMinor >= DxilMDHelper::kDxilTypeSystemCompactMinValMinor);
+  m_pMDHelper->EmitDxilTypeSystem(GetTypeSystem(), m_LLVMUsed, bCompactTypeSystem);
   if (!m_pSM->IsCS() &&
       (m_ValMajor > 1 || (m_ValMajor == 1 && m_ValMinor >= 1))) {
     m_pMDHelper->EmitDxilViewIdState(GetViewIdState());
@@ -1202,27 +1202,31 @@ void DxilModule::EmitDxilMetadata() {
   Entries.emplace_back(pEntry);
   m_pMDHelper->EmitDxilEntryPoints(Entries);
 
-  if (!m_RootSignature->IsEmpty()) {
+  if (bEmitRootSignature && !m_RootSignature->IsEmpty()) {
     m_pMDHelper->EmitRootSignature(*m_RootSignature.get());
   }
   if (m_pSM->IsLib()) {
     EmitDxilResourcesLinkInfo();
     NamedMDNode *fnProps = m_pModule->getOrInsertNamedMetadata(
         DxilMDHelper::kDxilFunctionPropertiesMDName);
-    for (auto &&pair : m_DxilFunctionPropsMap) {
-      const hlsl::DxilFunctionProps *props = pair.second.get();
-      MDTuple *pProps = m_pMDHelper->EmitDxilFunctionProps(props, pair.first);
+    // Both maps are keyed by address, so they are emitted in module order.
+    for (Function &F : *m_pModule) {
+      auto it = m_DxilFunctionPropsMap.find(&F);
+      if (it == m_DxilFunctionPropsMap.end())
+        continue;
+      MDTuple *pProps = m_pMDHelper->EmitDxilFunctionProps(it->second.get(), &F);
       fnProps->addOperand(pProps);
     }
 
     NamedMDNode *entrySigs = m_pModule->getOrInsertNamedMetadata(
         DxilMDHelper::kDxilEntrySignaturesMDName);
-    for (auto &&pair : m_DxilEntrySignatureMap) {
-      Function *F = pair.first;
-      DxilEntrySignature *Sig = pair.second.get();
-      MDTuple *pSig = m_pMDHelper->EmitDxilSignatures(*Sig);
+    for (Function &F : *m_pModule) {
+      auto it = m_DxilEntrySignatureMap.find(&F);
+      if (it == m_DxilEntrySignatureMap.end())
+        continue;
+      MDTuple *pSig = m_pMDHelper->EmitDxilSignatures(*it->second);
       entrySigs->addOperand(
-          MDTuple::get(m_Ctx, {ValueAsMetadata::get(F), pSig}));
+          MDTuple::get(m_Ctx, {ValueAsMetadata::get(&F), pSig}));
     }
   }
 }
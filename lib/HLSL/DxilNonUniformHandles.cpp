@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilNonUniformHandles.cpp                                                 //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Sets the non-uniform flag of resource handles from the uniformity of      //
+// their indices.                                                            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <memory>
+
+using namespace llvm;
+using namespace hlsl;
+
+#define DEBUG_TYPE "hlsl-dxil-non-uniform-handles"
+
+namespace {
+// The non-uniform flag of createHandle comes from NonUniformResourceIndex
+// in the source. Drivers turn a flagged handle into a loop over the
+// distinct indices of the wave, which is wasted when the index is the same
+// in every lane: a literal, a constant buffer value, the group id, or
+// anything computed from those alone. An index that differs per lane but
+// isn't flagged is undefined behavior that happens to work on some
+// hardware. With DxilUniformityAnalysis, this pass clears the flag of
+// handles with uniform indices and sets it on the others. Each change is
+// reported in an analysis remark; a flag that was missing points at a
+// source bug.
+class DxilNonUniformHandles : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilNonUniformHandles()
+      : FunctionPass(ID), m_pAnalysis(DxilUniformityAnalysis::create()) {}
+
+  const char *getPassName() const override {
+    return "DXIL non-uniform handles";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (!F.getParent()->HasDxilModule() || F.isDeclaration())
+      return false;
+
+    SmallVector<CallInst *, 16> Handles;
+    for (Instruction &I : inst_range(F)) {
+      if (!OP::IsDxilOpFuncCallInst(&I, OP::OpCode::CreateHandle))
+        continue;
+      DxilInst_CreateHandle CH(&I);
+      if (!isa<Constant>(CH.get_index()) &&
+          isa<ConstantInt>(CH.get_nonUniformIndex()))
+        Handles.push_back(cast<CallInst>(&I));
+    }
+    if (Handles.empty())
+      return false;
+
+    m_pAnalysis->Analyze(&F);
+    hlsl::OP *hlslOP = F.getParent()->GetDxilModule().GetOP();
+    bool bChanged = false;
+    for (CallInst *CI : Handles) {
+      DxilInst_CreateHandle CH(CI);
+      bool bNonUniform = !m_pAnalysis->IsUniform(CH.get_index());
+      if (bNonUniform == CH.get_nonUniformIndex_val())
+        continue;
+      CI->setArgOperand(DXIL::OperandIndex::kCreateHandleIsUniformOpIdx,
+                        hlslOP->GetI1Const(bNonUniform));
+      emitOptimizationRemarkAnalysis(
+          F.getContext(), DEBUG_TYPE, F, CI->getDebugLoc(),
+          bNonUniform
+              ? "resource index may differ across the wave but is not "
+                "marked with NonUniformResourceIndex; marked non-uniform"
+              : "resource index marked with NonUniformResourceIndex is "
+                "uniform across the wave; mark removed");
+      bChanged = true;
+    }
+    return bChanged;
+  }
+
+private:
+  std::unique_ptr<DxilUniformityAnalysis> m_pAnalysis;
+};
+
+char DxilNonUniformHandles::ID = 0;
+
+} // namespace
+
+FunctionPass *llvm::createDxilNonUniformHandlesPass() {
+  return new DxilNonUniformHandles();
+}
+
+INITIALIZE_PASS(DxilNonUniformHandles, "hlsl-dxil-non-uniform-handles",
+                "DXIL non-uniform handles", false, false)
@@ -141,7 +141,7 @@ const OP::OpCodeProperty OP::m_OpCodeProps[(unsigned)OP::OpCode::NumOpCodes] = {
   {  OC::BufferStore,             "BufferStore",              OCC::BufferStore,              "bufferStore",                false,  true,  true, false, false, false,  true,  true, false, Attribute::None,     },
   {  OC::BufferUpdateCounter,     "BufferUpdateCounter",      OCC::BufferUpdateCounter,      "bufferUpdateCounter",         true, false, false, false, false, false, false, false, false, Attribute::None,     },
   {  OC::CheckAccessFullyMapped,  "CheckAccessFullyMapped",   OCC::CheckAccessFullyMapped,   "checkAccessFullyMapped",     false, false, false, false, false, false, false,  true, false, Attribute::ReadOnly, },
-  {  OC::GetDimensions,           "GetDimensions",            OCC::GetDimensions,            "getDimensions",               true, false, false, false, false, false, false, false, false, Attribute::ReadOnly, },
+  {  OC::GetDimensions,           "GetDimensions",            OCC::GetDimensions,            "getDimensions",               true, false, false, false, false, false, false, false, false, Attribute::ReadNone, },
 
   // Resources - gather                                                                                                     void,     h,     f,     d,    i1,    i8,   i16,   i32,   i64  function attribute
   {  OC::TextureGather,           "TextureGather",            OCC::TextureGather,            "textureGather",              false, false,  true, false, false, false, false,  true, false, Attribute::ReadOnly, },
@@ -158,7 +158,7 @@ const OP::OpCodeProperty OP::m_OpCodeProps[(unsigned)OP::OpCode::NumOpCodes] = {
   {  OC::Barrier,                 "Barrier",                  OCC::Barrier,                  "barrier",                     true, false, false, false, false, false, false, false, false, Attribute::None,     },
 
   // Pixel shader                                                                                                           void,     h,     f,     d,    i1,    i8,   i16,   i32,   i64  function attribute
-  {  OC::CalculateLOD,            "CalculateLOD",             OCC::CalculateLOD,             "calculateLOD",               false, false,  true, false, false, false, false, false, false, Attribute::ReadOnly, },
+  {  OC::CalculateLOD,            "CalculateLOD",             OCC::CalculateLOD,             "calculateLOD",               false, false,  true, false, false, false, false, false, false, Attribute::ReadNone, },
   {  OC::Discard,                 "Discard",                  OCC::Discard,                  "discard",                     true, false, false, false, false, false, false, false, false, Attribute::None,     },
   {  OC::DerivCoarseX,            "DerivCoarseX",             OCC::Unary,                    "unary",                      false,  true,  true, false, false, false, false, false, false, Attribute::ReadNone, },
   {  OC::DerivCoarseY,            "DerivCoarseY",             OCC::Unary,                    "unary",                      false,  true,  true, false, false, false, false, false, false, Attribute::ReadNone, },
@@ -334,6 +334,30 @@ bool OP::IsDxilOpFuncName(StringRef name) {
   return name.startswith(OP::m_NamePrefix);
 }
 
+bool OP::IsDxilOpTypeName(StringRef name) {
+  static const char *const FixedNames[] = {
+    "dx.types.Handle", "dx.types.Dimensions", "dx.types.SamplePos",
+    "dx.types.i32c", "dx.types.twoi32", "dx.types.splitdouble",
+    "dx.types.fouri32"
+  };
+  for (const char *FixedName : FixedNames) {
+    if (name == FixedName)
+      return true;
+  }
+  StringRef overload;
+  if (name.startswith("dx.types.ResRet."))
+    overload = name.drop_front(sizeof("dx.types.ResRet.") - 1);
+  else if (name.startswith("dx.types.CBufRet."))
+    overload = name.drop_front(sizeof("dx.types.CBufRet.") - 1);
+  else
+    return false;
+  for (unsigned i = 0; i < kNumTypeOverloads; i++) {
+    if (overload == m_OverloadTypeName[i])
+      return true;
+  }
+  return false;
+}
+
 bool OP::IsDxilOpFunc(const llvm::Function *F) {
   if (!F->hasName())
     return false;
@@ -450,10 +474,11 @@ Function *OP::GetOpFunc(OpCode OpCode, Type *pOverloadType) {
   unsigned TypeSlot = GetTypeSlot(pOverloadType);
   OpCodeClass opClass = m_OpCodeProps[(unsigned)OpCode].OpCodeClass;
   Function *&F = m_OpCodeClassCache[(unsigned)opClass].pOverloads[TypeSlot];
-  if (F != nullptr) {
-    UpdateCache(opClass, TypeSlot, F);
+  // Functions enter the cache through UpdateCache, so a cached function is
+  // already in m_FunctionToOpClass; lowering hits this path for every call
+  // it emits.
+  if (F != nullptr)
     return F;
-  }
 
   vector<Type*> ArgTypes;      // RetType is ArgTypes[0]
   Type *pETy = pOverloadType;
@@ -728,7 +753,10 @@ llvm::ArrayRef<llvm::Function *> OP::GetOpFuncList(OpCode OpCode) const {
 
 void OP::RemoveFunction(Function *F) {
   if (OP::IsDxilOpFunc(F)) {
-    OpCodeClass opClass = m_FunctionToOpClass[F];
+    auto iter = m_FunctionToOpClass.find(F);
+    if (iter == m_FunctionToOpClass.end())
+      return;
+    OpCodeClass opClass = iter->second;
     for (unsigned i=0;i<kNumTypeOverloads;i++) {
       if (F == m_OpCodeClassCache[(unsigned)opClass].pOverloads[i]) {
         m_OpCodeClassCache[(unsigned)opClass].pOverloads[i] = nullptr;
@@ -739,7 +767,43 @@ void OP::RemoveFunction(Function *F) {
   }
 }
 
-bool OP::GetOpCodeClass(const Function *F, OP::OpCodeClass &opClass) {
+bool OP::IsCachedOpFunc(OpCodeClass opClass, const Function *F) const {
+  const OpCodeCacheItem &Item = m_OpCodeClassCache[(unsigned)opClass];
+  for (unsigned i = 0; i < kNumTypeOverloads; i++) {
+    if (Item.pOverloads[i] == F)
+      return true;
+  }
+  return false;
+}
+
+bool OP::GetOpCodeClass(const Function *F, OP::OpCodeClass &opClass) const {
+  // Most callers ask about every call they visit, so reject functions that
+  // are not dxil operations by name before touching any table.
+  if (!IsDxilOpFunc(F))
+    return false;
+
+  // Every call to a dxil operation carries its opcode as the first argument,
+  // which indexes the static property table directly.
+  if (!F->user_empty()) {
+    if (const CallInst *CI = dyn_cast<CallInst>(*F->user_begin())) {
+      if (CI->getCalledFunction() == F && CI->getNumArgOperands() > 0) {
+        if (const ConstantInt *CIOp =
+                dyn_cast<ConstantInt>(CI->getArgOperand(0))) {
+          uint64_t opcode = CIOp->getLimitedValue();
+          if (opcode < (uint64_t)OpCode::NumOpCodes) {
+            OpCodeClass candidate = m_OpCodeProps[(unsigned)opcode].OpCodeClass;
+            if (IsCachedOpFunc(candidate, F)) {
+              opClass = candidate;
+              return true;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Unused declarations, or ones whose first user is not a call, fall back
+  // to the map.
   auto iter = m_FunctionToOpClass.find(F);
   if (iter == m_FunctionToOpClass.end()) {
     DXASSERT(!IsDxilOpFunc(F), "dxil function without an opcode class mapping?");
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilPairHalfOps.cpp                                                       //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Schedules independent 16-bit float operations of the same kind next to    //
+// each other, so drivers targeting packed math can issue them together.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilOperations.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+// DXIL has no vector arithmetic, so 16-bit operations cannot be paired into
+// two-wide instructions here. Drivers for hardware with packed FP16 pair
+// them when lowering, but only look at neighbouring instructions. This pass
+// moves each half operation up to follow an earlier independent operation
+// of the same kind in its block, when all its operands are available there.
+class DxilPairHalfOps : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilPairHalfOps() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL pair half operations";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override {
+    bool bChanged = false;
+    for (BasicBlock &BB : F)
+      bChanged |= PairInBlock(BB);
+    return bChanged;
+  }
+
+private:
+  // Operations pair when they have the same callee (null for instructions)
+  // and the same opcode.
+  typedef std::pair<const Function *, unsigned> PairKey;
+
+  // Returns false if the instruction is not a pairable half operation.
+  static bool GetPairKey(Instruction *I, PairKey &Key) {
+    if (!I->getType()->isHalfTy())
+      return false;
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(I)) {
+      switch (BO->getOpcode()) {
+      case Instruction::FAdd:
+      case Instruction::FSub:
+      case Instruction::FMul:
+        Key = PairKey(nullptr, BO->getOpcode());
+        return true;
+      default:
+        return false;
+      }
+    }
+    CallInst *CI = dyn_cast<CallInst>(I);
+    if (!CI || !OP::IsDxilOpFuncCallInst(CI) || !CI->doesNotAccessMemory())
+      return false;
+    Key = PairKey(CI->getCalledFunction(),
+                  (unsigned)OP::GetDxilOpFuncCallInst(CI));
+    return true;
+  }
+
+  bool PairInBlock(BasicBlock &BB);
+};
+
+bool DxilPairHalfOps::PairInBlock(BasicBlock &BB) {
+  // Position of each instruction; a moved instruction takes its partner's.
+  DenseMap<Instruction *, unsigned> Order;
+  unsigned Index = 0;
+  for (Instruction &I : BB)
+    Order[&I] = Index++;
+
+  DenseMap<PairKey, Instruction *> Pending;
+  bool bChanged = false;
+  for (BasicBlock::iterator It = BB.begin(), E = BB.end(); It != E;) {
+    Instruction *I = It++;
+    PairKey Key;
+    if (!GetPairKey(I, Key))
+      continue;
+
+    auto P = Pending.find(Key);
+    if (P == Pending.end()) {
+      Pending[Key] = I;
+      continue;
+    }
+
+    Instruction *Partner = P->second;
+    unsigned PartnerOrder = Order[Partner];
+    bool bAvailable = true;
+    for (Value *Op : I->operands()) {
+      Instruction *OpI = dyn_cast<Instruction>(Op);
+      if (OpI && OpI->getParent() == &BB && Order[OpI] >= PartnerOrder) {
+        bAvailable = false;
+        break;
+      }
+    }
+    if (!bAvailable) {
+      // I depends on something after the partner; it may still pair with a
+      // later operation.
+      P->second = I;
+      continue;
+    }
+
+    Pending.erase(P);
+    if (Partner->getNextNode() == I)
+      continue;
+    I->moveBefore(Partner->getNextNode());
+    Order[I] = PartnerOrder;
+    bChanged = true;
+  }
+  return bChanged;
+}
+
+} // namespace
+
+char DxilPairHalfOps::ID = 0;
+
+FunctionPass *llvm::createDxilPairHalfOpsPass() {
+  return new DxilPairHalfOps();
+}
+
+INITIALIZE_PASS(DxilPairHalfOps, "hlsl-dxil-pair-half-ops",
+                "DXIL pair half operations", false, false)
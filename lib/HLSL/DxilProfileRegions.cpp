@@ -0,0 +1,348 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilProfileRegions.cpp                                                    //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides a pass to time [profile] regions with cycle counters into a UAV. //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilResource.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+#include "dxc/HLSL/DxilTypeSystem.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+// With -profile_regions, the front end brackets each [profile("name")] block
+// or function with calls to dx.profile.region(kind, index), where the index
+// numbers the names of the dx.profile.regions metadata. This pass replaces
+// the markers with cycle counter reads and accumulates, for each exit of a
+// region, the ticks since the nearest dominating entry to it into a
+// structured buffer with a single element:
+//
+//   struct ProfileRegion {
+//     uint ticksLow;  // total ticks spent in the region, as a 64-bit value
+//     uint ticksHigh;
+//     uint count;     // exits from the region
+//     uint maxTicks;  // longest single visit
+//   };
+//   struct ProfileRegions { ProfileRegion <name>; ... };
+//   RWStructuredBuffer<ProfileRegions> dx.profile.regions;
+//
+// The element type carries the region names, so that reflection describes
+// the layout of the buffer. Ticks are the low 32 bits of the counter, so a
+// single visit must take less than 2^32 ticks.
+
+namespace {
+
+// The space the buffer is bound in by default, next to the block counters.
+static const unsigned kDefaultRegionSpace = 1000;
+static const unsigned kDefaultRegionRegister = 1;
+static const char kRegionBufferName[] = "dx.profile.regions";
+static const char *kRegionFieldNames[] = {"ticksLow", "ticksHigh", "count",
+                                          "maxTicks"};
+static const unsigned kRegionFieldCount = array_lengthof(kRegionFieldNames);
+static const unsigned kRegionSize = kRegionFieldCount * 4;
+
+class DxilInsertProfileRegions : public ModulePass {
+  unsigned m_UAVSpace = kDefaultRegionSpace;
+  unsigned m_UAVRegister = kDefaultRegionRegister;
+  std::vector<std::string> m_Regions;
+  unsigned m_Unpaired = 0;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilInsertProfileRegions() : ModulePass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL insert profile regions";
+  }
+
+  void applyOptions(PassOptions O) override {
+    GetPassOptionUnsigned(O, "uav-space", &m_UAVSpace, m_UAVSpace);
+    GetPassOptionUnsigned(O, "uav-register", &m_UAVRegister, m_UAVRegister);
+  }
+
+  bool runOnModule(Module &M) override;
+
+  // Prints the byte offset of each region in the buffer element.
+  void print(raw_ostream &OS, const Module *) const override {
+    OS << "Profile regions in u" << m_UAVRegister << ", space " << m_UAVSpace
+       << "\n";
+    for (unsigned i = 0, e = m_Regions.size(); i < e; ++i)
+      OS << "region " << i << " at " << i * kRegionSize << ": " << m_Regions[i]
+         << "\n";
+    if (m_Unpaired)
+      OS << m_Unpaired << " region exits have no dominating entry\n";
+  }
+
+private:
+  StructType *CreateRegionsType(DxilModule &DM);
+  void InstrumentFunction(Function &F, ArrayRef<CallInst *> Markers,
+                          unsigned RegionsID, DxilModule &DM);
+};
+
+static bool IsMarker(Instruction *I, unsigned Kind, unsigned Index) {
+  CallInst *CI = dyn_cast<CallInst>(I);
+  if (!CI || !CI->getCalledFunction() ||
+      CI->getCalledFunction()->getName() !=
+          DxilMDHelper::kDxilProfileRegionMarkerName)
+    return false;
+  ConstantInt *K = dyn_cast<ConstantInt>(CI->getArgOperand(0));
+  ConstantInt *Idx = dyn_cast<ConstantInt>(CI->getArgOperand(1));
+  return K && Idx && K->getLimitedValue() == Kind &&
+         Idx->getLimitedValue() == Index;
+}
+
+// Finds the entry to the region that End leaves: the nearest dominating
+// entry with the same index, skipping over nested visits of the region.
+static CallInst *FindRegionBegin(CallInst *End, unsigned Index,
+                                 DominatorTree &DT) {
+  const unsigned BeginKind = (unsigned)DXIL::ProfileRegionMarker::Begin;
+  const unsigned EndKind = (unsigned)DXIL::ProfileRegionMarker::End;
+  unsigned Depth = 0;
+  Instruction *I = End;
+  for (DomTreeNode *Node = DT.getNode(End->getParent()); Node;
+       Node = Node->getIDom()) {
+    BasicBlock *BB = Node->getBlock();
+    if (!I)
+      I = BB->getTerminator();
+    for (; I; I = I->getPrevNode()) {
+      if (I == End)
+        continue;
+      if (IsMarker(I, EndKind, Index)) {
+        ++Depth;
+      } else if (IsMarker(I, BeginKind, Index)) {
+        if (Depth == 0)
+          return cast<CallInst>(I);
+        --Depth;
+      }
+    }
+  }
+  return nullptr;
+}
+
+StructType *DxilInsertProfileRegions::CreateRegionsType(DxilModule &DM) {
+  LLVMContext &Ctx = DM.GetCtx();
+  DxilTypeSystem &TypeSys = DM.GetTypeSystem();
+  Type *I32Ty = Type::getInt32Ty(Ctx);
+
+  SmallVector<Type *, 4> RegionFields(kRegionFieldCount, I32Ty);
+  StructType *RegionTy =
+      StructType::create(Ctx, RegionFields, "struct.ProfileRegion");
+  DxilStructAnnotation *RegionAnnotation =
+      TypeSys.AddStructAnnotation(RegionTy);
+  RegionAnnotation->SetCBufferSize(kRegionSize);
+  for (unsigned i = 0; i < kRegionFieldCount; ++i) {
+    DxilFieldAnnotation &Field = RegionAnnotation->GetFieldAnnotation(i);
+    Field.SetFieldName(kRegionFieldNames[i]);
+    Field.SetCBufferOffset(i * 4);
+    Field.SetCompType(CompType::Kind::U32);
+  }
+
+  unsigned NumRegions = m_Regions.size();
+  SmallVector<Type *, 8> ElementFields(NumRegions, RegionTy);
+  StructType *ElementTy =
+      StructType::create(Ctx, ElementFields, "struct.ProfileRegions");
+  DxilStructAnnotation *ElementAnnotation =
+      TypeSys.AddStructAnnotation(ElementTy);
+  ElementAnnotation->SetCBufferSize(NumRegions * kRegionSize);
+  for (unsigned i = 0; i < NumRegions; ++i) {
+    DxilFieldAnnotation &Field = ElementAnnotation->GetFieldAnnotation(i);
+    Field.SetFieldName(m_Regions[i]);
+    Field.SetCBufferOffset(i * kRegionSize);
+  }
+
+  // The resource type wraps the element type, as for an HLSL declaration.
+  StructType *BufferTy = StructType::create(
+      Ctx, {ElementTy}, "class.RWStructuredBuffer<ProfileRegions>");
+  DxilStructAnnotation *BufferAnnotation =
+      TypeSys.AddStructAnnotation(BufferTy);
+  BufferAnnotation->SetCBufferSize(NumRegions * kRegionSize);
+  BufferAnnotation->GetFieldAnnotation(0).SetFieldName("h");
+  return BufferTy;
+}
+
+void DxilInsertProfileRegions::InstrumentFunction(Function &F,
+                                                  ArrayRef<CallInst *> Markers,
+                                                  unsigned RegionsID,
+                                                  DxilModule &DM) {
+  LLVMContext &Ctx = DM.GetCtx();
+  OP *hlslOP = DM.GetOP();
+  Function *CreateHandle =
+      hlslOP->GetOpFunc(OP::OpCode::CreateHandle, Type::getVoidTy(Ctx));
+  Function *CycleCounter =
+      hlslOP->GetOpFunc(OP::OpCode::CycleCounterLegacy, Type::getVoidTy(Ctx));
+  Function *AtomicBinOp =
+      hlslOP->GetOpFunc(OP::OpCode::AtomicBinOp, Type::getInt32Ty(Ctx));
+  Value *CycleCounterArg =
+      hlslOP->GetU32Const((unsigned)OP::OpCode::CycleCounterLegacy);
+  Value *AtomicBinOpArg =
+      hlslOP->GetU32Const((unsigned)OP::OpCode::AtomicBinOp);
+  Value *AddArg = hlslOP->GetU32Const((unsigned)DXIL::AtomicBinOpCode::Add);
+  Value *UMaxArg = hlslOP->GetU32Const((unsigned)DXIL::AtomicBinOpCode::UMax);
+  Value *Element = hlslOP->GetU32Const(0);
+  Value *UndefI = UndefValue::get(Type::getInt32Ty(Ctx));
+
+  // The index is relative to the range; resource allocation adds the lower
+  // bound.
+  IRBuilder<> Builder(F.getEntryBlock().getFirstInsertionPt());
+  Value *HandleArgs[] = {
+      hlslOP->GetU32Const((unsigned)OP::OpCode::CreateHandle),
+      hlslOP->GetI8Const((char)DXIL::ResourceClass::UAV),
+      hlslOP->GetU32Const(RegionsID), hlslOP->GetU32Const(0),
+      hlslOP->GetI1Const(false)};
+  Value *Handle = Builder.CreateCall(CreateHandle, HandleArgs, "profile.regions");
+
+  auto ReadTicks = [&](Instruction *InsertPt) -> Value * {
+    Builder.SetInsertPoint(InsertPt);
+    Builder.SetCurrentDebugLocation(InsertPt->getDebugLoc());
+    Value *Counter = Builder.CreateCall(CycleCounter, {CycleCounterArg});
+    return Builder.CreateExtractValue(Counter, 0, "ticks");
+  };
+
+  // The entries are read first, so that every exit finds its start time.
+  const unsigned BeginKind = (unsigned)DXIL::ProfileRegionMarker::Begin;
+  DenseMap<CallInst *, Value *> StartTicks;
+  for (CallInst *Marker : Markers) {
+    if (cast<ConstantInt>(Marker->getArgOperand(0))->getLimitedValue() ==
+        BeginKind)
+      StartTicks[Marker] = ReadTicks(Marker);
+  }
+
+  DominatorTree DT;
+  DT.recalculate(F);
+  for (CallInst *Marker : Markers) {
+    if (StartTicks.count(Marker))
+      continue;
+    unsigned Index =
+        cast<ConstantInt>(Marker->getArgOperand(1))->getLimitedValue();
+    CallInst *Begin =
+        Index < m_Regions.size() ? FindRegionBegin(Marker, Index, DT) : nullptr;
+    if (!Begin) {
+      ++m_Unpaired;
+      continue;
+    }
+
+    Value *Ticks = Builder.CreateSub(ReadTicks(Marker), StartTicks[Begin]);
+    auto Atomic = [&](Value *Op, unsigned Field, Value *Val) -> Value * {
+      Value *Args[] = {AtomicBinOpArg, Handle, Op, Element,
+                       hlslOP->GetU32Const(Index * kRegionSize + Field * 4),
+                       UndefI, Val};
+      return Builder.CreateCall(AtomicBinOp, Args);
+    };
+    // The high word takes the carry out of the low word.
+    Value *Low = Atomic(AddArg, 0, Ticks);
+    Value *Carry = Builder.CreateICmpULT(Builder.CreateAdd(Low, Ticks), Low);
+    Atomic(AddArg, 1, Builder.CreateZExt(Carry, Ticks->getType()));
+    Atomic(AddArg, 2, hlslOP->GetU32Const(1));
+    Atomic(UMaxArg, 3, Ticks);
+  }
+
+  // Entries without a paired exit, as when the exits were unreachable,
+  // read the counter for nothing.
+  for (auto &Entry : StartTicks) {
+    Instruction *Ticks = cast<Instruction>(Entry.second);
+    if (!Ticks->use_empty())
+      continue;
+    Instruction *Counter = cast<Instruction>(Ticks->getOperand(0));
+    Ticks->eraseFromParent();
+    Counter->eraseFromParent();
+  }
+}
+
+bool DxilInsertProfileRegions::runOnModule(Module &M) {
+  NamedMDNode *pRegionsMD =
+      M.getNamedMetadata(DxilMDHelper::kDxilProfileRegionsMDName);
+  Function *Marker =
+      M.getFunction(DxilMDHelper::kDxilProfileRegionMarkerName);
+  if (!pRegionsMD && !Marker)
+    return false;
+
+  if (pRegionsMD) {
+    for (MDNode *Region : pRegionsMD->operands())
+      m_Regions.push_back(cast<MDString>(Region->getOperand(0))->getString());
+    pRegionsMD->eraseFromParent();
+  }
+
+  // Group the markers by function, keeping their order within each.
+  MapVector<Function *, SmallVector<CallInst *, 8>> FunctionMarkers;
+  if (Marker) {
+    for (User *U : Marker->users()) {
+      CallInst *CI = cast<CallInst>(U);
+      FunctionMarkers[CI->getParent()->getParent()].push_back(CI);
+    }
+  }
+
+  DxilModule &DM = M.GetOrCreateDxilModule();
+  // Library functions get their handles from the linker's bindings, so
+  // libraries only drop the markers.
+  bool Instrument = !DM.GetShaderModel()->IsLib() && !m_Regions.empty();
+  // All regions share one structured buffer element.
+  if (m_Regions.size() * kRegionSize > DXIL::kMaxStructBufferStride) {
+    M.getContext().emitError(
+        Twine("too many profile regions; at most ") +
+        Twine(DXIL::kMaxStructBufferStride / kRegionSize) + " are supported");
+    Instrument = false;
+  }
+
+  if (Instrument) {
+    StructType *BufferTy = CreateRegionsType(DM);
+    std::unique_ptr<DxilResource> pRegions = llvm::make_unique<DxilResource>();
+    pRegions->SetRW(true);
+    pRegions->SetKind(DxilResourceBase::Kind::StructuredBuffer);
+    pRegions->SetElementStride(m_Regions.size() * kRegionSize);
+    pRegions->SetGlobalSymbol(UndefValue::get(BufferTy->getPointerTo()));
+    pRegions->SetGlobalName(kRegionBufferName);
+    pRegions->SetSpaceID(m_UAVSpace);
+    pRegions->SetLowerBound(m_UAVRegister);
+    pRegions->SetRangeSize(1);
+    unsigned RegionsID = DM.AddUAV(std::move(pRegions));
+    DM.GetUAV(RegionsID).SetID(RegionsID);
+
+    for (auto &Entry : FunctionMarkers)
+      InstrumentFunction(*Entry.first, Entry.second, RegionsID, DM);
+  }
+
+  for (auto &Entry : FunctionMarkers) {
+    for (CallInst *CI : Entry.second)
+      CI->eraseFromParent();
+  }
+  if (Marker)
+    Marker->eraseFromParent();
+  return true;
+}
+
+} // namespace
+
+char DxilInsertProfileRegions::ID = 0;
+
+ModulePass *llvm::createDxilInsertProfileRegionsPass() {
+  return new DxilInsertProfileRegions();
+}
+
+INITIALIZE_PASS(DxilInsertProfileRegions, "hlsl-dxil-insert-profile-regions",
+                "DXIL insert profile regions", false, false)
@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilPruneUnreadOutputs.cpp                                                //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Removes outputs that the next pipeline stage does not read, along with    //
+// the computations feeding them, and repacks the output signature. For      //
+// pixel shaders, these are unbound render targets and disabled depth.       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilSignatureElement.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/Support/Global.h"
+#include "dxc/HLSL/DxilInstructions.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include <set>
+#include <string>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+class DxilPruneUnreadOutputs : public ModulePass {
+  // Upper-case semantic names with their index appended, e.g. "TEXCOORD1".
+  std::set<std::string> m_ConsumerInputs;
+  bool m_bHasConsumerInputs = false;
+  // Render targets the pipeline binds, one bit per SV_Target index.
+  unsigned m_RenderTargetMask = 0xFF;
+  bool m_bDepthWriteDisabled = false;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilPruneUnreadOutputs(unsigned RenderTargetMask = 0xFF,
+                                  bool bDepthWriteDisabled = false,
+                                  const char *pConsumerInputs = nullptr)
+      : ModulePass(ID), m_RenderTargetMask(RenderTargetMask),
+        m_bDepthWriteDisabled(bDepthWriteDisabled) {
+    if (pConsumerInputs != nullptr)
+      SetConsumerInputs(pConsumerInputs);
+  }
+
+  const char *getPassName() const override {
+    return "DXIL prune outputs unread by the next stage";
+  }
+
+  void applyOptions(PassOptions O) override;
+  bool runOnModule(Module &M) override;
+
+private:
+  void SetConsumerInputs(StringRef ConsumerInputs);
+  bool IsReadByConsumer(const DxilSignatureElement &SE) const;
+  bool IsReadByOutputMerger(const DxilSignatureElement &SE) const;
+};
+
+// Semantics read by the consumer stage, separated by '+'. An empty list
+// means the consumer reads no arbitrary semantics.
+void DxilPruneUnreadOutputs::SetConsumerInputs(StringRef ConsumerInputs) {
+  m_bHasConsumerInputs = true;
+  SmallVector<StringRef, 8> Semantics;
+  ConsumerInputs.split(Semantics, "+", -1, false);
+  for (StringRef Semantic : Semantics)
+    m_ConsumerInputs.insert(Semantic.trim().upper());
+}
+
+void DxilPruneUnreadOutputs::applyOptions(PassOptions O) {
+  for (const auto &option : O) {
+    if (0 == option.first.compare("consumer-inputs"))
+      SetConsumerInputs(option.second);
+  }
+  GetPassOptionUnsigned(O, "rt-mask", &m_RenderTargetMask, m_RenderTargetMask);
+  GetPassOptionBool(O, "depth-write-disabled", &m_bDepthWriteDisabled,
+                    m_bDepthWriteDisabled);
+}
+
+bool DxilPruneUnreadOutputs::IsReadByConsumer(
+    const DxilSignatureElement &SE) const {
+  // System values are consumed by fixed-function stages, so keep them.
+  if (!SE.IsArbitrary())
+    return true;
+
+  std::string Name = SE.GetSemanticName().upper();
+  for (unsigned Index : SE.GetSemanticIndexVec()) {
+    if (m_ConsumerInputs.count(Name + std::to_string(Index)))
+      return true;
+    // An unindexed semantic name is the same as index 0.
+    if (Index == 0 && m_ConsumerInputs.count(Name))
+      return true;
+  }
+  return false;
+}
+
+bool DxilPruneUnreadOutputs::IsReadByOutputMerger(
+    const DxilSignatureElement &SE) const {
+  switch (SE.GetKind()) {
+  case DXIL::SemanticKind::Target:
+    // Keep a target array while any of its targets is bound.
+    for (unsigned Index : SE.GetSemanticIndexVec()) {
+      if (m_RenderTargetMask & (1 << Index))
+        return true;
+    }
+    return false;
+  case DXIL::SemanticKind::Depth:
+  case DXIL::SemanticKind::DepthLessEqual:
+  case DXIL::SemanticKind::DepthGreaterEqual:
+    return !m_bDepthWriteDisabled;
+  default:
+    return true;
+  }
+}
+
+bool DxilPruneUnreadOutputs::runOnModule(Module &M) {
+  DxilModule &DM = M.GetOrCreateDxilModule();
+  const ShaderModel *pSM = DM.GetShaderModel();
+  // Only stages that feed the next stage through a single output signature,
+  // and pixel shaders, which feed the output merger.
+  bool bIsPS = pSM->IsPS();
+  if (bIsPS) {
+    if (m_RenderTargetMask == 0xFF && !m_bDepthWriteDisabled)
+      return false;
+  } else if (!m_bHasConsumerInputs || (!pSM->IsVS() && !pSM->IsDS())) {
+    return false;
+  }
+
+  DxilSignature &OutputSig = DM.GetOutputSignature();
+  const unsigned NumElements = OutputSig.GetElements().size();
+  std::vector<bool> bDelete(NumElements, false);
+  std::vector<unsigned> NewIDs(NumElements, 0);
+  unsigned NewCount = 0;
+  bool bAnyDeleted = false;
+  for (unsigned i = 0; i < NumElements; ++i) {
+    const DxilSignatureElement &SE = OutputSig.GetElement(i);
+    if (bIsPS ? IsReadByOutputMerger(SE) : IsReadByConsumer(SE)) {
+      NewIDs[i] = NewCount++;
+    } else {
+      bDelete[i] = true;
+      bAnyDeleted = true;
+    }
+  }
+  if (!bAnyDeleted)
+    return false;
+
+  // Drop stores to deleted outputs, with whatever only fed them, and
+  // renumber stores to the outputs that are left.
+  OP *hlslOP = DM.GetOP();
+  for (Function *F : hlslOP->GetOpFuncList(DXIL::OpCode::StoreOutput)) {
+    if (F == nullptr)
+      continue;
+    for (auto U = F->user_begin(), E = F->user_end(); U != E;) {
+      CallInst *CI = cast<CallInst>(*(U++));
+      DxilInst_StoreOutput Store(CI);
+      unsigned ID = cast<ConstantInt>(Store.get_outputSigId())->getLimitedValue();
+      if (bDelete[ID]) {
+        Value *V = Store.get_value();
+        CI->eraseFromParent();
+        RecursivelyDeleteTriviallyDeadInstructions(V);
+      } else if (NewIDs[ID] != ID) {
+        CI->setArgOperand(DXIL::OperandIndex::kStoreOutputIDOpIdx,
+                          hlslOP->GetU32Const(NewIDs[ID]));
+      }
+    }
+  }
+
+  OutputSig.DeleteElements(bDelete);
+  OutputSig.PackElements(pSM->GetDefaultPackingStrategy());
+
+  DM.GetViewIdState().Compute();
+  DM.EmitDxilMetadata();
+  return true;
+}
+
+}
+
+char DxilPruneUnreadOutputs::ID = 0;
+
+ModulePass *llvm::createDxilPruneUnreadOutputsPass(unsigned RenderTargetMask,
+                                                   bool bDepthWriteDisabled,
+                                                   const char *pConsumerInputs) {
+  return new DxilPruneUnreadOutputs(RenderTargetMask, bDepthWriteDisabled,
+                                    pConsumerInputs);
+}
+
+INITIALIZE_PASS(DxilPruneUnreadOutputs,
+                "hlsl-dxil-prune-unread-outputs",
+                "DXIL prune outputs unread by the next stage", false, false)
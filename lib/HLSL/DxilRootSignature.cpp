@@ -10,21 +10,25 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "dxc/HLSL/DxilConstants.h"
+#include "dxc/HLSL/DxilContainer.h"
 #include "dxc/HLSL/DxilRootSignature.h"
 #include "dxc/HLSL/DxilPipelineStateValidation.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/LockTracing.h"
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/dxcapi.h"
 
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 
 #include <string>
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 #include <vector>
-#include <set>
 
 using namespace llvm;
 using std::string;
@@ -98,6 +102,88 @@ void RootSignatureHandle::LoadSerialized(const uint8_t *pData,
   IFT(DxcCreateBlobOnHeapCopy(pData, length, &m_pSerialized));
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Root signature cache.
+
+namespace {
+// Root signatures come from a handful of shared definitions, so the cache
+// stays small; past the limit, new root signatures are simply not cached.
+static const size_t kMaxCachedRootSignatures = 1024;
+
+class RootSignatureCache {
+public:
+  static RootSignatureCache &Get() {
+    static RootSignatureCache cache;
+    return cache;
+  }
+
+  bool Lookup(const std::string &key, IDxcBlob **ppSerialized) {
+    TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+      return false;
+    *ppSerialized = it->second;
+    (*ppSerialized)->AddRef();
+    return true;
+  }
+  void Store(std::string &&key, IDxcBlob *pSerialized) {
+    TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+    if (m_entries.size() < kMaxCachedRootSignatures)
+      m_entries.emplace(std::move(key), pSerialized);
+  }
+  void Clear() {
+    TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+    m_entries.clear();
+  }
+
+private:
+  static const LockSite kLockSite;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, CComPtr<IDxcBlob>> m_entries;
+};
+
+const LockSite RootSignatureCache::kLockSite = {
+    "lock.rootSignatureCache.contended", "lock.rootSignatureCache.waitUs"};
+
+std::string GetRootSignatureCacheKey(DxilRootSignatureVersion Version,
+                                     const char *pText, size_t TextLength) {
+  std::string key(1, (char)Version);
+  key.append(pText, TextLength);
+  return key;
+}
+} // namespace
+
+_Use_decl_annotations_
+bool LookupCachedRootSignature(DxilRootSignatureVersion Version,
+                               const char *pText, size_t TextLength,
+                               IDxcBlob **ppSerialized) {
+  *ppSerialized = nullptr;
+  return RootSignatureCache::Get().Lookup(
+      GetRootSignatureCacheKey(Version, pText, TextLength), ppSerialized);
+}
+
+_Use_decl_annotations_
+void StoreCachedRootSignature(DxilRootSignatureVersion Version,
+                              const char *pText, size_t TextLength,
+                              IDxcBlob *pSerialized) {
+  RootSignatureCache::Get().Store(
+      GetRootSignatureCacheKey(Version, pText, TextLength), pSerialized);
+}
+
+void ClearRootSignatureCache() { RootSignatureCache::Get().Clear(); }
+
+_Use_decl_annotations_
+void ComputeRootSignatureHash(const void *pData, uint32_t Size,
+                              DxilContainerHash *pHash) {
+  llvm::MD5 md5;
+  md5.update(llvm::ArrayRef<uint8_t>((const uint8_t *)pData, Size));
+  llvm::MD5::MD5Result md5Result;
+  md5.final(md5Result);
+  static_assert(sizeof(md5Result) == sizeof(pHash->Digest),
+                "else digest sizes differ");
+  memcpy(pHash->Digest, md5Result, sizeof(pHash->Digest));
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // Simple serializer.
 
@@ -242,29 +328,6 @@ unsigned SimpleSerializer::GetSize() {
   return ((m_cbSegments + 3) >> 2) * 4;
 }
 
-//////////////////////////////////////////////////////////////////////////////
-// Interval helper.
-
-template <typename T>
-class CIntervalCollection {
-private:
-  std::set<T> m_set;
-public:
-  const T* FindIntersectingInterval(const T &I) {
-    auto it = m_set.find(I);
-    if (it != m_set.end())
-      return &*it;
-    return nullptr;
-  }
-  void Insert(const T& value) {
-    auto result = m_set.insert(value);
-    UNREFERENCED_PARAMETER(result);
-#if DBG
-    DXASSERT(result.second, "otherwise interval collides with existing in collection");
-#endif
-  }
-};
-
 //////////////////////////////////////////////////////////////////////////////
 // Verifier classes.
 
@@ -294,6 +357,14 @@ public:
                     const void *pPSVData,
                     uint32_t PSVSize,
                     DiagnosticPrinter &DiagPrinter);
+  void VerifyShader(DxilShaderVisibility VisType,
+                    const DxilPipelineStateValidation &PSV,
+                    DiagnosticPrinter &DiagPrinter);
+
+  // Why the last shader verified does not fit the root signature.
+  DxilRootSignatureCompatibility GetShaderIncompatibility() const {
+    return m_ShaderIncompatibility;
+  }
 
   typedef enum NODE_TYPE {
     DESCRIPTOR_TABLE_ENTRY,
@@ -310,37 +381,39 @@ private:
 
   struct RegisterRange {
     NODE_TYPE nt;
+    DxilShaderVisibility vis;
     unsigned space;
     unsigned lb;    // inclusive lower bound
     unsigned ub;    // inclusive upper bound
     unsigned iRP;
     unsigned iDTS;
+    unsigned order; // position in the root signature
     // Sort by space, then lower bound.
     bool operator<(const RegisterRange& other) const {
       return space < other.space ||
-        (space == other.space && ub < other.lb);
-    }
-    // Like a regular -1,0,1 comparison, but 0 indicates overlap.
-    int overlap(const RegisterRange& other) const {
-      if (space < other.space) return -1;
-      if (space > other.space) return 1;
-      if (ub < other.lb) return -1;
-      if (lb > other.ub) return 1;
-      return 0;
+        (space == other.space && lb < other.lb);
     }
     // Check containment.
     bool contains(const RegisterRange& other) const {
       return (space == other.space) && (lb <= other.lb && other.ub <= ub);
     }
   };
-  typedef CIntervalCollection<RegisterRange> RegisterRanges;
+  // Ranges of one visibility and descriptor type, sorted by VerifyRootSignature
+  // once they have all been added, and free of overlaps once it succeeds.
+  typedef std::vector<RegisterRange> RegisterRanges;
 
   void AddRegisterRange(unsigned iRTS, NODE_TYPE nt, unsigned iDTS,
                         DxilDescriptorRangeType DescType,
                         DxilShaderVisibility VisType,
                         unsigned NumRegisters, unsigned BaseRegister,
                         unsigned RegisterSpace, DiagnosticPrinter &DiagPrinter);
+  void VerifyRegisterRanges(DiagnosticPrinter &DiagPrinter);
+  void ReportOverlap(DxilDescriptorRangeType DescType,
+                     const RegisterRange &test, const RegisterRange &node,
+                     DiagnosticPrinter &DiagPrinter);
 
+  static const RegisterRange *FindContainingRange(const RegisterRanges &Ranges,
+                                                  const RegisterRange &RR);
   const RegisterRange *FindCoveringInterval(DxilDescriptorRangeType RangeType,
                                             DxilShaderVisibility VisType,
                                             unsigned Num,
@@ -353,6 +426,8 @@ private:
   }
 
   RegisterRanges RangeKinds[kMaxVisType + 1][kMaxDescType + 1];
+  unsigned m_NumRanges;
+  DxilRootSignatureCompatibility m_ShaderIncompatibility;
   bool m_bAllowReservedRegisterSpace;
   DxilRootSignatureFlags m_RootSignatureFlags;
 };
@@ -434,6 +509,8 @@ void DescriptorTableVerifier::Verify(const DxilDescriptorRange1 *pRanges,
 
 RootSignatureVerifier::RootSignatureVerifier() {
   m_RootSignatureFlags = DxilRootSignatureFlags::None;
+  m_NumRanges = 0;
+  m_ShaderIncompatibility = DxilRootSignatureCompatibility::Compatible;
   m_bAllowReservedRegisterSpace = false;
 }
 
@@ -475,8 +552,10 @@ void RootSignatureVerifier::AddRegisterRange(unsigned iRP,
   interval.lb = BaseRegister;
   interval.ub = (NumRegisters != UINT_MAX) ? BaseRegister + NumRegisters - 1 : UINT_MAX;
   interval.nt = nt;
+  interval.vis = VisType;
   interval.iDTS = iDTS;
   interval.iRP = iRP;
+  interval.order = m_NumRanges++;
 
   if (!m_bAllowReservedRegisterSpace &&
        (RegisterSpace >= DxilSystemReservedRegisterSpaceValuesStart) &&
@@ -499,75 +578,126 @@ void RootSignatureVerifier::AddRegisterRange(unsigned iRP,
     }
   }
 
-  const RegisterRange *pNode = nullptr;
-  DxilShaderVisibility NodeVis = VisType;
-  if (VisType == DxilShaderVisibility::All) {
-    // Check for overlap with each visibility type.
-    for (unsigned iVT = kMinVisType; iVT <= kMaxVisType; iVT++) {
-      pNode = GetRanges((DxilShaderVisibility)iVT, DescType).FindIntersectingInterval(interval);
-      if (pNode != nullptr)
-        break;
-    }
-  } else {
-    // Check for overlap with the same visibility.
-    pNode = GetRanges(VisType, DescType).FindIntersectingInterval(interval);
-
-    // Check for overlap with ALL visibility.
-    if (pNode == nullptr) {
-      pNode = GetRanges(DxilShaderVisibility::All, DescType).FindIntersectingInterval(interval);
-      NodeVis = DxilShaderVisibility::All;
+  // Overlaps are found once all ranges have been added.
+  GetRanges(VisType, DescType).push_back(interval);
+}
+
+void RootSignatureVerifier::VerifyRegisterRanges(DiagnosticPrinter &DiagPrinter) {
+  for (auto &VisRanges : RangeKinds)
+    for (RegisterRanges &Ranges : VisRanges)
+      std::sort(Ranges.begin(), Ranges.end());
+
+  // A range may not overlap a range of the same visibility, or any range if
+  // its visibility is ALL. Walk each visibility's ranges merged with the ALL
+  // ones in order, tracking the range reaching furthest in the space so far;
+  // a range starting before that one ends overlaps it. Of the overlaps found,
+  // report the one completed earliest in the root signature.
+  const RegisterRange *pTest = nullptr, *pNode = nullptr;
+  DxilDescriptorRangeType TestDescType = DxilDescriptorRangeType::SRV;
+  for (unsigned iDT = kMinDescType; iDT <= kMaxDescType; iDT++) {
+    const RegisterRanges &AllRanges =
+        RangeKinds[(unsigned)DxilShaderVisibility::All][iDT];
+    for (unsigned iVT = kMinVisType + 1; iVT <= kMaxVisType; iVT++) {
+      const RegisterRanges &VisRanges = RangeKinds[iVT][iDT];
+      auto itAll = AllRanges.begin(), itVis = VisRanges.begin();
+      const RegisterRange *pFurthest = nullptr;
+      while (itAll != AllRanges.end() || itVis != VisRanges.end()) {
+        const RegisterRange *pCur;
+        if (itVis == VisRanges.end() ||
+            (itAll != AllRanges.end() && !(*itVis < *itAll)))
+          pCur = &*itAll++;
+        else
+          pCur = &*itVis++;
+        if (pFurthest == nullptr || pFurthest->space != pCur->space) {
+          pFurthest = pCur;
+          continue;
+        }
+        if (pCur->lb <= pFurthest->ub) {
+          const RegisterRange *pLater =
+              pCur->order > pFurthest->order ? pCur : pFurthest;
+          if (pTest == nullptr || pLater->order < pTest->order) {
+            pTest = pLater;
+            pNode = pLater == pCur ? pFurthest : pCur;
+            TestDescType = (DxilDescriptorRangeType)iDT;
+          }
+        }
+        if (pCur->ub > pFurthest->ub)
+          pFurthest = pCur;
+      }
     }
   }
 
-  if (pNode != nullptr) {
-    const int strSize = 132;
-    char testString[strSize];
-    char nodeString[strSize];
-    switch (nt) {
-    case DESCRIPTOR_TABLE_ENTRY:
-      StringCchPrintfA(testString, strSize, "(root parameter [%u], visibility %s, descriptor table slot [%u])",
-        iRP, VisTypeString(VisType), iDTS);
-      break;
-    case ROOT_DESCRIPTOR:
-    case ROOT_CONSTANT:
-      StringCchPrintfA(testString, strSize, "(root parameter [%u], visibility %s)",
-        iRP, VisTypeString(VisType));
-      break;
-    case STATIC_SAMPLER:
-      StringCchPrintfA(testString, strSize, "(static sampler [%u], visibility %s)",
-        iRP, VisTypeString(VisType));
-      break;
-    default:
-      DXASSERT_NOMSG(false);
-      break;
-    }
+  if (pTest != nullptr)
+    ReportOverlap(TestDescType, *pTest, *pNode, DiagPrinter);
+}
 
-    switch (pNode->nt)
-    {
-    case DESCRIPTOR_TABLE_ENTRY:
-      StringCchPrintfA(nodeString, strSize, "(root parameter[%u], visibility %s, descriptor table slot [%u])",
-        pNode->iRP, VisTypeString(NodeVis), pNode->iDTS);
-      break;
-    case ROOT_DESCRIPTOR:
-    case ROOT_CONSTANT:
-      StringCchPrintfA(nodeString, strSize, "(root parameter [%u], visibility %s)",
-        pNode->iRP, VisTypeString(NodeVis));
-      break;
-    case STATIC_SAMPLER:
-      StringCchPrintfA(nodeString, strSize, "(static sampler [%u], visibility %s)",
-        pNode->iRP, VisTypeString(NodeVis));
-      break;
-    default:
-      DXASSERT_NOMSG(false);
-      break;
-    }
-    EAT(DiagPrinter << "Shader register range of type " << RangeTypeString(DescType)
-                    << " " << testString << " overlaps with another "
-                    << "shader register range " << nodeString << ".\n");
+void RootSignatureVerifier::ReportOverlap(DxilDescriptorRangeType DescType,
+                                          const RegisterRange &test,
+                                          const RegisterRange &node,
+                                          DiagnosticPrinter &DiagPrinter) {
+  const RegisterRange *pNode = &node;
+  unsigned iRP = test.iRP;
+  unsigned iDTS = test.iDTS;
+  NODE_TYPE nt = test.nt;
+  DxilShaderVisibility VisType = test.vis;
+  DxilShaderVisibility NodeVis = node.vis;
+
+  const int strSize = 132;
+  char testString[strSize];
+  char nodeString[strSize];
+  switch (nt) {
+  case DESCRIPTOR_TABLE_ENTRY:
+    StringCchPrintfA(testString, strSize, "(root parameter [%u], visibility %s, descriptor table slot [%u])",
+      iRP, VisTypeString(VisType), iDTS);
+    break;
+  case ROOT_DESCRIPTOR:
+  case ROOT_CONSTANT:
+    StringCchPrintfA(testString, strSize, "(root parameter [%u], visibility %s)",
+      iRP, VisTypeString(VisType));
+    break;
+  case STATIC_SAMPLER:
+    StringCchPrintfA(testString, strSize, "(static sampler [%u], visibility %s)",
+      iRP, VisTypeString(VisType));
+    break;
+  default:
+    DXASSERT_NOMSG(false);
+    break;
+  }
+
+  switch (pNode->nt)
+  {
+  case DESCRIPTOR_TABLE_ENTRY:
+    StringCchPrintfA(nodeString, strSize, "(root parameter[%u], visibility %s, descriptor table slot [%u])",
+      pNode->iRP, VisTypeString(NodeVis), pNode->iDTS);
+    break;
+  case ROOT_DESCRIPTOR:
+  case ROOT_CONSTANT:
+    StringCchPrintfA(nodeString, strSize, "(root parameter [%u], visibility %s)",
+      pNode->iRP, VisTypeString(NodeVis));
+    break;
+  case STATIC_SAMPLER:
+    StringCchPrintfA(nodeString, strSize, "(static sampler [%u], visibility %s)",
+      pNode->iRP, VisTypeString(NodeVis));
+    break;
+  default:
+    DXASSERT_NOMSG(false);
+    break;
   }
+  EAT(DiagPrinter << "Shader register range of type " << RangeTypeString(DescType)
+                  << " " << testString << " overlaps with another "
+                  << "shader register range " << nodeString << ".\n");
+}
 
-  // Insert node.
-  GetRanges(VisType, DescType).Insert(interval);
+const RootSignatureVerifier::RegisterRange *
+RootSignatureVerifier::FindContainingRange(const RegisterRanges &Ranges,
+                                           const RegisterRange &RR) {
+  // The ranges are sorted and disjoint, so only the last one starting at or
+  // before RR can contain it.
+  auto it = std::upper_bound(Ranges.begin(), Ranges.end(), RR);
+  if (it == Ranges.begin())
+    return nullptr;
+  --it;
+  return it->contains(RR) ? &*it : nullptr;
 }
 
 const RootSignatureVerifier::RegisterRange *
@@ -580,12 +710,10 @@ RootSignatureVerifier::FindCoveringInterval(DxilDescriptorRangeType RangeType,
   RR.space = Space;
   RR.lb = LB;
   RR.ub = LB + Num - 1;
-  const RootSignatureVerifier::RegisterRange *pRange = GetRanges(DxilShaderVisibility::All, RangeType).FindIntersectingInterval(RR);
+  const RootSignatureVerifier::RegisterRange *pRange =
+      FindContainingRange(GetRanges(DxilShaderVisibility::All, RangeType), RR);
   if (!pRange && VisType != DxilShaderVisibility::All) {
-    pRange = GetRanges(VisType, RangeType).FindIntersectingInterval(RR);
-  }
-  if (pRange && !pRange->contains(RR)) {
-    pRange = nullptr;
+    pRange = FindContainingRange(GetRanges(VisType, RangeType), RR);
   }
   return pRange;
 }
@@ -759,6 +887,8 @@ void RootSignatureVerifier::VerifyRootSignature(
                      DxilDescriptorRangeType::Sampler, Visibility, 1,
                      pSS->ShaderRegister, pSS->RegisterSpace, DiagPrinter);
   }
+
+  VerifyRegisterRanges(DiagPrinter);
 }
 
 void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
@@ -766,8 +896,17 @@ void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
                                          uint32_t PSVSize,
                                          DiagnosticPrinter &DiagPrinter) {
   DxilPipelineStateValidation PSV;
-  IFTBOOL(PSV.InitFromPSV0(pPSVData, PSVSize), E_INVALIDARG);
+  if (!PSV.InitFromPSV0(pPSVData, PSVSize)) {
+    m_ShaderIncompatibility = DxilRootSignatureCompatibility::InvalidShader;
+    IFT(E_INVALIDARG);
+  }
+  VerifyShader(VisType, PSV, DiagPrinter);
+}
 
+void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
+                                         const DxilPipelineStateValidation &PSV,
+                                         DiagnosticPrinter &DiagPrinter) {
+  m_ShaderIncompatibility = DxilRootSignatureCompatibility::UnboundResource;
   bool bShaderDeniedByRootSig = false;
   switch (VisType) {
   case DxilShaderVisibility::Vertex:
@@ -828,6 +967,8 @@ void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
       auto pCoveringRange = FindCoveringInterval(DxilDescriptorRangeType::SRV, VisType, Num, LB, Space);
       if (pCoveringRange) {
         if(pCoveringRange->nt == ROOT_DESCRIPTOR && ResType == PSVResourceType::SRVTyped) {
+          m_ShaderIncompatibility =
+              DxilRootSignatureCompatibility::RootDescriptorResourceType;
           EAT(DiagPrinter << "A Shader is declaring a resource object as a texture using "
                           << "a register mapped to a root descriptor SRV (RegisterSpace=" << Space
                           << ", ShaderRegister=" << LB << ").  "
@@ -851,12 +992,16 @@ void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
       if (pCoveringRange) {
         if (pCoveringRange->nt == ROOT_DESCRIPTOR) {
           if (ResType == PSVResourceType::UAVTyped) {
+            m_ShaderIncompatibility =
+                DxilRootSignatureCompatibility::RootDescriptorResourceType;
             EAT(DiagPrinter << "A shader is declaring a typed UAV using a register mapped "
                             << "to a root descriptor UAV (RegisterSpace=" << Space 
                             << ", ShaderRegister=" << LB << ").  "
                             << "SRV or UAV root descriptors can only be Raw or Structured buffers.\n");
           }
           if (ResType == PSVResourceType::UAVStructuredWithCounter) {
+            m_ShaderIncompatibility =
+                DxilRootSignatureCompatibility::RootDescriptorResourceType;
             EAT(DiagPrinter << "A Shader is declaring a structured UAV with counter using "
                             << "a register mapped to a root descriptor UAV (RegisterSpace=" << Space
                             << ", ShaderRegister=" << LB << ").  "
@@ -889,9 +1034,11 @@ void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
   }
 
   if (bShaderHasRootBindings && bShaderDeniedByRootSig) {
+    m_ShaderIncompatibility = DxilRootSignatureCompatibility::DeniedShaderStage;
     EAT(DiagPrinter << "Shader has root bindings but root signature uses a DENY flag "
                     << "to disallow root binding access to the shader stage.\n");
   }
+  m_ShaderIncompatibility = DxilRootSignatureCompatibility::Compatible;
 }
 
 BOOL isNaN(const float &a) {
@@ -1676,4 +1823,49 @@ bool VerifyRootSignatureWithShaderPSV(const DxilVersionedRootSignatureDesc *pDes
   return true;
 }
 
+_Use_decl_annotations_
+void VerifyRootSignaturesWithShaderPSVs(
+    unsigned NumRootSignatures,
+    const DxilVersionedRootSignatureDesc *const *ppDescs,
+    unsigned NumShaders, const DxilShaderPSV *pShaders,
+    DxilRootSignatureCompatibility *pResults) {
+  // Reasons are all that is reported, so the diagnostics are dropped.
+  llvm::raw_null_ostream NullStream;
+  DiagnosticPrinterRawOStream DiagPrinter(NullStream);
+
+  std::vector<DxilPipelineStateValidation> PSVs(NumShaders);
+  std::vector<bool> PSVValid(NumShaders);
+  for (unsigned iShader = 0; iShader < NumShaders; iShader++) {
+    PSVValid[iShader] = pShaders[iShader].pPSVData != nullptr &&
+                        PSVs[iShader].InitFromPSV0(pShaders[iShader].pPSVData,
+                                                   pShaders[iShader].PSVSize);
+  }
+
+  for (unsigned iRS = 0; iRS < NumRootSignatures; iRS++) {
+    DxilRootSignatureCompatibility *pRow = pResults + iRS * NumShaders;
+    RootSignatureVerifier RSV;
+    try {
+      IFTARG(ppDescs[iRS]);
+      RSV.VerifyRootSignature(ppDescs[iRS], DiagPrinter);
+    } catch (...) {
+      std::fill(pRow, pRow + NumShaders,
+                DxilRootSignatureCompatibility::InvalidRootSignature);
+      continue;
+    }
+
+    for (unsigned iShader = 0; iShader < NumShaders; iShader++) {
+      if (!PSVValid[iShader]) {
+        pRow[iShader] = DxilRootSignatureCompatibility::InvalidShader;
+        continue;
+      }
+      try {
+        RSV.VerifyShader(GetVisibilityType(pShaders[iShader].ShaderKind),
+                         PSVs[iShader], DiagPrinter);
+      } catch (...) {
+      }
+      pRow[iShader] = RSV.GetShaderIncompatibility();
+    }
+  }
+}
+
 } // namespace hlsl
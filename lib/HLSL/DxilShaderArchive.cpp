@@ -0,0 +1,364 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilShaderArchive.cpp                                                     //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides support for writing and reading archives of DXIL containers.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/MD5.h"
+#include "dxc/HLSL/DxilShaderArchive.h"
+#include "dxc/Support/Global.h"
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/FileIOHelper.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+uint32_t AlignTo4(uint32_t value) { return (value + 3) & ~3u; }
+
+uint32_t GetBucketCount(uint32_t containerCount) {
+  uint32_t bucketCount = 1;
+  while (bucketCount <= containerCount * 2)
+    bucketCount <<= 1;
+  return bucketCount;
+}
+
+uint32_t GetFirstBucket(const DxilContainerHash &Key, uint32_t bucketCount) {
+  uint32_t value;
+  memcpy(&value, Key.Digest, sizeof(value));
+  return value & (bucketCount - 1);
+}
+
+std::string GetKeyString(const DxilContainerHash &Key) {
+  return std::string((const char *)Key.Digest, sizeof(Key.Digest));
+}
+
+const size_t kContainerPrologSize = sizeof(DxilContainerHeader);
+}
+
+void hlsl::GetDxilShaderArchiveKey(const DxilContainerHeader *pHeader,
+                                   DxilContainerHash *pKey) {
+  ComputeDxilContainerDigest(pHeader, DxilContainerDigestKind::MD5, pKey);
+}
+
+class DxilShaderArchiveWriter_impl : public DxilShaderArchiveWriter {
+private:
+  struct Part {
+    uint32_t FourCC;
+    std::vector<char> Data;
+  };
+
+  std::vector<DxilShaderArchiveContainer> m_Containers;
+  std::vector<uint32_t> m_PartRefs;
+  std::vector<Part> m_Parts;
+  // Keyed by container key, and by part FourCC and MD5 digest.
+  std::unordered_map<std::string, uint32_t> m_ContainerMap;
+  std::unordered_map<std::string, uint32_t> m_PartMap;
+  uint64_t m_DataSize;
+
+  static bool IsArchivableLayout(const DxilContainerHeader *pHeader) {
+    uint64_t expected = kContainerPrologSize + GetOffsetTableSize(pHeader->PartCount);
+    const uint32_t *pPartOffsetTable =
+        reinterpret_cast<const uint32_t *>(pHeader + 1);
+    for (uint32_t i = 0; i < pHeader->PartCount; ++i) {
+      if (pPartOffsetTable[i] != expected)
+        return false;
+      expected += sizeof(DxilPartHeader) +
+                  GetDxilContainerPart(pHeader, i)->PartSize;
+    }
+    return expected == pHeader->ContainerSizeInBytes;
+  }
+
+  uint32_t AddPart(const DxilPartHeader *pPart) {
+    const uint8_t *pData = (const uint8_t *)GetDxilPartData(pPart);
+    MD5 md5;
+    md5.update(ArrayRef<uint8_t>(pData, pPart->PartSize));
+    MD5::MD5Result md5Result;
+    md5.final(md5Result);
+    std::string partKey((const char *)&pPart->PartFourCC,
+                        sizeof(pPart->PartFourCC));
+    partKey.append((const char *)md5Result, sizeof(md5Result));
+
+    auto it = m_PartMap.find(partKey);
+    if (it != m_PartMap.end()) {
+      const Part &existing = m_Parts[it->second];
+      if (existing.Data.size() == pPart->PartSize &&
+          0 == memcmp(existing.Data.data(), pData, pPart->PartSize))
+        return it->second;
+    }
+    uint32_t index = (uint32_t)m_Parts.size();
+    m_Parts.emplace_back();
+    m_Parts.back().FourCC = pPart->PartFourCC;
+    m_Parts.back().Data.assign((const char *)pData,
+                               (const char *)pData + pPart->PartSize);
+    m_DataSize += AlignTo4(pPart->PartSize);
+    if (it == m_PartMap.end())
+      m_PartMap[partKey] = index;
+    return index;
+  }
+
+  uint64_t GetTablesSize(uint64_t containerCount, uint64_t partCount,
+                         uint64_t partRefCount) const {
+    return sizeof(DxilShaderArchiveHeader) +
+           containerCount * sizeof(DxilShaderArchiveContainer) +
+           GetBucketCount((uint32_t)containerCount) * sizeof(uint32_t) +
+           partCount * sizeof(DxilShaderArchivePart) +
+           partRefCount * sizeof(uint32_t);
+  }
+
+public:
+  DxilShaderArchiveWriter_impl() : m_DataSize(0) {}
+
+  __override bool AddContainer(const DxilContainerHeader *pHeader,
+                               size_t length, DxilContainerHash *pKey) {
+    DXASSERT_NOMSG(pKey != nullptr);
+    if (!IsValidDxilContainer(pHeader, length) || !IsArchivableLayout(pHeader))
+      return false;
+    GetDxilShaderArchiveKey(pHeader, pKey);
+    std::string keyString = GetKeyString(*pKey);
+    if (m_ContainerMap.count(keyString))
+      return true;
+
+    // Bound the archive by what its 32-bit offsets can address, assuming
+    // every part of this container is new.
+    uint64_t newSize =
+        GetTablesSize(m_Containers.size() + 1,
+                      m_Parts.size() + pHeader->PartCount,
+                      m_PartRefs.size() + pHeader->PartCount) +
+        m_DataSize + pHeader->ContainerSizeInBytes + 3 * pHeader->PartCount;
+    if (newSize > UINT32_MAX)
+      return false;
+
+    DxilShaderArchiveContainer container;
+    container.Key = *pKey;
+    container.Hash = pHeader->Hash;
+    container.Version = pHeader->Version;
+    container.ContainerSizeInBytes = pHeader->ContainerSizeInBytes;
+    container.FirstPartRef = (uint32_t)m_PartRefs.size();
+    container.PartCount = pHeader->PartCount;
+    for (DxilPartIterator it = begin(pHeader), E = end(pHeader); it != E; ++it)
+      m_PartRefs.push_back(AddPart(*it));
+    m_ContainerMap[keyString] = (uint32_t)m_Containers.size();
+    m_Containers.push_back(container);
+    return true;
+  }
+
+  __override uint32_t GetContainerCount() const {
+    return (uint32_t)m_Containers.size();
+  }
+
+  __override uint32_t GetUniquePartCount() const {
+    return (uint32_t)m_Parts.size();
+  }
+
+  __override uint32_t size() const {
+    return (uint32_t)(GetTablesSize(m_Containers.size(), m_Parts.size(),
+                                    m_PartRefs.size()) +
+                      m_DataSize);
+  }
+
+  __override void write(AbstractMemoryStream *pStream) {
+    DxilShaderArchiveHeader header;
+    header.HeaderFourCC = DxilShaderArchiveFourCC;
+    header.MajorVersion = DxilShaderArchiveVersionMajor;
+    header.MinorVersion = DxilShaderArchiveVersionMinor;
+    header.ArchiveSizeInBytes = size();
+    header.ContainerCount = (uint32_t)m_Containers.size();
+    header.BucketCount = GetBucketCount(header.ContainerCount);
+    header.PartCount = (uint32_t)m_Parts.size();
+    header.PartRefCount = (uint32_t)m_PartRefs.size();
+    header.ContainerTableOffset = sizeof(DxilShaderArchiveHeader);
+    header.BucketTableOffset = header.ContainerTableOffset +
+        header.ContainerCount * sizeof(DxilShaderArchiveContainer);
+    header.PartTableOffset =
+        header.BucketTableOffset + header.BucketCount * sizeof(uint32_t);
+    header.PartRefTableOffset = header.PartTableOffset +
+        header.PartCount * sizeof(DxilShaderArchivePart);
+    IFT(pStream->Reserve(header.ArchiveSizeInBytes));
+    size_t archiveStart = (size_t)pStream->GetPosition();
+    IFT(WriteStreamValue(pStream, header));
+
+    ULONG cbWritten;
+    if (!m_Containers.empty()) {
+      IFT(pStream->Write(m_Containers.data(),
+                         m_Containers.size() * sizeof(DxilShaderArchiveContainer),
+                         &cbWritten));
+    }
+
+    std::vector<uint32_t> buckets(header.BucketCount, DxilShaderArchiveEmptyBucket);
+    for (uint32_t i = 0; i < header.ContainerCount; ++i) {
+      uint32_t bucket = GetFirstBucket(m_Containers[i].Key, header.BucketCount);
+      while (buckets[bucket] != DxilShaderArchiveEmptyBucket)
+        bucket = (bucket + 1) & (header.BucketCount - 1);
+      buckets[bucket] = i;
+    }
+    IFT(pStream->Write(buckets.data(), buckets.size() * sizeof(uint32_t),
+                       &cbWritten));
+
+    uint32_t dataOffset = header.PartRefTableOffset +
+                          header.PartRefCount * sizeof(uint32_t);
+    for (const Part &part : m_Parts) {
+      DxilShaderArchivePart partEntry;
+      partEntry.PartFourCC = part.FourCC;
+      partEntry.PartSize = (uint32_t)part.Data.size();
+      partEntry.DataOffset = dataOffset;
+      IFT(WriteStreamValue(pStream, partEntry));
+      dataOffset += AlignTo4(partEntry.PartSize);
+    }
+    if (!m_PartRefs.empty()) {
+      IFT(pStream->Write(m_PartRefs.data(),
+                         m_PartRefs.size() * sizeof(uint32_t), &cbWritten));
+    }
+
+    const uint32_t padding = 0;
+    for (const Part &part : m_Parts) {
+      uint32_t partSize = (uint32_t)part.Data.size();
+      if (partSize)
+        IFT(pStream->Write(part.Data.data(), partSize, &cbWritten));
+      if (AlignTo4(partSize) != partSize)
+        IFT(pStream->Write(&padding, AlignTo4(partSize) - partSize, &cbWritten));
+    }
+    DXASSERT_LOCALVAR(archiveStart,
+                      archiveStart + header.ArchiveSizeInBytes ==
+                          (size_t)pStream->GetPosition(),
+                      "else stream size is incorrect");
+  }
+};
+
+DxilShaderArchiveWriter *hlsl::NewDxilShaderArchiveWriter() {
+  return new DxilShaderArchiveWriter_impl();
+}
+
+static bool IsTableInBounds(uint32_t offset, uint64_t count, size_t elementSize,
+                            uint32_t archiveSize) {
+  return (offset % 4) == 0 &&
+         (uint64_t)offset + count * elementSize <= archiveSize;
+}
+
+bool DxilShaderArchiveReader::Load(const void *pArchive, size_t length) {
+  *this = DxilShaderArchiveReader();
+  if (pArchive == nullptr || length < sizeof(DxilShaderArchiveHeader))
+    return false;
+  const char *pBase = (const char *)pArchive;
+  const DxilShaderArchiveHeader *pHeader =
+      (const DxilShaderArchiveHeader *)pBase;
+  if (pHeader->HeaderFourCC != DxilShaderArchiveFourCC ||
+      pHeader->MajorVersion != DxilShaderArchiveVersionMajor ||
+      pHeader->ArchiveSizeInBytes > length)
+    return false;
+  uint32_t archiveSize = pHeader->ArchiveSizeInBytes;
+
+  // The bucket table must be a power of two with at least one empty bucket,
+  // so that probing for a missing key terminates.
+  if (pHeader->BucketCount == 0 ||
+      (pHeader->BucketCount & (pHeader->BucketCount - 1)) != 0 ||
+      pHeader->BucketCount <= pHeader->ContainerCount)
+    return false;
+  if (!IsTableInBounds(pHeader->ContainerTableOffset, pHeader->ContainerCount,
+                       sizeof(DxilShaderArchiveContainer), archiveSize) ||
+      !IsTableInBounds(pHeader->BucketTableOffset, pHeader->BucketCount,
+                       sizeof(uint32_t), archiveSize) ||
+      !IsTableInBounds(pHeader->PartTableOffset, pHeader->PartCount,
+                       sizeof(DxilShaderArchivePart), archiveSize) ||
+      !IsTableInBounds(pHeader->PartRefTableOffset, pHeader->PartRefCount,
+                       sizeof(uint32_t), archiveSize))
+    return false;
+
+  const DxilShaderArchiveContainer *pContainers =
+      (const DxilShaderArchiveContainer *)(pBase + pHeader->ContainerTableOffset);
+  const uint32_t *pBuckets = (const uint32_t *)(pBase + pHeader->BucketTableOffset);
+  const DxilShaderArchivePart *pParts =
+      (const DxilShaderArchivePart *)(pBase + pHeader->PartTableOffset);
+  const uint32_t *pPartRefs = (const uint32_t *)(pBase + pHeader->PartRefTableOffset);
+
+  for (uint32_t i = 0; i < pHeader->BucketCount; ++i) {
+    if (pBuckets[i] != DxilShaderArchiveEmptyBucket &&
+        pBuckets[i] >= pHeader->ContainerCount)
+      return false;
+  }
+  for (uint32_t i = 0; i < pHeader->PartCount; ++i) {
+    if ((uint64_t)pParts[i].DataOffset + pParts[i].PartSize > archiveSize)
+      return false;
+  }
+  for (uint32_t i = 0; i < pHeader->ContainerCount; ++i) {
+    const DxilShaderArchiveContainer &container = pContainers[i];
+    if ((uint64_t)container.FirstPartRef + container.PartCount >
+        pHeader->PartRefCount)
+      return false;
+    uint64_t containerSize =
+        kContainerPrologSize + GetOffsetTableSize(container.PartCount);
+    for (uint32_t j = 0; j < container.PartCount; ++j) {
+      uint32_t partIndex = pPartRefs[container.FirstPartRef + j];
+      if (partIndex >= pHeader->PartCount)
+        return false;
+      containerSize += sizeof(DxilPartHeader) + pParts[partIndex].PartSize;
+    }
+    if (containerSize != container.ContainerSizeInBytes ||
+        containerSize > DxilContainerMaxSize)
+      return false;
+  }
+
+  m_pArchive = pBase;
+  m_pHeader = pHeader;
+  m_pContainers = pContainers;
+  m_pBuckets = pBuckets;
+  m_pParts = pParts;
+  m_pPartRefs = pPartRefs;
+  return true;
+}
+
+bool DxilShaderArchiveReader::FindContainer(const DxilContainerHash &Key,
+                                            uint32_t *pIndex) const {
+  DXASSERT_NOMSG(pIndex != nullptr);
+  if (!IsLoaded())
+    return false;
+  uint32_t mask = m_pHeader->BucketCount - 1;
+  for (uint32_t bucket = GetFirstBucket(Key, m_pHeader->BucketCount);;
+       bucket = (bucket + 1) & mask) {
+    uint32_t index = m_pBuckets[bucket];
+    if (index == DxilShaderArchiveEmptyBucket)
+      return false;
+    if (0 == memcmp(m_pContainers[index].Key.Digest, Key.Digest,
+                    sizeof(Key.Digest))) {
+      *pIndex = index;
+      return true;
+    }
+  }
+}
+
+void DxilShaderArchiveReader::ReadContainer(uint32_t index, void *pDest) const {
+  DXASSERT_NOMSG(IsLoaded() && index < m_pHeader->ContainerCount);
+  const DxilShaderArchiveContainer &container = m_pContainers[index];
+  char *pCursor = (char *)pDest;
+  DxilContainerHeader *pHeader = (DxilContainerHeader *)pCursor;
+  pHeader->HeaderFourCC = DFCC_Container;
+  pHeader->Hash = container.Hash;
+  pHeader->Version = container.Version;
+  pHeader->ContainerSizeInBytes = container.ContainerSizeInBytes;
+  pHeader->PartCount = container.PartCount;
+  uint32_t *pPartOffsetTable = (uint32_t *)(pHeader + 1);
+  uint32_t offset = (uint32_t)(kContainerPrologSize +
+                               GetOffsetTableSize(container.PartCount));
+  pCursor += offset;
+  for (uint32_t i = 0; i < container.PartCount; ++i) {
+    const DxilShaderArchivePart &part = GetContainerPart(index, i);
+    pPartOffsetTable[i] = offset;
+    DxilPartHeader *pPart = (DxilPartHeader *)pCursor;
+    pPart->PartFourCC = part.PartFourCC;
+    pPart->PartSize = part.PartSize;
+    memcpy(pPart + 1, GetPartData(part), part.PartSize);
+    pCursor += sizeof(DxilPartHeader) + part.PartSize;
+    offset += sizeof(DxilPartHeader) + part.PartSize;
+  }
+  DXASSERT(pCursor == (char *)pDest + container.ContainerSizeInBytes,
+           "else container size is incorrect");
+}
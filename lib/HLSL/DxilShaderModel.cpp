@@ -14,19 +14,6 @@
 
 namespace hlsl {
 
-ShaderModel::ShaderModel(Kind Kind, unsigned Major, unsigned Minor, const char *pszName,
-                         unsigned NumInputRegs, unsigned NumOutputRegs,
-                         bool bUAVs, bool bTypedUavs,  unsigned NumUAVRegs)
-: m_Kind(Kind)
-, m_Major(Major)
-, m_Minor(Minor)
-, m_pszName(pszName)
-, m_NumInputRegs(NumInputRegs)
-, m_NumOutputRegs(NumOutputRegs)
-, m_bUAVs(bUAVs)
-, m_bTypedUavs(bTypedUavs)
-, m_NumUAVRegs(NumUAVRegs) {
-}
 
 bool ShaderModel::operator==(const ShaderModel &other) const {
     return m_Kind          == other.m_Kind
@@ -71,14 +58,16 @@ const ShaderModel *ShaderModel::Get(unsigned Idx) {
 }
 
 const ShaderModel *ShaderModel::Get(Kind Kind, unsigned Major, unsigned Minor) {
-  // Linear search. Replaced by binary search if necessary.
-  for (unsigned i = 0; i < kNumShaderModels; i++) {
-    const ShaderModel *pSM = &ms_ShaderModels[i];
-    if (pSM->m_Kind == Kind && pSM->m_Major == Major && pSM->m_Minor == Minor)
-      return pSM;
-  }
-
-  return GetInvalid();
+  if (Kind >= Kind::Invalid || Major < kMinIndexedMajor ||
+      Major - kMinIndexedMajor >= kNumIndexedMajors ||
+      Minor >= kNumIndexedMinors)
+    return GetInvalid();
+  const ShaderModel *pSM = &ms_ShaderModels[
+      ms_ShaderModelIndex[(unsigned)Kind][Major - kMinIndexedMajor][Minor]];
+  DXASSERT(pSM == GetInvalid() || (pSM->m_Kind == Kind &&
+           pSM->m_Major == Major && pSM->m_Minor == Minor),
+           "else ms_ShaderModelIndex is out of sync with ms_ShaderModels");
+  return pSM;
 }
 
 const ShaderModel *ShaderModel::GetByName(const char *pszName) {
@@ -221,4 +210,18 @@ const ShaderModel ShaderModel::ms_ShaderModels[kNumShaderModels] = {
   SM(Kind::Invalid,  0, 0, "invalid", 0,  0,   false, false, 0),
 };
 
+// 33 is the invalid shader model.
+const unsigned char ShaderModel::ms_ShaderModelIndex[(unsigned)Kind::Invalid]
+                                                    [kNumIndexedMajors]
+                                                    [kNumIndexedMinors] = {
+  //   4_0 4_1    5_0 5_1    6_0 6_1
+  { { 20, 21 }, { 22, 23 }, { 24, 25 } }, // Pixel
+  { { 26, 27 }, { 28, 29 }, { 30, 31 } }, // Vertex
+  { { 10, 11 }, { 12, 13 }, { 14, 15 } }, // Geometry
+  { { 33, 33 }, { 16, 17 }, { 18, 19 } }, // Hull
+  { { 33, 33 }, {  6,  7 }, {  8,  9 } }, // Domain
+  { {  0,  1 }, {  2,  3 }, {  4,  5 } }, // Compute
+  { { 33, 33 }, { 33, 33 }, { 33, 32 } }, // Library
+};
+
 } // namespace hlsl
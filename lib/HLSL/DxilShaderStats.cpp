@@ -0,0 +1,283 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilShaderStats.cpp                                                       //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Reports static cost estimates for each entry point of a DXIL module:      //
+// instruction counts by operation class, resource access counts, loops,     //
+// peak live values and ViewID dependence.                                   //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+#include "dxc/Support/Global.h"
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+
+struct FunctionStats {
+  unsigned InstructionCount = 0;
+  unsigned DxilOpCount = 0;
+  unsigned TextureOpCount = 0;
+  unsigned BufferOpCount = 0;
+  unsigned CBufferOpCount = 0;
+  unsigned LoopCount = 0;
+  unsigned PeakLiveValues = 0;
+  std::map<std::string, unsigned> OpClassCounts;
+};
+
+enum class ResourceOpKind { None, Texture, Buffer, CBuffer };
+
+static ResourceOpKind GetResourceOpKind(OP::OpCode opcode) {
+  switch (opcode) {
+  case OP::OpCode::Sample:
+  case OP::OpCode::SampleBias:
+  case OP::OpCode::SampleLevel:
+  case OP::OpCode::SampleGrad:
+  case OP::OpCode::SampleCmp:
+  case OP::OpCode::SampleCmpLevelZero:
+  case OP::OpCode::TextureLoad:
+  case OP::OpCode::TextureStore:
+  case OP::OpCode::TextureGather:
+  case OP::OpCode::TextureGatherCmp:
+  case OP::OpCode::CalculateLOD:
+    return ResourceOpKind::Texture;
+  case OP::OpCode::BufferLoad:
+  case OP::OpCode::BufferStore:
+  case OP::OpCode::BufferUpdateCounter:
+  case OP::OpCode::AtomicBinOp:
+  case OP::OpCode::AtomicCompareExchange:
+    return ResourceOpKind::Buffer;
+  case OP::OpCode::CBufferLoad:
+  case OP::OpCode::CBufferLoadLegacy:
+    return ResourceOpKind::CBuffer;
+  default:
+    return ResourceOpKind::None;
+  }
+}
+
+// Values that take a register: scalars and vectors. Handles, aggregates and
+// pointers are excluded; the components extracted from aggregates count.
+static bool TakesRegister(Value *V) {
+  if (!isa<Instruction>(V) && !isa<Argument>(V))
+    return false;
+  Type *Ty = V->getType();
+  if (Ty->isVectorTy())
+    Ty = Ty->getVectorElementType();
+  return Ty->isIntegerTy() || Ty->isFloatingPointTy();
+}
+
+} // namespace
+
+// Computes the largest number of values live at any point, with liveness
+// solved backwards over the CFG. Phi operands are live out of the incoming
+// block only.
+unsigned hlsl::ComputePeakLiveValues(Function &F) {
+  typedef std::unordered_set<Value *> ValueSet;
+  std::unordered_map<BasicBlock *, ValueSet> LiveIn;
+  std::unordered_map<BasicBlock *, ValueSet> LiveOut;
+
+  auto computeLiveOut = [&](BasicBlock *BB) {
+    ValueSet Out;
+    for (BasicBlock *Succ : successors(BB)) {
+      for (Value *V : LiveIn[Succ]) {
+        if (!isa<PHINode>(V) || cast<PHINode>(V)->getParent() != Succ)
+          Out.insert(V);
+      }
+      for (Instruction &I : *Succ) {
+        PHINode *Phi = dyn_cast<PHINode>(&I);
+        if (!Phi)
+          break;
+        Value *Incoming = Phi->getIncomingValueForBlock(BB);
+        if (TakesRegister(Incoming))
+          Out.insert(Incoming);
+      }
+    }
+    return Out;
+  };
+
+  // Walks a block backwards from its live-out set, reporting the peak and
+  // leaving the live-in set in Live.
+  auto walkBlock = [](BasicBlock *BB, ValueSet &Live) {
+    unsigned Peak = Live.size();
+    for (auto It = BB->rbegin(), E = BB->rend(); It != E; ++It) {
+      Instruction *I = &*It;
+      if (isa<PHINode>(I))
+        break;
+      Live.erase(I);
+      for (Value *Op : I->operands()) {
+        if (TakesRegister(Op))
+          Live.insert(Op);
+      }
+      if (Live.size() > Peak)
+        Peak = Live.size();
+    }
+    return Peak;
+  };
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (auto It = F.getBasicBlockList().rbegin(),
+              E = F.getBasicBlockList().rend();
+         It != E; ++It) {
+      BasicBlock *BB = &*It;
+      ValueSet Live = computeLiveOut(BB);
+      LiveOut[BB] = Live;
+      walkBlock(BB, Live);
+      if (Live != LiveIn[BB]) {
+        LiveIn[BB] = std::move(Live);
+        Changed = true;
+      }
+    }
+  }
+
+  unsigned Peak = 0;
+  for (BasicBlock &BB : F) {
+    ValueSet Live = LiveOut[&BB];
+    unsigned BlockPeak = walkBlock(&BB, Live);
+    if (BlockPeak > Peak)
+      Peak = BlockPeak;
+  }
+  return Peak;
+}
+
+namespace {
+
+static void ComputeFunctionStats(Function &F, FunctionStats &Stats) {
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      ++Stats.InstructionCount;
+      if (!OP::IsDxilOpFuncCallInst(&I))
+        continue;
+      OP::OpCode opcode = OP::GetDxilOpFuncCallInst(&I);
+      ++Stats.DxilOpCount;
+      ++Stats.OpClassCounts[OP::GetOpCodeClassName(opcode)];
+      switch (GetResourceOpKind(opcode)) {
+      case ResourceOpKind::Texture: ++Stats.TextureOpCount; break;
+      case ResourceOpKind::Buffer: ++Stats.BufferOpCount; break;
+      case ResourceOpKind::CBuffer: ++Stats.CBufferOpCount; break;
+      default: break;
+      }
+    }
+  }
+
+  DominatorTreeAnalysis DTA;
+  DominatorTree DT = DTA.run(F);
+  LoopInfo LI;
+  LI.Analyze(DT);
+  std::vector<Loop *> Loops(LI.begin(), LI.end());
+  while (!Loops.empty()) {
+    Loop *L = Loops.back();
+    Loops.pop_back();
+    ++Stats.LoopCount;
+    Loops.insert(Loops.end(), L->begin(), L->end());
+  }
+
+  Stats.PeakLiveValues = ComputePeakLiveValues(F);
+}
+
+static void PrintFunctionStats(raw_ostream &OS, StringRef Title, Function &F) {
+  FunctionStats Stats;
+  ComputeFunctionStats(F, Stats);
+  OS << Title << " " << F.getName() << "\n";
+  OS << "  Instructions: " << Stats.InstructionCount << "\n";
+  OS << "  DXIL operations: " << Stats.DxilOpCount << "\n";
+  for (const auto &it : Stats.OpClassCounts)
+    OS << "    " << it.first << ": " << it.second << "\n";
+  OS << "  Texture operations: " << Stats.TextureOpCount << "\n";
+  OS << "  Buffer operations: " << Stats.BufferOpCount << "\n";
+  OS << "  CBuffer operations: " << Stats.CBufferOpCount << "\n";
+  OS << "  Loops: " << Stats.LoopCount << "\n";
+  OS << "  Peak live values: " << Stats.PeakLiveValues << "\n";
+}
+
+static void PrintViewIdStats(raw_ostream &OS, DxilModule &DM) {
+  const ShaderModel *SM = DM.GetShaderModel();
+  if (SM->IsCS())
+    return;
+  DxilViewIdState &ViewIdState = DM.GetViewIdState();
+  unsigned NumStreams = SM->IsGS() ? DXIL::kNumOutputStreams : 1;
+  for (unsigned StreamId = 0; StreamId < NumStreams; ++StreamId) {
+    unsigned NumScalars = ViewIdState.getNumOutputSigScalars(StreamId);
+    if (NumScalars == 0)
+      continue;
+    OS << "  Outputs dependent on ViewID";
+    if (SM->IsGS())
+      OS << " (stream " << StreamId << ")";
+    OS << ": " << ViewIdState.getOutputsDependentOnViewId(StreamId).count()
+       << " of " << NumScalars << "\n";
+  }
+  if (SM->IsHS() && ViewIdState.getNumPCSigScalars() != 0) {
+    OS << "  Patch constants dependent on ViewID: "
+       << ViewIdState.getPCOutputsDependentOnViewId().count() << " of "
+       << ViewIdState.getNumPCSigScalars() << "\n";
+  }
+}
+
+class DxilShaderStats : public ModulePass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilShaderStats() : ModulePass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL shader statistics";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  bool runOnModule(Module &M) override {
+    raw_ostream &OS = OSOverride != nullptr ? *OSOverride : errs();
+    DxilModule &DM = M.GetOrCreateDxilModule();
+    const ShaderModel *SM = DM.GetShaderModel();
+
+    if (Function *Entry = DM.GetEntryFunction()) {
+      PrintFunctionStats(OS, "Entry", *Entry);
+      OS << "  Shader model: " << SM->GetName() << "\n";
+      PrintViewIdStats(OS, DM);
+      if (SM->IsHS()) {
+        if (Function *PCF = DM.GetPatchConstantFunction())
+          PrintFunctionStats(OS, "Patch constant function", *PCF);
+      }
+      return false;
+    }
+
+    // Libraries have no single entry point; report every function.
+    for (Function &F : M) {
+      if (!F.isDeclaration())
+        PrintFunctionStats(OS, "Function", F);
+    }
+    return false;
+  }
+};
+}
+
+char DxilShaderStats::ID = 0;
+
+ModulePass *llvm::createDxilShaderStatsPass() {
+  return new DxilShaderStats();
+}
+
+INITIALIZE_PASS(DxilShaderStats, "hlsl-dxil-shader-stats",
+                "DXIL shader statistics", false, true)
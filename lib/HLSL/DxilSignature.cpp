@@ -78,6 +78,20 @@ const std::vector<std::unique_ptr<DxilSignatureElement> > &DxilSignature::GetEle
   return m_Elements;
 }
 
+void DxilSignature::DeleteElements(const std::vector<bool> &bDelete) {
+  DXASSERT_NOMSG(bDelete.size() == m_Elements.size());
+  unsigned NewCount = 0;
+  for (unsigned i = 0; i < m_Elements.size(); ++i) {
+    if (bDelete[i])
+      continue;
+    m_Elements[i]->SetID(NewCount);
+    if (NewCount != i)
+      m_Elements[NewCount] = std::move(m_Elements[i]);
+    ++NewCount;
+  }
+  m_Elements.resize(NewCount);
+}
+
 namespace {
 
 static bool ShouldBeAllocated(const DxilSignatureElement *SE) {
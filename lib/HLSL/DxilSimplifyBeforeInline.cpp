@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilSimplifyBeforeInline.cpp                                              //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Simplifies helper functions once, before they are inlined.                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+// HLSL inlines every helper. Added right after the always-inliner, this pass
+// joins its call graph SCC pass manager, so it runs bottom-up: on a function
+// once its own callees are inlined, and before it is inlined into callers.
+// A helper called from many sites is then cleaned up once rather than once
+// per inlined copy.
+//
+// Only internal always-inline functions are simplified. They disappear once
+// inlined, so the lowering of entry point and library signatures still sees
+// the IR code generation produced. Within them, scalar and vector locals are
+// promoted unless marked precise (the mark lives on the alloca until DXIL
+// generation), then instructions are simplified and constant branches and
+// trivial blocks folded. Aggregates are left to SROA_HLSL, which runs after
+// inlining.
+class DxilSimplifyBeforeInline : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilSimplifyBeforeInline() : FunctionPass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL simplify before inline";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DominatorTreeWrapperPass>();
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (!F.hasLocalLinkage() ||
+        !F.hasFnAttribute(Attribute::AlwaysInline) || F.use_empty())
+      return false;
+
+    DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    bool bChanged = PromoteLocals(F, DT);
+    bChanged |= SimplifyInstructions(F);
+    bChanged |= SimplifyBlocks(F);
+    return bChanged;
+  }
+
+private:
+  static bool PromoteLocals(Function &F, DominatorTree &DT);
+  static bool SimplifyInstructions(Function &F);
+  static bool SimplifyBlocks(Function &F);
+};
+
+char DxilSimplifyBeforeInline::ID = 0;
+
+bool DxilSimplifyBeforeInline::PromoteLocals(Function &F, DominatorTree &DT) {
+  SmallVector<AllocaInst *, 16> Allocas;
+  for (Instruction &I : F.getEntryBlock()) {
+    AllocaInst *AI = dyn_cast<AllocaInst>(&I);
+    if (!AI)
+      continue;
+    Type *Ty = AI->getAllocatedType();
+    if (!Ty->isSingleValueType() || Ty->isPointerTy())
+      continue;
+    if (DxilMDHelper::IsMarkedPrecise(AI) || !isAllocaPromotable(AI))
+      continue;
+    Allocas.push_back(AI);
+  }
+  if (Allocas.empty())
+    return false;
+  PromoteMemToReg(Allocas, DT);
+  return true;
+}
+
+bool DxilSimplifyBeforeInline::SimplifyInstructions(Function &F) {
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  bool bChanged = false;
+  for (BasicBlock &BB : F) {
+    for (BasicBlock::iterator It = BB.begin(), E = BB.end(); It != E;) {
+      Instruction *I = It++;
+      if (!I->use_empty()) {
+        if (Value *V = SimplifyInstruction(I, DL)) {
+          I->replaceAllUsesWith(V);
+          bChanged = true;
+        }
+      }
+      // Deleting I can delete other instructions of the block with it, so
+      // start over rather than keep an iterator into the block.
+      if (RecursivelyDeleteTriviallyDeadInstructions(I)) {
+        It = BB.begin();
+        E = BB.end();
+        bChanged = true;
+      }
+    }
+  }
+  return bChanged;
+}
+
+bool DxilSimplifyBeforeInline::SimplifyBlocks(Function &F) {
+  bool bChanged = false;
+  for (BasicBlock &BB : F)
+    bChanged |= ConstantFoldTerminator(&BB, /*DeleteDeadConditions*/ true);
+  bChanged |= removeUnreachableBlocks(F);
+  for (Function::iterator It = F.begin(), E = F.end(); It != E;) {
+    BasicBlock *BB = It++;
+    bChanged |= MergeBlockIntoPredecessor(BB);
+  }
+  return bChanged;
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilSimplifyBeforeInlinePass() {
+  return new DxilSimplifyBeforeInline();
+}
+
+INITIALIZE_PASS_BEGIN(DxilSimplifyBeforeInline, "hlsl-dxil-simplify-before-inline",
+                      "DXIL simplify before inline", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_END(DxilSimplifyBeforeInline, "hlsl-dxil-simplify-before-inline",
+                    "DXIL simplify before inline", false, false)
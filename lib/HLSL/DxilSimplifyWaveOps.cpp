@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilSimplifyWaveOps.cpp                                                   //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Rewrites wave reductions and broadcasts of wave-uniform values into       //
+// cheaper forms.                                                            //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilInstructions.h"
+#include "dxc/HLSL/DxilMetadataHelper.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilOperations.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <memory>
+#include <unordered_map>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+// When every active lane passes the same value u to a wave operation, the
+// cross-lane work can be dropped:
+//   WaveReadLaneFirst(u), WaveActiveMin/Max(u), WaveActiveBitAnd/Or(u),
+//   WaveActiveAnyTrue(u), WaveActiveAllTrue(u)  -> u
+//   WaveActiveAllEqual(u)                       -> true
+//   WaveActiveSum(u)                            -> u * WaveActiveCountBits(true)
+//   WaveActiveBitXor(u)                         -> odd count ? u : 0
+//   WaveActiveCountBits(u)                      -> u ? WaveActiveCountBits(true) : 0
+// Uniformity comes from DxilUniformityAnalysis. The active lane count is
+// computed once per block, since the active lanes cannot change within one.
+// Floating-point sums marked precise are kept, as the product may round
+// differently from the lanes' additions; WaveActiveProduct has no cheaper
+// form and is kept too.
+class DxilSimplifyWaveOps : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilSimplifyWaveOps()
+      : FunctionPass(ID), m_pAnalysis(DxilUniformityAnalysis::create()) {}
+
+  const char *getPassName() const override {
+    return "DXIL simplify wave operations";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (!F.getParent()->HasDxilModule() || F.isDeclaration())
+      return false;
+
+    SmallVector<CallInst *, 16> WaveOps;
+    for (Instruction &I : inst_range(F)) {
+      if (!OP::IsDxilOpFuncCallInst(&I))
+        continue;
+      if (OP::IsDxilOpWave(OP::GetDxilOpFuncCallInst(&I)))
+        WaveOps.push_back(cast<CallInst>(&I));
+    }
+    if (WaveOps.empty())
+      return false;
+
+    m_pAnalysis->Analyze(&F);
+    hlsl::OP *hlslOP = F.getParent()->GetDxilModule().GetOP();
+    std::unordered_map<BasicBlock *, Value *> ActiveCounts;
+    bool bChanged = false;
+    for (CallInst *CI : WaveOps) {
+      Value *V = Simplify(CI, hlslOP, ActiveCounts);
+      if (!V)
+        continue;
+      CI->replaceAllUsesWith(V);
+      CI->eraseFromParent();
+      bChanged = true;
+    }
+    return bChanged;
+  }
+
+private:
+  std::unique_ptr<DxilUniformityAnalysis> m_pAnalysis;
+
+  Value *Simplify(CallInst *CI, hlsl::OP *hlslOP,
+                  std::unordered_map<BasicBlock *, Value *> &ActiveCounts);
+  static Value *GetActiveCount(CallInst *CI, hlsl::OP *hlslOP,
+                               std::unordered_map<BasicBlock *, Value *> &ActiveCounts);
+  static Value *ConvertCount(IRBuilder<> &B, Value *Count, Type *Ty);
+};
+
+char DxilSimplifyWaveOps::ID = 0;
+
+Value *DxilSimplifyWaveOps::GetActiveCount(
+    CallInst *CI, hlsl::OP *hlslOP,
+    std::unordered_map<BasicBlock *, Value *> &ActiveCounts) {
+  Value *&Count = ActiveCounts[CI->getParent()];
+  if (!Count) {
+    IRBuilder<> B(CI);
+    Function *F = hlslOP->GetOpFunc(OP::OpCode::WaveAllBitCount,
+                                    Type::getVoidTy(CI->getContext()));
+    Value *Args[] = {hlslOP->GetU32Const((unsigned)OP::OpCode::WaveAllBitCount),
+                     hlslOP->GetI1Const(true)};
+    Count = B.CreateCall(F, Args);
+  }
+  return Count;
+}
+
+Value *DxilSimplifyWaveOps::ConvertCount(IRBuilder<> &B, Value *Count,
+                                         Type *Ty) {
+  if (Ty->isFloatingPointTy())
+    return B.CreateUIToFP(Count, Ty);
+  return B.CreateZExtOrTrunc(Count, Ty);
+}
+
+Value *DxilSimplifyWaveOps::Simplify(
+    CallInst *CI, hlsl::OP *hlslOP,
+    std::unordered_map<BasicBlock *, Value *> &ActiveCounts) {
+  switch (OP::GetDxilOpFuncCallInst(CI)) {
+  case OP::OpCode::WaveReadLaneFirst: {
+    DxilInst_WaveReadLaneFirst Op(CI);
+    return m_pAnalysis->IsUniform(Op.get_value()) ? Op.get_value() : nullptr;
+  }
+  case OP::OpCode::WaveActiveAllEqual: {
+    DxilInst_WaveActiveAllEqual Op(CI);
+    if (!m_pAnalysis->IsUniform(Op.get_value()))
+      return nullptr;
+    return ConstantInt::getTrue(CI->getType());
+  }
+  case OP::OpCode::WaveAnyTrue: {
+    DxilInst_WaveAnyTrue Op(CI);
+    return m_pAnalysis->IsUniform(Op.get_cond()) ? Op.get_cond() : nullptr;
+  }
+  case OP::OpCode::WaveAllTrue: {
+    DxilInst_WaveAllTrue Op(CI);
+    return m_pAnalysis->IsUniform(Op.get_cond()) ? Op.get_cond() : nullptr;
+  }
+  case OP::OpCode::WaveAllBitCount: {
+    DxilInst_WaveAllBitCount Op(CI);
+    Value *Cond = Op.get_value();
+    if (ConstantInt *C = dyn_cast<ConstantInt>(Cond)) {
+      if (C->isOne()) {
+        // Already the active lane count. It becomes the count of its block
+        // unless an earlier one there takes its place.
+        auto Inserted = ActiveCounts.insert(std::make_pair(CI->getParent(), CI));
+        return Inserted.second ? nullptr : Inserted.first->second;
+      }
+      return ConstantInt::get(CI->getType(), 0);
+    }
+    if (!m_pAnalysis->IsUniform(Cond))
+      return nullptr;
+    Value *Count = GetActiveCount(CI, hlslOP, ActiveCounts);
+    IRBuilder<> B(CI);
+    return B.CreateSelect(Cond, Count, ConstantInt::get(CI->getType(), 0));
+  }
+  case OP::OpCode::WaveActiveOp: {
+    DxilInst_WaveActiveOp Op(CI);
+    Value *V = Op.get_value();
+    if (!isa<ConstantInt>(Op.get_op()) || !m_pAnalysis->IsUniform(V))
+      return nullptr;
+    switch ((DXIL::WaveOpKind)Op.get_op_val()) {
+    case DXIL::WaveOpKind::Min:
+    case DXIL::WaveOpKind::Max:
+      return V;
+    case DXIL::WaveOpKind::Sum: {
+      if (V->getType()->isFloatingPointTy() && DxilMDHelper::IsMarkedPrecise(CI))
+        return nullptr;
+      Value *Count = GetActiveCount(CI, hlslOP, ActiveCounts);
+      IRBuilder<> B(CI);
+      Value *Factor = ConvertCount(B, Count, V->getType());
+      if (V->getType()->isFloatingPointTy())
+        return B.CreateFMul(V, Factor);
+      return B.CreateMul(V, Factor);
+    }
+    default:
+      return nullptr;
+    }
+  }
+  case OP::OpCode::WaveActiveBit: {
+    DxilInst_WaveActiveBit Op(CI);
+    Value *V = Op.get_value();
+    if (!isa<ConstantInt>(Op.get_op()) || !m_pAnalysis->IsUniform(V))
+      return nullptr;
+    switch ((DXIL::WaveBitOpKind)Op.get_op_val()) {
+    case DXIL::WaveBitOpKind::And:
+    case DXIL::WaveBitOpKind::Or:
+      return V;
+    case DXIL::WaveBitOpKind::Xor: {
+      Value *Count = GetActiveCount(CI, hlslOP, ActiveCounts);
+      IRBuilder<> B(CI);
+      Value *Odd = B.CreateTrunc(Count, B.getInt1Ty());
+      return B.CreateSelect(Odd, V, Constant::getNullValue(V->getType()));
+    }
+    default:
+      return nullptr;
+    }
+  }
+  default:
+    return nullptr;
+  }
+}
+
+} // namespace
+
+FunctionPass *llvm::createDxilSimplifyWaveOpsPass() {
+  return new DxilSimplifyWaveOps();
+}
+
+INITIALIZE_PASS(DxilSimplifyWaveOps, "hlsl-dxil-simplify-wave-ops",
+                "DXIL simplify wave operations", false, false)
@@ -0,0 +1,425 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilTGSMBankConflicts.cpp                                                 //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Predicts bank conflicts of groupshared memory accesses in compute         //
+// shaders, from how their addresses depend on the thread id.                //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+
+// Collects the instructions of F whose value can differ between the threads
+// of a group: thread ids and everything computed from them.
+static void CollectThreadDependentValues(Function &F,
+                                         std::unordered_set<Value *> &Values) {
+  std::vector<Instruction *> WorkList;
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    if (!OP::IsDxilOpFuncCallInst(&*I))
+      continue;
+    switch (OP::GetDxilOpFuncCallInst(&*I)) {
+    case DXIL::OpCode::ThreadId:
+    case DXIL::OpCode::ThreadIdInGroup:
+    case DXIL::OpCode::FlattenedThreadIdInGroup:
+      break;
+    default:
+      if (!OP::IsDxilOpWave(OP::GetDxilOpFuncCallInst(&*I)))
+        continue;
+    }
+    if (Values.insert(&*I).second)
+      WorkList.emplace_back(&*I);
+  }
+
+  while (!WorkList.empty()) {
+    Instruction *I = WorkList.back();
+    WorkList.pop_back();
+    for (User *U : I->users()) {
+      if (isa<Instruction>(U) && Values.insert(U).second)
+        WorkList.emplace_back(cast<Instruction>(U));
+    }
+  }
+}
+
+// The value of an address computation for one lane. Values that are the
+// same in every thread but unknown at compile time contribute an unknown
+// offset, which does not change how lanes map onto banks as long as it is
+// only added in.
+struct LaneValue {
+  int64_t Known = 0;
+  bool HasUniformOffset = false;
+};
+
+// Evaluates address computations for a single lane of a wave.
+class LaneEvaluator {
+public:
+  LaneEvaluator(const DataLayout &DL,
+                const std::unordered_set<Value *> &ThreadDependent,
+                const unsigned GroupThreadId[3], unsigned FlatId)
+      : m_DL(DL), m_ThreadDependent(ThreadDependent), m_FlatId(FlatId) {
+    for (unsigned i = 0; i < 3; ++i)
+      m_GroupThreadId[i] = GroupThreadId[i];
+  }
+
+  // Returns false if V depends on the thread id in a way that cannot be
+  // evaluated, such as through a memory load.
+  bool Evaluate(Value *V, LaneValue &Result);
+
+private:
+  const DataLayout &m_DL;
+  const std::unordered_set<Value *> &m_ThreadDependent;
+  unsigned m_GroupThreadId[3];
+  unsigned m_FlatId;
+  std::unordered_map<Value *, LaneValue> m_Cache;
+
+  bool EvaluateUncached(Value *V, LaneValue &Result);
+  bool EvaluateGEP(GEPOperator *GEP, LaneValue &Result);
+};
+
+bool LaneEvaluator::Evaluate(Value *V, LaneValue &Result) {
+  auto It = m_Cache.find(V);
+  if (It != m_Cache.end()) {
+    Result = It->second;
+    return true;
+  }
+  if (!EvaluateUncached(V, Result))
+    return false;
+  m_Cache[V] = Result;
+  return true;
+}
+
+bool LaneEvaluator::EvaluateGEP(GEPOperator *GEP, LaneValue &Result) {
+  if (!Evaluate(GEP->getPointerOperand(), Result))
+    return false;
+  for (gep_type_iterator GTI = gep_type_begin(GEP), E = gep_type_end(GEP);
+       GTI != E; ++GTI) {
+    if (StructType *ST = dyn_cast<StructType>(*GTI)) {
+      unsigned Field = cast<ConstantInt>(GTI.getOperand())->getZExtValue();
+      Result.Known += m_DL.getStructLayout(ST)->getElementOffset(Field);
+      continue;
+    }
+    LaneValue Index;
+    if (!Evaluate(GTI.getOperand(), Index))
+      return false;
+    int64_t Size = m_DL.getTypeAllocSize(GTI.getIndexedType());
+    Result.Known += Index.Known * Size;
+    Result.HasUniformOffset |= Index.HasUniformOffset;
+  }
+  return true;
+}
+
+bool LaneEvaluator::EvaluateUncached(Value *V, LaneValue &Result) {
+  Result = LaneValue();
+  if (ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+    Result.Known = CI->getSExtValue();
+    return true;
+  }
+  // Accesses are measured from the start of the variable.
+  if (isa<GlobalVariable>(V))
+    return true;
+  if (GEPOperator *GEP = dyn_cast<GEPOperator>(V))
+    return EvaluateGEP(GEP, Result);
+  if (!m_ThreadDependent.count(V)) {
+    Result.HasUniformOffset = true;
+    return true;
+  }
+
+  Instruction *I = cast<Instruction>(V);
+  if (OP::IsDxilOpFuncCallInst(I)) {
+    switch (OP::GetDxilOpFuncCallInst(I)) {
+    case DXIL::OpCode::FlattenedThreadIdInGroup:
+      Result.Known = m_FlatId;
+      return true;
+    case DXIL::OpCode::ThreadIdInGroup:
+    case DXIL::OpCode::ThreadId: {
+      // The group id part of SV_DispatchThreadID is the same for the wave.
+      ConstantInt *Comp = dyn_cast<ConstantInt>(I->getOperand(1));
+      if (!Comp || Comp->getZExtValue() > 2)
+        return false;
+      Result.Known = m_GroupThreadId[Comp->getZExtValue()];
+      Result.HasUniformOffset =
+          OP::GetDxilOpFuncCallInst(I) == DXIL::OpCode::ThreadId;
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  if (CastInst *Cast = dyn_cast<CastInst>(I)) {
+    switch (Cast->getOpcode()) {
+    case Instruction::ZExt:
+    case Instruction::SExt:
+    case Instruction::Trunc:
+      return Evaluate(Cast->getOperand(0), Result);
+    default:
+      return false;
+    }
+  }
+
+  BinaryOperator *BO = dyn_cast<BinaryOperator>(I);
+  if (!BO)
+    return false;
+  LaneValue LHS, RHS;
+  if (!Evaluate(BO->getOperand(0), LHS) || !Evaluate(BO->getOperand(1), RHS))
+    return false;
+  Result.HasUniformOffset = LHS.HasUniformOffset || RHS.HasUniformOffset;
+  switch (BO->getOpcode()) {
+  case Instruction::Add:
+    Result.Known = LHS.Known + RHS.Known;
+    return true;
+  case Instruction::Sub:
+    Result.Known = LHS.Known - RHS.Known;
+    return true;
+  case Instruction::Mul:
+    // Scaling an unknown offset by a constant keeps it uniform; scaling a
+    // thread id by an unknown gives an unknown stride.
+    if ((LHS.HasUniformOffset && !isa<ConstantInt>(BO->getOperand(1))) ||
+        (RHS.HasUniformOffset && !isa<ConstantInt>(BO->getOperand(0))))
+      return false;
+    Result.Known = LHS.Known * RHS.Known;
+    return true;
+  case Instruction::Shl:
+    if (RHS.HasUniformOffset || RHS.Known < 0 || RHS.Known > 62)
+      return false;
+    Result.Known = LHS.Known << RHS.Known;
+    return true;
+  default:
+    break;
+  }
+
+  // The remaining operations only evaluate precisely without unknowns.
+  if (Result.HasUniformOffset)
+    return false;
+  switch (BO->getOpcode()) {
+  case Instruction::And:
+    Result.Known = LHS.Known & RHS.Known;
+    return true;
+  case Instruction::Or:
+    Result.Known = LHS.Known | RHS.Known;
+    return true;
+  case Instruction::Xor:
+    Result.Known = LHS.Known ^ RHS.Known;
+    return true;
+  case Instruction::LShr:
+  case Instruction::AShr:
+    if (RHS.Known < 0 || RHS.Known > 62)
+      return false;
+    Result.Known = LHS.Known >> RHS.Known;
+    return true;
+  case Instruction::UDiv:
+  case Instruction::SDiv:
+    if (RHS.Known == 0)
+      return false;
+    Result.Known = LHS.Known / RHS.Known;
+    return true;
+  case Instruction::URem:
+  case Instruction::SRem:
+    if (RHS.Known == 0)
+      return false;
+    Result.Known = LHS.Known % RHS.Known;
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Groupshared memory is split into banks of 32-bit words, and the lanes of
+// a wave access it together. Lanes that touch different words of the same
+// bank are serialized; lanes that read the same word share the access. For
+// each groupshared load, store and atomic in a compute shader, this pass
+// evaluates the address of the first wave (SV_GroupIndex 0 to lanes-1) and
+// reports the accesses where more than one word maps to a bank.
+//
+// Changing the layout would mean rewriting every index computation the
+// shader writes by hand, so conflicts are reported, together with the padding
+// that removes them when the lanes access memory at a fixed stride. The
+// report is printed by -analyze and appended to the /Fstats output.
+class DxilTGSMBankConflicts : public ModulePass {
+  unsigned m_Banks = 32;
+  unsigned m_Lanes = 32;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilTGSMBankConflicts() : ModulePass(ID) {}
+
+  const char *getPassName() const override {
+    return "DXIL groupshared bank conflicts";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  void applyOptions(PassOptions O) override {
+    GetPassOptionUnsigned(O, "banks", &m_Banks, m_Banks);
+    GetPassOptionUnsigned(O, "lanes", &m_Lanes, m_Lanes);
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  void ReportFunction(raw_ostream &OS, Function &F,
+                      const unsigned NumThreads[3]);
+};
+
+static Value *GetTGSMPointer(Instruction *I) {
+  Value *Ptr = nullptr;
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    Ptr = LI->getPointerOperand();
+  else if (StoreInst *SI = dyn_cast<StoreInst>(I))
+    Ptr = SI->getPointerOperand();
+  else if (AtomicRMWInst *RMW = dyn_cast<AtomicRMWInst>(I))
+    Ptr = RMW->getPointerOperand();
+  else if (AtomicCmpXchgInst *CX = dyn_cast<AtomicCmpXchgInst>(I))
+    Ptr = CX->getPointerOperand();
+  if (!Ptr || Ptr->getType()->getPointerAddressSpace() != DXIL::kTGSMAddrSpace)
+    return nullptr;
+  return Ptr;
+}
+
+static const char *GetAccessName(Instruction *I) {
+  if (isa<LoadInst>(I))
+    return "load";
+  if (isa<StoreInst>(I))
+    return "store";
+  return "atomic";
+}
+
+void DxilTGSMBankConflicts::ReportFunction(raw_ostream &OS, Function &F,
+                                           const unsigned NumThreads[3]) {
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  std::unordered_set<Value *> ThreadDependent;
+  CollectThreadDependentValues(F, ThreadDependent);
+
+  // Lay out the first wave over the group, x fastest, as SV_GroupIndex does.
+  unsigned Lanes = m_Lanes;
+  unsigned GroupSize = NumThreads[0] * NumThreads[1] * NumThreads[2];
+  if (GroupSize != 0 && GroupSize < Lanes)
+    Lanes = GroupSize;
+  std::vector<LaneEvaluator> Evaluators;
+  for (unsigned Lane = 0; Lane < Lanes; ++Lane) {
+    unsigned X = std::max(NumThreads[0], 1u);
+    unsigned Y = std::max(NumThreads[1], 1u);
+    unsigned Id[3] = {Lane % X, (Lane / X) % Y, Lane / (X * Y)};
+    Evaluators.emplace_back(DL, ThreadDependent, Id, Lane);
+  }
+
+  for (inst_iterator It = inst_begin(F), E = inst_end(F); It != E; ++It) {
+    Instruction *I = &*It;
+    Value *Ptr = GetTGSMPointer(I);
+    if (!Ptr || !ThreadDependent.count(Ptr))
+      continue;
+    Value *Base = GetUnderlyingObject(Ptr, DL);
+
+    OS << "  " << F.getName() << ": " << GetAccessName(I) << " of @"
+       << Base->getName();
+    if (const DebugLoc &Loc = I->getDebugLoc()) {
+      OS << " at ";
+      Loc.print(OS);
+    }
+
+    Type *AccessTy = cast<PointerType>(Ptr->getType())->getElementType();
+    uint64_t Size = DL.getTypeStoreSize(AccessTy);
+    std::vector<int64_t> Offsets;
+    for (LaneEvaluator &Evaluator : Evaluators) {
+      LaneValue Offset;
+      if (!Evaluator.Evaluate(Ptr, Offset))
+        break;
+      Offsets.push_back(Offset.Known);
+    }
+    if (Offsets.size() != Lanes) {
+      OS << ": address not analyzable\n";
+      continue;
+    }
+
+    // Distinct words each bank serves for the wave.
+    std::map<uint64_t, std::set<int64_t>> BankWords;
+    for (int64_t Offset : Offsets) {
+      int64_t FirstWord = Offset >> 2;
+      int64_t LastWord = (Offset + (int64_t)Size - 1) >> 2;
+      for (int64_t Word = FirstWord; Word <= LastWord; ++Word)
+        BankWords[(uint64_t)Word % m_Banks].insert(Word);
+    }
+    size_t Ways = 1;
+    for (const auto &Bank : BankWords)
+      Ways = std::max(Ways, Bank.second.size());
+
+    bool bFixedStride = Lanes > 1;
+    int64_t Stride = bFixedStride ? Offsets[1] - Offsets[0] : 0;
+    for (unsigned Lane = 2; bFixedStride && Lane < Lanes; ++Lane)
+      bFixedStride = Offsets[Lane] - Offsets[Lane - 1] == Stride;
+
+    if (Ways == 1) {
+      OS << ": no conflict\n";
+      continue;
+    }
+    OS << ": " << Ways << "-way conflict";
+    if (bFixedStride) {
+      OS << ", lane stride " << Stride << " bytes";
+      // One extra word per lane spreads the lanes over all banks.
+      if (Stride > 0 && Stride % 4 == 0 && Size <= 4 &&
+          GreatestCommonDivisor64(Stride / 4 + 1, m_Banks) == 1)
+        OS << "; padding each row by 4 bytes removes it";
+    }
+    OS << "\n";
+  }
+}
+
+bool DxilTGSMBankConflicts::runOnModule(Module &M) {
+  raw_ostream &OS = OSOverride != nullptr ? *OSOverride : errs();
+  DxilModule &DM = M.GetOrCreateDxilModule();
+  Function *Entry = DM.GetEntryFunction();
+  if (m_Banks == 0 || m_Lanes == 0 || !Entry || !DM.GetShaderModel()->IsCS())
+    return false;
+
+  bool bHasTGSM = false;
+  for (GlobalVariable &GV : M.globals())
+    bHasTGSM |= GV.getType()->getAddressSpace() == DXIL::kTGSMAddrSpace;
+  if (!bHasTGSM)
+    return false;
+
+  OS << "Groupshared bank conflicts (" << m_Banks << " banks, " << m_Lanes
+     << " lanes):\n";
+  for (Function &F : M) {
+    if (!F.isDeclaration())
+      ReportFunction(OS, F, DM.m_NumThreads);
+  }
+  return false;
+}
+
+} // namespace
+
+char DxilTGSMBankConflicts::ID = 0;
+
+ModulePass *llvm::createDxilTGSMBankConflictsPass() {
+  return new DxilTGSMBankConflicts();
+}
+
+INITIALIZE_PASS(DxilTGSMBankConflicts, "hlsl-dxil-tgsm-bank-conflicts",
+                "DXIL groupshared bank conflicts", false, true)
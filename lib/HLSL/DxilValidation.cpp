@@ -33,6 +33,7 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/TypeFinder.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -45,6 +46,9 @@
 #include "dxc/HLSL/DxilSignatureAllocator.h"
 #include "dxc/HLSL/DxilRootSignature.h"
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 
 
 using namespace llvm;
@@ -354,6 +358,13 @@ struct ValidationContext {
   const unsigned kLLVMLoopMDKind;
   bool m_bCoverageIn, m_bInnerCoverageIn;
   unsigned m_DxilMajor, m_DxilMinor;
+  // Errors past MaxErrors still fail validation but are not printed; 0 means
+  // no limit.
+  unsigned MaxErrors = 0;
+  unsigned ErrorCount = 0;
+  // What the function bodies use, gathered while validating them, to check
+  // the declared shader flags against.
+  DxilModule::InstructionCensus Census;
 
   ValidationContext(Module &llvmModule, Module *DebugModule,
                     DxilModule &dxilModule,
@@ -377,6 +388,29 @@ struct ValidationContext {
     patchConstCols.resize(DxilMod.GetPatchConstantSignature().GetElements().size(), 0);
   }
 
+  // Creates a context for validating a single function definition on another
+  // thread. Module-level state is shared read-only; diagnostics go to DiagPrn.
+  // The call sets, UAV counter map and signature masks are only consulted when
+  // validating declarations, which always use the module context.
+  ValidationContext(const ValidationContext &ModuleCtx,
+                    DiagnosticPrinterRawOStream &DiagPrn)
+      : M(ModuleCtx.M), pDebugModule(ModuleCtx.pDebugModule),
+        DxilMod(ModuleCtx.DxilMod), DL(ModuleCtx.DL),
+        PSExec(ModuleCtx.PSExec),
+        kDxilControlFlowHintMDKind(ModuleCtx.kDxilControlFlowHintMDKind),
+        kDxilPreciseMDKind(ModuleCtx.kDxilPreciseMDKind),
+        kLLVMLoopMDKind(ModuleCtx.kLLVMLoopMDKind), DiagPrinter(DiagPrn),
+        LastRuleEmit((ValidationRule)-1), m_bCoverageIn(false),
+        m_bInnerCoverageIn(false), hasViewID(false),
+        domainLocSize(ModuleCtx.domainLocSize),
+        m_DxilMajor(ModuleCtx.m_DxilMajor), m_DxilMinor(ModuleCtx.m_DxilMinor),
+        MaxErrors(ModuleCtx.MaxErrors) {
+    for (unsigned i = 0; i < DXIL::kNumOutputStreams; i++) {
+      hasOutputPosition[i] = false;
+      OutputPositionMask[i] = 0;
+    }
+  }
+
   // Provide direct access to the raw_ostream in DiagPrinter.
   raw_ostream &DiagStream() {
     struct DiagnosticPrinterRawOStream_Pub : public DiagnosticPrinterRawOStream {
@@ -387,12 +421,24 @@ struct ValidationContext {
     return p->DiagStream();
   }
 
+  // Counts an error about to be emitted and returns true if it should be
+  // suppressed. The first suppressed error prints a note instead.
+  bool SuppressError() {
+    Failed = true;
+    if (MaxErrors == 0 || ErrorCount++ < MaxErrors)
+      return false;
+    if (ErrorCount == MaxErrors + 1)
+      DiagPrinter << "too many errors emitted, stopping now\n";
+    return true;
+  }
+
   void EmitGlobalValueError(GlobalValue *GV, ValidationRule rule) {
     EmitFormatError(rule, { GV->getName().str() });
   }
 
   // This is the least desirable mechanism, as it has no context.
   void EmitError(ValidationRule rule) {
+    if (SuppressError()) return;
     DiagPrinter << GetValidationRuleText(rule) << '\n';
     Failed = true;
   }
@@ -415,6 +461,7 @@ struct ValidationContext {
   }
 
   void EmitFormatError(ValidationRule rule, ArrayRef<StringRef> args) {
+    if (SuppressError()) return;
     std::string ruleText = GetValidationRuleText(rule);
     FormatRuleText(ruleText, args);
     DiagPrinter << ruleText << '\n';
@@ -422,6 +469,7 @@ struct ValidationContext {
   }
 
   void EmitMetaError(Metadata *Meta, ValidationRule rule) {
+    if (SuppressError()) return;
     DiagPrinter << GetValidationRuleText(rule);
     Meta->print(DiagStream(), &M);
     DiagPrinter << '\n';
@@ -429,6 +477,7 @@ struct ValidationContext {
   }
 
   void EmitResourceError(const hlsl::DxilResourceBase *Res, ValidationRule rule) {
+    if (SuppressError()) return;
     DiagPrinter << GetValidationRuleText(rule);
     DiagPrinter << '\'' << Res->GetGlobalName() << '\'';
     DiagPrinter << '\n';
@@ -438,6 +487,7 @@ struct ValidationContext {
   void EmitResourceFormatError(const hlsl::DxilResourceBase *Res,
                                ValidationRule rule,
                                ArrayRef<StringRef> args) {
+    if (SuppressError()) return;
     std::string ruleText = GetValidationRuleText(rule);
     FormatRuleText(ruleText, args);
     DiagPrinter << ruleText;
@@ -483,11 +533,15 @@ struct ValidationContext {
       }
       LastRuleEmit = Rule;
       LastDebugLocEmit = L;
+      if (SuppressError())
+        return false;
 
       L.print(DiagStream());
       DiagPrinter << ' ';
       return true;
     }
+    if (SuppressError())
+      return false;
     BasicBlock *BB = I->getParent();
     Function *F = BB->getParent();
 
@@ -2085,7 +2139,8 @@ static bool GetNodeOperandAsInt(ValidationContext &ValCtx, MDNode *pMD, unsigned
 }
 
 static bool IsPrecise(Instruction &I, ValidationContext &ValCtx) {
-  MDNode *pMD = I.getMetadata(DxilMDHelper::kDxilPreciseAttributeMDName);
+  // Look up by kind rather than name; this runs on validation worker threads.
+  MDNode *pMD = I.getMetadata(ValCtx.kDxilPreciseMDKind);
   if (pMD == nullptr) {
     return false;
   }
@@ -2321,6 +2376,7 @@ static void ValidateFunctionBody(Function *F, ValidationContext &ValCtx) {
   for (auto b = F->begin(), bend = F->end(); b != bend; ++b) {
     for (auto i = b->begin(), iend = b->end(); i != iend; ++i) {
       llvm::Instruction &I = *i;
+      ValCtx.Census.AddInstruction(I);
 
       if (I.hasMetadata()) {
         ValidateInstructionMetadata(&I, ValCtx);
@@ -2577,6 +2633,8 @@ static void ValidateFunction(Function &F, ValidationContext &ValCtx) {
     if (!funcAnnotation) {
       ValCtx.EmitFormatError(ValidationRule::MetaFunctionAnnotation,
                              {F.getName().str()});
+      // The body is not validated, but still counts towards the flags.
+      ValCtx.Census.AddFunction(F);
       return;
     }
 
@@ -2614,6 +2672,108 @@ static void ValidateFunction(Function &F, ValidationContext &ValCtx) {
   }
 }
 
+namespace {
+// Diagnostics produced while validating one function definition.
+struct FunctionValidationResult {
+  std::string Diag;
+  bool Failed = false;
+  unsigned ErrorCount = 0;
+  DxilModule::InstructionCensus Census;
+  std::exception_ptr Error;
+};
+}
+
+static void ValidateFunctionDefinition(Function &F,
+                                       const ValidationContext &ModuleCtx,
+                                       FunctionValidationResult &Result) {
+  try {
+    raw_string_ostream diagStream(Result.Diag);
+    DiagnosticPrinterRawOStream DiagPrinter(diagStream);
+    ValidationContext ValCtx(ModuleCtx, DiagPrinter);
+    ValidateFunction(F, ValCtx);
+    diagStream.flush();
+    Result.Failed = ValCtx.Failed;
+    Result.ErrorCount = ValCtx.ErrorCount;
+    Result.Census = std::move(ValCtx.Census);
+  } catch (...) {
+    Result.Error = std::current_exception();
+  }
+}
+
+// Function definitions are validated concurrently, each into its own
+// diagnostic buffer, and the buffers are merged in module order so the output
+// does not depend on scheduling. Declarations are validated on this thread
+// with the module context as part of the merge, as they update cross-function
+// state and may add DXIL operation declarations to the module. Small modules
+// are validated serially, straight into the module diagnostics.
+static void ValidateFunctions(ValidationContext &ValCtx) {
+  const unsigned kMinFunctionsPerThread = 8;
+
+  unsigned definitionCount = 0;
+  for (Function &F : ValCtx.M.functions())
+    definitionCount += F.isDeclaration() ? 0 : 1;
+  unsigned threadCount = std::min<unsigned>(
+      std::thread::hardware_concurrency(),
+      definitionCount / kMinFunctionsPerThread);
+  if (threadCount <= 1) {
+    for (Function &F : ValCtx.M.functions())
+      ValidateFunction(F, ValCtx);
+    return;
+  }
+
+  std::vector<Function *> definitions;
+  std::unordered_map<Function *, unsigned> definitionIndex;
+  for (Function &F : ValCtx.M.functions()) {
+    if (!F.isDeclaration()) {
+      definitionIndex[&F] = definitions.size();
+      definitions.push_back(&F);
+    }
+  }
+
+  // DataLayout computes struct layouts on first use; build them up front so
+  // the workers only read from it.
+  TypeFinder structTypes;
+  structTypes.run(ValCtx.M, /*onlyNamed*/ false);
+  for (StructType *ST : structTypes) {
+    if (ST->isSized())
+      ValCtx.DL.getStructLayout(ST);
+  }
+
+  std::vector<FunctionValidationResult> results(definitions.size());
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < definitions.size(); i = next++)
+      ValidateFunctionDefinition(*definitions[i], ValCtx, results[i]);
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+
+  for (Function &F : ValCtx.M.functions()) {
+    auto it = definitionIndex.find(&F);
+    if (it == definitionIndex.end()) {
+      ValidateFunction(F, ValCtx);
+      continue;
+    }
+    FunctionValidationResult &result = results[it->second];
+    if (result.Error)
+      std::rethrow_exception(result.Error);
+    // Each worker applied the error limit on its own; apply it again across
+    // functions, and free each buffer once it has been written out.
+    if (ValCtx.MaxErrors == 0 || ValCtx.ErrorCount < ValCtx.MaxErrors)
+      ValCtx.DiagStream() << result.Diag;
+    else if (result.ErrorCount && ValCtx.ErrorCount == ValCtx.MaxErrors)
+      ValCtx.DiagStream() << "too many errors emitted, stopping now\n";
+    ValCtx.ErrorCount += result.ErrorCount;
+    ValCtx.Failed |= result.Failed;
+    ValCtx.Census.Merge(result.Census);
+    std::string().swap(result.Diag);
+  }
+}
+
 static void ValidateGlobalVariable(GlobalVariable &GV,
                                    ValidationContext &ValCtx) {
   bool isInternalGV =
@@ -2662,41 +2822,135 @@ static void CollectFixAddressAccess(Value *V,
   }
 }
 
-static bool IsDivergent(Value *V) {
-  // TODO: return correct result.
-  return false;
+struct DxilValidationAnalyses::FunctionAnalyses {
+  std::unique_ptr<DominatorTree> DT;
+  std::unique_ptr<LoopInfo> LI;
+  std::unique_ptr<PostDominatorTree> PDT;
+};
+
+DxilValidationAnalyses::DxilValidationAnalyses(Module &M)
+    : m_Module(M), m_Reducible(-1) {}
+
+DxilValidationAnalyses::~DxilValidationAnalyses() {}
+
+bool DxilValidationAnalyses::IsReducible() {
+  if (m_Reducible < 0)
+    m_Reducible = llvm::IsReducible(m_Module, IrreducibilityAction::Ignore);
+  return m_Reducible != 0;
 }
 
-static void ValidateTGSMRaceCondition(std::vector<StoreInst *> &fixAddrTGSMList,
-                                      ValidationContext &ValCtx) {
-  std::unordered_set<Function *> fixAddrTGSMFuncSet;
-  for (StoreInst *I : fixAddrTGSMList) {
-    BasicBlock *BB = I->getParent();
-    fixAddrTGSMFuncSet.insert(BB->getParent());
+CallGraph &DxilValidationAnalyses::GetCallGraph() {
+  if (!m_CallGraph)
+    m_CallGraph = llvm::make_unique<CallGraph>(m_Module);
+  return *m_CallGraph;
+}
+
+DxilValidationAnalyses::FunctionAnalyses &
+DxilValidationAnalyses::GetFunctionAnalyses(Function &F) {
+  DXASSERT(F.getParent() == &m_Module, "analyses are for another module");
+  std::unique_ptr<FunctionAnalyses> &FA = m_FunctionAnalyses[&F];
+  if (!FA)
+    FA = llvm::make_unique<FunctionAnalyses>();
+  return *FA;
+}
+
+DominatorTree &DxilValidationAnalyses::GetDominatorTree(Function &F) {
+  FunctionAnalyses &FA = GetFunctionAnalyses(F);
+  if (!FA.DT) {
+    FA.DT = llvm::make_unique<DominatorTree>();
+    FA.DT->recalculate(F);
   }
+  return *FA.DT;
+}
 
-  for (auto &F : ValCtx.DxilMod.GetModule()->functions()) {
-    if (F.isDeclaration() || !fixAddrTGSMFuncSet.count(&F))
+LoopInfo &DxilValidationAnalyses::GetLoopInfo(Function &F) {
+  FunctionAnalyses &FA = GetFunctionAnalyses(F);
+  if (!FA.LI) {
+    FA.LI = llvm::make_unique<LoopInfo>();
+    FA.LI->Analyze(GetDominatorTree(F));
+  }
+  return *FA.LI;
+}
+
+PostDominatorTree &DxilValidationAnalyses::GetPostDominatorTree(Function &F) {
+  FunctionAnalyses &FA = GetFunctionAnalyses(F);
+  if (!FA.PDT) {
+    FA.PDT = llvm::make_unique<PostDominatorTree>();
+    FA.PDT->runOnFunction(F);
+  }
+  return *FA.PDT;
+}
+
+// Collects the instructions of F whose value can differ between the threads
+// of a group: thread ids, wave intrinsic results, and everything computed
+// from them. Each instruction is visited at most once.
+static void CollectDivergentInstructions(Function &F,
+                                         std::unordered_set<Value *> &divergent) {
+  std::vector<Instruction *> workList;
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    CallInst *CI = dyn_cast<CallInst>(&*I);
+    if (!CI || !OP::IsDxilOpFuncCallInst(CI))
       continue;
+    DXIL::OpCode opcode = OP::GetDxilOpFuncCallInst(CI);
+    switch (opcode) {
+    case DXIL::OpCode::ThreadId:
+    case DXIL::OpCode::ThreadIdInGroup:
+    case DXIL::OpCode::FlattenedThreadIdInGroup:
+      break;
+    default:
+      if (!OP::IsDxilOpWave(opcode))
+        continue;
+    }
+    if (divergent.insert(CI).second)
+      workList.emplace_back(CI);
+  }
 
-    PostDominatorTree PDT;
-    PDT.runOnFunction(F);
+  while (!workList.empty()) {
+    Instruction *I = workList.back();
+    workList.pop_back();
+    for (User *U : I->users()) {
+      if (isa<Instruction>(U) && divergent.insert(U).second)
+        workList.emplace_back(cast<Instruction>(U));
+    }
+  }
+}
+
+static void ValidateTGSMRaceCondition(std::vector<StoreInst *> &fixAddrTGSMList,
+                                      ValidationContext &ValCtx,
+                                      DxilValidationAnalyses &Analyses) {
+  // Bucket the stores by function so each function is analyzed once.
+  std::unordered_map<Function *, std::vector<StoreInst *>> funcStores;
+  for (StoreInst *SI : fixAddrTGSMList)
+    funcStores[SI->getParent()->getParent()].emplace_back(SI);
+
+  std::unordered_set<Value *> divergent;
+  for (auto &F : ValCtx.DxilMod.GetModule()->functions()) {
+    auto it = funcStores.find(&F);
+    if (F.isDeclaration() || it == funcStores.end())
+      continue;
 
+    PostDominatorTree &PDT = Analyses.GetPostDominatorTree(F);
     BasicBlock *Entry = &F.getEntryBlock();
 
-    for (StoreInst *SI : fixAddrTGSMList) {
-      BasicBlock *BB = SI->getParent();
-      if (BB->getParent() == &F) {
-        if (PDT.dominates(BB, Entry)) {
-          if (IsDivergent(SI->getValueOperand()))
-            ValCtx.EmitInstrError(SI, ValidationRule::InstrTGSMRaceCond);
-        }
+    // Only stores every thread executes can race; find those before paying
+    // for the divergence analysis.
+    bool bDivergenceComputed = false;
+    for (StoreInst *SI : it->second) {
+      if (!PDT.dominates(SI->getParent(), Entry))
+        continue;
+      if (!bDivergenceComputed) {
+        divergent.clear();
+        CollectDivergentInstructions(F, divergent);
+        bDivergenceComputed = true;
       }
+      if (divergent.count(SI->getValueOperand()))
+        ValCtx.EmitInstrError(SI, ValidationRule::InstrTGSMRaceCond);
     }
   }
 }
 
-static void ValidateGlobalVariables(ValidationContext &ValCtx) {
+static void ValidateGlobalVariables(ValidationContext &ValCtx,
+                                    DxilValidationAnalyses &Analyses) {
   DxilModule &M = ValCtx.DxilMod;
 
   unsigned TGSMSize = 0;
@@ -2716,7 +2970,7 @@ static void ValidateGlobalVariables(ValidationContext &ValCtx) {
                             std::to_string(DXIL::kMaxTGSMSize)});
   }
   if (!fixAddrTGSMList.empty()) {
-    ValidateTGSMRaceCondition(fixAddrTGSMList, ValCtx);
+    ValidateTGSMRaceCondition(fixAddrTGSMList, ValCtx, Analyses);
   }
 }
 
@@ -2796,6 +3050,25 @@ static void ValidateMetadata(ValidationContext &ValCtx) {
     }
   }
 
+  // Compact type annotations are only understood by validator 1.2 and up.
+  if (NamedMDNode *pTypeAnnotations = pModule->getNamedMetadata(
+          DxilMDHelper::kDxilTypeSystemMDName)) {
+    unsigned ValMajor, ValMinor;
+    ValCtx.DxilMod.GetValidatorVersion(ValMajor, ValMinor);
+    bool bCompactAllowed =
+        ValMajor > DxilMDHelper::kDxilTypeSystemCompactMinValMajor ||
+        (ValMajor == DxilMDHelper::kDxilTypeSystemCompactMinValMajor &&
+         ValMinor >= DxilMDHelper::kDxilTypeSystemCompactMinValMinor);
+    for (MDNode *pNode : pTypeAnnotations->operands()) {
+      uint64_t Tag;
+      if (!bCompactAllowed && pNode->getNumOperands() > 0 &&
+          GetNodeOperandAsInt(ValCtx, pNode, 0, &Tag) &&
+          Tag == DxilMDHelper::kDxilTypeSystemCompactStructTag) {
+        ValCtx.EmitMetaError(pNode, ValidationRule::MetaWellFormed);
+      }
+    }
+  }
+
   const hlsl::ShaderModel *SM = ValCtx.DxilMod.GetShaderModel();
   if (!SM->IsValidForDxil()) {
     ValCtx.EmitFormatError(ValidationRule::SmName,
@@ -3081,9 +3354,11 @@ static void ValidateResources(ValidationContext &ValCtx) {
   }
 }
 
+// Function bodies must have been validated, which gathers the census the flags
+// are computed from.
 static void ValidateShaderFlags(ValidationContext &ValCtx) {
   DxilModule::ShaderFlags calcFlags;
-  ValCtx.DxilMod.CollectShaderFlags(calcFlags);
+  ValCtx.DxilMod.CollectShaderFlags(calcFlags, ValCtx.Census);
   const uint64_t mask = DxilModule::ShaderFlags::GetShaderFlagsRawForCollection();
   uint64_t declaredFlagsRaw = ValCtx.DxilMod.m_ShaderFlags.GetShaderFlagsRaw();
   uint64_t calcFlagsRaw = calcFlags.GetShaderFlagsRaw();
@@ -4019,9 +4294,9 @@ CalculateCallDepth(CallGraphNode *node,
   return false;
 }
 
-static void ValidateCallGraph(ValidationContext &ValCtx) {
-  // Build CallGraph.
-  CallGraph CG(*ValCtx.DxilMod.GetModule());
+static void ValidateCallGraph(ValidationContext &ValCtx,
+                              DxilValidationAnalyses &Analyses) {
+  CallGraph &CG = Analyses.GetCallGraph();
 
   std::unordered_map<CallGraphNode*, unsigned> depthMap;
   std::unordered_set<CallGraphNode*> callStack;
@@ -4040,24 +4315,20 @@ static void ValidateCallGraph(ValidationContext &ValCtx) {
   }
 }
 
-static void ValidateFlowControl(ValidationContext &ValCtx) {
-  bool reducible =
-      IsReducible(*ValCtx.DxilMod.GetModule(), IrreducibilityAction::Ignore);
-  if (!reducible) {
+static void ValidateFlowControl(ValidationContext &ValCtx,
+                                DxilValidationAnalyses &Analyses) {
+  if (!Analyses.IsReducible()) {
     ValCtx.EmitError(ValidationRule::FlowReducible);
     return;
   }
 
-  ValidateCallGraph(ValCtx);
+  ValidateCallGraph(ValCtx, Analyses);
 
   for (auto &F : ValCtx.DxilMod.GetModule()->functions()) {
     if (F.isDeclaration())
       continue;
 
-    DominatorTreeAnalysis DTA;
-    DominatorTree DT = DTA.run(F);
-    LoopInfo LI;
-    LI.Analyze(DT);
+    LoopInfo &LI = Analyses.GetLoopInfo(F);
     for (auto loopIt = LI.begin(); loopIt != LI.end(); loopIt++) {
       Loop *loop = *loopIt;
       SmallVector<BasicBlock *, 4> exitBlocks;
@@ -4101,15 +4372,28 @@ void GetValidationVersion(_Out_ unsigned *pMajor, _Out_ unsigned *pMinor) {
   // 1.0 is the first validator.
   // 1.1 adds:
   // - ILDN container part support
+  // 1.2 adds:
+  // - compact type annotation metadata
   *pMajor = 1;
-  *pMinor = 1;
+  *pMinor = 2;
 }
 
 _Use_decl_annotations_ HRESULT
-ValidateDxilModule(llvm::Module *pModule, llvm::Module *pDebugModule) {
+ValidateDxilModule(llvm::Module *pModule, llvm::Module *pDebugModule,
+                   DxilValidationAnalyses *pAnalyses,
+                   llvm::raw_ostream *pDiagStream, unsigned MaxErrors) {
   std::string diagStr;
-  raw_string_ostream diagStream(diagStr);
+  raw_string_ostream diagStringStream(diagStr);
+  raw_ostream &diagStream = pDiagStream ? *pDiagStream : diagStringStream;
   DiagnosticPrinterRawOStream DiagPrinter(diagStream);
+  // Without a caller stream, diagnostics are buffered and reported through
+  // the module's context in one piece.
+  auto reportDiag = [&]() {
+    if (pDiagStream)
+      pDiagStream->flush();
+    else
+      emitDxilDiag(pModule->getContext(), diagStringStream.str().c_str());
+  };
 
   DxilModule *pDxilModule = DxilModule::TryGetDxilModule(pModule);
   if (!pDxilModule) {
@@ -4117,23 +4401,40 @@ ValidateDxilModule(llvm::Module *pModule, llvm::Module *pDebugModule) {
   }
 
   ValidationContext ValCtx(*pModule, pDebugModule, *pDxilModule, DiagPrinter);
+  ValCtx.MaxErrors = MaxErrors;
 
   ValidateMetadata(ValCtx);
 
   ValidateShaderState(ValCtx);
 
-  ValidateGlobalVariables(ValCtx);
+  // The remaining checks look at function bodies or at uses, which a lazily
+  // loaded module only has once every function is materialized. The debug
+  // module is read from the function validation threads, so it is
+  // materialized here as well.
+  if (pModule->materializeAllPermanently() ||
+      (pDebugModule && pDebugModule->materializeAllPermanently())) {
+    reportDiag();
+    return DXC_E_IR_VERIFICATION_FAILED;
+  }
+
+  std::unique_ptr<DxilValidationAnalyses> pLocalAnalyses;
+  if (!pAnalyses) {
+    pLocalAnalyses = llvm::make_unique<DxilValidationAnalyses>(*pModule);
+    pAnalyses = pLocalAnalyses.get();
+  }
+  DXASSERT(&pAnalyses->GetModule() == pModule,
+           "analyses must be computed for the validated module");
+
+  ValidateGlobalVariables(ValCtx, *pAnalyses);
 
   ValidateResources(ValCtx);
 
   // Validate control flow and collect function call info.
   // If has recursive call, call info collection will not finish.
-  ValidateFlowControl(ValCtx);
+  ValidateFlowControl(ValCtx, *pAnalyses);
 
   // Validate functions.
-  for (Function &F : pModule->functions()) {
-    ValidateFunction(F, ValCtx);
-  }
+  ValidateFunctions(ValCtx);
 
   ValidateUninitializedOutput(ValCtx);
 
@@ -4160,7 +4461,7 @@ ValidateDxilModule(llvm::Module *pModule, llvm::Module *pDebugModule) {
 
   // Ensure error messages are flushed out on error.
   if (ValCtx.Failed) {
-    emitDxilDiag(pModule->getContext(), diagStream.str().c_str());
+    reportDiag();
     return DXC_E_IR_VERIFICATION_FAILED;
   }
   return S_OK;
@@ -4168,6 +4469,26 @@ ValidateDxilModule(llvm::Module *pModule, llvm::Module *pDebugModule) {
 
 // DXIL Container Verification Functions
 
+// Returns true if pWriter produces exactly the Size bytes at pData.
+static bool BlobPartMatches(DxilPartWriter *pWriter,
+                            _In_reads_bytes_(Size) const void *pData,
+                            _In_ uint32_t Size) {
+  if (pWriter->size() != Size)
+    return false;
+  if (Size == 0)
+    return true;
+
+  CComPtr<IMalloc> pMalloc;
+  IFT(CoGetMalloc(1, &pMalloc));
+  CComPtr<AbstractMemoryStream> pOutputStream;
+  IFT(CreateMemoryStream(pMalloc, &pOutputStream));
+  pOutputStream->Reserve(Size);
+
+  pWriter->write(pOutputStream);
+  DXASSERT(pOutputStream->GetPtrSize() == Size, "otherwise, DxilPartWriter misreported size");
+  return memcmp(pData, pOutputStream->GetPtr(), Size) == 0;
+}
+
 static void VerifyBlobPartMatches(_In_ ValidationContext &ValCtx,
                                   _In_ LPCSTR pName,
                                   DxilPartWriter *pWriter,
@@ -4179,26 +4500,7 @@ static void VerifyBlobPartMatches(_In_ ValidationContext &ValCtx,
     return;
   }
 
-  // Compare sizes
-  if (pWriter->size() != Size) {
-    ValCtx.EmitFormatError(ValidationRule::ContainerPartMatches, {pName});
-    return;
-  }
-
-  if (Size == 0) {
-    return;
-  }
-
-  CComPtr<IMalloc> pMalloc;
-  IFT(CoGetMalloc(1, &pMalloc));
-  CComPtr<AbstractMemoryStream> pOutputStream;
-  IFT(CreateMemoryStream(pMalloc, &pOutputStream));
-  pOutputStream->Reserve(Size);
-
-  pWriter->write(pOutputStream);
-  DXASSERT(pOutputStream->GetPtrSize() == Size, "otherwise, DxilPartWriter misreported size");
-
-  if (memcmp(pData, pOutputStream->GetPtr(), Size)) {
+  if (!BlobPartMatches(pWriter, pData, Size)) {
     ValCtx.EmitFormatError(ValidationRule::ContainerPartMatches, {pName});
     return;
   }
@@ -4227,6 +4529,13 @@ static void VerifySignatureMatches(_In_ ValidationContext &ValCtx,
   }
 
   unique_ptr<DxilPartWriter> pWriter(NewProgramSignatureWriter(ValCtx.DxilMod, SigKind));
+  if (pSigData && !BlobPartMatches(pWriter.get(), pSigData, SigSize)) {
+    // The container may have been written with deduplicated strings.
+    unique_ptr<DxilPartWriter> pDedupWriter(
+        NewProgramSignatureWriter(ValCtx.DxilMod, SigKind, /*bDedupStrings*/ true));
+    if (BlobPartMatches(pDedupWriter.get(), pSigData, SigSize))
+      return;
+  }
   VerifyBlobPartMatches(ValCtx, pName, pWriter.get(), pSigData, SigSize);
 }
 
@@ -4249,13 +4558,23 @@ bool VerifySignatureMatches(llvm::Module *pModule,
 static void VerifyPSVMatches(_In_ ValidationContext &ValCtx,
                              _In_reads_bytes_(PSVSize) const void *pPSVData,
                              _In_ uint32_t PSVSize) {
-  uint32_t PSVVersion = 1;  // This should be set to the newest version
+  uint32_t PSVVersion = 2;  // This should be set to the newest version
   unique_ptr<DxilPartWriter> pWriter(NewPSVWriter(ValCtx.DxilMod, PSVVersion));
   // Try each version in case an earlier version matches module
   while (PSVVersion && pWriter->size() != PSVSize) {
     PSVVersion --;
     pWriter.reset(NewPSVWriter(ValCtx.DxilMod, PSVVersion));
   }
+  if (pPSVData && !BlobPartMatches(pWriter.get(), pPSVData, PSVSize)) {
+    // With deduplicated strings the size is smaller, so try each version
+    // again. Version 0 has no strings.
+    for (uint32_t Version = 2; Version > 0; --Version) {
+      unique_ptr<DxilPartWriter> pDedupWriter(
+          NewPSVWriter(ValCtx.DxilMod, Version, /*bDedupStrings*/ true));
+      if (BlobPartMatches(pDedupWriter.get(), pPSVData, PSVSize))
+        return;
+    }
+  }
   // generate PSV data from module and memcmp
   VerifyBlobPartMatches(ValCtx, "Pipeline State Validation", pWriter.get(), pPSVData, PSVSize);
 }
@@ -4370,6 +4689,7 @@ HRESULT ValidateDxilContainerParts(llvm::Module *pModule,
     case DFCC_PrivateData:
     case DFCC_DXIL:
     case DFCC_ShaderDebugInfoDXIL:
+    case DFCC_ShaderDebugInfoDXILCompressed:
     case DFCC_ShaderDebugName:
       continue;
 
@@ -4459,7 +4779,8 @@ HRESULT ValidateLoadModule(const char *pIL,
                            uint32_t ILLength,
                            unique_ptr<llvm::Module> &pModule,
                            LLVMContext &Ctx,
-                           llvm::raw_ostream &DiagStream) {
+                           llvm::raw_ostream &DiagStream,
+                           bool bLazy) {
 
   llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
   PrintDiagnosticContext DiagContext(DiagPrinter);
@@ -4468,8 +4789,9 @@ HRESULT ValidateLoadModule(const char *pIL,
   std::unique_ptr<llvm::MemoryBuffer> pBitcodeBuf;
   pBitcodeBuf.reset(llvm::MemoryBuffer::getMemBuffer(
       llvm::StringRef(pIL, ILLength), "", false).release());
-  ErrorOr<std::unique_ptr<llvm::Module>> loadedModuleResult(llvm::parseBitcodeFile(
-    pBitcodeBuf->getMemBufferRef(), Ctx));
+  ErrorOr<std::unique_ptr<llvm::Module>> loadedModuleResult =
+      bLazy ? llvm::getLazyBitcodeModule(std::move(pBitcodeBuf), Ctx)
+            : llvm::parseBitcodeFile(pBitcodeBuf->getMemBufferRef(), Ctx);
 
   // DXIL disallows some LLVM bitcode constructs, like unaccounted-for sub-blocks.
   // These appear as warnings, which the validator should reject.
@@ -4542,7 +4864,7 @@ HRESULT ValidateLoadModuleFromContainer(
     _In_ uint32_t ContainerSize, _In_ std::unique_ptr<llvm::Module> &pModule,
     _In_ std::unique_ptr<llvm::Module> &pDebugModule,
     _In_ llvm::LLVMContext &Ctx, LLVMContext &DbgCtx,
-    _In_ llvm::raw_ostream &DiagStream) {
+    _In_ llvm::raw_ostream &DiagStream, _In_ bool bLazy) {
   llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
   PrintDiagnosticContext DiagContext(DiagPrinter);
   DiagRestore DR(Ctx, &DiagContext);
@@ -4557,7 +4879,7 @@ HRESULT ValidateLoadModuleFromContainer(
       reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)), &pIL,
       &ILLength);
 
-  IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream));
+  IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream, bLazy));
 
   HRESULT hr;
   const DxilPartHeader *pDbgPart = nullptr;
@@ -4572,7 +4894,25 @@ HRESULT ValidateLoadModuleFromContainer(
         reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pDbgPart)),
         &pIL, &ILLength);
     if (FAILED(hr = ValidateLoadModule(pIL, ILLength, pDebugModule, DbgCtx,
-                                       DiagStream))) {
+                                       DiagStream, bLazy))) {
+      return hr;
+    }
+  } else if (const DxilPartHeader *pCompressedPart = GetDxilPartByType(
+                 reinterpret_cast<const DxilContainerHeader *>(pContainer),
+                 DFCC_ShaderDebugInfoDXILCompressed)) {
+    // The decompressed bitcode does not outlive this call, so load it eagerly.
+    SmallVector<char, 0> DebugPartData;
+    if (!DecompressDxilPartData(pCompressedPart, DebugPartData)) {
+      return DXC_E_CONTAINER_INVALID;
+    }
+    const DxilProgramHeader *pProgramHeader =
+        reinterpret_cast<const DxilProgramHeader *>(DebugPartData.data());
+    if (!IsValidDxilProgramHeader(pProgramHeader, DebugPartData.size())) {
+      return DXC_E_CONTAINER_INVALID;
+    }
+    GetDxilProgramBitcode(pProgramHeader, &pIL, &ILLength);
+    if (FAILED(hr = ValidateLoadModule(pIL, ILLength, pDebugModule, DbgCtx,
+                                       DiagStream, /*bLazy*/ false))) {
       return hr;
     }
   }
@@ -4595,7 +4935,7 @@ HRESULT ValidateDxilContainer(const void *pContainer,
                               &DiagContext, true);
 
   IFR(ValidateLoadModuleFromContainer(pContainer, ContainerSize, pModule, pDebugModule,
-      Ctx, DbgCtx, DiagStream));
+      Ctx, DbgCtx, DiagStream, /*bLazy*/ true));
 
   // Validate DXIL Module
   IFR(ValidateDxilModule(pModule.get(), pDebugModule.get()));
@@ -15,11 +15,14 @@
 #include "dxc/HLSL/HLModule.h"
 #include "dxc/HlslIntrinsicOp.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/Cancellation.h"
 #include "dxc/HLSL/DxilOperations.h"
+#include "dxc/HLSL/DxilTypeSystem.h"
 
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Pass.h"
@@ -173,6 +176,7 @@ public:
 
       if (F.isDeclaration())
         continue;
+      hlsl::ThrowIfCancellationRequested();
       runOnFunction(F);
     }
     std::vector<GlobalVariable*> staticGVs;
@@ -234,6 +238,11 @@ private:
                           CallInst *mulInst, bool isSigned);
   void TranslateMul(CallInst *matInst, Instruction *vecInst, CallInst *mulInst,
                     bool isSigned);
+  // Get the elements of matrix matVal known to be constant, in row major
+  // order and null where unknown, for mul to skip terms. Returns false if
+  // no element is known.
+  bool GetKnownMatElements(Value *matVal, SmallVectorImpl<Constant *> &elts);
+  bool IsAffineMatPtr(Value *matPtr);
   // Replace matInst with vecInst on transposeInst.
   void TranslateMatTranspose(CallInst *matInst, Instruction *vecInst,
                              CallInst *transposeInst);
@@ -280,6 +289,9 @@ private:
   void DeleteDeadInsts();
   // Map from matrix inst to its vector version.
   DenseMap<Instruction *, Value *> matToVecMap;
+  // The keys of matToVecMap in the order lowerToVec created them, which is
+  // program order. The later sweeps walk this rather than the map.
+  std::vector<Instruction *> m_matInsts;
 };
 }
 
@@ -778,6 +790,7 @@ void HLMatrixLowerPass::lowerToVec(Instruction *matInst) {
     DXASSERT(0, "invalid inst");
   }
   matToVecMap[matInst] = vecInst;
+  m_matInsts.emplace_back(matInst);
 }
 
 // Replace matInst with vecInst on matUseInst.
@@ -838,6 +851,141 @@ static Function *GetOrCreateMadIntrinsic(Type *Ty, Type *opcodeTy, IntrinsicOp m
   return MAD;
 }
 
+// A matrix loaded through a GEP whose last struct field is annotated
+// [affine] has a last row of 0, 0, 0, 1. Array indices after the field are
+// fine, as the annotation covers every matrix of an array.
+bool HLMatrixLowerPass::IsAffineMatPtr(Value *matPtr) {
+  GEPOperator *GEP = dyn_cast<GEPOperator>(matPtr);
+  if (!GEP)
+    return false;
+  DxilTypeSystem &typeSys = m_pHLModule->GetTypeSystem();
+  const DxilFieldAnnotation *fieldAnnotation = nullptr;
+  for (gep_type_iterator GI = gep_type_begin(*GEP), E = gep_type_end(*GEP);
+       GI != E; ++GI) {
+    StructType *ST = dyn_cast<StructType>(*GI);
+    if (!ST)
+      continue;
+    DxilStructAnnotation *annotation = typeSys.GetStructAnnotation(ST);
+    ConstantInt *fieldIdx = dyn_cast<ConstantInt>(GI.getOperand());
+    if (!annotation || !fieldIdx ||
+        fieldIdx->getLimitedValue() >= annotation->GetNumFields())
+      return false;
+    fieldAnnotation =
+        &annotation->GetFieldAnnotation(fieldIdx->getLimitedValue());
+  }
+  return fieldAnnotation && fieldAnnotation->IsAffine();
+}
+
+bool HLMatrixLowerPass::GetKnownMatElements(Value *matVal,
+                                            SmallVectorImpl<Constant *> &elts) {
+  CallInst *CI = dyn_cast<CallInst>(matVal);
+  if (!CI)
+    return false;
+  unsigned col, row;
+  Type *EltTy = GetMatrixInfo(matVal->getType(), col, row);
+  elts.assign(col * row, nullptr);
+
+  switch (GetHLOpcodeGroupByName(CI->getCalledFunction())) {
+  case HLOpcodeGroup::HLInit: {
+    // InitList is row major. Only scalar and vector parts are looked at.
+    unsigned idx = 0;
+    bool known = false;
+    for (unsigned i = HLOperandIndex::kInitFirstArgOpIdx;
+         i < CI->getNumArgOperands(); i++) {
+      Value *val = CI->getArgOperand(i);
+      Type *Ty = val->getType();
+      if (!Ty->isSingleValueType())
+        return false;
+      unsigned size = Ty->isVectorTy() ? Ty->getVectorNumElements() : 1;
+      if (idx + size > elts.size())
+        return false;
+      if (Constant *C = dyn_cast<Constant>(val)) {
+        for (unsigned j = 0; j < size; j++) {
+          Constant *elt = Ty->isVectorTy() ? C->getAggregateElement(j) : C;
+          if (elt && elt->getType() == EltTy && !isa<UndefValue>(elt)) {
+            elts[idx + j] = elt;
+            known = true;
+          }
+        }
+      }
+      idx += size;
+    }
+    return known && idx == elts.size();
+  }
+  case HLOpcodeGroup::HLMatLoadStore: {
+    HLMatLoadStoreOpcode opcode =
+        static_cast<HLMatLoadStoreOpcode>(GetHLOpcode(CI));
+    if (opcode != HLMatLoadStoreOpcode::ColMatLoad &&
+        opcode != HLMatLoadStoreOpcode::RowMatLoad)
+      return false;
+    if (row != 4 || col != 4 || !EltTy->isFloatingPointTy() ||
+        !IsAffineMatPtr(CI->getArgOperand(HLOperandIndex::kMatLoadPtrOpIdx)))
+      return false;
+    for (unsigned c = 0; c < col; c++)
+      elts[HLMatrixLower::GetRowMajorIdx(row - 1, c, col)] =
+          c == col - 1 ? ConstantFP::get(EltTy, 1.0)
+                       : ConstantFP::get(EltTy, 0.0);
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+static bool IsKnownZero(Constant *C) { return C && C->isNullValue(); }
+
+static bool IsKnownOne(Constant *C) {
+  if (!C)
+    return false;
+  if (ConstantFP *CFP = dyn_cast<ConstantFP>(C))
+    return CFP->isExactlyValue(1.0);
+  return C->isOneValue();
+}
+
+namespace {
+// Builds one element of a mul as a chain of a multiply and mads, using what
+// is known about the factors of each term: a factor of one is dropped, and a
+// term with a factor of zero is skipped unless IEEE strictness asks to keep
+// the NaN and sign of zero such a product may have.
+class MulEltBuilder {
+public:
+  MulEltBuilder(IRBuilder<> &Builder, Function *Mad, Value *madOpArg,
+                bool isFloat, bool skipZeroTerms)
+      : Builder(Builder), Mad(Mad), madOpArg(madOpArg), isFloat(isFloat),
+        skipZeroTerms(skipZeroTerms), acc(nullptr) {}
+
+  void AddTerm(Value *l, Constant *lKnown, Value *r, Constant *rKnown) {
+    if (skipZeroTerms && (IsKnownZero(lKnown) || IsKnownZero(rKnown)))
+      return;
+    Value *prod = IsKnownOne(lKnown) ? r : IsKnownOne(rKnown) ? l : nullptr;
+    if (prod) {
+      acc = !acc ? prod
+                 : isFloat ? Builder.CreateFAdd(acc, prod)
+                           : Builder.CreateAdd(acc, prod);
+    } else if (!acc) {
+      acc = isFloat ? Builder.CreateFMul(l, r) : Builder.CreateMul(l, r);
+    } else {
+      acc = Builder.CreateCall(Mad, {madOpArg, l, r, acc});
+    }
+  }
+
+  // Returns the sum of the terms, which is zero if every term was skipped.
+  Value *GetResult(Type *EltTy) {
+    Value *result = acc ? acc : Constant::getNullValue(EltTy);
+    acc = nullptr;
+    return result;
+  }
+
+private:
+  IRBuilder<> &Builder;
+  Function *Mad;
+  Value *madOpArg;
+  bool isFloat;
+  bool skipZeroTerms;
+  Value *acc;
+};
+}
+
 void HLMatrixLowerPass::TranslateMatMatMul(CallInst *matInst,
                                            Instruction *vecInst,
                                            CallInst *mulInst, bool isSigned) {
@@ -863,40 +1011,32 @@ void HLMatrixLowerPass::TranslateMatMatMul(CallInst *matInst,
   Value *lMat = matToVecMap[cast<Instruction>(LVal)];
   Value *rMat = matToVecMap[cast<Instruction>(RVal)];
 
-  auto CreateOneEltMul = [&](unsigned r, unsigned lc, unsigned c) -> Value * {
-    unsigned lMatIdx = HLMatrixLower::GetRowMajorIdx(r, lc, col);
-    unsigned rMatIdx = HLMatrixLower::GetRowMajorIdx(lc, c, rCol);
-    Value *lMatElt = Builder.CreateExtractElement(lMat, lMatIdx);
-    Value *rMatElt = Builder.CreateExtractElement(rMat, rMatIdx);
-    return isFloat ? Builder.CreateFMul(lMatElt, rMatElt)
-                   : Builder.CreateMul(lMatElt, rMatElt);
-  };
+  SmallVector<Constant *, 16> lKnown, rKnown;
+  if (!GetKnownMatElements(LVal, lKnown))
+    lKnown.assign(col * row, nullptr);
+  if (!GetKnownMatElements(RVal, rKnown))
+    rKnown.assign(rCol * rRow, nullptr);
 
   IntrinsicOp madOp = isSigned ? IntrinsicOp::IOP_mad : IntrinsicOp::IOP_umad;
   Type *opcodeTy = Builder.getInt32Ty();
   Function *Mad = GetOrCreateMadIntrinsic(EltTy, opcodeTy, madOp,
                                           *m_pHLModule->GetModule());
   Value *madOpArg = Builder.getInt32((unsigned)madOp);
-
-  auto CreateOneEltMad = [&](unsigned r, unsigned lc, unsigned c,
-                             Value *acc) -> Value * {
-    unsigned lMatIdx = HLMatrixLower::GetRowMajorIdx(r, lc, col);
-    unsigned rMatIdx = HLMatrixLower::GetRowMajorIdx(lc, c, rCol);
-    Value *lMatElt = Builder.CreateExtractElement(lMat, lMatIdx);
-    Value *rMatElt = Builder.CreateExtractElement(rMat, rMatIdx);
-    return Builder.CreateCall(Mad, {madOpArg, lMatElt, rMatElt, acc});
-  };
+  MulEltBuilder EltBuilder(Builder, Mad, madOpArg, isFloat,
+                           !isFloat || !m_pHLModule->GetHLOptions().bIEEEStrict);
 
   for (unsigned r = 0; r < row; r++) {
     for (unsigned c = 0; c < rCol; c++) {
-      unsigned lc = 0;
-      Value *tmpVal = CreateOneEltMul(r, lc, c);
-
-      for (lc = 1; lc < col; lc++) {
-        tmpVal = CreateOneEltMad(r, lc, c, tmpVal);
+      for (unsigned lc = 0; lc < col; lc++) {
+        unsigned lMatIdx = HLMatrixLower::GetRowMajorIdx(r, lc, col);
+        unsigned rMatIdx = HLMatrixLower::GetRowMajorIdx(lc, c, rCol);
+        Value *lMatElt = Builder.CreateExtractElement(lMat, lMatIdx);
+        Value *rMatElt = Builder.CreateExtractElement(rMat, rMatIdx);
+        EltBuilder.AddTerm(lMatElt, lKnown[lMatIdx], rMatElt, rKnown[rMatIdx]);
       }
       unsigned matIdx = HLMatrixLower::GetRowMajorIdx(r, c, rCol);
-      retVal = Builder.CreateInsertElement(retVal, tmpVal, matIdx);
+      retVal = Builder.CreateInsertElement(
+          retVal, EltBuilder.GetResult(EltTy), matIdx);
     }
   }
 
@@ -925,33 +1065,30 @@ void HLMatrixLowerPass::TranslateMatVecMul(CallInst *matInst,
   Value *vec = RVal;
   Value *mat = vecInst; // vec version of matInst;
 
+  SmallVector<Constant *, 16> matKnown;
+  if (!GetKnownMatElements(matInst, matKnown))
+    matKnown.assign(col * row, nullptr);
+  Constant *vecConst = dyn_cast<Constant>(vec);
+
   IntrinsicOp madOp = isSigned ? IntrinsicOp::IOP_mad : IntrinsicOp::IOP_umad;
   Type *opcodeTy = Builder.getInt32Ty();
   Function *Mad = GetOrCreateMadIntrinsic(EltTy, opcodeTy, madOp,
                                           *m_pHLModule->GetModule());
   Value *madOpArg = Builder.getInt32((unsigned)madOp);
-
-  auto CreateOneEltMad = [&](unsigned r, unsigned c, Value *acc) -> Value * {
-    Value *vecElt = Builder.CreateExtractElement(vec, c);
-    uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
-    Value *matElt = Builder.CreateExtractElement(mat, matIdx);
-    return Builder.CreateCall(Mad, {madOpArg, vecElt, matElt, acc});
-  };
+  MulEltBuilder EltBuilder(Builder, Mad, madOpArg, isFloat,
+                           !isFloat || !m_pHLModule->GetHLOptions().bIEEEStrict);
 
   for (unsigned r = 0; r < row; r++) {
-    unsigned c = 0;
-    Value *vecElt = Builder.CreateExtractElement(vec, c);
-    uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
-    Value *matElt = Builder.CreateExtractElement(mat, matIdx);
-
-    Value *tmpVal = isFloat ? Builder.CreateFMul(vecElt, matElt)
-                            : Builder.CreateMul(vecElt, matElt);
-
-    for (c = 1; c < col; c++) {
-      tmpVal = CreateOneEltMad(r, c, tmpVal);
+    for (unsigned c = 0; c < col; c++) {
+      Value *vecElt = Builder.CreateExtractElement(vec, c);
+      uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
+      Value *matElt = Builder.CreateExtractElement(mat, matIdx);
+      EltBuilder.AddTerm(vecElt,
+                         vecConst ? vecConst->getAggregateElement(c) : nullptr,
+                         matElt, matKnown[matIdx]);
     }
 
-    retVal = Builder.CreateInsertElement(retVal, tmpVal, r);
+    retVal = Builder.CreateInsertElement(retVal, EltBuilder.GetResult(EltTy), r);
   }
 
   mulInst->replaceAllUsesWith(retVal);
@@ -977,33 +1114,30 @@ void HLMatrixLowerPass::TranslateVecMatMul(CallInst *matInst,
   Value *vec = LVal;
   Value *mat = RVal;
 
+  SmallVector<Constant *, 16> matKnown;
+  if (!GetKnownMatElements(matInst, matKnown))
+    matKnown.assign(col * row, nullptr);
+  Constant *vecConst = dyn_cast<Constant>(vec);
+
   IntrinsicOp madOp = isSigned ? IntrinsicOp::IOP_mad : IntrinsicOp::IOP_umad;
   Type *opcodeTy = Builder.getInt32Ty();
   Function *Mad = GetOrCreateMadIntrinsic(EltTy, opcodeTy, madOp,
                                           *m_pHLModule->GetModule());
   Value *madOpArg = Builder.getInt32((unsigned)madOp);
-
-  auto CreateOneEltMad = [&](unsigned r, unsigned c, Value *acc) -> Value * {
-    Value *vecElt = Builder.CreateExtractElement(vec, r);
-    uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
-    Value *matElt = Builder.CreateExtractElement(mat, matIdx);
-    return Builder.CreateCall(Mad, {madOpArg, vecElt, matElt, acc});
-  };
+  MulEltBuilder EltBuilder(Builder, Mad, madOpArg, isFloat,
+                           !isFloat || !m_pHLModule->GetHLOptions().bIEEEStrict);
 
   for (unsigned c = 0; c < col; c++) {
-    unsigned r = 0;
-    Value *vecElt = Builder.CreateExtractElement(vec, r);
-    uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
-    Value *matElt = Builder.CreateExtractElement(mat, matIdx);
-
-    Value *tmpVal = isFloat ? Builder.CreateFMul(vecElt, matElt)
-                            : Builder.CreateMul(vecElt, matElt);
-
-    for (r = 1; r < row; r++) {
-      tmpVal = CreateOneEltMad(r, c, tmpVal);
+    for (unsigned r = 0; r < row; r++) {
+      Value *vecElt = Builder.CreateExtractElement(vec, r);
+      uint32_t matIdx = HLMatrixLower::GetRowMajorIdx(r, c, col);
+      Value *matElt = Builder.CreateExtractElement(mat, matIdx);
+      EltBuilder.AddTerm(vecElt,
+                         vecConst ? vecConst->getAggregateElement(r) : nullptr,
+                         matElt, matKnown[matIdx]);
     }
 
-    retVal = Builder.CreateInsertElement(retVal, tmpVal, c);
+    retVal = Builder.CreateInsertElement(retVal, EltBuilder.GetResult(EltTy), c);
   }
 
   mulInst->replaceAllUsesWith(retVal);
@@ -2320,30 +2454,25 @@ void HLMatrixLowerPass::runOnFunction(Function &F) {
     }
   }
 
-  // Update the use of matrix inst with the vector version.
-  for (auto matToVecIter = matToVecMap.begin();
-       matToVecIter != matToVecMap.end();) {
-    auto matToVec = matToVecIter++;
-    replaceMatWithVec(matToVec->first, cast<Instruction>(matToVec->second));
-  }
+  if (m_matInsts.empty())
+    return;
+
+  // Update the use of matrix inst with the vector version. Translating a
+  // use may replace the vector version of the use, but never adds a matrix
+  // inst, so the list stays as it is.
+  for (Instruction *matInst : m_matInsts)
+    replaceMatWithVec(matInst, cast<Instruction>(matToVecMap[matInst]));
 
   // Translate mat inst which require all operands ready.
-  for (auto matToVecIter = matToVecMap.begin();
-       matToVecIter != matToVecMap.end();) {
-    auto matToVec = matToVecIter++;
-    finalMatTranslation(matToVec->first);
-  }
+  for (Instruction *matInst : m_matInsts)
+    finalMatTranslation(matInst);
 
   // Delete the matrix version insts.
-  for (auto matToVecIter = matToVecMap.begin();
-       matToVecIter != matToVecMap.end();) {
-    auto matToVec = matToVecIter++;
-    // Add to m_deadInsts.
-    Instruction *matInst = matToVec->first;
-    AddToDeadInsts(matInst);
-  }
-
+  m_deadInsts.insert(m_deadInsts.end(), m_matInsts.begin(), m_matInsts.end());
   DeleteDeadInsts();
-  
-  matToVecMap.clear();
+
+  // Release the state of the function rather than keep it at the size of
+  // the largest function lowered so far.
+  matToVecMap.shrink_and_clear();
+  std::vector<Instruction *>().swap(m_matInsts);
 }
@@ -58,6 +58,15 @@ HLModule::HLModule(Module *pModule)
   void (__thiscall Module::*pfnModuleDump)() const = &Module::dump;
   void (__thiscall Type::*pfnTypeDump)() const = &Type::dump;
   m_pUnused = (char *)&pfnModuleDump - (char *)&pfnTypeDump;
+
+  // HL functions of a module loaded with its HL metadata were not created
+  // through this module, so take their groups from their names. The module
+  // does not point at this HLModule yet, so the names are parsed.
+  for (Function &F : *pModule) {
+    HLOpcodeGroup group = GetHLOpcodeGroupByName(&F);
+    if (group != HLOpcodeGroup::NotHL)
+      m_HLFunctionGroups[&F] = group;
+  }
 }
 
 HLModule::~HLModule() {
@@ -210,6 +219,7 @@ const vector<unique_ptr<HLResource> > &HLModule::GetUAVs() const {
 void HLModule::RemoveFunction(llvm::Function *F) {
   DXASSERT_NOMSG(F != nullptr);
   m_DxilFunctionPropsMap.erase(F);
+  m_HLFunctionGroups.erase(F);
   if (m_pTypeSystem.get()->GetFunctionAnnotation(F))
     m_pTypeSystem.get()->EraseFunctionAnnotation(F);
   m_pOP->RemoveFunction(F);
@@ -305,6 +315,22 @@ HLModule::ReleaseFunctionPropsMap() {
   return std::move(m_DxilFunctionPropsMap);
 }
 
+vector<unique_ptr<DxilCBuffer> > &&HLModule::ReleaseCBuffers() {
+  return std::move(m_CBuffers);
+}
+
+vector<unique_ptr<DxilSampler> > &&HLModule::ReleaseSamplers() {
+  return std::move(m_Samplers);
+}
+
+vector<unique_ptr<HLResource> > &&HLModule::ReleaseSRVs() {
+  return std::move(m_SRVs);
+}
+
+vector<unique_ptr<HLResource> > &&HLModule::ReleaseUAVs() {
+  return std::move(m_UAVs);
+}
+
 void HLModule::EmitLLVMUsed() {
   if (m_LLVMUsed.empty())
     return;
@@ -350,11 +376,22 @@ DxilFunctionAnnotation *HLModule::AddFunctionAnnotation(llvm::Function *F) {
   return m_pTypeSystem->AddFunctionAnnotation(F);
 }
 
+void HLModule::SetHLFunctionGroup(llvm::Function *F, HLOpcodeGroup group) {
+  DXASSERT_NOMSG(group != HLOpcodeGroup::NotHL);
+  m_HLFunctionGroups[F] = group;
+}
+
+HLOpcodeGroup HLModule::GetHLFunctionGroup(const llvm::Function *F) const {
+  auto it = m_HLFunctionGroups.find(F);
+  return it == m_HLFunctionGroups.end() ? HLOpcodeGroup::NotHL : it->second;
+}
+
 void HLModule::AddResourceTypeAnnotation(llvm::Type *Ty,
                                          DXIL::ResourceClass resClass,
                                          DXIL::ResourceKind kind) {
   if (m_ResTypeAnnotation.count(Ty) == 0) {
-    m_ResTypeAnnotation.emplace(Ty, std::make_pair(resClass, kind));
+    m_ResTypeAnnotation.insert(
+        std::make_pair(Ty, std::make_pair(resClass, kind)));
   } else {
     DXASSERT(resClass == m_ResTypeAnnotation[Ty].first, "resClass mismatch");
     DXASSERT(kind == m_ResTypeAnnotation[Ty].second, "kind mismatch");
@@ -407,9 +444,12 @@ void HLModule::EmitHLMetadata() {
 
   {
     NamedMDNode * fnProps = m_pModule->getOrInsertNamedMetadata(kHLDxilFunctionPropertiesMDName);
-    for (auto && pair : m_DxilFunctionPropsMap) {
-      const hlsl::DxilFunctionProps * props = pair.second.get();
-      MDTuple *pProps = m_pMDHelper->EmitDxilFunctionProps(props, pair.first);
+    // In module order; the map is keyed by address.
+    for (Function &F : *m_pModule) {
+      auto it = m_DxilFunctionPropsMap.find(&F);
+      if (it == m_DxilFunctionPropsMap.end())
+        continue;
+      MDTuple *pProps = m_pMDHelper->EmitDxilFunctionProps(it->second.get(), &F);
       fnProps->addOperand(pProps);
     }
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "dxc/HLSL/HLOperations.h"
+#include "dxc/HLSL/HLModule.h"
 #include "dxc/HlslIntrinsicOp.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
@@ -89,8 +90,7 @@ static HLOpcodeGroup GetHLOpcodeGroupInternal(StringRef group) {
   }
   return HLOpcodeGroup::NotHL;
 }
-// GetHLOpGroup by function name.
-HLOpcodeGroup GetHLOpcodeGroupByName(const Function *F) {
+static HLOpcodeGroup GetHLOpcodeGroupFromName(const Function *F) {
   StringRef name = F->getName();
 
   if (!name.startswith(HLPrefix)) {
@@ -106,6 +106,20 @@ HLOpcodeGroup GetHLOpcodeGroupByName(const Function *F) {
   return GetHLOpcodeGroupInternal(group);
 }
 
+// GetHLOpGroup by function name.
+HLOpcodeGroup GetHLOpcodeGroupByName(const Function *F) {
+  // While the module has an HLModule, it records the group of each HL
+  // function, so the name need not be parsed for every call visited.
+  Module *M = const_cast<Module *>(F->getParent());
+  if (M && M->HasHLModule()) {
+    HLOpcodeGroup group = M->GetHLModule().GetHLFunctionGroup(F);
+    DXASSERT(group == GetHLOpcodeGroupFromName(F),
+             "otherwise HL function was created without its group recorded");
+    return group;
+  }
+  return GetHLOpcodeGroupFromName(F);
+}
+
 HLOpcodeGroup GetHLOpcodeGroup(llvm::Function *F) {
   llvm::StringRef name = GetHLOpcodeGroupNameByAttr(F);
   HLOpcodeGroup result = GetHLOpcodeGroupInternal(name);
@@ -458,6 +472,8 @@ Function *GetOrCreateHLFunction(Module &M, FunctionType *funcTy,
   Function *F = cast<Function>(M.getOrInsertFunction(mangledName, funcTy));
   if (group == HLOpcodeGroup::HLExtIntrinsic) {
     F->addFnAttr(hlsl::HLPrefix, *groupName);
+  } else if (M.HasHLModule()) {
+    M.GetHLModule().SetHLFunctionGroup(F, group);
   }
 
   SetHLFunctionAttribute(F, group, opcode);
@@ -477,6 +493,8 @@ Function *GetOrCreateHLFunctionWithBody(Module &M, FunctionType *funcTy,
   mangledNameStr.flush();
 
   Function *F = cast<Function>(M.getOrInsertFunction(mangledName, funcTy));
+  if (M.HasHLModule())
+    M.GetHLModule().SetHLFunctionGroup(F, group);
 
   SetHLFunctionAttribute(F, group, opcode);
 
@@ -526,6 +526,8 @@ Value *GenerateLdInput(Function *loadInput, ArrayRef<Value *> args,
   }
 }
 
+// Returns the value that replaces ldInst, or null if the extracts from it were
+// replaced instead.
 Value *replaceLdWithLdInput(Function *loadInput, LoadInst *ldInst,
                             unsigned cols, MutableArrayRef<Value *> args,
                             bool bCast) {
@@ -536,8 +538,39 @@ Value *replaceLdWithLdInput(Function *loadInput, LoadInst *ldInst,
   Value *zero = Builder.getInt32(0);
 
   if (VectorType *VT = dyn_cast<VectorType>(Ty)) {
-    Value *newVec = llvm::UndefValue::get(VT);
     DXASSERT(cols == VT->getNumElements(), "vec size must match");
+    // Wide structures are mostly read a component at a time; when only
+    // constant extracts use the load, load just the components they read
+    // instead of rebuilding the whole vector.
+    bool bOnlyConstExtracts = !ldInst->use_empty();
+    for (User *U : ldInst->users()) {
+      ExtractElementInst *EEI = dyn_cast<ExtractElementInst>(U);
+      ConstantInt *EltIdx =
+          EEI ? dyn_cast<ConstantInt>(EEI->getIndexOperand()) : nullptr;
+      if (!EltIdx || EltIdx->getLimitedValue() >= cols) {
+        bOnlyConstExtracts = false;
+        break;
+      }
+    }
+    if (bOnlyConstExtracts) {
+      SmallVector<Value *, 4> inputs(cols, nullptr);
+      for (auto U = ldInst->user_begin(); U != ldInst->user_end();) {
+        ExtractElementInst *EEI = cast<ExtractElementInst>(*(U++));
+        unsigned col = cast<ConstantInt>(EEI->getIndexOperand())
+                           ->getLimitedValue();
+        if (!inputs[col]) {
+          args[DXIL::OperandIndex::kLoadInputColOpIdx] = Builder.getInt8(col);
+          inputs[col] =
+              GenerateLdInput(loadInput, args, Builder, zero, bCast, EltTy);
+        }
+        EEI->replaceAllUsesWith(inputs[col]);
+        EEI->eraseFromParent();
+      }
+      ldInst->eraseFromParent();
+      return nullptr;
+    }
+
+    Value *newVec = llvm::UndefValue::get(VT);
     for (unsigned col = 0; col < cols; col++) {
       Value *colIdx = Builder.getInt8(col);
       args[DXIL::OperandIndex::kLoadInputColOpIdx] = colIdx;
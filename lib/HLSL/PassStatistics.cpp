@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// PassStatistics.cpp                                                        //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements the IR size and statistics recorder used by -print-stats.      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/PassStatistics.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace hlsl;
+using namespace llvm;
+
+static void WriteJsonString(raw_ostream &OS, StringRef value) {
+  OS << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      OS << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      OS << ' ';
+    else
+      OS << c;
+  }
+  OS << '"';
+}
+
+// Adds delta to the entry for S, keeping entries in the order they were
+// first added. Few statistics move in a pass, so a linear search suffices.
+static void AddStatDelta(std::vector<std::pair<const Statistic *, int64_t>> &deltas,
+                         const Statistic *S, int64_t delta) {
+  for (auto &entry : deltas) {
+    if (entry.first == S) {
+      entry.second += delta;
+      return;
+    }
+  }
+  deltas.push_back(std::make_pair(S, delta));
+}
+
+static void WriteStatDeltas(
+    raw_ostream &OS,
+    const std::vector<std::pair<const Statistic *, int64_t>> &deltas,
+    const char *pIndent) {
+  bool first = true;
+  for (const auto &entry : deltas) {
+    if (entry.second == 0)
+      continue;
+    OS << (first ? "\n" : ",\n") << pIndent << "{ \"name\": ";
+    WriteJsonString(OS, entry.first->getName());
+    OS << ", \"desc\": ";
+    WriteJsonString(OS, entry.first->getDesc());
+    OS << ", \"value\": " << entry.second << " }";
+    first = false;
+  }
+}
+
+PassStatisticsRecorder::IRCounts PassStatisticsRecorder::Count(Module &M) {
+  IRCounts counts;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    IRCounts functionCounts = Count(F);
+    counts.Functions += 1;
+    counts.Blocks += functionCounts.Blocks;
+    counts.Instructions += functionCounts.Instructions;
+  }
+  return counts;
+}
+
+PassStatisticsRecorder::IRCounts PassStatisticsRecorder::Count(Function &F) {
+  IRCounts counts;
+  counts.Functions = 1;
+  for (BasicBlock &BB : F) {
+    counts.Blocks += 1;
+    counts.Instructions += BB.size();
+  }
+  return counts;
+}
+
+PassStatisticsRecorder::PassStatisticsRecorder() : m_pModule(nullptr) {
+  GetStatistics(m_stats);
+  for (const Statistic *S : m_stats)
+    m_statsAtStart.push_back(S->getValue());
+}
+
+void PassStatisticsRecorder::BeginPass(const char *pName, Module &M,
+                                       Function *F) {
+  // The module may change between pass runs, and passes may run on more
+  // than one module, so module passes recount it; the counts follow the
+  // module most recently run on.
+  if (F == nullptr || m_pModule != &M) {
+    m_current = Count(M);
+    if (m_pModule == nullptr)
+      m_initial = m_current;
+    m_pModule = &M;
+  }
+
+  OpenPass pass;
+  pass.Name = pName;
+  pass.Before = F ? Count(*F) : m_current;
+  GetStatistics(m_stats);
+  for (const Statistic *S : m_stats)
+    pass.StatsBefore.push_back(S->getValue());
+  m_open.push_back(std::move(pass));
+}
+
+void PassStatisticsRecorder::EndPass(const char *pName, Module &M,
+                                     Function *F, bool changed) {
+  if (m_open.empty())
+    return;
+  OpenPass &pass = m_open.back();
+
+  // A function pass cannot add or remove its own function, so only its
+  // blocks and instructions change.
+  IRCounts after = F ? Count(*F) : Count(M);
+  IRCounts delta;
+  delta.Functions = F ? 0 : after.Functions - pass.Before.Functions;
+  delta.Blocks = after.Blocks - pass.Before.Blocks;
+  delta.Instructions = after.Instructions - pass.Before.Instructions;
+  if (F) {
+    m_current.Blocks += delta.Blocks;
+    m_current.Instructions += delta.Instructions;
+  } else {
+    m_current = after;
+  }
+  m_pModule = &M;
+
+  auto inserted = m_totals.insert(
+      std::make_pair(StringRef(pass.Name), PassTotals()));
+  PassTotals &totals = inserted.first->second;
+  if (inserted.second)
+    totals.Index = m_totals.size() - 1;
+  ++totals.Runs;
+  if (changed)
+    ++totals.Changed;
+  totals.Delta.Functions += delta.Functions;
+  totals.Delta.Blocks += delta.Blocks;
+  totals.Delta.Instructions += delta.Instructions;
+  totals.PeakInstructions =
+      std::max(totals.PeakInstructions, m_current.Instructions);
+
+  // Statistics first counted during the pass started from zero.
+  GetStatistics(m_stats);
+  for (size_t i = 0; i < m_stats.size(); ++i) {
+    int64_t before = i < pass.StatsBefore.size() ? pass.StatsBefore[i] : 0;
+    int64_t moved = (int64_t)m_stats[i]->getValue() - before;
+    if (moved != 0)
+      AddStatDelta(totals.Stats, m_stats[i], moved);
+  }
+  m_open.pop_back();
+}
+
+void PassStatisticsRecorder::WriteJson(raw_ostream &OS) const {
+  std::vector<const StringMapEntry<PassTotals> *> entries;
+  for (const auto &entry : m_totals)
+    entries.push_back(&entry);
+  std::sort(entries.begin(), entries.end(),
+            [](const StringMapEntry<PassTotals> *a,
+               const StringMapEntry<PassTotals> *b) {
+              return a->second.Index < b->second.Index;
+            });
+
+  OS << "{\n  \"statisticsEnabled\": ";
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+  OS << "true";
+#else
+  OS << "false";
+#endif
+  OS << ",\n  \"initial\": { \"functions\": " << m_initial.Functions
+     << ", \"blocks\": " << m_initial.Blocks
+     << ", \"instructions\": " << m_initial.Instructions << " }"
+     << ",\n  \"final\": { \"functions\": " << m_current.Functions
+     << ", \"blocks\": " << m_current.Blocks
+     << ", \"instructions\": " << m_current.Instructions << " }"
+     << ",\n  \"passes\": [";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const PassTotals &totals = entries[i]->second;
+    OS << (i ? ",\n" : "\n") << "    { \"name\": ";
+    WriteJsonString(OS, entries[i]->getKey());
+    OS << ", \"runs\": " << totals.Runs << ", \"changed\": " << totals.Changed
+       << ", \"functions\": " << totals.Delta.Functions
+       << ", \"blocks\": " << totals.Delta.Blocks
+       << ", \"instructions\": " << totals.Delta.Instructions
+       << ", \"peakInstructions\": " << totals.PeakInstructions
+       << ", \"statistics\": [";
+    WriteStatDeltas(OS, totals.Stats, "        ");
+    OS << (totals.Stats.empty() ? "] }" : "\n      ] }");
+  }
+
+  std::vector<const Statistic *> stats;
+  GetStatistics(stats);
+  std::vector<std::pair<const Statistic *, int64_t>> deltas;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    int64_t before = i < m_statsAtStart.size() ? m_statsAtStart[i] : 0;
+    deltas.push_back(std::make_pair(stats[i], (int64_t)stats[i]->getValue() - before));
+  }
+  std::stable_sort(deltas.begin(), deltas.end(),
+                   [](const std::pair<const Statistic *, int64_t> &a,
+                      const std::pair<const Statistic *, int64_t> &b) {
+                     return StringRef(a.first->getName()) <
+                            StringRef(b.first->getName());
+                   });
+  OS << "\n  ],\n  \"statistics\": [";
+  WriteStatDeltas(OS, deltas, "    ");
+  OS << "\n  ]\n}\n";
+}
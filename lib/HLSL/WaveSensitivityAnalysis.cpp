@@ -6,7 +6,7 @@
 // License. See LICENSE.TXT for details.                                     //
 //                                                                           //
 // This file provides support for doing analysis that are aware of wave      //
-// intrinsics.                                                               //
+// intrinsics, including a uniformity (divergence) analysis.                 //
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -22,18 +22,24 @@
 #include "dxc/HLSL/DxilInstructions.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Pass.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/ADT/BitVector.h"
 #include <winerror.h>
 #include "llvm/Support/raw_ostream.h"
 #include <unordered_set>
+#include <unordered_map>
 
 using namespace llvm;
 using namespace std;
@@ -183,4 +189,278 @@ bool WaveSensitivityAnalyzer::IsWaveSensitive(Instruction *op) {
   return (*c).second == KnownSensitive;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Uniformity analysis.
+//
+// Divergence starts at values that differ per lane (thread ids, inputs,
+// memory reads, atomics) and flows through data dependences. Reads of
+// constant globals only diverge through their address. A divergent
+// branch also makes divergent the phis of the blocks it controls and of its
+// immediate post-dominator, and any value defined in those blocks and used
+// past them, since lanes may have left a loop in different iterations.
+// Wave reductions and broadcasts are uniform over the active lanes, which
+// is what a scalar branch needs.
+
+class DxilUniformityAnalyzer : public DxilUniformityAnalysis {
+private:
+  std::unordered_set<Value *> Divergent;
+  std::vector<Value *> WorkList;
+  std::unordered_set<TerminatorInst *> DivergentBranches;
+  DominatorTreeBase<BasicBlock> PostDom;
+  unsigned ConditionalBranchCount;
+
+  void MarkDivergent(Value *V);
+  bool IsDivergentSource(Instruction *I);
+  bool IsUniformSource(Instruction *I);
+  bool ComputeDivergent(Instruction *I);
+  void PropagateBranchDivergence(TerminatorInst *TI);
+
+public:
+  DxilUniformityAnalyzer() : PostDom(true), ConditionalBranchCount(0) {}
+  void Analyze(Function *F) override;
+  bool IsUniform(Value *V) override;
+  bool IsUniformBranch(Instruction *TI) override;
+  unsigned GetConditionalBranchCount() override {
+    return ConditionalBranchCount;
+  }
+  unsigned GetDivergentBranchCount() override {
+    return DivergentBranches.size();
+  }
+};
+
+DxilUniformityAnalysis* DxilUniformityAnalysis::create() {
+  return new DxilUniformityAnalyzer();
+}
+
+static Value *GetBranchCondition(Instruction *TI) {
+  if (BranchInst *BI = dyn_cast<BranchInst>(TI))
+    return BI->isConditional() ? BI->getCondition() : nullptr;
+  if (SwitchInst *SI = dyn_cast<SwitchInst>(TI))
+    return SI->getCondition();
+  return nullptr;
+}
+
+void DxilUniformityAnalyzer::MarkDivergent(Value *V) {
+  if (Divergent.insert(V).second)
+    WorkList.push_back(V);
+}
+
+bool DxilUniformityAnalyzer::IsDivergentSource(Instruction *I) {
+  if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    GlobalVariable *GV = dyn_cast<GlobalVariable>(GetUnderlyingObject(
+        LI->getPointerOperand(), I->getModule()->getDataLayout()));
+    return !GV || !GV->isConstant();
+  }
+  if (isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I))
+    return true;
+  CallInst *CI = dyn_cast<CallInst>(I);
+  if (!CI)
+    return false;
+  if (!OP::IsDxilOpFuncCallInst(CI))
+    return !CI->getType()->isVoidTy();
+  switch (OP::GetDxilOpFuncCallInst(CI)) {
+  case OP::OpCode::ThreadId:
+  case OP::OpCode::ThreadIdInGroup:
+  case OP::OpCode::FlattenedThreadIdInGroup:
+  case OP::OpCode::LoadInput:
+  case OP::OpCode::LoadOutputControlPoint:
+  case OP::OpCode::LoadPatchConstant:
+  case OP::OpCode::AttributeAtVertex:
+  case OP::OpCode::EvalSnapped:
+  case OP::OpCode::EvalSampleIndex:
+  case OP::OpCode::EvalCentroid:
+  case OP::OpCode::DomainLocation:
+  case OP::OpCode::OutputControlPointID:
+  case OP::OpCode::PrimitiveID:
+  case OP::OpCode::GSInstanceID:
+  case OP::OpCode::ViewID:
+  case OP::OpCode::SampleIndex:
+  case OP::OpCode::Coverage:
+  case OP::OpCode::InnerCoverage:
+  case OP::OpCode::TempRegLoad:
+  case OP::OpCode::MinPrecXRegLoad:
+  case OP::OpCode::CycleCounterLegacy:
+  case OP::OpCode::AtomicBinOp:
+  case OP::OpCode::AtomicCompareExchange:
+  case OP::OpCode::BufferUpdateCounter:
+  case OP::OpCode::WaveIsFirstLane:
+  case OP::OpCode::WaveGetLaneIndex:
+  case OP::OpCode::WaveReadLaneAt:
+  case OP::OpCode::WavePrefixOp:
+  case OP::OpCode::WavePrefixBitCount:
+  case OP::OpCode::QuadReadLaneAt:
+  case OP::OpCode::QuadOp:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool DxilUniformityAnalyzer::IsUniformSource(Instruction *I) {
+  if (!OP::IsDxilOpFuncCallInst(I))
+    return false;
+  switch (OP::GetDxilOpFuncCallInst(I)) {
+  case OP::OpCode::GroupId:
+  case OP::OpCode::WaveGetLaneCount:
+  case OP::OpCode::WaveAnyTrue:
+  case OP::OpCode::WaveAllTrue:
+  case OP::OpCode::WaveActiveAllEqual:
+  case OP::OpCode::WaveActiveBallot:
+  case OP::OpCode::WaveReadLaneFirst:
+  case OP::OpCode::WaveActiveOp:
+  case OP::OpCode::WaveActiveBit:
+  case OP::OpCode::WaveAllBitCount:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool DxilUniformityAnalyzer::ComputeDivergent(Instruction *I) {
+  if (IsUniformSource(I))
+    return false;
+  if (IsDivergentSource(I))
+    return true;
+  for (Value *V : I->operands()) {
+    if (Divergent.count(V))
+      return true;
+  }
+  return false;
+}
+
+void DxilUniformityAnalyzer::PropagateBranchDivergence(TerminatorInst *TI) {
+  if (!DivergentBranches.insert(TI).second)
+    return;
+  BasicBlock *BB = TI->getParent();
+  BasicBlock *Join = nullptr;
+  if (DomTreeNodeBase<BasicBlock> *Node = PostDom.getNode(BB)) {
+    if (DomTreeNodeBase<BasicBlock> *IPDom = Node->getIDom())
+      Join = IPDom->getBlock();
+  }
+
+  // Blocks reachable from the branch before the lanes reconverge.
+  std::unordered_set<BasicBlock *> Region;
+  std::vector<BasicBlock *> Stack(succ_begin(BB), succ_end(BB));
+  while (!Stack.empty()) {
+    BasicBlock *Succ = Stack.back();
+    Stack.pop_back();
+    if (Succ == Join || !Region.insert(Succ).second)
+      continue;
+    Stack.insert(Stack.end(), succ_begin(Succ), succ_end(Succ));
+  }
+
+  if (Join) {
+    for (Instruction &I : *Join) {
+      if (!isa<PHINode>(I))
+        break;
+      MarkDivergent(&I);
+    }
+  }
+  for (BasicBlock *RegionBB : Region) {
+    for (Instruction &I : *RegionBB) {
+      if (isa<PHINode>(I)) {
+        MarkDivergent(&I);
+        continue;
+      }
+      for (User *U : I.users()) {
+        Instruction *UI = cast<Instruction>(U);
+        if (!Region.count(UI->getParent())) {
+          MarkDivergent(&I);
+          break;
+        }
+      }
+    }
+  }
+}
+
+void DxilUniformityAnalyzer::Analyze(Function *F) {
+  Divergent.clear();
+  WorkList.clear();
+  DivergentBranches.clear();
+  ConditionalBranchCount = 0;
+  PostDom.recalculate(*F);
+
+  // Only entry points see their arguments as uniform; anything else may be
+  // called with per-lane values.
+  for (Argument &Arg : F->args())
+    MarkDivergent(&Arg);
+  for (Instruction &I : inst_range(F)) {
+    if (GetBranchCondition(&I))
+      ++ConditionalBranchCount;
+    if (IsDivergentSource(&I) && !IsUniformSource(&I))
+      MarkDivergent(&I);
+  }
+
+  while (!WorkList.empty()) {
+    Value *V = WorkList.back();
+    WorkList.pop_back();
+    for (User *U : V->users()) {
+      Instruction *UI = cast<Instruction>(U);
+      if (TerminatorInst *TI = dyn_cast<TerminatorInst>(UI)) {
+        if (GetBranchCondition(TI) == V)
+          PropagateBranchDivergence(TI);
+        continue;
+      }
+      if (!Divergent.count(UI) && ComputeDivergent(UI))
+        MarkDivergent(UI);
+    }
+  }
+}
+
+bool DxilUniformityAnalyzer::IsUniform(Value *V) {
+  return Divergent.count(V) == 0;
+}
+
+bool DxilUniformityAnalyzer::IsUniformBranch(Instruction *TI) {
+  Value *Cond = GetBranchCondition(TI);
+  return Cond && IsUniform(Cond);
+}
+
 } // namespace hlsl
+
+///////////////////////////////////////////////////////////////////////////////
+// Reports, per function, how many conditional branches are divergent. Use
+// with -analyze to print the counts.
+
+using namespace hlsl;
+
+namespace {
+class DxilUniformityStats : public FunctionPass {
+  std::unique_ptr<DxilUniformityAnalysis> m_pAnalysis;
+  StringRef m_FunctionName;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit DxilUniformityStats()
+      : FunctionPass(ID), m_pAnalysis(DxilUniformityAnalysis::create()) {}
+
+  const char *getPassName() const override {
+    return "DXIL uniformity statistics";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    m_FunctionName = F.getName();
+    m_pAnalysis->Analyze(&F);
+    return false;
+  }
+
+  void print(raw_ostream &OS, const Module *) const override {
+    OS << "Function " << m_FunctionName << ": "
+       << m_pAnalysis->GetConditionalBranchCount() << " conditional branches, "
+       << m_pAnalysis->GetDivergentBranchCount() << " divergent\n";
+  }
+};
+}
+
+char DxilUniformityStats::ID = 0;
+
+FunctionPass *llvm::createDxilUniformityStatsPass() {
+  return new DxilUniformityStats();
+}
+
+INITIALIZE_PASS(DxilUniformityStats, "hlsl-dxil-uniformity-stats",
+                "DXIL uniformity statistics", false, true)
@@ -212,3 +212,11 @@ void llvm::emitLoopInterleaveWarning(LLVMContext &Ctx, const Function &Fn,
   Ctx.diagnose(DiagnosticInfoOptimizationFailure(
       Fn, DLoc, Twine("loop not interleaved: " + Msg)));
 }
+
+// HLSL Change Begin
+void llvm::emitLoopUnrollWarning(LLVMContext &Ctx, const Function &Fn,
+                                 const DebugLoc &DLoc, const Twine &Msg) {
+  Ctx.diagnose(DiagnosticInfoOptimizationFailure(
+      Fn, DLoc, Twine("loop not unrolled: " + Msg)));
+}
+// HLSL Change End
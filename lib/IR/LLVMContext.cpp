@@ -259,3 +259,36 @@ void LLVMContext::getMDKindNames(SmallVectorImpl<StringRef> &Names) const {
        E = pImpl->CustomMDKindNames.end(); I != E; ++I)
     Names[I->second] = I->first();
 }
+
+// HLSL Change Begin - Support reusing a context across modules.
+bool LLVMContext::resetForReuse(unsigned NumMDKinds,
+                                bool (*KeepStructName)(StringRef)) {
+  if (!pImpl->OwnedModules.empty())
+    return false;
+
+  // No instruction is left to carry an attachment of the removed kinds.
+  SmallVector<StringRef, 8> KindNames;
+  getMDKindNames(KindNames);
+  for (unsigned i = NumMDKinds, e = KindNames.size(); i < e; ++i)
+    pImpl->CustomMDKindNames.erase(KindNames[i]);
+
+  // Collect the types first: clearing a name removes it from the map.
+  SmallVector<StructType *, 64> Unnamed;
+  for (auto &Entry : pImpl->NamedStructTypes) {
+    if (!KeepStructName || !KeepStructName(Entry.getKey()))
+      Unnamed.push_back(Entry.getValue());
+  }
+  for (StructType *ST : Unnamed)
+    ST->setName("");
+  pImpl->NamedStructTypesUniqueID = 0;
+
+  pImpl->InlineAsmDiagHandler = nullptr;
+  pImpl->InlineAsmDiagContext = nullptr;
+  pImpl->DiagnosticHandler = nullptr;
+  pImpl->DiagnosticContext = nullptr;
+  pImpl->RespectDiagnosticFilters = false;
+  pImpl->YieldCallback = nullptr;
+  pImpl->YieldOpaqueHandle = nullptr;
+  return true;
+}
+// HLSL Change End
@@ -25,6 +25,10 @@
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "dxc/Support/WinIncludes.h" // HLSL Change
+#include "dxc/Support/Cancellation.h" // HLSL Change
+#include "dxc/Support/PhaseTracing.h" // HLSL Change
+#include "dxc/HLSL/PassStatistics.h" // HLSL Change
 #include <algorithm>
 #include <map>
 using namespace llvm;
@@ -1513,6 +1517,8 @@ bool FPPassManager::runOnFunction(Function &F) {
     FunctionPass *FP = getContainedPass(Index);
     bool LocalChanged = false;
 
+    hlsl::ThrowIfCancellationRequested(); // HLSL Change
+
     dumpPassInfo(FP, EXECUTION_MSG, ON_FUNCTION_MSG, F.getName());
     dumpRequiredSet(FP);
 
@@ -1521,8 +1527,19 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      hlsl::PhaseSpan PassSpan(FP->getPassName()); // HLSL Change
+      // HLSL Change Begin - report the pass to the observer for -print-stats.
+      hlsl::PassObserver *Observer = hlsl::CurrentPassObserver();
+      if (Observer)
+        Observer->BeginPass(FP->getPassName(), *F.getParent(), &F);
+      // HLSL Change End
 
       LocalChanged |= FP->runOnFunction(F);
+
+      // HLSL Change Begin
+      if (Observer)
+        Observer->EndPass(FP->getPassName(), *F.getParent(), &F, LocalChanged);
+      // HLSL Change End
     }
 
     Changed |= LocalChanged;
@@ -1589,6 +1606,8 @@ MPPassManager::runOnModule(Module &M) {
     ModulePass *MP = getContainedPass(Index);
     bool LocalChanged = false;
 
+    hlsl::ThrowIfCancellationRequested(); // HLSL Change
+
     dumpPassInfo(MP, EXECUTION_MSG, ON_MODULE_MSG, M.getModuleIdentifier());
     dumpRequiredSet(MP);
 
@@ -1597,8 +1616,19 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      hlsl::PhaseSpan PassSpan(MP->getPassName()); // HLSL Change
+      // HLSL Change Begin - report the pass to the observer for -print-stats.
+      hlsl::PassObserver *Observer = hlsl::CurrentPassObserver();
+      if (Observer)
+        Observer->BeginPass(MP->getPassName(), M, nullptr);
+      // HLSL Change End
 
       LocalChanged |= MP->runOnModule(M);
+
+      // HLSL Change Begin
+      if (Observer)
+        Observer->EndPass(MP->getPassName(), M, nullptr, LocalChanged);
+      // HLSL Change End
     }
 
     Changed |= LocalChanged;
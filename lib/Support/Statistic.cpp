@@ -64,6 +64,7 @@ public:
 
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
+static ManagedStatic<std::vector<const Statistic *> > AllStats; // HLSL Change
 
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
@@ -74,6 +75,7 @@ void Statistic::RegisterStatistic() {
   if (!Initialized) {
     if (Enabled)
       StatInfo->addStatistic(this);
+    AllStats->push_back(this); // HLSL Change
 
     TsanHappensBefore(this);
     sys::MemoryFence();
@@ -97,6 +99,13 @@ bool llvm::AreStatisticsEnabled() {
   return Enabled;
 }
 
+// HLSL Change Begin
+void llvm::GetStatistics(std::vector<const Statistic *> &Stats) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  Stats.assign(AllStats->begin(), AllStats->end());
+}
+// HLSL Change End
+
 void llvm::PrintStatistics(raw_ostream &OS) {
   StatisticInfo &Stats = *StatInfo;
 
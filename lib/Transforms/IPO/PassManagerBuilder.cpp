@@ -275,27 +275,82 @@ void PassManagerBuilder::populateModulePassManager(
     // HLSL Change Begins.
     addHLSLPasses(HLSLHighLevel, true/*NoOpt*/, HLSLExtensionsCodeGen, MPM); // HLSL Change
     if (!HLSLHighLevel) {
+      if (HLSLRenderTargetMask != 0xFF || HLSLDepthWriteDisabled ||
+          HLSLHasConsumerInputs)
+        MPM.add(createDxilPruneUnreadOutputsPass(
+            HLSLRenderTargetMask, HLSLDepthWriteDisabled,
+            HLSLHasConsumerInputs ? HLSLConsumerInputs.c_str() : nullptr));
+      if (HLSLProfileRegions)
+        MPM.add(createDxilInsertProfileRegionsPass()); // HLSL Change
       MPM.add(createMultiDimArrayToOneDimArrayPass());// HLSL Change
       MPM.add(createDxilCondenseResourcesPass()); // HLSL Change
       MPM.add(createDxilLegalizeSampleOffsetPass()); // HLSL Change
       MPM.add(createComputeViewIdStatePass());    // HLSL Change
-      MPM.add(createDxilEmitMetadataPass());      // HLSL Change
+      MPM.add(createDxilEmitMetadataPass(HLSLRootSignatureInMetadata));      // HLSL Change
     }
     // HLSL Change Ends.
     return;
   }
 
-  if (!HLSLHighLevel) {
+  if (!HLSLHighLevel && !HLSLLinked) {
     MPM.add(createHLEnsureMetadataPass()); // HLSL Change - rehydrate metadata from high-level codegen
   }
 
   // HLSL Change Begins
   MPM.add(createAlwaysInlinerPass(/*InsertLifeTime*/false));
+  // Joins the inliner's SCC pass manager, so each helper is simplified once,
+  // after its callees are inlined and before it is inlined into its callers.
+  if (!HLSLLinked)
+    MPM.add(createDxilSimplifyBeforeInlinePass());
   if (Inliner) {
     delete Inliner;
     Inliner = nullptr;
   }
-  addHLSLPasses(HLSLHighLevel, false/*NoOpt*/, HLSLExtensionsCodeGen, MPM); // HLSL Change
+  // A linked module is DXIL already; its libraries were lowered when they
+  // were compiled, so only the optimizations below run on it.
+  if (!HLSLLinked)
+    addHLSLPasses(HLSLHighLevel, false/*NoOpt*/, HLSLExtensionsCodeGen, MPM); // HLSL Change
+
+  // Block profiles are collected and applied right after DXIL generation,
+  // where the blocks of a recompile match the instrumented ones.
+  if (!HLSLHighLevel && !HLSLLinked) {
+    if (HLSLProfileInstrument)
+      MPM.add(createDxilInsertBlockCountersPass());
+    else if (!HLSLBlockProfile.empty())
+      MPM.add(createDxilApplyBlockProfilePass(HLSLBlockProfile));
+    // Region markers block code motion across them until they are replaced.
+    if (HLSLProfileRegions)
+      MPM.add(createDxilInsertProfileRegionsPass());
+    // Outputs are dropped before optimizing so that the computations that
+    // only fed them are removed along with everything else that is dead.
+    if (HLSLRenderTargetMask != 0xFF || HLSLDepthWriteDisabled ||
+        HLSLHasConsumerInputs)
+      MPM.add(createDxilPruneUnreadOutputsPass(
+          HLSLRenderTargetMask, HLSLDepthWriteDisabled,
+          HLSLHasConsumerInputs ? HLSLConsumerInputs.c_str() : nullptr));
+  }
+
+  // The fast-compile tier (-O1fast) stops after the lowering above, which
+  // already runs SROA_HLSL with promotion, mem2reg, instsimplify, the
+  // scalarizer and DCE, and adds only cheap clean-up: one instcombine,
+  // SCCP, ADCE and simplifycfg. It runs no GVN, LICM or loop passes, so
+  // loops are left rolled and redundant loads are kept.
+  if (HLSLFastOpt) {
+    MPM.add(createInstructionCombiningPass());
+    MPM.add(createSCCPPass());
+    MPM.add(createAggressiveDCEPass());
+    MPM.add(createCFGSimplificationPass());
+    MPM.add(createGlobalDCEPass());
+    if (!HLSLHighLevel) {
+      MPM.add(createMultiDimArrayToOneDimArrayPass());
+      MPM.add(createDxilCondenseResourcesPass());
+      MPM.add(createDxilLegalizeSampleOffsetPass());
+      MPM.add(createComputeViewIdStatePass());
+      MPM.add(createDxilEmitMetadataPass(HLSLRootSignatureInMetadata));
+    }
+    addExtensionsToPM(EP_OptimizerLast, MPM);
+    return;
+  }
   // HLSL Change Ends
 
   // Add LibraryInfo if we have some.
@@ -352,7 +407,7 @@ void PassManagerBuilder::populateModulePassManager(
   MPM.add(createReassociatePass());           // Reassociate expressions
   // Rotate Loop - disable header duplication at -Oz
   MPM.add(createLoopRotatePass(SizeLevel == 2 ? 0 : -1));
-  MPM.add(createLICMPass());                  // Hoist loop invariants
+  MPM.add(createLICMPass(HLSLFunctionBudget)); // Hoist loop invariants
   MPM.add(createLoopUnswitchPass(SizeLevel || OptLevel < 3));
   MPM.add(createInstructionCombiningPass());
   MPM.add(createIndVarSimplifyPass());        // Canonicalize indvars
@@ -366,11 +421,21 @@ void PassManagerBuilder::populateModulePassManager(
     MPM.add(createSimpleLoopUnrollPass());    // Unroll small loops
   addExtensionsToPM(EP_LoopOptimizerEnd, MPM);
 
+  // HLSL Change - hoist and merge handles and cbuffer loads that stores and
+  // barriers would hide from LICM and GVN.
+  MPM.add(createDxilCoalesceCBufferLoadsPass());
+  // HLSL Change - drop the cross-lane work of wave operations on wave-uniform
+  // values, before GVN and instcombine clean up what replaces them.
+  MPM.add(createDxilSimplifyWaveOpsPass());
+
   if (OptLevel > 1) {
     if (EnableMLSM)
       MPM.add(createMergedLoadStoreMotionPass()); // Merge ld/st in diamonds
-    MPM.add(createGVNPass(DisableGVNLoadPRE));  // Remove redundancies
+    MPM.add(createGVNPass(DisableGVNLoadPRE, HLSLFunctionBudget)); // Remove redundancies
   }
+  // HLSL Change - merge loads of 2x2 texel blocks into gathers, once GVN has
+  // given the loads of a block common coordinate bases.
+  MPM.add(createDxilLoadToGatherPass());
   // HLSL Change Begins.
   // HLSL don't allow memcpy and memset.
   //MPM.add(createMemCpyOptPass());             // Remove memcpy / form memset
@@ -389,7 +454,7 @@ void PassManagerBuilder::populateModulePassManager(
   // HLSL Change. MPM.add(createJumpThreadingPass());         // Thread jumps
   MPM.add(createCorrelatedValuePropagationPass());
   MPM.add(createDeadStoreEliminationPass());  // Delete dead stores
-  MPM.add(createLICMPass());
+  MPM.add(createLICMPass(HLSLFunctionBudget));
 
   addExtensionsToPM(EP_ScalarOptimizerLate, MPM);
 
@@ -500,7 +565,9 @@ void PassManagerBuilder::populateModulePassManager(
   MPM.add(createInstructionCombiningPass());
 
   if (!DisableUnrollLoops) {
-    MPM.add(createLoopUnrollPass());    // Unroll small loops
+    // Unroll small loops. HLSL Change - this is the last unroll pass, so it
+    // reports [unroll] attributes that could not be honored.
+    MPM.add(createLoopUnrollPass(-1, -1, -1, -1, true/*ReportHintFailures*/));
 
     // LoopUnroll may generate some redundency to cleanup.
     MPM.add(createInstructionCombiningPass());
@@ -509,7 +576,7 @@ void PassManagerBuilder::populateModulePassManager(
     // unrolled loop is a inner loop, then the prologue will be inside the
     // outer loop. LICM pass can help to promote the runtime check out if the
     // checked value is loop invariant.
-    MPM.add(createLICMPass());
+    MPM.add(createLICMPass(HLSLFunctionBudget));
   }
 
   // After vectorization and unrolling, assume intrinsics may tell us more
@@ -544,12 +611,22 @@ void PassManagerBuilder::populateModulePassManager(
 
   // HLSL Change Begins.
   if (!HLSLHighLevel) {
+    MPM.add(createDxilCombineBufferAccessesPass());
+    MPM.add(createDxilNonUniformHandlesPass());
+    if (HLSLHoistSamples)
+      MPM.add(createDxilHoistSamplesPass());
+    if (HLSLPairHalfOps)
+      MPM.add(createDxilPairHalfOpsPass());
     MPM.add(createMultiDimArrayToOneDimArrayPass());// HLSL Change
+    if (HLSLDynamicIndexToSelect)
+      MPM.add(createDxilDynamicIndexToSelectPass());
+    if (HLSLConstTableSelect || HLSLReportConstTables)
+      MPM.add(createDxilConstantTablesPass(HLSLConstTableSelect));
     MPM.add(createDxilCondenseResourcesPass());
     if (DisableUnrollLoops)
       MPM.add(createDxilLegalizeSampleOffsetPass()); // HLSL Change
     MPM.add(createComputeViewIdStatePass()); // HLSL Change
-    MPM.add(createDxilEmitMetadataPass());
+    MPM.add(createDxilEmitMetadataPass(HLSLRootSignatureInMetadata));
   }
   // HLSL Change Ends.
   addExtensionsToPM(EP_OptimizerLast, MPM);
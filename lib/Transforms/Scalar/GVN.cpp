@@ -591,6 +591,7 @@ namespace {
 
   class GVN : public FunctionPass {
     bool NoLoads;
+    unsigned MaxInstructions; // HLSL Change
     MemoryDependenceAnalysis *MD;
     DominatorTree *DT;
     const TargetLibraryInfo *TLI;
@@ -617,8 +618,9 @@ namespace {
 
   public:
     static char ID; // Pass identification, replacement for typeid
-    explicit GVN(bool noloads = false)
-        : FunctionPass(ID), NoLoads(noloads), MD(nullptr) {
+    explicit GVN(bool noloads = false, unsigned maxInstructions = 0) // HLSL Change
+        : FunctionPass(ID), NoLoads(noloads), MaxInstructions(maxInstructions), // HLSL Change
+          MD(nullptr) {
       initializeGVNPass(*PassRegistry::getPassRegistry());
     }
 
@@ -730,8 +732,8 @@ namespace {
 }
 
 // The public interface to this file...
-FunctionPass *llvm::createGVNPass(bool NoLoads) {
-  return new GVN(NoLoads);
+FunctionPass *llvm::createGVNPass(bool NoLoads, unsigned MaxInstructions) { // HLSL Change
+  return new GVN(NoLoads, MaxInstructions); // HLSL Change
 }
 
 INITIALIZE_PASS_BEGIN(GVN, "gvn", "Global Value Numbering", false, false)
@@ -2326,8 +2328,14 @@ bool GVN::runOnFunction(Function& F) {
   if (skipOptnoneFunction(F))
     return false;
 
-  if (!NoLoads)
+  // HLSL Change Begins - functions over budget skip the memory dependence
+  // queries of load elimination and the scalar PRE iterations.
+  bool OverBudget = isOverInstructionBudget(
+      F, MaxInstructions, "gvn", "runs without load elimination or PRE");
+  MD = nullptr;
+  if (!NoLoads && !OverBudget)
     MD = &getAnalysis<MemoryDependenceAnalysis>();
+  // HLSL Change Ends
   DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
   AC = &getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F);
   TLI = &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
@@ -2358,7 +2366,7 @@ bool GVN::runOnFunction(Function& F) {
     ++Iteration;
   }
 
-  if (EnablePRE) {
+  if (EnablePRE && !OverBudget) { // HLSL Change
     // Fabricate val-num for dead-code in order to suppress assertion in
     // performPRE().
     assignValNumForDeadCode();
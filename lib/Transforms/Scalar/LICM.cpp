@@ -101,7 +101,10 @@ static bool canSinkOrHoistInst(Instruction &I, AliasAnalysis *AA,
 namespace {
   struct LICM : public LoopPass {
     static char ID; // Pass identification, replacement for typeid
-    LICM() : LoopPass(ID) {
+    // HLSL Change - skip functions over MaxInstructions.
+    explicit LICM(unsigned MaxInstructions = 0)
+        : LoopPass(ID), MaxInstructions(MaxInstructions),
+          BudgetFunction(nullptr), OverBudget(false) {
       initializeLICMPass(*PassRegistry::getPassRegistry());
     }
 
@@ -132,6 +135,12 @@ namespace {
     }
 
   private:
+    // HLSL Change Begins - the budget is checked once per function.
+    unsigned MaxInstructions;
+    const Function *BudgetFunction;
+    bool OverBudget;
+    // HLSL Change Ends
+
     AliasAnalysis *AA;       // Current AliasAnalysis information
     LoopInfo      *LI;       // Current LoopInfo
     DominatorTree *DT;       // Dominator Tree for the current Loop.
@@ -169,7 +178,9 @@ INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
 INITIALIZE_PASS_END(LICM, "licm", "Loop Invariant Code Motion", false, false)
 
-Pass *llvm::createLICMPass() { return new LICM(); }
+Pass *llvm::createLICMPass(unsigned MaxInstructions) { // HLSL Change
+  return new LICM(MaxInstructions);
+}
 
 /// Hoist expressions out of the specified loop. Note, alias info for inner
 /// loop is not preserved so it is not a good idea to run LICM multiple
@@ -179,6 +190,18 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
   if (skipOptnoneFunction(L))
     return false;
 
+  // HLSL Change Begins - every loop of a function over budget is skipped,
+  // so no outer loop looks for the alias sets of a skipped inner one.
+  Function *F = L->getHeader()->getParent();
+  if (F != BudgetFunction) {
+    BudgetFunction = F;
+    OverBudget = isOverInstructionBudget(*F, MaxInstructions, "licm",
+                                         "is skipped");
+  }
+  if (OverBudget)
+    return false;
+  // HLSL Change Ends
+
   Changed = false;
 
   // Get our Loop and Alias Analysis information...
@@ -31,6 +31,8 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/UnrollLoop.h"
+#include "dxc/HLSL/DxilOperations.h"   // HLSL Change
+#include "dxc/HLSL/DxilInstructions.h" // HLSL Change
 #include <climits>
 
 using namespace llvm;
@@ -76,11 +78,25 @@ PragmaUnrollThreshold("pragma-unroll-threshold", cl::init(16 * 1024), cl::Hidden
   cl::desc("Unrolled size limit for loops with an unroll(full) or "
            "unroll_count pragma."));
 
+// HLSL Change Begin - DXIL unroll cost model.
+static cl::opt<unsigned> HLSLUnrollFetchBonus(
+    "hlsl-unroll-fetch-bonus", cl::init(10), cl::Hidden,
+    cl::desc("Amount the full unroll threshold grows by for each texture or "
+             "buffer read executed by the loop."));
+
+static cl::opt<unsigned> HLSLUnrollConstantIndexThreshold(
+    "hlsl-unroll-constant-index-threshold", cl::init(1024), cl::Hidden,
+    cl::desc("Full unroll threshold for loops whose resource and cbuffer "
+             "indices become constant when unrolled; also caps the fetch "
+             "bonus."));
+// HLSL Change End
+
 namespace {
   class LoopUnroll : public LoopPass {
   public:
     static char ID; // Pass ID, replacement for typeid
-    LoopUnroll(int T = -1, int C = -1, int P = -1, int R = -1) : LoopPass(ID) {
+    LoopUnroll(int T = -1, int C = -1, int P = -1, int R = -1,
+               bool H = false) : LoopPass(ID) { // HLSL Change - H
       CurrentThreshold = (T == -1) ? UnrollThreshold : unsigned(T);
       CurrentPercentDynamicCostSavedThreshold =
           UnrollPercentDynamicCostSavedThreshold;
@@ -99,6 +115,12 @@ namespace {
       UserRuntime = (R != -1) || (UnrollRuntime.getNumOccurrences() > 0);
       UserCount = (C != -1) || (UnrollCount.getNumOccurrences() > 0);
 
+      // HLSL Change Begin
+      CurrentFetchBonus = HLSLUnrollFetchBonus;
+      CurrentConstantIndexThreshold = HLSLUnrollConstantIndexThreshold;
+      ReportHintFailures = H;
+      // HLSL Change End
+
       initializeLoopUnrollPass(*PassRegistry::getPassRegistry());
     }
 
@@ -130,6 +152,30 @@ namespace {
     bool UserAllowPartial;
     bool UserRuntime;
 
+    // HLSL Change Begin
+    unsigned CurrentFetchBonus;
+    unsigned CurrentConstantIndexThreshold;
+    // A loop with an unroll(full) pragma is retried by every unroll pass in
+    // the pipeline, so only the last one warns when it cannot be unrolled.
+    bool ReportHintFailures;
+    LoopUnrollCallbacks Callbacks;
+
+    void applyOptions(PassOptions O) override {
+      GetPassOptionUnsigned(O, "hlsl-unroll-fetch-bonus", &CurrentFetchBonus,
+                            CurrentFetchBonus);
+      GetPassOptionUnsigned(O, "hlsl-unroll-constant-index-threshold",
+                            &CurrentConstantIndexThreshold,
+                            CurrentConstantIndexThreshold);
+      GetPassOptionBool(O, "ReportHintFailures", &ReportHintFailures,
+                        ReportHintFailures);
+    }
+
+    // Raises the full unroll threshold for loops that benefit from complete
+    // unrolling more on GPUs than their size suggests.
+    unsigned selectHLSLFullThreshold(Loop *L, ScalarEvolution &SE,
+                                     unsigned TripCount, unsigned Threshold);
+    // HLSL Change End
+
     bool runOnLoop(Loop *L, LPPassManager &LPM) override;
 
     /// This transformation requires natural loop information & requires that
@@ -242,10 +288,20 @@ INITIALIZE_PASS_DEPENDENCY(ScalarEvolution)
 INITIALIZE_PASS_END(LoopUnroll, "loop-unroll", "Unroll loops", false, false)
 
 Pass *llvm::createLoopUnrollPass(int Threshold, int Count, int AllowPartial,
-                                 int Runtime) {
-  return new LoopUnroll(Threshold, Count, AllowPartial, Runtime);
+                                 int Runtime, bool ReportHintFailures) {
+  return new LoopUnroll(Threshold, Count, AllowPartial, Runtime,
+                        ReportHintFailures); // HLSL Change
 }
 
+// HLSL Change Begin
+Pass *llvm::createLoopUnrollPass(int Threshold, int Count, int AllowPartial,
+                                 int Runtime, LoopUnrollCallbacks Callbacks) {
+  LoopUnroll *P = new LoopUnroll(Threshold, Count, AllowPartial, Runtime);
+  P->Callbacks = std::move(Callbacks);
+  return P;
+}
+// HLSL Change End
+
 Pass *llvm::createSimpleLoopUnrollPass() {
   return llvm::createLoopUnrollPass(-1, -1, 0, 0);
 }
@@ -569,6 +625,86 @@ static unsigned ApproximateLoopSize(const Loop *L, unsigned &NumCalls,
   return LoopSize;
 }
 
+// HLSL Change Begin - DXIL unroll cost model.
+// Texture and buffer reads have latencies of hundreds of cycles. In a rolled
+// loop each iteration waits for its own reads; unrolled, the reads of all
+// iterations are independent and can be issued back to back.
+static bool IsHighLatencyDxilOp(hlsl::OP::OpCode Opcode) {
+  switch (Opcode) {
+  case hlsl::OP::OpCode::Sample:
+  case hlsl::OP::OpCode::SampleBias:
+  case hlsl::OP::OpCode::SampleLevel:
+  case hlsl::OP::OpCode::SampleGrad:
+  case hlsl::OP::OpCode::SampleCmp:
+  case hlsl::OP::OpCode::SampleCmpLevelZero:
+  case hlsl::OP::OpCode::TextureLoad:
+  case hlsl::OP::OpCode::TextureGather:
+  case hlsl::OP::OpCode::TextureGatherCmp:
+  case hlsl::OP::OpCode::BufferLoad:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Returns true if V is an affine recurrence of L with a constant start and
+// step, which folds to a constant in every copy of a fully unrolled body.
+static bool IsConstantAfterFullUnroll(Value *V, const Loop *L,
+                                      ScalarEvolution &SE) {
+  if (!SE.isSCEVable(V->getType()))
+    return false;
+  auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(V));
+  return AR && AR->getLoop() == L && AR->isAffine() &&
+         isa<SCEVConstant>(AR->getStart()) &&
+         isa<SCEVConstant>(AR->getStepRecurrence(SE));
+}
+
+unsigned LoopUnroll::selectHLSLFullThreshold(Loop *L, ScalarEvolution &SE,
+                                             unsigned TripCount,
+                                             unsigned Threshold) {
+  if (Threshold == NoThreshold)
+    return Threshold;
+
+  unsigned NumFetches = 0;
+  bool MakesIndexConstant = false;
+  for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end();
+       BI != BE; ++BI) {
+    for (Instruction &I : **BI) {
+      if (!hlsl::OP::IsDxilOpFuncCallInst(&I))
+        continue;
+      if (IsHighLatencyDxilOp(hlsl::OP::GetDxilOpFuncCallInst(&I)))
+        ++NumFetches;
+      // Dynamically indexed resource arrays and cbuffer arrays need indexed
+      // descriptors or registers; constant indices avoid both.
+      hlsl::DxilInst_CreateHandle CreateHandle(&I);
+      hlsl::DxilInst_CBufferLoadLegacy CBufferLoad(&I);
+      if (CreateHandle)
+        MakesIndexConstant |=
+            IsConstantAfterFullUnroll(CreateHandle.get_index(), L, SE);
+      else if (CBufferLoad)
+        MakesIndexConstant |=
+            IsConstantAfterFullUnroll(CBufferLoad.get_regIndex(), L, SE);
+    }
+  }
+
+  unsigned Limit = std::max(Threshold, CurrentConstantIndexThreshold);
+  if (MakesIndexConstant) {
+    DEBUG(dbgs() << "  Unrolling makes resource indices constant.\n");
+    return Limit;
+  }
+  uint64_t FetchBonus = (uint64_t)NumFetches * TripCount * CurrentFetchBonus;
+  DEBUG(dbgs() << "  Fetch bonus = " << FetchBonus << "\n");
+  return (unsigned)std::min<uint64_t>(Threshold + FetchBonus, Limit);
+}
+
+// Reports why a loop with an [unroll] or [unroll(N)] attribute was not
+// unrolled as directed.
+static void EmitUnrollHintWarning(const Loop *L, const Twine &Msg) {
+  const Function *F = L->getHeader()->getParent();
+  emitLoopUnrollWarning(F->getContext(), *F, L->getStartLoc(), Msg);
+}
+// HLSL Change End
+
 // Returns the loop hint metadata node with the given name (for example,
 // "llvm.loop.unroll.count").  If no such metadata node exists, then nullptr is
 // returned.
@@ -741,6 +877,11 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   if (skipOptnoneFunction(L))
     return false;
 
+  // HLSL Change Begin
+  if (Callbacks.ShouldUnroll && !Callbacks.ShouldUnroll(L))
+    return false;
+  // HLSL Change End
+
   Function &F = *L->getHeader()->getParent();
 
   LoopInfo *LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
@@ -796,10 +937,20 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   if (notDuplicatable) {
     DEBUG(dbgs() << "  Not unrolling loop which contains non-duplicatable"
                  << " instructions.\n");
+    // HLSL Change Begin
+    if (HasPragma && ReportHintFailures)
+      EmitUnrollHintWarning(
+          L, "the loop contains instructions that cannot be duplicated");
+    // HLSL Change End
     return false;
   }
   if (NumInlineCandidates != 0) {
     DEBUG(dbgs() << "  Not unrolling loop with inlinable calls.\n");
+    // HLSL Change Begin
+    if (HasPragma && ReportHintFailures)
+      EmitUnrollHintWarning(
+          L, "the loop calls a function that has not been inlined");
+    // HLSL Change End
     return false;
   }
 
@@ -816,8 +967,12 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   int Unrolling;
   if (TripCount && Count == TripCount) {
     Unrolling = Partial;
+    // HLSL Change Begin - DXIL unroll cost model.
+    unsigned FullThreshold =
+        selectHLSLFullThreshold(L, *SE, TripCount, Threshold);
+    // HLSL Change End
     // If the loop is really small, we don't need to run an expensive analysis.
-    if (canUnrollCompletely(L, Threshold, 100, DynamicCostSavingsDiscount,
+    if (canUnrollCompletely(L, FullThreshold, 100, DynamicCostSavingsDiscount,
                             UnrolledSize, UnrolledSize)) {
       Unrolling = Full;
     } else {
@@ -825,8 +980,10 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
       // helps to remove a significant number of instructions.
       // To check that, run additional analysis on the loop.
       if (Optional<EstimatedUnrollCost> Cost = analyzeLoopUnrollCost(
-              L, TripCount, *SE, TTI, Threshold + DynamicCostSavingsDiscount))
-        if (canUnrollCompletely(L, Threshold, PercentDynamicCostSavedThreshold,
+              L, TripCount, *SE, TTI,
+              FullThreshold + DynamicCostSavingsDiscount))
+        if (canUnrollCompletely(L, FullThreshold,
+                                PercentDynamicCostSavedThreshold,
                                 DynamicCostSavingsDiscount, Cost->UnrolledCost,
                                 Cost->RolledDynamicCost)) {
           Unrolling = Full;
@@ -863,6 +1020,11 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
     if (!AllowRuntime && !CountSetExplicitly) {
       DEBUG(dbgs() << "  will not try to unroll loop with runtime trip count "
                    << "-unroll-runtime not given\n");
+      // HLSL Change Begin
+      if (PragmaFullUnroll && ReportHintFailures)
+        EmitUnrollHintWarning(
+            L, "[unroll] requires a trip count known at compile time");
+      // HLSL Change End
       return false;
     }
     // Reduce unroll count to be the largest power-of-two factor of
@@ -882,29 +1044,25 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
       // unrolling beyond that requested by the pragma.
       SetLoopAlreadyUnrolled(L);
 
-    // Emit optimization remarks if we are unable to unroll the loop
-    // as directed by a pragma.
-    DebugLoc LoopLoc = L->getStartLoc();
-    Function *F = Header->getParent();
-    LLVMContext &Ctx = F->getContext();
-    if (PragmaFullUnroll && PragmaCount == 0) {
+    // HLSL Change Begin - warn rather than remark, since HLSL unroll
+    // attributes are requirements the user expects to be met.
+    // Emit warnings if we are unable to unroll the loop as directed by a
+    // pragma. The unroll_count loop is final once marked as unrolled above.
+    if (PragmaFullUnroll && PragmaCount == 0 && ReportHintFailures) {
       if (TripCount && Count != TripCount) {
-        emitOptimizationRemarkMissed(
-            Ctx, DEBUG_TYPE, *F, LoopLoc,
-            "Unable to fully unroll loop as directed by unroll(full) pragma "
-            "because unrolled size is too large.");
+        EmitUnrollHintWarning(L, Twine("[unroll] of ") + Twine(TripCount) +
+                                     " iterations would exceed the unrolled "
+                                     "size limit");
       } else if (!TripCount) {
-        emitOptimizationRemarkMissed(
-            Ctx, DEBUG_TYPE, *F, LoopLoc,
-            "Unable to fully unroll loop as directed by unroll(full) pragma "
-            "because loop has a runtime trip count.");
+        EmitUnrollHintWarning(
+            L, "[unroll] requires a trip count known at compile time");
       }
     } else if (PragmaCount > 0 && Count != OriginalCount) {
-      emitOptimizationRemarkMissed(
-          Ctx, DEBUG_TYPE, *F, LoopLoc,
-          "Unable to unroll loop the number of times directed by "
-          "unroll_count pragma because unrolled size is too large.");
+      EmitUnrollHintWarning(L, Twine("[unroll(") + Twine(PragmaCount) +
+                                   ")] would exceed the unrolled size limit; "
+                                   "unroll count reduced to " + Twine(Count));
     }
+    // HLSL Change End
   }
 
   if (Unrolling != Full && Count < 2) {
@@ -914,9 +1072,21 @@ bool LoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   }
 
   // Unroll the loop.
+  DebugLoc LoopLoc = L->getStartLoc(); // HLSL Change - L may be deleted.
   if (!UnrollLoop(L, Count, TripCount, AllowRuntime, UP.AllowExpensiveTripCount,
-                  TripMultiple, LI, this, &LPM, &AC))
+                  TripMultiple, LI, this, &LPM, &AC)) {
+    // HLSL Change Begin
+    if (PragmaCount > 0 || (PragmaFullUnroll && ReportHintFailures))
+      EmitUnrollHintWarning(L, "the loop is not in a form that can be "
+                               "unrolled");
+    // HLSL Change End
     return false;
+  }
+
+  // HLSL Change Begin
+  if (Callbacks.Unrolled)
+    Callbacks.Unrolled(LoopLoc, Count, TripCount);
+  // HLSL Change End
 
   return true;
 }
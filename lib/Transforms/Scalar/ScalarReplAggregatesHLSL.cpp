@@ -15,6 +15,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
@@ -25,6 +26,7 @@
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
@@ -54,6 +56,8 @@
 #include "dxc/HLSL/DxilTypeSystem.h"
 #include "dxc/HLSL/HLMatrixLowerHelper.h"
 #include "dxc/HLSL/DxilOperations.h"
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/Cancellation.h"
 #include <deque>
 #include <unordered_map>
 #include <unordered_set>
@@ -1545,6 +1549,7 @@ bool SROA_HLSL::performScalarRepl(Function &F, DxilTypeSystem &typeSys) {
     std::deque<AllocaInst *> WorkList;
     WorkList.emplace_back(Alloc);
     while (!WorkList.empty()) {
+      hlsl::ThrowIfCancellationRequested();
       AllocaInst *AI = WorkList.front();
       WorkList.pop_front();
 
@@ -2144,22 +2149,13 @@ static void SimplePtrCopy(Value *DestPtr, Value *SrcPtr,
   Builder.CreateStore(ld, DestPtr);
 }
 
-// Copy srcVal to destPtr.
+// Copy srcVal to destPtr. SplitCpy has already extracted srcVal down to the
+// element that idxList addresses.
 static void SimpleValCopy(Value *DestPtr, Value *SrcVal,
                        llvm::SmallVector<llvm::Value *, 16> &idxList,
                        IRBuilder<> &Builder) {
   Value *DestGEP = Builder.CreateInBoundsGEP(DestPtr, idxList);
-  Value *Val = SrcVal;
-  // Skip beginning pointer type.
-  for (unsigned i = 1; i < idxList.size(); i++) {
-    ConstantInt *idx = cast<ConstantInt>(idxList[i]);
-    Type *Ty = Val->getType();
-    if (Ty->isAggregateType()) {
-      Val = Builder.CreateExtractValue(Val, idx->getLimitedValue());
-    }
-  }
-
-  Builder.CreateStore(Val, DestGEP);
+  Builder.CreateStore(SrcVal, DestGEP);
 }
 
 static void SimpleCopy(Value *Dest, Value *Src,
@@ -2170,7 +2166,9 @@ static void SimpleCopy(Value *Dest, Value *Src,
   else
     SimpleValCopy(Dest, Src, idxList, Builder);
 }
-// Split copy into ld/st.
+// Split copy into ld/st. When Src is a value rather than a pointer, each
+// aggregate level extracts its elements once and passes them down, instead of
+// every leaf extracting its whole path again.
 static void SplitCpy(Type *Ty, Value *Dest, Value *Src,
                      SmallVector<Value *, 16> &idxList, IRBuilder<> &Builder,
                      DxilTypeSystem &typeSys,
@@ -2235,7 +2233,10 @@ static void SplitCpy(Type *Ty, Value *Dest, Value *Src,
           IntegerType::get(Ty->getContext(), 32), APInt(32, i));
       idxList.emplace_back(idx);
       DxilFieldAnnotation &EltAnnotation = STA->GetFieldAnnotation(i);
-      SplitCpy(ET, Dest, Src, idxList, Builder, typeSys, &EltAnnotation);
+      Value *EltSrc = Src->getType()->isPointerTy()
+                          ? Src
+                          : Builder.CreateExtractValue(Src, i);
+      SplitCpy(ET, Dest, EltSrc, idxList, Builder, typeSys, &EltAnnotation);
 
       idxList.pop_back();
     }
@@ -2247,7 +2248,10 @@ static void SplitCpy(Type *Ty, Value *Dest, Value *Src,
       Constant *idx = Constant::getIntegerValue(
           IntegerType::get(Ty->getContext(), 32), APInt(32, i));
       idxList.emplace_back(idx);
-      SplitCpy(ET, Dest, Src, idxList, Builder, typeSys, fieldAnnotation);
+      Value *EltSrc = Src->getType()->isPointerTy()
+                          ? Src
+                          : Builder.CreateExtractValue(Src, i);
+      SplitCpy(ET, Dest, EltSrc, idxList, Builder, typeSys, fieldAnnotation);
 
       idxList.pop_back();
     }
@@ -2497,6 +2501,25 @@ void MemcpySplitter::Split(llvm::Function &F) {
 // SRoA Helper
 //===----------------------------------------------------------------------===//
 
+/// GetConstantEltUsers - Check whether every user of Ptr is a GEP that selects
+/// one of its NumElts struct or vector elements with a constant index, and if
+/// so collect the selected elements into UsedElts.
+static bool GetConstantEltUsers(Value *Ptr, unsigned NumElts,
+                                SmallBitVector &UsedElts) {
+  UsedElts.resize(NumElts);
+  for (User *U : Ptr->users()) {
+    GetElementPtrInst *UserGEP = dyn_cast<GetElementPtrInst>(U);
+    if (!UserGEP || UserGEP->getPointerOperand() != Ptr ||
+        UserGEP->getNumIndices() < 2)
+      return false;
+    ConstantInt *EltIdx = dyn_cast<ConstantInt>(UserGEP->getOperand(2));
+    if (!EltIdx || EltIdx->getLimitedValue() >= NumElts)
+      return false;
+    UsedElts.set(EltIdx->getLimitedValue());
+  }
+  return true;
+}
+
 /// RewriteGEP - Rewrite the GEP to be relative to new element when can find a
 /// new element which is struct field. If cannot find, create new element GEPs
 /// and try to rewrite GEP with new GEPS.
@@ -2556,16 +2579,25 @@ void SROA_Helper::RewriteForGEP(GEPOperator *GEP, IRBuilder<> &Builder) {
       SmallVector<Value *, 8> NewArgs;
       NewArgs.append(GEP->idx_begin(), GEP->idx_end());
 
+      // When GEP is only used to address its elements with constant indices,
+      // as for a[i].field, only create the new geps those elements need;
+      // the rewrite never looks at the others.
+      SmallBitVector UsedElts;
+      bool OnlyEltUsers = (Ty->isStructTy() || Ty->isVectorTy()) &&
+                          GetConstantEltUsers(GEP, NewElts.size(), UsedElts);
+
       SmallVector<Value *, 8> NewGEPs;
       // create new geps
       for (unsigned i = 0, e = NewElts.size(); i != e; ++i) {
-        Value *NewGEP = Builder.CreateGEP(nullptr, NewElts[i], NewArgs);
+        Value *NewGEP = nullptr;
+        if (!OnlyEltUsers || UsedElts.test(i))
+          NewGEP = Builder.CreateGEP(nullptr, NewElts[i], NewArgs);
         NewGEPs.emplace_back(NewGEP);
       }
       SROA_Helper helper(GEP, NewGEPs, DeadInsts);
       helper.RewriteForScalarRepl(GEP, Builder);
       for (Value *NewGEP : NewGEPs) {
-        if (NewGEP->user_empty() && isa<Instruction>(NewGEP)) {
+        if (NewGEP && NewGEP->user_empty() && isa<Instruction>(NewGEP)) {
           // Delete unused newGEP.
           cast<Instruction>(NewGEP)->eraseFromParent();
         }
@@ -3874,6 +3906,7 @@ public:
 
     // Process the worklist
     while (!WorkList.empty()) {
+      hlsl::ThrowIfCancellationRequested();
       Function *F = WorkList.front();
       WorkList.pop_front();
       createFlattenedFunction(F);
@@ -6052,8 +6085,7 @@ public:
           HLModule::IsStaticGlobal(&GV) &&
           GV.getType()->getAddressSpace() == DXIL::kDefaultAddrSpace;
 
-      if (isStaticGlobal &&
-          !GV.getType()->getElementType()->isAggregateType()) {
+      if (isStaticGlobal) {
         staticGVs.emplace_back(&GV);
       }
     }
@@ -6069,32 +6101,190 @@ public:
 
 private:
   bool lowerStaticGlobalIntoAlloca(GlobalVariable *GV, const DataLayout &DL);
+  bool isIndependentEntry(Function *F);
 };
 }
 
+// Returns true for scalars, vectors and arrays of them, which are what is left
+// of a static global once its structures have been split.
+static bool IsLowerableStaticGlobalType(Type *Ty) {
+  while (Ty->isArrayTy())
+    Ty = Ty->getArrayElementType();
+  return !Ty->isAggregateType();
+}
+
+// Walks the uses of the address V, collecting the functions that access it.
+// Returns the first use that lets the address escape, or null when the
+// address is only loaded from, stored to and passed to calls.
+static User *CollectStaticGlobalAccesses(Value *V,
+                                         SetVector<Function *> &Funcs) {
+  for (User *U : V->users()) {
+    Instruction *I = dyn_cast<Instruction>(U);
+    if (I)
+      Funcs.insert(I->getParent()->getParent());
+
+    if (isa<GEPOperator>(U) || isa<BitCastOperator>(U)) {
+      if (User *Escape = CollectStaticGlobalAccesses(U, Funcs))
+        return Escape;
+    } else if (!I) {
+      // Other constants refer to the address, e.g. another initializer.
+      return U;
+    } else if (isa<LoadInst>(I)) {
+      continue;
+    } else if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
+      if (SI->getPointerOperand() != V)
+        return U;
+    } else if (CallInst *CI = dyn_cast<CallInst>(I)) {
+      // Subscripts return pointers into the global; other calls, like memcpy,
+      // matrix load and store or calls with the address as argument, only
+      // access it.
+      Function *Callee = CI->getCalledFunction();
+      if (Callee &&
+          GetHLOpcodeGroupByName(Callee) == HLOpcodeGroup::HLSubscript) {
+        if (User *Escape = CollectStaticGlobalAccesses(CI, Funcs))
+          return Escape;
+      }
+    } else {
+      return U;
+    }
+  }
+  return nullptr;
+}
+
+// Stores the initializer Init into Ptr, one element at a time for arrays,
+// skipping undef elements.
+static void StoreStaticGlobalInitializer(Constant *Init, Value *Ptr,
+                                         IRBuilder<> &Builder) {
+  Type *Ty = Init->getType();
+  if (!Ty->isArrayTy()) {
+    Builder.CreateStore(Init, Ptr);
+    return;
+  }
+  Value *zero = Builder.getInt32(0);
+  for (unsigned i = 0, e = Ty->getArrayNumElements(); i < e; i++) {
+    Constant *Elt = Init->getAggregateElement(i);
+    if (isa<UndefValue>(Elt))
+      continue;
+    Value *EltPtr = Builder.CreateInBoundsGEP(Ptr, {zero, Builder.getInt32(i)});
+    StoreStaticGlobalInitializer(Elt, EltPtr, Builder);
+  }
+}
+
+static bool IsConstantUsedInFunction(Constant *C, Function *F) {
+  for (User *U : C->users()) {
+    if (Instruction *I = dyn_cast<Instruction>(U)) {
+      if (I->getParent()->getParent() == F)
+        return true;
+    } else if (IsConstantUsedInFunction(cast<Constant>(U), F)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Like ReplaceConstantWithInst, but only replaces the uses inside F.
+static void ReplaceConstantWithInstInFunction(Constant *C, Value *V,
+                                              Function *F,
+                                              IRBuilder<> &Builder) {
+  for (auto it = C->user_begin(); it != C->user_end(); ) {
+    User *U = *(it++);
+    if (Instruction *I = dyn_cast<Instruction>(U)) {
+      if (I->getParent()->getParent() == F)
+        I->replaceUsesOfWith(C, V);
+    } else {
+      ConstantExpr *CE = cast<ConstantExpr>(U);
+      if (!IsConstantUsedInFunction(CE, F))
+        continue;
+      Instruction *Inst = CE->getAsInstruction();
+      Builder.Insert(Inst);
+      Inst->replaceUsesOfWith(C, V);
+      ReplaceConstantWithInstInFunction(CE, Inst, F, Builder);
+    }
+  }
+}
+
+// Each invocation of an entry point starts with static globals holding their
+// initializers, so entries which are not called from elsewhere may each keep
+// a private copy. The patch constant function runs in its own phase and does
+// not see what the hull shader main function stores.
+bool LowerStaticGlobalIntoAlloca::isIndependentEntry(Function *F) {
+  for (User *U : F->users()) {
+    if (isa<CallInst>(U))
+      return false;
+  }
+  if (m_pHLModule->HasDxilFunctionProps(F))
+    return true;
+  Function *Entry = m_pHLModule->GetEntryFunction();
+  if (F == Entry)
+    return true;
+  if (Entry && m_pHLModule->HasDxilFunctionProps(Entry)) {
+    DxilFunctionProps &props = m_pHLModule->GetDxilFunctionProps(Entry);
+    return props.IsHS() && props.ShaderProps.HS.patchConstantFunc == F;
+  }
+  return false;
+}
+
 bool LowerStaticGlobalIntoAlloca::lowerStaticGlobalIntoAlloca(GlobalVariable *GV, const DataLayout &DL) {
   DxilTypeSystem &typeSys = m_pHLModule->GetTypeSystem();
-  unsigned size = DL.getTypeAllocSize(GV->getType()->getElementType());
+  Type *Ty = GV->getType()->getElementType();
+  unsigned size = DL.getTypeAllocSize(Ty);
   PointerStatus PS(size);
   GV->removeDeadConstantUsers();
   PS.analyzePointer(GV, PS, typeSys, /*bStructElt*/ false);
   bool NotStored = (PS.StoredType == PointerStatus::NotStored) ||
                    (PS.StoredType == PointerStatus::InitializerStored);
-  // Make sure GV only used in one function.
-  // Skip GV which don't have store.
-  if (PS.HasMultipleAccessingFunctions || NotStored)
+  // Skip GV which don't have store, they are constants to later passes.
+  if (NotStored)
     return false;
 
-  Function *F = const_cast<Function*>(PS.AccessingFunction);
-  IRBuilder<> Builder(F->getEntryBlock().getFirstInsertionPt());
-  AllocaInst *AI = Builder.CreateAlloca(GV->getType()->getElementType());
+  std::string Reason;
+  raw_string_ostream OS(Reason);
+  SetVector<Function *> Funcs;
+  if (!IsLowerableStaticGlobalType(Ty)) {
+    OS << "it contains a structure";
+  } else if (User *Escape = CollectStaticGlobalAccesses(GV, Funcs)) {
+    OS << "its address escapes through ";
+    if (Instruction *I = dyn_cast<Instruction>(Escape))
+      OS << "a " << I->getOpcodeName() << " instruction";
+    else
+      OS << "a constant";
+  } else if (Funcs.size() > 1) {
+    // Make sure the functions don't share the value of GV.
+    for (Function *F : Funcs) {
+      if (!isIndependentEntry(F)) {
+        OS << "it is accessed from more than one function, and '"
+           << F->getName() << "' may see what the others store";
+        break;
+      }
+    }
+  }
+  OS.flush();
 
-  // Store initializer is exist.
-  if (GV->hasInitializer() && !isa<UndefValue>(GV->getInitializer())) {
-    Builder.CreateStore(GV->getInitializer(), GV);
+  if (!Reason.empty()) {
+    Function *F = Funcs.empty() ? const_cast<Function *>(PS.AccessingFunction)
+                                : Funcs.front();
+    if (F) {
+      emitOptimizationRemarkAnalysis(
+          GV->getContext(), DEBUG_TYPE, *F, DebugLoc(),
+          Twine("static global '") + GV->getName() +
+              "' is kept in memory because " + Reason);
+    }
+    return false;
   }
 
-  ReplaceConstantWithInst(GV, AI, Builder);
+  for (Function *F : Funcs) {
+    IRBuilder<> Builder(F->getEntryBlock().getFirstInsertionPt());
+    AllocaInst *AI = Builder.CreateAlloca(Ty);
+
+    // Store initializer is exist.
+    if (GV->hasInitializer() && !isa<UndefValue>(GV->getInitializer())) {
+      StoreStaticGlobalInitializer(GV->getInitializer(), AI, Builder);
+    }
+
+    ReplaceConstantWithInstInFunction(GV, AI, F, Builder);
+  }
+  GV->removeDeadConstantUsers();
+  DXASSERT(GV->user_empty(), "otherwise, static global used outside Funcs");
   GV->eraseFromParent();
   return true;
 }
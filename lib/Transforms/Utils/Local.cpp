@@ -28,6 +28,7 @@
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/DiagnosticInfo.h" // HLSL Change
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
@@ -1344,3 +1345,25 @@ unsigned llvm::replaceDominatedUsesWith(Value *From, Value *To,
   }
   return Count;
 }
+
+// HLSL Change Begins
+bool llvm::isOverInstructionBudget(Function &F, unsigned MaxInstructions,
+                                   StringRef PassName, StringRef Degradation) {
+  if (MaxInstructions == 0)
+    return false;
+  unsigned NumInstructions = 0;
+  for (BasicBlock &BB : F) {
+    NumInstructions += BB.size();
+    if (NumInstructions > MaxInstructions)
+      break;
+  }
+  if (NumInstructions <= MaxInstructions)
+    return false;
+  F.getContext().diagnose(DiagnosticInfoOptimizationFailure(
+      F, DebugLoc(),
+      Twine("function '") + F.getName() + "' has more than " +
+          Twine(MaxInstructions) + " instructions, so " + PassName + " " +
+          Degradation + " on it"));
+  return true;
+}
+// HLSL Change Ends
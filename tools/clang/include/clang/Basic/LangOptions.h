@@ -156,6 +156,9 @@ public:
   unsigned RootSigMajor;
   unsigned RootSigMinor;
   bool IsHLSLLibrary;
+  // Keep the bodies of functions other than the entry point as tokens, and
+  // parse them at the end of the translation unit once they are used.
+  bool HLSLLazyFunctionBodies = false;
   // MS Change Ends
   
   bool isSignedOverflowDefined() const {
@@ -28,6 +28,10 @@ private:
   llvm::Module *LinkModule;
   llvm::LLVMContext *VMContext;
   bool OwnsVMContext;
+  // HLSL Change Starts - keep the consumer for a deferred backend.
+  std::unique_ptr<ASTConsumer> DeferredConsumer;
+  std::string InFile;
+  // HLSL Change Ends
 
 protected:
   /// Create a new code generation action.  If the optional \p _VMContext
@@ -59,6 +63,14 @@ public:
   /// Take the LLVM context used by this action.
   llvm::LLVMContext *takeLLVMContext();
 
+  // HLSL Change Starts
+  /// Run the backend left to after EndSourceFile by
+  /// CodeGenOptions::HLSLDeferBackend. By then the AST and Sema are gone;
+  /// backend diagnostics are reported through the source manager of \p CI
+  /// only. Does nothing if the backend already ran or was skipped.
+  void EmitDeferredBackendOutput(CompilerInstance &CI);
+  // HLSL Change Ends
+
   BackendConsumer *BEConsumer;
 };
 
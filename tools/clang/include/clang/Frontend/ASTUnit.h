@@ -30,18 +30,21 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/MD5.h"
+#include "llvm/Support/Mutex.h" // HLSL Change
 #include "llvm/Support/Path.h"
 #include <cassert>
 #include <map>
 #include <memory>
 #include <string>
 #include <sys/types.h>
+#include <unordered_map> // HLSL Change
 #include <utility>
 #include <vector>
 
 // HLSL Change Starts
 namespace hlsl {
   class DxcLangExtensionsHelperApply;
+  struct CancellationState;
 }
 // HLSL Change Ends
 
@@ -69,6 +72,26 @@ class TargetInfo;
 class ASTFrontendAction;
 class ASTDeserializationListener;
 
+// HLSL Change Starts
+/// \brief Preamble token caches shared by the translation units of one index.
+///
+/// The cache of a unit holds only the tokens of the files it included, so
+/// units that include the same unchanged files in the same order build
+/// identical caches. Interning keeps a single copy of each, alive for as long
+/// as a unit uses it.
+class PreambleTokenCacheStore {
+  llvm::sys::Mutex Mutex;
+  std::unordered_multimap<size_t, std::weak_ptr<const llvm::MemoryBuffer>>
+      Caches;
+
+public:
+  /// \brief Returns the stored cache with the contents of \p Buffer, storing
+  /// \p Buffer itself if there is none.
+  std::shared_ptr<const llvm::MemoryBuffer>
+  intern(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+};
+// HLSL Change Ends
+
 /// \brief Utility class for loading a ASTContext from an AST file.
 ///
 class ASTUnit : public ModuleLoader {
@@ -194,6 +217,9 @@ private:
 
 public:
   hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions; // HLSL Change
+  // HLSL Change - when set, polled by parses and code completion, which stop
+  // at the next top-level declaration once cancellation is requested.
+  hlsl::CancellationState *Cancellation = nullptr;
 
   class PreambleData {
     const FileEntry *File;
@@ -291,6 +317,17 @@ private:
   /// precompiled preamble.
   std::unique_ptr<llvm::MemoryBuffer> PreambleBuffer;
 
+  // HLSL Change Starts - no support for PCH, so the preamble is kept as the
+  // pretokenized contents of the included files instead.
+  /// \brief When non-NULL, the tokens of the files included by an earlier
+  /// parse, replayed on reparse while the files recorded in
+  /// \c FilesInPreamble are unchanged.
+  std::shared_ptr<const llvm::MemoryBuffer> PreambleTokenCache;
+  /// \brief When non-NULL, where \c PreambleTokenCache is shared with the
+  /// other units of the same index.
+  std::shared_ptr<PreambleTokenCacheStore> PreambleTokenCaches;
+  // HLSL Change Ends
+
   /// \brief The number of warnings that occurred while parsing the preamble.
   ///
   /// This value will be used to restore the state of the \c DiagnosticsEngine
@@ -461,6 +498,11 @@ private:
       unsigned MaxLines = 0);
   void RealizeTopLevelDeclsFromPreamble();
 
+  // HLSL Change Starts
+  void buildPreambleTokenCache(Preprocessor &PP);
+  bool isPreambleTokenCacheCurrent();
+  // HLSL Change Ends
+
   /// \brief Transfers ownership of the objects (like SourceManager) from
   /// \param CI to this ASTUnit.
   void transferASTDataFromCompilerInstance(CompilerInstance &CI);
@@ -863,7 +905,9 @@ public:
       bool AllowPCHWithCompilerErrors = false, bool SkipFunctionBodies = false,
       bool UserFilesAreVolatile = false, bool ForSerialization = false,
       std::unique_ptr<ASTUnit> *ErrAST = nullptr,
-      hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr); // HLSL Change
+      hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr, // HLSL Change
+      std::shared_ptr<PreambleTokenCacheStore> PreambleTokenCaches =
+          nullptr); // HLSL Change
 
   /// \brief Reparse the source files using the same command-line options that
   /// were originally used to produce this translation unit.
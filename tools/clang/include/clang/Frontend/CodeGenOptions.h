@@ -16,12 +16,18 @@
 
 #include "clang/Basic/Sanitizers.h"
 #include "llvm/Support/Regex.h"
+#include <functional> // HLSL Change
 #include <memory>
 #include <string>
 #include <vector>
 #include "dxc/HLSL/HLSLExtensionsCodegenHelper.h" // HLSL change
 
+namespace llvm {
+class Module; // HLSL Change
+}
+
 namespace clang {
+class ASTContext; // HLSL Change
 
 /// \brief Bitfields of CodeGenOptions, split out from CodeGenOptions to ensure
 /// that this large collection of bitfields is a trivial class type.
@@ -176,6 +182,8 @@ public:
   std::string HLSLProfile;
   /// Whether to target high-level DXIL.
   bool HLSLHighLevel = false;
+  /// Whether to run only the fast-compile pass list at -O1.
+  bool HLSLFastOpt = false;
   /// Whether use row major as default matrix major.
   bool HLSLDefaultRowMajor = false;
   /// Whether use legacy cbuffer load.
@@ -186,6 +194,38 @@ public:
   bool HLSLAvoidControlFlow = false;
   /// Force [flatten] on every if.
   bool HLSLAllResourcesBound = false;
+  /// Whether to schedule independent half operations next to each other.
+  bool HLSLPairHalfOps = false;
+  /// Whether to hoist samples and loads above the branches guarding them.
+  bool HLSLHoistSamples = false;
+  /// Whether to rewrite dynamic indexing of small local arrays into selects.
+  bool HLSLDynamicIndexToSelect = false;
+  /// Largest dynamically indexed constant table to rewrite into selects.
+  unsigned HLSLConstTableSelect = 0;
+  /// Whether to report how dynamically indexed constant tables are stored.
+  bool HLSLReportConstTables = false;
+  /// Instructions over which a function gets cheaper GVN and no LICM, with
+  /// a warning; 0 for no budget.
+  unsigned HLSLFunctionBudget = 0;
+  /// Whether to count basic block executions into a UAV.
+  bool HLSLProfileInstrument = false;
+  /// Whether to time [profile] regions into a UAV.
+  bool HLSLProfileRegions = false;
+  /// File with basic block counts to derive control flow hints from.
+  std::string HLSLProfileUseFile;
+  /// Whether to reorder cbuffer members without packoffset to minimize
+  /// padding.
+  bool HLSLPackCBuffers = false;
+  /// Render targets the pipeline binds to the pixel shader, one bit per
+  /// SV_Target index; stores to the others are removed.
+  unsigned HLSLRenderTargetMask = 0xFF;
+  /// Whether to remove the depth output of the pixel shader.
+  bool HLSLDepthWriteDisabled = false;
+  /// Whether HLSLConsumerInputs lists what the next pipeline stage reads.
+  bool HLSLHasConsumerInputs = false;
+  /// Semantics the next stage reads, with their index and separated by '+';
+  /// the other arbitrary outputs of a vertex or domain shader are removed.
+  std::string HLSLConsumerInputs;
   /// Major version of validator to run.
   unsigned HLSLValidatorMajorVer = 0;
   /// Minor version of validator to run.
@@ -198,6 +238,12 @@ public:
   std::shared_ptr<hlsl::HLSLExtensionsCodegenHelper> HLSLExtensionsCodegen;
   /// Signature packing mode (0 == default for target)
   unsigned HLSLSignaturePackingStrategy = 0;
+  /// Called with the high-level module once IR generation is done; returning
+  /// false skips the backend and leaves the module as generated.
+  std::function<bool(ASTContext &, llvm::Module &)> HLSLBackendFilter;
+  /// Leave the backend to CodeGenAction::EmitDeferredBackendOutput, so that
+  /// it runs once the AST is released.
+  bool HLSLDeferBackend = false;
   // HLSL Change Ends
   /// Regular expression to select optimizations for which we should enable
   /// optimization remarks. Transformation passes whose name matches this
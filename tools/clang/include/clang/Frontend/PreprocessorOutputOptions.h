@@ -23,6 +23,7 @@ public:
   unsigned ShowMacroComments : 1;  ///< Show comments, even in macros.
   unsigned ShowMacros : 1;         ///< Print macro definitions.
   unsigned RewriteIncludes : 1;    ///< Preprocess include directives only.
+  unsigned NormalizeWhitespace : 1; ///< HLSL Change - no indentation or blank lines.
 
 public:
   PreprocessorOutputOptions() {
@@ -33,6 +34,7 @@ public:
     ShowMacroComments = 0;
     ShowMacros = 0;
     RewriteIncludes = 0;
+    NormalizeWhitespace = 0; // HLSL Change
   }
 };
 
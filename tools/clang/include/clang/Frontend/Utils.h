@@ -163,6 +163,13 @@ void AttachHeaderIncludeGen(Preprocessor &PP, bool ShowAllHeaders = false,
 /// Cache tokens for use with PCH. Note that this requires a seekable stream.
 void CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS);
 
+// HLSL Change Starts
+/// Cache the tokens of the files a completed preprocessor run included, other
+/// than the main file and files whose buffers were overridden. Files are lexed
+/// in place, so the source manager is not modified.
+void CacheIncludedTokens(Preprocessor &PP, raw_pwrite_stream *OS);
+// HLSL Change Ends
+
 /// The ChainedIncludesSource class converts headers to chained PCHs in
 /// memory, mainly for testing.
 IntrusiveRefCntPtr<ExternalSemaSource>
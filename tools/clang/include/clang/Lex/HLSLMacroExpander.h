@@ -29,6 +29,7 @@ namespace clang {
 
 namespace llvm {
   class StringRef;
+  class raw_ostream;
 }
 
 namespace hlsl {
@@ -54,6 +55,10 @@ public:
   static clang::MacroInfo *FindMacroInfo(clang::Preprocessor &PP, llvm::StringRef macroName);
 
 private:
+  void CreateExpansionFile();
+  void PrintToken(llvm::raw_ostream &OS, const clang::Token &Tok,
+                  const clang::Token &PrevTok);
+
   clang::Preprocessor &PP;
   clang::FileID m_expansionFileId;
   bool m_stripQuotes;
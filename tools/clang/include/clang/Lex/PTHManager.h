@@ -131,6 +131,13 @@ public:
   ///  is the name of the PTH file.  This method returns NULL upon failure.
   static PTHManager *Create(StringRef file, DiagnosticsEngine &Diags);
 
+  // HLSL Change Starts
+  /// Create - Creates a PTHManager over the PTH data in File, which must be
+  ///  4-byte aligned. This method returns NULL upon failure.
+  static PTHManager *Create(std::unique_ptr<llvm::MemoryBuffer> File,
+                            DiagnosticsEngine &Diags);
+  // HLSL Change Ends
+
   void setPreprocessor(Preprocessor *pp) { PP = pp; }
 
   /// CreateLexer - Return a PTHLexer that "lexes" the cached tokens for the
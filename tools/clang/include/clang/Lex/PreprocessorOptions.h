@@ -89,6 +89,12 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  // HLSL Change Starts
+  /// If given, PTH data to use in place of TokenCache. The buffer is not
+  /// owned and must outlive the preprocessor.
+  const llvm::MemoryBuffer *TokenCacheBuffer = nullptr;
+  // HLSL Change Ends
+
   /// \brief True if the SourceManager should report the original file name for
   /// contents of files that were remapped to other files. Defaults to true.
   bool RemappedFilesKeepOriginalName;
@@ -174,6 +180,7 @@ public:
     ImplicitPCHInclude.clear();
     ImplicitPTHInclude.clear();
     TokenCache.clear();
+    TokenCacheBuffer = nullptr; // HLSL Change
     RetainRemappedFileBuffers = true;
     PrecompiledPreambleBytes.first = 0;
     PrecompiledPreambleBytes.second = 0;
@@ -39,7 +39,13 @@ public:
   const llvm::SmallVector<uint32_t, 2> &getArgs() const { return args; }
   llvm::Optional<uint32_t> getMemberIndex() const { return memberIndex; }
 
-  static const Decoration *getRelaxedPrecision(SPIRVContext &ctx);
+  /// \brief Returns the OpDecorate, or OpMemberDecorate for a structure
+  /// member, instruction applying this decoration to the given target.
+  std::vector<uint32_t> withTargetId(uint32_t targetId) const;
+
+  static const Decoration *
+  getRelaxedPrecision(SPIRVContext &ctx,
+                      llvm::Optional<uint32_t> member_idx = llvm::None);
   static const Decoration *getSpecId(SPIRVContext &ctx, uint32_t id);
   static const Decoration *getBlock(SPIRVContext &ctx);
   static const Decoration *getBufferBlock(SPIRVContext &ctx);
@@ -13,10 +13,28 @@
 
 namespace clang {
 
+/// \brief Options for emitting SPIR-V beyond those in the CompilerInstance.
+struct EmitSPIRVOptions {
+  EmitSPIRVOptions() : CompactIds(false), ReportStats(false) {}
+
+  /// Compact result ids to a dense range, and strip debug names unless debug
+  /// information is requested, whatever the optimization level.
+  bool CompactIds;
+  /// Report the word count of each section and the id bound as a remark.
+  bool ReportStats;
+};
+
 class EmitSPIRVAction : public ASTFrontendAction {
+public:
+  EmitSPIRVAction() {}
+  explicit EmitSPIRVAction(const EmitSPIRVOptions &Opts) : Options(Opts) {}
+
 protected:
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  StringRef InFile) override;
+
+private:
+  EmitSPIRVOptions Options;
 };
 
 } // end namespace clang
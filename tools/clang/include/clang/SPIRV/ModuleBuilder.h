@@ -9,10 +9,14 @@
 #ifndef LLVM_CLANG_SPIRV_MODULEBUILDER_H
 #define LLVM_CLANG_SPIRV_MODULEBUILDER_H
 
+#include <mutex>
+
+#include "clang/SPIRV/Decoration.h"
 #include "clang/SPIRV/InstBuilder.h"
 #include "clang/SPIRV/SPIRVContext.h"
 #include "clang/SPIRV/Structure.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/Support/raw_ostream.h"
 
 namespace clang {
 namespace spirv {
@@ -54,8 +58,19 @@ public:
   /// \brief Ends building the current SPIR-V basic block with OpReturn.
   Status endBasicBlockWithReturn();
 
+  /// \brief Adds a function built by a FunctionBuilder. May be called from
+  /// any thread; functions appear in the module in the order they are added.
+  Status addFunction(Function &&);
+
+  /// \brief Applies the given decoration to the given target. May be called
+  /// from any thread.
+  void decorate(uint32_t targetId, const Decoration *);
+
   /// \brief Takes the SPIR-V module under building.
   std::vector<uint32_t> takeModule();
+  /// \brief Takes the SPIR-V module under building and writes it to the given
+  /// stream section by section, without assembling the binary in memory.
+  void takeModule(llvm::raw_ostream &);
 
 private:
   /// \brief Ends building the current basic block.
@@ -67,6 +82,49 @@ private:
   llvm::Optional<BasicBlock> theBasicBlock; ///< The basic block under building.
   std::vector<uint32_t> constructSite;      ///< InstBuilder construction site.
   InstBuilder instBuilder;
+  std::mutex moduleMutex; ///< Guards theModule for addFunction and decorate.
+};
+
+/// \brief Builds one SPIR-V function apart from the ModuleBuilder, so that
+/// functions can be built on separate threads. Each thread uses its own
+/// FunctionBuilder; ids are taken from the shared context in ranges, and
+/// types and constants are registered in it, so a finished function can be
+/// added to the module as is, without remapping ids.
+class FunctionBuilder {
+public:
+  /// \brief Begins building a function with the given types.
+  FunctionBuilder(SPIRVContext *, uint32_t funcType, uint32_t returnType);
+
+  // Disable copy constructor/assignment.
+  FunctionBuilder(const FunctionBuilder &) = delete;
+  FunctionBuilder &operator=(const FunctionBuilder &) = delete;
+
+  /// \brief Returns the <result-id> of the function under building.
+  uint32_t getFunctionId() const { return functionId; }
+  /// \brief Returns a fresh <result-id> from the range of this builder.
+  uint32_t takeNextId();
+
+  /// \brief Begins building a SPIR-V basic block.
+  ModuleBuilder::Status beginBasicBlock();
+  /// \brief Ends building the current SPIR-V basic block with OpReturn.
+  ModuleBuilder::Status endBasicBlockWithReturn();
+
+  /// \brief Moves the finished function into the given function, to be added
+  /// with ModuleBuilder::addFunction.
+  ModuleBuilder::Status takeFunction(Function *);
+
+private:
+  /// \brief Number of ids taken from the context at a time.
+  static const uint32_t kIdRangeSize = 64;
+
+  SPIRVContext &theContext;
+  uint32_t nextId;    ///< Next unused id in the current range.
+  uint32_t endId;     ///< End of the current range.
+  uint32_t functionId;
+  Function theFunction;
+  llvm::Optional<BasicBlock> theBasicBlock;
+  std::vector<uint32_t> constructSite;
+  InstBuilder instBuilder;
 };
 
 } // end namespace spirv
@@ -0,0 +1,98 @@
+//===-- Optimizer.h - SPIR-V module optimizer -----------------*- C++ -*---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the passes run over a finished SPIR-V binary before it
+// is written out, and the statistics reported about it. They work on the
+// words directly, so they only need to know which operands of an instruction
+// are ids.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SPIRV_OPTIMIZER_H
+#define LLVM_CLANG_SPIRV_OPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace spirv {
+
+/// \brief The passes to run over a module.
+struct OptimizerOptions {
+  OptimizerOptions()
+      : mergeDeclarations(false), eliminateDeadDeclarations(false),
+        compactIds(false), stripDebugInfo(false) {}
+
+  /// \brief Returns the passes run at the given optimization level. Level 0
+  /// runs none; higher levels run all but stripDebugInfo.
+  static OptimizerOptions forOptLevel(unsigned optLevel);
+
+  /// \brief Returns true if any pass is enabled.
+  bool any() const {
+    return mergeDeclarations || eliminateDeadDeclarations || compactIds ||
+           stripDebugInfo;
+  }
+
+  /// Merge duplicate undecorated type and constant declarations.
+  bool mergeDeclarations;
+  /// Remove types, constants, global variables and functions that nothing
+  /// live refers to, together with their names and decorations.
+  bool eliminateDeadDeclarations;
+  /// Renumber the remaining ids densely and shrink the id bound.
+  bool compactIds;
+  /// Remove debug names, source and line information.
+  bool stripDebugInfo;
+};
+
+/// \brief Runs the given passes over the SPIR-V module binary in place.
+///
+/// Returns true if the binary was changed. Modules using instructions whose
+/// operands the optimizer does not know are left untouched.
+bool optimizeModule(std::vector<uint32_t> *binary, const OptimizerOptions &);
+
+/// \brief Optimizes the SPIR-V module binary in place for the given
+/// optimization level.
+inline bool optimizeModule(std::vector<uint32_t> *binary, unsigned optLevel) {
+  return optimizeModule(binary, OptimizerOptions::forOptLevel(optLevel));
+}
+
+/// \brief The word counts of the logical sections of a SPIR-V module.
+struct ModuleStats {
+  enum Section {
+    Header,
+    Capabilities,
+    Extensions,
+    MemoryModel,
+    EntryPoints,
+    ExecutionModes,
+    Debug,
+    Annotations,
+    TypesValues,
+    Functions,
+    SectionCount
+  };
+
+  /// \brief Collects the statistics of the given module binary.
+  explicit ModuleStats(const std::vector<uint32_t> &binary);
+
+  /// \brief Prints the total word count, the id bound and the word count of
+  /// each non-empty section on one line.
+  void print(llvm::raw_ostream &) const;
+
+  uint32_t idBound;
+  uint32_t totalWords;
+  uint32_t sectionWords[SectionCount];
+};
+
+} // end namespace spirv
+} // end namespace clang
+
+#endif
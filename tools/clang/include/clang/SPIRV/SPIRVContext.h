@@ -9,31 +9,77 @@
 #ifndef LLVM_CLANG_SPIRV_SPIRVCONTEXT_H
 #define LLVM_CLANG_SPIRV_SPIRVCONTEXT_H
 
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/SPIRV/Decoration.h"
 #include "clang/SPIRV/Type.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/Allocator.h"
 
 namespace clang {
 namespace spirv {
 
+/// \brief Hashes a Type over its opcode, arguments and decorations, so that
+/// only structurally equal types share a bucket. Decorations are unique
+/// within a context, so they are hashed by pointer.
 struct TypeHash {
-  std::size_t operator()(const Type &t) const {
-    // TODO: We could improve this hash function if necessary.
-    return std::hash<uint32_t>{}(static_cast<uint32_t>(t.getOpcode()));
+  std::size_t operator()(const Type *t) const {
+    return llvm::hash_combine(
+        static_cast<uint32_t>(t->getOpcode()),
+        llvm::hash_combine_range(t->getArgs().begin(), t->getArgs().end()),
+        llvm::hash_combine_range(t->getDecorations().begin(),
+                                 t->getDecorations().end()));
   }
 };
+struct TypeEqual {
+  bool operator()(const Type *a, const Type *b) const { return *a == *b; }
+};
+
+/// \brief Hashes a Decoration over its value, arguments and member index.
 struct DecorationHash {
-  std::size_t operator()(const Decoration &d) const {
-    // TODO: We could probably improve this hash function if needed.
-    return std::hash<uint32_t>{}(static_cast<uint32_t>(d.getValue()));
+  std::size_t operator()(const Decoration *d) const {
+    const llvm::Optional<uint32_t> memberIndex = d->getMemberIndex();
+    return llvm::hash_combine(
+        static_cast<uint32_t>(d->getValue()),
+        llvm::hash_combine_range(d->getArgs().begin(), d->getArgs().end()),
+        memberIndex.hasValue(), memberIndex.hasValue() ? *memberIndex : 0u);
+  }
+};
+struct DecorationEqual {
+  bool operator()(const Decoration *a, const Decoration *b) const {
+    return *a == *b;
+  }
+};
+
+/// \brief Identifies a constant by its type and the words of its value.
+struct ConstantKey {
+  const Type *type;
+  std::vector<uint32_t> words;
+
+  bool operator==(const ConstantKey &other) const {
+    return type == other.type && words == other.words;
+  }
+};
+struct ConstantKeyHash {
+  std::size_t operator()(const ConstantKey &k) const {
+    return llvm::hash_combine(
+        k.type, llvm::hash_combine_range(k.words.begin(), k.words.end()));
   }
 };
 
 /// \brief A class for holding various data needed in SPIR-V codegen.
 /// It should outlive all SPIR-V codegen components that requires/allocates
 /// data.
+///
+/// The context may be shared by threads building functions in parallel: ids
+/// are taken atomically, and types, decorations and constants are registered
+/// under a lock, so each is defined once no matter which thread uses it
+/// first.
 class SPIRVContext {
 public:
   /// \brief Constructs a default SPIR-V context.
@@ -49,11 +95,20 @@ public:
   inline uint32_t getNextId() const;
   /// \brief Consumes the next unused <result-id>.
   inline uint32_t takeNextId();
+  /// \brief Consumes count consecutive unused <result-id>s and returns the
+  /// first one. Builders on other threads take ids in ranges, so they do not
+  /// contend on each id.
+  inline uint32_t takeIdRange(uint32_t count);
 
   /// \brief Returns the <result-id> that defines the given Type. If the type
   /// has not been defined, it will define and store its instruction.
   uint32_t getResultIdForType(const Type *);
 
+  /// \brief Returns the <result-id> that defines the constant of the given
+  /// type whose value is made of the given words. If the constant has not
+  /// been defined, a new <result-id> is reserved for it.
+  uint32_t getResultIdForConstant(const Type *, llvm::ArrayRef<uint32_t>);
+
   /// \brief Registers the existence of the given type in the current context,
   /// and returns the unique Type pointer.
   const Type *registerType(const Type &);
@@ -63,10 +118,19 @@ public:
   const Decoration *registerDecoration(const Decoration &);
 
 private:
-  using TypeSet = std::unordered_set<Type, TypeHash>;
-  using DecorationSet = std::unordered_set<Decoration, DecorationHash>;
+  using TypeSet = std::unordered_set<const Type *, TypeHash, TypeEqual>;
+  using DecorationSet =
+      std::unordered_set<const Decoration *, DecorationHash, DecorationEqual>;
 
-  uint32_t nextId;
+  std::atomic<uint32_t> nextId;
+
+  /// \brief Guards the tables below.
+  std::mutex tableMutex;
+
+  /// \brief Storage of the unique Types and Decorations. Objects are never
+  /// freed before the context, so they are allocated from arenas.
+  llvm::SpecificBumpPtrAllocator<Type> typeAllocator;
+  llvm::SpecificBumpPtrAllocator<Decoration> decorationAllocator;
 
   /// \brief All the unique Decorations defined in the current context.
   DecorationSet existingDecorations;
@@ -74,6 +138,10 @@ private:
   /// \brief All the unique types defined in the current context.
   TypeSet existingTypes;
 
+  /// \brief Maps each constant to the <result-id> reserved for it.
+  std::unordered_map<ConstantKey, uint32_t, ConstantKeyHash>
+      constantResultIdMap;
+
   /// \brief Maps a given type to the <result-id> that is defined for
   /// that type. If a Type* does not exist in the map, the type
   /// is not yet defined and is not associated with a <result-id>.
@@ -83,6 +151,9 @@ private:
 SPIRVContext::SPIRVContext() : nextId(1) {}
 uint32_t SPIRVContext::getNextId() const { return nextId; }
 uint32_t SPIRVContext::takeNextId() { return nextId++; }
+uint32_t SPIRVContext::takeIdRange(uint32_t count) {
+  return nextId.fetch_add(count);
+}
 
 } // end namespace spirv
 } // end namespace clang
@@ -23,14 +23,17 @@
 
 #include "spirv/1.0/spirv.hpp11"
 #include "clang/SPIRV/InstBuilder.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
 
 namespace clang {
 namespace spirv {
 
-// TODO: do some statistics and switch to use SmallVector here if helps.
-/// \brief The class representing a SPIR-V instruction.
-using Instruction = std::vector<uint32_t>;
+/// \brief The words of one SPIR-V instruction. The structures below append
+/// instructions into contiguous word buffers instead of keeping one vector per
+/// instruction; the word count in the first word of each instruction delimits
+/// it within a buffer.
+using Instruction = llvm::ArrayRef<uint32_t>;
 
 /// \brief The class representing a SPIR-V basic block.
 class BasicBlock {
@@ -60,11 +63,12 @@ public:
   void take(InstBuilder *builder);
 
   /// \brief add an instruction to this basic block.
-  inline void addInstruction(Instruction &&);
+  inline void addInstruction(Instruction);
 
 private:
   uint32_t labelId; ///< The label id for this basic block. Zero means invalid.
-  std::vector<Instruction> instructions;
+  std::vector<uint32_t> words; ///< The words of all instructions.
+  size_t lastInstOffset;       ///< Offset of the last instruction in words.
 };
 
 /// \brief The class representing a SPIR-V function.
@@ -145,13 +149,15 @@ public:
   inline void addEntryPoint(spv::ExecutionModel, uint32_t targetId,
                             std::string targetName,
                             std::initializer_list<uint32_t> intefaces);
-  inline void addExecutionMode(Instruction &&);
+  inline void addExecutionMode(Instruction);
   inline void addDebugName(uint32_t targetId,
                            llvm::Optional<uint32_t> memberIndex,
                            std::string name);
-  inline void addDecoration(Instruction &&);
-  inline void addType(Instruction &&);
-  inline void addFunction(Function &&);
+  inline void addDecoration(Instruction);
+  inline void addType(Instruction);
+  /// \brief Adds a complete function. It is serialized right away, so the
+  /// structures of finished functions do not stay alive with the module.
+  void addFunction(Function &&);
 
 private:
   /// \brief The struct representing a SPIR-V module header.
@@ -197,30 +203,33 @@ private:
   llvm::Optional<spv::AddressingModel> addressingModel;
   llvm::Optional<spv::MemoryModel> memoryModel;
   std::vector<EntryPoint> entryPoints;
-  // XXX: Right now the following are basically vectors of Instructions.
+  // XXX: Right now the following are basically word buffers of instructions.
   // They will be turned into vectors of more full-fledged classes gradually
   // as we implement more features.
-  std::vector<Instruction> executionModes;
+  std::vector<uint32_t> executionModes;
   // TODO: support other debug instructions
   std::vector<DebugName> debugNames;
-  std::vector<Instruction> decorations;
-  std::vector<Instruction> typesValues;
-  std::vector<Function> functions;
+  std::vector<uint32_t> decorations;
+  std::vector<uint32_t> typesValues;
+  /// The function section. It comes after every other section in the binary,
+  /// but is filled in first, as functions are finished while the sections
+  /// above still grow.
+  std::vector<uint32_t> functionWords;
 };
 
-BasicBlock::BasicBlock() : labelId(0) {}
-BasicBlock::BasicBlock(uint32_t id) : labelId(id) {}
+BasicBlock::BasicBlock() : labelId(0), lastInstOffset(0) {}
+BasicBlock::BasicBlock(uint32_t id) : labelId(id), lastInstOffset(0) {}
 
-bool BasicBlock::isEmpty() const {
-  return labelId == 0 && instructions.empty();
-}
+bool BasicBlock::isEmpty() const { return labelId == 0 && words.empty(); }
 void BasicBlock::clear() {
   labelId = 0;
-  instructions.clear();
+  words.clear();
+  lastInstOffset = 0;
 }
 
-void BasicBlock::addInstruction(Instruction &&inst) {
-  instructions.push_back(std::move(inst));
+void BasicBlock::addInstruction(Instruction inst) {
+  lastInstOffset = words.size();
+  words.insert(words.end(), inst.begin(), inst.end());
 }
 
 Function::Function()
@@ -271,22 +280,19 @@ void SPIRVModule::addEntryPoint(spv::ExecutionModel em, uint32_t targetId,
   entryPoints.emplace_back(em, targetId, std::move(name),
                            std::move(interfaces));
 }
-void SPIRVModule::addExecutionMode(Instruction &&execMode) {
-  executionModes.push_back(std::move(execMode));
+void SPIRVModule::addExecutionMode(Instruction execMode) {
+  executionModes.insert(executionModes.end(), execMode.begin(), execMode.end());
 }
 void SPIRVModule::addDebugName(uint32_t targetId,
                                llvm::Optional<uint32_t> memberIndex,
                                std::string name) {
   debugNames.emplace_back(targetId, memberIndex, std::move(name));
 }
-void SPIRVModule::addDecoration(Instruction &&decoration) {
-  decorations.push_back(std::move(decoration));
-}
-void SPIRVModule::addType(Instruction &&type) {
-  typesValues.push_back(std::move(type));
+void SPIRVModule::addDecoration(Instruction decoration) {
+  decorations.insert(decorations.end(), decoration.begin(), decoration.end());
 }
-void SPIRVModule::addFunction(Function &&f) {
-  functions.push_back(std::move(f));
+void SPIRVModule::addType(Instruction type) {
+  typesValues.insert(typesValues.end(), type.begin(), type.end());
 }
 
 SPIRVModule::EntryPoint::EntryPoint(spv::ExecutionModel em, uint32_t id,
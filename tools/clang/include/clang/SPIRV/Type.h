@@ -37,6 +37,9 @@ class Type {
 public:
   spv::Op getOpcode() const { return opcode; }
   const std::vector<uint32_t> &getArgs() const { return args; }
+  const std::set<const Decoration *> &getDecorations() const {
+    return decorations;
+  }
 
   bool isBooleanType() const;
   bool isIntegerType() const;
@@ -0,0 +1,55 @@
+//===--- TypeTranslator.h - AST type to SPIR-V type translator --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_CLANG_SPIRV_TYPETRANSLATOR_H
+#define LLVM_CLANG_SPIRV_TYPETRANSLATOR_H
+
+#include "clang/AST/Type.h"
+#include "clang/SPIRV/ModuleBuilder.h"
+#include "clang/SPIRV/SPIRVContext.h"
+
+namespace clang {
+namespace spirv {
+
+/// \brief The class responsible for translating HLSL types into SPIR-V types.
+///
+/// Min-precision types (min16float, min10float, min16int, min12int and
+/// min16uint) are translated into their 32-bit counterparts. Their precision
+/// intent is kept as RelaxedPrecision decorations on the values, variables
+/// and structure members of those types, which lets drivers compute them at
+/// 16 bits.
+class TypeTranslator {
+public:
+  TypeTranslator(SPIRVContext *, ModuleBuilder *);
+
+  /// \brief Returns the <result-id> of the SPIR-V type for the given type, or
+  /// 0 if the type is not supported yet. Structure members of min-precision
+  /// types are decorated RelaxedPrecision.
+  uint32_t translateType(QualType type);
+
+  /// \brief Returns true if the given type is a min-precision scalar type, or
+  /// a vector or matrix of one.
+  static bool isRelaxedPrecisionType(QualType type);
+
+  /// \brief Decorates the given value or variable RelaxedPrecision if it is
+  /// of a min-precision type.
+  void decorateRelaxedPrecision(uint32_t targetId, QualType type);
+
+private:
+  /// \brief Returns the SPIR-V type for the given builtin scalar type, or
+  /// nullptr if it is not supported.
+  const Type *translateBuiltinType(const BuiltinType *);
+
+  SPIRVContext &theContext;
+  ModuleBuilder &theBuilder;
+};
+
+} // end namespace spirv
+} // end namespace clang
+
+#endif
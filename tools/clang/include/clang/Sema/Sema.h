@@ -4058,6 +4058,14 @@ public:
   bool IsOnHLSLBufferView();
   Decl *ActOnHLSLBufferView(Scope *bufferScope, SourceLocation KwLoc,
                         DeclGroupPtrTy &dcl, bool iscbuf);
+
+  /// Lazily parsed function bodies (LangOptions::HLSLLazyFunctionBodies).
+  /// Deferred bodies are kept as late parsed templates; the functions used
+  /// are queued here and their bodies parsed at the end of the translation
+  /// unit, which can use further functions in turn.
+  SmallVector<FunctionDecl *, 8> UsedLazyHLSLFunctions;
+  bool CanDeferHLSLFunctionBody(FunctionDecl *FD);
+  void ParseUsedLazyHLSLFunctionBodies();
   // HLSL Change Ends
 
   //===---------------------------- C++ Features --------------------------===//
@@ -47,6 +47,17 @@ bool CheckTemplateArgumentListForHLSL(
   clang::TemplateDecl*, 
   clang::SourceLocation, 
   clang::TemplateArgumentListInfo&);
+
+clang::QualType LookupTemplateSpecializationForHLSL(
+  clang::Sema& self,
+  clang::TemplateDecl*,
+  const clang::TemplateArgumentListInfo&,
+  llvm::SmallVectorImpl<uint64_t>& key);
+
+void AddTemplateSpecializationForHLSL(
+  clang::Sema& self,
+  const llvm::SmallVectorImpl<uint64_t>& key,
+  clang::QualType CanonType);
   
 clang::QualType CheckUnaryOpForHLSL(
   clang::Sema& self,
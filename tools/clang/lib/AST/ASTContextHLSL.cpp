@@ -24,6 +24,7 @@
 #include "dxc/Support/Global.h"
 #include "dxc/HLSL/HLOperations.h"
 #include "dxc/HLSL/DxilSemantic.h"
+#include "llvm/ADT/StringMap.h"
 
 using namespace clang;
 using namespace hlsl;
@@ -765,6 +766,52 @@ bool TryParseColOrRowChar(const char digit, _Out_ int* count) {
   return false;
 }
 
+namespace {
+/// <summary>Scalar type and dimensions named by a shorthand identifier.</summary>
+struct ShorthandTypeEntry {
+  HLSLScalarType ScalarType;
+  int RowCount; // Zero for vectors.
+  int ColCount;
+};
+
+/// <summary>Every vector and matrix shorthand name (eg, float3, min16uint2x4),
+/// built once per process.</summary>
+class ShorthandTypeTable {
+private:
+  llvm::StringMap<ShorthandTypeEntry> m_entries;
+
+public:
+  ShorthandTypeTable() {
+    char typeName[64];
+    for (HLSLScalarType index = HLSLScalarType_minvalid;
+         index <= HLSLScalarType_max;
+         index = (HLSLScalarType)(index + 1)) {
+      for (int col = 1; col <= 4; ++col) {
+        sprintf_s(typeName, _countof(typeName), "%s%d",
+                  HLSLScalarTypeNames[index], col);
+        m_entries[typeName] = ShorthandTypeEntry { index, 0, col };
+        for (int row = 1; row <= 4; ++row) {
+          sprintf_s(typeName, _countof(typeName), "%s%dx%d",
+                    HLSLScalarTypeNames[index], row, col);
+          m_entries[typeName] = ShorthandTypeEntry { index, row, col };
+        }
+      }
+    }
+  }
+
+  const ShorthandTypeEntry *Lookup(const char *typeName,
+                                   size_t typeNameLen) const {
+    auto it = m_entries.find(StringRef(typeName, typeNameLen));
+    return it == m_entries.end() ? nullptr : &it->second;
+  }
+};
+}
+
+static const ShorthandTypeTable &GetShorthandTypeTable() {
+  static const ShorthandTypeTable table;
+  return table;
+}
+
 /// <summary>Parses a matrix shorthand identifier (eg, float3x2).</summary>
 _Use_decl_annotations_
 bool hlsl::TryParseMatrixShorthand(
@@ -782,29 +829,19 @@ bool hlsl::TryParseMatrixShorthand(
   // PrimitiveType is one of the HLSLScalarTypeNames values.
   //
 
-  // TODO: binary-search or build a switch table for type name of matrix identifiers
-
   // At least *something*RxC characters necessary, where something is at least 'int'
   const size_t MinValidLen = 3 + 3;
   if (typeNameLen >= MinValidLen) {
-    // The trailing parts are less expensive to parse, so start with those.
+    // The trailing parts are cheap to check, and reject most identifiers
+    // before the name is hashed.
     if (TryParseColOrRowChar(typeName[typeNameLen - 1], colCount) &&
       typeName[typeNameLen - 2] == 'x' &&
       TryParseColOrRowChar(typeName[typeNameLen - 3], rowCount)) {
-      for (HLSLScalarType index = HLSLScalarType_minvalid;
-           index <= HLSLScalarType_max;
-           index = (HLSLScalarType)(index + 1)) {
-        // Shorten the compared character to make sure that the suffix isn't considered.
-        if (strncmp(HLSLScalarTypeNames[index], typeName, typeNameLen - 3) == 0) {
-          // Make sure the whole scalar type matches.
-          if (strlen(HLSLScalarTypeNames[index]) == typeNameLen - 3) {
-            *parsedType = index;
-            return true;
-          }
-          else {
-            return false;
-          }
-        }
+      const ShorthandTypeEntry *entry =
+          GetShorthandTypeTable().Lookup(typeName, typeNameLen);
+      if (entry != nullptr) {
+        *parsedType = entry->ScalarType;
+        return true;
       }
     }
   }
@@ -822,27 +859,18 @@ bool hlsl::TryParseVectorShorthand(
   int* elementCount
   )
 {
-  // TODO: binary-search or build a switch table for type name of vector identifiers
-
   // At least *something*N characters necessary, where something is at least 'int'
   const size_t MinValidLen = 1 + 3;
   if (typeNameLen >= MinValidLen) {
-    // The trailing part is less expensive to parse, so start with that.
-    if (TryParseColOrRowChar(typeName[typeNameLen - 1], elementCount)) {
-      for (HLSLScalarType index = HLSLScalarType_minvalid;
-        index <= HLSLScalarType_max;
-        index = (HLSLScalarType)(index + 1)) {
-        // Shorten the compared character to make sure that the suffix isn't considered.
-        if (strncmp(HLSLScalarTypeNames[index], typeName, typeNameLen - 1) == 0) {
-          // Make sure the whole scalar type matches.
-          if (strlen(HLSLScalarTypeNames[index]) == typeNameLen - 1) {
-            *parsedType = index;
-            return true;
-          }
-          else {
-            return false;
-          }
-        }
+    // The trailing part is cheap to check; no scalar type name ends in 'x',
+    // so matrix shorthands are rejected before the name is hashed too.
+    if (TryParseColOrRowChar(typeName[typeNameLen - 1], elementCount) &&
+      typeName[typeNameLen - 2] != 'x') {
+      const ShorthandTypeEntry *entry =
+          GetShorthandTypeTable().Lookup(typeName, typeNameLen);
+      if (entry != nullptr) {
+        *parsedType = entry->ScalarType;
+        return true;
       }
     }
   }
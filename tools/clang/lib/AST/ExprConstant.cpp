@@ -2014,6 +2014,14 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
     return false;
   }
 
+  // HLSL Change Starts - the value of a link-time constant is only known when
+  // the library is linked; the initializer is just its default.
+  if (VD->hasAttr<HLSLLinkConstantAttr>()) {
+    Info.Diag(E, diag::note_invalid_subexpr_in_const_expr);
+    return false;
+  }
+  // HLSL Change Ends
+
   // Check that we can fold the initializer. In C++, we will have already done
   // this in the cases where it matters for conformance.
   SmallVector<PartialDiagnosticAt, 8> Notes;
@@ -8933,6 +8941,9 @@ static ICEDiag CheckICE(const Expr* E, const ASTContext &Ctx) {
       if (const VarDecl *Dcl = dyn_cast<VarDecl>(D)) {
         if (!Dcl->getType()->isIntegralOrEnumerationType())
           return ICEDiag(IK_NotICE, cast<DeclRefExpr>(E)->getLocation());
+        // HLSL Change - link-time constants are not known until linking.
+        if (Dcl->hasAttr<HLSLLinkConstantAttr>())
+          return ICEDiag(IK_NotICE, cast<DeclRefExpr>(E)->getLocation());
 
         const VarDecl *VD;
         // Look for a declaration of this variable that has an initializer, and
@@ -27,6 +27,7 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h" // HLSL Change
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/Timer.h"
@@ -320,6 +321,33 @@ void EmitAssemblyHelper::CreatePasses() {
   PMBuilder.SLPVectorize = CodeGenOpts.VectorizeSLP;
   PMBuilder.LoopVectorize = CodeGenOpts.VectorizeLoop;
   PMBuilder.HLSLHighLevel = CodeGenOpts.HLSLHighLevel; // HLSL Change
+  PMBuilder.HLSLFastOpt = CodeGenOpts.HLSLFastOpt; // HLSL Change
+  PMBuilder.HLSLPairHalfOps = CodeGenOpts.HLSLPairHalfOps; // HLSL Change
+  PMBuilder.HLSLHoistSamples = CodeGenOpts.HLSLHoistSamples; // HLSL Change
+  PMBuilder.HLSLDynamicIndexToSelect = CodeGenOpts.HLSLDynamicIndexToSelect; // HLSL Change
+  PMBuilder.HLSLConstTableSelect = CodeGenOpts.HLSLConstTableSelect; // HLSL Change
+  PMBuilder.HLSLReportConstTables = CodeGenOpts.HLSLReportConstTables; // HLSL Change
+  PMBuilder.HLSLFunctionBudget = CodeGenOpts.HLSLFunctionBudget; // HLSL Change
+  // HLSL Change - the module is only written into a container, which takes
+  // the root signature from the DxilModule into its own part.
+  PMBuilder.HLSLRootSignatureInMetadata = false;
+  // HLSL Change Begins.
+  PMBuilder.HLSLProfileInstrument = CodeGenOpts.HLSLProfileInstrument;
+  PMBuilder.HLSLProfileRegions = CodeGenOpts.HLSLProfileRegions;
+  PMBuilder.HLSLRenderTargetMask = CodeGenOpts.HLSLRenderTargetMask;
+  PMBuilder.HLSLDepthWriteDisabled = CodeGenOpts.HLSLDepthWriteDisabled;
+  PMBuilder.HLSLHasConsumerInputs = CodeGenOpts.HLSLHasConsumerInputs;
+  PMBuilder.HLSLConsumerInputs = CodeGenOpts.HLSLConsumerInputs;
+  if (!CodeGenOpts.HLSLProfileUseFile.empty()) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> ProfileOrErr =
+        MemoryBuffer::getFile(CodeGenOpts.HLSLProfileUseFile);
+    if (ProfileOrErr)
+      PMBuilder.HLSLBlockProfile = (*ProfileOrErr)->getBuffer();
+    else
+      Diags.Report(diag::err_fe_error_reading)
+          << CodeGenOpts.HLSLProfileUseFile;
+  }
+  // HLSL Change Ends.
   PMBuilder.HLSLExtensionsCodeGen = CodeGenOpts.HLSLExtensionsCodegen.get(); // HLSL Change
 
   PMBuilder.DisableUnitAtATime = !CodeGenOpts.UnitAtATime;
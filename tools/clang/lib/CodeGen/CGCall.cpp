@@ -2144,6 +2144,9 @@ void CodeGenFunction::EmitFunctionProlog(const CGFunctionInfo &FI,
   if (getLangOpts().HLSL) {
     if (const FunctionDecl *FD = dyn_cast_or_null<FunctionDecl>(CurCodeDecl)) {
       CGM.getHLSLRuntime().EmitHLSLFunctionProlog(Fn, FD);
+      // The region cleanup is popped with the prologue cleanups, on return.
+      if (const HLSLProfileAttr *Profile = FD->getAttr<HLSLProfileAttr>())
+        CGM.getHLSLRuntime().EmitHLSLProfileRegionBegin(*this, Profile);
     }
   }
   // HLSL Change Ends.
@@ -18,6 +18,7 @@
 #include "dxc/HLSL/HLMatrixLowerHelper.h"
 #include "dxc/HLSL/HLModule.h"
 #include "dxc/HLSL/HLOperations.h"
+#include "dxc/HLSL/DxilLinker.h"
 #include "dxc/HLSL/DxilOperations.h"
 #include "dxc/HLSL/DxilTypeSystem.h"
 #include "clang/AST/DeclTemplate.h"
@@ -29,6 +30,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -123,6 +125,11 @@ private:
 
   // List for functions with clip plane.
   std::vector<Function *> clipPlaneFuncList;
+  // Globals marked [linkconstant].
+  std::vector<VarDecl *> linkConstantList;
+  // Names of [profile] regions, in the order of their indices.
+  std::vector<std::string> profileRegionNames;
+  StringMap<unsigned> profileRegionIndexMap;
   std::unordered_map<Value *, DebugLoc> debugInfoMap;
 
   DxilRootSignatureVersion  rootSigVer;
@@ -262,6 +269,8 @@ public:
   void AddControlFlowHint(CodeGenFunction &CGF, const Stmt &S,
                           llvm::TerminatorInst *TI,
                           ArrayRef<const Attr *> Attrs) override;
+  void EmitHLSLProfileRegionBegin(CodeGenFunction &CGF,
+                                  const HLSLProfileAttr *Attr) override;
   
   void FinishAutoVar(CodeGenFunction &CGF, const VarDecl &D, llvm::Value *V) override;
 
@@ -278,6 +287,14 @@ void clang::CompileRootSignature(
   llvm::raw_string_ostream OS(OSStr);
   hlsl::DxilVersionedRootSignatureDesc *D = nullptr;
 
+  // Shaders commonly share a few root signatures; reuse a compiled one.
+  CComPtr<IDxcBlob> pCached;
+  if (hlsl::LookupCachedRootSignature(rootSigVer, rootSigStr.data(),
+                                      rootSigStr.size(), &pCached)) {
+    pRootSigHandle->Assign(nullptr, pCached);
+    return;
+  }
+
   if (ParseHLSLRootSignature(rootSigStr.data(), rootSigStr.size(), rootSigVer,
                              &D, SLoc, Diags)) {
     CComPtr<IDxcBlob> pSignature;
@@ -290,6 +307,8 @@ void clang::CompileRootSignature(
       hlsl::DeleteRootSignature(D);
     } else {
       pRootSigHandle->Assign(D, pSignature);
+      hlsl::StoreCachedRootSignature(rootSigVer, rootSigStr.data(),
+                                     rootSigStr.size(), pSignature);
     }
   }
 }
@@ -825,6 +844,8 @@ unsigned CGMSHLSLRuntime::ConstructStructAnnotation(DxilStructAnnotation *annota
     ConstructFieldInterpolation(fieldAnnotation, fieldDecl);
     if (fieldDecl->hasAttr<HLSLPreciseAttr>())
       fieldAnnotation.SetPrecise();
+    if (fieldDecl->hasAttr<HLSLAffineAttr>())
+      fieldAnnotation.SetAffine();
 
     fieldAnnotation.SetCBufferOffset(CBufferOffset);
     fieldAnnotation.SetFieldName(fieldDecl->getName());
@@ -1787,6 +1808,47 @@ void CGMSHLSLRuntime::AddControlFlowHint(CodeGenFunction &CGF, const Stmt &S,
   }
 }
 
+namespace {
+// Closes a [profile] region on each exit from its scope.
+struct EmitProfileRegionEnd : EHScopeStack::Cleanup {
+  Function *Marker;
+  Value *Index;
+  EmitProfileRegionEnd(Function *Marker, Value *Index)
+      : Marker(Marker), Index(Index) {}
+  void Emit(CodeGenFunction &CGF, Flags flags) override {
+    Value *Kind = CGF.Builder.getInt32(
+        (unsigned)DXIL::ProfileRegionMarker::End);
+    CGF.Builder.CreateCall(Marker, {Kind, Index});
+  }
+};
+}
+
+void CGMSHLSLRuntime::EmitHLSLProfileRegionBegin(CodeGenFunction &CGF,
+                                                 const HLSLProfileAttr *Attr) {
+  // Without -profile_regions, the attribute only documents the region.
+  if (!CGM.getCodeGenOpts().HLSLProfileRegions)
+    return;
+
+  // Regions of the same name share an index, and so their counters.
+  auto inserted = profileRegionIndexMap.insert(
+      std::make_pair(Attr->getName(), (unsigned)profileRegionNames.size()));
+  if (inserted.second)
+    profileRegionNames.emplace_back(Attr->getName());
+
+  llvm::Type *i32Ty = CGF.Builder.getInt32Ty();
+  FunctionType *MarkerTy = FunctionType::get(
+      CGF.Builder.getVoidTy(), {i32Ty, i32Ty}, /*isVarArg*/ false);
+  Function *Marker = cast<Function>(TheModule.getOrInsertFunction(
+      DxilMDHelper::kDxilProfileRegionMarkerName, MarkerTy));
+  Marker->addFnAttr(Attribute::NoUnwind);
+
+  Value *Index = CGF.Builder.getInt32(inserted.first->second);
+  Value *Kind =
+      CGF.Builder.getInt32((unsigned)DXIL::ProfileRegionMarker::Begin);
+  CGF.Builder.CreateCall(Marker, {Kind, Index});
+  CGF.EHStack.pushCleanup<EmitProfileRegionEnd>(NormalCleanup, Marker, Index);
+}
+
 void CGMSHLSLRuntime::FinishAutoVar(CodeGenFunction &CGF, const VarDecl &D, llvm::Value *V) {
   if (D.hasAttr<HLSLPreciseAttr>()) {
     AllocaInst *AI = cast<AllocaInst>(V);
@@ -1869,6 +1931,10 @@ void CGMSHLSLRuntime::addResource(Decl *D) {
     // skip decl has init which is resource.
     if (VD->hasInit() && resClass != DXIL::ResourceClass::Invalid)
       return;
+    if (VD->hasAttr<HLSLLinkConstantAttr>()) {
+      linkConstantList.emplace_back(VD);
+      return;
+    }
     // skip static global.
     if (!VD->isExternallyVisible())
       return;
@@ -2434,6 +2500,8 @@ void CGMSHLSLRuntime::AddConstant(VarDecl *constDecl, HLCBuffer &CB) {
   }
   bool bDefaultRowMajor = m_pHLModule->GetHLOptions().bDefaultRowMajor;
   ConstructFieldAttributedAnnotation(fieldAnnotation, Ty, bDefaultRowMajor);
+  if (constDecl->hasAttr<HLSLAffineAttr>())
+    fieldAnnotation.SetAffine();
   m_ConstVarAnnotationMap[constVal] = fieldAnnotation;
 }
 
@@ -2594,10 +2662,79 @@ static unsigned AllocateDxilConstantBuffer(HLCBuffer &CB) {
   return offset;
 }
 
-static void AllocateDxilConstantBuffers(HLModule *pHLModule) {
+// Places the largest constants first, each at the lowest offset where it
+// neither overlaps the constants placed before it nor breaks the packing
+// rules, so smaller constants fill the padding the larger ones leave. The
+// constants are then renumbered in offset order, which the cbuffer struct and
+// its reflection follow.
+static unsigned PackDxilConstantBuffer(HLCBuffer &CB) {
+  std::vector<std::unique_ptr<DxilResourceBase>> &constants =
+      CB.GetConstants();
+  std::vector<DxilResourceBase *> bySize;
+  for (const std::unique_ptr<DxilResourceBase> &C : constants)
+    bySize.emplace_back(C.get());
+  std::stable_sort(bySize.begin(), bySize.end(),
+                   [](DxilResourceBase *A, DxilResourceBase *B) {
+                     return A->GetRangeSize() > B->GetRangeSize();
+                   });
+
+  // Ranges of the constants placed so far.
+  std::vector<std::pair<unsigned, unsigned>> placed;
+  unsigned cbSize = 0;
+  for (DxilResourceBase *C : bySize) {
+    unsigned size = C->GetRangeSize();
+    llvm::Type *Ty = C->GetGlobalSymbol()->getType()->getPointerElementType();
+    auto fits = [&](unsigned offset) {
+      for (const std::pair<unsigned, unsigned> &range : placed) {
+        if (offset < range.second && range.first < offset + size)
+          return false;
+      }
+      return true;
+    };
+    // The lowest such offset follows the start or the end of a constant.
+    unsigned offset = AlignCBufferOffset(cbSize, size, Ty);
+    if (fits(0))
+      offset = 0;
+    for (const std::pair<unsigned, unsigned> &range : placed) {
+      unsigned candidate = AlignCBufferOffset(range.second, size, Ty);
+      if (candidate < offset && fits(candidate))
+        offset = candidate;
+    }
+    C->SetLowerBound(offset);
+    placed.emplace_back(offset, offset + size);
+    cbSize = std::max(cbSize, offset + size);
+  }
+
+  std::stable_sort(constants.begin(), constants.end(),
+                   [](const std::unique_ptr<DxilResourceBase> &A,
+                      const std::unique_ptr<DxilResourceBase> &B) {
+                     return A->GetLowerBound() < B->GetLowerBound();
+                   });
+  for (unsigned i = 0; i < constants.size(); i++)
+    constants[i]->SetID(i);
+  return cbSize;
+}
+
+// Constants are only reordered in cbuffers the application cannot have laid
+// out itself: not tbuffers, not arrays of ConstantBuffer, and not cbuffers
+// with packoffset or register on any of their constants.
+static bool CanPackDxilConstantBuffer(HLCBuffer &CB) {
+  if (CB.GetKind() != DXIL::ResourceKind::CBuffer || CB.GetRangeSize() != 1)
+    return false;
+  for (const std::unique_ptr<DxilResourceBase> &C : CB.GetConstants()) {
+    if (C->GetLowerBound() != UINT_MAX)
+      return false;
+  }
+  return true;
+}
+
+static void AllocateDxilConstantBuffers(HLModule *pHLModule,
+                                        bool bPackCBuffers) {
   for (unsigned i = 0; i < pHLModule->GetCBuffers().size(); i++) {
     HLCBuffer &CB = *static_cast<HLCBuffer*>(&(pHLModule->GetCBuffer(i)));
-    unsigned size = AllocateDxilConstantBuffer(CB);
+    unsigned size = bPackCBuffers && CanPackDxilConstantBuffer(CB)
+                        ? PackDxilConstantBuffer(CB)
+                        : AllocateDxilConstantBuffer(CB);
     CB.SetSize(size);
   }
 }
@@ -3871,6 +4008,34 @@ static void CloneShaderEntry(Function *ShaderF, StringRef EntryName,
   }
 }
 
+// Replaces the loads of a link-time constant with calls that the linker
+// substitutes with the value supplied to the link. Each call takes the
+// default value, which is used when no value is supplied.
+static void ReplaceLinkConstantLoads(GlobalVariable *GV, StringRef Name,
+                                     llvm::Module &M) {
+  if (!GV->hasInitializer())
+    return;
+  llvm::Type *Ty = GV->getType()->getPointerElementType();
+  Constant *Default = GV->getInitializer();
+  Function *F = cast<Function>(M.getOrInsertFunction(
+      (Twine(DxilLinker::kLinkConstantPrefix) + Name).str(),
+      llvm::FunctionType::get(Ty, {Ty}, /*isVarArg*/ false)));
+  F->addFnAttr(llvm::Attribute::ReadNone);
+  F->addFnAttr(llvm::Attribute::NoUnwind);
+
+  for (auto U = GV->user_begin(); U != GV->user_end();) {
+    LoadInst *LI = dyn_cast<LoadInst>(*(U++));
+    if (!LI)
+      continue;
+    IRBuilder<> Builder(LI);
+    Value *V = Builder.CreateCall(F, {Default});
+    LI->replaceAllUsesWith(V);
+    LI->eraseFromParent();
+  }
+  if (GV->use_empty())
+    GV->eraseFromParent();
+}
+
 void CGMSHLSLRuntime::FinishCodeGen() {
   // Library don't have entry.
   if (!m_bIsLib) {
@@ -3912,8 +4077,29 @@ void CGMSHLSLRuntime::FinishCodeGen() {
     }
   }
 
+  // Link-time constants only stay unresolved in libraries; elsewhere their
+  // default is the value.
+  if (m_bIsLib) {
+    for (VarDecl *VD : linkConstantList) {
+      if (GlobalVariable *GV =
+              TheModule.getNamedGlobal(CGM.getMangledName(VD)))
+        ReplaceLinkConstantLoads(GV, VD->getQualifiedNameAsString(),
+                                 TheModule);
+    }
+  }
+
+  // Name the [profile] regions for the pass that replaces their markers.
+  if (!profileRegionNames.empty()) {
+    NamedMDNode *pRegions = TheModule.getOrInsertNamedMetadata(
+        DxilMDHelper::kDxilProfileRegionsMDName);
+    for (const std::string &name : profileRegionNames)
+      pRegions->addOperand(
+          MDNode::get(Context, MDString::get(Context, name)));
+  }
+
   // Allocate constant buffers.
-  AllocateDxilConstantBuffers(m_pHLModule);
+  AllocateDxilConstantBuffers(m_pHLModule,
+                              CGM.getCodeGenOpts().HLSLPackCBuffers);
   // TODO: create temp variable for constant which has store use.
 
   // Create Global variable and type annotation for each CBuffer.
@@ -4603,6 +4789,15 @@ static bool ExpTypeMatch(Expr *E, QualType Ty, ASTContext &Ctx, CodeGenTypes &Ty
   }
 }
 
+static bool ScanConstInitList(CodeGenModule &CGM, InitListExpr *E,
+                              SmallVector<Constant *, 4> &EltValList,
+                              CodeGenTypes &Types, bool bDefaultRowMajor,
+                              bool bOnlyConstDecls);
+static Constant *BuildConstInitializer(QualType Type, unsigned &offset,
+                                       SmallVector<Constant *, 4> &EltValList,
+                                       CodeGenTypes &Types,
+                                       bool bDefaultRowMajor);
+
 bool CGMSHLSLRuntime::IsTrivalInitListExpr(CodeGenFunction &CGF,
                                            InitListExpr *E) {
   QualType Ty = E->getType();
@@ -4628,12 +4823,34 @@ Value *CGMSHLSLRuntime::EmitHLSLInitListExpr(CodeGenFunction &CGF, InitListExpr
     }
   }
 
+  QualType ResultTy = E->getType();
+  if (DestPtr && (ResultTy->isArrayType() || ResultTy->isRecordType())) {
+    // Copy a fully constant aggregate from a private global rather than
+    // storing it one scalar at a time; SROA then reads the global in place
+    // of the copy.
+    bool bDefaultRowMajor = m_pHLModule->GetHLOptions().bDefaultRowMajor;
+    SmallVector<Constant *, 4> ConstList;
+    if (ScanConstInitList(CGF.CGM, E, ConstList, CGF.getTypes(),
+                          bDefaultRowMajor, /*bOnlyConstDecls*/ true)) {
+      unsigned offset = 0;
+      Constant *Init = BuildConstInitializer(ResultTy, offset, ConstList,
+                                             CGF.getTypes(), bDefaultRowMajor);
+      if (Init->getType() == DestPtr->getType()->getPointerElementType()) {
+        GlobalVariable *GV = new GlobalVariable(
+            TheModule, Init->getType(), /*IsConstant*/ true,
+            GlobalValue::PrivateLinkage, Init, "initlist.const");
+        GV->setUnnamedAddr(true);
+        EmitHLSLAggregateCopy(CGF, GV, DestPtr, ResultTy);
+        return nullptr;
+      }
+    }
+  }
+
   SmallVector<Value *, 4> EltValList;
   SmallVector<QualType, 4> EltTyList;
   
   ScanInitList(CGF, E, EltValList, EltTyList);
   
-  QualType ResultTy = E->getType();
   unsigned idx = 0;
   // Create cast if need.
   AddMissingCastOpsInInitList(EltValList, EltTyList, idx, ResultTy, CGF);
@@ -4738,21 +4955,29 @@ static void FlatConstToList(Constant *C, SmallVector<Constant *, 4> &EltValList,
   }
 }
 
+// With bOnlyConstDecls, a variable only counts as its initializer when it
+// cannot change: a const local or a static const. A uniform's initializer is
+// only its default value.
 static bool ScanConstInitList(CodeGenModule &CGM, InitListExpr *E,
                               SmallVector<Constant *, 4> &EltValList,
-                              CodeGenTypes &Types, bool bDefaultRowMajor) {
+                              CodeGenTypes &Types, bool bDefaultRowMajor,
+                              bool bOnlyConstDecls) {
   unsigned NumInitElements = E->getNumInits();
   for (unsigned i = 0; i != NumInitElements; ++i) {
     Expr *init = E->getInit(i);
     QualType iType = init->getType();
     if (InitListExpr *initList = dyn_cast<InitListExpr>(init)) {
       if (!ScanConstInitList(CGM, initList, EltValList, Types,
-                             bDefaultRowMajor))
+                             bDefaultRowMajor, bOnlyConstDecls))
         return false;
     } else if (DeclRefExpr *ref = dyn_cast<DeclRefExpr>(init)) {
       if (VarDecl *D = dyn_cast<VarDecl>(ref->getDecl())) {
         if (!D->hasInit())
           return false;
+        if (bOnlyConstDecls &&
+            !(D->getType().isConstQualified() &&
+              (D->hasLocalStorage() || D->getStorageClass() == SC_Static)))
+          return false;
         if (Constant *initVal = CGM.EmitConstantInit(*D)) {
           FlatConstToList(initVal, EltValList, iType, Types, bDefaultRowMajor);
         } else {
@@ -4776,11 +5001,6 @@ static bool ScanConstInitList(CodeGenModule &CGM, InitListExpr *E,
   return true;
 }
 
-static Constant *BuildConstInitializer(QualType Type, unsigned &offset,
-                                       SmallVector<Constant *, 4> &EltValList,
-                                       CodeGenTypes &Types,
-                                       bool bDefaultRowMajor);
-
 static Constant *BuildConstVector(llvm::VectorType *VT, unsigned &offset,
                                   SmallVector<Constant *, 4> &EltValList,
                                   QualType Type, CodeGenTypes &Types) {
@@ -4926,7 +5146,8 @@ Constant *CGMSHLSLRuntime::EmitHLSLConstInitListExpr(CodeGenModule &CGM,
                                                      InitListExpr *E) {
   bool bDefaultRowMajor = m_pHLModule->GetHLOptions().bDefaultRowMajor;
   SmallVector<Constant *, 4> EltValList;
-  if (!ScanConstInitList(CGM, E, EltValList, CGM.getTypes(), bDefaultRowMajor))
+  if (!ScanConstInitList(CGM, E, EltValList, CGM.getTypes(), bDefaultRowMajor,
+                         /*bOnlyConstDecls*/ false))
     return nullptr;
 
   QualType Type = E->getType();
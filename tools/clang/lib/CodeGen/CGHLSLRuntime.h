@@ -36,6 +36,7 @@ class Stmt;
 class Attr;
 class VarDecl;
 class HLSLRootSignatureAttr;
+class HLSLProfileAttr;
 
 namespace CodeGen {
 class CodeGenModule;
@@ -119,6 +120,9 @@ public:
   virtual bool IsHlslObjectType(llvm::Type *Ty) = 0;
 
   virtual void AddControlFlowHint(CodeGenFunction &CGF, const Stmt &S, llvm::TerminatorInst *TI, llvm::ArrayRef<const Attr *> Attrs) = 0;
+  // Opens a [profile] region at the insertion point, pushing a cleanup that
+  // closes it on every exit from the current scope.
+  virtual void EmitHLSLProfileRegionBegin(CodeGenFunction &CGF, const HLSLProfileAttr *Attr) = 0;
 
   virtual void FinishAutoVar(CodeGenFunction &CGF, const VarDecl &D, llvm::Value *V) = 0;
   static const clang::ExtVectorType *
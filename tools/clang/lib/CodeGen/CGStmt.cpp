@@ -497,6 +497,21 @@ void CodeGenFunction::EmitAttributedStmt(const AttributedStmt &S) {
     break;
   // HLSL Change Ends.
   default:
+    // HLSL Change Begins - a [profile] region closes on every exit.
+    if (getLangOpts().HLSL) {
+      const HLSLProfileAttr *Profile = nullptr;
+      for (const Attr *A : S.getAttrs()) {
+        if (const HLSLProfileAttr *PA = dyn_cast<HLSLProfileAttr>(A))
+          Profile = PA;
+      }
+      if (Profile) {
+        RunCleanupsScope ProfileScope(*this);
+        CGM.getHLSLRuntime().EmitHLSLProfileRegionBegin(*this, Profile);
+        EmitStmt(SubStmt);
+        break;
+      }
+    }
+    // HLSL Change Ends.
     EmitStmt(SubStmt);
   }
 }
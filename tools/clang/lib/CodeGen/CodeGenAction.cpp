@@ -34,6 +34,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/Timer.h"
+#include "dxc/Support/PhaseTracing.h" // HLSL Change
 #include <memory>
 using namespace clang;
 using namespace llvm;
@@ -48,6 +49,11 @@ namespace clang {
     const LangOptions &LangOpts;
     raw_pwrite_stream *AsmOutStream;
     ASTContext *Context;
+    // HLSL Change Starts - what the backend needs once the AST is released.
+    SourceManager *SourceMgr;
+    std::string TargetDescription;
+    bool BackendDeferred;
+    // HLSL Change Ends
 
     Timer LLVMIRGeneration;
 
@@ -67,7 +73,9 @@ namespace clang {
                     CoverageSourceInfo *CoverageInfo = nullptr)
         : Diags(Diags), Action(Action), CodeGenOpts(CodeGenOpts),
           TargetOpts(TargetOpts), LangOpts(LangOpts), AsmOutStream(OS),
-          Context(nullptr), LLVMIRGeneration("LLVM IR Generation Time"),
+          Context(nullptr), SourceMgr(nullptr),
+          BackendDeferred(false), // HLSL Change
+          LLVMIRGeneration("LLVM IR Generation Time"),
           Gen(CreateLLVMCodeGen(Diags, InFile, HeaderSearchOpts, PPOpts,
                                 CodeGenOpts, C, CoverageInfo)),
           LinkModule(LinkModule) {
@@ -77,6 +85,25 @@ namespace clang {
     std::unique_ptr<llvm::Module> takeModule() { return std::move(TheModule); }
     llvm::Module *takeLinkModule() { return LinkModule.release(); }
 
+    // HLSL Change Starts
+    bool isBackendDeferred() const { return BackendDeferred; }
+
+    /// Drop IR generation, whose state refers to the AST, ahead of the AST
+    /// itself being released. The deferred backend then reports diagnostics
+    /// without declarations to point at.
+    void releaseFrontend() {
+      Gen.reset();
+      Context = nullptr;
+    }
+
+    void EmitDeferredBackendOutput(raw_pwrite_stream *OS) {
+      assert(BackendDeferred && TheModule && "backend did not wait");
+      BackendDeferred = false;
+      AsmOutStream = OS;
+      EmitBackendOutputWithHandlers();
+    }
+    // HLSL Change Ends
+
     void HandleCXXStaticMemberVarInstantiation(VarDecl *VD) override {
       Gen->HandleCXXStaticMemberVarInstantiation(VD);
     }
@@ -88,6 +115,7 @@ namespace clang {
       }
         
       Context = &Ctx;
+      SourceMgr = &Ctx.getSourceManager(); // HLSL Change
 
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.startTimer();
@@ -108,6 +136,7 @@ namespace clang {
       if (llvm::TimePassesIsEnabled)
         LLVMIRGeneration.startTimer();
 
+      hlsl::PhaseSpan CodeGenSpan("CodeGenTopLevelDecl"); // HLSL Change
       Gen->HandleTopLevelDecl(D);
 
       if (llvm::TimePassesIsEnabled)
@@ -135,6 +164,7 @@ namespace clang {
         if (llvm::TimePassesIsEnabled)
           LLVMIRGeneration.startTimer();
 
+        hlsl::PhaseSpan CodeGenSpan("CodeGen"); // HLSL Change
         Gen->HandleTranslationUnit(C);
 
         if (llvm::TimePassesIsEnabled)
@@ -166,6 +196,23 @@ namespace clang {
           return;
       }
 
+      // HLSL Change Starts - let the caller reuse an earlier backend result,
+      // or run the backend itself once the AST is released.
+      if (CodeGenOpts.HLSLBackendFilter &&
+          !CodeGenOpts.HLSLBackendFilter(C, *TheModule))
+        return;
+
+      TargetDescription = C.getTargetInfo().getTargetDescription();
+      if (CodeGenOpts.HLSLDeferBackend) {
+        BackendDeferred = true;
+        return;
+      }
+      EmitBackendOutputWithHandlers();
+    }
+
+    void EmitBackendOutputWithHandlers() {
+      // HLSL Change Ends
+
       // Install an inline asm handler so that diagnostics get printed through
       // our diagnostics hooks.
       LLVMContext &Ctx = TheModule->getContext();
@@ -179,9 +226,12 @@ namespace clang {
       void *OldDiagnosticContext = Ctx.getDiagnosticContext();
       Ctx.setDiagnosticHandler(DiagnosticHandler, this);
 
-      EmitBackendOutput(Diags, CodeGenOpts, TargetOpts, LangOpts,
-                        C.getTargetInfo().getTargetDescription(),
-                        TheModule.get(), Action, AsmOutStream);
+      {
+        hlsl::PhaseSpan OptimizeSpan("Optimize"); // HLSL Change
+        EmitBackendOutput(Diags, CodeGenOpts, TargetOpts, LangOpts,
+                          TargetDescription, // HLSL Change
+                          TheModule.get(), Action, AsmOutStream);
+      }
 
       Ctx.setInlineAsmDiagnosticHandler(OldHandler, OldContext);
 
@@ -309,7 +359,7 @@ void BackendConsumer::InlineAsmDiagHandler2(const llvm::SMDiagnostic &D,
   // If the SMDiagnostic has an inline asm source location, translate it.
   FullSourceLoc Loc;
   if (D.getLoc() != SMLoc())
-    Loc = ConvertBackendLocation(D, Context->getSourceManager());
+    Loc = ConvertBackendLocation(D, *SourceMgr); // HLSL Change
 
   unsigned DiagID;
   switch (D.getKind()) {
@@ -417,7 +467,8 @@ BackendConsumer::StackSizeDiagHandler(const llvm::DiagnosticInfoStackSize &D) {
     // We do not know how to format other severities.
     return false;
 
-  if (const Decl *ND = Gen->GetDeclForMangledName(D.getFunction().getName())) {
+  // HLSL Change - no declarations once the frontend is released.
+  if (const Decl *ND = Gen ? Gen->GetDeclForMangledName(D.getFunction().getName()) : nullptr) {
     Diags.Report(ND->getASTContext().getFullLoc(ND->getLocation()),
                  diag::warn_fe_frame_larger_than)
         << D.getStackSize() << Decl::castToDeclContext(ND);
@@ -433,7 +484,7 @@ void BackendConsumer::EmitOptimizationMessage(
   assert(D.getSeverity() == llvm::DS_Remark ||
          D.getSeverity() == llvm::DS_Warning);
 
-  SourceManager &SourceMgr = Context->getSourceManager();
+  SourceManager &SourceMgr = *this->SourceMgr; // HLSL Change
   FileManager &FileMgr = SourceMgr.getFileManager();
   StringRef Filename;
   unsigned Line, Column;
@@ -453,7 +504,7 @@ void BackendConsumer::EmitOptimizationMessage(
   // function definition. We use the definition's right brace to differentiate
   // from diagnostics that genuinely relate to the function itself.
   FullSourceLoc Loc(DILoc, SourceMgr);
-  if (Loc.isInvalid())
+  if (Loc.isInvalid() && Gen) // HLSL Change - Gen is gone once released.
     if (const Decl *FD = Gen->GetDeclForMangledName(D.getFunction().getName()))
       Loc = FD->getASTContext().getFullLoc(FD->getBodyRBrace());
 
@@ -584,6 +635,7 @@ CodeGenAction::CodeGenAction(unsigned _Act, LLVMContext *_VMContext)
 
 CodeGenAction::~CodeGenAction() {
   TheModule.reset();
+  DeferredConsumer.reset(); // HLSL Change - holds a module too.
   if (OwnsVMContext)
     delete VMContext;
 }
@@ -599,6 +651,15 @@ void CodeGenAction::EndSourceFileAction() {
   if (LinkModule)
     BEConsumer->takeLinkModule();
 
+  // HLSL Change Starts - keep the module with the consumer until the
+  // deferred backend runs; the AST goes once this returns.
+  if (BEConsumer->isBackendDeferred()) {
+    BEConsumer->releaseFrontend();
+    DeferredConsumer = getCompilerInstance().takeASTConsumer();
+    return;
+  }
+  // HLSL Change Ends
+
   // Steal the module from the consumer.
   TheModule = BEConsumer->takeModule();
 }
@@ -634,12 +695,41 @@ GetOutputStream(CompilerInstance &CI, StringRef InFile, BackendAction Action) {
   llvm_unreachable("Invalid action!");
 }
 
+// HLSL Change Starts
+void CodeGenAction::EmitDeferredBackendOutput(CompilerInstance &CI) {
+  if (!DeferredConsumer)
+    return;
+
+  // The output file of the action was closed with the source file, so it is
+  // opened again for the backend to write to.
+  BackendAction BA = static_cast<BackendAction>(Act);
+  raw_pwrite_stream *OS = GetOutputStream(CI, InFile, BA);
+  if (BA == Backend_EmitNothing || OS) {
+    CI.getDiagnosticClient().BeginSourceFile(CI.getLangOpts());
+    BEConsumer->EmitDeferredBackendOutput(OS);
+    CI.getDiagnosticClient().EndSourceFile();
+  }
+  CI.clearOutputFiles(/*EraseFiles=*/CI.getDiagnostics().hasErrorOccurred());
+
+  TheModule = BEConsumer->takeModule();
+  DeferredConsumer.reset();
+  BEConsumer = nullptr;
+}
+// HLSL Change Ends
+
 std::unique_ptr<ASTConsumer>
 CodeGenAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
   BackendAction BA = static_cast<BackendAction>(Act);
-  raw_pwrite_stream *OS = GetOutputStream(CI, InFile, BA);
-  if (BA != Backend_EmitNothing && !OS)
-    return nullptr;
+  // HLSL Change Starts - a deferred backend opens its output when it runs.
+  raw_pwrite_stream *OS = nullptr;
+  if (CI.getCodeGenOpts().HLSLDeferBackend) {
+    this->InFile = InFile;
+  } else {
+    OS = GetOutputStream(CI, InFile, BA);
+    if (BA != Backend_EmitNothing && !OS)
+      return nullptr;
+  }
+  // HLSL Change Ends
 
   llvm::Module *LinkModuleToUse = LinkModule;
 
@@ -48,6 +48,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"  // HLSL Change
+#include "dxc/Support/WinIncludes.h" // HLSL Change
+#include "dxc/Support/Cancellation.h" // HLSL Change
 using namespace clang;
 
 using llvm::TimeRecord;
@@ -1064,6 +1066,25 @@ static void checkAndSanitizeDiags(SmallVectorImpl<StoredDiagnostic> &
 ///
 /// \returns True if a failure occurred that causes the ASTUnit not to
 /// contain any translation-unit information, false otherwise.
+// HLSL Change Starts
+/// \brief Executes the action with the unit's cancellation state current.
+/// A cancelled action keeps the declarations parsed before it stopped, and
+/// is reported as failed.
+static bool ExecuteCancellable(FrontendAction &Act,
+                               hlsl::CancellationState *State) {
+  if (State == nullptr)
+    return Act.Execute();
+  hlsl::CancellationScope Scope(*State);
+  try {
+    return Act.Execute();
+  } catch (const hlsl::Exception &E) {
+    if (E.hr != DXC_E_COMPILATION_CANCELLED)
+      throw;
+    return false;
+  }
+}
+// HLSL Change Ends
+
 bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
                     std::unique_ptr<llvm::MemoryBuffer> OverrideMainBuffer) {
   SavedMainFileBuffer.reset();
@@ -1164,6 +1185,11 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
     SavedMainFileBuffer = std::move(OverrideMainBuffer);
   }
 
+  // HLSL Change Starts - replay the tokens of unchanged included files.
+  if (PreambleTokenCache)
+    PreprocessorOpts.TokenCacheBuffer = PreambleTokenCache.get();
+  // HLSL Change Ends
+
   std::unique_ptr<TopLevelDeclTrackerAction> Act(
       new TopLevelDeclTrackerAction(*this));
 
@@ -1180,9 +1206,14 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
                                PreambleDiagnostics, StoredDiagnostics);
   }
 
-  if (!Act->Execute())
+  if (!ExecuteCancellable(*Act, Cancellation)) // HLSL Change
     goto error;
 
+  // HLSL Change Starts - keep the tokens of the included files for reparse.
+  if (PreambleRebuildCounter > 0 && !PreambleTokenCache)
+    buildPreambleTokenCache(Clang->getPreprocessor());
+  // HLSL Change Ends
+
   transferASTDataFromCompilerInstance(*Clang);
   
   Act->EndSourceFile();
@@ -1204,6 +1235,87 @@ error:
   return true;
 }
 
+// HLSL Change Starts
+/// \brief Caches the tokens of the files the last parse included, along with
+/// the size and modification time of each file.
+void ASTUnit::buildPreambleTokenCache(Preprocessor &PP) {
+  SmallString<4096> Tokens;
+  llvm::raw_svector_ostream OS(Tokens);
+  CacheIncludedTokens(PP, &OS);
+  std::unique_ptr<llvm::MemoryBuffer> Buffer =
+      llvm::MemoryBuffer::getMemBufferCopy(OS.str(), "<preamble tokens>");
+  if (PreambleTokenCaches)
+    PreambleTokenCache = PreambleTokenCaches->intern(std::move(Buffer));
+  else
+    PreambleTokenCache = std::move(Buffer);
+
+  FilesInPreamble.clear();
+  SourceManager &SM = PP.getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+                                        E = SM.fileinfo_end();
+       I != E; ++I) {
+    const FileEntry *File = I->first;
+    if (File == MainFile || I->second->BufferOverridden)
+      continue;
+    FilesInPreamble[File->getName()] = PreambleFileHash::createForFile(
+        File->getSize(), File->getModificationTime());
+  }
+}
+
+/// \brief Determines whether the cached tokens still match the included
+/// files, which no longer holds once a file is changed on disk or replaced by
+/// an unsaved buffer.
+bool ASTUnit::isPreambleTokenCacheCurrent() {
+  const PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
+  for (const auto &RF : PPOpts.RemappedFiles)
+    if (FilesInPreamble.count(RF.first))
+      return false;
+  for (const auto &RB : PPOpts.RemappedFileBuffers)
+    if (FilesInPreamble.count(RB.first))
+      return false;
+
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS =
+      createVFSFromCompilerInvocation(*Invocation, getDiagnostics());
+  if (!VFS)
+    return false;
+  for (const auto &F : FilesInPreamble) {
+    llvm::ErrorOr<vfs::Status> Status = VFS->status(F.first());
+    if (!Status ||
+        PreambleFileHash::createForFile(
+            Status->getSize(),
+            Status->getLastModificationTime().toEpochTime()) != F.second)
+      return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const llvm::MemoryBuffer>
+PreambleTokenCacheStore::intern(std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  StringRef Tokens = Buffer->getBuffer();
+  size_t Hash = llvm::hash_value(Tokens);
+  llvm::sys::ScopedLock Lock(Mutex);
+  auto Range = Caches.equal_range(Hash);
+  for (auto I = Range.first; I != Range.second; ++I) {
+    std::shared_ptr<const llvm::MemoryBuffer> Cache = I->second.lock();
+    if (Cache && Cache->getBuffer() == Tokens)
+      return Cache;
+  }
+
+  // Forget the caches no unit uses anymore before adding this one.
+  for (auto I = Caches.begin(); I != Caches.end();) {
+    if (I->second.expired())
+      I = Caches.erase(I);
+    else
+      ++I;
+  }
+  std::shared_ptr<const llvm::MemoryBuffer> Cache(std::move(Buffer));
+  Caches.insert(std::make_pair(Hash, std::weak_ptr<const llvm::MemoryBuffer>(
+                                         Cache)));
+  return Cache;
+}
+// HLSL Change Ends
+
 /// \brief Simple function to retrieve a path for a preamble precompiled header.
 static std::string GetPreamblePCHPath() {
   // FIXME: This is a hack so that we can override the preamble file during
@@ -1982,7 +2094,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
     bool AllowPCHWithCompilerErrors, bool SkipFunctionBodies,
     bool UserFilesAreVolatile, bool ForSerialization,
     std::unique_ptr<ASTUnit> *ErrAST,
-    hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions) { // HLSL Change
+    hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions, // HLSL Change
+    std::shared_ptr<PreambleTokenCacheStore> PreambleTokenCaches) { // HLSL Change
   assert(Diags.get() && "no DiagnosticsEngine was provided");
 
   SmallVector<StoredDiagnostic, 4> StoredDiagnostics;
@@ -2046,6 +2159,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   AST.reset(new ASTUnit(false));
   // HLSL Change Starts
   AST->HlslLangExtensions = HlslLangExtensions;
+  AST->PreambleTokenCaches = std::move(PreambleTokenCaches);
   // Enable -verify on the libclang initialization path.
   bool VerifyDiagnostics = false;
   for (const char** Arg = ArgBegin; Arg != ArgEnd; ++Arg) {
@@ -2126,6 +2240,11 @@ bool ASTUnit::Reparse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
     OverrideMainBuffer =
         getMainBufferWithPrecompiledPreamble(PCHContainerOps, *Invocation);
 
+  // HLSL Change Starts - drop the cached tokens if an included file changed.
+  if (PreambleTokenCache && !isPreambleTokenCacheCurrent())
+    PreambleTokenCache.reset();
+  // HLSL Change Ends
+
   // Clear out the diagnostics state.
   getDiagnostics().Reset();
   ProcessWarningOptions(getDiagnostics(), Invocation->getDiagnosticOpts());
@@ -2530,7 +2649,7 @@ void ASTUnit::CodeComplete(
   std::unique_ptr<SyntaxOnlyAction> Act;
   Act.reset(new SyntaxOnlyAction);
   if (Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0])) {
-    Act->Execute();
+    ExecuteCancellable(*Act, Cancellation); // HLSL Change
     Act->EndSourceFile();
   }
 }
@@ -240,7 +240,8 @@ public:
       : Out(out), PP(pp), idcount(0), CurStrOffset(0) {}
 
   PTHMap &getPM() { return PM; }
-  void GeneratePTH(const std::string &MainFile);
+  void GeneratePTH(const std::string &MainFile,
+                   bool IncludedOnly = false); // HLSL Change
 };
 } // end anonymous namespace
 
@@ -478,7 +479,7 @@ static void pwrite32le(raw_pwrite_stream &OS, uint32_t Val, uint64_t &Off) {
   Off += 4;
 }
 
-void PTHWriter::GeneratePTH(const std::string &MainFile) {
+void PTHWriter::GeneratePTH(const std::string &MainFile, bool IncludedOnly) {
   // Generate the prologue.
   Out << "cfe-pth" << '\0';
   Emit32(PTHManager::Version);
@@ -507,14 +508,29 @@ void PTHWriter::GeneratePTH(const std::string &MainFile) {
     const SrcMgr::ContentCache &C = *I->second;
     const FileEntry *FE = C.OrigEntry;
 
+#if 0 // HLSL Change - file names from the HLSL file system are stable
     // FIXME: Handle files with non-absolute paths.
     if (llvm::sys::path::is_relative(FE->getName()))
       continue;
+#endif // HLSL Change
+
+    // HLSL Change Starts - optionally cache only the unmodified files that
+    // were included, lexing them in place.
+    FileID FID;
+    if (IncludedOnly) {
+      if (C.BufferOverridden || FE == SM.getFileEntryForID(SM.getMainFileID()))
+        continue;
+      FID = SM.translateFile(FE);
+      if (FID.isInvalid())
+        continue;
+    }
+    // HLSL Change Ends
 
     const llvm::MemoryBuffer *B = C.getBuffer(PP.getDiagnostics(), SM);
     if (!B) continue;
 
-    FileID FID = SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
+    if (!IncludedOnly) // HLSL Change
+      FID = SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
     const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
     Lexer L(FID, FromFile, SM, LOpts);
     PM.insert(FE, LexTokens(L));
@@ -575,7 +591,7 @@ void clang::CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS) {
   const FileEntry *MainFile = SrcMgr.getFileEntryForID(SrcMgr.getMainFileID());
   SmallString<128> MainFilePath(MainFile->getName());
 
-  llvm::sys::fs::make_absolute(MainFilePath);
+  // llvm::sys::fs::make_absolute(MainFilePath); // HLSL Change - keep names as opened
 
   // Create the PTHWriter.
   PTHWriter PW(*OS, PP);
@@ -597,6 +613,15 @@ void clang::CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS) {
   PW.GeneratePTH(MainFilePath.str());
 }
 
+// HLSL Change Starts
+void clang::CacheIncludedTokens(Preprocessor &PP, raw_pwrite_stream *OS) {
+  // The main file is left unnamed so that units with the same includes
+  // produce the same cache, which ASTUnit can then share between them.
+  PTHWriter PW(*OS, PP);
+  PW.GeneratePTH("", /*IncludedOnly*/ true);
+}
+// HLSL Change Ends
+
 //===----------------------------------------------------------------------===//
 
 namespace {
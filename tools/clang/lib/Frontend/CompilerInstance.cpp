@@ -306,6 +306,15 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
 
   // Create a PTH manager if we are using some form of a token cache.
   PTHManager *PTHMgr = nullptr;
+  // HLSL Change Starts - allow an in-memory token cache.
+  if (PPOpts.TokenCacheBuffer)
+    PTHMgr = PTHManager::Create(
+        llvm::MemoryBuffer::getMemBuffer(
+            PPOpts.TokenCacheBuffer->getMemBufferRef(),
+            /*RequiresNullTerminator*/ false),
+        getDiagnostics());
+  else
+  // HLSL Change Ends
   if (!PPOpts.TokenCache.empty())
     PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics());
 
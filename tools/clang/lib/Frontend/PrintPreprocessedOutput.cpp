@@ -95,12 +95,15 @@ private:
   bool DumpDefines;
   bool UseLineDirectives;
   bool IsFirstFileEntered;
+  bool NormalizeWhitespace; // HLSL Change
 public:
   PrintPPOutputPPCallbacks(Preprocessor &pp, raw_ostream &os, bool lineMarkers,
-                           bool defines, bool UseLineDirectives)
+                           bool defines, bool UseLineDirectives,
+                           bool NormalizeWhitespace) // HLSL Change
       : PP(pp), SM(PP.getSourceManager()), ConcatInfo(PP), OS(os),
         DisableLineMarkers(lineMarkers), DumpDefines(defines),
-        UseLineDirectives(UseLineDirectives) {
+        UseLineDirectives(UseLineDirectives),
+        NormalizeWhitespace(NormalizeWhitespace) { // HLSL Change
     CurLine = 0;
     CurFilename += "<uninit>";
     EmittedTokensOnThisLine = false;
@@ -204,6 +207,15 @@ void PrintPPOutputPPCallbacks::WriteLineInfo(unsigned LineNo,
 /// #line directive.  This returns false if already at the specified line, true
 /// if some newlines were emitted.
 bool PrintPPOutputPPCallbacks::MoveToLine(unsigned LineNo) {
+  // HLSL Change Starts - a single newline between lines, keeping the output
+  // the same when lines only move.
+  if (NormalizeWhitespace && LineNo != CurLine) {
+    startNewLineIfNeeded(/*ShouldUpdateCurrentLine=*/false);
+    CurLine = LineNo;
+    return true;
+  }
+  // HLSL Change Ends
+
   // If this line is "close enough" to the original line, just print newlines,
   // otherwise print a #line directive.
   if (LineNo-CurLine <= 8) {
@@ -541,6 +553,14 @@ bool PrintPPOutputPPCallbacks::HandleFirstTokOnLine(Token &Tok) {
   if (ColNo <= 1 && Tok.is(tok::hash))
     OS << ' ';
 
+  // HLSL Change Starts - keep the leading space of a hash only.
+  if (NormalizeWhitespace) {
+    if (ColNo > 1 && Tok.is(tok::hash))
+      OS << ' ';
+    return true;
+  }
+  // HLSL Change Ends
+
   // Otherwise, indent the appropriate number of spaces.
   for (; ColNo > 1; --ColNo)
     OS << ' ';
@@ -745,7 +765,8 @@ void clang::DoPrintPreprocessedInput(Preprocessor &PP, raw_ostream *OS,
   PP.SetCommentRetentionState(Opts.ShowComments, Opts.ShowMacroComments);
 
   PrintPPOutputPPCallbacks *Callbacks = new PrintPPOutputPPCallbacks(
-      PP, *OS, !Opts.ShowLineMarkers, Opts.ShowMacros, Opts.UseLineDirectives);
+      PP, *OS, !Opts.ShowLineMarkers, Opts.ShowMacros, Opts.UseLineDirectives,
+      Opts.NormalizeWhitespace); // HLSL Change
 
   // Expand macros in pragmas with -fms-extensions.  The assumption is that
   // the majority of pragmas in such a file will be Microsoft pragmas.
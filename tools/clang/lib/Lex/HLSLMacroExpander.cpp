@@ -35,6 +35,11 @@ MacroExpander::MacroExpander(Preprocessor &PP_, unsigned options)
 {
   if (options & STRIP_QUOTES)
     m_stripQuotes = true;
+}
+
+void MacroExpander::CreateExpansionFile() {
+  if (m_expansionFileId.isValid())
+    return;
 
   // The preprocess requires a file to be on the lexing stack when we
   // call ExpandMacro. We add an empty in-memory buffer that we use
@@ -49,9 +54,8 @@ MacroExpander::MacroExpander(Preprocessor &PP_, unsigned options)
   // previously added file, so we have to add the empty file every time
   // we expand macros. We could modify source manager to get/set the
   // macro file id similar to the one we have for getPreambleFileID.
-  // Macros should only be expanded once (if needed for a root signature)
-  // or twice (for semantic defines) so adding an empty file every time
-  // is probably not a big deal.
+  // Only macros that expand other macros get here, so adding an empty
+  // file for them is probably not a big deal.
   m_expansionFileId = PP.getSourceManager().createFileID(std::move(SB));
   if (m_expansionFileId.isInvalid()) {
     DXASSERT(false, "Could not create FileID for macro expnasion?");
@@ -110,12 +114,67 @@ static bool ShouldPrintLeadingSpace(const Token &Tok, const Token &PrevTok, bool
   return true;
 }
 
+void MacroExpander::PrintToken(llvm::raw_ostream &OS, const Token &Tok,
+                               const Token &PrevTok) {
+  if (ShouldPrintLeadingSpace(Tok, PrevTok, m_stripQuotes)) {
+    OS << ' ';
+  }
+  if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
+    OS << II->getName();
+  }
+  else if (Tok.isLiteral() && !Tok.needsCleaning() &&
+    Tok.getLiteralData()) {
+    LiteralData literalData = GetLiteralData(Tok, m_stripQuotes);
+    OS.write(literalData.Data, literalData.Length);
+  }
+  else {
+    std::string S = PP.getSpelling(Tok);
+    OS.write(&S[0], S.size());
+  }
+}
+
+// Whether expanding the macro gives back its own tokens: it takes no
+// arguments, pastes no tokens and names no macro. Root signature defines
+// are usually string literals only.
+static bool ExpandsToOwnTokens(const MacroInfo &macro) {
+  if (!macro.isObjectLike())
+    return false;
+  for (const Token &Tok : macro.tokens()) {
+    if (Tok.is(tok::hashhash))
+      return false;
+    if (IdentifierInfo *II = Tok.getIdentifierInfo())
+      if (II->hasMacroDefinition())
+        return false;
+  }
+  return true;
+}
+
 // Macro expansion implementation.
-// We re-lex the macro using the preprocessors lexer.
+// We re-lex the macro using the preprocessors lexer, unless the expansion
+// is the macro's own tokens, which are printed directly.
 bool MacroExpander::ExpandMacro(MacroInfo *pMacro, std::string *out) {
   if (!pMacro || !out)
     return false;
   MacroInfo &macro = *pMacro;
+  llvm::raw_string_ostream OS(*out);
+
+  // Keep track of previous token to print spaces correctly.
+  Token PrevTok;
+  PrevTok.startToken();
+
+  if (ExpandsToOwnTokens(macro)) {
+    // The preprocessor gives the first token of an expansion the spacing of
+    // the macro name, which is lexed on its own, without leading space.
+    bool first = true;
+    for (Token Tok : macro.tokens()) {
+      if (first)
+        Tok.clearFlag(Token::LeadingSpace);
+      first = false;
+      PrintToken(OS, Tok, PrevTok);
+      PrevTok = Tok;
+    }
+    return true;
+  }
 
   // Initialize the token from the macro definition location.
   Token Tok;
@@ -124,32 +183,14 @@ bool MacroExpander::ExpandMacro(MacroInfo *pMacro, std::string *out) {
     return false;
 
   // Start the lexing process. Use an outer file to make the preprocessor happy.
+  CreateExpansionFile();
   PP.EnterSourceFile(m_expansionFileId, nullptr, PP.getSourceManager().getLocForStartOfFile(m_expansionFileId));
   PP.EnterMacro(Tok, macro.getDefinitionEndLoc(), &macro, nullptr);
   PP.Lex(Tok);
-  llvm::raw_string_ostream OS(*out);
-
-  // Keep track of previous token to print spaces correctly.
-  Token PrevTok;
-  PrevTok.startToken();
 
   // Lex all the tokens from the macro and add them to the output.
   while (!Tok.is(tok::eof)) {
-    if (ShouldPrintLeadingSpace(Tok, PrevTok, m_stripQuotes)) {
-      OS << ' ';
-    }
-    if (IdentifierInfo *II = Tok.getIdentifierInfo()) {
-      OS << II->getName();
-    }
-    else if (Tok.isLiteral() && !Tok.needsCleaning() &&
-      Tok.getLiteralData()) {
-      LiteralData literalData = GetLiteralData(Tok, m_stripQuotes);
-      OS.write(literalData.Data, literalData.Length);
-    }
-    else {
-      std::string S = PP.getSpelling(Tok);
-      OS.write(&S[0], S.size());
-    }
+    PrintToken(OS, Tok, PrevTok);
     PrevTok = Tok;
     PP.Lex(Tok);
   }
@@ -441,7 +441,14 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
     Diags.Report(diag::err_invalid_pth_file) << file;
     return nullptr;
   }
-  std::unique_ptr<llvm::MemoryBuffer> File = std::move(FileOrErr.get());
+  // HLSL Change Starts - reading the data is shared with in-memory caches.
+  return Create(std::move(FileOrErr.get()), Diags);
+}
+
+PTHManager *PTHManager::Create(std::unique_ptr<llvm::MemoryBuffer> File,
+                               DiagnosticsEngine &Diags) {
+  StringRef file = File->getBufferIdentifier();
+  // HLSL Change Ends
 
   using namespace llvm::support;
 
@@ -200,7 +200,11 @@ void Preprocessor::FinalizeForModelFile() {
 
 void Preprocessor::setPTHManager(PTHManager* pm) {
   PTH.reset(pm);
-  FileMgr.addStatCache(PTH->createStatCache());
+  // HLSL Change Starts - the HLSL file system numbers files in the order
+  // they are opened, so cached stat data would alias other files; files are
+  // still opened and only their tokens come from the cache.
+  // FileMgr.addStatCache(PTH->createStatCache());
+  // HLSL Change Ends
 }
 
 void Preprocessor::DumpToken(const Token &Tok, bool DumpFlags) const {
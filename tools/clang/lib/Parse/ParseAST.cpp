@@ -23,6 +23,9 @@
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/Sema/SemaHLSL.h" // HLSL Change
+#include "dxc/Support/WinIncludes.h" // HLSL Change
+#include "dxc/Support/Cancellation.h" // HLSL Change
+#include "dxc/Support/PhaseTracing.h" // HLSL Change
 #include "llvm/Support/CrashRecoveryContext.h"
 #include <cstdio>
 #include <memory>
@@ -133,6 +136,7 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
     External->StartTranslationUnit(Consumer);
 
   if (!S.getDiagnostics().hasUnrecoverableErrorOccurred()) {  // HLSL Change: Skip if fatal error already occurred
+    hlsl::PhaseSpan ParseSpan("Parse"); // HLSL Change
     if (P.ParseTopLevelDecl(ADecl)) {
       if (!External && !S.getLangOpts().CPlusPlus)
         P.Diag(diag::ext_empty_translation_unit);
@@ -143,6 +147,7 @@ void clang::ParseAST(Sema &S, bool PrintStats, bool SkipFunctionBodies) {
         // skipping something.
         if (ADecl && !Consumer->HandleTopLevelDecl(ADecl.get()))
           return;
+        hlsl::ThrowIfCancellationRequested(); // HLSL Change
       } while (!P.ParseTopLevelDecl(ADecl));
     }
   } // HLSL Change: Skip if fatal error already occurred
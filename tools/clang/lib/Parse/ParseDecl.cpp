@@ -693,6 +693,7 @@ void Parser::ParseGNUAttributeArgs(IdentifierInfo *AttrName,
   // HLSL Change Starts
   if (getLangOpts().HLSL) {
     switch (AttrKind) {
+    case AttributeList::AT_HLSLAffine:
     case AttributeList::AT_HLSLAllowUAVCondition:
     case AttributeList::AT_HLSLBranch:
     case AttributeList::AT_HLSLCall:
@@ -703,6 +704,7 @@ void Parser::ParseGNUAttributeArgs(IdentifierInfo *AttrName,
     case AttributeList::AT_HLSLFlatten:
     case AttributeList::AT_HLSLForceCase:
     case AttributeList::AT_HLSLInstance:
+    case AttributeList::AT_HLSLLinkConstant:
     case AttributeList::AT_HLSLLoop:
     case AttributeList::AT_HLSLMaxTessFactor:
     case AttributeList::AT_HLSLNumThreads:
@@ -712,6 +714,7 @@ void Parser::ParseGNUAttributeArgs(IdentifierInfo *AttrName,
     case AttributeList::AT_HLSLOutputTopology:
     case AttributeList::AT_HLSLPartitioning:
     case AttributeList::AT_HLSLPatchConstantFunc:
+    case AttributeList::AT_HLSLProfile:
     case AttributeList::AT_HLSLMaxVertexCount:
     case AttributeList::AT_HLSLUnroll:
     // The following are not accepted in [attribute(param)] syntax:
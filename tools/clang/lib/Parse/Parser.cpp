@@ -575,7 +575,8 @@ bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
 
   case tok::eof:
     // Late template parsing can begin.
-    if (getLangOpts().DelayedTemplateParsing)
+    if (getLangOpts().DelayedTemplateParsing ||
+        getLangOpts().HLSLLazyFunctionBodies) // HLSL Change
       Actions.SetLateTemplateParser(LateTemplateParserCallback,
                                     PP.isIncrementalProcessingEnabled() ?
                                     LateTemplateParserCleanupCallback : nullptr,
@@ -1051,6 +1052,37 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
     }
   }
 
+  // HLSL Change Starts - with lazy function bodies, consume the tokens of the
+  // body and store them for late parsing at the end of the translation unit,
+  // where the bodies of the functions used are parsed.
+  if (getLangOpts().HLSLLazyFunctionBodies && Tok.is(tok::l_brace) &&
+      TemplateInfo.Kind == ParsedTemplateInfo::NonTemplate &&
+      (!LateParsedAttrs || LateParsedAttrs->empty()) &&
+      Actions.CurContext->isFileContext()) {
+    ParseScope BodyScope(this, Scope::FnScope|Scope::DeclScope);
+    Scope *ParentScope = getCurScope()->getParent();
+
+    D.setFunctionDefinitionKind(FDK_Definition);
+    Decl *DP = Actions.HandleDeclarator(ParentScope, D,
+                                        MultiTemplateParamsArg());
+    D.complete(DP);
+    D.getMutableDeclSpec().abort();
+
+    FunctionDecl *FnD = DP ? DP->getAsFunction() : nullptr;
+    if (FnD && Actions.CanDeferHLSLFunctionBody(FnD)) {
+      CachedTokens Toks;
+      LexTemplateFunctionForLateParsing(Toks);
+      Actions.CheckForFunctionRedefinition(FnD);
+      Actions.MarkAsLateParsedTemplate(FnD, DP, Toks);
+      return DP;
+    }
+
+    Decl *Res = Actions.ActOnStartOfFunctionDef(getCurScope(), DP);
+    Actions.ActOnDefaultCtorInitializers(Res);
+    return ParseFunctionStatementBody(Res, BodyScope);
+  }
+  // HLSL Change Ends
+
   // In delayed template parsing mode, for function template we consume the
   // tokens and store them for late parsing at the end of the translation unit.
   if (getLangOpts().DelayedTemplateParsing && Tok.isNot(tok::equal) &&
@@ -19,8 +19,27 @@ const Decoration *Decoration::getUniqueDecoration(SPIRVContext &context,
                                                   const Decoration &d) {
   return context.registerDecoration(d);
 }
-const Decoration *Decoration::getRelaxedPrecision(SPIRVContext &context) {
+std::vector<uint32_t> Decoration::withTargetId(uint32_t targetId) const {
+  std::vector<uint32_t> words;
+  if (memberIndex.hasValue()) {
+    words.push_back(static_cast<uint32_t>(spv::Op::OpMemberDecorate));
+    words.push_back(targetId);
+    words.push_back(memberIndex.getValue());
+  } else {
+    words.push_back(static_cast<uint32_t>(spv::Op::OpDecorate));
+    words.push_back(targetId);
+  }
+  words.push_back(static_cast<uint32_t>(id));
+  words.insert(words.end(), args.begin(), args.end());
+  words.front() |= static_cast<uint32_t>(words.size()) << 16;
+  return words;
+}
+
+const Decoration *
+Decoration::getRelaxedPrecision(SPIRVContext &context,
+                                llvm::Optional<uint32_t> member_idx) {
   Decoration d = Decoration(spv::Decoration::RelaxedPrecision);
+  d.setMemberIndex(member_idx);
   return getUniqueDecoration(context, d);
 }
 const Decoration *Decoration::getSpecId(SPIRVContext &context, uint32_t id) {
@@ -16,8 +16,10 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/SPIRV/ModuleBuilder.h"
+#include "clang/SPIRV/Optimizer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -26,18 +28,41 @@ namespace {
 class SPIRVEmitter : public ASTConsumer,
                      public RecursiveASTVisitor<SPIRVEmitter> {
 public:
-  explicit SPIRVEmitter(raw_ostream *Out)
-      : OutStream(*Out), TheContext(), Builder(&TheContext) {}
+  SPIRVEmitter(raw_ostream *Out, const spirv::OptimizerOptions &OptOptions,
+               bool ReportStats)
+      : OutStream(*Out), OptOptions(OptOptions), ReportStats(ReportStats),
+        TheContext(), Builder(&TheContext) {}
 
   void HandleTranslationUnit(ASTContext &Context) override {
     Builder.beginModule();
     Builder.endModule();
+
+    // Without optimization or statistics the module is streamed out as it is
+    // built; both need the whole binary.
+    if (!OptOptions.any() && !ReportStats) {
+      Builder.takeModule(OutStream);
+      return;
+    }
     std::vector<uint32_t> M = Builder.takeModule();
+    spirv::optimizeModule(&M, OptOptions);
+
+    if (ReportStats) {
+      std::string Stats;
+      llvm::raw_string_ostream OS(Stats);
+      spirv::ModuleStats(M).print(OS);
+      DiagnosticsEngine &Diags = Context.getDiagnostics();
+      Diags.Report(Diags.getCustomDiagID(DiagnosticsEngine::Remark,
+                                         "SPIR-V module: %0"))
+          << OS.str();
+    }
+
     OutStream.write(reinterpret_cast<const char *>(M.data()), M.size() * 4);
   }
 
 private:
   raw_ostream &OutStream;
+  spirv::OptimizerOptions OptOptions;
+  bool ReportStats;
   spirv::SPIRVContext TheContext;
   spirv::ModuleBuilder Builder;
 };
@@ -45,6 +70,15 @@ private:
 
 std::unique_ptr<ASTConsumer>
 EmitSPIRVAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
-  return llvm::make_unique<SPIRVEmitter>(CI.getOutStream());
+  const CodeGenOptions &CGOpts = CI.getCodeGenOpts();
+  spirv::OptimizerOptions OptOptions =
+      spirv::OptimizerOptions::forOptLevel(CGOpts.OptimizationLevel);
+  if (Options.CompactIds) {
+    OptOptions.compactIds = true;
+    OptOptions.stripDebugInfo =
+        CGOpts.getDebugInfo() == CodeGenOptions::NoDebugInfo;
+  }
+  return llvm::make_unique<SPIRVEmitter>(CI.getOutStream(), OptOptions,
+                                         Options.ReportStats);
 }
 } // end namespace clang
\ No newline at end of file
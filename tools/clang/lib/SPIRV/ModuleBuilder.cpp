@@ -19,8 +19,11 @@ namespace spirv {
 ModuleBuilder::ModuleBuilder(SPIRVContext *C)
     : theContext(*C), theModule(), theFunction(llvm::None),
       theBasicBlock(llvm::None), instBuilder(nullptr) {
+  // Copy rather than take the words, so both the builder and the
+  // construction site keep their buffers and building an instruction does
+  // not allocate.
   instBuilder.setConsumer([this](std::vector<uint32_t> &&words) {
-    this->constructSite = std::move(words);
+    this->constructSite.assign(words.begin(), words.end());
   });
 }
 
@@ -78,11 +81,22 @@ ModuleBuilder::Status ModuleBuilder::endBasicBlockWithReturn() {
     return Status::ErrNoActiveBasicBlock;
 
   instBuilder.opReturn().x();
-  theBasicBlock.getValue().addInstruction(std::move(constructSite));
+  theBasicBlock.getValue().addInstruction(constructSite);
 
   return endBasicBlock();
 }
 
+ModuleBuilder::Status ModuleBuilder::addFunction(Function &&f) {
+  std::lock_guard<std::mutex> lock(moduleMutex);
+  theModule.addFunction(std::move(f));
+  return Status::Success;
+}
+
+void ModuleBuilder::decorate(uint32_t targetId, const Decoration *decoration) {
+  std::lock_guard<std::mutex> lock(moduleMutex);
+  theModule.addDecoration(decoration->withTargetId(targetId));
+}
+
 ModuleBuilder::Status ModuleBuilder::endBasicBlock() {
   theFunction.getValue().addBasicBlock(std::move(theBasicBlock.getValue()));
   theBasicBlock.reset();
@@ -95,8 +109,66 @@ std::vector<uint32_t> ModuleBuilder::takeModule() {
     binary.insert(binary.end(), words.begin(), words.end());
   });
 
+  // Each section is a contiguous word buffer, so this concatenates them.
+  theModule.take(&ib);
+  return binary;
+}
+
+FunctionBuilder::FunctionBuilder(SPIRVContext *C, uint32_t funcType,
+                                 uint32_t returnType)
+    : theContext(*C), nextId(0), endId(0), functionId(0),
+      theBasicBlock(llvm::None), instBuilder(nullptr) {
+  instBuilder.setConsumer([this](std::vector<uint32_t> &&words) {
+    this->constructSite.assign(words.begin(), words.end());
+  });
+  functionId = takeNextId();
+  theFunction = Function(returnType, functionId,
+                         spv::FunctionControlMask::MaskNone, funcType);
+}
+
+uint32_t FunctionBuilder::takeNextId() {
+  if (nextId == endId) {
+    nextId = theContext.takeIdRange(kIdRangeSize);
+    endId = nextId + kIdRangeSize;
+  }
+  return nextId++;
+}
+
+ModuleBuilder::Status FunctionBuilder::beginBasicBlock() {
+  if (theBasicBlock.hasValue())
+    return ModuleBuilder::Status::ErrNestedBasicBlock;
+
+  theBasicBlock = llvm::Optional<BasicBlock>(BasicBlock(takeNextId()));
+
+  return ModuleBuilder::Status::Success;
+}
+
+ModuleBuilder::Status FunctionBuilder::endBasicBlockWithReturn() {
+  if (!theBasicBlock.hasValue())
+    return ModuleBuilder::Status::ErrNoActiveBasicBlock;
+
+  instBuilder.opReturn().x();
+  theBasicBlock.getValue().addInstruction(constructSite);
+  theFunction.addBasicBlock(std::move(theBasicBlock.getValue()));
+  theBasicBlock.reset();
+
+  return ModuleBuilder::Status::Success;
+}
+
+ModuleBuilder::Status FunctionBuilder::takeFunction(Function *f) {
+  if (theBasicBlock.hasValue())
+    return ModuleBuilder::Status::ErrActiveBasicBlock;
+
+  *f = std::move(theFunction);
+  return ModuleBuilder::Status::Success;
+}
+
+void ModuleBuilder::takeModule(llvm::raw_ostream &out) {
+  auto ib = InstBuilder([&out](std::vector<uint32_t> &&words) {
+    out.write(reinterpret_cast<const char *>(words.data()), words.size() * 4);
+  });
+
   theModule.take(&ib);
-  return std::move(binary);
 }
 
 } // end namespace spirv
@@ -0,0 +1,609 @@
+//===--- Optimizer.cpp - SPIR-V module optimizer implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/SPIRV/Optimizer.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+#include "spirv/1.0/spirv.hpp11"
+
+namespace clang {
+namespace spirv {
+
+namespace {
+constexpr size_t kHeaderWordCount = 5;
+constexpr size_t kBoundIndex = 3;
+constexpr size_t kNoFunction = ~size_t(0);
+
+spv::Op getOpcode(const uint32_t *inst) {
+  return static_cast<spv::Op>(inst[0] & 0xffff);
+}
+
+uint32_t getWordCount(const uint32_t *inst) { return inst[0] >> 16; }
+
+/// \brief Returns the number of words taken by the literal string starting at
+/// word from of an instruction with the given word count.
+uint32_t getStringWordCount(const uint32_t *inst, uint32_t from,
+                            uint32_t count) {
+  for (uint32_t i = from; i < count; ++i) {
+    const uint32_t w = inst[i];
+    if ((w & 0xffu) == 0 || (w & 0xff00u) == 0 || (w & 0xff0000u) == 0 ||
+        (w & 0xff000000u) == 0)
+      return i - from + 1;
+  }
+  return count - from;
+}
+
+/// \brief Calls fn with the index of every word of inst that holds an id, the
+/// result id included. Returns false if the operands of the instruction are
+/// not known here.
+template <typename Fn> bool forEachIdIndex(const uint32_t *inst, Fn fn) {
+  const uint32_t count = getWordCount(inst);
+  auto range = [count, &fn](uint32_t from, uint32_t to) {
+    for (uint32_t i = from; i < to && i < count; ++i)
+      fn(i);
+  };
+
+  switch (getOpcode(inst)) {
+  case spv::Op::OpNop:
+  case spv::Op::OpSourceContinued:
+  case spv::Op::OpSourceExtension:
+  case spv::Op::OpNoLine:
+  case spv::Op::OpCapability:
+  case spv::Op::OpExtension:
+  case spv::Op::OpMemoryModel:
+  case spv::Op::OpFunctionEnd:
+  case spv::Op::OpReturn:
+  case spv::Op::OpKill:
+  case spv::Op::OpUnreachable:
+    return true;
+  case spv::Op::OpString:
+  case spv::Op::OpLine:
+  case spv::Op::OpExtInstImport:
+  case spv::Op::OpName:
+  case spv::Op::OpMemberName:
+  case spv::Op::OpDecorate:
+  case spv::Op::OpMemberDecorate:
+  case spv::Op::OpExecutionMode:
+  case spv::Op::OpTypeVoid:
+  case spv::Op::OpTypeBool:
+  case spv::Op::OpTypeInt:
+  case spv::Op::OpTypeFloat:
+  case spv::Op::OpTypeSampler:
+  case spv::Op::OpTypeOpaque:
+  case spv::Op::OpTypeEvent:
+  case spv::Op::OpTypeDeviceEvent:
+  case spv::Op::OpTypeReserveId:
+  case spv::Op::OpTypeQueue:
+  case spv::Op::OpTypePipe:
+  case spv::Op::OpTypeForwardPointer:
+  case spv::Op::OpLabel:
+  case spv::Op::OpReturnValue:
+  case spv::Op::OpBranch:
+  case spv::Op::OpSelectionMerge:
+    range(1, 2);
+    return true;
+  case spv::Op::OpTypeVector:
+  case spv::Op::OpTypeMatrix:
+  case spv::Op::OpTypeImage:
+  case spv::Op::OpTypeSampledImage:
+  case spv::Op::OpTypeRuntimeArray:
+  case spv::Op::OpConstantTrue:
+  case spv::Op::OpConstantFalse:
+  case spv::Op::OpConstant:
+  case spv::Op::OpConstantSampler:
+  case spv::Op::OpConstantNull:
+  case spv::Op::OpSpecConstantTrue:
+  case spv::Op::OpSpecConstantFalse:
+  case spv::Op::OpSpecConstant:
+  case spv::Op::OpFunctionParameter:
+  case spv::Op::OpLoopMerge:
+  case spv::Op::OpStore:
+    range(1, 3);
+    return true;
+  case spv::Op::OpTypeArray:
+  case spv::Op::OpLoad:
+  case spv::Op::OpBranchConditional:
+    range(1, 4);
+    return true;
+  case spv::Op::OpSource:
+    range(3, 4);
+    return true;
+  case spv::Op::OpTypePointer:
+    range(1, 2);
+    range(3, 4);
+    return true;
+  case spv::Op::OpVariable:
+  case spv::Op::OpFunction:
+    range(1, 3);
+    range(4, 5);
+    return true;
+  case spv::Op::OpTypeStruct:
+  case spv::Op::OpTypeFunction:
+  case spv::Op::OpConstantComposite:
+  case spv::Op::OpSpecConstantComposite:
+  case spv::Op::OpFunctionCall:
+    range(1, count);
+    return true;
+  case spv::Op::OpEntryPoint:
+    range(2, 3);
+    range(3 + getStringWordCount(inst, 3, count), count);
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// \brief Returns the index of the result id word for the given opcode, or 0
+/// if instructions with this opcode have no result id.
+uint32_t getResultIdIndex(spv::Op opcode) {
+  switch (opcode) {
+  case spv::Op::OpString:
+  case spv::Op::OpExtInstImport:
+  case spv::Op::OpTypeVoid:
+  case spv::Op::OpTypeBool:
+  case spv::Op::OpTypeInt:
+  case spv::Op::OpTypeFloat:
+  case spv::Op::OpTypeVector:
+  case spv::Op::OpTypeMatrix:
+  case spv::Op::OpTypeImage:
+  case spv::Op::OpTypeSampler:
+  case spv::Op::OpTypeSampledImage:
+  case spv::Op::OpTypeArray:
+  case spv::Op::OpTypeRuntimeArray:
+  case spv::Op::OpTypeStruct:
+  case spv::Op::OpTypeOpaque:
+  case spv::Op::OpTypePointer:
+  case spv::Op::OpTypeFunction:
+  case spv::Op::OpTypeEvent:
+  case spv::Op::OpTypeDeviceEvent:
+  case spv::Op::OpTypeReserveId:
+  case spv::Op::OpTypeQueue:
+  case spv::Op::OpTypePipe:
+  case spv::Op::OpLabel:
+    return 1;
+  case spv::Op::OpConstantTrue:
+  case spv::Op::OpConstantFalse:
+  case spv::Op::OpConstant:
+  case spv::Op::OpConstantComposite:
+  case spv::Op::OpConstantSampler:
+  case spv::Op::OpConstantNull:
+  case spv::Op::OpSpecConstantTrue:
+  case spv::Op::OpSpecConstantFalse:
+  case spv::Op::OpSpecConstant:
+  case spv::Op::OpSpecConstantComposite:
+  case spv::Op::OpVariable:
+  case spv::Op::OpFunction:
+  case spv::Op::OpFunctionParameter:
+  case spv::Op::OpFunctionCall:
+  case spv::Op::OpLoad:
+    return 2;
+  default:
+    return 0;
+  }
+}
+
+/// \brief Returns true if the opcode declares a type or a constant.
+bool isDeclaration(spv::Op opcode) {
+  if (opcode == spv::Op::OpTypeForwardPointer)
+    return false;
+  return (opcode >= spv::Op::OpTypeVoid && opcode <= spv::Op::OpTypePipe) ||
+         (opcode >= spv::Op::OpConstantTrue &&
+          opcode <= spv::Op::OpSpecConstantComposite);
+}
+
+/// \brief Returns true if two declarations with the opcode and the same
+/// operands are interchangeable. Structs and opaque types may be distinct
+/// with the same operands, and spec constants are told apart by their ids.
+bool isMergeable(spv::Op opcode) {
+  switch (opcode) {
+  case spv::Op::OpTypeStruct:
+  case spv::Op::OpTypeOpaque:
+  case spv::Op::OpSpecConstantTrue:
+  case spv::Op::OpSpecConstantFalse:
+  case spv::Op::OpSpecConstant:
+  case spv::Op::OpSpecConstantComposite:
+    return false;
+  default:
+    return isDeclaration(opcode);
+  }
+}
+
+/// \brief Returns true if the opcode only names or decorates its first
+/// operand, and so does not keep it alive.
+bool isDebugOrAnnotation(spv::Op opcode) {
+  switch (opcode) {
+  case spv::Op::OpName:
+  case spv::Op::OpMemberName:
+  case spv::Op::OpDecorate:
+  case spv::Op::OpMemberDecorate:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// \brief Returns true if the opcode carries debug information only.
+bool isDebugInfo(spv::Op opcode) {
+  switch (opcode) {
+  case spv::Op::OpSourceContinued:
+  case spv::Op::OpSource:
+  case spv::Op::OpSourceExtension:
+  case spv::Op::OpName:
+  case spv::Op::OpMemberName:
+  case spv::Op::OpString:
+  case spv::Op::OpLine:
+  case spv::Op::OpNoLine:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// \brief Runs the passes over the words of one module. Instructions are
+/// kept in place and rewritten there; removed ones are only marked until the
+/// binary is written back.
+class ModuleOptimizer {
+public:
+  explicit ModuleOptimizer(std::vector<uint32_t> &words)
+      : binary(words), bound(0), changed(false) {}
+
+  /// \brief Splits the binary into instructions. Returns false if it is
+  /// malformed or uses instructions whose operands are not known.
+  bool parse();
+  /// \brief Removes debug names, source and line information.
+  void stripDebugInfo();
+  /// \brief Merges duplicate undecorated type and constant declarations.
+  void mergeDuplicateDeclarations();
+  /// \brief Removes declarations, global variables and functions nothing live
+  /// refers to, along with their names and decorations.
+  void eliminateDeadDeclarations();
+  /// \brief Renumbers the ids in order of first appearance.
+  void compactIds();
+  /// \brief Writes the live instructions back to the binary. Returns true if
+  /// the binary changed.
+  bool finish();
+
+private:
+  uint32_t *getInst(size_t i) { return &binary[offsets[i]]; }
+  /// \brief Returns true if instruction i may be removed when unused.
+  bool isRemovable(size_t i);
+  /// \brief Marks instruction i dead, with the body if it is a function.
+  void markDead(size_t i);
+  /// \brief Rewrites every id of the live instructions through newIds.
+  void remapIds(const std::vector<uint32_t> &newIds);
+
+  std::vector<uint32_t> &binary;
+  std::vector<size_t> offsets;   ///< Offset of each instruction in binary.
+  std::vector<size_t> functions; ///< Enclosing OpFunction of each instruction.
+  std::vector<bool> dead;
+  uint32_t bound;
+  bool changed;
+};
+
+bool ModuleOptimizer::parse() {
+  if (binary.size() < kHeaderWordCount || binary[0] != spv::MagicNumber)
+    return false;
+  bound = binary[kBoundIndex];
+
+  size_t function = kNoFunction;
+  for (size_t offset = kHeaderWordCount; offset < binary.size();) {
+    const uint32_t *inst = &binary[offset];
+    const uint32_t count = getWordCount(inst);
+    if (count == 0 || offset + count > binary.size())
+      return false;
+
+    bool valid = true;
+    if (!forEachIdIndex(inst, [&](uint32_t i) {
+          if (inst[i] == 0 || inst[i] >= bound)
+            valid = false;
+        }) ||
+        !valid)
+      return false;
+
+    const spv::Op opcode = getOpcode(inst);
+    if (opcode == spv::Op::OpFunction)
+      function = offsets.size();
+    offsets.push_back(offset);
+    functions.push_back(function);
+    if (opcode == spv::Op::OpFunctionEnd)
+      function = kNoFunction;
+    offset += count;
+  }
+
+  dead.assign(offsets.size(), false);
+  return true;
+}
+
+bool ModuleOptimizer::isRemovable(size_t i) {
+  const spv::Op opcode = getOpcode(getInst(i));
+  if (opcode == spv::Op::OpVariable)
+    return functions[i] == kNoFunction;
+  return opcode == spv::Op::OpFunction || isDeclaration(opcode);
+}
+
+void ModuleOptimizer::markDead(size_t i) {
+  dead[i] = true;
+  if (getOpcode(getInst(i)) != spv::Op::OpFunction)
+    return;
+  for (size_t j = i + 1; j < offsets.size() && functions[j] == i; ++j)
+    dead[j] = true;
+}
+
+void ModuleOptimizer::remapIds(const std::vector<uint32_t> &newIds) {
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    if (dead[i])
+      continue;
+    uint32_t *inst = getInst(i);
+    forEachIdIndex(inst, [&](uint32_t w) { inst[w] = newIds[inst[w]]; });
+  }
+}
+
+void ModuleOptimizer::stripDebugInfo() {
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    if (!dead[i] && isDebugInfo(getOpcode(getInst(i)))) {
+      dead[i] = true;
+      changed = true;
+    }
+  }
+}
+
+void ModuleOptimizer::mergeDuplicateDeclarations() {
+  std::vector<bool> decorated(bound, false);
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    const spv::Op opcode = getOpcode(inst);
+    if (opcode == spv::Op::OpDecorate || opcode == spv::Op::OpMemberDecorate)
+      decorated[inst[1]] = true;
+  }
+
+  std::vector<uint32_t> newIds(bound);
+  std::iota(newIds.begin(), newIds.end(), 0);
+  // Keyed by the words of the declaration with the result id zeroed.
+  std::map<std::vector<uint32_t>, uint32_t> declarations;
+  bool merged = false;
+
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    const spv::Op opcode = getOpcode(inst);
+    if (dead[i] || !isMergeable(opcode))
+      continue;
+    const uint32_t resultIndex = getResultIdIndex(opcode);
+    const uint32_t resultId = inst[resultIndex];
+    if (decorated[resultId])
+      continue;
+
+    // Declarations only refer to earlier ones, whose merges are known.
+    std::vector<uint32_t> key(inst, inst + getWordCount(inst));
+    forEachIdIndex(inst, [&](uint32_t w) { key[w] = newIds[key[w]]; });
+    key[resultIndex] = 0;
+
+    auto inserted = declarations.emplace(std::move(key), resultId);
+    if (!inserted.second) {
+      newIds[resultId] = inserted.first->second;
+      dead[i] = true;
+      merged = true;
+    }
+  }
+  if (!merged)
+    return;
+
+  // The kept declaration has its own name already.
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    const spv::Op opcode = getOpcode(inst);
+    if ((opcode == spv::Op::OpName || opcode == spv::Op::OpMemberName) &&
+        newIds[inst[1]] != inst[1])
+      dead[i] = true;
+  }
+
+  remapIds(newIds);
+  changed = true;
+}
+
+void ModuleOptimizer::eliminateDeadDeclarations() {
+  // Functions may be exported through a LinkageAttributes decoration, so
+  // decorations keep functions alive.
+  std::vector<bool> isFunction(bound, false);
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    if (getOpcode(inst) == spv::Op::OpFunction)
+      isFunction[inst[2]] = true;
+  }
+
+  // Removing a declaration may leave the ones it used unused, so iterate
+  // until nothing more goes.
+  bool removed = true;
+  while (removed) {
+    removed = false;
+
+    std::vector<uint32_t> uses(bound, 0);
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      const uint32_t *inst = getInst(i);
+      const spv::Op opcode = getOpcode(inst);
+      if (dead[i])
+        continue;
+      if (isDebugOrAnnotation(opcode)) {
+        if (opcode == spv::Op::OpDecorate && isFunction[inst[1]])
+          ++uses[inst[1]];
+        continue;
+      }
+      const uint32_t resultIndex = getResultIdIndex(opcode);
+      forEachIdIndex(inst, [&](uint32_t w) {
+        if (w != resultIndex)
+          ++uses[inst[w]];
+      });
+    }
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      if (dead[i] || !isRemovable(i))
+        continue;
+      const uint32_t *inst = getInst(i);
+      if (uses[inst[getResultIdIndex(getOpcode(inst))]] == 0) {
+        markDead(i);
+        removed = true;
+        changed = true;
+      }
+    }
+  }
+
+  std::vector<bool> defined(bound, false);
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    const uint32_t resultIndex = getResultIdIndex(getOpcode(inst));
+    if (!dead[i] && resultIndex != 0)
+      defined[inst[resultIndex]] = true;
+  }
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const uint32_t *inst = getInst(i);
+    if (!dead[i] && isDebugOrAnnotation(getOpcode(inst)) && !defined[inst[1]])
+      dead[i] = true;
+  }
+}
+
+void ModuleOptimizer::compactIds() {
+  std::vector<uint32_t> newIds(bound, 0);
+  uint32_t nextId = 1;
+  bool renumbered = false;
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    if (dead[i])
+      continue;
+    const uint32_t *inst = getInst(i);
+    forEachIdIndex(inst, [&](uint32_t w) {
+      uint32_t &newId = newIds[inst[w]];
+      if (newId == 0) {
+        newId = nextId++;
+        renumbered |= newId != inst[w];
+      }
+    });
+  }
+  if (!renumbered && nextId == bound)
+    return;
+
+  remapIds(newIds);
+  bound = nextId;
+  changed = true;
+}
+
+bool ModuleOptimizer::finish() {
+  if (!changed)
+    return false;
+
+  // Instructions only move towards the front, so copying in order is safe.
+  size_t out = kHeaderWordCount;
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    if (dead[i])
+      continue;
+    const uint32_t *inst = getInst(i);
+    const uint32_t count = getWordCount(inst);
+    std::copy(inst, inst + count, binary.begin() + out);
+    out += count;
+  }
+  binary.resize(out);
+  binary[kBoundIndex] = bound;
+  return true;
+}
+} // namespace
+
+OptimizerOptions OptimizerOptions::forOptLevel(unsigned optLevel) {
+  OptimizerOptions options;
+  if (optLevel > 0) {
+    options.mergeDeclarations = true;
+    options.eliminateDeadDeclarations = true;
+    options.compactIds = true;
+  }
+  return options;
+}
+
+bool optimizeModule(std::vector<uint32_t> *binary,
+                    const OptimizerOptions &options) {
+  if (!options.any())
+    return false;
+
+  ModuleOptimizer optimizer(*binary);
+  if (!optimizer.parse())
+    return false;
+
+  if (options.stripDebugInfo)
+    optimizer.stripDebugInfo();
+  if (options.mergeDeclarations)
+    optimizer.mergeDuplicateDeclarations();
+  if (options.eliminateDeadDeclarations)
+    optimizer.eliminateDeadDeclarations();
+  if (options.compactIds)
+    optimizer.compactIds();
+  return optimizer.finish();
+}
+
+ModuleStats::ModuleStats(const std::vector<uint32_t> &binary)
+    : idBound(0), totalWords(static_cast<uint32_t>(binary.size())),
+      sectionWords() {
+  if (binary.size() < kHeaderWordCount)
+    return;
+  idBound = binary[kBoundIndex];
+  sectionWords[Header] = kHeaderWordCount;
+
+  bool inFunctions = false;
+  for (size_t offset = kHeaderWordCount; offset < binary.size();) {
+    const uint32_t *inst = &binary[offset];
+    const uint32_t count = getWordCount(inst);
+    if (count == 0)
+      break;
+
+    const spv::Op opcode = getOpcode(inst);
+    inFunctions |= opcode == spv::Op::OpFunction;
+    Section section = TypesValues;
+    if (inFunctions)
+      section = Functions;
+    else if (opcode == spv::Op::OpCapability)
+      section = Capabilities;
+    else if (opcode == spv::Op::OpExtension ||
+             opcode == spv::Op::OpExtInstImport)
+      section = Extensions;
+    else if (opcode == spv::Op::OpMemoryModel)
+      section = MemoryModel;
+    else if (opcode == spv::Op::OpEntryPoint)
+      section = EntryPoints;
+    else if (opcode == spv::Op::OpExecutionMode)
+      section = ExecutionModes;
+    else if (isDebugInfo(opcode) && opcode != spv::Op::OpLine &&
+             opcode != spv::Op::OpNoLine)
+      section = Debug;
+    else if (opcode >= spv::Op::OpDecorate &&
+             opcode <= spv::Op::OpGroupMemberDecorate)
+      section = Annotations;
+
+    sectionWords[section] += count;
+    offset += count;
+  }
+}
+
+void ModuleStats::print(llvm::raw_ostream &out) const {
+  static const char *const sectionNames[SectionCount] = {
+      "header",          "capabilities", "extensions",
+      "memory model",    "entry points", "execution modes",
+      "debug",           "annotations",  "types and values",
+      "functions"};
+
+  out << totalWords << " words, id bound " << idBound;
+  const char *separator = " (";
+  for (unsigned i = 0; i < SectionCount; ++i) {
+    if (sectionWords[i] == 0)
+      continue;
+    out << separator << sectionNames[i] << " " << sectionWords[i];
+    separator = ", ";
+  }
+  if (separator[0] == ',')
+    out << ")";
+}
+
+} // end namespace spirv
+} // end namespace clang
@@ -7,8 +7,6 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <tuple>
-
 #include "clang/SPIRV/SPIRVContext.h"
 #include "llvm/llvm_assert/assert.h"
 
@@ -17,6 +15,7 @@ namespace spirv {
 
 uint32_t SPIRVContext::getResultIdForType(const Type *t) {
   assert(t != nullptr);
+  std::lock_guard<std::mutex> lock(tableMutex);
   uint32_t result_id = 0;
 
   auto iter = typeResultIdMap.find(t);
@@ -32,18 +31,41 @@ uint32_t SPIRVContext::getResultIdForType(const Type *t) {
   return result_id;
 }
 
+uint32_t SPIRVContext::getResultIdForConstant(const Type *t,
+                                              llvm::ArrayRef<uint32_t> words) {
+  assert(t != nullptr);
+  std::lock_guard<std::mutex> lock(tableMutex);
+  ConstantKey key{t, words.vec()};
+  auto iter = constantResultIdMap.find(key);
+  if (iter != constantResultIdMap.end())
+    return iter->second;
+
+  // The constant has not been defined yet. Reserve an ID for it.
+  const uint32_t result_id = takeNextId();
+  constantResultIdMap.emplace(std::move(key), result_id);
+  return result_id;
+}
+
 const Type *SPIRVContext::registerType(const Type &t) {
-  // Insert function will only insert if it doesn't already exist in the set.
-  TypeSet::iterator it;
-  std::tie(it, std::ignore) = existingTypes.insert(t);
-  return &*it;
+  std::lock_guard<std::mutex> lock(tableMutex);
+  // Only copy the type into the arena if it is not already known.
+  auto iter = existingTypes.find(&t);
+  if (iter != existingTypes.end())
+    return *iter;
+  const Type *unique = new (typeAllocator.Allocate()) Type(t);
+  existingTypes.insert(unique);
+  return unique;
 }
 
 const Decoration *SPIRVContext::registerDecoration(const Decoration &d) {
-  // Insert function will only insert if it doesn't already exist in the set.
-  DecorationSet::iterator it;
-  std::tie(it, std::ignore) = existingDecorations.insert(d);
-  return &*it;
+  std::lock_guard<std::mutex> lock(tableMutex);
+  // Only copy the decoration into the arena if it is not already known.
+  auto iter = existingDecorations.find(&d);
+  if (iter != existingDecorations.end())
+    return *iter;
+  const Decoration *unique = new (decorationAllocator.Allocate()) Decoration(d);
+  existingDecorations.insert(unique);
+  return unique;
 }
 
 } // end namespace spirv
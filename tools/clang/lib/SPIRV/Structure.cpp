@@ -33,13 +33,15 @@ bool isTerminator(spv::Op opcode) {
 } // namespace
 
 BasicBlock::BasicBlock(BasicBlock &&that)
-    : labelId(that.labelId), instructions(std::move(that.instructions)) {
+    : labelId(that.labelId), words(std::move(that.words)),
+      lastInstOffset(that.lastInstOffset) {
   that.clear();
 }
 
 BasicBlock &BasicBlock::operator=(BasicBlock &&that) {
   labelId = that.labelId;
-  instructions = std::move(that.instructions);
+  words = std::move(that.words);
+  lastInstOffset = that.lastInstOffset;
 
   that.clear();
 
@@ -48,14 +50,11 @@ BasicBlock &BasicBlock::operator=(BasicBlock &&that) {
 
 void BasicBlock::take(InstBuilder *builder) {
   // Make sure we have a terminator instruction at the end.
-  // TODO: This is a little bit ugly. It suggests that we should put the opcode
-  // in the Instruction struct. But fine for now.
-  assert(!instructions.empty() && isTerminator(static_cast<spv::Op>(
-                                      instructions.back().front() & 0xffff)));
+  assert(!words.empty() &&
+         isTerminator(static_cast<spv::Op>(words[lastInstOffset] & 0xffff)));
   builder->opLabel(labelId).x();
-  for (auto &inst : instructions) {
-    builder->getConsumer()(std::move(inst));
-  }
+  // All instructions are fed to the consumer at once.
+  builder->getConsumer()(std::move(words));
   clear();
 }
 
@@ -110,7 +109,7 @@ bool SPIRVModule::isEmpty() const {
          extInstSets.empty() && !addressingModel.hasValue() &&
          !memoryModel.hasValue() && entryPoints.empty() &&
          executionModes.empty() && debugNames.empty() && decorations.empty() &&
-         functions.empty();
+         functionWords.empty();
 }
 
 void SPIRVModule::clear() {
@@ -124,7 +123,8 @@ void SPIRVModule::clear() {
   executionModes.clear();
   debugNames.clear();
   decorations.clear();
-  functions.clear();
+  typesValues.clear();
+  functionWords.clear();
 }
 
 void SPIRVModule::take(InstBuilder *builder) {
@@ -156,9 +156,8 @@ void SPIRVModule::take(InstBuilder *builder) {
         .x();
   }
 
-  for (auto &inst : executionModes) {
-    consumer(std::move(inst));
-  }
+  if (!executionModes.empty())
+    consumer(std::move(executionModes));
 
   for (auto &inst : debugNames) {
     if (inst.memberIndex.hasValue()) {
@@ -171,21 +170,25 @@ void SPIRVModule::take(InstBuilder *builder) {
     }
   }
 
-  for (auto &inst : decorations) {
-    consumer(std::move(inst));
-  }
+  if (!decorations.empty())
+    consumer(std::move(decorations));
 
-  for (auto &inst : typesValues) {
-    consumer(std::move(inst));
-  }
+  if (!typesValues.empty())
+    consumer(std::move(typesValues));
 
-  for (uint32_t i = 0; i < functions.size(); ++i) {
-    functions[i].take(builder);
-  }
+  if (!functionWords.empty())
+    consumer(std::move(functionWords));
 
   clear();
 }
 
+void SPIRVModule::addFunction(Function &&f) {
+  InstBuilder builder([this](std::vector<uint32_t> &&words) {
+    functionWords.insert(functionWords.end(), words.begin(), words.end());
+  });
+  f.take(&builder);
+}
+
 void SPIRVModule::Header::collect(const WordConsumer &consumer) {
   std::vector<uint32_t> words;
   words.push_back(magicNumber);
@@ -0,0 +1,125 @@
+//===--- TypeTranslator.cpp - TypeTranslator implementation -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/SPIRV/TypeTranslator.h"
+
+#include "clang/AST/Decl.h"
+#include "clang/AST/HlslTypes.h"
+
+namespace clang {
+namespace spirv {
+
+namespace {
+/// \brief Returns the element type of the given HLSL vector or matrix type,
+/// or the type itself otherwise.
+QualType getElementType(QualType type) {
+  if (hlsl::IsHLSLVecType(type))
+    return hlsl::GetHLSLVecElementType(type);
+  if (hlsl::IsHLSLMatType(type))
+    return hlsl::GetHLSLMatElementType(type);
+  return type;
+}
+} // namespace
+
+TypeTranslator::TypeTranslator(SPIRVContext *context, ModuleBuilder *builder)
+    : theContext(*context), theBuilder(*builder) {}
+
+bool TypeTranslator::isRelaxedPrecisionType(QualType type) {
+  const auto *builtinType = getElementType(type)->getAs<BuiltinType>();
+  if (!builtinType)
+    return false;
+
+  // Without native 16-bit types, min16float is half, min16int is short and
+  // min16uint is unsigned short.
+  switch (builtinType->getKind()) {
+  case BuiltinType::Half:
+  case BuiltinType::Min10Float:
+  case BuiltinType::Short:
+  case BuiltinType::UShort:
+  case BuiltinType::Min12Int:
+    return true;
+  default:
+    return false;
+  }
+}
+
+const Type *TypeTranslator::translateBuiltinType(const BuiltinType *type) {
+  switch (type->getKind()) {
+  case BuiltinType::Void:
+    return Type::getVoid(theContext);
+  case BuiltinType::Bool:
+    return Type::getBool(theContext);
+  case BuiltinType::Int:
+  case BuiltinType::Short:
+  case BuiltinType::Min12Int:
+    return Type::getInt32(theContext);
+  case BuiltinType::UInt:
+  case BuiltinType::UShort:
+    return Type::getUint32(theContext);
+  case BuiltinType::Float:
+  case BuiltinType::Half:
+  case BuiltinType::Min10Float:
+    return Type::getFloat32(theContext);
+  case BuiltinType::Double:
+    return Type::getFloat64(theContext);
+  default:
+    return nullptr;
+  }
+}
+
+uint32_t TypeTranslator::translateType(QualType type) {
+  if (const auto *builtinType = type->getAs<BuiltinType>()) {
+    const Type *spirvType = translateBuiltinType(builtinType);
+    return spirvType ? theContext.getResultIdForType(spirvType) : 0;
+  }
+
+  if (hlsl::IsHLSLVecType(type)) {
+    const uint32_t size = hlsl::GetHLSLVecSize(type);
+    const uint32_t elementId = translateType(getElementType(type));
+    if (elementId == 0)
+      return 0;
+    // A one-component vector is its element.
+    if (size == 1)
+      return elementId;
+    return theContext.getResultIdForType(
+        Type::getVector(theContext, elementId, size));
+  }
+
+  if (const auto *recordType = type->getAs<RecordType>()) {
+    const RecordDecl *decl = recordType->getDecl();
+    if (!decl->isStruct() || hlsl::IsHLSLMatType(type))
+      return 0;
+
+    std::vector<uint32_t> members;
+    std::set<const Decoration *> decorations;
+    for (const FieldDecl *field : decl->fields()) {
+      const uint32_t memberId = translateType(field->getType());
+      if (memberId == 0)
+        return 0;
+      if (isRelaxedPrecisionType(field->getType()))
+        decorations.insert(
+            Decoration::getRelaxedPrecision(theContext, members.size()));
+      members.push_back(memberId);
+    }
+    return theContext.getResultIdForType(Type::getType(
+        theContext, spv::Op::OpTypeStruct, std::move(members),
+        std::move(decorations)));
+  }
+
+  return 0;
+}
+
+void TypeTranslator::decorateRelaxedPrecision(uint32_t targetId,
+                                              QualType type) {
+  if (isRelaxedPrecisionType(type))
+    theBuilder.decorate(targetId, Decoration::getRelaxedPrecision(theContext));
+}
+
+} // end namespace spirv
+} // end namespace clang
@@ -683,6 +683,10 @@ void Sema::ActOnEndOfTranslationUnit() {
       PendingInstantiations.insert(PendingInstantiations.begin(),
                                    Pending.begin(), Pending.end());
     }
+    // HLSL Change Starts - parse the deferred bodies that turned out to be used.
+    if (getLangOpts().HLSLLazyFunctionBodies)
+      ParseUsedLazyHLSLFunctionBodies();
+    // HLSL Change Ends
     PerformPendingInstantiations();
 
     if (LateTemplateParserCleanup)
@@ -12553,6 +12553,11 @@ void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func,
       if (!i->isUsed(false) && i->isImplicitlyInstantiable())
         MarkFunctionReferenced(Loc, i);
     }
+    // HLSL Change Starts - bodies deferred until use are parsed at the end
+    // of the translation unit.
+    if (getLangOpts().HLSLLazyFunctionBodies)
+      UsedLazyHLSLFunctions.push_back(Func);
+    // HLSL Change Ends
   }
 
   // Keep track of used but undefined functions.
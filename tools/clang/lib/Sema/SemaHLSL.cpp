@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/DeclCXX.h"
@@ -31,12 +32,14 @@
 #include "clang/Sema/TemplateDeduction.h"
 #include "clang/Sema/SemaHLSL.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/PhaseTracing.h"
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.internal.h"
 #include "dxc/HlslIntrinsicOp.h"
 #include "gen_intrin_main_tables_15.h"
 #include "dxc/HLSL/HLOperations.h"
 #include <array>
+#include <map>
 
 enum ArBasicKind {
   AR_BASIC_BOOL,
@@ -1685,6 +1688,53 @@ private:
   mutable FunctionDecl* m_functionDecl;
 };
 
+/// <summary>
+/// Identifies a match of call arguments against an intrinsic by the intrinsic, the
+/// object element type and the canonical argument types, which are all the match
+/// depends on when no argument is a literal.
+/// </summary>
+class IntrinsicMatchKey
+{
+public:
+  IntrinsicMatchKey(const HLSL_INTRINSIC* intrinsic, QualType objectElement, _In_count_(argCount) const QualType* args, size_t argCount)
+    : m_intrinsic(intrinsic), m_objectElement(objectElement), m_argLength(argCount)
+  {
+    DXASSERT_NOMSG(argCount <= g_MaxIntrinsicParamCount);
+    std::copy(args, args + argCount, m_args);
+  }
+
+  bool operator<(const IntrinsicMatchKey& other) const
+  {
+    if (m_intrinsic != other.m_intrinsic)
+      return std::less<const HLSL_INTRINSIC*>()(m_intrinsic, other.m_intrinsic);
+    if (m_objectElement != other.m_objectElement)
+      return std::less<void*>()(m_objectElement.getAsOpaquePtr(), other.m_objectElement.getAsOpaquePtr());
+    if (m_argLength != other.m_argLength)
+      return m_argLength < other.m_argLength;
+    for (size_t i = 0; i < m_argLength; i++) {
+      if (m_args[i] != other.m_args[i])
+        return std::less<void*>()(m_args[i].getAsOpaquePtr(), other.m_args[i].getAsOpaquePtr());
+    }
+    return false;
+  }
+
+private:
+  const HLSL_INTRINSIC* m_intrinsic;
+  QualType m_objectElement;
+  QualType m_args[g_MaxIntrinsicParamCount];
+  size_t m_argLength;
+};
+
+/// <summary>Outcome of matching arguments against an intrinsic, failed matches included.</summary>
+struct IntrinsicMatchResult
+{
+  bool matched;
+  size_t argCount;
+  QualType argTypes[g_MaxIntrinsicParamCount + 1];
+};
+
+typedef std::map<IntrinsicMatchKey, IntrinsicMatchResult> IntrinsicMatchStore;
+
 template <typename T>
 inline void AssignOpt(T value, _Out_opt_ T* ptr)
 {
@@ -2071,23 +2121,37 @@ private:
   StringRef _typeName;
   StringRef _functionName;
   llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2>& _tables;
+  // IDxcIntrinsicTable2 of each table, or null if it only takes wide names.
+  llvm::SmallVector<CComPtr<IDxcIntrinsicTable2>, 2>& _tablesUtf8;
+  std::wstring _wideTypeName;
+  std::wstring _wideFunctionName;
   const HLSL_INTRINSIC* _tableIntrinsic;
   UINT64 _tableLookupCookie;
   unsigned _tableIndex;
   unsigned _argCount;
   bool _firstChecked;
+  bool _wideNamesConverted;
 
   IntrinsicTableDefIter(
     llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2>& tables,
+    llvm::SmallVector<CComPtr<IDxcIntrinsicTable2>, 2>& tablesUtf8,
     StringRef typeName,
     StringRef functionName,
     unsigned argCount) :
     _typeName(typeName), _functionName(functionName), _tables(tables),
-    _tableIntrinsic(nullptr), _tableLookupCookie(0), _tableIndex(0),
-    _argCount(argCount), _firstChecked(false)
+    _tablesUtf8(tablesUtf8), _tableIntrinsic(nullptr), _tableLookupCookie(0),
+    _tableIndex(0), _argCount(argCount), _firstChecked(false),
+    _wideNamesConverted(false)
   {
   }
 
+  // Names come from identifiers and static tables, which are null-terminated.
+  static LPCSTR GetTerminatedName(StringRef name) {
+    DXASSERT(name.data() == nullptr || name.data()[name.size()] == '\0',
+             "otherwise name is not null-terminated");
+    return name.data() ? name.data() : "";
+  }
+
   void CheckForIntrinsic() {
     if (_tableIndex >= _tables.size()) {
       return;
@@ -2095,12 +2159,23 @@ private:
 
     _firstChecked = true;
 
-    // TODO: review this - this will allocate at least once per string
-    CA2WEX<> typeName(_typeName.str().c_str(), CP_UTF8);
-    CA2WEX<> functionName(_functionName.str().c_str(), CP_UTF8);
-
-    if (FAILED(_tables[_tableIndex]->LookupIntrinsic(
-            typeName, functionName, &_tableIntrinsic, &_tableLookupCookie))) {
+    HRESULT hr;
+    if (_tablesUtf8[_tableIndex] != nullptr) {
+      hr = _tablesUtf8[_tableIndex]->LookupIntrinsicUtf8(
+          GetTerminatedName(_typeName), GetTerminatedName(_functionName),
+          &_tableIntrinsic, &_tableLookupCookie);
+    } else {
+      // Convert once for all the probes of this iterator.
+      if (!_wideNamesConverted) {
+        _wideTypeName = CA2WEX<>(GetTerminatedName(_typeName), CP_UTF8);
+        _wideFunctionName = CA2WEX<>(GetTerminatedName(_functionName), CP_UTF8);
+        _wideNamesConverted = true;
+      }
+      hr = _tables[_tableIndex]->LookupIntrinsic(
+          _wideTypeName.c_str(), _wideFunctionName.c_str(), &_tableIntrinsic,
+          &_tableLookupCookie);
+    }
+    if (FAILED(hr)) {
       _tableLookupCookie = 0;
       _tableIntrinsic = nullptr;
     }
@@ -2124,17 +2199,19 @@ private:
 
 public:
   static IntrinsicTableDefIter CreateStart(llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2>& tables,
+    llvm::SmallVector<CComPtr<IDxcIntrinsicTable2>, 2>& tablesUtf8,
     StringRef typeName,
     StringRef functionName,
     unsigned argCount)
   {
-    IntrinsicTableDefIter result(tables, typeName, functionName, argCount);
+    IntrinsicTableDefIter result(tables, tablesUtf8, typeName, functionName, argCount);
     return result;
   }
 
-  static IntrinsicTableDefIter CreateEnd(llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2>& tables)
+  static IntrinsicTableDefIter CreateEnd(llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2>& tables,
+    llvm::SmallVector<CComPtr<IDxcIntrinsicTable2>, 2>& tablesUtf8)
   {
-    IntrinsicTableDefIter result(tables, StringRef(), StringRef(), 0);
+    IntrinsicTableDefIter result(tables, tablesUtf8, StringRef(), StringRef(), 0);
     result._tableIndex = tables.size();
     return result;
   }
@@ -2240,6 +2317,58 @@ public:
   }
 };
 
+/// <summary>
+/// Process-wide index of the built-in intrinsic tables, from table, name and
+/// argument count to the first of the contiguous intrinsics that share them.
+/// </summary>
+class IntrinsicGroupIndex
+{
+  typedef std::pair<std::pair<const HLSL_INTRINSIC*, unsigned>, StringRef> GroupKey;
+  llvm::DenseMap<GroupKey, const HLSL_INTRINSIC*> _groups;
+  llvm::SmallPtrSet<const HLSL_INTRINSIC*, 64> _tables;
+
+  void AddTable(const HLSL_INTRINSIC* table, size_t count)
+  {
+    if (table == nullptr || !_tables.insert(table).second)
+      return;
+    for (size_t i = 0; i < count; i++) {
+      // Only the first group of a name and count is reachable, as with a scan.
+      GroupKey key(std::make_pair(table, table[i].uNumArgs), StringRef(table[i].pArgs[0].pName));
+      _groups.insert(std::make_pair(key, &table[i]));
+    }
+  }
+
+  IntrinsicGroupIndex()
+  {
+    AddTable(g_Intrinsics, _countof(g_Intrinsics));
+    for (int i = 0; i < _countof(g_ArBasicKindsAsTypes); i++) {
+      const HLSL_INTRINSIC* intrinsics;
+      size_t intrinsicCount;
+      GetIntrinsicMethods(g_ArBasicKindsAsTypes[i], &intrinsics, &intrinsicCount);
+      AddTable(intrinsics, intrinsicCount);
+    }
+  }
+
+public:
+  static const IntrinsicGroupIndex& Get()
+  {
+    static const IntrinsicGroupIndex index;
+    return index;
+  }
+
+  bool HasTable(const HLSL_INTRINSIC* table) const
+  {
+    return _tables.count(table) != 0;
+  }
+
+  // Returns the first intrinsic of the group, or nullptr if there is none.
+  const HLSL_INTRINSIC* Find(const HLSL_INTRINSIC* table, StringRef name, size_t argumentCount) const
+  {
+    auto it = _groups.find(GroupKey(std::make_pair(table, (unsigned)(1 + argumentCount)), name));
+    return it == _groups.end() ? nullptr : it->second;
+  }
+};
+
 static void AddHLSLSubscriptAttr(Decl *D, ASTContext &context, HLSubscriptOpcode opcode) {
   StringRef group = GetHLOpcodeGroupName(HLOpcodeGroup::HLSubscript);
   D->addAttr(HLSLIntrinsicAttr::CreateImplicit(context, group, "", static_cast<unsigned>(opcode)));
@@ -2406,6 +2535,8 @@ private:
 
   // Intrinsic tables available externally.
   llvm::SmallVector<CComPtr<IDxcIntrinsicTable>, 2> m_intrinsicTables;
+  // UTF-8 lookup interface of each external table, where implemented.
+  llvm::SmallVector<CComPtr<IDxcIntrinsicTable2>, 2> m_intrinsicTablesUtf8;
 
   // Scalar types indexed by HLSLScalarType.
   QualType m_scalarTypes[HLSLScalarTypeCount];
@@ -2420,6 +2551,10 @@ private:
   QualType m_vectorTypes[HLSLScalarTypeCount][4];
   TypedefDecl* m_vectorTypedefs[HLSLScalarTypeCount][4];
 
+  // Canonical types of built-in template specializations already checked,
+  // keyed by the template and its argument list (see GetTemplateSpecializationKey).
+  llvm::StringMap<QualType> m_templateSpecializations;
+
   // Built-in object types declarations, indexed by basic kind constant.
   CXXRecordDecl* m_objectTypeDecls[_countof(g_ArBasicKindsAsTypes)];
   // Map from object decl to the object index.
@@ -2429,6 +2564,9 @@ private:
   uint64_t m_objectTypeLazyInitMask;
 
   UsedIntrinsicStore m_usedIntrinsics;
+  // Argument matches already computed, so repeated calls with the same
+  // argument types skip the matching work.
+  IntrinsicMatchStore m_intrinsicMatches;
 
   /// <summary>Adds all supporting declarations to reference scalar types.</summary>
   void AddHLSLScalarTypes();
@@ -2585,6 +2723,7 @@ private:
       hlsl::CreateFunctionTemplateDecl(
         *m_context, recordDecl, functionDecl, templateParamNamedDecls, templateParamNamedDeclsCount);
     }
+    AddPhaseCount("BuiltinMethodTemplates", 1);
   }
 
   // Checks whether the two specified intrinsics generate equivalent templates.
@@ -2933,6 +3072,8 @@ public:
     memset(m_matrixShorthandTypes, 0, sizeof(m_matrixShorthandTypes));
     memset(m_vectorTypes, 0, sizeof(m_vectorTypes));
     memset(m_vectorTypedefs, 0, sizeof(m_vectorTypedefs));
+    memset(m_objectTypeDecls, 0, sizeof(m_objectTypeDecls));
+    m_objectTypeLazyInitMask = 0;
   }
 
   ~HLSLExternalSource() { }
@@ -2950,14 +3091,15 @@ public:
 
   void InitializeSema(Sema& S) override
   {
+    hlsl::PhaseSpan initializeSpan("InitializeHLSLSource");
     m_sema = &S;
     S.addExternalSource(this);
 
+    // Object methods, including those of extension tables, are added when
+    // each object kind is first looked into; see
+    // AddHLSLObjectMethodsIfNotReady.
     AddObjectTypes();
     AddStdIsEqualImplementation(S.getASTContext(), S);
-    for (auto && intrinsic : m_intrinsicTables) {
-      AddIntrinsicTableMethods(intrinsic);
-    }
   }
 
   void ForgetSema() override
@@ -2989,6 +3131,73 @@ public:
     return qt;
   }
 
+  /// <summary>Builds the key under which a built-in template specialization is cached.</summary>
+  /// <returns>false if the template is user-defined or an argument cannot be keyed.</returns>
+  bool GetTemplateSpecializationKey(_In_ TemplateDecl *Template,
+                                    const TemplateArgumentListInfo &TemplateArgList,
+                                    SmallVectorImpl<uint64_t> &key)
+  {
+    if (!Template->isImplicit() || !isa<ClassTemplateDecl>(Template)) {
+      return false;
+    }
+
+    key.push_back((uintptr_t)Template->getCanonicalDecl());
+    for (unsigned int i = 0; i < TemplateArgList.size(); i++) {
+      const TemplateArgument &arg = TemplateArgList[i].getArgument();
+      llvm::APSInt value;
+      switch (arg.getKind()) {
+      case TemplateArgument::ArgKind::Type: {
+        QualType argType = arg.getAsType();
+        if (argType.isNull() || argType->isDependentType()) {
+          return false;
+        }
+        key.push_back(TemplateArgument::ArgKind::Type);
+        key.push_back((uintptr_t)argType.getCanonicalType().getAsOpaquePtr());
+        continue;
+      }
+      case TemplateArgument::ArgKind::Expression: {
+        Expr *expr = arg.getAsExpr();
+        if (expr == nullptr || expr->isValueDependent() ||
+            !expr->isIntegerConstantExpr(value, *m_context)) {
+          return false;
+        }
+        break;
+      }
+      case TemplateArgument::ArgKind::Integral:
+        value = arg.getAsIntegral();
+        break;
+      default:
+        return false;
+      }
+
+      if (value.getMinSignedBits() > 64) {
+        return false;
+      }
+      key.push_back(TemplateArgument::ArgKind::Integral);
+      key.push_back((uint64_t)value.getSExtValue());
+    }
+    return true;
+  }
+
+  /// <summary>Looks up the canonical type of an already-checked built-in template specialization.</summary>
+  QualType LookupTemplateSpecialization(const SmallVectorImpl<uint64_t> &key)
+  {
+    auto found = m_templateSpecializations.find(GetTemplateSpecializationKeyName(key));
+    return found == m_templateSpecializations.end() ? QualType() : found->second;
+  }
+
+  /// <summary>Records the canonical type of a checked built-in template specialization.</summary>
+  void AddTemplateSpecialization(const SmallVectorImpl<uint64_t> &key, QualType canonType)
+  {
+    m_templateSpecializations[GetTemplateSpecializationKeyName(key)] = canonType;
+  }
+
+  static StringRef GetTemplateSpecializationKeyName(const SmallVectorImpl<uint64_t> &key)
+  {
+    return StringRef(reinterpret_cast<const char *>(key.data()),
+                     key.size() * sizeof(uint64_t));
+  }
+
   bool LookupUnqualified(LookupResult &R, Scope *S) override
   {
     const DeclarationNameInfo declName = R.getLookupNameInfo();
@@ -3241,45 +3450,71 @@ public:
     return AR_BASIC_UNKNOWN;
   }
 
-  void AddIntrinsicTableMethods(_In_ IDxcIntrinsicTable *table) {
+  // Gets the wide-character name of the object type at the given index of
+  // g_ArBasicKindsAsTypes. The names only depend on static tables, so they are
+  // converted once per process rather than on every compilation.
+  static LPCWSTR GetWideObjectTypeName(int index) {
+    static const std::array<std::wstring, _countof(g_ArBasicKindsAsTypes)> names = [] {
+      std::array<std::wstring, _countof(g_ArBasicKindsAsTypes)> result;
+      for (int i = 0; i < _countof(g_ArBasicKindsAsTypes); i++) {
+        result[i] = std::wstring(CA2W(g_ArBasicTypeNames[g_ArBasicKindsAsTypes[i]]));
+      }
+      return result;
+    }();
+    return names[index].c_str();
+  }
+
+  // Adds the methods a table provides for the object kind at index, which
+  // must have been created by AddObjectTypes.
+  void AddIntrinsicTableMethods(_In_ IDxcIntrinsicTable *table, int index) {
     DXASSERT_NOMSG(table != nullptr);
+    uint8_t templateArgCount = g_ArBasicKindsTemplateCount[index];
+    DXASSERT(0 <= templateArgCount && templateArgCount <= 2,
+      "otherwise a new case has been added");
+    int startDepth = (templateArgCount == 0) ? 0 : 1;
+    CXXRecordDecl *recordDecl = m_objectTypeDecls[index];
+    DXASSERT_NOMSG(recordDecl != nullptr);
 
-    // Function intrinsics are added on-demand, objects get template methods.
-    for (int i = 0; i < _countof(g_ArBasicKindsAsTypes); i++) {
-      // Grab information already processed by AddObjectTypes.
-      ArBasicKind kind = g_ArBasicKindsAsTypes[i];
-      const char *typeName = g_ArBasicTypeNames[kind];
-      uint8_t templateArgCount = g_ArBasicKindsTemplateCount[i];
-      DXASSERT(0 <= templateArgCount && templateArgCount <= 2,
-        "otherwise a new case has been added");
-      int startDepth = (templateArgCount == 0) ? 0 : 1;
-      CXXRecordDecl *recordDecl = m_objectTypeDecls[i];
-      if (recordDecl == nullptr) {
-        DXASSERT(kind == AR_OBJECT_WAVE, "else objects other than reserved not initialized");
-        continue;
+    // This is a variation of AddObjectMethods using the new table.
+    const HLSL_INTRINSIC *pIntrinsic = nullptr;
+    const HLSL_INTRINSIC *pPrior = nullptr;
+    UINT64 lookupCookie = 0;
+    LPCWSTR wideTypeName = GetWideObjectTypeName(index);
+    HRESULT found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic, &lookupCookie);
+    while (pIntrinsic != nullptr && SUCCEEDED(found)) {
+      if (!AreIntrinsicTemplatesEquivalent(pIntrinsic, pPrior)) {
+        AddObjectIntrinsicTemplate(recordDecl, startDepth, pIntrinsic);
+        // NOTE: this only works with the current implementation because
+        // intrinsics are alive as long as the table is alive.
+        pPrior = pIntrinsic;
       }
+      found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic, &lookupCookie);
+    }
+  }
 
-      // This is a variation of AddObjectMethods using the new table.
-      const HLSL_INTRINSIC *pIntrinsic = nullptr;
-      const HLSL_INTRINSIC *pPrior = nullptr;
-      UINT64 lookupCookie = 0;
-      CA2W wideTypeName(typeName);
-      HRESULT found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic, &lookupCookie);
-      while (pIntrinsic != nullptr && SUCCEEDED(found)) {
-        if (!AreIntrinsicTemplatesEquivalent(pIntrinsic, pPrior)) {
-          AddObjectIntrinsicTemplate(recordDecl, startDepth, pIntrinsic);
-          // NOTE: this only works with the current implementation because
-          // intrinsics are alive as long as the table is alive.
-          pPrior = pIntrinsic;
-        }
-        found = table->LookupIntrinsic(wideTypeName, L"*", &pIntrinsic, &lookupCookie);
+  // Function intrinsics are added on-demand, objects get template methods
+  // when their kind is first looked into; only kinds that are already
+  // materialized need the table's methods now.
+  void AddIntrinsicTableMethods(_In_ IDxcIntrinsicTable *table) {
+    DXASSERT_NOMSG(table != nullptr);
+    for (int i = 0; i < _countof(g_ArBasicKindsAsTypes); i++) {
+      if (m_objectTypeDecls[i] == nullptr) {
+        DXASSERT(g_ArBasicKindsAsTypes[i] == AR_OBJECT_WAVE,
+                 "else objects other than reserved not initialized");
+        continue;
       }
+      if ((m_objectTypeLazyInitMask & (((uint64_t)1) << i)) == 0)
+        AddIntrinsicTableMethods(table, i);
     }
   }
 
   void RegisterIntrinsicTable(_In_ IDxcIntrinsicTable *table) {
     DXASSERT_NOMSG(table != nullptr);
     m_intrinsicTables.push_back(table);
+    // The UTF-8 interface is optional; tableUtf8 stays null without it.
+    CComPtr<IDxcIntrinsicTable2> tableUtf8;
+    table->QueryInterface(&tableUtf8);
+    m_intrinsicTablesUtf8.push_back(tableUtf8);
     // If already initialized, add methods immediately.
     if (m_sema != nullptr) {
       AddIntrinsicTableMethods(table);
@@ -3492,6 +3727,14 @@ public:
     _Out_writes_(g_MaxIntrinsicParamCount + 1) QualType(&argTypes)[g_MaxIntrinsicParamCount + 1],
     _Out_range_(0, g_MaxIntrinsicParamCount + 1) size_t* argCount);
 
+  /// <summary>Performs the work of MatchArguments, which caches its results.</summary>
+  bool MatchArgumentsUncached(
+    _In_ const HLSL_INTRINSIC *pIntrinsic,
+    _In_ QualType objectElement,
+    _In_ ArrayRef<Expr *> Args,
+    _Out_writes_(g_MaxIntrinsicParamCount + 1) QualType(&argTypes)[g_MaxIntrinsicParamCount + 1],
+    _Out_range_(0, g_MaxIntrinsicParamCount + 1) size_t* argCount);
+
   /// <summary>Validate object element on intrinsic to catch case like integer on Sample.</summary>
   /// <param name="pIntrinsic">Intrinsic function to validate.</param>
   /// <param name="objectElement">Type element on the class intrinsic belongs to; possibly null (eg, 'float' in 'Texture2D<float>').</param>
@@ -3506,7 +3749,13 @@ public:
     StringRef nameIdentifier,
     size_t argumentCount)
   {
-    // TODO: avoid linear scan
+    const IntrinsicGroupIndex& index = IntrinsicGroupIndex::Get();
+    if (index.HasTable(table)) {
+      const HLSL_INTRINSIC* pIntrinsic = index.Find(table, nameIdentifier, argumentCount);
+      return IntrinsicDefIter::CreateStart(table, tableSize, pIntrinsic ? pIntrinsic : table + tableSize,
+        IntrinsicTableDefIter::CreateStart(m_intrinsicTables, m_intrinsicTablesUtf8, typeName, nameIdentifier, argumentCount));
+    }
+
     for (unsigned int i = 0; i < tableSize; i++) {
       const HLSL_INTRINSIC* pIntrinsic = &table[i];
 
@@ -3519,11 +3768,11 @@ public:
       }
 
       return IntrinsicDefIter::CreateStart(table, tableSize, pIntrinsic,
-        IntrinsicTableDefIter::CreateStart(m_intrinsicTables, typeName, nameIdentifier, argumentCount));
+        IntrinsicTableDefIter::CreateStart(m_intrinsicTables, m_intrinsicTablesUtf8, typeName, nameIdentifier, argumentCount));
     }
 
     return IntrinsicDefIter::CreateStart(table, tableSize, table + tableSize,
-      IntrinsicTableDefIter::CreateStart(m_intrinsicTables, typeName, nameIdentifier, argumentCount));
+      IntrinsicTableDefIter::CreateStart(m_intrinsicTables, m_intrinsicTablesUtf8, typeName, nameIdentifier, argumentCount));
   }
 
   bool AddOverloadedCallCandidates(
@@ -3546,7 +3795,7 @@ public:
     IntrinsicDefIter cursor = FindIntrinsicByNameAndArgCount(
       g_Intrinsics, _countof(g_Intrinsics), StringRef(), nameIdentifier, Args.size());
     IntrinsicDefIter end = IntrinsicDefIter::CreateEnd(
-      g_Intrinsics, _countof(g_Intrinsics), IntrinsicTableDefIter::CreateEnd(m_intrinsicTables));
+      g_Intrinsics, _countof(g_Intrinsics), IntrinsicTableDefIter::CreateEnd(m_intrinsicTables, m_intrinsicTablesUtf8));
     while (cursor != end)
     {
       // If this is the intrinsic we're interested in, build up a representation
@@ -3575,6 +3824,7 @@ public:
         DXASSERT(tableName, "otherwise IDxcIntrinsicTable::GetTableName() failed");
         intrinsicFuncDecl = AddHLSLIntrinsicFunction(*m_context, m_hlslNSDecl, tableName, lowering, pIntrinsic, functionArgTypes, functionArgTypeCount);
         insertResult.first->setFunctionDecl(intrinsicFuncDecl);
+        AddPhaseCount("BuiltinFunctions", 1);
       }
       else
       {
@@ -4061,6 +4311,10 @@ public:
     AddObjectMethods(kind, recordDecl, startDepth);
     // Clear the object.
     m_objectTypeLazyInitMask &= ~bit;
+    for (auto && intrinsic : m_intrinsicTables) {
+      AddIntrinsicTableMethods(intrinsic, idx);
+    }
+    AddPhaseCount("BuiltinObjectTypes", 1);
   }
 
   FunctionDecl* AddHLSLIntrinsicMethod(
@@ -4090,6 +4344,7 @@ public:
     if (SpecFunc != nullptr) {
       return SpecFunc;
     }
+    AddPhaseCount("BuiltinMethods", 1);
 
     // Change return type to rvalue reference type for aggregate types
     QualType retTy = parameterTypes[0];
@@ -4670,6 +4925,48 @@ bool HLSLExternalSource::MatchArguments(
   DXASSERT_NOMSG(pIntrinsic != nullptr);
   DXASSERT_NOMSG(argCount != nullptr);
 
+  // Literal arguments are typed from their values, so only matches without
+  // them are a function of the argument types alone.
+  if (Args.size() > g_MaxIntrinsicParamCount) {
+    return MatchArgumentsUncached(pIntrinsic, objectElement, Args, argTypes, argCount);
+  }
+  QualType canonicalArgs[g_MaxIntrinsicParamCount];
+  for (size_t i = 0; i < Args.size(); i++) {
+    QualType argType = Args[i]->getType();
+    ArBasicKind eltKind = GetTypeElementKind(argType);
+    if (eltKind == AR_BASIC_LITERAL_INT || eltKind == AR_BASIC_LITERAL_FLOAT) {
+      return MatchArgumentsUncached(pIntrinsic, objectElement, Args, argTypes, argCount);
+    }
+    canonicalArgs[i] = argType.getCanonicalType();
+  }
+  QualType canonicalObjectElement =
+    objectElement.isNull() ? objectElement : objectElement.getCanonicalType();
+
+  IntrinsicMatchKey key(pIntrinsic, canonicalObjectElement, canonicalArgs, Args.size());
+  IntrinsicMatchStore::iterator found = m_intrinsicMatches.find(key);
+  if (found == m_intrinsicMatches.end()) {
+    IntrinsicMatchResult result;
+    result.matched = MatchArgumentsUncached(pIntrinsic, objectElement, Args, result.argTypes, &result.argCount);
+    found = m_intrinsicMatches.insert(std::make_pair(key, result)).first;
+  }
+
+  const IntrinsicMatchResult& result = found->second;
+  std::copy(result.argTypes, result.argTypes + _countof(result.argTypes), argTypes);
+  *argCount = result.argCount;
+  return result.matched;
+}
+
+_Use_decl_annotations_
+bool HLSLExternalSource::MatchArgumentsUncached(
+  const HLSL_INTRINSIC* pIntrinsic,
+  QualType objectElement,
+  ArrayRef<Expr *> Args,
+  QualType(&argTypes)[g_MaxIntrinsicParamCount + 1],
+  size_t* argCount)
+{
+  DXASSERT_NOMSG(pIntrinsic != nullptr);
+  DXASSERT_NOMSG(argCount != nullptr);
+
   static const UINT UnusedSize = 0xFF;
   static const BYTE MaxIntrinsicArgs = g_MaxIntrinsicParamCount + 1;
 #define CAB(_) { if (!(_)) return false; }
@@ -8178,7 +8475,7 @@ Sema::TemplateDeductionResult HLSLExternalSource::DeduceTemplateArgumentsForHLSL
   QualType argTypes[g_MaxIntrinsicParamCount + 1];
   StringRef nameIdentifier = FunctionTemplate->getName();
   IntrinsicDefIter cursor = FindIntrinsicByNameAndArgCount(intrinsics, intrinsicCount, objectName, nameIdentifier, Args.size());
-  IntrinsicDefIter end = IntrinsicDefIter::CreateEnd(intrinsics, intrinsicCount, IntrinsicTableDefIter::CreateEnd(m_intrinsicTables));
+  IntrinsicDefIter end = IntrinsicDefIter::CreateEnd(intrinsics, intrinsicCount, IntrinsicTableDefIter::CreateEnd(m_intrinsicTables, m_intrinsicTablesUtf8));
 
   while (cursor != end)
   {
@@ -8560,6 +8857,41 @@ void hlsl::CheckBinOpForHLSL(Sema& self,
   return hlsl->CheckBinOpForHLSL(OpLoc, Opc, LHS, RHS, ResultTy, CompLHSTy, CompResultTy);
 }
 
+/// <summary>Looks up the canonical type of a built-in template specialization checked earlier.</summary>
+/// <returns>A null type if the specialization is not cached; key is filled in if it can be cached.</returns>
+QualType hlsl::LookupTemplateSpecializationForHLSL(Sema& self, TemplateDecl* Template, const TemplateArgumentListInfo& TemplateArgList, SmallVectorImpl<uint64_t>& key)
+{
+  DXASSERT_NOMSG(Template != nullptr);
+  key.clear();
+
+  ExternalSemaSource* externalSource = self.getExternalSource();
+  if (externalSource == nullptr) {
+    return QualType();
+  }
+
+  HLSLExternalSource* hlsl = reinterpret_cast<HLSLExternalSource*>(externalSource);
+  if (!hlsl->GetTemplateSpecializationKey(Template, TemplateArgList, key)) {
+    key.clear();
+    return QualType();
+  }
+
+  return hlsl->LookupTemplateSpecialization(key);
+}
+
+/// <summary>Records the canonical type of a checked built-in template specialization.</summary>
+void hlsl::AddTemplateSpecializationForHLSL(Sema& self, const SmallVectorImpl<uint64_t>& key, QualType CanonType)
+{
+  DXASSERT_NOMSG(!key.empty());
+
+  ExternalSemaSource* externalSource = self.getExternalSource();
+  if (externalSource == nullptr) {
+    return;
+  }
+
+  HLSLExternalSource* hlsl = reinterpret_cast<HLSLExternalSource*>(externalSource);
+  hlsl->AddTemplateSpecialization(key, CanonType);
+}
+
 /// <summary>Performs HLSL-specific processing of template declarations.</summary>
 bool hlsl::CheckTemplateArgumentListForHLSL(Sema& self, TemplateDecl* Template, SourceLocation TemplateLoc, TemplateArgumentListInfo& TemplateArgList)
 {
@@ -9075,6 +9407,7 @@ clang::ImplicitConversionSequence hlsl::TrySubscriptIndexInitialization(
 /// <summary>Performs HLSL-specific initialization on the specified context.</summary>
 void hlsl::InitializeASTContextForHLSL(ASTContext& context)
 {
+  hlsl::PhaseSpan initializeSpan("InitializeHLSLSource");
   HLSLExternalSource* hlslSource = new HLSLExternalSource();
   IntrusiveRefCntPtr<ExternalASTSource> externalSource(hlslSource);
   if (hlslSource->Initialize(context)) {
@@ -9804,6 +10137,15 @@ static void ValidateAttributeOnSwitchOrIf(Sema& S, Stmt* St, const AttributeList
   }
 }
 
+static void ValidateAttributeOnBlock(Sema& S, Stmt* St, const AttributeList &Attr)
+{
+  if (St->getStmtClass() != Stmt::CompoundStmtClass)
+  {
+    S.Diag(Attr.getLoc(), diag::warn_hlsl_unsupported_statement_for_block_attribute)
+      << Attr.getName();
+  }
+}
+
 static StringRef ValidateAttributeStringArg(Sema& S, const AttributeList &A, _In_opt_z_ const char* values)
 {
   // values is an optional comma-separated list of potential values.
@@ -9978,6 +10320,38 @@ void hlsl::HandleDeclAttributeForHLSL(Sema &S, Decl *D, const AttributeList &A,
     declAttr = ::new (S.Context) HLSLGloballyCoherentAttr(
         A.getRange(), S.Context, A.getAttributeSpellingListIndex());
     break;
+  case AttributeList::AT_HLSLAffine: {
+    // Matrix lowering takes the last row to be 0, 0, 0, 1, which is only
+    // meaningful for 4x4 floating-point matrices.
+    ValueDecl *VD = dyn_cast<ValueDecl>(D);
+    QualType Ty = VD ? S.Context.getBaseElementType(VD->getType()) : QualType();
+    unsigned rowCount = 0, colCount = 0;
+    if (!Ty.isNull() && IsHLSLMatType(Ty))
+      GetHLSLMatRowColCount(Ty, rowCount, colCount);
+    if (rowCount != 4 || colCount != 4 ||
+        !GetHLSLMatElementType(Ty)->isFloatingType()) {
+      S.Diag(A.getLoc(), diag::err_hlsl_affine_not_float4x4);
+      return;
+    }
+    declAttr = ::new (S.Context) HLSLAffineAttr(
+        A.getRange(), S.Context, A.getAttributeSpellingListIndex());
+    break;
+  }
+  case AttributeList::AT_HLSLLinkConstant: {
+    // The value is supplied when linking, so it must be a scalar that no
+    // code can write.
+    VarDecl *VD = dyn_cast<VarDecl>(D);
+    if (!VD || !VD->hasGlobalStorage() || VD->isStaticLocal() ||
+        VD->getStorageClass() != SC_Static ||
+        !VD->getType().isConstQualified() ||
+        !VD->getType()->isArithmeticType()) {
+      S.Diag(A.getLoc(), diag::err_hlsl_linkconstant_not_static_const_scalar);
+      return;
+    }
+    declAttr = ::new (S.Context) HLSLLinkConstantAttr(
+        A.getRange(), S.Context, A.getAttributeSpellingListIndex());
+    break;
+  }
 
   default:
     Handled = false;
@@ -10058,6 +10432,10 @@ void hlsl::HandleDeclAttributeForHLSL(Sema &S, Decl *D, const AttributeList &A,
     declAttr = ::new (S.Context) HLSLPatchConstantFuncAttr(A.getRange(), S.Context,
       ValidateAttributeStringArg(S, A, nullptr), A.getAttributeSpellingListIndex());
     break;
+  case AttributeList::AT_HLSLProfile:
+    declAttr = ::new (S.Context) HLSLProfileAttr(A.getRange(), S.Context,
+      ValidateAttributeStringArg(S, A, nullptr), A.getAttributeSpellingListIndex());
+    break;
   case AttributeList::AT_HLSLShader:
     declAttr = ::new (S.Context) HLSLShaderAttr(
         A.getRange(), S.Context,
@@ -10099,6 +10477,7 @@ Attr *hlsl::ProcessStmtAttributeForHLSL(Sema &S, Stmt *St, const AttributeList &
   // | for, while, do   | loop, fastopt, unroll, allow_uav_condition |
   // | if               | branch, flatten                            |
   // | switch           | branch, flatten, forcecase, call           |
+  // | { ... }          | profile                                    |
 
   Attr * result = nullptr;
   Handled = true;
@@ -10144,6 +10523,12 @@ Attr *hlsl::ProcessStmtAttributeForHLSL(Sema &S, Stmt *St, const AttributeList &
     result = ::new (S.Context) HLSLCallAttr(
       A.getRange(), S.Context, A.getAttributeSpellingListIndex());
     break;
+  case AttributeList::AT_HLSLProfile:
+    ValidateAttributeOnBlock(S, St, A);
+    result = ::new (S.Context) HLSLProfileAttr(
+      A.getRange(), S.Context, ValidateAttributeStringArg(S, A, nullptr),
+      A.getAttributeSpellingListIndex());
+    break;
   default:
     Handled = false;
     break;
@@ -10277,6 +10662,40 @@ void Sema::ActOnStartHLSLBufferView() {
   HLSLBuffers.emplace_back(nullptr);
 }
 
+bool Sema::CanDeferHLSLFunctionBody(FunctionDecl *FD) {
+  DXASSERT_NOMSG(getLangOpts().HLSLLazyFunctionBodies);
+  // Every function of a library is compiled.
+  if (getLangOpts().IsHLSLLibrary || FD->isInvalidDecl())
+    return false;
+  // The entry point is needed regardless, and a patch constant function is
+  // named by an attribute of the entry point rather than called, so it may
+  // never be used.
+  if (FD->getIdentifier() &&
+      FD->getName() == getLangOpts().HLSLEntryFunction)
+    return false;
+  if (Context.IsPatchConstantFunctionDecl(FD))
+    return false;
+  // A function used through an earlier declaration needs its body anyway.
+  return !FD->isUsed(/*CheckUsedAttr*/ false);
+}
+
+void Sema::ParseUsedLazyHLSLFunctionBodies() {
+  if (!LateTemplateParser)
+    return;
+  while (!UsedLazyHLSLFunctions.empty()) {
+    FunctionDecl *FD = UsedLazyHLSLFunctions.pop_back_val();
+    // The function may have been used through a declaration other than its
+    // definition.
+    for (FunctionDecl *Redecl : FD->redecls()) {
+      if (!Redecl->isLateTemplateParsed())
+        continue;
+      if (LateParsedTemplate *LPT = LateParsedTemplateMap.lookup(Redecl))
+        LateTemplateParser(OpaqueParser, *LPT);
+      break;
+    }
+  }
+}
+
 HLSLBufferDecl::HLSLBufferDecl(
     DeclContext *DC, bool cbuffer, bool cbufferView, SourceLocation KwLoc,
     IdentifierInfo *Id, SourceLocation IdLoc,
@@ -11064,6 +11483,25 @@ void hlsl::CustomPrintHLSLAttr(const clang::Attr *A, llvm::raw_ostream &Out, con
     break;
   }
 
+  case clang::attr::HLSLProfile:
+  {
+    Attr * noconst = const_cast<Attr*>(A);
+    HLSLProfileAttr *ACast = static_cast<HLSLProfileAttr*>(noconst);
+    Indent(Indentation, Out);
+    Out << "[profile(\"" << ACast->getName() << "\")]\n";
+    break;
+  }
+
+  case clang::attr::HLSLAffine:
+    Indent(Indentation, Out);
+    Out << "[affine]\n";
+    break;
+
+  case clang::attr::HLSLLinkConstant:
+    Indent(Indentation, Out);
+    Out << "[linkconstant]\n";
+    break;
+
   case clang::attr::HLSLShader:
   {
     Attr * noconst = const_cast<Attr*>(A);
@@ -11186,6 +11624,7 @@ void hlsl::CustomPrintHLSLAttr(const clang::Attr *A, llvm::raw_ostream &Out, con
 
 bool hlsl::IsHLSLAttr(clang::attr::Kind AttrKind) {
   switch (AttrKind){
+  case clang::attr::HLSLAffine:
   case clang::attr::HLSLAllowUAVCondition:
   case clang::attr::HLSLBranch:
   case clang::attr::HLSLCall:
@@ -11202,6 +11641,7 @@ bool hlsl::IsHLSLAttr(clang::attr::Kind AttrKind) {
   case clang::attr::HLSLInOut:
   case clang::attr::HLSLInstance:
   case clang::attr::HLSLLinear:
+  case clang::attr::HLSLLinkConstant:
   case clang::attr::HLSLLoop:
   case clang::attr::HLSLMaxTessFactor:
   case clang::attr::HLSLNoInterpolation:
@@ -11213,6 +11653,7 @@ bool hlsl::IsHLSLAttr(clang::attr::Kind AttrKind) {
   case clang::attr::HLSLOutputTopology:
   case clang::attr::HLSLPartitioning:
   case clang::attr::HLSLPatchConstantFunc:
+  case clang::attr::HLSLProfile:
   case clang::attr::HLSLMaxVertexCount:
   case clang::attr::HLSLPrecise:
   case clang::attr::HLSLRowMajor:
@@ -2051,6 +2051,19 @@ QualType Sema::CheckTemplateIdType(TemplateName Name,
     return QualType();
   }
 
+  // HLSL Change Starts - reuse built-in specializations already checked
+  SmallVector<uint64_t, 8> HLSLSpecializationKey;
+  DiagnosticErrorTrap HLSLErrorTrap(Diags);
+  unsigned HLSLNumWarnings = Diags.getNumWarnings();
+  if (getLangOpts().HLSL) {
+    QualType CachedType = hlsl::LookupTemplateSpecializationForHLSL(
+        *this, Template, TemplateArgs, HLSLSpecializationKey);
+    if (!CachedType.isNull())
+      return Context.getTemplateSpecializationType(Name, TemplateArgs,
+                                                   CachedType);
+  }
+  // HLSL Change Ends
+
   // Check that the template argument list is well-formed for this
   // template.
   SmallVector<TemplateArgument, 4> Converted;
@@ -2182,6 +2195,15 @@ QualType Sema::CheckTemplateIdType(TemplateName Name,
     CanonType = Context.getTypeDeclType(Decl);
     assert(isa<RecordType>(CanonType) &&
            "type of non-dependent specialization is not a RecordType");
+
+    // HLSL Change Starts - only cache checks that diagnosed nothing, so a
+    // cache hit never drops a warning
+    if (!HLSLSpecializationKey.empty() &&
+        !HLSLErrorTrap.hasErrorOccurred() &&
+        Diags.getNumWarnings() == HLSLNumWarnings)
+      hlsl::AddTemplateSpecializationForHLSL(*this, HLSLSpecializationKey,
+                                             CanonType);
+    // HLSL Change Ends
   }
 
   // Build the fully-sugared type for this class template
@@ -0,0 +1,28 @@
+// RUN: %dxc -E main -T cs_6_0 %s | FileCheck %s
+
+// Reads of four consecutive fields become one structured buffer load, and
+// two adjacent raw stores become one two-component store.
+
+// CHECK: call %dx.types.ResRet.f32 @dx.op.bufferLoad.f32(i32 68, %dx.types.Handle %{{.*}}, i32 %{{.*}}, i32 0)
+// CHECK-NOT: @dx.op.bufferLoad.f32(
+// CHECK: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %{{.*}}, i32 %{{.*}}, i32 undef, i32 %{{.*}}, i32 %{{.*}}, i32 undef, i32 undef, i8 3)
+// CHECK-NOT: @dx.op.bufferStore.i32(
+
+struct Bounds {
+  float a;
+  float b;
+  float c;
+  float d;
+};
+
+StructuredBuffer<Bounds> bounds;
+RWByteAddressBuffer results;
+
+[numthreads(64, 1, 1)]
+void main(uint id : SV_DispatchThreadID) {
+  float lo = bounds[id].a + bounds[id].b;
+  float hi = bounds[id].c * bounds[id].d;
+  uint addr = id * 16;
+  results.Store(addr, asuint(lo));
+  results.Store(addr + 4, asuint(hi));
+}
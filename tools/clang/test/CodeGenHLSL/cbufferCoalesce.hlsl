@@ -0,0 +1,26 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// Every field of a lives in row 0. The UAV stores between the uses keep GVN
+// from merging the loads, but the cbuffer cannot change, so one load of the
+// row is enough.
+
+// CHECK: call %dx.types.CBufRet.f32 @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %{{.*}}, i32 0)
+// CHECK-NOT: @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %{{.*}}, i32 0)
+// CHECK: ret void
+
+cbuffer CB {
+  float4 a;
+};
+
+RWBuffer<float> u;
+
+float main(uint i : I) : SV_Target {
+  float r = a.x;
+  u[i] = r;
+  if (i > 3)
+    r += a.y * 2;
+  else
+    r += a.z;
+  u[i + 1] = r;
+  return r + a.w;
+}
@@ -0,0 +1,32 @@
+// RUN: %dxc -E main -T ps_6_0 -pack_cbuffers %s | FileCheck %s
+
+// Largest first, with a and c filling the padding after f and e.
+// CHECK: cbuffer $Globals
+// CHECK: float4 b;{{ *}}; Offset: {{ *}}0
+// CHECK: float4 d;{{ *}}; Offset: {{ *}}16
+// CHECK: float3 f;{{ *}}; Offset: {{ *}}32
+// CHECK: float a;{{ *}}; Offset: {{ *}}44
+// CHECK: float2 e;{{ *}}; Offset: {{ *}}48
+// CHECK: float c;{{ *}}; Offset: {{ *}}56
+// CHECK: } $Globals;{{ *}}; Offset: {{ *}}0 Size: {{ *}}60
+
+// Left as declared because of packoffset.
+// CHECK: cbuffer Fixed
+// CHECK: float g;{{ *}}; Offset: {{ *}}0
+// CHECK: float4 h;{{ *}}; Offset: {{ *}}16
+
+float a;
+float4 b;
+float c;
+float4 d;
+float2 e;
+float3 f;
+
+cbuffer Fixed {
+  float g : packoffset(c0);
+  float4 h : packoffset(c1);
+};
+
+float4 main() : SV_Target {
+  return a + b + c + d + e.xyxy + f.xyzx + g + h;
+}
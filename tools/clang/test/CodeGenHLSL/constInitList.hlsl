@@ -0,0 +1,22 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// A local array with a constant initializer list is read from a constant
+// global; one that names a uniform still reads the constant buffer.
+
+// CHECK: constant [64 x float]
+// CHECK: @main
+// CHECK-NOT: alloca
+// CHECK: @dx.op.cbufferLoad
+// CHECK: ret void
+
+#define ROW(n) float4(n, n + 1, n + 2, n + 3)
+#define ROWS4(n) ROW(n), ROW(n + 4), ROW(n + 8), ROW(n + 12)
+
+float scale;
+uint index;
+
+float4 main() : SV_Target {
+  const float4 lut[16] = { ROWS4(0), ROWS4(16), ROWS4(32), ROWS4(48) };
+  float weights[2] = { scale, 1 };
+  return lut[index] * weights[index & 1];
+}
@@ -0,0 +1,25 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// The UAV store in the loop keeps LICM away from the texture handle, but
+// the size of the texture cannot change, so it is queried once ahead of the
+// loop and the query after the loop reuses it.
+
+// CHECK: call %dx.types.Dimensions @dx.op.getDimensions(i32 72,
+// CHECK-NOT: @dx.op.getDimensions(
+// CHECK: ret void
+
+Texture2D<float4> tex[4] : register(t0);
+RWBuffer<float4> u : register(u0);
+
+float4 main(uint idx : I, uint n : N) : SV_Target {
+  float4 r = 0;
+  for (uint j = 0; j < n; j++) {
+    uint w, h;
+    tex[idx].GetDimensions(w, h);
+    r += tex[idx].Load(int3(j % w, j / w % h, 0));
+    u[j] = r;
+  }
+  uint w, h;
+  tex[idx].GetDimensions(w, h);
+  return r + float4(w, h, 0, 0);
+}
@@ -0,0 +1,29 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// The UAV store in the loop keeps LICM and GVN away from the texture handle,
+// but its operands are loop-invariant, so it is created once ahead of the
+// loop and reused after it. The handle indexed by an input is non-uniform
+// and kept separate.
+
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 false)
+// CHECK-NOT: @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 false)
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 true)
+// CHECK-NOT: @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 false)
+// CHECK: ret void
+
+Texture2D<float4> tex[4] : register(t0);
+RWBuffer<float4> u : register(u0);
+
+cbuffer Params {
+  uint idx;
+};
+
+float4 main(uint lane : I, uint n : N) : SV_Target {
+  float4 r = 0;
+  for (uint j = 0; j < n; j++) {
+    r += tex[idx].Load(int3(j, 0, 0));
+    u[j] = r;
+  }
+  r += tex[idx].Load(int3(0, 0, 0));
+  return r + tex[NonUniformResourceIndex(lane)].Load(int3(1, 0, 0));
+}
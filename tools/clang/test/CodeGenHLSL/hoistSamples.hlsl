@@ -0,0 +1,36 @@
+// RUN: %dxc -E main -T ps_6_0 -hoist_samples %s | FileCheck %s
+
+// The first sample shows tex and samp are bound, so the explicit LOD sample
+// under the first branch is issued ahead of it. The sample there computes
+// derivatives under a divergent branch, and other is not known to be bound,
+// so both stay. The [branch] hint keeps the last sample where it is.
+
+// CHECK: call %dx.types.ResRet.f32 @dx.op.sample.f32(i32 60,
+// CHECK: call %dx.types.ResRet.f32 @dx.op.sampleLevel.f32(i32 62,
+// CHECK: br i1
+// CHECK: call %dx.types.ResRet.f32 @dx.op.sample.f32(i32 60,
+// CHECK: call %dx.types.ResRet.f32 @dx.op.sampleLevel.f32(i32 62,
+// CHECK: br i1 {{.*}}, !dx.controlflow.hints
+// CHECK: call %dx.types.ResRet.f32 @dx.op.sample.f32(i32 60,
+
+Texture2D<float4> tex : register(t0);
+Texture2D<float4> other : register(t1);
+SamplerState samp : register(s0);
+
+cbuffer Params {
+  float threshold;
+};
+
+float4 main(float2 uv : UV, float t : T) : SV_Target {
+  float4 r = tex.Sample(samp, uv);
+  if (t > 0.5) {
+    r += tex.SampleLevel(samp, uv * 2, 0);
+    r += tex.Sample(samp, uv * 3);
+    r += other.SampleLevel(samp, uv, 0);
+  }
+  [branch]
+  if (threshold > 0.5) {
+    r += tex.Sample(samp, uv * 4);
+  }
+  return r;
+}
@@ -0,0 +1,48 @@
+// RUN: %dxc -E main -T hs_6_0 %s | FileCheck %s
+
+// Components read one at a time from a 32 control point patch of wide
+// structures are each loaded once, from the right element and column.
+
+// CHECK: InputControlPointCount=32
+// CHECK-DAG: call float @dx.op.loadInput.f32(i32 4, i32 7, i32 0, i8 3, i32 %{{.*}})
+// CHECK-DAG: call float @dx.op.loadInput.f32(i32 4, i32 2, i32 0, i8 1, i32 %{{.*}})
+// CHECK-DAG: call float @dx.op.loadInput.f32(i32 4, i32 0, i32 0, i8 0, i32 31)
+// CHECK-DAG: call float @dx.op.loadInput.f32(i32 4, i32 5, i32 0, i8 2, i32 0)
+// CHECK: storePatchConstant
+
+struct VSOut {
+  float4 f0 : F0;
+  float4 f1 : F1;
+  float4 f2 : F2;
+  float4 f3 : F3;
+  float4 f4 : F4;
+  float4 f5 : F5;
+  float4 f6 : F6;
+  float4 f7 : F7;
+};
+
+struct PatchData {
+  float edges[4] : SV_TessFactor;
+  float inside[2] : SV_InsideTessFactor;
+};
+
+PatchData PatchFn(InputPatch<VSOut, 32> ip) {
+  PatchData d;
+  d.edges[0] = ip[31].f0.x;
+  d.edges[1] = ip[0].f5.z;
+  d.edges[2] = ip[0].f5.z;
+  d.edges[3] = ip[31].f0.x;
+  d.inside[0] = 1;
+  d.inside[1] = 1;
+  return d;
+}
+
+[domain("quad")]
+[partitioning("integer")]
+[outputtopology("triangle_cw")]
+[outputcontrolpoints(32)]
+[patchconstantfunc("PatchFn")]
+float4 main(InputPatch<VSOut, 32> ip, uint id : SV_OutputControlPointID)
+    : SV_Position {
+  return float4(ip[id].f7.w, ip[id].f2.y, 0, 1);
+}
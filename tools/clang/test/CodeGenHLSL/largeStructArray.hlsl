@@ -0,0 +1,56 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// Large parameter blocks and arrays of them are copied between functions and
+// read one field at a time; only the fields that are read survive.
+
+// CHECK: @main
+// CHECK-NOT: alloca %struct.Material
+// CHECK: ret void
+
+#define FIELDS4(n) float4 n##0; float4 n##1; float4 n##2; float4 n##3;
+#define FIELDS16(n) FIELDS4(n##0) FIELDS4(n##1) FIELDS4(n##2) FIELDS4(n##3)
+
+struct Material {
+  FIELDS16(a)
+  FIELDS16(b)
+  FIELDS16(c)
+  FIELDS16(d)
+  FIELDS16(e)
+  FIELDS16(f)
+  FIELDS16(g)
+  FIELDS16(h)
+};
+
+struct Light {
+  float3 position;
+  float range;
+  float3 color;
+  float intensity;
+  Material material;
+};
+
+cbuffer Lights {
+  Light g_lights[8];
+  uint g_lightCount;
+};
+
+Material PickMaterial(Light lights[8], uint i) {
+  return lights[i].material;
+}
+
+float4 Shade(Light light, Material m, float3 pos) {
+  float3 d = light.position - pos;
+  float att = saturate(1 - length(d) / light.range);
+  return float4(light.color * light.intensity * att, 1) * m.a00 + m.h33;
+}
+
+float4 main(float3 pos : POSITION) : SV_Target {
+  Light lights[8] = g_lights;
+  float4 result = 0;
+  [unroll]
+  for (uint i = 0; i < 8; ++i) {
+    Material m = PickMaterial(lights, i);
+    result += Shade(lights[i], m, pos) * (i < g_lightCount);
+  }
+  return result;
+}
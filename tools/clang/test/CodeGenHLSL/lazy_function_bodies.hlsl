@@ -0,0 +1,27 @@
+// RUN: %dxc -E main -T ps_6_0 -lazy_function_bodies %s | FileCheck %s
+
+// Only the bodies main uses are parsed, so the error in unused is never
+// reported. Functions used before their definition or from another
+// deferred body are still compiled.
+
+// CHECK: fadd
+// CHECK: fmul
+// CHECK: ret void
+
+float later(float x);
+
+float unused(float x) {
+  return x * undeclared_value;
+}
+
+float twice(float x) {
+  return later(x) * 2.0;
+}
+
+float4 main(float a : A) : SV_Target {
+  return twice(a);
+}
+
+float later(float x) {
+  return x + 1.0;
+}
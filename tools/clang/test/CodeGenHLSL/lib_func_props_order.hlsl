@@ -0,0 +1,23 @@
+// RUN: %dxc -T lib_6_1 %s | FileCheck %s
+
+// Function properties are emitted in module order rather than in the order
+// of a map keyed by address, so the output is the same from run to run.
+// CHECK: !dx.func.props
+// CHECK: @first{{[^?]*}}, i32 5, i32 1, i32 1, i32 1}
+// CHECK: @second{{[^?]*}}, i32 5, i32 2, i32 1, i32 1}
+// CHECK: @third{{[^?]*}}, i32 5, i32 3, i32 1, i32 1}
+
+[numthreads(1,1,1)]
+void first(uint gidx : SV_GroupIndex)
+{
+}
+
+[numthreads(2,1,1)]
+void second(uint gidx : SV_GroupIndex)
+{
+}
+
+[numthreads(3,1,1)]
+void third(uint gidx : SV_GroupIndex)
+{
+}
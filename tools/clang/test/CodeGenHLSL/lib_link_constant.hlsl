@@ -0,0 +1,15 @@
+// RUN: %dxc -T lib_6_1 %s | FileCheck %s
+
+// Make sure the link-time constant is left for the linker.
+// CHECK: call i32 @"dx.linkconst.kMode"(i32 0)
+// CHECK: @ps_mode(
+
+[linkconstant] static const int kMode = 0;
+
+[shader("pixel")]
+float4 ps_mode(float4 a : A) : SV_TARGET
+{
+  if (kMode == 1)
+    return a * 2;
+  return a + 1;
+}
@@ -0,0 +1,33 @@
+// RUN: %dxc -T lib_6_1 %s | FileCheck %s
+
+// Make sure entry functions exist.
+// CHECK: @ps_scale(
+// CHECK: @ps_shade(
+
+// Make sure the nested helpers exist.
+// CHECK: @"\01?Scale
+// CHECK: @"\01?Bias
+// CHECK: @"\01?Shade
+
+cbuffer Params {
+  float4 g_scale;
+  float4 g_bias;
+};
+
+float4 Scale(float4 v) { return v * g_scale; }
+
+float4 Bias(float4 v) { return v + g_bias; }
+
+float4 Shade(float4 v) { return Bias(Scale(v)); }
+
+[shader("pixel")]
+float4 ps_scale(float4 a : A) : SV_TARGET
+{
+  return Scale(a);
+}
+
+[shader("pixel")]
+float4 ps_shade(float4 a : A) : SV_TARGET
+{
+  return Shade(a) + Scale(a);
+}
@@ -0,0 +1,15 @@
+// RUN: %dxc -T lib_6_1 %s | FileCheck %s
+
+// Make sure the shared helper and the entry exist.
+// CHECK: @"\01?Tint
+// CHECK: @ps_tint2(
+
+// Check linking with lib_shared_helper.hlsl, which defines the same helper.
+
+float4 Tint(float4 v) { return v * float4(0.5, 0.25, 1, 1) + 0.125; }
+
+[shader("pixel")]
+float4 ps_tint2(float4 a : A) : SV_TARGET
+{
+  return Tint(a) * 2;
+}
@@ -0,0 +1,31 @@
+// RUN: %dxc -E main -T cs_6_0 %s | FileCheck %s
+
+// The four loads read the 2x2 block at p. The static sampler returns zero
+// outside the texture, as loads do, so they become a gather at the corner
+// the texels share.
+
+// CHECK: call %dx.types.Dimensions @dx.op.getDimensions(i32 72,
+// CHECK: call %dx.types.ResRet.f32 @dx.op.textureGather.f32(i32 73,
+// CHECK-NOT: @dx.op.textureLoad.f32(
+// CHECK: ret void
+
+#define RS "DescriptorTable(SRV(t0), UAV(u0)), " \
+           "StaticSampler(s0, addressU = TEXTURE_ADDRESS_BORDER, " \
+           "addressV = TEXTURE_ADDRESS_BORDER, " \
+           "borderColor = STATIC_BORDER_COLOR_TRANSPARENT_BLACK, " \
+           "filter = FILTER_MIN_MAG_MIP_POINT)"
+
+Texture2D<float> tex : register(t0);
+SamplerState border : register(s0);
+RWTexture2D<float> output : register(u0);
+
+[RootSignature(RS)]
+[numthreads(8, 8, 1)]
+void main(uint2 id : SV_DispatchThreadID) {
+  int2 p = id * 2;
+  float s = tex.Load(int3(p, 0)) + tex.Load(int3(p + int2(1, 0), 0)) +
+            tex.Load(int3(p + int2(0, 1), 0)) +
+            tex.Load(int3(p + int2(1, 1), 0));
+  // The gather needs the sampler to be declared, and so used.
+  output[id] = s * 0.25 + tex.SampleLevel(border, float2(0, 0), 0);
+}
@@ -0,0 +1,23 @@
+// RUN: %dxc -E main -T vs_6_0 %s | FileCheck %s
+
+// The last row of an [affine] matrix is 0, 0, 0, 1, so mul(World, pos)
+// passes pos.w through; a constructor with literal zeros and ones does the
+// same for the terms they multiply.
+
+// CHECK: [[W:%[0-9]+]] = call float @dx.op.loadInput.f32(i32 4, i32 0, i32 0, i8 3
+// CHECK: call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 3, float [[W]])
+// CHECK: call void @dx.op.storeOutput.f32(i32 5, i32 1, i32 0, i8 3, float [[W]])
+
+cbuffer C {
+  [affine] float4x4 World;
+  float Scale;
+};
+
+void main(float4 pos : POSITION, out float4 o0 : SV_Position,
+          out float4 o1 : O1) {
+  o0 = mul(World, pos);
+  o1 = mul(float4x4(Scale, 0, 0, 0,
+                    0, Scale, 0, 0,
+                    0, 0, Scale, 0,
+                    0, 0, 0, 1), pos);
+}
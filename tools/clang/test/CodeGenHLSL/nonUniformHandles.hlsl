@@ -0,0 +1,25 @@
+// RUN: %dxc -E main -T cs_6_0 %s | FileCheck %s
+
+// The constant buffer value and the group id are the same in every lane,
+// so the first mark is dropped and the second handle stays uniform. The
+// thread index differs per lane, so its handle is marked non-uniform.
+
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 false)
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 false)
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 %{{.*}}, i1 true)
+// CHECK: ret void
+
+Texture2D<float4> textures[8] : register(t0);
+RWStructuredBuffer<float4> output : register(u0);
+
+cbuffer Params {
+  uint material;
+};
+
+[numthreads(64, 1, 1)]
+void main(uint3 gid : SV_GroupID, uint tid : SV_GroupIndex) {
+  float4 r = textures[NonUniformResourceIndex(material)].Load(int3(0, 0, 0));
+  r += textures[gid.x % 8].Load(int3(1, 0, 0));
+  r += textures[tid % 8].Load(int3(2, 0, 0));
+  output[tid] = r;
+}
@@ -0,0 +1,20 @@
+// RUN: %dxc -E main -T ps_6_0 -Od %s | FileCheck %s
+
+// Only the loop the sample offsets are computed from gets unrolled.
+// CHECK: @dx.op.sample.f32(i32 60, {{.*}}, i32 0, i32 0, i32 undef
+// CHECK: @dx.op.sample.f32(i32 60, {{.*}}, i32 1, i32 -1, i32 undef
+// CHECK: br i1
+
+SamplerState samp1 : register(s5);
+Texture2D<float4> text1 : register(t3);
+
+float4 main(float2 a : A) : SV_Target {
+  float4 r = 0;
+  for (int x = 0; x < 2; x++) {
+    r += text1.Sample(samp1, a, int2(x, -x));
+  }
+  for (uint k = 0; k < 3; k++) {
+    r = r * a.x + k;
+  }
+  return r;
+}
@@ -0,0 +1,15 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// Each step reaches x through both the sin and the cos call, so visiting
+// values once per path would take 2^64 visits to propagate precise.
+// CHECK: call float @dx.op.unary.f32(i32 13, {{.*}}!dx.precise
+
+float4 main(float a : A, float b : B) : SV_Target
+{
+  precise float x = a;
+  [unroll]
+  for (int i = 0; i < 64; i++) {
+    x = x > b ? sin(x) : cos(x);
+  }
+  return x;
+}
@@ -0,0 +1,21 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// The constant branch in scale is folded once, before scale is inlined
+// into each of its callers, and every copy still computes the same value.
+
+// CHECK: fmul
+// CHECK-NOT: br i1
+// CHECK: ret void
+
+static const bool useBias = false;
+
+float scale(float x) {
+  float r = x;
+  if (useBias)
+    r += 1.0;
+  return r * 2.0;
+}
+
+float4 main(float4 a : A) : SV_Target {
+  return float4(scale(a.x), scale(a.y), scale(a.z), scale(a.w));
+}
@@ -0,0 +1,27 @@
+// RUN: %dxc -E main -T ps_6_0 %s | FileCheck %s
+
+// Scratch state written in one helper and read in another only lives in main
+// once the helpers are inlined, so it becomes a local array.
+// CHECK-NOT: internal global [4 x float]
+// CHECK: alloca [4 x float]
+
+static float scratch[4];
+static float sum;
+
+void Fill(float4 v) {
+  scratch[0] = v.x;
+  scratch[1] = v.y;
+  scratch[2] = v.z;
+  scratch[3] = v.w;
+}
+
+float Read(uint i) {
+  return scratch[i];
+}
+
+float4 main(float4 v : V, uint i : I) : SV_Target {
+  Fill(v);
+  sum += Read(i);
+  sum += Read(i + 1);
+  return sum;
+}
@@ -26,14 +26,16 @@ float4 main() : SV_TARGET {
   if (WaveIsFirstLane()) {
     f += 1;
   }
-  f += WaveGetLaneIndex();
+  // Lane-varying arguments keep the operations below from being simplified.
+  uint lane = WaveGetLaneIndex();
+  f += lane;
   if (WaveGetLaneCount() == 0) {
     f += 1;
   }
-  if (WaveActiveAnyTrue(true)) {
+  if (WaveActiveAnyTrue(lane == 1)) {
     f += 1;
   }
-  if (WaveActiveAllTrue(true)) {
+  if (WaveActiveAllTrue(lane < 64)) {
     f += 1;
   }
   if (WaveActiveAllEqual(WaveGetLaneIndex())) {
@@ -44,10 +46,12 @@ float4 main() : SV_TARGET {
     f += 1;
   }
   float3 f3 = { 1, 2, 3 };
+  f3 += lane;
   uint3 u3 = { 1, 2 ,3 };
+  u3 += lane;
   uint u = 0;
   uint2 u2 = { 1, 2 };
-  int i_signed = -2;
+  int i_signed = lane - 2;
   f += WaveReadLaneAt(f3, 1).x;
   f3 += WaveReadLaneFirst(f3).x;
   f3 += WaveActiveSum(f3).x;
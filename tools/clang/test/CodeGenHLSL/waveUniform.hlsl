@@ -0,0 +1,29 @@
+// RUN: %dxc -E main -T cs_6_0 %s | FileCheck %s
+
+// Every argument below is the same in all lanes of the wave, so only the
+// active lane count is left, computed once for the block.
+
+// CHECK: %[[count:.*]] = call i32 @dx.op.waveAllOp(i32 135, i1 true)
+// CHECK-NOT: call i32 @dx.op.waveAllOp
+// CHECK-NOT: waveActiveOp
+// CHECK-NOT: waveReadLaneFirst
+// CHECK-NOT: waveActiveAllEqual
+// CHECK: uitofp i32 %[[count]] to float
+// CHECK-NOT: waveActiveOp
+// CHECK: ret void
+
+cbuffer Params {
+  uint scale;
+  float bias;
+};
+
+RWBuffer<uint> output;
+RWBuffer<float> foutput;
+
+[numthreads(64, 1, 1)]
+void main(uint3 gid : SV_GroupID, uint id : SV_GroupIndex) {
+  uint g = gid.x * scale;
+  output[id] = WaveActiveSum(scale) + WaveActiveMax(g) + WaveReadLaneFirst(g);
+  foutput[id] = WaveActiveSum(bias);
+  output[id + 64] = WaveActiveAllEqual(g) ? WaveActiveCountBits(scale > 2) : 0;
+}
@@ -0,0 +1,16 @@
+// RUN: %dxc -E main -T ps_6_0 /profile_instrument %s | FileCheck %s
+
+// Each block adds one to its own counter in the counter buffer.
+
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 1, i32 0, i32 0, i1 false)
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 undef, i32 undef, i32 1)
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 4, i32 undef, i32 undef, i32 1)
+// CHECK: !"dx.block.counters", i32 1000, i32 0, i32 1, i32 11
+
+float4 main(float4 a : A) : SV_Target {
+  float4 r = a;
+  [branch]
+  if (a.x > 0)
+    r = sqrt(a);
+  return r;
+}
@@ -0,0 +1,48 @@
+; RUN: %opt %s -hlsl-dxil-insert-block-counters,per-line=1 -S | FileCheck %s
+
+; The block starts on line 3 and moves to line 4, so it gets a second
+; counter right before the first instruction of line 4. Each increment takes
+; the location of the instructions it counts.
+
+; CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 undef, i32 undef, i32 1), !dbg [[L3:![0-9]+]]
+; CHECK-NEXT: %a = fadd
+; CHECK-NEXT: %b = fmul
+; CHECK-NEXT: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 4, i32 undef, i32 undef, i32 1), !dbg [[L4:![0-9]+]]
+; CHECK-NEXT: %c = fadd
+; CHECK: [[L3]] = !DILocation(line: 3
+; CHECK: [[L4]] = !DILocation(line: 4
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+define void @main() {
+entry:
+  %a = fadd fast float 1.000000e+00, 2.000000e+00, !dbg !20
+  %b = fmul fast float %a, %a, !dbg !20
+  %c = fadd fast float %b, %a, !dbg !21
+  ret void, !dbg !21
+}
+
+!llvm.dbg.cu = !{!10}
+!llvm.module.flags = !{!15, !16}
+!dx.version = !{!0}
+!dx.shaderModel = !{!1}
+!dx.typeAnnotations = !{!5}
+!dx.entryPoints = !{!9}
+
+!0 = !{i32 1, i32 0}
+!1 = !{!"ps", i32 6, i32 0}
+!5 = !{i32 1, void ()* @main, !6}
+!6 = !{!7}
+!7 = !{i32 0, !8, !8}
+!8 = !{}
+!9 = !{void ()* @main, !"main", null, null, null}
+!10 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !11, producer: "dxc", isOptimized: false, runtimeVersion: 0, emissionKind: 1, subprograms: !12)
+!11 = !DIFile(filename: "t.hlsl", directory: "")
+!12 = !{!13}
+!13 = !DISubprogram(name: "main", scope: !11, file: !11, line: 1, type: !14, isLocal: false, isDefinition: true, scopeLine: 1, flags: DIFlagPrototyped, isOptimized: false, function: void ()* @main)
+!14 = !DISubroutineType(types: !8)
+!15 = !{i32 2, !"Dwarf Version", i32 4}
+!16 = !{i32 2, !"Debug Info Version", i32 3}
+!20 = !DILocation(line: 3, column: 5, scope: !13)
+!21 = !DILocation(line: 4, column: 5, scope: !13)
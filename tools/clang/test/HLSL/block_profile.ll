@@ -0,0 +1,38 @@
+; RUN: %opt %s -hlsl-dxil-apply-block-profile,profile=main:0:100;main:1:2;main:2:100;main:3:50;main:4:50;main:5:100 -S | FileCheck %s
+
+; The first branch goes to %rare 2 times out of 100 and gets a [branch]
+; hint; the second one is balanced and is left alone.
+
+; CHECK: br i1 %c1, label %rare, label %mid, !dx.controlflow.hints
+; CHECK: br i1 %c2, label %left, label %right{{$}}
+; CHECK: !"dx.controlflow.hints", i32 1}
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+define float @main(float %a, float %b) {
+entry:
+  %c1 = fcmp fast ogt float %a, 1.000000e+02
+  br i1 %c1, label %rare, label %mid
+
+rare:
+  %s = fmul fast float %a, %a
+  br label %mid
+
+mid:
+  %m = phi float [ %s, %rare ], [ %a, %entry ]
+  %c2 = fcmp fast ogt float %b, 0.000000e+00
+  br i1 %c2, label %left, label %right
+
+left:
+  %l = fadd fast float %m, %b
+  br label %done
+
+right:
+  %r = fsub fast float %m, %b
+  br label %done
+
+done:
+  %v = phi float [ %l, %left ], [ %r, %right ]
+  ret float %v
+}
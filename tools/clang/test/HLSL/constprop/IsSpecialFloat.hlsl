@@ -0,0 +1,17 @@
+// RUN: %dxc -T ps_6_0 %s -E main | %FileCheck %s
+// CHECK-NOT: call i1 @dx.op.isSpecialFloat
+// CHECK: call void @dx.op.storeOutput{{.*}} float 4.000000e+00
+
+[RootSignature("")]
+float main() : SV_Target {
+    float inf = asfloat(0x7f800000);
+    float nan = asfloat(0x7fc00000);
+    float one = 1.0;
+
+    float result = 0;
+    result += isinf(inf) ? 1 : 0;
+    result += isnan(nan) ? 1 : 0;
+    result += isfinite(one) && !isfinite(inf) ? 1 : 0;
+    result += (!isnan(one) && !isinf(nan)) ? 1 : 0;
+    return result;
+}
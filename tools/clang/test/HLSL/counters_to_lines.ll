@@ -0,0 +1,59 @@
+; RUN: %opt %s -hlsl-dxil-map-counters-to-lines,counts=5;40;2 -analyze | FileCheck %s
+
+; Counters 0 and 2 both increment on line 3, so their counts add up; the
+; hotter line 7 is listed first.
+
+; CHECK: t.hlsl:7 40
+; CHECK-NEXT: t.hlsl:3 7
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+%dx.types.Handle = type { i8* }
+%struct.RWByteAddressBuffer = type { i32 }
+
+define void @main() {
+entry:
+  %h = call %dx.types.Handle @dx.op.createHandle(i32 57, i8 1, i32 0, i32 0, i1 false)
+  %0 = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %h, i32 0, i32 0, i32 undef, i32 undef, i32 1), !dbg !20
+  %1 = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %h, i32 0, i32 4, i32 undef, i32 undef, i32 1), !dbg !21
+  %2 = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %h, i32 0, i32 8, i32 undef, i32 undef, i32 1), !dbg !20
+  ret void
+}
+
+; Function Attrs: nounwind readonly
+declare %dx.types.Handle @dx.op.createHandle(i32, i8, i32, i32, i1) #0
+
+; Function Attrs: nounwind
+declare i32 @dx.op.atomicBinOp.i32(i32, %dx.types.Handle, i32, i32, i32, i32, i32) #1
+
+attributes #0 = { nounwind readonly }
+attributes #1 = { nounwind }
+
+!llvm.dbg.cu = !{!10}
+!llvm.module.flags = !{!15, !16}
+!dx.version = !{!0}
+!dx.shaderModel = !{!1}
+!dx.resources = !{!2}
+!dx.typeAnnotations = !{!5}
+!dx.entryPoints = !{!9}
+
+!0 = !{i32 1, i32 0}
+!1 = !{!"ps", i32 6, i32 0}
+!2 = !{null, !3, null, null}
+!3 = !{!4}
+!4 = !{i32 0, %struct.RWByteAddressBuffer* undef, !"dx.block.counters", i32 1000, i32 0, i32 1, i32 11, i1 false, i1 false, i1 false, null}
+!5 = !{i32 1, void ()* @main, !6}
+!6 = !{!7}
+!7 = !{i32 0, !8, !8}
+!8 = !{}
+!9 = !{void ()* @main, !"main", null, !2, null}
+!10 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !11, producer: "dxc", isOptimized: false, runtimeVersion: 0, emissionKind: 1, subprograms: !12)
+!11 = !DIFile(filename: "t.hlsl", directory: "")
+!12 = !{!13}
+!13 = !DISubprogram(name: "main", scope: !11, file: !11, line: 1, type: !14, isLocal: false, isDefinition: true, scopeLine: 1, flags: DIFlagPrototyped, isOptimized: false, function: void ()* @main)
+!14 = !DISubroutineType(types: !8)
+!15 = !{i32 2, !"Dwarf Version", i32 4}
+!16 = !{i32 2, !"Debug Info Version", i32 3}
+!20 = !DILocation(line: 3, column: 5, scope: !13)
+!21 = !DILocation(line: 7, column: 5, scope: !13)
@@ -0,0 +1,33 @@
+; RUN: %opt %s -hlsl-dxil-constant-tables,max-elements=4 -S | FileCheck %s
+
+; The four-element table is replaced by selects over its elements and
+; removed; the eight-element one is larger than max-elements and stays as
+; immediate constant data.
+
+; CHECK-NOT: @small
+; CHECK: @big = internal unnamed_addr constant [8 x float]
+; CHECK-NOT: @small
+; CHECK: icmp eq i32 %i, 1
+; CHECK: select i1 {{.*}}, float 2.000000e+00, float 1.000000e+00
+; CHECK: icmp eq i32 %i, 3
+; CHECK: select i1 {{.*}}, float 4.000000e+00
+; CHECK: getelementptr [8 x float], [8 x float]* @big, i32 0, i32 %i
+; CHECK: fadd float {{.*}}, 3.000000e+00
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+@small = internal unnamed_addr constant [4 x float] [float 1.000000e+00, float 2.000000e+00, float 3.000000e+00, float 4.000000e+00], align 4
+@big = internal unnamed_addr constant [8 x float] [float 1.000000e+00, float 2.000000e+00, float 3.000000e+00, float 4.000000e+00, float 5.000000e+00, float 6.000000e+00, float 7.000000e+00, float 8.000000e+00], align 4
+
+define float @main(i32 %i) {
+entry:
+  %sd = getelementptr [4 x float], [4 x float]* @small, i32 0, i32 %i
+  %s = load float, float* %sd, align 4
+  %bd = getelementptr [8 x float], [8 x float]* @big, i32 0, i32 %i
+  %b = load float, float* %bd, align 4
+  %sum = fadd float %s, %b
+  %c = load float, float* getelementptr inbounds ([4 x float], [4 x float]* @small, i32 0, i32 2), align 4
+  %r = fadd float %sum, %c
+  ret float %r
+}
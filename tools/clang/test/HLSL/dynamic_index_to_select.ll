@@ -0,0 +1,37 @@
+; RUN: %opt %s -hlsl-dxil-dynamic-index-to-select,max-elements=4 -S | FileCheck %s
+
+; The four-element array is replaced by selects over its elements; the
+; eight-element one is larger than max-elements and stays in memory.
+
+; CHECK-NOT: alloca [4 x float]
+; CHECK: alloca [8 x float]
+; CHECK-NOT: alloca [4 x float]
+; CHECK: icmp eq i32 %i, 1
+; CHECK: select i1
+; CHECK: icmp eq i32 %i, 3
+; CHECK: select i1
+; CHECK: getelementptr [8 x float], [8 x float]* %big, i32 0, i32 %i
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+define float @main(i32 %i, float %a, float %b) {
+entry:
+  %small = alloca [4 x float], align 4
+  %big = alloca [8 x float], align 4
+  %s0 = getelementptr [4 x float], [4 x float]* %small, i32 0, i32 0
+  store float %a, float* %s0, align 4
+  %s1 = getelementptr [4 x float], [4 x float]* %small, i32 0, i32 1
+  store float %b, float* %s1, align 4
+  %s2 = getelementptr [4 x float], [4 x float]* %small, i32 0, i32 2
+  store float %a, float* %s2, align 4
+  %s3 = getelementptr [4 x float], [4 x float]* %small, i32 0, i32 3
+  store float %b, float* %s3, align 4
+  %sd = getelementptr [4 x float], [4 x float]* %small, i32 0, i32 %i
+  %v = load float, float* %sd, align 4
+  %bd = getelementptr [8 x float], [8 x float]* %big, i32 0, i32 %i
+  store float %v, float* %bd, align 4
+  %b0 = getelementptr [8 x float], [8 x float]* %big, i32 0, i32 0
+  %r = load float, float* %b0, align 4
+  ret float %r
+}
@@ -0,0 +1,24 @@
+// RUN: %dxc -Emain -Tvs_6_0 %s | %opt -S -hlsl-dxil-eliminate-output-dynamic | %FileCheck %s
+
+// Only the components a store can reach are written before the return: the
+// index is masked to rows 0 to 3, and only x and y are written.
+
+// CHECK-NOT: storeOutput.f32(i32 5, i32 0, i32 %
+// CHECK: storeOutput.f32(i32 5, i32 0, i32 0, i8 0
+// CHECK: storeOutput.f32(i32 5, i32 0, i32 3, i8 0
+// CHECK-NOT: storeOutput.f32(i32 5, i32 0, i32 4, i8 0
+// CHECK: storeOutput.f32(i32 5, i32 0, i32 0, i8 1
+// CHECK: storeOutput.f32(i32 5, i32 0, i32 3, i8 1
+// CHECK-NOT: storeOutput.f32(i32 5, i32 0, i32 {{[0-9]}}, i8 2
+// CHECK-NOT: storeOutput.f32(i32 5, i32 0, i32 {{[0-9]}}, i8 3
+
+int  count;
+float4 c[16];
+
+float4 main(out float4 o[8] : I, float4 pos: POS) : SV_POSITION {
+
+    for (uint i=0;i<count;i++)
+        o[i & 3].xy = c[i].xy;
+
+    return pos;
+}
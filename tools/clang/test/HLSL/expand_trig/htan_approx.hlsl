@@ -0,0 +1,16 @@
+// RUN: %dxc -Emain -Tps_6_0 %s | %opt -S -hlsl-dxil-expand-trig-intrinsics,approximate=1 | %FileCheck %s
+
+// CHECK: [[X:%.*]]   = call float @dx.op.loadInput.f32(i32 4
+// CHECK: [[r0:%.*]]  = fmul fast float [[X]], {{.*}}
+// CHECK: [[r1:%.*]]  = call float @dx.op.unary.f32(i32 21, float [[r0]]
+// CHECK: [[r2:%.*]]  = fadd fast float [[r1]], 1.000000e+00
+// CHECK: [[r3:%.*]]  = fdiv fast float 2.000000e+00, [[r2]]
+// CHECK: fsub fast float 1.000000e+00, [[r3]]
+
+// CHECK-NOT: call float @dx.op.unary.f32(i32 21
+// CHECK-NOT: call float @dx.op.unary.f32(i32 18
+
+[RootSignature("")]
+float main(float x : A) : SV_Target {
+    return tanh(x);
+}
@@ -0,0 +1,17 @@
+// RUN: %dxc -E main -T ps_6_0 -function_budget 8 %s | StdErrCheck %s
+
+// CHECK: warning: function 'main' has more than 8 instructions, so licm is skipped on it
+// CHECK: warning: function 'main' has more than 8 instructions, so gvn runs without load elimination or PRE on it
+
+cbuffer C {
+  uint n;
+  float4 v[8];
+  float4 scale;
+};
+
+float4 main() : SV_Target {
+  float4 r = 0;
+  for (uint i = 0; i < n; ++i)
+    r += v[i & 7] * scale;
+  return r;
+}
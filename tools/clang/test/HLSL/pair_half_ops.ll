@@ -0,0 +1,22 @@
+; RUN: %opt %s -hlsl-dxil-pair-half-ops -S | FileCheck %s
+
+; The second fmul does not depend on the first one, so it moves up next to
+; it. The fadd of the two products has to stay after both.
+
+; CHECK: %m0 = fmul fast half %a, %b
+; CHECK-NEXT: %m1 = fmul fast half %c, %d
+; CHECK-NEXT: %s0 = fadd fast half %a, %c
+; CHECK-NEXT: %s1 = fadd fast half %m0, %m1
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+define half @main(half %a, half %b, half %c, half %d) {
+entry:
+  %m0 = fmul fast half %a, %b
+  %s0 = fadd fast half %a, %c
+  %m1 = fmul fast half %c, %d
+  %s1 = fadd fast half %m0, %m1
+  %r = fadd fast half %s0, %s1
+  ret half %r
+}
@@ -0,0 +1,25 @@
+// RUN: %dxc -E main -T ps_6_0 /profile_regions %s | FileCheck %s
+
+// The block region exits before the function region. Each exit adds the
+// ticks since its entry, the carry out of them, one visit and the longest
+// visit to the entry of its region in the buffer element.
+
+// CHECK: call %dx.types.Handle @dx.op.createHandle(i32 57, i8 1, i32 0, i32 0, i1 false)
+// CHECK: call %dx.types.twoi32 @dx.op.cycleCounterLegacy(i32 109)
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 16, i32 undef, i32 %{{.*}})
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 20, i32 undef, i32 %{{.*}})
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 24, i32 undef, i32 1)
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 7, i32 0, i32 28, i32 undef, i32 %{{.*}})
+// CHECK: call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %{{.*}}, i32 0, i32 0, i32 0, i32 undef, i32 %{{.*}})
+// CHECK-NOT: @dx.profile.region(
+// CHECK: !"dx.profile.regions", i32 1000, i32 1, i32 1, i32 12
+
+[profile("main")]
+float4 main(float4 a : A) : SV_Target {
+  float4 r = a;
+  [profile("shade")]
+  {
+    r = sqrt(a) * a.x;
+  }
+  return r;
+}
@@ -0,0 +1,52 @@
+; RUN: %opt %s -hlsl-dxil-insert-profile-regions -analyze | FileCheck %s
+
+; Region 0 is entered twice, one visit nested in the other, and each exit
+; pairs with the nearest entry that is not closed yet. The exit in %skip has
+; no dominating entry of region 1 and is dropped.
+
+; CHECK: Profile regions in u1, space 1000
+; CHECK: region 0 at 0: outer
+; CHECK: region 1 at 16: inner
+; CHECK: 1 region exits have no dominating entry
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+define void @main(i1 %c) {
+entry:
+  call void @dx.profile.region(i32 0, i32 0)
+  call void @dx.profile.region(i32 0, i32 0)
+  call void @dx.profile.region(i32 1, i32 0)
+  br i1 %c, label %body, label %skip
+
+body:
+  call void @dx.profile.region(i32 0, i32 1)
+  call void @dx.profile.region(i32 1, i32 1)
+  br label %exit
+
+skip:
+  call void @dx.profile.region(i32 1, i32 1)
+  br label %exit
+
+exit:
+  call void @dx.profile.region(i32 1, i32 0)
+  ret void
+}
+
+declare void @dx.profile.region(i32, i32)
+
+!dx.version = !{!0}
+!dx.shaderModel = !{!1}
+!dx.typeAnnotations = !{!5}
+!dx.entryPoints = !{!9}
+!dx.profile.regions = !{!10, !11}
+
+!0 = !{i32 1, i32 0}
+!1 = !{!"ps", i32 6, i32 0}
+!5 = !{i32 1, void (i1)* @main, !6}
+!6 = !{!7, !7}
+!7 = !{i32 0, !8, !8}
+!8 = !{}
+!9 = !{void (i1)* @main, !"main", null, null, null}
+!10 = !{!"outer"}
+!11 = !{!"inner"}
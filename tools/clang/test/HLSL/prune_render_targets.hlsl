@@ -0,0 +1,27 @@
+// RUN: %dxc -Emain -Tps_6_0 -rt_mask 0x1 -no_depth_write %s | FileCheck %s
+
+// Only SV_Target0 is bound and depth writes are disabled, so the stores to
+// SV_Target1 and SV_Depth are removed along with the sin and cos feeding
+// them, and the signature keeps SV_Target0 alone.
+
+// CHECK-NOT: @dx.op.unary.f32(i32 13
+// CHECK-NOT: @dx.op.unary.f32(i32 12
+// CHECK: call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 0,
+// CHECK-NOT: call void @dx.op.storeOutput.f32(i32 5, i32 1,
+// CHECK-NOT: call void @dx.op.storeOutput.f32(i32 5, i32 2,
+// CHECK: !{i32 0, !"SV_Target", i8 9, i8 16,
+// CHECK-NOT: !"SV_Depth"
+
+struct PSOut {
+  float4 color : SV_Target0;
+  float4 normal : SV_Target1;
+  float depth : SV_Depth;
+};
+
+PSOut main(float4 c : COLOR, float4 n : NORMAL) {
+  PSOut o;
+  o.color = c * 2;
+  o.normal = sin(n);
+  o.depth = cos(c.x);
+  return o;
+}
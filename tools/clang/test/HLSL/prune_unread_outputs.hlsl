@@ -0,0 +1,23 @@
+// RUN: %dxc -Emain -Tvs_6_0 %s | %opt -S -hlsl-dxil-prune-unread-outputs,consumer-inputs=TEXCOORD1 | %FileCheck %s
+
+// TEXCOORD0 is not read by the consumer, so its store and the sin feeding it
+// are removed, and TEXCOORD1 moves up to take its ID and register.
+
+// CHECK-NOT: @dx.op.unary.f32(i32 13
+// CHECK: call void @dx.op.storeOutput.f32(i32 5, i32 1, i32 0, i8 0,
+// CHECK-NOT: call void @dx.op.storeOutput.f32(i32 5, i32 2,
+// CHECK: !{i32 1, !"TEXCOORD", i8 9, i8 0, !{{[0-9]+}}, i8 2, i32 1, i8 4, i32 1, i8 0, null}
+
+struct VSOut {
+  float4 pos : SV_Position;
+  float4 a : TEXCOORD0;
+  float4 b : TEXCOORD1;
+};
+
+VSOut main(float4 p : POSITION, float4 n : NORMAL) {
+  VSOut o;
+  o.pos = p;
+  o.a = sin(n);
+  o.b = n * 2;
+  return o;
+}
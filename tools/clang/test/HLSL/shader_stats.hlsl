@@ -0,0 +1,27 @@
+// RUN: %dxc -E main -T ps_6_0 %s | %opt -hlsl-dxil-shader-stats | %FileCheck %s
+
+// CHECK: Entry main
+// CHECK: DXIL operations:
+// CHECK: sample: 1
+// CHECK: Texture operations: 1
+// CHECK: CBuffer operations: {{[1-9]}}
+// CHECK: Loops: 1
+// CHECK: Peak live values: {{[1-9][0-9]*}}
+// CHECK: Shader model: ps_6_0
+
+Texture2D tex;
+SamplerState samp;
+
+cbuffer Params {
+  float4 scale;
+  uint count;
+};
+
+float4 main(float2 uv : TEXCOORD0) : SV_Target {
+  float4 result = 0;
+  [loop]
+  for (uint i = 0; i < count; ++i) {
+    result += tex.Sample(samp, uv + i) * scale;
+  }
+  return result;
+}
@@ -0,0 +1,20 @@
+// RUN: %dxc -E main -T cs_6_0 %s | %opt -hlsl-dxil-tgsm-bank-conflicts | %FileCheck %s
+
+// Writing a row of the tile puts consecutive threads in consecutive banks;
+// reading a column puts all of them in the same bank.
+
+// CHECK: Groupshared bank conflicts (32 banks, 32 lanes):
+// CHECK: main: store of @{{.*}}tile{{.*}}: no conflict
+// CHECK: main: load of @{{.*}}tile{{.*}}: 32-way conflict, lane stride 128 bytes; padding each row by 4 bytes removes it
+
+groupshared float tile[32][32];
+
+StructuredBuffer<float> input;
+RWStructuredBuffer<float> output;
+
+[numthreads(32, 1, 1)]
+void main(uint3 tid : SV_GroupThreadID) {
+  tile[0][tid.x] = input[tid.x];
+  GroupMemoryBarrierWithGroupSync();
+  output[tid.x] = tile[tid.x][0];
+}
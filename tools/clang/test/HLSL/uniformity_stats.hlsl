@@ -0,0 +1,27 @@
+// RUN: %dxc -E main -T cs_6_0 %s | %opt -analyze -hlsl-dxil-uniformity-stats | %FileCheck %s
+
+// The branch on the cbuffer value is uniform across the wave; the branch on
+// the thread id is not.
+
+// CHECK: Function main: 2 conditional branches, 1 divergent
+
+cbuffer Params {
+  uint mode;
+  uint count;
+};
+
+RWBuffer<uint> output;
+
+[numthreads(64, 1, 1)]
+void main(uint id : SV_DispatchThreadID) {
+  uint v = 1;
+  [branch]
+  if (mode == 3) {
+    v = output[count];
+  }
+  [branch]
+  if (id < count) {
+    v += output[id + 64];
+  }
+  output[id] = v;
+}
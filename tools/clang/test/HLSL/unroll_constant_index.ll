@@ -0,0 +1,78 @@
+; RUN: %opt %s -loop-unroll -S | FileCheck %s
+
+; Both loops are too large for the default full unroll threshold. Unrolling
+; the first one makes every cbuffer row index constant, so it is unrolled
+; anyway; the second one indexes from an unknown base and stays a loop.
+
+; CHECK-LABEL: define float @constant_index
+; CHECK: @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %h, i32 0)
+; CHECK: @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %h, i32 31)
+; CHECK-NOT: br i1
+
+; CHECK-LABEL: define float @dynamic_index
+; CHECK: phi i32
+; CHECK: br i1
+
+target datalayout = "e-m:e-p:32:32-i64:64-f80:32-n8:16:32-a:0:32-S32"
+target triple = "dxil-ms-dx"
+
+%dx.types.Handle = type { i8* }
+%dx.types.CBufRet.f32 = type { float, float, float, float }
+
+define float @constant_index() {
+entry:
+  %h = call %dx.types.Handle @dx.op.createHandle(i32 57, i8 2, i32 0, i32 0, i1 false)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi float [ 0.000000e+00, %entry ], [ %acc.next, %loop ]
+  %row = call %dx.types.CBufRet.f32 @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %h, i32 %i)
+  %x = extractvalue %dx.types.CBufRet.f32 %row, 0
+  %y = extractvalue %dx.types.CBufRet.f32 %row, 1
+  %z = extractvalue %dx.types.CBufRet.f32 %row, 2
+  %w = extractvalue %dx.types.CBufRet.f32 %row, 3
+  %xy = fmul fast float %x, %y
+  %zw = fmul fast float %z, %w
+  %sum = fadd fast float %xy, %zw
+  %acc.next = fadd fast float %acc, %sum
+  %i.next = add nuw nsw i32 %i, 1
+  %cond = icmp ult i32 %i.next, 32
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %r = phi float [ %acc.next, %loop ]
+  ret float %r
+}
+
+define float @dynamic_index(i32 %base) {
+entry:
+  %h = call %dx.types.Handle @dx.op.createHandle(i32 57, i8 2, i32 0, i32 0, i1 false)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi float [ 0.000000e+00, %entry ], [ %acc.next, %loop ]
+  %idx = add i32 %i, %base
+  %row = call %dx.types.CBufRet.f32 @dx.op.cbufferLoadLegacy.f32(i32 59, %dx.types.Handle %h, i32 %idx)
+  %x = extractvalue %dx.types.CBufRet.f32 %row, 0
+  %y = extractvalue %dx.types.CBufRet.f32 %row, 1
+  %z = extractvalue %dx.types.CBufRet.f32 %row, 2
+  %w = extractvalue %dx.types.CBufRet.f32 %row, 3
+  %xy = fmul fast float %x, %y
+  %zw = fmul fast float %z, %w
+  %sum = fadd fast float %xy, %zw
+  %acc.next = fadd fast float %acc, %sum
+  %i.next = add nuw nsw i32 %i, 1
+  %cond = icmp ult i32 %i.next, 32
+  br i1 %cond, label %loop, label %exit
+
+exit:
+  %r = phi float [ %acc.next, %loop ]
+  ret float %r
+}
+
+declare %dx.types.Handle @dx.op.createHandle(i32, i8, i32, i32, i1) #0
+declare %dx.types.CBufRet.f32 @dx.op.cbufferLoadLegacy.f32(i32, %dx.types.Handle, i32) #0
+
+attributes #0 = { nounwind readonly }
@@ -0,0 +1,16 @@
+// RUN: %dxc -E main -T ps_6_0 %s | StdErrCheck %s
+
+// CHECK: warning: loop not unrolled: [unroll] requires a trip count known at compile time
+
+cbuffer C {
+  uint n;
+  float4 v[8];
+};
+
+float4 main() : SV_Target {
+  float4 r = 0;
+  [unroll]
+  for (uint i = 0; i < n; ++i)
+    r += v[i & 7];
+  return r;
+}
@@ -18,14 +18,46 @@
 #include <vector>
 #include <string>
 
+// The library and compiler created on each thread are kept until the thread
+// exits, so that callers compiling in a loop pay for creating them once.
+// A compiler only runs one compilation at a time, so it is not shared
+// between threads.
+struct BridgeSession {
+  IDxcLibrary *pLibrary;
+  IDxcCompiler *pCompiler;
+};
+
+static thread_local BridgeSession ThreadSession = {nullptr, nullptr};
+
+static void ReleaseThreadSession() {
+  if (ThreadSession.pCompiler) {
+    ThreadSession.pCompiler->Release();
+    ThreadSession.pCompiler = nullptr;
+  }
+  if (ThreadSession.pLibrary) {
+    ThreadSession.pLibrary->Release();
+    ThreadSession.pLibrary = nullptr;
+  }
+}
+
 HRESULT CreateLibrary(IDxcLibrary **pLibrary) {
-  return DxcCreateInstance(CLSID_DxcLibrary, __uuidof(IDxcLibrary),
-                           (void **)pLibrary);
+  if (ThreadSession.pLibrary == nullptr) {
+    IFR(DxcCreateInstance(CLSID_DxcLibrary, __uuidof(IDxcLibrary),
+                          (void **)&ThreadSession.pLibrary));
+  }
+  ThreadSession.pLibrary->AddRef();
+  *pLibrary = ThreadSession.pLibrary;
+  return S_OK;
 }
 
 HRESULT CreateCompiler(IDxcCompiler **ppCompiler) {
-  return DxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler),
-                           (void **)ppCompiler);
+  if (ThreadSession.pCompiler == nullptr) {
+    IFR(DxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler),
+                          (void **)&ThreadSession.pCompiler));
+  }
+  ThreadSession.pCompiler->AddRef();
+  *ppCompiler = ThreadSession.pCompiler;
+  return S_OK;
 }
 
 HRESULT CreateContainerReflection(IDxcContainerReflection **ppReflection) {
@@ -226,6 +258,9 @@ HRESULT WINAPI BridgeD3DReflect(
 
   *ppReflector = nullptr;
 
+  // The reflection object reads the program part lazily and keeps referring
+  // to it, so the container is copied once; the caller may free pSrcData as
+  // soon as this returns.
   IFR(CreateLibrary(&library));
   IFR(library->CreateBlobWithEncodingOnHeapCopy((LPBYTE)pSrcData, SrcDataSize,
                                                 CP_ACP, &source));
@@ -237,12 +272,18 @@ HRESULT WINAPI BridgeD3DReflect(
   return S_OK;
 }
 
-BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD Reason, LPVOID) {
+BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD Reason, LPVOID pReserved) {
   BOOL result = TRUE;
-  if (Reason == DLL_PROCESS_ATTACH) {
-    DisableThreadLibraryCalls(hinstDLL);
+  UNREFERENCED_PARAMETER(hinstDLL);
+  // Thread notifications are kept so that each thread's session is released
+  // when the thread exits.
+  if (Reason == DLL_THREAD_DETACH) {
+    ReleaseThreadSession();
   } else if (Reason == DLL_PROCESS_DETACH) {
-    // Nothing to clean-up.
+    // When the process is terminating, other threads are gone and dxcompiler
+    // may already be unloaded; only release on FreeLibrary.
+    if (pReserved == nullptr)
+      ReleaseThreadSession();
   }
 
   return result;
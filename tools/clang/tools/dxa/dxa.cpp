@@ -19,8 +19,14 @@
 #include "dxc/HLSL/DxilContainer.h"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
 #include <dia2.h>
 #include <intsafe.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 using namespace llvm;
 using namespace llvm::opt;
@@ -31,6 +37,10 @@ static cl::opt<std::string> InputFilename(cl::Positional,
                                           cl::desc("<input .llvm file>"),
                                           cl::init("-"));
 
+static cl::list<std::string>
+    BatchInputFilenames(cl::Positional, cl::ZeroOrMore,
+                        cl::desc("<more input files with -batch>"));
+
 static cl::opt<std::string> OutputFilename("o",
                                            cl::desc("Override output filename"),
                                            cl::value_desc("filename"));
@@ -48,6 +58,16 @@ static cl::opt<bool> ListFiles("listfiles",
 static cl::opt<std::string>
     ExtractFile("extractfile", cl::desc("Extract file from debug information (use '*' for all files)"));
 
+static cl::opt<bool> Batch("batch",
+                           cl::desc("Assemble every input file in parallel, "
+                                    "each next to its input"),
+                           cl::init(false));
+static cl::opt<unsigned>
+    BatchThreads("batch-threads",
+                 cl::desc("Number of threads for -batch (default: one per "
+                          "hardware thread)"),
+                 cl::init(0));
+
 
 class DxaContext {
 
@@ -59,12 +79,23 @@ public:
   DxaContext(DxcDllSupport &dxcSupport) : m_dxcSupport(dxcSupport) {}
 
   void Assemble();
+  unsigned AssembleBatch();
   bool ExtractFile(const char *pName);
   bool ExtractPart(const char *pName);
   void ListFiles();
   void ListParts();
 };
 
+// Returns the container file name for an input, replacing a .ll or .bc
+// extension with .dxbc.
+static std::string GetDefaultOutputFilename(StringRef IFN) {
+  if (IFN == "-")
+    return "-";
+  if (IFN.endswith(".ll") || IFN.endswith(".bc"))
+    IFN = IFN.drop_back(3);
+  return IFN.str() + ".dxbc";
+}
+
 void DxaContext::Assemble() {
   CComPtr<IDxcOperationResult> pAssembleResult;
 
@@ -84,22 +115,135 @@ void DxaContext::Assemble() {
     IFT(pAssembleResult->GetResult(&pContainer));
     if (pContainer.p != nullptr) {
       // Infer the output filename if needed.
-      if (OutputFilename.empty()) {
-        if (InputFilename == "-") {
-          OutputFilename = "-";
-        } else {
-          StringRef IFN = InputFilename;
-          OutputFilename = (IFN.endswith(".ll") ? IFN.drop_back(3) : IFN).str();
-          OutputFilename = (IFN.endswith(".bc") ? IFN.drop_back(3) : IFN).str();
-          OutputFilename += ".dxbc";
-        }
-      }
+      if (OutputFilename.empty())
+        OutputFilename = GetDefaultOutputFilename(InputFilename);
 
       WriteBlobToFile(pContainer, StringRefUtf16(OutputFilename));
     }
   }
 }
 
+namespace {
+struct AssembleJob {
+  std::string InputFilename;
+  HRESULT Status = S_OK;
+  std::string Diagnostics;
+  double Milliseconds = 0;
+};
+}
+
+// Assembles one batch input with the worker's assembler and writes its
+// container next to it.
+static HRESULT RunAssembleJob(DxcDllSupport &dxcSupport,
+                              IDxcAssembler *pAssembler, AssembleJob &job) {
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcOperationResult> pResult;
+  ReadFileIntoBlob(dxcSupport, StringRefUtf16(job.InputFilename), &pSource);
+  IFR(pAssembler->AssembleToContainer(pSource, &pResult));
+
+  HRESULT status;
+  IFR(pResult->GetStatus(&status));
+  if (FAILED(status)) {
+    CComPtr<IDxcBlobEncoding> pErrors;
+    if (SUCCEEDED(pResult->GetErrorBuffer(&pErrors)) && pErrors != nullptr)
+      job.Diagnostics.assign((const char *)pErrors->GetBufferPointer(),
+                             pErrors->GetBufferSize());
+    return status;
+  }
+
+  CComPtr<IDxcBlob> pContainer;
+  IFR(pResult->GetResult(&pContainer));
+  if (pContainer.p != nullptr)
+    WriteBlobToFile(pContainer,
+                    StringRefUtf16(GetDefaultOutputFilename(job.InputFilename)));
+  return S_OK;
+}
+
+// Assembles the input files on a pool of workers, each owning one assembler
+// and so one LLVM context at a time, and prints the status and time of every
+// input in command line order. Returns the number of inputs that failed.
+unsigned DxaContext::AssembleBatch() {
+  std::vector<AssembleJob> jobs;
+  jobs.emplace_back();
+  jobs.back().InputFilename = InputFilename;
+  for (const std::string &name : BatchInputFilenames) {
+    jobs.emplace_back();
+    jobs.back().InputFilename = name;
+  }
+  for (const AssembleJob &job : jobs) {
+    if (job.InputFilename == "-")
+      throw hlsl::Exception(E_INVALIDARG,
+                            "-batch cannot assemble standard input.");
+  }
+
+  unsigned threadCount = BatchThreads;
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min<unsigned>(threadCount, jobs.size());
+
+  std::atomic<size_t> nextJob(0);
+  auto worker = [&]() {
+    CComPtr<IDxcAssembler> pAssembler;
+    HRESULT hr = m_dxcSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler);
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      AssembleJob &job = jobs[i];
+      if (FAILED(hr)) {
+        job.Status = hr;
+        continue;
+      }
+      auto start = std::chrono::steady_clock::now();
+      try {
+        job.Status = RunAssembleJob(m_dxcSupport, pAssembler, job);
+      } catch (const ::hlsl::Exception &hlslException) {
+        job.Status = hlslException.hr;
+        job.Diagnostics += hlslException.msg;
+      } catch (std::bad_alloc &) {
+        job.Status = E_OUTOFMEMORY;
+      } catch (...) {
+        job.Status = E_FAIL;
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      job.Milliseconds = elapsed.count();
+    }
+  };
+
+  auto batchStart = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+  std::chrono::duration<double, std::milli> batchElapsed =
+      std::chrono::steady_clock::now() - batchStart;
+
+  unsigned failed = 0;
+  std::string summary;
+  raw_string_ostream summaryStream(summary);
+  for (const AssembleJob &job : jobs) {
+    if (FAILED(job.Status))
+      ++failed;
+    summaryStream << job.InputFilename << ": "
+                  << (SUCCEEDED(job.Status) ? "succeeded" : "failed");
+    if (FAILED(job.Status))
+      summaryStream << " (" << format_hex((uint32_t)job.Status, 10) << ")";
+    summaryStream << " in " << format("%.1f", job.Milliseconds) << " ms\n";
+    if (!job.Diagnostics.empty()) {
+      summaryStream << job.Diagnostics;
+      if (job.Diagnostics.back() != '\n')
+        summaryStream << "\n";
+    }
+  }
+  summaryStream << "Assembled " << jobs.size() << " files on " << threadCount
+                << " workers in " << format("%.1f", batchElapsed.count())
+                << " ms: " << (unsigned)jobs.size() - failed << " succeeded, "
+                << failed << " failed.\n";
+  summaryStream.flush();
+  WriteUtf8ToConsoleSizeT(summary.data(), summary.size());
+  return failed;
+}
+
 // Finds DXIL module from the blob assuming blob is either DxilContainer, DxilPartHeader, or DXIL module
 HRESULT DxaContext::FindModule(hlsl::DxilFourCC fourCC, IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcBlob **ppTargetBlob) {
   if (!pSource || !pLibrary || !ppTargetBlob)
@@ -361,8 +505,22 @@ int __cdecl main(int argc, _In_reads_z_(argc) char **argv) {
         return 1;
       }
     }
+    else if (Batch) {
+      pStage = "Assembling";
+      if (!OutputFilename.empty()) {
+        printf("-o cannot be used with -batch.\n");
+        return 1;
+      }
+      if (context.AssembleBatch() != 0) {
+        return 1;
+      }
+    }
     else {
       pStage = "Assembling";
+      if (!BatchInputFilenames.empty()) {
+        printf("More than one input file requires -batch.\n");
+        return 1;
+      }
       context.Assemble();
     }
   } catch (const ::hlsl::Exception &hlslException) {
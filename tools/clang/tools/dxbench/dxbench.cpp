@@ -0,0 +1,1045 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxbench.cpp                                                               //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the entry point for the dxbench console program, which measures  //
+// compiler throughput over a corpus of shaders.                             //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/Global.h"
+#include "dxc/Support/Unicode.h"
+#include "dxc/Support/WinIncludes.h"
+#include <vector>
+#include <string>
+
+#include "dxc/dxcapi.h"
+#include "dxc/Support/dxcapi.use.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <Psapi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+#pragma comment(lib, "psapi.lib")
+
+inline bool wcsieq(LPCWSTR a, LPCWSTR b) { return _wcsicmp(a, b) == 0; }
+inline bool wcsistarts(LPCWSTR text, LPCWSTR prefix) {
+  return wcslen(text) >= wcslen(prefix) && _wcsnicmp(text, prefix, wcslen(prefix)) == 0;
+}
+inline bool wcsieqopt(LPCWSTR text, LPCWSTR opt) {
+  return (text[0] == L'-' || text[0] == L'/') && wcsieq(text + 1, opt);
+}
+
+static dxc::DxcDllSupport g_DxcSupport;
+
+// A shader of the corpus, with the entry point, profile and other arguments
+// taken from the first RUN line that invokes dxc.
+struct CorpusShader {
+  std::wstring FileName;
+  CComPtr<IDxcBlobEncoding> Source;
+  std::wstring EntryPoint;
+  std::wstring TargetProfile;
+  std::vector<std::wstring> Arguments;
+};
+
+// The time spent in one phase over every compilation of a configuration.
+struct PhaseTotals {
+  double WallMs = 0;
+  double CpuMs = 0;
+};
+
+// The results of compiling the corpus at one optimization level on a given
+// number of threads.
+struct BenchConfiguration {
+  unsigned OptLevel;
+  unsigned Threads;
+  unsigned Compiled = 0;
+  unsigned Failed = 0;
+  double WallMs = 0;
+  uint64_t PeakWorkingSetBytes = 0;
+  std::map<std::string, PhaseTotals> Phases;
+  // Counters of the time reports, such as the lock waits, summed.
+  std::map<std::string, uint64_t> Counters;
+};
+
+static void PrintHelp() {
+  wprintf(L"%s",
+    L"Measures compiler throughput over a corpus of shaders.\n"
+    L"\n"
+    L"dxbench.exe [options] <file or directory>...\n"
+    L"dxbench.exe -sema [-iterations=N] [-o=FILE]\n"
+    L"dxbench.exe -matrix [-iterations=N] [-o=FILE]\n"
+    L"dxbench.exe -scaling [options] [<file or directory>...]\n"
+    L"\n"
+    L"Directories are searched recursively for .hlsl files. The entry point,\n"
+    L"profile and other arguments of each shader are taken from its first\n"
+    L"'RUN: %dxc' line; files without one are skipped.\n"
+    L"\n"
+    L"Options:\n"
+    L"  -O=LEVELS       Comma-separated optimization levels (default 0,1,2,3)\n"
+    L"  -threads=LIST   Comma-separated thread counts (default 1 and the\n"
+    L"                  number of hardware threads)\n"
+    L"  -iterations=N   Compile the corpus N times per configuration (default 1)\n"
+    L"  -o=FILE         Write the results as JSON to FILE\n"
+    L"  -sema           Run the Sema microbenchmarks instead of a corpus:\n"
+    L"                  external source initialization, intrinsic matching,\n"
+    L"                  shorthand type lookup and template specialization\n"
+    L"  -matrix         Run the matrix lowering benchmarks instead of a corpus:\n"
+    L"                  palette skinning and matrix blending\n"
+    L"  -scaling        Measure throughput at 1, 2, 4... threads up to the\n"
+    L"                  number of hardware threads, unless -threads is given;\n"
+    L"                  without inputs, the matrix benchmark shaders are the\n"
+    L"                  corpus\n"
+    L"  -shared         Compile on every thread with one compiler object\n"
+    L"\n"
+    L"Speedup and efficiency are relative to the fewest threads at the same\n"
+    L"level. Lock waits are the time spent waiting for locks held by other\n"
+    L"compilations, summed over threads.\n"
+    L"  -?              Print this help\n");
+}
+
+static bool ParseUnsignedList(LPCWSTR text, std::vector<unsigned> &values) {
+  values.clear();
+  while (*text) {
+    wchar_t *pEnd;
+    unsigned long value = wcstoul(text, &pEnd, 10);
+    if (pEnd == text)
+      return false;
+    values.push_back((unsigned)value);
+    text = pEnd;
+    if (*text == L',')
+      ++text;
+    else if (*text)
+      return false;
+  }
+  return !values.empty();
+}
+
+static bool IsOptLevelArg(llvm::StringRef arg) {
+  return arg.size() == 3 && (arg[0] == '-' || arg[0] == '/') &&
+         (arg[1] == 'O') && (arg[2] == 'd' || (arg[2] >= '0' && arg[2] <= '3'));
+}
+
+static bool IsOutputArg(llvm::StringRef arg) {
+  return arg.size() >= 3 && (arg[0] == '-' || arg[0] == '/') && arg[1] == 'F';
+}
+
+// Reads the dxc arguments of the first RUN line of the source. Returns false
+// if there is none or it has no profile. Output file and optimization level
+// arguments are dropped, and include directories are made relative to the
+// shader's directory.
+static bool ReadRunLine(llvm::StringRef text, llvm::StringRef directory,
+                        CorpusShader &shader) {
+  size_t runPos = text.find("RUN: %dxc");
+  if (runPos == llvm::StringRef::npos)
+    return false;
+  llvm::StringRef line = text.substr(runPos + strlen("RUN: %dxc"));
+  line = line.substr(0, line.find_first_of("\r\n"));
+  line = line.substr(0, line.find('|'));
+
+  llvm::SmallVector<llvm::StringRef, 16> tokens;
+  line.split(tokens, " ", -1, false);
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    llvm::StringRef token = tokens[i];
+    bool hasNext = i + 1 < tokens.size();
+    if (token.startswith("%"))
+      continue;
+    if ((token == "-E" || token == "/E") && hasNext) {
+      shader.EntryPoint = Unicode::UTF8ToUTF16StringOrThrow(tokens[++i].str().c_str());
+      continue;
+    }
+    if ((token == "-T" || token == "/T") && hasNext) {
+      shader.TargetProfile = Unicode::UTF8ToUTF16StringOrThrow(tokens[++i].str().c_str());
+      continue;
+    }
+    if (IsOptLevelArg(token))
+      continue;
+    if (IsOutputArg(token)) {
+      if (hasNext && tokens[i + 1].startswith("%"))
+        ++i;
+      continue;
+    }
+    shader.Arguments.push_back(Unicode::UTF8ToUTF16StringOrThrow(token.str().c_str()));
+    if ((token == "-I" || token == "/I") && hasNext) {
+      std::string includeDir = (directory + "\\" + tokens[++i]).str();
+      shader.Arguments.push_back(Unicode::UTF8ToUTF16StringOrThrow(includeDir.c_str()));
+    }
+  }
+  return !shader.TargetProfile.empty();
+}
+
+static void AddCorpusFile(const std::wstring &fileName,
+                          std::vector<CorpusShader> &corpus) {
+  CorpusShader shader;
+  shader.FileName = fileName;
+  dxc::ReadFileIntoBlob(g_DxcSupport, fileName.c_str(), &shader.Source);
+
+  std::string fileNameUtf8 = Unicode::UTF16ToUTF8StringOrThrow(fileName.c_str());
+  llvm::StringRef directory(fileNameUtf8);
+  directory = directory.substr(0, directory.find_last_of("\\/"));
+  llvm::StringRef text((const char *)shader.Source->GetBufferPointer(),
+                       shader.Source->GetBufferSize());
+  if (ReadRunLine(text, directory, shader))
+    corpus.push_back(std::move(shader));
+}
+
+// Adds the .hlsl files under the directory, in name order so that the corpus
+// is the same on every run.
+static void AddCorpusDirectory(const std::wstring &directory,
+                               std::vector<CorpusShader> &corpus) {
+  std::vector<std::wstring> files, subdirectories;
+  WIN32_FIND_DATAW findData;
+  HANDLE hFind = FindFirstFileW((directory + L"\\*").c_str(), &findData);
+  if (hFind == INVALID_HANDLE_VALUE)
+    IFT(HRESULT_FROM_WIN32(GetLastError()));
+  do {
+    std::wstring name = findData.cFileName;
+    if (name == L"." || name == L"..")
+      continue;
+    if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      subdirectories.push_back(directory + L"\\" + name);
+    else if (name.size() > 5 &&
+             wcsieq(name.c_str() + name.size() - 5, L".hlsl"))
+      files.push_back(directory + L"\\" + name);
+  } while (FindNextFileW(hFind, &findData));
+  FindClose(hFind);
+
+  std::sort(files.begin(), files.end());
+  std::sort(subdirectories.begin(), subdirectories.end());
+  for (const std::wstring &file : files)
+    AddCorpusFile(file, corpus);
+  for (const std::wstring &subdirectory : subdirectories)
+    AddCorpusDirectory(subdirectory, corpus);
+}
+
+static const char *ReadReportNumber(const char *pCursor, const char *pKey,
+                                    double *pValue) {
+  const char *pFound = strstr(pCursor, pKey);
+  if (pFound == nullptr) {
+    return nullptr;
+  }
+  char *pEnd;
+  *pValue = strtod(pFound + strlen(pKey), &pEnd);
+  return pEnd;
+}
+
+// Adds the phases and, if pCounterTotals is given, the counters of a
+// -ftime-report report to the totals.
+static void AddTimeReport(IDxcBlobEncoding *pReport,
+                          std::map<std::string, PhaseTotals> &phases,
+                          std::map<std::string, uint64_t> *pCounterTotals) {
+  std::string report((const char *)pReport->GetBufferPointer(),
+                     pReport->GetBufferSize());
+  const char *pCursor = strstr(report.c_str(), "\"phases\": [");
+  const char *pCounters = strstr(report.c_str(), "\"counters\": [");
+  if (pCursor == nullptr)
+    return;
+
+  static const char NameKey[] = "\"name\": \"";
+  for (;;) {
+    const char *pName = strstr(pCursor, NameKey);
+    if (pName == nullptr || (pCounters != nullptr && pName > pCounters))
+      break;
+    pName += strlen(NameKey);
+    const char *pNameEnd = strchr(pName, '"');
+    IFTBOOL(pNameEnd != nullptr, E_FAIL);
+    double wallMs, cpuMs;
+    pCursor = ReadReportNumber(pNameEnd, "\"wallMs\": ", &wallMs);
+    IFTBOOL(pCursor != nullptr, E_FAIL);
+    pCursor = ReadReportNumber(pCursor, "\"cpuMs\": ", &cpuMs);
+    IFTBOOL(pCursor != nullptr, E_FAIL);
+    PhaseTotals &totals = phases[std::string(pName, pNameEnd)];
+    totals.WallMs += wallMs;
+    totals.CpuMs += cpuMs;
+  }
+  if (pCounters == nullptr || pCounterTotals == nullptr)
+    return;
+
+  for (pCursor = pCounters;;) {
+    const char *pName = strstr(pCursor, NameKey);
+    if (pName == nullptr)
+      break;
+    pName += strlen(NameKey);
+    const char *pNameEnd = strchr(pName, '"');
+    IFTBOOL(pNameEnd != nullptr, E_FAIL);
+    double value;
+    pCursor = ReadReportNumber(pNameEnd, "\"value\": ", &value);
+    IFTBOOL(pCursor != nullptr, E_FAIL);
+    (*pCounterTotals)[std::string(pName, pNameEnd)] += (uint64_t)value;
+  }
+}
+
+static uint64_t GetPeakWorkingSetBytes() {
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize;
+}
+
+// Compiles one shader at the given level. Returns false if it failed.
+static bool CompileShader(IDxcCompiler *pCompiler,
+                          IDxcIncludeHandler *pIncludeHandler,
+                          const CorpusShader &shader, LPCWSTR pOptLevel,
+                          std::map<std::string, PhaseTotals> &phases,
+                          std::map<std::string, uint64_t> *pCounters) {
+  std::vector<LPCWSTR> arguments;
+  for (const std::wstring &arg : shader.Arguments)
+    arguments.push_back(arg.c_str());
+  arguments.push_back(pOptLevel);
+  arguments.push_back(L"-ftime-report");
+
+  CComPtr<IDxcOperationResult> pResult;
+  if (FAILED(pCompiler->Compile(shader.Source, shader.FileName.c_str(),
+                                shader.EntryPoint.c_str(),
+                                shader.TargetProfile.c_str(), arguments.data(),
+                                (UINT32)arguments.size(), nullptr, 0,
+                                pIncludeHandler, &pResult)))
+    return false;
+  HRESULT status;
+  if (FAILED(pResult->GetStatus(&status)) || FAILED(status))
+    return false;
+
+  CComPtr<IDxcTimeReportResult> pTimeReportResult;
+  CComPtr<IDxcBlobEncoding> pReport;
+  if (SUCCEEDED(pResult.QueryInterface(&pTimeReportResult)) &&
+      SUCCEEDED(pTimeReportResult->GetTimeReport(&pReport)) &&
+      pReport != nullptr)
+    AddTimeReport(pReport, phases, pCounters);
+  return true;
+}
+
+// Compiles the corpus the given number of times on a pool of threads, each
+// with its own compiler unless sharedCompiler is set, and records the failing
+// files.
+static void RunConfiguration(const std::vector<CorpusShader> &corpus,
+                             unsigned iterations, bool sharedCompiler,
+                             BenchConfiguration &config,
+                             std::set<std::wstring> &failedFiles) {
+  wchar_t optLevel[4] = L"-O0";
+  optLevel[2] = L'0' + config.OptLevel;
+
+  const size_t jobCount = corpus.size() * iterations;
+  std::atomic<size_t> nextJob(0);
+  std::vector<std::map<std::string, PhaseTotals>> threadPhases(config.Threads);
+  std::vector<std::map<std::string, uint64_t>> threadCounters(config.Threads);
+  std::vector<std::vector<size_t>> threadFailures(config.Threads);
+  std::vector<HRESULT> threadStatus(config.Threads, S_OK);
+  CComPtr<IDxcCompiler> pSharedCompiler;
+  if (sharedCompiler)
+    IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &pSharedCompiler));
+  auto worker = [&](unsigned threadIndex) {
+    try {
+      CComPtr<IDxcLibrary> pLibrary;
+      CComPtr<IDxcCompiler> pCompiler = pSharedCompiler;
+      CComPtr<IDxcIncludeHandler> pIncludeHandler;
+      IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+      if (pCompiler == nullptr)
+        IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+      IFT(pLibrary->CreateIncludeHandler(&pIncludeHandler));
+      for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+        size_t shaderIndex = i % corpus.size();
+        if (!CompileShader(pCompiler, pIncludeHandler, corpus[shaderIndex],
+                           optLevel, threadPhases[threadIndex],
+                           &threadCounters[threadIndex]))
+          threadFailures[threadIndex].push_back(shaderIndex);
+      }
+    } catch (const ::hlsl::Exception &hlslException) {
+      threadStatus[threadIndex] = hlslException.hr;
+    } catch (std::bad_alloc &) {
+      threadStatus[threadIndex] = E_OUTOFMEMORY;
+    } catch (...) {
+      threadStatus[threadIndex] = E_FAIL;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < config.Threads; ++i)
+    threads.emplace_back(worker, i);
+  worker(0);
+  for (std::thread &t : threads)
+    t.join();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  for (HRESULT hr : threadStatus)
+    IFT(hr);
+  config.WallMs = elapsed.count();
+  config.PeakWorkingSetBytes = GetPeakWorkingSetBytes();
+  for (unsigned i = 0; i < config.Threads; ++i) {
+    config.Failed += (unsigned)threadFailures[i].size();
+    for (size_t shaderIndex : threadFailures[i])
+      failedFiles.insert(corpus[shaderIndex].FileName);
+    for (const auto &phase : threadPhases[i]) {
+      PhaseTotals &totals = config.Phases[phase.first];
+      totals.WallMs += phase.second.WallMs;
+      totals.CpuMs += phase.second.CpuMs;
+    }
+    for (const auto &counter : threadCounters[i])
+      config.Counters[counter.first] += counter.second;
+  }
+  config.Compiled = (unsigned)jobCount - config.Failed;
+}
+
+static double ShadersPerSecond(const BenchConfiguration &config) {
+  return config.WallMs > 0 ? config.Compiled * 1000.0 / config.WallMs : 0;
+}
+
+// Returns the throughput of the configuration relative to the one with the
+// fewest threads at the same level, and that relative to the thread count.
+static void GetScaling(const std::vector<BenchConfiguration> &configs,
+                       const BenchConfiguration &config, double *pSpeedup,
+                       double *pEfficiency) {
+  const BenchConfiguration *pBase = &config;
+  for (const BenchConfiguration &other : configs) {
+    if (other.OptLevel == config.OptLevel && other.Threads < pBase->Threads)
+      pBase = &other;
+  }
+  double baseRate = ShadersPerSecond(*pBase);
+  *pSpeedup = baseRate > 0 ? ShadersPerSecond(config) / baseRate : 0;
+  *pEfficiency = *pSpeedup * pBase->Threads / config.Threads;
+}
+
+static bool IsLockWaitCounter(llvm::StringRef name) {
+  return name.startswith("lock.") && name.endswith(".waitUs");
+}
+
+// The time spent waiting for locks, summed over every lock and thread.
+static double LockWaitMs(const BenchConfiguration &config) {
+  uint64_t waitUs = 0;
+  for (const auto &counter : config.Counters) {
+    if (IsLockWaitCounter(counter.first))
+      waitUs += counter.second;
+  }
+  return waitUs / 1000.0;
+}
+
+static void WriteJsonString(llvm::raw_ostream &OS, llvm::StringRef value) {
+  OS << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      OS << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      OS << ' ';
+    else
+      OS << c;
+  }
+  OS << '"';
+}
+
+static void WriteTextToFile(IDxcLibrary *pLibrary, const std::string &text,
+                            LPCWSTR pFileName) {
+  CComPtr<IDxcBlobEncoding> pBlob;
+  IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+      text.data(), (UINT32)text.size(), CP_UTF8, &pBlob));
+  dxc::WriteBlobToFile(pBlob, pFileName);
+}
+
+// Writes the results as JSON. Keys, configurations and phases always come
+// in the same order, so that reports of two compiler drops can be diffed.
+static void WriteJson(llvm::raw_ostream &OS, size_t corpusSize,
+                      unsigned iterations,
+                      const std::vector<BenchConfiguration> &configs,
+                      const std::set<std::wstring> &failedFiles) {
+  OS << "{\n  \"shaders\": " << corpusSize
+     << ",\n  \"iterations\": " << iterations
+     << ",\n  \"configurations\": [";
+  for (size_t i = 0; i < configs.size(); ++i) {
+    const BenchConfiguration &config = configs[i];
+    OS << (i ? ",\n" : "\n") << "    {\n"
+       << "      \"optLevel\": " << config.OptLevel << ",\n"
+       << "      \"threads\": " << config.Threads << ",\n"
+       << "      \"compiled\": " << config.Compiled << ",\n"
+       << "      \"failed\": " << config.Failed << ",\n"
+       << "      \"wallMs\": " << llvm::format("%.3f", config.WallMs) << ",\n"
+       << "      \"shadersPerSecond\": "
+       << llvm::format("%.3f", ShadersPerSecond(config)) << ",\n"
+       << "      \"peakWorkingSetBytes\": " << config.PeakWorkingSetBytes
+       << ",\n";
+    double speedup, efficiency;
+    GetScaling(configs, config, &speedup, &efficiency);
+    OS << "      \"speedup\": " << llvm::format("%.3f", speedup) << ",\n"
+       << "      \"efficiency\": " << llvm::format("%.3f", efficiency)
+       << ",\n      \"phases\": [";
+    bool first = true;
+    for (const auto &phase : config.Phases) {
+      OS << (first ? "\n" : ",\n") << "        { \"name\": ";
+      WriteJsonString(OS, phase.first);
+      OS << ", \"wallMs\": " << llvm::format("%.3f", phase.second.WallMs)
+         << ", \"cpuMs\": " << llvm::format("%.3f", phase.second.CpuMs)
+         << " }";
+      first = false;
+    }
+    OS << "\n      ],\n      \"counters\": [";
+    first = true;
+    for (const auto &counter : config.Counters) {
+      OS << (first ? "\n" : ",\n") << "        { \"name\": ";
+      WriteJsonString(OS, counter.first);
+      OS << ", \"value\": " << counter.second << " }";
+      first = false;
+    }
+    OS << "\n      ]\n    }";
+  }
+  OS << "\n  ],\n  \"failedFiles\": [";
+  bool first = true;
+  for (const std::wstring &fileName : failedFiles) {
+    OS << (first ? "\n" : ",\n") << "    ";
+    WriteJsonString(OS, Unicode::UTF16ToUTF8StringOrThrow(fileName.c_str()));
+    first = false;
+  }
+  OS << "\n  ]\n}\n";
+}
+
+// Prints one line per configuration, then the ten slowest phases and the
+// waits for each contended lock of each.
+static void PrintTable(const std::vector<BenchConfiguration> &configs) {
+  std::string text;
+  llvm::raw_string_ostream OS(text);
+  OS << "level threads compiled failed    wall ms  shaders/s  speedup  "
+        "efficiency  lock wait ms  peak MB\n";
+  for (const BenchConfiguration &config : configs) {
+    double speedup, efficiency;
+    GetScaling(configs, config, &speedup, &efficiency);
+    OS << llvm::format("  -O%u %7u %8u %6u %10.1f %10.1f %8.2f %10.0f%% "
+                       "%13.1f %8.1f\n",
+                       config.OptLevel, config.Threads, config.Compiled,
+                       config.Failed, config.WallMs, ShadersPerSecond(config),
+                       speedup, efficiency * 100, LockWaitMs(config),
+                       config.PeakWorkingSetBytes / (1024.0 * 1024.0));
+  }
+  for (const BenchConfiguration &config : configs) {
+    std::vector<std::pair<double, const std::string *>> phases;
+    for (const auto &phase : config.Phases)
+      phases.push_back(std::make_pair(phase.second.WallMs, &phase.first));
+    std::sort(phases.rbegin(), phases.rend());
+    OS << "\n-O" << config.OptLevel << ", " << config.Threads
+       << " threads, slowest phases (wall ms summed over threads):\n";
+    for (size_t i = 0; i < phases.size() && i < 10; ++i)
+      OS << llvm::format("  %10.1f  ", phases[i].first) << *phases[i].second
+         << "\n";
+    for (const auto &counter : config.Counters) {
+      if (!IsLockWaitCounter(counter.first))
+        continue;
+      llvm::StringRef lock = llvm::StringRef(counter.first)
+                                 .drop_front(strlen("lock."))
+                                 .drop_back(strlen(".waitUs"));
+      auto contended =
+          config.Counters.find("lock." + lock.str() + ".contended");
+      OS << llvm::format("  %10.1f  ", counter.second / 1000.0)
+         << "waiting for " << lock << " ("
+         << (contended == config.Counters.end() ? 0 : contended->second)
+         << " contended acquisitions)\n";
+    }
+  }
+  OS.flush();
+  dxc::WriteUtf8ToConsoleSizeT(text.data(), text.size());
+}
+
+// Sema microbenchmarks.
+//
+// Each generates a translation unit that stresses one frontend path and
+// times it with -fcgl, so that optimization and validation are skipped. The
+// frontend time is the parse phase, which includes semantic analysis, less
+// the IR generation it triggers for each top-level declaration.
+
+typedef void (*SemaSourceGenerator)(llvm::raw_ostream &OS);
+
+static void GenerateExternalSourceInit(llvm::raw_ostream &OS) {
+  OS << "float4 main() : SV_Target { return 0; }\n";
+}
+
+// 10k intrinsic calls over scalar, vector and integer overloads.
+static void GenerateIntrinsicMatching(llvm::raw_ostream &OS) {
+  static const char *Calls[] = {
+    "r += abs(a);",
+    "ri += abs(i);",
+    "r.x += dot(a, r);",
+    "r.y += dot(a.xy, r.zw);",
+    "r += mad(a, r, a);",
+    "r.xy += lerp(a.xy, r.zw, 0.5);",
+    "r = max(a, r);",
+    "ri = min(i, ri);",
+    "r = clamp(r, 0, 1);",
+    "r = saturate(r);",
+    "r += sin(a) * cos(r);",
+    "r.xyz += cross(a.xyz, r.xyz);",
+    "r.z += length(a.xyz);",
+    "u += countbits(u);",
+    "r.w += asfloat(u.x);",
+    "r += frac(a) + floor(r);",
+  };
+  OS << "float4 main(float4 a : A, int4 i : I, uint4 u : U) : SV_Target {\n"
+        "  float4 r = 0;\n  int4 ri = 0;\n";
+  for (unsigned n = 0; n < 10000; ++n)
+    OS << "  " << Calls[n % _countof(Calls)] << "\n";
+  OS << "  return r + ri + u;\n}\n";
+}
+
+// 5k local typedefs of shorthand vector and matrix names.
+static void GenerateShorthandLookup(llvm::raw_ostream &OS) {
+  static const char *Names[] = {
+    "float2", "float3x4", "min16float4", "int2", "uint3x3", "half4",
+    "bool2", "double2", "min16int3", "min16uint2", "float1x4", "int4x4",
+    "uint1", "min10float3", "min12int2x2", "double3x2",
+  };
+  OS << "float4 main() : SV_Target {\n";
+  for (unsigned n = 0; n < 5000; ++n)
+    OS << "  typedef " << Names[n % _countof(Names)] << " t" << n << ";\n";
+  OS << "  return 0;\n}\n";
+}
+
+// 2k vector and matrix template uses and 500 structured buffers of distinct
+// element types.
+static void GenerateSpecializations(llvm::raw_ostream &OS) {
+  static const char *Scalars[] = {
+    "float", "int", "uint", "bool", "half", "double", "min16float",
+    "min16int", "min16uint", "min10float", "min12int",
+  };
+  for (unsigned n = 0; n < 500; ++n)
+    OS << "struct S" << n << " { float" << n % 4 + 1 << " f; };\n"
+       << "StructuredBuffer<S" << n << "> sb" << n << ";\n";
+  OS << "float4 main() : SV_Target {\n";
+  for (unsigned n = 0; n < 2000; ++n) {
+    const char *scalar = Scalars[n % _countof(Scalars)];
+    if (n % 2)
+      OS << "  typedef vector<" << scalar << ", " << n % 4 + 1 << "> v" << n
+         << ";\n";
+    else
+      OS << "  typedef matrix<" << scalar << ", " << n % 4 + 1 << ", "
+         << (n / 4) % 4 + 1 << "> m" << n << ";\n";
+  }
+  OS << "  return 0;\n}\n";
+}
+
+struct SemaBenchmark {
+  const char *Name;
+  SemaSourceGenerator Generate;
+  std::vector<double> WallMs;
+  std::vector<double> FrontendMs;
+  std::vector<double> InitializeMs;
+};
+
+static double Median(std::vector<double> values) {
+  if (values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+static double PhaseWallMs(const std::map<std::string, PhaseTotals> &phases,
+                          const char *pName) {
+  auto found = phases.find(pName);
+  return found == phases.end() ? 0 : found->second.WallMs;
+}
+
+// Runs every Sema microbenchmark the given number of times on one thread and
+// reports the median times. Returns the number of benchmarks that failed to
+// compile.
+static unsigned RunSemaBenchmarks(unsigned iterations, LPCWSTR outFileName) {
+  SemaBenchmark benchmarks[] = {
+    { "ExternalSourceInit", GenerateExternalSourceInit },
+    { "IntrinsicMatching", GenerateIntrinsicMatching },
+    { "ShorthandLookup", GenerateShorthandLookup },
+    { "Specializations", GenerateSpecializations },
+  };
+
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcCompiler> pCompiler;
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+
+  unsigned failed = 0;
+  std::string failures;
+  for (SemaBenchmark &bench : benchmarks) {
+    std::string text;
+    llvm::raw_string_ostream OS(text);
+    bench.Generate(OS);
+    OS.flush();
+
+    CorpusShader shader;
+    shader.FileName = Unicode::UTF8ToUTF16StringOrThrow(bench.Name) + L".hlsl";
+    shader.EntryPoint = L"main";
+    shader.TargetProfile = L"ps_6_0";
+    shader.Arguments.push_back(L"-fcgl");
+    IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+        text.data(), (UINT32)text.size(), CP_UTF8, &shader.Source));
+
+    for (unsigned i = 0; i < iterations; ++i) {
+      std::map<std::string, PhaseTotals> phases;
+      auto start = std::chrono::steady_clock::now();
+      if (!CompileShader(pCompiler, nullptr, shader, L"-O0", phases,
+                         nullptr)) {
+        ++failed;
+        failures += std::string(bench.Name) + " failed to compile.\n";
+        break;
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      bench.WallMs.push_back(elapsed.count());
+      bench.FrontendMs.push_back(PhaseWallMs(phases, "Parse") -
+                                 PhaseWallMs(phases, "CodeGenTopLevelDecl"));
+      bench.InitializeMs.push_back(PhaseWallMs(phases, "InitializeHLSLSource"));
+    }
+  }
+
+  std::string table;
+  llvm::raw_string_ostream OS(table);
+  OS << failures
+     << "benchmark            wall ms  frontend ms  initialize ms  (medians)\n";
+  for (const SemaBenchmark &bench : benchmarks)
+    OS << llvm::format("%-18s %9.2f %12.2f %14.2f\n", bench.Name,
+                       Median(bench.WallMs), Median(bench.FrontendMs),
+                       Median(bench.InitializeMs));
+  OS.flush();
+  dxc::WriteUtf8ToConsoleSizeT(table.data(), table.size());
+
+  if (outFileName != nullptr) {
+    std::string json;
+    llvm::raw_string_ostream JS(json);
+    JS << "{\n  \"iterations\": " << iterations << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < _countof(benchmarks); ++i) {
+      const SemaBenchmark &bench = benchmarks[i];
+      JS << (i ? ",\n" : "\n") << "    { \"name\": ";
+      WriteJsonString(JS, bench.Name);
+      JS << ", \"runs\": " << bench.WallMs.size() << ", \"wallMs\": "
+         << llvm::format("%.3f", Median(bench.WallMs)) << ", \"frontendMs\": "
+         << llvm::format("%.3f", Median(bench.FrontendMs))
+         << ", \"initializeMs\": "
+         << llvm::format("%.3f", Median(bench.InitializeMs)) << " }";
+    }
+    JS << "\n  ]\n}\n";
+    JS.flush();
+    WriteTextToFile(pLibrary, json, outFileName);
+  }
+  return failed;
+}
+
+// Matrix lowering benchmarks.
+//
+// Each generates a shader with thousands of matrix operations and times the
+// whole compile and the HL matrix lower pass within it.
+
+// 1k palette blends of two cbuffer matrices, each transforming a position.
+static void GenerateSkinning(llvm::raw_ostream &OS) {
+  OS << "cbuffer Bones { float4x4 bones[64]; };\n"
+        "float4 main(float4 pos : POSITION, float4 w : BLENDWEIGHT)"
+        " : SV_Position {\n"
+        "  float4 r = 0;\n  float4x4 m;\n";
+  for (unsigned n = 0; n < 1000; ++n)
+    OS << "  m = bones[" << (n * 7) % 64 << "] * w.x + bones["
+       << (n * 13 + 1) % 64 << "] * w.y;\n"
+       << "  r += mul(pos, m);\n";
+  OS << "  return r;\n}\n";
+}
+
+// 4k unary, binary, intrinsic and cast operations on local matrices.
+static void GenerateMatrixBlending(llvm::raw_ostream &OS) {
+  static const char *Statements[] = {
+    "a = lerp(a, b, t);",
+    "b = transpose(a) * t + b;",
+    "a = mul(a, b);",
+    "c = (float3x3)a + c;",
+    "b = -b + abs(a);",
+    "h = (float4x3)b * 0.5;",
+    "a = max(a, b) - min(a, b);",
+    "r += mul(a, mul(b, v));",
+  };
+  OS << "float4 main(float4x4 a : A, float4x4 b : B, float4 v : V,"
+        " float t : T) : SV_Target {\n"
+        "  float4 r = 0;\n  float3x3 c = 0;\n  float4x3 h = 0;\n";
+  for (unsigned n = 0; n < 4000; ++n)
+    OS << "  " << Statements[n % _countof(Statements)] << "\n";
+  OS << "  return r + c[0].xyzz + h[0].xyzz;\n}\n";
+}
+
+struct MatrixBenchmark {
+  const char *Name;
+  SemaSourceGenerator Generate;
+  LPCWSTR TargetProfile;
+  std::vector<double> WallMs;
+  std::vector<double> LowerMs;
+};
+
+// Runs every matrix lowering benchmark the given number of times on one
+// thread and reports the median times. Returns the number of benchmarks
+// that failed to compile.
+static unsigned RunMatrixBenchmarks(unsigned iterations, LPCWSTR outFileName) {
+  MatrixBenchmark benchmarks[] = {
+    { "Skinning", GenerateSkinning, L"vs_6_0" },
+    { "MatrixBlending", GenerateMatrixBlending, L"ps_6_0" },
+  };
+
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcCompiler> pCompiler;
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+
+  unsigned failed = 0;
+  std::string failures;
+  for (MatrixBenchmark &bench : benchmarks) {
+    std::string text;
+    llvm::raw_string_ostream OS(text);
+    bench.Generate(OS);
+    OS.flush();
+
+    CorpusShader shader;
+    shader.FileName = Unicode::UTF8ToUTF16StringOrThrow(bench.Name) + L".hlsl";
+    shader.EntryPoint = L"main";
+    shader.TargetProfile = bench.TargetProfile;
+    IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+        text.data(), (UINT32)text.size(), CP_UTF8, &shader.Source));
+
+    for (unsigned i = 0; i < iterations; ++i) {
+      std::map<std::string, PhaseTotals> phases;
+      auto start = std::chrono::steady_clock::now();
+      if (!CompileShader(pCompiler, nullptr, shader, L"-O0", phases,
+                         nullptr)) {
+        ++failed;
+        failures += std::string(bench.Name) + " failed to compile.\n";
+        break;
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      bench.WallMs.push_back(elapsed.count());
+      bench.LowerMs.push_back(PhaseWallMs(phases, "HL matrix lower"));
+    }
+  }
+
+  std::string table;
+  llvm::raw_string_ostream OS(table);
+  OS << failures << "benchmark            wall ms  matrix lower ms  (medians)\n";
+  for (const MatrixBenchmark &bench : benchmarks)
+    OS << llvm::format("%-18s %9.2f %16.2f\n", bench.Name,
+                       Median(bench.WallMs), Median(bench.LowerMs));
+  OS.flush();
+  dxc::WriteUtf8ToConsoleSizeT(table.data(), table.size());
+
+  if (outFileName != nullptr) {
+    std::string json;
+    llvm::raw_string_ostream JS(json);
+    JS << "{\n  \"iterations\": " << iterations << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < _countof(benchmarks); ++i) {
+      const MatrixBenchmark &bench = benchmarks[i];
+      JS << (i ? ",\n" : "\n") << "    { \"name\": ";
+      WriteJsonString(JS, bench.Name);
+      JS << ", \"runs\": " << bench.WallMs.size() << ", \"wallMs\": "
+         << llvm::format("%.3f", Median(bench.WallMs))
+         << ", \"matrixLowerMs\": "
+         << llvm::format("%.3f", Median(bench.LowerMs)) << " }";
+    }
+    JS << "\n  ]\n}\n";
+    JS.flush();
+    WriteTextToFile(pLibrary, json, outFileName);
+  }
+  return failed;
+}
+
+// Adds the matrix lowering benchmark shaders to the corpus, so that scaling
+// can be measured without one.
+static void AddGeneratedCorpus(std::vector<CorpusShader> &corpus) {
+  MatrixBenchmark benchmarks[] = {
+    { "Skinning", GenerateSkinning, L"vs_6_0" },
+    { "MatrixBlending", GenerateMatrixBlending, L"ps_6_0" },
+  };
+
+  CComPtr<IDxcLibrary> pLibrary;
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  for (MatrixBenchmark &bench : benchmarks) {
+    std::string text;
+    llvm::raw_string_ostream OS(text);
+    bench.Generate(OS);
+    OS.flush();
+
+    CorpusShader shader;
+    shader.FileName = Unicode::UTF8ToUTF16StringOrThrow(bench.Name) + L".hlsl";
+    shader.EntryPoint = L"main";
+    shader.TargetProfile = bench.TargetProfile;
+    IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+        text.data(), (UINT32)text.size(), CP_UTF8, &shader.Source));
+    corpus.push_back(std::move(shader));
+  }
+}
+
+int __cdecl wmain(int argc, const wchar_t **argv_) {
+  const char *pStage = "Operation";
+  try {
+    // Parse command line options.
+    pStage = "Argument processing";
+
+    std::vector<unsigned> optLevels = {0, 1, 2, 3};
+    std::vector<unsigned> threadCounts;
+    unsigned iterations = 1;
+    LPCWSTR outFileName = nullptr;
+    bool runSema = false;
+    bool runMatrix = false;
+    bool runScaling = false;
+    bool sharedCompiler = false;
+    std::vector<LPCWSTR> inputs;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+      LPCWSTR arg = argv_[argIdx];
+      if (wcsieqopt(arg, L"?")) {
+        PrintHelp();
+        return 0;
+      }
+      else if (wcsistarts(arg, L"-O=")) {
+        if (!ParseUnsignedList(arg + 3, optLevels) ||
+            *std::max_element(optLevels.begin(), optLevels.end()) > 3) {
+          wprintf(L"Optimization levels must be between 0 and 3.\n");
+          return 1;
+        }
+      }
+      else if (wcsistarts(arg, L"-threads=")) {
+        if (!ParseUnsignedList(arg + 9, threadCounts) ||
+            *std::min_element(threadCounts.begin(), threadCounts.end()) == 0) {
+          wprintf(L"Thread counts must be positive.\n");
+          return 1;
+        }
+      }
+      else if (wcsistarts(arg, L"-iterations=")) {
+        iterations = wcstoul(arg + 12, nullptr, 10);
+        if (iterations == 0) {
+          wprintf(L"The iteration count must be positive.\n");
+          return 1;
+        }
+      }
+      else if (wcsistarts(arg, L"-o=")) {
+        outFileName = arg + 3;
+      }
+      else if (wcsieqopt(arg, L"sema")) {
+        runSema = true;
+      }
+      else if (wcsieqopt(arg, L"matrix")) {
+        runMatrix = true;
+      }
+      else if (wcsieqopt(arg, L"scaling")) {
+        runScaling = true;
+      }
+      else if (wcsieqopt(arg, L"shared")) {
+        sharedCompiler = true;
+      }
+      else if (arg[0] == L'-' || arg[0] == L'/') {
+        wprintf(L"Unknown option %s.\n", arg);
+        PrintHelp();
+        return 1;
+      }
+      else {
+        inputs.push_back(arg);
+      }
+    }
+    if (runSema) {
+      if (!inputs.empty()) {
+        wprintf(L"-sema does not take input files.\n");
+        return 1;
+      }
+      pStage = "Running the Sema microbenchmarks";
+      dxc::EnsureEnabled(g_DxcSupport);
+      return RunSemaBenchmarks(iterations, outFileName) == 0 ? 0 : 1;
+    }
+    if (runMatrix) {
+      if (!inputs.empty()) {
+        wprintf(L"-matrix does not take input files.\n");
+        return 1;
+      }
+      pStage = "Running the matrix lowering benchmarks";
+      dxc::EnsureEnabled(g_DxcSupport);
+      return RunMatrixBenchmarks(iterations, outFileName) == 0 ? 0 : 1;
+    }
+    if (inputs.empty() && !runScaling) {
+      PrintHelp();
+      return 1;
+    }
+    if (threadCounts.empty()) {
+      unsigned hardwareThreads = std::thread::hardware_concurrency();
+      threadCounts.push_back(1);
+      for (unsigned threads = 2; runScaling && threads < hardwareThreads;
+           threads *= 2)
+        threadCounts.push_back(threads);
+      if (hardwareThreads > 1)
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    pStage = "Loading the corpus";
+    dxc::EnsureEnabled(g_DxcSupport);
+    std::vector<CorpusShader> corpus;
+    for (LPCWSTR input : inputs) {
+      DWORD attributes = GetFileAttributesW(input);
+      if (attributes == INVALID_FILE_ATTRIBUTES)
+        dxc::IFT_Data(HRESULT_FROM_WIN32(GetLastError()), input);
+      if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+        AddCorpusDirectory(input, corpus);
+      else
+        AddCorpusFile(input, corpus);
+    }
+    if (inputs.empty())
+      AddGeneratedCorpus(corpus);
+    if (corpus.empty()) {
+      wprintf(L"No shaders with a 'RUN: %%dxc' line were found.\n");
+      return 1;
+    }
+
+    pStage = "Compiling";
+    std::vector<BenchConfiguration> configs;
+    std::set<std::wstring> failedFiles;
+    for (unsigned optLevel : optLevels) {
+      for (unsigned threads : threadCounts) {
+        BenchConfiguration config;
+        config.OptLevel = optLevel;
+        config.Threads = threads;
+        RunConfiguration(corpus, iterations, sharedCompiler, config,
+                         failedFiles);
+        configs.push_back(std::move(config));
+      }
+    }
+
+    pStage = "Writing results";
+    PrintTable(configs);
+    if (outFileName != nullptr) {
+      std::string json;
+      llvm::raw_string_ostream OS(json);
+      WriteJson(OS, corpus.size(), iterations, configs, failedFiles);
+      OS.flush();
+      CComPtr<IDxcLibrary> pLibrary;
+      IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+      WriteTextToFile(pLibrary, json, outFileName);
+    }
+  }
+  catch (const ::hlsl::Exception &hlslException) {
+    try {
+      const char *msg = hlslException.what();
+      Unicode::acp_char printBuffer[128]; // printBuffer is safe to treat as
+                                          // UTF-8 because we use ASCII only errors
+                                          // only
+      if (msg == nullptr || *msg == '\0') {
+        sprintf_s(printBuffer, _countof(printBuffer),
+                  "%s failed - error code 0x%08x.", pStage, hlslException.hr);
+        msg = printBuffer;
+      }
+      printf("%s\n", msg);
+    }
+    catch (...) {
+      printf("%s failed - unable to retrieve error message.\n", pStage);
+    }
+
+    return 1;
+  }
+  catch (std::bad_alloc &) {
+    printf("%s failed - out of memory.\n", pStage);
+    return 1;
+  }
+  catch (...) {
+    printf("%s failed - unknown error.\n", pStage);
+    return 1;
+  }
+
+  return 0;
+}
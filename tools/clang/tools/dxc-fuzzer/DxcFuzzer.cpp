@@ -0,0 +1,365 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxcFuzzer.cpp                                                             //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the entry point for dxc-fuzzer, a libFuzzer harness that looks   //
+// for HLSL inputs that compile too slowly or use too much memory.           //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/Global.h"
+#include "dxc/Support/Unicode.h"
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/dxcapi.h"
+#include "dxc/Support/dxcapi.use.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "FuzzerInterface.h"
+#include "FuzzerInternal.h"
+#include <chrono>
+#include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using fuzzer::Unit;
+
+// Options of the harness. libFuzzer exits on flags it does not know, so
+// these are removed from the command line before it is parsed. Workers
+// started with -jobs only see the libFuzzer flags and read the thresholds
+// from the environment instead.
+struct HarnessOptions {
+  unsigned SlowMs = 0;        // A compile taking longer is a finding.
+  unsigned MemoryMb = 0;      // A compile allocating more is a finding.
+  std::string FindingsDir = ".";
+  std::string Minimize;       // Input to minimize instead of fuzzing.
+  unsigned MinimizeRuns = 500;
+  std::string SeedCorpus;     // Directory to write the seed corpus to.
+};
+
+static HarnessOptions g_Options;
+static dxc::DxcDllSupport g_DxcSupport;
+static CComPtr<IDxcLibrary> g_pLibrary;
+static CComPtr<IDxcCompiler> g_pCompiler;
+static std::unordered_set<std::string> g_ReportedFindings;
+
+enum class FindingKind { None, Slow, Memory };
+
+struct CompileOutcome {
+  FindingKind Kind = FindingKind::None;
+  double WallMs = 0;
+  UINT64 PeakBytes = 0;
+};
+
+static const char *GetFindingPrefix(FindingKind kind) {
+  return kind == FindingKind::Slow ? "slow-" : "memory-";
+}
+
+static bool ReadUnsignedFlag(llvm::StringRef arg, llvm::StringRef name,
+                             unsigned &value) {
+  if (!arg.startswith(name))
+    return false;
+  value = (unsigned)strtoul(arg.substr(name.size()).str().c_str(), nullptr, 10);
+  return true;
+}
+
+static bool ReadStringFlag(llvm::StringRef arg, llvm::StringRef name,
+                           std::string &value) {
+  if (!arg.startswith(name))
+    return false;
+  value = arg.substr(name.size());
+  return true;
+}
+
+static void ReadEnvironmentOptions() {
+  if (const char *pSlowMs = getenv("DXC_FUZZER_SLOW_MS"))
+    g_Options.SlowMs = (unsigned)strtoul(pSlowMs, nullptr, 10);
+  if (const char *pMemoryMb = getenv("DXC_FUZZER_MEMORY_MB"))
+    g_Options.MemoryMb = (unsigned)strtoul(pMemoryMb, nullptr, 10);
+  if (const char *pFindingsDir = getenv("DXC_FUZZER_FINDINGS_DIR"))
+    g_Options.FindingsDir = pFindingsDir;
+}
+
+// Moves the harness options out of argv, leaving the libFuzzer ones.
+static void ReadHarnessOptions(int &argc, char **argv) {
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    llvm::StringRef arg(argv[i]);
+    if (!ReadUnsignedFlag(arg, "-slow_ms=", g_Options.SlowMs) &&
+        !ReadUnsignedFlag(arg, "-memory_mb=", g_Options.MemoryMb) &&
+        !ReadStringFlag(arg, "-findings_dir=", g_Options.FindingsDir) &&
+        !ReadStringFlag(arg, "-minimize=", g_Options.Minimize) &&
+        !ReadUnsignedFlag(arg, "-minimize_runs=", g_Options.MinimizeRuns) &&
+        !ReadStringFlag(arg, "-seed_corpus=", g_Options.SeedCorpus))
+      argv[kept++] = argv[i];
+  }
+  argc = kept;
+  argv[argc] = nullptr;
+}
+
+static void PrintHarnessHelp() {
+  fuzzer::Printf("%s",
+    "dxc-fuzzer [harness options] [libFuzzer options] [corpus dirs]\n"
+    "dxc-fuzzer -seed_corpus=DIR <file or directory>...\n"
+    "dxc-fuzzer -minimize=FILE [harness options]\n"
+    "\n"
+    "Compiles each input as HLSL. The entry point and profile come from the\n"
+    "input's 'RUN: %dxc' line, or are main and ps_6_0. An input that takes\n"
+    "longer or allocates more than the thresholds is written to the findings\n"
+    "directory as slow-<sha1> or memory-<sha1>, and fuzzing continues.\n"
+    "\n"
+    "Harness options:\n"
+    "  -slow_ms=T         Compiles taking more than T ms are findings.\n"
+    "  -memory_mb=M       Compiles allocating more than M MB are findings.\n"
+    "  -findings_dir=DIR  Where findings are written (default: .).\n"
+    "  -seed_corpus=DIR   Copy the .hlsl files found under the inputs, for\n"
+    "                     example tools/clang/test/CodeGenHLSL, into DIR as\n"
+    "                     a flat corpus.\n"
+    "  -minimize=FILE     Shrink a finding while it stays one of the same\n"
+    "                     kind and write it to FILE.min.\n"
+    "  -minimize_runs=N   Compiles the minimizer may run (default: 500).\n"
+    "\n"
+    "DXC_FUZZER_SLOW_MS, DXC_FUZZER_MEMORY_MB and DXC_FUZZER_FINDINGS_DIR set\n"
+    "the defaults, which is how -jobs workers are configured. Use -max_len\n"
+    "to let libFuzzer grow inputs to the size of real shaders, and -timeout\n"
+    "to abort on compiles that never finish. -tokens=hlsl_fuzzer_tokens.txt,\n"
+    "from the harness sources, fuzzes sequences of HLSL tokens instead.\n"
+    "\n");
+}
+
+static void InitializeCompiler() {
+  IFT(g_DxcSupport.Initialize());
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &g_pLibrary));
+  IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &g_pCompiler));
+  if (g_Options.MemoryMb != 0) {
+    CComPtr<IDxcMemoryAccounting> pAccounting;
+    IFT(g_pCompiler.QueryInterface(&pAccounting));
+    IFT(pAccounting->SetMemoryAccounting(
+        TRUE, (UINT64)g_Options.MemoryMb * 1024 * 1024));
+  }
+}
+
+// Reads the entry point, profile, defines and optimization level from the
+// first RUN line of the input. Other arguments are ignored so that mutated
+// RUN lines cannot make the compiler write files.
+static void ReadRunLine(llvm::StringRef text, std::wstring &entryPoint,
+                        std::wstring &targetProfile,
+                        std::vector<std::wstring> &arguments) {
+  entryPoint = L"main";
+  targetProfile = L"ps_6_0";
+  size_t runPos = text.find("RUN: %dxc");
+  if (runPos == llvm::StringRef::npos)
+    return;
+  llvm::StringRef line = text.substr(runPos + strlen("RUN: %dxc"));
+  line = line.substr(0, line.find_first_of("\r\n"));
+  line = line.substr(0, line.find('|'));
+
+  llvm::SmallVector<llvm::StringRef, 16> tokens;
+  line.split(tokens, " ", -1, false);
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    llvm::StringRef token = tokens[i];
+    bool hasNext = i + 1 < tokens.size();
+    if (token.empty() || (token[0] != '-' && token[0] != '/'))
+      continue;
+    llvm::StringRef name = token.substr(1);
+    std::wstring value;
+    if ((name == "E" || name == "T" || name == "D") && hasNext) {
+      if (!Unicode::UTF8ToUTF16String(tokens[++i].str().c_str(), &value))
+        continue;
+      if (name == "E")
+        entryPoint = value;
+      else if (name == "T")
+        targetProfile = value;
+      else {
+        arguments.push_back(L"-D");
+        arguments.push_back(value);
+      }
+    } else if (name == "Od" || name == "O0" || name == "O1" || name == "O2" ||
+               name == "O3") {
+      Unicode::UTF8ToUTF16String(token.str().c_str(), &value);
+      arguments.push_back(value);
+    }
+  }
+}
+
+static CompileOutcome CompileInput(const uint8_t *pData, size_t size) {
+  CompileOutcome outcome;
+  llvm::StringRef text((const char *)pData, size);
+  std::wstring entryPoint, targetProfile;
+  std::vector<std::wstring> arguments;
+  ReadRunLine(text, entryPoint, targetProfile, arguments);
+  std::vector<LPCWSTR> argumentPtrs;
+  for (const std::wstring &arg : arguments)
+    argumentPtrs.push_back(arg.c_str());
+
+  CComPtr<IDxcBlobEncoding> pSource;
+  IFT(g_pLibrary->CreateBlobWithEncodingFromPinned(
+      (LPBYTE)pData, (UINT32)size, CP_UTF8, &pSource));
+
+  CComPtr<IDxcOperationResult> pResult;
+  auto start = std::chrono::steady_clock::now();
+  HRESULT hr = g_pCompiler->Compile(
+      pSource, L"fuzz.hlsl", entryPoint.c_str(), targetProfile.c_str(),
+      argumentPtrs.data(), (UINT32)argumentPtrs.size(), nullptr, 0, nullptr,
+      &pResult);
+  outcome.WallMs = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start).count();
+
+  HRESULT status = hr;
+  if (SUCCEEDED(hr))
+    pResult->GetStatus(&status);
+  CComPtr<IDxcMemoryUsageResult> pUsage;
+  UINT64 totalBytes;
+  if (pResult != nullptr && SUCCEEDED(pResult.QueryInterface(&pUsage)))
+    pUsage->GetMemoryUsage(&outcome.PeakBytes, &totalBytes);
+
+  if (g_Options.MemoryMb != 0 && status == E_OUTOFMEMORY)
+    outcome.Kind = FindingKind::Memory;
+  else if (g_Options.SlowMs != 0 && outcome.WallMs > g_Options.SlowMs)
+    outcome.Kind = FindingKind::Slow;
+  return outcome;
+}
+
+extern "C" void LLVMFuzzerTestOneInput(const uint8_t *pData, size_t size) {
+  CompileOutcome outcome;
+  try {
+    outcome = CompileInput(pData, size);
+  } catch (...) {
+    // Inputs the harness cannot pass to the compiler are not findings.
+    return;
+  }
+  if (outcome.Kind == FindingKind::None)
+    return;
+  Unit unit(pData, pData + size);
+  std::string name = GetFindingPrefix(outcome.Kind) + fuzzer::Hash(unit);
+  if (!g_ReportedFindings.insert(name).second)
+    return;
+  std::string path = fuzzer::DirPlusFile(g_Options.FindingsDir, name);
+  fuzzer::WriteToFile(unit, path);
+  if (outcome.Kind == FindingKind::Slow)
+    fuzzer::Printf("SLOW INPUT: %.0f ms; file written to %s\n",
+                   outcome.WallMs, path.c_str());
+  else
+    fuzzer::Printf("MEMORY LIMIT EXCEEDED: file written to %s\n",
+                   path.c_str());
+}
+
+// Shrinks the input while it stays a finding of the same kind: first by
+// removing runs of lines, halving the run length down to a single line, then
+// by removing runs of bytes the same way.
+static int MinimizeFinding() {
+  Unit unit = fuzzer::FileToVector(g_Options.Minimize);
+  CompileOutcome outcome = CompileInput(unit.data(), unit.size());
+  if (outcome.Kind == FindingKind::None) {
+    fuzzer::Printf("%s is not a finding with these thresholds.\n",
+                   g_Options.Minimize.c_str());
+    return 1;
+  }
+  FindingKind kind = outcome.Kind;
+  unsigned runs = 1;
+
+  auto tryRemove = [&](size_t begin, size_t end) {
+    if (runs >= g_Options.MinimizeRuns)
+      return false;
+    Unit candidate(unit.begin(), unit.begin() + begin);
+    candidate.insert(candidate.end(), unit.begin() + end, unit.end());
+    ++runs;
+    if (CompileInput(candidate.data(), candidate.size()).Kind != kind)
+      return false;
+    unit.swap(candidate);
+    return true;
+  };
+
+  for (bool byLines : {true, false}) {
+    auto splitPoints = [&]() {
+      std::vector<size_t> points(1, 0);
+      for (size_t i = 0; i < unit.size(); ++i) {
+        if (!byLines || unit[i] == '\n')
+          points.push_back(i + 1);
+      }
+      if (points.back() != unit.size())
+        points.push_back(unit.size());
+      return points;
+    };
+    size_t pieces = splitPoints().size() - 1;
+    for (size_t run = pieces / 2; run >= 1 && runs < g_Options.MinimizeRuns;
+         run /= 2) {
+      // Walk from the end so that a removal leaves the earlier split points
+      // in place.
+      std::vector<size_t> points = splitPoints();
+      for (size_t end = points.size() - 1; end >= run; end -= run)
+        tryRemove(points[end - run], points[end]);
+    }
+  }
+
+  std::string path = g_Options.Minimize + ".min";
+  fuzzer::WriteToFile(unit, path);
+  fuzzer::Printf("Minimized to %zu bytes in %u compiles; written to %s\n",
+                 unit.size(), runs, path.c_str());
+  return 0;
+}
+
+// Writes the .hlsl files found under the inputs to the seed corpus
+// directory, named by their hash as libFuzzer does.
+static int WriteSeedCorpus(int argc, char **argv) {
+  unsigned count = 0;
+  auto addFile = [&count](llvm::StringRef fileName) {
+    if (!llvm::sys::path::extension(fileName).equals_lower(".hlsl"))
+      return;
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(fileName);
+    if (!buffer)
+      return;
+    llvm::StringRef text = (*buffer)->getBuffer();
+    Unit unit(text.begin(), text.end());
+    fuzzer::WriteToFile(
+        unit, fuzzer::DirPlusFile(g_Options.SeedCorpus, fuzzer::Hash(unit)));
+    ++count;
+  };
+
+  if (llvm::sys::fs::create_directories(g_Options.SeedCorpus)) {
+    fuzzer::Printf("Cannot create %s.\n", g_Options.SeedCorpus.c_str());
+    return 1;
+  }
+  for (int i = 1; i < argc; ++i) {
+    if (!llvm::sys::fs::is_directory(argv[i])) {
+      addFile(argv[i]);
+      continue;
+    }
+    std::error_code ec;
+    for (llvm::sys::fs::recursive_directory_iterator it(argv[i], ec), end;
+         it != end && !ec; it.increment(ec))
+      addFile(it->path());
+  }
+  fuzzer::Printf("Wrote %u seeds to %s\n", count, g_Options.SeedCorpus.c_str());
+  return count != 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  ReadEnvironmentOptions();
+  ReadHarnessOptions(argc, argv);
+  if (argc > 1 && llvm::StringRef(argv[1]) == "-help=1")
+    PrintHarnessHelp();
+
+  if (!g_Options.SeedCorpus.empty())
+    return WriteSeedCorpus(argc, argv);
+
+  try {
+    InitializeCompiler();
+  } catch (const ::hlsl::Exception &hlslException) {
+    fuzzer::Printf("Loading the compiler failed - error code 0x%08x.\n",
+                   hlslException.hr);
+    return 1;
+  }
+
+  if (!g_Options.Minimize.empty())
+    return MinimizeFinding();
+  return fuzzer::FuzzerDriver(argc, argv, LLVMFuzzerTestOneInput);
+}
@@ -53,15 +53,40 @@
 #include "dxc/HLSL/DxilRootSignature.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/microcom.h"
+#include "dxc/HLSL/DxilModule.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Option/OptTable.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/StringSaver.h"
 #include <dia2.h>
 #include <comdef.h>
+#include <Shlwapi.h>
+#include <Psapi.h>
+#include <fcntl.h>
+#include <io.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
+#pragma comment(lib, "shlwapi.lib")
+#pragma comment(lib, "psapi.lib")
+
 inline bool wcseq(LPCWSTR a, LPCWSTR b) {
   return (a == nullptr && b == nullptr) || (a != nullptr && b != nullptr && wcscmp(a, b) == 0);
 }
@@ -76,6 +101,9 @@ class DxcContext {
 private:
   DxcOpts &m_Opts;
   DxcDllSupport &m_dxcSupport;
+  IDxcCompiler *m_pWorkerCompiler = nullptr;
+  IDxcIncludeHandler *m_pWorkerIncludeHandler = nullptr;
+  std::string *m_pWorkerDiagnostics = nullptr;
 
   int ActOnBlob(IDxcBlob *pBlob);
   int ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugBlobName);
@@ -85,26 +113,73 @@ private:
                    llvm::Twine &pVariableName, LPCWSTR pPath);
   HRESULT ReadFileIntoPartContent(hlsl::DxilFourCC fourCC, LPCWSTR fileName, IDxcBlob **ppResult);
   
-  // TODO : Refactor two functions below. There are duplicate functions in DxcContext in dxa.cpp
-  HRESULT GetDxcDiaTable(IDxcLibrary *pLibrary, IDxcBlob *pTargetBlob, IDiaTable **ppTable, LPCWSTR tableName);
+  // TODO : Refactor the function below. There is a duplicate function in DxcContext in dxa.cpp
   HRESULT FindModuleBlob(hlsl::DxilFourCC fourCC, IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcBlob **ppTargetBlob);
   void ExtractRootSignature(IDxcBlob *pBlob, IDxcBlob **ppResult);
+  void WriteShaderStatistics(IDxcBlob *pBlob);
   int VerifyRootSignature();
+  void CompileOnce(IDxcCompiler *pCompiler, IDxcOperationResult **ppResult,
+                   IDxcBlob **ppDebugBlob, std::wstring &debugName);
+  bool VerifyDeterminism(IDxcBlob *pProgram);
 
 public:
   DxcContext(DxcOpts &Opts, DxcDllSupport &dxcSupport)
       : m_Opts(Opts), m_dxcSupport(dxcSupport) {}
 
+  // Makes Compile use the given compiler instead of creating one, and collect
+  // its warnings and errors instead of writing them to the console, for
+  // batch workers that run compiles side by side. A given include handler is
+  // used in place of the default one.
+  void SetBatchWorker(IDxcCompiler *pCompiler, std::string *pDiagnostics,
+                      IDxcIncludeHandler *pIncludeHandler = nullptr) {
+    m_pWorkerCompiler = pCompiler;
+    m_pWorkerDiagnostics = pDiagnostics;
+    m_pWorkerIncludeHandler = pIncludeHandler;
+  }
+
   int  Compile();
   void Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcCompiler *pCompiler, std::vector<LPCWSTR> &args, IDxcOperationResult **pCompileResult);
   int DumpBinary();
   void Preprocess();
+  void WriteDependencies();
+  int WritePackage();
 };
 
 static void WriteBlobToFile(_In_opt_ IDxcBlob *pBlob, llvm::StringRef FName) {
   ::dxc::WriteBlobToFile(pBlob, StringRefUtf16(FName));
 }
 
+// Streams the disassembly to the file as it is produced, so large listings
+// are never held in memory.
+static void WriteDisassemblyToFile(IDxcCompilerDisassembly *pDisassembly,
+                                   IDxcBlob *pProgram, llvm::StringRef FName) {
+  StringRefUtf16 WideName(FName);
+  CComPtr<IStream> pStream;
+  IFT_Data(SHCreateStreamOnFileEx(WideName,
+                                  STGM_WRITE | STGM_CREATE | STGM_SHARE_DENY_WRITE,
+                                  FILE_ATTRIBUTE_NORMAL, TRUE, nullptr, &pStream),
+           WideName);
+  IFT(pDisassembly->DisassembleToStream(pProgram, DxcDisassembleSection_All,
+                                        nullptr, 0, pStream));
+}
+
+static void WriteDataToFile(const char *pData, DWORD dataLen,
+                            llvm::StringRef FName) {
+  StringRefUtf16 WideName(FName);
+  CHandle file(CreateFile2(WideName, GENERIC_WRITE, FILE_SHARE_READ,
+                           CREATE_ALWAYS, nullptr));
+  if (file == INVALID_HANDLE_VALUE) {
+    IFT_Data(HRESULT_FROM_WIN32(GetLastError()), WideName);
+  }
+  DWORD written;
+  if (FALSE == WriteFile(file, pData, dataLen, &written, nullptr)) {
+    IFT_Data(HRESULT_FROM_WIN32(GetLastError()), WideName);
+  }
+  if (written != dataLen) {
+    IFT_Data(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), WideName);
+  }
+}
+
 static void WritePartToFile(IDxcBlob *pBlob, hlsl::DxilFourCC CC,
                             llvm::StringRef FName) {
   const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
@@ -119,18 +194,24 @@ static void WritePartToFile(IDxcBlob *pBlob, hlsl::DxilFourCC CC,
     throw hlsl::Exception(E_FAIL, "Unable to find required part in blob");
   }
 
-  const char *pData = hlsl::GetDxilPartData(*it);
-  DWORD dataLen = (*it)->PartSize;
-  StringRefUtf16 WideName(FName);
-  CHandle file(CreateFile2(WideName, GENERIC_WRITE, FILE_SHARE_READ,
-                           CREATE_ALWAYS, nullptr));
-  if (file == INVALID_HANDLE_VALUE) {
-    IFT_Data(HRESULT_FROM_WIN32(GetLastError()), WideName);
-  }
-  DWORD written;
-  if (FALSE == WriteFile(file, pData, dataLen, &written, nullptr)) {
-    IFT_Data(HRESULT_FROM_WIN32(GetLastError()), WideName);
+  WriteDataToFile(hlsl::GetDxilPartData(*it), (*it)->PartSize, FName);
+}
+
+// Writes the content of the debug info part, decompressing it if needed, so
+// the debug file is the same whether or not the container compresses it.
+static void WriteDebugPartToFile(IDxcBlob *pBlob, llvm::StringRef FName) {
+  const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+      pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+  llvm::SmallVector<char, 0> DecompressedData;
+  const hlsl::DxilProgramHeader *pProgramHeader =
+      pContainer ? hlsl::GetDxilDebugProgramHeader(pContainer, DecompressedData)
+                 : nullptr;
+  if (!pProgramHeader) {
+    throw hlsl::Exception(E_FAIL, "Unable to find required part in blob");
   }
+
+  WriteDataToFile(reinterpret_cast<const char *>(pProgramHeader),
+                  pProgramHeader->SizeInUint32 * sizeof(uint32_t), FName);
 }
 
 // This function is called either after the compilation is done or /dumpbin option is provided
@@ -175,7 +256,7 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugB
       WriteBlobToFile(pDebugBlob, pDebugBlobName);
     }
     else {
-      WritePartToFile(pBlob, hlsl::DFCC_ShaderDebugInfoDXIL, m_Opts.DebugFile);
+      WriteDebugPartToFile(pBlob, m_Opts.DebugFile);
     }
   }
 
@@ -191,11 +272,16 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugB
     WritePartToFile(pBlob, hlsl::DFCC_PrivateData, m_Opts.ExtractPrivateFile);
   }
 
+  // Compute and write static shader statistics.
+  if (!m_Opts.StatisticsFile.empty()) {
+    WriteShaderStatistics(pBlob);
+  }
+
   // OutputObject suppresses console dump.
   bool needDisassembly =
       !m_Opts.OutputHeader.empty() || !m_Opts.AssemblyCode.empty() ||
       (m_Opts.OutputObject.empty() && m_Opts.DebugFile.empty() &&
-       m_Opts.ExtractPrivateFile.empty() &&
+       m_Opts.ExtractPrivateFile.empty() && m_Opts.StatisticsFile.empty() &&
        m_Opts.VerifyRootSignatureSource.empty() && !m_Opts.ExtractRootSignature);
 
   if (!needDisassembly)
@@ -212,6 +298,12 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugB
   } else {
       CComPtr<IDxcCompiler> pCompiler;
       IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+      CComPtr<IDxcCompilerDisassembly> pDisassembly;
+      if (m_Opts.OutputHeader.empty() && !m_Opts.AssemblyCode.empty() &&
+          SUCCEEDED(pCompiler.QueryInterface(&pDisassembly))) {
+        WriteDisassemblyToFile(pDisassembly, pBlob, m_Opts.AssemblyCode);
+        return retVal;
+      }
       IFT(pCompiler->Disassemble(pBlob, &pDisassembleResult));
   }
   
@@ -229,6 +321,36 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugB
   return retVal;
 }
 
+// Runs the statistics pass over the program part and writes its report.
+void DxcContext::WriteShaderStatistics(IDxcBlob *pBlob) {
+  const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+      pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+  const hlsl::DxilProgramHeader *pProgramHeader =
+      pContainer ? hlsl::GetDxilProgramHeader(pContainer, hlsl::DFCC_DXIL)
+                 : nullptr;
+  IFTBOOLMSG(pProgramHeader, E_INVALIDARG,
+             "/Fstats specified, but no DXIL program was found");
+
+  const char *pBitcode;
+  uint32_t bitcodeLength;
+  hlsl::GetDxilProgramBitcode(pProgramHeader, &pBitcode, &bitcodeLength);
+
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcBlobEncoding> pProgram;
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(pLibrary->CreateBlobWithEncodingFromPinned(
+      (LPBYTE)pBitcode, bitcodeLength, CP_ACP, &pProgram));
+
+  CComPtr<IDxcOptimizer> pOptimizer;
+  CComPtr<IDxcBlobEncoding> pStatistics;
+  LPCWSTR Options[] = { L"-hlsl-dxil-shader-stats",
+                        L"-hlsl-dxil-tgsm-bank-conflicts" };
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcOptimizer, &pOptimizer));
+  IFT(pOptimizer->RunOptimizer(pProgram, Options, _countof(Options), nullptr,
+                               &pStatistics));
+  WriteBlobToFile(pStatistics, m_Opts.StatisticsFile);
+}
+
 // Given a dxil container, update the dxil container by processing container specific options.
 void DxcContext::UpdatePart(IDxcBlob *pSource, IDxcBlob **ppResult) {
   DXASSERT(pSource && ppResult, "otherwise blob cannot be updated");
@@ -247,7 +369,13 @@ void DxcContext::UpdatePart(IDxcBlob *pSource, IDxcBlob **ppResult) {
 
   // Update parts based on dxc options
   if (m_Opts.StripDebug) {
-    IFT(pContainerBuilder->RemovePart(hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL));
+    const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+        pSource->GetBufferPointer(), pSource->GetBufferSize());
+    bool isCompressed = pContainer && hlsl::GetDxilPartByType(
+        pContainer, hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXILCompressed);
+    IFT(pContainerBuilder->RemovePart(
+        isCompressed ? hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXILCompressed
+                     : hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL));
   }
   if (m_Opts.StripPrivate) {
     IFT(pContainerBuilder->RemovePart(hlsl::DxilFourCC::DFCC_PrivateData));
@@ -461,141 +589,106 @@ public:
   }
 };
 
+// Returns operand i of the node, which must be a string.
+static llvm::StringRef GetMDStringOperand(const llvm::MDNode *pNode,
+                                          unsigned i) {
+  const llvm::MDString *pString =
+      i < pNode->getNumOperands()
+          ? llvm::dyn_cast_or_null<llvm::MDString>(pNode->getOperand(i))
+          : nullptr;
+  IFTBOOL(pString != nullptr, DXC_E_CONTAINER_MISSING_DEBUG);
+  return pString->getString();
+}
+
+// Recompiles from the sources and defines recorded in the debug module. Only
+// the module-level records are read, and the sources are compiled in place
+// from the metadata strings, which outlive the compile.
 void DxcContext::Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcCompiler *pCompiler, std::vector<LPCWSTR> &args, IDxcOperationResult **ppCompileResult) {
   CComPtr<IDxcBlob> pTargetBlob;
   IFT(FindModuleBlob(hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL, pSource, pLibrary, &pTargetBlob));
-  // Retrieve necessary data from DIA symbols for recompiling
-  CComPtr<IDiaTable> pSymbolTable;
-  IFT(GetDxcDiaTable(pLibrary, pTargetBlob, &pSymbolTable, L"Symbols"));
-  IFTARG(pSymbolTable != nullptr);
-  std::wstring Arguments;   // Backing storage for blob arguments
-  std::wstring BlobDefines; // Backing storage for blob defines
-  std::string EntryPoint = m_Opts.EntryPoint;
-  std::string TargetProfile = m_Opts.TargetProfile;
-  std::vector<LPCWSTR> ConcatArgs;      // Blob arguments + command-line arguments
-  std::vector<DxcDefine> ConcatDefines; // Blob defines + command-line defines
-  CComBSTR pMainFileName;
-  ULONG fetched;
-  for (;;) {
-    CComPtr<IUnknown> pSymbolUnk;
-    CComPtr<IDiaSymbol> pSymbol;
-    DWORD symTag;
-    IFT(pSymbolTable->Next(1, &pSymbolUnk, &fetched));
-    if (fetched == 0) {
-      break;
-    }
-    IFT(pSymbolUnk->QueryInterface(&pSymbol));
-    IFT(pSymbol->get_symTag(&symTag));
 
-    CComBSTR pName;
-    pSymbol->get_name(&pName);
+  llvm::LLVMContext llvmContext;
+  std::unique_ptr<llvm::MemoryBuffer> pBitcodeBuf(
+      llvm::MemoryBuffer::getMemBuffer(
+          llvm::StringRef((const char *)pTargetBlob->GetBufferPointer(),
+                          pTargetBlob->GetBufferSize()),
+          "", false));
+  llvm::ErrorOr<std::unique_ptr<llvm::Module>> pModuleOrErr =
+      llvm::getLazyBitcodeModule(std::move(pBitcodeBuf), llvmContext);
+  if (std::error_code ec = pModuleOrErr.getError()) {
+    throw hlsl::Exception(DXC_E_CONTAINER_MISSING_DEBUG,
+                          "Unable to read the debug module: " + ec.message());
+  }
+  std::unique_ptr<llvm::Module> pModule = std::move(pModuleOrErr.get());
 
-    if (symTag == SymTagCompiland && wcseq(pName, L"main")) {
-      pMainFileName.Empty();
-      IFT(pSymbol->get_sourceFileName(&pMainFileName));
-      continue;
-    }
+  std::string EntryPoint = m_Opts.EntryPoint;
+  std::string TargetProfile = m_Opts.TargetProfile;
+  if (EntryPoint.empty() || TargetProfile.empty()) {
+    hlsl::DxilModule &DM = pModule->GetOrCreateDxilModule();
+    if (EntryPoint.empty())
+      EntryPoint = DM.GetEntryFunctionName();
+    if (TargetProfile.empty())
+      TargetProfile = DM.GetShaderModel()->GetName();
+  }
 
-    // Check for well-known compiland environment values (name/value pairs).
-    if (symTag != SymTagCompilandEnv) {
-      continue;
-    }
+  std::wstring MainFileName;
+  llvm::NamedMDNode *pMainFileName =
+      pModule->getNamedMetadata("llvm.dbg.mainFileName");
+  IFTBOOL(pMainFileName && pMainFileName->getNumOperands() != 0,
+          DXC_E_CONTAINER_MISSING_DEBUG);
+  MainFileName = Unicode::UTF8ToUTF16StringOrThrow(
+      GetMDStringOperand(pMainFileName->getOperand(0), 0).str().c_str());
 
-    CComVariant pVariant;
-    IFT(pSymbol->get_value(&pVariant));
-    if (EntryPoint.empty() && wcseq(pName, L"hlslEntry")) {
-      IFTARG(VARENUM::VT_BSTR == pVariant.vt);
-      EntryPoint = Unicode::UTF16ToUTF8StringOrThrow(pVariant.bstrVal);
-      continue;
-    }
-    if (TargetProfile.empty() && wcseq(pName, L"hlslTarget")) {
-      IFTARG(VARENUM::VT_BSTR == pVariant.vt);
-      TargetProfile = Unicode::UTF16ToUTF8StringOrThrow(pVariant.bstrVal);
-      continue;
-    }
-    if (wcseq(pName, L"hlslArguments")) {
-      IFTARG(VARENUM::VT_BSTR == pVariant.vt);
-      Arguments = pVariant.bstrVal;
-      continue;
+  // Defines are recorded as "name=value" or "name".
+  std::vector<std::wstring> BlobDefines; // Backing storage for blob defines
+  std::vector<LPCWSTR> ConcatArgs;      // Blob arguments + command-line arguments
+  std::vector<DxcDefine> ConcatDefines; // Blob defines + command-line defines
+  llvm::NamedMDNode *pDefines = pModule->getNamedMetadata("llvm.dbg.defines");
+  if (pDefines && pDefines->getNumOperands() != 0) {
+    const llvm::MDNode *pDefineList = pDefines->getOperand(0);
+    BlobDefines.reserve(pDefineList->getNumOperands());
+    for (unsigned i = 0; i < pDefineList->getNumOperands(); ++i) {
+      llvm::StringRef Define = GetMDStringOperand(pDefineList, i);
+      if (!Define.empty())
+        BlobDefines.push_back(
+            Unicode::UTF8ToUTF16StringOrThrow(Define.str().c_str()));
     }
-
-    if (wcseq(pName, L"hlslDefines")) {
-      IFTARG(VARENUM::VT_BSTR == pVariant.vt);
-      // Parsing double null terminated string of defines into ConcatDefines.
-      BlobDefines = std::wstring(pVariant.bstrVal, SysStringLen(pVariant.bstrVal));
-      ConcatDefines.clear();
-      LPWSTR Defines = const_cast<wchar_t *>(BlobDefines.data());
-      UINT32 begin = 0;
-      for (UINT32 i = 0;; ++i) {
-        if (Defines[i] != L'\0') {
-          continue;
-        }
-        if (begin != i) {
-          wchar_t *pDefineStart = Defines + begin;
-          wchar_t *pDefineEnd = Defines + i;
-          DxcDefine D;
-          D.Name = Defines + begin;
-          D.Value = nullptr;
-          for (wchar_t *pCursor = pDefineStart; pCursor < pDefineEnd+ i; ++pCursor) {
-            if (*pCursor == L'=') {
-              *pCursor = L'\0';
-              D.Value = (pCursor + 1);
-              break;
-            }
-          }
-          ConcatDefines.push_back(D);
-        }
-        if (Defines[i + 1] == L'\0') {
-          break;
-        }
-        begin = i + 1;
+    for (std::wstring &Define : BlobDefines) {
+      DxcDefine D;
+      D.Name = Define.c_str();
+      D.Value = nullptr;
+      size_t equals = Define.find(L'=');
+      if (equals != std::wstring::npos) {
+        Define[equals] = L'\0';
+        D.Value = Define.c_str() + equals + 1;
       }
+      ConcatDefines.push_back(D);
     }
   }
 
-  // Extracting file content from the blob
-  CComPtr<IDiaTable> pInjectedSourceTable;
-  IFT(GetDxcDiaTable(pLibrary, pTargetBlob, &pInjectedSourceTable, L"InjectedSource"));
-  IFTARG(pInjectedSourceTable != nullptr);
+  // Extracting file content from the module, without copying it.
   CComPtr<IDxcBlobEncoding> pCompileSource;
   CComPtr<DxcIncludeHandlerForInjectedSources> pIncludeHandler = new DxcIncludeHandlerForInjectedSources();
-  for (;;) {
-    CComPtr<IUnknown> pInjectedSourcesUnk;
-    ULONG fetched;
-    IFT(pInjectedSourceTable->Next(1, &pInjectedSourcesUnk, &fetched));
-    if (fetched == 0) {
-      break;
-    }
-    CComPtr<IDiaInjectedSource> pInjectedSource;
-    IFT(pInjectedSourcesUnk->QueryInterface(&pInjectedSource));
-
-    // Retrieve source from InjectedSource
-    ULONGLONG dataLenLL;
-    DWORD dataLen;
-    IFT(pInjectedSource->get_length(&dataLenLL));
-    IFT(ULongLongToDWord(dataLenLL, &dataLen));
-
-    CComHeapPtr<BYTE> heapCopy;
-    if (!heapCopy.AllocateBytes(dataLen)) {
-      throw ::hlsl::Exception(E_OUTOFMEMORY);
-    }
-    CComPtr<IMalloc> pIMalloc;
-    IFT(CoGetMalloc(1, &pIMalloc));
-    IFT(pInjectedSource->get_source(dataLen, &dataLen, heapCopy.m_pData));
-
-    // Get file name for this injected source
-    CComBSTR pFileName;
-    IFT(pInjectedSource->get_filename(&pFileName));
-    IFTARG(pFileName);
-
-    CComPtr<IDxcBlobEncoding> pBlobEncoding;
-    IFT(pLibrary->CreateBlobWithEncodingOnMalloc(heapCopy.Detach(), pIMalloc, dataLen, CP_UTF8, &pBlobEncoding));
-    IFT(pIncludeHandler->insertIncludeFile(pFileName, pBlobEncoding, dataLen));
-    // Check if this file is the main file or included file
-    if (wcscmp(pFileName, pMainFileName) == 0) {
-      pCompileSource = pBlobEncoding.Detach();
+  if (llvm::NamedMDNode *pContents =
+          pModule->getNamedMetadata("llvm.dbg.contents")) {
+    for (unsigned i = 0; i < pContents->getNumOperands(); ++i) {
+      const llvm::MDNode *pFile = pContents->getOperand(i);
+      std::wstring FileName = Unicode::UTF8ToUTF16StringOrThrow(
+          GetMDStringOperand(pFile, 0).str().c_str());
+      llvm::StringRef Content = GetMDStringOperand(pFile, 1);
+
+      CComPtr<IDxcBlobEncoding> pBlobEncoding;
+      IFT(pLibrary->CreateBlobWithEncodingFromPinned(
+          (LPBYTE)Content.data(), Content.size(), CP_UTF8, &pBlobEncoding));
+      IFT(pIncludeHandler->insertIncludeFile(FileName.c_str(), pBlobEncoding,
+                                             Content.size()));
+      // Check if this file is the main file or included file
+      if (FileName == MainFileName) {
+        pCompileSource = pBlobEncoding;
+      }
     }
   }
+  IFTBOOL(pCompileSource != nullptr, DXC_E_CONTAINER_MISSING_DEBUG);
 
   // Append arguments and defines from the command-line specification.
   for (LPCWSTR &A : args) {
@@ -606,7 +699,7 @@ void DxcContext::Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcCompile
   }
 
   CComPtr<IDxcOperationResult> pResult;
-  IFT(pCompiler->Compile(pCompileSource, pMainFileName,
+  IFT(pCompiler->Compile(pCompileSource, MainFileName.c_str(),
     StringRefUtf16(EntryPoint),
     StringRefUtf16(TargetProfile), ConcatArgs.data(),
     ConcatArgs.size(), ConcatDefines.data(),
@@ -614,16 +707,23 @@ void DxcContext::Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary, IDxcCompile
   *ppCompileResult = pResult.Detach();
 }
 
-int DxcContext::Compile() {
-  CComPtr<IDxcCompiler> pCompiler;
+// Runs the compile the options describe with the given compiler.
+void DxcContext::CompileOnce(IDxcCompiler *pCompiler,
+                             IDxcOperationResult **ppResult,
+                             IDxcBlob **ppDebugBlob, std::wstring &debugName) {
   CComPtr<IDxcOperationResult> pCompileResult;
-  CComPtr<IDxcBlob> pDebugBlob;
-  std::wstring debugName;
   {
     CComPtr<IDxcBlobEncoding> pSource;
 
     std::vector<std::wstring> argStrings;
     CopyArgsToWStrings(m_Opts.Args, CoreOption, argStrings);
+    // The rule is for the object file by default.
+    if (m_Opts.DependenciesWithOutput && m_Opts.DependencyTarget.empty() &&
+        !m_Opts.OutputObject.empty()) {
+      argStrings.push_back(L"-MT");
+      argStrings.push_back(
+          Unicode::UTF8ToUTF16StringOrThrow(m_Opts.OutputObject.str().c_str()));
+    }
 
     std::vector<LPCWSTR> args;
     args.reserve(argStrings.size());
@@ -635,16 +735,24 @@ int DxcContext::Compile() {
 
     CComPtr<IDxcLibrary> pLibrary;
     IFT(m_dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
-    IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
     ReadFileIntoBlob(m_dxcSupport, StringRefUtf16(m_Opts.InputFile), &pSource);
     IFTARG(pSource->GetBufferSize() >= 4);
 
-    if (m_Opts.RecompileFromBinary) {
+    if (m_Opts.FromPackage) {
+      // The package carries its own arguments and includes.
+      CComPtr<IDxcCompilerPackaging> pPackaging;
+      IFT(pCompiler.QueryInterface(&pPackaging));
+      IFT(pPackaging->CompileFromPackage(pSource, &pCompileResult));
+    }
+    else if (m_Opts.RecompileFromBinary) {
       Recompile(pSource, pLibrary, pCompiler, args, &pCompileResult);
     }
     else {
       CComPtr<IDxcIncludeHandler> pIncludeHandler;
-      IFT(pLibrary->CreateIncludeHandler(&pIncludeHandler));
+      if (m_pWorkerIncludeHandler)
+        pIncludeHandler = m_pWorkerIncludeHandler;
+      else
+        IFT(pLibrary->CreateIncludeHandler(&pIncludeHandler));
 
       // Upgrade profile to 6.0 version from minimum recognized shader model
       llvm::StringRef TargetProfile = m_Opts.TargetProfile;
@@ -663,7 +771,7 @@ int DxcContext::Compile() {
             StringRefUtf16(m_Opts.EntryPoint), StringRefUtf16(TargetProfile),
             args.data(), args.size(), m_Opts.Defines.data(),
             m_Opts.Defines.size(), pIncludeHandler, &pCompileResult,
-            &pDebugName, &pDebugBlob));
+            &pDebugName, ppDebugBlob));
         if (pDebugName.m_pData) {
           Unicode::UTF8ToUTF16String(m_Opts.DebugFile.str().c_str(), &debugName);
           debugName += pDebugName.m_pData;
@@ -677,18 +785,64 @@ int DxcContext::Compile() {
       }
     }
   }
+  *ppResult = pCompileResult.Detach();
+}
+
+int DxcContext::Compile() {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pCompileResult;
+  CComPtr<IDxcBlob> pDebugBlob;
+  std::wstring debugName;
+  if (m_pWorkerCompiler)
+    pCompiler = m_pWorkerCompiler;
+  else
+    IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+  CompileOnce(pCompiler, &pCompileResult, &pDebugBlob, debugName);
 
   if (!m_Opts.OutputWarningsFile.empty()) {
     CComPtr<IDxcBlobEncoding> pErrors;
     IFT(pCompileResult->GetErrorBuffer(&pErrors));
     WriteBlobToFile(pErrors, m_Opts.OutputWarningsFile);
   }
+  else if (m_pWorkerDiagnostics) {
+    CComPtr<IDxcBlobEncoding> pErrors;
+    IFT(pCompileResult->GetErrorBuffer(&pErrors));
+    if (pErrors && m_Opts.OutputWarnings)
+      m_pWorkerDiagnostics->append((const char *)pErrors->GetBufferPointer(),
+                                   pErrors->GetBufferSize());
+  }
   else {
     WriteOperationErrorsToConsole(pCompileResult, m_Opts.OutputWarnings);
   }
 
+  if (m_Opts.PrintStats) {
+    CComPtr<IDxcPassStatisticsResult> pStatsResult;
+    CComPtr<IDxcBlobEncoding> pStats;
+    if (SUCCEEDED(pCompileResult.QueryInterface(&pStatsResult)) &&
+        SUCCEEDED(pStatsResult->GetPassStatistics(&pStats)))
+      WriteBlobToConsole(pStats);
+  }
+
   HRESULT status;
   IFT(pCompileResult->GetStatus(&status));
+  if (SUCCEEDED(status) && m_Opts.DependenciesWithOutput) {
+    CComPtr<IDxcDependenciesResult> pDependenciesResult;
+    CComPtr<IDxcBlobEncoding> pDependencies;
+    if (SUCCEEDED(pCompileResult.QueryInterface(&pDependenciesResult)) &&
+        SUCCEEDED(pDependenciesResult->GetDependencies(&pDependencies)) &&
+        pDependencies != nullptr) {
+      // Next to the object file by default, as for clang's -MD.
+      std::string dependencyFile = m_Opts.DependencyFile;
+      if (dependencyFile.empty()) {
+        llvm::SmallString<128> name(m_Opts.OutputObject.empty()
+                                        ? m_Opts.InputFile
+                                        : m_Opts.OutputObject);
+        llvm::sys::path::replace_extension(name, "d");
+        dependencyFile = name.str();
+      }
+      WriteBlobToFile(pDependencies, dependencyFile);
+    }
+  }
   if (SUCCEEDED(status) || m_Opts.AstDump || m_Opts.OptDump) {
     CComPtr<IDxcBlob> pProgram;
     IFT(pCompileResult->GetResult(&pProgram));
@@ -696,11 +850,124 @@ int DxcContext::Compile() {
     pCompileResult.Release();
     if (pProgram.p != nullptr) {
       ActOnBlob(pProgram.p, pDebugBlob, debugName.c_str());
+      if (SUCCEEDED(status) && m_Opts.VerifyDeterminism &&
+          !VerifyDeterminism(pProgram))
+        status = E_FAIL;
     }
   }
   return status;
 }
 
+namespace {
+// Holds blocks of many sizes, with every other one freed, so that a compile
+// run meanwhile gets different addresses than one run before.
+class HeapPerturbation {
+public:
+  HeapPerturbation() {
+    unsigned size = 24;
+    for (unsigned i = 0; i < 4096; ++i) {
+      m_blocks.push_back(malloc(size));
+      size = size * 7 % 4093 + 8;
+    }
+    for (size_t i = 0; i < m_blocks.size(); i += 2) {
+      free(m_blocks[i]);
+      m_blocks[i] = nullptr;
+    }
+  }
+  ~HeapPerturbation() {
+    for (void *p : m_blocks)
+      free(p);
+  }
+
+private:
+  std::vector<void *> m_blocks;
+};
+}
+
+// Compiles the input again with a new compiler and a perturbed heap and
+// compares the container with pProgram part by part. Output that depends on
+// the addresses of objects, as through the iteration order of a container
+// keyed by pointers, shows up as differing parts. Returns whether the
+// outputs are the same.
+bool DxcContext::VerifyDeterminism(IDxcBlob *pProgram) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pCompileResult;
+  CComPtr<IDxcBlob> pDebugBlob;
+  CComPtr<IDxcBlob> pOtherProgram;
+  std::wstring debugName;
+  HRESULT status;
+  {
+    HeapPerturbation perturbation;
+    IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+    CompileOnce(pCompiler, &pCompileResult, &pDebugBlob, debugName);
+    IFT(pCompileResult->GetStatus(&status));
+    if (SUCCEEDED(status))
+      IFT(pCompileResult->GetResult(&pOtherProgram));
+  }
+  if (FAILED(status) || pOtherProgram == nullptr) {
+    fprintf(stderr, "Determinism check: the second compilation failed.\n");
+    return false;
+  }
+
+  const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+      pProgram->GetBufferPointer(), pProgram->GetBufferSize());
+  const hlsl::DxilContainerHeader *pOtherContainer = hlsl::IsDxilContainerLike(
+      pOtherProgram->GetBufferPointer(), pOtherProgram->GetBufferSize());
+  if (pContainer == nullptr || pOtherContainer == nullptr) {
+    // Not a container, as for /fcgl or /Odump; compare the whole output.
+    bool same = pProgram->GetBufferSize() == pOtherProgram->GetBufferSize() &&
+                memcmp(pProgram->GetBufferPointer(),
+                       pOtherProgram->GetBufferPointer(),
+                       pProgram->GetBufferSize()) == 0;
+    if (!same)
+      fprintf(stderr, "Determinism check: the outputs differ.\n");
+    return same;
+  }
+
+  // Parts are matched by kind, in order, so a part missing from one output
+  // is reported as well.
+  bool same = true;
+  std::vector<const hlsl::DxilPartHeader *> otherParts(
+      hlsl::begin(pOtherContainer), hlsl::end(pOtherContainer));
+  std::vector<bool> matched(otherParts.size(), false);
+  for (hlsl::DxilPartIterator it = hlsl::begin(pContainer),
+                              itEnd = hlsl::end(pContainer);
+       it != itEnd; ++it) {
+    const hlsl::DxilPartHeader *pPart = *it;
+    const hlsl::DxilPartHeader *pOtherPart = nullptr;
+    for (size_t i = 0; i < otherParts.size(); ++i) {
+      if (!matched[i] && otherParts[i]->PartFourCC == pPart->PartFourCC) {
+        matched[i] = true;
+        pOtherPart = otherParts[i];
+        break;
+      }
+    }
+    char fourCC[5] = {};
+    memcpy(fourCC, &pPart->PartFourCC, 4);
+    if (pOtherPart == nullptr) {
+      fprintf(stderr, "Determinism check: part %s is missing from the second "
+                      "output.\n", fourCC);
+      same = false;
+    } else if (pPart->PartSize != pOtherPart->PartSize ||
+               memcmp(hlsl::GetDxilPartData(pPart),
+                      hlsl::GetDxilPartData(pOtherPart),
+                      pPart->PartSize) != 0) {
+      fprintf(stderr, "Determinism check: part %s differs.\n", fourCC);
+      same = false;
+    }
+  }
+  for (size_t i = 0; i < otherParts.size(); ++i) {
+    if (!matched[i]) {
+      char fourCC[5] = {};
+      memcpy(fourCC, &otherParts[i]->PartFourCC, 4);
+      fprintf(stderr, "Determinism check: part %s is missing from the first "
+                      "output.\n", fourCC);
+      same = false;
+    }
+  }
+  return same;
+}
+
 int DxcContext::DumpBinary() {
   CComPtr<IDxcBlobEncoding> pSource;
   ReadFileIntoBlob(m_dxcSupport, StringRefUtf16(m_Opts.InputFile), &pSource);
@@ -733,10 +1000,132 @@ void DxcContext::Preprocess() {
   }
 }
 
-static void WriteString(HANDLE hFile, _In_z_ LPCSTR value, LPCWSTR pFileName) {
-  DWORD written;
-  if (FALSE == WriteFile(hFile, value, strlen(value) * sizeof(value[0]), &written, nullptr))
-    IFT_Data(HRESULT_FROM_WIN32(GetLastError()), pFileName);
+void DxcContext::WriteDependencies() {
+  DXASSERT(m_Opts.DependenciesOnly, "else option reading should have failed");
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pPreprocessResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  std::vector<std::wstring> argStrings;
+  CopyArgsToWStrings(m_Opts.Args, CoreOption, argStrings);
+  // The rule is for the object file by default.
+  if (m_Opts.DependencyTarget.empty() && !m_Opts.OutputObject.empty()) {
+    argStrings.push_back(L"-MT");
+    argStrings.push_back(
+        Unicode::UTF8ToUTF16StringOrThrow(m_Opts.OutputObject.str().c_str()));
+  }
+  // -MF alone implies the Makefile format.
+  if (!m_Opts.DependenciesJson)
+    argStrings.push_back(L"-M");
+  std::vector<LPCWSTR> args;
+  args.reserve(argStrings.size());
+  for (const std::wstring &a : argStrings)
+    args.push_back(a.data());
+
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcIncludeHandler> pIncludeHandler;
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(pLibrary->CreateIncludeHandler(&pIncludeHandler));
+
+  ReadFileIntoBlob(m_dxcSupport, StringRefUtf16(m_Opts.InputFile), &pSource);
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+  IFT(pCompiler->Preprocess(pSource, StringRefUtf16(m_Opts.InputFile), args.data(), args.size(), m_Opts.Defines.data(), m_Opts.Defines.size(), pIncludeHandler, &pPreprocessResult));
+  WriteOperationErrorsToConsole(pPreprocessResult, m_Opts.OutputWarnings);
+
+  HRESULT status;
+  IFT(pPreprocessResult->GetStatus(&status));
+  if (SUCCEEDED(status)) {
+    CComPtr<IDxcBlob> pDependencies;
+    IFT(pPreprocessResult->GetResult(&pDependencies));
+    if (m_Opts.DependencyFile.empty())
+      WriteBlobToConsole(pDependencies);
+    else
+      WriteBlobToFile(pDependencies, m_Opts.DependencyFile);
+  }
+}
+
+int DxcContext::WritePackage() {
+  DXASSERT(!m_Opts.PackageFile.empty(), "else option reading should have failed");
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerPackaging> pPackaging;
+  CComPtr<IDxcOperationResult> pPackageResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  std::vector<std::wstring> argStrings;
+  CopyArgsToWStrings(m_Opts.Args, CoreOption, argStrings);
+  std::vector<LPCWSTR> args;
+  args.reserve(argStrings.size());
+  for (const std::wstring &a : argStrings)
+    args.push_back(a.data());
+
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcIncludeHandler> pIncludeHandler;
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(pLibrary->CreateIncludeHandler(&pIncludeHandler));
+
+  // Upgrade profile to 6.0 version from minimum recognized shader model, as
+  // Compile does, so the package compiles the same anywhere.
+  llvm::StringRef TargetProfile = m_Opts.TargetProfile;
+  const hlsl::ShaderModel *SM = hlsl::ShaderModel::GetByName(m_Opts.TargetProfile.str().c_str());
+  if (SM->IsValid() && SM->GetMajor() < 6) {
+    TargetProfile = hlsl::ShaderModel::Get(SM->GetKind(), 6, 0)->GetName();
+  }
+
+  ReadFileIntoBlob(m_dxcSupport, StringRefUtf16(m_Opts.InputFile), &pSource);
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+  IFT(pCompiler.QueryInterface(&pPackaging));
+  IFT(pPackaging->CreatePackage(
+      pSource, StringRefUtf16(m_Opts.InputFile),
+      StringRefUtf16(m_Opts.EntryPoint), StringRefUtf16(TargetProfile),
+      args.data(), args.size(), m_Opts.Defines.data(), m_Opts.Defines.size(),
+      pIncludeHandler, &pPackageResult));
+  WriteOperationErrorsToConsole(pPackageResult, m_Opts.OutputWarnings);
+
+  HRESULT status;
+  IFT(pPackageResult->GetStatus(&status));
+  if (SUCCEEDED(status)) {
+    CComPtr<IDxcBlob> pPackage;
+    IFT(pPackageResult->GetResult(&pPackage));
+    WriteBlobToFile(pPackage, m_Opts.PackageFile);
+  }
+  return status;
+}
+
+namespace {
+// Writes to a file handle through a fixed buffer, so large outputs are
+// formatted and written in chunks rather than built up in memory first.
+class HandleOutputStream : public llvm::raw_ostream {
+public:
+  HandleOutputStream(HANDLE hFile, LPCWSTR pFileName)
+      : m_hFile(hFile), m_pFileName(pFileName), m_pos(0) {
+    SetBufferSize(64 * 1024);
+  }
+  ~HandleOutputStream() {
+    // Callers flush to see write errors; one left here cannot be reported.
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+private:
+  void write_impl(const char *Ptr, size_t Size) override {
+    while (Size != 0) {
+      DWORD chunk = (DWORD)std::min<size_t>(Size, 0x40000000);
+      DWORD written;
+      if (FALSE == WriteFile(m_hFile, Ptr, chunk, &written, nullptr))
+        IFT_Data(HRESULT_FROM_WIN32(GetLastError()), m_pFileName);
+      Ptr += written;
+      Size -= written;
+      m_pos += written;
+    }
+  }
+  uint64_t current_pos() const override { return m_pos; }
+
+  HANDLE m_hFile;
+  LPCWSTR m_pFileName;
+  uint64_t m_pos;
+};
 }
 
 void DxcContext::WriteHeader(IDxcBlobEncoding *pDisassembly, IDxcBlob *pCode,
@@ -747,46 +1136,39 @@ void DxcContext::WriteHeader(IDxcBlobEncoding *pDisassembly, IDxcBlob *pCode,
     IFT_Data(HRESULT_FROM_WIN32(GetLastError()), pFileName);
   }
 
-  {
-    std::string s;
-    llvm::raw_string_ostream OS(s);
-    // Note: with \r\n line endings, writing the disassembly could be a simple
-    // WriteBlobToHandle with a prior and following WriteString for #ifs
-    OS << "#if 0\r\n";
-    const uint8_t *pBytes = (const uint8_t *)pDisassembly->GetBufferPointer();
-    size_t len = pDisassembly->GetBufferSize();
-    s.reserve(len + len * 0.1f); // rough estimate
-    for (size_t i = 0; i < len; ++i) {
-      if (pBytes[i] == '\n')
-        OS << '\r';
-      OS << pBytes[i];
-    }
-    OS << "\r\n#endif\r\n";
-    OS.flush();
-    WriteString(file, s.c_str(), pFileName);
+  HandleOutputStream OS(file, pFileName);
+
+  // The disassembly is copied a line at a time, with '\r' before each line
+  // end, up to its null terminator.
+  OS << "#if 0\r\n";
+  const char *pText = (const char *)pDisassembly->GetBufferPointer();
+  const char *pTextEnd = std::find(
+      pText, pText + pDisassembly->GetBufferSize(), '\0');
+  while (pText != pTextEnd) {
+    const char *pLineEnd = std::find(pText, pTextEnd, '\n');
+    OS.write(pText, pLineEnd - pText);
+    if (pLineEnd == pTextEnd)
+      break;
+    OS << "\r\n";
+    pText = pLineEnd + 1;
   }
-
-  {
-    std::string s;
-    llvm::raw_string_ostream OS(s);
-    OS << "\r\nconst unsigned char " << pVariableName << "[] = {";
-    const uint8_t *pBytes = (const uint8_t *)pCode->GetBufferPointer();
-    size_t len = pCode->GetBufferSize();
-    s.reserve(100 + len * 6 + (len / 12) * 3); // rough estimate
-    for (size_t i = 0; i < len; ++i) {
-      if (i != 0)
-        OS << ',';
-      if ((i % 12) == 0)
-        OS << "\r\n ";
-      OS << " 0x";
-      if (pBytes[i] < 0x10)
-        OS << '0';
-      OS.write_hex(pBytes[i]);
-    }
-    OS << "\r\n};\r\n";
-    OS.flush();
-    WriteString(file, s.c_str(), pFileName);
+  OS << "\r\n#endif\r\n";
+
+  static const char HexDigits[] = "0123456789abcdef";
+  OS << "\r\nconst unsigned char " << pVariableName << "[] = {";
+  const uint8_t *pBytes = (const uint8_t *)pCode->GetBufferPointer();
+  size_t len = pCode->GetBufferSize();
+  for (size_t i = 0; i < len; ++i) {
+    if (i != 0)
+      OS << ',';
+    if ((i % 12) == 0)
+      OS << "\r\n ";
+    char byteText[5] = {' ', '0', 'x', HexDigits[pBytes[i] >> 4],
+                        HexDigits[pBytes[i] & 0xf]};
+    OS.write(byteText, sizeof(byteText));
   }
+  OS << "\r\n};\r\n";
+  OS.flush();
 }
 
 // Finds DXIL module from the blob assuming blob is either DxilContainer, DxilPartHeader, or DXIL module
@@ -805,6 +1187,19 @@ HRESULT DxcContext::FindModuleBlob(hlsl::DxilFourCC fourCC, IDxcBlob *pSource, I
   if (hlsl::IsValidDxilContainer((hlsl::DxilContainerHeader*)pSource->GetBufferPointer(), pSource->GetBufferSize())) {
     hlsl::DxilContainerHeader *pDxilContainerHeader = (hlsl::DxilContainerHeader*)pSource->GetBufferPointer();
     pDxilPartHeader = hlsl::GetDxilPartByType(pDxilContainerHeader, fourCC);
+    if (pDxilPartHeader == nullptr && fourCC == hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL) {
+      // The debug module may be compressed; return a decompressed copy.
+      llvm::SmallVector<char, 0> DecompressedData;
+      const hlsl::DxilProgramHeader *pDxilProgramHeader =
+          hlsl::GetDxilDebugProgramHeader(pDxilContainerHeader, DecompressedData);
+      IFTBOOL(pDxilProgramHeader != nullptr, DXC_E_CONTAINER_MISSING_DEBUG);
+      UINT32 pBlobSize;
+      hlsl::GetDxilProgramBitcode(pDxilProgramHeader, &pBitcode, &pBlobSize);
+      CComPtr<IDxcBlobEncoding> pTargetBlob;
+      IFR(pLibrary->CreateBlobWithEncodingOnHeapCopy(pBitcode, pBlobSize, CP_ACP, &pTargetBlob));
+      *ppTargetBlob = pTargetBlob.Detach();
+      return S_OK;
+    }
     IFTBOOL(pDxilPartHeader != nullptr, DXC_E_CONTAINER_MISSING_DEBUG);
   }
   if (fourCC == pDxilPartHeader->PartFourCC) {
@@ -819,35 +1214,430 @@ HRESULT DxcContext::FindModuleBlob(hlsl::DxilFourCC fourCC, IDxcBlob *pSource, I
 }
 
 // TODO : There is an identical code in DxaContext in Dxa.cpp. Refactor this function.
-HRESULT DxcContext::GetDxcDiaTable(IDxcLibrary *pLibrary, IDxcBlob *pTargetBlob, IDiaTable **ppTable, LPCWSTR tableName) {
-  if (!pLibrary || !pTargetBlob || !ppTable)
+namespace {
+// One compile of a batch: the arguments from a line of the job file, and
+// what came of running them.
+struct BatchJob {
+  unsigned LineNumber = 0;
+  std::string CommandLine;
+  HRESULT Status = S_OK;
+  double Milliseconds = 0;
+  std::string Diagnostics;
+};
+}
+
+// Reads the job file. Each line holds the arguments of one compile as they
+// would be given to dxc, such as input, /E, /T, /D and the output options;
+// blank lines and lines starting with '#' are skipped.
+static void ReadBatchJobs(DxcDllSupport &dxcSupport, llvm::StringRef fileName,
+                          std::vector<BatchJob> &jobs) {
+  CComPtr<IDxcBlobEncoding> pList;
+  ReadFileIntoBlob(dxcSupport, StringRefUtf16(fileName), &pList);
+  const char *pText = (const char *)pList->GetBufferPointer();
+  const char *pEnd = pText + pList->GetBufferSize();
+  for (unsigned lineNumber = 1; pText < pEnd; ++lineNumber) {
+    const char *pLineEnd = std::find(pText, pEnd, '\n');
+    llvm::StringRef line = llvm::StringRef(pText, pLineEnd - pText).trim();
+    if (!line.empty() && !line.startswith("#")) {
+      jobs.emplace_back();
+      jobs.back().LineNumber = lineNumber;
+      jobs.back().CommandLine = line.str();
+    }
+    pText = pLineEnd + 1;
+  }
+}
+
+// Compiles one job with the given compiler. Server requests must write their
+// results to files, since standard output carries the responses.
+static HRESULT RunBatchJob(DxcDllSupport &dxcSupport, IDxcCompiler *pCompiler,
+                           IDxcIncludeHandler *pIncludeHandler, BatchJob &job,
+                           bool serverRequest) {
+  llvm::BumpPtrAllocator allocator;
+  llvm::BumpPtrStringSaver saver(allocator);
+  llvm::SmallVector<const char *, 16> tokens;
+  llvm::cl::TokenizeWindowsCommandLine(job.CommandLine, saver, tokens);
+  llvm::SmallVector<llvm::StringRef, 16> argRefs(tokens.begin(), tokens.end());
+  MainArgs argStrings(argRefs);
+
+  DxcOpts opts;
+  std::string errorString;
+  llvm::raw_string_ostream errorStream(errorString);
+  int optResult = ReadDxcOpts(getHlslOptTable(), DxcFlags, argStrings, opts,
+                              errorStream);
+  job.Diagnostics = errorStream.str();
+  if (optResult != 0)
     return E_INVALIDARG;
-  CComPtr<IDiaDataSource> pDataSource;
-  CComPtr<IStream> pSourceStream;
-  CComPtr<IDiaSession> pSession;
-  CComPtr<IDiaEnumTables> pEnumTables;
-  IFT(m_dxcSupport.CreateInstance(CLSID_DxcDiaDataSource, &pDataSource));
-  IFT(pLibrary->CreateStreamFromBlobReadOnly(pTargetBlob, &pSourceStream));
-  IFT(pDataSource->loadDataFromIStream(pSourceStream));
-  IFT(pDataSource->openSession(&pSession));
-  IFT(pSession->getEnumTables(&pEnumTables));
-  CComPtr<IDiaTable> pTable;
-  for (;;) {
-    ULONG fetched;
-    pTable.Release();
-    IFT(pEnumTables->Next(1, &pTable, &fetched));
-    if (fetched == 0) {
-      pTable.Release();
-      break;
+  if (!opts.BatchFile.empty() || opts.Server || !opts.Preprocess.empty() ||
+      opts.DependenciesOnly || opts.DumpBin || !opts.PackageFile.empty()) {
+    job.Diagnostics += "Batch jobs can only compile.";
+    return E_INVALIDARG;
+  }
+  if (serverRequest &&
+      (opts.AstDump || opts.OptDump ||
+       (opts.OutputObject.empty() && opts.AssemblyCode.empty() &&
+        opts.OutputHeader.empty()))) {
+    job.Diagnostics += "Server requests must write their output to /Fo, /Fc "
+                       "or /Fh.";
+    return E_INVALIDARG;
+  }
+  if (opts.EntryPoint.empty() && !opts.RecompileFromBinary)
+    opts.EntryPoint = "main";
+
+  DxcContext context(opts, dxcSupport);
+  context.SetBatchWorker(pCompiler, &job.Diagnostics, pIncludeHandler);
+  return context.Compile();
+}
+
+// Runs the job, turning exceptions into its status, and records its time.
+static void RunTimedBatchJob(DxcDllSupport &dxcSupport, IDxcCompiler *pCompiler,
+                             IDxcIncludeHandler *pIncludeHandler, BatchJob &job,
+                             bool serverRequest) {
+  auto start = std::chrono::steady_clock::now();
+  try {
+    job.Status = RunBatchJob(dxcSupport, pCompiler, pIncludeHandler, job,
+                             serverRequest);
+  } catch (const ::hlsl::Exception &hlslException) {
+    job.Status = hlslException.hr;
+    job.Diagnostics += hlslException.msg;
+  } catch (std::bad_alloc &) {
+    job.Status = E_OUTOFMEMORY;
+  } catch (...) {
+    job.Status = E_FAIL;
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  job.Milliseconds = elapsed.count();
+}
+
+// Runs the jobs of the batch file on a pool of workers, each owning one
+// compiler, and writes the status and time of every job in file order.
+// Returns the number of jobs that failed.
+static unsigned BatchCompile(const DxcOpts &batchOpts,
+                             DxcDllSupport &dxcSupport) {
+  std::vector<BatchJob> jobs;
+  ReadBatchJobs(dxcSupport, batchOpts.BatchFile, jobs);
+
+  unsigned threadCount = batchOpts.BatchThreads;
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min<unsigned>(threadCount, std::max<size_t>(jobs.size(), 1));
+
+  // Jobs are handed out one at a time so a few slow shaders do not stall a
+  // whole slice.
+  std::atomic<size_t> nextJob(0);
+  auto worker = [&]() {
+    CComPtr<IDxcCompiler> pCompiler;
+    HRESULT hr = dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler);
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      BatchJob &job = jobs[i];
+      if (FAILED(hr)) {
+        job.Status = hr;
+        continue;
+      }
+      RunTimedBatchJob(dxcSupport, pCompiler, nullptr, job,
+                       /*serverRequest*/ false);
+    }
+  };
+
+  auto batchStart = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+  std::chrono::duration<double, std::milli> batchElapsed =
+      std::chrono::steady_clock::now() - batchStart;
+
+  unsigned failed = 0;
+  std::string summary;
+  llvm::raw_string_ostream summaryStream(summary);
+  for (const BatchJob &job : jobs) {
+    if (FAILED(job.Status))
+      ++failed;
+    summaryStream << "line " << job.LineNumber << ": "
+                  << (SUCCEEDED(job.Status) ? "succeeded" : "failed");
+    if (FAILED(job.Status))
+      summaryStream << " (" << llvm::format_hex((uint32_t)job.Status, 10)
+                    << ")";
+    summaryStream << " in " << llvm::format("%.1f", job.Milliseconds)
+                  << " ms: " << job.CommandLine << "\n";
+    if (!job.Diagnostics.empty()) {
+      summaryStream << job.Diagnostics;
+      if (job.Diagnostics.back() != '\n')
+        summaryStream << "\n";
     }
-    CComBSTR name;
-    IFT(pTable->get_name(&name));
-    if (wcscmp(name, tableName) == 0) {
+  }
+  summaryStream << "Compiled " << jobs.size() << " jobs on " << threadCount
+                << " workers in " << llvm::format("%.1f", batchElapsed.count())
+                << " ms: " << (unsigned)jobs.size() - failed << " succeeded, "
+                << failed << " failed.\n";
+  summaryStream.flush();
+
+  if (!batchOpts.BatchSummaryFile.empty())
+    WriteDataToFile(summary.data(), summary.size(), batchOpts.BatchSummaryFile);
+  else
+    WriteUtf8ToConsoleSizeT(summary.data(), summary.size());
+  return failed;
+}
+
+// Caches the files included by server requests, so headers shared by many
+// shaders are read once. An entry is loaded again when the size or the last
+// write time of its file changes.
+class DxcCachingIncludeHandler : public IDxcIncludeHandler {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  struct CachedFile {
+    FILETIME LastWriteTime;
+    uint64_t Size;
+    CComPtr<IDxcBlob> Blob;
+  };
+  CComPtr<IDxcIncludeHandler> m_pFileHandler;
+  std::mutex m_mutex;
+  std::unordered_map<std::wstring, CachedFile> m_files;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  DxcCachingIncludeHandler(IDxcIncludeHandler *pFileHandler)
+      : m_dwRef(0), m_pFileHandler(pFileHandler) {}
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeHandler>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LoadSource(
+    _In_ LPCWSTR pFilename,
+    _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource
+  ) {
+    *ppIncludeSource = nullptr;
+    try {
+      WIN32_FILE_ATTRIBUTE_DATA data;
+      if (!GetFileAttributesExW(pFilename, GetFileExInfoStandard, &data))
+        return m_pFileHandler->LoadSource(pFilename, ppIncludeSource);
+      uint64_t size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+      std::wstring key(pFilename);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_files.find(key);
+        if (it != m_files.end() && it->second.Size == size &&
+            CompareFileTime(&it->second.LastWriteTime,
+                            &data.ftLastWriteTime) == 0) {
+          *ppIncludeSource = it->second.Blob;
+          (*ppIncludeSource)->AddRef();
+          return S_OK;
+        }
+      }
+
+      // A file changed while it is read gets a stale time, so it is simply
+      // read again by the next request.
+      CComPtr<IDxcBlob> pBlob;
+      IFR(m_pFileHandler->LoadSource(pFilename, &pBlob));
+      if (pBlob) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CachedFile &file = m_files[key];
+        file.LastWriteTime = data.ftLastWriteTime;
+        file.Size = size;
+        file.Blob = pBlob;
+      }
+      *ppIncludeSource = pBlob.Detach();
+    }
+    CATCH_CPP_RETURN_HRESULT()
+    return S_OK;
+  }
+};
+
+// Serves compile requests read from standard input, one per line:
+//
+//   <id> compile <arguments>   compiles as dxc would with the given arguments
+//   <id> cancel <request id>   drops a compile request that has not started
+//   <id> shutdown              finishes the queued requests, then exits
+//
+// Ids are chosen by the client and cannot contain spaces. Every request gets
+// one response on standard output, in the order they complete:
+//
+//   <id> <succeeded|failed|cancelled> <hresult> <milliseconds> <size>
+//
+// followed by <size> bytes of warnings and errors. The end of the input shuts
+// down like a shutdown request. Each worker keeps its compiler between
+// requests, and included files are cached for all of them.
+class DxcServer {
+public:
+  DxcServer(const DxcOpts &opts, DxcDllSupport &dxcSupport)
+      : m_dxcSupport(dxcSupport),
+        m_memoryLimit((size_t)opts.ServerMemoryLimit * 1024 * 1024) {
+    m_threadCount = opts.BatchThreads;
+    if (m_threadCount == 0)
+      m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Serves requests until shutdown.
+  int Run();
+
+private:
+  struct Request {
+    std::string Id;
+    std::string CommandLine;
+  };
+
+  // Handles one line of input; returns false on shutdown.
+  bool HandleLine(llvm::StringRef line);
+  void WorkerMain();
+  void Respond(llvm::StringRef id, const char *pResult, HRESULT hr,
+               double milliseconds, llvm::StringRef diagnostics);
+  bool IsOverMemoryLimit() const;
+
+  DxcDllSupport &m_dxcSupport;
+  unsigned m_threadCount;
+  size_t m_memoryLimit; // In bytes, or 0 for no limit.
+  CComPtr<IDxcIncludeHandler> m_pIncludeHandler;
+  std::string m_shutdownId;
+
+  std::mutex m_queueMutex;
+  std::condition_variable m_queueReady;
+  std::deque<Request> m_queue;
+  bool m_shuttingDown = false;
+
+  std::mutex m_outputMutex;
+};
+
+int DxcServer::Run() {
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcIncludeHandler> pFileHandler;
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(pLibrary->CreateIncludeHandler(&pFileHandler));
+  m_pIncludeHandler = new DxcCachingIncludeHandler(pFileHandler);
+
+  // Diagnostic sizes are in bytes, so line endings must not be translated.
+  _setmode(_fileno(stdout), _O_BINARY);
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < m_threadCount; ++i)
+    threads.emplace_back([this]() { WorkerMain(); });
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!HandleLine(line))
       break;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_shuttingDown = true;
+  }
+  m_queueReady.notify_all();
+  for (std::thread &t : threads)
+    t.join();
+
+  if (!m_shutdownId.empty())
+    Respond(m_shutdownId, "succeeded", S_OK, 0, "");
+  return 0;
+}
+
+bool DxcServer::HandleLine(llvm::StringRef line) {
+  line = line.trim();
+  if (line.empty())
+    return true;
+
+  std::pair<llvm::StringRef, llvm::StringRef> idAndRest = line.split(' ');
+  std::pair<llvm::StringRef, llvm::StringRef> commandAndArgs =
+      idAndRest.second.ltrim().split(' ');
+  llvm::StringRef id = idAndRest.first;
+  llvm::StringRef command = commandAndArgs.first;
+  llvm::StringRef args = commandAndArgs.second.trim();
+
+  if (command == "compile") {
+    {
+      std::lock_guard<std::mutex> lock(m_queueMutex);
+      m_queue.push_back(Request{id.str(), args.str()});
     }
+    m_queueReady.notify_one();
+  } else if (command == "cancel") {
+    // Running compiles cannot be interrupted, so only queued ones are
+    // cancelled.
+    bool cancelled = false;
+    {
+      std::lock_guard<std::mutex> lock(m_queueMutex);
+      auto it = std::find_if(m_queue.begin(), m_queue.end(),
+                             [&](const Request &r) { return r.Id == args; });
+      if (it != m_queue.end()) {
+        m_queue.erase(it);
+        cancelled = true;
+      }
+    }
+    if (cancelled) {
+      Respond(args, "cancelled", E_ABORT, 0, "");
+      Respond(id, "succeeded", S_OK, 0, "");
+    } else {
+      Respond(id, "failed", E_INVALIDARG, 0,
+              "No queued request has the given id.");
+    }
+  } else if (command == "shutdown") {
+    m_shutdownId = id.str();
+    return false;
+  } else {
+    std::string message = "Unknown command '" + command.str() + "'.";
+    Respond(id, "failed", E_INVALIDARG, 0, message);
   }
-  *ppTable = pTable.Detach();
-  return S_OK;
+  return true;
+}
+
+void DxcServer::WorkerMain() {
+  CComPtr<IDxcCompiler> pCompiler;
+  for (;;) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(m_queueMutex);
+      m_queueReady.wait(lock,
+                        [this]() { return m_shuttingDown || !m_queue.empty(); });
+      if (m_queue.empty())
+        return;
+      request = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    BatchJob job;
+    job.CommandLine = std::move(request.CommandLine);
+    HRESULT hr = S_OK;
+    if (!pCompiler)
+      hr = m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler);
+    if (SUCCEEDED(hr))
+      RunTimedBatchJob(m_dxcSupport, pCompiler, m_pIncludeHandler, job,
+                       /*serverRequest*/ true);
+    else
+      job.Status = hr;
+    Respond(request.Id, SUCCEEDED(job.Status) ? "succeeded" : "failed",
+            job.Status, job.Milliseconds, job.Diagnostics);
+
+    // Past the limit, the next request gets a fresh compiler, so whatever
+    // this one holds on to is freed.
+    if (IsOverMemoryLimit())
+      pCompiler.Release();
+  }
+}
+
+void DxcServer::Respond(llvm::StringRef id, const char *pResult, HRESULT hr,
+                        double milliseconds, llvm::StringRef diagnostics) {
+  std::string header;
+  llvm::raw_string_ostream headerStream(header);
+  headerStream << id << " " << pResult << " "
+               << llvm::format_hex((uint32_t)hr, 10) << " "
+               << llvm::format("%.1f", milliseconds) << " "
+               << diagnostics.size() << "\n";
+  headerStream.flush();
+
+  std::lock_guard<std::mutex> lock(m_outputMutex);
+  fwrite(header.data(), 1, header.size(), stdout);
+  fwrite(diagnostics.data(), 1, diagnostics.size(), stdout);
+  fflush(stdout);
+}
+
+bool DxcServer::IsOverMemoryLimit() const {
+  if (m_memoryLimit == 0)
+    return false;
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return false;
+  return counters.WorkingSetSize > m_memoryLimit;
 }
 
 int __cdecl wmain(int argc, const wchar_t **argv_) {
@@ -922,12 +1712,32 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
     }
 
     EnsureEnabled(dxcSupport);
+
+    // Batch jobs carry their own options, so nothing else applies.
+    if (!dxcOpts.BatchFile.empty()) {
+      pStage = "Batch compilation";
+      return BatchCompile(dxcOpts, dxcSupport) == 0 ? 0 : 1;
+    }
+    if (dxcOpts.Server) {
+      pStage = "Compile server";
+      DxcServer server(dxcOpts, dxcSupport);
+      return server.Run();
+    }
+
     DxcContext context(dxcOpts, dxcSupport);
     // TODO: implement all other actions.
     if (!dxcOpts.Preprocess.empty()) {
       pStage = "Preprocessing";
       context.Preprocess();
     }
+    else if (dxcOpts.DependenciesOnly) {
+      pStage = "Scanning dependencies";
+      context.WriteDependencies();
+    }
+    else if (!dxcOpts.PackageFile.empty()) {
+      pStage = "Packaging";
+      retVal = context.WritePackage();
+    }
     else if (dxcOpts.DumpBin) {
       pStage = "Dumping existing binary";
       retVal = context.DumpBinary();
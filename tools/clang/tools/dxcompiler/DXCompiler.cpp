@@ -15,6 +15,7 @@
 #include "dxc/Support/WinIncludes.h"
 #include "dxcetw.h"
 #include "dxillib.h"
+#include "dxcutil.h"
 
 namespace hlsl { HRESULT SetupRegistryPassForHLSL(); }
 
@@ -45,6 +46,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD Reason, LPVOID reserved) {
     ::llvm::llvm_shutdown();
     DxcEtw_DXCompilerShutdown_Stop(S_OK);
     EventUnregisterMicrosoft_Windows_DXCompiler_API();
+    dxcutil::ReleaseCachedValidators(reserved != NULL);
     if (reserved == NULL) { // FreeLibrary has been called or the DLL load failed
       DxilLibCleanup(DxilLibCleanUpType::UnloadLibrary);
     }
@@ -29,10 +29,13 @@
 #include "dxc/Support/Unicode.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MSFileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "dxc/Support/microcom.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/dxcapi.impl.h"
+#include "llvm/ADT/StringMap.h"
 #include <algorithm>
+#include <mutex>
 #include <comdef.h>
 
 using namespace llvm;
@@ -132,6 +135,12 @@ static HRESULT StringRefToBSTR(llvm::StringRef value, BSTR *pRetVal) {
 
 static HRESULT CreateDxcDiaEnumTables(DxcDiaSession *, IDiaEnumTables **);
 static HRESULT CreateDxcDiaTable(DxcDiaSession *, DiaTableKind kind, IDiaTable **ppTable);
+static HRESULT CreateDxcDiaLineNumbers(DxcDiaSession *, std::vector<DWORD> &&lines,
+                                       IDiaEnumLineNumbers **ppResult);
+static HRESULT CreateDxcDiaInjectedSources(DxcDiaSession *, std::vector<DWORD> &&files,
+                                           IDiaEnumInjectedSources **ppResult);
+static HRESULT CreateDxcDiaSourceFile(DxcDiaSession *, DWORD index,
+                                      IDiaSourceFile **ppResult);
 
 class DxcDiaSession : public IDiaSession {
 private:
@@ -144,23 +153,40 @@ private:
   llvm::NamedMDNode *m_defines;
   llvm::NamedMDNode *m_mainFileName;
   llvm::NamedMDNode *m_arguments;
+  // Function bodies are only materialized, and the instruction tables built,
+  // on the first query that needs instructions; the compiland environment
+  // and injected sources are read from module metadata alone.
+  std::once_flag m_instructionsFlag;
+  HRESULT m_instructionsStatus;
   std::vector<const Instruction *> m_instructions;
   std::vector<const Instruction *> m_instructionLines; // Instructions with line info.
-public:
-  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  std::vector<DWORD> m_instructionLineRvas; // RVA of each line, ascending.
+  // Lookup tables from file names to file ids and from file ids to their
+  // lines sorted by line number, built on the first query that needs them.
+  std::once_flag m_sourceFileIdsFlag;
+  llvm::StringMap<DWORD> m_sourceFileIds;
+  std::vector<std::vector<std::pair<DWORD, DWORD>>> m_sourceFileLines;
+
+  void BuildSourceFileIds() {
+    unsigned fileCount = Contents() ? Contents()->getNumOperands() : 0;
+    for (unsigned i = 0; i < fileCount; ++i) {
+      StringRef fn =
+          dyn_cast<MDString>(Contents()->getOperand(i)->getOperand(0))
+              ->getString();
+      // Keep the first file with a given name, as a linear search would.
+      m_sourceFileIds.insert(std::make_pair(fn, (DWORD)i));
+    }
+  }
 
-  DxcDiaSession(std::shared_ptr<llvm::LLVMContext> context,
-                std::shared_ptr<llvm::Module> module,
-                std::shared_ptr<llvm::DebugInfoFinder> finder)
-      : m_module(module), m_context(context), m_finder(finder), m_dwRef(0), m_dxilModule(module.get()) {
-    // Extract HLSL metadata.
-    m_dxilModule.LoadDxilMetadata();
+  void EnsureSourceFileIds() {
+    std::call_once(m_sourceFileIdsFlag, [this]() { BuildSourceFileIds(); });
+  }
 
-    // Get file contents.
-    m_contents = m_module->getNamedMetadata("llvm.dbg.contents");
-    m_defines = m_module->getNamedMetadata("llvm.dbg.defines");
-    m_mainFileName = m_module->getNamedMetadata("llvm.dbg.mainFileName");
-    m_arguments = m_module->getNamedMetadata("llvm.dbg.args");
+  void BuildInstructions() {
+    if (m_module->materializeAll()) {
+      m_instructionsStatus = DXC_E_IR_VERIFICATION_FAILED;
+      return;
+    }
     // Build up a linear list of instructions. The index will be used as the
     // RVA. Debug instructions are ommitted from this enumeration.
     for (const Function &fn : m_module->functions()) {
@@ -176,10 +202,65 @@ public:
           m_instructions.push_back(&i);
           if (i.getDebugLoc()) {
             m_instructionLines.push_back(&i);
+            m_instructionLineRvas.push_back(m_instructions.size() - 1);
           }
         }
       }
     }
+
+    EnsureSourceFileIds();
+    m_sourceFileLines.resize(Contents() ? Contents()->getNumOperands() : 0);
+    for (DWORD i = 0; i < (DWORD)m_instructionLines.size(); ++i) {
+      DWORD fileId;
+      if (LookupSourceFileIdForLine(i, &fileId) == S_OK) {
+        m_sourceFileLines[fileId].push_back(
+            std::make_pair(m_instructionLines[i]->getDebugLoc().getLine(), i));
+      }
+    }
+    for (auto &lines : m_sourceFileLines)
+      std::sort(lines.begin(), lines.end());
+  }
+
+  HRESULT LookupSourceFileIdForLine(DWORD lineIndex, DWORD *pRetVal) {
+    DIScope *pScope = dyn_cast_or_null<DIScope>(
+        m_instructionLines[lineIndex]->getDebugLoc().getScope());
+    if (pScope != nullptr) {
+      auto it = m_sourceFileIds.find(pScope->getFilename());
+      if (it != m_sourceFileIds.end()) {
+        *pRetVal = it->second;
+        return S_OK;
+      }
+    }
+    *pRetVal = 0;
+    return S_FALSE;
+  }
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  DxcDiaSession(std::shared_ptr<llvm::LLVMContext> context,
+                std::shared_ptr<llvm::Module> module,
+                std::shared_ptr<llvm::DebugInfoFinder> finder)
+      : m_module(module), m_context(context), m_finder(finder), m_dwRef(0),
+        m_dxilModule(module.get()), m_instructionsStatus(S_OK) {
+    // Extract HLSL metadata.
+    m_dxilModule.LoadDxilMetadata();
+
+    // Get file contents.
+    m_contents = m_module->getNamedMetadata("llvm.dbg.contents");
+    m_defines = m_module->getNamedMetadata("llvm.dbg.defines");
+    m_mainFileName = m_module->getNamedMetadata("llvm.dbg.mainFileName");
+    m_arguments = m_module->getNamedMetadata("llvm.dbg.args");
+  }
+
+  // Materializes the module and builds the instruction tables; the
+  // instruction accessors below may only be used once this succeeds.
+  HRESULT EnsureInstructions() {
+    try {
+      std::call_once(m_instructionsFlag, [this]() { BuildInstructions(); });
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return m_instructionsStatus;
   }
   llvm::NamedMDNode *Contents() { return m_contents; }
   llvm::NamedMDNode *Defines() { return m_defines; }
@@ -190,23 +271,54 @@ public:
   llvm::DebugInfoFinder &InfoRef() { return *m_finder.get(); }
   std::vector<const Instruction *> &InstructionsRef() { return m_instructions; }
   std::vector<const Instruction *> &InstructionLinesRef() { return m_instructionLines; }
+  DWORD InstructionLineRva(DWORD lineIndex) { return m_instructionLineRvas[lineIndex]; }
 
   HRESULT getSourceFileIdByName(StringRef fileName, DWORD *pRetVal) {
-    if (Contents() != nullptr) {
-      for (unsigned i = 0; i < Contents()->getNumOperands(); ++i) {
-        StringRef fn =
-            dyn_cast<MDString>(Contents()->getOperand(i)->getOperand(0))
-                ->getString();
-        if (fn.equals(fileName)) {
-          *pRetVal = i;
-          return S_OK;
-        }
-      }
+    EnsureSourceFileIds();
+    auto it = m_sourceFileIds.find(fileName);
+    if (it != m_sourceFileIds.end()) {
+      *pRetVal = it->second;
+      return S_OK;
     }
     *pRetVal = 0;
     return S_FALSE;
   }
 
+  HRESULT getSourceFileIdForLine(DWORD lineIndex, DWORD *pRetVal) {
+    return LookupSourceFileIdForLine(lineIndex, pRetVal);
+  }
+
+  // Lines of the instructions with RVAs in [rva, rva + length).
+  void getLinesByRVA(DWORD rva, DWORD length, std::vector<DWORD> &lines) {
+    auto first = std::lower_bound(m_instructionLineRvas.begin(),
+                                  m_instructionLineRvas.end(), rva);
+    auto last = std::lower_bound(first, m_instructionLineRvas.end(),
+                                 (ULONGLONG)rva + std::max(length, (DWORD)1),
+                                 [](DWORD a, ULONGLONG b) { return a < b; });
+    for (auto it = first; it != last; ++it)
+      lines.push_back((DWORD)(it - m_instructionLineRvas.begin()));
+  }
+
+  // Lines in the file, all of them when linenum is 0; column 0 matches any.
+  void getLinesByLinenum(DWORD fileId, DWORD linenum, DWORD column,
+                         std::vector<DWORD> &lines) {
+    if (fileId >= m_sourceFileLines.size())
+      return;
+    const auto &fileLines = m_sourceFileLines[fileId];
+    auto first = fileLines.begin(), last = fileLines.end();
+    if (linenum != 0) {
+      first = std::lower_bound(first, last, std::make_pair(linenum, (DWORD)0));
+      last = std::lower_bound(first, last, std::make_pair(linenum + 1, (DWORD)0));
+    }
+    for (auto it = first; it != last; ++it) {
+      if (column == 0 ||
+          m_instructionLines[it->second]->getDebugLoc().getCol() == column)
+        lines.push_back(it->second);
+    }
+    // Present the lines in address order, as a table enumeration does.
+    std::sort(lines.begin(), lines.end());
+  }
+
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
     return DoBasicQueryInterface<IDiaSession>(this, iid, ppvObject);
   }
@@ -319,39 +431,99 @@ public:
 
   __override STDMETHODIMP findFileById(
     /* [in] */ DWORD uniqueId,
-    /* [out] */ IDiaSourceFile **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaSourceFile **ppResult) {
+    if (ppResult == nullptr)
+      return E_POINTER;
+    *ppResult = nullptr;
+    if (Contents() == nullptr || uniqueId >= Contents()->getNumOperands())
+      return S_FALSE;
+    return CreateDxcDiaSourceFile(this, uniqueId, ppResult);
+  }
 
   __override STDMETHODIMP findLines(
     /* [in] */ IDiaSymbol *compiland,
     /* [in] */ IDiaSourceFile *file,
-    /* [out] */ IDiaEnumLineNumbers **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumLineNumbers **ppResult) {
+    return findLinesByLinenum(compiland, file, 0, 0, ppResult);
+  }
 
+  // A program has a single section, so addresses are RVAs.
   __override STDMETHODIMP findLinesByAddr(
     /* [in] */ DWORD seg,
     /* [in] */ DWORD offset,
     /* [in] */ DWORD length,
-    /* [out] */ IDiaEnumLineNumbers **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumLineNumbers **ppResult) {
+    return findLinesByRVA(offset, length, ppResult);
+  }
 
   __override STDMETHODIMP findLinesByRVA(
     /* [in] */ DWORD rva,
     /* [in] */ DWORD length,
-    /* [out] */ IDiaEnumLineNumbers **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumLineNumbers **ppResult) {
+    if (ppResult == nullptr)
+      return E_POINTER;
+    *ppResult = nullptr;
+    IFR(EnsureInstructions());
+    try {
+      std::vector<DWORD> lines;
+      getLinesByRVA(rva, length, lines);
+      return CreateDxcDiaLineNumbers(this, std::move(lines), ppResult);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
 
   __override STDMETHODIMP findLinesByVA(
     /* [in] */ ULONGLONG va,
     /* [in] */ DWORD length,
-    /* [out] */ IDiaEnumLineNumbers **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumLineNumbers **ppResult) {
+    if (va > UINT32_MAX)
+      return E_INVALIDARG;
+    return findLinesByRVA((DWORD)va, length, ppResult);
+  }
 
   __override STDMETHODIMP findLinesByLinenum(
     /* [in] */ IDiaSymbol *compiland,
     /* [in] */ IDiaSourceFile *file,
     /* [in] */ DWORD linenum,
     /* [in] */ DWORD column,
-    /* [out] */ IDiaEnumLineNumbers **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumLineNumbers **ppResult) {
+    if (ppResult == nullptr)
+      return E_POINTER;
+    *ppResult = nullptr;
+    if (file == nullptr)
+      return E_INVALIDARG;
+    DWORD fileId;
+    IFR(file->get_uniqueId(&fileId));
+    IFR(EnsureInstructions());
+    try {
+      std::vector<DWORD> lines;
+      getLinesByLinenum(fileId, linenum, column, lines);
+      return CreateDxcDiaLineNumbers(this, std::move(lines), ppResult);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
 
   __override STDMETHODIMP findInjectedSource(
     /* [in] */ LPCOLESTR srcFile,
-    /* [out] */ IDiaEnumInjectedSources **ppResult) { return E_NOTIMPL; }
+    /* [out] */ IDiaEnumInjectedSources **ppResult) {
+    if (ppResult == nullptr)
+      return E_POINTER;
+    *ppResult = nullptr;
+    try {
+      std::vector<DWORD> files;
+      if (srcFile != nullptr) {
+        DWORD fileId;
+        if (getSourceFileIdByName(Unicode::UTF16ToUTF8StringOrThrow(srcFile),
+                                  &fileId) == S_OK)
+          files.push_back(fileId);
+      } else if (Contents() != nullptr) {
+        for (unsigned i = 0; i < Contents()->getNumOperands(); ++i)
+          files.push_back(i);
+      }
+      return CreateDxcDiaInjectedSources(this, std::move(files), ppResult);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
 
   __override STDMETHODIMP getEnumDebugStreams(
     /* [out] */ IDiaEnumDebugStreams **ppEnumDebugStreams) { return E_NOTIMPL; }
@@ -1709,7 +1881,7 @@ public:
 
   __override STDMETHODIMP get_relativeVirtualAddress(
     /* [retval][out] */ DWORD *pRetVal) { 
-    *pRetVal = m_index;
+    *pRetVal = m_pSession->InstructionLineRva(m_index);
     return S_OK;
   }
 
@@ -1721,17 +1893,7 @@ public:
 
   __override STDMETHODIMP get_sourceFileId(
     /* [retval][out] */ DWORD *pRetVal) {
-    MDNode *pScope = DL().getScope();
-    DILexicalBlock *pBlock = dyn_cast_or_null<DILexicalBlock>(pScope);
-    if (pBlock != nullptr) {
-      return m_pSession->getSourceFileIdByName(pBlock->getFile()->getFilename(), pRetVal);
-    }
-    DISubprogram *pSubProgram= dyn_cast_or_null<DISubprogram>(pScope);
-    if (pSubProgram != nullptr) {
-      return m_pSession->getSourceFileIdByName(pSubProgram->getFile()->getFilename(), pRetVal);
-    }
-    *pRetVal = 0;
-    return S_FALSE;
+    return m_pSession->getSourceFileIdForLine(m_index, pRetVal);
   }
 
   __override STDMETHODIMP get_statement(
@@ -1748,13 +1910,22 @@ public:
 };
 
 class DxcDiaTableLineNumbers : public DxcDiaTableBase<IDiaEnumLineNumbers, IDiaLineNumber> {
+private:
+  std::vector<DWORD> m_lines; // Line indices, when enumerating a query result.
+  bool m_isQuery;
 public:
-  DxcDiaTableLineNumbers(DxcDiaSession *pSession) : DxcDiaTableBase(pSession, DiaTableKind::LineNumbers) {
+  DxcDiaTableLineNumbers(DxcDiaSession *pSession)
+      : DxcDiaTableBase(pSession, DiaTableKind::LineNumbers), m_isQuery(false) {
     m_count = pSession->InstructionLinesRef().size();
   }
+  DxcDiaTableLineNumbers(DxcDiaSession *pSession, std::vector<DWORD> &&lines)
+      : DxcDiaTableBase(pSession, DiaTableKind::LineNumbers),
+        m_lines(std::move(lines)), m_isQuery(true) {
+    m_count = m_lines.size();
+  }
 
   __override HRESULT GetItem(DWORD index, IDiaLineNumber **ppItem) {
-    *ppItem = new (std::nothrow)DxcDiaLineNumber(m_pSession, index);
+    *ppItem = new (std::nothrow)DxcDiaLineNumber(m_pSession, m_isQuery ? m_lines[index] : index);
     if (*ppItem == nullptr)
       return E_OUTOFMEMORY;
     (*ppItem)->AddRef();
@@ -1847,16 +2018,25 @@ public:
 };
 
 class DxcDiaTableInjectedSource : public DxcDiaTableBase<IDiaEnumInjectedSources, IDiaInjectedSource> {
+private:
+  std::vector<DWORD> m_files; // File indices, when enumerating a query result.
+  bool m_isQuery;
 public:
-  DxcDiaTableInjectedSource(DxcDiaSession *pSession) : DxcDiaTableBase(pSession, DiaTableKind::InjectedSource) {
+  DxcDiaTableInjectedSource(DxcDiaSession *pSession)
+      : DxcDiaTableBase(pSession, DiaTableKind::InjectedSource), m_isQuery(false) {
     // Count the number of source files available.
     // m_count = m_pSession->InfoRef().compile_unit_count();
     m_count =
       (m_pSession->Contents() == nullptr) ? 0 : m_pSession->Contents()->getNumOperands();
   }
+  DxcDiaTableInjectedSource(DxcDiaSession *pSession, std::vector<DWORD> &&files)
+      : DxcDiaTableBase(pSession, DiaTableKind::InjectedSource),
+        m_files(std::move(files)), m_isQuery(true) {
+    m_count = m_files.size();
+  }
 
   __override HRESULT GetItem(DWORD index, IDiaInjectedSource **ppItem) {
-    *ppItem = new (std::nothrow)DxcDiaInjectedSource(m_pSession, index);
+    *ppItem = new (std::nothrow)DxcDiaInjectedSource(m_pSession, m_isQuery ? m_files[index] : index);
     if (*ppItem == nullptr)
       return E_OUTOFMEMORY;
     (*ppItem)->AddRef();
@@ -1893,7 +2073,10 @@ HRESULT CreateDxcDiaTable(DxcDiaSession *pSession, DiaTableKind kind, IDiaTable
   switch (kind) {
   case DiaTableKind::Symbols: *ppTable = new (std::nothrow)DxcDiaTableSymbols(pSession); break;
   case DiaTableKind::SourceFiles: *ppTable = new (std::nothrow)DxcDiaTableSourceFiles(pSession); break;
-  case DiaTableKind::LineNumbers: *ppTable = new (std::nothrow)DxcDiaTableLineNumbers(pSession); break;
+  case DiaTableKind::LineNumbers:
+    IFR(pSession->EnsureInstructions());
+    *ppTable = new (std::nothrow)DxcDiaTableLineNumbers(pSession);
+    break;
   case DiaTableKind::Sections: *ppTable = new (std::nothrow)DxcDiaTableSections(pSession); break;
   case DiaTableKind::SegmentMap: *ppTable = new (std::nothrow)DxcDiaTableSegmentMap(pSession); break;
   case DiaTableKind::InjectedSource: *ppTable = new (std::nothrow)DxcDiaTableInjectedSource(pSession); break;
@@ -1907,6 +2090,41 @@ HRESULT CreateDxcDiaTable(DxcDiaSession *pSession, DiaTableKind kind, IDiaTable
   return S_OK;
 }
 
+template <typename TTable, typename TEnum>
+static HRESULT CreateDxcDiaQueryResult(DxcDiaSession *pSession,
+                                       std::vector<DWORD> &&items,
+                                       TEnum **ppResult) {
+  TTable *pTable = new (std::nothrow) TTable(pSession, std::move(items));
+  if (pTable == nullptr)
+    return E_OUTOFMEMORY;
+  pTable->AddRef();
+  *ppResult = pTable;
+  return S_OK;
+}
+
+static HRESULT CreateDxcDiaLineNumbers(DxcDiaSession *pSession,
+                                       std::vector<DWORD> &&lines,
+                                       IDiaEnumLineNumbers **ppResult) {
+  return CreateDxcDiaQueryResult<DxcDiaTableLineNumbers>(
+      pSession, std::move(lines), ppResult);
+}
+
+static HRESULT CreateDxcDiaInjectedSources(DxcDiaSession *pSession,
+                                           std::vector<DWORD> &&files,
+                                           IDiaEnumInjectedSources **ppResult) {
+  return CreateDxcDiaQueryResult<DxcDiaTableInjectedSource>(
+      pSession, std::move(files), ppResult);
+}
+
+static HRESULT CreateDxcDiaSourceFile(DxcDiaSession *pSession, DWORD index,
+                                      IDiaSourceFile **ppResult) {
+  *ppResult = new (std::nothrow) DxcDiaSourceFile(pSession, index);
+  if (*ppResult == nullptr)
+    return E_OUTOFMEMORY;
+  (*ppResult)->AddRef();
+  return S_OK;
+}
+
 class DxcDiaDataSource : public IDiaDataSource {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
@@ -1962,8 +2180,29 @@ public:
       m_context = std::make_shared<LLVMContext>();
       std::unique_ptr<MemoryBuffer> pBuffer =
           getMemBufferFromStream(pIStream, "data");
+      // Accept a container as well as bare bitcode, taking the debug module
+      // from whichever debug info part the container has.
+      SmallVector<char, 0> DecompressedData;
+      if (const DxilContainerHeader *pContainer = IsDxilContainerLike(
+              pBuffer->getBufferStart(), pBuffer->getBufferSize())) {
+        if (!IsValidDxilContainer(pContainer, pBuffer->getBufferSize()))
+          return DXC_E_CONTAINER_INVALID;
+        const DxilProgramHeader *pProgramHeader =
+            GetDxilDebugProgramHeader(pContainer, DecompressedData);
+        if (!pProgramHeader)
+          return DXC_E_CONTAINER_MISSING_DEBUG;
+        const char *pBitcode;
+        uint32_t bitcodeLength;
+        GetDxilProgramBitcode(pProgramHeader, &pBitcode, &bitcodeLength);
+        // The lazy module keeps reading from its buffer, which must outlive
+        // both the stream buffer and any decompressed data.
+        pBuffer = MemoryBuffer::getMemBufferCopy(
+            StringRef(pBitcode, bitcodeLength), "data");
+      }
+      // Only metadata is read here; function bodies are materialized when a
+      // session first needs instructions.
       ErrorOr<std::unique_ptr<llvm::Module>> module =
-          parseBitcodeFile(pBuffer->getMemBufferRef(), *m_context.get());
+          getLazyBitcodeModule(std::move(pBuffer), *m_context.get());
       if (!module)
         return E_FAIL;
       m_finder = std::make_shared<DebugInfoFinder>();
@@ -48,7 +48,7 @@ bool SigElementHasStream(const DxilProgramSignatureElement &pSignature) {
 }
 
 void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
-                           bool bIsInput, raw_string_ostream &OS,
+                           bool bIsInput, raw_ostream &OS,
                            StringRef comment) {
   OS << comment << "\n"
      << comment << " " << pName << " signature:\n"
@@ -251,7 +251,7 @@ void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
   OS << comment << "\n";
 }
 
-void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
+void PintCompMaskNameCompact(raw_ostream &OS, unsigned CompMask) {
   char Mask[5];
   memset(Mask, '\0', sizeof(Mask));
   unsigned idx = 0;
@@ -267,7 +267,7 @@ void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
 }
 
 void PrintDxilSignature(LPCSTR pName, const DxilSignature &Signature,
-                               raw_string_ostream &OS, StringRef comment) {
+                               raw_ostream &OS, StringRef comment) {
   const std::vector<std::unique_ptr<DxilSignatureElement>> &sigElts =
       Signature.GetElements();
   if (sigElts.size() == 0)
@@ -314,7 +314,7 @@ PCSTR g_pFeatureInfoNames[] = {
 };
 
 void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
-                             raw_string_ostream &OS, StringRef comment) {
+                             raw_ostream &OS, StringRef comment) {
   uint64_t featureFlags = pFeatureInfo->FeatureFlags;
   if (!featureFlags)
     return;
@@ -328,7 +328,7 @@ void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
 }
 
 void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
-                                raw_string_ostream &OS) {
+                                raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -355,7 +355,7 @@ void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
 }
 
 void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
-                             raw_string_ostream &OS) {
+                             raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -395,7 +395,7 @@ void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
   }
 }
 
-void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
+void PrintResourceBinding(DxilResourceBase &res, raw_ostream &OS,
                                  StringRef comment) {
   OS << comment << " " << left_justify(res.GetGlobalName(), 31);
 
@@ -421,7 +421,7 @@ void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
     OS << right_justify("unbounded", 6) << "\n";
 }
 
-void PrintResourceBindings(DxilModule &M, raw_string_ostream &OS,
+void PrintResourceBindings(DxilModule &M, raw_ostream &OS,
                                   StringRef comment) {
   OS << comment << "\n"
      << comment << " Resource Bindings:\n"
@@ -488,7 +488,7 @@ void PrintInputsContributingToOutputs(
   }
 }
 
-void PrintViewIdState(DxilModule &M, raw_string_ostream &OS,
+void PrintViewIdState(DxilModule &M, raw_ostream &OS,
                              StringRef comment) {
   if (!M.GetModule()->getNamedMetadata("dx.viewIdState"))
     return;
@@ -556,7 +556,7 @@ void PrintViewIdState(DxilModule &M, raw_string_ostream &OS,
 }
 
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                              raw_string_ostream &OS, StringRef comment,
+                              raw_ostream &OS, StringRef comment,
                               StringRef varName, unsigned offset,
                               unsigned indent, unsigned arraySize,
                               unsigned sizeOfStruct = 0);
@@ -592,7 +592,7 @@ void PrintTypeAndName(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 }
 
 void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
-                             DxilTypeSystem &typeSys, raw_string_ostream &OS,
+                             DxilTypeSystem &typeSys, raw_ostream &OS,
                              StringRef comment, unsigned offset,
                              unsigned indent, unsigned offsetIndent,
                              unsigned sizeToPrint = 0) {
@@ -660,7 +660,7 @@ void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 }
 
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                              raw_string_ostream &OS, StringRef comment,
+                              raw_ostream &OS, StringRef comment,
                               StringRef varName, unsigned offset,
                               unsigned indent, unsigned offsetIndent,
                               unsigned sizeOfStruct) {
@@ -692,7 +692,7 @@ void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
 void PrintStructBufferDefinition(DxilResource *buf,
                                         DxilTypeSystem &typeSys,
                                         const DataLayout &DL,
-                                        raw_string_ostream &OS,
+                                        raw_ostream &OS,
                                         StringRef comment) {
   const unsigned offsetIndent = 50;
 
@@ -742,7 +742,7 @@ void PrintStructBufferDefinition(DxilResource *buf,
 }
 
 void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
-                                   raw_string_ostream &OS, StringRef comment) {
+                                   raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   Value *GV = buf->GetGlobalSymbol();
   llvm::Type *Ty = GV->getType()->getPointerElementType();
@@ -769,7 +769,7 @@ void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
 }
 
 void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
-                                   raw_string_ostream &OS, StringRef comment) {
+                                   raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   Value *GV = buf->GetGlobalSymbol();
   llvm::Type *Ty = GV->getType()->getPointerElementType();
@@ -796,7 +796,7 @@ void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
   OS << comment << "\n";
 }
 
-void PrintBufferDefinitions(DxilModule &M, raw_string_ostream &OS,
+void PrintBufferDefinitions(DxilModule &M, raw_ostream &OS,
                                    StringRef comment) {
   OS << comment << "\n"
      << comment << " Buffer Definitions:\n"
@@ -998,7 +998,7 @@ public:
 
 void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
                                                     DXIL::ShaderKind shaderKind,
-                                                    raw_string_ostream &OS,
+                                                    raw_ostream &OS,
                                                     StringRef comment) {
   OS << comment << "\n"
      << comment << " Pipeline Runtime Information: \n"
@@ -1227,9 +1227,11 @@ void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
 
 
 namespace dxcutil {
-HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
+HRESULT Disassemble(IDxcBlob *pProgram, raw_ostream &Stream, UINT32 Sections,
+                    ArrayRef<std::string> Functions) {
   const char *pIL = (const char *)pProgram->GetBufferPointer();
   uint32_t pILLength = pProgram->GetBufferSize();
+  SmallVector<char, 0> DecompressedDebugPart;
   if (const DxilContainerHeader *pContainer =
           IsDxilContainerLike(pIL, pILLength)) {
     if (!IsValidDxilContainer(pContainer, pILLength)) {
@@ -1238,7 +1240,8 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
     DxilPartIterator it = std::find_if(begin(pContainer), end(pContainer),
                                        DxilPartIsType(DFCC_FeatureInfo));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) &&
+        (Sections & DxcDisassembleSection_FeatureInfo)) {
       PrintFeatureInfo(
           reinterpret_cast<const DxilShaderFeatureInfo *>(GetDxilPartData(*it)),
           Stream, /*comment*/ ";");
@@ -1246,7 +1249,7 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
     it = std::find_if(begin(pContainer), end(pContainer),
                       DxilPartIsType(DFCC_InputSignature));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) && (Sections & DxcDisassembleSection_Signatures)) {
       PrintSignature(
           "Input",
           reinterpret_cast<const DxilProgramSignature *>(GetDxilPartData(*it)),
@@ -1254,7 +1257,7 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
     }
     it = std::find_if(begin(pContainer), end(pContainer),
                       DxilPartIsType(DFCC_OutputSignature));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) && (Sections & DxcDisassembleSection_Signatures)) {
       PrintSignature(
           "Output",
           reinterpret_cast<const DxilProgramSignature *>(GetDxilPartData(*it)),
@@ -1262,7 +1265,7 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
     }
     it = std::find_if(begin(pContainer), end(pContainer),
                       DxilPartIsType(DFCC_PatchConstantSignature));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) && (Sections & DxcDisassembleSection_Signatures)) {
       PrintSignature(
           "Patch Constant signature",
           reinterpret_cast<const DxilProgramSignature *>(GetDxilPartData(*it)),
@@ -1271,7 +1274,7 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
     it = std::find_if(begin(pContainer), end(pContainer),
                       DxilPartIsType(DFCC_ShaderDebugName));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) && (Sections & DxcDisassembleSection_DebugName)) {
       const char *pDebugName;
       if (!GetDxilShaderDebugName(*it, &pDebugName, nullptr)) {
         Stream << "; shader debug name present; corruption detected\n";
@@ -1295,13 +1298,28 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
     const DxilProgramHeader *pProgramHeader =
         reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(*it));
-    if (!IsValidDxilProgramHeader(pProgramHeader, (*it)->PartSize)) {
+    uint32_t programLength = (*it)->PartSize;
+    if (dbgit == end(pContainer)) {
+      // Use the compressed dbg module if that is what the container has.
+      dbgit = std::find_if(begin(pContainer), end(pContainer),
+                           DxilPartIsType(DFCC_ShaderDebugInfoDXILCompressed));
+      if (dbgit != end(pContainer)) {
+        if (!DecompressDxilPartData(*dbgit, DecompressedDebugPart)) {
+          return DXC_E_CONTAINER_INVALID;
+        }
+        pProgramHeader = reinterpret_cast<const DxilProgramHeader *>(
+            DecompressedDebugPart.data());
+        programLength = DecompressedDebugPart.size();
+      }
+    }
+    if (!IsValidDxilProgramHeader(pProgramHeader, programLength)) {
       return DXC_E_CONTAINER_INVALID;
     }
 
     it = std::find_if(begin(pContainer), end(pContainer),
                       DxilPartIsType(DFCC_PipelineStateValidation));
-    if (it != end(pContainer)) {
+    if (it != end(pContainer) &&
+        (Sections & DxcDisassembleSection_PipelineStateValidation)) {
       PrintPipelineStateValidationRuntimeInfo(
           GetDxilPartData(*it),
           GetVersionShaderType(pProgramHeader->ProgramVersion), Stream,
@@ -1332,19 +1350,36 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
   if (pModule->get()->getNamedMetadata("dx.version")) {
     DxilModule &dxilModule = pModule->get()->GetOrCreateDxilModule();
-    PrintDxilSignature("Input", dxilModule.GetInputSignature(), Stream,
-                       /*comment*/ ";");
-    PrintDxilSignature("Output", dxilModule.GetOutputSignature(), Stream,
-                       /*comment*/ ";");
-    PrintDxilSignature("Patch Constant signature",
-                       dxilModule.GetPatchConstantSignature(), Stream,
-                       /*comment*/ ";");
-    PrintBufferDefinitions(dxilModule, Stream, /*comment*/ ";");
-    PrintResourceBindings(dxilModule, Stream, /*comment*/ ";");
-    PrintViewIdState(dxilModule, Stream, /*comment*/ ";");
+    if (Sections & DxcDisassembleSection_Signatures) {
+      PrintDxilSignature("Input", dxilModule.GetInputSignature(), Stream,
+                         /*comment*/ ";");
+      PrintDxilSignature("Output", dxilModule.GetOutputSignature(), Stream,
+                         /*comment*/ ";");
+      PrintDxilSignature("Patch Constant signature",
+                         dxilModule.GetPatchConstantSignature(), Stream,
+                         /*comment*/ ";");
+    }
+    if (Sections & DxcDisassembleSection_BufferDefinitions)
+      PrintBufferDefinitions(dxilModule, Stream, /*comment*/ ";");
+    if (Sections & DxcDisassembleSection_ResourceBindings)
+      PrintResourceBindings(dxilModule, Stream, /*comment*/ ";");
+    if (Sections & DxcDisassembleSection_ViewIdState)
+      PrintViewIdState(dxilModule, Stream, /*comment*/ ";");
+  }
+  if (Sections & DxcDisassembleSection_Module) {
+    DxcAssemblyAnnotationWriter w;
+    if (Functions.empty()) {
+      pModule.get()->print(Stream, &w);
+    } else {
+      for (const std::string &Name : Functions) {
+        Function *F = pModule.get()->getFunction(Name);
+        if (F == nullptr)
+          return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+        Stream << "\n";
+        F->print(Stream, &w);
+      }
+    }
   }
-  DxcAssemblyAnnotationWriter w;
-  pModule.get()->print(Stream, &w);
   Stream.flush();
   return S_OK;
 }
@@ -15,6 +15,7 @@
 #include "dxc/HLSL/DxilContainer.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/microcom.h"
 #include "dxc/dxcapi.h"
 #include "llvm/Support/raw_ostream.h"
 #include "dxcutil.h"
@@ -22,6 +23,8 @@
 #include "dxc/Support/dxcfilesystem.h"
 #include "dxc/Support/Unicode.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include <mutex>
+#include <unordered_map>
 
 using namespace llvm;
 using namespace hlsl;
@@ -73,9 +76,10 @@ enum class SpecialValue {
   Source = 3,
   Output = 4
 };
+// Handles double as CRT file numbers, so they must fit in 31 bits.
 struct HandleBits {
-  unsigned Offset : 8;
-  unsigned Length : 8;
+  unsigned Offset : 16;
+  unsigned Length : 10;
   unsigned Kind : 4;
 };
 struct DxcArgsHandle {
@@ -120,10 +124,10 @@ const DxcArgsHandle StdOutHandle(SpecialValue::StdOut);
 const DxcArgsHandle StdErrHandle(SpecialValue::StdErr);
 const DxcArgsHandle OutputHandle(SpecialValue::Output);
 
-/// Max number of included files (1:1 to their directories) or search directories.
-/// If programs include more than a handful, DxcArgsFileSystem will need to do better than linear scans.
+/// Max number of included files (1:1 to their directories) or search directories,
+/// as many as the offset of a handle can index.
 /// If this is fired, ERROR_OUT_OF_STRUCTURES will be returned by an attempt to open a file.
-static const size_t MaxIncludedFiles = 200;
+static const size_t MaxIncludedFiles = (1 << 16) - 1;
 
 bool IsAbsoluteOrCurDirRelativeW(LPCWSTR Path) {
   if (!Path || !Path[0]) return FALSE;
@@ -152,6 +156,35 @@ bool IsAbsoluteOrCurDirRelativeW(LPCWSTR Path) {
   return FALSE;
 }
 
+// Returns the key included files are indexed by: the path with '/' for every
+// separator, and without repeated separators or "." components, so that the
+// spellings header search produces for one file find the same entry.
+std::wstring NormalizeIncludePath(LPCWSTR Path) {
+  std::wstring result;
+  // Keep the leading separators of a UNC name.
+  size_t i = 0;
+  if ((Path[0] == L'\\' || Path[0] == L'/') &&
+      (Path[1] == L'\\' || Path[1] == L'/')) {
+    result = L"//";
+    i = 2;
+  }
+  for (; Path[i]; ++i) {
+    wchar_t c = Path[i] == L'\\' ? L'/' : Path[i];
+    if (c == L'/') {
+      if (!result.empty() && result.back() == L'/')
+        continue;
+      // Drop a "." component, but not a leading one.
+      size_t size = result.size();
+      if (size >= 2 && result[size - 1] == L'.' && result[size - 2] == L'/') {
+        result.pop_back();
+        continue;
+      }
+    }
+    result.push_back(c);
+  }
+  return result;
+}
+
 void MakeAbsoluteOrCurDirRelativeW(LPCWSTR &Path, std::wstring &PathStorage) {
   if (IsAbsoluteOrCurDirRelativeW(Path)) {
     return;
@@ -192,26 +225,52 @@ private:
   CComPtr<IDxcBlob> m_pSource;
   LPCWSTR m_pSourceName;
   std::wstring m_pAbsSourceName; // absolute (or '.'-relative) source name
-  CComPtr<IStream> m_pSourceStream;
   CComPtr<IStream> m_pOutputStream;
   CComPtr<AbstractMemoryStream> m_pStdOutStream;
   CComPtr<AbstractMemoryStream> m_pStdErrStream;
   LPCWSTR m_pOutputStreamName;
   std::wstring m_pAbsOutputStreamName;
   CComPtr<IDxcIncludeHandler> m_includeLoader;
+  CComPtr<IDxcIncludeCache> m_pIncludeCache;
   std::vector<std::wstring> m_searchEntries;
   bool m_bDisplayIncludeProcess;
 
   // Some constraints of the current design: opening the same file twice
   // will return the same handle/structure, and thus the same file pointer.
+  // Included files are read straight out of their blobs, so opening one
+  // doesn't allocate a stream object on top of it.
   struct IncludedFile {
     CComPtr<IDxcBlob> Blob;
-    CComPtr<IStream> BlobStream;
     std::wstring Name;
-    IncludedFile(std::wstring &&name, IDxcBlob *pBlob, IStream *pStream)
-      : Name(name), Blob(pBlob), BlobStream(pStream) { }
+    ULONG Offset;
+    IncludedFile(std::wstring &&name, IDxcBlob *pBlob)
+      : Name(name), Blob(pBlob), Offset(0) { }
   };
   llvm::SmallVector<IncludedFile, 4> m_includedFiles;
+  // Indices of the included files by normalized name.
+  std::unordered_map<std::wstring, size_t> m_includedFileIndices;
+  // Index of the first included file under each directory, by every
+  // spelling TryFindDirHandle may be asked for: each parent path of an
+  // included file, with and without its trailing separator.
+  std::unordered_map<std::wstring, size_t> m_includedDirIndices;
+  // Errors of the files the include handler failed to load, by normalized
+  // name. Header search probes every search directory for each include, so
+  // the same missing paths are asked for again and again; they are not
+  // passed to the handler a second time during this compilation.
+  std::unordered_map<std::wstring, DWORD> m_missingFiles;
+
+  size_t AddIncludedFile(std::wstring &&name, IDxcBlob *pBlob) {
+    size_t index = m_includedFiles.size();
+    m_includedFileIndices.emplace(NormalizeIncludePath(name.c_str()), index);
+    for (size_t i = 1; i < name.size(); ++i) {
+      if (name[i] == L'\\' || name[i] == L'/') {
+        m_includedDirIndices.emplace(name.substr(0, i), index);
+        m_includedDirIndices.emplace(name.substr(0, i + 1), index);
+      }
+    }
+    m_includedFiles.emplace_back(std::move(name), pBlob);
+    return index;
+  }
 
   static bool IsDirOf(LPCWSTR lpDir, size_t dirLen, const std::wstring &fileName) {
     if (fileName.size() <= dirLen) return false;
@@ -234,11 +293,10 @@ private:
 
   HANDLE TryFindDirHandle(LPCWSTR lpDir) const {
     size_t dirLen = wcslen(lpDir);
-    for (size_t i = 0; i < m_includedFiles.size(); ++i) {
-      const std::wstring &fileName = m_includedFiles[i].Name;
-      if (IsDirOf(lpDir, dirLen, fileName)) {
-        return DxcArgsHandle(HandleKind::FileDir, i, dirLen).Handle;
-      }
+    auto dirIt = m_includedDirIndices.find(lpDir);
+    if (dirIt != m_includedDirIndices.end()) {
+      DXASSERT_NOMSG(IsDirOf(lpDir, dirLen, m_includedFiles[dirIt->second].Name));
+      return DxcArgsHandle(HandleKind::FileDir, dirIt->second, dirLen).Handle;
     }
     for (size_t i = 0; i < m_searchEntries.size(); ++i) {
       if (IsDirPrefixOrSame(lpDir, dirLen, m_searchEntries[i])) {
@@ -248,49 +306,66 @@ private:
     return INVALID_HANDLE_VALUE;
   }
   DWORD TryFindOrOpen(LPCWSTR lpFileName, size_t &index) {
-    for (size_t i = 0; i < m_includedFiles.size(); ++i) {
-      if (0 == wcscmp(lpFileName, m_includedFiles[i].Name.data())) {
-        index = i;
-        return ERROR_SUCCESS;
-      }
+    std::wstring key = NormalizeIncludePath(lpFileName);
+    auto fileIt = m_includedFileIndices.find(key);
+    if (fileIt != m_includedFileIndices.end()) {
+      index = fileIt->second;
+      return ERROR_SUCCESS;
+    }
+    auto missingIt = m_missingFiles.find(key);
+    if (missingIt != m_missingFiles.end()) {
+      return missingIt->second;
     }
 
     if (m_includeLoader.p != nullptr) {
       if (m_includedFiles.size() == MaxIncludedFiles) {
         return ERROR_OUT_OF_STRUCTURES;
       }
-
+      DWORD loadError = TryLoad(lpFileName, index);
+      if (loadError != ERROR_SUCCESS)
+        m_missingFiles.emplace(std::move(key), loadError);
+      return loadError;
+    }
+    return ERROR_NOT_FOUND;
+  }
+  DWORD TryLoad(LPCWSTR lpFileName, size_t &index) {
+    CComPtr<IDxcBlobEncoding> fileBlobEncoded;
+    if (m_pIncludeCache.p != nullptr &&
+        FAILED(m_pIncludeCache->Lookup(lpFileName, &fileBlobEncoded))) {
+      return ERROR_UNHANDLED_EXCEPTION;
+    }
+    if (fileBlobEncoded.p == nullptr) {
       CComPtr<::IDxcBlob> fileBlob;
       HRESULT hr = m_includeLoader->LoadSource(lpFileName, &fileBlob);
       if (FAILED(hr)) {
         return ERROR_UNHANDLED_EXCEPTION;
       }
       if (fileBlob.p != nullptr) {
-        CComPtr<IDxcBlobEncoding> fileBlobEncoded;
         if (FAILED(hlsl::DxcGetBlobAsUtf8(fileBlob, &fileBlobEncoded))) {
           return ERROR_UNHANDLED_EXCEPTION;
         }
-        CComPtr<IStream> fileStream;
-        if (FAILED(hlsl::CreateReadOnlyBlobStream(fileBlobEncoded, &fileStream))) {
+        if (m_pIncludeCache.p != nullptr &&
+            FAILED(m_pIncludeCache->Store(lpFileName, fileBlobEncoded))) {
           return ERROR_UNHANDLED_EXCEPTION;
         }
-        m_includedFiles.emplace_back(std::wstring(lpFileName), fileBlobEncoded, fileStream);
-        index = m_includedFiles.size() - 1;
-
-        if (m_bDisplayIncludeProcess) {
-          std::string openFileStr;
-          raw_string_ostream s(openFileStr);
-          std::string fileName = Unicode::UTF16ToUTF8StringOrThrow(lpFileName);
-          s << "Opening file [" << fileName << "], stack top [" << (index-1)
-            << "]\n";
-          s.flush();
-          ULONG cbWritten;
-          IFT(m_pStdErrStream->Write(openFileStr.c_str(), openFileStr.size(),
-                                 &cbWritten));
-        }
-        return ERROR_SUCCESS;
       }
     }
+    if (fileBlobEncoded.p != nullptr) {
+      index = AddIncludedFile(std::wstring(lpFileName), fileBlobEncoded);
+
+      if (m_bDisplayIncludeProcess) {
+        std::string openFileStr;
+        raw_string_ostream s(openFileStr);
+        std::string fileName = Unicode::UTF16ToUTF8StringOrThrow(lpFileName);
+        s << "Opening file [" << fileName << "], stack top [" << (index-1)
+          << "]\n";
+        s.flush();
+        ULONG cbWritten;
+        IFT(m_pStdErrStream->Write(openFileStr.c_str(), openFileStr.size(),
+                               &cbWritten));
+      }
+      return ERROR_SUCCESS;
+    }
     return ERROR_NOT_FOUND;
   }
   static HANDLE IncludedFileIndexToHandle(size_t index) {
@@ -310,12 +385,14 @@ public:
       : m_pSource(pSource), m_pSourceName(pSourceName), m_includeLoader(pHandler), m_bDisplayIncludeProcess(false),
         m_pOutputStreamName(nullptr) {
     MakeAbsoluteOrCurDirRelativeW(m_pSourceName, m_pAbsSourceName);
-    IFT(CreateReadOnlyBlobStream(m_pSource, &m_pSourceStream));
-    m_includedFiles.push_back(IncludedFile(std::wstring(m_pSourceName), m_pSource, m_pSourceStream));
+    AddIncludedFile(std::wstring(m_pSourceName), m_pSource);
   }
   void EnableDisplayIncludeProcess() override {
     m_bDisplayIncludeProcess = true;
   }
+  void SetIncludeCache(_In_opt_ IDxcIncludeCache *pCache) override {
+    m_pIncludeCache = pCache;
+  }
   void WriteStdErrToStream(raw_string_ostream &s) override {
     s.write((char*)m_pStdErrStream->GetPtr(), m_pStdErrStream->GetPtrSize());
     s.flush();
@@ -345,12 +422,16 @@ public:
     else if (argsHandle == StdErrHandle) {
       stream = m_pStdErrStream;
     }
-    else if (argsHandle.GetKind() == HandleKind::File) {
-      stream = HandleToIncludedFile(handle).BlobStream;
-    }
     *ppResult = stream.Detach();
   }
 
+  // Included files are read-only and have no stream; see IncludedFile.
+  IncludedFile *TryGetIncludedFileForFD(int fd) {
+    HANDLE handle = HandleFromFD(fd);
+    if (!DxcArgsHandle(handle).IsFileKind()) return nullptr;
+    return &HandleToIncludedFile(handle);
+  }
+
   void GetStdOutpuHandleStream(IStream **ppResultStream) override {
     return GetStreamForHandle(StdOutHandle.Handle, ppResultStream);
   }
@@ -385,6 +466,18 @@ public:
     return S_OK;
   }
 
+  void GetOpenedFileNames(std::vector<std::wstring> &names) override {
+    for (const IncludedFile &file : m_includedFiles)
+      names.push_back(file.Name);
+  }
+
+  void GetIncludedFiles(
+      std::vector<std::pair<std::wstring, CComPtr<IDxcBlob>>> &files) override {
+    // The first file is the source itself.
+    for (size_t i = 1; i < m_includedFiles.size(); ++i)
+      files.emplace_back(m_includedFiles[i].Name, m_includedFiles[i].Blob);
+  }
+
   __override ~DxcArgsFileSystemImpl() { };
   __override BOOL FindNextFileW(
     _In_   HANDLE hFindFile,
@@ -635,6 +728,27 @@ public:
     return 0;
   }
   __override long lseek(int fd, long offset, int origin) throw() {
+    if (IncludedFile *pFile = TryGetIncludedFileForFD(fd)) {
+      // Same rules as the read-only blob stream: no seeking past the end.
+      ULONG size = (ULONG)pFile->Blob->GetBufferSize();
+      ULONG newOffset;
+      switch (origin) {
+      case STREAM_SEEK_SET: newOffset = 0; break;
+      case STREAM_SEEK_CUR: newOffset = pFile->Offset; break;
+      case STREAM_SEEK_END: newOffset = size; break;
+      default:
+        errno = EINVAL;
+        return -1;
+      }
+      newOffset += (ULONG)offset;
+      if (newOffset > size) {
+        errno = EINVAL;
+        return -1;
+      }
+      pFile->Offset = newOffset;
+      return newOffset;
+    }
+
     CComPtr<IStream> stream;
     GetStreamForFD(fd, &stream);
     if (stream == nullptr) {
@@ -661,6 +775,15 @@ public:
     return 0;
   }
   __override int Read(int fd, _Out_bytecap_(count) void* buffer, unsigned int count) throw() {
+    if (IncludedFile *pFile = TryGetIncludedFileForFD(fd)) {
+      ULONG size = (ULONG)pFile->Blob->GetBufferSize();
+      ULONG cbRead = std::min((ULONG)count, size - pFile->Offset);
+      memcpy(buffer, (char *)pFile->Blob->GetBufferPointer() + pFile->Offset,
+             cbRead);
+      pFile->Offset += cbRead;
+      return (int)cbRead;
+    }
+
     CComPtr<IStream> stream;
     GetStreamForFD(fd, &stream);
     if (stream == nullptr) {
@@ -708,6 +831,73 @@ public:
 }
 
 namespace dxcutil {
+/// Default IDxcIncludeCache implementation, an in-memory map guarded by a
+/// mutex so a single instance can be attached to compilers on any thread.
+class DxcIncludeCache : public IDxcIncludeCache {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  std::mutex m_mutex;
+  std::unordered_map<std::wstring, CComPtr<IDxcBlobEncoding>> m_entries;
+
+  static bool HasSameContents(IDxcBlob *pLHS, IDxcBlob *pRHS) {
+    return pLHS->GetBufferSize() == pRHS->GetBufferSize() &&
+           0 == memcmp(pLHS->GetBufferPointer(), pRHS->GetBufferPointer(),
+                       pLHS->GetBufferSize());
+  }
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeCache>(this, iid, ppvObject);
+  }
+
+  DxcIncludeCache() : m_dwRef(0) { }
+
+  __override HRESULT STDMETHODCALLTYPE Lookup(
+    _In_ LPCWSTR pFileName,
+    _COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppSource) {
+    if (pFileName == nullptr || ppSource == nullptr)
+      return E_POINTER;
+    *ppSource = nullptr;
+    try {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_entries.find(pFileName);
+      if (it != m_entries.end()) {
+        *ppSource = it->second;
+        (*ppSource)->AddRef();
+      }
+      return S_OK;
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Store(
+    _In_ LPCWSTR pFileName, _In_ IDxcBlobEncoding *pSource) {
+    if (pFileName == nullptr || pSource == nullptr)
+      return E_POINTER;
+    try {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      CComPtr<IDxcBlobEncoding> &entry = m_entries[pFileName];
+      if (entry.p == nullptr || !HasSameContents(entry, pSource))
+        entry = pSource;
+      return S_OK;
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Invalidate(_In_opt_ LPCWSTR pFileName) {
+    try {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (pFileName == nullptr)
+        m_entries.clear();
+      else
+        m_entries.erase(pFileName);
+      return S_OK;
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+};
 
 HRESULT
 CreateDxcArgsFileSystem(
@@ -722,4 +912,14 @@ CreateDxcArgsFileSystem(
   return S_OK;
 }
 
-} // namespace dxcutil
\ No newline at end of file
+} // namespace dxcutil
+
+HRESULT CreateDxcIncludeCache(_In_ REFIID riid, _Out_ LPVOID *ppv) {
+  CComPtr<dxcutil::DxcIncludeCache> result = new (std::nothrow) dxcutil::DxcIncludeCache();
+  if (result == nullptr) {
+    *ppv = nullptr;
+    return E_OUTOFMEMORY;
+  }
+
+  return result.p->QueryInterface(riid, ppv);
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcincremental.cpp                                                        //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements the digest incremental compilation matches entry points by.    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxcincremental.h"
+#include "dxc/HLSL/DxilShaderModel.h"
+#include "dxc/HLSL/HLModule.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclBase.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+typedef SmallPtrSet<Function *, 32> FunctionSet;
+
+// Same walk as DxilViewIdState::ComputeReachableFunctionsRec, except that
+// the high-level module is not inlined yet, so functions are reached more
+// than once.
+void ComputeReachableFunctionsRec(CallGraph &CG, CallGraphNode *pNode,
+                                  FunctionSet &FuncSet) {
+  Function *F = pNode->getFunction();
+  // Accumulate only functions with bodies.
+  if (F == nullptr || F->empty() || !FuncSet.insert(F).second)
+    return;
+  for (auto it = pNode->begin(), itEnd = pNode->end(); it != itEnd; ++it) {
+    CallGraphNode *pSuccNode = it->second;
+    ComputeReachableFunctionsRec(CG, pSuccNode, FuncSet);
+  }
+}
+
+void CollectGlobals(Constant *C, SetVector<GlobalVariable *> &Globals) {
+  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(C)) {
+    if (Globals.insert(GV) && GV->hasInitializer())
+      CollectGlobals(GV->getInitializer(), Globals);
+    return;
+  }
+  for (Value *Op : C->operands()) {
+    if (Constant *OpC = dyn_cast<Constant>(Op))
+      CollectGlobals(OpC, Globals);
+  }
+}
+
+void UpdateString(MD5 &md5, StringRef str) {
+  // Hash strings with their terminator so adjacent fields can't alias.
+  md5.update(ArrayRef<uint8_t>((const uint8_t *)str.data(), str.size() + 1));
+}
+} // namespace
+
+void dxcutil::ComputeEntryPointDigest(clang::ASTContext &C, Module &M,
+                                      MD5::MD5Result &digest) {
+  MD5 md5;
+  std::string text;
+  raw_string_ostream OS(text);
+
+  // Declarations, with function bodies left to the IR below.
+  clang::PrintingPolicy declPolicy(C.getPrintingPolicy());
+  clang::PrintingPolicy signaturePolicy(declPolicy);
+  signaturePolicy.TerseOutput = true;
+  for (clang::Decl *D : C.getTranslationUnitDecl()->decls()) {
+    if (D->isImplicit())
+      continue;
+    D->print(OS, isa<clang::FunctionDecl>(D) ? signaturePolicy : declPolicy);
+    OS << '\n';
+  }
+  UpdateString(md5, OS.str());
+  text.clear();
+
+  // Reachable function bodies and the globals they use, in module order.
+  HLModule &HLM = M.GetHLModule();
+  CallGraphAnalysis CGA;
+  CallGraph CG = CGA.run(&M);
+  FunctionSet reachable;
+  if (HLM.GetShaderModel()->IsLib()) {
+    for (Function &F : M) {
+      if (!F.isDeclaration())
+        reachable.insert(&F);
+    }
+  } else if (Function *pEntry = HLM.GetEntryFunction()) {
+    ComputeReachableFunctionsRec(CG, CG[pEntry], reachable);
+    if (HLM.HasDxilFunctionProps(pEntry)) {
+      DxilFunctionProps &props = HLM.GetDxilFunctionProps(pEntry);
+      if (props.IsHS() && props.ShaderProps.HS.patchConstantFunc)
+        ComputeReachableFunctionsRec(
+            CG, CG[props.ShaderProps.HS.patchConstantFunc], reachable);
+    }
+  }
+
+  SetVector<GlobalVariable *> globals;
+  for (Function &F : M) {
+    if (!reachable.count(&F))
+      continue;
+    F.print(OS);
+    for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+      for (Value *Op : I->operands()) {
+        if (Constant *OpC = dyn_cast<Constant>(Op))
+          CollectGlobals(OpC, globals);
+      }
+    }
+  }
+  for (GlobalVariable &GV : M.globals()) {
+    if (globals.count(&GV)) {
+      GV.print(OS);
+      OS << '\n';
+    }
+  }
+  UpdateString(md5, OS.str());
+  md5.final(digest);
+}
@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcincremental.h                                                          //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the digest incremental compilation matches entry points by.      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "llvm/Support/MD5.h"
+
+namespace clang {
+class ASTContext;
+}
+
+namespace llvm {
+class Module;
+}
+
+namespace dxcutil {
+// Computes the digest of what the backend compiles the entry point of the
+// high-level module M from: the IR of the functions reachable from the entry
+// point and its patch constant function, the globals they use, and every
+// declaration of the translation unit outside of function bodies, which
+// carry the signatures, attributes, types and resource bindings that the
+// high-level module derives its metadata from. For libraries, every
+// function counts as reachable.
+//
+// Edits to functions the entry point does not reach leave the digest
+// unchanged. The IR carries no source positions without debug information,
+// so callers must not match compilations with debug information by it.
+void ComputeEntryPointDigest(clang::ASTContext &C, llvm::Module &M,
+                             llvm::MD5::MD5Result &digest);
+} // namespace dxcutil
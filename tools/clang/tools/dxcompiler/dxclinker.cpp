@@ -14,13 +14,21 @@
 #include "dxc/Support/ErrorCodes.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/MemoryTracking.h"
 #include "dxc/Support/dxcapi.impl.h"
 #include "dxc/Support/microcom.h"
 #include "dxc/dxcapi.h"
 #include "dxillib.h"
 
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MD5.h"
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include "dxc/HLSL/DxilLinker.h"
 #include "dxc/HLSL/DxilValidation.h"
@@ -42,7 +50,12 @@ using namespace llvm;
 // This declaration is used for the locally-linked validator.
 HRESULT CreateDxcValidator(_In_ REFIID riid, _Out_ LPVOID *ppv);
 
-class DxcLinker : public IDxcLinker, public IDxcContainerEvent {
+class DxcLinker : public IDxcLinker,
+                  public IDxcLinkerBatch,
+                  public IDxcLinkerResultCache,
+                  public IDxcLinkerLibraryUpdate,
+                  public IDxcMemoryAccounting,
+                  public IDxcContainerEvent {
 public:
   // Register a library with name to ref it later.
   __override HRESULT RegisterLibrary(
@@ -65,6 +78,37 @@ public:
           *ppResult // Linker output status, buffer, and errors
   );
 
+  // Links several entry points concurrently.
+  __override HRESULT STDMETHODCALLTYPE LinkBatch(
+      _In_count_(targetCount)
+          const DxcCompileTarget *pTargets, // Array of (entry point, profile) pairs
+      _In_ UINT32 targetCount,              // Number of targets
+      _In_count_(libCount)
+          const LPCWSTR *pLibNames, // Array of library names to link
+      UINT32 libCount,              // Number of libraries to link
+      _In_count_(argCount)
+          const LPCWSTR *pArguments, // Array of pointers to arguments
+      _In_ UINT32 argCount,          // Number of arguments
+      _Out_writes_(targetCount) IDxcOperationResult *
+          *ppResults // Linker output status, buffer, and errors per target
+  );
+
+  // Sets the number of successful links whose results are kept.
+  __override HRESULT STDMETHODCALLTYPE
+  SetResultCacheCapacity(UINT32 capacity);
+
+  // Replaces a registered library, keeping the cached results it leaves
+  // valid.
+  __override HRESULT STDMETHODCALLTYPE UpdateLibrary(_In_ LPCWSTR pLibName,
+                                                     _In_ IDxcBlob *pBlob);
+
+  __override HRESULT STDMETHODCALLTYPE
+  SetMemoryAccounting(BOOL enabled, UINT64 limitBytes) {
+    m_memoryAccounting.Enabled = enabled != FALSE;
+    m_memoryAccounting.LimitBytes = limitBytes;
+    return S_OK;
+  }
+
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
 
   __override HRESULT STDMETHODCALLTYPE RegisterDxilContainerEventHandler(
@@ -84,7 +128,10 @@ public:
   }
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcLinker>(this, riid, ppvObject);
+    return DoBasicQueryInterface<IDxcLinker, IDxcLinkerBatch,
+                                 IDxcLinkerResultCache,
+                                 IDxcLinkerLibraryUpdate,
+                                 IDxcMemoryAccounting>(this, riid, ppvObject);
   }
 
   DxcLinker() : m_dwRef(0), m_pLinker(nullptr) {
@@ -103,73 +150,174 @@ private:
 
   std::unique_ptr<DxilLinker> m_pLinker;
   CComPtr<IDxcContainerEventsHandler> m_pDxcContainerEventsHandler;
+  // Registered library containers. They back the lazily loaded library
+  // modules, and LinkBatch loads them again into the context of each of its
+  // workers.
+  llvm::StringMap<CComPtr<IDxcBlob>> m_libBlobs;
+  // MD5 digests of the registered library containers.
+  llvm::StringMap<std::string> m_libDigests;
+  dxcutil::MemoryAccounting m_memoryAccounting;
+
+  // Results of successful links, keyed by GetResultCacheKey. m_cacheOrder
+  // holds the keys oldest first, so the oldest result is dropped when the
+  // cache is full. Guarded by m_cacheMutex, as LinkBatch workers use it.
+  // Each result keeps what it was linked from, so that UpdateLibrary can
+  // tell whether it is still valid and key it again.
+  struct CachedLink {
+    std::string entryPoint;
+    std::string targetProfile;
+    std::vector<std::string> libNames;
+    std::vector<std::string> arguments;
+    llvm::StringSet<> linkedFunctions;
+  };
+  struct CachedResult {
+    CComPtr<IDxcBlob> pResultBlob;
+    CComPtr<IDxcBlobEncoding> pErrorBlob;
+    std::shared_ptr<CachedLink> pLink;
+  };
+  std::mutex m_cacheMutex;
+  UINT32 m_cacheCapacity = 0;
+  llvm::StringMap<CachedResult> m_cachedResults;
+  std::deque<std::string> m_cacheOrder;
+
+  bool GetResultCacheKey(const char *pUtf8EntryPoint,
+                         const char *pUtf8TargetProfile,
+                         ArrayRef<std::string> libNames,
+                         ArrayRef<std::string> arguments, std::string &key);
+  bool ComputeResultCacheKey(const char *pUtf8EntryPoint,
+                             const char *pUtf8TargetProfile,
+                             ArrayRef<std::string> libNames,
+                             ArrayRef<std::string> arguments,
+                             std::string &key);
+  bool LookupResult(StringRef key, IDxcOperationResult **ppResult);
+  void StoreResult(StringRef key, IDxcOperationResult *pResult,
+                   const char *pUtf8EntryPoint, const char *pUtf8TargetProfile,
+                   ArrayRef<std::string> libNames,
+                   ArrayRef<std::string> arguments,
+                   llvm::StringSet<> &linkedFunctions);
+  void UpdateCachedResults(StringRef libName,
+                           const llvm::StringSet<> &changedFunctions,
+                           bool bAllChanged);
 };
 
-HRESULT
-DxcLinker::RegisterLibrary(_In_opt_ LPCWSTR pLibName, // Name of the library.
-                           _In_ IDxcBlob *pBlob       // Library to add.
-) {
-  // Prepare UTF8-encoded versions of API values.
-  CW2A pUtf8LibName(pLibName, CP_UTF8);
-  // Already exist lib with same name.
-  if (m_pLinker->HasLibNameRegistered(pUtf8LibName.m_psz))
-    return E_INVALIDARG;
+// Loads the modules of a library container into Ctx. Function bodies are
+// materialized when a link first needs them, so pBlob must outlive the
+// modules.
+static HRESULT LoadLinkModules(LLVMContext &Ctx, IDxcBlob *pBlob,
+                               std::unique_ptr<llvm::Module> &pModule,
+                               std::unique_ptr<llvm::Module> &pDebugModule) {
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<AbstractMemoryStream> pDiagStream;
 
-  try {
-    std::unique_ptr<llvm::Module> pModule, pDebugModule;
+  IFR(CoGetMalloc(1, &pMalloc));
+  IFR(CreateMemoryStream(pMalloc, &pDiagStream));
 
-    CComPtr<IMalloc> pMalloc;
-    CComPtr<AbstractMemoryStream> pDiagStream;
+  raw_stream_ostream DiagStream(pDiagStream);
 
-    IFT(CoGetMalloc(1, &pMalloc));
-    IFT(CreateMemoryStream(pMalloc, &pDiagStream));
+  return ValidateLoadModuleFromContainer(
+      pBlob->GetBufferPointer(), pBlob->GetBufferSize(), pModule,
+      pDebugModule, Ctx, Ctx, DiagStream, /*bLazy*/ true);
+}
 
-    raw_stream_ostream DiagStream(pDiagStream);
+// Loads a library container into Ctx and registers it with pLinker. pBlob
+// must outlive the library.
+static HRESULT LoadLinkLibrary(DxilLinker *pLinker, LLVMContext &Ctx,
+                           StringRef name, IDxcBlob *pBlob) {
+  std::unique_ptr<llvm::Module> pModule, pDebugModule;
+  IFR(LoadLinkModules(Ctx, pBlob, pModule, pDebugModule));
+
+  return pLinker->RegisterLib(name, std::move(pModule),
+                              std::move(pDebugModule))
+             ? S_OK
+             : E_INVALIDARG;
+}
 
-    IFR(ValidateLoadModuleFromContainer(
-        pBlob->GetBufferPointer(), pBlob->GetBufferSize(), pModule,
-        pDebugModule, m_Ctx, m_Ctx, DiagStream));
+// Returns the MD5 digest of a library container.
+static std::string GetLibraryDigest(IDxcBlob *pBlob) {
+  llvm::MD5 md5;
+  llvm::MD5::MD5Result digest;
+  md5.update(ArrayRef<uint8_t>((const uint8_t *)pBlob->GetBufferPointer(),
+                               pBlob->GetBufferSize()));
+  md5.final(digest);
+  return std::string((const char *)digest, sizeof(digest));
+}
 
-    return m_pLinker->RegisterLib(pUtf8LibName.m_psz, std::move(pModule),
-                                  std::move(pDebugModule))
-               ? S_OK
-               : E_INVALIDARG;
-  } catch (hlsl::Exception &) {
-    return E_INVALIDARG;
+// Returns UTF-8 copies of the arguments of a link.
+static std::vector<std::string> GetUtf8Arguments(const LPCWSTR *pArguments,
+                                                 UINT32 argCount) {
+  std::vector<std::string> arguments;
+  for (UINT32 i = 0; i < argCount; ++i) {
+    CW2A pUtf8Arg(pArguments[i], CP_UTF8);
+    arguments.emplace_back(pUtf8Arg.m_psz);
   }
+  return arguments;
 }
 
-// Links the shader and produces a shader blob that the Direct3D runtime can
-// use.
-HRESULT STDMETHODCALLTYPE DxcLinker::Link(
-    _In_opt_ LPCWSTR pEntryName, // Entry point name
-    _In_ LPCWSTR pTargetProfile, // shader profile to link
-    _In_count_(libCount)
-        const LPCWSTR *pLibNames, // Array of library names to link
-    UINT32 libCount,              // Number of libraries to link
-    _In_count_(argCount)
-        const LPCWSTR *pArguments, // Array of pointers to arguments
-    _In_ UINT32 argCount,          // Number of arguments
-    _COM_Outptr_ IDxcOperationResult *
-        *ppResult // Linker output status, buffer, and errors
-) {
-  // Prepare UTF8-encoded versions of API values.
-  CW2A pUtf8EntryPoint(pEntryName, CP_UTF8);
-  CW2A pUtf8TargetProfile(pTargetProfile, CP_UTF8);
-  // TODO: read and validate options.
+// Collects link-time constant values given as "-D name=value" or
+// "-Dname=value", and the optimization level given as -Od or -O0 to -O3.
+// Other arguments are ignored.
+static HRESULT ReadLinkArguments(const LPCWSTR *pArguments, UINT32 argCount,
+                                 StringMap<std::string> &linkConstants,
+                                 unsigned &optLevel) {
+  optLevel = 0;
+  if (argCount > 0 && pArguments == nullptr)
+    return E_INVALIDARG;
+  for (UINT32 i = 0; i < argCount; ++i) {
+    CW2A pUtf8Arg(pArguments[i], CP_UTF8);
+    StringRef arg(pUtf8Arg.m_psz);
+    if (arg.startswith("-O") || arg.startswith("/O")) {
+      StringRef level = arg.substr(2);
+      if (level == "d")
+        optLevel = 0;
+      else if (level.size() == 1 && level[0] >= '0' && level[0] <= '3')
+        optLevel = level[0] - '0';
+      else
+        return E_INVALIDARG;
+      continue;
+    }
+    if (!arg.startswith("-D") && !arg.startswith("/D"))
+      continue;
+    std::string define = arg.substr(2);
+    if (define.empty()) {
+      if (++i == argCount)
+        return E_INVALIDARG;
+      CW2A pUtf8Define(pArguments[i], CP_UTF8);
+      define = pUtf8Define.m_psz;
+    }
+    std::pair<StringRef, StringRef> nameValue = StringRef(define).split('=');
+    if (nameValue.first.empty() || nameValue.second.empty())
+      return E_INVALIDARG;
+    linkConstants[nameValue.first] = nameValue.second;
+  }
+  return S_OK;
+}
 
+// Links one entry point from the libraries registered with pLinker, which
+// must have been created for Ctx. If pLinkedFunctions is not null, it
+// receives the names of the library functions the link used.
+static HRESULT LinkEntry(DxilLinker *pLinker, LLVMContext &Ctx,
+                         const char *pUtf8EntryPoint,
+                         const char *pUtf8TargetProfile,
+                         ArrayRef<std::string> libNames,
+                         const StringMap<std::string> &linkConstants,
+                         unsigned optLevel,
+                         IDxcContainerEventsHandler *pEventsHandler,
+                         const dxcutil::MemoryAccounting &memoryAccounting,
+                         StringSet<> *pLinkedFunctions,
+                         IDxcOperationResult **ppResult) {
   CComPtr<AbstractMemoryStream> pOutputStream;
 
   // Detach previous libraries.
-  m_pLinker->DetachAll();
+  pLinker->DetachAll();
 
   HRESULT hr = S_OK;
+  dxcutil::MemoryAccountingScope memoryScope(memoryAccounting);
   try {
     CComPtr<IMalloc> pMalloc;
     CComPtr<IDxcBlob> pOutputBlob;
     CComPtr<AbstractMemoryStream> pDiagStream;
 
-    IFT(CoGetMalloc(1, &pMalloc));
+    IFT(DxcGetOperationMalloc(&pMalloc));
     IFT(CreateMemoryStream(pMalloc, &pOutputStream));
 
     std::string warnings;
@@ -189,20 +337,20 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
 
     llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
     PrintDiagnosticContext DiagContext(DiagPrinter);
-    m_Ctx.setDiagnosticHandler(PrintDiagnosticContext::PrintDiagnosticHandler,
-                               &DiagContext, true);
+    Ctx.setDiagnosticHandler(PrintDiagnosticContext::PrintDiagnosticHandler,
+                             &DiagContext, true);
 
     // Attach libraries.
     bool bSuccess = true;
-    for (unsigned i = 0; i < libCount; i++) {
-      CW2A pUtf8LibName(pLibNames[i], CP_UTF8);
-      bSuccess &= m_pLinker->AttachLib(pUtf8LibName.m_psz);
+    for (const std::string &libName : libNames) {
+      bSuccess &= pLinker->AttachLib(libName);
     }
 
     bool hasErrorOccurred = !bSuccess;
     if (bSuccess) {
       std::unique_ptr<Module> pM =
-          m_pLinker->Link(pUtf8EntryPoint.m_psz, pUtf8TargetProfile.m_psz);
+          pLinker->Link(pUtf8EntryPoint, pUtf8TargetProfile,
+                        linkConstants, optLevel, pLinkedFunctions);
       if (pM) {
         const IntrusiveRefCntPtr<clang::DiagnosticIDs> Diags(
             new clang::DiagnosticIDs);
@@ -227,9 +375,9 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
         // Callback after valid DXIL is produced
         if (SUCCEEDED(valHR)) {
           CComPtr<IDxcBlob> pTargetBlob;
-          if (m_pDxcContainerEventsHandler != nullptr) {
-            HRESULT hr = m_pDxcContainerEventsHandler->OnDxilContainerBuilt(
-                pOutputBlob, &pTargetBlob);
+          if (pEventsHandler != nullptr) {
+            HRESULT hr = pEventsHandler->OnDxilContainerBuilt(pOutputBlob,
+                                                              &pTargetBlob);
             if (SUCCEEDED(hr) && pTargetBlob != nullptr) {
               std::swap(pOutputBlob, pTargetBlob);
             }
@@ -249,9 +397,366 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
                                               hasErrorOccurred, ppResult);
   }
   CATCH_CPP_ASSIGN_HRESULT();
+  return memoryScope.Finish(hr, ppResult);
+}
+
+HRESULT
+DxcLinker::RegisterLibrary(_In_opt_ LPCWSTR pLibName, // Name of the library.
+                           _In_ IDxcBlob *pBlob       // Library to add.
+) {
+  // Prepare UTF8-encoded versions of API values.
+  CW2A pUtf8LibName(pLibName, CP_UTF8);
+  // Already exist lib with same name.
+  if (m_pLinker->HasLibNameRegistered(pUtf8LibName.m_psz))
+    return E_INVALIDARG;
+
+  try {
+    IFR(LoadLinkLibrary(m_pLinker.get(), m_Ctx, pUtf8LibName.m_psz, pBlob));
+    m_libBlobs[pUtf8LibName.m_psz] = pBlob;
+    m_libDigests[pUtf8LibName.m_psz] = GetLibraryDigest(pBlob);
+    return S_OK;
+  } catch (hlsl::Exception &) {
+    return E_INVALIDARG;
+  }
+}
+
+HRESULT STDMETHODCALLTYPE DxcLinker::UpdateLibrary(_In_ LPCWSTR pLibName,
+                                                   _In_ IDxcBlob *pBlob) {
+  if (pLibName == nullptr || pBlob == nullptr)
+    return E_INVALIDARG;
+  CW2A pUtf8LibName(pLibName, CP_UTF8);
+  if (!m_pLinker->HasLibNameRegistered(pUtf8LibName.m_psz))
+    return E_INVALIDARG;
+
+  try {
+    std::unique_ptr<llvm::Module> pModule, pDebugModule;
+    IFR(LoadLinkModules(m_Ctx, pBlob, pModule, pDebugModule));
+
+    // Each link attaches its libraries again, and an attached library
+    // cannot be replaced.
+    m_pLinker->DetachAll();
+    StringSet<> changedFunctions;
+    bool bAllChanged;
+    if (!m_pLinker->ReplaceLib(pUtf8LibName.m_psz, std::move(pModule),
+                               std::move(pDebugModule), changedFunctions,
+                               bAllChanged))
+      return E_INVALIDARG;
+    // The old container is released only once its modules are gone.
+    m_libBlobs[pUtf8LibName.m_psz] = pBlob;
+    m_libDigests[pUtf8LibName.m_psz] = GetLibraryDigest(pBlob);
+    UpdateCachedResults(pUtf8LibName.m_psz, changedFunctions, bAllChanged);
+    return S_OK;
+  } catch (hlsl::Exception &) {
+    return E_INVALIDARG;
+  }
+}
+
+// Links the shader and produces a shader blob that the Direct3D runtime can
+// use.
+HRESULT STDMETHODCALLTYPE DxcLinker::Link(
+    _In_opt_ LPCWSTR pEntryName, // Entry point name
+    _In_ LPCWSTR pTargetProfile, // shader profile to link
+    _In_count_(libCount)
+        const LPCWSTR *pLibNames, // Array of library names to link
+    UINT32 libCount,              // Number of libraries to link
+    _In_count_(argCount)
+        const LPCWSTR *pArguments, // Array of pointers to arguments
+    _In_ UINT32 argCount,          // Number of arguments
+    _COM_Outptr_ IDxcOperationResult *
+        *ppResult // Linker output status, buffer, and errors
+) {
+  // Prepare UTF8-encoded versions of API values.
+  CW2A pUtf8EntryPoint(pEntryName, CP_UTF8);
+  CW2A pUtf8TargetProfile(pTargetProfile, CP_UTF8);
+
+  HRESULT hr = S_OK;
+  try {
+    StringMap<std::string> linkConstants;
+    unsigned optLevel;
+    IFR(ReadLinkArguments(pArguments, argCount, linkConstants, optLevel));
+    std::vector<std::string> libNames;
+    for (unsigned i = 0; i < libCount; i++) {
+      CW2A pUtf8LibName(pLibNames[i], CP_UTF8);
+      libNames.emplace_back(pUtf8LibName.m_psz);
+    }
+    std::vector<std::string> arguments =
+        GetUtf8Arguments(pArguments, argCount);
+    std::string cacheKey;
+    bool bCache =
+        GetResultCacheKey(pUtf8EntryPoint.m_psz, pUtf8TargetProfile.m_psz,
+                          libNames, arguments, cacheKey);
+    if (bCache && LookupResult(cacheKey, ppResult))
+      return S_OK;
+    StringSet<> linkedFunctions;
+    hr = LinkEntry(m_pLinker.get(), m_Ctx, pUtf8EntryPoint.m_psz,
+                   pUtf8TargetProfile.m_psz, libNames, linkConstants,
+                   optLevel, m_pDxcContainerEventsHandler,
+                   m_memoryAccounting, bCache ? &linkedFunctions : nullptr,
+                   ppResult);
+    if (SUCCEEDED(hr) && bCache)
+      StoreResult(cacheKey, *ppResult, pUtf8EntryPoint.m_psz,
+                  pUtf8TargetProfile.m_psz, libNames, arguments,
+                  linkedFunctions);
+  }
+  CATCH_CPP_ASSIGN_HRESULT();
+  return hr;
+}
+
+// Links several entry points concurrently.
+HRESULT STDMETHODCALLTYPE DxcLinker::LinkBatch(
+    _In_count_(targetCount)
+        const DxcCompileTarget *pTargets, // Array of (entry point, profile) pairs
+    _In_ UINT32 targetCount,              // Number of targets
+    _In_count_(libCount)
+        const LPCWSTR *pLibNames, // Array of library names to link
+    UINT32 libCount,              // Number of libraries to link
+    _In_count_(argCount)
+        const LPCWSTR *pArguments, // Array of pointers to arguments
+    _In_ UINT32 argCount,          // Number of arguments
+    _Out_writes_(targetCount) IDxcOperationResult *
+        *ppResults // Linker output status, buffer, and errors per target
+) {
+  if (ppResults == nullptr || (targetCount > 0 && pTargets == nullptr) ||
+      (libCount > 0 && pLibNames == nullptr))
+    return E_INVALIDARG;
+  for (UINT32 i = 0; i < targetCount; ++i)
+    ppResults[i] = nullptr;
+
+  HRESULT hr = S_OK;
+  try {
+    StringMap<std::string> linkConstants;
+    unsigned optLevel;
+    IFR(ReadLinkArguments(pArguments, argCount, linkConstants, optLevel));
+    std::vector<std::string> entryPoints, targetProfiles, libNames;
+    for (UINT32 i = 0; i < targetCount; ++i) {
+      CW2A pUtf8EntryPoint(pTargets[i].EntryPoint, CP_UTF8);
+      CW2A pUtf8TargetProfile(pTargets[i].TargetProfile, CP_UTF8);
+      entryPoints.emplace_back(pUtf8EntryPoint.m_psz);
+      targetProfiles.emplace_back(pUtf8TargetProfile.m_psz);
+    }
+    for (UINT32 i = 0; i < libCount; ++i) {
+      CW2A pUtf8LibName(pLibNames[i], CP_UTF8);
+      libNames.emplace_back(pUtf8LibName.m_psz);
+    }
+    std::vector<std::string> arguments =
+        GetUtf8Arguments(pArguments, argCount);
+
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, std::max(targetCount, 1u));
+
+    // A module can only be used from one thread at a time, so each worker
+    // loads the libraries into its own context once, then links and
+    // validates targets handed out one at a time. Linking only materializes
+    // bodies in the library modules, so they are reused across the worker's
+    // targets.
+    std::vector<HRESULT> results(targetCount, S_OK);
+    std::atomic<UINT32> nextTarget(0);
+    auto worker = [&]() {
+      HRESULT workerHR = S_OK;
+      try {
+        LLVMContext Ctx;
+        std::unique_ptr<DxilLinker> pLinker(DxilLinker::CreateLinker(Ctx));
+        // An unregistered name is left for AttachLib to report.
+        for (const std::string &libName : libNames) {
+          auto it = m_libBlobs.find(libName);
+          if (SUCCEEDED(workerHR) && it != m_libBlobs.end() &&
+              !pLinker->HasLibNameRegistered(libName))
+            workerHR = LoadLinkLibrary(pLinker.get(), Ctx, libName, it->second);
+        }
+        for (UINT32 i = nextTarget++; i < targetCount; i = nextTarget++) {
+          if (FAILED(workerHR)) {
+            results[i] = workerHR;
+            continue;
+          }
+          std::string cacheKey;
+          bool bCache = GetResultCacheKey(
+              entryPoints[i].c_str(), targetProfiles[i].c_str(), libNames,
+              arguments, cacheKey);
+          if (bCache && LookupResult(cacheKey, &ppResults[i]))
+            continue;
+          StringSet<> linkedFunctions;
+          results[i] = LinkEntry(pLinker.get(), Ctx, entryPoints[i].c_str(),
+                                 targetProfiles[i].c_str(), libNames,
+                                 linkConstants, optLevel,
+                                 m_pDxcContainerEventsHandler,
+                                 m_memoryAccounting,
+                                 bCache ? &linkedFunctions : nullptr,
+                                 &ppResults[i]);
+          if (SUCCEEDED(results[i]) && bCache)
+            StoreResult(cacheKey, ppResults[i], entryPoints[i].c_str(),
+                        targetProfiles[i].c_str(), libNames, arguments,
+                        linkedFunctions);
+        }
+        return;
+      } catch (const ::hlsl::Exception &hlslException) {
+        workerHR = hlslException.hr;
+      } catch (std::bad_alloc &) {
+        workerHR = E_OUTOFMEMORY;
+      } catch (...) {
+        workerHR = E_FAIL;
+      }
+      for (UINT32 i = nextTarget++; i < targetCount; i = nextTarget++)
+        results[i] = workerHR;
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i)
+      threads.emplace_back(worker);
+    worker();
+    for (std::thread &t : threads)
+      t.join();
+
+    for (UINT32 i = 0; SUCCEEDED(hr) && i < targetCount; ++i)
+      hr = results[i];
+  }
+  CATCH_CPP_ASSIGN_HRESULT();
+
+  if (FAILED(hr)) {
+    for (UINT32 i = 0; i < targetCount; ++i) {
+      if (ppResults[i] != nullptr) {
+        ppResults[i]->Release();
+        ppResults[i] = nullptr;
+      }
+    }
+  }
   return hr;
 }
 
+HRESULT STDMETHODCALLTYPE
+DxcLinker::SetResultCacheCapacity(UINT32 capacity) {
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  m_cacheCapacity = capacity;
+  while (m_cacheOrder.size() > m_cacheCapacity) {
+    m_cachedResults.erase(m_cacheOrder.front());
+    m_cacheOrder.pop_front();
+  }
+  return S_OK;
+}
+
+// Computes the key of a link in the result cache. Returns false if the cache
+// is disabled or a library is not registered, in which case the link is not
+// cached.
+bool DxcLinker::GetResultCacheKey(const char *pUtf8EntryPoint,
+                                  const char *pUtf8TargetProfile,
+                                  ArrayRef<std::string> libNames,
+                                  ArrayRef<std::string> arguments,
+                                  std::string &key) {
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (m_cacheCapacity == 0)
+      return false;
+  }
+  return ComputeResultCacheKey(pUtf8EntryPoint, pUtf8TargetProfile, libNames,
+                               arguments, key);
+}
+
+// Computes the key of a link from the entry point, profile, digests of the
+// libraries in link order and the arguments. Returns false if a library is
+// not registered.
+bool DxcLinker::ComputeResultCacheKey(const char *pUtf8EntryPoint,
+                                      const char *pUtf8TargetProfile,
+                                      ArrayRef<std::string> libNames,
+                                      ArrayRef<std::string> arguments,
+                                      std::string &key) {
+  llvm::MD5 md5;
+  auto updateString = [&md5](StringRef str) {
+    md5.update(ArrayRef<uint8_t>((const uint8_t *)str.data(), str.size() + 1));
+  };
+  updateString(pUtf8EntryPoint);
+  updateString(pUtf8TargetProfile);
+  for (const std::string &libName : libNames) {
+    auto it = m_libDigests.find(libName);
+    if (it == m_libDigests.end())
+      return false;
+    updateString(it->second);
+  }
+  for (const std::string &argument : arguments)
+    updateString(argument);
+  llvm::MD5::MD5Result digest;
+  md5.final(digest);
+  key.assign((const char *)digest, sizeof(digest));
+  return true;
+}
+
+// Creates a result for a cached link in ppResult, if there is one for key.
+bool DxcLinker::LookupResult(StringRef key, IDxcOperationResult **ppResult) {
+  CachedResult cached;
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto it = m_cachedResults.find(key);
+    if (it == m_cachedResults.end())
+      return false;
+    cached = it->second;
+  }
+  return SUCCEEDED(DxcOperationResult::CreateFromResultErrorStatus(
+      cached.pResultBlob, cached.pErrorBlob, S_OK, ppResult));
+}
+
+// Keeps the output of a successful link for later identical links.
+void DxcLinker::StoreResult(StringRef key, IDxcOperationResult *pResult,
+                            const char *pUtf8EntryPoint,
+                            const char *pUtf8TargetProfile,
+                            ArrayRef<std::string> libNames,
+                            ArrayRef<std::string> arguments,
+                            StringSet<> &linkedFunctions) {
+  HRESULT status;
+  CachedResult cached;
+  if (FAILED(pResult->GetStatus(&status)) || FAILED(status) ||
+      FAILED(pResult->GetResult(&cached.pResultBlob)) ||
+      FAILED(pResult->GetErrorBuffer(&cached.pErrorBlob)))
+    return;
+  cached.pLink = std::make_shared<CachedLink>();
+  cached.pLink->entryPoint = pUtf8EntryPoint;
+  cached.pLink->targetProfile = pUtf8TargetProfile;
+  cached.pLink->libNames = libNames;
+  cached.pLink->arguments = arguments;
+  cached.pLink->linkedFunctions.swap(linkedFunctions);
+
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  if (m_cacheCapacity == 0 || m_cachedResults.count(key))
+    return;
+  if (m_cacheOrder.size() == m_cacheCapacity) {
+    m_cachedResults.erase(m_cacheOrder.front());
+    m_cacheOrder.pop_front();
+  }
+  m_cachedResults[key] = cached;
+  m_cacheOrder.push_back(key);
+}
+
+// Drops the cached results of links that used a changed function of the
+// updated library, and keys the others again with its new digest.
+void DxcLinker::UpdateCachedResults(StringRef libName,
+                                    const StringSet<> &changedFunctions,
+                                    bool bAllChanged) {
+  std::lock_guard<std::mutex> lock(m_cacheMutex);
+  std::deque<std::string> cacheOrder;
+  for (const std::string &key : m_cacheOrder) {
+    auto it = m_cachedResults.find(key);
+    CachedResult cached = it->second;
+    const CachedLink &link = *cached.pLink;
+    if (std::find(link.libNames.begin(), link.libNames.end(), libName) ==
+        link.libNames.end()) {
+      cacheOrder.push_back(key);
+      continue;
+    }
+    m_cachedResults.erase(it);
+
+    bool bAffected = bAllChanged;
+    for (auto &changed : changedFunctions)
+      bAffected |= link.linkedFunctions.count(changed.getKey()) != 0;
+    std::string newKey;
+    if (bAffected ||
+        !ComputeResultCacheKey(link.entryPoint.c_str(),
+                               link.targetProfile.c_str(), link.libNames,
+                               link.arguments, newKey) ||
+        m_cachedResults.count(newKey))
+      continue;
+    m_cachedResults[newKey] = cached;
+    cacheOrder.push_back(newKey);
+  }
+  m_cacheOrder.swap(cacheOrder);
+}
+
 HRESULT CreateDxcLinker(_In_ REFIID riid, _Out_ LPVOID *ppv) {
   CComPtr<IDxcLinker> Result = new (std::nothrow) DxcLinker();
   if (Result == nullptr) {
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcmem.cpp                                                                //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Replaces the global allocation functions of the library so that the       //
+// memory LLVM and Clang allocate counts against the current operation.      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/MemoryTracking.h"
+#include <malloc.h>
+#include <new>
+
+using namespace hlsl;
+
+// The blocks come from malloc, as with the default operator new, so blocks
+// allocated while no tracker is installed can be freed while one is, and the
+// other way around; _msize sizes them when a tracker is installed.
+
+static void *TrackedAlloc(size_t size) {
+  if (size == 0)
+    size = 1;
+  void *p = malloc(size);
+  MemoryTracker *pTracker = CurrentMemoryTracker();
+  if (p != nullptr && pTracker != nullptr &&
+      !pTracker->Allocate(_msize(p))) {
+    free(p);
+    return nullptr;
+  }
+  return p;
+}
+
+static void TrackedFree(void *p) {
+  if (p == nullptr)
+    return;
+  if (MemoryTracker *pTracker = CurrentMemoryTracker())
+    pTracker->Free(_msize(p));
+  free(p);
+}
+
+static void *TrackedAllocOrThrow(size_t size) {
+  for (;;) {
+    if (void *p = TrackedAlloc(size))
+      return p;
+    // The new handler cannot make room under a limit.
+    MemoryTracker *pTracker = CurrentMemoryTracker();
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr ||
+        (pTracker != nullptr && pTracker->IsLimitExceeded()))
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void *operator new(size_t size) { return TrackedAllocOrThrow(size); }
+void *operator new[](size_t size) { return TrackedAllocOrThrow(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) throw() {
+  try {
+    return TrackedAllocOrThrow(size);
+  } catch (std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new[](size_t size, const std::nothrow_t &) throw() {
+  try {
+    return TrackedAllocOrThrow(size);
+  } catch (std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p) throw() { TrackedFree(p); }
+void operator delete[](void *p) throw() { TrackedFree(p); }
+void operator delete(void *p, size_t) throw() { TrackedFree(p); }
+void operator delete[](void *p, size_t) throw() { TrackedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) throw() {
+  TrackedFree(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) throw() {
+  TrackedFree(p);
+}
@@ -10,7 +10,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 //#include "clang/AST/ASTConsumer.h"
-//#include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTContext.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
@@ -23,13 +23,20 @@
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Sema/SemaHLSL.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/ADT/StringMap.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/Utils.h"
 #include "clang/CodeGen/CodeGenAction.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/HLSL/HLSLExtensionsCodegenHelper.h"
 #include "dxc/HLSL/DxilRootSignature.h"
 #include "dxcutil.h"
+#include "dxcincremental.h"
+#include "dxcontextpool.h"
+#include "dxcthreadpool.h"
 #include "dxc/Support/dxcfilesystem.h"
 
 // SPIRV change starts
@@ -41,6 +48,7 @@
 
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/HLSL/DxilContainer.h"
+#include "dxc/HLSL/DxilValidation.h"
 
 #include "dxc/dxcapi.internal.h"
 
@@ -51,10 +59,22 @@
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/dxcapi.impl.h"
 #include "dxc/Support/DxcLangExtensionsHelper.h"
+#include "dxc/Support/Cancellation.h"
+#include "dxc/Support/PhaseTracing.h"
+#include "dxc/Support/LockTracing.h"
+#include "dxc/Support/TimeReport.h"
+#include "dxc/Support/TraceArchive.h"
+#include "dxc/HLSL/PassStatistics.h"
+#include "dxc/Support/MemoryTracking.h"
 #include "dxc/Support/HLSLOptions.h"
 #include "dxcetw.h"
 #include "dxillib.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #define CP_UTF16 1200
 
@@ -73,6 +93,7 @@ HRESULT CreateDxcValidator(_In_ REFIID riid, _Out_ LPVOID *ppv);
 HRESULT RunInternalValidator(_In_ IDxcValidator *pValidator,
                              _In_ llvm::Module *pModule,
                              _In_ llvm::Module *pDebugModule,
+                             _In_opt_ hlsl::DxilValidationAnalyses *pAnalyses,
                              _In_ IDxcBlob *pShader, UINT32 Flags,
                              _In_ IDxcOperationResult **ppResult);
 
@@ -97,6 +118,199 @@ static void CreateOperationResultFromOutputs(
                                    ppResult);
 }
 
+// Records the digest of the root signature part of a container result, if
+// it has one, on the result.
+static void SetRootSignatureHash(IDxcBlob *pContainer,
+                                 IDxcOperationResult *pResult) {
+  if (pContainer == nullptr)
+    return;
+  const DxilContainerHeader *pHeader = IsDxilContainerLike(
+      pContainer->GetBufferPointer(), pContainer->GetBufferSize());
+  if (pHeader == nullptr ||
+      !IsValidDxilContainer(pHeader, pContainer->GetBufferSize()))
+    return;
+  const DxilPartHeader *pPart =
+      GetDxilPartByType(pHeader, DxilFourCC::DFCC_RootSignature);
+  if (pPart == nullptr)
+    return;
+  DxilContainerHash hash;
+  ComputeRootSignatureHash(GetDxilPartData(pPart), pPart->PartSize, &hash);
+  DxcOperationResult *pOperationResult =
+      static_cast<DxcOperationResult *>(pResult);
+  static_assert(sizeof(hash.Digest) ==
+                    sizeof(pOperationResult->m_rootSignatureHash),
+                "else digest sizes differ");
+  memcpy(pOperationResult->m_rootSignatureHash, hash.Digest,
+         sizeof(hash.Digest));
+  pOperationResult->m_hasRootSignatureHash = true;
+}
+
+// Returns the position of the stage of a profile in the graphics pipeline,
+// or -1 if it is not a graphics stage.
+static int GetPipelineStageRank(LPCWSTR pTargetProfile) {
+  static const wchar_t *const kStagePrefixes[] = {L"vs_", L"hs_", L"ds_",
+                                                   L"gs_", L"ps_"};
+  for (int i = 0; i < (int)_countof(kStagePrefixes); ++i) {
+    if (0 == wcsncmp(pTargetProfile, kStagePrefixes[i], 3))
+      return i;
+  }
+  return -1;
+}
+static const int kPipelineVertexRank = 0;
+static const int kPipelineDomainRank = 2;
+
+// Lists the arbitrary semantics of the input signature of a successful
+// compile result, as names with their index separated by '+'. Returns false
+// if the result has no input signature to read.
+static bool GetConsumerInputs(IDxcOperationResult *pResult,
+                              std::string &inputs) {
+  HRESULT status;
+  CComPtr<IDxcBlob> pContainer;
+  if (pResult == nullptr || FAILED(pResult->GetStatus(&status)) ||
+      FAILED(status) || FAILED(pResult->GetResult(&pContainer)) ||
+      pContainer == nullptr)
+    return false;
+  const DxilContainerHeader *pHeader = IsDxilContainerLike(
+      pContainer->GetBufferPointer(), pContainer->GetBufferSize());
+  if (pHeader == nullptr ||
+      !IsValidDxilContainer(pHeader, pContainer->GetBufferSize()))
+    return false;
+  const DxilPartHeader *pPart =
+      GetDxilPartByType(pHeader, DxilFourCC::DFCC_InputSignature);
+  if (pPart == nullptr || pPart->PartSize < sizeof(DxilProgramSignature))
+    return false;
+  const char *pData = GetDxilPartData(pPart);
+  const DxilProgramSignature *pSignature =
+      reinterpret_cast<const DxilProgramSignature *>(pData);
+  if (pSignature->ParamOffset > pPart->PartSize ||
+      pSignature->ParamCount > (pPart->PartSize - pSignature->ParamOffset) /
+                                   sizeof(DxilProgramSignatureElement))
+    return false;
+  const DxilProgramSignatureElement *pElements =
+      reinterpret_cast<const DxilProgramSignatureElement *>(
+          pData + pSignature->ParamOffset);
+  inputs.clear();
+  for (uint32_t i = 0; i < pSignature->ParamCount; ++i) {
+    const DxilProgramSignatureElement &E = pElements[i];
+    // System values are kept by the pass whether they are read or not.
+    if (E.SystemValue != DxilProgramSigSemantic::Undefined)
+      continue;
+    if (E.SemanticName >= pPart->PartSize)
+      return false;
+    const char *pName = pData + E.SemanticName;
+    size_t nameLength = strnlen(pName, pPart->PartSize - E.SemanticName);
+    if (nameLength == pPart->PartSize - E.SemanticName)
+      return false;
+    if (!inputs.empty())
+      inputs += "+";
+    inputs.append(pName, nameLength);
+    inputs += std::to_string(E.SemanticIndex);
+  }
+  return true;
+}
+
+// Wraps the UTF-8 source in a memory buffer for the main file. When the blob
+// already carries a null terminator the caller's memory is referenced
+// directly; otherwise a null-terminated copy is made. The blob must outlive
+// the returned buffer.
+static std::unique_ptr<llvm::MemoryBuffer>
+CreateMemoryBufferForSource(IDxcBlobEncoding *pUtf8Source,
+                            const char *pBufferName) {
+  const char *pChars = (const char *)pUtf8Source->GetBufferPointer();
+  size_t size = pUtf8Source->GetBufferSize();
+  if (size > 0 && pChars[size - 1] == '\0') {
+    return llvm::MemoryBuffer::getMemBuffer(StringRef(pChars, size - 1),
+                                            pBufferName,
+                                            /*RequiresNullTerminator*/ true);
+  }
+  return llvm::MemoryBuffer::getMemBufferCopy(StringRef(pChars, size),
+                                              pBufferName);
+}
+
+// A token cache is this header followed by PTH data, the clang format for
+// pretokenized files.
+static const uint32_t DxcTokenCacheFourCC = DXIL_FOURCC('D', 'X', 'T', 'C');
+static const uint32_t DxcTokenCacheVersion = 1;
+struct DxcTokenCacheHeader {
+  uint32_t FourCC;
+  uint32_t Version;
+  uint8_t Digest[16]; // See ComputeTokenCacheDigest.
+};
+
+// Lexes the main file to completion, then writes the raw tokens and the
+// conditional directive tables of every file that was entered.
+class GenerateTokenCacheAction : public PreprocessorFrontendAction {
+private:
+  raw_pwrite_stream &m_OS;
+
+public:
+  explicit GenerateTokenCacheAction(raw_pwrite_stream &OS) : m_OS(OS) {}
+
+protected:
+  void ExecuteAction() override {
+    CacheTokens(getCompilerInstance().getPreprocessor(), &m_OS);
+  }
+};
+
+static void WriteMakefileName(raw_ostream &OS, StringRef name) {
+  for (char c : name) {
+    if (c == ' ' || c == '#')
+      OS << '\\';
+    else if (c == '$')
+      OS << '$';
+    OS << c;
+  }
+}
+
+static void WriteJsonName(raw_ostream &OS, StringRef name) {
+  OS << '"';
+  for (char c : name) {
+    if (c == '"' || c == '\\')
+      OS << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      OS << ' ';
+    else
+      OS << c;
+  }
+  OS << '"';
+}
+
+// Writes the files the source depends on, the source first, as a Makefile
+// rule for target or as a JSON object.
+static void WriteDependencies(raw_ostream &OS, StringRef target,
+                              const std::vector<std::wstring> &fileNames,
+                              bool json) {
+  if (json) {
+    OS << "{\n  \"target\": ";
+    WriteJsonName(OS, target);
+    OS << ",\n  \"dependencies\": [";
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+      OS << (i ? ",\n    " : "\n    ");
+      WriteJsonName(OS, Unicode::UTF16ToUTF8StringOrThrow(fileNames[i].c_str()));
+    }
+    OS << "\n  ]\n}\n";
+    return;
+  }
+  WriteMakefileName(OS, target);
+  OS << ':';
+  for (const std::wstring &fileName : fileNames) {
+    OS << " \\\n  ";
+    WriteMakefileName(OS, Unicode::UTF16ToUTF8StringOrThrow(fileName.c_str()));
+  }
+  OS << '\n';
+}
+
+// The target of the dependency output is the -MT value, or the source name
+// with a .cso extension.
+static std::string GetDependencyTarget(const hlsl::options::DxcOpts &opts,
+                                       StringRef sourceName) {
+  if (!opts.DependencyTarget.empty())
+    return opts.DependencyTarget;
+  SmallString<128> objectName(sourceName);
+  llvm::sys::path::replace_extension(objectName, "cso");
+  return objectName.str();
+}
+
 class HLSLExtensionsCodegenHelperImpl : public HLSLExtensionsCodegenHelper {
 private:
   CompilerInstance &m_CI;
@@ -127,8 +341,11 @@ private:
   }
 
   SemanticDefineErrorList GetValidatedSemanticDefines(const ParsedSemanticDefineList &defines, ParsedSemanticDefineList &validated, SemanticDefineErrorList &errors) {
-    for (const ParsedSemanticDefine &define : defines) {
-      DxcLangExtensionsHelper::SemanticDefineValidationResult result = m_langExtensionsHelper.ValidateSemanticDefine(define.Name, define.Value);
+    std::vector<DxcLangExtensionsHelper::SemanticDefineValidationResult> results =
+      m_langExtensionsHelper.ValidateSemanticDefines(defines);
+    for (size_t i = 0; i < defines.size(); ++i) {
+      const ParsedSemanticDefine &define = defines[i];
+      DxcLangExtensionsHelper::SemanticDefineValidationResult &result = results[i];
         if (result.HasError())
           errors.emplace_back(SemanticDefineError(define.Location, SemanticDefineError::Level::Error, result.Error));
         if (result.HasWarning())
@@ -197,12 +414,369 @@ public:
   }
 };
 
-class DxcCompiler : public IDxcCompiler2, public IDxcLangExtensions, public IDxcContainerEvent, public IDxcVersionInfo {
+/// Reports compilation phases as DXCompilerPhase events, tagged with the
+/// source name and entry point of the compilation.
+class EtwPhaseTracer : public hlsl::PhaseTracer {
+public:
+  EtwPhaseTracer(_In_opt_ LPCWSTR pSourceName, _In_ LPCWSTR pEntryPoint)
+      : m_pSourceName(pSourceName ? pSourceName : L""),
+        m_pEntryPoint(pEntryPoint) {}
+  void BeginPhase(const char *pName) override {
+    DxcEtw_DXCompilerPhase_Start(pName, m_pSourceName, m_pEntryPoint);
+  }
+  void EndPhase(const char *pName) override {
+    DxcEtw_DXCompilerPhase_Stop(pName);
+  }
+
+private:
+  LPCWSTR m_pSourceName;
+  LPCWSTR m_pEntryPoint;
+};
+
+/// Serves a UTF-8 include handler to the file system, which names files in
+/// UTF-16 like the Windows file APIs it stands in for.
+class DxcIncludeHandlerUtf8Adapter : public IDxcIncludeHandler {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  CComPtr<IDxcIncludeHandlerUtf8> m_pHandler;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  DxcIncludeHandlerUtf8Adapter(_In_ IDxcIncludeHandlerUtf8 *pHandler)
+      : m_dwRef(0), m_pHandler(pHandler) {}
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeHandler>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LoadSource(
+      _In_ LPCWSTR pFilename,
+      _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource) {
+    if (pFilename == nullptr || ppIncludeSource == nullptr)
+      return E_INVALIDARG;
+    *ppIncludeSource = nullptr;
+    try {
+      std::string utf8Filename = Unicode::UTF16ToUTF8StringOrThrow(pFilename);
+      return m_pHandler->LoadSource(utf8Filename.c_str(), ppIncludeSource);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+};
+
+/// Serves the includes stored in a compile package. Names are matched
+/// exactly, as the compiler asks for the same names given the same
+/// arguments.
+class DxcPackageIncludeHandler : public IDxcIncludeHandler {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  std::unordered_map<std::wstring, const hlsl::TraceCall::Include *>
+      m_includes;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  DxcPackageIncludeHandler(const hlsl::TraceCall &call) : m_dwRef(0) {
+    for (const hlsl::TraceCall::Include &include : call.Includes)
+      m_includes.emplace(include.Name, &include);
+  }
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeHandler>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LoadSource(
+      _In_ LPCWSTR pFilename,
+      _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource) {
+    if (pFilename == nullptr || ppIncludeSource == nullptr)
+      return E_INVALIDARG;
+    *ppIncludeSource = nullptr;
+    try {
+      auto it = m_includes.find(pFilename);
+      if (it == m_includes.end())
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+      // The include cache may keep the blob past the package, so it owns a
+      // copy of the contents.
+      const std::string &contents = it->second->Contents;
+      CComPtr<IDxcBlobEncoding> pBlob;
+      IFR(DxcCreateBlobWithEncodingOnHeapCopy(
+          contents.data(), (UINT32)contents.size(), CP_UTF8, &pBlob));
+      *ppIncludeSource = pBlob.Detach();
+      return S_OK;
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+};
+
+/// Arguments parsed by IDxcCompilerArgsParsing::ParseArguments. Opts refers
+/// into Args, so neither moves once parsed, and compilations only read them.
+class DxcCompilerArgs : public IDxcCompilerArgs {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  hlsl::options::MainArgs Args;
+  hlsl::options::DxcOpts Opts;
+  // The UTF-16 arguments, for ETW events, trace recordings and the result
+  // store key.
+  std::vector<std::wstring> WideArgumentStrings;
+  std::vector<LPCWSTR> WideArguments;
+
+  DxcCompilerArgs(_In_count_(argCount) LPCWSTR *pArguments, UINT32 argCount)
+      : m_dwRef(0), Args((int)argCount, pArguments, 0),
+        WideArgumentStrings(pArguments, pArguments + argCount) {
+    for (const std::wstring &arg : WideArgumentStrings)
+      WideArguments.push_back(arg.c_str());
+  }
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcCompilerArgs>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE GetArguments(
+      _Outptr_result_buffer_(*pArgCount) LPCWSTR **ppArguments,
+      _Out_ UINT32 *pArgCount) {
+    if (ppArguments == nullptr || pArgCount == nullptr)
+      return E_INVALIDARG;
+    *ppArguments = WideArguments.data();
+    *pArgCount = (UINT32)WideArguments.size();
+    return S_OK;
+  }
+};
+
+/// Result of a compilation queued through IDxcCompilerAsync. The pool thread
+/// calls Complete once; every IDxcOperationResult accessor waits for that.
+class DxcAsyncOperationResult : public IDxcAsyncOperationResult {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  std::mutex m_mutex;
+  std::condition_variable m_completed;
+  bool m_bComplete;
+  HRESULT m_hr;
+  CComPtr<IDxcOperationResult> m_pResult;
+
+  HRESULT WaitForResult() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_completed.wait(lock, [this] { return m_bComplete; });
+    return m_hr;
+  }
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcOperationResult, IDxcAsyncOperationResult>(
+        this, iid, ppvObject);
+  }
+
+  DxcAsyncOperationResult() : m_dwRef(0), m_bComplete(false), m_hr(E_PENDING) { }
+
+  // hr is the HRESULT of the compile call itself; pResult is set when it
+  // succeeded.
+  void Complete(HRESULT hr, _In_opt_ IDxcOperationResult *pResult) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_hr = hr;
+      m_pResult = pResult;
+      m_bComplete = true;
+    }
+    m_completed.notify_all();
+  }
+
+  __override HRESULT STDMETHODCALLTYPE IsComplete(_Out_ BOOL *pComplete) {
+    if (pComplete == nullptr) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *pComplete = m_bComplete ? TRUE : FALSE;
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Wait(_In_ UINT32 timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (timeoutMs == INFINITE) {
+      m_completed.wait(lock, [this] { return m_bComplete; });
+      return S_OK;
+    }
+    return m_completed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                [this] { return m_bComplete; })
+               ? S_OK
+               : S_FALSE;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE GetStatus(_Out_ HRESULT *pStatus) {
+    if (pStatus == nullptr) return E_INVALIDARG;
+    IFR(WaitForResult());
+    return m_pResult->GetStatus(pStatus);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE GetResult(_COM_Outptr_result_maybenull_ IDxcBlob **ppResult) {
+    if (ppResult == nullptr) return E_INVALIDARG;
+    *ppResult = nullptr;
+    IFR(WaitForResult());
+    return m_pResult->GetResult(ppResult);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE GetErrorBuffer(_COM_Outptr_result_maybenull_ IDxcBlobEncoding **ppErrors) {
+    if (ppErrors == nullptr) return E_INVALIDARG;
+    *ppErrors = nullptr;
+    IFR(WaitForResult());
+    return m_pResult->GetErrorBuffer(ppErrors);
+  }
+};
+
+// Compilations on other threads can hold the locks of the compiler object;
+// the waits for them show in the counters of the time report.
+static const hlsl::LockSite kTokenCacheLockSite = {
+    "lock.tokenCache.contended", "lock.tokenCache.waitUs"};
+static const hlsl::LockSite kContextPoolLockSite = {
+    "lock.compilerContextPool.contended", "lock.compilerContextPool.waitUs"};
+static const hlsl::LockSite kIncrementalLockSite = {
+    "lock.incremental.contended", "lock.incremental.waitUs"};
+
+class DxcCompiler : public IDxcCompiler2, public IDxcCompilerUtf8, public IDxcCompilerArgsParsing, public IDxcCompilerBatch, public IDxcCompilerPermutations, public IDxcCompilerResultCaching, public IDxcCompilerIncludeCaching, public IDxcCompilerTokenCaching, public IDxcCompilerStreamingPreprocess, public IDxcCompilerPackaging, public IDxcCompilerAsync, public IDxcCompilerCancellation, public IDxcCompilerDisassembly, public IDxcMemoryAccounting, public IDxcCompilerContextPooling, public IDxcCompilerIncremental, public IDxcLangExtensions2, public IDxcContainerEvent, public IDxcVersionInfo, public IDxcCompilerPipeline {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
   DxcLangExtensionsHelper m_langExtensionsHelper;
   CComPtr<IDxcContainerEventsHandler> m_pDxcContainerEventsHandler;
 
+  // The inputs of a compilation. The front end reads the UTF-8 values; the
+  // UTF-16 ones feed ETW events, trace recordings, the result store key and
+  // the file system. Compile keeps its UTF-16 values and converts each once;
+  // CompileUtf8 converts the few it needs into the Wide* storage.
+  struct CompileRequest {
+    LPCWSTR pSourceName = nullptr;
+    LPCWSTR pEntryPoint = nullptr;
+    LPCWSTR pTargetProfile = nullptr;
+    LPCWSTR *pArguments = nullptr;
+    UINT32 argCount = 0;
+    const DxcDefine *pDefines = nullptr;
+    UINT32 defineCount = 0;
+    IDxcIncludeHandler *pIncludeHandler = nullptr;
+    bool HasSourceName = false;
+    std::string Utf8SourceName;
+    std::string Utf8EntryPoint;
+    std::string Utf8TargetProfile;
+    hlsl::options::MainArgs Args;
+    // Set when the arguments were parsed ahead of time; Args is unused then.
+    CComPtr<DxcCompilerArgs> pParsedArgs;
+    std::vector<std::string> Defines; // As name=value.
+    std::wstring WideSourceName;
+    std::wstring WideEntryPoint;
+    std::wstring WideTargetProfile;
+    std::vector<std::wstring> WideArgumentStrings;
+    std::vector<LPCWSTR> WideArguments;
+    std::vector<std::wstring> WideDefineStrings;
+    std::vector<DxcDefine> WideDefines;
+    // Set by CompilePipeline: the token cache to use instead of the one of
+    // the compiler object, and the inputs the next stage reads.
+    CComPtr<IDxcBlob> pTokenCache;
+    bool HasConsumerInputs = false;
+    std::string ConsumerInputs;
+  };
+  // The validator version does not change for the lifetime of the compiler
+  // object, so it is queried once and reused by every compilation.
+  std::once_flag m_validatorVersionFlag;
+  UINT32 m_validatorMajor;
+  UINT32 m_validatorMinor;
+
+  CComPtr<IDxcCompileResultStore> m_pResultStore;
+  CComPtr<IDxcIncludeCache> m_pIncludeCache;
+  dxcutil::MemoryAccounting m_memoryAccounting;
+  // Guards m_pTokenCache, which is read at the start of every compilation.
+  std::mutex m_tokenCacheMutex;
+  CComPtr<IDxcBlob> m_pTokenCache;
+  // Guards m_pContextPool; compilations hold a reference to the pool they
+  // started with, so it can be replaced while they run.
+  std::mutex m_contextPoolMutex;
+  std::shared_ptr<dxcutil::DxcContextPool> m_pContextPool;
+  // Guards the incremental state; compilations look up and update their
+  // entry under it, and run the front end and backend without it.
+  struct IncrementalEntry {
+    llvm::MD5::MD5Result Digest;
+    CComPtr<IDxcBlob> pContainer;
+  };
+  std::mutex m_incrementalMutex;
+  bool m_incremental = false;
+  llvm::StringMap<IncrementalEntry> m_incrementalEntries;
+  UINT32 m_incrementalReused = 0;
+  UINT32 m_incrementalCompiled = 0;
+
+  // Created on the first CompileAsync call. Declared last so that it is
+  // destroyed first: its destructor finishes queued compilations, which
+  // still use the members above.
+  std::once_flag m_threadPoolFlag;
+  std::unique_ptr<dxcutil::DxcThreadPool> m_pThreadPool;
+
+  void GetValidatorVersion(_Out_ UINT32 *pMajor, _Out_ UINT32 *pMinor) {
+    std::call_once(m_validatorVersionFlag, [this]() {
+      dxcutil::GetValidatorVersion(&m_validatorMajor, &m_validatorMinor);
+    });
+    *pMajor = m_validatorMajor;
+    *pMinor = m_validatorMinor;
+  }
+
+  // Computes the digest a token cache is matched by: the source, its name
+  // and every argument other than defines, which are re-evaluated when the
+  // cached tokens are replayed.
+  void ComputeTokenCacheDigest(_In_ IDxcBlob *pUtf8Source,
+                               _In_z_ const char *pUtf8SourceName,
+                               const hlsl::options::DxcOpts &opts,
+                               llvm::MD5::MD5Result &digest) {
+    llvm::MD5 md5;
+    auto updateString = [&md5](StringRef str) {
+      md5.update(ArrayRef<uint8_t>((const uint8_t *)str.data(), str.size() + 1));
+    };
+    md5.update(ArrayRef<uint8_t>(
+        (const uint8_t *)pUtf8Source->GetBufferPointer(),
+        pUtf8Source->GetBufferSize()));
+    updateString(pUtf8SourceName);
+    for (const llvm::opt::Arg *A : opts.Args) {
+      if (A->getOption().matches(options::OPT_D))
+        continue;
+      updateString(A->getAsString(opts.Args));
+    }
+    md5.final(digest);
+  }
+
+  // Returns the tokens of pRequestTokenCache, or of the current token
+  // cache when it is null, if it was created for this source and these
+  // arguments, or nullptr.
+  std::unique_ptr<llvm::MemoryBuffer>
+  GetTokenCacheBuffer(_In_ IDxcBlob *pUtf8Source,
+                      _In_z_ const char *pUtf8SourceName,
+                      const hlsl::options::DxcOpts &opts,
+                      _In_opt_ IDxcBlob *pRequestTokenCache = nullptr) {
+    CComPtr<IDxcBlob> pTokenCache = pRequestTokenCache;
+    if (pTokenCache == nullptr) {
+      hlsl::TracedLockGuard<std::mutex> lock(m_tokenCacheMutex,
+                                               kTokenCacheLockSite);
+      pTokenCache = m_pTokenCache;
+    }
+    // Replayed tokens do not open the files they were lexed from, which
+    // dependency output lists.
+    if (pTokenCache == nullptr || opts.DependenciesWithOutput)
+      return nullptr;
+    const char *pData = (const char *)pTokenCache->GetBufferPointer();
+    size_t size = pTokenCache->GetBufferSize();
+    DxcTokenCacheHeader header;
+    if (size < sizeof(header))
+      return nullptr;
+    memcpy(&header, pData, sizeof(header));
+    if (header.FourCC != DxcTokenCacheFourCC ||
+        header.Version != DxcTokenCacheVersion)
+      return nullptr;
+    llvm::MD5::MD5Result digest;
+    ComputeTokenCacheDigest(pUtf8Source, pUtf8SourceName, opts, digest);
+    if (0 != memcmp(header.Digest, digest, sizeof(header.Digest)))
+      return nullptr;
+    // The tokens are read with aligned loads, and the caller's blob may be
+    // released while the compilation runs, so they are always copied.
+    return llvm::MemoryBuffer::getMemBufferCopy(
+        StringRef(pData + sizeof(header), size - sizeof(header)),
+        "token cache");
+  }
+
   void CreateDefineStrings(_In_count_(defineCount) const DxcDefine *pDefines,
                            UINT defineCount,
                            std::vector<std::string> &defines) {
@@ -217,6 +791,131 @@ private:
     }
   }
 
+  // Computes the result store key for a compilation. The key hashes the
+  // preprocessed source, so defines that are dead after preprocessing do not
+  // produce distinct keys. *ppKey is left null when the output may depend on
+  // more than the preprocessed text and arguments.
+  void ComputeResultStoreKey(
+      _In_ IDxcBlob *pSource, _In_opt_ LPCWSTR pSourceName,
+      _In_ LPCWSTR pEntryPoint, _In_ LPCWSTR pTargetProfile,
+      _In_count_(argCount) LPCWSTR *pArguments, _In_ UINT32 argCount,
+      _In_count_(defineCount) const DxcDefine *pDefines,
+      _In_ UINT32 defineCount, _In_opt_ IDxcIncludeHandler *pIncludeHandler,
+      _COM_Outptr_result_maybenull_ IDxcBlob **ppKey) {
+    *ppKey = nullptr;
+
+    // Semantic defines and extension intrinsics see macros and declarations
+    // that the preprocessed text does not capture, and an events handler may
+    // rewrite the container.
+    if (m_pDxcContainerEventsHandler != nullptr ||
+        !m_langExtensionsHelper.GetSemanticDefines().empty() ||
+        !m_langExtensionsHelper.GetIntrinsicTables().empty())
+      return;
+
+    int argCountInt;
+    IFT(UIntToInt(argCount, &argCountInt));
+    hlsl::options::MainArgs mainArgs(argCountInt, pArguments, 0);
+    hlsl::options::DxcOpts opts;
+    std::string optErrors;
+    raw_string_ostream optErrorStream(optErrors);
+    if (0 != hlsl::options::ReadDxcOpts(::options::getHlslOptTable(),
+                                        hlsl::options::CompilerFlags,
+                                        mainArgs, opts, optErrorStream))
+      return;
+
+    // Debug information embeds every define and argument, and the root
+    // signature define is read from a macro that is not in the output.
+    if (opts.DebugInfo || opts.AstDump || opts.OptDump ||
+        opts.CodeGenHighLevel || opts.DisplayIncludeProcess ||
+        opts.TimeReport || opts.PrintStats || opts.DependenciesWithOutput ||
+        !opts.RootSignatureDefine.empty())
+      return;
+
+    // Preprocess doesn't read defines from the arguments, so pass them along
+    // with the API defines.
+    std::vector<DxcDefine> allDefines(pDefines, pDefines + defineCount);
+    allDefines.insert(allDefines.end(), opts.Defines.data(),
+                      opts.Defines.data() + opts.Defines.size());
+
+    CComPtr<IDxcOperationResult> pPreprocessResult;
+    CComPtr<IDxcBlob> pPreprocessed;
+    HRESULT status;
+    IFT(Preprocess(pSource, pSourceName, pArguments, argCount,
+                   allDefines.data(), allDefines.size(), pIncludeHandler,
+                   &pPreprocessResult));
+    IFT(pPreprocessResult->GetStatus(&status));
+    if (FAILED(status))
+      return;
+    IFT(pPreprocessResult->GetResult(&pPreprocessed));
+
+    UINT32 valMajor, valMinor;
+    GetValidatorVersion(&valMajor, &valMinor);
+    const UINT32 versions[] = { DXIL::kDxilMajor, DXIL::kDxilMinor,
+                                valMajor, valMinor };
+
+    llvm::MD5 md5;
+    // Hash strings with their terminator so adjacent fields can't alias.
+    auto updateString = [&md5](StringRef str) {
+      md5.update(ArrayRef<uint8_t>((const uint8_t *)str.data(), str.size() + 1));
+    };
+    md5.update(ArrayRef<uint8_t>((const uint8_t *)versions, sizeof(versions)));
+    md5.update(ArrayRef<uint8_t>(
+        (const uint8_t *)pPreprocessed->GetBufferPointer(),
+        pPreprocessed->GetBufferSize()));
+    updateString(Unicode::UTF16ToUTF8StringOrThrow(pEntryPoint));
+    updateString(Unicode::UTF16ToUTF8StringOrThrow(pTargetProfile));
+    for (const llvm::opt::Arg *A : opts.Args) {
+      // Defines are already reflected in the preprocessed text.
+      if (A->getOption().matches(options::OPT_D))
+        continue;
+      updateString(A->getAsString(opts.Args));
+    }
+
+    llvm::MD5::MD5Result md5Result;
+    md5.final(md5Result);
+    IFT(DxcCreateBlobOnHeapCopy(md5Result, sizeof(md5Result), ppKey));
+  }
+
+  // Returns whether a compilation with these options may be matched by its
+  // entry point digest, and if so computes the key its entry is kept under.
+  // The digest captures neither the macros read by semantic defines and
+  // the root signature define, nor what extension intrinsics, profile data
+  // and events handlers contribute.
+  bool ComputeIncrementalKey(_In_z_ const char *pUtf8SourceName,
+                             _In_z_ const char *pUtf8EntryPoint,
+                             _In_z_ const char *pUtf8TargetProfile,
+                             const hlsl::options::DxcOpts &opts,
+                             const std::vector<std::string> &defines,
+                             std::string &key) {
+    {
+      hlsl::TracedLockGuard<std::mutex> lock(m_incrementalMutex,
+                                               kIncrementalLockSite);
+      if (!m_incremental)
+        return false;
+    }
+    if (m_pDxcContainerEventsHandler != nullptr ||
+        !m_langExtensionsHelper.GetSemanticDefines().empty() ||
+        !m_langExtensionsHelper.GetIntrinsicTables().empty())
+      return false;
+    if (opts.DebugInfo || opts.TimeReport || opts.PrintStats ||
+        !opts.RootSignatureDefine.empty() || !opts.ProfileUseFile.empty())
+      return false;
+
+    // Strings are kept with their terminator so adjacent fields can't alias.
+    auto appendString = [&key](StringRef str) {
+      key.append(str.data(), str.size());
+      key.push_back('\0');
+    };
+    appendString(pUtf8SourceName);
+    appendString(pUtf8EntryPoint);
+    appendString(pUtf8TargetProfile);
+    for (const llvm::opt::Arg *A : opts.Args)
+      appendString(A->getAsString(opts.Args));
+    for (const std::string &define : defines)
+      appendString(define);
+    return true;
+  }
+
   void ReadOptsAndValidate(hlsl::options::MainArgs &mainArgs,
                            hlsl::options::DxcOpts &opts,
                            AbstractMemoryStream *pOutputStream,
@@ -243,6 +942,10 @@ public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
   DXC_LANGEXTENSIONS_HELPER_IMPL(m_langExtensionsHelper)
 
+  __override HRESULT STDMETHODCALLTYPE SetSemanticDefineValidationCaching(BOOL enabled) {
+    return m_langExtensionsHelper.SetSemanticDefineValidationCaching(enabled);
+  }
+
   __override HRESULT STDMETHODCALLTYPE RegisterDxilContainerEventHandler(IDxcContainerEventsHandler *pHandler, UINT64 *pCookie) {
     DXASSERT(m_pDxcContainerEventsHandler == nullptr, "else events handler is already registered");
     *pCookie = 1; // Only one EventsHandler supported 
@@ -255,12 +958,75 @@ public:
     return S_OK;
   }
 
+  __override HRESULT STDMETHODCALLTYPE SetResultStore(_In_opt_ IDxcCompileResultStore *pStore) {
+    m_pResultStore = pStore;
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE SetIncludeCache(_In_opt_ IDxcIncludeCache *pCache) {
+    m_pIncludeCache = pCache;
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE SetMemoryAccounting(BOOL enabled, UINT64 limitBytes) {
+    m_memoryAccounting.Enabled = enabled != FALSE;
+    m_memoryAccounting.LimitBytes = limitBytes;
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE SetContextPooling(UINT32 maxContexts) {
+    try {
+      std::shared_ptr<dxcutil::DxcContextPool> pPool;
+      if (maxContexts != 0)
+        pPool = std::make_shared<dxcutil::DxcContextPool>(maxContexts);
+      std::lock_guard<std::mutex> lock(m_contextPoolMutex);
+      m_pContextPool.swap(pPool);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE SetIncremental(BOOL enabled) {
+    std::lock_guard<std::mutex> lock(m_incrementalMutex);
+    m_incremental = enabled != FALSE;
+    if (!m_incremental)
+      m_incrementalEntries.clear();
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE GetIncrementalCounts(
+      _Out_ UINT32 *pReused, _Out_ UINT32 *pCompiled) {
+    if (pReused == nullptr || pCompiled == nullptr)
+      return E_INVALIDARG;
+    std::lock_guard<std::mutex> lock(m_incrementalMutex);
+    *pReused = m_incrementalReused;
+    *pCompiled = m_incrementalCompiled;
+    return S_OK;
+  }
+
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
     return DoBasicQueryInterface<IDxcCompiler,
                                  IDxcCompiler2,
+                                 IDxcCompilerUtf8,
+                                 IDxcCompilerArgsParsing,
+                                 IDxcCompilerBatch,
+                                 IDxcCompilerPermutations,
+                                 IDxcCompilerResultCaching,
+                                 IDxcCompilerIncludeCaching,
+                                 IDxcCompilerTokenCaching,
+                                 IDxcCompilerStreamingPreprocess,
+                                 IDxcCompilerPackaging,
+                                 IDxcCompilerAsync,
+                                 IDxcCompilerCancellation,
+                                 IDxcCompilerDisassembly,
+                                 IDxcMemoryAccounting,
+                                 IDxcCompilerContextPooling,
+                                 IDxcCompilerIncremental,
                                  IDxcLangExtensions,
+                                 IDxcLangExtensions2,
                                  IDxcContainerEvent,
-                                 IDxcVersionInfo>
+                                 IDxcVersionInfo,
+                                 IDxcCompilerPipeline>
                                  (this, iid, ppvObject);
   }
 
@@ -306,12 +1072,251 @@ public:
     AssignToOutOpt(nullptr, ppDebugBlobName);
     AssignToOutOpt(nullptr, ppDebugBlob);
 
+    CompileRequest req;
+    try {
+      InitCompileRequest(req, pSourceName, pEntryPoint, pTargetProfile,
+                         pArguments, argCount, pDefines, defineCount,
+                         pIncludeHandler);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return CompileRequestWithDebug(pSource, req, ppResult, ppDebugBlobName,
+                                   ppDebugBlob);
+  }
+
+  // Fills a request from UTF-16 inputs. The front end reads UTF-8, so each
+  // value is converted once here.
+  void InitCompileRequest(CompileRequest &req, _In_opt_ LPCWSTR pSourceName,
+                          _In_ LPCWSTR pEntryPoint, _In_ LPCWSTR pTargetProfile,
+                          _In_count_(argCount) LPCWSTR *pArguments,
+                          UINT32 argCount,
+                          _In_count_(defineCount) const DxcDefine *pDefines,
+                          UINT32 defineCount,
+                          _In_opt_ IDxcIncludeHandler *pIncludeHandler) {
+    req.pSourceName = pSourceName;
+    req.pEntryPoint = pEntryPoint;
+    req.pTargetProfile = pTargetProfile;
+    req.pArguments = pArguments;
+    req.argCount = argCount;
+    req.pDefines = pDefines;
+    req.defineCount = defineCount;
+    req.pIncludeHandler = pIncludeHandler;
+    int argCountInt;
+    IFT(UIntToInt(argCount, &argCountInt));
+    req.Args = hlsl::options::MainArgs(argCountInt, pArguments, 0);
+    req.HasSourceName = pSourceName != nullptr;
+    if (req.HasSourceName)
+      req.Utf8SourceName = Unicode::UTF16ToUTF8StringOrThrow(pSourceName);
+    req.Utf8EntryPoint = Unicode::UTF16ToUTF8StringOrThrow(pEntryPoint);
+    req.Utf8TargetProfile = Unicode::UTF16ToUTF8StringOrThrow(pTargetProfile);
+    CreateDefineStrings(pDefines, defineCount, req.Defines);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CompileUtf8(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_z_ LPCSTR pSourceName,                // Optional file name for pSource. Used in errors and include handlers.
+    _In_z_ LPCSTR pEntryPoint,                    // Entry point name
+    _In_z_ LPCSTR pTargetProfile,                 // Shader profile to compile
+    _In_count_(argCount) LPCSTR *pArguments,      // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefineUtf8 *pDefines, // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandlerUtf8 *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) {
+    if (pSource == nullptr || ppResult == nullptr ||
+        (defineCount > 0 && pDefines == nullptr) ||
+        (argCount > 0 && pArguments == nullptr) || pEntryPoint == nullptr ||
+        pTargetProfile == nullptr)
+      return E_INVALIDARG;
+    *ppResult = nullptr;
+
+    CompileRequest req;
+    CComPtr<IDxcIncludeHandler> pIncludeAdapter;
+    try {
+      req.HasSourceName = pSourceName != nullptr;
+      if (req.HasSourceName)
+        req.Utf8SourceName = pSourceName;
+      req.Utf8EntryPoint = pEntryPoint;
+      req.Utf8TargetProfile = pTargetProfile;
+      SmallVector<StringRef, 16> args(pArguments, pArguments + argCount);
+      req.Args = hlsl::options::MainArgs(args);
+      for (UINT32 i = 0; i < defineCount; ++i) {
+        std::string define(pDefines[i].Name);
+        define += "=";
+        define += pDefines[i].Value ? pDefines[i].Value : "1";
+        req.Defines.push_back(std::move(define));
+      }
+
+      // The source name and entry point tag ETW events and name the main
+      // file of the file system, so they are always needed in UTF-16.
+      if (req.HasSourceName) {
+        req.WideSourceName = Unicode::UTF8ToUTF16StringOrThrow(pSourceName);
+        req.pSourceName = req.WideSourceName.c_str();
+      }
+      req.WideEntryPoint = Unicode::UTF8ToUTF16StringOrThrow(pEntryPoint);
+      req.WideTargetProfile = Unicode::UTF8ToUTF16StringOrThrow(pTargetProfile);
+      req.pEntryPoint = req.WideEntryPoint.c_str();
+      req.pTargetProfile = req.WideTargetProfile.c_str();
+      if (m_pResultStore != nullptr ||
+          dxcutil::TraceRecording::IsRecordingEnabled()) {
+        for (UINT32 i = 0; i < argCount; ++i)
+          req.WideArgumentStrings.push_back(
+              Unicode::UTF8ToUTF16StringOrThrow(pArguments[i]));
+        for (const std::wstring &arg : req.WideArgumentStrings)
+          req.WideArguments.push_back(arg.c_str());
+        for (UINT32 i = 0; i < defineCount; ++i) {
+          req.WideDefineStrings.push_back(
+              Unicode::UTF8ToUTF16StringOrThrow(pDefines[i].Name));
+          if (pDefines[i].Value)
+            req.WideDefineStrings.push_back(
+                Unicode::UTF8ToUTF16StringOrThrow(pDefines[i].Value));
+        }
+        for (UINT32 i = 0, s = 0; i < defineCount; ++i) {
+          DxcDefine define;
+          define.Name = req.WideDefineStrings[s++].c_str();
+          define.Value =
+              pDefines[i].Value ? req.WideDefineStrings[s++].c_str() : nullptr;
+          req.WideDefines.push_back(define);
+        }
+        req.pArguments = req.WideArguments.data();
+        req.argCount = argCount;
+        req.pDefines = req.WideDefines.data();
+        req.defineCount = defineCount;
+      }
+      if (pIncludeHandler != nullptr) {
+        pIncludeAdapter = new DxcIncludeHandlerUtf8Adapter(pIncludeHandler);
+        req.pIncludeHandler = pIncludeAdapter;
+      }
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return CompileRequestWithDebug(pSource, req, ppResult, nullptr, nullptr);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE ParseArguments(
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _COM_Outptr_result_maybenull_ IDxcCompilerArgs **ppArgs, // Parsed arguments
+    _COM_Outptr_result_maybenull_ IDxcOperationResult **ppResult // Errors if the arguments are invalid
+  ) {
+    if ((argCount > 0 && pArguments == nullptr) || ppArgs == nullptr ||
+        ppResult == nullptr)
+      return E_INVALIDARG;
+    *ppArgs = nullptr;
+    *ppResult = nullptr;
+    int argCountInt;
+    IFR(UIntToInt(argCount, &argCountInt));
+    try {
+      CComPtr<IMalloc> pMalloc;
+      CComPtr<AbstractMemoryStream> pOutputStream;
+      IFT(hlsl::DxcGetOperationMalloc(&pMalloc));
+      IFT(CreateMemoryStream(pMalloc, &pOutputStream));
+      CComPtr<DxcCompilerArgs> pArgs = new DxcCompilerArgs(pArguments, argCount);
+      bool finished;
+      ReadOptsAndValidate(pArgs->Args, pArgs->Opts, pOutputStream, ppResult,
+                          finished);
+      if (!finished)
+        *ppArgs = pArgs.Detach();
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CompileWithArgs(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // Entry point name
+    _In_ LPCWSTR pTargetProfile,                  // Shader profile to compile
+    _In_ IDxcCompilerArgs *pArgs,                 // Arguments from ParseArguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) {
+    if (pSource == nullptr || ppResult == nullptr || pArgs == nullptr ||
+        (defineCount > 0 && pDefines == nullptr) || pEntryPoint == nullptr ||
+        pTargetProfile == nullptr)
+      return E_INVALIDARG;
+    *ppResult = nullptr;
+
+    CompileRequest req;
+    // Only objects from ParseArguments carry parsed options.
+    req.pParsedArgs = static_cast<DxcCompilerArgs *>(pArgs);
+    req.pSourceName = pSourceName;
+    req.pEntryPoint = pEntryPoint;
+    req.pTargetProfile = pTargetProfile;
+    req.pArguments = req.pParsedArgs->WideArguments.data();
+    req.argCount = (UINT32)req.pParsedArgs->WideArguments.size();
+    req.pDefines = pDefines;
+    req.defineCount = defineCount;
+    req.pIncludeHandler = pIncludeHandler;
+    try {
+      req.HasSourceName = pSourceName != nullptr;
+      if (req.HasSourceName)
+        req.Utf8SourceName = Unicode::UTF16ToUTF8StringOrThrow(pSourceName);
+      req.Utf8EntryPoint = Unicode::UTF16ToUTF8StringOrThrow(pEntryPoint);
+      req.Utf8TargetProfile = Unicode::UTF16ToUTF8StringOrThrow(pTargetProfile);
+      CreateDefineStrings(pDefines, defineCount, req.Defines);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return CompileRequestWithDebug(pSource, req, ppResult, nullptr, nullptr);
+  }
+
+  // Compiles with the inputs converted for both the front end and the
+  // UTF-16 consumers.
+  HRESULT CompileRequestWithDebug(_In_ IDxcBlob *pSource, CompileRequest &req,
+                                  _COM_Outptr_ IDxcOperationResult **ppResult,
+                                  _Outptr_opt_result_z_ LPWSTR *ppDebugBlobName,
+                                  _COM_Outptr_opt_ IDxcBlob **ppDebugBlob) {
+    LPCWSTR pSourceName = req.pSourceName;
+    LPCWSTR pEntryPoint = req.pEntryPoint;
+    LPCWSTR pTargetProfile = req.pTargetProfile;
+    LPCWSTR *pArguments = req.pArguments;
+    UINT32 argCount = req.argCount;
+    const DxcDefine *pDefines = req.pDefines;
+    UINT32 defineCount = req.defineCount;
+    IDxcIncludeHandler *pIncludeHandler = req.pIncludeHandler;
+
     HRESULT hr = S_OK;
     CComPtr<IDxcBlobEncoding> utf8Source;
     CComPtr<AbstractMemoryStream> pOutputStream;
     CHeapPtr<wchar_t> DebugBlobName;
+    CComPtr<IDxcBlob> pResultStoreKey;
+    std::string incrementalKey;
+    bool incrementalDigestValid = false;
+    llvm::MD5::MD5Result incrementalDigest;
     DxcEtw_DXCompilerCompile_Start();
+    EtwPhaseTracer phaseTracer(pSourceName, pEntryPoint);
+    hlsl::PhaseTracerScope phaseTracerScope(&phaseTracer);
+    dxcutil::MemoryAccountingScope memoryScope(m_memoryAccounting);
+    dxcutil::TraceRecording traceRecording(pSourceName, pEntryPoint,
+                                           pTargetProfile, pArguments, argCount,
+                                           pDefines, defineCount);
     IFC(hlsl::DxcGetBlobAsUtf8(pSource, &utf8Source));
+    traceRecording.SetSource(utf8Source);
+
+    // Serve the container from the result store if it has been produced
+    // before. Debug blob outputs are never stored, nor are containers pruned
+    // for a consumer, which the key does not cover.
+    if (m_pResultStore != nullptr && ppDebugBlob == nullptr &&
+        ppDebugBlobName == nullptr && !req.HasConsumerInputs) {
+      try {
+        ComputeResultStoreKey(utf8Source, pSourceName, pEntryPoint,
+                              pTargetProfile, pArguments, argCount, pDefines,
+                              defineCount, pIncludeHandler, &pResultStoreKey);
+        CComPtr<IDxcBlob> pStored;
+        if (pResultStoreKey != nullptr &&
+            SUCCEEDED(m_pResultStore->Lookup(pResultStoreKey, &pStored)) &&
+            pStored != nullptr) {
+          IFT(DxcOperationResult::CreateFromResultErrorStatus(pStored, nullptr,
+                                                              S_OK, ppResult));
+          SetRootSignatureHash(pStored, *ppResult);
+          hr = S_OK;
+          goto Cleanup;
+        }
+      }
+      CATCH_CPP_ASSIGN_HRESULT();
+      IFC(hr);
+    }
 
     try {
       CComPtr<IMalloc> pMalloc;
@@ -319,32 +1324,56 @@ public:
       dxcutil::DxcArgsFileSystem *msfPtr;
       IFT(dxcutil::CreateDxcArgsFileSystem(utf8Source, pSourceName, pIncludeHandler, &msfPtr));
       std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+      msfPtr->SetIncludeCache(m_pIncludeCache);
 
       ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
       IFTLLVM(pts.error_code());
 
-      IFT(CoGetMalloc(1, &pMalloc));
+      IFT(hlsl::DxcGetOperationMalloc(&pMalloc));
       IFT(CreateMemoryStream(pMalloc, &pOutputStream));
       IFT(pOutputStream.QueryInterface(&pOutputBlob));
 
-      int argCountInt;
-      IFT(UIntToInt(argCount, &argCountInt));
-      hlsl::options::MainArgs mainArgs(argCountInt, pArguments, 0);
-      hlsl::options::DxcOpts opts;
-      bool finished;
-      ReadOptsAndValidate(mainArgs, opts, pOutputStream, ppResult, finished);
-      if (finished) {
-        hr = S_OK;
-        goto Cleanup;
+      hlsl::options::DxcOpts parsedOpts;
+      if (req.pParsedArgs == nullptr) {
+        bool finished;
+        ReadOptsAndValidate(req.Args, parsedOpts, pOutputStream, ppResult,
+                            finished);
+        if (finished) {
+          hr = S_OK;
+          goto Cleanup;
+        }
       }
+      // Arguments parsed ahead of time may be shared with other
+      // compilations, so the options are only read from here on.
+      const hlsl::options::DxcOpts &opts =
+          req.pParsedArgs ? req.pParsedArgs->Opts : parsedOpts;
+      const hlsl::options::MainArgs &mainArgs =
+          req.pParsedArgs ? req.pParsedArgs->Args : req.Args;
       if (opts.DisplayIncludeProcess)
         msfPtr->EnableDisplayIncludeProcess();
 
-      // Prepare UTF8-encoded versions of API values.
-      CW2A pUtf8EntryPoint(pEntryPoint, CP_UTF8);
-      CW2A pUtf8TargetProfile(pTargetProfile, CP_UTF8);
-      CW2A utf8SourceName(pSourceName, CP_UTF8);
-      const char *pUtf8SourceName = utf8SourceName.m_psz;
+      // Record phase timings for -ftime-report; the phases are still
+      // forwarded to the ETW tracer.
+      std::unique_ptr<hlsl::TimeReportTracer> pTimeReport;
+      std::unique_ptr<hlsl::PhaseTracerScope> pTimeReportScope;
+      if (opts.TimeReport) {
+        pTimeReport.reset(new hlsl::TimeReportTracer(hlsl::CurrentPhaseTracer()));
+        pTimeReportScope.reset(new hlsl::PhaseTracerScope(pTimeReport.get()));
+      }
+
+      // Record pass effects for -print-stats.
+      std::unique_ptr<hlsl::PassStatisticsRecorder> pPassStats;
+      std::unique_ptr<hlsl::PassObserverScope> pPassStatsScope;
+      if (opts.PrintStats) {
+        pPassStats.reset(new hlsl::PassStatisticsRecorder());
+        pPassStatsScope.reset(new hlsl::PassObserverScope(pPassStats.get()));
+      }
+
+      const char *pApiUtf8SourceName =
+          req.HasSourceName ? req.Utf8SourceName.c_str() : nullptr;
+      const char *pUtf8EntryPoint = req.Utf8EntryPoint.c_str();
+      const char *pUtf8TargetProfile = req.Utf8TargetProfile.c_str();
+      const char *pUtf8SourceName = pApiUtf8SourceName;
       if (pUtf8SourceName == nullptr) {
         if (opts.InputFile.empty()) {
           pUtf8SourceName = "input.hlsl";
@@ -353,22 +1382,21 @@ public:
           pUtf8SourceName = opts.InputFile.data();
         }
       }
-      // Set target profile.
-      opts.TargetProfile = pUtf8TargetProfile.m_psz;
+      // The target profile comes from the API rather than the arguments.
+      const bool isLibraryProfile = StringRef(pUtf8TargetProfile).startswith("lib_");
 
       IFT(msfPtr->RegisterOutputStream(L"output.bc", pOutputStream));
       IFT(msfPtr->CreateStdStreams(pMalloc));
 
-      StringRef Data((LPSTR)utf8Source->GetBufferPointer(),
-                     utf8Source->GetBufferSize());
       std::unique_ptr<llvm::MemoryBuffer> pBuffer(
-          llvm::MemoryBuffer::getMemBufferCopy(Data, pUtf8SourceName));
+          CreateMemoryBufferForSource(utf8Source, pUtf8SourceName));
 
-      // Not very efficient but also not very important.
-      std::vector<std::string> defines;
-      CreateDefineStrings(pDefines, defineCount, defines);
+      std::vector<std::string> defines(req.Defines);
       CreateDefineStrings(opts.Defines.data(), opts.Defines.size(), defines);
 
+      std::unique_ptr<llvm::MemoryBuffer> pTokenCache(GetTokenCacheBuffer(
+          utf8Source, pUtf8SourceName, opts, req.pTokenCache));
+
       // Setup a compiler instance.
       std::string warnings;
       raw_string_ostream w(warnings);
@@ -376,8 +1404,17 @@ public:
       CompilerInstance compiler;
       std::unique_ptr<TextDiagnosticPrinter> diagPrinter =
           std::make_unique<TextDiagnosticPrinter>(w, &compiler.getDiagnosticOpts());
-      SetupCompilerForCompile(compiler, &m_langExtensionsHelper, utf8SourceName, diagPrinter.get(), defines, opts, pArguments, argCount);
+      SetupCompilerForCompile(compiler, &m_langExtensionsHelper, pApiUtf8SourceName, diagPrinter.get(), defines, opts, mainArgs);
       msfPtr->SetupForCompilerInstance(compiler);
+      // Serve the main file from the source blob rather than reading it back
+      // through the file system; the source manager takes ownership.
+      compiler.getPreprocessorOpts().addRemappedFile(pApiUtf8SourceName,
+                                                     pBuffer.release());
+      compiler.getPreprocessorOpts().TokenCacheBuffer = pTokenCache.get();
+      if (req.HasConsumerInputs) {
+        compiler.getCodeGenOpts().HLSLHasConsumerInputs = true;
+        compiler.getCodeGenOpts().HLSLConsumerInputs = req.ConsumerInputs;
+      }
 
       // The clang entry point (cc1_main) would now create a compiler invocation
       // from arguments, but for this path we're exclusively trying to compile
@@ -392,8 +1429,8 @@ public:
       compiler.setOutStream(&outStream);
 
       compiler.getLangOpts().HLSLEntryFunction =
-      compiler.getCodeGenOpts().HLSLEntryFunction = pUtf8EntryPoint.m_psz;
-      compiler.getCodeGenOpts().HLSLProfile = pUtf8TargetProfile.m_psz;
+      compiler.getCodeGenOpts().HLSLEntryFunction = pUtf8EntryPoint;
+      compiler.getCodeGenOpts().HLSLProfile = pUtf8TargetProfile;
 
       unsigned rootSigMajor = 0;
       unsigned rootSigMinor = 0;
@@ -404,18 +1441,18 @@ public:
         rootSigMajor = 1;
         rootSigMinor = 0;
       }
-      compiler.getLangOpts().IsHLSLLibrary = opts.IsLibraryProfile();
+      compiler.getLangOpts().IsHLSLLibrary = isLibraryProfile;
 
       // NOTE: this calls the validation component from dxil.dll; the built-in
       // validator can be used as a fallback.
       bool produceFullContainer = !opts.CodeGenHighLevel && !opts.AstDump && !opts.OptDump && rootSigMajor == 0;
 
       bool needsValidation = produceFullContainer && !opts.DisableValidation &&
-                             !opts.IsLibraryProfile();
+                             !isLibraryProfile;
 
       if (needsValidation) {
         UINT32 majorVer, minorVer;
-        dxcutil::GetValidatorVersion(&majorVer, &minorVer);
+        GetValidatorVersion(&majorVer, &minorVer);
         compiler.getCodeGenOpts().HLSLValidatorMajorVer = majorVer;
         compiler.getCodeGenOpts().HLSLValidatorMinorVer = minorVer;
       }
@@ -424,7 +1461,7 @@ public:
         clang::ASTDumpAction dumpAction;
         // Consider - ASTDumpFilter, ASTDumpLookups
         compiler.getFrontendOpts().ASTDumpDecls = true;
-        FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
+        FrontendInputFile file(pApiUtf8SourceName, IK_HLSL);
         dumpAction.BeginSourceFile(compiler, file);
         dumpAction.Execute();
         dumpAction.EndSourceFile();
@@ -433,7 +1470,7 @@ public:
       else if (opts.OptDump) {
         llvm::LLVMContext llvmContext;
         EmitOptDumpAction action(&llvmContext);
-        FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
+        FrontendInputFile file(pApiUtf8SourceName, IK_HLSL);
         action.BeginSourceFile(compiler, file);
         action.Execute();
         action.EndSourceFile();
@@ -443,7 +1480,7 @@ public:
         HLSLRootSignatureAction action(
             compiler.getCodeGenOpts().HLSLEntryFunction, rootSigMajor,
             rootSigMinor);
-        FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
+        FrontendInputFile file(pApiUtf8SourceName, IK_HLSL);
         action.BeginSourceFile(compiler, file);
         action.Execute();
         action.EndSourceFile();
@@ -465,8 +1502,11 @@ public:
       // SPIRV change starts
 #ifdef ENABLE_SPIRV_CODEGEN
       else if (opts.GenSPIRV) {
-          clang::EmitSPIRVAction action;
-          FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
+          clang::EmitSPIRVOptions spirvOpts;
+          spirvOpts.CompactIds = opts.SPIRVCompact;
+          spirvOpts.ReportStats = opts.SPIRVStats;
+          clang::EmitSPIRVAction action(spirvOpts);
+          FrontendInputFile file(pApiUtf8SourceName, IK_HLSL);
           action.BeginSourceFile(compiler, file);
           action.Execute();
           action.EndSourceFile();
@@ -475,13 +1515,54 @@ public:
 #endif
       // SPIRV change ends
       else {
-        llvm::LLVMContext llvmContext;
-        EmitBCAction action(&llvmContext);
-        FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
+        std::shared_ptr<dxcutil::DxcContextPool> pContextPool;
+        {
+          hlsl::TracedLockGuard<std::mutex> lock(m_contextPoolMutex,
+                                                   kContextPoolLockSite);
+          pContextPool = m_pContextPool;
+        }
+        dxcutil::DxcContextLease contextLease(pContextPool.get());
+
+        // In incremental mode, the backend is skipped when the entry point
+        // digest matches the one its kept container was compiled from.
+        CComPtr<IDxcBlob> pKeptContainer;
+        if (produceFullContainer && ppDebugBlob == nullptr &&
+            ppDebugBlobName == nullptr && !req.HasConsumerInputs &&
+            ComputeIncrementalKey(pUtf8SourceName, pUtf8EntryPoint,
+                                  pUtf8TargetProfile, opts, defines,
+                                  incrementalKey)) {
+          compiler.getCodeGenOpts().HLSLBackendFilter =
+              [&](clang::ASTContext &C, llvm::Module &M) {
+            // Errors are reported by the backend as usual.
+            if (C.getDiagnostics().hasErrorOccurred())
+              return true;
+            dxcutil::ComputeEntryPointDigest(C, M, incrementalDigest);
+            incrementalDigestValid = true;
+            hlsl::TracedLockGuard<std::mutex> lock(m_incrementalMutex,
+                                                     kIncrementalLockSite);
+            auto it = m_incrementalEntries.find(incrementalKey);
+            if (it == m_incrementalEntries.end() ||
+                0 != memcmp(it->second.Digest, incrementalDigest,
+                            sizeof(incrementalDigest)))
+              return true;
+            pKeptContainer = it->second.pContainer;
+            return false;
+          };
+        }
+
+        // The optimization pipeline, validation and serialization only need
+        // the module, so the AST and Sema are released with the source file
+        // and the backend runs afterwards. The preprocessor goes too; the
+        // source manager stays for diagnostics.
+        compiler.getCodeGenOpts().HLSLDeferBackend = true;
+        EmitBCAction action(&contextLease.get());
+        FrontendInputFile file(pApiUtf8SourceName, IK_HLSL);
         bool compileOK;
         if (action.BeginSourceFile(compiler, file)) {
           action.Execute();
           action.EndSourceFile();
+          compiler.setPreprocessor(nullptr);
+          action.EmitDeferredBackendOutput(compiler);
           compileOK = !compiler.getDiagnostics().hasErrorOccurred();
         }
         else {
@@ -495,15 +1576,32 @@ public:
           // Unless we want to strip it right away, include it in the container.
           if (!opts.StripDebug || ppDebugBlob == nullptr) {
             SerializeFlags |= SerializeDxilFlags::IncludeDebugInfoPart;
+            if (opts.CompressDebug)
+              SerializeFlags |= SerializeDxilFlags::CompressDebugInfoPart;
           }
         }
         if (opts.DebugNameForSource) {
           SerializeFlags |= SerializeDxilFlags::DebugNameDependOnSource;
         }
+        if (opts.DebugNameFastHash) {
+          SerializeFlags |= SerializeDxilFlags::DebugNameFastHash;
+        }
+        if (opts.PSVIndexes) {
+          SerializeFlags |= SerializeDxilFlags::IncludePSVIndexes;
+        }
+        if (opts.DedupStrings) {
+          SerializeFlags |= SerializeDxilFlags::DeduplicateStrings;
+        }
 
+        if (compileOK && pKeptContainer != nullptr) {
+          pOutputBlob = pKeptContainer;
+          hlsl::TracedLockGuard<std::mutex> lock(m_incrementalMutex,
+                                                   kIncrementalLockSite);
+          ++m_incrementalReused;
+        }
         // Don't do work to put in a container if an error has occurred
         // Do not create a container when there is only a a high-level representation in the module.
-        if (compileOK && !opts.CodeGenHighLevel) {
+        else if (compileOK && !opts.CodeGenHighLevel) {
           HRESULT valHR = S_OK;
 
           if (needsValidation) {
@@ -540,18 +1638,88 @@ public:
             }
           }
         }
+
+        // Only the context of a successful compilation goes back to the pool;
+        // the action and its module are destroyed before the lease.
+        if (compileOK)
+          contextLease.SetReusable();
       }
 
       // Add std err to warnings.
       msfPtr->WriteStdErrToStream(w);
+      traceRecording.SetIncludes(msfPtr);
+
+      // List the files this compilation opened for -MD, so that build
+      // systems need no separate preprocessing pass to find them.
+      CComPtr<IDxcBlobEncoding> pDependenciesBlob;
+      if (opts.DependenciesWithOutput) {
+        std::vector<std::wstring> fileNames;
+        msfPtr->GetOpenedFileNames(fileNames);
+        std::string dependencies;
+        raw_string_ostream dependencyStream(dependencies);
+        WriteDependencies(dependencyStream,
+                          GetDependencyTarget(opts, pUtf8SourceName),
+                          fileNames, opts.DependenciesJson);
+        dependencyStream.flush();
+        IFT(DxcCreateBlobWithEncodingOnHeapCopy(
+            dependencies.data(), dependencies.size(), CP_UTF8,
+            &pDependenciesBlob));
+      }
+
+      CComPtr<IDxcBlobEncoding> pTimeReportBlob;
+      if (pTimeReport) {
+        pTimeReportScope.reset();
+        std::string report;
+        raw_string_ostream reportStream(report);
+        pTimeReport->WriteJson(reportStream);
+        reportStream.flush();
+        IFT(DxcCreateBlobWithEncodingOnHeapCopy(report.data(), report.size(),
+                                                CP_UTF8, &pTimeReportBlob));
+      }
+
+      CComPtr<IDxcBlobEncoding> pPassStatsBlob;
+      if (pPassStats) {
+        pPassStatsScope.reset();
+        std::string report;
+        raw_string_ostream reportStream(report);
+        pPassStats->WriteJson(reportStream);
+        reportStream.flush();
+        IFT(DxcCreateBlobWithEncodingOnHeapCopy(report.data(), report.size(),
+                                                CP_UTF8, &pPassStatsBlob));
+      }
 
       CreateOperationResultFromOutputs(pOutputBlob, msfPtr, warnings,
                                        compiler.getDiagnostics(), ppResult);
+      if (pTimeReportBlob != nullptr) {
+        static_cast<DxcOperationResult *>(*ppResult)->m_timeReport = pTimeReportBlob;
+      }
+      if (pPassStatsBlob != nullptr) {
+        static_cast<DxcOperationResult *>(*ppResult)->m_passStatistics = pPassStatsBlob;
+      }
+      if (pDependenciesBlob != nullptr) {
+        static_cast<DxcOperationResult *>(*ppResult)->m_dependencies = pDependenciesBlob;
+      }
+      SetRootSignatureHash(pOutputBlob, *ppResult);
 
       // On success, return values. After assigning ppResult, nothing should fail.
       HRESULT status;
       DXVERIFY_NOMSG(SUCCEEDED((*ppResult)->GetStatus(&status)));
       if (SUCCEEDED(status)) {
+        if (pResultStoreKey != nullptr && pOutputBlob != nullptr) {
+          // Failing to store only costs a future recompile.
+          m_pResultStore->Store(pResultStoreKey, pOutputBlob);
+        }
+        if (incrementalDigestValid && pOutputBlob != nullptr) {
+          hlsl::TracedLockGuard<std::mutex> lock(m_incrementalMutex,
+                                                   kIncrementalLockSite);
+          // A reused container is already the kept one.
+          IncrementalEntry &entry = m_incrementalEntries[incrementalKey];
+          if (m_incremental && entry.pContainer != pOutputBlob) {
+            memcpy(entry.Digest, incrementalDigest, sizeof(entry.Digest));
+            entry.pContainer = pOutputBlob;
+            ++m_incrementalCompiled;
+          }
+        }
         if (opts.DebugInfo && ppDebugBlob) {
           DXVERIFY_NOMSG(SUCCEEDED(pOutputStream.QueryInterface(ppDebugBlob)));
         }
@@ -564,25 +1732,394 @@ public:
     }
     CATCH_CPP_ASSIGN_HRESULT();
   Cleanup:
+    hr = memoryScope.Finish(hr, ppResult);
+    traceRecording.Finish(hr, *ppResult);
     DxcEtw_DXCompilerCompile_Stop(hr);
     return hr;
   }
 
-  // Preprocess source text
-  __override HRESULT STDMETHODCALLTYPE Preprocess(
-    _In_ IDxcBlob *pSource,                       // Source text to preprocess
+  // Compile several entry points of the same source text.
+  __override HRESULT STDMETHODCALLTYPE CompileBatch(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
     _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_count_(targetCount) const DxcCompileTarget *pTargets, // Array of (entry point, profile) pairs
+    _In_ UINT32 targetCount,                      // Number of targets
     _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
     _In_ UINT32 argCount,                         // Number of arguments
     _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
     _In_ UINT32 defineCount,                      // Number of defines
     _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
-    _COM_Outptr_ IDxcOperationResult **ppResult   // Preprocessor output status, buffer, and errors
-    ) {
-    if (pSource == nullptr || ppResult == nullptr ||
+    _Out_writes_(targetCount) IDxcOperationResult **ppResults // Compiler output status, buffer, and errors per target
+  ) {
+    if (pSource == nullptr || ppResults == nullptr ||
+        (targetCount > 0 && pTargets == nullptr))
+      return E_INVALIDARG;
+    for (UINT32 i = 0; i < targetCount; ++i)
+      ppResults[i] = nullptr;
+
+    // Convert the source once; each target then reuses the UTF-8 blob along
+    // with the state cached on this compiler object.
+    CComPtr<IDxcBlobEncoding> utf8Source;
+    HRESULT hr = hlsl::DxcGetBlobAsUtf8(pSource, &utf8Source);
+    for (UINT32 i = 0; SUCCEEDED(hr) && i < targetCount; ++i) {
+      hr = CompileWithDebug(utf8Source, pSourceName, pTargets[i].EntryPoint,
+                            pTargets[i].TargetProfile, pArguments, argCount,
+                            pDefines, defineCount, pIncludeHandler,
+                            &ppResults[i], nullptr, nullptr);
+    }
+
+    if (FAILED(hr)) {
+      for (UINT32 i = 0; i < targetCount; ++i) {
+        if (ppResults[i] != nullptr) {
+          ppResults[i]->Release();
+          ppResults[i] = nullptr;
+        }
+      }
+    }
+    return hr;
+  }
+
+  // Compile the stages of a graphics pipeline. Stages that share a source
+  // share one token cache, and each vertex or domain shader is compiled
+  // once the stage after it is, keeping only the outputs that stage reads.
+  __override HRESULT STDMETHODCALLTYPE CompilePipeline(
+    _In_count_(stageCount) const DxcPipelineStage *pStages, // Stages in pipeline order
+    _In_ UINT32 stageCount,                       // Number of stages
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _Out_writes_(stageCount) IDxcOperationResult **ppResults // Compiler output status, buffer, and errors per stage
+  ) {
+    if (ppResults == nullptr || (stageCount > 0 && pStages == nullptr) ||
         (defineCount > 0 && pDefines == nullptr) ||
         (argCount > 0 && pArguments == nullptr))
       return E_INVALIDARG;
+    std::vector<int> ranks(stageCount);
+    for (UINT32 i = 0; i < stageCount; ++i) {
+      if (pStages[i].pSource == nullptr || pStages[i].EntryPoint == nullptr ||
+          pStages[i].TargetProfile == nullptr)
+        return E_INVALIDARG;
+      ranks[i] = GetPipelineStageRank(pStages[i].TargetProfile);
+      if (ranks[i] < 0 || (i > 0 && ranks[i] <= ranks[i - 1]))
+        return E_INVALIDARG;
+    }
+    for (UINT32 i = 0; i < stageCount; ++i)
+      ppResults[i] = nullptr;
+
+    HRESULT hr = S_OK;
+    try {
+      std::vector<CompileRequest> requests(stageCount);
+      for (UINT32 i = 0; i < stageCount; ++i)
+        InitCompileRequest(requests[i], pStages[i].pSourceName,
+                           pStages[i].EntryPoint, pStages[i].TargetProfile,
+                           pArguments, argCount, pDefines, defineCount,
+                           pIncludeHandler);
+
+      // Lex each source used by several stages once. The token cache does
+      // not depend on the entry point or profile; a source that fails to
+      // preprocess is left for its compilations to report.
+      auto isSameSource = [&](UINT32 a, UINT32 b) {
+        LPCWSTR pNameA = pStages[a].pSourceName;
+        LPCWSTR pNameB = pStages[b].pSourceName;
+        if (pStages[a].pSource != pStages[b].pSource)
+          return false;
+        if (pNameA == nullptr || pNameB == nullptr)
+          return pNameA == pNameB;
+        return 0 == wcscmp(pNameA, pNameB);
+      };
+      std::vector<bool> lexed(stageCount, false);
+      for (UINT32 i = 0; i < stageCount; ++i) {
+        if (lexed[i])
+          continue;
+        std::vector<UINT32> sharing(1, i);
+        for (UINT32 j = i + 1; j < stageCount; ++j) {
+          if (isSameSource(i, j))
+            sharing.push_back(j);
+        }
+        for (UINT32 j : sharing)
+          lexed[j] = true;
+        if (sharing.size() < 2)
+          continue;
+        CComPtr<IDxcOperationResult> pCacheResult;
+        CComPtr<IDxcBlob> pTokenCache;
+        HRESULT status;
+        if (SUCCEEDED(CreateTokenCache(pStages[i].pSource,
+                                       pStages[i].pSourceName, pArguments,
+                                       argCount, pDefines, defineCount,
+                                       pIncludeHandler, &pCacheResult)) &&
+            SUCCEEDED(pCacheResult->GetStatus(&status)) && SUCCEEDED(status))
+          IFT(pCacheResult->GetResult(&pTokenCache));
+        for (UINT32 j : sharing)
+          requests[j].pTokenCache = pTokenCache;
+      }
+
+      // Compiles the given stages on worker threads, one at a time each.
+      std::vector<HRESULT> results(stageCount, S_OK);
+      auto compileStages = [&](const std::vector<UINT32> &stages) {
+        if (stages.empty())
+          return;
+        unsigned threadCount =
+            std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min<unsigned>(threadCount, (unsigned)stages.size());
+        std::atomic<size_t> nextStage(0);
+        auto worker = [&]() {
+          for (size_t n = nextStage++; n < stages.size(); n = nextStage++) {
+            UINT32 i = stages[n];
+            results[i] = CompileRequestWithDebug(
+                pStages[i].pSource, requests[i], &ppResults[i], nullptr,
+                nullptr);
+          }
+        };
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < threadCount; ++i)
+          threads.emplace_back(worker);
+        worker();
+        for (std::thread &t : threads)
+          t.join();
+      };
+
+      // A vertex or domain shader waits for the stage it feeds, unless that
+      // stage is itself waiting.
+      std::vector<UINT32> consumers, producers;
+      for (UINT32 i = 0; i < stageCount; ++i) {
+        if ((ranks[i] == kPipelineVertexRank ||
+             ranks[i] == kPipelineDomainRank) &&
+            i + 1 < stageCount && ranks[i + 1] != kPipelineDomainRank)
+          producers.push_back(i);
+        else
+          consumers.push_back(i);
+      }
+      compileStages(consumers);
+      for (UINT32 i : producers) {
+        // A stage that failed to compile leaves its producer as it is.
+        requests[i].HasConsumerInputs =
+            GetConsumerInputs(ppResults[i + 1], requests[i].ConsumerInputs);
+      }
+      compileStages(producers);
+
+      for (UINT32 i = 0; SUCCEEDED(hr) && i < stageCount; ++i)
+        hr = results[i];
+    }
+    CATCH_CPP_ASSIGN_HRESULT();
+
+    if (FAILED(hr)) {
+      for (UINT32 i = 0; i < stageCount; ++i) {
+        if (ppResults[i] != nullptr) {
+          ppResults[i]->Release();
+          ppResults[i] = nullptr;
+        }
+      }
+    }
+    return hr;
+  }
+
+  // Compile one entry point under several define sets, once per group of
+  // sets that preprocess to the same text.
+  __override HRESULT STDMETHODCALLTYPE CompilePermutations(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // Entry point name
+    _In_ LPCWSTR pTargetProfile,                  // Shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(setCount) const DxcDefineSet *pDefineSets, // Array of define sets
+    _In_ UINT32 setCount,                         // Number of define sets
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _Out_writes_(setCount) IDxcOperationResult **ppResults, // Compiler output status, buffer, and errors per set
+    _Out_writes_opt_(setCount) UINT32 *pRepresentatives // Index of the set compiled for each set
+  ) {
+    if (pSource == nullptr || ppResults == nullptr ||
+        (setCount > 0 && pDefineSets == nullptr) ||
+        (argCount > 0 && pArguments == nullptr) || pEntryPoint == nullptr ||
+        pTargetProfile == nullptr)
+      return E_INVALIDARG;
+    for (UINT32 i = 0; i < setCount; ++i) {
+      if (pDefineSets[i].DefineCount > 0 && pDefineSets[i].pDefines == nullptr)
+        return E_INVALIDARG;
+    }
+    for (UINT32 i = 0; i < setCount; ++i)
+      ppResults[i] = nullptr;
+
+    CComPtr<IDxcBlobEncoding> utf8Source;
+    HRESULT hr = hlsl::DxcGetBlobAsUtf8(pSource, &utf8Source);
+    try {
+      // The result store key hashes the preprocessed text with everything
+      // else the container depends on, so equal keys mean equal containers.
+      // Sets without a key are compiled on their own.
+      llvm::StringMap<UINT32> groups;
+      for (UINT32 i = 0; SUCCEEDED(hr) && i < setCount; ++i) {
+        CComPtr<IDxcBlob> pKey;
+        ComputeResultStoreKey(utf8Source, pSourceName, pEntryPoint,
+                              pTargetProfile, pArguments, argCount,
+                              pDefineSets[i].pDefines,
+                              pDefineSets[i].DefineCount, pIncludeHandler,
+                              &pKey);
+        UINT32 representative = i;
+        if (pKey != nullptr) {
+          StringRef key((const char *)pKey->GetBufferPointer(),
+                        pKey->GetBufferSize());
+          representative = groups.insert(std::make_pair(key, i)).first->second;
+        }
+        if (pRepresentatives != nullptr)
+          pRepresentatives[i] = representative;
+        if (representative != i) {
+          ppResults[i] = ppResults[representative];
+          ppResults[i]->AddRef();
+          continue;
+        }
+        hr = CompileWithDebug(utf8Source, pSourceName, pEntryPoint,
+                              pTargetProfile, pArguments, argCount,
+                              pDefineSets[i].pDefines,
+                              pDefineSets[i].DefineCount, pIncludeHandler,
+                              &ppResults[i], nullptr, nullptr);
+      }
+    }
+    CATCH_CPP_ASSIGN_HRESULT();
+
+    if (FAILED(hr)) {
+      for (UINT32 i = 0; i < setCount; ++i) {
+        if (ppResults[i] != nullptr) {
+          ppResults[i]->Release();
+          ppResults[i] = nullptr;
+        }
+      }
+    }
+    return hr;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CompileAsync(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // entry point name
+    _In_ LPCWSTR pTargetProfile,                  // shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcAsyncOperationResult **ppResult // Pending compiler output status, buffer, and errors
+  ) {
+    if (pSource == nullptr || ppResult == nullptr ||
+        (defineCount > 0 && pDefines == nullptr) ||
+        (argCount > 0 && pArguments == nullptr) || pEntryPoint == nullptr ||
+        pTargetProfile == nullptr)
+      return E_INVALIDARG;
+    *ppResult = nullptr;
+
+    try {
+      // The caller's strings only live for this call, so the job owns copies.
+      struct CompileJob {
+        CComPtr<IDxcBlob> Source;
+        CComPtr<IDxcIncludeHandler> IncludeHandler;
+        CComPtr<DxcAsyncOperationResult> Result;
+        bool HasSourceName;
+        std::wstring SourceName, EntryPoint, TargetProfile;
+        std::vector<std::wstring> Arguments, DefineNames, DefineValues;
+        std::vector<bool> DefineHasValue;
+      };
+      std::shared_ptr<CompileJob> job = std::make_shared<CompileJob>();
+      job->Source = pSource;
+      job->IncludeHandler = pIncludeHandler;
+      job->Result = new DxcAsyncOperationResult();
+      job->HasSourceName = pSourceName != nullptr;
+      if (pSourceName != nullptr)
+        job->SourceName = pSourceName;
+      job->EntryPoint = pEntryPoint;
+      job->TargetProfile = pTargetProfile;
+      job->Arguments.assign(pArguments, pArguments + argCount);
+      for (UINT32 i = 0; i < defineCount; ++i) {
+        job->DefineNames.emplace_back(pDefines[i].Name);
+        job->DefineHasValue.push_back(pDefines[i].Value != nullptr);
+        job->DefineValues.emplace_back(pDefines[i].Value ? pDefines[i].Value : L"");
+      }
+
+      std::call_once(m_threadPoolFlag, [this]() {
+        m_pThreadPool.reset(new dxcutil::DxcThreadPool());
+      });
+
+      *ppResult = job->Result;
+      (*ppResult)->AddRef();
+      m_pThreadPool->Enqueue([this, job]() {
+        CComPtr<IDxcOperationResult> pResult;
+        HRESULT hr = S_OK;
+        try {
+          std::vector<LPCWSTR> args;
+          for (const std::wstring &arg : job->Arguments)
+            args.push_back(arg.c_str());
+          std::vector<DxcDefine> defines(job->DefineNames.size());
+          for (size_t i = 0; i < defines.size(); ++i) {
+            defines[i].Name = job->DefineNames[i].c_str();
+            defines[i].Value = job->DefineHasValue[i] ? job->DefineValues[i].c_str() : nullptr;
+          }
+          hr = CompileWithDebug(
+              job->Source, job->HasSourceName ? job->SourceName.c_str() : nullptr,
+              job->EntryPoint.c_str(), job->TargetProfile.c_str(),
+              args.data(), (UINT32)args.size(), defines.data(),
+              (UINT32)defines.size(), job->IncludeHandler, &pResult, nullptr,
+              nullptr);
+        }
+        CATCH_CPP_ASSIGN_HRESULT();
+        job->Result->Complete(hr, pResult);
+      });
+    }
+    CATCH_CPP_RETURN_HRESULT();
+
+    return S_OK;
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CompileWithCancellation(
+    _In_ IDxcBlob *pSource,                       // Source text to compile
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_ LPCWSTR pEntryPoint,                     // entry point name
+    _In_ LPCWSTR pTargetProfile,                  // shader profile to compile
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _In_opt_ IDxcCancellationToken *pToken,       // Cancellation flag (optional)
+    _In_ UINT32 timeoutMs,                        // Deadline relative to the call, or INFINITE
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Compiler output status, buffer, and errors
+  ) {
+    // The checks run on this thread inside Sema and the pass managers, and
+    // unwind back into CompileWithDebug as an hlsl::Exception.
+    hlsl::CancellationState state;
+    if (pToken != nullptr) {
+      state.IsCancelled = [](void *pContext) -> bool {
+        return ((IDxcCancellationToken *)pContext)->IsCancellationRequested() != FALSE;
+      };
+      state.pContext = pToken;
+    }
+    if (timeoutMs != INFINITE) {
+      state.HasDeadline = true;
+      state.Deadline = hlsl::CancellationState::Clock::now() +
+                       std::chrono::milliseconds(timeoutMs);
+    }
+    hlsl::CancellationScope scope(state);
+    return CompileWithDebug(pSource, pSourceName, pEntryPoint, pTargetProfile,
+                            pArguments, argCount, pDefines, defineCount,
+                            pIncludeHandler, ppResult, nullptr, nullptr);
+  }
+
+  // Runs the preprocessor only, producing the preprocessed text, the
+  // dependency list, with createTokenCache a token cache or, with pPackage,
+  // the package of pPackage with the source and the files it includes.
+  // With pTextOutput, the text or dependency list is written there instead
+  // of into the result, shaped by the DxcPreprocessFlags_* in flags.
+  HRESULT PreprocessImpl(
+    _In_ IDxcBlob *pSource, _In_opt_ LPCWSTR pSourceName,
+    _In_count_(argCount) LPCWSTR *pArguments, _In_ UINT32 argCount,
+    _In_count_(defineCount) const DxcDefine *pDefines, _In_ UINT32 defineCount,
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, bool createTokenCache,
+    _Inout_opt_ hlsl::TraceCall *pPackage, _In_opt_ IStream *pTextOutput,
+    UINT32 flags, _COM_Outptr_ IDxcOperationResult **ppResult) {
+    if (pSource == nullptr || ppResult == nullptr ||
+        (defineCount > 0 && pDefines == nullptr) ||
+        (argCount > 0 && pArguments == nullptr) ||
+        (flags & ~DxcPreprocessFlags_ValidMask))
+      return E_INVALIDARG;
     *ppResult = nullptr;
 
     HRESULT hr = S_OK;
@@ -596,6 +2133,7 @@ public:
       dxcutil::DxcArgsFileSystem *msfPtr;
       IFT(dxcutil::CreateDxcArgsFileSystem(utf8Source, pSourceName, pIncludeHandler, &msfPtr));
       std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+      msfPtr->SetIncludeCache(m_pIncludeCache);
 
       ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
       IFTLLVM(pts.error_code());
@@ -627,27 +2165,44 @@ public:
         }
       }
 
-      IFT(msfPtr->RegisterOutputStream(L"output.hlsl", pOutputStream));
+      if (pTextOutput != nullptr)
+        IFT(msfPtr->RegisterOutputStream(L"output.hlsl", pTextOutput));
+      else
+        IFT(msfPtr->RegisterOutputStream(L"output.hlsl", pOutputStream));
       IFT(msfPtr->CreateStdStreams(pMalloc));
 
-      StringRef Data((LPSTR)utf8Source->GetBufferPointer(),
-        utf8Source->GetBufferSize());
       std::unique_ptr<llvm::MemoryBuffer> pBuffer(
-        llvm::MemoryBuffer::getMemBufferCopy(Data, pUtf8SourceName));
+          CreateMemoryBufferForSource(utf8Source, pUtf8SourceName));
 
       // Not very efficient but also not very important.
       std::vector<std::string> defines;
       CreateDefineStrings(pDefines, defineCount, defines);
 
+      // A token cache is created by lexing the files themselves, and a
+      // package must reach every file the compilation would.
+      std::unique_ptr<llvm::MemoryBuffer> pTokenCache;
+      if (!createTokenCache && pPackage == nullptr)
+        pTokenCache = GetTokenCacheBuffer(utf8Source, pUtf8SourceName, opts);
+
       // Setup a compiler instance.
       std::string warnings;
       raw_string_ostream w(warnings);
       raw_stream_ostream outStream(pOutputStream.p);
+      std::unique_ptr<raw_istream_ostream> pTextStream;
+      if (pTextOutput != nullptr)
+        pTextStream.reset(new raw_istream_ostream(pTextOutput));
+      raw_ostream &textStream =
+          pTextStream ? static_cast<raw_ostream &>(*pTextStream) : outStream;
       CompilerInstance compiler;
       std::unique_ptr<TextDiagnosticPrinter> diagPrinter =
           std::make_unique<TextDiagnosticPrinter>(w, &compiler.getDiagnosticOpts());
-      SetupCompilerForCompile(compiler, &m_langExtensionsHelper, utf8SourceName, diagPrinter.get(), defines, opts, pArguments, argCount);
+      SetupCompilerForCompile(compiler, &m_langExtensionsHelper, utf8SourceName, diagPrinter.get(), defines, opts, mainArgs);
       msfPtr->SetupForCompilerInstance(compiler);
+      // Serve the main file from the source blob rather than reading it back
+      // through the file system; the source manager takes ownership.
+      compiler.getPreprocessorOpts().addRemappedFile(utf8SourceName.m_psz,
+                                                     pBuffer.release());
+      compiler.getPreprocessorOpts().TokenCacheBuffer = pTokenCache.get();
 
       // The clang entry point (cc1_main) would now create a compiler invocation
       // from arguments, but for this path we're exclusively trying to preproces
@@ -661,18 +2216,73 @@ public:
           compiler.getPreprocessorOutputOpts();
       PPOutOpts.ShowCPP = 1;            // Print normal preprocessed output.
       PPOutOpts.ShowComments = 0;       // Show comments.
-      PPOutOpts.ShowLineMarkers = 1;    // Show \#line markers.
+      PPOutOpts.ShowLineMarkers =       // Show \#line markers.
+          (flags & DxcPreprocessFlags_NoLineMarkers) == 0;
       PPOutOpts.UseLineDirectives = 1;  // Use \#line instead of GCC-style \# N.
       PPOutOpts.ShowMacroComments = 0;  // Show comments, even in macros.
       PPOutOpts.ShowMacros = 0;         // Print macro definitions.
       PPOutOpts.RewriteIncludes = 0;    // Preprocess include directives only.
+      PPOutOpts.NormalizeWhitespace =
+          (flags & DxcPreprocessFlags_NormalizeWhitespace) != 0;
 
       FrontendInputFile file(utf8SourceName.m_psz, IK_HLSL);
-      clang::PrintPreprocessedAction action;
-      if (action.BeginSourceFile(compiler, file)) {
-        action.Execute();
-        action.EndSourceFile();
+      if (createTokenCache) {
+        SmallVector<char, 4096> tokens;
+        raw_svector_ostream tokenStream(tokens);
+        GenerateTokenCacheAction action(tokenStream);
+        if (action.BeginSourceFile(compiler, file)) {
+          action.Execute();
+          action.EndSourceFile();
+        }
+        tokenStream.flush();
+        llvm::MD5::MD5Result digest;
+        ComputeTokenCacheDigest(utf8Source, pUtf8SourceName, opts, digest);
+        DxcTokenCacheHeader header;
+        header.FourCC = DxcTokenCacheFourCC;
+        header.Version = DxcTokenCacheVersion;
+        memcpy(header.Digest, digest, sizeof(header.Digest));
+        outStream.write((const char *)&header, sizeof(header));
+        outStream.write(tokens.data(), tokens.size());
+      }
+      else if (pPackage != nullptr) {
+        // Preprocessing opens the same files as the compilation; a file
+        // reached only from an excluded conditional block is not needed.
+        clang::PreprocessOnlyAction action;
+        if (action.BeginSourceFile(compiler, file)) {
+          action.Execute();
+          action.EndSourceFile();
+        }
+        if (!compiler.getDiagnostics().hasErrorOccurred()) {
+          pPackage->Source.assign(
+              (const char *)utf8Source->GetBufferPointer(),
+              utf8Source->GetBufferSize());
+          dxcutil::SetTraceCallIncludes(*pPackage, msfPtr);
+          std::string package;
+          hlsl::SerializeCompilePackage(*pPackage, package);
+          outStream.write(package.data(), package.size());
+        }
       }
+      else if (opts.DependenciesOnly) {
+        // Only run the preprocessor, which skips excluded conditional blocks
+        // without lexing them, and list the files it opened.
+        clang::PreprocessOnlyAction action;
+        if (action.BeginSourceFile(compiler, file)) {
+          action.Execute();
+          action.EndSourceFile();
+        }
+        std::vector<std::wstring> fileNames;
+        msfPtr->GetOpenedFileNames(fileNames);
+        WriteDependencies(textStream, GetDependencyTarget(opts, pUtf8SourceName),
+                          fileNames, opts.DependenciesJson);
+      }
+      else {
+        clang::PrintPreprocessedAction action;
+        if (action.BeginSourceFile(compiler, file)) {
+          action.Execute();
+          action.EndSourceFile();
+        }
+      }
+      textStream.flush();
       outStream.flush();
 
       // Add std err to warnings.
@@ -688,6 +2298,116 @@ public:
     return hr;
   }
 
+  // Preprocess source text
+  __override HRESULT STDMETHODCALLTYPE Preprocess(
+    _In_ IDxcBlob *pSource,                       // Source text to preprocess
+    _In_opt_ LPCWSTR pSourceName,                 // Optional file name for pSource. Used in errors and include handlers.
+    _In_count_(argCount) LPCWSTR *pArguments,     // Array of pointers to arguments
+    _In_ UINT32 argCount,                         // Number of arguments
+    _In_count_(defineCount) const DxcDefine *pDefines,  // Array of defines
+    _In_ UINT32 defineCount,                      // Number of defines
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, // user-provided interface to handle #include directives (optional)
+    _COM_Outptr_ IDxcOperationResult **ppResult   // Preprocessor output status, buffer, and errors
+    ) {
+    return PreprocessImpl(pSource, pSourceName, pArguments, argCount, pDefines,
+                          defineCount, pIncludeHandler, false, nullptr,
+                          nullptr, DxcPreprocessFlags_None, ppResult);
+  }
+
+  // IDxcCompilerStreamingPreprocess
+  __override HRESULT STDMETHODCALLTYPE PreprocessToStream(
+    _In_ IDxcBlob *pSource, _In_opt_ LPCWSTR pSourceName,
+    _In_count_(argCount) LPCWSTR *pArguments, _In_ UINT32 argCount,
+    _In_count_(defineCount) const DxcDefine *pDefines, _In_ UINT32 defineCount,
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler, _In_ UINT32 Flags,
+    _In_ IStream *pOutput, _COM_Outptr_ IDxcOperationResult **ppResult) {
+    if (pOutput == nullptr)
+      return E_INVALIDARG;
+    return PreprocessImpl(pSource, pSourceName, pArguments, argCount, pDefines,
+                          defineCount, pIncludeHandler, false, nullptr,
+                          pOutput, Flags, ppResult);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CreateTokenCache(
+    _In_ IDxcBlob *pSource, _In_opt_ LPCWSTR pSourceName,
+    _In_count_(argCount) LPCWSTR *pArguments, _In_ UINT32 argCount,
+    _In_count_(defineCount) const DxcDefine *pDefines, _In_ UINT32 defineCount,
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler,
+    _COM_Outptr_ IDxcOperationResult **ppResult) {
+    return PreprocessImpl(pSource, pSourceName, pArguments, argCount, pDefines,
+                          defineCount, pIncludeHandler, true, nullptr,
+                          nullptr, DxcPreprocessFlags_None, ppResult);
+  }
+
+  // IDxcCompilerPackaging
+  __override HRESULT STDMETHODCALLTYPE CreatePackage(
+    _In_ IDxcBlob *pSource, _In_opt_ LPCWSTR pSourceName,
+    _In_ LPCWSTR pEntryPoint, _In_ LPCWSTR pTargetProfile,
+    _In_count_(argCount) LPCWSTR *pArguments, _In_ UINT32 argCount,
+    _In_count_(defineCount) const DxcDefine *pDefines, _In_ UINT32 defineCount,
+    _In_opt_ IDxcIncludeHandler *pIncludeHandler,
+    _COM_Outptr_ IDxcOperationResult **ppResult) {
+    if (pSource == nullptr || ppResult == nullptr ||
+        (defineCount > 0 && pDefines == nullptr) ||
+        (argCount > 0 && pArguments == nullptr) || pEntryPoint == nullptr ||
+        pTargetProfile == nullptr)
+      return E_INVALIDARG;
+    *ppResult = nullptr;
+
+    hlsl::TraceCall package;
+    try {
+      dxcutil::SetTraceCallRequest(package, pSourceName, pEntryPoint,
+                                   pTargetProfile, pArguments, argCount,
+                                   pDefines, defineCount);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return PreprocessImpl(pSource, pSourceName, pArguments, argCount, pDefines,
+                          defineCount, pIncludeHandler, false, &package,
+                          nullptr, DxcPreprocessFlags_None, ppResult);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE CompileFromPackage(
+    _In_ IDxcBlob *pPackage, _COM_Outptr_ IDxcOperationResult **ppResult) {
+    if (pPackage == nullptr || ppResult == nullptr)
+      return E_INVALIDARG;
+    *ppResult = nullptr;
+
+    hlsl::TraceCall package;
+    std::vector<LPCWSTR> arguments;
+    std::vector<DxcDefine> defines;
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcIncludeHandler> pIncludeHandler;
+    try {
+      if (!hlsl::DeserializeCompilePackage(pPackage->GetBufferPointer(),
+                                           pPackage->GetBufferSize(), package))
+        return E_INVALIDARG;
+      for (const std::wstring &arg : package.Arguments)
+        arguments.push_back(arg.c_str());
+      for (const hlsl::TraceCall::Define &define : package.Defines) {
+        DxcDefine d;
+        d.Name = define.Name.c_str();
+        d.Value = define.HasValue ? define.Value.c_str() : nullptr;
+        defines.push_back(d);
+      }
+      IFT(DxcCreateBlobWithEncodingOnHeapCopy(package.Source.data(),
+                                              (UINT32)package.Source.size(),
+                                              CP_UTF8, &pSource));
+      pIncludeHandler = new DxcPackageIncludeHandler(package);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+    return CompileWithDebug(
+        pSource, package.HasSourceName ? package.SourceName.c_str() : nullptr,
+        package.EntryPoint.c_str(), package.TargetProfile.c_str(),
+        arguments.data(), (UINT32)arguments.size(), defines.data(),
+        (UINT32)defines.size(), pIncludeHandler, ppResult, nullptr, nullptr);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE SetTokenCache(_In_opt_ IDxcBlob *pTokenCache) {
+    std::lock_guard<std::mutex> lock(m_tokenCacheMutex);
+    m_pTokenCache = pTokenCache;
+    return S_OK;
+  }
+
   // Disassemble a shader.
   __override HRESULT STDMETHODCALLTYPE Disassemble(
     _In_ IDxcBlob *pProgram,                      // Program to disassemble.
@@ -724,13 +2444,50 @@ public:
     return hr;
   }
 
+  // Disassemble a shader into a caller-provided stream.
+  __override HRESULT STDMETHODCALLTYPE DisassembleToStream(
+    _In_ IDxcBlob *pSource,                         // Program to disassemble.
+    _In_ UINT32 sections,                           // DxcDisassembleSection_* flags.
+    _In_count_(functionCount) LPCWSTR *pFunctions,  // Functions to list (optional).
+    _In_ UINT32 functionCount,                      // Number of functions; 0 for all.
+    _In_ IStream *pOutput                           // Receives disassembly text (UTF-8).
+    ) {
+    if (pSource == nullptr || pOutput == nullptr ||
+        (sections & ~DxcDisassembleSection_All) ||
+        (functionCount > 0 && pFunctions == nullptr))
+      return E_INVALIDARG;
+
+    HRESULT hr = S_OK;
+    DxcEtw_DXCompilerDisassemble_Start();
+    try {
+      ::llvm::sys::fs::MSFileSystem *msfPtr;
+      IFT(CreateMSFileSystemForDisk(&msfPtr));
+      std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+
+      ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+      IFTLLVM(pts.error_code());
+
+      std::vector<std::string> functions;
+      for (UINT32 i = 0; i < functionCount; ++i) {
+        IFTARG(pFunctions[i]);
+        functions.emplace_back(Unicode::UTF16ToUTF8StringOrThrow(pFunctions[i]));
+      }
+
+      raw_istream_ostream Stream(pOutput);
+      IFC(dxcutil::Disassemble(pSource, Stream, sections, functions));
+    }
+    CATCH_CPP_ASSIGN_HRESULT();
+  Cleanup:
+    DxcEtw_DXCompilerDisassemble_Stop(hr);
+    return hr;
+  }
+
   void SetupCompilerForCompile(CompilerInstance &compiler,
                                _In_ DxcLangExtensionsHelper *helper,
                                _In_ LPCSTR pMainFile, _In_ TextDiagnosticPrinter *diagPrinter,
                                _In_ std::vector<std::string>& defines,
-                               _In_ hlsl::options::DxcOpts &Opts,
-                               _In_count_(argCount) LPCWSTR *pArguments,
-                               _In_ UINT32 argCount) {
+                               const hlsl::options::DxcOpts &Opts,
+                               const hlsl::options::MainArgs &mainArgs) {
     // Setup a compiler instance.
     std::shared_ptr<TargetOptions> targetOptions(new TargetOptions);
     targetOptions->Triple = "dxil-ms-dx";
@@ -745,7 +2502,11 @@ public:
     // Setup debug information.
     if (Opts.DebugInfo) {
       CodeGenOptions &CGOpts = compiler.getCodeGenOpts();
-      CGOpts.setDebugInfo(CodeGenOptions::FullDebugInfo);
+      // Line tables keep locations and function scopes, which is what
+      // crash triage needs, and skip the type and variable descriptions.
+      CGOpts.setDebugInfo(Opts.DebugInfoLineTablesOnly
+                              ? CodeGenOptions::DebugLineTablesOnly
+                              : CodeGenOptions::FullDebugInfo);
       CGOpts.DebugColumnInfo = 1;
       CGOpts.DwarfVersion = 4; // Latest version.
       // TODO: consider
@@ -756,6 +2517,11 @@ public:
     for (size_t i = 0; i < defines.size(); ++i) {
       PPOpts.addMacroDef(defines[i]);
     }
+    // Forced includes are resolved like #include "file" in the main file, so
+    // a shared prologue goes through the include handler (and include cache).
+    for (const llvm::opt::Arg *A : Opts.Args.filtered(options::OPT_include)) {
+      PPOpts.Includes.push_back(A->getValue());
+    }
 
     // Pick additional arguments.
     clang::HeaderSearchOptions &HSOpts = compiler.getHeaderSearchOpts();
@@ -789,6 +2555,7 @@ public:
     compiler.getLangOpts().HLSL2015 = Opts.HLSL2015;
     compiler.getLangOpts().HLSL2016 = Opts.HLSL2016;
     compiler.getLangOpts().HLSL2017 = Opts.HLSL2017;
+    compiler.getLangOpts().HLSLLazyFunctionBodies = Opts.LazyFunctionBodies;
 
     if (Opts.WarningAsError)
       compiler.getDiagnostics().setWarningsAsErrors(true);
@@ -804,7 +2571,45 @@ public:
       compiler.getCodeGenOpts().UnrollLoops = true;
 
     compiler.getCodeGenOpts().HLSLHighLevel = Opts.CodeGenHighLevel;
+    compiler.getCodeGenOpts().HLSLFastOpt = Opts.OptFast;
     compiler.getCodeGenOpts().HLSLAllResourcesBound = Opts.AllResourcesBound;
+    compiler.getCodeGenOpts().HLSLPairHalfOps = Opts.PairHalfOps;
+    compiler.getCodeGenOpts().HLSLHoistSamples = Opts.HoistSamples;
+    if (Opts.HoistSamples) {
+      // The count of moved samples is an optimization remark, only printed
+      // for passes matching the pattern.
+      compiler.getCodeGenOpts().OptimizationRemarkPattern =
+          std::make_shared<llvm::Regex>("^hlsl-dxil-hoist-samples$");
+      compiler.getDiagnostics().setSeverityForGroup(
+          diag::Flavor::Remark, "pass", diag::Severity::Remark);
+    }
+    compiler.getCodeGenOpts().HLSLDynamicIndexToSelect = Opts.DynamicIndexToSelect;
+    compiler.getCodeGenOpts().HLSLConstTableSelect = Opts.ConstTableSelect;
+    compiler.getCodeGenOpts().HLSLReportConstTables = Opts.ReportConstTables;
+    // The constant table and non-uniform handle passes report through
+    // analysis remarks, which are only printed for passes matching the
+    // pattern.
+    std::string analysisRemarks;
+    if (Opts.ReportConstTables)
+      analysisRemarks = "hlsl-dxil-constant-tables";
+    if (Opts.ReportNonUniformIndices) {
+      if (!analysisRemarks.empty())
+        analysisRemarks += "|";
+      analysisRemarks += "hlsl-dxil-non-uniform-handles";
+    }
+    if (!analysisRemarks.empty()) {
+      compiler.getCodeGenOpts().OptimizationRemarkAnalysisPattern =
+          std::make_shared<llvm::Regex>("^(" + analysisRemarks + ")$");
+      compiler.getDiagnostics().setSeverityForGroup(
+          diag::Flavor::Remark, "pass-analysis", diag::Severity::Remark);
+    }
+    compiler.getCodeGenOpts().HLSLFunctionBudget = Opts.FunctionBudget;
+    compiler.getCodeGenOpts().HLSLProfileInstrument = Opts.ProfileInstrument;
+    compiler.getCodeGenOpts().HLSLProfileRegions = Opts.ProfileRegions;
+    compiler.getCodeGenOpts().HLSLProfileUseFile = Opts.ProfileUseFile;
+    compiler.getCodeGenOpts().HLSLPackCBuffers = Opts.PackCBuffers;
+    compiler.getCodeGenOpts().HLSLRenderTargetMask = Opts.RenderTargetMask;
+    compiler.getCodeGenOpts().HLSLDepthWriteDisabled = Opts.NoDepthWrite;
     compiler.getCodeGenOpts().HLSLDefaultRowMajor = Opts.DefaultRowMajor;
     compiler.getCodeGenOpts().HLSLPreferControlFlow = Opts.PreferFlowControl;
     compiler.getCodeGenOpts().HLSLAvoidControlFlow = Opts.AvoidFlowControl;
@@ -820,13 +2625,10 @@ public:
     else
       compiler.getCodeGenOpts().HLSLSignaturePackingStrategy = (unsigned)DXIL::PackingStrategy::Default;
 
-    // Constructing vector of wide strings to pass in to codegen. Just passing
-    // in pArguments will expose ownership of memory to both CodeGenOptions and
-    // this caller, which can lead to unexpected behavior.
-    for (UINT32 i = 0; i != argCount; ++i) {
-      compiler.getCodeGenOpts().HLSLArguments.emplace_back(
-          Unicode::UTF16ToUTF8StringOrThrow(pArguments[i]));
-    }
+    // Copy the arguments that option reading already converted, so that
+    // CodeGenOptions owns its strings.
+    compiler.getCodeGenOpts().HLSLArguments.assign(
+        mainArgs.Utf8StringVector.begin(), mainArgs.Utf8StringVector.end());
     // Overrding default set of loop unroll.
     if (Opts.PreferFlowControl)
       compiler.getCodeGenOpts().UnrollLoops = false;
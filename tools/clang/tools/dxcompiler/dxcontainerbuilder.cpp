@@ -12,6 +12,7 @@
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.h"
 #include "dxc/HLSL/DxilContainer.h"
+#include "dxc/HLSL/DxilRootSignature.h"
 #include "dxc/Support/ErrorCodes.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/Global.h"
@@ -21,22 +22,32 @@
 
 #include <algorithm>
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace hlsl;
 
 // This declaration is used for the locally-linked validator.
 HRESULT CreateDxcValidator(_In_ REFIID riid, _Out_ LPVOID *ppv);
 
-class DxcContainerBuilder : public IDxcContainerBuilder {
+class DxcContainerBuilder : public IDxcContainerBuilder,
+                            public IDxcContainerBuilderBatch {
 public:
   __override HRESULT STDMETHODCALLTYPE Load(_In_ IDxcBlob *pDxilContainerHeader); // Loads DxilContainer to the builder
   __override HRESULT STDMETHODCALLTYPE AddPart(_In_ UINT32 fourCC, _In_ IDxcBlob *pSource); // Add the given part with fourCC
   __override HRESULT STDMETHODCALLTYPE RemovePart(_In_ UINT32 fourCC);                // Remove the part with fourCC
   __override HRESULT STDMETHODCALLTYPE SerializeContainer(_Out_ IDxcOperationResult **ppResult); // Builds a container of the given container builder state
 
+  // IDxcContainerBuilderBatch
+  __override HRESULT STDMETHODCALLTYPE AddRootSignatureToContainers(
+      _In_ IDxcBlob *pRootSignature, _In_ UINT32 containerCount,
+      _In_count_(containerCount) IDxcBlob **ppContainers,
+      _Out_writes_(containerCount) IDxcOperationResult **ppResults);
+
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcContainerBuilder>(this, riid, ppvObject);
+    return DoBasicQueryInterface<IDxcContainerBuilder,
+                                 IDxcContainerBuilderBatch>(this, riid,
+                                                            ppvObject);
   }
 
   DxcContainerBuilder(const char *warning) : m_dwRef(0), m_parts(), m_pContainer(), m_warning(warning), m_RequireValidation(false) {}
@@ -110,6 +121,7 @@ HRESULT STDMETHODCALLTYPE DxcContainerBuilder::AddPart(_In_ UINT32 fourCC, _In_
 HRESULT STDMETHODCALLTYPE DxcContainerBuilder::RemovePart(_In_ UINT32 fourCC) {
   try {
     IFTBOOL(fourCC == DxilFourCC::DFCC_ShaderDebugInfoDXIL ||
+                fourCC == DxilFourCC::DFCC_ShaderDebugInfoDXILCompressed ||
                 fourCC == DxilFourCC::DFCC_RootSignature ||
                 fourCC == DxilFourCC::DFCC_PrivateData,
             E_INVALIDARG); // You can only remove debug info, rootsignature, or private data blob
@@ -183,6 +195,128 @@ HRESULT STDMETHODCALLTYPE DxcContainerBuilder::SerializeContainer(_Out_ IDxcOper
   CATCH_CPP_RETURN_HRESULT();
 }
 
+// Writes the parts of pHeader, with pRootSignature in place of any existing
+// root signature part, into a stream reserved at the final container size.
+static void WriteContainerWithRootSignature(IMalloc *pMalloc,
+                                            const DxilContainerHeader *pHeader,
+                                            IDxcBlob *pRootSignature,
+                                            IDxcBlob **ppResult) {
+  llvm::SmallVector<const DxilPartHeader *, 8> parts;
+  uint32_t partsSize = pRootSignature->GetBufferSize();
+  for (DxilPartIterator it = begin(pHeader), itEnd = end(pHeader); it != itEnd; ++it) {
+    const DxilPartHeader *pPart = *it;
+    if (pPart->PartFourCC == DFCC_RootSignature)
+      continue;
+    parts.push_back(pPart);
+    partsSize += pPart->PartSize;
+  }
+  uint32_t partCount = parts.size() + 1;
+  uint32_t containerSize = GetDxilContainerSizeFromParts(partCount, partsSize);
+
+  CComPtr<AbstractMemoryStream> pStream;
+  IFT(CreateMemoryStream(pMalloc, &pStream));
+  IFT(pStream->Reserve(containerSize));
+
+  ULONG cbWritten;
+  DxilContainerHeader header;
+  InitDxilContainer(&header, partCount, containerSize);
+  IFT(pStream->Write(&header, sizeof(header), &cbWritten));
+  uint32_t offset = sizeof(DxilContainerHeader) + GetOffsetTableSize(partCount);
+  for (const DxilPartHeader *pPart : parts) {
+    IFT(pStream->Write(&offset, sizeof(offset), &cbWritten));
+    offset += sizeof(DxilPartHeader) + pPart->PartSize;
+  }
+  IFT(pStream->Write(&offset, sizeof(offset), &cbWritten));
+  for (const DxilPartHeader *pPart : parts) {
+    IFT(pStream->Write(pPart, sizeof(DxilPartHeader) + pPart->PartSize, &cbWritten));
+  }
+  DxilPartHeader rootSignatureHeader = { DFCC_RootSignature,
+                                         (uint32_t)pRootSignature->GetBufferSize() };
+  IFT(pStream->Write(&rootSignatureHeader, sizeof(rootSignatureHeader), &cbWritten));
+  IFT(pStream->Write(pRootSignature->GetBufferPointer(),
+                     pRootSignature->GetBufferSize(), &cbWritten));
+  IFT(pStream.QueryInterface(ppResult));
+}
+
+HRESULT STDMETHODCALLTYPE DxcContainerBuilder::AddRootSignatureToContainers(
+    _In_ IDxcBlob *pRootSignature, _In_ UINT32 containerCount,
+    _In_count_(containerCount) IDxcBlob **ppContainers,
+    _Out_writes_(containerCount) IDxcOperationResult **ppResults) {
+  if (pRootSignature == nullptr ||
+      (containerCount != 0 && (ppContainers == nullptr || ppResults == nullptr)))
+    return E_INVALIDARG;
+  for (UINT32 i = 0; i < containerCount; ++i)
+    ppResults[i] = nullptr;
+
+  RootSignatureHandle RSH;
+  try {
+    RSH.LoadSerialized((const uint8_t *)pRootSignature->GetBufferPointer(),
+                       pRootSignature->GetBufferSize());
+    RSH.Deserialize();
+  } catch (...) {
+    return DXC_E_INCORRECT_ROOT_SIGNATURE;
+  }
+
+  HRESULT hr = S_OK;
+  try {
+    CComPtr<IMalloc> pMalloc;
+    IFT(CoGetMalloc(1, &pMalloc));
+    for (UINT32 i = 0; i < containerCount; ++i) {
+      IDxcBlob *pContainer = ppContainers[i];
+      IFTARG(pContainer);
+      const DxilContainerHeader *pHeader = IsDxilContainerLike(
+          pContainer->GetBufferPointer(), pContainer->GetBufferSize());
+      IFTBOOL(pHeader != nullptr &&
+                  IsValidDxilContainer(pHeader, pContainer->GetBufferSize()),
+              DXC_E_CONTAINER_INVALID);
+
+      std::string diag(m_warning);
+      HRESULT status = S_OK;
+      const DxilProgramHeader *pProgramHeader =
+          GetDxilProgramHeader(pHeader, DFCC_DXIL);
+      const DxilPartHeader *pPSVPart =
+          GetDxilPartByType(pHeader, DFCC_PipelineStateValidation);
+      if (pProgramHeader == nullptr || pPSVPart == nullptr) {
+        status = DXC_E_MISSING_PART;
+      } else {
+        llvm::raw_string_ostream DiagStream(diag);
+        bool matches = false;
+        try {
+          matches = VerifyRootSignatureWithShaderPSV(
+              RSH.GetDesc(),
+              GetVersionShaderType(pProgramHeader->ProgramVersion),
+              GetDxilPartData(pPSVPart), pPSVPart->PartSize, DiagStream);
+        } catch (...) {
+        }
+        DiagStream.flush();
+        if (!matches)
+          status = DXC_E_INCORRECT_ROOT_SIGNATURE;
+      }
+
+      CComPtr<IDxcBlob> pResult;
+      if (SUCCEEDED(status))
+        WriteContainerWithRootSignature(pMalloc, pHeader, pRootSignature,
+                                        &pResult);
+      CComPtr<IDxcBlobEncoding> pErrorBlob;
+      IFT(DxcCreateBlobWithEncodingOnHeapCopy(diag.c_str(), diag.size(),
+                                              CP_UTF8, &pErrorBlob));
+      IFT(DxcOperationResult::CreateFromResultErrorStatus(
+          pResult, pErrorBlob, status, &ppResults[i]));
+    }
+  }
+  CATCH_CPP_ASSIGN_HRESULT();
+
+  if (FAILED(hr)) {
+    for (UINT32 i = 0; i < containerCount; ++i) {
+      if (ppResults[i] != nullptr) {
+        ppResults[i]->Release();
+        ppResults[i] = nullptr;
+      }
+    }
+  }
+  return hr;
+}
+
 UINT32 DxcContainerBuilder::ComputeContainerSize() {
   UINT32 partsSize = 0;
   for (DxilPart part : m_parts) {
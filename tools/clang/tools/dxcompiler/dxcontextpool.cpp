@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcontextpool.cpp                                                         //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements a pool of LLVM contexts reused by successive compilations.     //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxcontextpool.h"
+#include "dxc/HLSL/DxilOperations.h"
+#include "dxc/Support/LockTracing.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+
+namespace dxcutil {
+
+// Contexts keep the constants and unnamed types of every module they held,
+// so they are retired after this many compilations to bound their growth.
+static const unsigned kMaxContextUses = 64;
+
+static const hlsl::LockSite kContextPoolLockSite = {
+    "lock.contextPool.contended", "lock.contextPool.waitUs"};
+
+DxcContextPool::DxcContextPool(unsigned maxContexts)
+    : m_maxContexts(maxContexts) {
+  // Release runs from destructors; with the room reserved, keeping a context
+  // does not allocate.
+  m_idle.reserve(maxContexts);
+  llvm::LLVMContext context;
+  llvm::SmallVector<llvm::StringRef, 16> names;
+  context.getMDKindNames(names);
+  m_numMDKinds = (unsigned)names.size();
+}
+
+DxcContextPool::~DxcContextPool() {}
+
+DxcContextPool::PooledContext DxcContextPool::Acquire() {
+  {
+    hlsl::TracedLockGuard<std::mutex> lock(m_mutex, kContextPoolLockSite);
+    if (!m_idle.empty()) {
+      PooledContext context = std::move(m_idle.back());
+      m_idle.pop_back();
+      return context;
+    }
+  }
+  PooledContext context;
+  context.Context.reset(new llvm::LLVMContext());
+  context.UseCount = 0;
+  return context;
+}
+
+void DxcContextPool::Release(PooledContext context, bool reusable) {
+  if (!reusable || ++context.UseCount >= kMaxContextUses)
+    return;
+  try {
+    // Only the types of the DXIL operations keep their names; every other
+    // named type may have a different body in the next module.
+    if (!context.Context->resetForReuse(m_numMDKinds,
+                                        &hlsl::OP::IsDxilOpTypeName))
+      return;
+    hlsl::TracedLockGuard<std::mutex> lock(m_mutex, kContextPoolLockSite);
+    if (m_idle.size() < m_maxContexts)
+      m_idle.push_back(std::move(context));
+  } catch (...) {
+    // A context that could not be reset is destroyed with the argument.
+  }
+}
+
+DxcContextLease::DxcContextLease(DxcContextPool *pPool)
+    : m_pPool(pPool), m_reusable(false) {
+  if (m_pPool != nullptr) {
+    m_context = m_pPool->Acquire();
+  } else {
+    m_context.Context.reset(new llvm::LLVMContext());
+    m_context.UseCount = 0;
+  }
+}
+
+DxcContextLease::~DxcContextLease() {
+  if (m_pPool != nullptr)
+    m_pPool->Release(std::move(m_context), m_reusable);
+}
+
+} // namespace dxcutil
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcontextpool.h                                                           //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides a pool of LLVM contexts reused by successive compilations.       //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace llvm {
+class LLVMContext;
+}
+
+namespace dxcutil {
+
+/// Keeps the LLVM contexts of finished compilations so that later ones find
+/// the types every shader uses, including the DXIL operation types, already
+/// uniqued. A context is reset before it is reused, and it is only reused if
+/// the compilation that had it succeeded and left no module behind, so the
+/// output matches that of a compilation in a new context. Thread-safe.
+class DxcContextPool {
+public:
+  struct PooledContext {
+    std::unique_ptr<llvm::LLVMContext> Context;
+    unsigned UseCount; // Compilations the context has served.
+  };
+
+  /// Keeps at most maxContexts idle contexts.
+  explicit DxcContextPool(unsigned maxContexts);
+  ~DxcContextPool();
+
+  DxcContextPool(const DxcContextPool &) = delete;
+  DxcContextPool &operator=(const DxcContextPool &) = delete;
+
+  /// Returns an idle context, or a new one if there is none.
+  PooledContext Acquire();
+  /// Takes back a context from Acquire. It is destroyed rather than kept if
+  /// it is not reusable, cannot be reset, has served too many compilations
+  /// or the pool is full.
+  void Release(PooledContext context, bool reusable);
+
+private:
+  std::mutex m_mutex;
+  std::vector<PooledContext> m_idle; // Guarded by m_mutex.
+  unsigned m_maxContexts;
+  unsigned m_numMDKinds;             // Kinds registered by a new context.
+};
+
+/// Holds a context for one compilation: from the pool if there is one, or a
+/// new one otherwise. The context goes back to the pool on destruction if
+/// the compilation marked it reusable; declare the lease before anything
+/// that creates modules in the context so that they are gone by then.
+class DxcContextLease {
+public:
+  explicit DxcContextLease(DxcContextPool *pPool);
+  ~DxcContextLease();
+
+  DxcContextLease(const DxcContextLease &) = delete;
+  DxcContextLease &operator=(const DxcContextLease &) = delete;
+
+  llvm::LLVMContext &get() { return *m_context.Context; }
+  void SetReusable() { m_reusable = true; }
+
+private:
+  DxcContextPool *m_pPool;
+  DxcContextPool::PooledContext m_context;
+  bool m_reusable;
+};
+
+} // namespace dxcutil
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcthreadpool.cpp                                                         //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Implements a work-stealing thread pool for asynchronous compilation.      //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxcthreadpool.h"
+
+namespace dxcutil {
+
+DxcThreadPool::DxcThreadPool(unsigned threadCount)
+    : m_queuedCount(0), m_nextQueue(0), m_shutdown(false) {
+  if (threadCount == 0) {
+    threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+      threadCount = 1;
+  }
+  for (unsigned i = 0; i < threadCount; ++i)
+    m_queues.emplace_back(new WorkerQueue());
+  m_threads.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; ++i)
+    m_threads.emplace_back(&DxcThreadPool::WorkerMain, this, i);
+}
+
+DxcThreadPool::~DxcThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_shutdown = true;
+  }
+  m_wake.notify_all();
+  for (std::thread &t : m_threads)
+    t.join();
+}
+
+void DxcThreadPool::Enqueue(Task task) {
+  unsigned index;
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    index = m_nextQueue;
+    m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+  }
+  {
+    WorkerQueue &queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+    queue.Tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    ++m_queuedCount;
+  }
+  m_wake.notify_one();
+}
+
+bool DxcThreadPool::TryPop(unsigned index, Task &task) {
+  // Take the oldest task from our own queue first, then steal the newest
+  // task from the others so the owner keeps working in submission order.
+  {
+    WorkerQueue &own = *m_queues[index];
+    std::lock_guard<std::mutex> lock(own.Mutex);
+    if (!own.Tasks.empty()) {
+      task = std::move(own.Tasks.front());
+      own.Tasks.pop_front();
+      return true;
+    }
+  }
+  for (size_t i = 1, e = m_queues.size(); i < e; ++i) {
+    WorkerQueue &victim = *m_queues[(index + i) % e];
+    std::lock_guard<std::mutex> lock(victim.Mutex);
+    if (!victim.Tasks.empty()) {
+      task = std::move(victim.Tasks.back());
+      victim.Tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void DxcThreadPool::WorkerMain(unsigned index) {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_wakeMutex);
+      m_wake.wait(lock, [this] { return m_queuedCount > 0 || m_shutdown; });
+      if (m_queuedCount == 0)
+        return; // Shutting down with nothing left to run.
+    }
+
+    // Another worker may claim the task first; in that case wait again.
+    Task task;
+    if (!TryPop(index, task))
+      continue;
+    {
+      std::lock_guard<std::mutex> lock(m_wakeMutex);
+      --m_queuedCount;
+    }
+    task();
+  }
+}
+
+} // namespace dxcutil
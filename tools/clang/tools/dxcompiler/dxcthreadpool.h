@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcthreadpool.h                                                           //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides a work-stealing thread pool for asynchronous compilation.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dxcutil {
+
+/// Fixed-size pool of worker threads. Each worker owns a queue; tasks are
+/// distributed round-robin, and idle workers steal from the back of other
+/// queues. Tasks must not throw.
+class DxcThreadPool {
+public:
+  typedef std::function<void()> Task;
+
+  /// Creates threadCount workers, or one per hardware thread when zero.
+  explicit DxcThreadPool(unsigned threadCount = 0);
+  /// Runs every queued task to completion, then joins the workers.
+  ~DxcThreadPool();
+
+  DxcThreadPool(const DxcThreadPool &) = delete;
+  DxcThreadPool &operator=(const DxcThreadPool &) = delete;
+
+  void Enqueue(Task task);
+  unsigned GetThreadCount() const { return (unsigned)m_threads.size(); }
+
+private:
+  struct WorkerQueue {
+    std::mutex Mutex;
+    std::deque<Task> Tasks;
+  };
+
+  bool TryPop(unsigned index, Task &task);
+  void WorkerMain(unsigned index);
+
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+  std::vector<std::thread> m_threads;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  size_t m_queuedCount;   // Tasks pushed but not yet popped; guarded by m_wakeMutex.
+  unsigned m_nextQueue;   // Round-robin cursor; guarded by m_wakeMutex.
+  bool m_shutdown;        // Guarded by m_wakeMutex.
+};
+
+} // namespace dxcutil
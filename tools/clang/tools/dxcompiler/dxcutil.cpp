@@ -13,6 +13,7 @@
 
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/HLSL/DxilContainer.h"
+#include "dxc/HLSL/DxilValidation.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/Global.h"
 #include "dxc/dxcapi.h"
@@ -21,10 +22,18 @@
 #include "clang/Basic/Diagnostic.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/raw_ostream.h"
-#include "llvm/Transforms/Utils/Cloning.h"
 #include "dxc/Support/dxcapi.impl.h"
+#include "dxc/Support/PhaseTracing.h"
+#include "dxc/Support/LockTracing.h"
+#include "dxc/Support/MemoryTracking.h"
+#include "dxc/Support/TraceArchive.h"
+#include "dxc/Support/dxcfilesystem.h"
 
 #include "llvm/Support/Path.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
 
 using namespace llvm;
 using namespace hlsl;
@@ -38,6 +47,7 @@ HRESULT CreateDxcValidator(_In_ REFIID riid, _Out_ LPVOID *ppv);
 HRESULT RunInternalValidator(_In_ IDxcValidator *pValidator,
                              _In_ llvm::Module *pModule,
                              _In_ llvm::Module *pDebugModule,
+                             _In_opt_ hlsl::DxilValidationAnalyses *pAnalyses,
                              _In_ IDxcBlob *pShader, UINT32 Flags,
                              _In_ IDxcOperationResult **ppResult);
 
@@ -56,6 +66,91 @@ bool CreateValidator(CComPtr<IDxcValidator> &pValidator) {
   return bInternalValidator;
 }
 
+// Whether the validator comes from dxil.dll is settled by the first probe
+// and kept for the lifetime of the process, so the version and instances of
+// the validator can be kept as well. An instance is used by one validation
+// at a time; idle instances wait here for the next one instead of being
+// created again.
+class ValidatorCache {
+public:
+  bool Acquire(CComPtr<IDxcValidator> &pValidator) {
+    {
+      hlsl::TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+      if (!m_idle.empty()) {
+        pValidator.Attach(m_idle.back().first.Detach());
+        bool bInternalValidator = m_idle.back().second;
+        m_idle.pop_back();
+        return bInternalValidator;
+      }
+    }
+    return CreateValidator(pValidator);
+  }
+  void Return(CComPtr<IDxcValidator> &pValidator, bool bInternalValidator) {
+    if (pValidator == nullptr)
+      return;
+    hlsl::TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+    m_idle.emplace_back(CComPtr<IDxcValidator>(), bInternalValidator);
+    m_idle.back().first.Attach(pValidator.Detach());
+  }
+  void GetVersion(unsigned *pMajor, unsigned *pMinor);
+  void Clear(bool bProcessTermination) {
+    hlsl::TracedLockGuard<std::mutex> lock(m_mutex, kLockSite);
+    // On process termination dxil.dll may already be gone; leak instead.
+    if (bProcessTermination) {
+      for (auto &idle : m_idle)
+        idle.first.Detach();
+    }
+    m_idle.clear();
+  }
+
+private:
+  static const hlsl::LockSite kLockSite;
+  std::mutex m_mutex;
+  std::vector<std::pair<CComPtr<IDxcValidator>, bool>> m_idle;
+  std::once_flag m_versionFlag;
+  unsigned m_major = 1;
+  unsigned m_minor = 0;
+};
+
+const hlsl::LockSite ValidatorCache::kLockSite = {
+    "lock.validatorCache.contended", "lock.validatorCache.waitUs"};
+
+ValidatorCache g_ValidatorCache;
+
+// Borrows a validator from the cache for the lifetime of the object.
+class CachedValidator {
+public:
+  CachedValidator() {
+    m_bInternalValidator = g_ValidatorCache.Acquire(m_pValidator);
+  }
+  ~CachedValidator() {
+    g_ValidatorCache.Return(m_pValidator, m_bInternalValidator);
+  }
+  IDxcValidator *get() const { return m_pValidator; }
+  bool IsInternal() const { return m_bInternalValidator; }
+
+private:
+  CComPtr<IDxcValidator> m_pValidator;
+  bool m_bInternalValidator;
+};
+
+void ValidatorCache::GetVersion(unsigned *pMajor, unsigned *pMinor) {
+  std::call_once(m_versionFlag, [this]() {
+    CachedValidator validator;
+    CComPtr<IDxcVersionInfo> pVersionInfo;
+    // Defaults to 1.0 for validators without version information.
+    if (SUCCEEDED(
+            validator.get()->QueryInterface(IID_PPV_ARGS(&pVersionInfo)))) {
+      UINT32 major, minor;
+      IFT(pVersionInfo->GetVersion(&major, &minor));
+      m_major = major;
+      m_minor = minor;
+    }
+  });
+  *pMajor = m_major;
+  *pMinor = m_minor;
+}
+
 // Class to manage lifetime of llvm module and provide some utility
 // functions used for generating compiler output.
 class DxilCompilerLLVMModuleOutput {
@@ -63,10 +158,6 @@ public:
   DxilCompilerLLVMModuleOutput(std::unique_ptr<llvm::Module> module)
       : m_llvmModule(std::move(module)) {}
 
-  void CloneForDebugInfo() {
-    m_llvmModuleWithDebugInfo.reset(llvm::CloneModule(m_llvmModule.get()));
-  }
-
   void WrapModuleInDxilContainer(IMalloc *pMalloc,
                                  AbstractMemoryStream *pModuleBitcode,
                                  CComPtr<IDxcBlob> &pDxilContainerBlob,
@@ -81,11 +172,9 @@ public:
   }
 
   llvm::Module *get() { return m_llvmModule.get(); }
-  llvm::Module *getWithDebugInfo() { return m_llvmModuleWithDebugInfo.get(); }
 
 private:
   std::unique_ptr<llvm::Module> m_llvmModule;
-  std::unique_ptr<llvm::Module> m_llvmModuleWithDebugInfo;
 };
 
 } // namespace
@@ -95,17 +184,11 @@ void GetValidatorVersion(unsigned *pMajor, unsigned *pMinor) {
   if (pMajor == nullptr || pMinor == nullptr)
     return;
 
-  CComPtr<IDxcValidator> pValidator;
-  CreateValidator(pValidator);
+  g_ValidatorCache.GetVersion(pMajor, pMinor);
+}
 
-  CComPtr<IDxcVersionInfo> pVersionInfo;
-  if (SUCCEEDED(pValidator.QueryInterface(&pVersionInfo))) {
-    IFT(pVersionInfo->GetVersion(pMajor, pMinor));
-  } else {
-    // Default to 1.0
-    *pMajor = 1;
-    *pMinor = 0;
-  }
+void ReleaseCachedValidators(bool bProcessTermination) {
+  g_ValidatorCache.Clear(bProcessTermination);
 }
 
 void AssembleToContainer(std::unique_ptr<llvm::Module> pM,
@@ -130,26 +213,37 @@ HRESULT ValidateAndAssembleToContainer(
   // Take ownership of the module from the action.
   DxilCompilerLLVMModuleOutput llvmModule(std::move(pM));
 
-  CComPtr<IDxcValidator> pValidator;
-  bool bInternalValidator = CreateValidator(pValidator);
-  // If using the internal validator, we'll use the modules directly.
-  // In this case, we'll want to make a clone to avoid
-  // SerializeDxilContainerForModule stripping all the debug info. The debug
-  // info will be stripped from the orginal module, but preserved in the cloned
-  // module.
-  if (bInternalValidator && bDebugInfo)
-    llvmModule.CloneForDebugInfo();
+  CachedValidator validator;
+  IDxcValidator *pValidator = validator.get();
+  bool bInternalValidator = validator.IsInternal();
 
-  llvmModule.WrapModuleInDxilContainer(pMalloc, pOutputStream, pOutputBlob,
-                                       SerializeFlags);
+  {
+    hlsl::PhaseSpan serializeSpan("SerializeDxilContainer");
+    llvmModule.WrapModuleInDxilContainer(pMalloc, pOutputStream, pOutputBlob,
+                                         SerializeFlags);
+  }
 
   CComPtr<IDxcOperationResult> pValResult;
+  hlsl::PhaseSpan validateSpan("Validate");
   // Important: in-place edit is required so the blob is reused and thus
   // dxil.dll can be released.
   if (bInternalValidator) {
-    IFT(RunInternalValidator(pValidator, llvmModule.get(),
-                             llvmModule.getWithDebugInfo(), pOutputBlob,
-                             DxcValidatorFlags_InPlaceEdit, &pValResult));
+    // SerializeDxilContainerForModule has stripped the debug info from the
+    // module in place, after writing it to the debug part. Validate the
+    // stripped module directly, and only when it fails validate the container
+    // again so the debug part is loaded and errors carry source locations.
+    // The analyses are built for the stripped module once, however many
+    // checks need them.
+    hlsl::DxilValidationAnalyses Analyses(*llvmModule.get());
+    IFT(RunInternalValidator(pValidator, llvmModule.get(), nullptr, &Analyses,
+                             pOutputBlob, DxcValidatorFlags_InPlaceEdit,
+                             &pValResult));
+    IFT(pValResult->GetStatus(&valHR));
+    if (FAILED(valHR) && bDebugInfo) {
+      pValResult.Release();
+      IFT(pValidator->Validate(pOutputBlob, DxcValidatorFlags_InPlaceEdit,
+                               &pValResult));
+    }
   } else {
     IFT(pValidator->Validate(pOutputBlob, DxcValidatorFlags_InPlaceEdit,
                              &pValResult));
@@ -171,7 +265,6 @@ HRESULT ValidateAndAssembleToContainer(
   if (pValidatedBlob != nullptr) {
     std::swap(pOutputBlob, pValidatedBlob);
   }
-  pValidator.Release();
 
   return valHR;
 }
@@ -212,4 +305,168 @@ bool IsAbsoluteOrCurDirRelative(const Twine &T) {
   return false;
 }
 
-} // namespace dxcutil
\ No newline at end of file
+MemoryAccountingScope::MemoryAccountingScope(
+    const MemoryAccounting &settings) {
+  if (settings.Enabled) {
+    m_pTracker.reset(new MemoryTracker(settings.LimitBytes));
+    m_pScope.reset(new MemoryTrackerScope(m_pTracker.get()));
+  }
+}
+
+MemoryAccountingScope::~MemoryAccountingScope() {}
+
+HRESULT MemoryAccountingScope::Finish(HRESULT hr,
+                                      IDxcOperationResult **ppResult) {
+  if (m_pTracker == nullptr)
+    return hr;
+  // Uninstall the tracker before building the result, so that doing so is
+  // not refused as well.
+  m_pScope.reset();
+  if (m_pTracker->IsLimitExceeded()) {
+    if (*ppResult != nullptr) {
+      (*ppResult)->Release();
+      *ppResult = nullptr;
+    }
+    std::string errors = "error: the operation exceeded its memory limit of " +
+                         std::to_string(m_pTracker->GetLimitBytes()) +
+                         " bytes.\n";
+    CComPtr<IDxcBlobEncoding> pErrorBlob;
+    IFR(DxcCreateBlobWithEncodingOnHeapCopy(errors.c_str(), errors.size(),
+                                            CP_UTF8, &pErrorBlob));
+    IFR(DxcOperationResult::CreateFromResultErrorStatus(
+        nullptr, pErrorBlob, E_OUTOFMEMORY, ppResult));
+    hr = S_OK;
+  }
+  if (SUCCEEDED(hr) && *ppResult != nullptr) {
+    DxcOperationResult *pResult = static_cast<DxcOperationResult *>(*ppResult);
+    pResult->m_memoryCounted = true;
+    pResult->m_peakBytes = m_pTracker->GetPeakBytes();
+    pResult->m_totalBytes = m_pTracker->GetTotalBytes();
+  }
+  return hr;
+}
+
+// Returns the directory calls are recorded into, or an empty string. The
+// environment is read once per process.
+static const std::wstring &GetTraceRecordDirectory() {
+  static const std::wstring directory = []() {
+    wchar_t buffer[MAX_PATH];
+    DWORD length = GetEnvironmentVariableW(TraceRecordEnvVar, buffer,
+                                           _countof(buffer));
+    return std::wstring(buffer, length < _countof(buffer) ? length : 0);
+  }();
+  return directory;
+}
+
+static UINT64 GetSteadyTicksUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void SetTraceCallRequest(TraceCall &call, LPCWSTR pSourceName,
+                         LPCWSTR pEntryPoint, LPCWSTR pTargetProfile,
+                         LPCWSTR *pArguments, UINT32 argCount,
+                         const DxcDefine *pDefines, UINT32 defineCount) {
+  call.HasSourceName = pSourceName != nullptr;
+  if (pSourceName != nullptr)
+    call.SourceName = pSourceName;
+  call.EntryPoint = pEntryPoint;
+  call.TargetProfile = pTargetProfile;
+  call.Arguments.assign(pArguments, pArguments + argCount);
+  call.Defines.clear();
+  for (UINT32 i = 0; i < defineCount; ++i) {
+    TraceCall::Define define;
+    define.Name = pDefines[i].Name;
+    define.HasValue = pDefines[i].Value != nullptr;
+    if (define.HasValue)
+      define.Value = pDefines[i].Value;
+    call.Defines.push_back(std::move(define));
+  }
+}
+
+void SetTraceCallIncludes(TraceCall &call, DxcArgsFileSystem *pFileSystem) {
+  std::vector<std::pair<std::wstring, CComPtr<IDxcBlob>>> files;
+  pFileSystem->GetIncludedFiles(files);
+  call.Includes.clear();
+  for (auto &file : files) {
+    TraceCall::Include include;
+    include.Name = std::move(file.first);
+    include.Contents.assign((const char *)file.second->GetBufferPointer(),
+                            file.second->GetBufferSize());
+    call.Includes.push_back(std::move(include));
+  }
+}
+
+bool TraceRecording::IsRecordingEnabled() {
+  return !GetTraceRecordDirectory().empty();
+}
+
+TraceRecording::TraceRecording(LPCWSTR pSourceName, LPCWSTR pEntryPoint,
+                               LPCWSTR pTargetProfile, LPCWSTR *pArguments,
+                               UINT32 argCount, const DxcDefine *pDefines,
+                               UINT32 defineCount)
+    : m_startTicks(0) {
+  if (GetTraceRecordDirectory().empty())
+    return;
+  try {
+    std::unique_ptr<TraceCall> pCall(new TraceCall());
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    pCall->StartTime = ((UINT64)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    SetTraceCallRequest(*pCall, pSourceName, pEntryPoint, pTargetProfile,
+                        pArguments, argCount, pDefines, defineCount);
+    m_pCall = std::move(pCall);
+    m_startTicks = GetSteadyTicksUs();
+  } catch (...) {
+    m_pCall.reset();
+  }
+}
+
+TraceRecording::~TraceRecording() {}
+
+void TraceRecording::SetSource(IDxcBlob *pUtf8Source) {
+  if (m_pCall == nullptr)
+    return;
+  try {
+    m_pCall->Source.assign((const char *)pUtf8Source->GetBufferPointer(),
+                           pUtf8Source->GetBufferSize());
+  } catch (...) {
+    m_pCall.reset();
+  }
+}
+
+void TraceRecording::SetIncludes(DxcArgsFileSystem *pFileSystem) {
+  if (m_pCall == nullptr)
+    return;
+  try {
+    SetTraceCallIncludes(*m_pCall, pFileSystem);
+  } catch (...) {
+    m_pCall.reset();
+  }
+}
+
+void TraceRecording::Finish(HRESULT hr, IDxcOperationResult *pResult) {
+  if (m_pCall == nullptr)
+    return;
+  m_pCall->DurationUs = GetSteadyTicksUs() - m_startTicks;
+  m_pCall->Status = hr;
+  if (SUCCEEDED(hr) && pResult != nullptr)
+    pResult->GetStatus(&m_pCall->Status);
+
+  // Processes of a build record side by side, each numbering its calls.
+  static std::atomic<unsigned> s_nextCall(0);
+  try {
+    std::string data;
+    SerializeTraceCall(*m_pCall, data);
+    std::wstring fileName = GetTraceRecordDirectory() + L"\\" +
+                            std::to_wstring(GetCurrentProcessId()) + L"-" +
+                            std::to_wstring(s_nextCall++) + TraceFileExtension;
+    WriteBinaryFile(fileName.c_str(), data.data(), (DWORD)data.size());
+  } catch (...) {
+    // The call is not recorded.
+  }
+  m_pCall.reset();
+}
+
+} // namespace dxcutil
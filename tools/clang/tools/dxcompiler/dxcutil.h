@@ -14,7 +14,9 @@
 
 #include "dxc/dxcapi.h"
 #include "dxc/Support/microcom.h"
+#include "llvm/ADT/ArrayRef.h"
 #include <memory>
+#include <string>
 
 namespace clang {
 class DiagnosticsEngine;
@@ -22,13 +24,16 @@ class DiagnosticsEngine;
 
 namespace llvm {
 class Module;
-class raw_string_ostream;
+class raw_ostream;
 class Twine;
 } // namespace llvm
 
 namespace hlsl {
 enum class SerializeDxilFlags : uint32_t;
 class AbstractMemoryStream;
+class MemoryTracker;
+class MemoryTrackerScope;
+struct TraceCall;
 }
 
 
@@ -38,13 +43,22 @@ HRESULT ValidateAndAssembleToContainer(
     CComPtr<IMalloc> &pMalloc, hlsl::SerializeDxilFlags SerializeFlags,
     CComPtr<hlsl::AbstractMemoryStream> &pModuleBitcode, bool bDebugInfo,
     clang::DiagnosticsEngine &Diag);
+// Returns the version of the validator compilations are validated with; it
+// is queried once per process.
 void GetValidatorVersion(unsigned *pMajor, unsigned *pMinor);
+// Releases the validators kept between validations, before dxil.dll is
+// unloaded. On process termination they are abandoned instead.
+void ReleaseCachedValidators(bool bProcessTermination);
 void AssembleToContainer(std::unique_ptr<llvm::Module> pM,
                          CComPtr<IDxcBlob> &pOutputContainerBlob,
                          CComPtr<IMalloc> &pMalloc,
                          hlsl::SerializeDxilFlags SerializeFlags,
                          CComPtr<hlsl::AbstractMemoryStream> &pModuleBitcode);
-HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_string_ostream &Stream);
+// Writes the sections selected by DxcDisassembleSection_* flags; when
+// Functions is not empty, the module section lists only those definitions.
+HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_ostream &Stream,
+                    UINT32 Sections = DxcDisassembleSection_All,
+                    llvm::ArrayRef<std::string> Functions = llvm::None);
 
 void CreateOperationResultFromOutputs(
     IDxcBlob *pResultBlob, CComPtr<IStream> &pErrorStream,
@@ -53,4 +67,64 @@ void CreateOperationResultFromOutputs(
 
 bool IsAbsoluteOrCurDirRelative(const llvm::Twine &T);
 
+// Memory accounting settings of a compiler, linker or validator, set through
+// IDxcMemoryAccounting.
+struct MemoryAccounting {
+  MemoryAccounting() : Enabled(false), LimitBytes(0) {}
+  bool Enabled;
+  UINT64 LimitBytes;
+};
+
+// Counts the memory of an operation on this thread from construction until
+// Finish, if accounting is enabled.
+class MemoryAccountingScope {
+public:
+  explicit MemoryAccountingScope(const MemoryAccounting &settings);
+  ~MemoryAccountingScope();
+  // Stops counting. If the limit was exceeded, replaces the outcome of the
+  // operation with a result failed with E_OUTOFMEMORY; otherwise records the
+  // usage on *ppResult, which must be a DxcOperationResult if set.
+  HRESULT Finish(HRESULT hr, _Inout_ IDxcOperationResult **ppResult);
+
+private:
+  std::unique_ptr<hlsl::MemoryTracker> m_pTracker;
+  std::unique_ptr<hlsl::MemoryTrackerScope> m_pScope;
+};
+
+class DxcArgsFileSystem;
+
+// Sets the fields of call from the source name to the defines. Throws on
+// allocation failure.
+void SetTraceCallRequest(hlsl::TraceCall &call, LPCWSTR pSourceName,
+                         LPCWSTR pEntryPoint, LPCWSTR pTargetProfile,
+                         LPCWSTR *pArguments, UINT32 argCount,
+                         const DxcDefine *pDefines, UINT32 defineCount);
+// Sets the includes of call to the files served through pFileSystem so far.
+// Throws on allocation failure.
+void SetTraceCallIncludes(hlsl::TraceCall &call,
+                          DxcArgsFileSystem *pFileSystem);
+
+// Records a compile call into the directory named by the DXC_TRACE_RECORD
+// environment variable, if it is set, for replay with dxreplay. Recording
+// never fails the call; a call that cannot be written is not recorded.
+class TraceRecording {
+public:
+  TraceRecording(LPCWSTR pSourceName, LPCWSTR pEntryPoint,
+                 LPCWSTR pTargetProfile, LPCWSTR *pArguments, UINT32 argCount,
+                 const DxcDefine *pDefines, UINT32 defineCount);
+  ~TraceRecording();
+  // Whether calls are recorded at all, before one is started.
+  static bool IsRecordingEnabled();
+  bool IsEnabled() const { return m_pCall != nullptr; }
+  void SetSource(IDxcBlob *pUtf8Source);
+  // Takes the files served to the compilation so far.
+  void SetIncludes(DxcArgsFileSystem *pFileSystem);
+  // Writes the call with its outcome.
+  void Finish(HRESULT hr, IDxcOperationResult *pResult);
+
+private:
+  std::unique_ptr<hlsl::TraceCall> m_pCall;
+  UINT64 m_startTicks;
+};
+
 } // namespace dxcutil
\ No newline at end of file
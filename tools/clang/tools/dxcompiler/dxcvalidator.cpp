@@ -12,6 +12,7 @@
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/Support/MD5.h"
 
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/HLSL/DxilContainer.h"
@@ -23,8 +24,13 @@
 #include "dxc/Support/microcom.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/dxcapi.impl.h"
+#include "dxc/Support/MemoryTracking.h"
 #include "dxc/HLSL/DxilRootSignature.h"
 #include "dxcetw.h"
+#include "dxcutil.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
 
 using namespace llvm;
 using namespace hlsl;
@@ -46,7 +52,82 @@ struct DiagRestore {
   }
 };
 
-class DxcValidator : public IDxcValidator, public IDxcVersionInfo {
+namespace {
+// Verdicts of module validation, shared by every validator in the process
+// once enabled. Only modules that pass are recorded, so failing programs are
+// always validated again and report their diagnostics.
+class ValidationCache {
+private:
+  static const size_t kMaxEntries = 4096;
+  std::atomic<bool> m_enabled;
+  std::mutex m_mutex;
+  std::unordered_set<std::string> m_passed;
+
+public:
+  ValidationCache() : m_enabled(false) {}
+
+  static ValidationCache &Get() {
+    static ValidationCache cache;
+    return cache;
+  }
+
+  bool IsEnabled() const { return m_enabled; }
+
+  void SetEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = enabled;
+    if (!enabled)
+      m_passed.clear();
+  }
+
+  bool Contains(const std::string &key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_passed.count(key) != 0;
+  }
+
+  void Insert(const std::string &key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_passed.size() >= kMaxEntries)
+      m_passed.clear();
+    m_passed.insert(key);
+  }
+};
+}
+
+// Hashes the DXIL part (or the bitcode, for module-only validation) with the
+// validator version and flags. Returns an empty key when the shader has no
+// DXIL part; container validation reports that.
+static std::string ComputeValidationCacheKey(IDxcBlob *pShader, UINT32 Flags) {
+  const void *pData = pShader->GetBufferPointer();
+  size_t dataSize = pShader->GetBufferSize();
+  if (!(Flags & DxcValidatorFlags_ModuleOnly)) {
+    const DxilContainerHeader *pContainer =
+        IsDxilContainerLike(pData, dataSize);
+    const DxilPartHeader *pPart =
+        pContainer ? GetDxilPartByType(pContainer, DFCC_DXIL) : nullptr;
+    if (pPart == nullptr)
+      return std::string();
+    pData = GetDxilPartData(pPart);
+    dataSize = pPart->PartSize;
+  }
+
+  unsigned valMajor, valMinor;
+  GetValidationVersion(&valMajor, &valMinor);
+  const UINT32 header[] = { valMajor, valMinor, Flags };
+
+  llvm::MD5 md5;
+  md5.update(ArrayRef<uint8_t>((const uint8_t *)header, sizeof(header)));
+  md5.update(ArrayRef<uint8_t>((const uint8_t *)pData, dataSize));
+  llvm::MD5::MD5Result md5Result;
+  md5.final(md5Result);
+  return std::string((const char *)md5Result, sizeof(md5Result));
+}
+
+class DxcValidator : public IDxcValidator, public IDxcVersionInfo,
+                     public IDxcValidatorCaching,
+                     public IDxcValidatorDiagnostics,
+                     public IDxcRootSignatureCompatibility,
+                     public IDxcMemoryAccounting {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
 
@@ -55,18 +136,36 @@ private:
     _In_ UINT32 Flags,                            // Validation flags.
     _In_ llvm::Module *pModule,                   // Module to validate, if available.
     _In_ llvm::Module *pDebugModule,              // Debug module to validate, if available
-    _In_ AbstractMemoryStream *pDiagStream);
+    _In_opt_ DxilValidationAnalyses *pAnalyses,   // Analyses of pModule to reuse, if available
+    _In_ llvm::raw_ostream &DiagStream);
 
   HRESULT RunRootSignatureValidation(
     _In_ IDxcBlob *pShader,                       // Shader to validate.
-    _In_ AbstractMemoryStream *pDiagStream);
+    _In_ llvm::raw_ostream &DiagStream);
+
+  // Runs the validation selected by Flags and returns its status; throws
+  // only when validation could not be performed.
+  HRESULT ValidateToOStream(
+    _In_ IDxcBlob *pShader,
+    _In_ UINT32 Flags,
+    _In_ llvm::Module *pModule,
+    _In_ llvm::Module *pDebugModule,
+    _In_opt_ DxilValidationAnalyses *pAnalyses,
+    _In_ llvm::raw_ostream &DiagStream);
+
+  UINT32 m_MaxErrors;
+  dxcutil::MemoryAccounting m_MemoryAccounting;
 
 public:
   DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
-  DxcValidator() : m_dwRef(0) {}
+  DxcValidator() : m_dwRef(0), m_MaxErrors(0) {}
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcValidator, IDxcVersionInfo>(this, iid, ppvObject);
+    return DoBasicQueryInterface<IDxcValidator, IDxcVersionInfo,
+                                 IDxcValidatorCaching,
+                                 IDxcValidatorDiagnostics,
+                                 IDxcRootSignatureCompatibility,
+                                 IDxcMemoryAccounting>(this, iid, ppvObject);
   }
 
   // For internal use only.
@@ -75,6 +174,7 @@ public:
     _In_ UINT32 Flags,                            // Validation flags.
     _In_ llvm::Module *pModule,                   // Module to validate, if available.
     _In_ llvm::Module *pDebugModule,              // Debug module to validate, if available
+    _In_opt_ DxilValidationAnalyses *pAnalyses,   // Analyses of pModule to reuse, if available
     _COM_Outptr_ IDxcOperationResult **ppResult   // Validation output status, buffer, and errors
   );
 
@@ -88,6 +188,40 @@ public:
   // IDxcVersionInfo
   __override HRESULT STDMETHODCALLTYPE GetVersion(_Out_ UINT32 *pMajor, _Out_ UINT32 *pMinor);
   __override HRESULT STDMETHODCALLTYPE GetFlags(_Out_ UINT32 *pFlags);
+
+  // IDxcValidatorCaching
+  __override HRESULT STDMETHODCALLTYPE SetValidationCacheEnabled(BOOL enabled) {
+    ValidationCache::Get().SetEnabled(enabled != FALSE);
+    return S_OK;
+  }
+
+  // IDxcValidatorDiagnostics
+  __override HRESULT STDMETHODCALLTYPE SetMaxErrors(UINT32 maxErrors) {
+    m_MaxErrors = maxErrors;
+    return S_OK;
+  }
+  __override HRESULT STDMETHODCALLTYPE ValidateToStream(
+    _In_ IDxcBlob *pShader,                       // Shader to validate.
+    _In_ UINT32 Flags,                            // Validation flags.
+    _In_ IStream *pDiagStream,                    // Receives diagnostic text (UTF-8).
+    _Out_ HRESULT *pStatus                        // Validation status.
+    );
+
+  // IDxcRootSignatureCompatibility
+  __override HRESULT STDMETHODCALLTYPE CheckRootSignatureCompatibility(
+    _In_ UINT32 rootSignatureCount,
+    _In_count_(rootSignatureCount) IDxcBlob **ppRootSignatures,
+    _In_ UINT32 shaderCount,
+    _In_count_(shaderCount) IDxcBlob **ppShaders,
+    _Out_writes_(rootSignatureCount * shaderCount) UINT32 *pReasons);
+
+  // IDxcMemoryAccounting. Applies to Validate; ValidateToStream has no
+  // result to report the usage on.
+  __override HRESULT STDMETHODCALLTYPE SetMemoryAccounting(BOOL enabled, UINT64 limitBytes) {
+    m_MemoryAccounting.Enabled = enabled != FALSE;
+    m_MemoryAccounting.LimitBytes = limitBytes;
+    return S_OK;
+  }
 };
 
 // Compile a single entry point to the target shader model
@@ -100,7 +234,61 @@ HRESULT STDMETHODCALLTYPE DxcValidator::Validate(
     return E_INVALIDARG;
   if ((Flags & DxcValidatorFlags_ModuleOnly) && (Flags & (DxcValidatorFlags_InPlaceEdit | DxcValidatorFlags_RootSignatureOnly)))
     return E_INVALIDARG;
-  return ValidateWithOptModules(pShader, Flags, nullptr, nullptr, ppResult);
+  if ((Flags & DxcValidatorFlags_StructuralOnly) && (Flags & (DxcValidatorFlags_ModuleOnly | DxcValidatorFlags_RootSignatureOnly)))
+    return E_INVALIDARG;
+  return ValidateWithOptModules(pShader, Flags, nullptr, nullptr, nullptr, ppResult);
+}
+
+HRESULT STDMETHODCALLTYPE DxcValidator::ValidateToStream(
+  _In_ IDxcBlob *pShader,                       // Shader to validate.
+  _In_ UINT32 Flags,                            // Validation flags.
+  _In_ IStream *pDiagStream,                    // Receives diagnostic text (UTF-8).
+  _Out_ HRESULT *pStatus                        // Validation status.
+) {
+  if (pShader == nullptr || pDiagStream == nullptr || pStatus == nullptr ||
+      Flags & ~DxcValidatorFlags_ValidMask)
+    return E_INVALIDARG;
+  if ((Flags & DxcValidatorFlags_ModuleOnly) && (Flags & (DxcValidatorFlags_InPlaceEdit | DxcValidatorFlags_RootSignatureOnly)))
+    return E_INVALIDARG;
+  if ((Flags & DxcValidatorFlags_StructuralOnly) && (Flags & (DxcValidatorFlags_ModuleOnly | DxcValidatorFlags_RootSignatureOnly)))
+    return E_INVALIDARG;
+  *pStatus = S_OK;
+  HRESULT hr = S_OK;
+  HRESULT validationStatus = S_OK;
+  DxcEtw_DxcValidation_Start();
+  try {
+    raw_istream_ostream DiagStream(pDiagStream);
+    validationStatus =
+        ValidateToOStream(pShader, Flags, nullptr, nullptr, nullptr, DiagStream);
+    *pStatus = validationStatus;
+  }
+  CATCH_CPP_ASSIGN_HRESULT();
+
+  DxcEtw_DxcValidation_Stop(SUCCEEDED(hr) ? validationStatus : hr);
+  return hr;
+}
+
+HRESULT DxcValidator::ValidateToOStream(
+  _In_ IDxcBlob *pShader,
+  _In_ UINT32 Flags,
+  _In_ llvm::Module *pModule,
+  _In_ llvm::Module *pDebugModule,
+  _In_opt_ DxilValidationAnalyses *pAnalyses,
+  _In_ llvm::raw_ostream &DiagStream) {
+  // Run validation may throw, but that indicates an inability to validate,
+  // not that the validation failed (eg out of memory).
+  HRESULT validationStatus;
+  if (Flags & DxcValidatorFlags_RootSignatureOnly) {
+    validationStatus = RunRootSignatureValidation(pShader, DiagStream);
+  } else {
+    validationStatus = RunValidation(pShader, Flags, pModule, pDebugModule,
+                                     pAnalyses, DiagStream);
+  }
+  if (FAILED(validationStatus)) {
+    DiagStream << "Validation failed.\n";
+  }
+  DiagStream.flush();
+  return validationStatus;
 }
 
 HRESULT DxcValidator::ValidateWithOptModules(
@@ -108,29 +296,24 @@ HRESULT DxcValidator::ValidateWithOptModules(
   _In_ UINT32 Flags,                            // Validation flags.
   _In_ llvm::Module *pModule,                   // Module to validate, if available.
   _In_ llvm::Module *pDebugModule,              // Debug module to validate, if available
+  _In_opt_ DxilValidationAnalyses *pAnalyses,   // Analyses of pModule to reuse, if available
   _COM_Outptr_ IDxcOperationResult **ppResult   // Validation output status, buffer, and errors
 ) {
   *ppResult = nullptr;
   HRESULT hr = S_OK;
   HRESULT validationStatus = S_OK;
   DxcEtw_DxcValidation_Start();
+  dxcutil::MemoryAccountingScope memoryScope(m_MemoryAccounting);
   try {
     CComPtr<IMalloc> pMalloc;
     CComPtr<AbstractMemoryStream> pDiagStream;
-    IFT(CoGetMalloc(1, &pMalloc));
+    IFT(DxcGetOperationMalloc(&pMalloc));
     IFT(CreateMemoryStream(pMalloc, &pDiagStream));
 
-    // Run validation may throw, but that indicates an inability to validate,
-    // not that the validation failed (eg out of memory).
-    if (Flags & DxcValidatorFlags_RootSignatureOnly) {
-      validationStatus = RunRootSignatureValidation(pShader, pDiagStream);
-    } else {
-      validationStatus = RunValidation(pShader, Flags, pModule, pDebugModule, pDiagStream);
-    }
-    if (FAILED(validationStatus)) {
-      std::string msg("Validation failed.\n");
-      ULONG cbWritten;
-      pDiagStream->Write(msg.c_str(), msg.size(), &cbWritten);
+    {
+      raw_stream_ostream DiagStream(pDiagStream);
+      validationStatus = ValidateToOStream(pShader, Flags, pModule,
+                                           pDebugModule, pAnalyses, DiagStream);
     }
     // Assemble the result object.
     CComPtr<IDxcBlob> pDiagBlob;
@@ -141,6 +324,7 @@ HRESULT DxcValidator::ValidateWithOptModules(
     IFT(DxcOperationResult::CreateFromResultErrorStatus(nullptr, pDiagBlobEnconding, validationStatus, ppResult));
   }
   CATCH_CPP_ASSIGN_HRESULT();
+  hr = memoryScope.Finish(hr, ppResult);
 
   DxcEtw_DxcValidation_Stop(SUCCEEDED(hr) ? validationStatus : hr);
   return hr;
@@ -169,34 +353,67 @@ HRESULT DxcValidator::RunValidation(
   _In_ UINT32 Flags,                            // Validation flags.
   _In_ llvm::Module *pModule,                   // Module to validate, if available.
   _In_ llvm::Module *pDebugModule,              // Debug module to validate, if available
-  _In_ AbstractMemoryStream *pDiagStream) {
+  _In_opt_ DxilValidationAnalyses *pAnalyses,   // Analyses of pModule to reuse, if available
+  _In_ llvm::raw_ostream &DiagStream) {
 
   // Run validation may throw, but that indicates an inability to validate,
   // not that the validation failed (eg out of memory). That is indicated
   // by a failing HRESULT, and possibly error messages in the diagnostics stream.
 
-  raw_stream_ostream DiagStream(pDiagStream);
-
   if (Flags & DxcValidatorFlags_ModuleOnly) {
     IFRBOOL(!IsDxilContainerLike(pShader->GetBufferPointer(), pShader->GetBufferSize()), E_INVALIDARG);
   } else {
     IFRBOOL(IsDxilContainerLike(pShader->GetBufferPointer(), pShader->GetBufferSize()), DXC_E_CONTAINER_INVALID);
   }
 
+  // Structural-only validation trusts the module and checks only the parts
+  // derived from it, so there is no verdict to cache.
+  bool structuralOnly = (Flags & DxcValidatorFlags_StructuralOnly) != 0;
+  ValidationCache &cache = ValidationCache::Get();
+  std::string cacheKey;
+  if (cache.IsEnabled() && !structuralOnly)
+    cacheKey = ComputeValidationCacheKey(pShader, Flags);
+  bool moduleKnownValid = !cacheKey.empty() && cache.Contains(cacheKey);
+
+  llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
+  PrintDiagnosticContext DiagContext(DiagPrinter);
+  LLVMContext Ctx, DbgCtx;
+  std::unique_ptr<llvm::Module> pLoadedModule, pLoadedDebugModule;
+  std::unique_ptr<DiagRestore> pLoadDR, pLoadDbgDR;
+
   if (!pModule) {
     DXASSERT_NOMSG(pDebugModule == nullptr);
     if (Flags & DxcValidatorFlags_ModuleOnly) {
-      return ValidateDxilBitcode((const char*)pShader->GetBufferPointer(), (uint32_t)pShader->GetBufferSize(), DiagStream);
-    } else {
-      return ValidateDxilContainer(pShader->GetBufferPointer(), pShader->GetBufferSize(), DiagStream);
+      if (moduleKnownValid)
+        return S_OK;
+      HRESULT hr = ValidateDxilBitcode((const char*)pShader->GetBufferPointer(), (uint32_t)pShader->GetBufferSize(), DiagStream);
+      if (hr == S_OK && !cacheKey.empty())
+        cache.Insert(cacheKey);
+      return hr;
     }
+
+    // Load the module here rather than through ValidateDxilContainer so a
+    // cached verdict or structural-only validation can skip straight to the
+    // container part checks, and module diagnostics go straight to DiagStream.
+    pLoadDR.reset(new DiagRestore(Ctx, &DiagContext));
+    pLoadDbgDR.reset(new DiagRestore(DbgCtx, &DiagContext));
+    IFR(ValidateLoadModuleFromContainer(
+        pShader->GetBufferPointer(), pShader->GetBufferSize(), pLoadedModule,
+        pLoadedDebugModule, Ctx, DbgCtx, DiagStream, /*bLazy*/ true));
+    pModule = pLoadedModule.get();
+    pDebugModule = pLoadedDebugModule.get();
   }
 
-  llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
-  PrintDiagnosticContext DiagContext(DiagPrinter);
   DiagRestore DR(pModule->getContext(), &DiagContext);
 
-  IFR(hlsl::ValidateDxilModule(pModule, pDebugModule));
+  if (!moduleKnownValid && !structuralOnly) {
+    IFR(hlsl::ValidateDxilModule(pModule, pDebugModule, pAnalyses, &DiagStream,
+                                 m_MaxErrors));
+    if (!cacheKey.empty() && !DiagContext.HasErrors() &&
+        !DiagContext.HasWarnings())
+      cache.Insert(cacheKey);
+  }
+
   if (!(Flags & DxcValidatorFlags_ModuleOnly)) {
     IFR(ValidateDxilContainerParts(pModule, pDebugModule,
                       IsDxilContainerLike(pShader->GetBufferPointer(), pShader->GetBufferSize()),
@@ -212,7 +429,7 @@ HRESULT DxcValidator::RunValidation(
 
 HRESULT DxcValidator::RunRootSignatureValidation(
   _In_ IDxcBlob *pShader,
-  _In_ AbstractMemoryStream *pDiagStream) {
+  _In_ llvm::raw_ostream &DiagStream) {
 
   const DxilContainerHeader *pDxilContainer = IsDxilContainerLike(
     pShader->GetBufferPointer(), pShader->GetBufferSize());
@@ -228,7 +445,6 @@ HRESULT DxcValidator::RunRootSignatureValidation(
     RootSignatureHandle RSH;
     RSH.LoadSerialized((const uint8_t*)GetDxilPartData(pRSPart), pRSPart->PartSize);
     RSH.Deserialize();
-    raw_stream_ostream DiagStream(pDiagStream);
     IFRBOOL(VerifyRootSignatureWithShaderPSV(RSH.GetDesc(),
                                              GetVersionShaderType(pProgramHeader->ProgramVersion),
                                              GetDxilPartData(pPSVPart),
@@ -242,11 +458,86 @@ HRESULT DxcValidator::RunRootSignatureValidation(
   return S_OK;
 }
 
+HRESULT STDMETHODCALLTYPE DxcValidator::CheckRootSignatureCompatibility(
+  _In_ UINT32 rootSignatureCount,
+  _In_count_(rootSignatureCount) IDxcBlob **ppRootSignatures,
+  _In_ UINT32 shaderCount,
+  _In_count_(shaderCount) IDxcBlob **ppShaders,
+  _Out_writes_(rootSignatureCount * shaderCount) UINT32 *pReasons) {
+  if ((rootSignatureCount != 0 && ppRootSignatures == nullptr) ||
+      (shaderCount != 0 && ppShaders == nullptr) ||
+      (rootSignatureCount != 0 && shaderCount != 0 && pReasons == nullptr))
+    return E_INVALIDARG;
+
+  try {
+    // Root signatures that cannot be read keep a null description, which
+    // marks their row invalid.
+    std::vector<RootSignatureHandle> handles(rootSignatureCount);
+    std::vector<const DxilVersionedRootSignatureDesc *> descs(rootSignatureCount);
+    for (UINT32 i = 0; i < rootSignatureCount; ++i) {
+      IDxcBlob *pBlob = ppRootSignatures[i];
+      IFTARG(pBlob);
+      const uint8_t *pData = (const uint8_t *)pBlob->GetBufferPointer();
+      uint32_t size = (uint32_t)pBlob->GetBufferSize();
+      if (const DxilContainerHeader *pHeader = IsDxilContainerLike(pData, size)) {
+        const DxilPartHeader *pRSPart =
+            IsValidDxilContainer(pHeader, size)
+                ? GetDxilPartByType(pHeader, DFCC_RootSignature)
+                : nullptr;
+        if (pRSPart == nullptr)
+          continue;
+        pData = (const uint8_t *)GetDxilPartData(pRSPart);
+        size = pRSPart->PartSize;
+      }
+      try {
+        handles[i].LoadSerialized(pData, size);
+        handles[i].Deserialize();
+        descs[i] = handles[i].GetDesc();
+      } catch (...) {
+      }
+    }
+
+    std::vector<DxilShaderPSV> shaders(shaderCount);
+    for (UINT32 i = 0; i < shaderCount; ++i) {
+      IDxcBlob *pShader = ppShaders[i];
+      IFTARG(pShader);
+      DxilShaderPSV &shader = shaders[i];
+      shader.ShaderKind = DXIL::ShaderKind::Invalid;
+      shader.pPSVData = nullptr;
+      shader.PSVSize = 0;
+      const DxilContainerHeader *pHeader = IsDxilContainerLike(
+          pShader->GetBufferPointer(), pShader->GetBufferSize());
+      if (pHeader == nullptr ||
+          !IsValidDxilContainer(pHeader, pShader->GetBufferSize()))
+        continue;
+      const DxilProgramHeader *pProgramHeader =
+          GetDxilProgramHeader(pHeader, DFCC_DXIL);
+      const DxilPartHeader *pPSVPart =
+          GetDxilPartByType(pHeader, DFCC_PipelineStateValidation);
+      if (pProgramHeader == nullptr || pPSVPart == nullptr)
+        continue;
+      shader.ShaderKind = GetVersionShaderType(pProgramHeader->ProgramVersion);
+      shader.pPSVData = GetDxilPartData(pPSVPart);
+      shader.PSVSize = pPSVPart->PartSize;
+    }
+
+    static_assert(sizeof(DxilRootSignatureCompatibility) == sizeof(UINT32),
+                  "reasons are written in place");
+    VerifyRootSignaturesWithShaderPSVs(
+        rootSignatureCount, descs.data(), shaderCount, shaders.data(),
+        (DxilRootSignatureCompatibility *)pReasons);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+
+  return S_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 HRESULT RunInternalValidator(_In_ IDxcValidator *pValidator,
                              _In_ llvm::Module *pModule,
                              _In_ llvm::Module *pDebugModule,
+                             _In_opt_ DxilValidationAnalyses *pAnalyses,
                              _In_ IDxcBlob *pShader, UINT32 Flags,
                              _COM_Outptr_ IDxcOperationResult **ppResult) {
   DXASSERT_NOMSG(pValidator != nullptr);
@@ -256,7 +547,8 @@ HRESULT RunInternalValidator(_In_ IDxcValidator *pValidator,
 
   DxcValidator *pInternalValidator = (DxcValidator *)pValidator;
   return pInternalValidator->ValidateWithOptModules(pShader, Flags, pModule,
-                                                    pDebugModule, ppResult);
+                                                    pDebugModule, pAnalyses,
+                                                    ppResult);
 }
 
 HRESULT CreateDxcValidator(_In_ REFIID riid, _Out_ LPVOID* ppv) {
@@ -12,12 +12,16 @@
 #include "dxillib.h"
 #include "dxc/Support/Global.h" // For DXASSERT
 #include "dxc/Support/dxcapi.use.h"
+#include <atomic>
 
 using namespace dxc;
 
 static DxcDllSupport g_DllSupport;
 static HRESULT g_DllLibResult = S_OK;
 static CRITICAL_SECTION cs;
+// Set once the probe for dxil.dll has settled g_DllLibResult, so that the
+// checks made by every compilation do not enter cs.
+static std::atomic<bool> g_DllLibSettled(false);
 
 // Check if we can successfully get IDxcValidator from dxil.dll
 // This function is to prevent multiple attempts to load dxil.dll 
@@ -33,6 +37,7 @@ HRESULT DxilLibCleanup(DxilLibCleanUpType type) {
   }
   else if (type == DxilLibCleanUpType::UnloadLibrary) {
     g_DllSupport.Cleanup();
+    g_DllLibSettled.store(false, std::memory_order_release);
   }
   else {
     hr = E_INVALIDARG;
@@ -45,12 +50,15 @@ HRESULT DxilLibCleanup(DxilLibCleanUpType type) {
 // If we fail to load dxil.dll, set g_DllLibResult to E_FAIL so that we don't
 // have multiple attempts to load dxil.dll
 bool DxilLibIsEnabled() {
+  if (g_DllLibSettled.load(std::memory_order_acquire))
+    return SUCCEEDED(g_DllLibResult);
   EnterCriticalSection(&cs);
   if (SUCCEEDED(g_DllLibResult)) {
     if (!g_DllSupport.IsEnabled()) {
       g_DllLibResult = g_DllSupport.InitializeForDll(L"dxil.dll", "DxcCreateInstance");
     }
   }
+  g_DllLibSettled.store(true, std::memory_order_release);
   LeaveCriticalSection(&cs);
   return SUCCEEDED(g_DllLibResult);
 }
@@ -59,10 +67,9 @@ bool DxilLibIsEnabled() {
 HRESULT DxilLibCreateInstance(_In_ REFCLSID rclsid, _In_ REFIID riid, _In_ IUnknown **ppInterface) {
   DXASSERT_NOMSG(ppInterface != nullptr);
   HRESULT hr = E_FAIL;
-  if (DxilLibIsEnabled()) {
-    EnterCriticalSection(&cs);
+  // Once loaded, dxil.dll is not unloaded before the process or dxcompiler
+  // is, and its DxcCreateInstance is safe to call from any thread.
+  if (DxilLibIsEnabled())
     hr = g_DllSupport.CreateInstance(rclsid, riid, ppInterface);
-    LeaveCriticalSection(&cs);
-  }
   return hr;
 }
\ No newline at end of file
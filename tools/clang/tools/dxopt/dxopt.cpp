@@ -24,9 +24,14 @@
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/microcom.h"
 #include <comdef.h>
+#include <Psapi.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
 
+#pragma comment(lib, "psapi.lib")
+
 inline bool wcseq(LPCWSTR a, LPCWSTR b) {
   return (a == nullptr && b == nullptr) || (a != nullptr && b != nullptr && wcscmp(a, b) == 0);
 }
@@ -45,6 +50,7 @@ enum class ProgramAction {
   PrintPasses,
   PrintPassesWithDetails,
   RunOptimizer,
+  RunBenchmark,
 };
 
 const wchar_t *STDIN_FILE_NAME = L"-";
@@ -191,16 +197,146 @@ static void ReadFileOpts(LPCWSTR pPassFileName, IDxcBlobEncoding **ppPassOpts, s
   *ppPassOpts = pPassOpts.Detach();
 }
 
+// The times of the runs of a pipeline over one module, and the instruction
+// counts it went through, as read back from the RunPipeline reports.
+struct PipelineBenchmark {
+  std::vector<std::string> PassNames;
+  std::vector<std::vector<double>> PassMs; // Per pass, the time of each run.
+  std::vector<double> TotalMs;             // The time of each run.
+  uint64_t InitialInstructions = 0;
+  std::vector<uint64_t> PassInstructions;  // The count after each pass.
+};
+
+// Reads the number following the key, searching from pCursor. Returns the
+// position after the number, or nullptr if the key is not found.
+static const char *ReadReportNumber(const char *pCursor, const char *pKey,
+                                    double *pValue) {
+  const char *pFound = strstr(pCursor, pKey);
+  if (pFound == nullptr) {
+    return nullptr;
+  }
+  char *pEnd;
+  *pValue = strtod(pFound + strlen(pKey), &pEnd);
+  return pEnd;
+}
+
+// Adds one run to the benchmark from its RunPipeline report.
+static void AddPipelineReport(IDxcBlobEncoding *pReport,
+                              PipelineBenchmark &bench) {
+  std::string report((const char *)pReport->GetBufferPointer(),
+                     pReport->GetBufferSize());
+  const bool firstRun = bench.TotalMs.empty();
+  const char *pCursor = report.c_str();
+  double value;
+  pCursor = ReadReportNumber(pCursor, "\"pipelineWallMs\": ", &value);
+  IFTBOOL(pCursor != nullptr, E_FAIL);
+  bench.TotalMs.push_back(value);
+  pCursor = ReadReportNumber(pCursor, "\"initialInstructions\": ", &value);
+  IFTBOOL(pCursor != nullptr, E_FAIL);
+  bench.InitialInstructions = (uint64_t)value;
+
+  static const char NameKey[] = "\"name\": \"";
+  for (size_t i = 0;; ++i) {
+    const char *pName = strstr(pCursor, NameKey);
+    if (pName == nullptr) {
+      break;
+    }
+    pName += strlen(NameKey);
+    const char *pNameEnd = strchr(pName, '"');
+    IFTBOOL(pNameEnd != nullptr, E_FAIL);
+    double wallMs, instructions;
+    pCursor = ReadReportNumber(pNameEnd, "\"wallMs\": ", &wallMs);
+    IFTBOOL(pCursor != nullptr, E_FAIL);
+    pCursor = ReadReportNumber(pCursor, "\"instructions\": ", &instructions);
+    IFTBOOL(pCursor != nullptr, E_FAIL);
+    if (firstRun) {
+      bench.PassNames.emplace_back(pName, pNameEnd);
+      bench.PassMs.emplace_back();
+      bench.PassInstructions.push_back((uint64_t)instructions);
+    }
+    IFTBOOL(i < bench.PassMs.size(), E_FAIL);
+    bench.PassMs[i].push_back(wallMs);
+  }
+}
+
+// Returns the nearest-rank percentile of the values.
+static double Percentile(std::vector<double> values, double percent) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t rank = (size_t)std::ceil(percent / 100 * values.size());
+  return values[rank == 0 ? 0 : rank - 1];
+}
+
+static void PrintBenchmarkRow(const wchar_t *pName,
+                              const std::vector<double> &ms,
+                              uint64_t instructions, uint64_t previous) {
+  wprintf(L"  %-40s %10.3f %10.3f %10.3f %12llu %+9lld\n", pName,
+          Percentile(ms, 50), Percentile(ms, 90), Percentile(ms, 99),
+          (unsigned long long)instructions,
+          (long long)instructions - (long long)previous);
+}
+
+static void PrintBenchmark(LPCWSTR pFileName, const PipelineBenchmark &bench) {
+  wprintf(L"%s: %u runs, %llu instructions\n", pFileName,
+          (unsigned)bench.TotalMs.size(),
+          (unsigned long long)bench.InitialInstructions);
+  wprintf(L"  %-40s %10s %10s %10s %12s %9s\n", L"pass", L"median ms",
+          L"p90 ms", L"p99 ms", L"instructions", L"delta");
+  uint64_t previous = bench.InitialInstructions;
+  for (size_t i = 0; i < bench.PassNames.size(); ++i) {
+    CA2W name(bench.PassNames[i].c_str(), CP_UTF8);
+    PrintBenchmarkRow(name, bench.PassMs[i], bench.PassInstructions[i],
+                      previous);
+    previous = bench.PassInstructions[i];
+  }
+  PrintBenchmarkRow(L"total", bench.TotalMs, previous,
+                    bench.InitialInstructions);
+}
+
+// Runs the pipeline the given number of times over each input module, and
+// prints the time percentiles and instruction counts of each pass, then the
+// peak working set of the process.
+static void RunBenchmark(IDxcOptimizer *pOptimizer,
+                         const std::vector<LPCWSTR> &inFileNames,
+                         LPCWSTR pPipeline, unsigned runCount) {
+  CComPtr<IDxcOptimizer2> pOptimizer2;
+  IFT(pOptimizer->QueryInterface(&pOptimizer2));
+  for (LPCWSTR pFileName : inFileNames) {
+    CComPtr<IDxcBlob> pBlob;
+    CComPtr<IDxcOptimizerModule> pModule;
+    BlobFromFile(pFileName, &pBlob);
+    IFT(pOptimizer2->ParseModule(pBlob, &pModule));
+    PipelineBenchmark bench;
+    for (unsigned run = 0; run < runCount; ++run) {
+      CComPtr<IDxcBlobEncoding> pReport;
+      IFT(pModule->RunPipeline(pPipeline, nullptr, &pReport));
+      AddPipelineReport(pReport, bench);
+    }
+    PrintBenchmark(pFileName, bench);
+  }
+
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    wprintf(L"Peak working set: %.1f MB\n",
+            counters.PeakWorkingSetSize / (1024.0 * 1024.0));
+  }
+}
+
 static void PrintHelp() {
   wprintf(L"%s",
     L"Performs optimizations on a bitcode file by running a sequence of passes.\n\n"
-    L"dxopt [-? | -passes | -pass-details | -pf [PASS-FILE] | [-o=OUT-FILE] | IN-FILE OPT-ARGUMENTS ...]\n\n"
+    L"dxopt [-? | -passes | -pass-details | -pf [PASS-FILE] | [-o=OUT-FILE] | IN-FILE OPT-ARGUMENTS ...]\n"
+    L"dxopt -bench=COUNT [-pf PASS-FILE] IN-FILE ... OPT-ARGUMENTS ...\n\n"
     L"Arguments:\n"
     L"  -?  Displays this help message\n"
     L"  -passes        Displays a list of pass names\n"
     L"  -pass-details  Displays a list of passes with detailed information\n"
     L"  -pf PASS-FILE  Loads passes from the specified file\n"
     L"  -o=OUT-FILE    Output file for processed module\n"
+    L"  -bench=COUNT   Runs the passes COUNT times over each input file and\n"
+    L"                 reports the time and instruction count of each pass\n"
     L"  IN-FILE        File with with bitcode to optimize\n"
     L"  OPT-ARGUMENTS  One or more passes to run in sequence\n"
     L"\n"
@@ -223,6 +359,9 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
     LPCWSTR passFileName = nullptr;
     const wchar_t **optArgs = nullptr;
     UINT32 optArgCount = 0;
+    unsigned benchRunCount = 0;
+    std::vector<LPCWSTR> benchFileNames;
+    std::vector<LPCWSTR> benchPasses;
 
     int argIdx = 1;
     while (argIdx < argc) {
@@ -263,6 +402,24 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
       else if (wcsistarts(arg, L"-o=")) {
         outFileName = argv_[argIdx] + 3;
       }
+      else if (wcsistarts(arg, L"-bench=")) {
+        benchRunCount = wcstoul(arg + 7, nullptr, 10);
+        if (benchRunCount == 0) {
+          PrintHelp();
+          return 1;
+        }
+      }
+      else if (benchRunCount != 0) {
+        // The remaining arguments are input files and passes, in any order.
+        action = ProgramAction::RunBenchmark;
+        for (; argIdx < argc; ++argIdx) {
+          if (isFileInputArg(argv_[argIdx]))
+            benchFileNames.push_back(argv_[argIdx]);
+          else
+            benchPasses.push_back(argv_[argIdx]);
+        }
+        break;
+      }
       else {
         action = ProgramAction::RunOptimizer;
         // See if arg is file input specifier.
@@ -288,7 +445,12 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
       return retVal;
     }
 
-    if (passFileName && optArgCount) {
+    if (benchRunCount != 0 && benchFileNames.empty()) {
+      wprintf(L"%s", L"-bench requires at least one input file.\n");
+      return 1;
+    }
+
+    if (passFileName && (optArgCount || !benchPasses.empty())) {
       wprintf(L"%s", L"Cannot specify both command-line options and an pass option file.\n");
       return 1;
     }
@@ -324,6 +486,20 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
       IFT(pOptimizer->RunOptimizer(pBlob, optArgs, optArgCount, &pOutputModule, &pOutputText));
       PrintOptOutput(outFileName, pOutputModule, pOutputText);
       break;
+    case ProgramAction::RunBenchmark: {
+      pStage = "Benchmark";
+      const wchar_t **passArgs = benchPasses.data();
+      UINT32 passArgCount = benchPasses.size();
+      ReadFileOpts(passFileName, &pPassOpts, passes, &passArgs, &passArgCount);
+      std::wstring pipeline;
+      for (UINT32 i = 0; i < passArgCount; ++i) {
+        if (i != 0)
+          pipeline += L';';
+        pipeline += passArgs[i];
+      }
+      RunBenchmark(pOptimizer, benchFileNames, pipeline.c_str(), benchRunCount);
+      break;
+    }
     }
   } catch (const ::hlsl::Exception &hlslException) {
     try {
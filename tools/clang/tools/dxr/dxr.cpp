@@ -29,17 +29,17 @@ class DxrContext {
 
 private:
   bool m_outputWarnings;
-  LPCWSTR m_pEntryPoint;
+  std::vector<LPCWSTR> m_entryPoints;
   LPCWSTR m_pName;
   DxcDefine *m_pDefines;
   UINT32 m_definesCount;
   DxcDllSupport& m_dxcSupport;
 
 public:
-  DxrContext(LPCWSTR pName, LPCWSTR pEntryPoint, DxcDefine *pDefines,
-             UINT32 definesCount, bool outputWarnings,
+  DxrContext(LPCWSTR pName, std::vector<LPCWSTR> entryPoints,
+             DxcDefine *pDefines, UINT32 definesCount, bool outputWarnings,
              DxcDllSupport& dxcSupport) :
-    m_pName(pName), m_pEntryPoint(pEntryPoint), m_pDefines(pDefines),
+    m_pName(pName), m_entryPoints(std::move(entryPoints)), m_pDefines(pDefines),
     m_definesCount(definesCount), m_outputWarnings(outputWarnings),
     m_dxcSupport(dxcSupport) {
   }
@@ -56,9 +56,27 @@ void DxrContext::RunRemoveUnusedGlobals() {
 
   IFT_Data(ReadFromFile(m_pName, &pBlobEncoding), m_pName);
   IFT(m_dxcSupport.CreateInstance(CLSID_DxcRewriter, &pRewriter));
-  IFT(pRewriter->RemoveUnusedGlobals(pBlobEncoding, m_pEntryPoint, m_pDefines, m_definesCount, &pRewriteResult));
+  if (m_entryPoints.size() == 1) {
+    IFT(pRewriter->RemoveUnusedGlobals(pBlobEncoding, m_entryPoints[0], m_pDefines, m_definesCount, &pRewriteResult));
+    WriteOperationResultToConsole(pRewriteResult, m_outputWarnings);
+    return;
+  }
 
-  WriteOperationResultToConsole(pRewriteResult, m_outputWarnings);
+  // Several entry points share one parse; each result follows its name.
+  CComPtr<IDxcRewriter2> pRewriter2;
+  IFT(pRewriter.QueryInterface(&pRewriter2));
+  std::vector<IDxcOperationResult *> resultPtrs(m_entryPoints.size());
+  IFT(pRewriter2->RemoveUnusedGlobalsForEntryPoints(
+      pBlobEncoding, m_entryPoints.data(), m_entryPoints.size(), m_pDefines,
+      m_definesCount, resultPtrs.data()));
+  std::vector<CComPtr<IDxcOperationResult>> results(resultPtrs.size());
+  for (size_t i = 0; i < resultPtrs.size(); ++i)
+    results[i].Attach(resultPtrs[i]);
+  for (size_t i = 0; i < m_entryPoints.size(); ++i) {
+    wprintf(L"// Entry point: %s\n", m_entryPoints[i]);
+    fflush(stdout);
+    WriteOperationResultToConsole(results[i], m_outputWarnings);
+  }
 }
 
 void DxrContext::RunRewriteUnchanged() {
@@ -163,7 +181,7 @@ void PrintUsage() {
   wprintf(L"FILE is the .hlsl file to be rewritten.\n");
   wprintf(L"  Note that this file will be read using the system default Windows ANSI code page.\n");
   wprintf(L"OPTIONS currently supports:\n"
-          L"  -E<entry point>\n"
+          L"  -E<entry point> (may be repeated for -remove-unused-globals)\n"
           L"  -D<define-name>\n"
           L"  -D<define-name>=<define-value>\n"
           L"  -external <dxcompiler-path> <entry-point>\n"
@@ -203,7 +221,7 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
   try {
     DxcDllSupport dxcSupport;
     bool outputWarnings = true;
-    LPCWSTR pEntryPoint = nullptr;
+    std::vector<LPCWSTR> entryPoints;
     int definesCount = 0;
     std::vector<DxcDefine> definesVector;
     std::vector<std::wstring> definesPieces; // This ensures that the memory needed for the DXCDefine ptrs won't get freed too soon
@@ -238,8 +256,7 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
       }
 
       if (wcsieq(start.c_str(), L"-E") || wcsieq(start.c_str(), L"/E")) {
-         pEntryPoint = argv_[i];
-         pEntryPoint += 2;
+         entryPoints.push_back(argv_[i] + 2);
          continue;
       }
 
@@ -273,14 +290,15 @@ int __cdecl wmain(int argc, const wchar_t **argv_) {
       pDefinesArray = definesVector.data(); 
 
     EnsureEnabled(dxcSupport);
-    DxrContext context(pFileName, pEntryPoint, pDefinesArray, definesCount, outputWarnings, dxcSupport);
+    bool hasEntryPoint = !entryPoints.empty();
+    DxrContext context(pFileName, std::move(entryPoints), pDefinesArray, definesCount, outputWarnings, dxcSupport);
 
     switch (modeNum) {
     case 0:
       context.RunRewriteUnchanged();
       break;
     case 1:
-      if (pEntryPoint == nullptr) {
+      if (!hasEntryPoint) {
         printf("Cannot use -remove-unused-globals without specifying an entry point.\n");
         return 1;
       }
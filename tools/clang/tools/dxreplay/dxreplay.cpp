@@ -0,0 +1,449 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxreplay.cpp                                                              //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides the entry point for the dxreplay console program, which runs     //
+// again the compile calls recorded with DXC_TRACE_RECORD and times them.    //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/Support/Global.h"
+#include "dxc/Support/Unicode.h"
+#include "dxc/Support/WinIncludes.h"
+#include "dxc/Support/microcom.h"
+#include "dxc/Support/FileIOHelper.h"
+#include "dxc/Support/TraceArchive.h"
+#include <vector>
+#include <string>
+
+#include "dxc/dxcapi.h"
+#include "dxc/Support/dxcapi.use.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace hlsl;
+
+inline bool wcsieq(LPCWSTR a, LPCWSTR b) { return _wcsicmp(a, b) == 0; }
+inline bool wcsistarts(LPCWSTR text, LPCWSTR prefix) {
+  return wcslen(text) >= wcslen(prefix) && _wcsnicmp(text, prefix, wcslen(prefix)) == 0;
+}
+inline bool wcsieqopt(LPCWSTR text, LPCWSTR opt) {
+  return (text[0] == L'-' || text[0] == L'/') && wcsieq(text + 1, opt);
+}
+
+static dxc::DxcDllSupport g_DxcSupport;
+
+// A recorded call and the outcome of its replays.
+struct ReplayCall {
+  std::wstring FileName;
+  TraceCall Call;
+  std::map<std::wstring, const TraceCall::Include *> Includes;
+  double ReplayMs = 0;      // Summed over iterations.
+  unsigned Failed = 0;      // Replays that did not run.
+  unsigned Mismatched = 0;  // Replays whose status differs from the trace.
+};
+
+// Serves the files recorded with a call. Names are matched exactly, as the
+// compiler asks for the same names given the same arguments.
+class ReplayIncludeHandler : public IDxcIncludeHandler {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  CComPtr<IDxcLibrary> m_pLibrary;
+  const ReplayCall &m_call;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  ReplayIncludeHandler(IDxcLibrary *pLibrary, const ReplayCall &call)
+      : m_dwRef(0), m_pLibrary(pLibrary), m_call(call) {}
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeHandler>(this, iid, ppvObject);
+  }
+
+  HRESULT STDMETHODCALLTYPE LoadSource(
+      _In_ LPCWSTR pFilename, _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource) override {
+    *ppIncludeSource = nullptr;
+    auto it = m_call.Includes.find(pFilename);
+    if (it == m_call.Includes.end())
+      return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    const std::string &contents = it->second->Contents;
+    CComPtr<IDxcBlobEncoding> pBlob;
+    IFR(m_pLibrary->CreateBlobWithEncodingFromPinned(
+        (LPBYTE)contents.data(), (UINT32)contents.size(), CP_UTF8, &pBlob));
+    *ppIncludeSource = pBlob.Detach();
+    return S_OK;
+  }
+};
+
+static void PrintHelp() {
+  wprintf(L"%s",
+    L"Runs again the compile calls recorded with DXC_TRACE_RECORD and times\n"
+    L"them.\n"
+    L"\n"
+    L"dxreplay.exe [options] <trace directory or .dxctrace file>...\n"
+    L"\n"
+    L"To record, set DXC_TRACE_RECORD to an existing directory before running\n"
+    L"the build; every compile call of dxcompiler is written to it with its\n"
+    L"source, arguments, defines and the includes it was served. Calls are\n"
+    L"replayed in the order they started, with the recorded includes, so the\n"
+    L"archive can be replayed on another machine.\n"
+    L"\n"
+    L"Options:\n"
+    L"  -threads=N       Calls replayed at once (default: 1).\n"
+    L"  -iterations=N    Times each call is replayed (default: 1).\n"
+    L"  -dxcompiler=DLL  Compiler to replay with (default: dxcompiler.dll).\n"
+    L"  -o=FILE          Also write the results to FILE as JSON.\n"
+    L"  -?               Display this help.\n");
+}
+
+static void AddTraceFile(const std::wstring &fileName,
+                         std::vector<ReplayCall> &calls) {
+  CComHeapPtr<char> pData;
+  DWORD dataSize;
+  ReadBinaryFile(fileName.c_str(), (void **)&pData, &dataSize);
+  ReplayCall call;
+  call.FileName = fileName;
+  if (!DeserializeTraceCall(pData.m_pData, dataSize, call.Call)) {
+    wprintf(L"Skipping %s, which is not a trace of this version.\n",
+            fileName.c_str());
+    return;
+  }
+  calls.push_back(std::move(call));
+}
+
+static void AddTraceDirectory(const std::wstring &directory,
+                              std::vector<ReplayCall> &calls) {
+  WIN32_FIND_DATAW findData;
+  HANDLE hFind = FindFirstFileW(
+      (directory + L"\\*" + TraceFileExtension).c_str(), &findData);
+  if (hFind == INVALID_HANDLE_VALUE) {
+    DWORD error = GetLastError();
+    if (error == ERROR_FILE_NOT_FOUND)
+      return;
+    IFT(HRESULT_FROM_WIN32(error));
+  }
+  do {
+    if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      AddTraceFile(directory + L"\\" + findData.cFileName, calls);
+  } while (FindNextFileW(hFind, &findData));
+  FindClose(hFind);
+}
+
+// Replays one call. Returns false if it could not be run.
+static bool ReplayOne(IDxcLibrary *pLibrary, IDxcCompiler *pCompiler,
+                      ReplayCall &call, double &elapsedMs,
+                      HRESULT &status) {
+  const TraceCall &trace = call.Call;
+  std::vector<LPCWSTR> arguments;
+  for (const std::wstring &arg : trace.Arguments)
+    arguments.push_back(arg.c_str());
+  std::vector<DxcDefine> defines(trace.Defines.size());
+  for (size_t i = 0; i < defines.size(); ++i) {
+    defines[i].Name = trace.Defines[i].Name.c_str();
+    defines[i].Value =
+        trace.Defines[i].HasValue ? trace.Defines[i].Value.c_str() : nullptr;
+  }
+
+  CComPtr<IDxcBlobEncoding> pSource;
+  IFT(pLibrary->CreateBlobWithEncodingFromPinned(
+      (LPBYTE)trace.Source.data(), (UINT32)trace.Source.size(), CP_UTF8,
+      &pSource));
+  CComPtr<IDxcIncludeHandler> pIncludeHandler =
+      new ReplayIncludeHandler(pLibrary, call);
+
+  CComPtr<IDxcOperationResult> pResult;
+  auto start = std::chrono::steady_clock::now();
+  HRESULT hr = pCompiler->Compile(
+      pSource, trace.HasSourceName ? trace.SourceName.c_str() : nullptr,
+      trace.EntryPoint.c_str(), trace.TargetProfile.c_str(), arguments.data(),
+      (UINT32)arguments.size(), defines.data(), (UINT32)defines.size(),
+      pIncludeHandler, &pResult);
+  elapsedMs = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start).count();
+  status = hr;
+  if (SUCCEEDED(hr))
+    pResult->GetStatus(&status);
+  return SUCCEEDED(hr);
+}
+
+static double ReplayCalls(std::vector<ReplayCall> &calls, unsigned threadCount,
+                          unsigned iterations) {
+  const size_t jobCount = calls.size() * iterations;
+  std::atomic<size_t> nextJob(0);
+  std::vector<HRESULT> threadStatus(threadCount, S_OK);
+  std::mutex callMutex;
+  auto worker = [&](unsigned threadIndex) {
+    try {
+      CComPtr<IDxcLibrary> pLibrary;
+      CComPtr<IDxcCompiler> pCompiler;
+      IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+      IFT(g_DxcSupport.CreateInstance(CLSID_DxcCompiler, &pCompiler));
+      for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+        ReplayCall &call = calls[i % calls.size()];
+        double elapsedMs = 0;
+        HRESULT status = S_OK;
+        bool ran = ReplayOne(pLibrary, pCompiler, call, elapsedMs, status);
+        std::lock_guard<std::mutex> lock(callMutex);
+        call.ReplayMs += elapsedMs;
+        if (!ran)
+          ++call.Failed;
+        else if (SUCCEEDED(status) != SUCCEEDED(call.Call.Status))
+          ++call.Mismatched;
+      }
+    } catch (const ::hlsl::Exception &hlslException) {
+      threadStatus[threadIndex] = hlslException.hr;
+    } catch (std::bad_alloc &) {
+      threadStatus[threadIndex] = E_OUTOFMEMORY;
+    } catch (...) {
+      threadStatus[threadIndex] = E_FAIL;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker, i);
+  worker(0);
+  for (std::thread &t : threads)
+    t.join();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  for (HRESULT hr : threadStatus)
+    IFT(hr);
+  return elapsed.count();
+}
+
+static std::string DescribeCall(const ReplayCall &call) {
+  const TraceCall &trace = call.Call;
+  std::wstring text = trace.HasSourceName ? trace.SourceName : call.FileName;
+  text += L" " + trace.EntryPoint + L" " + trace.TargetProfile;
+  return Unicode::UTF16ToUTF8StringOrThrow(text.c_str());
+}
+
+static void WriteJsonString(llvm::raw_ostream &OS, llvm::StringRef value) {
+  OS << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      OS << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      OS << ' ';
+    else
+      OS << c;
+  }
+  OS << '"';
+}
+
+struct ReplayTotals {
+  unsigned Calls = 0;
+  unsigned Failed = 0;
+  unsigned Mismatched = 0;
+  double RecordedMs = 0;
+  double ReplayMs = 0;
+  double WallMs = 0;
+};
+
+static ReplayTotals ComputeTotals(const std::vector<ReplayCall> &calls,
+                                  unsigned iterations, double wallMs) {
+  ReplayTotals totals;
+  totals.Calls = (unsigned)calls.size();
+  totals.WallMs = wallMs;
+  for (const ReplayCall &call : calls) {
+    totals.Failed += call.Failed;
+    totals.Mismatched += call.Mismatched;
+    totals.RecordedMs += call.Call.DurationUs / 1000.0;
+    totals.ReplayMs += call.ReplayMs / iterations;
+  }
+  return totals;
+}
+
+// Writes the results as JSON, with the calls in replay order so that the
+// reports of two compilers can be diffed.
+static void WriteJson(llvm::raw_ostream &OS, const std::vector<ReplayCall> &calls,
+                      const ReplayTotals &totals, unsigned threads,
+                      unsigned iterations) {
+  OS << "{\n  \"calls\": " << totals.Calls
+     << ",\n  \"threads\": " << threads
+     << ",\n  \"iterations\": " << iterations
+     << ",\n  \"failed\": " << totals.Failed
+     << ",\n  \"mismatched\": " << totals.Mismatched
+     << ",\n  \"wallMs\": " << llvm::format("%.3f", totals.WallMs)
+     << ",\n  \"recordedMs\": " << llvm::format("%.3f", totals.RecordedMs)
+     << ",\n  \"replayMs\": " << llvm::format("%.3f", totals.ReplayMs)
+     << ",\n  \"replays\": [";
+  for (size_t i = 0; i < calls.size(); ++i) {
+    OS << (i ? ",\n" : "\n") << "    { \"call\": ";
+    WriteJsonString(OS, DescribeCall(calls[i]));
+    OS << ", \"recordedMs\": "
+       << llvm::format("%.3f", calls[i].Call.DurationUs / 1000.0)
+       << ", \"replayMs\": "
+       << llvm::format("%.3f", calls[i].ReplayMs / iterations) << " }";
+  }
+  OS << "\n  ]\n}\n";
+}
+
+// Prints the totals, then the ten calls that took longest to replay.
+static void PrintTable(const std::vector<ReplayCall> &calls,
+                       const ReplayTotals &totals, unsigned iterations) {
+  std::string text;
+  llvm::raw_string_ostream OS(text);
+  OS << "calls failed mismatched    wall ms  recorded ms  replayed ms\n"
+     << llvm::format("%5u %6u %10u %10.1f %12.1f %12.1f\n", totals.Calls,
+                     totals.Failed, totals.Mismatched, totals.WallMs,
+                     totals.RecordedMs, totals.ReplayMs);
+  std::vector<const ReplayCall *> slowest;
+  for (const ReplayCall &call : calls)
+    slowest.push_back(&call);
+  std::sort(slowest.begin(), slowest.end(),
+            [](const ReplayCall *a, const ReplayCall *b) {
+              return a->ReplayMs > b->ReplayMs;
+            });
+  OS << "\nSlowest calls (replayed ms, recorded ms):\n";
+  for (size_t i = 0; i < slowest.size() && i < 10; ++i)
+    OS << llvm::format("  %10.1f %10.1f  ", slowest[i]->ReplayMs / iterations,
+                       slowest[i]->Call.DurationUs / 1000.0)
+       << DescribeCall(*slowest[i]) << "\n";
+  OS.flush();
+  dxc::WriteUtf8ToConsoleSizeT(text.data(), text.size());
+}
+
+int __cdecl wmain(int argc, const wchar_t **argv_) {
+  const char *pStage = "Operation";
+  try {
+    // Parse command line options.
+    pStage = "Argument processing";
+
+    unsigned threads = 1;
+    unsigned iterations = 1;
+    LPCWSTR outFileName = nullptr;
+    LPCWSTR dllName = nullptr;
+    std::vector<LPCWSTR> inputs;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+      LPCWSTR arg = argv_[argIdx];
+      if (wcsieqopt(arg, L"?")) {
+        PrintHelp();
+        return 0;
+      }
+      else if (wcsistarts(arg, L"-threads=")) {
+        threads = wcstoul(arg + 9, nullptr, 10);
+        if (threads == 0) {
+          wprintf(L"The thread count must be positive.\n");
+          return 1;
+        }
+      }
+      else if (wcsistarts(arg, L"-iterations=")) {
+        iterations = wcstoul(arg + 12, nullptr, 10);
+        if (iterations == 0) {
+          wprintf(L"The iteration count must be positive.\n");
+          return 1;
+        }
+      }
+      else if (wcsistarts(arg, L"-dxcompiler=")) {
+        dllName = arg + 12;
+      }
+      else if (wcsistarts(arg, L"-o=")) {
+        outFileName = arg + 3;
+      }
+      else if (arg[0] == L'-' || arg[0] == L'/') {
+        wprintf(L"Unknown option %s.\n", arg);
+        PrintHelp();
+        return 1;
+      }
+      else {
+        inputs.push_back(arg);
+      }
+    }
+    if (inputs.empty()) {
+      PrintHelp();
+      return 1;
+    }
+
+    pStage = "Loading the trace";
+    std::vector<ReplayCall> calls;
+    for (LPCWSTR input : inputs) {
+      DWORD attributes = GetFileAttributesW(input);
+      if (attributes == INVALID_FILE_ATTRIBUTES)
+        dxc::IFT_Data(HRESULT_FROM_WIN32(GetLastError()), input);
+      if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+        AddTraceDirectory(input, calls);
+      else
+        AddTraceFile(input, calls);
+    }
+    if (calls.empty()) {
+      wprintf(L"No recorded calls were found.\n");
+      return 1;
+    }
+    std::stable_sort(calls.begin(), calls.end(),
+                     [](const ReplayCall &a, const ReplayCall &b) {
+                       return a.Call.StartTime < b.Call.StartTime;
+                     });
+    for (ReplayCall &call : calls) {
+      for (const TraceCall::Include &include : call.Call.Includes)
+        call.Includes[include.Name] = &include;
+    }
+
+    // The replayed compiler must not record the replay into the trace.
+    SetEnvironmentVariableW(TraceRecordEnvVar, nullptr);
+    pStage = "Loading the compiler";
+    if (dllName != nullptr)
+      IFT(g_DxcSupport.InitializeForDll(dllName, "DxcCreateInstance"));
+    else
+      dxc::EnsureEnabled(g_DxcSupport);
+
+    pStage = "Replaying";
+    double wallMs = ReplayCalls(calls, threads, iterations);
+
+    pStage = "Writing results";
+    ReplayTotals totals = ComputeTotals(calls, iterations, wallMs);
+    PrintTable(calls, totals, iterations);
+    if (outFileName != nullptr) {
+      std::string json;
+      llvm::raw_string_ostream OS(json);
+      WriteJson(OS, calls, totals, threads, iterations);
+      OS.flush();
+      CComPtr<IDxcLibrary> pLibrary;
+      CComPtr<IDxcBlobEncoding> pBlob;
+      IFT(g_DxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+      IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+          json.data(), (UINT32)json.size(), CP_UTF8, &pBlob));
+      dxc::WriteBlobToFile(pBlob, outFileName);
+    }
+    return totals.Failed == 0 ? 0 : 1;
+  }
+  catch (const ::hlsl::Exception &hlslException) {
+    try {
+      const char *msg = hlslException.what();
+      Unicode::acp_char printBuffer[128]; // printBuffer is safe to treat as
+                                          // UTF-8 because we use ASCII only errors
+                                          // only
+      if (msg == nullptr || *msg == '\0') {
+        sprintf_s(printBuffer, _countof(printBuffer),
+                  "%s failed - error code 0x%08x.", pStage, hlslException.hr);
+        msg = printBuffer;
+      }
+      printf("%s\n", msg);
+    }
+    catch (...) {
+      printf("%s failed - unable to retrieve error message.\n", pStage);
+    }
+
+    return 1;
+  }
+  catch (std::bad_alloc &) {
+    printf("%s failed - out of memory.\n", pStage);
+    return 1;
+  }
+  catch (...) {
+    printf("%s failed - unknown error.\n", pStage);
+    return 1;
+  }
+}
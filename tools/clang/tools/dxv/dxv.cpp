@@ -17,8 +17,13 @@
 #include "dxc/dxcapi.internal.h"
 #include "dxc/Support/dxcapi.use.h"
 #include "dxc/Support/HLSLOptions.h"
+#include "dxc/HLSL/DxilContainer.h"
 
 #include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace dxc;
 using namespace llvm;
@@ -28,61 +33,213 @@ using namespace hlsl::options;
 static cl::opt<std::string>
 InputFilename(cl::Positional, cl::desc("<input dxil file>"), cl::init("-"));
 
+static cl::opt<bool>
+StructuralOnly("structural-only",
+               cl::desc("Only check container parts against the module; "
+                        "the module itself is not validated"),
+               cl::init(false));
+
+static cl::opt<std::string>
+BatchInput("batch",
+           cl::desc("Validate every file in <directory> (recursively), or "
+                    "every file named on a line of <list file>"),
+           cl::value_desc("directory|list file"), cl::init(""));
+
+static cl::opt<unsigned>
+BatchThreads("threads",
+             cl::desc("Number of batch validation threads (default: one per "
+                      "hardware thread)"),
+             cl::init(0));
+
 class DxvContext {
 private:
   DxcDllSupport &m_dxcSupport;
+
+  // Returns the validation status of one file; errors gets the assembler or
+  // validator messages. Assembly text is assembled first, containers are
+  // validated as they are.
+  HRESULT ValidateFile(LPCWSTR pFileName, IDxcAssembler *pAssembler,
+                       IDxcValidator *pValidator, std::string &errors);
 public:
   DxvContext(DxcDllSupport &dxcSupport)
       : m_dxcSupport(dxcSupport) {}
 
   void Validate();
+  // Returns the number of files that failed validation.
+  unsigned ValidateBatch();
 };
 
-void DxvContext::Validate() {
-  CComPtr<IDxcOperationResult> pCompileResult;
+static std::string GetErrorText(IDxcOperationResult *pResult) {
+  CComPtr<IDxcBlobEncoding> text;
+  IFT(pResult->GetErrorBuffer(&text));
+  if (text == nullptr || text->GetBufferSize() == 0)
+    return std::string();
+  const char *pStart = (const char *)text->GetBufferPointer();
+  return std::string(pStart, strnlen(pStart, text->GetBufferSize()));
+}
 
-  {
-    CComPtr<IDxcBlobEncoding> pSource;
-    ReadFileIntoBlob(m_dxcSupport, StringRefUtf16(InputFilename), &pSource);
+HRESULT DxvContext::ValidateFile(LPCWSTR pFileName, IDxcAssembler *pAssembler,
+                                 IDxcValidator *pValidator,
+                                 std::string &errors) {
+  CComPtr<IDxcBlobEncoding> pSource;
+  ReadFileIntoBlob(m_dxcSupport, pFileName, &pSource);
 
-    CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcBlob> pContainerBlob;
+  if (hlsl::IsDxilContainerLike(pSource->GetBufferPointer(),
+                                pSource->GetBufferSize())) {
+    pContainerBlob = pSource;
+  } else {
     CComPtr<IDxcOperationResult> pAsmResult;
-
-    CComPtr<IDxcBlob> pContainerBlob;
     HRESULT resultStatus;
-
-    IFT(m_dxcSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
     IFT(pAssembler->AssembleToContainer(pSource, &pAsmResult));
     IFT(pAsmResult->GetStatus(&resultStatus));
     if (FAILED(resultStatus)) {
-      CComPtr<IDxcBlobEncoding> text;
-      IFT(pAsmResult->GetErrorBuffer(&text));
-      const char *pStart = (const char *)text->GetBufferPointer();
-      std::string msg(pStart);
-      IFTMSG(resultStatus, msg);
-      return;
+      errors = GetErrorText(pAsmResult);
+      return resultStatus;
     }
     IFT(pAsmResult->GetResult(&pContainerBlob));
+  }
+
+  CComPtr<IDxcOperationResult> pResult;
+  UINT32 flags = DxcValidatorFlags_InPlaceEdit;
+  if (StructuralOnly)
+    flags |= DxcValidatorFlags_StructuralOnly;
+  IFT(pValidator->Validate(pContainerBlob, flags, &pResult));
+
+  HRESULT status;
+  IFT(pResult->GetStatus(&status));
+  if (FAILED(status))
+    errors = GetErrorText(pResult);
+  return status;
+}
+
+void DxvContext::Validate() {
+  CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcValidator> pValidator;
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
+  IFT(m_dxcSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+
+  std::string errors;
+  HRESULT status = ValidateFile(StringRefUtf16(InputFilename), pAssembler,
+                                pValidator, errors);
+  if (FAILED(status)) {
+    IFTMSG(status, errors);
+  } else {
+    printf("Validation succeed.");
+  }
+}
+
+static void CollectDirectoryFiles(const std::wstring &dir,
+                                  std::vector<std::wstring> &files) {
+  WIN32_FIND_DATAW findData;
+  HANDLE hFind = FindFirstFileW((dir + L"\\*").c_str(), &findData);
+  if (hFind == INVALID_HANDLE_VALUE)
+    return;
+  do {
+    if (wcscmp(findData.cFileName, L".") == 0 ||
+        wcscmp(findData.cFileName, L"..") == 0)
+      continue;
+    std::wstring path = dir + L"\\" + findData.cFileName;
+    if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      CollectDirectoryFiles(path, files);
+    else
+      files.emplace_back(std::move(path));
+  } while (FindNextFileW(hFind, &findData));
+  FindClose(hFind);
+}
+
+static void CollectBatchFiles(DxcDllSupport &dxcSupport,
+                              std::vector<std::wstring> &files) {
+  std::wstring batchInput = Unicode::UTF8ToUTF16StringOrThrow(BatchInput.c_str());
+  DWORD attributes = GetFileAttributesW(batchInput.c_str());
+  if (attributes == INVALID_FILE_ATTRIBUTES)
+    IFT(HRESULT_FROM_WIN32(GetLastError()));
+  if (attributes & FILE_ATTRIBUTE_DIRECTORY) {
+    CollectDirectoryFiles(batchInput, files);
+    return;
+  }
+
+  // A list file names one input per line; blank lines are skipped.
+  CComPtr<IDxcBlobEncoding> pList;
+  ReadFileIntoBlob(dxcSupport, batchInput.c_str(), &pList);
+  const char *pText = (const char *)pList->GetBufferPointer();
+  const char *pEnd = pText + pList->GetBufferSize();
+  while (pText < pEnd) {
+    const char *pLineEnd = std::find(pText, pEnd, '\n');
+    std::string line(pText, pLineEnd);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+      line.pop_back();
+    if (!line.empty())
+      files.emplace_back(Unicode::UTF8ToUTF16StringOrThrow(line.c_str()));
+    pText = pLineEnd + 1;
+  }
+}
 
+unsigned DxvContext::ValidateBatch() {
+  std::vector<std::wstring> files;
+  CollectBatchFiles(m_dxcSupport, files);
+
+  struct FileResult {
+    HRESULT Status = S_OK;
+    std::string Errors;
+  };
+  std::vector<FileResult> results(files.size());
+
+  unsigned threadCount = BatchThreads;
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min<unsigned>(threadCount, std::max<size_t>(files.size(), 1));
+
+  // Each worker owns its assembler and validator; files are handed out one
+  // at a time so a few slow containers do not stall a whole slice.
+  std::atomic<size_t> nextFile(0);
+  auto worker = [&]() {
+    CComPtr<IDxcAssembler> pAssembler;
     CComPtr<IDxcValidator> pValidator;
-    CComPtr<IDxcOperationResult> pResult;
-
-    IFT(m_dxcSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
-    IFT(pValidator->Validate(pContainerBlob, DxcValidatorFlags_InPlaceEdit, &pResult));
-
-    HRESULT status;
-    IFT(pResult->GetStatus(&status));
-
-    if (FAILED(status)) {
-      CComPtr<IDxcBlobEncoding> text;
-      IFT(pResult->GetErrorBuffer(&text));
-      const char *pStart = (const char *)text->GetBufferPointer();
-      std::string msg(pStart);
-      IFTMSG(status, msg);
-    } else {
-      printf("Validation succeed.");
+    HRESULT hr = m_dxcSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler);
+    if (SUCCEEDED(hr))
+      hr = m_dxcSupport.CreateInstance(CLSID_DxcValidator, &pValidator);
+    for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+      FileResult &result = results[i];
+      if (FAILED(hr)) {
+        result.Status = hr;
+        continue;
+      }
+      try {
+        result.Status =
+            ValidateFile(files[i].c_str(), pAssembler, pValidator, result.Errors);
+      } catch (const ::hlsl::Exception &hlslException) {
+        result.Status = hlslException.hr;
+        result.Errors = hlslException.msg;
+      } catch (std::bad_alloc &) {
+        result.Status = E_OUTOFMEMORY;
+      } catch (...) {
+        result.Status = E_FAIL;
+      }
     }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+
+  unsigned failed = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    const FileResult &result = results[i];
+    if (SUCCEEDED(result.Status))
+      continue;
+    ++failed;
+    std::string fileName = Unicode::UTF16ToUTF8StringOrThrow(files[i].c_str());
+    printf("%s: error 0x%08x\n", fileName.c_str(), result.Status);
+    if (!result.Errors.empty())
+      printf("%s\n", result.Errors.c_str());
   }
+  printf("Validated %u files: %u succeeded, %u failed.\n",
+         (unsigned)files.size(), (unsigned)files.size() - failed, failed);
+  return failed;
 }
 
 int __cdecl main(int argc,  _In_reads_z_(argc) const char **argv) {
@@ -98,6 +255,8 @@ int __cdecl main(int argc,  _In_reads_z_(argc) const char **argv) {
 
     DxvContext context(dxcSupport);
     pStage = "Validation";
+    if (!BatchInput.empty())
+      return context.ValidateBatch() == 0 ? 0 : 1;
     context.Validate();
   } catch (const ::hlsl::Exception &hlslException) {
     try {
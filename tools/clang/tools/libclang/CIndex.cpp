@@ -84,6 +84,7 @@ CXTranslationUnit cxtu::MakeCXTranslationUnit(CIndexer *CIdx, ASTUnit *AU) {
   D->Diagnostics = nullptr;
   D->OverridenCursorsPool = createOverridenCXCursorsPool();
   D->CommentToXML = nullptr;
+  D->ReferenceIndex = nullptr; // HLSL Change
   return D;
 }
 
@@ -2894,6 +2895,8 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
   llvm::InitializeAllAsmParsers();
 
   CIndexer *CIdxr = new CIndexer();
+  // HLSL Change - units that include the same files share their tokens.
+  CIdxr->PreambleTokenCaches = std::make_shared<PreambleTokenCacheStore>();
 
   if (excludeDeclarationsFromPCH)
     CIdxr->setOnlyLocalDecls();
@@ -3131,7 +3134,8 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
       CacheCodeCompletionResults, IncludeBriefCommentsInCodeCompletion,
       /*AllowPCHWithCompilerErrors=*/true, SkipFunctionBodies,
       /*UserFilesAreVolatile=*/true, ForSerialization, &ErrUnit,
-      CXXIdx->HlslLangExtensions)); // HLSL Change - add language extensions
+      CXXIdx->HlslLangExtensions, // HLSL Change - add language extensions
+      CXXIdx->PreambleTokenCaches)); // HLSL Change - share preamble tokens
 
   // Early failures in LoadFromCommandLine may return with ErrUnit unset.
   if (!Unit && !ErrUnit) {
@@ -3329,6 +3333,7 @@ void clang_disposeTranslationUnit(CXTranslationUnit CTUnit) {
     delete static_cast<CXDiagnosticSetImpl *>(CTUnit->Diagnostics);
     disposeOverridenCXCursorsPool(CTUnit->OverridenCursorsPool);
     delete CTUnit->CommentToXML;
+    cxtu::disposeReferenceIndex(CTUnit); // HLSL Change
     delete CTUnit;
   }
 }
@@ -3361,6 +3366,7 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
   // Reset the associated diagnostics.
   delete static_cast<CXDiagnosticSetImpl*>(TU->Diagnostics);
   TU->Diagnostics = nullptr;
+  cxtu::disposeReferenceIndex(TU); // HLSL Change
 
   CIndexer *CXXIdx = TU->CIdx;
   if (CXXIdx->isOptEnabled(CXGlobalOpt_ThreadBackgroundPriorityForEditing))
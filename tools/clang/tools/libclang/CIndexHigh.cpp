@@ -14,7 +14,9 @@
 #include "CXTranslationUnit.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/Frontend/ASTUnit.h"
+#include "llvm/ADT/DenseMap.h" // HLSL Change
 #include "llvm/Support/Compiler.h"
+#include <map> // HLSL Change
 
 using namespace clang;
 using namespace cxcursor;
@@ -76,7 +78,7 @@ struct FindFileIdRefVisitData {
   ///
   /// we consider the canonical decl of the constructor decl to be the class
   /// itself, so both 'C' can be highlighted.
-  const Decl *getCanonical(const Decl *D) const {
+  static const Decl *getCanonical(const Decl *D) { // HLSL Change - static
     if (!D)
       return nullptr;
 
@@ -212,6 +214,103 @@ static enum CXChildVisitResult findFileIdRefVisit(CXCursor cursor,
   return CXChildVisit_Recurse;
 }
 
+// HLSL Change Starts
+namespace {
+
+/// \brief The references in one file, by the canonical declaration they
+/// refer to, in the order of the AST.
+struct FileIdRefs {
+  typedef SmallVector<std::pair<CXCursor, SourceLocation>, 4> RefsTy;
+  llvm::DenseMap<const Decl *, RefsTy> Refs;
+  /// \brief Whether a referenced method overrides another, so that matching
+  /// its references needs more than the canonical declaration.
+  bool HasOverridingMethods = false;
+};
+
+/// \brief The references of a translation unit, indexed file by file on the
+/// first query for each. Dropped when the unit is reparsed.
+struct IdRefIndex {
+  std::map<FileID, std::unique_ptr<FileIdRefs>> Files;
+};
+
+struct IndexFileIdRefsVisitData {
+  ASTContext &Ctx;
+  FileID FID;
+  FileIdRefs &Refs;
+};
+
+} // end anonymous namespace.
+
+/// \brief Records every reference \c findFileIdRefVisit could report for a
+/// query without a selector identifier.
+static enum CXChildVisitResult indexFileIdRefVisit(CXCursor cursor,
+                                                   CXCursor parent,
+                                                   CXClientData client_data) {
+  CXCursor declCursor = clang_getCursorReferenced(cursor);
+  if (!clang_isDeclaration(declCursor.kind))
+    return CXChildVisit_Recurse;
+
+  const Decl *D = cxcursor::getCursorDecl(declCursor);
+  if (!D)
+    return CXChildVisit_Continue;
+
+  IndexFileIdRefsVisitData *data = (IndexFileIdRefsVisitData *)client_data;
+  cursor = cxcursor::getSelectorIdentifierCursor(-1, cursor);
+  if (clang_isExpression(cursor.kind) &&
+      cursor.kind != CXCursor_DeclRefExpr &&
+      cursor.kind != CXCursor_MemberRefExpr)
+    return CXChildVisit_Recurse;
+
+  SourceLocation
+    Loc = cxloc::translateSourceLocation(clang_getCursorLocation(cursor));
+  SourceManager &SM = data->Ctx.getSourceManager();
+  if (Loc.isMacroID()) {
+    bool isMacroArg;
+    Loc = getFileSpellingLoc(SM, Loc, isMacroArg);
+    if (!isMacroArg)
+      return CXChildVisit_Recurse;
+  }
+  if (SM.getFileID(Loc) != data->FID)
+    return CXChildVisit_Recurse;
+
+  D = FindFileIdRefVisitData::getCanonical(D);
+  if (isa<ObjCMethodDecl>(D))
+    data->Refs.HasOverridingMethods = true;
+  else if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(D))
+    data->Refs.HasOverridingMethods |= MD->size_overridden_methods() != 0;
+  data->Refs.Refs[D].push_back(std::make_pair(cursor, Loc));
+  return CXChildVisit_Recurse;
+}
+
+static const FileIdRefs &getFileIdRefs(CXTranslationUnit TU, FileID FID) {
+  if (!TU->ReferenceIndex)
+    TU->ReferenceIndex = new IdRefIndex();
+  std::unique_ptr<FileIdRefs> &Refs =
+      static_cast<IdRefIndex *>(TU->ReferenceIndex)->Files[FID];
+  if (Refs)
+    return *Refs;
+
+  Refs.reset(new FileIdRefs());
+  ASTContext &Ctx = cxtu::getASTUnit(TU)->getASTContext();
+  SourceManager &SM = Ctx.getSourceManager();
+  IndexFileIdRefsVisitData data = { Ctx, FID, *Refs };
+  SourceRange Range(SM.getLocForStartOfFile(FID), SM.getLocForEndOfFile(FID));
+  CursorVisitor IndexVisitor(TU,
+                             indexFileIdRefVisit, &data,
+                             /*VisitPreprocessorLast=*/true,
+                             /*VisitIncludedEntities=*/false,
+                             Range,
+                             /*VisitDeclsOnly=*/true);
+  IndexVisitor.visitFileRegion();
+  return *Refs;
+}
+
+void cxtu::disposeReferenceIndex(CXTranslationUnit TU) {
+  delete static_cast<IdRefIndex *>(TU->ReferenceIndex);
+  TU->ReferenceIndex = nullptr;
+}
+// HLSL Change Ends
+
 static bool findIdRefsInFile(CXTranslationUnit TU, CXCursor declCursor,
                              const FileEntry *File,
                              CXCursorAndRangeVisitor Visitor) {
@@ -227,6 +326,30 @@ static bool findIdRefsInFile(CXTranslationUnit TU, CXCursor declCursor,
                               cxcursor::getSelectorIdentifierIndex(declCursor),
                               Visitor);
 
+  // HLSL Change Starts - look the references up in the index of the file,
+  // unless matching them takes overridden methods into account.
+  if (FID.isInvalid())
+    return false;
+  const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(data.Dcl);
+  if (data.SelectorIdIdx == -1 && !isa<ObjCMethodDecl>(data.Dcl) &&
+      !(MD && MD->size_overridden_methods() != 0)) {
+    const FileIdRefs &Refs = getFileIdRefs(TU, FID);
+    if (!MD || !Refs.HasOverridingMethods) {
+      auto Found = Refs.Refs.find(data.Dcl);
+      if (Found == Refs.Refs.end())
+        return false;
+      ASTContext &Ctx = data.getASTContext();
+      for (const auto &Ref : Found->second) {
+        if (Visitor.visit(Visitor.context, Ref.first,
+                          cxloc::translateSourceRange(Ctx, Ref.second)) ==
+            CXVisit_Break)
+          return true;
+      }
+      return false;
+    }
+  }
+  // HLSL Change Ends
+
   if (const DeclContext *DC = Dcl->getParentFunctionOrMethod()) {
     return clang_visitChildren(cxcursor::MakeCXCursor(cast<Decl>(DC), TU),
                                findFileIdRefVisit, &data);
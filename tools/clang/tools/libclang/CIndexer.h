@@ -34,6 +34,7 @@ namespace llvm {
 
 namespace clang {
 class ASTUnit;
+class PreambleTokenCacheStore; // HLSL Change
 class MacroInfo;
 class MacroDefinitionRecord;
 class SourceLocation;
@@ -54,7 +55,11 @@ public:
       : OnlyLocalDecls(false), DisplayDiagnostics(false),
         Options(CXGlobalOpt_None), PCHContainerOps(PCHContainerOps) {}
 
-  hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr; // HLSL Change
+  // HLSL Change Starts
+  hlsl::DxcLangExtensionsHelperApply *HlslLangExtensions = nullptr;
+  /// \brief The preamble token caches shared by the units of this index.
+  std::shared_ptr<PreambleTokenCacheStore> PreambleTokenCaches;
+  // HLSL Change Ends
 
   /// \brief Whether we only want to see "local" declarations (that did not
   /// come from a previous precompiled header). If false, we want to see all
@@ -33,6 +33,7 @@ struct CXTranslationUnitImpl {
   void *Diagnostics;
   void *OverridenCursorsPool;
   clang::index::CommentToXMLConverter *CommentToXML;
+  void *ReferenceIndex; // HLSL Change
 };
 
 namespace clang {
@@ -50,6 +51,12 @@ static inline ASTUnit *getASTUnit(CXTranslationUnit TU) {
 /// corrupted.
 bool isASTReadError(ASTUnit *AU);
 
+// HLSL Change Starts
+/// \brief Frees the index of references built by clang_findReferencesInFile,
+/// which no longer matches the AST once the unit is reparsed.
+void disposeReferenceIndex(CXTranslationUnit TU);
+// HLSL Change Ends
+
 static inline bool isNotUsableTU(CXTranslationUnit TU) {
   return !TU;
 }
@@ -34,6 +34,7 @@
 #include "dxcisenseimpl.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MSFileSystem.h"
+#include "CXTranslationUnit.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -1235,6 +1236,175 @@ HRESULT DxcIntelliSense::CreateUnsavedFile(LPCSTR fileName, LPCSTR contents, uns
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static bool IsRequestCancelled(void* pContext)
+{
+  return ((std::atomic<bool>*)pContext)->load();
+}
+
+DxcIntelliSenseRequest::DxcIntelliSenseRequest(RequestKind kind)
+  : m_dwRef(0), m_status(DxcIntelliSenseRequest_Pending), m_cancelRequested(false),
+    Kind(kind), Line(0), Column(0), UnsavedFiles(nullptr), NumUnsavedFiles(0)
+{
+  m_cancellation.IsCancelled = IsRequestCancelled;
+  m_cancellation.pContext = &m_cancelRequested;
+}
+
+DxcIntelliSenseRequest::~DxcIntelliSenseRequest()
+{
+  if (UnsavedFiles != nullptr)
+  {
+    CleanupUnsavedFiles(UnsavedFiles, NumUnsavedFiles);
+  }
+}
+
+bool DxcIntelliSenseRequest::Start()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_status != DxcIntelliSenseRequest_Pending)
+  {
+    return false;
+  }
+  m_status = DxcIntelliSenseRequest_Running;
+  return true;
+}
+
+static
+std::string GetCompletionTypedText(CXCompletionString completion)
+{
+  unsigned chunkCount = clang_getNumCompletionChunks(completion);
+  for (unsigned i = 0; i < chunkCount; ++i)
+  {
+    if (clang_getCompletionChunkKind(completion, i) == CXCompletionChunk_TypedText)
+    {
+      CXString text = clang_getCompletionChunkText(completion, i);
+      const char* pText = clang_getCString(text);
+      std::string result(pText ? pText : "");
+      clang_disposeString(text);
+      return result;
+    }
+  }
+  return std::string();
+}
+
+void DxcIntelliSenseRequest::AddCompletions(const CXCompletionResult* results, unsigned count)
+{
+  // Convert outside the lock, so readers only wait for the append.
+  std::vector<std::pair<DxcCursorKind, std::string> > completions;
+  completions.reserve(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    completions.emplace_back((DxcCursorKind)results[i].CursorKind,
+                             GetCompletionTypedText(results[i].CompletionString));
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& completion : completions)
+  {
+    m_completions.emplace_back(std::move(completion));
+  }
+}
+
+void DxcIntelliSenseRequest::AddDiagnostic(CXDiagnostic diagnostic)
+{
+  CXString text = clang_formatDiagnostic(diagnostic, clang_defaultDiagnosticDisplayOptions());
+  const char* pText = clang_getCString(text);
+  std::pair<DxcDiagnosticSeverity, std::string> entry(
+    (DxcDiagnosticSeverity)clang_getDiagnosticSeverity(diagnostic), pText ? pText : "");
+  clang_disposeString(text);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_diagnostics.emplace_back(std::move(entry));
+}
+
+void DxcIntelliSenseRequest::Finish(bool succeeded)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_cancelRequested)
+    m_status = DxcIntelliSenseRequest_Cancelled;
+  else
+    m_status = succeeded ? DxcIntelliSenseRequest_Completed : DxcIntelliSenseRequest_Failed;
+  m_finished.notify_all();
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::GetStatus(DxcIntelliSenseRequestStatus* pStatus)
+{
+  if (pStatus == nullptr) return E_POINTER;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  *pStatus = m_status;
+  return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::Wait(UINT32 timeoutMs)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto isFinished = [this] {
+    return m_status != DxcIntelliSenseRequest_Pending && m_status != DxcIntelliSenseRequest_Running;
+  };
+  if (timeoutMs == INFINITE)
+  {
+    m_finished.wait(lock, isFinished);
+    return S_OK;
+  }
+  return m_finished.wait_for(lock, std::chrono::milliseconds(timeoutMs), isFinished)
+    ? S_OK : S_FALSE;
+}
+
+HRESULT DxcIntelliSenseRequest::Cancel()
+{
+  m_cancelRequested = true;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_status == DxcIntelliSenseRequest_Pending)
+  {
+    m_status = DxcIntelliSenseRequest_Cancelled;
+    m_finished.notify_all();
+  }
+  return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::GetNumCompletions(unsigned* pValue)
+{
+  if (pValue == nullptr) return E_POINTER;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  *pValue = (unsigned)m_completions.size();
+  return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::GetCompletionAt(unsigned index, DxcCursorKind* pKind, LPSTR* pTypedText)
+{
+  if (pKind == nullptr || pTypedText == nullptr) return E_POINTER;
+  *pTypedText = nullptr;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (index >= m_completions.size()) return E_INVALIDARG;
+  *pKind = m_completions[index].first;
+  return CoTaskMemAllocString(m_completions[index].second.c_str(), pTypedText);
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::GetNumDiagnostics(unsigned* pValue)
+{
+  if (pValue == nullptr) return E_POINTER;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  *pValue = (unsigned)m_diagnostics.size();
+  return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DxcIntelliSenseRequest::GetDiagnosticAt(unsigned index, DxcDiagnosticSeverity* pSeverity, LPSTR* pText)
+{
+  if (pSeverity == nullptr || pText == nullptr) return E_POINTER;
+  *pText = nullptr;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (index >= m_diagnostics.size()) return E_INVALIDARG;
+  *pSeverity = m_diagnostics[index].first;
+  return CoTaskMemAllocString(m_diagnostics[index].second.c_str(), pText);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 DxcSourceLocation::DxcSourceLocation() : m_dwRef(0)
 {
 }
@@ -1443,11 +1613,24 @@ HRESULT DxcToken::GetSpelling(LPSTR* pValue)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-DxcTranslationUnit::DxcTranslationUnit() : m_tu(nullptr), m_dwRef(0)
+DxcTranslationUnit::DxcTranslationUnit() : m_tu(nullptr), m_dwRef(0), m_asyncShutdown(false)
 {
 }
 
 DxcTranslationUnit::~DxcTranslationUnit() {
+  // Cancel outstanding requests, and wait for the one running to stop.
+  {
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    m_asyncShutdown = true;
+    for (auto& request : m_asyncQueue)
+      request->Cancel();
+    if (m_asyncRunning != nullptr)
+      m_asyncRunning->Cancel();
+  }
+  m_asyncWake.notify_all();
+  if (m_asyncThread.joinable())
+    m_asyncThread.join();
+
   if (m_tu != nullptr) {
     // TODO: until an interface to file access is defined and implemented, simply fall back to pure Win32/CRT calls.
     // Also, note that this can throw / fail in a destructor, which is a big no-no.
@@ -1596,6 +1779,173 @@ HRESULT DxcTranslationUnit::Reparse(
   return reparseResult == 0 ? S_OK : E_FAIL;
 }
 
+HRESULT DxcTranslationUnit::QueueRequest(
+  DxcIntelliSenseRequest* request,
+  IDxcIntelliSenseRequest** pRequest)
+{
+  try
+  {
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    // A reparse is for newer text than anything queued before it, and a
+    // completion supersedes earlier completions.
+    for (auto& queued : m_asyncQueue)
+    {
+      if (request->Kind == DxcIntelliSenseRequest::Reparse || queued->Kind == request->Kind)
+        queued->Cancel();
+    }
+    if (m_asyncRunning != nullptr &&
+        (request->Kind == DxcIntelliSenseRequest::Reparse || m_asyncRunning->Kind == request->Kind))
+    {
+      m_asyncRunning->Cancel();
+    }
+
+    m_asyncQueue.push_back(request);
+    if (!m_asyncThread.joinable())
+    {
+      m_asyncThread = std::thread(&DxcTranslationUnit::AsyncWorkerMain, this);
+    }
+  }
+  CATCH_CPP_RETURN_HRESULT();
+
+  m_asyncWake.notify_one();
+  request->AddRef();
+  *pRequest = request;
+  return S_OK;
+}
+
+void DxcTranslationUnit::AsyncWorkerMain()
+{
+  // TODO: until an interface to file access is defined and implemented, simply fall back to pure Win32/CRT calls.
+  ::llvm::sys::fs::MSFileSystem* msfPtr;
+  CreateMSFileSystemForDisk(&msfPtr);
+  assert(msfPtr != nullptr);
+  std::auto_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+
+  ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+  assert(!pts.error_code());
+
+  for (;;)
+  {
+    CComPtr<DxcIntelliSenseRequest> request;
+    {
+      std::unique_lock<std::mutex> lock(m_asyncMutex);
+      m_asyncWake.wait(lock, [this] { return m_asyncShutdown || !m_asyncQueue.empty(); });
+      // Queued requests are drained even on shutdown, so their waiters wake.
+      if (m_asyncQueue.empty())
+        return;
+      request = m_asyncQueue.front();
+      m_asyncQueue.pop_front();
+      m_asyncRunning = request;
+    }
+
+    RunRequest(request);
+
+    std::lock_guard<std::mutex> lock(m_asyncMutex);
+    m_asyncRunning.Release();
+  }
+}
+
+void DxcTranslationUnit::RunRequest(DxcIntelliSenseRequest* request)
+{
+  // Completions are published in batches, so callers can show the best
+  // matches while the rest are converted.
+  const unsigned CompletionBatchSize = 64;
+
+  if (!request->Start())
+    return;
+
+  clang::ASTUnit* unit = clang::cxtu::getASTUnit(m_tu);
+  unit->Cancellation = &request->GetCancellationState();
+
+  bool succeeded;
+  if (request->Kind == DxcIntelliSenseRequest::Reparse)
+  {
+    succeeded = 0 == clang_reparseTranslationUnit(m_tu,
+      request->NumUnsavedFiles, request->UnsavedFiles, clang_defaultReparseOptions(m_tu));
+    unsigned diagCount = clang_getNumDiagnostics(m_tu);
+    for (unsigned i = 0; i < diagCount; ++i)
+    {
+      CXDiagnostic diag = clang_getDiagnostic(m_tu, i);
+      request->AddDiagnostic(diag);
+      clang_disposeDiagnostic(diag);
+    }
+  }
+  else
+  {
+    CXCodeCompleteResults* results = clang_codeCompleteAt(m_tu,
+      request->FileName.c_str(), request->Line, request->Column,
+      request->UnsavedFiles, request->NumUnsavedFiles, clang_defaultCodeCompleteOptions());
+    succeeded = results != nullptr;
+    if (results != nullptr)
+    {
+      clang_sortCodeCompletionResults(results->Results, results->NumResults);
+      for (unsigned i = 0; i < results->NumResults && !request->IsCancelRequested(); i += CompletionBatchSize)
+      {
+        request->AddCompletions(results->Results + i,
+          std::min(CompletionBatchSize, results->NumResults - i));
+      }
+      unsigned diagCount = clang_codeCompleteGetNumDiagnostics(results);
+      for (unsigned i = 0; i < diagCount; ++i)
+      {
+        CXDiagnostic diag = clang_codeCompleteGetDiagnostic(results, i);
+        request->AddDiagnostic(diag);
+        clang_disposeDiagnostic(diag);
+      }
+      clang_disposeCodeCompleteResults(results);
+    }
+  }
+
+  unit->Cancellation = nullptr;
+  request->Finish(succeeded);
+}
+
+_Use_decl_annotations_
+HRESULT DxcTranslationUnit::ReparseAsync(
+  IDxcUnsavedFile** unsaved_files,
+  unsigned num_unsaved_files,
+  IDxcIntelliSenseRequest** pRequest)
+{
+  if (pRequest == nullptr) return E_POINTER;
+  *pRequest = nullptr;
+  if (m_tu == nullptr) return E_FAIL;
+
+  try
+  {
+    CComPtr<DxcIntelliSenseRequest> request =
+      new DxcIntelliSenseRequest(DxcIntelliSenseRequest::Reparse);
+    IFR(SetupUnsavedFiles(unsaved_files, num_unsaved_files, &request->UnsavedFiles));
+    request->NumUnsavedFiles = num_unsaved_files;
+    return QueueRequest(request, pRequest);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+}
+
+_Use_decl_annotations_
+HRESULT DxcTranslationUnit::CodeCompleteAsync(
+  const char* fileName, unsigned line, unsigned column,
+  IDxcUnsavedFile** unsaved_files,
+  unsigned num_unsaved_files,
+  IDxcIntelliSenseRequest** pRequest)
+{
+  if (pRequest == nullptr) return E_POINTER;
+  *pRequest = nullptr;
+  if (fileName == nullptr) return E_INVALIDARG;
+  if (m_tu == nullptr) return E_FAIL;
+
+  try
+  {
+    CComPtr<DxcIntelliSenseRequest> request =
+      new DxcIntelliSenseRequest(DxcIntelliSenseRequest::CodeComplete);
+    request->FileName = fileName;
+    request->Line = line;
+    request->Column = column;
+    IFR(SetupUnsavedFiles(unsaved_files, num_unsaved_files, &request->UnsavedFiles));
+    request->NumUnsavedFiles = num_unsaved_files;
+    return QueueRequest(request, pRequest);
+  }
+  CATCH_CPP_RETURN_HRESULT();
+}
+
 _Use_decl_annotations_
 HRESULT DxcTranslationUnit::GetCursorForLocation(IDxcSourceLocation* location, IDxcCursor** pResult)
 {
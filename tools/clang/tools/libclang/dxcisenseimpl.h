@@ -17,6 +17,14 @@
 #include "dxc/dxcapi.internal.h"
 #include "dxc/Support/microcom.h"
 #include "dxc/Support/DxcLangExtensionsHelper.h"
+#include "dxc/Support/Cancellation.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Forward declarations.
 class DxcCursor;
@@ -24,6 +32,7 @@ class DxcDiagnostic;
 class DxcFile;
 class DxcIndex;
 class DxcIntelliSense;
+class DxcIntelliSenseRequest;
 class DxcSourceLocation;
 class DxcSourceRange;
 class DxcTranslationUnit;
@@ -218,6 +227,57 @@ public:
       _Outptr_result_nullonfailure_ IDxcUnsavedFile** pResult);
 };
 
+class DxcIntelliSenseRequest : public IDxcIntelliSenseRequest
+{
+public:
+  enum RequestKind { Reparse, CodeComplete };
+
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  std::mutex m_mutex;
+  std::condition_variable m_finished;
+  DxcIntelliSenseRequestStatus m_status;  // Guarded by m_mutex.
+  std::vector<std::pair<DxcCursorKind, std::string> > m_completions;  // Guarded by m_mutex.
+  std::vector<std::pair<DxcDiagnosticSeverity, std::string> > m_diagnostics;  // Guarded by m_mutex.
+  std::atomic<bool> m_cancelRequested;
+  hlsl::CancellationState m_cancellation;
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject)
+  {
+    return DoBasicQueryInterface<IDxcIntelliSenseRequest>(this, iid, ppvObject);
+  }
+
+  // What to run; set before the request is queued, then read by the worker.
+  RequestKind Kind;
+  std::string FileName;
+  unsigned Line;
+  unsigned Column;
+  CXUnsavedFile* UnsavedFiles;
+  unsigned NumUnsavedFiles;
+
+  DxcIntelliSenseRequest(RequestKind kind);
+  ~DxcIntelliSenseRequest();
+
+  // Moves a pending request to running; returns false if it was cancelled.
+  bool Start();
+  void AddCompletions(_In_count_(count) const CXCompletionResult* results, unsigned count);
+  void AddDiagnostic(CXDiagnostic diagnostic);
+  void Finish(bool succeeded);
+  bool IsCancelRequested() const { return m_cancelRequested; }
+  hlsl::CancellationState& GetCancellationState() { return m_cancellation; }
+
+  __override HRESULT STDMETHODCALLTYPE GetStatus(_Out_ DxcIntelliSenseRequestStatus* pStatus);
+  __override HRESULT STDMETHODCALLTYPE Wait(UINT32 timeoutMs);
+  __override HRESULT STDMETHODCALLTYPE Cancel();
+  __override HRESULT STDMETHODCALLTYPE GetNumCompletions(_Out_ unsigned* pValue);
+  __override HRESULT STDMETHODCALLTYPE GetCompletionAt(unsigned index,
+    _Out_ DxcCursorKind* pKind, _Outptr_result_z_ LPSTR* pTypedText);
+  __override HRESULT STDMETHODCALLTYPE GetNumDiagnostics(_Out_ unsigned* pValue);
+  __override HRESULT STDMETHODCALLTYPE GetDiagnosticAt(unsigned index,
+    _Out_ DxcDiagnosticSeverity* pSeverity, _Outptr_result_z_ LPSTR* pText);
+};
+
 class DxcSourceLocation : public IDxcSourceLocation
 {
 private:
@@ -293,16 +353,30 @@ public:
   __override HRESULT STDMETHODCALLTYPE GetSpelling(_Outptr_result_maybenull_ LPSTR* pValue);
 };
 
-class DxcTranslationUnit : public IDxcTranslationUnit
+class DxcTranslationUnit : public IDxcTranslationUnit, public IDxcTranslationUnitAsync
 {
 private:
     DXC_MICROCOM_REF_FIELD(m_dwRef)
     CXTranslationUnit m_tu;
+
+    // Asynchronous requests run in order on m_asyncThread, which is started
+    // by the first request.
+    std::mutex m_asyncMutex;
+    std::condition_variable m_asyncWake;
+    std::deque<CComPtr<DxcIntelliSenseRequest> > m_asyncQueue;  // Guarded by m_asyncMutex.
+    CComPtr<DxcIntelliSenseRequest> m_asyncRunning;             // Guarded by m_asyncMutex.
+    bool m_asyncShutdown;                                       // Guarded by m_asyncMutex.
+    std::thread m_asyncThread;
+
+    HRESULT QueueRequest(_In_ DxcIntelliSenseRequest* request,
+      _COM_Outptr_ IDxcIntelliSenseRequest** pRequest);
+    void AsyncWorkerMain();
+    void RunRequest(_In_ DxcIntelliSenseRequest* request);
 public:
     DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
     HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject)
     {
-      return DoBasicQueryInterface<IDxcTranslationUnit>(this, iid, ppvObject);
+      return DoBasicQueryInterface<IDxcTranslationUnit, IDxcTranslationUnitAsync>(this, iid, ppvObject);
     }
 
     DxcTranslationUnit();
@@ -337,6 +411,17 @@ public:
       _Out_ unsigned* errorLength,
       _Out_ BSTR* errorMessage);
     __override HRESULT STDMETHODCALLTYPE GetInclusionList(_Out_ unsigned* pResultCount, _Outptr_result_buffer_(*pResultCount) IDxcInclusion*** pResult);
+
+    // IDxcTranslationUnitAsync implementation.
+    __override HRESULT STDMETHODCALLTYPE ReparseAsync(
+      _In_count_(num_unsaved_files) IDxcUnsavedFile** unsaved_files,
+      unsigned num_unsaved_files,
+      _COM_Outptr_ IDxcIntelliSenseRequest** pRequest);
+    __override HRESULT STDMETHODCALLTYPE CodeCompleteAsync(
+      _In_z_ const char* fileName, unsigned line, unsigned column,
+      _In_count_(num_unsaved_files) IDxcUnsavedFile** unsaved_files,
+      unsigned num_unsaved_files,
+      _COM_Outptr_ IDxcIntelliSenseRequest** pRequest);
 };
 
 class DxcType : public IDxcType
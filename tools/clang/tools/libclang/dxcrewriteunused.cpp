@@ -41,6 +41,7 @@
 #include "dxc/Support/dxcapi.impl.h"
 #include "dxc/Support/DxcLangExtensionsHelper.h"
 #include "dxc/Support/dxcfilesystem.h"
+#include <unordered_map>
 
 #define CP_UTF16 1200
 
@@ -62,47 +63,63 @@ public:
   }
 };
 
-class VarReferenceVisitor : public RecursiveASTVisitor<VarReferenceVisitor> {
+// The functions and variables that one function refers to directly.
+struct FunctionReferences {
+  SmallVector<FunctionDecl*, 8> Functions;
+  SmallVector<VarDecl*, 8> Variables;
+};
+
+class ReferenceCollector : public RecursiveASTVisitor<ReferenceCollector> {
 private:
-  SmallPtrSet<VarDecl*, 128>& m_unusedGlobals;
-  SmallPtrSet<FunctionDecl*, 128>& m_visitedFunctions;
-  SmallVector<FunctionDecl*, 32>& m_pendingFunctions;
+  FunctionReferences &m_references;
 public:
-  VarReferenceVisitor(
-    SmallPtrSet<VarDecl*, 128>& unusedGlobals,
-    SmallPtrSet<FunctionDecl*, 128>& visitedFunctions,
-    SmallVector<FunctionDecl*, 32>& pendingFunctions) :
-    m_unusedGlobals(unusedGlobals),
-    m_visitedFunctions(visitedFunctions),
-    m_pendingFunctions(pendingFunctions) {
-  }
+  ReferenceCollector(FunctionReferences &references)
+      : m_references(references) {}
 
   bool VisitDeclRefExpr(DeclRefExpr* ref) {
     ValueDecl* valueDecl = ref->getDecl();
     FunctionDecl* fnDecl = dyn_cast_or_null<FunctionDecl>(valueDecl);
     if (fnDecl != nullptr) {
-      if (!m_visitedFunctions.count(fnDecl)) {
-        m_pendingFunctions.push_back(fnDecl);
-      }
+      m_references.Functions.push_back(fnDecl);
     }
     else {
       VarDecl* varDecl = dyn_cast_or_null<VarDecl>(valueDecl);
       if (varDecl != nullptr) {
-        m_unusedGlobals.erase(varDecl);
+        m_references.Variables.push_back(varDecl);
       }
     }
     return true;
   }
 };
 
-static void raw_string_ostream_to_CoString(raw_string_ostream &o, _Outptr_result_z_ LPSTR *pResult) {
-  std::string& s = o.str(); // .str() will flush automatically
+// Collects the references of each function the first time an entry point
+// reaches it, so function bodies are walked once however many entry points
+// are trimmed from the same parse.
+class ReferenceCache {
+private:
+  std::unordered_map<FunctionDecl*, FunctionReferences> m_references;
+public:
+  const FunctionReferences &GetReferences(FunctionDecl *fnDecl) {
+    auto found = m_references.find(fnDecl);
+    if (found != m_references.end())
+      return found->second;
+    FunctionReferences &references = m_references[fnDecl];
+    ReferenceCollector(references).TraverseDecl(fnDecl);
+    return references;
+  }
+};
+
+static void string_to_CoString(const std::string &s, _Outptr_result_z_ LPSTR *pResult) {
   *pResult = (LPSTR)CoTaskMemAlloc(s.size() + 1);
   if (*pResult == nullptr) 
     throw std::bad_alloc();
   strcpy_s(*pResult, s.size() + 1, s.c_str());
 }
 
+static void raw_string_ostream_to_CoString(raw_string_ostream &o, _Outptr_result_z_ LPSTR *pResult) {
+  string_to_CoString(o.str(), pResult); // .str() will flush automatically
+}
+
 static
 void SetupCompilerForRewrite(CompilerInstance &compiler,
                              _In_ DxcLangExtensionsHelper *helper,
@@ -232,25 +249,107 @@ ParsedSemanticDefineList hlsl::CollectSemanticDefinesParsedByCompiler(CompilerIn
   return parsedDefines;
 }
 
+// Writes the source trimmed to what the entry point uses, by hiding the
+// unused globals and functions while the translation unit is printed.
+static void WriteRewriteUnusedForEntryPoint(
+    CompilerInstance &compiler, _In_ DxcLangExtensionsHelper *pHelper,
+    ReferenceCache &references, const SmallPtrSetImpl<VarDecl*> &globals,
+    const SmallPtrSetImpl<FunctionDecl*> &functions, StringRef entryPoint,
+    raw_ostream &o, raw_ostream &w) {
+  ASTContext& C = compiler.getASTContext();
+  TranslationUnitDecl *tu = C.getTranslationUnitDecl();
+
+  w << "//found " << globals.size() << " globals as candidates for removal\n";
+  w << "//found " << functions.size() << " functions as candidates for removal\n";
+
+  DeclContext::lookup_result l = tu->lookup(DeclarationName(&C.Idents.get(entryPoint)));
+  if (l.empty()) {
+    w << "//entry point not found\n";
+    return;
+  }
+
+  w << "//entry point found\n";
+  NamedDecl *entryDecl = l.front();
+  FunctionDecl *entryFnDecl = dyn_cast_or_null<FunctionDecl>(entryDecl);
+  if (entryFnDecl == nullptr) {
+    o << "//entry point found but is not a function declaration\n";
+    return;
+  }
+
+  // Traverse reachable functions and variables.
+  SmallPtrSet<VarDecl*, 128> unusedGlobals(globals.begin(), globals.end());
+  SmallPtrSet<FunctionDecl*, 128> visitedFunctions;
+  SmallVector<FunctionDecl*, 32> pendingFunctions;
+  pendingFunctions.push_back(entryFnDecl);
+  while (!pendingFunctions.empty() && !unusedGlobals.empty()) {
+    FunctionDecl* pendingDecl = pendingFunctions.pop_back_val();
+    visitedFunctions.insert(pendingDecl);
+    const FunctionReferences &refs = references.GetReferences(pendingDecl);
+    for (FunctionDecl *fnDecl : refs.Functions) {
+      if (!visitedFunctions.count(fnDecl)) {
+        pendingFunctions.push_back(fnDecl);
+      }
+    }
+    for (VarDecl *varDecl : refs.Variables) {
+      unusedGlobals.erase(varDecl);
+    }
+  }
+
+  // Don't bother doing work if there are no globals to remove.
+  if (unusedGlobals.empty()) {
+    w << "//no unused globals found - no work to be done\n";
+    StringRef contents = C.getSourceManager().getBufferData(C.getSourceManager().getMainFileID());
+    o << contents;
+    return;
+  }
+
+  w << "//found " << unusedGlobals.size() << " globals to remove\n";
+
+  // Don't remove visited functions.
+  SmallVector<Decl*, 128> unusedDecls(unusedGlobals.begin(), unusedGlobals.end());
+  for (FunctionDecl *fnDecl : functions) {
+    if (!visitedFunctions.count(fnDecl)) {
+      unusedDecls.push_back(fnDecl);
+    }
+  }
+  w << "//found " << unusedDecls.size() - unusedGlobals.size() << " functions to remove\n";
+
+  // Unused variables and functions are marked implicit, which the printer
+  // skips, rather than removed, so the same parse serves the next entry
+  // point. Candidates are never implicit to begin with.
+  for (Decl *unusedDecl : unusedDecls) {
+    unusedDecl->setImplicit(true);
+  }
+
+  o << "// Rewrite unused globals result:\n";
+  PrintingPolicy p = PrintingPolicy(C.getPrintingPolicy());
+  p.Indentation = 1;
+  tu->print(o, p);
+
+  for (Decl *unusedDecl : unusedDecls) {
+    unusedDecl->setImplicit(false);
+  }
+
+  WriteSemanticDefines(compiler, pHelper, o);
+}
+
+// Parses the source once and writes, for each entry point, the source with
+// the globals and functions it does not use removed, and its warnings.
 static
 HRESULT DoRewriteUnused(_In_ DxcLangExtensionsHelper *pHelper,
                      _In_ LPCSTR pFileName,
                      _In_ ASTUnit::RemappedFile *pRemap,
-                     _In_ LPCSTR pEntryPoint,
+                     ArrayRef<std::string> entryPoints,
                      _In_ LPCSTR pDefines,
-                     _Outptr_result_z_ LPSTR *pWarnings,
-                     _Outptr_result_z_ LPSTR *pResult) {
-  if (pWarnings != nullptr) *pWarnings = nullptr;
-  if (pResult != nullptr) *pResult = nullptr;
-
-  std::string s, warnings;
-  raw_string_ostream o(s);
-  raw_string_ostream w(warnings);
+                     std::vector<std::string> &warnings,
+                     std::vector<std::string> &results) {
+  std::string parseWarnings;
+  raw_string_ostream pw(parseWarnings);
 
   // Setup a compiler instance.
   CompilerInstance compiler;
   std::unique_ptr<TextDiagnosticPrinter> diagPrinter =
-      std::make_unique<TextDiagnosticPrinter>(w, &compiler.getDiagnosticOpts());  
+      std::make_unique<TextDiagnosticPrinter>(pw, &compiler.getDiagnosticOpts());  
   SetupCompilerForRewrite(compiler, pHelper, pFileName, diagPrinter.get(), pRemap, pDefines);
 
   // Parse the source file.
@@ -261,91 +360,37 @@ HRESULT DoRewriteUnused(_In_ DxcLangExtensionsHelper *pHelper,
   TranslationUnitDecl *tu = C.getTranslationUnitDecl();
 
   // Gather all global variables that are not in cbuffers and all functions.
-  SmallPtrSet<VarDecl*, 128> unusedGlobals;
-  SmallPtrSet<FunctionDecl*, 128> unusedFunctions;
+  SmallPtrSet<VarDecl*, 128> globals;
+  SmallPtrSet<FunctionDecl*, 128> functions;
   auto tuDeclsEnd = tu->decls_end();
   for (auto && tuDecl = tu->decls_begin(); tuDecl != tuDeclsEnd; ++tuDecl) {
     VarDecl* varDecl = dyn_cast_or_null<VarDecl>(*tuDecl);
     if (varDecl != nullptr) {
-      unusedGlobals.insert(varDecl);
+      globals.insert(varDecl);
       continue;
     }
 
     FunctionDecl* fnDecl = dyn_cast_or_null<FunctionDecl>(*tuDecl);
     if (fnDecl != nullptr) {
       if (fnDecl->hasBody()) {
-        unusedFunctions.insert(fnDecl);
+        functions.insert(fnDecl);
       }
     }
   }
 
-  w << "//found " << unusedGlobals.size() << " globals as candidates for removal\n";
-  w << "//found " << unusedFunctions.size() << " functions as candidates for removal\n";
-
-  DeclContext::lookup_result l = tu->lookup(DeclarationName(&C.Idents.get(StringRef(pEntryPoint))));
-  if (l.empty()) {
-    w << "//entry point not found\n";
-  }
-  else {
-    w << "//entry point found\n";
-    NamedDecl *entryDecl = l.front();
-    FunctionDecl *entryFnDecl = dyn_cast_or_null<FunctionDecl>(entryDecl);
-    if (entryFnDecl == nullptr) {
-      o << "//entry point found but is not a function declaration\n";
-    }
-    else {
-      // Traverse reachable functions and variables.
-      SmallPtrSet<FunctionDecl*, 128> visitedFunctions;
-      SmallVector<FunctionDecl*, 32> pendingFunctions;
-      VarReferenceVisitor visitor(unusedGlobals, visitedFunctions, pendingFunctions);
-      pendingFunctions.push_back(entryFnDecl);
-      while (!pendingFunctions.empty() && !unusedGlobals.empty()) {
-        FunctionDecl* pendingDecl = pendingFunctions.pop_back_val();
-        visitedFunctions.insert(pendingDecl);
-        visitor.TraverseDecl(pendingDecl);
-      }
-
-      // Don't bother doing work if there are no globals to remove.
-      if (unusedGlobals.empty()) {
-        w << "//no unused globals found - no work to be done\n";
-        StringRef contents = C.getSourceManager().getBufferData(C.getSourceManager().getMainFileID());
-        o << contents;
-      }
-      else {
-        w << "//found " << unusedGlobals.size() << " globals to remove\n";
-
-        // Don't remove visited functions.
-        auto visitedFunctionsEnd = visitedFunctions.end();
-        for (auto && visitedFn = visitedFunctions.begin(); visitedFn != visitedFunctionsEnd; ++visitedFn) {
-          unusedFunctions.erase(*visitedFn);
-        }
-        w << "//found " << unusedFunctions.size() << " functions to remove\n";
-
-        // Remove all unused variables and functions.
-        auto globalsEnd = unusedGlobals.end();
-        for (auto && unusedGlobal = unusedGlobals.begin(); unusedGlobal != globalsEnd; ++unusedGlobal) {
-          tu->removeDecl(*unusedGlobal);
-        }
-
-        auto functionsEnd = unusedFunctions.end();
-        for (auto && unusedFn = unusedFunctions.begin(); unusedFn != functionsEnd; ++unusedFn) {
-          tu->removeDecl(*unusedFn);
-        }
-
-        o << "// Rewrite unused globals result:\n";
-        PrintingPolicy p = PrintingPolicy(C.getPrintingPolicy());
-        p.Indentation = 1;
-        tu->print(o, p);
-
-        WriteSemanticDefines(compiler, pHelper, o);
-      }
-    }
+  pw.flush();
+  ReferenceCache references;
+  warnings.clear();
+  results.clear();
+  for (const std::string &entryPoint : entryPoints) {
+    std::string s, w = parseWarnings;
+    raw_string_ostream so(s), wo(w);
+    WriteRewriteUnusedForEntryPoint(compiler, pHelper, references, globals,
+                                    functions, entryPoint, so, wo);
+    results.push_back(std::move(so.str()));
+    warnings.push_back(std::move(wo.str()));
   }
 
-  // Flush and return results.
-  raw_string_ostream_to_CoString(o, pResult);
-  raw_string_ostream_to_CoString(w, pWarnings);
-
   if (compiler.getDiagnosticClient().getNumErrors() > 0)
     return E_FAIL;
   return S_OK;
@@ -425,7 +470,7 @@ HRESULT DoSimpleReWrite(_In_ DxcLangExtensionsHelper *pHelper,
   return S_OK;
 }
 
-class DxcRewriter : public IDxcRewriter, public IDxcLangExtensions {
+class DxcRewriter : public IDxcRewriter2, public IDxcLangExtensions {
 private:
   DXC_MICROCOM_REF_FIELD(m_dwRef)
   DxcLangExtensionsHelper m_langExtensionsHelper;
@@ -435,7 +480,7 @@ public:
   DXC_LANGEXTENSIONS_HELPER_IMPL(m_langExtensionsHelper)
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void **ppvObject) {
-    return DoBasicQueryInterface<IDxcRewriter, IDxcLangExtensions>(this, iid, ppvObject);
+    return DoBasicQueryInterface<IDxcRewriter, IDxcRewriter2, IDxcLangExtensions>(this, iid, ppvObject);
   }
 
   __override HRESULT STDMETHODCALLTYPE RemoveUnusedGlobals(_In_ IDxcBlobEncoding *pSource,
@@ -468,19 +513,84 @@ public:
       std::unique_ptr<ASTUnit::RemappedFile> pRemap(new ASTUnit::RemappedFile(fakeName, pBuffer.release()));
 
       CW2A utf8EntryPoint(pEntryPoint, CP_UTF8);
+      std::string entryPoint(utf8EntryPoint);
       std::string definesStr = DefinesToString(pDefines, defineCount);
 
-      LPSTR errors = nullptr;
-      LPSTR rewrite = nullptr;
+      std::vector<std::string> warnings, results;
       HRESULT status = DoRewriteUnused(
-          &m_langExtensionsHelper, fakeName, pRemap.get(), utf8EntryPoint,
-          defineCount > 0 ? definesStr.c_str() : nullptr, &errors, &rewrite);
-      return DxcOperationResult::CreateFromUtf8Strings(errors, rewrite, status,
-                                                       ppResult);
+          &m_langExtensionsHelper, fakeName, pRemap.get(), entryPoint,
+          defineCount > 0 ? definesStr.c_str() : nullptr, warnings, results);
+      // The errors are copied; the result takes ownership of the rewrite.
+      LPSTR rewrite = nullptr;
+      string_to_CoString(results.front(), &rewrite);
+      return DxcOperationResult::CreateFromUtf8Strings(
+          warnings.front().c_str(), rewrite, status, ppResult);
     }
     CATCH_CPP_RETURN_HRESULT();
   }
 
+  __override HRESULT STDMETHODCALLTYPE RemoveUnusedGlobalsForEntryPoints(
+      _In_ IDxcBlobEncoding *pSource,
+      _In_count_(entryPointCount) LPCWSTR *pEntryPoints,
+      _In_ UINT32 entryPointCount,
+      _In_count_(defineCount) DxcDefine *pDefines,
+      _In_ UINT32 defineCount,
+      _Out_writes_(entryPointCount) IDxcOperationResult **ppResults) {
+    if (pSource == nullptr || ppResults == nullptr ||
+        (entryPointCount > 0 && pEntryPoints == nullptr) ||
+        (defineCount > 0 && pDefines == nullptr))
+      return E_INVALIDARG;
+
+    for (UINT32 i = 0; i < entryPointCount; ++i)
+      ppResults[i] = nullptr;
+
+    CComPtr<IDxcBlobEncoding> utf8Source;
+    IFR(hlsl::DxcGetBlobAsUtf8(pSource, &utf8Source));
+
+    LPCSTR fakeName = "input.hlsl";
+
+    HRESULT hr = S_OK;
+    try {
+      ::llvm::sys::fs::MSFileSystem* msfPtr;
+      IFT(CreateMSFileSystemForDisk(&msfPtr));
+      std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+
+      ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+      IFTLLVM(pts.error_code());
+
+      StringRef Data((LPSTR)utf8Source->GetBufferPointer(), utf8Source->GetBufferSize());
+      std::unique_ptr<llvm::MemoryBuffer> pBuffer(llvm::MemoryBuffer::getMemBufferCopy(Data, fakeName));
+      std::unique_ptr<ASTUnit::RemappedFile> pRemap(new ASTUnit::RemappedFile(fakeName, pBuffer.release()));
+
+      std::vector<std::string> entryPoints;
+      for (UINT32 i = 0; i < entryPointCount; ++i)
+        entryPoints.push_back(std::string(CW2A(pEntryPoints[i], CP_UTF8)));
+      std::string definesStr = DefinesToString(pDefines, defineCount);
+
+      std::vector<std::string> warnings, results;
+      HRESULT status = DoRewriteUnused(
+          &m_langExtensionsHelper, fakeName, pRemap.get(), entryPoints,
+          defineCount > 0 ? definesStr.c_str() : nullptr, warnings, results);
+      for (UINT32 i = 0; i < entryPointCount && SUCCEEDED(hr); ++i) {
+        LPSTR rewrite = nullptr;
+        string_to_CoString(results[i], &rewrite);
+        hr = DxcOperationResult::CreateFromUtf8Strings(
+            warnings[i].c_str(), rewrite, status, &ppResults[i]);
+      }
+    }
+    CATCH_CPP_ASSIGN_HRESULT();
+
+    if (FAILED(hr)) {
+      for (UINT32 i = 0; i < entryPointCount; ++i) {
+        if (ppResults[i] != nullptr) {
+          ppResults[i]->Release();
+          ppResults[i] = nullptr;
+        }
+      }
+    }
+    return hr;
+  }
+
   __override HRESULT STDMETHODCALLTYPE 
   RewriteUnchanged(_In_ IDxcBlobEncoding *pSource,
                    _In_count_(defineCount) DxcDefine *pDefines,
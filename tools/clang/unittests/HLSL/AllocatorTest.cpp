@@ -16,6 +16,7 @@
 #include <cstdlib>
 #include <random>
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <vector>
 #include <set>
@@ -535,6 +536,7 @@ public:
   TEST_METHOD(Intersections);
   TEST_METHOD(GapFilling);
   TEST_METHOD(Allocate);
+  TEST_METHOD(AllocateScaling);
 
   void InitScenarios() {
     struct P {
@@ -754,3 +756,40 @@ TEST_F(AllocatorTest, Allocate) {
     TestSizesFn();
   }
 }
+
+TEST_F(AllocatorTest, AllocateScaling) {
+  WEX::TestExecution::SetVerifyOutput verifySettings(WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures);
+  // Bound resources on every even register leave single register gaps that
+  // arrays of two can't use; each array allocation used to rescan them all.
+  const unsigned count = 20000;
+  ElementVector elements;
+  elements.reserve(count * 3);
+  Allocator alloc(0, UINT_MAX);
+  for (unsigned i = 0; i < count; ++i) {
+    elements.emplace_back(i, i * 2, i * 2);
+    VERIFY_IS_NULL(alloc.Insert(&elements.back(), i * 2, i * 2));
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < count; ++i) {
+    unsigned pos = 0xFEFEFEFE;
+    elements.emplace_back(count + i, 0, 0);
+    VERIFY_IS_TRUE(alloc.Allocate(&elements.back(), 2, pos));
+    VERIFY_ARE_EQUAL(count * 2 + i * 2, pos);
+  }
+  // Single registers still go to the first gap.
+  for (unsigned i = 0; i < count; ++i) {
+    unsigned pos = 0xFEFEFEFE;
+    elements.emplace_back(count * 2 + i, 0, 0);
+    VERIFY_IS_TRUE(alloc.Allocate(&elements.back(), 1, pos));
+    VERIFY_ARE_EQUAL(i * 2 + 1, pos);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  WEX::Logging::Log::Comment(WEX::Common::String().Format(
+      L"Allocated %u spans around %u bound spans in %u ms", count * 2, count,
+      (unsigned)elapsed.count()));
+
+  VERIFY_ARE_EQUAL(count * 4, alloc.GetFirstFree());
+  VERIFY_ARE_EQUAL(count * 3, (unsigned)alloc.GetSpans().size());
+}
@@ -19,6 +19,8 @@
 #include <cassert>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <map>
 #include "dxc/HLSL/DxilContainer.h"
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.h"
@@ -31,6 +33,7 @@
 
 #include "llvm/Support/raw_os_ostream.h"
 #include "dxc/Support/Global.h"
+#include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/dxcapi.use.h"
 #include "dxc/Support/microcom.h"
 #include "dxc/Support/HLSLOptions.h"
@@ -316,6 +319,76 @@ public:
   }
 };
 
+// Serves one source for every include and records the names asked for.
+class TestIncludeHandlerUtf8 : public IDxcIncludeHandlerUtf8 {
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  dxc::DxcDllSupport &m_dllSupport;
+  std::string Source;
+  std::vector<std::string> FileNames;
+  TestIncludeHandlerUtf8(dxc::DxcDllSupport &dllSupport, const char *pSource)
+      : m_dwRef(0), m_dllSupport(dllSupport), Source(pSource) { }
+  __override HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject) {
+    return DoBasicQueryInterface<IDxcIncludeHandlerUtf8>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LoadSource(
+    _In_z_ LPCSTR pFilename,
+    _COM_Outptr_result_maybenull_ IDxcBlob **ppIncludeSource) {
+    FileNames.push_back(pFilename);
+    Utf8ToBlob(m_dllSupport, Source, ppIncludeSource);
+    return S_OK;
+  }
+};
+
+class TestResultStore : public IDxcCompileResultStore {
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  TestResultStore() : m_dwRef(0), LookupHits(0) { }
+  __override HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject) {
+    return DoBasicQueryInterface<IDxcCompileResultStore>(this, iid, ppvObject);
+  }
+
+  std::map<std::string, CComPtr<IDxcBlob>> Entries;
+  unsigned LookupHits;
+
+  static std::string KeyString(IDxcBlob *pKey) {
+    return std::string((const char *)pKey->GetBufferPointer(), pKey->GetBufferSize());
+  }
+
+  __override HRESULT STDMETHODCALLTYPE Lookup(_In_ IDxcBlob *pKey,
+                                              _COM_Outptr_result_maybenull_ IDxcBlob **ppContainer) {
+    *ppContainer = nullptr;
+    auto it = Entries.find(KeyString(pKey));
+    if (it != Entries.end()) {
+      ++LookupHits;
+      *ppContainer = it->second;
+      (*ppContainer)->AddRef();
+    }
+    return S_OK;
+  }
+  __override HRESULT STDMETHODCALLTYPE Store(_In_ IDxcBlob *pKey, _In_ IDxcBlob *pContainer) {
+    Entries[KeyString(pKey)] = pContainer;
+    return S_OK;
+  }
+};
+
+class TestCancellationToken : public IDxcCancellationToken {
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  bool Cancelled;
+  TestCancellationToken(bool cancelled) : m_dwRef(0), Cancelled(cancelled) { }
+  __override HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject) {
+    return DoBasicQueryInterface<IDxcCancellationToken>(this, iid, ppvObject);
+  }
+  __override BOOL STDMETHODCALLTYPE IsCancellationRequested() {
+    return Cancelled ? TRUE : FALSE;
+  }
+};
+
 class CompilerTest {
 public:
   BEGIN_TEST_CLASS(CompilerTest)
@@ -326,18 +399,44 @@ public:
   TEST_CLASS_SETUP(InitSupport);
 
   TEST_METHOD(CompileWhenDebugThenDIPresent)
+  TEST_METHOD(CompileWhenDebugThenLinesFoundByAddressAndLine)
 
   TEST_METHOD(CompileWhenDefinesThenApplied)
   TEST_METHOD(CompileWhenDefinesManyThenApplied)
+  TEST_METHOD(CompileBatchWhenMultipleTargetsThenAllProduced)
+  TEST_METHOD(CompilePipelineWhenOutputUnreadThenRemoved)
+  TEST_METHOD(CompilePermutationsWhenSamePreprocessedThenCompiledOnce)
+  TEST_METHOD(CompileAsyncWhenManyQueuedThenAllComplete)
+  TEST_METHOD(CompileWhenCancelledThenDistinctError)
+  TEST_METHOD(CompileWhenTimeReportThenPhasesReported)
+  TEST_METHOD(CompileWhenTimeReportThenBuiltinsCounted)
+  TEST_METHOD(CompileWhenPrintStatsThenPassEffectsReported)
+  TEST_METHOD(CompileWhenMemoryAccountingThenUsageReported)
+  TEST_METHOD(CompileWhenMemoryLimitExceededThenOutOfMemory)
+  TEST_METHOD(CompileWhenContextPoolingThenOutputMatches)
+  TEST_METHOD(CompileWhenIncrementalThenUnchangedEntryPointsReused)
+  TEST_METHOD(CompileWhenResultStoreThenDeadDefinesReuseResult)
   TEST_METHOD(CompileWhenEmptyThenFails)
   TEST_METHOD(CompileWhenIncorrectThenFails)
+  TEST_METHOD(CompileWhenNullTerminatedSourceThenSucceeds)
   TEST_METHOD(CompileWhenWorksThenDisassembleWorks)
   TEST_METHOD(CompileWhenDebugWorksThenStripDebug)
+  TEST_METHOD(CompileWhenLineTablesOnlyThenDebugPartSmaller)
   TEST_METHOD(CompileWhenWorksThenAddRemovePrivate)
   TEST_METHOD(CompileWithRootSignatureThenStripRootSignature)
+  TEST_METHOD(CompileWhenInProcessThenMetadataNotReloaded)
+  TEST_METHOD(CompileWhenValidator1_2ThenTypeAnnotationsCompact)
+  TEST_METHOD(CompileWhenSameRootSignatureThenSameHash)
+  TEST_METHOD(ContainerBuilderWhenBatchRootSignatureThenStamped)
+  TEST_METHOD(ValidatorWhenRootSignatureSetThenCompatibilityMatrix)
 
   TEST_METHOD(CompileWhenIncludeThenLoadInvoked)
+  TEST_METHOD(CompileWhenUtf8ThenOutputMatchesUtf16)
+  TEST_METHOD(CompileWhenParsedArgsThenOutputMatches)
   TEST_METHOD(CompileWhenIncludeThenLoadUsed)
+  TEST_METHOD(CompileWhenIncludeCacheThenLoadOnce)
+  TEST_METHOD(CompileWhenPackageThenIncludesNotLoaded)
+  TEST_METHOD(CompileWhenForcedIncludeThenPrologueApplied)
   TEST_METHOD(CompileWhenIncludeAbsoluteThenLoadAbsolute)
   TEST_METHOD(CompileWhenIncludeLocalThenLoadRelative)
   TEST_METHOD(CompileWhenIncludeSystemThenLoadNotRelative)
@@ -347,7 +446,10 @@ public:
   TEST_METHOD(CompileWhenIncludeHasPathThenOK)
 
   TEST_METHOD(CompileWhenODumpThenPassConfig)
+  TEST_METHOD(CompileWhenO1fastThenNoLoopPasses)
   TEST_METHOD(CompileWhenODumpThenOptimizerMatch)
+  TEST_METHOD(OptimizerWhenParsedModuleThenPipelinesReuseIt)
+  TEST_METHOD(OptimizerWhenContainerThenProgramOptimized)
   TEST_METHOD(CompileWhenVdThenProducesDxilContainer)
 
   TEST_METHOD(CompileWhenShaderModelMismatchAttributeThenFail)
@@ -376,6 +478,8 @@ public:
   TEST_METHOD(CodeGenArrayArg2)
   TEST_METHOD(CodeGenArrayArg3)
   TEST_METHOD(CodeGenArrayOfStruct)
+  TEST_METHOD(CodeGenLargeStructArray)
+  TEST_METHOD(CodeGenConstInitList)
   TEST_METHOD(CodeGenAsUint)
   TEST_METHOD(CodeGenAsUint2)
   TEST_METHOD(CodeGenAtomic)
@@ -385,6 +489,10 @@ public:
   TEST_METHOD(CodeGenBarycentrics1)
   TEST_METHOD(CodeGenBarycentricsThreeSV)
   TEST_METHOD(CodeGenBinary1)
+  TEST_METHOD(CodeGenBlockCounters)
+  TEST_METHOD(CodeGenBlockCountersLines)
+  TEST_METHOD(CodeGenBlockProfile)
+  TEST_METHOD(CodeGenCountersToLines)
   TEST_METHOD(CodeGenBoolComb)
   TEST_METHOD(CodeGenBoolSvTarget)
   TEST_METHOD(CodeGenCalcLod2DArray)
@@ -403,6 +511,8 @@ public:
   TEST_METHOD(CodeGenCbufferCopy2)
   TEST_METHOD(CodeGenCbufferCopy3)
   TEST_METHOD(CodeGenCbufferCopy4)
+  TEST_METHOD(CodeGenBufferCombine)
+  TEST_METHOD(CodeGenCbufferCoalesce)
   TEST_METHOD(CodeGenCbuffer_unused)
   TEST_METHOD(CodeGenCbuffer1_50)
   TEST_METHOD(CodeGenCbuffer1_51)
@@ -415,6 +525,7 @@ public:
   TEST_METHOD(CodeGenCbufferAlloc)
   TEST_METHOD(CodeGenCbufferAllocLegacy)
   TEST_METHOD(CodeGenCbufferInLoop)
+  TEST_METHOD(CodeGenCbufferPack)
   TEST_METHOD(CodeGenClass)
   TEST_METHOD(CodeGenClip)
   TEST_METHOD(CodeGenClipPlanes)
@@ -427,6 +538,8 @@ public:
   TEST_METHOD(CodeGenDivZero)
   TEST_METHOD(CodeGenDot1)
   TEST_METHOD(CodeGenDynamic_Resources)
+  TEST_METHOD(CodeGenDxilConstantTables)
+  TEST_METHOD(CodeGenDynamicIndexToSelect)
   TEST_METHOD(CodeGenEffectSkip)
   TEST_METHOD(CodeGenEliminateDynamicIndexing)
   TEST_METHOD(CodeGenEliminateDynamicIndexing2)
@@ -434,6 +547,7 @@ public:
   TEST_METHOD(CodeGenEliminateDynamicIndexing4)
   TEST_METHOD(CodeGenEliminateDynamicIndexing5)
   TEST_METHOD(CodeGenEliminateDynamicIndexing6)
+  TEST_METHOD(CodeGenEliminateDynamicIndexing7)
   TEST_METHOD(CodeGenEmpty)
   TEST_METHOD(CodeGenEmptyStruct)
   TEST_METHOD(CodeGenEnum1)
@@ -457,13 +571,18 @@ public:
   TEST_METHOD(CodeGenFloatMaxtessfactor)
   TEST_METHOD(CodeGenFModPS)
   TEST_METHOD(CodeGenFuncCast)
+  TEST_METHOD(CodeGenFunctionBudget)
   TEST_METHOD(CodeGenFunctionalCast)
   TEST_METHOD(CodeGenGather)
   TEST_METHOD(CodeGenGatherCmp)
   TEST_METHOD(CodeGenGatherCubeOffset)
   TEST_METHOD(CodeGenGatherOffset)
   TEST_METHOD(CodeGenGepZeroIdx)
+  TEST_METHOD(CodeGenGetDimensionsHoist)
   TEST_METHOD(CodeGenGloballyCoherent)
+  TEST_METHOD(CodeGenHandleHoist)
+  TEST_METHOD(CodeGenHoistSamples)
+  TEST_METHOD(CodeGenHsWidePatch)
   TEST_METHOD(CodeGenI32ColIdx)
   TEST_METHOD(CodeGenIcb1)
   TEST_METHOD(CodeGenIf1)
@@ -506,17 +625,20 @@ public:
   TEST_METHOD(CodeGenIntrinsic4_dbg)
   TEST_METHOD(CodeGenIntrinsic5)
   TEST_METHOD(CodeGenInvalidInputOutputTypes)
+  TEST_METHOD(CodeGenLazyFunctionBodies)
   TEST_METHOD(CodeGenLegacyStruct)
   TEST_METHOD(CodeGenLibCsEntry)
   TEST_METHOD(CodeGenLibCsEntry2)
   TEST_METHOD(CodeGenLibCsEntry3)
   TEST_METHOD(CodeGenLibEntries)
   TEST_METHOD(CodeGenLibEntries2)
+  TEST_METHOD(CodeGenLibFuncPropsOrder)
   TEST_METHOD(CodeGenLibResource)
   TEST_METHOD(CodeGenLibUnusedFunc)
   TEST_METHOD(CodeGenLitInParen)
   TEST_METHOD(CodeGenLiteralShift)
   TEST_METHOD(CodeGenLiveness1)
+  TEST_METHOD(CodeGenLoadToGather)
   TEST_METHOD(CodeGenLocalRes1)
   TEST_METHOD(CodeGenLocalRes4)
   TEST_METHOD(CodeGenLocalRes7)
@@ -530,6 +652,7 @@ public:
   TEST_METHOD(CodeGenMatParam)
   TEST_METHOD(CodeGenMatParam2)
  // TEST_METHOD(CodeGenMatParam3)
+  TEST_METHOD(CodeGenMatAffineMul)
   TEST_METHOD(CodeGenMatElt)
   TEST_METHOD(CodeGenMatInit)
   TEST_METHOD(CodeGenMatMulMat)
@@ -571,8 +694,10 @@ public:
   TEST_METHOD(CodeGenNegabs1)
   TEST_METHOD(CodeGenNoise)
   TEST_METHOD(CodeGenNonUniform)
+  TEST_METHOD(CodeGenNonUniformHandles)
   TEST_METHOD(CodeGenOptForNoOpt)
   TEST_METHOD(CodeGenOptForNoOpt2)
+  TEST_METHOD(CodeGenOptForNoOpt5)
   TEST_METHOD(CodeGenOptionGis)
   TEST_METHOD(CodeGenOptionWX)
   TEST_METHOD(CodeGenOutput1)
@@ -588,9 +713,15 @@ public:
   TEST_METHOD(CodeGenPrecise2)
   TEST_METHOD(CodeGenPrecise3)
   TEST_METHOD(CodeGenPrecise4)
+  TEST_METHOD(CodeGenPrecise5)
   TEST_METHOD(CodeGenPreciseOnCall)
   TEST_METHOD(CodeGenPreciseOnCallNot)
   TEST_METHOD(CodeGenPreserveAllOutputs)
+  TEST_METHOD(CodeGenPairHalfOps)
+  TEST_METHOD(CodeGenProfileRegions)
+  TEST_METHOD(CodeGenProfileRegionsPairing)
+  TEST_METHOD(CodeGenPruneRenderTargets)
+  TEST_METHOD(CodeGenPruneUnreadOutputs)
   TEST_METHOD(CodeGenRaceCond2)
   TEST_METHOD(CodeGenRaw_Buf1)
   TEST_METHOD(CodeGenRcp1)
@@ -624,6 +755,7 @@ public:
   TEST_METHOD(CodeGenSelfCopy)
   TEST_METHOD(CodeGenSelMat)
   TEST_METHOD(CodeGenShaderAttr)
+  TEST_METHOD(CodeGenShaderStats)
   TEST_METHOD(CodeGenShare_Mem_Dbg)
   TEST_METHOD(CodeGenShare_Mem_Phi)
   TEST_METHOD(CodeGenShare_Mem1)
@@ -652,6 +784,7 @@ public:
   TEST_METHOD(CodeGenSimpleHS6)
   TEST_METHOD(CodeGenSimpleHS7)
   TEST_METHOD(CodeGenSimpleHS8)
+  TEST_METHOD(CodeGenSimplifyBeforeInline)
   TEST_METHOD(CodeGenSMFail)
   TEST_METHOD(CodeGenSrv_Ms_Load1)
   TEST_METHOD(CodeGenSrv_Ms_Load2)
@@ -661,6 +794,7 @@ public:
   TEST_METHOD(CodeGenStaticGlobals2)
   TEST_METHOD(CodeGenStaticGlobals3)
   TEST_METHOD(CodeGenStaticGlobals4)
+  TEST_METHOD(CodeGenStaticGlobals5)
   TEST_METHOD(CodeGenStaticMatrix)
   TEST_METHOD(CodeGenStaticResource)
   TEST_METHOD(CodeGenStaticResource2)
@@ -682,6 +816,7 @@ public:
   TEST_METHOD(CodeGenSwizzleAtomic)
   TEST_METHOD(CodeGenSwizzleAtomic2)
   TEST_METHOD(CodeGenSwizzleIndexing)
+  TEST_METHOD(CodeGenTGSMBankConflicts)
   TEST_METHOD(CodeGenTempDbgInfo)
   TEST_METHOD(CodeGenTemp1)
   TEST_METHOD(CodeGenTemp2)
@@ -689,11 +824,14 @@ public:
   TEST_METHOD(CodeGenUav_Raw1)
   TEST_METHOD(CodeGenUav_Typed_Load_Store1)
   TEST_METHOD(CodeGenUav_Typed_Load_Store2)
+  TEST_METHOD(CodeGenUniformityStats)
   TEST_METHOD(CodeGenUint64_1)
   TEST_METHOD(CodeGenUint64_2)
   TEST_METHOD(CodeGenUintSample)
   TEST_METHOD(CodeGenUmaxObjectAtomic)
+  TEST_METHOD(CodeGenUnrollConstantIndex)
   TEST_METHOD(CodeGenUnrollDbg)
+  TEST_METHOD(CodeGenUnrollHintWarning)
   TEST_METHOD(CodeGenUnsignedShortHandMatrixVector)
   TEST_METHOD(CodeGenUnusedFunc)
   TEST_METHOD(CodeGenUnusedCB)
@@ -706,6 +844,7 @@ public:
   TEST_METHOD(CodeGenVecTrunc)
   TEST_METHOD(CodeGenWave)
   TEST_METHOD(CodeGenWaveNoOpt)
+  TEST_METHOD(CodeGenWaveUniform)
   TEST_METHOD(CodeGenWriteMaskBuf)
   TEST_METHOD(CodeGenWriteMaskBuf2)
   TEST_METHOD(CodeGenWriteMaskBuf3)
@@ -790,6 +929,10 @@ public:
   TEST_METHOD(CodeGenRootSigDefine11)
   TEST_METHOD(CodeGenCBufferStructArray)
   TEST_METHOD(PreprocessWhenValidThenOK)
+  TEST_METHOD(PreprocessWhenDependenciesThenIncludesListed)
+  TEST_METHOD(CompileWhenDependenciesThenIncludesListed)
+  TEST_METHOD(PreprocessWhenTokenCacheThenDefinesReevaluated)
+  TEST_METHOD(PreprocessToStreamWhenNormalizedThenLinesOnly)
   TEST_METHOD(WhenSigMismatchPCFunctionThenFail)
 
   // Dx11 Sample
@@ -1478,6 +1621,81 @@ TEST_F(CompilerTest, CompileWhenDebugThenDIPresent) {
 #endif
 }
 
+TEST_F(CompilerTest, CompileWhenDebugThenLinesFoundByAddressAndLine) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcLibrary> pLib;
+  CComPtr<IStream> pProgramStream;
+  CComPtr<IDiaDataSource> pDiaSource;
+  CComPtr<IDiaSession> pSession;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("float4 main(float4 pos : SV_Position) : SV_Target {\r\n"
+    "  float4 local = abs(pos);\r\n"
+    "  return local;\r\n"
+    "}", &pSource);
+  LPCWSTR args[] = { L"/Zi" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+    L"ps_6_0", args, _countof(args), nullptr, 0, nullptr, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcLibrary, &pLib));
+  VERIFY_SUCCEEDED(pLib->CreateStreamFromBlobReadOnly(pProgram, &pProgramStream));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcDiaDataSource, &pDiaSource));
+  VERIFY_SUCCEEDED(pDiaSource->loadDataFromIStream(pProgramStream));
+  VERIFY_SUCCEEDED(pDiaSource->openSession(&pSession));
+
+  // The source file is found by name and by id.
+  CComPtr<IDiaEnumInjectedSources> pInjectedSources;
+  CComPtr<IDiaSourceFile> pFile;
+  CComBSTR fileName;
+  LONG count;
+  VERIFY_SUCCEEDED(pSession->findInjectedSource(L"source.hlsl", &pInjectedSources));
+  VERIFY_SUCCEEDED(pInjectedSources->get_Count(&count));
+  VERIFY_ARE_EQUAL(1, count);
+  VERIFY_SUCCEEDED(pSession->findFileById(0, &pFile));
+  VERIFY_SUCCEEDED(pFile->get_fileName(&fileName));
+  VERIFY_ARE_EQUAL_WSTR(L"source.hlsl", (LPWSTR)fileName);
+
+  // Every line of the file is found again through its address.
+  CComPtr<IDiaEnumLineNumbers> pFileLines;
+  VERIFY_SUCCEEDED(pSession->findLines(nullptr, pFile, &pFileLines));
+  VERIFY_SUCCEEDED(pFileLines->get_Count(&count));
+  VERIFY_IS_GREATER_THAN(count, 0);
+  for (LONG i = 0; i < count; ++i) {
+    CComPtr<IDiaLineNumber> pLine;
+    CComPtr<IDiaEnumLineNumbers> pAddrLines;
+    CComPtr<IDiaLineNumber> pAddrLine;
+    DWORD rva, line, addrRva, addrLine;
+    VERIFY_SUCCEEDED(pFileLines->Item(i, &pLine));
+    VERIFY_SUCCEEDED(pLine->get_relativeVirtualAddress(&rva));
+    VERIFY_SUCCEEDED(pLine->get_lineNumber(&line));
+    VERIFY_SUCCEEDED(pSession->findLinesByRVA(rva, 1, &pAddrLines));
+    LONG addrCount;
+    VERIFY_SUCCEEDED(pAddrLines->get_Count(&addrCount));
+    VERIFY_ARE_EQUAL(1, addrCount);
+    VERIFY_SUCCEEDED(pAddrLines->Item(0, &pAddrLine));
+    VERIFY_SUCCEEDED(pAddrLine->get_relativeVirtualAddress(&addrRva));
+    VERIFY_SUCCEEDED(pAddrLine->get_lineNumber(&addrLine));
+    VERIFY_ARE_EQUAL(rva, addrRva);
+    VERIFY_ARE_EQUAL(line, addrLine);
+  }
+
+  // Lookups by line number only return that line.
+  CComPtr<IDiaEnumLineNumbers> pLine2;
+  VERIFY_SUCCEEDED(pSession->findLinesByLinenum(nullptr, pFile, 2, 0, &pLine2));
+  VERIFY_SUCCEEDED(pLine2->get_Count(&count));
+  VERIFY_IS_GREATER_THAN(count, 0);
+  for (LONG i = 0; i < count; ++i) {
+    CComPtr<IDiaLineNumber> pLine;
+    DWORD line;
+    VERIFY_SUCCEEDED(pLine2->Item(i, &pLine));
+    VERIFY_SUCCEEDED(pLine->get_lineNumber(&line));
+    VERIFY_ARE_EQUAL(2U, line);
+  }
+}
+
 TEST_F(CompilerTest, CompileWhenDefinesThenApplied) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1492,6 +1710,498 @@ TEST_F(CompilerTest, CompileWhenDefinesThenApplied) {
                                       _countof(defines), nullptr, &pResult));
 }
 
+TEST_F(CompilerTest, CompileBatchWhenMultipleTargetsThenAllProduced) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerBatch> pBatch;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pBatch));
+  CreateBlobFromText("float4 VSMain(float4 pos : POSITION) : SV_Position { return pos; }\r\n"
+                     "float4 PSMain() : SV_Target { return 1; }", &pSource);
+
+  DxcCompileTarget targets[] = {{L"VSMain", L"vs_6_0"}, {L"PSMain", L"ps_6_0"}};
+  IDxcOperationResult *results[_countof(targets)];
+  VERIFY_SUCCEEDED(pBatch->CompileBatch(pSource, L"source.hlsl", targets,
+                                        _countof(targets), nullptr, 0, nullptr,
+                                        0, nullptr, results));
+  for (IDxcOperationResult *pRawResult : results) {
+    CComPtr<IDxcOperationResult> pResult;
+    pResult.Attach(pRawResult);
+    CComPtr<IDxcBlob> pProgram;
+    CheckOperationSucceeded(pResult, &pProgram);
+    VERIFY_IS_NOT_NULL(hlsl::IsDxilContainerLike(pProgram->GetBufferPointer(),
+                                                 pProgram->GetBufferSize()));
+  }
+}
+
+TEST_F(CompilerTest, CompilePipelineWhenOutputUnreadThenRemoved) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerPipeline> pPipeline;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pPipeline));
+  CreateBlobFromText(
+    "struct VSOut { float4 pos : SV_Position; float4 color : COLOR;\r\n"
+    "               float2 uv : TEXCOORD; };\r\n"
+    "VSOut VSMain(float4 pos : POSITION) {\r\n"
+    "  VSOut o; o.pos = pos; o.color = pos * 2; o.uv = pos.xy; return o;\r\n"
+    "}\r\n"
+    "float4 PSMain(float4 pos : SV_Position, float4 color : COLOR) : SV_Target {\r\n"
+    "  return color;\r\n"
+    "}", &pSource);
+
+  DxcPipelineStage stages[] = {
+    { pSource, L"source.hlsl", L"VSMain", L"vs_6_0" },
+    { pSource, L"source.hlsl", L"PSMain", L"ps_6_0" },
+  };
+  IDxcOperationResult *pRawResults[_countof(stages)];
+  VERIFY_SUCCEEDED(pPipeline->CompilePipeline(stages, _countof(stages),
+                                              nullptr, 0, nullptr, 0, nullptr,
+                                              pRawResults));
+  CComPtr<IDxcOperationResult> pResults[_countof(stages)];
+  for (unsigned i = 0; i < _countof(stages); ++i)
+    pResults[i].Attach(pRawResults[i]);
+  CComPtr<IDxcBlob> pVertexProgram, pPixelProgram;
+  CheckOperationSucceeded(pResults[0], &pVertexProgram);
+  CheckOperationSucceeded(pResults[1], &pPixelProgram);
+
+  // The pixel shader does not read TEXCOORD, so only SV_Position and COLOR
+  // are left.
+  const hlsl::DxilContainerHeader *pContainer = hlsl::IsDxilContainerLike(
+      pVertexProgram->GetBufferPointer(), pVertexProgram->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pContainer);
+  const hlsl::DxilPartHeader *pPart = hlsl::GetDxilPartByType(
+      pContainer, hlsl::DxilFourCC::DFCC_OutputSignature);
+  VERIFY_IS_NOT_NULL(pPart);
+  const hlsl::DxilProgramSignature *pSignature =
+      (const hlsl::DxilProgramSignature *)hlsl::GetDxilPartData(pPart);
+  VERIFY_ARE_EQUAL(2u, pSignature->ParamCount);
+
+  // Stages out of pipeline order are rejected.
+  DxcPipelineStage reversed[] = { stages[1], stages[0] };
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+                   pPipeline->CompilePipeline(reversed, _countof(reversed),
+                                              nullptr, 0, nullptr, 0, nullptr,
+                                              pRawResults));
+}
+
+TEST_F(CompilerTest, CompilePermutationsWhenSamePreprocessedThenCompiledOnce) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerPermutations> pPermutations;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pPermutations));
+  CreateBlobFromText(
+    "#if USED\r\n"
+    "float4 main() : SV_Target { return 1; }\r\n"
+    "#else\r\n"
+    "float4 main() : SV_Target { return 0; }\r\n"
+    "#endif\r\n", &pSource);
+
+  // UNUSED never appears in the preprocessed text.
+  DxcDefine used[] = { { L"USED", L"1" } };
+  DxcDefine usedAndUnused[] = { { L"USED", L"1" }, { L"UNUSED", L"2" } };
+  DxcDefine notUsed[] = { { L"USED", L"0" } };
+  DxcDefineSet sets[] = {
+    { used, _countof(used) },
+    { usedAndUnused, _countof(usedAndUnused) },
+    { notUsed, _countof(notUsed) },
+  };
+  IDxcOperationResult *pResults[_countof(sets)];
+  UINT32 representatives[_countof(sets)];
+  VERIFY_SUCCEEDED(pPermutations->CompilePermutations(
+      pSource, L"source.hlsl", L"main", L"ps_6_0", nullptr, 0, sets,
+      _countof(sets), nullptr, pResults, representatives));
+  CComPtr<IDxcOperationResult> pResult0, pResult1, pResult2;
+  pResult0.Attach(pResults[0]);
+  pResult1.Attach(pResults[1]);
+  pResult2.Attach(pResults[2]);
+  VerifyOperationSucceeded(pResult0);
+  VerifyOperationSucceeded(pResult2);
+  VERIFY_ARE_EQUAL(0u, representatives[0]);
+  VERIFY_ARE_EQUAL(0u, representatives[1]);
+  VERIFY_ARE_EQUAL(2u, representatives[2]);
+  VERIFY_ARE_EQUAL(pResult0.p, pResult1.p);
+  VERIFY_ARE_NOT_EQUAL(pResult0.p, pResult2.p);
+}
+
+TEST_F(CompilerTest, CompileAsyncWhenManyQueuedThenAllComplete) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerAsync> pAsync;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pAsync));
+  CreateBlobFromText("float4 main() : SV_Target { return VAL; }", &pSource);
+
+  const unsigned JobCount = 8;
+  std::vector<CComPtr<IDxcAsyncOperationResult>> results(JobCount);
+  for (unsigned i = 0; i < JobCount; ++i) {
+    // The define storage goes away before the job runs; it must be copied.
+    std::wstring value = std::to_wstring(i);
+    DxcDefine define = { L"VAL", value.c_str() };
+    VERIFY_SUCCEEDED(pAsync->CompileAsync(pSource, L"source.hlsl", L"main",
+                                          L"ps_6_0", nullptr, 0, &define, 1,
+                                          nullptr, &results[i]));
+  }
+
+  for (unsigned i = 0; i < JobCount; ++i) {
+    BOOL complete;
+    VERIFY_SUCCEEDED(results[i]->Wait(INFINITE));
+    VERIFY_SUCCEEDED(results[i]->IsComplete(&complete));
+    VERIFY_IS_TRUE(complete);
+    VerifyOperationSucceeded(results[i]);
+  }
+}
+
+TEST_F(CompilerTest, CompileWhenCancelledThenDistinctError) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerCancellation> pCancellation;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<TestCancellationToken> pToken = new TestCancellationToken(false);
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pCancellation));
+  CreateBlobFromText("float4 main() : SV_Target { return 0; }", &pSource);
+
+  VERIFY_SUCCEEDED(pCancellation->CompileWithCancellation(
+      pSource, L"source.hlsl", L"main", L"ps_6_0", nullptr, 0, nullptr, 0,
+      nullptr, pToken, INFINITE, &pResult));
+  VerifyOperationSucceeded(pResult);
+  pResult.Release();
+
+  pToken->Cancelled = true;
+  VERIFY_ARE_EQUAL(DXC_E_COMPILATION_CANCELLED,
+                   pCancellation->CompileWithCancellation(
+                       pSource, L"source.hlsl", L"main", L"ps_6_0", nullptr, 0,
+                       nullptr, 0, nullptr, pToken, INFINITE, &pResult));
+
+  // An expired deadline cancels without a token.
+  pResult.Release();
+  VERIFY_ARE_EQUAL(DXC_E_COMPILATION_CANCELLED,
+                   pCancellation->CompileWithCancellation(
+                       pSource, L"source.hlsl", L"main", L"ps_6_0", nullptr, 0,
+                       nullptr, 0, nullptr, nullptr, 0, &pResult));
+}
+
+TEST_F(CompilerTest, CompileWhenTimeReportThenPhasesReported) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcTimeReportResult> pTimeReportResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pReport;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("float4 main() : SV_Target { return 0; }", &pSource);
+
+  LPCWSTR args[] = { L"-ftime-report" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args), nullptr,
+                                      0, nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pTimeReportResult));
+  VERIFY_SUCCEEDED(pTimeReportResult->GetTimeReport(&pReport));
+  VERIFY_IS_NOT_NULL(pReport.p);
+  std::string report = BlobToUtf8(pReport);
+  VERIFY_IS_TRUE(report.find("\"name\": \"Parse\"") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"Validate\"") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"peakWorkingSetBytes\"") != std::string::npos);
+
+  // Without the option, no report is attached.
+  pResult.Release();
+  pTimeReportResult.Release();
+  pReport.Release();
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pTimeReportResult));
+  VERIFY_SUCCEEDED(pTimeReportResult->GetTimeReport(&pReport));
+  VERIFY_IS_NULL(pReport.p);
+}
+
+TEST_F(CompilerTest, CompileWhenPrintStatsThenPassEffectsReported) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcPassStatisticsResult> pStatsResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pStats;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(
+      "struct S { float4 a[4]; };"
+      "float4 main(S s : A, uint i : B) : SV_Target { return s.a[i]; }",
+      &pSource);
+
+  LPCWSTR args[] = { L"-print-stats" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args), nullptr,
+                                      0, nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pStatsResult));
+  VERIFY_SUCCEEDED(pStatsResult->GetPassStatistics(&pStats));
+  VERIFY_IS_NOT_NULL(pStats.p);
+  std::string report = BlobToUtf8(pStats);
+  VERIFY_IS_TRUE(report.find("\"initial\": { \"functions\": ") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"SROA Parameter HLSL\", \"runs\": ") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"statistics\": [") != std::string::npos);
+
+  // Without the option, no report is attached.
+  pResult.Release();
+  pStatsResult.Release();
+  pStats.Release();
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pStatsResult));
+  VERIFY_SUCCEEDED(pStatsResult->GetPassStatistics(&pStats));
+  VERIFY_IS_NULL(pStats.p);
+}
+
+TEST_F(CompilerTest, CompileWhenTimeReportThenBuiltinsCounted) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcTimeReportResult> pTimeReportResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pReport;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(
+      "Texture2D t; SamplerState s;"
+      "float4 main(float2 uv : TEXCOORD) : SV_Target {"
+      "  return abs(t.Sample(s, uv));"
+      "}",
+      &pSource);
+
+  LPCWSTR args[] = { L"-ftime-report" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args), nullptr,
+                                      0, nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pTimeReportResult));
+  VERIFY_SUCCEEDED(pTimeReportResult->GetTimeReport(&pReport));
+  VERIFY_IS_NOT_NULL(pReport.p);
+  std::string report = BlobToUtf8(pReport);
+  // Only the object types the shader looks into get their methods.
+  VERIFY_IS_TRUE(report.find("\"name\": \"BuiltinObjectTypes\"") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"BuiltinMethodTemplates\"") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"BuiltinMethods\"") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"BuiltinFunctions\"") != std::string::npos);
+}
+
+TEST_F(CompilerTest, CompileWhenMemoryAccountingThenUsageReported) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcMemoryAccounting> pAccounting;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcMemoryUsageResult> pUsage;
+  CComPtr<IDxcBlobEncoding> pSource;
+  UINT64 peakBytes, totalBytes;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("float4 main() : SV_Target { return 0; }", &pSource);
+
+  // Without accounting, no usage is reported.
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pUsage));
+  VERIFY_ARE_EQUAL(S_FALSE, pUsage->GetMemoryUsage(&peakBytes, &totalBytes));
+
+  pResult.Release();
+  pUsage.Release();
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pAccounting));
+  VERIFY_SUCCEEDED(pAccounting->SetMemoryAccounting(TRUE, 0));
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pUsage));
+  VERIFY_ARE_EQUAL(S_OK, pUsage->GetMemoryUsage(&peakBytes, &totalBytes));
+  VERIFY_IS_TRUE(peakBytes > 0);
+  VERIFY_IS_TRUE(totalBytes >= peakBytes);
+}
+
+TEST_F(CompilerTest, CompileWhenMemoryLimitExceededThenOutOfMemory) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcMemoryAccounting> pAccounting;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pErrors;
+  HRESULT status;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pAccounting));
+  VERIFY_SUCCEEDED(pAccounting->SetMemoryAccounting(TRUE, 64 * 1024));
+  CreateBlobFromText("float4 main() : SV_Target { return 0; }", &pSource);
+
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&status));
+  VERIFY_ARE_EQUAL(E_OUTOFMEMORY, status);
+  VERIFY_SUCCEEDED(pResult->GetErrorBuffer(&pErrors));
+  std::string errors = BlobToUtf8(pErrors);
+  VERIFY_IS_TRUE(errors.find("memory limit") != std::string::npos);
+
+  // The compiler is still usable once the limit is lifted.
+  pResult.Release();
+  VERIFY_SUCCEEDED(pAccounting->SetMemoryAccounting(FALSE, 0));
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+}
+
+TEST_F(CompilerTest, CompileWhenContextPoolingThenOutputMatches) {
+  // The shaders declare types of the same name with different bodies, which
+  // a reused context must not carry from one compilation to the next.
+  const char *pSources[] = {
+    "struct S { float4 a; }; cbuffer C { S s; }; Texture2D T; SamplerState P;\n"
+    "float4 main(float2 uv : UV) : SV_Target { return s.a * T.Sample(P, uv); }",
+    "struct S { int2 b; float c; }; cbuffer C { S s; }; Buffer<int> B;\n"
+    "float4 main() : SV_Target { return s.b.x + s.c + B[s.b.y]; }",
+  };
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerContextPooling> pPooling;
+  CComPtr<IDxcBlob> pExpected[_countof(pSources)];
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  for (unsigned i = 0; i < _countof(pSources); ++i) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CreateBlobFromText(pSources[i], &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(&pExpected[i]));
+  }
+
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pPooling));
+  VERIFY_SUCCEEDED(pPooling->SetContextPooling(1));
+  // Alternate the shaders so that each compilation reuses the context of
+  // the other one.
+  for (unsigned n = 0; n < 4; ++n) {
+    unsigned i = n % _countof(pSources);
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CComPtr<IDxcBlob> pProgram;
+    CreateBlobFromText(pSources[i], &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+    VERIFY_ARE_EQUAL(pExpected[i]->GetBufferSize(), pProgram->GetBufferSize());
+    VERIFY_ARE_EQUAL(0, memcmp(pExpected[i]->GetBufferPointer(),
+                               pProgram->GetBufferPointer(),
+                               pProgram->GetBufferSize()));
+  }
+  VERIFY_SUCCEEDED(pPooling->SetContextPooling(0));
+}
+
+TEST_F(CompilerTest, CompileWhenIncrementalThenUnchangedEntryPointsReused) {
+  // The second source edits the helper only mainB calls; the third edits a
+  // declaration outside of function bodies.
+  const char *pSources[] = {
+    "cbuffer C { float4 g_a; float4 g_b; };\n"
+    "float4 helperA() { return g_a * 2; }\n"
+    "float4 helperB() { return g_b + 1; }\n"
+    "float4 mainA() : SV_Target { return helperA(); }\n"
+    "float4 mainB() : SV_Target { return helperB(); }",
+    "cbuffer C { float4 g_a; float4 g_b; };\n"
+    "float4 helperA() { return g_a * 2; }\n"
+    "float4 helperB() { return g_b - 1; }\n"
+    "float4 mainA() : SV_Target { return helperA(); }\n"
+    "float4 mainB() : SV_Target { return helperB(); }",
+    "cbuffer C { float4 g_b; float4 g_a; };\n"
+    "float4 helperA() { return g_a * 2; }\n"
+    "float4 helperB() { return g_b - 1; }\n"
+    "float4 mainA() : SV_Target { return helperA(); }\n"
+    "float4 mainB() : SV_Target { return helperB(); }",
+  };
+  const UINT32 expectedReused[] = { 0, 1, 1 };
+  const UINT32 expectedCompiled[] = { 2, 3, 5 };
+  LPCWSTR entryPoints[] = { L"mainA", L"mainB" };
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerIncremental> pIncremental;
+  CComPtr<IDxcBlob> pFirst[_countof(entryPoints)];
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pIncremental));
+  VERIFY_SUCCEEDED(pIncremental->SetIncremental(TRUE));
+  for (unsigned i = 0; i < _countof(pSources); ++i) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CreateBlobFromText(pSources[i], &pSource);
+    for (unsigned e = 0; e < _countof(entryPoints); ++e) {
+      CComPtr<IDxcOperationResult> pResult;
+      CComPtr<IDxcBlob> pProgram;
+      VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl",
+                                          entryPoints[e], L"ps_6_0", nullptr,
+                                          0, nullptr, 0, nullptr, &pResult));
+      VerifyOperationSucceeded(pResult);
+      VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+      if (i == 0)
+        pFirst[e] = pProgram;
+      // mainA is unchanged by the helper edit and gets the same container.
+      if (i == 1 && e == 0)
+        VERIFY_ARE_EQUAL(pFirst[e].p, pProgram.p);
+      if (i == 1 && e == 1)
+        VERIFY_ARE_NOT_EQUAL(pFirst[e].p, pProgram.p);
+    }
+    UINT32 reused, compiled;
+    VERIFY_SUCCEEDED(pIncremental->GetIncrementalCounts(&reused, &compiled));
+    VERIFY_ARE_EQUAL(expectedReused[i], reused);
+    VERIFY_ARE_EQUAL(expectedCompiled[i], compiled);
+  }
+  VERIFY_SUCCEEDED(pIncremental->SetIncremental(FALSE));
+}
+
+TEST_F(CompilerTest, CompileWhenResultStoreThenDeadDefinesReuseResult) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerResultCaching> pCaching;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<TestResultStore> pStore = new TestResultStore();
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pCaching));
+  VERIFY_SUCCEEDED(pCaching->SetResultStore(pStore));
+  CreateBlobFromText("float4 main() : SV_Target { return VAL; }", &pSource);
+
+  DxcDefine definesA[] = {{L"VAL", L"1"}, {L"UNUSED", L"1"}};
+  DxcDefine definesB[] = {{L"VAL", L"1"}, {L"UNUSED", L"2"}};
+  DxcDefine definesC[] = {{L"VAL", L"2"}};
+  CComPtr<IDxcOperationResult> pResultA, pResultB, pResultC;
+  CComPtr<IDxcBlob> pProgramA, pProgramB, pProgramC;
+
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, definesA,
+                                      _countof(definesA), nullptr, &pResultA));
+  CheckOperationSucceeded(pResultA, &pProgramA);
+  VERIFY_ARE_EQUAL(1U, pStore->Entries.size());
+  VERIFY_ARE_EQUAL(0U, pStore->LookupHits);
+
+  // Only a dead define changed, so the stored container is returned.
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, definesB,
+                                      _countof(definesB), nullptr, &pResultB));
+  CheckOperationSucceeded(pResultB, &pProgramB);
+  VERIFY_ARE_EQUAL(1U, pStore->LookupHits);
+  VERIFY_ARE_EQUAL(pProgramA.p, pProgramB.p);
+
+  // A define that reaches the source produces a new entry.
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, definesC,
+                                      _countof(definesC), nullptr, &pResultC));
+  CheckOperationSucceeded(pResultC, &pProgramC);
+  VERIFY_ARE_EQUAL(1U, pStore->LookupHits);
+  VERIFY_ARE_EQUAL(2U, pStore->Entries.size());
+}
+
 TEST_F(CompilerTest, CompileWhenDefinesManyThenApplied) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1568,6 +2278,24 @@ TEST_F(CompilerTest, CompileWhenIncorrectThenFails) {
   // WEX::Logging::Log::Comment(errorStringW.m_psz);
 }
 
+TEST_F(CompilerTest, CompileWhenNullTerminatedSourceThenSucceeds) {
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+
+  // The terminator is referenced in place rather than copied; it must not be
+  // seen as part of the source text.
+  const char program[] = "float4 main() : SV_Target { return 0; }";
+  for (SIZE_T size : { sizeof(program), sizeof(program) - 1 }) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CreateBlobPinned(program, size, CP_UTF8, &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+  }
+}
+
 TEST_F(CompilerTest, CompileWhenWorksThenDisassembleWorks) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1636,6 +2364,77 @@ TEST_F(CompilerTest, CompileWhenDebugWorksThenStripDebug) {
   VERIFY_IS_NULL(pPartHeader);
 }
 
+TEST_F(CompilerTest, CompileWhenLineTablesOnlyThenDebugPartSmaller) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("struct Light { float3 dir; float4 color; };\r\n"
+                     "cbuffer C { Light lights[4]; };\r\n"
+                     "float4 shade(float3 n, Light l) {\r\n"
+                     "  float ndotl = saturate(dot(n, l.dir));\r\n"
+                     "  return l.color * ndotl;\r\n"
+                     "}\r\n"
+                     "float4 main(float3 n : NORMAL) : SV_Target {\r\n"
+                     "  float4 sum = 0;\r\n"
+                     "  for (uint i = 0; i < 4; i++)\r\n"
+                     "    sum += shade(n, lights[i]);\r\n"
+                     "  return sum;\r\n"
+                     "}",
+                     &pSource);
+
+  // Compiles with the given debug flag, returning the debug part bitcode.
+  auto CompileDebugPart = [&](LPCWSTR debugArg, CComPtr<IDxcBlob> &pDebugPart,
+                              unsigned &elapsedMs) {
+    CComPtr<IDxcOperationResult> pResult;
+    CComPtr<IDxcBlob> pProgram;
+    LPCWSTR args[] = {debugArg};
+    auto startTime = std::chrono::steady_clock::now();
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", args, _countof(args),
+                                        nullptr, 0, nullptr, &pResult));
+    elapsedMs = (unsigned)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - startTime)
+                    .count();
+    VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+    hlsl::DxilContainerHeader *pHeader =
+        (hlsl::DxilContainerHeader *)(pProgram->GetBufferPointer());
+    hlsl::DxilPartHeader *pPartHeader = hlsl::GetDxilPartByType(
+        pHeader, hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL);
+    VERIFY_IS_NOT_NULL(pPartHeader);
+    const hlsl::DxilProgramHeader *pProgramHeader =
+        (const hlsl::DxilProgramHeader *)hlsl::GetDxilPartData(pPartHeader);
+    uint32_t bitcodeLength;
+    const char *pBitcode;
+    hlsl::GetDxilProgramBitcode(pProgramHeader, &pBitcode, &bitcodeLength);
+    CComPtr<IDxcLibrary> pLib;
+    VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcLibrary, &pLib));
+    VERIFY_SUCCEEDED(pLib->CreateBlobFromBlob(
+        pProgram, pBitcode - (char *)pProgram->GetBufferPointer(),
+        bitcodeLength, &pDebugPart));
+  };
+
+  CComPtr<IDxcBlob> pFullPart, pLinesPart;
+  unsigned fullMs, linesMs;
+  CompileDebugPart(L"/Zi", pFullPart, fullMs);
+  CompileDebugPart(L"/gline-tables-only", pLinesPart, linesMs);
+  WEX::Logging::Log::Comment(WEX::Common::String().Format(
+      L"Debug part: %u bytes in %u ms with /Zi, %u bytes in %u ms with "
+      L"/gline-tables-only",
+      (unsigned)pFullPart->GetBufferSize(), fullMs,
+      (unsigned)pLinesPart->GetBufferSize(), linesMs));
+  VERIFY_IS_TRUE(pLinesPart->GetBufferSize() < pFullPart->GetBufferSize());
+
+  // Locations and function scopes stay, variables and types go.
+  CComPtr<IDxcBlobEncoding> pDisassembly;
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pLinesPart, &pDisassembly));
+  std::string disText = BlobToUtf8(pDisassembly);
+  VERIFY_IS_TRUE(disText.find("!DILocation(line: 4") != std::string::npos);
+  VERIFY_IS_TRUE(disText.find("DISubprogram(name: \"main\"") != std::string::npos);
+  VERIFY_IS_TRUE(disText.find("DILocalVariable") == std::string::npos);
+  VERIFY_IS_TRUE(disText.find("DICompositeType") == std::string::npos);
+}
+
 TEST_F(CompilerTest, CompileWhenWorksThenAddRemovePrivate) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1732,7 +2531,379 @@ TEST_F(CompilerTest, CompileWithRootSignatureThenStripRootSignature) {
   VERIFY_IS_NULL(pPartHeader);
 }
 
-TEST_F(CompilerTest, CompileWhenIncludeThenLoadInvoked) {
+TEST_F(CompilerTest, CompileWhenInProcessThenMetadataNotReloaded) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcPassStatisticsResult> pStatsResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pStats;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlobEncoding> pDisassembly;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("[RootSignature(\"RootConstants(b0, num32BitConstants = 1)\")]\r\n"
+                     "float4 main(float a : A) : SV_Target {\r\n"
+                     "  return a;\r\n"
+                     "}",
+                     &pSource);
+  LPCWSTR args[] = { L"-print-stats" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args), nullptr,
+                                      0, nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+
+  // The high-level and DXIL modules stay live from codegen to the
+  // container, so the passes that load them from metadata find them loaded.
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pStatsResult));
+  VERIFY_SUCCEEDED(pStatsResult->GetPassStatistics(&pStats));
+  std::string report = BlobToUtf8(pStats);
+  VERIFY_IS_TRUE(report.find("\"name\": \"HLSL High-Level Metadata Ensure\", \"runs\": 1, \"changed\": 0") != std::string::npos);
+  VERIFY_IS_TRUE(report.find("\"name\": \"HLSL load DxilModule from metadata\", \"runs\": 1, \"changed\": 0") != std::string::npos);
+
+  // The root signature is only in its part, not in the program metadata.
+  VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+  hlsl::DxilContainerHeader *pContainerHeader =
+      (hlsl::DxilContainerHeader *)(pProgram->GetBufferPointer());
+  VERIFY_IS_NOT_NULL(hlsl::GetDxilPartByType(
+      pContainerHeader, hlsl::DxilFourCC::DFCC_RootSignature));
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pProgram, &pDisassembly));
+  std::string disassembly = BlobToUtf8(pDisassembly);
+  VERIFY_IS_TRUE(disassembly.find("dx.rootSignature") == std::string::npos);
+}
+
+TEST_F(CompilerTest, CompileWhenValidator1_2ThenTypeAnnotationsCompact) {
+  if (m_ver.m_ValMajor < 1 || (m_ver.m_ValMajor == 1 && m_ver.m_ValMinor < 2)) {
+    WEX::Logging::Log::Comment(L"Test skipped because it requires Validator 1.2.");
+    return;
+  }
+
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcValidator> pValidator;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlobEncoding> pDisassembly;
+  CComPtr<IDxcBlob> pAssembled;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+  CreateBlobFromText("struct Light { float3 dir; row_major float3x4 xform; };\r\n"
+                     "cbuffer Lights : register(b0) {\r\n"
+                     "  Light lights[2];\r\n"
+                     "  float4 tint;\r\n"
+                     "}\r\n"
+                     "float4 main(float4 a : A) : SV_Target {\r\n"
+                     "  return float4(mul(lights[1].xform, a) + lights[0].dir, 1) * tint;\r\n"
+                     "}",
+                     &pSource);
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+
+  // Struct annotations are packed arrays with a shared string table, rather
+  // than tag/value tuples per field.
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pProgram, &pDisassembly));
+  std::string disassembly = BlobToUtf8(pDisassembly);
+  VERIFY_IS_TRUE(disassembly.find(" = !{i32 2, !") != std::string::npos);
+  VERIFY_IS_TRUE(disassembly.find("!\"xform\"") != std::string::npos);
+  VERIFY_IS_TRUE(disassembly.find("i32 6, !\"xform\"") == std::string::npos);
+
+  // The loader reads them back for validation.
+  pResult.Release();
+  VERIFY_SUCCEEDED(pAssembler->AssembleToContainer(pDisassembly, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pAssembled));
+  pResult.Release();
+  VERIFY_SUCCEEDED(pValidator->Validate(pAssembled, DxcValidatorFlags_Default, &pResult));
+  VerifyOperationSucceeded(pResult);
+}
+
+TEST_F(CompilerTest, CompileWhenSameRootSignatureThenSameHash) {
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  auto compile = [&](const char *pText, BYTE *pDigest) -> HRESULT {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CComPtr<IDxcRootSignatureHashResult> pHashResult;
+    CreateBlobFromText(pText, &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult.QueryInterface(&pHashResult));
+    return pHashResult->GetRootSignatureHash(pDigest);
+  };
+
+  // The second compile of a root signature is served by the cache, and
+  // carries the same part as the first.
+  BYTE digest1[16], digest2[16], digest3[16], digest4[16];
+  VERIFY_ARE_EQUAL(S_OK, compile(
+      "[RootSignature(\"RootConstants(b0, num32BitConstants = 4)\")]\r\n"
+      "float4 main(float a : A) : SV_Target { return a; }", digest1));
+  VERIFY_ARE_EQUAL(S_OK, compile(
+      "[RootSignature(\"RootConstants(b0, num32BitConstants = 4)\")]\r\n"
+      "float4 main(float2 a : A) : SV_Target { return a.xyxy; }", digest2));
+  VERIFY_ARE_EQUAL(S_OK, compile(
+      "[RootSignature(\"RootConstants(b0, num32BitConstants = 8)\")]\r\n"
+      "float4 main(float a : A) : SV_Target { return a; }", digest3));
+  VERIFY_ARE_EQUAL(S_FALSE, compile(
+      "float4 main(float a : A) : SV_Target { return a; }", digest4));
+  VERIFY_ARE_EQUAL(0, memcmp(digest1, digest2, sizeof(digest1)));
+  VERIFY_ARE_NOT_EQUAL(0, memcmp(digest1, digest3, sizeof(digest1)));
+  BYTE zero[16] = {};
+  VERIFY_ARE_EQUAL(0, memcmp(digest4, zero, sizeof(digest4)));
+}
+
+TEST_F(CompilerTest, ContainerBuilderWhenBatchRootSignatureThenStamped) {
+  CComPtr<IDxcContainerBuilder> pBuilder;
+  CComPtr<IDxcContainerBuilderBatch> pBatch;
+  VERIFY_SUCCEEDED(CreateContainerBuilder(&pBuilder));
+  if (FAILED(pBuilder.QueryInterface(&pBatch))) {
+    WEX::Logging::Log::Comment(L"Container builder from dxil.dll does not support batches.");
+    return;
+  }
+
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  auto compile = [&](const char *pText, IDxcBlob **ppProgram) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CreateBlobFromText(pText, &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(ppProgram));
+  };
+
+  // Take the root signature part from one program.
+  CComPtr<IDxcBlob> pRSProgram;
+  compile("[RootSignature(\"RootConstants(b0, num32BitConstants = 1)\")] "
+          "float c; float4 main() : SV_Target { return c; }", &pRSProgram);
+  const hlsl::DxilPartHeader *pRSPart = hlsl::GetDxilPartByType(
+      (hlsl::DxilContainerHeader *)pRSProgram->GetBufferPointer(),
+      hlsl::DxilFourCC::DFCC_RootSignature);
+  VERIFY_IS_NOT_NULL(pRSPart);
+  CComPtr<IDxcBlobEncoding> pRootSignature;
+  CreateBlobPinned(pRSPart + 1, pRSPart->PartSize, CP_ACP, &pRootSignature);
+
+  // Stamp it onto a compatible program and one that uses a register the
+  // root signature doesn't declare.
+  CComPtr<IDxcBlob> pPrograms[2];
+  compile("float c; float4 main() : SV_Target { return c; }", &pPrograms[0]);
+  compile("Texture2D t; float4 main() : SV_Target { return t.Load(0); }",
+          &pPrograms[1]);
+  IDxcBlob *pContainers[] = { pPrograms[0], pPrograms[1] };
+  IDxcOperationResult *pResults[_countof(pContainers)];
+  VERIFY_SUCCEEDED(pBatch->AddRootSignatureToContainers(
+      pRootSignature, _countof(pContainers), pContainers, pResults));
+  CComPtr<IDxcOperationResult> pGood, pBad;
+  pGood.Attach(pResults[0]);
+  pBad.Attach(pResults[1]);
+
+  HRESULT status;
+  CComPtr<IDxcBlob> pStamped;
+  VerifyOperationSucceeded(pGood);
+  VERIFY_SUCCEEDED(pGood->GetResult(&pStamped));
+  const hlsl::DxilPartHeader *pStampedPart = hlsl::GetDxilPartByType(
+      (hlsl::DxilContainerHeader *)pStamped->GetBufferPointer(),
+      hlsl::DxilFourCC::DFCC_RootSignature);
+  VERIFY_IS_NOT_NULL(pStampedPart);
+  VERIFY_ARE_EQUAL(pRSPart->PartSize, pStampedPart->PartSize);
+  VERIFY_ARE_EQUAL(0, memcmp(pRSPart + 1, pStampedPart + 1, pRSPart->PartSize));
+
+  VERIFY_SUCCEEDED(pBad->GetStatus(&status));
+  VERIFY_ARE_EQUAL(DXC_E_INCORRECT_ROOT_SIGNATURE, status);
+}
+
+TEST_F(CompilerTest, ValidatorWhenRootSignatureSetThenCompatibilityMatrix) {
+  CComPtr<IDxcValidator> pValidator;
+  CComPtr<IDxcRootSignatureCompatibility> pCompat;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+  if (FAILED(pValidator.QueryInterface(&pCompat))) {
+    WEX::Logging::Log::Comment(L"Validator from dxil.dll does not check root signature sets.");
+    return;
+  }
+
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  auto compile = [&](const char *pText, IDxcBlob **ppProgram) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CreateBlobFromText(pText, &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", nullptr, 0, nullptr, 0,
+                                        nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(ppProgram));
+  };
+
+  // Root signatures come from containers carrying them.
+  CComPtr<IDxcBlob> pRootSignatures[3];
+  compile("[RootSignature(\"RootConstants(b0, num32BitConstants = 1)\")] "
+          "float4 main() : SV_Target { return 0; }", &pRootSignatures[0]);
+  compile("[RootSignature(\"SRV(t0)\")] "
+          "float4 main() : SV_Target { return 0; }", &pRootSignatures[1]);
+  compile("[RootSignature(\"RootFlags(DENY_PIXEL_SHADER_ROOT_ACCESS), "
+          "RootConstants(b0, num32BitConstants = 1)\")] "
+          "float4 main() : SV_Target { return 0; }", &pRootSignatures[2]);
+
+  CComPtr<IDxcBlob> pShaders[2];
+  compile("float c; float4 main() : SV_Target { return c; }", &pShaders[0]);
+  compile("Texture2D t; float4 main() : SV_Target { return t.Load(0); }",
+          &pShaders[1]);
+
+  IDxcBlob *pRSList[] = { pRootSignatures[0], pRootSignatures[1], pRootSignatures[2] };
+  IDxcBlob *pShaderList[] = { pShaders[0], pShaders[1] };
+  UINT32 reasons[_countof(pRSList) * _countof(pShaderList)];
+  VERIFY_SUCCEEDED(pCompat->CheckRootSignatureCompatibility(
+      _countof(pRSList), pRSList, _countof(pShaderList), pShaderList,
+      reasons));
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_Compatible, reasons[0]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_UnboundResource, reasons[1]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_UnboundResource, reasons[2]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_RootDescriptorResourceType, reasons[3]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_DeniedShaderStage, reasons[4]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_UnboundResource, reasons[5]);
+
+  // A blob that is neither a root signature nor a container fails its row.
+  CComPtr<IDxcBlobEncoding> pBogus;
+  CreateBlobFromText("not a root signature", &pBogus);
+  IDxcBlob *pBogusList[] = { pBogus };
+  VERIFY_SUCCEEDED(pCompat->CheckRootSignatureCompatibility(
+      1, pBogusList, _countof(pShaderList), pShaderList, reasons));
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_InvalidRootSignature, reasons[0]);
+  VERIFY_ARE_EQUAL(DxcRootSignatureCompatibility_InvalidRootSignature, reasons[1]);
+}
+
+TEST_F(CompilerTest, CompileWhenUtf8ThenOutputMatchesUtf16) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerUtf8> pCompilerUtf8;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcOperationResult> pResultUtf8;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlob> pProgramUtf8;
+  CComPtr<TestIncludeHandler> pInclude;
+  CComPtr<TestIncludeHandlerUtf8> pIncludeUtf8;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pCompilerUtf8));
+  CreateBlobFromText(
+    "#include \"h\xc3\xa9lper.h\"\r\n"
+    "float4 main() : SV_Target { return SCALE * ZERO; }", &pSource);
+
+  LPCWSTR args[] = { L"-Zpr", L"-O3" };
+  DxcDefine define = { L"SCALE", L"2" };
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args),
+                                      &define, 1, pInclude, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+
+  LPCSTR argsUtf8[] = { "-Zpr", "-O3" };
+  DxcDefineUtf8 defineUtf8 = { "SCALE", "2" };
+  pIncludeUtf8 = new TestIncludeHandlerUtf8(m_dllSupport, "#define ZERO 0");
+  VERIFY_SUCCEEDED(pCompilerUtf8->CompileUtf8(
+      pSource, "source.hlsl", "main", "ps_6_0", argsUtf8,
+      _countof(argsUtf8), &defineUtf8, 1, pIncludeUtf8, &pResultUtf8));
+  VerifyOperationSucceeded(pResultUtf8);
+  VERIFY_SUCCEEDED(pResultUtf8->GetResult(&pProgramUtf8));
+
+  VERIFY_ARE_EQUAL(1, pIncludeUtf8->FileNames.size());
+  VERIFY_ARE_EQUAL_STR("./h\xc3\xa9lper.h", pIncludeUtf8->FileNames[0].c_str());
+  VERIFY_ARE_EQUAL(pProgram->GetBufferSize(), pProgramUtf8->GetBufferSize());
+  VERIFY_ARE_EQUAL(0, memcmp(pProgram->GetBufferPointer(),
+                             pProgramUtf8->GetBufferPointer(),
+                             pProgram->GetBufferSize()));
+}
+
+TEST_F(CompilerTest, CompileWhenParsedArgsThenOutputMatches) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerArgsParsing> pParsing;
+  CComPtr<IDxcCompilerArgs> pArgs;
+  CComPtr<IDxcOperationResult> pParseResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pParsing));
+  CreateBlobFromText("float4 main() : SV_Target { return VALUE; }", &pSource);
+
+  LPCWSTR args[] = { L"-Zpr", L"-O3" };
+  VERIFY_SUCCEEDED(pParsing->ParseArguments(args, _countof(args), &pArgs,
+                                            &pParseResult));
+  VERIFY_IS_NOT_NULL(pArgs.p);
+  VERIFY_IS_NULL(pParseResult.p);
+  LPCWSTR *pParsedArgs;
+  UINT32 parsedArgCount;
+  VERIFY_SUCCEEDED(pArgs->GetArguments(&pParsedArgs, &parsedArgCount));
+  VERIFY_ARE_EQUAL(_countof(args), parsedArgCount);
+  VERIFY_ARE_EQUAL_WSTR(L"-O3", pParsedArgs[1]);
+
+  // The same parsed arguments serve compilations with different defines.
+  LPCWSTR values[] = { L"1", L"2" };
+  for (LPCWSTR value : values) {
+    DxcDefine define = { L"VALUE", value };
+    CComPtr<IDxcOperationResult> pResult;
+    CComPtr<IDxcOperationResult> pParsedResult;
+    CComPtr<IDxcBlob> pProgram;
+    CComPtr<IDxcBlob> pParsedProgram;
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", args, _countof(args),
+                                        &define, 1, nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+    VERIFY_SUCCEEDED(pParsing->CompileWithArgs(pSource, L"source.hlsl",
+                                               L"main", L"ps_6_0", pArgs,
+                                               &define, 1, nullptr,
+                                               &pParsedResult));
+    VerifyOperationSucceeded(pParsedResult);
+    VERIFY_SUCCEEDED(pParsedResult->GetResult(&pParsedProgram));
+    VERIFY_ARE_EQUAL(pProgram->GetBufferSize(),
+                     pParsedProgram->GetBufferSize());
+    VERIFY_ARE_EQUAL(0, memcmp(pProgram->GetBufferPointer(),
+                               pParsedProgram->GetBufferPointer(),
+                               pProgram->GetBufferSize()));
+  }
+
+  // Invalid arguments are reported the way Compile reports them.
+  LPCWSTR badArgs[] = { L"/Zss", L"/Zsb" };
+  CComPtr<IDxcCompilerArgs> pBadArgs;
+  CComPtr<IDxcOperationResult> pBadResult;
+  HRESULT status;
+  VERIFY_SUCCEEDED(pParsing->ParseArguments(badArgs, _countof(badArgs),
+                                            &pBadArgs, &pBadResult));
+  VERIFY_IS_NULL(pBadArgs.p);
+  VERIFY_IS_NOT_NULL(pBadResult.p);
+  VERIFY_SUCCEEDED(pBadResult->GetStatus(&status));
+  VERIFY_ARE_EQUAL(E_INVALIDARG, status);
+}
+
+TEST_F(CompilerTest, CompileWhenIncludeThenLoadInvoked) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<TestIncludeHandler> pInclude;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(
+    "#include \"helper.h\"\r\n"
+    "float4 main() : SV_Target { return 0; }", &pSource);
+
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("");
+
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+    L"ps_6_0", nullptr, 0, nullptr, 0, pInclude, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_ARE_EQUAL_WSTR(L"./helper.h;", pInclude->GetAllFileNames().c_str());
+}
+
+TEST_F(CompilerTest, CompileWhenIncludeThenLoadUsed) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
   CComPtr<IDxcBlobEncoding> pSource;
@@ -1741,10 +2912,10 @@ TEST_F(CompilerTest, CompileWhenIncludeThenLoadInvoked) {
   VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
   CreateBlobFromText(
     "#include \"helper.h\"\r\n"
-    "float4 main() : SV_Target { return 0; }", &pSource);
+    "float4 main() : SV_Target { return ZERO; }", &pSource);
 
   pInclude = new TestIncludeHandler(m_dllSupport);
-  pInclude->CallResults.emplace_back("");
+  pInclude->CallResults.emplace_back("#define ZERO 0");
 
   VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
     L"ps_6_0", nullptr, 0, nullptr, 0, pInclude, &pResult));
@@ -1752,24 +2923,109 @@ TEST_F(CompilerTest, CompileWhenIncludeThenLoadInvoked) {
   VERIFY_ARE_EQUAL_WSTR(L"./helper.h;", pInclude->GetAllFileNames().c_str());
 }
 
-TEST_F(CompilerTest, CompileWhenIncludeThenLoadUsed) {
+TEST_F(CompilerTest, CompileWhenIncludeCacheThenLoadOnce) {
   CComPtr<IDxcCompiler> pCompiler;
-  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcCompiler> pOtherCompiler;
+  CComPtr<IDxcIncludeCache> pCache;
+  CComPtr<IDxcCompilerIncludeCaching> pCaching;
   CComPtr<IDxcBlobEncoding> pSource;
   CComPtr<TestIncludeHandler> pInclude;
 
   VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(CreateCompiler(&pOtherCompiler));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcIncludeCache, &pCache));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pCaching));
+  VERIFY_SUCCEEDED(pCaching->SetIncludeCache(pCache));
+  pCaching.Release();
+  VERIFY_SUCCEEDED(pOtherCompiler.QueryInterface(&pCaching));
+  VERIFY_SUCCEEDED(pCaching->SetIncludeCache(pCache));
   CreateBlobFromText(
     "#include \"helper.h\"\r\n"
     "float4 main() : SV_Target { return ZERO; }", &pSource);
 
   pInclude = new TestIncludeHandler(m_dllSupport);
   pInclude->CallResults.emplace_back("#define ZERO 0");
+  pInclude->CallResults.emplace_back("#define ZERO 1");
+
+  // Both compilers share the cache, so the handler is only asked once.
+  for (IDxcCompiler *pC : { pCompiler.p, pOtherCompiler.p }) {
+    CComPtr<IDxcOperationResult> pResult;
+    VERIFY_SUCCEEDED(pC->Compile(pSource, L"source.hlsl", L"main",
+      L"ps_6_0", nullptr, 0, nullptr, 0, pInclude, &pResult));
+    VerifyOperationSucceeded(pResult);
+  }
+  VERIFY_ARE_EQUAL_WSTR(L"./helper.h;", pInclude->GetAllFileNames().c_str());
 
+  // Invalidating the entry makes the next compile load it again.
+  VERIFY_SUCCEEDED(pCache->Invalidate(L"./helper.h"));
+  CComPtr<IDxcOperationResult> pResult;
   VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
     L"ps_6_0", nullptr, 0, nullptr, 0, pInclude, &pResult));
   VerifyOperationSucceeded(pResult);
-  VERIFY_ARE_EQUAL_WSTR(L"./helper.h;", pInclude->GetAllFileNames().c_str());
+  VERIFY_ARE_EQUAL_WSTR(L"./helper.h;./helper.h;", pInclude->GetAllFileNames().c_str());
+}
+
+TEST_F(CompilerTest, CompileWhenPackageThenIncludesNotLoaded) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerPackaging> pPackaging;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pPackage;
+  CComPtr<IDxcBlobEncoding> pBadPackage;
+  CComPtr<TestIncludeHandler> pInclude;
+  HRESULT hrOp;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pPackaging));
+  CreateBlobFromText(
+    "#include \"first.h\"\r\n"
+    "#include \"second.h\"\r\n"
+    "float4 main() : SV_Target { return ZERO + ONE; }", &pSource);
+
+  DxcDefine define;
+  define.Name = L"ONE";
+  define.Value = L"1";
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  VERIFY_SUCCEEDED(pPackaging->CreatePackage(
+      pSource, L"source.hlsl", L"main", L"ps_6_0", nullptr, 0, &define, 1,
+      pInclude, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pPackage));
+  VERIFY_ARE_EQUAL_WSTR(L"./first.h;./second.h;",
+                        pInclude->GetAllFileNames().c_str());
+
+  // The package compiles with no include handler to ask.
+  pResult.Release();
+  VERIFY_SUCCEEDED(pPackaging->CompileFromPackage(pPackage, &pResult));
+  VerifyOperationSucceeded(pResult);
+
+  // Anything else is rejected.
+  CreateBlobFromText("float4 main() : SV_Target { return 0; }", &pBadPackage);
+  pResult.Release();
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+                   pPackaging->CompileFromPackage(pBadPackage, &pResult));
+}
+
+TEST_F(CompilerTest, CompileWhenForcedIncludeThenPrologueApplied) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<TestIncludeHandler> pInclude;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText("float4 main() : SV_Target { return ZERO; }", &pSource);
+
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+
+  LPCWSTR args[] = { L"-include", L"prelude.h" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+    L"ps_6_0", args, _countof(args), nullptr, 0, pInclude, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_ARE_EQUAL(1U, pInclude->CallInfos.size());
 }
 
 TEST_F(CompilerTest, CompileWhenIncludeAbsoluteThenLoadAbsolute) {
@@ -1954,6 +3210,97 @@ TEST_F(CompilerTest, CompileWhenODumpThenPassConfig) {
   VERIFY_ARE_NOT_EQUAL(string::npos, passes.find("inline"));
 }
 
+TEST_F(CompilerTest, CompileWhenO1fastThenNoLoopPasses) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcBlobEncoding> pSource;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(EmptyCompute, &pSource);
+
+  LPCWSTR OptLevels[] = { L"/O1", L"/O1fast" };
+  string passes[_countof(OptLevels)];
+  for (unsigned i = 0; i < _countof(OptLevels); ++i) {
+    CComPtr<IDxcOperationResult> pResult;
+    CComPtr<IDxcBlob> pResultBlob;
+    LPCWSTR Args[] = { OptLevels[i], L"/Odump" };
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+      L"cs_6_0", Args, _countof(Args), nullptr, 0, nullptr, &pResult));
+    VerifyOperationSucceeded(pResult);
+    VERIFY_SUCCEEDED(pResult->GetResult(&pResultBlob));
+    passes[i].assign((char *)pResultBlob->GetBufferPointer(),
+                     pResultBlob->GetBufferSize());
+  }
+
+  VERIFY_ARE_NOT_EQUAL(string::npos, passes[0].find("-licm"));
+  VERIFY_ARE_EQUAL(string::npos, passes[1].find("-licm"));
+  VERIFY_ARE_EQUAL(string::npos, passes[1].find("-gvn"));
+  VERIFY_ARE_EQUAL(string::npos, passes[1].find("-loop-"));
+  VERIFY_ARE_NOT_EQUAL(string::npos, passes[1].find("-scalarizer"));
+  VERIFY_ARE_NOT_EQUAL(string::npos, passes[1].find("-dxilgen"));
+}
+
+TEST_F(CompilerTest, OptimizerWhenParsedModuleThenPipelinesReuseIt) {
+  CComPtr<IDxcOptimizer2> pOptimizer;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcOptimizerModule> pModule;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcOptimizer, &pOptimizer));
+  CreateBlobFromText(
+    "define i32 @f(i32 %a) {\n"
+    "  %p = alloca i32\n"
+    "  store i32 %a, i32* %p\n"
+    "  %v = load i32, i32* %p\n"
+    "  ret i32 %v\n"
+    "}\n", &pSource);
+  VERIFY_SUCCEEDED(pOptimizer->ParseModule(pSource, &pModule));
+
+  // Each run starts from the parsed module, so both see the alloca.
+  for (int i = 0; i < 2; ++i) {
+    CComPtr<IDxcBlob> pOutputModule;
+    CComPtr<IDxcBlobEncoding> pReport;
+    VERIFY_SUCCEEDED(pModule->RunPipeline(L"mem2reg; -simplifycfg",
+                                          &pOutputModule, &pReport));
+    VERIFY_IS_NOT_NULL(pOutputModule.p);
+    std::string report = BlobToUtf8(pReport);
+    VERIFY_ARE_NOT_EQUAL(string::npos, report.find("\"initialInstructions\": 4"));
+    VERIFY_ARE_NOT_EQUAL(string::npos, report.find("\"name\": \"mem2reg\""));
+    VERIFY_ARE_NOT_EQUAL(string::npos, report.find("\"delta\": -3"));
+    VERIFY_ARE_NOT_EQUAL(string::npos, report.find("\"name\": \"simplifycfg\""));
+  }
+
+  CComPtr<IDxcBlobEncoding> pReport;
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+                   pModule->RunPipeline(L"mem2reg;no-such-pass", nullptr, &pReport));
+}
+
+TEST_F(CompilerTest, OptimizerWhenContainerThenProgramOptimized) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOptimizer> pOptimizer;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pContainer;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcOptimizer, &pOptimizer));
+  CreateBlobFromText(EmptyCompute, &pSource);
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+    L"cs_6_0", nullptr, 0, nullptr, 0, nullptr, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pContainer));
+
+  // The program of the container is optimized as its bitcode would be.
+  LPCWSTR Options[] = { L"-opt-fn-passes", L"-simplifycfg",
+                        L"-opt-mod-passes", L"-S" };
+  CComPtr<IDxcBlob> pOutputModule;
+  CComPtr<IDxcBlobEncoding> pOutputText;
+  VERIFY_SUCCEEDED(pOptimizer->RunOptimizer(pContainer, Options,
+                                            _countof(Options), &pOutputModule,
+                                            &pOutputText));
+  VERIFY_IS_NOT_NULL(pOutputModule.p);
+  std::string text = BlobToUtf8(pOutputText);
+  VERIFY_ARE_NOT_EQUAL(string::npos, text.find("define void @main()"));
+  VERIFY_ARE_NOT_EQUAL(string::npos, text.find("!dx.entryPoints"));
+}
+
 TEST_F(CompilerTest, CompileWhenVdThenProducesDxilContainer) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1973,7 +3320,7 @@ TEST_F(CompilerTest, CompileWhenVdThenProducesDxilContainer) {
 }
 
 TEST_F(CompilerTest, CompileWhenODumpThenOptimizerMatch) {
-  LPCWSTR OptLevels[] = { L"/Od", L"/O1", L"/O2" };
+  LPCWSTR OptLevels[] = { L"/Od", L"/O1", L"/O1fast", L"/O2" };
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOptimizer> pOptimizer;
   CComPtr<IDxcAssembler> pAssembler;
@@ -2281,6 +3628,14 @@ TEST_F(CompilerTest, CodeGenArrayOfStruct){
   CodeGenTest(L"..\\CodeGenHLSL\\arrayOfStruct.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenLargeStructArray) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\largeStructArray.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenConstInitList) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\constInitList.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenAsUint) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\asuint.hlsl");
 }
@@ -2321,6 +3676,22 @@ TEST_F(CompilerTest, CodeGenBinary1) {
   CodeGenTest(L"..\\CodeGenHLSL\\binary1.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenBlockCounters) {
+  CodeGenTestCheck(L"block_counters.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenBlockCountersLines) {
+  CodeGenTestCheck(L"block_counters_lines.ll");
+}
+
+TEST_F(CompilerTest, CodeGenBlockProfile) {
+  CodeGenTestCheck(L"block_profile.ll");
+}
+
+TEST_F(CompilerTest, CodeGenCountersToLines) {
+  CodeGenTestCheck(L"counters_to_lines.ll");
+}
+
 TEST_F(CompilerTest, CodeGenBoolComb) {
   CodeGenTest(L"..\\CodeGenHLSL\\boolComb.hlsl");
 }
@@ -2393,6 +3764,14 @@ TEST_F(CompilerTest, CodeGenCbufferCopy4) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\cbuffer_copy4.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenBufferCombine) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\bufferCombine.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenCbufferCoalesce) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\cbufferCoalesce.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenCbuffer_unused) {
   CodeGenTest(L"..\\CodeGenHLSL\\cbuffer_unused.hlsl");
 }
@@ -2441,6 +3820,10 @@ TEST_F(CompilerTest, CodeGenCbufferInLoop) {
   CodeGenTest(L"..\\CodeGenHLSL\\cbufferInLoop.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenCbufferPack) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\cbufferPack.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenClass) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\class.hlsl");
 }
@@ -2489,6 +3872,14 @@ TEST_F(CompilerTest, CodeGenDynamic_Resources) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\dynamic-resources.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenDxilConstantTables) {
+  CodeGenTestCheck(L"dxil_constant_tables.ll");
+}
+
+TEST_F(CompilerTest, CodeGenDynamicIndexToSelect) {
+  CodeGenTestCheck(L"dynamic_index_to_select.ll");
+}
+
 TEST_F(CompilerTest, CodeGenEffectSkip) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\effect_skip.hlsl");
 }
@@ -2517,6 +3908,10 @@ TEST_F(CompilerTest, CodeGenEliminateDynamicIndexing6) {
   CodeGenTestCheck(L"eliminate_dynamic_output6.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenEliminateDynamicIndexing7) {
+  CodeGenTestCheck(L"eliminate_dynamic_output7.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenEmpty) {
   CodeGenTest(L"..\\CodeGenHLSL\\empty.hlsl");
 }
@@ -2594,6 +3989,9 @@ TEST_F(CompilerTest, CodeGenExpandTrig) {
   CodeGenTestCheck(L"expand_trig\\tan.hlsl");
   CodeGenTestCheck(L"expand_trig\\keep_precise.0.hlsl");
   CodeGenTestCheck(L"expand_trig\\keep_precise.1.hlsl");
+  CodeGenTestCheck(L"expand_trig\\acos_approx.hlsl");
+  CodeGenTestCheck(L"expand_trig\\atan_approx.hlsl");
+  CodeGenTestCheck(L"expand_trig\\htan_approx.hlsl");
 }
 
 TEST_F(CompilerTest, CodeGenFloatCast) {
@@ -2625,6 +4023,10 @@ TEST_F(CompilerTest, CodeGenFuncCast) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\func_cast.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenFunctionBudget) {
+  CodeGenTestCheck(L"function_budget.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenFunctionalCast) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\functionalCast.hlsl");
 }
@@ -2649,10 +4051,26 @@ TEST_F(CompilerTest, CodeGenGepZeroIdx) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\gep_zero_idx.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenGetDimensionsHoist) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\getDimensionsHoist.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenGloballyCoherent) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\globallycoherent.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenHandleHoist) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\handleHoist.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenHoistSamples) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\hoistSamples.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenHsWidePatch) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\hsWidePatch.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenI32ColIdx) {
   CodeGenTest(L"..\\CodeGenHLSL\\i32colIdx.hlsl");
 }
@@ -2803,6 +4221,10 @@ TEST_F(CompilerTest, CodeGenInvalidInputOutputTypes) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\invalid_input_output_types.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenLazyFunctionBodies) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\lazy_function_bodies.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenLegacyStruct) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\legacy_struct.hlsl");
 }
@@ -2827,6 +4249,10 @@ TEST_F(CompilerTest, CodeGenLibEntries2) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\lib_entries2.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenLibFuncPropsOrder) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\lib_func_props_order.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenLibResource) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\lib_resource.hlsl");
 }
@@ -2847,6 +4273,10 @@ TEST_F(CompilerTest, CodeGenLiveness1) {
   CodeGenTest(L"..\\CodeGenHLSL\\liveness1.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenLoadToGather) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\loadToGather.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenLoop1) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\loop1.hlsl");
 }
@@ -2899,6 +4329,10 @@ TEST_F(CompilerTest, CodeGenMatParam2) {
 //  CodeGenTestCheck(L"..\\CodeGenHLSL\\mat_param3.hlsl");
 //}
 
+TEST_F(CompilerTest, CodeGenMatAffineMul) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\matAffineMul.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenMatElt) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\matElt.hlsl");
 }
@@ -3070,6 +4504,10 @@ TEST_F(CompilerTest, CodeGenNonUniform) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\NonUniform.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenNonUniformHandles) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\nonUniformHandles.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenOptForNoOpt) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\optForNoOpt.hlsl");
 }
@@ -3078,6 +4516,10 @@ TEST_F(CompilerTest, CodeGenOptForNoOpt2) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\optForNoOpt2.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenOptForNoOpt5) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\optForNoOpt5.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenOptionGis) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\option_gis.hlsl");
 }
@@ -3138,6 +4580,10 @@ TEST_F(CompilerTest, CodeGenPrecise4) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\precise4.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenPrecise5) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\precise5.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenPreciseOnCall) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\precise_call.hlsl");
 }
@@ -3156,6 +4602,26 @@ TEST_F(CompilerTest, CodeGenPreserveAllOutputs) {
   CodeGenTestCheck(L"preserve_all_outputs_7.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenPairHalfOps) {
+  CodeGenTestCheck(L"pair_half_ops.ll");
+}
+
+TEST_F(CompilerTest, CodeGenProfileRegions) {
+  CodeGenTestCheck(L"profile_regions.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenProfileRegionsPairing) {
+  CodeGenTestCheck(L"profile_regions.ll");
+}
+
+TEST_F(CompilerTest, CodeGenPruneRenderTargets) {
+  CodeGenTestCheck(L"prune_render_targets.hlsl");
+}
+
+TEST_F(CompilerTest, CodeGenPruneUnreadOutputs) {
+  CodeGenTestCheck(L"prune_unread_outputs.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenRaceCond2) {
   CodeGenTest(L"..\\CodeGenHLSL\\RaceCond2.hlsl");
 }
@@ -3288,6 +4754,10 @@ TEST_F(CompilerTest, CodeGenShaderAttr) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\shader_attr.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenShaderStats) {
+  CodeGenTestCheck(L"shader_stats.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenShare_Mem_Dbg) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\share_mem_dbg.hlsl");
 }
@@ -3400,6 +4870,10 @@ TEST_F(CompilerTest, CodeGenSimpleHS8) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\SimpleHS8.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenSimplifyBeforeInline) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\simplify_before_inline.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenSMFail) {
   CodeGenTestCheck(L"sm-fail.hlsl");
 }
@@ -3436,6 +4910,10 @@ TEST_F(CompilerTest, CodeGenStaticGlobals4) {
   CodeGenTest(L"..\\CodeGenHLSL\\staticGlobals4.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenStaticGlobals5) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\staticGlobals5.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenStaticMatrix) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\static_matrix.hlsl");
 }
@@ -3528,6 +5006,10 @@ TEST_F(CompilerTest, CodeGenTemp2) {
   CodeGenTest(L"..\\CodeGenHLSL\\temp2.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenTGSMBankConflicts) {
+  CodeGenTestCheck(L"tgsm_bank_conflicts.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenTempDbgInfo) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\temp_dbg_info.hlsl");
 }
@@ -3548,6 +5030,10 @@ TEST_F(CompilerTest, CodeGenUav_Typed_Load_Store2) {
   CodeGenTest(L"..\\CodeGenHLSL\\uav_typed_load_store2.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenUniformityStats) {
+  CodeGenTestCheck(L"uniformity_stats.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenUint64_1) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\uint64_1.hlsl");
 }
@@ -3565,10 +5051,18 @@ TEST_F(CompilerTest, CodeGenUmaxObjectAtomic) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\umaxObjectAtomic.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenUnrollConstantIndex) {
+  CodeGenTestCheck(L"unroll_constant_index.ll");
+}
+
 TEST_F(CompilerTest, CodeGenUnrollDbg) {
   CodeGenTest(L"..\\CodeGenHLSL\\unroll_dbg.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenUnrollHintWarning) {
+  CodeGenTestCheck(L"unroll_hint_warning.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenUnsignedShortHandMatrixVector) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\unsignedShortHandMatrixVector.hlsl");
 }
@@ -3617,6 +5111,10 @@ TEST_F(CompilerTest, CodeGenWaveNoOpt) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\wave_no_opt.hlsl");
 }
 
+TEST_F(CompilerTest, CodeGenWaveUniform) {
+  CodeGenTestCheck(L"..\\CodeGenHLSL\\waveUniform.hlsl");
+}
+
 TEST_F(CompilerTest, CodeGenWriteMaskBuf) {
   CodeGenTestCheck(L"..\\CodeGenHLSL\\writeMaskBuf.hlsl");
 }
@@ -4684,6 +6182,7 @@ TEST_F(CompilerTest, DxilGen_StoreOutput) {
 
 TEST_F(CompilerTest, ConstantFolding) {
   CodeGenTestCheck(L"constprop\\FAbs.hlsl");
+  CodeGenTestCheck(L"constprop\\IsSpecialFloat.hlsl");
   CodeGenTestCheck(L"constprop\\Saturate_half.hlsl");
   CodeGenTestCheck(L"constprop\\Saturate_float.hlsl");
   CodeGenTestCheck(L"constprop\\Saturate_double.hlsl");
@@ -4782,6 +6281,199 @@ TEST_F(CompilerTest, PreprocessWhenValidThenOK) {
     "int BAR;\n", text.c_str());
 }
 
+TEST_F(CompilerTest, PreprocessWhenDependenciesThenIncludesListed) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<TestIncludeHandler> pInclude;
+  CComPtr<IDxcBlob> pOutText;
+  HRESULT hrOp;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(
+    "#include \"helper.h\"\r\n"
+    "#if 0\r\n"
+    "#include \"skipped.h\"\r\n"
+    "#endif\r\n"
+    "float4 main() : SV_Target { return ZERO; }", &pSource);
+
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  LPCWSTR makeArgs[] = { L"-M", L"-MT", L"out dir/source.cso" };
+  VERIFY_SUCCEEDED(pCompiler->Preprocess(pSource, L"source.hlsl", makeArgs,
+                                         _countof(makeArgs), nullptr, 0,
+                                         pInclude, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pOutText));
+  VERIFY_ARE_EQUAL_STR(
+    "out\\ dir/source.cso: \\\n"
+    "  source.hlsl \\\n"
+    "  ./helper.h\n", BlobToUtf8(pOutText).c_str());
+  VERIFY_ARE_EQUAL_WSTR(L"./helper.h;", pInclude->GetAllFileNames().c_str());
+
+  pResult.Release();
+  pOutText.Release();
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  LPCWSTR jsonArgs[] = { L"-MJ" };
+  VERIFY_SUCCEEDED(pCompiler->Preprocess(pSource, L"source.hlsl", jsonArgs,
+                                         _countof(jsonArgs), nullptr, 0,
+                                         pInclude, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pOutText));
+  VERIFY_ARE_EQUAL_STR(
+    "{\n"
+    "  \"target\": \"source.cso\",\n"
+    "  \"dependencies\": [\n"
+    "    \"source.hlsl\",\n"
+    "    \"./helper.h\"\n"
+    "  ]\n"
+    "}\n", BlobToUtf8(pOutText).c_str());
+}
+
+TEST_F(CompilerTest, CompileWhenDependenciesThenIncludesListed) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcDependenciesResult> pDependenciesResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlobEncoding> pDependencies;
+  CComPtr<TestIncludeHandler> pInclude;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  CreateBlobFromText(
+    "#include \"helper.h\"\r\n"
+    "float4 main() : SV_Target { return ZERO; }", &pSource);
+
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  LPCWSTR args[] = { L"-MD", L"-MT", L"out dir/source.cso" };
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args),
+                                      nullptr, 0, pInclude, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pDependenciesResult));
+  VERIFY_SUCCEEDED(pDependenciesResult->GetDependencies(&pDependencies));
+  VERIFY_IS_NOT_NULL(pDependencies.p);
+  VERIFY_ARE_EQUAL_STR(
+    "out\\ dir/source.cso: \\\n"
+    "  source.hlsl \\\n"
+    "  ./helper.h\n", BlobToUtf8(pDependencies).c_str());
+
+  // Without -MD there are none.
+  pResult.Release();
+  pDependenciesResult.Release();
+  pDependencies.Release();
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define ZERO 0");
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", nullptr, 0, nullptr, 0,
+                                      pInclude, &pResult));
+  VerifyOperationSucceeded(pResult);
+  VERIFY_SUCCEEDED(pResult.QueryInterface(&pDependenciesResult));
+  VERIFY_SUCCEEDED(pDependenciesResult->GetDependencies(&pDependencies));
+  VERIFY_IS_NULL(pDependencies.p);
+}
+
+TEST_F(CompilerTest, PreprocessWhenTokenCacheThenDefinesReevaluated) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerTokenCaching> pTokenCaching;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pTokenCache;
+  CComPtr<TestIncludeHandler> pInclude;
+  HRESULT hrOp;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pTokenCaching));
+  CreateBlobFromText(
+    "#include \"helper.h\"\r\n"
+    "#if VARIANT\r\n"
+    "int g_first = HELPER;\r\n"
+    "#else\r\n"
+    "int g_second = HELPER;\r\n"
+    "#endif\r\n", &pSource);
+
+  DxcDefine define;
+  define.Name = L"VARIANT";
+  define.Value = L"1";
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define HELPER 7");
+  VERIFY_SUCCEEDED(pTokenCaching->CreateTokenCache(
+      pSource, L"source.hlsl", nullptr, 0, &define, 1, pInclude, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+  VERIFY_SUCCEEDED(pResult->GetResult(&pTokenCache));
+  VERIFY_IS_TRUE(pTokenCache->GetBufferSize() > 0);
+  VERIFY_SUCCEEDED(pTokenCaching->SetTokenCache(pTokenCache));
+
+  // Both branches are replayed from the cache.
+  LPCWSTR values[] = { L"1", L"0" };
+  const char *expected[] = { "int g_first = 7;", "int g_second = 7;" };
+  for (unsigned i = 0; i < _countof(values); ++i) {
+    CComPtr<IDxcBlob> pOutText;
+    pResult.Release();
+    define.Value = values[i];
+    pInclude = new TestIncludeHandler(m_dllSupport);
+    pInclude->CallResults.emplace_back("#define HELPER 7");
+    VERIFY_SUCCEEDED(pCompiler->Preprocess(pSource, L"source.hlsl", nullptr, 0,
+                                           &define, 1, pInclude, &pResult));
+    VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+    VERIFY_SUCCEEDED(hrOp);
+    VERIFY_SUCCEEDED(pResult->GetResult(&pOutText));
+    std::string text(BlobToUtf8(pOutText));
+    VERIFY_IS_TRUE(text.find(expected[i]) != std::string::npos);
+    VERIFY_IS_TRUE(text.find(expected[1 - i]) == std::string::npos);
+  }
+
+  // A cache for other arguments is not used, and compiles still succeed.
+  pResult.Release();
+  LPCWSTR args[] = { L"/Zpr" };
+  pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back("#define HELPER 7");
+  VERIFY_SUCCEEDED(pCompiler->Preprocess(pSource, L"source.hlsl", args,
+                                         _countof(args), &define, 1, pInclude,
+                                         &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+  VERIFY_SUCCEEDED(pTokenCaching->SetTokenCache(nullptr));
+}
+
+TEST_F(CompilerTest, PreprocessToStreamWhenNormalizedThenLinesOnly) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerStreamingPreprocess> pStreaming;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pOutText;
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<hlsl::AbstractMemoryStream> pStream;
+  HRESULT hrOp;
+
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pStreaming));
+  VERIFY_SUCCEEDED(CoGetMalloc(1, &pMalloc));
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pStream));
+  CreateBlobFromText(
+    "// First line\r\n"
+    "  int   g_a;\r\n"
+    "\r\n"
+    "\r\n"
+    "    int g_b;", &pSource);
+  VERIFY_SUCCEEDED(pStreaming->PreprocessToStream(
+      pSource, L"file.hlsl", nullptr, 0, nullptr, 0, nullptr,
+      DxcPreprocessFlags_NoLineMarkers | DxcPreprocessFlags_NormalizeWhitespace,
+      pStream, &pResult));
+  VERIFY_SUCCEEDED(pResult->GetStatus(&hrOp));
+  VERIFY_SUCCEEDED(hrOp);
+
+  // The text went to the stream only.
+  std::string text((const char *)pStream->GetPtr(), pStream->GetPtrSize());
+  VERIFY_ARE_EQUAL_STR("int g_a;\nint g_b;\n", text.c_str());
+  VERIFY_SUCCEEDED(pResult->GetResult(&pOutText));
+  VERIFY_ARE_EQUAL((SIZE_T)0, pOutText->GetBufferSize());
+}
+
 TEST_F(CompilerTest, WhenSigMismatchPCFunctionThenFail) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -83,6 +83,7 @@ protected:
   TEST_METHOD(CursorWhenFindAtGlobalThenMatch);
   TEST_METHOD(CursorWhenFindBeforeBodyCallThenMatch);
   TEST_METHOD(CursorWhenFindBeforeGlobalThenMatch);
+  TEST_METHOD(CursorWhenFindReferencesAgainThenSame);
   TEST_METHOD(CursorWhenFunctionThenParamsAvailable);
   TEST_METHOD(CursorWhenFunctionThenReturnTypeAvailable);
   TEST_METHOD(CursorWhenFunctionThenSignatureAvailable);
@@ -107,6 +108,9 @@ protected:
   TEST_METHOD(TUWhenRegionInactiveThenEndIsBeforeElseHash);
   TEST_METHOD(TUWhenRegionInactiveThenEndIsBeforeEndifHash);
   TEST_METHOD(TUWhenRegionInactiveThenStartIsAtIfdefEol);
+  TEST_METHOD(TUWhenReparsePreambleThenIncludeChangesSeen);
+  TEST_METHOD(TUWhenSharedPreambleThenUnitsIndependent);
+  TEST_METHOD(TUWhenAsyncRequestsThenSupersededCancelled);
   TEST_METHOD(TUWhenUnsaveFileThenOK);
 
   TEST_METHOD(QualifiedNameClass);
@@ -154,6 +158,46 @@ TEST_F(DXIntellisenseTest, CursorWhenCBufferRefThenFound) {
   VERIFY_ARE_EQUAL(2, line);
 }
 
+TEST_F(DXIntellisenseTest, CursorWhenFindReferencesAgainThenSame) {
+  char program[] =
+    "int g;\r\n"
+    "int main() { int l = g;\r\n"
+    "l += g;\r\n"
+    "return l; }";
+
+  CComPtr<IDxcCursor> globalRefCursor;
+  CComPtr<IDxcCursor> localRefCursor;
+  CComPtr<IDxcFile> file;
+  CComPtr<IDxcSourceLocation> loc;
+  unsigned line;
+
+  CompilationResult c(CompilationResult::CreateForProgram(program, strlen(program)));
+  VERIFY_ARE_EQUAL(true, c.ParseSucceeded());
+  ExpectCursorAt(c.TU, 3, 6, DxcCursor_DeclRefExpr, &globalRefCursor);
+  ExpectCursorAt(c.TU, 4, 8, DxcCursor_DeclRefExpr, &localRefCursor);
+  VERIFY_SUCCEEDED(c.TU->GetFile(CompilationResult::getDefaultFileName(), &file));
+
+  // The first query indexes the file; later ones are answered from it.
+  for (int i = 0; i < 2; ++i) {
+    CComInterfaceArray<IDxcCursor> refs;
+    VERIFY_SUCCEEDED(globalRefCursor->FindReferencesInFile(file, 0, 4, refs.size_ref(), refs.data_ref()));
+    VERIFY_ARE_EQUAL(3, refs.size());
+    loc.Release();
+    VERIFY_SUCCEEDED(refs.begin()[2]->GetLocation(&loc));
+    VERIFY_SUCCEEDED(loc->GetSpellingLocation(nullptr, &line, nullptr, nullptr));
+    VERIFY_ARE_EQUAL(3, line);
+  }
+
+  // Paging applies to indexed results as well.
+  CComInterfaceArray<IDxcCursor> refs;
+  VERIFY_SUCCEEDED(localRefCursor->FindReferencesInFile(file, 1, 4, refs.size_ref(), refs.data_ref()));
+  VERIFY_ARE_EQUAL(2, refs.size());
+  loc.Release();
+  VERIFY_SUCCEEDED(refs.begin()[1]->GetLocation(&loc));
+  VERIFY_SUCCEEDED(loc->GetSpellingLocation(nullptr, &line, nullptr, nullptr));
+  VERIFY_ARE_EQUAL(4, line);
+}
+
 TEST_F(DXIntellisenseTest, InclusionWhenMissingThenError) {
   CComPtr<IDxcIntelliSense> isense;
   CComPtr<IDxcIndex> index;
@@ -207,6 +251,108 @@ TEST_F(DXIntellisenseTest, InclusionWhenValidThenAvailable) {
   }
 }
 
+TEST_F(DXIntellisenseTest, TUWhenReparsePreambleThenIncludeChangesSeen) {
+  CComPtr<IDxcIntelliSense> isense;
+  CComPtr<IDxcIndex> index;
+  CComPtr<IDxcUnsavedFile> unsaved[2];
+  CComPtr<IDxcTranslationUnit> TU;
+  const char main_text[] = "#include \"inc.h\"\r\nfloat4 main() : SV_Target { return FOO; }";
+  const char unsaved_text[] = "#define FOO 1";
+  const char changed_text[] = "#define BAR 1";
+  unsigned diagCount;
+  VERIFY_SUCCEEDED(CompilationResult::DefaultHlslSupport->CreateIntellisense(&isense));
+  VERIFY_SUCCEEDED(isense->CreateIndex(&index));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("./inc.h", unsaved_text, strlen(unsaved_text), &unsaved[0]));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("file.hlsl", main_text, strlen(main_text), &unsaved[1]));
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit("file.hlsl", nullptr, 0, &unsaved[0].p, 2,
+    (DxcTranslationUnitFlags)(DxcTranslationUnitFlags_UseCallerThread | DxcTranslationUnitFlags_PrecompiledPreamble), &TU));
+  VERIFY_SUCCEEDED(TU->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(0, diagCount);
+
+  // Reparsing with the same files reuses the included tokens.
+  VERIFY_SUCCEEDED(TU->Reparse(&unsaved[0].p, 2));
+  VERIFY_SUCCEEDED(TU->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(0, diagCount);
+
+  // An edit to the included file must not be hidden by them.
+  unsaved[0].Release();
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("./inc.h", changed_text, strlen(changed_text), &unsaved[0]));
+  VERIFY_SUCCEEDED(TU->Reparse(&unsaved[0].p, 2));
+  VERIFY_SUCCEEDED(TU->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(1, diagCount);
+}
+
+TEST_F(DXIntellisenseTest, TUWhenSharedPreambleThenUnitsIndependent) {
+  CComPtr<IDxcIntelliSense> isense;
+  CComPtr<IDxcIndex> index;
+  CComPtr<IDxcUnsavedFile> unsaved[2];
+  CComPtr<IDxcTranslationUnit> TUs[2];
+  const char a_text[] = "float4 main() : SV_Target { return 1; }";
+  const char b_text[] = "float4 main() : SV_Target { return FOO; }";
+  const DxcTranslationUnitFlags flags = (DxcTranslationUnitFlags)(
+    DxcTranslationUnitFlags_UseCallerThread | DxcTranslationUnitFlags_PrecompiledPreamble);
+  unsigned diagCount;
+  VERIFY_SUCCEEDED(CompilationResult::DefaultHlslSupport->CreateIntellisense(&isense));
+  VERIFY_SUCCEEDED(isense->CreateIndex(&index));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("a.hlsl", a_text, strlen(a_text), &unsaved[0]));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("b.hlsl", b_text, strlen(b_text), &unsaved[1]));
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit("a.hlsl", nullptr, 0, &unsaved[0].p, 1, flags, &TUs[0]));
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit("b.hlsl", nullptr, 0, &unsaved[1].p, 1, flags, &TUs[1]));
+  VERIFY_SUCCEEDED(TUs[0]->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(0, diagCount);
+  VERIFY_SUCCEEDED(TUs[1]->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(1, diagCount);
+
+  // The units share one cache of included tokens, which outlives either.
+  TUs[0].Release();
+  VERIFY_SUCCEEDED(TUs[1]->Reparse(&unsaved[1].p, 1));
+  VERIFY_SUCCEEDED(TUs[1]->GetNumDiagnostics(&diagCount));
+  VERIFY_ARE_EQUAL(1, diagCount);
+}
+
+TEST_F(DXIntellisenseTest, TUWhenAsyncRequestsThenSupersededCancelled) {
+  CComPtr<IDxcIntelliSense> isense;
+  CComPtr<IDxcIndex> index;
+  CComPtr<IDxcUnsavedFile> unsaved;
+  CComPtr<IDxcTranslationUnit> TU;
+  CComPtr<IDxcTranslationUnitAsync> asyncTU;
+  CComPtr<IDxcIntelliSenseRequest> first, second, completion;
+  DxcIntelliSenseRequestStatus status;
+  const char main_text[] = "float4 g_global;\r\nfloat4 main() : SV_Target { return g_global; }";
+  VERIFY_SUCCEEDED(CompilationResult::DefaultHlslSupport->CreateIntellisense(&isense));
+  VERIFY_SUCCEEDED(isense->CreateIndex(&index));
+  VERIFY_SUCCEEDED(isense->CreateUnsavedFile("file.hlsl", main_text, strlen(main_text), &unsaved));
+  VERIFY_SUCCEEDED(index->ParseTranslationUnit("file.hlsl", nullptr, 0, &unsaved.p, 1,
+    DxcTranslationUnitFlags_UseCallerThread, &TU));
+  VERIFY_SUCCEEDED(TU.QueryInterface(&asyncTU));
+
+  // The second edit supersedes the first, which is dropped or stopped early.
+  VERIFY_SUCCEEDED(asyncTU->ReparseAsync(&unsaved.p, 1, &first));
+  VERIFY_SUCCEEDED(asyncTU->ReparseAsync(&unsaved.p, 1, &second));
+  VERIFY_SUCCEEDED(asyncTU->CodeCompleteAsync("file.hlsl", 2, 36, &unsaved.p, 1, &completion));
+  VERIFY_SUCCEEDED(completion->Wait(INFINITE));
+  VERIFY_SUCCEEDED(first->GetStatus(&status));
+  VERIFY_IS_TRUE(status == DxcIntelliSenseRequest_Cancelled || status == DxcIntelliSenseRequest_Completed);
+  VERIFY_SUCCEEDED(second->GetStatus(&status));
+  VERIFY_ARE_EQUAL(DxcIntelliSenseRequest_Completed, status);
+  VERIFY_SUCCEEDED(completion->GetStatus(&status));
+  VERIFY_ARE_EQUAL(DxcIntelliSenseRequest_Completed, status);
+
+  unsigned completionCount;
+  bool foundGlobal = false;
+  VERIFY_SUCCEEDED(completion->GetNumCompletions(&completionCount));
+  for (unsigned i = 0; i < completionCount; ++i) {
+    DxcCursorKind kind;
+    CComHeapPtr<char> typedText;
+    VERIFY_SUCCEEDED(completion->GetCompletionAt(i, &kind, &typedText));
+    if (0 == strcmp(typedText.m_pData, "g_global")) {
+      VERIFY_ARE_EQUAL(DxcCursor_VarDecl, kind);
+      foundGlobal = true;
+    }
+  }
+  VERIFY_IS_TRUE(foundGlobal);
+}
+
 
 TEST_F(DXIntellisenseTest, TUWhenGetFileMissingThenFail) {
   const char program[] = "int i;";
@@ -19,6 +19,7 @@
 #include <tuple>
 #include <cassert>
 #include <sstream>
+#include <thread>
 #include <algorithm>
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.h"
@@ -32,7 +33,11 @@
 #include "dxc/Support/Global.h"
 #include "dxc/Support/dxcapi.use.h"
 #include "dxc/Support/HLSLOptions.h"
+#include "dxc/Support/FileIOHelper.h"
 #include "dxc/HLSL/DxilContainer.h"
+#include "dxc/HLSL/DxilPipelineStateValidation.h"
+#include "dxc/HLSL/DxilShaderArchive.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include <fstream>
 #include <filesystem>
@@ -66,6 +71,10 @@ public:
   END_TEST_CLASS()
 
   TEST_METHOD(CompileWhenDebugSourceThenSourceMatters)
+  TEST_METHOD(CompileWhenDebugFastNameThenNameIsShort)
+  TEST_METHOD(CompileWhenDebugCompressedThenDebugInfoReadable)
+  TEST_METHOD(CompileWhenDedupStringsThenPartsSmaller)
+  TEST_METHOD(CompileWhenPSVIndexesThenBindingsFound)
   TEST_METHOD(CompileWhenOKThenIncludesFeatureInfo)
   TEST_METHOD(CompileWhenOKThenIncludesSignatures)
   TEST_METHOD(CompileWhenSigSquareThenIncludeSplit)
@@ -73,8 +82,15 @@ public:
   TEST_METHOD(DisassemblyWhenBCInvalidThenFails)
   TEST_METHOD(DisassemblyWhenInvalidThenFails)
   TEST_METHOD(DisassemblyWhenValidThenOK)
+  TEST_METHOD(DisassemblyToStreamWhenSectionsSelectedThenOnlyTheyListed)
+  TEST_METHOD(ChunkedMemoryStreamWhenWrittenThenMatchesMemoryStream)
   TEST_METHOD(ValidateFromLL_Abs2)
   TEST_METHOD(DxilContainerUnitTest)
+  TEST_METHOD(ReflectionWhenContainerMappedThenPartsNotCopied)
+  TEST_METHOD(ReflectionWhenCBufferFieldsUnusedThenNotMarkedUsed)
+  TEST_METHOD(ReflectionWhenPartReflectedTwiceThenStateShared)
+  TEST_METHOD(ReflectionWhenComputeShaderThenSummaryReported)
+  TEST_METHOD(ShaderArchiveWhenPermutationsThenPartsShared)
 
   TEST_METHOD(ReflectionMatchesDXBC_CheckIn)
   BEGIN_TEST_METHOD(ReflectionMatchesDXBC_Full)
@@ -558,6 +574,30 @@ TEST_F(DxilContainerTest, CompileWhenDebugSourceThenSourceMatters) {
   VERIFY_IS_FALSE(0 == strcmp(sourceName1Zss.c_str(), binName1.c_str()));
 }
 
+TEST_F(DxilContainerTest, CompileWhenDebugFastNameThenNameIsShort) {
+  char program1[] = "float4 main() : SV_Target { return 0; }";
+  char program2[] = "  float4 main() : SV_Target { return 0; }  ";
+  LPCWSTR Zi[] = { L"/Zi" };
+  LPCWSTR ZiZsx[] = { L"/Zi", L"/Zsx" };
+
+  if (!DoesValidatorSupportDebugName())
+    return;
+
+  // 32 hex digits of MD5 by default, 16 of xxHash64 with /Zsx.
+  std::string md5Name = CompileToDebugName(program1, L"main", L"ps_6_0", Zi, _countof(Zi));
+  VERIFY_ARE_EQUAL((size_t)36, md5Name.size());
+  std::string fastName1 = CompileToDebugName(program1, L"main", L"ps_6_0", ZiZsx, _countof(ZiZsx));
+  VERIFY_ARE_EQUAL((size_t)20, fastName1.size());
+  VERIFY_IS_TRUE(fastName1.compare(16, 4, ".lld") == 0);
+  VERIFY_IS_TRUE(fastName1.find_first_not_of("0123456789abcdef") == 16);
+
+  // Deterministic, and still dependent on the source.
+  std::string fastName1Again = CompileToDebugName(program1, L"main", L"ps_6_0", ZiZsx, _countof(ZiZsx));
+  VERIFY_ARE_EQUAL_STR(fastName1.c_str(), fastName1Again.c_str());
+  std::string fastName2 = CompileToDebugName(program2, L"main", L"ps_6_0", ZiZsx, _countof(ZiZsx));
+  VERIFY_IS_FALSE(0 == strcmp(fastName1.c_str(), fastName2.c_str()));
+}
+
 TEST_F(DxilContainerTest, CompileWhenOKThenIncludesSignatures) {
   char program[] =
     "struct PSInput {\r\n"
@@ -810,6 +850,102 @@ TEST_F(DxilContainerTest, DisassemblyWhenValidThenOK) {
   VERIFY_ARE_NOT_EQUAL(0, disassembleString.size());
 }
 
+TEST_F(DxilContainerTest, DisassemblyToStreamWhenSectionsSelectedThenOnlyTheyListed) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcCompilerDisassembly> pDisassembler;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlobEncoding> pDisassembly;
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<hlsl::AbstractMemoryStream> pFullStream;
+  CComPtr<hlsl::AbstractMemoryStream> pModuleStream;
+  CComPtr<hlsl::AbstractMemoryStream> pMissingStream;
+  CompileToProgram("float4 main(float4 pos : POSITION) : SV_Target { return pos; }",
+                   L"main", L"ps_6_0", nullptr, 0, &pProgram);
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler.QueryInterface(&pDisassembler));
+  VERIFY_SUCCEEDED(CoGetMalloc(1, &pMalloc));
+
+  // Streaming every section matches the blob-based listing.
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pProgram, &pDisassembly));
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pFullStream));
+  VERIFY_SUCCEEDED(pDisassembler->DisassembleToStream(
+      pProgram, DxcDisassembleSection_All, nullptr, 0, pFullStream));
+  std::string fullText((const char *)pFullStream->GetPtr(), pFullStream->GetPtrSize());
+  VERIFY_ARE_EQUAL_STR(BlobToUtf8(pDisassembly).c_str(), fullText.c_str());
+
+  // Only the named function's definition is listed.
+  LPCWSTR functions[] = { L"main" };
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pModuleStream));
+  VERIFY_SUCCEEDED(pDisassembler->DisassembleToStream(
+      pProgram, DxcDisassembleSection_Module, functions, _countof(functions),
+      pModuleStream));
+  std::string moduleText((const char *)pModuleStream->GetPtr(), pModuleStream->GetPtrSize());
+  VERIFY_IS_TRUE(moduleText.find("define void @main()") != std::string::npos);
+  VERIFY_IS_TRUE(moduleText.find("signature:") == std::string::npos);
+  VERIFY_IS_TRUE(moduleText.find("!dx.entryPoints") == std::string::npos);
+
+  LPCWSTR missing[] = { L"no_such_function" };
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pMissingStream));
+  VERIFY_ARE_EQUAL(HRESULT_FROM_WIN32(ERROR_NOT_FOUND),
+                   pDisassembler->DisassembleToStream(
+                       pProgram, DxcDisassembleSection_Module, missing,
+                       _countof(missing), pMissingStream));
+}
+
+TEST_F(DxilContainerTest, ChunkedMemoryStreamWhenWrittenThenMatchesMemoryStream) {
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<hlsl::AbstractMemoryStream> pChunked;
+  CComPtr<hlsl::AbstractMemoryStream> pContiguous;
+  CComPtr<hlsl::AbstractMemoryStream> pCopy;
+  VERIFY_SUCCEEDED(CoGetMalloc(1, &pMalloc));
+  VERIFY_SUCCEEDED(hlsl::CreateChunkedMemoryStream(pMalloc, &pChunked));
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pContiguous));
+
+  // Enough data for several chunks, written in pieces that straddle them.
+  std::vector<BYTE> data(300 * 1024);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (BYTE)(i * 7 + i / 251);
+  ULONG cbWritten;
+  for (size_t offset = 0; offset < data.size(); offset += 3001) {
+    ULONG count = (ULONG)std::min<size_t>(3001, data.size() - offset);
+    VERIFY_SUCCEEDED(pChunked->Write(&data[offset], count, &cbWritten));
+    VERIFY_SUCCEEDED(pContiguous->Write(&data[offset], count, &cbWritten));
+  }
+
+  // Overwrite across a chunk boundary, then continue at the end.
+  LARGE_INTEGER position;
+  position.QuadPart = 64 * 1024 - 10;
+  VERIFY_SUCCEEDED(pChunked->Seek(position, STREAM_SEEK_SET, nullptr));
+  VERIFY_SUCCEEDED(pContiguous->Seek(position, STREAM_SEEK_SET, nullptr));
+  VERIFY_SUCCEEDED(pChunked->Write(&data[0], 100, &cbWritten));
+  VERIFY_SUCCEEDED(pContiguous->Write(&data[0], 100, &cbWritten));
+  position.QuadPart = 0;
+  VERIFY_SUCCEEDED(pChunked->Seek(position, STREAM_SEEK_END, nullptr));
+  VERIFY_SUCCEEDED(pContiguous->Seek(position, STREAM_SEEK_END, nullptr));
+  VERIFY_SUCCEEDED(pChunked->Write(&data[0], 10, &cbWritten));
+  VERIFY_SUCCEEDED(pContiguous->Write(&data[0], 10, &cbWritten));
+  VERIFY_ARE_EQUAL(pContiguous->GetPtrSize(), pChunked->GetPtrSize());
+  VERIFY_ARE_EQUAL(pContiguous->GetPosition(), pChunked->GetPosition());
+
+  // Copying does not need a contiguous view and keeps the position.
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pCopy));
+  VERIFY_SUCCEEDED(hlsl::CopyMemoryStream(pChunked, pCopy));
+  VERIFY_ARE_EQUAL(pContiguous->GetPosition(), pChunked->GetPosition());
+  VERIFY_ARE_EQUAL(pContiguous->GetPtrSize(), pCopy->GetPtrSize());
+  VERIFY_ARE_EQUAL(0, memcmp(pContiguous->GetPtr(), pCopy->GetPtr(),
+                             pCopy->GetPtrSize()));
+
+  VERIFY_ARE_EQUAL(0, memcmp(pContiguous->GetPtr(), pChunked->GetPtr(),
+                             pChunked->GetPtrSize()));
+
+  // Writes after the data was coalesced are appended as before.
+  VERIFY_SUCCEEDED(pChunked->Write(&data[0], 1000, &cbWritten));
+  VERIFY_SUCCEEDED(pContiguous->Write(&data[0], 1000, &cbWritten));
+  VERIFY_ARE_EQUAL(pContiguous->GetPtrSize(), pChunked->GetPtrSize());
+  VERIFY_ARE_EQUAL(0, memcmp(pContiguous->GetPtr(), pChunked->GetPtr(),
+                             pChunked->GetPtrSize()));
+}
+
 class HlslFileVariables {
 private:
   std::wstring m_Entry;
@@ -913,6 +1049,409 @@ TEST_F(DxilContainerTest, ReflectionMatchesDXBC_Full) {
   }
 }
 
+TEST_F(DxilContainerTest, CompileWhenDebugCompressedThenDebugInfoReadable) {
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlob> pCompressedProgram;
+  CComPtr<IDxcBlobEncoding> pDisassembly;
+  CComPtr<IDxcContainerReflection> pContainer;
+  CComPtr<ID3D12ShaderReflection> pReflection;
+  LPCWSTR debugArgs[] = { L"/Zi" };
+  LPCWSTR compressedArgs[] = { L"/Zi", L"/Qcompress_debug" };
+  const char program[] =
+    "Texture2D<float4> t : register(t0);\r\n"
+    "SamplerState s : register(s0);\r\n"
+    "float4 main(float2 uv : TEXCOORD) : SV_Target {\r\n"
+    "  float4 r = 0;\r\n"
+    "  [unroll] for (int i = 0; i < 8; ++i) r += t.Sample(s, uv * i);\r\n"
+    "  return r;\r\n"
+    "}";
+
+  CompileToProgram(program, L"main", L"ps_6_0", debugArgs, _countof(debugArgs), &pProgram);
+  CompileToProgram(program, L"main", L"ps_6_0", compressedArgs, _countof(compressedArgs), &pCompressedProgram);
+
+  // Exactly one debug info part is present, and it yields a valid program.
+  const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+      pCompressedProgram->GetBufferPointer(), pCompressedProgram->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pHeader);
+  VERIFY_IS_TRUE(hlsl::IsValidDxilContainer(pHeader, pCompressedProgram->GetBufferSize()));
+  const hlsl::DxilPartHeader *pPlainPart =
+    hlsl::GetDxilPartByType(pHeader, hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL);
+  const hlsl::DxilPartHeader *pCompressedPart =
+    hlsl::GetDxilPartByType(pHeader, hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXILCompressed);
+  VERIFY_IS_TRUE((pPlainPart == nullptr) != (pCompressedPart == nullptr));
+  llvm::SmallVector<char, 0> decompressed;
+  const hlsl::DxilProgramHeader *pDebugHeader =
+    hlsl::GetDxilDebugProgramHeader(pHeader, decompressed);
+  VERIFY_IS_NOT_NULL(pDebugHeader);
+  if (pCompressedPart) {
+    VERIFY_IS_LESS_THAN(pCompressedProgram->GetBufferSize(), pProgram->GetBufferSize());
+  }
+
+  // The debug part can be disassembled and reflected.
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pCompressedProgram, &pDisassembly));
+  VERIFY_IS_TRUE(BlobToUtf8(pDisassembly).find("!llvm.dbg.cu") != std::string::npos);
+
+  UINT32 debugIdx;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcContainerReflection, &pContainer));
+  VERIFY_SUCCEEDED(pContainer->Load(pCompressedProgram));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(
+      pCompressedPart ? hlsl::DFCC_ShaderDebugInfoDXILCompressed
+                      : hlsl::DFCC_ShaderDebugInfoDXIL, &debugIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(debugIdx, __uuidof(ID3D12ShaderReflection), (void**)&pReflection));
+  D3D12_SHADER_DESC desc;
+  VERIFY_SUCCEEDED(pReflection->GetDesc(&desc));
+  VERIFY_ARE_EQUAL(2U, desc.BoundResources);
+}
+
+TEST_F(DxilContainerTest, CompileWhenDedupStringsThenPartsSmaller) {
+  LPCWSTR dedupArgs[] = { L"/Qdedup_strings" };
+  const char program[] =
+    "struct VSOut {\r\n"
+    "  float4 t0 : TEXCOORD0; float4 t1 : TEXCOORD1; float4 c : COLOR;\r\n"
+    "  float4 pos : SV_Position;\r\n"
+    "};\r\n"
+    "VSOut main(float4 t0 : TEXCOORD0, float4 t1 : TEXCOORD1,\r\n"
+    "           float4 c : COLOR, float4 pos : POSITION) {\r\n"
+    "  VSOut o = { t0, t1, c, pos };\r\n"
+    "  return o;\r\n"
+    "}";
+
+  auto getPartSize = [](IDxcBlob *pProgram, hlsl::DxilFourCC fourCC) {
+    const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+        pProgram->GetBufferPointer(), pProgram->GetBufferSize());
+    VERIFY_IS_NOT_NULL(pHeader);
+    const hlsl::DxilPartHeader *pPart = hlsl::GetDxilPartByType(pHeader, fourCC);
+    VERIFY_IS_NOT_NULL(pPart);
+    return pPart->PartSize;
+  };
+
+  // Both containers validate when compiled.
+  CComPtr<IDxcBlob> pPlainProgram, pDedupProgram;
+  CompileToProgram(program, L"main", L"vs_6_0", nullptr, 0, &pPlainProgram);
+  CompileToProgram(program, L"main", L"vs_6_0", dedupArgs, _countof(dedupArgs), &pDedupProgram);
+
+  // TEXCOORD is stored once in each signature, and TEXCOORD and COLOR once
+  // in PSV, rather than per element.
+  VERIFY_IS_LESS_THAN(getPartSize(pDedupProgram, hlsl::DFCC_InputSignature),
+                      getPartSize(pPlainProgram, hlsl::DFCC_InputSignature));
+  VERIFY_IS_LESS_THAN(getPartSize(pDedupProgram, hlsl::DFCC_OutputSignature),
+                      getPartSize(pPlainProgram, hlsl::DFCC_OutputSignature));
+  VERIFY_IS_LESS_THAN(getPartSize(pDedupProgram, hlsl::DFCC_PipelineStateValidation),
+                      getPartSize(pPlainProgram, hlsl::DFCC_PipelineStateValidation));
+
+  // The names read back the same.
+  CComPtr<IDxcCompiler> pCompiler;
+  CComPtr<IDxcBlobEncoding> pPlainDisassembly, pDedupDisassembly;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pPlainProgram, &pPlainDisassembly));
+  VERIFY_SUCCEEDED(pCompiler->Disassemble(pDedupProgram, &pDedupDisassembly));
+  VERIFY_ARE_EQUAL_STR(BlobToUtf8(pPlainDisassembly).c_str(),
+                       BlobToUtf8(pDedupDisassembly).c_str());
+}
+
+TEST_F(DxilContainerTest, CompileWhenPSVIndexesThenBindingsFound) {
+  LPCWSTR indexArgs[] = { L"/Qpsv_indexes" };
+  const char program[] =
+    "Texture2D<float4> t : register(t0);\r\n"
+    "Texture2D<float4> ts[8] : register(t4, space1);\r\n"
+    "SamplerState s : register(s0);\r\n"
+    "RWBuffer<float4> u : register(u2);\r\n"
+    "cbuffer C : register(b1) { uint i; };\r\n"
+    "float4 main(float2 uv : TEXCOORD) : SV_Target {\r\n"
+    "  u[i] = t.Sample(s, uv);\r\n"
+    "  return ts[i].Sample(s, uv);\r\n"
+    "}";
+  const char otherBody[] =
+    "Texture2D<float4> t : register(t3);\r\n"
+    "SamplerState s : register(s1);\r\n"
+    "float4 main(float2 uv : TEXCOORD) : SV_Target { return t.Sample(s, uv); }";
+  const char otherSignature[] =
+    "float4 main(float2 uv : TEXCOORD1) : SV_Target { return uv.xyxy; }";
+
+  auto loadPSV = [](IDxcBlob *pProgram, DxilPipelineStateValidation &PSV) {
+    const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+        pProgram->GetBufferPointer(), pProgram->GetBufferSize());
+    VERIFY_IS_NOT_NULL(pHeader);
+    const hlsl::DxilPartHeader *pPart = hlsl::GetDxilPartByType(
+        pHeader, hlsl::DxilFourCC::DFCC_PipelineStateValidation);
+    VERIFY_IS_NOT_NULL(pPart);
+    VERIFY_IS_TRUE(PSV.InitFromPSV0(hlsl::GetDxilPartData(pPart), pPart->PartSize));
+  };
+
+  // Without the option the part is unchanged and has no indexes.
+  CComPtr<IDxcBlob> pPlainProgram;
+  DxilPipelineStateValidation plainPSV;
+  CompileToProgram(program, L"main", L"ps_6_0", nullptr, 0, &pPlainProgram);
+  loadPSV(pPlainProgram, plainPSV);
+  VERIFY_IS_FALSE(plainPSV.HasResourceBindIndexes());
+  VERIFY_ARE_EQUAL(0U, plainPSV.GetSignatureHash());
+
+  CComPtr<IDxcBlob> pProgram;
+  DxilPipelineStateValidation PSV;
+  CompileToProgram(program, L"main", L"ps_6_0", indexArgs, _countof(indexArgs), &pProgram);
+  loadPSV(pProgram, PSV);
+  VERIFY_IS_TRUE(PSV.HasResourceBindIndexes());
+  VERIFY_ARE_EQUAL(5U, PSV.GetBindCount());
+
+  // Every binding is found by its lower bound, and ranges by any register.
+  for (uint32_t i = 0; i < PSV.GetBindCount(); ++i) {
+    const PSVResourceBindInfo0 *pBindInfo = PSV.GetPSVResourceBindInfo0(i);
+    uint32_t index;
+    VERIFY_IS_TRUE(PSV.FindResourceBind(PSVGetResourceClass(pBindInfo->ResType),
+                                        pBindInfo->Space, pBindInfo->LowerBound, &index));
+    VERIFY_ARE_EQUAL(i, index);
+  }
+  uint32_t rangeIndex, index;
+  VERIFY_IS_TRUE(PSV.FindResourceBind(PSVResourceClass::SRV, 1, 4, &rangeIndex));
+  VERIFY_IS_TRUE(PSV.FindResourceBind(PSVResourceClass::SRV, 1, 11, &index));
+  VERIFY_ARE_EQUAL(rangeIndex, index);
+  VERIFY_IS_FALSE(PSV.FindResourceBind(PSVResourceClass::SRV, 1, 12, &index));
+  VERIFY_IS_FALSE(PSV.FindResourceBind(PSVResourceClass::SRV, 0, 4, &index));
+  VERIFY_IS_FALSE(PSV.FindResourceBind(PSVResourceClass::UAV, 0, 0, &index));
+  VERIFY_IS_TRUE(PSV.FindResourceBind(PSVResourceClass::CBV, 0, 1, &index));
+
+  // The signature hash depends on the signatures only.
+  CComPtr<IDxcBlob> pOtherBody;
+  CComPtr<IDxcBlob> pOtherSignature;
+  DxilPipelineStateValidation otherBodyPSV, otherSignaturePSV;
+  CompileToProgram(otherBody, L"main", L"ps_6_0", indexArgs, _countof(indexArgs), &pOtherBody);
+  CompileToProgram(otherSignature, L"main", L"ps_6_0", indexArgs, _countof(indexArgs), &pOtherSignature);
+  loadPSV(pOtherBody, otherBodyPSV);
+  loadPSV(pOtherSignature, otherSignaturePSV);
+  VERIFY_ARE_EQUAL(PSV.GetSignatureHash(), otherBodyPSV.GetSignatureHash());
+  VERIFY_ARE_NOT_EQUAL(PSV.GetSignatureHash(), otherSignaturePSV.GetSignatureHash());
+}
+
+TEST_F(DxilContainerTest, ReflectionWhenCBufferFieldsUnusedThenNotMarkedUsed) {
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcContainerReflection> pContainer;
+  CComPtr<ID3D12ShaderReflection> pReflection;
+  const char program[] =
+    "Texture2D<float4> unusedTex : register(t0);\r\n"
+    "cbuffer CB : register(b0) { float4 a; float4 b; float c; float4 d; };\r\n"
+    "float4 main() : SV_Target { return b * c; }";
+  CompileToProgram(program, L"main", L"ps_6_0", nullptr, 0, &pProgram);
+
+  UINT32 shaderIdx;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcContainerReflection, &pContainer));
+  VERIFY_SUCCEEDED(pContainer->Load(pProgram));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(ID3D12ShaderReflection), (void**)&pReflection));
+
+  // Resources only referenced from dead code are not bound.
+  D3D12_SHADER_INPUT_BIND_DESC bindDesc;
+  VERIFY_FAILED(pReflection->GetResourceBindingDescByName("unusedTex", &bindDesc));
+
+  // Fields that are never loaded are reported as unused.
+  ID3D12ShaderReflectionConstantBuffer *pCB = pReflection->GetConstantBufferByName("CB");
+  const char *names[] = { "a", "b", "c", "d" };
+  const bool used[] = { false, true, true, false };
+  for (unsigned i = 0; i < _countof(names); ++i) {
+    D3D12_SHADER_VARIABLE_DESC varDesc;
+    VERIFY_SUCCEEDED(pCB->GetVariableByName(names[i])->GetDesc(&varDesc));
+    VERIFY_ARE_EQUAL(used[i], (varDesc.uFlags & D3D_SVF_USED) != 0);
+  }
+}
+
+TEST_F(DxilContainerTest, ReflectionWhenPartReflectedTwiceThenStateShared) {
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcContainerReflection> pContainer;
+  CComPtr<ID3D12ShaderReflection> pReflection;
+  CComPtr<ID3D12ShaderReflection> pOtherReflection;
+  const char program[] =
+    "Texture2D<float4> t : register(t3);\r\n"
+    "cbuffer CB : register(b0) { float4 a; float4 b; };\r\n"
+    "float4 main(float4 pos : SV_Position) : SV_Target { return t[pos.xy] * a + b; }";
+  CompileToProgram(program, L"main", L"ps_6_0", nullptr, 0, &pProgram);
+
+  UINT32 shaderIdx;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcContainerReflection, &pContainer));
+  VERIFY_SUCCEEDED(pContainer->Load(pProgram));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(ID3D12ShaderReflection), (void**)&pReflection));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(ID3D12ShaderReflection), (void**)&pOtherReflection));
+
+  // Each call returns its own object, over the part loaded once.
+  VERIFY_ARE_NOT_EQUAL(pReflection.p, pOtherReflection.p);
+  VERIFY_ARE_EQUAL(pReflection->GetConstantBufferByName("CB"),
+                   pOtherReflection->GetConstantBufferByName("CB"));
+
+  // Views stay valid without the container reflection, and can be queried
+  // from several threads at once.
+  pContainer.Release();
+  pOtherReflection.Release();
+  bool results[4];
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < _countof(results); ++i) {
+    threads.emplace_back([&pReflection, &results, i]() {
+      bool result = true;
+      for (unsigned n = 0; n < 100; ++n) {
+        D3D12_SHADER_INPUT_BIND_DESC bindDesc;
+        D3D12_SHADER_VARIABLE_DESC varDesc;
+        result &= SUCCEEDED(pReflection->GetResourceBindingDescByName("t", &bindDesc)) &&
+                  bindDesc.BindPoint == 3;
+        result &= SUCCEEDED(pReflection->GetVariableByName("b")->GetDesc(&varDesc)) &&
+                  varDesc.StartOffset == 16;
+      }
+      results[i] = result;
+    });
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+  for (bool result : results)
+    VERIFY_IS_TRUE(result);
+}
+
+TEST_F(DxilContainerTest, ReflectionWhenComputeShaderThenSummaryReported) {
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlob> pPixelProgram;
+  CComPtr<IDxcContainerReflection> pContainer;
+  CComPtr<IDxcComputeShaderReflection> pReflection;
+  const char program[] =
+    "RWStructuredBuffer<uint> buf : register(u0);\r\n"
+    "groupshared uint cache[64];\r\n"
+    "groupshared float4 tile[8];\r\n"
+    "[numthreads(8, 4, 2)]\r\n"
+    "void main(uint gi : SV_GroupIndex) {\r\n"
+    "  cache[gi] = buf[gi];\r\n"
+    "  tile[gi % 8] = float4(gi, gi, gi, gi);\r\n"
+    "  GroupMemoryBarrierWithGroupSync();\r\n"
+    "  buf[gi] = WaveActiveSum(cache[63 - gi]) + (uint)dot(tile[gi % 8], 1);\r\n"
+    "}";
+  CompileToProgram(program, L"main", L"cs_6_0", nullptr, 0, &pProgram);
+
+  UINT32 shaderIdx;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcContainerReflection, &pContainer));
+  VERIFY_SUCCEEDED(pContainer->Load(pProgram));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(IDxcComputeShaderReflection), (void**)&pReflection));
+
+  DxcComputeShaderSummary summary;
+  VERIFY_SUCCEEDED(pReflection->GetComputeShaderSummary(&summary));
+  VERIFY_ARE_EQUAL(8u, summary.ThreadGroupSize[0]);
+  VERIFY_ARE_EQUAL(4u, summary.ThreadGroupSize[1]);
+  VERIFY_ARE_EQUAL(2u, summary.ThreadGroupSize[2]);
+  VERIFY_ARE_EQUAL(64u * 4 + 8 * 16, summary.GroupSharedBytes);
+  VERIFY_IS_TRUE(summary.PeakLiveValues > 0);
+  VERIFY_ARE_EQUAL(DxcComputeShaderUsage_WaveOps, summary.Usage);
+
+  // Other stages have no summary.
+  pReflection.Release();
+  CompileToProgram("float4 main() : SV_Target { return 1; }", L"main",
+                   L"ps_6_0", nullptr, 0, &pPixelProgram);
+  VERIFY_SUCCEEDED(pContainer->Load(pPixelProgram));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(IDxcComputeShaderReflection), (void**)&pReflection));
+  VERIFY_ARE_EQUAL(E_NOTIMPL, pReflection->GetComputeShaderSummary(&summary));
+}
+
+TEST_F(DxilContainerTest, ReflectionWhenContainerMappedThenPartsNotCopied) {
+  CComPtr<IDxcBlob> pProgram;
+  CComPtr<IDxcBlobEncoding> pMapped;
+  CComPtr<IDxcBlob> pPartContent;
+  CComPtr<IDxcContainerReflection> pContainer;
+  CComPtr<ID3D12ShaderReflection> pReflection;
+  const char program[] =
+    "Texture2D<float4> t : register(t1);\r\n"
+    "SamplerState s : register(s2);\r\n"
+    "float4 main(float2 uv : TEXCOORD) : SV_Target { return t.Sample(s, uv); }";
+  CompileToProgram(program, L"main", L"ps_6_0", nullptr, 0, &pProgram);
+
+  wchar_t tempPath[MAX_PATH];
+  VERIFY_WIN32_BOOL_SUCCEEDED(GetTempPathW(MAX_PATH, tempPath) != 0);
+  std::wstring fileName(tempPath);
+  fileName += L"DxilContainerTest_mapped.dxo";
+  hlsl::WriteBinaryFile(fileName.c_str(), pProgram->GetBufferPointer(),
+                        pProgram->GetBufferSize());
+  VERIFY_SUCCEEDED(hlsl::DxcCreateBlobFromFileMapped(fileName.c_str(), nullptr, &pMapped));
+  VERIFY_ARE_EQUAL(pProgram->GetBufferSize(), pMapped->GetBufferSize());
+  VERIFY_ARE_EQUAL(0, memcmp(pProgram->GetBufferPointer(), pMapped->GetBufferPointer(),
+                             pProgram->GetBufferSize()));
+
+  // Part content is a view into the mapped file, and reflection reads the
+  // program from it.
+  UINT32 shaderIdx;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcContainerReflection, &pContainer));
+  VERIFY_SUCCEEDED(pContainer->Load(pMapped));
+  VERIFY_SUCCEEDED(pContainer->FindFirstPartKind(hlsl::DFCC_DXIL, &shaderIdx));
+  VERIFY_SUCCEEDED(pContainer->GetPartContent(shaderIdx, &pPartContent));
+  const char *pMappedStart = (const char *)pMapped->GetBufferPointer();
+  const char *pPartStart = (const char *)pPartContent->GetBufferPointer();
+  VERIFY_IS_TRUE(pMappedStart <= pPartStart &&
+                 pPartStart + pPartContent->GetBufferSize() <= pMappedStart + pMapped->GetBufferSize());
+  VERIFY_SUCCEEDED(pContainer->GetPartReflection(shaderIdx, __uuidof(ID3D12ShaderReflection), (void**)&pReflection));
+  D3D12_SHADER_INPUT_BIND_DESC bindDesc;
+  VERIFY_SUCCEEDED(pReflection->GetResourceBindingDescByName("t", &bindDesc));
+  VERIFY_ARE_EQUAL(1U, bindDesc.BindPoint);
+
+  // Release everything that refers to the mapping before deleting the file.
+  pReflection.Release();
+  pPartContent.Release();
+  pContainer.Release();
+  pMapped.Release();
+  VERIFY_WIN32_BOOL_SUCCEEDED(DeleteFileW(fileName.c_str()));
+}
+
+TEST_F(DxilContainerTest, ShaderArchiveWhenPermutationsThenPartsShared) {
+  CComPtr<IDxcBlob> pPrograms[3];
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<hlsl::AbstractMemoryStream> pArchiveStream;
+  LPCWSTR defineA[] = { L"/DVALUE=1" };
+  LPCWSTR defineB[] = { L"/DVALUE=2" };
+  const char program[] =
+    "float4 main(float4 pos : POSITION) : SV_Position { return pos * VALUE; }";
+  CompileToProgram(program, L"main", L"vs_6_0", defineA, _countof(defineA), &pPrograms[0]);
+  CompileToProgram(program, L"main", L"vs_6_0", defineB, _countof(defineB), &pPrograms[1]);
+  CompileToProgram(program, L"main", L"vs_6_0", defineA, _countof(defineA), &pPrograms[2]);
+
+  std::unique_ptr<hlsl::DxilShaderArchiveWriter> pWriter(hlsl::NewDxilShaderArchiveWriter());
+  hlsl::DxilContainerHash keys[3];
+  uint32_t totalPartCount = 0;
+  for (unsigned i = 0; i < _countof(pPrograms); ++i) {
+    const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+        pPrograms[i]->GetBufferPointer(), pPrograms[i]->GetBufferSize());
+    VERIFY_IS_TRUE(pWriter->AddContainer(pHeader, pPrograms[i]->GetBufferSize(), &keys[i]));
+    if (i < 2)
+      totalPartCount += pHeader->PartCount;
+  }
+
+  // The repeated compile is stored once, and the permutations share the
+  // signature parts that do not depend on VALUE.
+  VERIFY_ARE_EQUAL(0, memcmp(&keys[0], &keys[2], sizeof(keys[0])));
+  VERIFY_ARE_EQUAL(2U, pWriter->GetContainerCount());
+  VERIFY_IS_LESS_THAN(pWriter->GetUniquePartCount(), totalPartCount);
+
+  VERIFY_SUCCEEDED(CoGetMalloc(1, &pMalloc));
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pArchiveStream));
+  pWriter->write(pArchiveStream);
+  VERIFY_ARE_EQUAL(pWriter->size(), pArchiveStream->GetPtrSize());
+
+  hlsl::DxilShaderArchiveReader reader;
+  VERIFY_IS_TRUE(reader.Load(pArchiveStream->GetPtr(), pArchiveStream->GetPtrSize()));
+  VERIFY_ARE_EQUAL(2U, reader.GetContainerCount());
+  for (unsigned i = 0; i < 2; ++i) {
+    uint32_t index;
+    VERIFY_IS_TRUE(reader.FindContainer(keys[i], &index));
+    const hlsl::DxilShaderArchiveContainer &container = reader.GetContainer(index);
+    VERIFY_ARE_EQUAL(pPrograms[i]->GetBufferSize(), container.ContainerSizeInBytes);
+    std::vector<char> reconstituted(container.ContainerSizeInBytes);
+    reader.ReadContainer(index, reconstituted.data());
+    VERIFY_ARE_EQUAL(0, memcmp(reconstituted.data(), pPrograms[i]->GetBufferPointer(),
+                               reconstituted.size()));
+  }
+
+  // Unknown keys and truncated archives are rejected.
+  hlsl::DxilContainerHash unknownKey = keys[0];
+  unknownKey.Digest[0] ^= 0xFF;
+  uint32_t unknownIndex;
+  VERIFY_IS_FALSE(reader.FindContainer(unknownKey, &unknownIndex));
+  hlsl::DxilShaderArchiveReader truncatedReader;
+  VERIFY_IS_FALSE(truncatedReader.Load(pArchiveStream->GetPtr(),
+                                       pArchiveStream->GetPtrSize() - 1));
+}
+
 TEST_F(DxilContainerTest, ValidateFromLL_Abs2) {
   CodeGenTestCheck(L"abs2_m.ll");
 }
@@ -300,6 +300,63 @@ public:
   }
 };
 
+// Exposes the test table through the UTF-8 lookup interface, counting the
+// lookups of specific names that come through each entry point.
+class TestIntrinsicTable2 : public IDxcIntrinsicTable2 {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef);
+  CComPtr<TestIntrinsicTable> m_table;
+public:
+  unsigned m_wideLookups;
+  unsigned m_utf8Lookups;
+  TestIntrinsicTable2()
+    : m_dwRef(0), m_table(new TestIntrinsicTable()), m_wideLookups(0),
+      m_utf8Lookups(0) {}
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  __override HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject) {
+    return DoBasicQueryInterface<IDxcIntrinsicTable, IDxcIntrinsicTable2>(this, iid, ppvObject);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+  GetTableName(_Outptr_ LPCSTR *pTableName) {
+    return m_table->GetTableName(pTableName);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LookupIntrinsic(
+      LPCWSTR typeName, LPCWSTR functionName, const HLSL_INTRINSIC **pIntrinsic,
+      _Inout_ UINT64 *pLookupCookie) {
+    // Enumerating object methods with "*" always uses wide names.
+    if (functionName != nullptr && wcscmp(functionName, L"*") != 0)
+      ++m_wideLookups;
+    return m_table->LookupIntrinsic(typeName, functionName, pIntrinsic, pLookupCookie);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE LookupIntrinsicUtf8(
+      LPCSTR typeName, LPCSTR functionName, const HLSL_INTRINSIC **pIntrinsic,
+      _Inout_ UINT64 *pLookupCookie) {
+    ++m_utf8Lookups;
+    if (typeName == nullptr || functionName == nullptr)
+      return E_FAIL;
+    return m_table->LookupIntrinsic(CA2W(typeName, CP_UTF8), CA2W(functionName, CP_UTF8),
+                                    pIntrinsic, pLookupCookie);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+  GetLoweringStrategy(UINT opcode, _Outptr_ LPCSTR *pStrategy) {
+    return m_table->GetLoweringStrategy(opcode, pStrategy);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+  GetIntrinsicName(UINT opcode, _Outptr_ LPCSTR *pName) {
+    return m_table->GetIntrinsicName(opcode, pName);
+  }
+
+  __override HRESULT STDMETHODCALLTYPE
+  GetDxilOpCode(UINT opcode, _Outptr_ UINT *pDxilOpcode) {
+    return m_table->GetDxilOpCode(opcode, pDxilOpcode);
+  }
+};
+
 // A class to test semantic define validation.
 // It takes a list of defines that when present should cause errors
 // and defines that should cause warnings. A more realistic validator
@@ -341,6 +398,53 @@ public:
     return S_OK;
   }
 };
+
+// A batching validator that warns about one define and counts its calls.
+class TestSemanticDefineValidator2 : public IDxcSemanticDefineValidator2 {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef);
+  std::string m_warningDefine;
+public:
+  unsigned SingleCalls = 0;
+  unsigned BatchCalls = 0;
+  unsigned BatchDefines = 0;
+  TestSemanticDefineValidator2(const char *warningDefine)
+    : m_dwRef(0), m_warningDefine(warningDefine) { }
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+
+  __override HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** ppvObject) {
+    return DoBasicQueryInterface<IDxcSemanticDefineValidator, IDxcSemanticDefineValidator2>(this, iid, ppvObject);
+  }
+
+  virtual HRESULT STDMETHODCALLTYPE GetSemanticDefineWarningsAndErrors(LPCSTR pName, LPCSTR pValue, IDxcBlobEncoding **ppWarningBlob, IDxcBlobEncoding **ppErrorBlob) {
+    ++SingleCalls;
+    return Validate(pName, ppWarningBlob, ppErrorBlob);
+  }
+
+  virtual HRESULT STDMETHODCALLTYPE GetSemanticDefinesWarningsAndErrors(
+    UINT32 count, const LPCSTR *pNames, const LPCSTR *pValues,
+    IDxcBlobEncoding **ppWarningBlobs, IDxcBlobEncoding **ppErrorBlobs) {
+    ++BatchCalls;
+    BatchDefines += count;
+    for (UINT32 i = 0; i < count; ++i)
+      IFR(Validate(pNames[i], &ppWarningBlobs[i], &ppErrorBlobs[i]));
+    return S_OK;
+  }
+
+  HRESULT Validate(LPCSTR pName, IDxcBlobEncoding **ppWarningBlob, IDxcBlobEncoding **ppErrorBlob) {
+    *ppWarningBlob = nullptr;
+    *ppErrorBlob = nullptr;
+    if (m_warningDefine == pName) {
+      dxc::DxcDllSupport dllSupport;
+      VERIFY_SUCCEEDED(dllSupport.Initialize());
+      std::string warning("bad define: ");
+      warning.append(pName);
+      Utf8ToBlob(dllSupport, warning.c_str(), ppWarningBlob);
+    }
+    return S_OK;
+  }
+};
+
 static void CheckOperationFailed(IDxcOperationResult *pResult) {
   HRESULT status;
   VERIFY_SUCCEEDED(pResult->GetStatus(&status));
@@ -426,8 +530,10 @@ public:
   TEST_METHOD(DefineValidationError);
   TEST_METHOD(DefineValidationWarning);
   TEST_METHOD(DefineNoValidatorOk);
+  TEST_METHOD(DefineValidationWhenCachedThenBatchedOnce);
   TEST_METHOD(DefineFromMacro);
   TEST_METHOD(IntrinsicWhenAvailableThenUsed);
+  TEST_METHOD(IntrinsicWhenUtf8LookupThenUsed);
   TEST_METHOD(CustomIntrinsicName);
   TEST_METHOD(NoLowering);
   TEST_METHOD(PackedLowering);
@@ -510,6 +616,44 @@ TEST_F(ExtensionTest, DefineValidationError) {
     errors.find("hlsl.hlsl:1:9: error: bad define: FOO"));
 }
 
+TEST_F(ExtensionTest, DefineValidationWhenCachedThenBatchedOnce) {
+  Compiler c(m_dllSupport);
+  CComPtr<IDxcLangExtensions2> pLangExtensions2;
+  VERIFY_SUCCEEDED(c.pLangExtensions.QueryInterface(&pLangExtensions2));
+  VERIFY_SUCCEEDED(pLangExtensions2->SetSemanticDefineValidationCaching(TRUE));
+  c.RegisterSemanticDefine(L"FOO*");
+  CComPtr<TestSemanticDefineValidator2> pValidator =
+    new TestSemanticDefineValidator2("FOO");
+  c.SetSemanticDefineValidator(pValidator);
+
+  const char *program =
+    "#define FOO 1\n"
+    "#define FOOBAR 2\n"
+    "#define FOOBAZ 3\n"
+    "float4 main() : SV_Target {\n"
+    "  return 0;\n"
+    "}\n";
+  for (int i = 0; i < 2; ++i) {
+    c.pCompileResult.Release();
+    IDxcOperationResult *pCompileResult = c.Compile(program, { L"/Vd" }, {});
+    // Cached results still report their warnings.
+    std::string errors = GetCompileErrors(pCompileResult);
+    VERIFY_IS_TRUE(
+      errors.npos !=
+      errors.find("hlsl.hlsl:1:9: warning: bad define: FOO"));
+    std::string disassembly = c.Disassemble();
+    VERIFY_IS_TRUE(
+      disassembly.npos !=
+      disassembly.find("!{!\"FOOBAZ\", !\"3\"}"));
+  }
+
+  // The first compile validated every define in one call; the second
+  // validated none.
+  VERIFY_ARE_EQUAL(0, pValidator->SingleCalls);
+  VERIFY_ARE_EQUAL(1, pValidator->BatchCalls);
+  VERIFY_ARE_EQUAL(3, pValidator->BatchDefines);
+}
+
 TEST_F(ExtensionTest, DefineValidationWarning) {
   Compiler c(m_dllSupport);
   c.RegisterSemanticDefine(L"FOO*");
@@ -616,6 +760,31 @@ TEST_F(ExtensionTest, IntrinsicWhenAvailableThenUsed) {
     disassembly.find("declare float @\"test.\\01?test_fn@hlsl@@YA?AV?$vector@M$01@@V2@@Z.r\"(i32, float) #"));
 }
 
+TEST_F(ExtensionTest, IntrinsicWhenUtf8LookupThenUsed) {
+  Compiler c(m_dllSupport);
+  TestIntrinsicTable2 *pTable = new TestIntrinsicTable2();
+  c.RegisterIntrinsicTable(pTable);
+  c.Compile(
+    "Buffer<float2> buf;"
+    "float2 main(float2 v : V, uint2 u : U) : SV_Target {\n"
+    "  float2 a = test_fn(v);\n"
+    "  return a + buf.MyBufferOp(u);\n"
+    "}\n",
+    { L"/Vd" }, {}
+  );
+  std::string disassembly = c.Disassemble();
+
+  // Call sites were resolved through the UTF-8 lookup alone.
+  VERIFY_IS_TRUE(pTable->m_utf8Lookups > 0);
+  VERIFY_ARE_EQUAL(0U, pTable->m_wideLookups);
+  VERIFY_IS_TRUE(
+    disassembly.npos !=
+    disassembly.find("call float @\"test.\\01?test_fn@hlsl@@YA?AV?$vector@M$01@@V2@@Z.r\"(i32 1, float"));
+  VERIFY_IS_TRUE(
+    disassembly.npos !=
+    disassembly.find("@MyBufferOp(i32 12, %dx.types.Handle"));
+}
+
 TEST_F(ExtensionTest, CustomIntrinsicName) {
   Compiler c(m_dllSupport);
   c.RegisterIntrinsicTable(new TestIntrinsicTable());
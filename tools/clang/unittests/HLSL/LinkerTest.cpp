@@ -40,9 +40,16 @@ public:
 
   TEST_METHOD(RunLinkResource);
   TEST_METHOD(RunLinkAllProfiles);
+  TEST_METHOD(RunLinkBatch);
   TEST_METHOD(RunLinkFailNoDefine);
   TEST_METHOD(RunLinkFailReDefine);
   TEST_METHOD(RunLinkGlobalInit);
+  TEST_METHOD(RunLinkLibraryUpdate);
+  TEST_METHOD(RunLinkNestedHelpers);
+  TEST_METHOD(RunLinkConstants);
+  TEST_METHOD(RunLinkOptimized);
+  TEST_METHOD(RunLinkResultCache);
+  TEST_METHOD(RunLinkSharedHelper);
   TEST_METHOD(RunLinkFailReDefineGlobal);
   TEST_METHOD(RunLinkFailProfileMismatch);
   TEST_METHOD(RunLinkFailEntryNoProps);
@@ -83,10 +90,12 @@ public:
   }
 
   void Link(LPCWSTR pEntryName, LPCWSTR pShaderModel, IDxcLinker *pLinker,
-            ArrayRef<LPCWSTR> libNames, llvm::ArrayRef<LPCSTR> pCheckMsgs) {
+            ArrayRef<LPCWSTR> libNames, llvm::ArrayRef<LPCSTR> pCheckMsgs,
+            ArrayRef<LPCWSTR> arguments = {}) {
     CComPtr<IDxcOperationResult> pResult;
     VERIFY_SUCCEEDED(pLinker->Link(pEntryName, pShaderModel, libNames.data(),
-                                   libNames.size(), nullptr, 0, &pResult));
+                                   libNames.size(), arguments.data(),
+                                   arguments.size(), &pResult));
     CComPtr<IDxcBlob> pProgram;
     CheckOperationSucceeded(pResult, &pProgram);
 
@@ -160,6 +169,49 @@ TEST_F(LinkerTest, RunLinkAllProfiles) {
   Link(L"cs_main", L"cs_6_0", pLinker, {libName, libResName}, {});
 }
 
+TEST_F(LinkerTest, RunLinkBatch) {
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+  CComPtr<IDxcLinkerBatch> pLinkerBatch;
+  VERIFY_SUCCEEDED(pLinker.QueryInterface(&pLinkerBatch));
+
+  LPCWSTR libName = L"entry";
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_entries2.hlsl", &pEntryLib);
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  LPCWSTR libResName = L"res";
+  CComPtr<IDxcBlob> pResLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_resource2.hlsl", &pResLib);
+  RegisterDxcModule(libResName, pResLib, pLinker);
+
+  const DxcCompileTarget targets[] = {
+      {L"vs_main", L"vs_6_0"}, {L"hs_main", L"hs_6_0"},
+      {L"ds_main", L"ds_6_0"}, {L"gs_main", L"gs_6_0"},
+      {L"ps_main", L"ps_6_0"}, {L"cs_main", L"cs_6_0"},
+      {L"ps_main", L"vs_6_0"}};
+  const UINT32 targetCount = _countof(targets);
+  LPCWSTR libNames[] = {libName, libResName};
+  IDxcOperationResult *pResults[targetCount];
+  VERIFY_SUCCEEDED(pLinkerBatch->LinkBatch(targets, targetCount, libNames,
+                                           _countof(libNames), nullptr, 0,
+                                           pResults));
+
+  // Every target but the last links; the last has a mismatched profile.
+  for (UINT32 i = 0; i < targetCount; ++i) {
+    CComPtr<IDxcOperationResult> pResult;
+    pResult.Attach(pResults[i]);
+    if (i + 1 < targetCount) {
+      CComPtr<IDxcBlob> pProgram;
+      CheckOperationSucceeded(pResult, &pProgram);
+    } else {
+      LPCSTR pErrorMsg =
+          "Profile mismatch between entry function and target profile";
+      CheckOperationResultMsgs(pResult, &pErrorMsg, 1, false, false);
+    }
+  }
+}
+
 TEST_F(LinkerTest, RunLinkFailNoDefine) {
   CComPtr<IDxcBlob> pEntryLib;
   CompileLib(L"..\\CodeGenHLSL\\lib_cs_entry.hlsl", &pEntryLib);
@@ -203,6 +255,166 @@ TEST_F(LinkerTest, RunLinkGlobalInit) {
        {"dx.op.cbufferLoad"});
 }
 
+TEST_F(LinkerTest, RunLinkNestedHelpers) {
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_nested_helpers.hlsl", &pEntryLib);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  // Later links reuse the helpers prepared by earlier ones.
+  Link(L"ps_shade", L"ps_6_0", pLinker, {libName},
+       {"@dx.op.cbufferLoadLegacy", "fmul", "fadd"});
+  Link(L"ps_scale", L"ps_6_0", pLinker, {libName},
+       {"@dx.op.cbufferLoadLegacy", "fmul"});
+  Link(L"ps_shade", L"ps_6_0", pLinker, {libName},
+       {"@dx.op.cbufferLoadLegacy", "fmul", "fadd"});
+}
+
+TEST_F(LinkerTest, RunLinkConstants) {
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_link_constant.hlsl", &pEntryLib);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  // Without a value the default is used and the other branch is folded away.
+  Link(L"ps_mode", L"ps_6_0", pLinker, {libName}, {"fadd"});
+  Link(L"ps_mode", L"ps_6_0", pLinker, {libName}, {"fmul"},
+       {L"-D", L"kMode=1"});
+  Link(L"ps_mode", L"ps_6_0", pLinker, {libName}, {"fadd"},
+       {L"-DkMode=0"});
+
+  CComPtr<IDxcOperationResult> pResult;
+  LPCWSTR args[] = {L"-DkMode=fast"};
+  VERIFY_SUCCEEDED(pLinker->Link(L"ps_mode", L"ps_6_0", &libName, 1, args,
+                                 _countof(args), &pResult));
+  LPCSTR errors[] = {"Invalid value for link-time constant kMode"};
+  CheckOperationResultMsgs(pResult, errors, _countof(errors), false, false);
+}
+
+TEST_F(LinkerTest, RunLinkOptimized) {
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_nested_helpers.hlsl", &pEntryLib);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  Link(L"ps_shade", L"ps_6_0", pLinker, {libName},
+       {"@dx.op.cbufferLoadLegacy", "fmul", "fadd"}, {L"-O3"});
+  Link(L"ps_shade", L"ps_6_0", pLinker, {libName},
+       {"@dx.op.cbufferLoadLegacy", "fmul", "fadd"}, {L"-Od"});
+
+  CComPtr<IDxcOperationResult> pResult;
+  LPCWSTR args[] = {L"-O4"};
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+                   pLinker->Link(L"ps_shade", L"ps_6_0", &libName, 1, args,
+                                 _countof(args), &pResult));
+}
+
+TEST_F(LinkerTest, RunLinkLibraryUpdate) {
+  CComPtr<IDxcBlob> pEntryLib, pUpdatedLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_nested_helpers.hlsl", &pEntryLib);
+  CompileLib(L"..\\CodeGenHLSL\\lib_nested_helpers.hlsl", &pUpdatedLib);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+  CComPtr<IDxcLinkerResultCache> pCache;
+  VERIFY_SUCCEEDED(pLinker.QueryInterface(&pCache));
+  VERIFY_SUCCEEDED(pCache->SetResultCacheCapacity(4));
+  CComPtr<IDxcLinkerLibraryUpdate> pUpdate;
+  VERIFY_SUCCEEDED(pLinker.QueryInterface(&pUpdate));
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  auto linkProgram = [&](LPCWSTR pEntryName, IDxcBlob **ppProgram) {
+    CComPtr<IDxcOperationResult> pResult;
+    VERIFY_SUCCEEDED(pLinker->Link(pEntryName, L"ps_6_0", &libName, 1,
+                                   nullptr, 0, &pResult));
+    CheckOperationSucceeded(pResult, ppProgram);
+  };
+
+  // No function changed, so the cached results stay valid.
+  CComPtr<IDxcBlob> pShade, pScale, pShadeAfter, pScaleAfter;
+  linkProgram(L"ps_shade", &pShade);
+  linkProgram(L"ps_scale", &pScale);
+  VERIFY_SUCCEEDED(pUpdate->UpdateLibrary(libName, pUpdatedLib));
+  linkProgram(L"ps_shade", &pShadeAfter);
+  linkProgram(L"ps_scale", &pScaleAfter);
+  VERIFY_ARE_EQUAL(pShade.p, pShadeAfter.p);
+  VERIFY_ARE_EQUAL(pScale.p, pScaleAfter.p);
+
+  // Only registered libraries can be updated.
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+                   pUpdate->UpdateLibrary(L"missing", pUpdatedLib));
+}
+
+TEST_F(LinkerTest, RunLinkResultCache) {
+  CComPtr<IDxcBlob> pEntryLib;
+  CompileLib(L"..\\CodeGenHLSL\\lib_nested_helpers.hlsl", &pEntryLib);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+  CComPtr<IDxcLinkerResultCache> pCache;
+  VERIFY_SUCCEEDED(pLinker.QueryInterface(&pCache));
+  VERIFY_SUCCEEDED(pCache->SetResultCacheCapacity(1));
+
+  LPCWSTR libName = L"entry";
+  RegisterDxcModule(libName, pEntryLib, pLinker);
+
+  auto linkProgram = [&](LPCWSTR pEntryName, ArrayRef<LPCWSTR> arguments,
+                         IDxcBlob **ppProgram) {
+    CComPtr<IDxcOperationResult> pResult;
+    VERIFY_SUCCEEDED(pLinker->Link(pEntryName, L"ps_6_0", &libName, 1,
+                                   arguments.data(), arguments.size(),
+                                   &pResult));
+    CheckOperationSucceeded(pResult, ppProgram);
+  };
+
+  // An identical link returns the cached container.
+  CComPtr<IDxcBlob> pFirst, pSecond, pOptimized, pOther, pThird;
+  linkProgram(L"ps_shade", {}, &pFirst);
+  linkProgram(L"ps_shade", {}, &pSecond);
+  VERIFY_ARE_EQUAL(pFirst.p, pSecond.p);
+
+  // Different arguments link again.
+  linkProgram(L"ps_shade", {L"-O3"}, &pOptimized);
+  VERIFY_ARE_NOT_EQUAL(pFirst.p, pOptimized.p);
+
+  // With a capacity of one, the first result has been dropped.
+  linkProgram(L"ps_scale", {}, &pOther);
+  linkProgram(L"ps_shade", {}, &pThird);
+  VERIFY_ARE_NOT_EQUAL(pFirst.p, pThird.p);
+  VERIFY_ARE_EQUAL(pFirst->GetBufferSize(), pThird->GetBufferSize());
+}
+
+TEST_F(LinkerTest, RunLinkSharedHelper) {
+  CComPtr<IDxcBlob> pLib0;
+  CompileLib(L"..\\CodeGenHLSL\\lib_shared_helper.hlsl", &pLib0);
+  CComPtr<IDxcBlob> pLib1;
+  CompileLib(L"..\\CodeGenHLSL\\lib_shared_helper2.hlsl", &pLib1);
+  CComPtr<IDxcLinker> pLinker;
+  CreateLinker(&pLinker);
+
+  LPCWSTR libName0 = L"lib0";
+  RegisterDxcModule(libName0, pLib0, pLinker);
+  LPCWSTR libName1 = L"lib1";
+  RegisterDxcModule(libName1, pLib1, pLinker);
+
+  // Both libraries define the same Tint, which is merged rather than
+  // reported as a redefinition.
+  Link(L"ps_tint", L"ps_6_0", pLinker, {libName0, libName1}, {"fmul", "fadd"});
+  Link(L"ps_tint2", L"ps_6_0", pLinker, {libName0, libName1},
+       {"fmul", "fadd"});
+  Link(L"ps_tint2", L"ps_6_0", pLinker, {libName1, libName0},
+       {"fmul", "fadd"});
+}
+
 TEST_F(LinkerTest, RunLinkFailReDefineGlobal) {
   CComPtr<IDxcBlob> pEntryLib;
   CompileLib(L"..\\CodeGenHLSL\\lib_global2.hlsl", &pEntryLib);
@@ -502,6 +502,7 @@ public:
   TEST_METHOD(AssignReturnResult);
   TEST_METHOD(PassToInoutArgs);
   TEST_METHOD(TemplateArgConstraints);
+  TEST_METHOD(RepeatedTemplateArgs);
   TEST_METHOD(FunctionInvoke);
 
   void FormatTypeNameAndPreamble(const ShaderObjectDataItem& sod,
@@ -887,6 +888,27 @@ TEST_F(ObjectTest, TemplateArgConstraints) {
   }
 }
 
+TEST_F(ObjectTest, RepeatedTemplateArgs) {
+  // Specializations checked once are reused; the same template with other
+  // arguments must still be checked.
+  const char valid[] =
+    "Buffer<float4> b1; Buffer<float4> b2; StructuredBuffer<float2x2> s1;"
+    "float ps(float4 color : COLOR) { StructuredBuffer<float2x2> s2 = s1;"
+    " vector<float, 2> v1 = 0; vector<float, 1 + 1> v2 = v1;"
+    " return b1[0].x + b2[0].x + s2[0]._m00 + v2.x; }";
+  CheckCompiles(valid, strlen(valid), true);
+
+  const char invalidVector[] =
+    "float ps(float4 color : COLOR) { vector<float, 4> v1 = 0;"
+    " vector<float, 5> v2; return v1.x; }";
+  CheckCompiles(invalidVector, strlen(invalidVector), false);
+
+  const char invalidMatrix[] =
+    "matrix<float, 2, 4> m1; matrix<float, 2, 5> m2;"
+    "float ps(float4 color : COLOR) { return m1._m00; }";
+  CheckCompiles(invalidMatrix, strlen(invalidMatrix), false);
+}
+
 static
 std::string SelectComponentType(BYTE legalTypes)
 {
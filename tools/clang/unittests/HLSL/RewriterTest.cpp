@@ -76,6 +76,7 @@ public:
   TEST_METHOD(RunNoFunctionBody);
   TEST_METHOD(RunNoFunctionBodyInclude);
   TEST_METHOD(RunNoStatic);
+  TEST_METHOD(RunRemoveUnusedGlobalsForEntryPoints);
 
   dxc::DxcDllSupport m_dllSupport;
   CComPtr<IDxcIncludeHandler> m_pIncludeHandler;
@@ -521,4 +522,50 @@ TEST_F(RewriterTest, RunNoStatic) {
   std::string strResult = BlobToUtf8(result);
   // No static.
   VERIFY_IS_TRUE(strResult.find("static") == std::string::npos);
-}
\ No newline at end of file
+}
+TEST_F(RewriterTest, RunRemoveUnusedGlobalsForEntryPoints) {
+  CComPtr<IDxcRewriter> pRewriter;
+  CComPtr<IDxcRewriter2> pRewriter2;
+  VERIFY_SUCCEEDED(CreateRewriter(&pRewriter));
+  VERIFY_SUCCEEDED(pRewriter.QueryInterface(&pRewriter2));
+
+  const char source[] =
+      "float globalA;\n"
+      "float globalB;\n"
+      "float useA() { return globalA; }\n"
+      "float useB() { return globalB; }\n"
+      "float mainA() : SV_Target { return useA(); }\n"
+      "float mainB() : SV_Target { return useB(); }\n";
+  CComPtr<IDxcBlobEncoding> pSource;
+  CreateBlobPinned(source, sizeof(source) - 1, CP_UTF8, &pSource);
+
+  LPCWSTR entryPoints[] = { L"mainA", L"mainB" };
+  IDxcOperationResult *pResults[_countof(entryPoints)] = {};
+  VERIFY_SUCCEEDED(pRewriter2->RemoveUnusedGlobalsForEntryPoints(
+      pSource, entryPoints, _countof(entryPoints), nullptr, 0, pResults));
+  CComPtr<IDxcOperationResult> pResultA, pResultB;
+  pResultA.Attach(pResults[0]);
+  pResultB.Attach(pResults[1]);
+
+  CComPtr<IDxcBlob> pBlobA, pBlobB;
+  VERIFY_SUCCEEDED(pResultA->GetResult(&pBlobA));
+  VERIFY_SUCCEEDED(pResultB->GetResult(&pBlobB));
+  std::string resultA = BlobToUtf8(pBlobA);
+  std::string resultB = BlobToUtf8(pBlobB);
+
+  VERIFY_IS_TRUE(resultA.find("globalA") != std::string::npos);
+  VERIFY_IS_TRUE(resultA.find("useA") != std::string::npos);
+  VERIFY_IS_TRUE(resultA.find("globalB") == std::string::npos);
+  VERIFY_IS_TRUE(resultA.find("mainB") == std::string::npos);
+  VERIFY_IS_TRUE(resultB.find("globalB") != std::string::npos);
+  VERIFY_IS_TRUE(resultB.find("globalA") == std::string::npos);
+  VERIFY_IS_TRUE(resultB.find("useA") == std::string::npos);
+
+  // Each result matches the single entry point rewrite.
+  CComPtr<IDxcOperationResult> pSingleResult;
+  CComPtr<IDxcBlob> pSingleBlob;
+  VERIFY_SUCCEEDED(pRewriter->RemoveUnusedGlobals(pSource, L"mainB", nullptr,
+                                                  0, &pSingleResult));
+  VERIFY_SUCCEEDED(pSingleResult->GetResult(&pSingleBlob));
+  VERIFY_ARE_EQUAL(resultB, BlobToUtf8(pSingleBlob));
+}
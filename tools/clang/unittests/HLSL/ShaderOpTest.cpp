@@ -345,6 +345,14 @@ void ShaderOpTest::CreateDescriptorHeaps() {
   queryHeapDesc.Count = 1;
   queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
   CHECK_HR(m_pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pQueryHeap)));
+
+  // Create a timestamp heap with a begin and an end for each timed run.
+  if (m_TimingRunCount != 0) {
+    ZeroMemory(&queryHeapDesc, sizeof(queryHeapDesc));
+    queryHeapDesc.Count = m_TimingRunCount * 2;
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    CHECK_HR(m_pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pTimestampHeap)));
+  }
 }
 
 void ShaderOpTest::CreateDevice() {
@@ -585,6 +593,17 @@ void ShaderOpTest::CreateResources() {
     SetObjectName(m_pQueryBuffer, "Query Pipeline Readback Buffer");
   }
 
+  // Create a buffer to receive timestamps.
+  if (m_TimingRunCount != 0) {
+    CD3DX12_HEAP_PROPERTIES readback(D3D12_HEAP_TYPE_READBACK);
+    CD3DX12_RESOURCE_DESC readbackDesc(CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT64) * m_TimingRunCount * 2));
+    CHECK_HR(m_pDevice->CreateCommittedResource(
+      &readback, D3D12_HEAP_FLAG_NONE, &readbackDesc,
+      D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+      IID_PPV_ARGS(&m_pTimestampBuffer)));
+    SetObjectName(m_pTimestampBuffer, "Query Timestamp Readback Buffer");
+  }
+
   CHECK_HR(pList->Close());
   ExecuteCommandList(ResCommandList.Queue, pList);
   WaitForSignal(ResCommandList.Queue, m_pFence, m_hFence, m_FenceValue++);
@@ -681,6 +700,21 @@ void ShaderOpTest::GetPipelineStats(D3D12_QUERY_DATA_PIPELINE_STATISTICS *pStats
   memcpy(pStats, M.data(), sizeof(*pStats));
 }
 
+void ShaderOpTest::GetGpuTimesMs(std::vector<double> *pTimes) {
+  pTimes->clear();
+  if (m_TimingRunCount == 0)
+    return;
+  UINT64 frequency;
+  CHECK_HR(m_CommandList.Queue->GetTimestampFrequency(&frequency));
+  MappedData M;
+  M.reset(m_pTimestampBuffer, sizeof(UINT64) * m_TimingRunCount * 2);
+  const UINT64 *pTimestamps = (const UINT64 *)M.data();
+  for (UINT i = 0; i < m_TimingRunCount; ++i) {
+    UINT64 ticks = pTimestamps[i * 2 + 1] - pTimestamps[i * 2];
+    pTimes->push_back(ticks * 1000.0 / frequency);
+  }
+}
+
 void ShaderOpTest::GetReadBackData(LPCSTR pResourceName, MappedData *pData) {
   pResourceName = m_pShaderOp->Strings.insert(pResourceName); // Unique
   ShaderOpResourceData &D = m_ResourceData.at(pResourceName);
@@ -712,6 +746,15 @@ void ShaderOpTest::RunCommandList() {
     SetRootValues(pList, m_pShaderOp->IsCompute());
     pList->Dispatch(m_pShaderOp->DispatchX, m_pShaderOp->DispatchY,
                     m_pShaderOp->DispatchZ);
+    // The UAV barriers keep the timed dispatches from overlapping.
+    for (UINT i = 0; i < m_TimingRunCount; ++i) {
+      CD3DX12_RESOURCE_BARRIER barrier(CD3DX12_RESOURCE_BARRIER::UAV(nullptr));
+      pList->ResourceBarrier(1, &barrier);
+      pList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, i * 2);
+      pList->Dispatch(m_pShaderOp->DispatchX, m_pShaderOp->DispatchY,
+                      m_pShaderOp->DispatchZ);
+      pList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, i * 2 + 1);
+    }
   } else {
     pList->SetPipelineState(m_pPSO);
     pList->SetGraphicsRootSignature(m_pRootSignature);
@@ -785,6 +828,15 @@ void ShaderOpTest::RunCommandList() {
     pList->EndQuery(m_pQueryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0);
     pList->ResolveQueryData(m_pQueryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS,
                             0, 1, m_pQueryBuffer, 0);
+    for (UINT i = 0; i < m_TimingRunCount; ++i) {
+      pList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, i * 2);
+      pList->DrawInstanced(vertexCountPerInstance, instanceCount, 0, 0);
+      pList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, i * 2 + 1);
+    }
+  }
+  if (m_TimingRunCount != 0) {
+    pList->ResolveQueryData(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0,
+                            m_TimingRunCount * 2, m_pTimestampBuffer, 0);
   }
   CHECK_HR(pList->Close());
   ExecuteCommandList(m_CommandList.Queue, pList);
@@ -877,6 +929,10 @@ void ShaderOpTest::SetDxcSupport(dxc::DxcDllSupport *pDxcSupport) {
   m_pDxcSupport = pDxcSupport;
 }
 
+void ShaderOpTest::SetTimingRunCount(UINT count) {
+  m_TimingRunCount = count;
+}
+
 void ShaderOpTest::SetInitCallback(TInitCallbackFn InitCallbackFn) {
   m_InitCallbackFn = InitCallbackFn;
 }
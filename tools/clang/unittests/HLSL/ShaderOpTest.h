@@ -235,11 +235,17 @@ public:
   typedef std::function<void(LPCSTR Name, std::vector<BYTE> &Data, ShaderOp *pShaderOp)> TInitCallbackFn;
   void GetPipelineStats(D3D12_QUERY_DATA_PIPELINE_STATISTICS *pStats);
   void GetReadBackData(LPCSTR pResourceName, MappedData *pData);
+  // Returns the GPU time of each timed repetition, in milliseconds.
+  void GetGpuTimesMs(std::vector<double> *pTimes);
   void RunShaderOp(ShaderOp *pShaderOp);
   void RunShaderOp(std::shared_ptr<ShaderOp> pShaderOp);
   void SetDevice(ID3D12Device* pDevice);
   void SetDxcSupport(dxc::DxcDllSupport *pDxcSupport);
   void SetInitCallback(TInitCallbackFn InitCallbackFn);
+  // Repeats the dispatch or draw count more times after the checked one,
+  // each between timestamp queries. The operation must produce the same
+  // results when repeated.
+  void SetTimingRunCount(UINT count);
   void SetupRenderTarget(ShaderOp *pShaderOp, ID3D12Device *pDevice,
                          ID3D12CommandQueue *pCommandQueue,
                          ID3D12Resource *pRenderTarget);
@@ -265,6 +271,9 @@ private:
   CComPtr<ID3D12RootSignature> m_pRootSignature;
   CComPtr<ID3D12QueryHeap> m_pQueryHeap;
   CComPtr<ID3D12Resource> m_pQueryBuffer;
+  CComPtr<ID3D12QueryHeap> m_pTimestampHeap;
+  CComPtr<ID3D12Resource> m_pTimestampBuffer;
+  UINT m_TimingRunCount = 0;
   dxc::DxcDllSupport *m_pDxcSupport = nullptr;
   CommandListRefs m_CommandList;
   HANDLE m_hFence;
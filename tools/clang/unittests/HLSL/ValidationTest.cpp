@@ -126,6 +126,9 @@ public:
   TEST_CLASS_SETUP(InitSupport);
 
   TEST_METHOD(WhenCorrectThenOK);
+  TEST_METHOD(WhenValidationCachedThenPartsStillChecked);
+  TEST_METHOD(WhenStructuralOnlyThenModuleNotValidated);
+  TEST_METHOD(WhenMaxErrorsThenDiagnosticsStreamedAndTruncated);
   TEST_METHOD(WhenMisalignedThenFail);
   TEST_METHOD(WhenEmptyFileThenFail);
   TEST_METHOD(WhenIncorrectMagicThenFail);
@@ -157,6 +160,7 @@ public:
   TEST_METHOD(ResourceRangeOverlap3)
   TEST_METHOD(CBufferOverlap0)
   TEST_METHOD(CBufferOverlap1)
+  TEST_METHOD(CompactTypeAnnotationsNeedValidator1_2)
   TEST_METHOD(ControlFlowHint)
   TEST_METHOD(ControlFlowHint1)
   TEST_METHOD(ControlFlowHint2)
@@ -211,9 +215,8 @@ public:
   TEST_METHOD(BigStructInBuffer)
   TEST_METHOD(GloballyCoherent2)
   TEST_METHOD(GloballyCoherent3)
-  // TODO: enable this.
-  //TEST_METHOD(TGSMRaceCond)
-  //TEST_METHOD(TGSMRaceCond2)
+  TEST_METHOD(TGSMRaceCond)
+  TEST_METHOD(TGSMRaceCond2)
   TEST_METHOD(AddUint64Odd)
 
   TEST_METHOD(BarycentricFloat4Fail)
@@ -255,6 +258,7 @@ public:
   TEST_METHOD(GetDimCalcLODFail);
   TEST_METHOD(HsAttributeFail);
   TEST_METHOD(InnerCoverageFail);
+  TEST_METHOD(LibFunctionsWhenManyFailThenAllReported);
   TEST_METHOD(InterpChangeFail);
   TEST_METHOD(InterpOnIntFail);
   TEST_METHOD(InvalidSigCompTyFail);
@@ -787,6 +791,21 @@ TEST_F(ValidationTest, InnerCoverageFail) {
       },
       "InnerCoverage and Coverage are mutually exclusive.");
 }
+TEST_F(ValidationTest, LibFunctionsWhenManyFailThenAllReported) {
+  // Enough functions for the definitions to be validated concurrently.
+  std::string source;
+  for (unsigned i = 0; i < 64; ++i) {
+    source += "export float f" + std::to_string(i) + "(float a) { return a * " +
+              std::to_string(i + 2) + "; }\n";
+  }
+  RewriteAssemblyCheckMsg(
+      source.c_str(), "lib_6_1",
+      {"ret float %[a-z0-9.]+"},
+      {"ret float undef"},
+      {"Instructions should not read uninitialized value.*f0.*"
+       "Instructions should not read uninitialized value.*f63"},
+      /*bRegex*/ true);
+}
 TEST_F(ValidationTest, InterpChangeFail) {
   RewriteAssemblyCheckMsg(
       L"..\\CodeGenHLSL\\interpChange.hlsl", "ps_6_0",
@@ -1142,19 +1161,28 @@ TEST_F(ValidationTest, ResourceRangeOverlap3) {
 TEST_F(ValidationTest, CBufferOverlap0) {
     RewriteAssemblyCheckMsg(
       L"..\\CodeGenHLSL\\cbufferOffset.hlsl", "ps_6_0",
-      "i32 6, !\"g2\", i32 3, i32 0",
-      "i32 6, !\"g2\", i32 3, i32 8",
-      "CBuffer Foo1 has offset overlaps at 16");
+      "(i32 73, i32 [0-9]+, i32 16, i32 9, i32 73, i32 [0-9]+, )i32 0, ",
+      "\\1i32 8, ",
+      "CBuffer Foo1 has offset overlaps at 16",
+      /*bRegex*/true);
 }
 
 TEST_F(ValidationTest, CBufferOverlap1) {
     RewriteAssemblyCheckMsg(
       L"..\\CodeGenHLSL\\cbufferOffset.hlsl", "ps_6_0",
-      " = !{i32 32, !",
-      " = !{i32 16, !",
+      "[i32 32, i32 2, ",
+      "[i32 16, i32 2, ",
       "CBuffer Foo1 size insufficient for element at offset 16");
 }
 
+TEST_F(ValidationTest, CompactTypeAnnotationsNeedValidator1_2) {
+    RewriteAssemblyCheckMsg(
+      L"..\\CodeGenHLSL\\cbufferOffset.hlsl", "ps_6_0",
+      "!{i32 1, i32 2}",
+      "!{i32 1, i32 1}",
+      "TODO - Metadata must be well-formed in operand count and types");
+}
+
 TEST_F(ValidationTest, ControlFlowHint) {
     RewriteAssemblyCheckMsg(
       L"..\\CodeGenHLSL\\if1.hlsl", "ps_6_0",
@@ -1545,19 +1573,18 @@ TEST_F(ValidationTest, GloballyCoherent3) {
   TestCheck(L"..\\CodeGenHLSL\\globallycoherent3.hlsl");
 }
 
-// TODO: enable this.
-//TEST_F(ValidationTest, TGSMRaceCond) {
-//  TestCheck(L"..\\CodeGenHLSL\\RaceCond.hlsl");
-//}
-//
-//TEST_F(ValidationTest, TGSMRaceCond2) {
-//    RewriteAssemblyCheckMsg(L"..\\CodeGenHLSL\\structInBuffer.hlsl", "cs_6_0",
-//        "ret void",
-//        "%TID = call i32 @dx.op.flattenedThreadIdInGroup.i32(i32 96)\n"
-//        "store i32 %TID, i32 addrspace(3)* @\"\\01?sharedData@@3UFoo@@A.3\", align 4\n"
-//        "ret void",
-//        "Race condition writing to shared memory detected, consider making this write conditional");
-//}
+TEST_F(ValidationTest, TGSMRaceCond) {
+  TestCheck(L"..\\CodeGenHLSL\\RaceCond.hlsl");
+}
+
+TEST_F(ValidationTest, TGSMRaceCond2) {
+    RewriteAssemblyCheckMsg(L"..\\CodeGenHLSL\\structInBuffer.hlsl", "cs_6_0",
+        "ret void",
+        "%TID = call i32 @dx.op.flattenedThreadIdInGroup.i32(i32 96)\n"
+        "store i32 %TID, i32 addrspace(3)* @\"\\01?sharedData@@3UFoo@@A.3\", align 4\n"
+        "ret void",
+        "Race condition writing to shared memory detected, consider making this write conditional");
+}
 
 TEST_F(ValidationTest, AddUint64Odd) {
   TestCheck(L"..\\CodeGenHLSL\\AddUint64Odd.hlsl");
@@ -2924,6 +2951,130 @@ TEST_F(ValidationTest, WhenPSVMismatchThenFail) {
   );
 }
 
+TEST_F(ValidationTest, WhenValidationCachedThenPartsStillChecked) {
+  if (!m_ver.m_InternalValidator) {
+    WEX::Logging::Log::Comment(L"Test skipped; the validation cache is only available in the internal validator.");
+    return;
+  }
+  CComPtr<IDxcValidator> pValidator;
+  CComPtr<IDxcValidatorCaching> pCaching;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+  VERIFY_SUCCEEDED(pValidator.QueryInterface(&pCaching));
+  VERIFY_SUCCEEDED(pCaching->SetValidationCacheEnabled(TRUE));
+
+  LPCSTR pSource = "float c; [RootSignature ( \"RootConstants(b0, num32BitConstants = 1)\" )] float4 main() : semantic { return c; }";
+  CComPtr<IDxcBlob> pProgram;
+  CompileSource(pSource, "vs_6_0", &pProgram);
+  CheckValidationMsgs(pProgram, nullptr);
+  CheckValidationMsgs(pProgram, nullptr);
+
+  // The module is now cached as valid; a mismatched part must still fail.
+  ReplaceContainerPartsCheckMsgs(
+    pSource,
+    "[RootSignature ( \"\" )] float4 main() : semantic { return 0; }",
+    "vs_6_0",
+    {DFCC_PipelineStateValidation},
+    {
+      "Container part 'Pipeline State Validation' does not match expected for module.",
+      "Validation failed."
+    }
+  );
+
+  VERIFY_SUCCEEDED(pCaching->SetValidationCacheEnabled(FALSE));
+}
+
+TEST_F(ValidationTest, WhenStructuralOnlyThenModuleNotValidated) {
+  if (!m_ver.m_InternalValidator) {
+    WEX::Logging::Log::Comment(L"Test skipped; structural-only validation is only available in the internal validator.");
+    return;
+  }
+  // Build a container whose parts match its module, but whose module fails
+  // validation.
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pText;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  VERIFY_SUCCEEDED(pLibrary->CreateBlobFromFile(
+      hlsl_test::GetPathToHlslDataFile(L"..\\CodeGenHLSL\\InnerCoverage2.hlsl").c_str(),
+      nullptr, &pSource));
+  RewriteAssemblyToText(pSource, "ps_6_0",
+      {"dx.op.coverage.i32(i32 91)",
+       "declare i32 @dx.op.coverage.i32(i32)"},
+      {"dx.op.coverage.i32(i32 91)\n  %inner = call i32 @dx.op.innerCoverage.i32(i32 92)",
+       "declare i32 @dx.op.coverage.i32(i32)\n"
+       "declare i32 @dx.op.innerCoverage.i32(i32)"},
+      &pText);
+
+  CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcOperationResult> pAssembleResult;
+  CComPtr<IDxcBlob> pContainer;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
+  VERIFY_SUCCEEDED(pAssembler->AssembleToContainer(pText, &pAssembleResult));
+  VERIFY_SUCCEEDED(pAssembleResult->GetResult(&pContainer));
+
+  CComPtr<IDxcValidator> pValidator;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+  CComPtr<IDxcOperationResult> pResult;
+  VERIFY_SUCCEEDED(pValidator->Validate(pContainer, DxcValidatorFlags_Default, &pResult));
+  CheckOperationResultMsgs(pResult, {"InnerCoverage and Coverage are mutually exclusive."}, false, false);
+
+  pResult.Release();
+  VERIFY_SUCCEEDED(pValidator->Validate(pContainer, DxcValidatorFlags_StructuralOnly, &pResult));
+  CheckOperationResultMsgs(pResult, nullptr, false, false);
+
+  // Structural-only validation does not apply to bare modules.
+  pResult.Release();
+  VERIFY_ARE_EQUAL(E_INVALIDARG,
+      pValidator->Validate(pContainer, DxcValidatorFlags_StructuralOnly | DxcValidatorFlags_ModuleOnly, &pResult));
+}
+
+TEST_F(ValidationTest, WhenMaxErrorsThenDiagnosticsStreamedAndTruncated) {
+  if (!m_ver.m_InternalValidator) {
+    WEX::Logging::Log::Comment(L"Test skipped; diagnostic limits are only available in the internal validator.");
+    return;
+  }
+  // One error in each of 64 functions, validated concurrently.
+  std::string source;
+  for (unsigned i = 0; i < 64; ++i) {
+    source += "export float f" + std::to_string(i) + "(float a) { return a * " +
+              std::to_string(i + 2) + "; }\n";
+  }
+  CComPtr<IDxcBlobEncoding> pSource;
+  CComPtr<IDxcBlob> pText;
+  Utf8ToBlob(m_dllSupport, source.c_str(), &pSource);
+  RewriteAssemblyToText(pSource, "lib_6_1", {"ret float %[a-z0-9.]+"},
+                        {"ret float undef"}, &pText, /*bRegex*/ true);
+
+  CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcOperationResult> pAssembleResult;
+  CComPtr<IDxcBlob> pContainer;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
+  VERIFY_SUCCEEDED(pAssembler->AssembleToContainer(pText, &pAssembleResult));
+  VERIFY_SUCCEEDED(pAssembleResult->GetResult(&pContainer));
+
+  CComPtr<IDxcValidatorDiagnostics> pValidator;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcValidator, &pValidator));
+  VERIFY_SUCCEEDED(pValidator->SetMaxErrors(4));
+
+  CComPtr<IMalloc> pMalloc;
+  CComPtr<hlsl::AbstractMemoryStream> pDiagStream;
+  VERIFY_SUCCEEDED(CoGetMalloc(1, &pMalloc));
+  VERIFY_SUCCEEDED(hlsl::CreateMemoryStream(pMalloc, &pDiagStream));
+  HRESULT status;
+  VERIFY_SUCCEEDED(pValidator->ValidateToStream(pContainer, DxcValidatorFlags_Default,
+                                                pDiagStream, &status));
+  VERIFY_FAILED(status);
+
+  std::string diag((const char *)pDiagStream->GetPtr(), pDiagStream->GetPtrSize());
+  VERIFY_IS_TRUE(diag.find("too many errors emitted, stopping now") != std::string::npos);
+  VERIFY_IS_TRUE(diag.find("Validation failed.") != std::string::npos);
+  size_t errorCount = 0;
+  for (size_t pos = diag.find("uninitialized value"); pos != std::string::npos;
+       pos = diag.find("uninitialized value", pos + 1))
+    ++errorCount;
+  VERIFY_IS_TRUE(0 < errorCount && errorCount < 64);
+}
+
 TEST_F(ValidationTest, WhenFeatureInfoMismatchThenFail) {
   ReplaceContainerPartsCheckMsgs(
     "float4 main(uint2 foo : FOO) : SV_Target { return asdouble(foo.x, foo.y) * 2.0; }",
@@ -58,6 +58,34 @@ TEST(Decoration, RelaxedPrecision) {
   EXPECT_TRUE(rp->getArgs().empty());
 }
 
+TEST(Decoration, RelaxedPrecisionOnMember) {
+  SPIRVContext ctx;
+  const Decoration *rp = Decoration::getRelaxedPrecision(ctx, 2);
+  EXPECT_EQ(rp->getValue(), spv::Decoration::RelaxedPrecision);
+  EXPECT_EQ(rp->getMemberIndex().getValue(), 2U);
+  EXPECT_TRUE(rp->getArgs().empty());
+  EXPECT_NE(rp, Decoration::getRelaxedPrecision(ctx));
+}
+
+TEST(Decoration, WithTargetIdCreatesDecorateInstruction) {
+  SPIRVContext ctx;
+  const Decoration *stride = Decoration::getArrayStride(ctx, 16);
+  EXPECT_THAT(stride->withTargetId(5),
+              ElementsAre(4u << 16 | static_cast<uint32_t>(
+                                         spv::Op::OpDecorate),
+                          5u,
+                          static_cast<uint32_t>(spv::Decoration::ArrayStride),
+                          16u));
+
+  const Decoration *rp = Decoration::getRelaxedPrecision(ctx, 1);
+  EXPECT_THAT(rp->withTargetId(7),
+              ElementsAre(4u << 16 | static_cast<uint32_t>(
+                                         spv::Op::OpMemberDecorate),
+                          7u, 1u,
+                          static_cast<uint32_t>(
+                              spv::Decoration::RelaxedPrecision)));
+}
+
 TEST(Decoration, SpecId) {
   SPIRVContext ctx;
   const Decoration *specId = Decoration::getSpecId(ctx, 15);
@@ -7,6 +7,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
+#include <set>
+#include <thread>
+
 #include "clang/SPIRV/ModuleBuilder.h"
 #include "spirv/1.0/spirv.hpp11"
 
@@ -84,6 +88,81 @@ TEST(ModuleBuilder, BeginEndBasicBlockCreatesBasicBlock) {
   EXPECT_THAT(result, ContainerEq(expected));
 }
 
+TEST(ModuleBuilder, TakeModuleToStreamWritesSameBinary) {
+  SPIRVContext context;
+  ModuleBuilder builder(&context);
+  SPIRVContext streamContext;
+  ModuleBuilder streamBuilder(&streamContext);
+
+  for (ModuleBuilder *b : {&builder, &streamBuilder}) {
+    expectBuildSuccess(b->beginModule());
+    for (int i = 0; i < 2; ++i) {
+      expectBuildSuccess(b->beginFunction(1, 2));
+      expectBuildSuccess(b->beginBasicBlock());
+      expectBuildSuccess(b->endBasicBlockWithReturn());
+      expectBuildSuccess(b->endFunction());
+    }
+    expectBuildSuccess(b->endModule());
+  }
+
+  const auto expected = builder.takeModule();
+  std::string binary;
+  llvm::raw_string_ostream os(binary);
+  streamBuilder.takeModule(os);
+  os.flush();
+
+  ASSERT_EQ(expected.size() * 4, binary.size());
+  std::vector<uint32_t> result(expected.size());
+  memcpy(result.data(), binary.data(), binary.size());
+  EXPECT_THAT(result, ContainerEq(expected));
+}
+
+TEST(ModuleBuilder, FunctionsBuiltOnThreadsGetDistinctIds) {
+  SPIRVContext context;
+  ModuleBuilder builder(&context);
+  expectBuildSuccess(builder.beginModule());
+  const auto rType = context.takeNextId();
+  const auto fType = context.takeNextId();
+
+  const unsigned kThreadCount = 4;
+  std::vector<Function> functions(kThreadCount);
+  std::vector<std::vector<uint32_t>> ids(kThreadCount);
+  std::vector<uint32_t> intIds(kThreadCount);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      FunctionBuilder fb(&context, fType, rType);
+      ids[i].push_back(fb.getFunctionId());
+      for (int j = 0; j < 100; ++j)
+        ids[i].push_back(fb.takeNextId());
+      intIds[i] = context.getResultIdForType(Type::getInt32(context));
+      expectBuildSuccess(fb.beginBasicBlock());
+      expectBuildSuccess(fb.endBasicBlockWithReturn());
+      expectBuildSuccess(fb.takeFunction(&functions[i]));
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  // Ids taken by different builders never collide, while the type they all
+  // use is defined once.
+  std::set<uint32_t> seen;
+  for (unsigned i = 0; i < kThreadCount; ++i) {
+    for (uint32_t id : ids[i])
+      EXPECT_TRUE(seen.insert(id).second);
+    EXPECT_EQ(intIds[0], intIds[i]);
+  }
+  EXPECT_EQ(0u, seen.count(intIds[0]));
+
+  for (auto &f : functions)
+    expectBuildSuccess(builder.addFunction(std::move(f)));
+  expectBuildSuccess(builder.endModule());
+  const auto result = builder.takeModule();
+  // The id bound covers every id taken.
+  EXPECT_EQ(context.getNextId(), result[3]);
+  EXPECT_LT(*seen.rbegin(), result[3]);
+}
+
 TEST(ModuleBuilder, NestedModuleResultsInError) {
   SPIRVContext context;
   ModuleBuilder builder(&context);
@@ -115,6 +194,24 @@ TEST(ModuleBuilder, NestedBasicBlockResultsInError) {
             builder.beginBasicBlock());
 }
 
+TEST(ModuleBuilder, DecorateAddsDecorationInstruction) {
+  SPIRVContext context;
+  ModuleBuilder builder(&context);
+
+  expectBuildSuccess(builder.beginModule());
+  const auto targetId = context.takeNextId();
+  builder.decorate(targetId, Decoration::getRelaxedPrecision(context));
+  expectBuildSuccess(builder.endModule());
+  const auto result = builder.takeModule();
+
+  auto expected = getModuleHeader(context.getNextId());
+  appendVector(&expected,
+               constructInst(spv::Op::OpDecorate,
+                             {targetId, static_cast<uint32_t>(
+                                            spv::Decoration::RelaxedPrecision)}));
+  EXPECT_THAT(result, ContainerEq(expected));
+}
+
 TEST(ModuleBuilder, BasicBlockWoFunctionResultsInError) {
   SPIRVContext context;
   ModuleBuilder builder(&context);
@@ -0,0 +1,182 @@
+//===- unittests/SPIRV/OptimizerTest.cpp ------ SPIR-V optimizer tests ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/SPIRV/Optimizer.h"
+#include "spirv/1.0/spirv.hpp11"
+
+#include "SPIRVTestUtils.h"
+
+namespace {
+
+using namespace clang::spirv;
+
+using ::testing::ContainerEq;
+
+TEST(Optimizer, OptLevelZeroLeavesModuleUntouched) {
+  auto binary = getModuleHeader(10);
+  appendVector(&binary, constructInst(spv::Op::OpTypeVoid, {7}));
+  const auto original = binary;
+
+  EXPECT_FALSE(optimizeModule(&binary, 0));
+  EXPECT_THAT(binary, ContainerEq(original));
+}
+
+/// Creates an OpEntryPoint for a fragment shader named "main".
+std::vector<uint32_t> constructEntryPoint(uint32_t functionId) {
+  return constructInst(
+      spv::Op::OpEntryPoint,
+      {static_cast<uint32_t>(spv::ExecutionModel::Fragment), functionId,
+       0x6e69616d, 0});
+}
+
+TEST(Optimizer, RemovesUnusedDeclarationsAndCompactsIds) {
+  auto binary = getModuleHeader(20);
+  appendVector(&binary, constructEntryPoint(12));
+  appendVector(&binary, constructInst(spv::Op::OpName, {6, 0x66}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeVoid, {4}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFloat, {6, 32}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFunction, {8, 4}));
+  appendVector(&binary, constructInst(spv::Op::OpFunction, {4, 12, 0, 8}));
+  appendVector(&binary, constructInst(spv::Op::OpLabel, {14}));
+  appendVector(&binary, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&binary, constructInst(spv::Op::OpFunctionEnd, {}));
+  appendVector(&binary, constructInst(spv::Op::OpFunction, {4, 16, 0, 8}));
+  appendVector(&binary, constructInst(spv::Op::OpLabel, {18}));
+  appendVector(&binary, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&binary, constructInst(spv::Op::OpFunctionEnd, {}));
+
+  EXPECT_TRUE(optimizeModule(&binary, 3));
+
+  // The unused float goes with its name, and so does the function that is
+  // not an entry point.
+  auto expected = getModuleHeader(5);
+  appendVector(&expected, constructEntryPoint(1));
+  appendVector(&expected, constructInst(spv::Op::OpTypeVoid, {2}));
+  appendVector(&expected, constructInst(spv::Op::OpTypeFunction, {3, 2}));
+  appendVector(&expected, constructInst(spv::Op::OpFunction, {2, 1, 0, 3}));
+  appendVector(&expected, constructInst(spv::Op::OpLabel, {4}));
+  appendVector(&expected, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&expected, constructInst(spv::Op::OpFunctionEnd, {}));
+  EXPECT_THAT(binary, ContainerEq(expected));
+}
+
+TEST(Optimizer, MergesDuplicateUndecoratedDeclarations) {
+  const uint32_t one = 0x3f800000;
+  const uint32_t relaxed =
+      static_cast<uint32_t>(spv::Decoration::RelaxedPrecision);
+  const uint32_t priv = static_cast<uint32_t>(spv::StorageClass::Private);
+
+  auto binary = getModuleHeader(12);
+  appendVector(&binary, constructEntryPoint(10));
+  appendVector(&binary, constructInst(spv::Op::OpDecorate, {5, relaxed}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFloat, {1, 32}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFloat, {2, 32}));
+  appendVector(&binary, constructInst(spv::Op::OpConstant, {1, 3, one}));
+  appendVector(&binary, constructInst(spv::Op::OpConstant, {2, 4, one}));
+  appendVector(&binary, constructInst(spv::Op::OpConstant, {2, 5, one}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeVoid, {6}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFunction, {7, 6}));
+  appendVector(&binary, constructInst(spv::Op::OpTypePointer, {8, priv, 1}));
+  appendVector(&binary, constructInst(spv::Op::OpVariable, {8, 9, priv}));
+  appendVector(&binary, constructInst(spv::Op::OpFunction, {6, 10, 0, 7}));
+  appendVector(&binary, constructInst(spv::Op::OpLabel, {11}));
+  appendVector(&binary, constructInst(spv::Op::OpStore, {9, 4}));
+  appendVector(&binary, constructInst(spv::Op::OpStore, {9, 5}));
+  appendVector(&binary, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&binary, constructInst(spv::Op::OpFunctionEnd, {}));
+
+  EXPECT_TRUE(optimizeModule(&binary, 1));
+
+  // The second float and the constant of it are merged into the first ones;
+  // the decorated constant stays apart.
+  auto expected = getModuleHeader(10);
+  appendVector(&expected, constructEntryPoint(1));
+  appendVector(&expected, constructInst(spv::Op::OpDecorate, {2, relaxed}));
+  appendVector(&expected, constructInst(spv::Op::OpTypeFloat, {3, 32}));
+  appendVector(&expected, constructInst(spv::Op::OpConstant, {3, 4, one}));
+  appendVector(&expected, constructInst(spv::Op::OpConstant, {3, 2, one}));
+  appendVector(&expected, constructInst(spv::Op::OpTypeVoid, {5}));
+  appendVector(&expected, constructInst(spv::Op::OpTypeFunction, {6, 5}));
+  appendVector(&expected, constructInst(spv::Op::OpTypePointer, {7, priv, 3}));
+  appendVector(&expected, constructInst(spv::Op::OpVariable, {7, 8, priv}));
+  appendVector(&expected, constructInst(spv::Op::OpFunction, {5, 1, 0, 6}));
+  appendVector(&expected, constructInst(spv::Op::OpLabel, {9}));
+  appendVector(&expected, constructInst(spv::Op::OpStore, {8, 4}));
+  appendVector(&expected, constructInst(spv::Op::OpStore, {8, 2}));
+  appendVector(&expected, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&expected, constructInst(spv::Op::OpFunctionEnd, {}));
+  EXPECT_THAT(binary, ContainerEq(expected));
+}
+
+TEST(Optimizer, LeavesModulesWithUnknownInstructionsUntouched) {
+  auto binary = getModuleHeader(10);
+  appendVector(&binary, constructInst(spv::Op::OpTypeVoid, {7}));
+  appendVector(&binary, constructInst(spv::Op::OpSwitch, {7, 8}));
+  const auto original = binary;
+
+  EXPECT_FALSE(optimizeModule(&binary, 3));
+  EXPECT_THAT(binary, ContainerEq(original));
+}
+
+TEST(Optimizer, StripsDebugInfoAndCompactsIdsOnly) {
+  auto binary = getModuleHeader(30);
+  appendVector(&binary, constructInst(spv::Op::OpString, {20, 0x61}));
+  appendVector(&binary,
+               constructInst(spv::Op::OpSource,
+                             {static_cast<uint32_t>(spv::SourceLanguage::HLSL),
+                              500, 20}));
+  appendVector(&binary, constructInst(spv::Op::OpName, {10, 0x66}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFloat, {10, 32}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFloat, {12, 32}));
+
+  OptimizerOptions options;
+  options.compactIds = true;
+  options.stripDebugInfo = true;
+  EXPECT_TRUE(optimizeModule(&binary, options));
+
+  // Without the other passes, the unused and duplicate types stay.
+  auto expected = getModuleHeader(3);
+  appendVector(&expected, constructInst(spv::Op::OpTypeFloat, {1, 32}));
+  appendVector(&expected, constructInst(spv::Op::OpTypeFloat, {2, 32}));
+  EXPECT_THAT(binary, ContainerEq(expected));
+}
+
+TEST(Optimizer, ModuleStatsCountsWordsPerSection) {
+  auto binary = getModuleHeader(8);
+  appendVector(&binary,
+               constructInst(spv::Op::OpCapability,
+                             {static_cast<uint32_t>(spv::Capability::Shader)}));
+  appendVector(&binary, constructEntryPoint(3));
+  appendVector(&binary, constructInst(spv::Op::OpName, {1, 0x66}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeVoid, {1}));
+  appendVector(&binary, constructInst(spv::Op::OpTypeFunction, {2, 1}));
+  appendVector(&binary, constructInst(spv::Op::OpFunction, {1, 3, 0, 2}));
+  appendVector(&binary, constructInst(spv::Op::OpLabel, {4}));
+  appendVector(&binary, constructInst(spv::Op::OpReturn, {}));
+  appendVector(&binary, constructInst(spv::Op::OpFunctionEnd, {}));
+
+  const ModuleStats stats(binary);
+  EXPECT_EQ(8u, stats.idBound);
+  EXPECT_EQ(binary.size(), stats.totalWords);
+  EXPECT_EQ(5u, stats.sectionWords[ModuleStats::Header]);
+  EXPECT_EQ(2u, stats.sectionWords[ModuleStats::Capabilities]);
+  EXPECT_EQ(5u, stats.sectionWords[ModuleStats::EntryPoints]);
+  EXPECT_EQ(3u, stats.sectionWords[ModuleStats::Debug]);
+  EXPECT_EQ(5u, stats.sectionWords[ModuleStats::TypesValues]);
+  EXPECT_EQ(9u, stats.sectionWords[ModuleStats::Functions]);
+
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  stats.print(os);
+  EXPECT_EQ("29 words, id bound 8 (header 5, capabilities 2, entry points 5, "
+            "debug 3, types and values 5, functions 9)",
+            os.str());
+}
+
+} // anonymous namespace
@@ -75,6 +75,50 @@ TEST(ValidateSPIRVContext, ValidateUniqueIdForUniqueAggregateType) {
   EXPECT_EQ(struct_1_id, struct_2_id);
 }
 
+TEST(ValidateSPIRVContext, ValidateDistinctTypesWithSameOpcode) {
+  SPIRVContext ctx;
+  const uint32_t float_id = ctx.getResultIdForType(Type::getFloat32(ctx));
+  const uint32_t int_id = ctx.getResultIdForType(Type::getInt32(ctx));
+
+  // Types sharing an opcode are only unified when their arguments and
+  // decorations match as well.
+  const Type *vec4f = Type::getVec4(ctx, float_id);
+  const Type *vec4i = Type::getVec4(ctx, int_id);
+  const Type *vec3f = Type::getVec3(ctx, float_id);
+  EXPECT_NE(vec4f, vec4i);
+  EXPECT_NE(vec4f, vec3f);
+  EXPECT_EQ(vec4f, Type::getVec4(ctx, float_id));
+
+  const auto relaxed = Decoration::getRelaxedPrecision(ctx);
+  const Type *relaxed_vec4f =
+      Type::getType(ctx, spv::Op::OpTypeVector, {float_id, 4}, {relaxed});
+  EXPECT_NE(vec4f, relaxed_vec4f);
+  EXPECT_EQ(relaxed_vec4f, Type::getType(ctx, spv::Op::OpTypeVector,
+                                         {float_id, 4}, {relaxed}));
+}
+
+TEST(ValidateSPIRVContext, ValidateDistinctDecorationsWithSameValue) {
+  SPIRVContext ctx;
+  const auto offset_0 = Decoration::getOffset(ctx, 0u, 0);
+  const auto offset_0_mem_1 = Decoration::getOffset(ctx, 0u, 1);
+  const auto offset_16 = Decoration::getOffset(ctx, 16u, 0);
+  EXPECT_NE(offset_0, offset_0_mem_1);
+  EXPECT_NE(offset_0, offset_16);
+  EXPECT_EQ(offset_0, Decoration::getOffset(ctx, 0u, 0));
+}
+
+TEST(ValidateSPIRVContext, ValidateUniqueIdForUniqueConstant) {
+  SPIRVContext ctx;
+  const Type *intt = Type::getInt32(ctx);
+  const Type *uintt = Type::getUint32(ctx);
+  const uint32_t one = ctx.getResultIdForConstant(intt, {1});
+  // The same value of the same type gets the same ID.
+  EXPECT_EQ(one, ctx.getResultIdForConstant(intt, {1}));
+  // A different value or type gets a different ID.
+  EXPECT_NE(one, ctx.getResultIdForConstant(intt, {2}));
+  EXPECT_NE(one, ctx.getResultIdForConstant(uintt, {1}));
+}
+
 // TODO: Add more SPIRVContext tests
 
 } // anonymous namespace
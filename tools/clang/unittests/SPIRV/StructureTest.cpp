@@ -38,6 +38,26 @@ TEST(Structure, TakeBasicBlockHaveAllContents) {
   EXPECT_TRUE(bb.isEmpty());
 }
 
+TEST(Structure, TakeBasicBlockKeepsInstructionOrder) {
+  std::vector<uint32_t> result;
+  auto ib = constructInstBuilder(result);
+
+  auto bb = BasicBlock(42);
+  bb.addInstruction(constructInst(spv::Op::OpNop, {}));
+  bb.addInstruction(constructInst(spv::Op::OpUndef, {1, 2}));
+  bb.addInstruction(constructInst(spv::Op::OpReturn, {}));
+  bb.take(&ib);
+
+  std::vector<uint32_t> expected;
+  appendVector(&expected, constructInst(spv::Op::OpLabel, {42}));
+  appendVector(&expected, constructInst(spv::Op::OpNop, {}));
+  appendVector(&expected, constructInst(spv::Op::OpUndef, {1, 2}));
+  appendVector(&expected, constructInst(spv::Op::OpReturn, {}));
+
+  EXPECT_THAT(result, ContainerEq(expected));
+  EXPECT_TRUE(bb.isEmpty());
+}
+
 TEST(Structure, AfterClearBasicBlockIsEmpty) {
   auto bb = BasicBlock(42);
   bb.addInstruction(constructInst(spv::Op::OpNop, {}));
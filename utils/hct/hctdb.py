@@ -695,7 +695,7 @@ class db_dxil(object):
             db_dxil_param(0, "i1", "", "nonzero if all values accessed mapped tiles in a tiled resource"),
             db_dxil_param(2, "u32", "status", "status result from the Sample, Gather or Load operation")])
         next_op_idx += 1
-        self.add_dxil_op("GetDimensions", next_op_idx, "GetDimensions", "gets texture size information", "v", "ro", [
+        self.add_dxil_op("GetDimensions", next_op_idx, "GetDimensions", "gets texture size information", "v", "rn", [
             db_dxil_param(0, "dims", "", "dimension information for texture"),
             db_dxil_param(2, "res", "handle", "resource handle to query"),
             db_dxil_param(3, "i32", "mipLevel", "mip level to query")])
@@ -766,7 +766,7 @@ class db_dxil(object):
         next_op_idx += 1
 
         # Pixel shader
-        self.add_dxil_op("CalculateLOD", next_op_idx, "CalculateLOD", "calculates the level of detail", "f", "ro", [
+        self.add_dxil_op("CalculateLOD", next_op_idx, "CalculateLOD", "calculates the level of detail", "f", "rn", [
             db_dxil_param(0, "f", "", "level of detail"),
             db_dxil_param(2, "res", "handle", "resource handle"),
             db_dxil_param(3, "res", "sampler", "sampler handle"),
@@ -1262,6 +1262,8 @@ class db_dxil(object):
         add_pass('multi-dim-one-dim', 'MultiDimArrayToOneDimArray', 'Flatten multi-dim array into one-dim array', [])
         add_pass('resource-handle', 'ResourceToHandle', 'Lower resource into handle', [])
         add_pass('hlsl-dxil-condense', 'DxilCondenseResources', 'DXIL Condense Resources', [])
+        add_pass('hlsl-dxil-coalesce-cbuffer-loads', 'DxilCoalesceCBufferLoads', 'DXIL coalesce cbuffer loads', [])
+        add_pass('hlsl-dxil-combine-buffer-accesses', 'DxilCombineBufferAccesses', 'DXIL combine buffer accesses', [])
         add_pass('hlsl-dxil-eliminate-output-dynamic', 'DxilEliminateOutputDynamicIndexing', 'DXIL eliminate ouptut dynamic indexing', [])
         add_pass('hlsl-dxil-constantColor', 'DxilOutputColorBecomesConstant', 'DXIL Constant Color Mod', [
             {'n':'mod-mode','t':'int','c':1},
@@ -1271,9 +1273,41 @@ class db_dxil(object):
             {'n':'constant-alpha','t':'float','c':1}])
         add_pass('hlsl-dxilemit', 'DxilEmitMetadata', 'HLSL DXIL Metadata Emit', [])
         add_pass('hlsl-dxilload', 'DxilLoadMetadata', 'HLSL DXIL Metadata Load', [])
-        add_pass('hlsl-dxil-expand-trig', 'DxilExpandTrigIntrinsics', 'DXIL expand trig intrinsics', [])
+        add_pass('hlsl-dxil-apply-block-profile', 'DxilApplyBlockProfile', 'DXIL apply block profile', [
+            {'n':'profile','t':'string','c':1,'d':"Block counts, as function:block:count entries separated by ';'"},
+            {'n':'cold-percent','t':'unsigned','c':1,'d':'Branches whose rarer side runs less than this percentage of the time are marked [branch]'}])
+        add_pass('hlsl-dxil-insert-block-counters', 'DxilInsertBlockCounters', 'DXIL insert block counters', [
+            {'n':'uav-space','t':'unsigned','c':1,'d':'Register space of the counter buffer'},
+            {'n':'uav-register','t':'unsigned','c':1,'d':'Register of the counter buffer'},
+            {'n':'per-line','t':'bool','c':1,'d':'Also count each run of instructions on a new source line'}])
+        add_pass('hlsl-dxil-insert-profile-regions', 'DxilInsertProfileRegions', 'DXIL insert profile regions', [
+            {'n':'uav-space','t':'unsigned','c':1,'d':'Register space of the region timing buffer'},
+            {'n':'uav-register','t':'unsigned','c':1,'d':'Register of the region timing buffer'}])
+        add_pass('hlsl-dxil-map-counters-to-lines', 'DxilMapCountersToLines', 'DXIL map counters to lines', [
+            {'n':'counts','t':'string','c':1,'d':"Values of the counter buffer, in order, separated by ';'"}])
+        add_pass('hlsl-dxil-constant-tables', 'DxilConstantTables', 'DXIL constant tables', [
+            {'n':'max-elements','t':'unsigned','c':1,'d':'Largest dynamically indexed constant table, in elements, to rewrite into selects'}])
+        add_pass('hlsl-dxil-dynamic-index-to-select', 'DxilDynamicIndexToSelect', 'DXIL dynamic index to select', [
+            {'n':'max-elements','t':'unsigned','c':1,'d':'Largest array, in elements, to rewrite into selects'}])
+        add_pass('hlsl-dxil-expand-trig-intrinsics', 'DxilExpandTrigIntrinsics', 'DXIL expand trig intrinsics', [
+            {'n':'approximate','t':'bool','c':1,'d':'Use cheaper, less accurate expansions for non-precise calls'}])
+        add_pass('hlsl-dxil-hoist-samples', 'DxilHoistSamples', 'DXIL hoist samples', [])
         add_pass('hlsl-hca', 'HoistConstantArray', 'HLSL constant array hoisting', [])
+        add_pass('hlsl-dxil-load-to-gather', 'DxilLoadToGather', 'DXIL load to gather', [])
+        add_pass('hlsl-dxil-non-uniform-handles', 'DxilNonUniformHandles', 'DXIL non-uniform handles', [])
+        add_pass('hlsl-dxil-pair-half-ops', 'DxilPairHalfOps', 'DXIL pair half operations', [])
         add_pass('hlsl-dxil-preserve-all-outputs', 'DxilPreserveAllOutputs', 'DXIL write to all outputs in signature', [])
+        add_pass('hlsl-dxil-prune-unread-outputs', 'DxilPruneUnreadOutputs', 'DXIL prune outputs unread by the next stage', [
+            {'n':'consumer-inputs','t':'string','c':1,'d':"Semantics read by the next stage, separated by '+'"},
+            {'n':'rt-mask','t':'unsigned','c':1,'d':'Render targets bound to a pixel shader, one bit per SV_Target index'},
+            {'n':'depth-write-disabled','t':'bool','c':1,'d':'Remove the depth output of a pixel shader'}])
+        add_pass('hlsl-dxil-shader-stats', 'DxilShaderStats', 'DXIL shader statistics', [])
+        add_pass('hlsl-dxil-simplify-before-inline', 'DxilSimplifyBeforeInline', 'DXIL simplify before inline', [])
+        add_pass('hlsl-dxil-simplify-wave-ops', 'DxilSimplifyWaveOps', 'DXIL simplify wave operations', [])
+        add_pass('hlsl-dxil-tgsm-bank-conflicts', 'DxilTGSMBankConflicts', 'DXIL groupshared bank conflicts', [
+            {'n':'banks','t':'unsigned','c':1,'d':'Number of groupshared memory banks'},
+            {'n':'lanes','t':'unsigned','c':1,'d':'Number of threads that access groupshared memory together'}])
+        add_pass('hlsl-dxil-uniformity-stats', 'DxilUniformityStats', 'DXIL uniformity statistics', [])
         add_pass('ipsccp', 'IPSCCP', 'Interprocedural Sparse Conditional Constant Propagation', [])
         add_pass('globalopt', 'GlobalOpt', 'Global Variable Optimizer', [])
         add_pass('deadargelim', 'DAE', 'Dead Argument Elimination', [])
@@ -1308,6 +1342,7 @@ class db_dxil(object):
             {'n':'Count', 't':'int', 'c':1},
             {'n':'AllowPartial', 't':'int', 'c':1},
             {'n':'Runtime', 't':'int', 'c':1},
+            {'n':'ReportHintFailures', 't':'bool', 'c':1, 'd':'Warn when a loop with an unroll attribute cannot be unrolled as directed'},
             {'n':'unroll-threshold', 'i':'UnrollThreshold', 't':'unsigned', 'd':'The baseline cost threshold for loop unrolling'},
             {'n':'unroll-percent-dynamic-cost-saved-threshold', 'i':'UnrollPercentDynamicCostSavedThreshold', 't':'unsigned', 'd':'The percentage of estimated dynamic cost which must be saved by unrolling to allow unrolling up to the max threshold.'},
             {'n':'unroll-dynamic-cost-savings-discount', 'i':'UnrollDynamicCostSavingsDiscount', 't':'unsigned', 'd':"This is the amount discounted from the total unroll cost when the unrolled form has a high dynamic cost savings (triggered by the '-unroll-perecent-dynamic-cost-saved-threshold' flag)."},
@@ -1315,7 +1350,9 @@ class db_dxil(object):
             {'n':'unroll-count', 'i':'UnrollCount', 't':'unsigned', 'd':'Use this unroll count for all loops including those with unroll_count pragma values, for testing purposes'},
             {'n':'unroll-allow-partial', 'i':'UnrollAllowPartial', 't':'bool', 'd':'Allows loops to be partially unrolled until -unroll-threshold loop size is reached.'},
             {'n':'unroll-runtime', 'i':'UnrollRuntime', 't':'bool', 'd':'Unroll loops with run-time trip counts'},
-            {'n':'pragma-unroll-threshold', 'i':'PragmaUnrollThreshold', 't':'unsigned', 'd':'Unrolled size limit for loops with an unroll(full) or unroll_count pragma.'}])
+            {'n':'pragma-unroll-threshold', 'i':'PragmaUnrollThreshold', 't':'unsigned', 'd':'Unrolled size limit for loops with an unroll(full) or unroll_count pragma.'},
+            {'n':'hlsl-unroll-fetch-bonus', 'i':'HLSLUnrollFetchBonus', 't':'unsigned', 'd':'Amount the full unroll threshold grows by for each texture or buffer read executed by the loop.'},
+            {'n':'hlsl-unroll-constant-index-threshold', 'i':'HLSLUnrollConstantIndexThreshold', 't':'unsigned', 'd':'Full unroll threshold for loops whose resource and cbuffer indices become constant when unrolled; also caps the fetch bonus.'}])
         add_pass('mldst-motion', 'MergedLoadStoreMotion', 'MergedLoadStoreMotion', [])
         add_pass('gvn', 'GVN', 'Global Value Numbering', [
             {'n':'noloads', 't':'bool', 'c':1},
@@ -1342,6 +1379,7 @@ class db_dxil(object):
         add_pass('lowerbitsets', 'LowerBitSets', 'Lower bitset metadata', [
             {'n':'lowerbitsets-avoid-reuse', 'i':'AvoidReuse', 't':'bool', 'd':'Try to avoid reuse of byte array addresses using aliases'}])
         add_pass('red', 'ReducibilityAnalysis', 'Reducibility Analysis', [])
+        add_pass('hlsl-control-dependence', 'ControlDependenceWrapperPass', 'HLSL Control Dependence Construction', [])
         add_pass('viewid-state', 'ComputeViewIdState', 'Compute information related to ViewID', [])
         # TODO: turn STATISTICS macros into ETW events
         # assert no duplicate names
@@ -16,6 +16,8 @@ DXCompilerIntelliSenseParse = 4;
 DXCompilerCompile = 5;
 DXCompilerPreprocess = 6;
 DXCompilerDisassemble = 7;
+DxcValidation = 8;
+DXCompilerPhase = 9;
 
 # Opcode values
 OpcodeStart = 1;
@@ -64,6 +66,37 @@ def write_compile_times(root):
                 print "Compilation took %s" % str(parsed_time_created - old_parsed_time_created)
 
 
+def write_phase_times(root):
+    '''Prints out the total time spent in each compilation phase.'''
+    totals = {}
+    open_phases = {}
+    for e in root:
+        system_node = e.find("e:System", ns)
+        if system_node is None:
+            continue
+        channel = system_node.find("e:Channel", ns)
+        if channel is None or channel.text <> "Microsoft-Windows-DXCompiler-API/Analytic":
+            continue
+        task = int(system_node.find("e:Task", ns).text)
+        if task != DXCompilerPhase:
+            continue
+        opcode = int(system_node.find("e:Opcode", ns).text)
+        pid = int(system_node.find("e:Execution", ns).attrib['ProcessID'])
+        tid = int(system_node.find("e:Execution", ns).attrib['ThreadID'])
+        time_created = system_node.find("e:TimeCreated", ns).attrib['SystemTime'][:26]
+        parsed_time_created = datetime.datetime.strptime(time_created, "%Y-%m-%dT%H:%M:%S.%f")
+        phase = e.find("e:EventData/e:Data[@Name='phaseName']", ns).text
+        # Phases nest, so keep a stack per thread.
+        stack = open_phases.setdefault('{0},{1}'.format(pid, tid), [])
+        if opcode == OpcodeStart:
+            stack.append((phase, parsed_time_created))
+        elif stack:
+            started_phase, started = stack.pop()
+            totals[started_phase] = totals.get(started_phase, datetime.timedelta()) + (parsed_time_created - started)
+    for phase, total in sorted(totals.items(), key=lambda item: item[1], reverse=True):
+        print "%s: %s" % (phase, str(total))
+
+
 def main():
   parser = argparse.ArgumentParser(description=__doc__)
   parser.add_argument('-v', '--verbose', action='store_true',
@@ -78,6 +111,7 @@ def main():
     root = tree.getroot()
     write_basic_info(root.find('e:Event/e:EventData', ns))
     write_compile_times(root)
+    write_phase_times(root)
     # Other interesting things:
     # errors, working set, additional stats
 